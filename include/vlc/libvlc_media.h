@@ -110,6 +110,28 @@ typedef enum libvlc_track_type_t
     libvlc_track_text      = 2
 } libvlc_track_type_t;
 
+/** Number of buckets of the latency histograms */
+#define LIBVLC_MEDIA_LATENCY_BUCKETS 24
+
+/**
+ * Measured latencies, see libvlc_media_stats_t
+ */
+typedef enum libvlc_media_latency_t
+{
+    libvlc_media_latency_video_decode = 0, /**< Video decoder, per block */
+    libvlc_media_latency_audio_decode, /**< Audio decoder, per block */
+    libvlc_media_latency_video_queue, /**< Picture queued until displayed */
+    libvlc_media_latency_video_display, /**< Picture preparation and display */
+    libvlc_media_latency_audio_play, /**< Audio output play, per buffer */
+    libvlc_media_latency_video_prepare, /**< Picture rendering and prepare */
+    libvlc_media_latency_video_present, /**< Picture display callback */
+    libvlc_media_latency_video_present_error, /**< Distance between the
+        presentation reported by the video output and the intended date */
+    libvlc_media_latency_audio_output, /**< Audio buffered in the output
+        until heard, per buffer */
+} libvlc_media_latency_t;
+#define LIBVLC_MEDIA_LATENCY_STAGES 9
+
 typedef struct libvlc_media_stats_t
 {
     /* Input */
@@ -133,6 +155,12 @@ typedef struct libvlc_media_stats_t
     /* Audio output */
     int         i_played_abuffers;
     int         i_lost_abuffers;
+
+    /* Latency histograms, indexed by libvlc_media_latency_t.
+     * The first bucket counts durations below 2 microseconds, bucket n counts
+     * durations from 2^n to 2^(n+1) microseconds. The last bucket counts
+     * longer durations as well. */
+    uint64_t    latency[LIBVLC_MEDIA_LATENCY_STAGES][LIBVLC_MEDIA_LATENCY_BUCKETS];
 } libvlc_media_stats_t;
 
 typedef struct libvlc_audio_track_t
@@ -272,6 +300,12 @@ typedef enum libvlc_media_parse_flag_t
      * when the input is asking for credentials.
      */
     libvlc_media_do_interact    = 0x08,
+    /**
+     * Parse this media in the background: requests without this flag (for
+     * the items the user is looking at) are served first. This is meant for
+     * bulk parsing, like indexing a media library.
+     */
+    libvlc_media_parse_background = 0x10,
 } libvlc_media_parse_flag_t;
 
 /**
@@ -54,6 +54,9 @@
  * above which upsampling will be performed */
 #define AOUT_MAX_PTS_DELAY              VLC_TICK_FROM_MS(60)
 
+/* Shortest latency budget of the audio output, see aout_LatencyBudget() */
+#define AOUT_MIN_LATENCY                VLC_TICK_FROM_MS(5)
+
 /* Max acceptable resampling (in %) */
 #define AOUT_MAX_RESAMPLING             10
 
@@ -480,6 +483,26 @@ static inline void aout_PauseDefault(audio_output_t *aout, bool paused,
     (void) date;
 }
 
+/**
+ * Latency budget of the audio output ("audio-latency")
+ *
+ * The modules should size the buffers and the periods of the device after
+ * it, when it is set, rather than after their defaults.
+ *
+ * \param obj the audio output, or any of its children or parents
+ * eturn the latency, from the play callback to the speakers, requested by
+ * the user (AOUT_MIN_LATENCY at least), or 0 for the default buffering
+ */
+static inline vlc_tick_t aout_LatencyBudget(vlc_object_t *obj)
+{
+    vlc_tick_t budget = VLC_TICK_FROM_MS(var_InheritInteger(obj,
+                                                            "audio-latency"));
+    if (budget <= 0)
+        return 0;
+    return budget < AOUT_MIN_LATENCY ? AOUT_MIN_LATENCY : budget;
+}
+#define aout_LatencyBudget(o) aout_LatencyBudget(VLC_OBJECT(o))
+
 /* Audio output filters */
 
 /**
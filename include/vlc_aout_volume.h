@@ -47,6 +47,12 @@ struct audio_volume
 
     vlc_fourcc_t format; /**< Audio samples format */
     void (*amplify)(audio_volume_t *, block_t *, float); /**< Amplifier */
+    /**
+     * Amplifier with a linear gain ramp over the buffer, from the first
+     * gain, which was applied to the previous buffer, to the second one,
+     * reached on the last frame (optional, may be NULL)
+     */
+    void (*amplify_ramp)(audio_volume_t *, block_t *, float, float);
 };
 
 /** @} */
@@ -247,6 +247,36 @@ static inline block_t *block_Duplicate( const block_t *p_block )
  */
 VLC_API block_t *block_heap_Alloc(void *, size_t) VLC_USED VLC_MALLOC;
 
+/**
+ * Makes a block shareable.
+ *
+ * Wraps a block so that views of its payload can be created with
+ * block_View(). The data is released once the returned block and all its
+ * views are released. If the block is already shareable, it is returned as is.
+ *
+ * @param block block to share (owned by the returned block on success)
+ * @return a shareable block, or NULL on error (the block is then unchanged)
+ */
+VLC_API block_t *block_Share(block_t *block) VLC_USED;
+
+/**
+ * Creates a view of a shareable block payload.
+ *
+ * The view is a block pointing to the shareable block data without copying
+ * it. Views do not carry the block metadata.
+ *
+ * @warning The data is common to the block and its views: the bytes given to
+ * a view must not be modified or moved through the shareable block anymore,
+ * including by block_TryRealloc(). Distinct views must not overlap if any of
+ * them is to be modified.
+ *
+ * @param block shareable block (see block_Share())
+ * @param offset offset of the view in the block payload
+ * @param length byte length of the view
+ * @return a new block, or NULL on error
+ */
+VLC_API block_t *block_View(block_t *block, size_t offset, size_t length) VLC_USED;
+
 /**
  * Wraps a memory mapping in a block
  *
@@ -77,8 +77,10 @@ VLC_API unsigned vlc_CPU(void);
 
 # ifdef __SSSE3__
 #  define vlc_CPU_SSSE3() (1)
+#  define VLC_SSSE3
 # else
 #  define vlc_CPU_SSSE3() ((vlc_CPU() & VLC_CPU_SSSE3) != 0)
+#  define VLC_SSSE3 __attribute__ ((__target__ ("ssse3")))
 # endif
 
 # ifdef __SSE4_1__
@@ -107,8 +109,10 @@ VLC_API unsigned vlc_CPU(void);
 
 # ifdef __AVX2__
 #  define vlc_CPU_AVX2() (1)
+#  define VLC_AVX2
 # else
 #  define vlc_CPU_AVX2() ((vlc_CPU() & VLC_CPU_AVX2) != 0)
+#  define VLC_AVX2 __attribute__ ((__target__ ("avx2")))
 # endif
 
 # ifdef __3dNOW__
@@ -201,4 +205,50 @@ VLC_API unsigned vlc_CPU(void);
 
 # endif
 
+/**
+ * \defgroup cpu_dispatch SIMD dispatch
+ * Run-time selection among the implementations of a function.
+ *
+ * A function with SIMD optimizations is described by a table of its
+ * implementations, from the most to the least preferred, ending with the C
+ * reference, which requires no CPU feature. The table is resolved once,
+ * typically when the module is opened, and the test suite checks every
+ * implementation that the CPU supports against the reference.
+ *
+ * Setting the VLC_CPU_FLAGS environment variable restricts the CPU features
+ * to those it lists, e.g. "sse2,ssse3" or "none", so as to force a given
+ * implementation.
+ * @{
+ */
+struct vlc_cpu_impl
+{
+    const char *name; /**< Implementation name, e.g. "avx2" */
+    unsigned flags; /**< Required VLC_CPU_* flags, 0 for the C reference */
+    void (*func)(void); /**< Implementation, to cast back to its type */
+};
+
+#define VLC_CPU_IMPL(name, flags, func) \
+    { name, flags, (void (*)(void))(func) }
+
+/**
+ * Checks if the CPU has all the given features.
+ */
+static inline bool vlc_CPU_has(unsigned flags)
+{
+    return (flags & ~vlc_CPU()) == 0;
+}
+
+/**
+ * Selects the preferred implementation supported by the CPU.
+ *
+ * @param impls table of implementations, from the most preferred
+ * @param count number of entries in the table
+ * @return the first entry whose required features are all supported,
+ *         or NULL if none is (never if the table ends with a C reference)
+ */
+VLC_API const struct vlc_cpu_impl *vlc_CPU_select(const struct vlc_cpu_impl *impls,
+                                                  size_t count) VLC_USED;
+
+/** @} */
+
 #endif /* !VLC_CPU_H */
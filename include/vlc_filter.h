@@ -154,6 +154,20 @@ struct filter_t
 
     /** Private structure for the owner of the filter */
     filter_owner_t      owner;
+
+    /** Filter a slice of a picture (video filter), or NULL.
+     *
+     * Optionally set along pf_video_filter by the filters whose output pixels
+     * only depend on the input pixels at the same place, with the same input
+     * and output formats. The filter chain can then run several of them on
+     * each slice, one after another, without intermediate pictures.
+     *
+     * The source and destination pictures can be the same. Only the lines
+     * of the slice must be written, see filter_GetSliceLines(), and the
+     * picture properties are copied by the caller. */
+    void (*pf_video_filter_slice)( filter_t *, picture_t *p_dst,
+                                   const picture_t *p_src,
+                                   unsigned slice, unsigned slices );
 };
 
 /**
@@ -337,6 +351,51 @@ VLC_API void filter_DeleteBlend( vlc_blender_t * );
         return p_outpic;                                                \
     }
 
+/**
+ * Callback processing a slice of a picture.
+ *
+ * The slices are horizontal bands of the picture, processed at once by
+ * different threads: the callback must only write the lines of its slice.
+ *
+ * \param filter the filter passed to filter_RunSlices()
+ * \param data the data passed to filter_RunSlices()
+ * \param slice index of the slice, from 0 to slices - 1
+ * \param slices number of slices of the picture
+ * \see filter_GetSliceLines()
+ */
+typedef void (*filter_slice_cb)( filter_t *filter, void *data,
+                                 unsigned slice, unsigned slices );
+
+/**
+ * Processes a picture by slices, on the shared video filter threads.
+ *
+ * The picture is split in as many slices as CPUs, unless they would be less
+ * than a few lines high, and the calling thread processes slices too. This
+ * function returns when all the slices are processed.
+ *
+ * \param lines number of lines of the picture, in its first plane
+ * \param cb callback processing a slice
+ * \param data opaque data for the callback
+ */
+VLC_API void filter_RunSlices( filter_t *, unsigned lines, filter_slice_cb cb,
+                               void *data );
+
+/**
+ * Gets the lines of a plane belonging to a slice.
+ *
+ * \param lines number of lines of the plane
+ * \param slice index of the slice
+ * \param slices number of slices
+ * \param first [OUT] first line of the slice
+ * \param end [OUT] line past the last line of the slice
+ */
+static inline void filter_GetSliceLines( int lines, unsigned slice,
+                                         unsigned slices, int *first, int *end )
+{
+    *first = (int64_t)lines * slice / slices;
+    *end = (int64_t)lines * (slice + 1) / slices;
+}
+
 /**
  * Filter chain management API
  * The filter chain management API is used to dynamically construct filters
@@ -466,6 +466,8 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_FETCH_NETWORK = 0x08,
     META_REQUEST_OPTION_FETCH_ANY     = 0x0C,
     META_REQUEST_OPTION_DO_INTERACT   = 0x10,
+    META_REQUEST_OPTION_BACKGROUND    = 0x20, /**< bulk request, served after
+                                                   the other requests */
 } input_item_meta_request_option_t;
 
 /* status of the on_preparse_ended() callback */
@@ -500,6 +502,53 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+
+/** Number of buckets of a latency histogram */
+#define INPUT_LATENCY_BUCKETS 24
+
+/**
+ * Latency histogram.
+ *
+ * The first bucket counts durations below 2 microseconds. Bucket n counts
+ * durations from 2^n to 2^(n+1) microseconds (excluded). The last bucket
+ * counts all durations above 2^23 microseconds (about 8 seconds) as well.
+ */
+typedef struct input_latency_t
+{
+    uint64_t buckets[INPUT_LATENCY_BUCKETS];
+} input_latency_t;
+
+/** Measured latencies */
+enum input_latency_stage
+{
+    INPUT_LATENCY_VIDEO_DECODE, /**< Video decoder, per block */
+    INPUT_LATENCY_AUDIO_DECODE, /**< Audio decoder, per block */
+    INPUT_LATENCY_VIDEO_QUEUE, /**< Picture queued until its display date */
+    INPUT_LATENCY_VIDEO_DISPLAY, /**< Picture preparation and display */
+    INPUT_LATENCY_AUDIO_PLAY, /**< Audio output play, per buffer */
+    INPUT_LATENCY_VIDEO_PREPARE, /**< Picture filtering, rendering and prepare */
+    INPUT_LATENCY_VIDEO_PRESENT, /**< Picture display callback */
+    INPUT_LATENCY_VIDEO_PRESENT_ERROR, /**< Distance between the reported
+                                          presentation and the intended date */
+    INPUT_LATENCY_AUDIO_OUTPUT, /**< Audio buffered in the output until
+                                   heard, per buffer */
+};
+#define INPUT_LATENCY_STAGES 9
+
+/**
+ * Gets the latency histogram bucket of a duration.
+ */
+static inline unsigned input_latency_GetBucket(vlc_tick_t duration)
+{
+    int64_t us = US_FROM_VLC_TICK(duration);
+
+    if (us < 2)
+        return 0;
+
+    unsigned n = 63 - vlc_clzll(us);
+    return (n < INPUT_LATENCY_BUCKETS) ? n : (INPUT_LATENCY_BUCKETS - 1);
+}
+
 struct input_stats_t
 {
     /* Input */
@@ -525,6 +574,9 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Latency histograms, all ES of a category together */
+    input_latency_t latency[INPUT_LATENCY_STAGES];
 };
 
 /**
@@ -465,6 +465,7 @@ enum vlc_ml_control
     VLC_ML_MEDIA_GENERATE_THUMBNAIL,        /**< arg1: media id; arg2: vlc_ml_thumbnail_size_t; arg3: width; arg4: height; arg5: position */
     VLC_ML_MEDIA_ADD_EXTERNAL_MRL,          /**< arg1: media id; arg2: const char*; arg3: type(vlc_ml_file_type_t) */
     VLC_ML_MEDIA_SET_TYPE,                  /**< arg1: media id; arg2: vlc_ml_media_type_t */
+    VLC_ML_MEDIA_CANCEL_THUMBNAIL,          /**< arg1: media id; arg2: vlc_ml_thumbnail_size_t */
 };
 
 /**
@@ -952,6 +953,19 @@ static inline int vlc_ml_media_generate_thumbnail( vlc_medialibrary_t* p_ml, int
                            size_type, i_desired_width, i_desired_height, position );
 }
 
+/**
+ * Cancel a thumbnail generation request which did not start yet, typically
+ * because the media is not displayed anymore.
+ *
+ * Pending requests are served in reverse order (the latest request first),
+ * so that the media being displayed get their thumbnail first.
+ */
+static inline int vlc_ml_media_cancel_thumbnail( vlc_medialibrary_t* p_ml, int64_t i_media_id,
+                                                 vlc_ml_thumbnail_size_t size_type )
+{
+    return vlc_ml_control( p_ml, VLC_ML_MEDIA_CANCEL_THUMBNAIL, i_media_id, size_type );
+}
+
 static inline int vlc_ml_media_add_external_mrl( vlc_medialibrary_t* p_ml, int64_t i_media_id,
                                                  const char* psz_mrl, int i_type )
 {
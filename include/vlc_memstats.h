@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * vlc_memstats.h: memory accounting
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MEMSTATS_H
+# define VLC_MEMSTATS_H 1
+
+/**
+ * \defgroup memstats Memory accounting
+ * \ingroup misc
+ *
+ * Accounting of the blocks (block_Alloc()), the pictures
+ * (picture_NewFromFormat()) and the object resources (vlc_obj_malloc()).
+ *
+ * Each allocation is attributed to the code which requested it, so that the
+ * module holding memory or allocating at a high rate can be found. The
+ * accounting is disabled unless the VLC_MEMSTATS environment variable is set
+ * to a non-zero value when the process starts.
+ * @{
+ */
+
+enum vlc_memstats_kind
+{
+    VLC_MEMSTATS_BLOCK,
+    VLC_MEMSTATS_PICTURE,
+    VLC_MEMSTATS_OBJRES,
+};
+
+/**
+ * Accounting of one allocation site.
+ */
+struct vlc_memstats_entry
+{
+    enum vlc_memstats_kind kind;
+    const char *module; /**< file name of the plugin or library, or NULL */
+    const char *symbol; /**< function which allocated, or NULL */
+    const void *caller; /**< return address of the allocation call */
+
+    size_t live_bytes; /**< bytes currently allocated */
+    size_t live_count; /**< allocations not released yet */
+    uint64_t total_bytes; /**< bytes allocated since the start */
+    uint64_t total_count; /**< allocations since the start */
+    double byte_rate; /**< bytes allocated per second since the last call */
+    double count_rate; /**< allocations per second since the last call */
+};
+
+/**
+ * Takes a snapshot of the accounting.
+ *
+ * The entries are sorted by decreasing live bytes. The rates are computed
+ * over the time elapsed since the previous snapshot, they are zero in the
+ * first snapshot.
+ *
+ * @param entries pointer to the table of entries [OUT],
+ *                to be released with vlc_memstats_Release()
+ * @return the number of entries, 0 if the accounting is disabled,
+ *         or -1 on error
+ */
+VLC_API ssize_t vlc_memstats_Get(struct vlc_memstats_entry **entries) VLC_USED;
+
+/**
+ * Releases a table returned by vlc_memstats_Get().
+ */
+VLC_API void vlc_memstats_Release(struct vlc_memstats_entry *entries,
+                                  size_t count);
+
+/** @} */
+
+#endif /* !VLC_MEMSTATS_H */
@@ -287,6 +287,38 @@ VLC_API void picture_Copy( picture_t *p_dst, const picture_t *p_src );
  */
 VLC_API picture_t *picture_Clone(picture_t *pic);
 
+/**
+ * Makes a picture writable
+ *
+ * The planes of a picture may be shared with other pictures, e.g. after
+ * picture_Hold(), picture_Clone() or picture_CloneRegion(). A filter
+ * modifying the pixels in place must first call this function: if the planes
+ * are shared, they are copied into a new picture, otherwise the picture is
+ * returned as is.
+ *
+ * \param pic picture to modify (the reference is consumed)
+ * \return a picture with planes owned exclusively, or NULL on error.
+ */
+VLC_API picture_t *picture_MakeWritable(picture_t *pic);
+
+/**
+ * Creates a picture sharing a region of the planes of another picture
+ *
+ * No pixels are copied: the planes of the new picture point inside the
+ * planes of the original one, from the (x, y) position, with the dimensions
+ * given by fmt. The region must fit inside the original planes, and x and y
+ * should be multiples of the chroma subsampling.
+ *
+ * The pixels are shared: use picture_MakeWritable() before modifying them.
+ * Only the properties of the format are set, the dynamic properties must be
+ * copied with picture_CopyProperties().
+ *
+ * \return the new picture on success, NULL on error or if the chroma has no
+ * planes (opaque pictures).
+ */
+VLC_API picture_t *picture_CloneRegion(picture_t *pic, const video_format_t *fmt,
+                                       unsigned x, unsigned y);
+
 /**
  * This function will export a picture to an encoded bitstream.
  *
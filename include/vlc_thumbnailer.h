@@ -43,6 +43,23 @@ typedef struct vlc_thumbnailer_request_t vlc_thumbnailer_request_t;
  */
 typedef void(*vlc_thumbnailer_cb)( void* data, picture_t* thumbnail );
 
+/**
+ * \brief vlc_thumbnailer_batch_cb defines a callback invoked for each
+ * thumbnail of a batch request, see \link vlc_thumbnailer_RequestBatch \endlink
+ *
+ * This callback is called once for each requested time, in order, unless the
+ * request is cancelled. The picture follows the same rules as with
+ * \link vlc_thumbnailer_cb \endlink.
+ *
+ * \param data Is the opaque pointer passed as vlc_thumbnailer_RequestBatch
+ *             last parameter
+ * \param index The index of the time the thumbnail was requested at
+ * \param thumbnail The generated thumbnail, or NULL in case of failure or
+ *                  timeout
+ */
+typedef void(*vlc_thumbnailer_batch_cb)( void* data, size_t index,
+                                         picture_t* thumbnail );
+
 
 /**
  * \brief vlc_thumbnailer_Create Creates a thumbnailer object
@@ -112,6 +129,37 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                               input_item_t *input_item, vlc_tick_t timeout,
                               vlc_thumbnailer_cb cb, void* user_data );
 
+/**
+ * \brief vlc_thumbnailer_RequestBatch Requests thumbnails at several times
+ * \param thumbnailer A thumbnailer object
+ * \param times The times at which the thumbnails should be taken
+ * \param count The number of times
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param input_item The input item to generate the thumbnails for
+ * \param timeout A timeout value for the whole batch, or VLC_TICK_INVALID to
+ *                disable timeout
+ * \param cb A user callback to be called for each thumbnail
+ * \param user_data An opaque value, provided as pf_cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The input is opened once, then seeked to each time in turn, which is much
+ * faster than one request per time (for a preview strip, for instance). Times
+ * should be given in increasing order. With VLC_THUMBNAILER_SEEK_FAST, the
+ * pictures are also decoded with lower quality settings, when the decoder
+ * supports it.
+ *
+ * The callbacks are guaranteed to be called, as with
+ * \link vlc_thumbnailer_RequestByTime \endlink. The returned request object
+ * must not be used after the last callback has been invoked.
+ * The times array is copied.
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data );
+
 /**
  * \brief vlc_thumbnailer_Cancel Cancel a thumbnail request
  * \param thumbnailer A thumbnailer object
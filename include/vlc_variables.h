@@ -240,6 +240,28 @@ VLC_API int var_Inherit( vlc_object_t *, const char *, int, vlc_value_t * );
 VLC_API void var_AddCallback(vlc_object_t *obj, const char *name,
                              vlc_callback_t callback, void *opaque);
 
+/**
+ * Registers a deferred callback for a variable.
+ *
+ * This is the same as var_AddCallback(), except that the callback is run
+ * asynchronously, from a LibVLC thread dedicated to deferred callbacks, so
+ * that a slow callback does not delay the thread changing the variable.
+ *
+ * Changes are merged while the callback has not been run yet: the callback
+ * gets the value from before the first change, and the latest value. The
+ * variable may have changed again by the time the callback runs.
+ *
+ * var_DelCallback() removes deferred callbacks too. Once it returns, the
+ * callback is not running and will not be called anymore (unless
+ * var_DelCallback() is called from the callback itself).
+ *
+ * 
+ote Deferred callbacks must not block, as they are run in turn from a
+ * single thread.
+ */
+VLC_API void var_AddDeferredCallback(vlc_object_t *obj, const char *name,
+                                     vlc_callback_t callback, void *opaque);
+
 /**
  * Deregisters a callback from a variable.
  *
@@ -778,6 +800,8 @@ VLC_API int var_LocationParse(vlc_object_t *, const char *mrl, const char *prefi
 
 #define var_AddCallback(a,b,c,d) var_AddCallback(VLC_OBJECT(a), b, c, d)
 #define var_DelCallback(a,b,c,d) var_DelCallback(VLC_OBJECT(a), b, c, d)
+#define var_AddDeferredCallback(a,b,c,d) \
+        var_AddDeferredCallback(VLC_OBJECT(a), b, c, d)
 #define var_TriggerCallback(a,b) var_TriggerCallback(VLC_OBJECT(a), b)
 #define var_AddListCallback(a,b,c,d) \
         var_AddListCallback(VLC_OBJECT(a), b, c, d)
@@ -126,6 +126,39 @@ VLC_API int vout_GetSnapshot( vout_thread_t *p_vout,
                               video_format_t *p_fmt,
                               const char *psz_format, vlc_tick_t i_timeout );
 
+/**
+ * Asynchronous snapshot completion callback.
+ *
+ * \param data the opaque pointer given to vout_GetSnapshotAsync()
+ * \param image the encoded picture, to be released by the callee, or NULL
+ * on error
+ * \param fmt the format of the picture before encoding (only valid during
+ * the call), or NULL on error
+ */
+typedef void (*vout_snapshot_cb)( void *data, block_t *image,
+                                  const video_format_t *fmt );
+
+/**
+ * This function will request a snapshot without waiting for it.
+ *
+ * The next displayed picture is encoded in psz_format format on a background
+ * thread shared with the other video outputs, so that the caller and the
+ * video output thread are not stalled.
+ *
+ * i_width/i_height allow to reduce the resolution of the encoded picture,
+ * as in picture_Export().
+ *
+ * On success, the callback is invoked exactly once, with a NULL image if no
+ * snapshot could be taken (e.g. the video output was stopped). It may be
+ * invoked from any thread.
+ *
+ * \return VLC_SUCCESS, or an error if too many snapshots are pending
+ */
+VLC_API int vout_GetSnapshotAsync( vout_thread_t *p_vout,
+                                   const char *psz_format,
+                                   int i_width, int i_height,
+                                   vout_snapshot_cb cb, void *data );
+
 /* */
 VLC_API picture_t * vout_GetPicture( vout_thread_t * );
 VLC_API void vout_PutPicture( vout_thread_t *, picture_t * );
@@ -228,6 +228,7 @@ struct vout_display_owner_t {
      * from multiple threads.
      */
     void (*viewpoint_moved)(void *sys, const vlc_viewpoint_t *vp);
+    void (*presented)(void *sys, vlc_tick_t date, vlc_tick_t refresh);
 };
 
 /**
@@ -346,6 +347,21 @@ struct vout_display_t {
      */
     int        (*control)(vout_display_t *, int query, va_list);
 
+    /**
+     * Allocates pictures for the decoder to render into (optional).
+     *
+     * The pictures are in the source format, and are displayed without copy
+     * when they come back unconverted. This is called with the display
+     * locked, from a decoder thread.
+     *
+     * The pool and its pictures must remain valid until they are released,
+     * even after the display is closed.
+     *
+     * \param count number of pictures
+     * \return a picture pool, or NULL if none can be provided
+     */
+    picture_pool_t *(*pool)(vout_display_t *, unsigned count);
+
     /**
      * Destroys the display.
      */
@@ -438,6 +454,25 @@ static inline void vout_display_SendEventViewpointMoved(vout_display_t *vd,
         vd->owner.viewpoint_moved(vd->owner.sys, vp);
 }
 
+/**
+ * Reports when the last displayed picture reached the screen.
+ *
+ * Display modules that get presentation feedback from the system (e.g.
+ * Wayland presentation-time, DXGI frame statistics or EGL/GLX timestamps)
+ * should call this once per displayed picture. The video output then
+ * accounts the presentation error, and aligns the pictures on the refresh.
+ *
+ * \param date presentation date, in the vlc_tick_now() time base
+ * \param refresh duration of the refresh cycle, or 0 if unknown
+ */
+static inline void vout_display_SendEventPresented(vout_display_t *vd,
+                                                   vlc_tick_t date,
+                                                   vlc_tick_t refresh)
+{
+    if (vd->owner.presented)
+        vd->owner.presented(vd->owner.sys, date, refresh);
+}
+
 /**
  * Helper function that applies the necessary transforms to the mouse position
  * and then calls vout_display_SendEventMouseMoved.
@@ -726,6 +726,13 @@ bool libvlc_media_get_stats(libvlc_media_t *p_md,
     p_stats->i_played_abuffers = p_itm_stats->i_played_abuffers;
     p_stats->i_lost_abuffers = p_itm_stats->i_lost_abuffers;
 
+    static_assert(LIBVLC_MEDIA_LATENCY_STAGES == INPUT_LATENCY_STAGES
+               && LIBVLC_MEDIA_LATENCY_BUCKETS == INPUT_LATENCY_BUCKETS,
+                  "latency histograms mismatch");
+    for( size_t i = 0; i < LIBVLC_MEDIA_LATENCY_STAGES; i++ )
+        for( size_t j = 0; j < LIBVLC_MEDIA_LATENCY_BUCKETS; j++ )
+            p_stats->latency[i][j] = p_itm_stats->latency[i].buckets[j];
+
     vlc_mutex_unlock( &item->lock );
     return true;
 }
@@ -796,6 +803,8 @@ static int media_parse(libvlc_media_t *media, bool b_async,
             parse_scope |= META_REQUEST_OPTION_FETCH_NETWORK;
         if (parse_flag & libvlc_media_do_interact)
             parse_scope |= META_REQUEST_OPTION_DO_INTERACT;
+        if (parse_flag & libvlc_media_parse_background)
+            parse_scope |= META_REQUEST_OPTION_BACKGROUND;
 
         ret = libvlc_MetadataRequest(libvlc, item, parse_scope,
                                      &input_preparser_callbacks, media,
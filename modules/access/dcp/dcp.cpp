@@ -42,6 +42,10 @@
 
 #define KDM_HELP_TEXT          N_("KDM file")
 #define KDM_HELP_LONG_TEXT     N_("Path to Key Delivery Message XML file")
+#define THREADS_TEXT           N_("Reading threads")
+#define THREADS_LONGTEXT       N_("Number of threads reading and decrypting " \
+                                  "the picture frames ahead of the playback " \
+                                  "(0 for automatic).")
 
 /* VLC core API headers */
 #include <vlc_common.h>
@@ -50,6 +54,7 @@
 #include <vlc_xml.h>
 #include <vlc_url.h>
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
 
 #ifdef _WIN32
 # define KM_WIN32
@@ -59,6 +64,7 @@
 #include <AS_DCP.h>
 
 #include <vector>
+#include <deque>
 
 #include "dcpparser.h"
 
@@ -67,6 +73,8 @@ using namespace ASDCP;
 #define FRAME_BUFFER_SIZE 1302083 /* maximum frame length, in bytes, after
                                      "Digital Cinema System Specification Version 1.2
                                      with Errata as of 30 August 2012" */
+#define PREFETCH_MAX_THREADS 4 /* automatic number of reading threads */
+#define PREFETCH_FRAMES 2      /* frames read ahead, per thread */
 
 /* Forward declarations */
 static int Open( vlc_object_t * );
@@ -77,6 +85,8 @@ vlc_module_begin()
     set_shortname( N_( "DCP" ) )
     add_shortcut( "dcp" )
     add_loadfile("kdm", "", KDM_HELP_TEXT, KDM_HELP_LONG_TEXT)
+    add_integer_with_range( "dcp-threads", 0, 0, 16, THREADS_TEXT,
+                            THREADS_LONGTEXT, true )
     set_description( N_( "Digital Cinema Package module" ) )
     set_capability( "access", 0 )
     set_category( CAT_INPUT )
@@ -110,6 +120,392 @@ struct audioReader_t
     PCM::MXFReader *p_AudioMXFReader;
 };
 
+/*****************************************************************************
+ * Picture reading helpers
+ *****************************************************************************/
+
+static bool OpenPictureReader( EssenceType_t type, const char *psz_filename,
+                               videoReader_t *p_reader )
+{
+    Result_t result;
+
+    switch( type )
+    {
+        case ESS_JPEG_2000:
+            p_reader->p_PicMXFReader = new ( nothrow ) JP2K::MXFReader();
+            if( !p_reader->p_PicMXFReader )
+                return false;
+            result = p_reader->p_PicMXFReader->OpenRead( psz_filename );
+            break;
+        case ESS_JPEG_2000_S:
+            p_reader->p_PicMXFSReader = new ( nothrow ) JP2K::MXFSReader();
+            if( !p_reader->p_PicMXFSReader )
+                return false;
+            result = p_reader->p_PicMXFSReader->OpenRead( psz_filename );
+            break;
+        case ESS_MPEG2_VES:
+            p_reader->p_VideoMXFReader = new ( nothrow ) MPEG2::MXFReader();
+            if( !p_reader->p_VideoMXFReader )
+                return false;
+            result = p_reader->p_VideoMXFReader->OpenRead( psz_filename );
+            break;
+        default:
+            p_reader->p_PicMXFReader = NULL;
+            return false;
+    }
+    return ASDCP_SUCCESS( result );
+}
+
+static void ClosePictureReader( EssenceType_t type, videoReader_t *p_reader )
+{
+    switch( type )
+    {
+        case ESS_JPEG_2000:
+            delete p_reader->p_PicMXFReader;
+            break;
+        case ESS_JPEG_2000_S:
+            delete p_reader->p_PicMXFSReader;
+            break;
+        case ESS_MPEG2_VES:
+            delete p_reader->p_VideoMXFReader;
+            break;
+        default:
+            break;
+    }
+    p_reader->p_PicMXFReader = NULL;
+}
+
+/**
+ * Reads (and decrypts) a picture frame.
+ * @param i_frame Frame number, relative to the MXF file.
+ * @return The frame, NULL on error.
+ */
+static block_t *ReadPictureFrame( EssenceType_t type, videoReader_t reader,
+                                  uint32_t i_frame, AESDecContext *p_aes_ctx )
+{
+    block_t *p_frame = block_Alloc( FRAME_BUFFER_SIZE );
+    if( p_frame == NULL )
+        return NULL;
+
+    switch( type )
+    {
+        case ESS_JPEG_2000:
+        case ESS_JPEG_2000_S: {
+            JP2K::FrameBuffer PicFrameBuff;
+            Result_t result = PicFrameBuff.SetData( p_frame->p_buffer, FRAME_BUFFER_SIZE );
+            if( ASDCP_SUCCESS( result ) )
+            {
+                if( type == ESS_JPEG_2000_S )
+                    result = reader.p_PicMXFSReader->ReadFrame( i_frame, JP2K::SP_LEFT,
+                                                    PicFrameBuff, p_aes_ctx, 0 );
+                else
+                    result = reader.p_PicMXFReader->ReadFrame( i_frame, PicFrameBuff,
+                                                               p_aes_ctx, 0 );
+            }
+            p_frame->i_buffer = PicFrameBuff.Size();
+            PicFrameBuff.SetData( 0, 0 );
+            if( ASDCP_SUCCESS( result ) )
+                return p_frame;
+            break;
+        }
+        case ESS_MPEG2_VES: {
+            MPEG2::FrameBuffer VideoFrameBuff;
+            Result_t result = VideoFrameBuff.SetData( p_frame->p_buffer, FRAME_BUFFER_SIZE );
+            if( ASDCP_SUCCESS( result ) )
+                result = reader.p_VideoMXFReader->ReadFrame( i_frame, VideoFrameBuff,
+                                                             p_aes_ctx, 0 );
+            p_frame->i_buffer = VideoFrameBuff.Size();
+            VideoFrameBuff.SetData( 0, 0 );
+            if( ASDCP_SUCCESS( result ) )
+                return p_frame;
+            break;
+        }
+        default:
+            break;
+    }
+    block_Release( p_frame );
+    return NULL;
+}
+
+/*****************************************************************************
+ * Picture prefetcher
+ *****************************************************************************/
+
+/**
+ * Reads and decrypts the picture frames ahead of the demux, on a pool of
+ * threads. The asdcp readers are not thread-safe, so each thread opens its
+ * own reader and keeps its own AES context, initialized once per reel.
+ * The frames are delivered in order.
+ */
+class picturePrefetcher_t
+{
+ public:
+    picturePrefetcher_t( demux_t *p_demux, EssenceType_t type, dcp_t *p_dcp ):
+        p_demux( p_demux ),
+        type( type ),
+        p_dcp( p_dcp ),
+        i_ahead( 0 ),
+        i_next_frame( 0 ),
+        i_next_reel( 0 ),
+        b_stop( false )
+    {
+        vlc_mutex_init( &lock );
+        vlc_cond_init( &wait_request );
+        vlc_cond_init( &wait_frame );
+    }
+
+    ~picturePrefetcher_t()
+    {
+        vlc_mutex_lock( &lock );
+        b_stop = true;
+        vlc_cond_broadcast( &wait_request );
+        vlc_mutex_unlock( &lock );
+
+        for( size_t i = 0; i < workers.size(); i++ )
+        {
+            vlc_join( workers[i]->thread, NULL );
+            ClosePictureReader( type, &workers[i]->reader );
+            delete workers[i];
+        }
+        Flush();
+    }
+
+    bool Start( unsigned i_threads )
+    {
+        for( unsigned i = 0; i < i_threads; i++ )
+        {
+            worker_t *p_worker = new ( nothrow ) worker_t( this );
+            if( unlikely( p_worker == NULL ) )
+                break;
+            if( vlc_clone( &p_worker->thread, Run, p_worker,
+                           VLC_THREAD_PRIORITY_INPUT ) )
+            {
+                delete p_worker;
+                break;
+            }
+            workers.push_back( p_worker );
+        }
+        i_ahead = workers.size() * PREFETCH_FRAMES;
+        return !workers.empty();
+    }
+
+    /**
+     * Returns the frame at the given absolute number, waiting for it if
+     * needed. Seeking restarts the reading from the requested frame.
+     * @return The frame, NULL on error.
+     */
+    block_t *Get( uint32_t frame_no )
+    {
+        vlc_mutex_lock( &lock );
+        if( queue.empty() || queue.front()->frame_no != frame_no )
+        {
+            Flush();
+            i_next_frame = frame_no;
+            i_next_reel = 0;
+            Schedule();
+            if( queue.empty() )
+            {
+                vlc_mutex_unlock( &lock );
+                return NULL;
+            }
+        }
+
+        frame_t *p_frame = queue.front();
+        while( p_frame->state == FRAME_PENDING || p_frame->state == FRAME_READING )
+            vlc_cond_wait( &wait_frame, &lock );
+        queue.pop_front();
+        Schedule();
+        vlc_mutex_unlock( &lock );
+
+        block_t *p_block = p_frame->p_block;
+        delete p_frame;
+        return p_block;
+    }
+
+ private:
+    enum frameState_t
+    {
+        FRAME_PENDING,
+        FRAME_READING,
+        FRAME_READY,
+        FRAME_FAILED,
+    };
+
+    struct frame_t
+    {
+        uint32_t frame_no;
+        unsigned int i_reel;
+        frameState_t state;
+        /* dropped by a seek while being read */
+        bool b_abandoned;
+        block_t *p_block;
+    };
+
+    struct worker_t
+    {
+        worker_t( picturePrefetcher_t *p_owner ):
+            p_owner( p_owner ),
+            i_reel( -1 ),
+            i_key_reel( -1 )
+        {
+            reader.p_PicMXFReader = NULL;
+        }
+
+        picturePrefetcher_t *p_owner;
+        vlc_thread_t thread;
+
+        /* reader of the current reel */
+        videoReader_t reader;
+        int i_reel;
+
+        /* AES context, initialized for the key of the reel i_key_reel */
+        AESDecContext aes_ctx;
+        int i_key_reel;
+    };
+
+    /* Queues the next frames to read, called with the lock held */
+    void Schedule()
+    {
+        const std::vector<info_reel> &reels = p_dcp->video_reels;
+
+        while( queue.size() < i_ahead )
+        {
+            while( i_next_reel < reels.size()
+                && i_next_frame >= reels[i_next_reel].i_absolute_end )
+                i_next_reel++;
+            if( i_next_reel >= reels.size() )
+                break;
+
+            frame_t *p_frame = new ( nothrow ) frame_t;
+            if( unlikely( p_frame == NULL ) )
+                break;
+            p_frame->frame_no = i_next_frame++;
+            p_frame->i_reel = i_next_reel;
+            p_frame->state = FRAME_PENDING;
+            p_frame->b_abandoned = false;
+            p_frame->p_block = NULL;
+            queue.push_back( p_frame );
+            vlc_cond_signal( &wait_request );
+        }
+    }
+
+    /* Drops the queued frames, called with the lock held */
+    void Flush()
+    {
+        for( size_t i = 0; i < queue.size(); i++ )
+        {
+            frame_t *p_frame = queue[i];
+            if( p_frame->state == FRAME_READING )
+            {
+                /* released by its worker */
+                p_frame->b_abandoned = true;
+                continue;
+            }
+            if( p_frame->p_block )
+                block_Release( p_frame->p_block );
+            delete p_frame;
+        }
+        queue.clear();
+    }
+
+    block_t *Read( worker_t *p_worker, const frame_t *p_frame )
+    {
+        const info_reel &reel = p_dcp->video_reels[p_frame->i_reel];
+
+        if( p_worker->i_reel != (int) p_frame->i_reel )
+        {
+            ClosePictureReader( type, &p_worker->reader );
+            p_worker->i_reel = -1;
+            if( !OpenPictureReader( type, reel.filename.c_str(), &p_worker->reader ) )
+            {
+                msg_Err( p_demux, "File %s could not be opened with ASDCP",
+                         reel.filename.c_str() );
+                ClosePictureReader( type, &p_worker->reader );
+                return NULL;
+            }
+            p_worker->i_reel = p_frame->i_reel;
+        }
+
+        if( reel.p_key && p_worker->i_key_reel != (int) p_frame->i_reel )
+        {
+            if( !ASDCP_SUCCESS( p_worker->aes_ctx.InitKey( reel.p_key->getKey() ) ) )
+            {
+                msg_Err( p_demux, "ASDCP failed to initialize AES key" );
+                return NULL;
+            }
+            p_worker->i_key_reel = p_frame->i_reel;
+        }
+
+        return ReadPictureFrame( type, p_worker->reader,
+                                 p_frame->frame_no + reel.i_correction,
+                                 &p_worker->aes_ctx );
+    }
+
+    static void *Run( void *data )
+    {
+        worker_t *p_worker = (worker_t *) data;
+        picturePrefetcher_t *p_this = p_worker->p_owner;
+
+        vlc_mutex_lock( &p_this->lock );
+        for( ;; )
+        {
+            frame_t *p_frame = NULL;
+            while( !p_this->b_stop )
+            {
+                for( size_t i = 0; i < p_this->queue.size(); i++ )
+                {
+                    if( p_this->queue[i]->state == FRAME_PENDING )
+                    {
+                        p_frame = p_this->queue[i];
+                        break;
+                    }
+                }
+                if( p_frame != NULL )
+                    break;
+                vlc_cond_wait( &p_this->wait_request, &p_this->lock );
+            }
+            if( p_this->b_stop )
+                break;
+
+            p_frame->state = FRAME_READING;
+            vlc_mutex_unlock( &p_this->lock );
+
+            block_t *p_block = p_this->Read( p_worker, p_frame );
+
+            vlc_mutex_lock( &p_this->lock );
+            if( p_frame->b_abandoned )
+            {
+                if( p_block )
+                    block_Release( p_block );
+                delete p_frame;
+                continue;
+            }
+            p_frame->p_block = p_block;
+            p_frame->state = p_block ? FRAME_READY : FRAME_FAILED;
+            vlc_cond_broadcast( &p_this->wait_frame );
+        }
+        vlc_mutex_unlock( &p_this->lock );
+        return NULL;
+    }
+
+    demux_t *p_demux;
+    EssenceType_t type;
+    dcp_t *p_dcp;
+
+    std::vector<worker_t *> workers;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait_request;
+    vlc_cond_t wait_frame;
+
+    /* frames being read, in presentation order */
+    std::deque<frame_t *> queue;
+    size_t i_ahead;
+    uint32_t i_next_frame;
+    unsigned int i_next_reel;
+    bool b_stop;
+};
+
 /* ASDCP library (version 1.10.48) can handle files having one of the following Essence Types, as defined in AS_DCP.h:
     ESS_UNKNOWN,     // the file is not a supported AS-DCP essence container
     ESS_MPEG2_VES,   // the file contains an MPEG video elementary stream
@@ -166,6 +562,16 @@ class demux_sys_t
 
     vlc_tick_t i_pts;
 
+    /* AES contexts, initialized for the key of the reels i_video_key_reel
+     * and i_audio_key_reel */
+    AESDecContext video_aes_ctx;
+    AESDecContext audio_aes_ctx;
+    int i_video_key_reel;
+    int i_audio_key_reel;
+
+    /* picture frames read ahead, NULL if read on the demux thread */
+    picturePrefetcher_t *p_prefetcher;
+
     demux_sys_t():
         PictureEssType ( ESS_UNKNOWN ),
         v_videoReader(),
@@ -177,11 +583,16 @@ class demux_sys_t
         frames_total( 0 ),
         i_video_reel( 0 ),
         i_audio_reel( 0 ),
-        i_pts( 0 )
+        i_pts( 0 ),
+        i_video_key_reel( -1 ),
+        i_audio_key_reel( -1 ),
+        p_prefetcher( NULL )
     {}
 
     ~demux_sys_t()
     {
+        delete p_prefetcher;
+
         switch ( PictureEssType )
         {
             case ESS_UNKNOWN:
@@ -584,6 +995,21 @@ static int Open( vlc_object_t *obj )
     p_demux->pf_control = Control;
     p_sys->frame_no = p_sys->p_dcp->video_reels[0].i_entrypoint;
 
+    /* read and decrypt the picture frames ahead, the readers of the demux
+     * thread are then only used for the descriptors */
+    unsigned i_threads;
+    i_threads = var_InheritInteger( p_demux, "dcp-threads" );
+    if( i_threads == 0 )
+        i_threads = __MIN( vlc_GetCPUCount(), PREFETCH_MAX_THREADS );
+    p_sys->p_prefetcher = new ( nothrow ) picturePrefetcher_t( p_demux,
+                                    p_sys->PictureEssType, p_sys->p_dcp );
+    if( p_sys->p_prefetcher && !p_sys->p_prefetcher->Start( i_threads ) )
+    {
+        msg_Warn( p_demux, "cannot start the reading threads" );
+        delete p_sys->p_prefetcher;
+        p_sys->p_prefetcher = NULL;
+    }
+
     return VLC_SUCCESS;
 error:
     CloseDcpAndMxf( p_demux );
@@ -611,7 +1037,6 @@ static int Demux( demux_t *p_demux )
     block_t *p_video_frame = NULL, *p_audio_frame = NULL;
 
     PCM::FrameBuffer   AudioFrameBuff( p_sys->i_audio_buffer);
-    AESDecContext video_aes_ctx, audio_aes_ctx;
 
     /* swaping video reels */
     if  ( p_sys->frame_no == p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_absolute_end )
@@ -640,67 +1065,33 @@ static int Demux( demux_t *p_demux )
      }
 
     /* video frame */
-
-    /* initialize AES context, if reel is encrypted */
-    if( p_sys->p_dcp->video_reels.size() > p_sys->i_video_reel &&
-        p_sys->p_dcp->video_reels[p_sys->i_video_reel].p_key )
+    if( p_sys->p_prefetcher )
     {
-        if( ! ASDCP_SUCCESS( video_aes_ctx.InitKey( p_sys->p_dcp->video_reels[p_sys->i_video_reel].p_key->getKey() ) ) )
-        {
-            msg_Err( p_demux, "ASDCP failed to initialize AES key" );
-            goto error;
-        }
+        p_video_frame = p_sys->p_prefetcher->Get( p_sys->frame_no );
+        if( p_video_frame == NULL )
+            goto error_asdcp;
     }
-
-    switch( p_sys->PictureEssType )
+    else
     {
-        case ESS_JPEG_2000:
-        case ESS_JPEG_2000_S:{
-            JP2K::FrameBuffer  PicFrameBuff(FRAME_BUFFER_SIZE);
-            int nextFrame = p_sys->frame_no + p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_correction;
-            if ( ( p_video_frame = block_Alloc( FRAME_BUFFER_SIZE )) == NULL )
+        /* initialize AES context, if reel is encrypted */
+        if( p_sys->p_dcp->video_reels.size() > p_sys->i_video_reel &&
+            p_sys->p_dcp->video_reels[p_sys->i_video_reel].p_key &&
+            p_sys->i_video_key_reel != (int) p_sys->i_video_reel )
+        {
+            if( ! ASDCP_SUCCESS( p_sys->video_aes_ctx.InitKey( p_sys->p_dcp->video_reels[p_sys->i_video_reel].p_key->getKey() ) ) )
+            {
+                msg_Err( p_demux, "ASDCP failed to initialize AES key" );
                 goto error;
-
-            if ( ! ASDCP_SUCCESS(
-                    PicFrameBuff.SetData(p_video_frame->p_buffer, FRAME_BUFFER_SIZE)) )
-                goto error_asdcp;
-            if ( p_sys->PictureEssType == ESS_JPEG_2000_S ) {
-                if ( ! ASDCP_SUCCESS(
-                        p_sys->v_videoReader[p_sys->i_video_reel].p_PicMXFSReader->ReadFrame(nextFrame, JP2K::SP_LEFT, PicFrameBuff, &video_aes_ctx, 0)) ) {
-                    PicFrameBuff.SetData(0,0);
-                    goto error_asdcp;
-                }
-             } else {
-                if ( ! ASDCP_SUCCESS(
-                        p_sys->v_videoReader[p_sys->i_video_reel].p_PicMXFReader->ReadFrame(nextFrame, PicFrameBuff, &video_aes_ctx, 0)) ) {
-                    PicFrameBuff.SetData(0,0);
-                    goto error_asdcp;
-                }
             }
-            p_video_frame->i_buffer = PicFrameBuff.Size();
-            break;
+            p_sys->i_video_key_reel = p_sys->i_video_reel;
         }
-        case ESS_MPEG2_VES: {
-            MPEG2::FrameBuffer VideoFrameBuff(FRAME_BUFFER_SIZE);
-            if ( ( p_video_frame = block_Alloc( FRAME_BUFFER_SIZE )) == NULL )
-                goto error;
-
-            if ( ! ASDCP_SUCCESS(
-                    VideoFrameBuff.SetData(p_video_frame->p_buffer, FRAME_BUFFER_SIZE)) )
-                goto error_asdcp;
-
-            if ( ! ASDCP_SUCCESS(
-                    p_sys->v_videoReader[p_sys->i_video_reel].p_VideoMXFReader->ReadFrame(p_sys->frame_no + p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_correction, VideoFrameBuff, &video_aes_ctx, 0)) ) {
-                VideoFrameBuff.SetData(0,0);
-                goto error_asdcp;
-            }
 
-            p_video_frame->i_buffer = VideoFrameBuff.Size();
-            break;
-        }
-        default:
-            msg_Err( p_demux, "Unrecognized video format" );
-            goto error;
+        p_video_frame = ReadPictureFrame( p_sys->PictureEssType,
+                p_sys->v_videoReader[p_sys->i_video_reel],
+                p_sys->frame_no + p_sys->p_dcp->video_reels[p_sys->i_video_reel].i_correction,
+                &p_sys->video_aes_ctx );
+        if( p_video_frame == NULL )
+            goto error_asdcp;
     }
 
     p_video_frame->i_length = vlc_tick_from_samples(p_sys->frame_rate_denom, p_sys->frame_rate_num);
@@ -715,13 +1106,15 @@ static int Demux( demux_t *p_demux )
 
         /* initialize AES context, if reel is encrypted */
         if( p_sys->p_dcp->audio_reels.size() > p_sys->i_audio_reel &&
-            p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].p_key )
+            p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].p_key &&
+            p_sys->i_audio_key_reel != (int) p_sys->i_audio_reel )
         {
-            if( ! ASDCP_SUCCESS( audio_aes_ctx.InitKey( p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].p_key->getKey() ) ) )
+            if( ! ASDCP_SUCCESS( p_sys->audio_aes_ctx.InitKey( p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].p_key->getKey() ) ) )
             {
                 msg_Err( p_demux, "ASDCP failed to initialize AES key" );
                 goto error;
             }
+            p_sys->i_audio_key_reel = p_sys->i_audio_reel;
         }
 
         if ( ! ASDCP_SUCCESS(
@@ -730,7 +1123,7 @@ static int Demux( demux_t *p_demux )
         }
 
         if ( ! ASDCP_SUCCESS(
-                p_sys->v_audioReader[p_sys->i_audio_reel].p_AudioMXFReader->ReadFrame(p_sys->frame_no + p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].i_correction, AudioFrameBuff, &audio_aes_ctx, 0)) ) {
+                p_sys->v_audioReader[p_sys->i_audio_reel].p_AudioMXFReader->ReadFrame(p_sys->frame_no + p_sys->p_dcp->audio_reels[p_sys->i_audio_reel].i_correction, AudioFrameBuff, &p_sys->audio_aes_ctx, 0)) ) {
             AudioFrameBuff.SetData(0,0);
             goto error_asdcp;
         }
@@ -45,6 +45,7 @@
 #include "sdi.h"
 
 #include <atomic>
+#include <new>
 
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
@@ -313,6 +314,36 @@ private:
     demux_t *demux_;
 };
 
+/* Block referencing the memory of a captured frame or audio packet: the
+ * frame is held, and given back to the driver when the block is released */
+struct decklink_frame_block
+{
+    block_t self;
+    IUnknown *frame;
+};
+
+static void DeckLinkFrameBlockRelease(block_t *block)
+{
+    decklink_frame_block *b = container_of(block, decklink_frame_block, self);
+    b->frame->Release();
+    delete b;
+}
+
+static const struct vlc_block_callbacks decklink_frame_cbs =
+{
+    DeckLinkFrameBlockRelease,
+};
+
+static block_t *DeckLinkFrameBlock(IUnknown *frame, void *buf, size_t size)
+{
+    decklink_frame_block *b = new (std::nothrow) decklink_frame_block;
+    if (!b)
+        return NULL;
+    frame->AddRef();
+    b->frame = frame;
+    return block_Init(&b->self, &decklink_frame_cbs, buf, size);
+}
+
 } // namespace
 
 HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioFrame)
@@ -340,13 +371,20 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
                 bpp = 2;
                 break;
         };
-        block_t *video_frame = block_Alloc(width * height * bpp);
-        if (!video_frame)
-            return S_OK;
-
         const uint32_t *frame_bytes;
         videoFrame->GetBytes((void**)&frame_bytes);
 
+        /* The frames not needing conversion nor repacking are referenced
+         * in the buffers the driver captured them in, not copied */
+        block_t *video_frame;
+        if (sys->video_fmt.i_codec != VLC_CODEC_I422_10L && stride == width * bpp)
+            video_frame = DeckLinkFrameBlock(videoFrame, (void *)frame_bytes,
+                                             width * height * bpp);
+        else
+            video_frame = block_Alloc(width * height * bpp);
+        if (!video_frame)
+            return S_OK;
+
         BMDTimeValue stream_time, frame_duration;
         videoFrame->GetStreamTime(&stream_time, &frame_duration, CLOCK_FREQ);
         video_frame->i_flags = BLOCK_FLAG_TYPE_I | sys->dominance_flags;
@@ -385,6 +423,8 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
                 }
                 vanc->Release();
             }
+        } else if (video_frame->cbs == &decklink_frame_cbs) {
+            /* referenced */
         } else if (sys->video_fmt.i_codec == VLC_CODEC_UYVY) {
             for (int y = 0; y < height; ++y) {
                 const uint8_t *src = (const uint8_t *)frame_bytes + stride * y;
@@ -435,10 +475,9 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
         }
         else
         {
-            block_t *audio_frame = block_Alloc(bytes);
+            block_t *audio_frame = DeckLinkFrameBlock(audioFrame, frame_bytes, bytes);
             if (!audio_frame)
                 return S_OK;
-            memcpy(audio_frame->p_buffer, frame_bytes, bytes);
             audio_frame->i_pts = audio_frame->i_dts = VLC_TICK_0 + packet_time;
             es_out_Send(demux_->out, sys->audio_es[0], audio_frame);
         }
@@ -115,6 +115,33 @@ void DirClose(vlc_object_t *obj)
     closedir(sys->dir);
 }
 
+/* Reads the next entry name, and its file type when the file system reports
+ * it along the name, which saves a stat() call per entry. */
+static const char *DirReadEntry(DIR *dir, mode_t *restrict mode)
+{
+#if defined(HAVE_FSTATAT) && defined(DT_UNKNOWN) && !defined(__OS2__)
+    struct dirent *ent = readdir(dir);
+    if (ent == NULL)
+        return NULL;
+
+    switch (ent->d_type)
+    {
+        case DT_REG:
+            *mode = S_IFREG;
+            break;
+        case DT_DIR:
+            *mode = S_IFDIR;
+            break;
+        default: /* unknown, special or symbolic link to follow */
+            *mode = 0;
+    }
+    return ent->d_name;
+#else
+    *mode = 0;
+    return vlc_readdir(dir);
+#endif
+}
+
 int DirRead (stream_t *access, input_item_node_t *node)
 {
     access_sys_t *sys = access->p_sys;
@@ -126,22 +153,30 @@ int DirRead (stream_t *access, input_item_node_t *node)
     struct vlc_readdir_helper rdh;
     vlc_readdir_helper_init(&rdh, access, node);
 
-    while (ret == VLC_SUCCESS && (entry = vlc_readdir(sys->dir)) != NULL)
+    mode_t mode;
+
+    while (ret == VLC_SUCCESS
+        && (entry = DirReadEntry(sys->dir, &mode)) != NULL)
     {
-        struct stat st;
         int type;
 
+        if (mode == 0)
+        {
+            struct stat st;
 #ifdef HAVE_FSTATAT
-        if (fstatat(dirfd(sys->dir), entry, &st, 0))
-            continue;
+            if (fstatat(dirfd(sys->dir), entry, &st, 0))
+                continue;
 #else
-        char path[PATH_MAX];
+            char path[PATH_MAX];
 
-        if (snprintf(path, PATH_MAX, "%s"DIR_SEP"%s", access->psz_filepath,
-                     entry) >= PATH_MAX || vlc_stat(path, &st))
-            continue;
+            if (snprintf(path, PATH_MAX, "%s"DIR_SEP"%s", access->psz_filepath,
+                         entry) >= PATH_MAX || vlc_stat(path, &st))
+                continue;
 #endif
-        switch (st.st_mode & S_IFMT)
+            mode = st.st_mode;
+        }
+
+        switch (mode & S_IFMT)
         {
 #ifdef S_IFBLK
             case S_IFBLK:
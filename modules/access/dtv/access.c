@@ -48,6 +48,11 @@
     "Only useful programs are normally demultiplexed from the transponder. " \
     "This option will disable demultiplexing and receive all programs.")
 
+#define BUFFER_SIZE_TEXT N_("Demultiplexer buffer size")
+#define BUFFER_SIZE_LONGTEXT N_( \
+    "Size of the kernel buffer of the demultiplexer, in bytes. " \
+    "Increase it if data is lost at high bit rates.")
+
 #define NAME_TEXT N_("Network name")
 #define NAME_LONGTEXT N_("Unique network name in the System Tuning Spaces")
 
@@ -263,6 +268,9 @@ vlc_module_begin ()
         change_integer_range (0, 255)
         change_safe ()
     add_bool ("dvb-budget-mode", false, BUDGET_TEXT, BUDGET_LONGTEXT, true)
+    add_integer ("dvb-buffer-size", 4 << 20, BUFFER_SIZE_TEXT,
+                 BUFFER_SIZE_LONGTEXT, true)
+        change_integer_range (188 << 10, 64 << 20)
 #endif
 #ifdef _WIN32
     add_integer ("dvb-adapter", -1, ADAPTER_TEXT, ADAPTER_LONGTEXT, true)
@@ -502,7 +510,9 @@ static void Close (vlc_object_t *obj)
 
 static block_t *Read (stream_t *access, bool *restrict eof)
 {
-#define BUFSIZE (20*188)
+/* Read as much as available at once: the device returns what it has, so
+ * large reads do not add latency, but save system calls at high rates. */
+#define BUFSIZE (348*188)
     block_t *block = block_Alloc (BUFSIZE);
     if (unlikely(block == NULL))
         return NULL;
@@ -179,6 +179,16 @@ static int dvb_open_node (dvb_device_t *d, const char *type, int flags)
     return vlc_openat (d->dir, path, flags | O_NONBLOCK);
 }
 
+/** Sets the size of the kernel buffer of a demux or DVR device */
+static void dvb_set_buffer_size (dvb_device_t *d, int fd)
+{
+    unsigned long size = var_InheritInteger (d->obj, "dvb-buffer-size");
+
+    if (ioctl (fd, DMX_SET_BUFFER_SIZE, size) < 0)
+        msg_Warn (d->obj, "cannot expand demultiplexing buffer: %s",
+                  vlc_strerror_c(errno));
+}
+
 /**
  * Opens the DVB tuner
  */
@@ -219,9 +229,7 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
            return NULL;
        }
 
-       if (ioctl (d->demux, DMX_SET_BUFFER_SIZE, 1 << 20) < 0)
-           msg_Warn (obj, "cannot expand demultiplexing buffer: %s",
-                     vlc_strerror_c(errno));
+       dvb_set_buffer_size (d, d->demux);
 
        /* We need to filter at least one PID. The tap for TS demultiplexing
         * cannot be configured otherwise. So add the PAT. */
@@ -252,6 +260,8 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
             free (d);
             return NULL;
         }
+        /* the filtered packets of all the PIDs are queued in the DVR */
+        dvb_set_buffer_size (d, d->demux);
 #endif
     }
 
@@ -42,6 +42,9 @@
 #   include <sys/vfs.h>
 #   include <linux/magic.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #if defined( _WIN32 )
 #   include <io.h>
@@ -61,12 +64,25 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 #include <vlc_interrupt.h>
+#include <vlc_block.h>
+
+/* Size of the blocks mapped from the file, and of the read-ahead
+ * requested past the current block */
+#define MMAP_BLOCK_SIZE (1 << 20)
+#define MMAP_READAHEAD  (4 * MMAP_BLOCK_SIZE)
 
 typedef struct
 {
     int fd;
 
     bool b_pace_control;
+
+#ifdef HAVE_MMAP
+    /* memory-mapped mode */
+    uint64_t offset;
+    uint64_t size;
+    size_t   page_mask;
+#endif
 } access_sys_t;
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -124,10 +140,17 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
+#ifdef HAVE_MMAP
+static block_t *BlockMmap (stream_t *, bool *);
+static int MmapSeek (stream_t *, uint64_t);
+#endif
 
 /*****************************************************************************
  * FileOpen: open the file
@@ -228,6 +251,24 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_MMAP
+        /* Map local regular files, if requested. A remote file may be
+         * truncated behind our back, and its pages faulted in one by one. */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap"))
+        {
+            if (IsRemote(fd, p_access->psz_filepath))
+                msg_Dbg (p_access, "not mapping a remote file");
+            else
+            {
+                p_sys->offset = 0;
+                p_sys->size = st.st_size;
+                p_sys->page_mask = sysconf (_SC_PAGESIZE) - 1;
+                p_access->pf_read = NULL;
+                p_access->pf_block = BlockMmap;
+                p_access->pf_seek = MmapSeek;
+            }
+        }
 #endif
     }
     else
@@ -250,7 +291,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -284,6 +325,68 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_MMAP
+/*****************************************************************************
+ * BlockMmap: return the next part of the file, mapped in memory
+ *****************************************************************************/
+static block_t *BlockMmap (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->offset >= p_sys->size)
+    {
+        /* The file may be growing */
+        struct stat st;
+
+        if (fstat (p_sys->fd, &st) == 0)
+            p_sys->size = st.st_size;
+        if (p_sys->offset >= p_sys->size)
+        {
+            *eof = true;
+            return NULL;
+        }
+    }
+
+    /* mmap() offsets must be page aligned */
+    const size_t inner = p_sys->offset & p_sys->page_mask;
+    const uint64_t start = p_sys->offset - inner;
+    size_t length = __MIN(p_sys->size - p_sys->offset, MMAP_BLOCK_SIZE);
+
+    void *addr = mmap (NULL, inner + length, PROT_READ, MAP_SHARED,
+                       p_sys->fd, start);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "memory mapping failed: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    /* The demuxer reads from there, have the next blocks read ahead */
+    posix_madvise (addr, inner + length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, inner + length, POSIX_MADV_WILLNEED);
+    posix_fadvise (p_sys->fd, start + inner + length, MMAP_READAHEAD,
+                   POSIX_FADV_WILLNEED);
+
+    block_t *block = block_mmap_Alloc (addr, inner + length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    block->p_buffer += inner;
+    block->i_buffer -= inner;
+    p_sys->offset += length;
+    return block;
+}
+
+static int MmapSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->offset = i_pos;
+    posix_fadvise (p_sys->fd, i_pos, MMAP_READAHEAD, POSIX_FADV_WILLNEED);
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
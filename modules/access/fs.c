@@ -39,6 +39,12 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, N_("Memory-mapped file access"),
+              N_("Map local files in memory instead of copying the data, "
+                 "which saves CPU time with high bitrate files. The file "
+                 "must not be truncated while it is being read."), true )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -190,6 +190,14 @@ static int Open(vlc_object_t *obj)
     if (sys->resource == NULL)
         goto error;
 
+    if (!live && !access->b_preparsing)
+        vlc_http_file_set_segments(sys->resource,
+                                   var_InheritInteger(obj, "http-segments"));
+
+    /* Let playback take precedence over preparsing on shared connections */
+    if (access->b_preparsing)
+        vlc_http_res_set_urgency(sys->resource, 6);
+
     if (vlc_credential_get(&crd, obj, NULL, NULL, NULL, NULL))
         vlc_http_res_set_login(sys->resource,
                                crd.psz_username, crd.psz_password);
@@ -292,6 +300,12 @@ vlc_module_begin()
     add_bool("http-continuous", false, N_("Continuous stream"),
              N_("Keep reading a resource that keeps being updated."), true)
         change_volatile()
+    add_integer("http-segments", 0, N_("Concurrent byte ranges"),
+                N_("Download files as that many byte ranges ahead of the "
+                   "playback position, each on its own connection, if the "
+                   "server supports ranges. This improves the throughput of "
+                   "lossy long-distance links (0 to disable)."), true)
+        change_integer_range(0, 16)
     add_bool("http-forward-cookies", true, N_("Cookies forwarding"),
              N_("Forward cookies across HTTP redirections."), true)
     add_string("http-referrer", NULL, N_("Referrer"),
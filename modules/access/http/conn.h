@@ -110,6 +110,16 @@ struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
  */
 struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *);
 
+/**
+ * Counts the open streams of an HTTP/2 connection.
+ *
+ * \param maxp storage space for the maximum number of concurrent streams
+ *             allowed by the server, or zero if no new streams can be
+ *             opened on the connection anymore [OUT]
+ * \return the number of currently open streams
+ */
+unsigned vlc_h2_conn_streams(struct vlc_http_conn *, unsigned *restrict maxp);
+
 /** @} */
 
 /** @} */
@@ -96,11 +96,220 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+/*
+ * HTTP/2 connections are shared by all managers within the process, so that
+ * successive or concurrent resources from the same origin (e.g. playlist
+ * items being preparsed, or adaptive streaming segments) are multiplexed
+ * onto a single TLS session. The pool exists while at least one manager
+ * does. HTTP/1.x connections can only carry one stream at a time, and remain
+ * private to the manager.
+ */
+#define VLC_HTTP_POOL_MAX_STREAMS 32 /* per connection */
+#define VLC_HTTP_POOL_MAX_IDLE 8
+#define VLC_HTTP_POOL_IDLE_TIMEOUT VLC_TICK_FROM_SEC(60)
+
+struct vlc_http_pool_conn
+{
+    struct vlc_http_pool_conn *next;
+    struct vlc_http_conn *conn;
+    vlc_tick_t idle_since; /**< VLC_TICK_INVALID if in use */
+    unsigned port;
+    char host[];
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned refs;
+    vlc_tls_client_t *creds;
+    struct vlc_http_pool_conn *conns;
+} vlc_http_pool = { VLC_STATIC_MUTEX, 0, NULL, NULL };
+
+static void vlc_http_pool_hold(void)
+{
+    vlc_mutex_lock(&vlc_http_pool.lock);
+    vlc_http_pool.refs++;
+    vlc_mutex_unlock(&vlc_http_pool.lock);
+}
+
+static void vlc_http_pool_release(void)
+{
+    struct vlc_http_pool_conn *list = NULL;
+    vlc_tls_client_t *creds = NULL;
+
+    vlc_mutex_lock(&vlc_http_pool.lock);
+    assert(vlc_http_pool.refs > 0);
+    if (--vlc_http_pool.refs == 0)
+    {
+        list = vlc_http_pool.conns;
+        creds = vlc_http_pool.creds;
+        vlc_http_pool.conns = NULL;
+        vlc_http_pool.creds = NULL;
+    }
+    vlc_mutex_unlock(&vlc_http_pool.lock);
+
+    while (list != NULL)
+    {
+        struct vlc_http_pool_conn *pc = list;
+
+        list = pc->next;
+        vlc_http_conn_release(pc->conn);
+        free(pc);
+    }
+
+    /* Managers are destroyed after their streams, so the connections are
+     * gone by now, and the credentials can be deleted. */
+    if (creds != NULL)
+        vlc_tls_ClientDelete(creds);
+}
+
+/**
+ * Gets the shared TLS credentials.
+ *
+ * The credentials are parented to the instance, rather than to any given
+ * manager object, as they outlive the manager that loaded them.
+ */
+static vlc_tls_client_t *vlc_http_pool_get_creds(vlc_object_t *obj)
+{
+    vlc_tls_client_t *creds;
+
+    vlc_mutex_lock(&vlc_http_pool.lock);
+    if (vlc_http_pool.creds == NULL)
+        vlc_http_pool.creds =
+            vlc_tls_ClientCreate(VLC_OBJECT(vlc_object_instance(obj)));
+    creds = vlc_http_pool.creds;
+    vlc_mutex_unlock(&vlc_http_pool.lock);
+    return creds;
+}
+
+/** Removes a connection from the pool. Call with the pool lock held. */
+static void vlc_http_pool_remove(struct vlc_http_pool_conn **pp)
+{
+    struct vlc_http_pool_conn *pc = *pp;
+
+    *pp = pc->next;
+    vlc_http_conn_release(pc->conn);
+    free(pc);
+}
+
+/**
+ * Opens a stream on a pooled connection to an origin.
+ *
+ * Connections that cannot take new streams are removed, and so are
+ * connections idle for too long or in excess.
+ */
+static struct vlc_http_stream *vlc_http_pool_open(const char *host,
+                                                  unsigned port,
+                                                  const struct vlc_http_msg *req,
+                                                  struct vlc_http_conn **connp)
+{
+    struct vlc_http_stream *stream = NULL;
+    vlc_tick_t now = vlc_tick_now();
+    unsigned idle = 0;
+
+    vlc_mutex_lock(&vlc_http_pool.lock);
+    for (struct vlc_http_pool_conn **pp = &vlc_http_pool.conns, *pc;
+         (pc = *pp) != NULL;)
+    {
+        unsigned max;
+        unsigned count = vlc_h2_conn_streams(pc->conn, &max);
+
+        if (max == 0)
+        {   /* Closing connection */
+            vlc_http_pool_remove(pp);
+            continue;
+        }
+
+        if (count > 0)
+            pc->idle_since = VLC_TICK_INVALID;
+        else if (pc->idle_since == VLC_TICK_INVALID)
+            pc->idle_since = now;
+
+        if (stream == NULL && pc->port == port && !strcmp(pc->host, host)
+         && count < max && count < VLC_HTTP_POOL_MAX_STREAMS)
+        {
+            stream = vlc_http_stream_open(pc->conn, req);
+            if (stream == NULL)
+            {
+                vlc_http_pool_remove(pp);
+                continue;
+            }
+            pc->idle_since = VLC_TICK_INVALID;
+            *connp = pc->conn;
+        }
+        else
+        if (pc->idle_since != VLC_TICK_INVALID
+         && (now - pc->idle_since >= VLC_HTTP_POOL_IDLE_TIMEOUT
+          || ++idle > VLC_HTTP_POOL_MAX_IDLE))
+        {
+            vlc_http_pool_remove(pp);
+            continue;
+        }
+        pp = &pc->next;
+    }
+    vlc_mutex_unlock(&vlc_http_pool.lock);
+    return stream;
+}
+
+static int vlc_http_pool_add(const char *host, unsigned port,
+                             struct vlc_http_conn *conn)
+{
+    size_t len = strlen(host) + 1;
+    struct vlc_http_pool_conn *pc = malloc(sizeof (*pc) + len);
+    if (unlikely(pc == NULL))
+        return -1;
+
+    pc->conn = conn;
+    pc->idle_since = vlc_tick_now();
+    pc->port = port;
+    memcpy(pc->host, host, len);
+
+    vlc_mutex_lock(&vlc_http_pool.lock);
+    pc->next = vlc_http_pool.conns;
+    vlc_http_pool.conns = pc;
+    vlc_mutex_unlock(&vlc_http_pool.lock);
+    return 0;
+}
+
+/** Removes a failed connection from the pool, unless already done. */
+static void vlc_http_pool_drop(struct vlc_http_conn *conn)
+{
+    vlc_mutex_lock(&vlc_http_pool.lock);
+    for (struct vlc_http_pool_conn **pp = &vlc_http_pool.conns; *pp != NULL;
+         pp = &(*pp)->next)
+        if ((*pp)->conn == conn)
+        {
+            vlc_http_pool_remove(pp);
+            break;
+        }
+    vlc_mutex_unlock(&vlc_http_pool.lock);
+}
+
+static struct vlc_http_msg *vlc_http_pool_reuse(const char *host,
+                                                unsigned port,
+                                                const struct vlc_http_msg *req)
+{
+    struct vlc_http_conn *conn = NULL;
+    struct vlc_http_stream *stream;
+
+    while ((stream = vlc_http_pool_open(host, port, req, &conn)) != NULL)
+    {
+        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+        if (m != NULL)
+            return m;
+
+        /* Same as vlc_http_mgr_reuse(): retry on another connection */
+        vlc_http_pool_drop(conn);
+    }
+    return NULL;
+}
+
+
 struct vlc_http_mgr
 {
     struct vlc_logger *logger;
     vlc_object_t *obj;
-    vlc_tls_client_t *creds;
+    vlc_tls_client_t *creds; /**< Shared credentials, once HTTPS is used */
     struct vlc_http_cookie_jar_t *jar;
     struct vlc_http_conn *conn;
 };
@@ -158,8 +367,8 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL; /* switch from HTTP to HTTPS not implemented */
 
     if (mgr->creds == NULL)
-    {   /* First TLS connection: load x509 credentials */
-        mgr->creds = vlc_tls_ClientCreate(mgr->obj);
+    {   /* First TLS connection: get x509 credentials */
+        mgr->creds = vlc_http_pool_get_creds(mgr->obj);
         if (mgr->creds == NULL)
             return NULL;
     }
@@ -169,6 +378,10 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     if (resp != NULL)
         return resp; /* existing connection reused */
 
+    resp = vlc_http_pool_reuse(host, port, req);
+    if (resp != NULL)
+        return resp; /* shared HTTP/2 connection reused */
+
     char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
     {
@@ -192,7 +405,14 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
      * NOTE: We do not enforce TLS version 1.2 for HTTP 2.0 explicitly.
      */
     if (http2)
-        conn = vlc_h2_conn_create(mgr->logger, tls);
+    {   /* The connection may outlive the manager: log with the credentials */
+        conn = vlc_h2_conn_create(mgr->creds->obj.logger, tls);
+        if (likely(conn != NULL) && vlc_http_pool_add(host, port, conn))
+        {
+            vlc_http_conn_release(conn);
+            return NULL;
+        }
+    }
     else
         conn = vlc_h1_conn_create(mgr->logger, tls, false);
 
@@ -202,6 +422,9 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
+    if (http2)
+        return vlc_http_pool_reuse(host, port, req);
+
     mgr->conn = conn;
 
     return vlc_http_mgr_reuse(mgr, host, port, req);
@@ -283,14 +506,19 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->creds = NULL;
     mgr->jar = jar;
     mgr->conn = NULL;
+    vlc_http_pool_hold();
     return mgr;
 }
 
+struct vlc_http_mgr *vlc_http_mgr_clone(struct vlc_http_mgr *mgr)
+{
+    return vlc_http_mgr_create(mgr->obj, mgr->jar);
+}
+
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
     if (mgr->conn != NULL)
         vlc_http_mgr_release(mgr, mgr->conn);
-    if (mgr->creds != NULL)
-        vlc_tls_ClientDelete(mgr->creds);
+    vlc_http_pool_release();
     free(mgr);
 }
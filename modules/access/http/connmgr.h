@@ -65,6 +65,17 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
                                          struct vlc_http_cookie_jar_t *jar);
 
+/**
+ * Creates a sibling HTTP connection manager
+ *
+ * Allocates an HTTP client connections manager for the same object and
+ * cookies jar as an existing one. The new manager establishes its own
+ * HTTP/1.x connections, so that its requests can run concurrently with those
+ * of the original manager. HTTP/2 connections remain shared.
+ * @param mgr existing HTTP connection manager
+ */
+struct vlc_http_mgr *vlc_http_mgr_clone(struct vlc_http_mgr *mgr);
+
 /**
  * Destroys an HTTP connection manager
  *
@@ -32,42 +32,94 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_interrupt.h>
 #include <vlc_strings.h>
 #include "message.h"
+#include "connmgr.h"
 #include "resource.h"
 #include "file.h"
 
 #pragma GCC visibility push(default)
 
+/*
+ * In segmented mode, the file is downloaded as consecutive ranges ahead of
+ * the read offset, by as many workers, each with its own connection manager.
+ * A range is reassigned past the last one once it has been completely read.
+ */
+#define VLC_HTTP_FILE_SEGMENT_SIZE (UINTMAX_C(4) << 20)
+
+struct vlc_http_file_segment
+{
+    uintmax_t start; /**< Offset of the next byte to read */
+    uintmax_t end; /**< Offset past the last byte of the range */
+    uintmax_t received; /**< Offset past the last received byte */
+    block_t *blocks; /**< Received data not read yet */
+    block_t **tailp;
+    unsigned serial; /**< Incremented whenever the range is reassigned */
+    bool busy; /**< Being downloaded by a worker */
+    bool failed;
+};
+
+struct vlc_http_file_worker
+{
+    /* Copy of the file resource, bound to a private connection manager.
+     * The strings belong to the file resource. */
+    struct vlc_http_resource resource;
+    struct vlc_http_file *file;
+    vlc_interrupt_t *interrupt;
+    vlc_thread_t thread;
+};
+
+struct vlc_http_file_segments
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    uintmax_t size; /**< File size */
+    uintmax_t next; /**< Start of the next range to assign */
+    unsigned head; /**< Segment being read */
+    unsigned count;
+    unsigned workers;
+    bool closing;
+    struct vlc_http_file_segment *segs;
+    struct vlc_http_file_worker *worker;
+};
+
 struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    unsigned segments; /**< Requested number of concurrent ranges */
+    struct vlc_http_file_segments *seg;
 };
 
+static void vlc_http_file_add_validators(struct vlc_http_msg *req,
+                                         const struct vlc_http_msg *resp)
+{
+    if (resp == NULL)
+        return;
+
+    const char *str = vlc_http_msg_get_header(resp, "ETag");
+    if (str != NULL)
+    {
+        if (!memcmp(str, "W/", 2))
+            str += 2; /* skip weak mark */
+        vlc_http_msg_add_header(req, "If-Match", "%s", str);
+    }
+    else
+    {
+        time_t mtime = vlc_http_msg_get_mtime(resp);
+        if (mtime != -1)
+            vlc_http_msg_add_time(req, "If-Unmodified-Since", &mtime);
+    }
+}
+
 static int vlc_http_file_req(const struct vlc_http_resource *res,
                              struct vlc_http_msg *req, void *opaque)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
     const uintmax_t *offset = opaque;
 
-    if (file->resource.response != NULL)
-    {
-        const char *str = vlc_http_msg_get_header(file->resource.response,
-                                                  "ETag");
-        if (str != NULL)
-        {
-            if (!memcmp(str, "W/", 2))
-                str += 2; /* skip weak mark */
-            vlc_http_msg_add_header(req, "If-Match", "%s", str);
-        }
-        else
-        {
-            time_t mtime = vlc_http_msg_get_mtime(file->resource.response);
-            if (mtime != -1)
-                vlc_http_msg_add_time(req, "If-Unmodified-Since", &mtime);
-        }
-    }
+    vlc_http_file_add_validators(req, file->resource.response);
 
     if (vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-", *offset)
      && *offset != 0)
@@ -104,10 +156,21 @@ fail:
     return -1;
 }
 
+static void vlc_http_file_segments_stop(struct vlc_http_file *);
+
+static void vlc_http_file_destroy_cb(struct vlc_http_resource *res)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    if (file->seg != NULL)
+        vlc_http_file_segments_stop(file);
+}
+
 static const struct vlc_http_resource_cbs vlc_http_file_callbacks =
 {
     vlc_http_file_req,
     vlc_http_file_resp,
+    vlc_http_file_destroy_cb,
 };
 
 struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
@@ -126,6 +189,8 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->segments = 0;
+    file->seg = NULL;
     return &file->resource;
 }
 
@@ -201,14 +266,391 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *res)
     return vlc_http_msg_can_seek(res->response);
 }
 
+/*** Segmented mode ***/
+
+static int vlc_http_file_seg_req(const struct vlc_http_resource *res,
+                                 struct vlc_http_msg *req, void *opaque)
+{
+    const struct vlc_http_file_worker *worker =
+        (const struct vlc_http_file_worker *)res;
+    const uintmax_t *range = opaque;
+
+    vlc_http_file_add_validators(req, worker->file->resource.response);
+    return vlc_http_msg_add_header(req, "Range",
+                                   "bytes=%" PRIuMAX "-%" PRIuMAX,
+                                   range[0], range[1] - 1);
+}
+
+static int vlc_http_file_seg_resp(const struct vlc_http_resource *res,
+                                  const struct vlc_http_msg *resp,
+                                  void *opaque)
+{
+    const uintmax_t *range = opaque;
+
+    /* Anything but the requested range is useless here */
+    if (vlc_http_msg_get_status(resp) != 206)
+        goto fail;
+
+    const char *str = vlc_http_msg_get_header(resp, "Content-Range");
+    uintmax_t start, end;
+
+    if (str == NULL
+     || sscanf(str, "bytes %" SCNuMAX "-%" SCNuMAX, &start, &end) != 2
+     || start != range[0] || start > end)
+        goto fail;
+
+    (void) res;
+    return 0;
+
+fail:
+    errno = EIO;
+    return -1;
+}
+
+static const struct vlc_http_resource_cbs vlc_http_file_seg_callbacks =
+{
+    vlc_http_file_seg_req,
+    vlc_http_file_seg_resp,
+    NULL,
+};
+
+/** Assigns the next range to a segment. Call with the lock held. */
+static void vlc_http_file_segment_assign(struct vlc_http_file_segments *segs,
+                                         struct vlc_http_file_segment *seg)
+{
+    block_ChainRelease(seg->blocks);
+    seg->blocks = NULL;
+    seg->tailp = &seg->blocks;
+    seg->start = seg->received = segs->next;
+    if (segs->size - segs->next > VLC_HTTP_FILE_SEGMENT_SIZE)
+        seg->end = segs->next + VLC_HTTP_FILE_SEGMENT_SIZE;
+    else
+        seg->end = segs->size;
+    segs->next = seg->end;
+    seg->serial++;
+    seg->busy = false;
+    seg->failed = false;
+}
+
+/** Restarts all ranges from an offset. Call with the lock held. */
+static void vlc_http_file_segments_reset(struct vlc_http_file_segments *segs,
+                                         uintmax_t offset)
+{
+    segs->next = (offset < segs->size) ? offset : segs->size;
+    segs->head = 0;
+
+    for (unsigned i = 0; i < segs->count; i++)
+        vlc_http_file_segment_assign(segs, &segs->segs[i]);
+    vlc_cond_broadcast(&segs->wait);
+}
+
+/** Finds the closest range left to download. Call with the lock held. */
+static struct vlc_http_file_segment *
+vlc_http_file_segment_pick(struct vlc_http_file_segments *segs)
+{
+    for (unsigned i = 0; i < segs->count; i++)
+    {
+        struct vlc_http_file_segment *seg =
+            &segs->segs[(segs->head + i) % segs->count];
+
+        if (!seg->busy && !seg->failed && seg->received < seg->end)
+            return seg;
+    }
+    return NULL;
+}
+
+static void *vlc_http_file_worker_run(void *data)
+{
+    struct vlc_http_file_worker *worker = data;
+    struct vlc_http_file_segments *segs = worker->file->seg;
+
+    vlc_interrupt_set(worker->interrupt);
+    vlc_mutex_lock(&segs->lock);
+
+    for (;;)
+    {
+        struct vlc_http_file_segment *seg;
+
+        while ((seg = vlc_http_file_segment_pick(segs)) == NULL
+            && !segs->closing)
+            vlc_cond_wait(&segs->wait, &segs->lock);
+        if (segs->closing)
+            break;
+
+        unsigned serial = seg->serial;
+        uintmax_t range[2] = { seg->received, seg->end };
+
+        seg->busy = true;
+        vlc_mutex_unlock(&segs->lock);
+
+        struct vlc_http_msg *resp = vlc_http_res_open(&worker->resource,
+                                                      range);
+        bool ok = resp != NULL;
+
+        vlc_mutex_lock(&segs->lock);
+        while (ok && seg->serial == serial && !segs->closing
+            && seg->received < seg->end)
+        {
+            vlc_mutex_unlock(&segs->lock);
+            block_t *block = vlc_http_msg_read(resp);
+            vlc_mutex_lock(&segs->lock);
+
+            if (block == NULL || block == vlc_http_error)
+            {   /* Premature end of the range */
+                ok = false;
+                break;
+            }
+
+            if (seg->serial != serial)
+            {   /* The range was reassigned meanwhile (seek) */
+                block_Release(block);
+                break;
+            }
+
+            if (block->i_buffer > seg->end - seg->received)
+                block->i_buffer = seg->end - seg->received;
+            seg->received += block->i_buffer;
+            *seg->tailp = block;
+            seg->tailp = &block->p_next;
+            vlc_cond_broadcast(&segs->wait);
+        }
+
+        if (seg->serial == serial)
+        {
+            seg->busy = false;
+            if (!ok && !segs->closing)
+                seg->failed = true;
+            vlc_cond_broadcast(&segs->wait);
+        }
+
+        if (resp != NULL)
+        {
+            vlc_mutex_unlock(&segs->lock);
+            vlc_http_msg_destroy(resp);
+            vlc_mutex_lock(&segs->lock);
+        }
+    }
+
+    vlc_mutex_unlock(&segs->lock);
+    return NULL;
+}
+
+static void vlc_http_file_segments_stop(struct vlc_http_file *file)
+{
+    struct vlc_http_file_segments *segs = file->seg;
+
+    vlc_mutex_lock(&segs->lock);
+    segs->closing = true;
+    vlc_cond_broadcast(&segs->wait);
+    vlc_mutex_unlock(&segs->lock);
+
+    for (unsigned i = 0; i < segs->workers; i++)
+    {
+        struct vlc_http_file_worker *worker = &segs->worker[i];
+
+        vlc_interrupt_kill(worker->interrupt);
+        vlc_join(worker->thread, NULL);
+        vlc_interrupt_destroy(worker->interrupt);
+        vlc_http_mgr_destroy(worker->resource.manager);
+    }
+
+    for (unsigned i = 0; i < segs->count; i++)
+        block_ChainRelease(segs->segs[i].blocks);
+
+    free(segs);
+    file->seg = NULL;
+}
+
+static int vlc_http_file_segments_start(struct vlc_http_file *file)
+{
+    struct vlc_http_resource *res = &file->resource;
+
+    /* The server must have honored the range of the initial request */
+    if (res->response == NULL || vlc_http_msg_get_status(res->response) != 206)
+    {
+        file->segments = 0;
+        return -1;
+    }
+
+    uintmax_t size = vlc_http_msg_get_file_size(res->response);
+    if (size == (uintmax_t)-1)
+    {
+        file->segments = 0;
+        return -1;
+    }
+
+    if (file->offset >= size
+     || size - file->offset <= VLC_HTTP_FILE_SEGMENT_SIZE)
+        return -1; /* not worth it (yet) */
+
+    /* The response is only kept for its header lines from now on: its
+     * payload stream and connection are released. */
+    char *str = vlc_http_msg_format(res->response, NULL, false);
+    if (unlikely(str == NULL))
+        return -1;
+
+    struct vlc_http_msg *head = vlc_http_msg_headers(str);
+    free(str);
+    if (unlikely(head == NULL))
+        return -1;
+
+    unsigned count = file->segments;
+    struct vlc_http_file_segments *segs =
+        malloc(sizeof (*segs) + count * (sizeof (*segs->segs)
+                                         + sizeof (*segs->worker)));
+    if (unlikely(segs == NULL))
+    {
+        vlc_http_msg_destroy(head);
+        return -1;
+    }
+
+    vlc_mutex_init(&segs->lock);
+    vlc_cond_init(&segs->wait);
+    segs->size = size;
+    segs->count = count;
+    segs->workers = 0;
+    segs->closing = false;
+    segs->worker = (struct vlc_http_file_worker *)(segs + 1);
+    segs->segs = (struct vlc_http_file_segment *)(segs->worker + count);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        segs->segs[i].blocks = NULL;
+        segs->segs[i].serial = 0;
+    }
+    vlc_http_file_segments_reset(segs, file->offset);
+
+    vlc_http_msg_destroy(res->response);
+    res->response = head;
+    file->seg = segs;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct vlc_http_file_worker *worker = &segs->worker[i];
+        struct vlc_http_mgr *mgr = vlc_http_mgr_clone(res->manager);
+        if (mgr == NULL)
+            break;
+
+        worker->resource = *res;
+        worker->resource.cbs = &vlc_http_file_seg_callbacks;
+        worker->resource.response = NULL;
+        worker->resource.manager = mgr;
+        worker->file = file;
+        worker->interrupt = vlc_interrupt_create();
+
+        if (unlikely(worker->interrupt == NULL)
+         || vlc_clone(&worker->thread, vlc_http_file_worker_run, worker,
+                      VLC_THREAD_PRIORITY_INPUT))
+        {
+            if (worker->interrupt != NULL)
+                vlc_interrupt_destroy(worker->interrupt);
+            vlc_http_mgr_destroy(mgr);
+            break;
+        }
+        segs->workers++;
+    }
+
+    if (segs->workers == 0)
+    {
+        vlc_http_file_segments_stop(file);
+        file->segments = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static void vlc_http_file_segments_wake(void *data)
+{
+    struct vlc_http_file_segments *segs = data;
+
+    vlc_mutex_lock(&segs->lock);
+    vlc_cond_broadcast(&segs->wait);
+    vlc_mutex_unlock(&segs->lock);
+}
+
+static block_t *vlc_http_file_segments_read(struct vlc_http_file *file)
+{
+    struct vlc_http_file_segments *segs = file->seg;
+    block_t *block;
+
+    vlc_interrupt_register(vlc_http_file_segments_wake, segs);
+    vlc_mutex_lock(&segs->lock);
+
+    for (;;)
+    {
+        struct vlc_http_file_segment *seg = &segs->segs[segs->head];
+
+        if (seg->start >= seg->end)
+        {   /* End of file */
+            block = NULL;
+            break;
+        }
+
+        block = seg->blocks;
+        if (block != NULL)
+        {
+            seg->blocks = block->p_next;
+            if (seg->blocks == NULL)
+                seg->tailp = &seg->blocks;
+            block->p_next = NULL;
+            seg->start += block->i_buffer;
+
+            if (seg->start >= seg->end)
+            {   /* Completely read: move the range past the last one */
+                vlc_http_file_segment_assign(segs, seg);
+                segs->head = (segs->head + 1) % segs->count;
+                vlc_cond_broadcast(&segs->wait);
+            }
+            break;
+        }
+
+        if (seg->failed)
+        {
+            block = vlc_http_error;
+            break;
+        }
+
+        if (vlc_killed())
+        {
+            block = NULL;
+            break;
+        }
+
+        vlc_cond_wait(&segs->wait, &segs->lock);
+    }
+
+    vlc_mutex_unlock(&segs->lock);
+    vlc_interrupt_unregister();
+    return block;
+}
+
+void vlc_http_file_set_segments(struct vlc_http_resource *res, unsigned count)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    assert(file->seg == NULL);
+    file->segments = (count >= 2) ? count : 0;
+}
+
 int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 {
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    if (file->seg != NULL)
+    {   /* Restart the ranges, errors are reported by the next read */
+        struct vlc_http_file_segments *segs = file->seg;
+
+        vlc_mutex_lock(&segs->lock);
+        vlc_http_file_segments_reset(segs, offset);
+        vlc_mutex_unlock(&segs->lock);
+        file->offset = offset;
+        return 0;
+    }
+
     struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
     if (resp == NULL)
         return -1;
 
-    struct vlc_http_file *file = (struct vlc_http_file *)res;
-
     int status = vlc_http_msg_get_status(resp);
     if (res->response != NULL)
     {   /* Accept the new and ditch the old one if:
@@ -232,7 +674,25 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 block_t *vlc_http_file_read(struct vlc_http_resource *res)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
-    block_t *block = vlc_http_res_read(res);
+    block_t *block;
+
+    if (file->seg == NULL && file->segments > 0)
+        vlc_http_file_segments_start(file);
+
+    if (file->seg != NULL)
+    {
+        block = vlc_http_file_segments_read(file);
+        if (block != vlc_http_error)
+            goto out;
+
+        /* A range failed: fall back to a single request from the offset */
+        vlc_http_file_segments_stop(file);
+        file->segments = 0;
+        if (vlc_http_file_seek(res, file->offset))
+            return NULL;
+    }
+
+    block = vlc_http_res_read(res);
 
     if (block == vlc_http_error)
     {   /* Automatically reconnect on error if server supports seek */
@@ -246,6 +706,7 @@ block_t *vlc_http_file_read(struct vlc_http_resource *res)
             return NULL;
     }
 
+out:
     if (block == NULL)
         return NULL; /* End of stream */
 
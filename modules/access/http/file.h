@@ -79,6 +79,19 @@ int vlc_http_file_seek(struct vlc_http_resource *, uintmax_t offset);
  */
 struct block_t *vlc_http_file_read(struct vlc_http_resource *);
 
+/**
+ * Sets the number of concurrent byte ranges.
+ *
+ * If the count is two or more, and the server supports byte ranges, the file
+ * is downloaded as that many consecutive ranges ahead of the read offset,
+ * each on its own connection, and reassembled in order.
+ * This spreads the transfer over several congestion windows, which helps on
+ * lossy long-distance links. Otherwise, a single request is used.
+ *
+ * This must be set before the first read.
+ */
+void vlc_http_file_set_segments(struct vlc_http_resource *, unsigned count);
+
 #define vlc_http_file_get_status vlc_http_res_get_status
 #define vlc_http_file_get_redirect vlc_http_res_get_redirect
 #define vlc_http_file_get_type vlc_http_res_get_type
@@ -400,3 +400,15 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
     assert(mgr == NULL);
     return jar;
 }
+
+struct vlc_http_mgr *vlc_http_mgr_clone(struct vlc_http_mgr *mgr)
+{
+    (void) mgr;
+    vlc_assert_unreachable(); /* segmented mode is not tested */
+}
+
+void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
+{
+    (void) mgr;
+    vlc_assert_unreachable();
+}
@@ -54,11 +54,16 @@ struct vlc_h2_conn
 
     struct vlc_h2_stream *streams; /**< List of open streams */
     uint32_t next_id; /**< Next free stream identifier */
+    uint32_t max_streams; /**< Peer limit of concurrent streams */
     bool released; /**< Connection released by owner */
 
     uint32_t init_send_cwnd; /**< Initial send congestion window */
     uint64_t send_cwnd; /**< Send congestion window */
 
+    vlc_tick_t rtt; /**< Smoothed round-trip time (or VLC_TICK_INVALID) */
+    vlc_tick_t ping_time; /**< Time the latest ping was sent */
+    bool ping_pending; /**< Ping awaiting acknowledgement */
+
     vlc_mutex_t lock; /**< State machine lock */
     vlc_thread_t thread; /**< Receive thread */
 };
@@ -80,6 +85,8 @@ struct vlc_h2_stream
     struct vlc_http_msg *recv_hdr; /**< Latest received headers (or NULL) */
 
     size_t recv_cwnd; /**< Free space in receive congestion window */
+    uint32_t recv_window; /**< Receive congestion window size */
+    vlc_tick_t recv_credit_time; /**< Time the window was last credited */
     struct vlc_h2_frame *recv_head; /**< Earliest pending received buffer */
     struct vlc_h2_frame **recv_tailp; /**< Tail of receive queue */
     vlc_cond_t recv_wait;
@@ -103,6 +110,59 @@ static int vlc_h2_conn_queue_prio(struct vlc_h2_conn *conn,
 
 /* Stream callbacks */
 
+/**
+ * Measures the round-trip time.
+ *
+ * The receive windows are auto-tuned from the round-trip time, which is
+ * sampled with a ping while data is flowing, at most every 10 seconds.
+ */
+static void vlc_h2_conn_ping(struct vlc_h2_conn *conn, vlc_tick_t now)
+{
+    if (conn->ping_pending || (conn->rtt != VLC_TICK_INVALID
+                            && now - conn->ping_time < VLC_TICK_FROM_SEC(10)))
+        return;
+
+    if (vlc_h2_conn_queue_prio(conn, vlc_h2_frame_ping(now)) == 0)
+    {
+        conn->ping_time = now;
+        conn->ping_pending = true;
+    }
+}
+
+/**
+ * Gets the stream weight from the HTTP request priority.
+ *
+ * The urgency of the Priority header (RFC 9218) is mapped to an HTTP/2
+ * stream weight, with the default urgency 3 mapped to the default weight.
+ */
+static unsigned vlc_h2_stream_weight(const struct vlc_http_msg *msg)
+{
+    static const unsigned short weights[8] = {
+        256, 128, 64, VLC_H2_DEFAULT_WEIGHT, 8, 4, 2, 1
+    };
+    const char *prio = vlc_http_msg_get_header(msg, "Priority");
+
+    if (prio != NULL)
+        for (const char *p = strchr(prio, 'u'); p != NULL;
+             p = strchr(p + 1, 'u'))
+            if (p[1] == '=' && p[2] >= '0' && p[2] <= '7'
+             && (p == prio || p[-1] == ' ' || p[-1] == ','))
+                return weights[p[2] - '0'];
+
+    return VLC_H2_DEFAULT_WEIGHT;
+}
+
+/** Counts open streams. */
+static unsigned vlc_h2_conn_count(const struct vlc_h2_conn *conn)
+{
+    unsigned count = 0;
+
+    for (const struct vlc_h2_stream *s = conn->streams; s != NULL;
+         s = s->older)
+        count++;
+    return count;
+}
+
 /** Looks a stream up by ID. */
 static void *vlc_h2_stream_lookup(void *ctx, uint_fast32_t id)
 {
@@ -323,10 +383,32 @@ static block_t *vlc_h2_stream_read(struct vlc_http_stream *stream)
     }
 
     /* Credit the receive window if missing credit exceeds 50%. */
-    uint_fast32_t credit = VLC_H2_INIT_WINDOW - s->recv_cwnd;
-    if (credit >= (VLC_H2_INIT_WINDOW / 2)
-     && !vlc_h2_conn_queue(conn, vlc_h2_frame_window_update(s->id, credit)))
-        s->recv_cwnd += credit;
+    uint_fast32_t credit = s->recv_window - s->recv_cwnd;
+    if (credit >= (s->recv_window / 2))
+    {
+        vlc_tick_t now = vlc_tick_now();
+
+        /* If half the window was consumed within two round trips, the window
+         * rather than the link or the reader limits the throughput. */
+        if (conn->rtt != VLC_TICK_INVALID
+         && s->recv_window < VLC_H2_MAX_WINDOW
+         && now - s->recv_credit_time < 2 * conn->rtt)
+        {
+            s->recv_window = __MIN(2 * (uint_fast64_t)s->recv_window,
+                                   VLC_H2_MAX_WINDOW);
+            credit = s->recv_window - s->recv_cwnd;
+            vlc_http_dbg(SO(s), "stream %"PRIu32" window grown to %"PRIu32,
+                         s->id, s->recv_window);
+        }
+
+        if (!vlc_h2_conn_queue(conn, vlc_h2_frame_window_update(s->id,
+                                                                credit)))
+        {
+            s->recv_cwnd += credit;
+            s->recv_credit_time = now;
+        }
+        vlc_h2_conn_ping(conn, now);
+    }
 
     vlc_h2_stream_unlock(s);
 
@@ -431,6 +513,8 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
     s->recv_err = 0;
     s->recv_hdr = NULL;
     s->recv_cwnd = VLC_H2_INIT_WINDOW;
+    s->recv_window = VLC_H2_INIT_WINDOW;
+    s->recv_credit_time = vlc_tick_now();
     s->recv_head = NULL;
     s->recv_tailp = &s->recv_head;
     vlc_cond_init(&s->recv_wait);
@@ -445,6 +529,12 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
         goto error;
     }
 
+    if (vlc_h2_conn_count(conn) >= conn->max_streams)
+    {
+        vlc_http_dbg(CO(conn), "too many concurrent streams");
+        goto error;
+    }
+
     s->id = conn->next_id;
     conn->next_id += 2;
 
@@ -454,6 +544,10 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
 
     vlc_h2_conn_queue(conn, f);
 
+    unsigned weight = vlc_h2_stream_weight(msg);
+    if (weight != VLC_H2_DEFAULT_WEIGHT)
+        vlc_h2_conn_queue(conn, vlc_h2_frame_priority(s->id, 0, weight));
+
     s->older = conn->streams;
     if (s->older != NULL)
         s->older->newer = s;
@@ -494,6 +588,9 @@ static void vlc_h2_setting(void *ctx, uint_fast16_t id, uint_fast32_t value)
         case VLC_H2_SETTING_INITIAL_WINDOW_SIZE:
             vlc_h2_initial_window_update(conn, value);
             break;
+        case VLC_H2_SETTING_MAX_CONCURRENT_STREAMS:
+            conn->max_streams = value;
+            break;
     }
 }
 
@@ -513,6 +610,24 @@ static int vlc_h2_ping(void *ctx, uint_fast64_t opaque)
     return vlc_h2_conn_queue_prio(conn, vlc_h2_frame_pong(opaque));
 }
 
+/** Reports a ping acknowledgement from HTTP/2 peer */
+static void vlc_h2_pong(void *ctx, uint_fast64_t opaque)
+{
+    struct vlc_h2_conn *conn = ctx;
+
+    if (!conn->ping_pending || opaque != (uint64_t)conn->ping_time)
+        return; /* not our ping */
+
+    vlc_tick_t rtt = vlc_tick_now() - conn->ping_time;
+
+    conn->rtt = (conn->rtt != VLC_TICK_INVALID) ? (7 * conn->rtt + rtt) / 8
+                                                : rtt;
+    conn->ping_pending = false;
+    vlc_http_dbg(CO(conn), "round-trip time: %"PRId64" us (smoothed: %"
+                 PRId64" us)", US_FROM_VLC_TICK(rtt),
+                 US_FROM_VLC_TICK(conn->rtt));
+}
+
 /** Reports a local HTTP/2 connection failure */
 static void vlc_h2_error(void *ctx, uint_fast32_t code)
 {
@@ -579,6 +694,7 @@ static const struct vlc_h2_parser_cbs vlc_h2_parser_callbacks =
     vlc_h2_setting,
     vlc_h2_settings_done,
     vlc_h2_ping,
+    vlc_h2_pong,
     vlc_h2_error,
     vlc_h2_reset,
     vlc_h2_window_status,
@@ -722,8 +838,9 @@ static void *vlc_h2_recv_thread(void *data)
     vlc_cleanup_pop();
     vlc_h2_parse_destroy(parser);
 fail:
-    /* Terminate any remaining stream */
+    /* Terminate any remaining stream, and prevent adding new ones */
     vlc_mutex_lock(&conn->lock);
+    conn->next_id = 0x80000000;
     for (struct vlc_h2_stream *s = conn->streams; s != NULL; s = s->older)
         vlc_h2_stream_reset(s, VLC_H2_CANCEL);
     vlc_mutex_unlock(&conn->lock);
@@ -762,6 +879,21 @@ static void vlc_h2_conn_release(struct vlc_http_conn *c)
         vlc_h2_conn_destroy(conn);
 }
 
+unsigned vlc_h2_conn_streams(struct vlc_http_conn *c,
+                             unsigned *restrict maxp)
+{
+    struct vlc_h2_conn *conn = container_of(c, struct vlc_h2_conn, conn);
+    unsigned count;
+
+    vlc_mutex_lock(&conn->lock);
+    assert(!conn->released);
+    count = vlc_h2_conn_count(conn);
+    /* No new streams after GOAWAY or once out of identifiers */
+    *maxp = (conn->next_id > 0x7ffffff) ? 0 : conn->max_streams;
+    vlc_mutex_unlock(&conn->lock);
+    return count;
+}
+
 static const struct vlc_http_conn_cbs vlc_h2_conn_callbacks =
 {
     vlc_h2_stream_open,
@@ -780,9 +912,13 @@ struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *tls)
     conn->opaque = ctx;
     conn->streams = NULL;
     conn->next_id = 1; /* TODO: server side */
+    conn->max_streams = UINT32_MAX;
     conn->released = false;
     conn->init_send_cwnd = VLC_H2_DEFAULT_INIT_WINDOW;
     conn->send_cwnd = VLC_H2_DEFAULT_INIT_WINDOW;
+    conn->rtt = VLC_TICK_INVALID;
+    conn->ping_time = VLC_TICK_INVALID;
+    conn->ping_pending = false;
 
     if (unlikely(conn->out == NULL))
         goto error;
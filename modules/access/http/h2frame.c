@@ -237,6 +237,25 @@ vlc_h2_frame_data(uint_fast32_t stream_id, const void *buf, size_t len,
     return f;
 }
 
+struct vlc_h2_frame *
+vlc_h2_frame_priority(uint_fast32_t stream_id, uint_fast32_t depend,
+                      unsigned weight)
+{
+    assert((depend >> 31) == 0);
+    assert(weight >= 1 && weight <= 256);
+
+    struct vlc_h2_frame *f = vlc_h2_frame_alloc(VLC_H2_FRAME_PRIORITY, 0,
+                                                stream_id, 5);
+    if (likely(f != NULL))
+    {
+        uint8_t *p = vlc_h2_frame_payload(f);
+
+        SetDWBE(p, depend); /* non-exclusive */
+        p[4] = weight - 1;
+    }
+    return f;
+}
+
 struct vlc_h2_frame *
 vlc_h2_frame_rst_stream(uint_fast32_t stream_id, uint_fast32_t error_code)
 {
@@ -811,13 +830,15 @@ static int vlc_h2_parse_frame_ping(struct vlc_h2_parser *p,
         return vlc_h2_parse_error(p, VLC_H2_FRAME_SIZE_ERROR);
     }
 
+    memcpy(&opaque, vlc_h2_frame_payload(f), 8);
+
     if (vlc_h2_frame_flags(f) & VLC_H2_PING_ACK)
     {
         free(f);
+        p->cbs->pong(p->opaque, opaque);
         return 0;
     }
 
-    memcpy(&opaque, vlc_h2_frame_payload(f), 8);
     free(f);
 
     return p->cbs->ping(p->opaque, opaque);
@@ -42,6 +42,9 @@ struct vlc_h2_frame *
 vlc_h2_frame_data(uint_fast32_t stream_id, const void *buf, size_t len,
                   bool eos);
 struct vlc_h2_frame *
+vlc_h2_frame_priority(uint_fast32_t stream_id, uint_fast32_t depend,
+                      unsigned weight);
+struct vlc_h2_frame *
 vlc_h2_frame_rst_stream(uint_fast32_t stream_id, uint_fast32_t error_code);
 struct vlc_h2_frame *vlc_h2_frame_settings(void);
 struct vlc_h2_frame *vlc_h2_frame_settings_ack(void);
@@ -88,6 +91,7 @@ const char *vlc_h2_setting_name(uint_fast16_t);
 #define VLC_H2_MAX_HEADER_TABLE   4096 /* Header (compression) table size */
 #define VLC_H2_MAX_STREAMS           0 /* Concurrent peer-initiated streams */
 #define VLC_H2_INIT_WINDOW     1048575 /* Initial congestion window size */
+#define VLC_H2_MAX_WINDOW     16777215 /* Auto-tuned congestion window limit */
 #define VLC_H2_MAX_FRAME       1048576 /* Frame size */
 #define VLC_H2_MAX_HEADER_LIST   65536 /* Header (decompressed) list size */
 
@@ -95,6 +99,7 @@ const char *vlc_h2_setting_name(uint_fast16_t);
 #define VLC_H2_DEFAULT_MAX_HEADER_TABLE  4096
 #define VLC_H2_DEFAULT_INIT_WINDOW      65535
 #define VLC_H2_DEFAULT_MAX_FRAME        16384
+#define VLC_H2_DEFAULT_WEIGHT              16
 
 struct vlc_h2_parser;
 struct vlc_h2_parser_cbs
@@ -102,6 +107,7 @@ struct vlc_h2_parser_cbs
     void (*setting)(void *ctx, uint_fast16_t id, uint_fast32_t value);
     int  (*settings_done)(void *ctx);
     int  (*ping)(void *ctx, uint_fast64_t opaque);
+    void (*pong)(void *ctx, uint_fast64_t opaque);
     void (*error)(void *ctx, uint_fast32_t code);
     int  (*reset)(void *ctx, uint_fast32_t last_seq, uint_fast32_t code);
     void (*window_status)(void *ctx, uint32_t *rcwd);
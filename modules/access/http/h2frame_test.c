@@ -106,6 +106,15 @@ static int vlc_h2_ping(void *ctx, uint_fast64_t opaque)
     return 0;
 }
 
+static unsigned pongs;
+
+static void vlc_h2_pong(void *ctx, uint_fast64_t opaque)
+{
+    assert(ctx == CTX);
+    assert(opaque == 42);
+    pongs++;
+}
+
 static uint_fast32_t remote_error;
 
 static void vlc_h2_error(void *ctx, uint_fast32_t code)
@@ -282,7 +291,7 @@ static struct vlc_h2_frame *data(bool eos)
 
 static struct vlc_h2_frame *priority(void)
 {
-    return localize(resize(retype(data(false), 0x2), 5));
+    return vlc_h2_frame_priority(STREAM_ID, 0, 256);
 }
 
 static struct vlc_h2_frame *rst_stream(void)
@@ -337,6 +346,7 @@ static const struct vlc_h2_parser_cbs vlc_h2_frame_test_callbacks =
     vlc_h2_setting,
     vlc_h2_settings_done,
     vlc_h2_ping,
+    vlc_h2_pong,
     vlc_h2_error,
     vlc_h2_reset,
     vlc_h2_window_status,
@@ -357,7 +367,7 @@ static unsigned test_seq(void *ctx, ...)
     unsigned i;
 
     settings = settings_acked = 0;
-    pings = 0;
+    pings = pongs = 0;
     remote_error = -1;
     stream_header_tables = stream_blocks = stream_ends = 0;
 
@@ -438,6 +448,7 @@ int main(void)
     ret = test_seq(CTX, ping(), vlc_h2_frame_pong(42), ping(), NULL);
     assert(ret == 3);
     assert(pings == 2);
+    assert(pongs == 1);
     assert(stream_header_tables == 0);
     assert(stream_blocks == 0);
     assert(stream_ends == 0);
@@ -22,6 +22,7 @@
 # include <config.h>
 #endif
 
+#include <assert.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -70,6 +71,9 @@ vlc_http_res_req(const struct vlc_http_resource *res, void *opaque)
 
     vlc_http_msg_add_cookies(req, vlc_http_mgr_get_jar(res->manager));
 
+    if (res->urgency != VLC_HTTP_URGENCY_DEFAULT)
+        vlc_http_msg_add_header(req, "Priority", "u=%u", res->urgency);
+
     /* TODO: vlc_http_msg_add_header(req, "TE", "gzip, deflate"); */
 
     if (res->cbs->request_format(res, req, opaque))
@@ -161,6 +165,8 @@ static void vlc_http_res_deinit(struct vlc_http_resource *res)
 
 void vlc_http_res_destroy(struct vlc_http_resource *res)
 {
+    if (res->cbs->destroy != NULL)
+        res->cbs->destroy(res);
     vlc_http_res_deinit(res);
     free(res);
 }
@@ -217,6 +223,7 @@ int vlc_http_res_init(struct vlc_http_resource *restrict res,
                                                : NULL;
     res->agent = (ua != NULL) ? strdup(ua) : NULL;
     res->referrer = (ref != NULL) ? strdup(ref) : NULL;
+    res->urgency = VLC_HTTP_URGENCY_DEFAULT;
 
     const char *path = url.psz_path;
     if (path == NULL)
@@ -362,6 +369,13 @@ int vlc_http_res_set_login(struct vlc_http_resource *res,
     return 0;
 }
 
+void vlc_http_res_set_urgency(struct vlc_http_resource *res,
+                              unsigned urgency)
+{
+    assert(urgency <= 7);
+    res->urgency = urgency;
+}
+
 char *vlc_http_res_get_basic_realm(struct vlc_http_resource *res)
 {
     int status = vlc_http_res_get_status(res);
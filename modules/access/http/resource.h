@@ -38,6 +38,7 @@ struct vlc_http_resource_cbs
                           struct vlc_http_msg *, void *);
     int (*response_validate)(const struct vlc_http_resource *,
                              const struct vlc_http_msg *, void *);
+    void (*destroy)(struct vlc_http_resource *); /**< optional */
 };
 
 struct vlc_http_resource
@@ -56,6 +57,7 @@ struct vlc_http_resource
     char *password;
     char *agent;
     char *referrer;
+    unsigned urgency;
 };
 
 int vlc_http_res_init(struct vlc_http_resource *,
@@ -98,6 +100,20 @@ struct block_t *vlc_http_res_read(struct vlc_http_resource *);
 
 int vlc_http_res_set_login(struct vlc_http_resource *res,
                            const char *username, const char *password);
+
+/**
+ * Sets the request urgency.
+ *
+ * Sets the urgency of the subsequent requests for the resource, from 0 (most
+ * urgent) to 7 (least urgent), as per the HTTP Priority header (RFC 9218).
+ * This determines the share of the connection bandwidth when the resource
+ * is multiplexed with others onto an HTTP/2 connection.
+ * The default urgency is VLC_HTTP_URGENCY_DEFAULT.
+ */
+void vlc_http_res_set_urgency(struct vlc_http_resource *res,
+                              unsigned urgency);
+
+#define VLC_HTTP_URGENCY_DEFAULT 3
 char *vlc_http_res_get_basic_realm(struct vlc_http_resource *res);
 
 /** @} */
@@ -93,6 +93,10 @@ static void Close( vlc_object_t * );
     "track, can be increased in case of broken pictures due " \
     "to too small buffer.")
 #define DEFAULT_FRAME_BUFFER_SIZE 250000
+#define MAX_FRAME_BUFFER_SIZE 4000000
+#define MAX_RECEIVE_BUFFER_SIZE 8000000
+/* room reserved before the frames for the headers added by StreamRead */
+#define FRAME_HEADROOM 4
 
 vlc_module_begin ()
     set_description( N_("RTP/RTSP/SDP demuxer (using Live555)" ) )
@@ -169,6 +173,8 @@ typedef struct
     bool            b_discard_trunc;
     vlc_demux_chained_t *p_out_muxed;    /* for muxed stream */
 
+    /* the frames are received in the block p_frame, at p_buffer */
+    block_t         *p_frame;
     uint8_t         *p_buffer;
     unsigned int    i_buffer;
 
@@ -493,7 +499,7 @@ static void Close( vlc_object_t *p_this )
             vlc_demux_chained_Delete( tk->p_out_muxed );
         es_format_Clean( &tk->fmt );
         dtsgen_Clean( &tk->dtsgen );
-        free( tk->p_buffer );
+        block_Release( tk->p_frame );
         free( tk );
     }
     TAB_CLEAN( p_sys->i_track, p_sys->track );
@@ -762,6 +768,8 @@ static int SessionsSetup( demux_t *p_demux )
         Boolean bInit;
         live_track_t *tk;
 
+        i_frame_buffer = DEFAULT_FRAME_BUFFER_SIZE;
+
         /* Value taken from mplayer */
         if( !strcmp( sub->mediumName(), "audio" ) )
             i_receive_buffer = 100000;
@@ -771,6 +779,17 @@ static int SessionsSetup( demux_t *p_demux )
             if( i_var_buf_size > 0 )
                 i_frame_buffer = i_var_buf_size;
             i_receive_buffer = 2000000;
+
+            /* Size the buffers from the bandwidth announced in the SDP
+             * (b=AS, in kbit/s), so that the large key frames of high
+             * bitrate streams are not truncated before the buffer grows:
+             * a quarter of second of stream for a frame, and a second in
+             * the socket buffer */
+            uint64_t i_bytes_per_sec = (uint64_t)sub->bandwidth() * 1000 / 8;
+            if( i_bytes_per_sec / 4 > (unsigned)i_frame_buffer )
+                i_frame_buffer = __MIN( i_bytes_per_sec / 4, MAX_FRAME_BUFFER_SIZE );
+            if( i_bytes_per_sec > i_receive_buffer )
+                i_receive_buffer = __MIN( i_bytes_per_sec, MAX_RECEIVE_BUFFER_SIZE );
         }
         else if( !strcmp( sub->mediumName(), "text" ) )
             ;
@@ -808,7 +827,13 @@ static int SessionsSetup( demux_t *p_demux )
 
                 /* Increase the buffer size */
                 if( i_receive_buffer > 0 )
-                    increaseReceiveBufferTo( *p_sys->env, fd, i_receive_buffer );
+                {
+                    unsigned i_size = increaseReceiveBufferTo( *p_sys->env, fd,
+                                                               i_receive_buffer );
+                    if( i_size < i_receive_buffer )
+                        msg_Dbg( p_demux, "receive buffer limited to %u bytes "
+                                 "(%u requested)", i_size, i_receive_buffer );
+                }
 
                 /* Increase the RTP reorder timebuffer just a bit */
                 sub->rtpSource()->setPacketReorderingThresholdTime(thresh);
@@ -876,15 +901,17 @@ static int SessionsSetup( demux_t *p_demux )
             dtsgen_Init( &tk->dtsgen );
             tk->state       = live_track_t::STATE_SELECTED;
             tk->i_buffer    = i_frame_buffer;
-            tk->p_buffer    = (uint8_t *)malloc( i_frame_buffer );
+            tk->p_frame     = block_Alloc( FRAME_HEADROOM + i_frame_buffer );
 
-            if( !tk->p_buffer )
+            if( !tk->p_frame )
             {
                 free( tk );
                 delete iter;
                 return VLC_ENOMEM;
             }
 
+            tk->p_buffer    = tk->p_frame->p_buffer + FRAME_HEADROOM;
+
             /* Value taken from mplayer */
             if( !strcmp( sub->mediumName(), "audio" ) )
             {
@@ -1226,6 +1253,7 @@ static int SessionsSetup( demux_t *p_demux )
                 /* BUG ??? */
                 msg_Err( p_demux, "unusable RTSP track. this should not happen" );
                 es_format_Clean( &tk->fmt );
+                block_Release( tk->p_frame );
                 free( tk );
             }
         }
@@ -1793,7 +1821,7 @@ static int RollOverTcp( demux_t *p_demux )
         if( tk->p_es ) es_out_Del( p_demux->out, tk->p_es );
         if( tk->p_asf_block ) block_Release( tk->p_asf_block );
         es_format_Clean( &tk->fmt );
-        free( tk->p_buffer );
+        block_Release( tk->p_frame );
         free( tk );
     }
     TAB_CLEAN( p_sys->i_track, p_sys->track );
@@ -1919,6 +1947,38 @@ static block_t *StreamParseAsf( demux_t *p_demux, live_track_t *tk,
     return p_list;
 }
 
+/*****************************************************************************
+ * StreamTakeFrame: returns the frame received in the track buffer, with
+ * i_header bytes (at most FRAME_HEADROOM) left before it for the caller.
+ *****************************************************************************/
+static block_t *StreamTakeFrame( live_track_t *tk, unsigned int i_size,
+                                 unsigned int i_header )
+{
+    block_t *p_block;
+
+    /* Large frames are handed over in the buffer they were received in,
+     * and a new buffer is used for the next ones. The small frames are
+     * copied, not to queue mostly empty buffers downstream. */
+    if( i_size >= tk->i_buffer / 2 )
+    {
+        block_t *p_next = block_Alloc( FRAME_HEADROOM + tk->i_buffer );
+        if( p_next )
+        {
+            p_block = tk->p_frame;
+            p_block->p_buffer += FRAME_HEADROOM - i_header;
+            p_block->i_buffer = i_header + i_size;
+
+            tk->p_frame = p_next;
+            tk->p_buffer = p_next->p_buffer + FRAME_HEADROOM;
+            return p_block;
+        }
+    }
+
+    if( (p_block = block_Alloc( i_header + i_size )) )
+        memcpy( p_block->p_buffer + i_header, tk->p_buffer, i_size );
+    return p_block;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -2014,19 +2074,22 @@ static void StreamRead( void *p_private, unsigned int i_size,
      * up all the memory on strange streams */
     if( i_truncated_bytes > 0 )
     {
-        if( tk->i_buffer < 2000000 )
+        if( tk->i_buffer < MAX_FRAME_BUFFER_SIZE )
         {
-            void *p_tmp;
+            block_t *p_tmp;
             msg_Dbg( p_demux, "lost %d bytes", i_truncated_bytes );
             msg_Dbg( p_demux, "increasing buffer size to %d", tk->i_buffer * 2 );
-            p_tmp = realloc( tk->p_buffer, tk->i_buffer * 2 );
+            p_tmp = block_Alloc( FRAME_HEADROOM + tk->i_buffer * 2 );
             if( p_tmp == NULL )
             {
                 msg_Warn( p_demux, "realloc failed" );
             }
             else
             {
-                tk->p_buffer = (uint8_t*)p_tmp;
+                memcpy( p_tmp->p_buffer + FRAME_HEADROOM, tk->p_buffer, i_size );
+                block_Release( tk->p_frame );
+                tk->p_frame = p_tmp;
+                tk->p_buffer = p_tmp->p_buffer + FRAME_HEADROOM;
                 tk->i_buffer *= 2;
             }
         }
@@ -2046,21 +2109,15 @@ static void StreamRead( void *p_private, unsigned int i_size,
     {
         AMRAudioSource *amrSource = (AMRAudioSource*)tk->sub->readSource();
 
-        if( (p_block = block_Alloc( i_size + 1 )) )
-        {
+        if( (p_block = StreamTakeFrame( tk, i_size, 1 )) )
             p_block->p_buffer[0] = amrSource->lastFrameHeader();
-            memcpy( p_block->p_buffer + 1, tk->p_buffer, i_size );
-        }
     }
     else if( tk->fmt.i_codec == VLC_CODEC_H261 )
     {
         H261VideoRTPSource *h261Source = (H261VideoRTPSource*)tk->sub->rtpSource();
         uint32_t header = h261Source->lastSpecialHeader();
-        if( (p_block = block_Alloc( i_size + 4 )) )
-        {
+        if( (p_block = StreamTakeFrame( tk, i_size, 4 )) )
             memcpy( p_block->p_buffer, &header, 4 );
-            memcpy( p_block->p_buffer + 4, tk->p_buffer, i_size );
-        }
     }
     else if( tk->fmt.i_codec == VLC_CODEC_H264 || tk->fmt.i_codec == VLC_CODEC_HEVC )
     {
@@ -2070,13 +2127,12 @@ static void StreamRead( void *p_private, unsigned int i_size,
             msg_Warn( p_demux, "unsupported NAL type for H265" );
 
         /* Normal NAL type */
-        if( (p_block = block_Alloc( i_size + 4 )) )
+        if( (p_block = StreamTakeFrame( tk, i_size, 4 )) )
         {
             p_block->p_buffer[0] = 0x00;
             p_block->p_buffer[1] = 0x00;
             p_block->p_buffer[2] = 0x00;
             p_block->p_buffer[3] = 0x01;
-            memcpy( &p_block->p_buffer[4], tk->p_buffer, i_size );
             if( tk->sub->rtpSource()->curPacketMarkerBit() )
                 p_block->i_flags |= BLOCK_FLAG_AU_END;
         }
@@ -2088,10 +2144,7 @@ static void StreamRead( void *p_private, unsigned int i_size,
                                   tk->p_buffer, i_size );
     }
     else
-    {
-        if( (p_block = block_Alloc( i_size )) )
-            memcpy( p_block->p_buffer, tk->p_buffer, i_size );
-    }
+        p_block = StreamTakeFrame( tk, i_size, 0 );
 
     /* No data sent. Always in sync then */
     if( !tk->b_rtcp_sync && tk->sub->rtpSource() &&
@@ -37,6 +37,10 @@
 #ifdef HAVE_POLL
 #include <poll.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#include <sys/uio.h>
+#endif
+#include <stdatomic.h>
 #include <bitstream/ietf/rtcp_rr.h>
 #include <bitstream/ietf/rtcp_sdes.h>
 #include <bitstream/ietf/rtcp_fb.h>
@@ -60,6 +64,9 @@
 #define NACK_INTERVAL 5 /*ms*/
 /* Calculate and print stats once per second */
 #define STATS_INTERVAL 1000 /*ms*/
+/* NACK batches queued for the NACK thread, must be a power of 2 */
+#define RIST_NACK_RING_SIZE 16
+#define RIST_NACK_BUFSIZE (RTCP_FB_HEADER_SIZE + RTCP_FB_FCI_GENERIC_NACK_SIZE * MAX_NACKS)
 
 static const int nack_type[] = {
     0, 1,
@@ -74,6 +81,15 @@ enum NACK_TYPE {
     NACK_FMT_BITMASK
 };
 
+/* Sequence numbers to request, with the peer they are requested from */
+struct rist_nack_batch
+{
+    struct sockaddr_storage peer;
+    socklen_t        slen;
+    unsigned         count;
+    uint16_t         seqs[MAX_NACKS];
+};
+
 typedef struct
 {
     struct rist_flow *flow;
@@ -90,8 +106,14 @@ typedef struct
     bool             b_sendblindnacks;
     bool             b_disablenacks;
     bool             b_flag_discontinuity;
-    block_fifo_t     *p_fifo;
-    vlc_mutex_t      lock;
+    uint8_t          *p_rtcp_buf;
+    /* Single producer (BlockRIST), single consumer (rist_thread) ring:
+     * each index is only written by its own side */
+    struct rist_nack_batch nack_ring[RIST_NACK_RING_SIZE];
+    atomic_uint      nack_write;
+    atomic_uint      nack_read;
+    vlc_sem_t        nack_sem;
+    atomic_bool      b_nack_stop;
     uint64_t         last_message;
     uint64_t         last_reset;
     /* stat variables */
@@ -102,6 +124,7 @@ typedef struct
     uint16_t         vbr_ratio_count;
     uint32_t         i_lost_packets;
     uint32_t         i_nack_packets;
+    uint32_t         i_nack_dropped;
     uint32_t         i_recovered_packets;
     uint32_t         i_reordered_packets;
     uint32_t         i_total_packets;
@@ -151,14 +174,6 @@ static struct rist_flow *rist_init_rx(void)
     return flow;
 }
 
-static void rist_WriteTo_i11e_Locked(vlc_mutex_t lock, int fd, const void *buf, size_t len,
-    const struct sockaddr *peer, socklen_t slen)
-{
-    vlc_mutex_lock( &lock );
-    rist_WriteTo_i11e(fd, buf, len, peer, slen);
-    vlc_mutex_unlock( &lock );
-}
-
 static struct rist_flow *rist_udp_receiver(stream_t *p_access, vlc_url_t *parsed_url, bool b_ismulticast)
 {
     stream_sys_t *p_sys = p_access->p_sys;
@@ -227,9 +242,8 @@ static int is_index_in_range(struct rist_flow *flow, uint16_t idx)
     }
 }
 
-static void send_rtcp_feedback(stream_t *p_access, struct rist_flow *flow)
+static void send_rtcp_feedback(struct rist_flow *flow)
 {
-    stream_sys_t *p_sys = p_access->p_sys;
     int namelen = strlen(flow->cname) + 1;
 
     /* we need to make sure it is a multiple of 4, pad if necessary */
@@ -260,89 +274,90 @@ static void send_rtcp_feedback(stream_t *p_access, struct rist_flow *flow)
     strlcpy((char *)p_sdes_name, flow->cname, namelen);
 
     /* Write to Socket */
-    rist_WriteTo_i11e_Locked(p_sys->lock, flow->fd_nack, buf, rtcp_feedback_size,
+    rist_WriteTo_i11e(flow->fd_nack, buf, rtcp_feedback_size,
         (struct sockaddr *)&flow->peer_sockaddr, flow->peer_socklen);
     free(buf);
     buf = NULL;
 }
 
-static void send_bbnack(stream_t *p_access, int fd_nack, block_t *pkt_nacks, uint16_t nack_count)
+/* Builds one RTCP feedback packet, grouping consecutive sequence numbers in
+ * the same record. The sequence numbers are in increasing order. */
+static size_t rist_nack_build(uint8_t *buf, enum NACK_TYPE type, const uint16_t *seqs,
+    unsigned count)
 {
-    stream_sys_t *p_sys = p_access->p_sys;
-    struct rist_flow *flow = p_sys->flow;
-    int len = 0;
-
-    int bbnack_bufsize = RTCP_FB_HEADER_SIZE +
-        RTCP_FB_FCI_GENERIC_NACK_SIZE * nack_count;
-    uint8_t *buf = malloc(bbnack_bufsize);
-    if ( unlikely( buf == NULL ) )
-        return;
+    unsigned records = 0;
 
     /* Populate NACKS */
     uint8_t *nack = buf;
     rtp_set_hdr(nack);
-    rtcp_fb_set_fmt(nack, NACK_FMT_BITMASK);
-    rtcp_set_pt(nack, RTCP_PT_RTPFB);
-    rtcp_set_length(nack, 2 + nack_count);
-    /*uint8_t name[4] = "RIST";*/
-    /*rtcp_fb_set_ssrc_media_src(nack, name);*/
-    len += RTCP_FB_HEADER_SIZE;
-    /* TODO : group together */
-    uint16_t nacks[MAX_NACKS];
-    memcpy(nacks, pkt_nacks->p_buffer, pkt_nacks->i_buffer);
-    for (int i = 0; i < nack_count; i++) {
-        uint8_t *nack_record = buf + len + RTCP_FB_FCI_GENERIC_NACK_SIZE*i;
-        rtcp_fb_nack_set_packet_id(nack_record, nacks[i]);
-        rtcp_fb_nack_set_bitmask_lost(nack_record, 0);
+    rtcp_fb_set_fmt(nack, type);
+    if (type == NACK_FMT_BITMASK)
+    {
+        rtcp_set_pt(nack, RTCP_PT_RTPFB);
+        /*uint8_t name[4] = "RIST";*/
+        /*rtcp_fb_set_ssrc_media_src(nack, name);*/
+    }
+    else
+    {
+        uint8_t name[4] = "RIST";
+        rtcp_set_pt(nack, RTCP_PT_RTPFR);
+        rtcp_fb_set_ssrc_media_src(nack, name);
     }
-    len += RTCP_FB_FCI_GENERIC_NACK_SIZE * nack_count;
 
-    /* Write to Socket */
-    if (p_sys->b_sendnacks && p_sys->b_disablenacks == false)
-        rist_WriteTo_i11e_Locked(p_sys->lock, fd_nack, buf, len,
-            (struct sockaddr *)&flow->peer_sockaddr, flow->peer_socklen);
-    free(buf);
-    buf = NULL;
+    for (unsigned i = 0; i < count; records++)
+    {
+        uint8_t *nack_record = buf + RTCP_FB_HEADER_SIZE + RTCP_FB_FCI_GENERIC_NACK_SIZE*records;
+        uint16_t first = seqs[i++];
+
+        if (type == NACK_FMT_BITMASK)
+        {
+            /* the 16 following packets are flagged in the bitmask */
+            uint16_t bitmask = 0;
+            while (i < count && (uint16_t)(seqs[i] - first - 1) < 16)
+                bitmask |= 1 << (uint16_t)(seqs[i++] - first - 1);
+            rtcp_fb_nack_set_packet_id(nack_record, first);
+            rtcp_fb_nack_set_bitmask_lost(nack_record, bitmask);
+        }
+        else
+        {
+            uint16_t extra = 0;
+            while (i < count && seqs[i] == (uint16_t)(first + extra + 1))
+            {
+                extra++;
+                i++;
+            }
+            rtcp_fb_nack_set_range_start(nack_record, first);
+            rtcp_fb_nack_set_range_extra(nack_record, extra);
+        }
+    }
+    rtcp_set_length(nack, 2 + records);
+
+    return RTCP_FB_HEADER_SIZE + RTCP_FB_FCI_GENERIC_NACK_SIZE * records;
 }
 
-static void send_rbnack(stream_t *p_access, int fd_nack, block_t *pkt_nacks, uint16_t nack_count)
+/* Hands the NACKs over to the NACK thread, without blocking */
+static void rist_nack_push(stream_t *p_access, struct rist_flow *flow, const uint16_t *seqs,
+    unsigned count)
 {
     stream_sys_t *p_sys = p_access->p_sys;
-    struct rist_flow *flow = p_sys->flow;
-    int len = 0;
+    unsigned w = atomic_load_explicit(&p_sys->nack_write, memory_order_relaxed);
+    unsigned r = atomic_load_explicit(&p_sys->nack_read, memory_order_acquire);
 
-    int rbnack_bufsize = RTCP_FB_HEADER_SIZE +
-        RTCP_FB_FCI_GENERIC_NACK_SIZE * nack_count;
-    uint8_t *buf = malloc(rbnack_bufsize);
-    if ( unlikely( buf == NULL ) )
-        return;
-
-    /* Populate NACKS */
-    uint8_t *nack = buf;
-    rtp_set_hdr(nack);
-    rtcp_fb_set_fmt(nack, NACK_FMT_RANGE);
-    rtcp_set_pt(nack, RTCP_PT_RTPFR);
-    rtcp_set_length(nack, 2 + nack_count);
-    uint8_t name[4] = "RIST";
-    rtcp_fb_set_ssrc_media_src(nack, name);
-    len += RTCP_FB_HEADER_SIZE;
-    /* TODO : group together */
-    uint16_t nacks[MAX_NACKS];
-    memcpy(nacks, pkt_nacks->p_buffer, pkt_nacks->i_buffer);
-    for (int i = 0; i < nack_count; i++)
+    if (w - r >= RIST_NACK_RING_SIZE)
     {
-        uint8_t *nack_record = buf + len + RTCP_FB_FCI_GENERIC_NACK_SIZE*i;
-        rtcp_fb_nack_set_range_start(nack_record, nacks[i]);
-        rtcp_fb_nack_set_range_extra(nack_record, 0);
+        /* The NACK thread is late, the retry interval will ask for them again */
+        p_sys->i_nack_dropped++;
+        return;
     }
-    len += RTCP_FB_FCI_GENERIC_NACK_SIZE * nack_count;
 
-    /* Write to Socket */
-    if (p_sys->b_sendnacks && p_sys->b_disablenacks == false)
-        rist_WriteTo_i11e_Locked(p_sys->lock, fd_nack, buf, len,
-            (struct sockaddr *)&flow->peer_sockaddr, flow->peer_socklen);
-    free(buf);
-    buf = NULL;
+    struct rist_nack_batch *batch = &p_sys->nack_ring[w % RIST_NACK_RING_SIZE];
+    memcpy(&batch->peer, &flow->peer_sockaddr, sizeof(batch->peer));
+    batch->slen = flow->peer_socklen;
+    memcpy(batch->seqs, seqs, count * sizeof(*seqs));
+    batch->count = count;
+
+    atomic_store_explicit(&p_sys->nack_write, w + 1, memory_order_release);
+    vlc_sem_post(&p_sys->nack_sem);
 }
 
 static void send_nacks(stream_t *p_access, struct rist_flow *flow)
@@ -399,13 +414,8 @@ static void send_nacks(stream_t *p_access, struct rist_flow *flow)
     if (nacks_len > 0)
     {
         p_sys->i_nack_packets += nacks_len;
-        block_t *pkt_nacks = block_Alloc(nacks_len * 2);
-        if (pkt_nacks)
-        {
-            memcpy(pkt_nacks->p_buffer, nacks, nacks_len * 2);
-            pkt_nacks->i_buffer = nacks_len * 2;
-            block_FifoPut( p_sys->p_fifo, pkt_nacks );
-        }
+        if (p_sys->b_sendnacks && p_sys->b_disablenacks == false)
+            rist_nack_push(p_access, flow, nacks, nacks_len);
     }
 }
 
@@ -546,10 +556,8 @@ static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_
                                 (struct sockaddr *)&flow->peer_sockaddr, peer);
                         else
                             print_sockaddr_info(p_access, peer);
-                        vlc_mutex_lock( &p_sys->lock );
                         memcpy(&flow->peer_sockaddr, peer, sizeof(struct sockaddr_storage));
                         flow->peer_socklen = slen;
-                        vlc_mutex_unlock( &p_sys->lock );
                     }
 
                     /* Check for changes in cname */
@@ -591,21 +599,26 @@ static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_
     }
 }
 
-static bool rist_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf, size_t len)
+/* Queues the packet, which is stored as is in the buffer (no copy) */
+static bool rist_input(stream_t *p_access, struct rist_flow *flow, block_t *p_block)
 {
     stream_sys_t *p_sys = p_access->p_sys;
+    const uint8_t *buf = p_block->p_buffer;
+    size_t len = p_block->i_buffer;
 
     /* safety checks */
     if ( len < RTP_HEADER_SIZE )
     {
         /* check if packet size >= rtp header size */
-        msg_Err(p_access, "Rist rtp packet must have at least 12 bytes, we have %lu", len);
+        msg_Err(p_access, "Rist rtp packet must have at least 12 bytes, we have %zu", len);
+        block_Release(p_block);
         return false;
     }
     else if (!rtp_check_hdr(buf))
     {
         /* check for a valid rtp header */
         msg_Err(p_access, "Malformed rtp packet header starting with %02x, ignoring.", buf[0]);
+        block_Release(p_block);
         return false;
     }
 
@@ -661,17 +674,9 @@ static bool rist_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf,
     /* Always replace the existing one with the new one */
     struct rtp_pkt *pkt;
     pkt = &(flow->buffer[idx]);
-    if (pkt->buffer && pkt->buffer->i_buffer > 0)
-    {
+    if (pkt->buffer)
         block_Release(pkt->buffer);
-        pkt->buffer = NULL;
-    }
-    pkt->buffer = block_Alloc(len);
-    if (!pkt->buffer)
-        return false;
-
-    pkt->buffer->i_buffer = len;
-    memcpy(pkt->buffer->p_buffer, buf, len);
+    pkt->buffer = p_block;
     pkt->rtp_ts = pkt_ts;
     p_sys->last_data_rx = vlc_tick_now();
     /* Reset the try counter regardless of wether it was a retransmit or not */
@@ -739,20 +744,15 @@ static block_t *rist_dequeue(stream_t *p_access, struct rist_flow *flow)
             flow->hi_timestamp, (ts - 100 * flow->qdelay));*/
         if (flow->hi_timestamp > (uint32_t)(pkt->rtp_ts + flow->rtp_latency))
         {
-            /* Populate output packet now but remove rtp header from source */
-            int newSize = pkt->buffer->i_buffer - RTP_HEADER_SIZE;
-            pktout = block_Alloc(newSize);
-            if (pktout)
-            {
-                pktout->i_buffer = newSize;
-                memcpy(pktout->p_buffer, pkt->buffer->p_buffer + RTP_HEADER_SIZE, newSize);
-                /* free the buffer and increase the read index */
-                flow->ri = idx;
-                /* TODO: calculate average duration using buffer average (bring from sender) */
-                found_data = true;
-            }
-            block_Release(pkt->buffer);
+            /* Output the queued packet itself, minus the rtp header */
+            pktout = pkt->buffer;
+            pktout->p_buffer += RTP_HEADER_SIZE;
+            pktout->i_buffer -= RTP_HEADER_SIZE;
             pkt->buffer = NULL;
+            /* increase the read index */
+            flow->ri = idx;
+            /* TODO: calculate average duration using buffer average (bring from sender) */
+            found_data = true;
             break;
         }
 
@@ -770,34 +770,75 @@ static block_t *rist_dequeue(stream_t *p_access, struct rist_flow *flow)
     return pktout;
 }
 
+static void rist_nack_send(int fd, uint8_t bufs[][RIST_NACK_BUFSIZE], const size_t *lens,
+    struct rist_nack_batch *const *batches, unsigned count)
+{
+    unsigned sent = 0;
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[RIST_NACK_RING_SIZE];
+    struct iovec iov[RIST_NACK_RING_SIZE];
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = lens[i];
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        if (batches[i]->slen > 0)
+        {
+            msgs[i].msg_hdr.msg_name = &batches[i]->peer;
+            msgs[i].msg_hdr.msg_namelen = batches[i]->slen;
+        }
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (sent < count)
+    {
+        int val = sendmmsg(fd, msgs + sent, count - sent, 0);
+        if (val <= 0)
+            break; /* the one by one path below deals with the errors */
+        sent += val;
+    }
+#endif
+    for (; sent < count; sent++)
+        rist_WriteTo_i11e(fd, bufs[sent], lens[sent],
+            (struct sockaddr *)&batches[sent]->peer, batches[sent]->slen);
+}
+
 static void *rist_thread(void *data)
 {
     stream_t *p_access = data;
     stream_sys_t *p_sys = p_access->p_sys;
+    int fd_nack = p_sys->flow->fd_nack;
+    uint8_t bufs[RIST_NACK_RING_SIZE][RIST_NACK_BUFSIZE];
+    size_t lens[RIST_NACK_RING_SIZE];
+    struct rist_nack_batch *batches[RIST_NACK_RING_SIZE];
 
-    /* Process nacks every 5ms */
-    /* We only ask for the relevant ones */
+    /* Send the nacks queued by BlockRIST, all the pending ones at once */
     for (;;) {
-        block_t *pkt_nacks = block_FifoGet(p_sys->p_fifo);
+        vlc_sem_wait(&p_sys->nack_sem);
+        if (atomic_load_explicit(&p_sys->b_nack_stop, memory_order_relaxed))
+            break;
 
-        int canc = vlc_savecancel();
+        unsigned r = atomic_load_explicit(&p_sys->nack_read, memory_order_relaxed);
+        unsigned w = atomic_load_explicit(&p_sys->nack_write, memory_order_acquire);
+        unsigned count = 0, nack_count = 0;
 
-        /* there are two bytes per nack */
-        uint16_t nack_count = (uint16_t)pkt_nacks->i_buffer/2;
-        switch(p_sys->nack_type) {
-            case NACK_FMT_BITMASK:
-                send_bbnack(p_access, p_sys->flow->fd_nack, pkt_nacks, nack_count);
-                break;
-
-            default:
-                send_rbnack(p_access, p_sys->flow->fd_nack, pkt_nacks, nack_count);
+        for (; r != w; r++, count++)
+        {
+            batches[count] = &p_sys->nack_ring[r % RIST_NACK_RING_SIZE];
+            lens[count] = rist_nack_build(bufs[count], p_sys->nack_type,
+                batches[count]->seqs, batches[count]->count);
+            nack_count += batches[count]->count;
         }
+        if (count == 0)
+            continue;
+
+        rist_nack_send(fd_nack, bufs, lens, batches, count);
+        /* the batches can be reused now that they have been sent */
+        atomic_store_explicit(&p_sys->nack_read, w, memory_order_release);
 
         if (nack_count > 1)
             msg_Dbg(p_access, "Sent %u NACKs !!!", nack_count);
-        block_Release(pkt_nacks);
-
-        vlc_restorecancel (canc);
     }
 
     return NULL;
@@ -860,10 +901,7 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     }
     else
     {
-
-        uint8_t *buf = malloc(p_sys->i_max_packet_size);
-        if ( unlikely( buf == NULL ) )
-            return NULL;
+        uint8_t *buf = p_sys->p_rtcp_buf;
 
         /* Process rctp incoming data */
         if (pfd[1].revents & POLLIN)
@@ -893,14 +931,22 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
         /* Process regular incoming data */
         if (pfd[0].revents & POLLIN)
         {
-            r = rist_Read_i11e(flow->fd_in, buf, p_sys->i_max_packet_size);
+            /* The packet is read straight in the block that will be queued then output */
+            block_t *p_block = block_Alloc(p_sys->i_max_packet_size);
+            if (unlikely(p_block == NULL))
+                r = -1;
+            else
+                r = rist_Read_i11e(flow->fd_in, p_block->p_buffer, p_sys->i_max_packet_size);
             if (unlikely(r == -1)) {
                 msg_Err(p_access, "socket %d error: %s\n", flow->fd_in, gai_strerror(errno));
+                if (p_block)
+                    block_Release(p_block);
             }
             else
             {
+                p_block->i_buffer = r;
                 /* rist_input will process and queue the pkt */
-                if (rist_input(p_access, flow, buf, r))
+                if (rist_input(p_access, flow, p_block))
                 {
                     /* Check the queue for the next packet that needs to be delivered */
                     pktout = rist_dequeue(p_access, flow);
@@ -914,9 +960,6 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
                 }
             }
         }
-
-        free(buf);
-        buf = NULL;
     }
 
     now = vlc_tick_now();
@@ -947,6 +990,9 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     {
         if ( p_sys->i_lost_packets > 0)
             msg_Err(p_access, "We have %d lost packets", p_sys->i_lost_packets);
+        if ( p_sys->i_nack_dropped > 0)
+            msg_Warn(p_access, "%u NACK batches dropped, the NACK thread is late",
+                p_sys->i_nack_dropped);
         float ratio = 1;
         if (p_sys->vbr_ratio_count > 0)
             ratio = p_sys->vbr_ratio / (float)p_sys->vbr_ratio_count;
@@ -964,6 +1010,7 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
         p_sys->vbr_ratio_count = 0;
         p_sys->i_lost_packets = 0;
         p_sys->i_nack_packets = 0;
+        p_sys->i_nack_dropped = 0;
         p_sys->i_recovered_packets = 0;
         p_sys->i_reordered_packets = 0;
         p_sys->i_total_packets = 0;
@@ -975,7 +1022,7 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     {
         /* msg_Dbg(p_access, "Calling RTCP Feedback %lu<%d ms using timer", interval,
         VLC_TICK_FROM_MS(RTCP_INTERVAL)); */
-        send_rtcp_feedback(p_access, flow);
+        send_rtcp_feedback(flow);
         flow->feedback_time = now;
     }
 
@@ -1014,8 +1061,7 @@ static void Clean( stream_t *p_access )
 {
     stream_sys_t *p_sys = p_access->p_sys;
 
-    if( likely(p_sys->p_fifo != NULL) )
-        block_FifoRelease( p_sys->p_fifo );
+    free(p_sys->p_rtcp_buf);
 
     if (p_sys->flow)
     {
@@ -1027,7 +1073,7 @@ static void Clean( stream_t *p_access )
             net_Close (p_sys->flow->fd_rtcp_m);
         for (int i=0; i<RIST_QUEUE_SIZE; i++) {
             struct rtp_pkt *pkt = &(p_sys->flow->buffer[i]);
-            if (pkt->buffer && pkt->buffer->i_buffer > 0) {
+            if (pkt->buffer) {
                 block_Release(pkt->buffer);
                 pkt->buffer = NULL;
             }
@@ -1042,7 +1088,8 @@ static void Close(vlc_object_t *p_this)
     stream_t     *p_access = (stream_t*)p_this;
     stream_sys_t *p_sys = p_access->p_sys;
 
-    vlc_cancel(p_sys->thread);
+    atomic_store_explicit(&p_sys->b_nack_stop, true, memory_order_relaxed);
+    vlc_sem_post(&p_sys->nack_sem);
     vlc_join(p_sys->thread, NULL);
 
     Clean( p_access );
@@ -1060,7 +1107,10 @@ static int Open(vlc_object_t *p_this)
 
     p_access->p_sys = p_sys;
 
-    vlc_mutex_init( &p_sys->lock );
+    vlc_sem_init( &p_sys->nack_sem, 0 );
+    atomic_init( &p_sys->nack_write, 0 );
+    atomic_init( &p_sys->nack_read, 0 );
+    atomic_init( &p_sys->b_nack_stop, false );
 
     if ( vlc_UrlParse( &parsed_url, p_access->psz_url ) == -1 )
     {
@@ -1104,11 +1154,11 @@ static int Open(vlc_object_t *p_this)
     p_sys->flow->retry_interval = rtp_get_ts(VLC_TICK_FROM_MS(p_sys->flow->retry_interval));
     p_sys->flow->reorder_buffer = rtp_get_ts(VLC_TICK_FROM_MS(p_sys->flow->reorder_buffer));
 
-    p_sys->p_fifo = block_FifoNew();
-    if( unlikely(p_sys->p_fifo == NULL) )
+    p_sys->p_rtcp_buf = malloc(p_sys->i_max_packet_size);
+    if( unlikely(p_sys->p_rtcp_buf == NULL) )
         goto failed;
 
-    /* This extra thread is for sending feedback/nack packets even when no data comes in */
+    /* This extra thread sends the nack packets, so that receiving never waits on it */
     if (vlc_clone(&p_sys->thread, rist_thread, p_access, VLC_THREAD_PRIORITY_INPUT))
     {
         msg_Err(p_access, "Failed to create worker thread.");
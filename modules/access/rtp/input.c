@@ -38,6 +38,10 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <sys/socket.h>
+# include <time.h>
+#endif
 
 #include "rtp.h"
 #ifdef HAVE_SRTP
@@ -100,12 +104,162 @@ static int rtp_timeout (vlc_tick_t deadline)
     return t;
 }
 
+#ifdef HAVE_RECVMMSG
 /**
- * RTP/RTCP session thread for datagram sockets
+ * Ring of preallocated packets, received with a single system call
  */
-void *rtp_dgram_thread (void *opaque)
+struct rtp_ring
+{
+    unsigned       size;
+    size_t         mru;
+    block_t       *blocks[RTP_BATCH_MAX];
+    struct mmsghdr msgs[RTP_BATCH_MAX];
+    struct iovec   iovs[RTP_BATCH_MAX];
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (struct timespec))];
+        struct cmsghdr align;
+    } controls[RTP_BATCH_MAX];
+};
+
+static struct rtp_ring *rtp_ring_create (demux_t *demux, int fd)
+{
+    demux_sys_t *sys = demux->p_sys;
+    unsigned size = sys->batch;
+
+    if (size <= 1)
+        return NULL;
+    if (size > RTP_BATCH_MAX)
+        size = RTP_BATCH_MAX;
+
+    struct rtp_ring *ring = calloc (1, sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL; /* receive packets one by one */
+
+    ring->size = size;
+    ring->mru = DEFAULT_MRU;
+    for (unsigned i = 0; i < size; i++)
+    {
+        struct msghdr *hdr = &ring->msgs[i].msg_hdr;
+
+        hdr->msg_iov = &ring->iovs[i];
+        hdr->msg_iovlen = 1;
+        hdr->msg_control = ring->controls[i].buf;
+    }
+
+    /* Several packets are received at once, the kernel reception time is
+     * needed for the interarrival jitter estimation. */
+    int on = 1;
+    if (setsockopt (fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof (on)))
+        msg_Warn (demux, "cannot enable reception timestamps: %s",
+                  vlc_strerror_c(errno));
+    return ring;
+}
+
+static void rtp_ring_destroy (void *data)
+{
+    struct rtp_ring *ring = data;
+
+    if (ring == NULL)
+        return;
+    for (unsigned i = 0; i < ring->size; i++)
+        if (ring->blocks[i] != NULL)
+            block_Release (ring->blocks[i]);
+    free (ring);
+}
+
+static vlc_tick_t rtp_ring_arrival (struct msghdr *hdr, vlc_tick_t offset)
+{
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR (hdr);
+         cmsg != NULL; cmsg = CMSG_NXTHDR (hdr, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET
+         && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            struct timespec ts;
+
+            memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+            return vlc_tick_from_timespec (&ts) + offset;
+        }
+    }
+    return VLC_TICK_INVALID;
+}
+
+/**
+ * Receives and processes all the pending packets, up to the ring size.
+ * @return -1 if the thread cannot continue, 0 otherwise
+ */
+static int rtp_ring_recv (demux_t *demux, struct rtp_ring *ring, int fd)
+{
+    /* Replace the packets processed from the previous batch */
+    for (unsigned i = 0; i < ring->size; i++)
+    {
+        if (ring->blocks[i] == NULL)
+        {
+            ring->blocks[i] = block_Alloc (ring->mru);
+            if (unlikely(ring->blocks[i] == NULL))
+            {
+                if (ring->mru == DEFAULT_MRU)
+                    return -1; /* we are totallly screwed */
+                ring->mru = DEFAULT_MRU;
+                return 0; /* retry with shrunk MRU */
+            }
+        }
+
+        struct msghdr *hdr = &ring->msgs[i].msg_hdr;
+
+        ring->iovs[i].iov_base = ring->blocks[i]->p_buffer;
+        ring->iovs[i].iov_len = ring->blocks[i]->i_buffer;
+        hdr->msg_controllen = sizeof (ring->controls[i]);
+        hdr->msg_flags = 0;
+    }
+
+    int n = recvmmsg (fd, ring->msgs, ring->size,
+                      MSG_WAITFORONE | MSG_TRUNC, NULL);
+    if (n == -1)
+    {
+        msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+        return 0;
+    }
+
+    /* Kernel timestamps use the real-time clock */
+    struct timespec now;
+    clock_gettime (CLOCK_REALTIME, &now);
+    const vlc_tick_t offset = vlc_tick_now () - vlc_tick_from_timespec (&now);
+
+    for (int i = 0; i < n; i++)
+    {
+        struct mmsghdr *msg = &ring->msgs[i];
+        block_t *block = ring->blocks[i];
+
+        ring->blocks[i] = NULL;
+        if (msg->msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            msg_Err(demux, "%u bytes packet truncated (MRU was %zu)",
+                    msg->msg_len, block->i_buffer);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            ring->mru = msg->msg_len;
+        }
+        else
+            block->i_buffer = msg->msg_len;
+
+        block->i_pts = rtp_ring_arrival (&msg->msg_hdr, offset);
+        rtp_process (demux, block);
+    }
+    return 0;
+}
+#endif
+
+#ifndef HAVE_RECVMMSG
+struct rtp_ring;
+#endif
+
+/**
+ * Receives datagrams until the socket fails (or the thread is canceled).
+ * @param ring ring of packets to receive at once, or NULL
+ */
+static void rtp_dgram_loop (demux_t *demux, struct rtp_ring *ring)
 {
-    demux_t *demux = opaque;
     demux_sys_t *sys = demux->p_sys;
     vlc_tick_t deadline = VLC_TICK_INVALID;
     int rtp_fd = sys->fd;
@@ -129,6 +283,9 @@ void *rtp_dgram_thread (void *opaque)
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
 
+#ifndef HAVE_RECVMMSG
+    (void) ring;
+#endif
     for (;;)
     {
         int n = poll (ufd, 1, rtp_timeout (deadline));
@@ -145,6 +302,14 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
+#ifdef HAVE_RECVMMSG
+            if (ring != NULL)
+            {
+                if (rtp_ring_recv (demux, ring, rtp_fd))
+                    break;
+                goto dequeue;
+            }
+#endif
             block_t *block = block_Alloc (iov.iov_len);
             if (unlikely(block == NULL))
             {
@@ -185,6 +350,28 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TICK_INVALID;
         vlc_restorecancel (canc);
     }
+}
+
+/**
+ * RTP/RTCP session thread for datagram sockets
+ */
+void *rtp_dgram_thread (void *opaque)
+{
+    demux_t *demux = opaque;
+#ifdef HAVE_RECVMMSG
+    demux_sys_t *sys = demux->p_sys;
+    struct rtp_ring *ring = rtp_ring_create (demux, sys->fd);
+
+    if (ring != NULL)
+    {
+        vlc_cleanup_push (rtp_ring_destroy, ring);
+        rtp_dgram_loop (demux, ring);
+        vlc_cleanup_pop ();
+        rtp_ring_destroy (ring);
+        return NULL;
+    }
+#endif
+    rtp_dgram_loop (demux, NULL);
     return NULL;
 }
 
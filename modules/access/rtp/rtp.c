@@ -75,6 +75,15 @@
     "RTP packets will be discarded if they are too far behind (i.e. in the " \
     "past) by this many packets from the last received packet." )
 
+#define RTP_REORDER_DEPTH_TEXT N_("RTP re-ordering buffer depth")
+#define RTP_REORDER_DEPTH_LONGTEXT N_( \
+    "How many RTP packets can be queued per source while waiting for " \
+    "missing or re-ordered packets. This is rounded up to a power of two." )
+
+#define RTP_BATCH_TEXT N_("Packets received at once")
+#define RTP_BATCH_LONGTEXT N_( \
+    "Number of RTP packets which can be received with a single system " \
+    "call. 0 or 1 receives them one by one.")
 #define RTP_DYNAMIC_PT_TEXT N_("RTP payload format assumed for dynamic " \
                                "payloads")
 #define RTP_DYNAMIC_PT_LONGTEXT N_( \
@@ -122,6 +131,14 @@ vlc_module_begin ()
     add_integer ("rtp-max-misorder", 100, RTP_MAX_MISORDER_TEXT,
                  RTP_MAX_MISORDER_LONGTEXT, true)
         change_integer_range (0, 32767)
+    add_integer ("rtp-reorder-depth", 1024, RTP_REORDER_DEPTH_TEXT,
+                 RTP_REORDER_DEPTH_LONGTEXT, true)
+        change_integer_range (16, 32768)
+#ifdef HAVE_RECVMMSG
+    add_integer ("rtp-batch", 32, RTP_BATCH_TEXT,
+                 RTP_BATCH_LONGTEXT, true)
+        change_integer_range (0, RTP_BATCH_MAX)
+#endif
     add_string ("rtp-dynamic-pt", NULL, RTP_DYNAMIC_PT_TEXT,
                 RTP_DYNAMIC_PT_LONGTEXT, true)
         change_string_list (dynamic_pt_list, dynamic_pt_list_text)
@@ -266,6 +283,10 @@ static int Open (vlc_object_t *obj)
     p_sys->timeout      = vlc_tick_from_sec( var_CreateGetInteger (obj, "rtp-timeout") );
     p_sys->max_dropout  = var_CreateGetInteger (obj, "rtp-max-dropout");
     p_sys->max_misorder = var_CreateGetInteger (obj, "rtp-max-misorder");
+    p_sys->reorder_depth = var_CreateGetInteger (obj, "rtp-reorder-depth");
+#ifdef HAVE_RECVMMSG
+    p_sys->batch        = var_CreateGetInteger (obj, "rtp-batch");
+#endif
     p_sys->thread_ready = false;
     p_sys->autodetect   = true;
 
@@ -395,6 +416,16 @@ static int Control (demux_t *demux, int query, va_list args)
             *v = false;
             return VLC_SUCCESS;
         }
+
+        case DEMUX_GET_SIGNAL:
+        {
+            double *quality = va_arg (args, double *);
+            double *strength = va_arg (args, double *);
+
+            if (rtp_session_signal (sys->session, quality, strength))
+                return VLC_EGENERIC;
+            return VLC_SUCCESS;
+        }
     }
 
     if (sys->chained_demux != NULL)
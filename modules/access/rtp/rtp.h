@@ -56,11 +56,16 @@ void rtp_session_destroy (demux_t *, rtp_session_t *);
 void rtp_queue (demux_t *, rtp_session_t *, block_t *);
 bool rtp_dequeue (demux_t *, const rtp_session_t *, vlc_tick_t *);
 void rtp_dequeue_force (demux_t *, const rtp_session_t *);
+int rtp_session_signal (rtp_session_t *, double *, double *);
 int rtp_add_type (demux_t *demux, rtp_session_t *ses, const rtp_pt_t *pt);
 
 void *rtp_dgram_thread (void *data);
 void *rtp_stream_thread (void *data);
 
+#ifdef HAVE_RECVMMSG
+# define RTP_BATCH_MAX 256
+#endif
+
 /* Global data */
 typedef struct
 {
@@ -76,7 +81,11 @@ typedef struct
     vlc_tick_t    timeout;
     uint16_t      max_dropout; /**< Max packet forward misordering */
     uint16_t      max_misorder; /**< Max packet backward misordering */
+    uint16_t      reorder_depth; /**< Max packets queued for re-ordering */
     uint8_t       max_src; /**< Max simultaneous RTP sources */
+#ifdef HAVE_RECVMMSG
+    unsigned      batch; /**< Max packets received at once */
+#endif
     bool          thread_ready;
     bool          autodetect; /**< Payload type autodetection pending */
 } demux_sys_t;
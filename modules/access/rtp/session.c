@@ -30,6 +30,7 @@
 
 #include <vlc_common.h>
 #include <vlc_demux.h>
+#include <vlc_input_item.h>
 
 #include "rtp.h"
 
@@ -42,6 +43,12 @@ struct rtp_session_t
     unsigned       srcc;
     uint8_t        ptc;
     rtp_pt_t      *ptv;
+    uint16_t       ring_mask; /* re-ordering ring size minus one */
+
+    vlc_tick_t     stats_time; /* last statistics update */
+    vlc_mutex_t    lock; /* protects the signal values below */
+    double         quality;
+    double         strength;
 };
 
 static rtp_source_t *
@@ -61,12 +68,22 @@ rtp_session_create (demux_t *demux)
     if (session == NULL)
         return NULL;
 
+    demux_sys_t *sys = demux->p_sys;
+    unsigned size = 16;
+
+    /* The ring is indexed by the low order bits of the sequence number */
+    while (size < sys->reorder_depth && size < 0x8000)
+        size <<= 1;
+
     session->srcv = NULL;
     session->srcc = 0;
     session->ptc = 0;
     session->ptv = NULL;
-
-    (void)demux;
+    session->ring_mask = size - 1;
+    session->stats_time = VLC_TICK_INVALID;
+    vlc_mutex_init (&session->lock);
+    session->quality = -1.;
+    session->strength = -1.;
     return session;
 }
 
@@ -82,7 +99,29 @@ void rtp_session_destroy (demux_t *demux, rtp_session_t *session)
     free (session->srcv);
     free (session->ptv);
     free (session);
-    (void)demux;
+}
+
+/**
+ * Gets the reception quality of an RTP session, over the last second.
+ *
+ * @param quality fraction of the expected packets which were received
+ * @param strength fraction of the received packets which were not too late
+ * @return 0 on success, -1 if nothing was received yet.
+ */
+int rtp_session_signal (rtp_session_t *session,
+                        double *restrict quality, double *restrict strength)
+{
+    int ret = -1;
+
+    vlc_mutex_lock (&session->lock);
+    if (session->quality >= 0.)
+    {
+        *quality = session->quality;
+        *strength = session->strength;
+        ret = 0;
+    }
+    vlc_mutex_unlock (&session->lock);
+    return ret;
 }
 
 static void *no_init (demux_t *demux)
@@ -148,11 +187,58 @@ struct rtp_source_t
     uint16_t bad_seq; /* tentatively next expected sequence for resync */
     uint16_t max_seq; /* next expected sequence */
 
-    uint16_t last_seq; /* sequence of the next dequeued packet */
-    block_t *blocks; /* re-ordered blocks queue */
+    uint16_t last_seq; /* sequence of the last dequeued packet */
+    uint16_t first_seq; /* lowest queued sequence, if any */
+    unsigned count; /* number of queued blocks */
+    bool     discontinuity; /* packets were skipped without being lost */
+    block_t **ring; /* re-ordering ring, indexed by sequence */
+
+    /* Reception statistics (see RFC 3550 appendix A.3) */
+    uint32_t freq; /* RTP clock rate, for the jitter */
+    uint32_t cycles; /* sequence number wrap-arounds, shifted by 16 */
+    uint32_t base_seq; /* first sequence, extended */
+    uint32_t received; /* packets received, including late ones */
+    uint32_t late; /* packets received after being given up */
+    uint32_t expected_prior; /* expected packets at the last update */
+    uint32_t received_prior; /* received packets at the last update */
+    uint32_t late_prior; /* late packets at the last update */
+    char     info[32]; /* input item info category */
+
     void    *opaque[]; /* Per-source private payload data */
 };
 
+/**
+ * Resets the reception statistics of an RTP source.
+ */
+static void rtp_source_reset (rtp_source_t *source, uint16_t seq)
+{
+    source->cycles = 0;
+    source->base_seq = seq;
+    source->received = 0;
+    source->late = 0;
+    source->expected_prior = 0;
+    source->received_prior = 0;
+    source->late_prior = 0;
+}
+
+/**
+ * Releases all the queued blocks of an RTP source.
+ */
+static void rtp_source_flush (const rtp_session_t *session,
+                              rtp_source_t *source)
+{
+    for (unsigned i = 0; source->count > 0; i++)
+    {
+        assert (i <= session->ring_mask);
+        if (source->ring[i] != NULL)
+        {
+            block_Release (source->ring[i]);
+            source->ring[i] = NULL;
+            source->count--;
+        }
+    }
+}
+
 /**
  * Initializes a new RTP source within an RTP session.
  */
@@ -166,13 +252,26 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
     if (source == NULL)
         return NULL;
 
+    source->ring = calloc (session->ring_mask + 1, sizeof (block_t *));
+    if (source->ring == NULL)
+    {
+        free (source);
+        return NULL;
+    }
+
     source->ssrc = ssrc;
     source->jitter = 0;
     source->ref_rtp = 0;
     source->ref_ntp = UINT64_C (1) << 62;
     source->max_seq = source->bad_seq = init_seq;
     source->last_seq = init_seq - 1;
-    source->blocks = NULL;
+    source->first_seq = init_seq;
+    source->count = 0;
+    source->discontinuity = false;
+    source->freq = 0;
+    rtp_source_reset (source, init_seq);
+    snprintf (source->info, sizeof (source->info), "%s %08"PRIx32,
+              _("RTP source"), ssrc);
 
     /* Initializes all payload */
     for (unsigned i = 0; i < session->ptc; i++)
@@ -194,7 +293,10 @@ rtp_source_destroy (demux_t *demux, const rtp_session_t *session,
 
     for (unsigned i = 0; i < session->ptc; i++)
         session->ptv[i].destroy (demux, source->opaque[i]);
-    block_ChainRelease (source->blocks);
+    if (demux->p_input_item != NULL)
+        input_item_DelInfo (demux->p_input_item, source->info, NULL);
+    rtp_source_flush (session, source);
+    free (source->ring);
     free (source);
 }
 
@@ -228,6 +330,68 @@ rtp_find_ptype (const rtp_session_t *session, rtp_source_t *source,
     return NULL;
 }
 
+/**
+ * Updates the reception statistics of all sources.
+ */
+static void rtp_session_stats (demux_t *demux, rtp_session_t *session)
+{
+    uint32_t expected = 0, received = 0, late = 0;
+
+    for (unsigned i = 0; i < session->srcc; i++)
+    {
+        rtp_source_t *src = session->srcv[i];
+        const uint32_t src_expected = src->cycles + src->max_seq
+                                    - src->base_seq;
+        const uint32_t expected_interval = src_expected - src->expected_prior;
+        const uint32_t received_interval = src->received - src->received_prior;
+        const uint32_t late_interval = src->late - src->late_prior;
+
+        src->expected_prior = src_expected;
+        src->received_prior = src->received;
+        src->late_prior = src->late;
+        expected += expected_interval;
+        received += received_interval;
+        late += late_interval;
+
+        /* Duplicates count as received, so the loss can be negative */
+        int32_t lost = src_expected - src->received;
+        double jitter = 0.;
+        if (src->freq > 0)
+            jitter = 1000. * src->jitter / src->freq;
+
+        if (expected_interval > received_interval || late_interval > 0)
+            msg_Dbg (demux, "RTP source %08"PRIx32": %"PRIu32" packet(s) "
+                     "lost, %"PRIu32" late, jitter %.2f ms", src->ssrc,
+                     expected_interval > received_interval
+                         ? expected_interval - received_interval : 0,
+                     late_interval, jitter);
+
+        input_item_t *item = demux->p_input_item;
+        if (item == NULL)
+            continue;
+        input_item_AddInfo (item, src->info, _("Packets received"),
+                            "%"PRIu32, src->received);
+        input_item_AddInfo (item, src->info, _("Packets lost"),
+                            "%"PRId32, lost);
+        input_item_AddInfo (item, src->info, _("Late packets"),
+                            "%"PRIu32, src->late);
+        input_item_AddInfo (item, src->info, _("Jitter"), "%.2f ms", jitter);
+    }
+
+    if (expected == 0)
+        return;
+
+    double quality = (expected > received) ? (double)received / expected : 1.;
+    double strength = 1.;
+    if (received > 0 && late < received)
+        strength -= (double)late / received;
+
+    vlc_mutex_lock (&session->lock);
+    session->quality = quality;
+    session->strength = strength;
+    vlc_mutex_unlock (&session->lock);
+}
+
 /**
  * Receives an RTP packet and queues it. Not a cancellation point.
  *
@@ -258,6 +422,9 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
 
     vlc_tick_t     now = vlc_tick_now ();
     rtp_source_t  *src  = NULL;
+    /* reception time, if known from the socket */
+    const vlc_tick_t arrival = (block->i_pts != VLC_TICK_INVALID)
+                             ? block->i_pts : now;
     const uint16_t seq  = rtp_seq (block);
     const uint32_t ssrc = GetDWBE (block->p_buffer + 8);
 
@@ -312,15 +479,16 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
              * That is computed from the RTP timestamps and the system clock.
              * It is independent of RTP sequence. */
             uint32_t freq = pt->frequency;
+            src->freq = freq;
             int64_t ts = rtp_timestamp (block);
-            int64_t d = samples_from_vlc_tick(now - src->last_rx, freq);
+            int64_t d = samples_from_vlc_tick(arrival - src->last_rx, freq);
             d        -=    ts - src->last_ts;
             if (d < 0) d = -d;
             src->jitter += ((d - src->jitter) + 8) >> 4;
         }
     }
-    src->last_rx = now;
-    block->i_pts = now; /* store reception time until dequeued */
+    src->last_rx = arrival;
+    block->i_pts = arrival; /* store reception time until dequeued */
     src->last_ts = rtp_timestamp (block);
 
     /* Check sequence number */
@@ -335,10 +503,11 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
         if (seq == src->bad_seq)
         {
             src->max_seq = src->bad_seq = seq + 1;
-            src->last_seq = seq - 0x7fffe; /* hack for rtp_decode() */
             msg_Warn (demux, "sequence resynchronized");
-            block_ChainRelease (src->blocks);
-            src->blocks = NULL;
+            rtp_source_flush (session, src);
+            src->last_seq = seq - 1;
+            src->discontinuity = true;
+            rtp_source_reset (src, seq);
         }
         else
         {
@@ -348,27 +517,53 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
     }
     else
     if (delta_seq >= 0)
+    {
+        if ((uint16_t)(seq + 1) < src->max_seq)
+            src->cycles += 0x10000; /* sequence number wrapped around */
         src->max_seq = seq + 1;
+    }
+    src->received++;
 
-    /* Queues the block in sequence order,
-     * hence there is a single queue for all payload types. */
-    block_t **pp = &src->blocks;
-    for (block_t *prev = *pp; prev != NULL; prev = *pp)
+    if (session->stats_time == VLC_TICK_INVALID)
+        session->stats_time = now;
+    else if (now - session->stats_time >= VLC_TICK_FROM_SEC(1))
     {
-        delta_seq = seq - rtp_seq (prev);
-        if (delta_seq < 0)
-            break;
-        if (delta_seq == 0)
+        rtp_session_stats (demux, session);
+        session->stats_time = now;
+    }
+
+    /* Queues the block in its slot of the ring, in sequence order,
+     * hence there is a single queue for all payload types. */
+    uint16_t offset = seq - (uint16_t)(src->last_seq + 1);
+    if (offset >= 0x8000)
+    {   /* Trash too late packets (and PIM Assert duplicates) */
+        msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")", seq);
+        src->late++;
+        goto drop;
+    }
+
+    while (offset > session->ring_mask)
+    {   /* Too far ahead, give up on the oldest packets to make room */
+        if (src->count == 0)
         {
-            msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
-            goto drop; /* duplicate */
+            msg_Warn (demux, "%"PRIu16" packet(s) skipped", offset);
+            src->last_seq = seq - 1;
+            src->discontinuity = true;
+            break;
         }
-        pp = &prev->p_next;
+        rtp_decode (demux, session, src);
+        offset = seq - (uint16_t)(src->last_seq + 1);
     }
-    block->p_next = *pp;
-    *pp = block;
 
-    /*rtp_decode (demux, session, src);*/
+    block_t **slot = &src->ring[seq & session->ring_mask];
+    if (*slot != NULL)
+    {
+        msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
+        goto drop; /* duplicate */
+    }
+    *slot = block;
+    if (src->count++ == 0 || (int16_t)(seq - src->first_seq) < 0)
+        src->first_seq = seq;
     return;
 
 drop:
@@ -401,7 +596,6 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
 
         /* Because of IP packet delay variation (IPDV), we need to guesstimate
          * how long to wait for a missing packet in the RTP sequence
@@ -419,10 +613,12 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
          * LibVLC E/S-out clock synchronization. Here, we need to bother about
          * re-ordering packets, as decoders can't cope with mis-ordered data.
          */
-        while (((block = src->blocks)) != NULL)
+        while (src->count > 0)
         {
-            if ((int16_t)(rtp_seq (block) - (src->last_seq + 1)) <= 0)
-            {   /* Next (or earlier) block ready, no need to wait */
+            block_t *block = src->ring[src->first_seq & session->ring_mask];
+
+            if (src->first_seq == (uint16_t)(src->last_seq + 1))
+            {   /* Next block ready, no need to wait */
                 rtp_decode (demux, session, src);
                 continue;
             }
@@ -470,37 +666,38 @@ void rtp_dequeue_force (demux_t *demux, const rtp_session_t *session)
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
 
-        while (((block = src->blocks)) != NULL)
+        while (src->count > 0)
             rtp_decode (demux, session, src);
     }
 }
 
 /**
- * Decodes one RTP packet.
+ * Decodes the first queued RTP packet.
  */
 static void
 rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src)
 {
-    block_t *block = src->blocks;
-
-    assert (block);
-    src->blocks = block->p_next;
-    block->p_next = NULL;
+    block_t **slot = &src->ring[src->first_seq & session->ring_mask];
+    block_t *block = *slot;
+
+    assert (src->count > 0 && block != NULL);
+    *slot = NULL;
+    if (--src->count > 0)
+    {   /* Skip over the missing packets, each slot is only scanned once */
+        do
+            src->first_seq++;
+        while (src->ring[src->first_seq & session->ring_mask] == NULL);
+    }
 
     /* Discontinuity detection */
     uint16_t delta_seq = rtp_seq (block) - (src->last_seq + 1);
     if (delta_seq != 0)
-    {
-        if (delta_seq >= 0x8000)
-        {   /* Trash too late packets (and PIM Assert duplicates) */
-            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
-                      rtp_seq (block));
-            goto drop;
-        }
         msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq);
+    if (delta_seq != 0 || src->discontinuity)
+    {
         block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        src->discontinuity = false;
     }
     src->last_seq = rtp_seq (block);
 
@@ -31,17 +31,37 @@
 #include <vlc_network.h>
 #include <vlc_url.h>
 
-
+/* Received blocks queued between the receive thread and the reader */
+#define SRT_RING_SIZE 64
+/* Receive thread poll timeout, i.e. maximum latency to stop (ms) */
+#define SRT_THREAD_POLL_TIMEOUT 100
+#define SRT_STATS_INTERVAL VLC_TICK_FROM_SEC(5)
 
 typedef struct
 {
     SRTSOCKET   sock;
     int         i_poll_id;
-    vlc_mutex_t lock;
-    bool        b_interrupted;
     char       *psz_host;
     int         i_port;
     int         i_chunks; /* Number of chunks to allocate in the next read */
+    int         i_latency; /* Configured latency (ms) */
+
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    bool        b_stop;
+    bool        b_interrupted;
+
+    /* Blocks received by the thread, from the oldest */
+    block_t    *ring[SRT_RING_SIZE];
+    unsigned    i_ring_head;
+    unsigned    i_ring_count;
+    unsigned    i_dropped; /* blocks dropped since the last statistics */
+
+    /* Link statistics, as signal quality and strength */
+    bool        b_stats;
+    double      f_quality; /* ratio of packets received in time */
+    double      f_strength; /* receive buffer fill relative to latency */
 } stream_sys_t;
 
 
@@ -52,16 +72,8 @@ static void srt_wait_interrupted(void *p_data)
     stream_sys_t *p_sys = p_stream->p_sys;
 
     vlc_mutex_lock( &p_sys->lock );
-    if ( p_sys->i_poll_id >= 0 &&  p_sys->sock != SRT_INVALID_SOCK )
-    {
-        p_sys->b_interrupted = true;
-
-        msg_Dbg( p_stream, "Waking up srt_epoll_wait");
-
-        /* Removing all socket descriptors from the monitoring list
-         * wakes up SRT's threads. We only have one to remove. */
-        srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
-    }
+    p_sys->b_interrupted = true;
+    vlc_cond_signal( &p_sys->wait );
     vlc_mutex_unlock( &p_sys->lock );
 }
 
@@ -81,6 +93,23 @@ static int Control(stream_t *p_stream, int i_query, va_list args)
             *va_arg( args, vlc_tick_t * ) = VLC_TICK_FROM_MS(
                    var_InheritInteger(p_stream, "network-caching") );
             break;
+        case STREAM_GET_SIGNAL:
+        {
+            stream_sys_t *p_sys = p_stream->p_sys;
+            double *pf_quality = va_arg( args, double * );
+            double *pf_strength = va_arg( args, double * );
+
+            vlc_mutex_lock( &p_sys->lock );
+            if ( p_sys->b_stats )
+            {
+                *pf_quality = p_sys->f_quality;
+                *pf_strength = p_sys->f_strength;
+            }
+            else
+                i_ret = VLC_EGENERIC;
+            vlc_mutex_unlock( &p_sys->lock );
+            break;
+        }
         default:
             i_ret = VLC_EGENERIC;
             break;
@@ -165,6 +194,7 @@ static bool srt_schedule_reconnect(stream_t *p_stream)
     /* Set latency */
     srt_set_socket_option( strm_obj, SRT_PARAM_LATENCY, p_sys->sock,
             SRTO_TSBPDDELAY, &i_latency, sizeof(i_latency) );
+    p_sys->i_latency = i_latency;
 
     /* set passphrase */
     if (psz_passphrase != NULL && psz_passphrase[0] != '\0') {
@@ -217,22 +247,50 @@ out:
     return !failed;
 }
 
-static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
+/* Polls and reads from the receive thread */
+static block_t *ReadSRT(stream_t *p_stream)
 {
     stream_sys_t *p_sys = p_stream->p_sys;
     int i_chunk_size = var_InheritInteger( p_stream, "chunk-size" );
-    int i_poll_timeout = var_InheritInteger( p_stream, "poll-timeout" );
-    /* SRT doesn't have a concept of EOF for live streams. */
-    VLC_UNUSED(eof);
 
-    if ( vlc_killed() )
+    if ( p_sys->i_chunks == 0 )
+        p_sys->i_chunks = SRT_MIN_CHUNKS_TRYREAD;
+
+    SRTSOCKET ready[1];
+    int readycnt = 1;
+    if ( srt_epoll_wait( p_sys->i_poll_id,
+        ready, &readycnt, 0, 0,
+        SRT_THREAD_POLL_TIMEOUT, NULL, 0, NULL, 0 ) < 0 )
     {
-        /* We are told to stop. Stop. */
+        /* if the poll reports errors for any reason at all,
+         * including a timeout, we skip the turn.
+         */
         return NULL;
     }
 
-    if ( p_sys->i_chunks == 0 )
-        p_sys->i_chunks = SRT_MIN_CHUNKS_TRYREAD;
+    if ( readycnt < 0  || ready[0] != p_sys->sock )
+    {
+        /* should never happen, force recovery */
+        srt_close(p_sys->sock);
+        p_sys->sock = SRT_INVALID_SOCK;
+    }
+
+    switch( srt_getsockstate( p_sys->sock ) )
+    {
+        case SRTS_CONNECTED:
+            /* Good to go */
+            break;
+        case SRTS_BROKEN:
+        case SRTS_NONEXIST:
+        case SRTS_CLOSED:
+            /* Failed. Schedule recovery. */
+            if ( !srt_schedule_reconnect( p_stream ) )
+                msg_Err( p_stream, "Failed to schedule connect" );
+            /* Fall-through */
+        default:
+            /* Not ready */
+            return NULL;
+    }
 
     size_t i_chunk_size_actual = ( i_chunk_size > 0 )
         ? i_chunk_size : SRT_DEFAULT_CHUNK_SIZE;
@@ -243,102 +301,171 @@ static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
         return NULL;
     }
 
-    vlc_interrupt_register( srt_wait_interrupted, p_stream);
-
-    SRTSOCKET ready[1];
-    int readycnt = 1;
-    while ( srt_epoll_wait( p_sys->i_poll_id,
-        ready, &readycnt, 0, 0,
-        i_poll_timeout, NULL, 0, NULL, 0 ) >= 0)
+    /* Try to get as much data as possible out of the lib, if there
+     * is still some left, increase the number of chunks to read so that
+     * it will read faster on the next iteration. This way the buffer will
+     * grow until it reads fast enough to keep the library empty after
+     * each iteration.
+     */
+    pkt->i_buffer = 0;
+    while ( ( bufsize - pkt->i_buffer ) >= i_chunk_size_actual )
     {
-        if ( readycnt < 0  || ready[0] != p_sys->sock )
+        int stat = srt_recvmsg( p_sys->sock,
+            (char *)( pkt->p_buffer + pkt->i_buffer ),
+            bufsize - pkt->i_buffer );
+        if ( stat <= 0 )
         {
-            /* should never happen, force recovery */
-            srt_close(p_sys->sock);
-            p_sys->sock = SRT_INVALID_SOCK;
+            break;
         }
+        pkt->i_buffer += (size_t)stat;
+    }
 
-        switch( srt_getsockstate( p_sys->sock ) )
+    /* Gradually adjust number of chunks we read at a time
+    * up to a predefined maximum. The actual number we might
+    * settle on depends on stream's bit rate.
+    */
+    size_t rem = bufsize - pkt->i_buffer;
+    if ( rem < i_chunk_size_actual )
+    {
+        if ( p_sys->i_chunks < SRT_MAX_CHUNKS_TRYREAD )
         {
-            case SRTS_CONNECTED:
-                /* Good to go */
-                break;
-            case SRTS_BROKEN:
-            case SRTS_NONEXIST:
-            case SRTS_CLOSED:
-                /* Failed. Schedule recovery. */
-                if ( !srt_schedule_reconnect( p_stream ) )
-                    msg_Err( p_stream, "Failed to schedule connect" );
-                /* Fall-through */
-            default:
-                /* Not ready */
-                continue;
+            p_sys->i_chunks++;
         }
+    }
 
-        /* Try to get as much data as possible out of the lib, if there
-         * is still some left, increase the number of chunks to read so that
-         * it will read faster on the next iteration. This way the buffer will
-         * grow until it reads fast enough to keep the library empty after
-         * each iteration.
-         */
-        pkt->i_buffer = 0;
-        while ( ( bufsize - pkt->i_buffer ) >= i_chunk_size_actual )
+    if (pkt->i_buffer == 0) {
+      block_Release(pkt);
+      pkt = NULL;
+    }
+
+    return pkt;
+}
+
+/* Gathers the link statistics, resetting the interval counters */
+static void StatsSRT(stream_t *p_stream)
+{
+    stream_sys_t *p_sys = p_stream->p_sys;
+    SRT_TRACEBSTATS perf;
+
+    if ( p_sys->sock == SRT_INVALID_SOCK
+      || srt_bstats( p_sys->sock, &perf, 1 ) == SRT_ERROR )
+        return;
+
+    int64_t i_total = (int64_t)perf.pktRecv + perf.pktRcvLoss;
+    double f_quality = ( i_total > 0 )
+        ? (double)( perf.pktRecv - perf.pktRcvDrop ) / i_total : 1.;
+    double f_strength = ( p_sys->i_latency > 0 )
+        ? (double)perf.msRcvBuf / p_sys->i_latency : 1.;
+
+    if ( f_quality < 0. )
+        f_quality = 0.;
+    if ( f_strength > 1. )
+        f_strength = 1.;
+
+    vlc_mutex_lock( &p_sys->lock );
+    unsigned i_dropped = p_sys->i_dropped;
+    p_sys->i_dropped = 0;
+    p_sys->f_quality = f_quality;
+    p_sys->f_strength = f_strength;
+    p_sys->b_stats = true;
+    vlc_mutex_unlock( &p_sys->lock );
+
+    msg_Dbg( p_stream, "RTT %.1f ms, receiving %.2f Mbps (link %.2f Mbps), "
+             "%d packets lost, %d retransmitted, %d dropped, %d belated, "
+             "receive buffer %d ms (%d bytes)", perf.msRTT, perf.mbpsRecvRate,
+             perf.mbpsBandwidth, perf.pktRcvLoss, perf.pktRcvRetrans,
+             perf.pktRcvDrop, perf.pktRcvBelated, perf.msRcvBuf,
+             perf.byteRcvBuf );
+    if ( i_dropped > 0 )
+        msg_Warn( p_stream, "%u blocks dropped, reading too slowly",
+                  i_dropped );
+}
+
+/* Receives data ahead of the reader, so that the SRT receive buffer gets
+ * drained at the link rate whatever the input thread is doing. */
+static void *ThreadSRT(void *data)
+{
+    stream_t *p_stream = data;
+    stream_sys_t *p_sys = p_stream->p_sys;
+    vlc_tick_t i_stats = vlc_tick_now() + SRT_STATS_INTERVAL;
+
+    vlc_mutex_lock( &p_sys->lock );
+    while ( !p_sys->b_stop )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+
+        block_t *pkt = ReadSRT( p_stream );
+
+        vlc_tick_t now = vlc_tick_now();
+        if ( now >= i_stats )
         {
-            int stat = srt_recvmsg( p_sys->sock,
-                (char *)( pkt->p_buffer + pkt->i_buffer ),
-                bufsize - pkt->i_buffer );
-            if ( stat <= 0 )
-            {
-                break;
-            }
-            pkt->i_buffer += (size_t)stat;
+            StatsSRT( p_stream );
+            i_stats = now + SRT_STATS_INTERVAL;
         }
 
-        msg_Dbg ( p_stream, "Read %zu bytes out of a max of %zu"
-            " (%d chunks of %zu bytes)", pkt->i_buffer,
-            p_sys->i_chunks * i_chunk_size_actual, p_sys->i_chunks,
-                 i_chunk_size_actual );
-
+        vlc_mutex_lock( &p_sys->lock );
+        if ( pkt == NULL )
+            continue;
 
-        /* Gradually adjust number of chunks we read at a time
-        * up to a predefined maximum. The actual number we might
-        * settle on depends on stream's bit rate.
-        */
-        size_t rem = bufsize - pkt->i_buffer;
-        if ( rem < i_chunk_size_actual )
+        if ( p_sys->i_ring_count == SRT_RING_SIZE )
         {
-            if ( p_sys->i_chunks < SRT_MAX_CHUNKS_TRYREAD )
-            {
-                p_sys->i_chunks++;
-            }
+            /* The reader is late: drop the oldest data */
+            block_Release( p_sys->ring[p_sys->i_ring_head] );
+            p_sys->i_ring_head = ( p_sys->i_ring_head + 1 ) % SRT_RING_SIZE;
+            p_sys->i_ring_count--;
+            p_sys->i_dropped++;
         }
 
-        goto out;
+        p_sys->ring[( p_sys->i_ring_head + p_sys->i_ring_count )
+                    % SRT_RING_SIZE] = pkt;
+        p_sys->i_ring_count++;
+        vlc_cond_signal( &p_sys->wait );
     }
+    vlc_mutex_unlock( &p_sys->lock );
 
-    /* if the poll reports errors for any reason at all,
-     * including a timeout, we skip the turn.
-     */
-    pkt->i_buffer = 0;
+    return NULL;
+}
 
-out:
-    if (pkt->i_buffer == 0) {
-      block_Release(pkt);
-      pkt = NULL;
+static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
+{
+    stream_sys_t *p_sys = p_stream->p_sys;
+    int i_poll_timeout = var_InheritInteger( p_stream, "poll-timeout" );
+    block_t *pkt = NULL;
+    /* SRT doesn't have a concept of EOF for live streams. */
+    VLC_UNUSED(eof);
+
+    if ( vlc_killed() )
+    {
+        /* We are told to stop. Stop. */
+        return NULL;
     }
 
-    vlc_interrupt_unregister();
+    vlc_tick_t deadline = ( i_poll_timeout >= 0 )
+        ? vlc_tick_now() + VLC_TICK_FROM_MS( i_poll_timeout )
+        : VLC_TICK_INVALID;
+
+    vlc_interrupt_register( srt_wait_interrupted, p_stream);
 
-    /* Re-add the socket to the poll if we were interrupted */
     vlc_mutex_lock( &p_sys->lock );
-    if ( p_sys->b_interrupted )
+    while ( p_sys->i_ring_count == 0 && !p_sys->b_interrupted )
+    {
+        if ( deadline == VLC_TICK_INVALID )
+            vlc_cond_wait( &p_sys->wait, &p_sys->lock );
+        else if ( vlc_cond_timedwait( &p_sys->wait, &p_sys->lock, deadline ) )
+            break;
+    }
+
+    if ( p_sys->i_ring_count > 0 )
     {
-        srt_epoll_add_usock( p_sys->i_poll_id, p_sys->sock,
-            &(int) { SRT_EPOLL_ERR | SRT_EPOLL_IN } );
-        p_sys->b_interrupted = false;
+        pkt = p_sys->ring[p_sys->i_ring_head];
+        p_sys->i_ring_head = ( p_sys->i_ring_head + 1 ) % SRT_RING_SIZE;
+        p_sys->i_ring_count--;
     }
+    p_sys->b_interrupted = false;
     vlc_mutex_unlock( &p_sys->lock );
 
+    vlc_interrupt_unregister();
+
     return pkt;
 }
 
@@ -355,6 +482,7 @@ static int Open(vlc_object_t *p_this)
     srt_startup();
 
     vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( &p_sys->wait );
 
     p_stream->p_sys = p_sys;
 
@@ -384,6 +512,10 @@ static int Open(vlc_object_t *p_this)
         goto failed;
     }
 
+    if ( vlc_clone( &p_sys->thread, ThreadSRT, p_stream,
+                    VLC_THREAD_PRIORITY_INPUT ) )
+        goto failed;
+
     p_stream->pf_block = BlockSRT;
     p_stream->pf_control = Control;
 
@@ -401,6 +533,15 @@ static void Close(vlc_object_t *p_this)
     stream_t     *p_stream = (stream_t*)p_this;
     stream_sys_t *p_sys = p_stream->p_sys;
 
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_stop = true;
+    vlc_mutex_unlock( &p_sys->lock );
+    vlc_join( p_sys->thread, NULL );
+
+    for ( unsigned i = 0; i < p_sys->i_ring_count; i++ )
+        block_Release( p_sys->ring[( p_sys->i_ring_head + i )
+                                   % SRT_RING_SIZE] );
+
     srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
     srt_close( p_sys->sock );
     srt_epoll_release( p_sys->i_poll_id );
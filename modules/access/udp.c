@@ -47,16 +47,54 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <errno.h>
+# include <sys/socket.h>
+#endif
 
 /* Buffer can be max theoretical datagram content minus anticipated MTU.
  * IPv6 headers are larger than IPv4, ignore IPv6 jumbograms.
  */
 #define MRU 65507u
 
+#ifdef HAVE_RECVMMSG
+/* Initial size of the batch mode buffers: Ethernet MTU minus IPv4/UDP */
+# define BATCH_MRU (1500u - (20 + 8))
+# define BATCH_MAX 256
+# define JITTER_REPORT_PERIOD VLC_TICK_FROM_SEC(10)
+
+typedef union {
+    char buf[CMSG_SPACE(sizeof(struct timespec))];
+    struct cmsghdr align;
+} ts_control_t;
+#endif
+
 typedef struct {
     int fd;
     int timeout;
 
+#ifdef HAVE_RECVMMSG
+    /* batch mode: ring of preallocated blocks filled by recvmmsg() */
+    struct {
+        unsigned size; /* datagrams per call, 0 if disabled */
+        unsigned pos; /* next received datagram */
+        unsigned count; /* received datagrams */
+        size_t mru;
+        block_t **blocks;
+        struct mmsghdr *msgs;
+        struct iovec *iovs;
+        ts_control_t *controls; /* NULL without timestamps */
+    } ring;
+
+    /* arrival statistics from the kernel timestamps */
+    struct {
+        vlc_tick_t last; /* last arrival */
+        vlc_tick_t interval; /* mean inter-arrival time */
+        vlc_tick_t jitter; /* mean deviation from it */
+        vlc_tick_t report;
+    } arrival;
+#endif
+
     size_t length;
     char *offset;
     char buf[MRU];
@@ -132,6 +170,170 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+#ifdef HAVE_RECVMMSG
+static void UpdateArrival(stream_t *access, struct msghdr *hdr)
+{
+    access_sys_t *sys = access->p_sys;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+         cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET
+         || cmsg->cmsg_type != SCM_TIMESTAMPNS)
+            continue;
+
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof (ts));
+
+        vlc_tick_t date = vlc_tick_from_timespec(&ts);
+        if (sys->arrival.last != VLC_TICK_INVALID)
+        {
+            vlc_tick_t interval = date - sys->arrival.last;
+            vlc_tick_t deviation = interval - sys->arrival.interval;
+
+            /* same smoothing as the RTP interarrival jitter (RFC 3550) */
+            sys->arrival.interval += deviation / 16;
+            if (deviation < 0)
+                deviation = -deviation;
+            sys->arrival.jitter += (deviation - sys->arrival.jitter) / 16;
+        }
+        sys->arrival.last = date;
+
+        if (date >= sys->arrival.report)
+        {
+            if (sys->arrival.report != VLC_TICK_INVALID)
+                msg_Dbg(access, "datagram interval %"PRId64" us, "
+                        "jitter %"PRId64" us",
+                        US_FROM_VLC_TICK(sys->arrival.interval),
+                        US_FROM_VLC_TICK(sys->arrival.jitter));
+            sys->arrival.report = date + JITTER_REPORT_PERIOD;
+        }
+        break;
+    }
+}
+
+static block_t *BlockBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->ring.pos >= sys->ring.count)
+    {
+        /* Replace the blocks handed out by the previous batch */
+        for (unsigned i = 0; i < sys->ring.size; i++)
+        {
+            if (sys->ring.blocks[i] == NULL)
+            {
+                sys->ring.blocks[i] = block_Alloc(sys->ring.mru);
+                if (unlikely(sys->ring.blocks[i] == NULL))
+                    return NULL;
+            }
+
+            struct msghdr *hdr = &sys->ring.msgs[i].msg_hdr;
+
+            sys->ring.iovs[i].iov_base = sys->ring.blocks[i]->p_buffer;
+            sys->ring.iovs[i].iov_len = sys->ring.blocks[i]->i_buffer;
+            hdr->msg_flags = 0;
+            if (sys->ring.controls != NULL)
+                hdr->msg_controllen = sizeof (sys->ring.controls[i]);
+        }
+        sys->ring.pos = sys->ring.count = 0;
+
+        struct pollfd ufd[1];
+
+        ufd[0].fd = sys->fd;
+        ufd[0].events = POLLIN;
+
+        switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+            case 0:
+                msg_Err(access, "receive time-out");
+                *eof = true;
+                /* fall through */
+            case -1:
+                return NULL;
+        }
+
+        int val = recvmmsg(sys->fd, sys->ring.msgs, sys->ring.size,
+                           MSG_WAITFORONE | MSG_TRUNC, NULL);
+        if (val <= 0)
+            return NULL;
+        sys->ring.count = val;
+    }
+
+    const unsigned i = sys->ring.pos++;
+    struct mmsghdr *msg = &sys->ring.msgs[i];
+    block_t *block = sys->ring.blocks[i];
+
+    sys->ring.blocks[i] = NULL;
+
+    if (msg->msg_hdr.msg_flags & MSG_TRUNC)
+    {
+        msg_Err(access, "%u bytes datagram truncated (MRU was %zu)",
+                msg->msg_len, block->i_buffer);
+        block->i_flags |= BLOCK_FLAG_CORRUPTED;
+        /* grow the next buffers */
+        sys->ring.mru = __MIN(msg->msg_len, MRU);
+    }
+    else
+        block->i_buffer = msg->msg_len;
+
+    if (sys->ring.controls != NULL)
+        UpdateArrival(access, &msg->msg_hdr);
+
+    return block;
+}
+
+static int OpenBatch(stream_t *access, unsigned size, bool timestamps)
+{
+    access_sys_t *sys = access->p_sys;
+    vlc_object_t *obj = VLC_OBJECT(access);
+
+    sys->ring.size = 0;
+    sys->ring.pos = sys->ring.count = 0;
+    sys->ring.mru = BATCH_MRU;
+    sys->ring.controls = NULL;
+    sys->arrival.last = VLC_TICK_INVALID;
+    sys->arrival.interval = 0;
+    sys->arrival.jitter = 0;
+    sys->arrival.report = VLC_TICK_INVALID;
+
+    sys->ring.blocks = vlc_obj_calloc(obj, size, sizeof (*sys->ring.blocks));
+    sys->ring.msgs = vlc_obj_calloc(obj, size, sizeof (*sys->ring.msgs));
+    sys->ring.iovs = vlc_obj_calloc(obj, size, sizeof (*sys->ring.iovs));
+    if (unlikely(sys->ring.blocks == NULL || sys->ring.msgs == NULL
+              || sys->ring.iovs == NULL))
+        return VLC_ENOMEM;
+
+    if (timestamps)
+    {
+        int on = 1;
+
+        if (setsockopt(sys->fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof (on)))
+            msg_Warn(access, "cannot enable reception timestamps: %s",
+                     vlc_strerror_c(errno));
+        else
+        {
+            sys->ring.controls = vlc_obj_calloc(obj, size,
+                                                sizeof (*sys->ring.controls));
+            if (unlikely(sys->ring.controls == NULL))
+                return VLC_ENOMEM;
+        }
+    }
+
+    for (unsigned i = 0; i < size; i++)
+    {
+        struct msghdr *hdr = &sys->ring.msgs[i].msg_hdr;
+
+        hdr->msg_iov = &sys->ring.iovs[i];
+        hdr->msg_iovlen = 1;
+        if (sys->ring.controls != NULL)
+            hdr->msg_control = sys->ring.controls[i].buf;
+    }
+
+    sys->ring.size = size;
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -217,6 +419,25 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    unsigned i_batch = var_InheritInteger( p_access, "udp-batch" );
+    if( i_batch > BATCH_MAX )
+        i_batch = BATCH_MAX;
+    if( i_batch > 1 )
+    {
+        if( OpenBatch( p_access, i_batch,
+                       var_InheritBool( p_access, "udp-timestamps" ) ) )
+        {
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+        p_access->pf_read = NULL;
+        p_access->pf_block = BlockBatch;
+    }
+    else
+        sys->ring.size = 0;
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -228,10 +449,23 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    for( unsigned i = 0; i < sys->ring.size; i++ )
+        if( sys->ring.blocks[i] != NULL )
+            block_Release( sys->ring.blocks[i] );
+#endif
     net_Close( sys->fd );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Datagrams received at once")
+#define BATCH_LONGTEXT N_( \
+    "Number of datagrams which can be received with a single system call. " \
+    "0 or 1 receives them one by one.")
+#define TIMESTAMPS_TEXT N_("Reception timestamps")
+#define TIMESTAMPS_LONGTEXT N_( \
+    "Get the datagrams arrival time from the kernel, " \
+    "to report the reception jitter.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -242,6 +476,12 @@ vlc_module_begin()
     add_obsolete_integer("server-port") /* since 2.0.0 */
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL, true)
+#ifdef HAVE_RECVMMSG
+    add_integer_with_range("udp-batch", 32, 0, BATCH_MAX,
+                           BATCH_TEXT, BATCH_LONGTEXT, true)
+    add_bool("udp-timestamps", false, TIMESTAMPS_TEXT, TIMESTAMPS_LONGTEXT,
+             true)
+#endif
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
@@ -58,26 +58,329 @@
 
 #define SOUT_CFG_PREFIX "sout-file-"
 
+/*****************************************************************************
+ * Asynchronous writer: the blocks are coalesced into large aligned chunks,
+ * which a thread writes, so that a slow disk does not stall the muxer.
+ *****************************************************************************/
+#define WRITER_CHUNK_SIZE (1 << 20)
+#define WRITER_ALIGN 4096
+#define WRITER_QUEUE_MAX 16 /* chunks in flight */
+
+typedef struct file_chunk
+{
+    struct file_chunk *next;
+    size_t length;
+    unsigned char *data; /* WRITER_CHUNK_SIZE bytes, WRITER_ALIGN-aligned */
+} file_chunk_t;
+
+typedef struct
+{
+    int fd;
+    bool direct; /* O_DIRECT is set on the file descriptor */
+    uint64_t offset; /* file offset of the next chunk */
+    vlc_thread_t thread;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /* signals the writer thread */
+    vlc_cond_t done; /* signals the muxer thread */
+    file_chunk_t *queue;
+    file_chunk_t **tailp;
+    file_chunk_t *pool; /* recycled chunks */
+    unsigned queued; /* chunks queued or being written */
+    int error; /* errno of the first failed write */
+    bool closing;
+
+    file_chunk_t *chunk; /* being filled, owned by the muxer thread */
+} file_writer_t;
+
+typedef struct
+{
+    int fd;
+    file_writer_t *writer; /* NULL if writing synchronously */
+} sout_access_out_sys_t;
+
+static int WriterWrite( file_writer_t *w, const file_chunk_t *c )
+{
+#ifdef O_DIRECT
+    if (w->direct && ((w->offset | c->length) & (WRITER_ALIGN - 1)))
+    {   /* direct I/O needs aligned offsets and lengths: the tail of the
+         * file, or anything written after a seek, goes through the cache */
+        int flags = fcntl(w->fd, F_GETFL);
+        if (flags != -1)
+            fcntl(w->fd, F_SETFL, flags & ~O_DIRECT);
+        w->direct = false;
+    }
+#endif
+    const unsigned char *p = c->data;
+    size_t length = c->length;
+
+    while (length > 0)
+    {
+        ssize_t val = write(w->fd, p, length);
+        if (val < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        p += val;
+        length -= val;
+        w->offset += val;
+    }
+    return 0;
+}
+
+static void *WriterThread( void *data )
+{
+    file_writer_t *w = data;
+
+    vlc_mutex_lock(&w->lock);
+    for (;;)
+    {
+        while (w->queue == NULL && !w->closing)
+            vlc_cond_wait(&w->wait, &w->lock);
+
+        file_chunk_t *c = w->queue;
+        if (c == NULL)
+            break;
+
+        w->queue = c->next;
+        if (w->queue == NULL)
+            w->tailp = &w->queue;
+        vlc_mutex_unlock(&w->lock);
+
+        /* only this thread sets the error */
+        int err = (w->error == 0) ? WriterWrite(w, c) : 0;
+
+        vlc_mutex_lock(&w->lock);
+        if (err != 0)
+            w->error = err;
+        c->length = 0;
+        c->next = w->pool;
+        w->pool = c;
+        w->queued--;
+        vlc_cond_signal(&w->done);
+    }
+    vlc_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+static file_chunk_t *WriterGetChunk( file_writer_t *w )
+{
+    if (w->chunk != NULL)
+        return w->chunk;
+
+    vlc_mutex_lock(&w->lock);
+    file_chunk_t *c = w->pool;
+    if (c != NULL)
+        w->pool = c->next;
+    vlc_mutex_unlock(&w->lock);
+
+    if (c == NULL)
+    {
+        c = malloc(sizeof (*c));
+        if (unlikely(c == NULL))
+            return NULL;
+        c->data = aligned_alloc(WRITER_ALIGN, WRITER_CHUNK_SIZE);
+        if (unlikely(c->data == NULL))
+        {
+            free(c);
+            return NULL;
+        }
+        c->length = 0;
+    }
+    w->chunk = c;
+    return c;
+}
+
+/* Queues the chunk being filled, waiting if too many are in flight */
+static void WriterQueue( file_writer_t *w )
+{
+    file_chunk_t *c = w->chunk;
+
+    w->chunk = NULL;
+    c->next = NULL;
+
+    vlc_mutex_lock(&w->lock);
+    while (w->queued >= WRITER_QUEUE_MAX)
+        vlc_cond_wait(&w->done, &w->lock);
+    *w->tailp = c;
+    w->tailp = &c->next;
+    w->queued++;
+    vlc_cond_signal(&w->wait);
+    vlc_mutex_unlock(&w->lock);
+}
+
+/* Writes everything out, returns the errno of the first failed write */
+static int WriterDrain( file_writer_t *w )
+{
+    if (w->chunk != NULL && w->chunk->length > 0)
+        WriterQueue(w);
+
+    vlc_mutex_lock(&w->lock);
+    while (w->queued > 0)
+        vlc_cond_wait(&w->done, &w->lock);
+    int err = w->error;
+    vlc_mutex_unlock(&w->lock);
+    return err;
+}
+
+static void WriterFreeChunks( file_chunk_t *c )
+{
+    while (c != NULL)
+    {
+        file_chunk_t *next = c->next;
+
+        aligned_free(c->data);
+        free(c);
+        c = next;
+    }
+}
+
+static file_writer_t *WriterNew( sout_access_out_t *p_access, int fd,
+                                 bool direct )
+{
+    file_writer_t *w = malloc(sizeof (*w));
+    if (unlikely(w == NULL))
+        return NULL;
+
+    w->fd = fd;
+    w->direct = false;
+    w->offset = lseek(fd, 0, SEEK_CUR);
+    vlc_mutex_init(&w->lock);
+    vlc_cond_init(&w->wait);
+    vlc_cond_init(&w->done);
+    w->queue = NULL;
+    w->tailp = &w->queue;
+    w->pool = NULL;
+    w->queued = 0;
+    w->error = 0;
+    w->closing = false;
+    w->chunk = NULL;
+
+#ifdef O_DIRECT
+    if (direct)
+    {
+        int flags = fcntl(fd, F_GETFL);
+        if (flags != -1 && fcntl(fd, F_SETFL, flags | O_DIRECT) == 0)
+            w->direct = true;
+        else
+            msg_Warn(p_access, "cannot bypass the page cache: %s",
+                     vlc_strerror_c(errno));
+    }
+#else
+    VLC_UNUSED(direct);
+#endif
+
+    if (vlc_clone(&w->thread, WriterThread, w, VLC_THREAD_PRIORITY_OUTPUT))
+    {
+#ifdef O_DIRECT
+        if (w->direct)
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+#endif
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+static void WriterDelete( sout_access_out_t *p_access, file_writer_t *w )
+{
+    int err = WriterDrain(w);
+    if (err != 0)
+        msg_Err(p_access, "cannot write: %s", vlc_strerror_c(err));
+
+    vlc_mutex_lock(&w->lock);
+    w->closing = true;
+    vlc_cond_signal(&w->wait);
+    vlc_mutex_unlock(&w->lock);
+    vlc_join(w->thread, NULL);
+
+    WriterFreeChunks(w->chunk);
+    WriterFreeChunks(w->pool);
+    free(w);
+}
+
 /*****************************************************************************
  * Read: standard read on a file descriptor.
  *****************************************************************************/
 static ssize_t Read( sout_access_out_t *p_access, block_t *p_buffer )
 {
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
     ssize_t val;
 
+    if (p_sys->writer != NULL && WriterDrain(p_sys->writer) != 0)
+        return -1;
+
     do
         val = read(fd, p_buffer->p_buffer, p_buffer->i_buffer);
     while (val == -1 && errno == EINTR);
+
+    if (p_sys->writer != NULL && val > 0)
+        p_sys->writer->offset = lseek(fd, 0, SEEK_CUR);
     return val;
 }
 
+/*****************************************************************************
+ * WriteAsync: coalesce the blocks into chunks for the writer thread
+ *****************************************************************************/
+static ssize_t WriteAsync( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    file_writer_t *w = p_sys->writer;
+    size_t i_write = 0;
+
+    vlc_mutex_lock(&w->lock);
+    int err = w->error;
+    vlc_mutex_unlock(&w->lock);
+
+    while (p_buffer != NULL && err == 0)
+    {
+        block_t *p_next = p_buffer->p_next;
+        const uint8_t *p = p_buffer->p_buffer;
+        size_t length = p_buffer->i_buffer;
+
+        while (length > 0)
+        {
+            file_chunk_t *c = WriterGetChunk(w);
+            if (unlikely(c == NULL))
+            {
+                err = ENOMEM;
+                break;
+            }
+
+            size_t copy = __MIN(length, WRITER_CHUNK_SIZE - c->length);
+            memcpy(c->data + c->length, p, copy);
+            c->length += copy;
+            p += copy;
+            length -= copy;
+            i_write += copy;
+
+            if (c->length == WRITER_CHUNK_SIZE)
+                WriterQueue(w);
+        }
+
+        block_Release(p_buffer);
+        p_buffer = p_next;
+    }
+
+    if (err != 0)
+    {
+        block_ChainRelease(p_buffer);
+        msg_Err(p_access, "cannot write: %s", vlc_strerror_c(err));
+        return -1;
+    }
+    return i_write;
+}
+
 /*****************************************************************************
  * Write: standard write on a file descriptor.
  *****************************************************************************/
 static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
     size_t i_write = 0;
 
     while( p_buffer )
@@ -110,7 +413,8 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
 static ssize_t WritePipe(sout_access_out_t *access, block_t *block)
 {
-    int *fdp = access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *sys = access->p_sys;
+    int fd = sys->fd;
     ssize_t total = 0;
 
     while (block != NULL)
@@ -149,7 +453,8 @@ static ssize_t WritePipe(sout_access_out_t *access, block_t *block)
 #ifdef S_ISSOCK
 static ssize_t Send(sout_access_out_t *access, block_t *block)
 {
-    int *fdp = access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *sys = access->p_sys;
+    int fd = sys->fd;
     size_t total = 0;
 
     while (block != NULL)
@@ -188,7 +493,19 @@ static ssize_t Send(sout_access_out_t *access, block_t *block)
  *****************************************************************************/
 static int Seek( sout_access_out_t *p_access, off_t i_pos )
 {
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
+
+    if (p_sys->writer != NULL)
+    {
+        if (WriterDrain(p_sys->writer) != 0)
+            return -1;
+
+        off_t ret = lseek(fd, i_pos, SEEK_SET);
+        if (ret != -1)
+            p_sys->writer->offset = ret;
+        return ret;
+    }
 
     return lseek(fd, i_pos, SEEK_SET);
 }
@@ -223,6 +540,10 @@ static const char *const ppsz_sout_options[] = {
     "overwrite",
 #ifdef O_SYNC
     "sync",
+#endif
+    "async",
+#ifdef O_DIRECT
+    "direct",
 #endif
     NULL
 };
@@ -234,9 +555,9 @@ static int Open( vlc_object_t *p_this )
 {
     sout_access_out_t   *p_access = (sout_access_out_t*)p_this;
     int fd;
-    int *fdp = vlc_obj_malloc(p_this, sizeof (*fdp));
+    sout_access_out_sys_t *p_sys = vlc_obj_malloc(p_this, sizeof (*p_sys));
 
-    if (unlikely(fdp == NULL))
+    if (unlikely(p_sys == NULL))
         return VLC_ENOMEM;
 
     config_ChainParse( p_access, SOUT_CFG_PREFIX, ppsz_sout_options, p_access->p_cfg );
@@ -321,8 +642,9 @@ static int Open( vlc_object_t *p_this )
             return VLC_EGENERIC;
     }
 
-    *fdp = fd;
-    p_access->p_sys = fdp;
+    p_sys->fd = fd;
+    p_sys->writer = NULL;
+    p_access->p_sys = p_sys;
 
     struct stat st;
 
@@ -358,6 +680,20 @@ static int Open( vlc_object_t *p_this )
     if (append)
         lseek (fd, 0, SEEK_END);
 
+    if (p_access->pf_write == Write
+     && var_GetBool (p_access, SOUT_CFG_PREFIX"async"))
+    {
+        bool direct = false;
+#ifdef O_DIRECT
+        direct = var_GetBool (p_access, SOUT_CFG_PREFIX"direct");
+#endif
+        p_sys->writer = WriterNew (p_access, fd, direct);
+        if (p_sys->writer != NULL)
+            p_access->pf_write = WriteAsync;
+        else
+            msg_Warn (p_access, "cannot write asynchronously");
+    }
+
     return VLC_SUCCESS;
 }
 
@@ -367,8 +703,11 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t * p_this )
 {
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
 
+    if (p_sys->writer != NULL)
+        WriterDelete(p_access, p_sys->writer);
     vlc_close(fd);
     msg_Dbg( p_access, "file access output closed" );
 }
@@ -384,6 +723,12 @@ static void Close( vlc_object_t * p_this )
     "on the file path")
 #define SYNC_TEXT N_("Synchronous writing")
 #define SYNC_LONGTEXT N_( "Open the file with synchronous writing.")
+#define ASYNC_TEXT N_("Asynchronous writing")
+#define ASYNC_LONGTEXT N_( "Write the file from a separate thread, in " \
+    "large chunks, so that a slow disk does not stall the stream output.")
+#define DIRECT_TEXT N_("Direct I/O")
+#define DIRECT_LONGTEXT N_( "Bypass the page cache when writing " \
+    "asynchronously (O_DIRECT).")
 
 vlc_module_begin ()
     set_description( N_("File stream output") )
@@ -401,6 +746,12 @@ vlc_module_begin ()
 #ifdef O_SYNC
     add_bool( SOUT_CFG_PREFIX "sync", false, SYNC_TEXT,SYNC_LONGTEXT,
               false )
+#endif
+    add_bool( SOUT_CFG_PREFIX "async", false, ASYNC_TEXT, ASYNC_LONGTEXT,
+              true )
+#ifdef O_DIRECT
+    add_bool( SOUT_CFG_PREFIX "direct", false, DIRECT_TEXT, DIRECT_LONGTEXT,
+              true )
 #endif
     set_callbacks( Open, Close )
 vlc_module_end ()
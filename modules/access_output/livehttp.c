@@ -43,6 +43,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -105,6 +107,23 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define PARTLEN_TEXT N_("Partial segment length")
+#define PARTLEN_LONGTEXT N_("Length in milliseconds of the low-latency "\
+                            "partial segments (EXT-X-PART) announced while "\
+                            "a segment is being written, 0 to disable")
+
+#define CMAF_TEXT N_("Fragmented MP4 segments")
+#define CMAF_LONGTEXT N_("Expect fragmented MP4 from the muxer (mux=mp4frag): "\
+                         "the movie header is written once as init segment "\
+                         "(the segment number being replaced by \"init\") and "\
+                         "segments are cut on fragment boundaries")
+
+#define HTTPD_TEXT N_("Serve from memory")
+#define HTTPD_LONGTEXT N_("Keep the index and the segments in memory and "\
+                          "serve them with the HTTP server (see http-host and "\
+                          "http-port) instead of writing files. The index and "\
+                          "segment paths are then used as URLs")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -115,6 +134,11 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "seglen", 10, SEGLEN_TEXT, SEGLEN_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "numsegs", 0, NUMSEGS_TEXT, NUMSEGS_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "initial-segment-number", 1, INTITIAL_SEG_TEXT, INITIAL_SEG_LONGTEXT, false )
+    add_integer( SOUT_CFG_PREFIX "partlen", 0, PARTLEN_TEXT, PARTLEN_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "cmaf", false,
+              CMAF_TEXT, CMAF_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "httpd", false,
+              HTTPD_TEXT, HTTPD_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "splitanywhere", false,
               SPLITANYWHERE_TEXT, SPLITANYWHERE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "delsegs", true,
@@ -156,12 +180,23 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "partlen",
+    "cmaf",
+    "httpd",
     NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
+typedef struct output_part
+{
+    size_t i_offset;
+    size_t i_size;
+    vlc_tick_t i_length;
+    bool b_independent;
+} output_part_t;
+
 typedef struct output_segment
 {
     char *psz_filename;
@@ -171,6 +206,11 @@ typedef struct output_segment
     vlc_tick_t segment_length;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    output_part_t *p_parts;
+    size_t i_parts;
+    size_t i_size;
+    uint8_t *p_data;        /* segment content when serving from memory */
+    httpd_file_t *p_httpd;
 } output_segment_t;
 
 typedef struct
@@ -181,6 +221,7 @@ typedef struct
     char *psz_keyfile;
     vlc_tick_t i_keyfile_modification;
     vlc_tick_t segment_max_length;
+    vlc_tick_t part_max_length;
     vlc_tick_t current_segment_length;
     uint32_t i_segment;
     block_t *full_segments;
@@ -196,19 +237,37 @@ typedef struct
     bool b_caching;
     bool b_generate_iv;
     bool b_segment_has_data;
+    bool b_segment_open;
+    bool b_part_independent;
+    bool b_cmaf;
+    char *psz_initUri;
     uint8_t aes_ivs[16];
     gcry_cipher_hd_t aes_ctx;
     char *key_uri;
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+
+    /* Serving from memory: the lock protects the segments array, their
+     * content and parts, the index and the init segment from the httpd
+     * thread */
+    vlc_mutex_t lock;
+    httpd_host_t *p_httpd_host;
+    httpd_file_t *p_httpd_index;
+    httpd_file_t *p_httpd_init;
+    char *psz_index;
+    size_t i_index;
+    block_t *p_init;
 } sout_access_out_sys_t;
 
 static int LoadCryptFile( sout_access_out_t *p_access);
 static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
+static ssize_t writePart( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static int HttpdFill( httpd_file_sys_t *, httpd_file_t *, uint8_t *psz_request,
+                      uint8_t **pp_data, int *pi_data );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -233,6 +292,8 @@ static int Open( vlc_object_t *p_this )
     size_t i_seglen = var_GetInteger( p_access, SOUT_CFG_PREFIX "seglen" );
 
     p_sys->segment_max_length = vlc_tick_from_sec( i_seglen );
+    p_sys->part_max_length =
+        VLC_TICK_FROM_MS( var_GetInteger( p_access, SOUT_CFG_PREFIX "partlen" ) );
     p_sys->full_segments = NULL;
     p_sys->full_segments_end = &p_sys->full_segments;
 
@@ -246,7 +307,12 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_ratecontrol = var_GetBool( p_access, SOUT_CFG_PREFIX "ratecontrol") ;
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
+    p_sys->b_cmaf = var_GetBool( p_access, SOUT_CFG_PREFIX "cmaf") ;
     p_sys->b_segment_has_data = false;
+    p_sys->b_segment_open = false;
+
+    const bool b_httpd = var_GetBool( p_access, SOUT_CFG_PREFIX "httpd" );
+    vlc_mutex_init( &p_sys->lock );
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -265,7 +331,7 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !b_httpd )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
@@ -273,6 +339,28 @@ static int Open( vlc_object_t *p_this )
     p_sys->psz_keyfile  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-loadfile" );
     p_sys->key_uri      = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-uri" );
 
+    if( ( p_sys->b_cmaf || b_httpd ) && ( p_sys->key_uri || p_sys->psz_keyfile ) )
+    {
+        /* Whole segment AES-128 doesn't apply to fMP4 (it would need
+         * SAMPLE-AES), and the key would have to be served too */
+        msg_Err( p_access, "Encryption is not supported with %s",
+                 p_sys->b_cmaf ? "CMAF segments" : "in-memory serving" );
+        free( p_sys->key_uri );
+        free( p_sys->psz_keyfile );
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    if( p_sys->part_max_length && ( p_sys->key_uri || p_sys->psz_keyfile ) )
+    {
+        /* Parts are byte ranges, which doesn't fit with CBC padding done
+         * when the segment is closed */
+        msg_Warn( p_access, "Partial segments disabled with encryption" );
+        p_sys->part_max_length = 0;
+    }
+
     p_access->p_sys = p_sys;
 
     if( p_sys->psz_keyfile && ( LoadCryptFile( p_access ) < 0 ) )
@@ -292,6 +380,29 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    if( b_httpd )
+    {
+        if( p_sys->psz_indexPath )
+            p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+        if( p_sys->p_httpd_host )
+            p_sys->p_httpd_index = httpd_FileNew( p_sys->p_httpd_host,
+                                                  p_sys->psz_indexPath,
+                                                  "application/vnd.apple.mpegurl",
+                                                  NULL, NULL, HttpdFill,
+                                                  (httpd_file_sys_t *)p_access );
+        if( !p_sys->p_httpd_index )
+        {
+            msg_Err( p_access, "cannot serve index `%s'",
+                     p_sys->psz_indexPath ? p_sys->psz_indexPath : "" );
+            if( p_sys->p_httpd_host )
+                httpd_HostDelete( p_sys->p_httpd_host );
+            free( p_sys->psz_indexUrl );
+            free( p_sys->psz_indexPath );
+            free( p_sys );
+            return VLC_EGENERIC;
+        }
+    }
+
     p_sys->i_handle = -1;
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
@@ -499,31 +610,85 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
     return psz_result;
 }
 
+/*****************************************************************************
+ * formatInitPath: create init segment path name, "init" replacing the seg #
+ *****************************************************************************/
+static char *formatInitPath( char *psz_path )
+{
+    char *psz_result;
+    char *psz_newResult;
+    char *psz_firstNumSign;
+    int ret;
+
+    if ( ! ( psz_result  = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    if ( *psz_firstNumSign )
+    {
+        int i_cnt = strspn( psz_firstNumSign, SEG_NUMBER_PLACEHOLDER );
+
+        *psz_firstNumSign = '\0';
+        ret = asprintf( &psz_newResult, "%sinit%s", psz_result, psz_firstNumSign + i_cnt );
+    }
+    else
+        ret = asprintf( &psz_newResult, "%s.init", psz_result );
+
+    free ( psz_result );
+    return ret < 0 ? NULL : psz_newResult;
+}
+
 static void destroySegment( output_segment_t *segment )
 {
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
     free( segment->psz_key_uri );
+    free( segment->p_parts );
+    free( segment->p_data );
     free( segment );
 }
 
+/************************************************************************
+ * removeFirstSegment: Stop serving the oldest segment and forget it
+ ************************************************************************/
+static void removeFirstSegment( sout_access_out_sys_t *p_sys, bool b_unlink )
+{
+    output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
+
+    /* Not under the lock: the httpd callbacks hold the host lock when they
+     * take it */
+    if( segment->p_httpd )
+        httpd_FileDelete( segment->p_httpd );
+
+    vlc_mutex_lock( &p_sys->lock );
+    vlc_array_remove( &p_sys->segments_t, 0 );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    if( b_unlink && segment->psz_filename && !p_sys->p_httpd_host )
+        vlc_unlink( segment->psz_filename );
+
+    destroySegment( segment );
+}
+
 /************************************************************************
  * segmentAmountNeeded: check that playlist has atleast 3*p_sys->segment_max_length of segments
  * return how many segments are needed for that (max of p_sys->i_segment )
+ * The i_open last segments (still being written) are not accounted for.
  ************************************************************************/
-static uint32_t segmentAmountNeeded( sout_access_out_sys_t *p_sys )
+static uint32_t segmentAmountNeeded( sout_access_out_sys_t *p_sys, size_t i_open )
 {
     vlc_tick_t duration = 0;
-    for( size_t index = 1; index <= vlc_array_count( &p_sys->segments_t ); index++ )
+    size_t i_count = vlc_array_count( &p_sys->segments_t ) - i_open;
+    for( size_t index = 1; index <= i_count; index++ )
     {
-        output_segment_t* segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - index );
+        output_segment_t* segment = vlc_array_item_at_index( &p_sys->segments_t, i_count - index );
         duration += segment->segment_length;
 
         if( duration >= ( 3 * p_sys->segment_max_length ) )
             return __MAX(index, p_sys->i_numsegs);
     }
-    return vlc_array_count( &p_sys->segments_t ) - 1;
+    return i_count - 1;
 
 }
 
@@ -550,59 +715,166 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->segment_length + (p_sys->i_numsegs * p_sys->segment_max_length));
 }
 
+/************************************************************************
+ * printSeconds: locale independent "%.3f" of a duration
+ ************************************************************************/
+static void printSeconds( struct vlc_memstream *ms, vlc_tick_t i_length )
+{
+    int64_t i_ms = MS_FROM_VLC_TICK( i_length );
+    vlc_memstream_printf( ms, "%"PRId64".%03u", i_ms / 1000, (unsigned)( i_ms % 1000 ) );
+}
+
+/************************************************************************
+ * printParts: List the partial segments (EXT-X-PART) of a segment
+ ************************************************************************/
+static void printParts( struct vlc_memstream *ms, sout_access_out_sys_t *p_sys,
+                        const output_segment_t *segment )
+{
+    for( size_t i = 0; i < segment->i_parts; i++ )
+    {
+        const output_part_t *part = &segment->p_parts[i];
+
+        vlc_memstream_puts( ms, "#EXT-X-PART:DURATION=" );
+        printSeconds( ms, part->i_length );
+        /* httpd doesn't handle ranges: parts are selected by query */
+        if( p_sys->p_httpd_host )
+            vlc_memstream_printf( ms, ",URI=\"%s?part=%zu\"", segment->psz_uri, i );
+        else
+            vlc_memstream_printf( ms, ",URI=\"%s\",BYTERANGE=\"%zu@%zu\"",
+                                  segment->psz_uri, part->i_size, part->i_offset );
+        if( part->b_independent )
+            vlc_memstream_puts( ms, ",INDEPENDENT=YES" );
+        vlc_memstream_putc( ms, '\n' );
+    }
+}
+
+/************************************************************************
+ * publishIndex: Atomically replace the served or written index
+ ************************************************************************/
+static int publishIndex( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                         char *psz_index, size_t i_index )
+{
+    if( p_sys->p_httpd_host )
+    {
+        vlc_mutex_lock( &p_sys->lock );
+        free( p_sys->psz_index );
+        p_sys->psz_index = psz_index;
+        p_sys->i_index = i_index;
+        vlc_mutex_unlock( &p_sys->lock );
+        return 0;
+    }
+
+    int val;
+    FILE *fp;
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+    {
+        free( psz_index );
+        return -1;
+    }
+
+    fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        free( psz_index );
+        return -1;
+    }
+
+    size_t i_written = fwrite( psz_index, 1, i_index, fp );
+    free( psz_index );
+    if ( fclose( fp ) != 0 || i_written != i_index )
+    {
+        vlc_unlink( psz_idxTmp );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+    }
+    else
+        msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+
+    free( psz_idxTmp );
+    return 0;
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
 static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-
-    uint32_t i_firstseg;
+    /* A segment being written only shows its parts: the window is computed
+     * on the complete segments before it */
+    const size_t i_open = p_sys->b_segment_open ? 1 : 0;
+    const int64_t i_lastseg = (int64_t)p_sys->i_segment - i_open;
+    int64_t i_firstseg;
     unsigned i_index_offset = 0;
 
     if ( p_sys->i_numsegs == 0 ||
-         p_sys->i_segment < ( p_sys->i_numsegs + p_sys->i_initial_segment ) )
+         i_lastseg < ( p_sys->i_numsegs + p_sys->i_initial_segment ) )
     {
         i_firstseg = p_sys->i_initial_segment;
     }
     else
     {
-        unsigned numsegs = segmentAmountNeeded( p_sys );
-        i_firstseg = ( p_sys->i_segment - numsegs ) + 1;
-        i_index_offset = vlc_array_count( &p_sys->segments_t ) - numsegs;
+        unsigned numsegs = segmentAmountNeeded( p_sys, i_open );
+        i_firstseg = ( i_lastseg - numsegs ) + 1;
+        i_index_offset = vlc_array_count( &p_sys->segments_t ) - i_open - numsegs;
+    }
+
+    /* Partial segments are only listed for the last three target durations */
+    int64_t i_firstpartseg = i_lastseg + 1;
+    if ( p_sys->part_max_length )
+    {
+        vlc_tick_t tail = i_open ? p_sys->current_segment_length : 0;
+        while ( i_firstpartseg > i_firstseg && tail < 3 * p_sys->segment_max_length )
+        {
+            i_firstpartseg--;
+            output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t,
+                                  i_firstpartseg - i_firstseg + i_index_offset );
+            tail += segment->segment_length;
+        }
     }
 
     // First update index
     if ( p_sys->psz_indexPath )
     {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+        struct vlc_memstream ms;
+        if ( vlc_memstream_open( &ms ) )
             return -1;
 
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
-            return -1;
-        }
+        vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:%d\n#EXT-X-ALLOW-CACHE:%s"
+                              "%s\n", ceil(secf_from_vlc_tick( p_sys->segment_max_length )),
+                              p_sys->b_cmaf || p_sys->part_max_length ? 6 : 3,
+                              p_sys->b_caching ? "YES" : "NO",
+                              p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT" );
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
-                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", ceil(secf_from_vlc_tick( p_sys->segment_max_length )) ,
-                          p_sys->b_caching ? "YES" : "NO",
-                          p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
-                          i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
+        if ( p_sys->part_max_length )
         {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
+            vlc_memstream_puts( &ms, "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=" );
+            printSeconds( &ms, 3 * p_sys->part_max_length );
+            vlc_memstream_puts( &ms, "\n#EXT-X-PART-INF:PART-TARGET=" );
+            printSeconds( &ms, p_sys->part_max_length );
+            vlc_memstream_putc( &ms, '\n' );
         }
+
+        vlc_memstream_printf( &ms, "#EXT-X-MEDIA-SEQUENCE:%"PRId64"\n", i_firstseg );
+        if ( p_sys->psz_initUri )
+            vlc_memstream_printf( &ms, "#EXT-X-MAP:URI=\"%s\"\n", p_sys->psz_initUri );
+        if ( (p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg) )
+            vlc_memstream_puts( &ms, "#EXT-X-DISCONTINUITY\n" );
+
         char *psz_current_uri=NULL;
 
 
-        for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
+        for ( int64_t i = i_firstseg; i <= i_lastseg + (int64_t)i_open; i++ )
         {
             //scale to i_index_offset..numsegs + i_index_offset
             uint32_t index = i - i_firstseg + i_index_offset;
@@ -612,7 +884,6 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                 ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
               )
             {
-                int ret = 0;
                 free( psz_current_uri );
                 psz_current_uri = strdup( segment->psz_key_uri );
                 if( p_sys->b_generate_iv )
@@ -626,73 +897,41 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                         iv_lo <<= 8;
                         iv_lo |= segment->aes_ivs[8+j] & 0xff;
                     }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                          segment->psz_key_uri, iv_hi, iv_lo );
 
                 } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
                 }
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
+            if ( i >= i_firstpartseg )
+                printParts( &ms, p_sys, segment );
+
+            if ( i <= i_lastseg )
+                vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
         }
         free( psz_current_uri );
 
         if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
+            vlc_memstream_puts( &ms, STR_ENDLIST );
 
-        }
-        fclose( fp );
-
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
-
-        if ( val < 0 )
-        {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
-        }
-        else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+        if ( vlc_memstream_close( &ms ) )
+            return -1;
 
-        free( psz_idxTmp );
+        if ( publishIndex( p_access, p_sys, ms.ptr, ms.length ) )
+            return -1;
     }
 
     // Then take care of deletion
     // Try to follow pantos draft 11 section 6.2.2
-    while( p_sys->b_delsegs && p_sys->i_numsegs &&
+    while( !i_open && p_sys->b_delsegs && p_sys->i_numsegs &&
            isFirstItemRemovable( p_sys, i_firstseg, i_index_offset )
          )
     {
          output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
-         vlc_array_remove( &p_sys->segments_t, 0 );
-
-         if ( segment->psz_filename )
-         {
-             vlc_unlink( segment->psz_filename );
-         }
-
-         destroySegment( segment );
+         removeFirstSegment( p_sys, true );
          i_index_offset -=1;
     }
 
@@ -700,12 +939,104 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     return 0;
 }
 
+/*****************************************************************************
+ * segmentWrite: Append data to the segment being written
+ *****************************************************************************/
+static ssize_t segmentWrite( sout_access_out_sys_t *p_sys, const uint8_t *p_buf, size_t i_buf )
+{
+    output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
+
+    if ( !p_sys->p_httpd_host )
+    {
+        ssize_t val = vlc_write( p_sys->i_handle, p_buf, i_buf );
+        if ( val > 0 )
+            segment->i_size += val;
+        return val;
+    }
+
+    vlc_mutex_lock( &p_sys->lock );
+    uint8_t *p_data = realloc( segment->p_data, segment->i_size + i_buf );
+    if ( unlikely( !p_data ) )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy( &p_data[segment->i_size], p_buf, i_buf );
+    segment->p_data = p_data;
+    segment->i_size += i_buf;
+    vlc_mutex_unlock( &p_sys->lock );
+    return i_buf;
+}
+
+/*****************************************************************************
+ * writeInitSegment: Store the fragmented MP4 movie header (EXT-X-MAP)
+ *****************************************************************************/
+static int writeInitSegment( sout_access_out_t *p_access, block_t *p_init )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
+    char *psz_initPath = formatInitPath( p_access->psz_path );
+    int ret = -1;
+
+    if ( unlikely( !psz_initPath ) )
+        goto out;
+
+    if ( p_sys->p_httpd_host )
+    {
+        vlc_mutex_lock( &p_sys->lock );
+        if ( p_sys->p_init )
+            block_Release( p_sys->p_init );
+        p_sys->p_init = p_init;
+        p_init = NULL;
+        vlc_mutex_unlock( &p_sys->lock );
+
+        if ( !p_sys->p_httpd_init )
+            p_sys->p_httpd_init = httpd_FileNew( p_sys->p_httpd_host, psz_initPath,
+                                                 "video/mp4", NULL, NULL, HttpdFill,
+                                                 (httpd_file_sys_t *)p_access );
+        if ( !p_sys->p_httpd_init )
+        {
+            msg_Err( p_access, "cannot serve `%s'", psz_initPath );
+            goto out;
+        }
+    }
+    else
+    {
+        int fd = vlc_open( psz_initPath, O_WRONLY | O_CREAT | O_LARGEFILE |
+                           O_TRUNC, 0666 );
+        if ( fd == -1 )
+        {
+            msg_Err( p_access, "cannot open `%s' (%s)", psz_initPath,
+                     vlc_strerror_c(errno) );
+            goto out;
+        }
+        ssize_t val = vlc_write( fd, p_init->p_buffer, p_init->i_buffer );
+        vlc_close( fd );
+        if ( val < 0 || (size_t)val != p_init->i_buffer )
+        {
+            msg_Err( p_access, "cannot write `%s'", psz_initPath );
+            goto out;
+        }
+    }
+
+    if ( !p_sys->psz_initUri )
+        p_sys->psz_initUri = formatInitPath( psz_idxFormat );
+    msg_Dbg( p_access, "LiveHttpInitComplete: %s", psz_initPath );
+    ret = 0;
+out:
+    free( psz_initPath );
+    if ( p_init )
+        block_Release( p_init );
+    return ret;
+}
+
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( p_sys->b_segment_open )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -719,7 +1050,7 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
             } else {
 
-            int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
+            int ret = segmentWrite( p_sys, p_sys->stuffing_bytes, 16 );
             if( ret != 16 )
                 msg_Err( p_access, "Couldn't write 16 bytes" );
             }
@@ -727,8 +1058,12 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        if ( p_sys->i_handle >= 0 )
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
+        p_sys->b_segment_open = false;
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", secf_from_vlc_tick( p_sys->current_segment_length )) ) )
         {
@@ -781,7 +1116,7 @@ static void Close( vlc_object_t * p_this )
         p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
     }
 
-    ssize_t writevalue = writeSegment( p_access );
+    ssize_t writevalue = writePart( p_access );
     msg_Dbg( p_access, "Writing.. %zd", writevalue );
     if( unlikely( writevalue < 0 ) )
     {
@@ -799,19 +1134,27 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->key_uri );
     }
 
+    if( p_sys->p_httpd_index )
+        httpd_FileDelete( p_sys->p_httpd_index );
+    if( p_sys->p_httpd_init )
+        httpd_FileDelete( p_sys->p_httpd_init );
+
     while( vlc_array_count( &p_sys->segments_t ) > 0 )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
-        vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
-        {
+        const bool b_unlink = p_sys->b_delsegs && p_sys->i_numsegs;
+        if( b_unlink && segment->psz_filename && !p_sys->p_httpd_host )
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
-            vlc_unlink( segment->psz_filename );
-        }
 
-        destroySegment( segment );
+        removeFirstSegment( p_sys, b_unlink );
     }
 
+    if( p_sys->p_httpd_host )
+        httpd_HostDelete( p_sys->p_httpd_host );
+    if( p_sys->p_init )
+        block_Release( p_sys->p_init );
+    free( p_sys->psz_index );
+    free( p_sys->psz_initUri );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -839,12 +1182,70 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * HttpdFill: Serve the index, init segment and segments (or parts of) from
+ * memory
+ *****************************************************************************/
+static int HttpdFill( httpd_file_sys_t *p_args, httpd_file_t *p_file,
+                      uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    sout_access_out_t *p_access = (sout_access_out_t *)p_args;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    const uint8_t *p_src = NULL;
+    size_t i_src = 0;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_file == p_sys->p_httpd_index )
+    {
+        p_src = (const uint8_t *)p_sys->psz_index;
+        i_src = p_sys->i_index;
+    }
+    else if( p_file == p_sys->p_httpd_init )
+    {
+        if( p_sys->p_init )
+        {
+            p_src = p_sys->p_init->p_buffer;
+            i_src = p_sys->p_init->i_buffer;
+        }
+    }
+    else for( size_t i = 0; i < vlc_array_count( &p_sys->segments_t ); i++ )
+    {
+        const output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, i );
+        if( segment->p_httpd != p_file )
+            continue;
+
+        p_src = segment->p_data;
+        i_src = segment->i_size;
+
+        size_t i_part;
+        if( psz_request && sscanf( (const char *)psz_request, "part=%zu", &i_part ) == 1 )
+        {
+            if( i_part < segment->i_parts )
+            {
+                p_src += segment->p_parts[i_part].i_offset;
+                i_src = segment->p_parts[i_part].i_size;
+            }
+            else
+                i_src = 0;
+        }
+        break;
+    }
+
+    *pp_data = i_src ? malloc( i_src ) : NULL;
+    if( *pp_data )
+        memcpy( *pp_data, p_src, i_src );
+    *pi_data = *pp_data ? i_src : 0;
+    vlc_mutex_unlock( &p_sys->lock );
+
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * openNextFile: Open the segment file
  *****************************************************************************/
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
 {
-    int fd;
+    int fd = -1;
 
     uint32_t i_newseg = p_sys->i_segment + 1;
 
@@ -865,17 +1266,35 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
-    if ( fd == -1 )
+    if ( p_sys->p_httpd_host )
     {
-        msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
-                 vlc_strerror_c(errno) );
-        destroySegment( segment );
-        return -1;
+        segment->p_httpd = httpd_FileNew( p_sys->p_httpd_host, segment->psz_filename,
+                                          p_sys->b_cmaf ? "video/mp4" : "video/MP2T",
+                                          NULL, NULL, HttpdFill,
+                                          (httpd_file_sys_t *)p_access );
+        if ( !segment->p_httpd )
+        {
+            msg_Err( p_access, "cannot serve `%s'", segment->psz_filename );
+            destroySegment( segment );
+            return -1;
+        }
+    }
+    else
+    {
+        fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                         O_TRUNC, 0666 );
+        if ( fd == -1 )
+        {
+            msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
+                     vlc_strerror_c(errno) );
+            destroySegment( segment );
+            return -1;
+        }
     }
 
+    vlc_mutex_lock( &p_sys->lock );
     vlc_array_append_or_abort( &p_sys->segments_t, segment );
+    vlc_mutex_unlock( &p_sys->lock );
 
     if( p_sys->psz_keyfile )
     {
@@ -895,7 +1314,9 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     p_sys->i_handle = fd;
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
-    return fd;
+    p_sys->b_segment_open = true;
+    p_sys->current_segment_length = 0;
+    return VLC_SUCCESS;
 }
 /*****************************************************************************
  * CheckSegmentChange: Check if segment needs to be closed and new opened
@@ -911,10 +1332,12 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     block_ChainProperties( p_sys->full_segments, NULL, NULL, &current_length );
     block_ChainProperties( p_sys->ongoing_segment, NULL, NULL, &ongoing_length );
 
-    if( p_sys->i_handle > 0 &&
-       (( p_buffer->i_length + current_length + ongoing_length ) >= p_sys->segment_max_length ) )
+    /* current_segment_length accounts for the parts already written */
+    if( p_sys->b_segment_open &&
+       (( p_buffer->i_length + current_length + ongoing_length +
+          p_sys->current_segment_length ) >= p_sys->segment_max_length ) )
     {
-        writevalue = writeSegment( p_access );
+        writevalue = writePart( p_access );
         if( unlikely( writevalue < 0 ) )
         {
             block_ChainRelease ( p_buffer );
@@ -924,7 +1347,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !p_sys->b_segment_open ) )
     {
         if ( openNextFile( p_access, p_sys ) < 0 )
            return -1;
@@ -946,7 +1369,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
     ssize_t i_write=0;
     bool crypted = false;
-    p_sys->current_segment_length = current_length;
+    p_sys->current_segment_length += current_length;
     while( output )
     {
         if( p_sys->key_uri && !crypted )
@@ -980,7 +1403,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
-        ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
+        ssize_t val = segmentWrite( p_sys, output->p_buffer, output->i_buffer );
         if ( val == -1 )
         {
            if ( errno == EINTR )
@@ -1006,6 +1429,42 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
     return i_write;
 }
 
+/*****************************************************************************
+ * writePart: Write the full segments queue as a new partial segment
+ *****************************************************************************/
+static ssize_t writePart( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( !p_sys->part_max_length || !p_sys->b_segment_open )
+        return writeSegment( p_access );
+
+    output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
+    const size_t i_offset = segment->i_size;
+    const vlc_tick_t i_start = p_sys->current_segment_length;
+
+    ssize_t i_write = writeSegment( p_access );
+    if( i_write <= 0 || segment->i_size == i_offset )
+        return i_write;
+
+    vlc_mutex_lock( &p_sys->lock );
+    output_part_t *p_parts = realloc( segment->p_parts,
+                                      ( segment->i_parts + 1 ) * sizeof( *p_parts ) );
+    if( likely( p_parts ) )
+    {
+        p_parts[segment->i_parts++] = (output_part_t) {
+            .i_offset = i_offset,
+            .i_size = segment->i_size - i_offset,
+            .i_length = p_sys->current_segment_length - i_start,
+            .b_independent = p_sys->b_part_independent,
+        };
+        segment->p_parts = p_parts;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+
+    return i_write;
+}
+
 /*****************************************************************************
  * Write: standard write on a file descriptor.
  *****************************************************************************/
@@ -1015,11 +1474,56 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     while( p_buffer )
     {
+        /* The fragmented MP4 movie header is not part of any segment */
+        if( p_sys->b_cmaf && ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) )
+        {
+            block_t *p_temp = p_buffer->p_next;
+            p_buffer->p_next = NULL;
+            if( writeInitSegment( p_access, p_buffer ) )
+            {
+                block_ChainRelease( p_temp );
+                return -1;
+            }
+            p_buffer = p_temp;
+            continue;
+        }
+
+        /* Segments and parts boundaries: PAT/PMT in TS, moof in fMP4 */
+        const bool b_boundary = p_sys->b_cmaf ? ( p_buffer->i_flags & BLOCK_FLAG_TYPE_I )
+                                              : ( p_buffer->i_flags & BLOCK_FLAG_HEADER );
+
         /* Check if current block is already past segment-length
             and we want to write gathered blocks into segment
             and update playlist */
-        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || b_boundary ) )
         {
+            if( p_sys->part_max_length && p_sys->full_segments && p_sys->b_segment_open )
+            {
+                vlc_tick_t full_length = 0;
+                vlc_tick_t ongoing_length = 0;
+
+                block_ChainProperties( p_sys->full_segments, NULL, NULL, &full_length );
+                block_ChainProperties( p_sys->ongoing_segment, NULL, NULL, &ongoing_length );
+
+                /* Keep parts below the announced target */
+                if( full_length + ongoing_length > p_sys->part_max_length )
+                {
+                    ssize_t ret = writePart( p_access );
+                    if( ret < 0 )
+                    {
+                        msg_Err( p_access, "Error in write loop");
+                        block_ChainRelease( p_buffer );
+                        return ret;
+                    }
+                    i_write += ret;
+                    updateIndexAndDel( p_access, p_sys, false );
+                }
+            }
+
+            if( !p_sys->full_segments )
+                p_sys->b_part_independent = !p_sys->b_cmaf &&
+                    ( p_sys->ongoing_segment->i_flags & BLOCK_FLAG_HEADER );
+
             msg_Dbg( p_access, "Moving ongoing segment to full segments-queue" );
             block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
             p_sys->ongoing_segment = NULL;
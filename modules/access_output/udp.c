@@ -45,11 +45,26 @@
 #elif defined (HAVE_SYS_SOCKET_H)
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#   include <sys/uio.h>
+#   include <netinet/in.h>
+#   include <netinet/udp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
 
+/* datagrams due at the same time are handed to the kernel at once */
+#define UDP_BATCH_MAX 64
+#if defined(HAVE_SENDMMSG) && defined(UDP_SEGMENT)
+#   ifndef SOL_UDP
+#       define SOL_UDP 17
+#   endif
+/* the kernel does not accept more than 64 segments or 64KiB per send */
+#   define UDP_GSO_MAX_BYTES 65000
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -70,6 +85,12 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define GSO_TEXT N_("Segmentation offload")
+#define GSO_LONGTEXT N_("Let the kernel split runs of equally sized " \
+                        "packets due at the same time (Linux UDP GSO). " \
+                        "This further reduces the sending load at high " \
+                        "bitrates." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -78,6 +99,7 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+    add_bool( SOUT_CFG_PREFIX "gso", false, GSO_TEXT, GSO_LONGTEXT, true )
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -91,6 +113,7 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+    "gso",
     NULL
 };
 
@@ -112,6 +135,7 @@ typedef struct
     vlc_tick_t    i_caching;
     int           i_handle;
     bool          b_mtu_warning;
+    bool          b_gso;
     size_t        i_mtu;
 
     block_fifo_t *p_fifo;
@@ -206,6 +230,27 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
+    p_sys->b_gso = var_GetBool( p_access, SOUT_CFG_PREFIX "gso" );
+#ifdef UDP_GSO_MAX_BYTES
+    if( p_sys->b_gso )
+    {
+        int i_segment;
+        socklen_t i_optlen = sizeof(i_segment);
+        if( getsockopt( i_handle, SOL_UDP, UDP_SEGMENT,
+                        &i_segment, &i_optlen ) )
+        {
+            msg_Warn( p_access, "UDP segmentation offload not supported: %s",
+                      vlc_strerror_c(errno) );
+            p_sys->b_gso = false;
+        }
+    }
+#else
+    if( p_sys->b_gso )
+    {
+        msg_Warn( p_access, "UDP segmentation offload not supported" );
+        p_sys->b_gso = false;
+    }
+#endif
     p_sys->p_fifo = block_FifoNew();
     p_sys->p_buffer = NULL;
 
@@ -345,12 +390,162 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
     return i_len;
 }
 
+/*****************************************************************************
+ * SendPackets: send a batch of datagrams
+ *****************************************************************************/
+static void SendPackets( sout_access_out_t *p_access,
+                         block_t **pp_pks, unsigned i_pks )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[UDP_BATCH_MAX];
+    struct iovec iov[UDP_BATCH_MAX];
+    unsigned pi_first[UDP_BATCH_MAX]; /* first packet of each message */
+# ifdef UDP_GSO_MAX_BYTES
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } ctrl[UDP_BATCH_MAX];
+# endif
+    unsigned i_msgs = 0;
+
+    assert( i_pks <= UDP_BATCH_MAX );
+
+    for( unsigned i = 0; i < i_pks; )
+    {
+        struct msghdr *p_hdr = &msgs[i_msgs].msg_hdr;
+        const size_t i_segment = pp_pks[i]->i_buffer;
+        size_t i_total = 0;
+        unsigned j = i;
+
+        /* with segmentation offload, all datagrams of a message have the
+         * same size but the last one, which can be shorter */
+        do
+        {
+            iov[j].iov_base = pp_pks[j]->p_buffer;
+            iov[j].iov_len = pp_pks[j]->i_buffer;
+            i_total += pp_pks[j]->i_buffer;
+            j++;
+        }
+# ifdef UDP_GSO_MAX_BYTES
+        while( p_sys->b_gso && j < i_pks &&
+               pp_pks[j - 1]->i_buffer == i_segment &&
+               pp_pks[j]->i_buffer <= i_segment &&
+               i_total + pp_pks[j]->i_buffer <= UDP_GSO_MAX_BYTES );
+# else
+        while( 0 );
+# endif
+
+        memset( p_hdr, 0, sizeof(*p_hdr) );
+        p_hdr->msg_iov = &iov[i];
+        p_hdr->msg_iovlen = j - i;
+# ifdef UDP_GSO_MAX_BYTES
+        if( j - i > 1 )
+        {
+            struct cmsghdr *p_cmsg;
+            uint16_t i_size = i_segment;
+
+            p_hdr->msg_control = ctrl[i_msgs].buf;
+            p_hdr->msg_controllen = sizeof(ctrl[i_msgs].buf);
+            p_cmsg = CMSG_FIRSTHDR(p_hdr);
+            p_cmsg->cmsg_level = SOL_UDP;
+            p_cmsg->cmsg_type = UDP_SEGMENT;
+            p_cmsg->cmsg_len = CMSG_LEN(sizeof(i_size));
+            memcpy( CMSG_DATA(p_cmsg), &i_size, sizeof(i_size) );
+        }
+# else
+        VLC_UNUSED(i_segment);
+        VLC_UNUSED(i_total);
+# endif
+        pi_first[i_msgs++] = i;
+        i = j;
+    }
+
+    for( unsigned i_sent = 0; i_sent < i_msgs; )
+    {
+        int i_val = sendmmsg( p_sys->i_handle, &msgs[i_sent],
+                              i_msgs - i_sent, 0 );
+        if( i_val >= 0 )
+        {
+            i_sent += i_val;
+            continue;
+        }
+        if( errno == EINTR )
+            continue;
+
+        if( p_sys->b_gso && msgs[i_sent].msg_hdr.msg_controllen != 0 &&
+            (errno == EIO || errno == EINVAL) )
+        {
+            /* the output device is not capable of it, resend the
+             * remaining datagrams one by one */
+            msg_Warn( p_access, "UDP segmentation offload failed (%s), "
+                      "disabling it", vlc_strerror_c(errno) );
+            p_sys->b_gso = false;
+            SendPackets( p_access, &pp_pks[pi_first[i_sent]],
+                         i_pks - pi_first[i_sent] );
+            return;
+        }
+
+        /* skip the failing datagram, as a single send() would */
+        msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+        i_sent++;
+    }
+#else
+    for( unsigned i = 0; i < i_pks; i++ )
+    {
+        if( send( p_sys->i_handle, pp_pks[i]->p_buffer,
+                  pp_pks[i]->i_buffer, 0 ) == -1 )
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+    }
+#endif
+}
+
+typedef struct
+{
+    block_t    *pp_pks[UDP_BATCH_MAX];
+    vlc_tick_t  i_date; /* of the first packet */
+    unsigned    i_pks;
+} udp_batch_t;
+
+static void BatchRelease( void *data )
+{
+    udp_batch_t *p_batch = data;
+
+    for( unsigned i = 0; i < p_batch->i_pks; i++ )
+        block_Release( p_batch->pp_pks[i] );
+    p_batch->i_pks = 0;
+}
+
+static void BatchFlush( sout_access_out_t *p_access, udp_batch_t *p_batch )
+{
+    if( p_batch->i_pks == 0 )
+        return;
+
+    SendPackets( p_access, p_batch->pp_pks, p_batch->i_pks );
+
+#if 1
+    vlc_tick_t i_late = vlc_tick_now() - p_batch->i_date;
+    if ( i_late > VLC_TICK_FROM_MS(20) )
+    {
+        msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
+                 i_late );
+    }
+#endif
+
+    BatchRelease( p_batch );
+}
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
+ *****************************************************************************
+ * Packets are still waited for one by one, but all the packets which are
+ * due are given to the kernel with a single call.
  *****************************************************************************/
-static void* ThreadWrite( void *data )
+/* Runs until the thread is canceled. The packets are only held in the
+ * batch, which is released by the cleanup handler of ThreadWrite(). */
+static void WriteLoop( sout_access_out_t *p_access, udp_batch_t *p_batch )
 {
-    sout_access_out_t *p_access = data;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     vlc_tick_t i_date_last = -1;
     const unsigned i_group = var_GetInteger( p_access,
@@ -360,6 +555,16 @@ static void* ThreadWrite( void *data )
 
     for (;;)
     {
+        /* do not hold due packets while waiting for new ones */
+        if( p_batch->i_pks > 0 )
+        {
+            vlc_fifo_Lock( p_sys->p_fifo );
+            bool b_empty = vlc_fifo_IsEmpty( p_sys->p_fifo );
+            vlc_fifo_Unlock( p_sys->p_fifo );
+            if( b_empty )
+                BatchFlush( p_access, p_batch );
+        }
+
         block_t *p_pk = block_FifoGet( p_sys->p_fifo );
         vlc_tick_t    i_date;
 
@@ -386,16 +591,27 @@ static void* ThreadWrite( void *data )
             }
         }
 
-        block_cleanup_push( p_pk );
         i_to_send--;
+        bool b_wait = false;
         if( !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK) )
         {
-            vlc_tick_wait( i_date );
+            if( i_date > vlc_tick_now() )
+            {
+                /* the pending packets are due before this one */
+                BatchFlush( p_access, p_batch );
+                b_wait = true;
+            }
             i_to_send = i_group;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
-            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
-        vlc_cleanup_pop();
+
+        if( p_batch->i_pks == 0 )
+            p_batch->i_date = i_date;
+        p_batch->pp_pks[p_batch->i_pks++] = p_pk;
+        /* the packet is released with the batch if canceled while waiting */
+        if( b_wait )
+            vlc_tick_wait( i_date );
+        if( p_batch->i_pks == UDP_BATCH_MAX )
+            BatchFlush( p_access, p_batch );
 
         if( i_dropped_packets )
         {
@@ -404,18 +620,16 @@ static void* ThreadWrite( void *data )
         }
 
         i_date_last = i_date;
+    }
+}
 
-#if 1
-        i_date = vlc_tick_now() - i_date;
-        if ( i_date > VLC_TICK_FROM_MS(20) )
-        {
-            msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
-                     i_date );
-        }
-#endif
-
-        block_Release( p_pk );
+static void* ThreadWrite( void *data )
+{
+    sout_access_out_t *p_access = data;
+    udp_batch_t batch = { .i_pks = 0 };
 
-    }
+    vlc_cleanup_push( BatchRelease, &batch );
+    WriteLoop( p_access, &batch );
+    vlc_cleanup_pop();
     return NULL;
 }
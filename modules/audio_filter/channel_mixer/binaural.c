@@ -0,0 +1,440 @@
+/*****************************************************************************
+ * binaural.c : binaural renderer of speaker layouts for headphones
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************
+ * Each speaker is rendered to both ears by the convolution with its head
+ * related impulse responses: from a SOFA file when libmysofa is available,
+ * or else from a spherical head model, with the delay and the head shadow
+ * of each ear (C. P. Brown and R. O. Duda, "A structural model for binaural
+ * sound synthesis", 1998).
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#ifdef HAVE_MYSOFA
+# include <vlc_configuration.h>
+# include <mysofa.h>
+#endif
+
+#include "../convolver.h"
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define HRTF_FILE_TEXT N_("HRTF file")
+#define HRTF_FILE_LONGTEXT N_("Head related transfer functions, in the SOFA " \
+    "format. Without it, the responses of a spherical head are used.")
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_description( N_("Binaural renderer for headphones") )
+    set_shortname( N_("Binaural") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+    add_loadfile( "binaural-hrtf-file", NULL,
+                  HRTF_FILE_TEXT, HRTF_FILE_LONGTEXT )
+    set_capability( "audio filter", 1 )
+    set_callbacks( Open, Close )
+    add_shortcut( "binaural", "binauralizer" )
+vlc_module_end ()
+
+#define DEFAULT_HRTF_PATH "hrtfs" DIR_SEP "dodeca_and_7channel_3DSL_HRTF.sofa"
+
+/* Frames per block at 48 kHz, the latency of the filter */
+#define BLOCK_48K 256
+/* Samples of the responses of the spherical head at 48 kHz */
+#define MODEL_LENGTH_48K 256
+
+#define HEAD_RADIUS  .0875 /* m */
+#define SOUND_SPEED  343.  /* m/s */
+
+/* Azimuth, counterclockwise from the front, and elevation, in degrees */
+struct speaker
+{
+    float azimuth;
+    float elevation;
+};
+
+typedef struct
+{
+    convolver_t *conv;
+    unsigned block;
+    unsigned channels;
+    unsigned pos;        /**< frames of the current block */
+    float   *in;         /**< the current block of input */
+    float   *out;        /**< the output of the previous block */
+} filter_sys_t;
+
+/*****************************************************************************
+ * Speakers
+ *****************************************************************************/
+static bool SpeakerPosition( uint32_t chan, uint16_t layout,
+                             struct speaker *pos )
+{
+    const bool middle = ( layout & AOUT_CHANS_MIDDLE ) != 0;
+    const bool rear = ( layout & AOUT_CHANS_REAR ) != 0;
+
+    pos->elevation = 0.f;
+    switch( chan )
+    {
+        case AOUT_CHAN_LEFT:        pos->azimuth = 30.f; break;
+        case AOUT_CHAN_RIGHT:       pos->azimuth = -30.f; break;
+        case AOUT_CHAN_CENTER:      pos->azimuth = 0.f; break;
+        case AOUT_CHAN_MIDDLELEFT:  pos->azimuth = rear ? 90.f : 110.f; break;
+        case AOUT_CHAN_MIDDLERIGHT: pos->azimuth = rear ? -90.f : -110.f; break;
+        case AOUT_CHAN_REARLEFT:    pos->azimuth = middle ? 150.f : 110.f; break;
+        case AOUT_CHAN_REARRIGHT:   pos->azimuth = middle ? -150.f : -110.f;
+                                    break;
+        case AOUT_CHAN_REARCENTER:  pos->azimuth = 180.f; break;
+        default: /* the LFE is not localized */
+            return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Spherical head
+ *****************************************************************************/
+/* The response of an ear, whose axis is at the angle theta (radians) from
+ * the source */
+static void ModelResponse( float *ir, unsigned length, unsigned rate,
+                           double theta )
+{
+    const double a_c = HEAD_RADIUS / SOUND_SPEED;
+
+    /* Woodworth's delay, from the nearest point of the head */
+    double delay = theta < M_PI / 2 ? a_c * ( 1. - cos( theta ) )
+                                    : a_c * ( 1. + theta - M_PI / 2 );
+    delay *= rate;
+
+    /* The head shadow, a pole and a zero, from the bilinear transform */
+    const double alpha_min = .1, theta_min = 5. * M_PI / 6.;
+    const double alpha = 1. + alpha_min / 2.
+                       + ( 1. - alpha_min / 2. ) * cos( theta / theta_min * M_PI );
+    const double k = rate * a_c;
+    const double b0 = ( 1. + alpha * k ) / ( 1. + k );
+    const double b1 = ( 1. - alpha * k ) / ( 1. + k );
+    const double a1 = ( 1. - k ) / ( 1. + k );
+
+    /* of a windowed sinc pulse, for the fraction of the delay */
+    const double center = 8. + delay;
+    double x1 = 0., y1 = 0.;
+    for( unsigned n = 0; n < length; n++ )
+    {
+        const double t = n - center;
+        double x = 0.;
+        if( fabs( t ) < 8. )
+            x = ( t != 0. ? sin( M_PI * t ) / ( M_PI * t ) : 1. )
+              * ( .5 + .5 * cos( M_PI * t / 8. ) );
+
+        const double y = b0 * x + b1 * x1 - a1 * y1;
+        x1 = x;
+        y1 = y;
+        ir[n] = y;
+    }
+}
+
+static int ModelResponses( filter_t *p_filter, const struct speaker *pos,
+                           float *ir[2], unsigned *length )
+{
+    const unsigned rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned n = ( (uint64_t)MODEL_LENGTH_48K * rate + 47999 ) / 48000;
+    const double az = pos->azimuth * M_PI / 180.;
+    const double el = pos->elevation * M_PI / 180.;
+    /* the left ear is at +90 degrees */
+    const double lateral = cos( el ) * sin( az );
+
+    for( unsigned e = 0; e < 2; e++ )
+    {
+        ir[e] = vlc_alloc( n, sizeof (float) );
+        if( unlikely( ir[e] == NULL ) )
+            return VLC_ENOMEM;
+        const double c = e == 0 ? lateral : -lateral;
+        ModelResponse( ir[e], n, rate, acos( VLC_CLIP( c, -1., 1. ) ) );
+    }
+    *length = n;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * SOFA
+ *****************************************************************************/
+#ifdef HAVE_MYSOFA
+static struct MYSOFA_EASY *SofaOpen( filter_t *p_filter, int *length )
+{
+    char *path = var_InheritString( p_filter, "binaural-hrtf-file" );
+    const bool user = path != NULL;
+
+    if( path == NULL )
+        path = config_GetSysPath( VLC_PKG_DATA_DIR, DEFAULT_HRTF_PATH );
+    if( path == NULL )
+        return NULL;
+
+    int err;
+    struct MYSOFA_EASY *sofa = mysofa_open( path, p_filter->fmt_in.audio.i_rate,
+                                            length, &err );
+    if( sofa == NULL )
+    {
+        if( user )
+            msg_Err( p_filter, "cannot load the HRTF file %s (error %d)",
+                     path, err );
+        else
+            msg_Dbg( p_filter, "no HRTF file in %s", path );
+    }
+    else
+        msg_Dbg( p_filter, "using the HRTF file %s", path );
+    free( path );
+    return sofa;
+}
+
+static int SofaResponses( struct MYSOFA_EASY *sofa, int sofa_length,
+                          unsigned rate, const struct speaker *pos,
+                          float *ir[2], unsigned *length )
+{
+    const float az = pos->azimuth * M_PI / 180.f;
+    const float el = pos->elevation * M_PI / 180.f;
+    float *hrir[2] = { NULL, NULL };
+    float delays[2];
+
+    hrir[0] = vlc_alloc( sofa_length, sizeof (float) );
+    hrir[1] = vlc_alloc( sofa_length, sizeof (float) );
+    if( unlikely( hrir[0] == NULL || hrir[1] == NULL ) )
+        goto error;
+
+    /* x to the front, y to the left, z up */
+    mysofa_getfilter_float( sofa, cosf( el ) * cosf( az ),
+                            cosf( el ) * sinf( az ), sinf( el ),
+                            hrir[0], hrir[1], &delays[0], &delays[1] );
+
+    /* Delay the responses, to the nearest sample */
+    unsigned shifts[2];
+    for( unsigned e = 0; e < 2; e++ )
+        shifts[e] = lroundf( __MAX( delays[e], 0.f ) * rate );
+
+    *length = sofa_length + __MAX( shifts[0], shifts[1] );
+    for( unsigned e = 0; e < 2; e++ )
+    {
+        ir[e] = calloc( *length, sizeof (float) );
+        if( unlikely( ir[e] == NULL ) )
+            goto error;
+        memcpy( &ir[e][shifts[e]], hrir[e], sofa_length * sizeof (float) );
+    }
+    free( hrir[1] );
+    free( hrir[0] );
+    return VLC_SUCCESS;
+
+error:
+    free( hrir[1] );
+    free( hrir[0] );
+    return VLC_ENOMEM;
+}
+#endif
+
+/*****************************************************************************
+ * Rendering
+ *****************************************************************************/
+static block_t *Render( filter_t *p_filter, block_t *p_in )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned channels = p_sys->channels;
+    const size_t frames = p_in->i_nb_samples;
+
+    block_t *p_out = block_Alloc( frames * 2 * sizeof (float) );
+    if( unlikely( p_out == NULL ) )
+    {
+        block_Release( p_in );
+        return NULL;
+    }
+    p_out->i_nb_samples = frames;
+    p_out->i_dts = p_in->i_dts;
+    p_out->i_pts = p_in->i_pts;
+    p_out->i_length = p_in->i_length;
+
+    /* The output lags the input by one block */
+    const float *in = (const float *)p_in->p_buffer;
+    float *out = (float *)p_out->p_buffer;
+    for( size_t done = 0; done < frames; )
+    {
+        const size_t count = __MIN( frames - done,
+                                    (size_t)p_sys->block - p_sys->pos );
+
+        memcpy( &p_sys->in[p_sys->pos * channels], &in[done * channels],
+                count * channels * sizeof (float) );
+        memcpy( &out[done * 2], &p_sys->out[p_sys->pos * 2],
+                count * 2 * sizeof (float) );
+        p_sys->pos += count;
+        done += count;
+
+        if( p_sys->pos == p_sys->block )
+        {
+            convolver_Process( p_sys->conv, p_sys->in, p_sys->out );
+            p_sys->pos = 0;
+        }
+    }
+
+    block_Release( p_in );
+    return p_out;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    convolver_Reset( p_sys->conv );
+    memset( p_sys->out, 0, p_sys->block * 2 * sizeof (float) );
+    p_sys->pos = 0;
+}
+
+/*****************************************************************************
+ * Open:
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    audio_format_t *infmt = &p_filter->fmt_in.audio;
+    audio_format_t *outfmt = &p_filter->fmt_out.audio;
+
+    if( infmt->channel_type != AUDIO_CHANNEL_TYPE_BITMAP
+     || infmt->i_physical_channels == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof (*p_sys) );
+    if( unlikely( p_sys == NULL ) )
+        return VLC_ENOMEM;
+    p_filter->p_sys = p_sys;
+
+    const unsigned rate = infmt->i_rate;
+    unsigned block = BLOCK_48K;
+    while( block * 48000ull < (uint64_t)BLOCK_48K * rate * 3 / 4 )
+        block *= 2;
+
+    p_sys->block = block;
+    p_sys->channels = aout_FormatNbChannels( infmt );
+    p_sys->in = vlc_alloc( block * p_sys->channels, sizeof (float) );
+    p_sys->out = calloc( block * 2, sizeof (float) );
+    p_sys->conv = convolver_New( block, p_sys->channels, 2 );
+    if( unlikely( p_sys->in == NULL || p_sys->out == NULL
+               || p_sys->conv == NULL ) )
+        goto error;
+
+#ifdef HAVE_MYSOFA
+    int sofa_length;
+    struct MYSOFA_EASY *sofa = SofaOpen( p_filter, &sofa_length );
+#endif
+
+    /* Every speaker to both ears, a bit down not to add up too loud */
+    const float gain = M_SQRT1_2;
+    unsigned input = 0;
+    int ret = VLC_SUCCESS;
+    for( unsigned i = 0; pi_vlc_chan_order_wg4[i] && ret == VLC_SUCCESS; i++ )
+    {
+        const uint32_t chan = pi_vlc_chan_order_wg4[i];
+        if( !( infmt->i_physical_channels & chan ) )
+            continue;
+
+        struct speaker pos;
+        float *ir[2] = { NULL, NULL };
+        unsigned length;
+
+        if( !SpeakerPosition( chan, infmt->i_physical_channels, &pos ) )
+        {
+            /* The LFE straight to both ears */
+            for( unsigned e = 0; e < 2 && ret == VLC_SUCCESS; e++ )
+                ret = convolver_SetResponse( p_sys->conv, input, e,
+                                             &gain, 1 );
+            input++;
+            continue;
+        }
+
+#ifdef HAVE_MYSOFA
+        if( sofa != NULL )
+            ret = SofaResponses( sofa, sofa_length, rate, &pos, ir, &length );
+        else
+#endif
+            ret = ModelResponses( p_filter, &pos, ir, &length );
+
+        for( unsigned e = 0; e < 2 && ret == VLC_SUCCESS; e++ )
+        {
+            for( unsigned n = 0; n < length; n++ )
+                ir[e][n] *= gain;
+            ret = convolver_SetResponse( p_sys->conv, input, e, ir[e],
+                                         length );
+        }
+        free( ir[1] );
+        free( ir[0] );
+        input++;
+    }
+
+#ifdef HAVE_MYSOFA
+    if( sofa != NULL )
+        mysofa_close( sofa );
+#endif
+    if( ret != VLC_SUCCESS )
+        goto error;
+
+    msg_Dbg( p_filter, "rendering %u channels to binaural by blocks of %u",
+             p_sys->channels, block );
+
+    infmt->i_format = VLC_CODEC_FL32;
+    *outfmt = *infmt;
+    outfmt->i_physical_channels = AOUT_CHANS_STEREO;
+    outfmt->i_chan_mode = 0;
+    aout_FormatPrepare( infmt );
+    aout_FormatPrepare( outfmt );
+
+    p_filter->pf_audio_filter = Render;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+
+error:
+    Close( p_this );
+    return VLC_ENOMEM;
+}
+
+/*****************************************************************************
+ * Close:
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->conv != NULL )
+        convolver_Delete( p_sys->conv );
+    free( p_sys->out );
+    free( p_sys->in );
+    free( p_sys );
+}
@@ -34,11 +34,22 @@
 #include <vlc_plugin.h>
 
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 
 #include "../../packetizer/a52.h"
 #include "../../packetizer/dts_header.h"
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
 static int  Open( vlc_object_t * );
 static void Close( vlc_object_t * );
 
@@ -50,10 +61,119 @@ vlc_module_begin ()
     set_callbacks( Open, Close )
 vlc_module_end ()
 
+/* Bursts are large (up to 61440 bytes for TrueHD) and built at a steady
+ * rate, so the released ones are kept for the next bursts. The pool outlives
+ * the filter until its last burst is released by the audio output. */
+#define SPDIF_POOL_MAX 4
+
+typedef struct spdif_pool
+{
+    vlc_mutex_t lock;
+    block_t *p_free;
+    unsigned i_free;
+    unsigned i_used;
+    size_t i_size;
+    bool b_closed;
+} spdif_pool;
+
+typedef struct
+{
+    block_t self;
+    spdif_pool *p_pool;
+    size_t i_size;
+} spdif_block;
+
+static void pool_Destroy( spdif_pool *p_pool )
+{
+    while( p_pool->p_free != NULL )
+    {
+        block_t *p_block = p_pool->p_free;
+        p_pool->p_free = p_block->p_next;
+        free( p_block );
+    }
+    p_pool->i_free = 0;
+}
+
+static void pool_Release( block_t *p_block )
+{
+    spdif_block *p_spdif = container_of( p_block, spdif_block, self );
+    spdif_pool *p_pool = p_spdif->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    assert( p_pool->i_used > 0 );
+    p_pool->i_used--;
+    if( !p_pool->b_closed && p_spdif->i_size == p_pool->i_size
+     && p_pool->i_free < SPDIF_POOL_MAX )
+    {
+        p_block->p_next = p_pool->p_free;
+        p_pool->p_free = p_block;
+        p_pool->i_free++;
+        p_block = NULL;
+    }
+    bool b_destroy = p_pool->b_closed && p_pool->i_used == 0;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    free( p_block );
+    if( b_destroy )
+        free( p_pool );
+}
+
+static const struct vlc_block_callbacks pool_cbs =
+{
+    pool_Release,
+};
+
+static block_t *pool_Get( spdif_pool *p_pool, size_t i_size )
+{
+    spdif_block *p_spdif = NULL;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( i_size != p_pool->i_size )
+    {   /* the bursts of another size are not coming back */
+        pool_Destroy( p_pool );
+        p_pool->i_size = i_size;
+    }
+    if( p_pool->p_free != NULL )
+    {
+        block_t *p_block = p_pool->p_free;
+        p_pool->p_free = p_block->p_next;
+        p_pool->i_free--;
+        p_spdif = container_of( p_block, spdif_block, self );
+    }
+    else
+    {
+        p_spdif = malloc( sizeof( *p_spdif ) + i_size );
+        if( unlikely( p_spdif == NULL ) )
+        {
+            vlc_mutex_unlock( &p_pool->lock );
+            return NULL;
+        }
+        p_spdif->p_pool = p_pool;
+        p_spdif->i_size = i_size;
+    }
+    p_pool->i_used++;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    return block_Init( &p_spdif->self, &pool_cbs, p_spdif + 1, i_size );
+}
+
+static void pool_Close( spdif_pool *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    pool_Destroy( p_pool );
+    p_pool->b_closed = true;
+    bool b_destroy = p_pool->i_used == 0;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( b_destroy )
+        free( p_pool );
+}
+
 typedef struct
 {
     block_t *p_out_buf;
     size_t i_out_offset;
+    spdif_pool *p_pool;
 
     union
     {
@@ -135,6 +255,53 @@ static void write_padding( filter_t *p_filter, size_t i_size )
     p_sys->i_out_offset += i_size;
 }
 
+/* Copy 16-bit words swapping their bytes, as the bursts of TrueHD and DTS-HD
+ * take megabytes per second. The buffers may also be the same. */
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static size_t swap_16_avx2( uint8_t *p_out, const uint8_t *p_in, size_t i_size )
+{
+    size_t i = 0;
+    for( ; i + 32 <= i_size; i += 32 )
+    {
+        __m256i v = _mm256_loadu_si256( (const __m256i *)&p_in[i] );
+        v = _mm256_or_si256( _mm256_slli_epi16( v, 8 ),
+                             _mm256_srli_epi16( v, 8 ) );
+        _mm256_storeu_si256( (__m256i *)&p_out[i], v );
+    }
+    return i;
+}
+#endif
+
+static void swap_16( uint8_t *p_out, const uint8_t *p_in, size_t i_size )
+{
+    size_t i = 0;
+
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        i = swap_16_avx2( p_out, p_in, i_size );
+#endif
+#if defined(__SSE2__)
+    for( ; i + 16 <= i_size; i += 16 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i *)&p_in[i] );
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        _mm_storeu_si128( (__m128i *)&p_out[i], v );
+    }
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+        for( ; i + 16 <= i_size; i += 16 )
+            vst1q_u8( &p_out[i], vrev16q_u8( vld1q_u8( &p_in[i] ) ) );
+#endif
+    for( ; i + 2 <= i_size; i += 2 )
+    {
+        const uint8_t i_first = p_in[i];
+        p_out[i] = p_in[i + 1];
+        p_out[i + 1] = i_first;
+    }
+}
+
 static void write_data( filter_t *p_filter, const void *p_buf, size_t i_size,
                         bool b_input_big_endian )
 {
@@ -149,7 +316,7 @@ static void write_data( filter_t *p_filter, const void *p_buf, size_t i_size,
     assert( p_sys->p_out_buf->i_buffer - p_sys->i_out_offset >= i_size );
 
     if( b_input_big_endian != b_output_big_endian )
-        swab( p_in, p_out, i_size & ~1 );
+        swap_16( p_out, p_in, i_size & ~1 );
     else
         memcpy( p_out, p_in, i_size & ~1 );
     p_sys->i_out_offset += ( i_size & ~1 );
@@ -179,7 +346,7 @@ static int write_init( filter_t *p_filter, block_t *p_in_buf,
     assert( p_sys->p_out_buf == NULL );
     assert( i_out_size > SPDIF_HEADER_SIZE && ( i_out_size & 3 ) == 0 );
 
-    p_sys->p_out_buf = block_Alloc( i_out_size );
+    p_sys->p_out_buf = pool_Get( p_sys->p_pool, i_out_size );
     if( !p_sys->p_out_buf )
         return VLC_ENOMEM;
     p_sys->p_out_buf->i_dts = p_in_buf->i_dts;
@@ -616,6 +783,14 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( p_sys == NULL ) )
         return VLC_ENOMEM;
 
+    p_sys->p_pool = calloc( 1, sizeof(*p_sys->p_pool) );
+    if( unlikely( p_sys->p_pool == NULL ) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    vlc_mutex_init( &p_sys->p_pool->lock );
+
     p_filter->pf_audio_filter = DoWork;
     p_filter->pf_flush = Flush;
 
@@ -626,6 +801,9 @@ static void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    filter_sys_t *p_sys = p_filter->p_sys;
+
     Flush( p_filter );
-    free( p_filter->p_sys );
+    pool_Close( p_sys->p_pool );
+    free( p_sys );
 }
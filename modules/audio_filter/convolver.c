@@ -0,0 +1,483 @@
+/*****************************************************************************
+ * convolver.c: partitioned convolution engine
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "convolver.h"
+
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
+/* The blocks are transformed on twice their length, as real signals packed
+ * in complex transforms of their length: a spectrum is the real parts of its
+ * bins then their imaginary parts, with the Nyquist bin, real, in the
+ * imaginary part of the DC bin. */
+
+typedef void (*mac_fn)( float *restrict, const float *restrict,
+                        const float *restrict, unsigned );
+
+struct convolver
+{
+    unsigned block;
+    unsigned inputs;
+    unsigned outputs;
+
+    unsigned partitions;  /**< spectra of each input kept */
+    unsigned current;     /**< spectrum of the last input block */
+    float   *spectra;     /**< inputs * partitions spectra */
+    float   *history;     /**< inputs * block, the previous input block */
+
+    unsigned *lengths;    /**< partitions of each path, 0 if none */
+    float   **responses;  /**< spectra of the partitions of each path */
+
+    float   *acc;         /**< spectrum of one output */
+    unsigned *bitrev;
+    float   *twiddles;    /**< cosines then sines, of each stage */
+    float   *packing;     /**< cosines then sines, of pi k / block */
+
+    mac_fn   mac;
+};
+
+/*****************************************************************************
+ * Transforms
+ *****************************************************************************/
+/* In place radix-2 transform of block complex numbers, unnormalized */
+static void Transform( const convolver_t *conv, float *re, float *im,
+                       bool inverse )
+{
+    const unsigned n = conv->block;
+    const float sign = inverse ? 1.f : -1.f;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        const unsigned j = conv->bitrev[i];
+        if( i < j )
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for( unsigned half = 1; half < n; half *= 2 )
+    {
+        const float *wr = &conv->twiddles[half - 1];
+        const float *wi = &conv->twiddles[n - 1 + half - 1];
+
+        for( unsigned s = 0; s < n; s += 2 * half )
+        {
+            float *ar = &re[s], *ai = &im[s];
+            float *br = &re[s + half], *bi = &im[s + half];
+
+            for( unsigned j = 0; j < half; j++ )
+            {
+                const float ci = sign * wi[j];
+                const float tr = br[j] * wr[j] - bi[j] * ci;
+                const float ti = br[j] * ci + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+/* Spectrum of 2 * block real samples, the even ones in re, the odd ones in
+ * im */
+static void Forward( const convolver_t *conv, float *re, float *im )
+{
+    const unsigned n = conv->block;
+    const float *cosines = conv->packing, *sines = conv->packing + n;
+
+    Transform( conv, re, im, false );
+
+    const float r0 = re[0], i0 = im[0];
+    re[0] = r0 + i0;
+    im[0] = r0 - i0;
+
+    for( unsigned k = 1; k <= n / 2; k++ )
+    {
+        const float zr = re[k], zi = im[k];
+        const float yr = re[n - k], yi = im[n - k];
+        /* the transforms of the even and odd samples */
+        const float er = .5f * ( zr + yr ), ei = .5f * ( zi - yi );
+        const float odr = .5f * ( zi + yi ), odi = -.5f * ( zr - yr );
+        /* times exp(-i pi k / n) */
+        const float tr = odr * cosines[k] + odi * sines[k];
+        const float ti = odi * cosines[k] - odr * sines[k];
+
+        re[k] = er + tr;
+        im[k] = ei + ti;
+        re[n - k] = er - tr;
+        im[n - k] = ti - ei;
+    }
+}
+
+/* 2 * block real samples, times block, of a spectrum, as in Forward() */
+static void Inverse( const convolver_t *conv, float *re, float *im )
+{
+    const unsigned n = conv->block;
+    const float *cosines = conv->packing, *sines = conv->packing + n;
+
+    const float x0 = re[0], xn = im[0];
+    re[0] = .5f * ( x0 + xn );
+    im[0] = .5f * ( x0 - xn );
+
+    for( unsigned k = 1; k <= n / 2; k++ )
+    {
+        const float xr = re[k], xi = im[k];
+        const float yr = re[n - k], yi = im[n - k];
+        const float er = .5f * ( xr + yr ), ei = .5f * ( xi - yi );
+        const float dr = .5f * ( xr - yr ), di = .5f * ( xi + yi );
+        /* times exp(i pi k / n) */
+        const float odr = dr * cosines[k] - di * sines[k];
+        const float odi = di * cosines[k] + dr * sines[k];
+
+        re[k] = er - odi;
+        im[k] = ei + odr;
+        re[n - k] = er + odi;
+        im[n - k] = odr - ei;
+    }
+
+    Transform( conv, re, im, true );
+}
+
+/*****************************************************************************
+ * Complex multiply and accumulate
+ *****************************************************************************/
+static void Mac_c( float *restrict acc, const float *restrict x,
+                   const float *restrict h, unsigned n )
+{
+    float *ar = acc, *ai = acc + n;
+    const float *xr = x, *xi = x + n, *hr = h, *hi = h + n;
+
+    for( unsigned k = 0; k < n; k++ )
+    {
+        ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+        ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+}
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static void Mac_sse( float *restrict acc, const float *restrict x,
+                     const float *restrict h, unsigned n )
+{
+    float *ar = acc, *ai = acc + n;
+    const float *xr = x, *xi = x + n, *hr = h, *hi = h + n;
+
+    for( unsigned k = 0; k < n; k += 4 )
+    {
+        const __m128 a = _mm_load_ps( &xr[k] ), b = _mm_load_ps( &xi[k] );
+        const __m128 c = _mm_load_ps( &hr[k] ), d = _mm_load_ps( &hi[k] );
+
+        _mm_store_ps( &ar[k], _mm_add_ps( _mm_load_ps( &ar[k] ),
+                      _mm_sub_ps( _mm_mul_ps( a, c ), _mm_mul_ps( b, d ) ) ) );
+        _mm_store_ps( &ai[k], _mm_add_ps( _mm_load_ps( &ai[k] ),
+                      _mm_add_ps( _mm_mul_ps( a, d ), _mm_mul_ps( b, c ) ) ) );
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static void Mac_avx2( float *restrict acc, const float *restrict x,
+                      const float *restrict h, unsigned n )
+{
+    float *ar = acc, *ai = acc + n;
+    const float *xr = x, *xi = x + n, *hr = h, *hi = h + n;
+
+    for( unsigned k = 0; k < n; k += 8 )
+    {
+        const __m256 a = _mm256_load_ps( &xr[k] ), b = _mm256_load_ps( &xi[k] );
+        const __m256 c = _mm256_load_ps( &hr[k] ), d = _mm256_load_ps( &hi[k] );
+
+        _mm256_store_ps( &ar[k], _mm256_add_ps( _mm256_load_ps( &ar[k] ),
+            _mm256_sub_ps( _mm256_mul_ps( a, c ), _mm256_mul_ps( b, d ) ) ) );
+        _mm256_store_ps( &ai[k], _mm256_add_ps( _mm256_load_ps( &ai[k] ),
+            _mm256_add_ps( _mm256_mul_ps( a, d ), _mm256_mul_ps( b, c ) ) ) );
+    }
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void Mac_neon( float *restrict acc, const float *restrict x,
+                      const float *restrict h, unsigned n )
+{
+    float *ar = acc, *ai = acc + n;
+    const float *xr = x, *xi = x + n, *hr = h, *hi = h + n;
+
+    for( unsigned k = 0; k < n; k += 4 )
+    {
+        const float32x4_t a = vld1q_f32( &xr[k] ), b = vld1q_f32( &xi[k] );
+        const float32x4_t c = vld1q_f32( &hr[k] ), d = vld1q_f32( &hi[k] );
+
+        vst1q_f32( &ar[k], vfmsq_f32( vfmaq_f32( vld1q_f32( &ar[k] ), a, c ),
+                                      b, d ) );
+        vst1q_f32( &ai[k], vfmaq_f32( vfmaq_f32( vld1q_f32( &ai[k] ), a, d ),
+                                      b, c ) );
+    }
+}
+#endif
+
+/* The DC and Nyquist bins are real, and not a complex number */
+static void Mac( const convolver_t *conv, float *acc, const float *x,
+                 const float *h )
+{
+    const unsigned n = conv->block;
+    const float dc = acc[0], nyquist = acc[n];
+
+    conv->mac( acc, x, h, n );
+    acc[0] = dc + x[0] * h[0];
+    acc[n] = nyquist + x[n] * h[n];
+}
+
+/*****************************************************************************
+ * Convolver
+ *****************************************************************************/
+convolver_t *convolver_New( unsigned block, unsigned inputs,
+                            unsigned outputs )
+{
+    assert( block >= 8 && ( block & ( block - 1 ) ) == 0 );
+    assert( inputs > 0 && outputs > 0 );
+
+    convolver_t *conv = calloc( 1, sizeof (*conv) );
+    if( unlikely( conv == NULL ) )
+        return NULL;
+
+    conv->block = block;
+    conv->inputs = inputs;
+    conv->outputs = outputs;
+    conv->history = calloc( (size_t)inputs * block, sizeof (float) );
+    conv->lengths = calloc( (size_t)inputs * outputs, sizeof (unsigned) );
+    conv->responses = calloc( (size_t)inputs * outputs, sizeof (float *) );
+    conv->acc = aligned_alloc( 32, 2 * block * sizeof (float) );
+    conv->bitrev = vlc_alloc( block, sizeof (unsigned) );
+    conv->twiddles = vlc_alloc( 2 * ( block - 1 ), sizeof (float) );
+    conv->packing = vlc_alloc( 2 * block, sizeof (float) );
+    if( unlikely( conv->history == NULL || conv->lengths == NULL
+               || conv->responses == NULL || conv->acc == NULL
+               || conv->bitrev == NULL || conv->twiddles == NULL
+               || conv->packing == NULL ) )
+    {
+        convolver_Delete( conv );
+        return NULL;
+    }
+
+    unsigned bits = 0;
+    while( ( 1u << bits ) < block )
+        bits++;
+    for( unsigned i = 0; i < block; i++ )
+    {
+        unsigned r = 0;
+        for( unsigned b = 0; b < bits; b++ )
+            r |= ( ( i >> b ) & 1 ) << ( bits - 1 - b );
+        conv->bitrev[i] = r;
+    }
+
+    for( unsigned half = 1; half < block; half *= 2 )
+        for( unsigned j = 0; j < half; j++ )
+        {
+            conv->twiddles[half - 1 + j] = cos( M_PI * j / half );
+            conv->twiddles[block - 1 + half - 1 + j] = sin( M_PI * j / half );
+        }
+    for( unsigned k = 0; k < block; k++ )
+    {
+        conv->packing[k] = cos( M_PI * k / block );
+        conv->packing[block + k] = sin( M_PI * k / block );
+    }
+
+    conv->mac = Mac_c;
+#ifdef CAN_COMPILE_SSE
+    if( vlc_CPU_SSE() )
+        conv->mac = Mac_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        conv->mac = Mac_avx2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+        conv->mac = Mac_neon;
+#endif
+    return conv;
+}
+
+void convolver_Delete( convolver_t *conv )
+{
+    if( conv->responses != NULL )
+        for( unsigned i = 0; i < conv->inputs * conv->outputs; i++ )
+            aligned_free( conv->responses[i] );
+    free( conv->responses );
+    free( conv->lengths );
+    aligned_free( conv->spectra );
+    free( conv->history );
+    aligned_free( conv->acc );
+    free( conv->bitrev );
+    free( conv->twiddles );
+    free( conv->packing );
+    free( conv );
+}
+
+void convolver_Reset( convolver_t *conv )
+{
+    const size_t size = 2 * conv->block * sizeof (float);
+
+    memset( conv->history, 0, conv->inputs * conv->block * sizeof (float) );
+    if( conv->spectra != NULL )
+        memset( conv->spectra, 0, conv->inputs * conv->partitions * size );
+    conv->current = 0;
+}
+
+int convolver_SetResponse( convolver_t *conv, unsigned input,
+                           unsigned output, const float *ir, size_t length )
+{
+    assert( input < conv->inputs && output < conv->outputs );
+
+    const unsigned n = conv->block;
+    const size_t path = (size_t)input * conv->outputs + output;
+    const unsigned count = ir != NULL ? ( length + n - 1 ) / n : 0;
+    float *spectra = NULL;
+
+    if( count > 0 )
+    {
+        spectra = aligned_alloc( 32, (size_t)count * 2 * n * sizeof (float) );
+        if( unlikely( spectra == NULL ) )
+            return VLC_ENOMEM;
+    }
+
+    /* Keep the input spectra of the longest path */
+    if( count > conv->partitions )
+    {
+        float *fdl = aligned_alloc( 32, (size_t)conv->inputs * count
+                                        * 2 * n * sizeof (float) );
+        if( unlikely( fdl == NULL ) )
+        {
+            aligned_free( spectra );
+            return VLC_ENOMEM;
+        }
+        aligned_free( conv->spectra );
+        conv->spectra = fdl;
+        conv->partitions = count;
+        convolver_Reset( conv );
+    }
+
+    for( unsigned p = 0; p < count; p++ )
+    {
+        float *re = &spectra[p * 2 * n], *im = re + n;
+
+        /* the partition, then as many zeros */
+        for( unsigned k = 0; k < n; k++ )
+        {
+            const size_t i = (size_t)p * n + 2 * k;
+            re[k] = 2 * k < n && i < length ? ir[i] : 0.f;
+            im[k] = 2 * k + 1 < n && i + 1 < length ? ir[i + 1] : 0.f;
+        }
+        Forward( conv, re, im );
+        /* the inverse transform is not normalized */
+        for( unsigned k = 0; k < 2 * n; k++ )
+            re[k] /= n;
+    }
+
+    aligned_free( conv->responses[path] );
+    conv->responses[path] = spectra;
+    conv->lengths[path] = count;
+    return VLC_SUCCESS;
+}
+
+void convolver_Process( convolver_t *conv, const float *in, float *out )
+{
+    const unsigned n = conv->block;
+    const unsigned inputs = conv->inputs, outputs = conv->outputs;
+
+    if( conv->partitions == 0 )
+    {
+        memset( out, 0, (size_t)n * outputs * sizeof (float) );
+        return;
+    }
+
+    /* Transform the last two blocks of each input */
+    conv->current = ( conv->current + 1 ) % conv->partitions;
+    for( unsigned i = 0; i < inputs; i++ )
+    {
+        float *re = &conv->spectra[( (size_t)i * conv->partitions
+                                     + conv->current ) * 2 * n];
+        float *im = re + n;
+        float *history = &conv->history[(size_t)i * n];
+
+        for( unsigned k = 0; k < n / 2; k++ )
+        {
+            re[k] = history[2 * k];
+            im[k] = history[2 * k + 1];
+        }
+        for( unsigned k = 0; k < n / 2; k++ )
+        {
+            re[n / 2 + k] = in[( 2 * k ) * inputs + i];
+            im[n / 2 + k] = in[( 2 * k + 1 ) * inputs + i];
+        }
+        for( unsigned k = 0; k < n; k++ )
+            history[k] = in[k * inputs + i];
+        Forward( conv, re, im );
+    }
+
+    for( unsigned o = 0; o < outputs; o++ )
+    {
+        float *acc = conv->acc;
+        memset( acc, 0, 2 * n * sizeof (float) );
+
+        for( unsigned i = 0; i < inputs; i++ )
+        {
+            const size_t path = (size_t)i * outputs + o;
+            const float *h = conv->responses[path];
+            const float *fdl = &conv->spectra[(size_t)i * conv->partitions
+                                              * 2 * n];
+
+            for( unsigned p = 0; p < conv->lengths[path]; p++ )
+            {
+                const unsigned slot = ( conv->current + conv->partitions - p )
+                                    % conv->partitions;
+                Mac( conv, acc, &fdl[slot * 2 * n], &h[p * 2 * n] );
+            }
+        }
+
+        /* The second half of the circular convolution is the output */
+        Inverse( conv, acc, acc + n );
+        for( unsigned k = 0; k < n / 2; k++ )
+        {
+            out[( 2 * k ) * outputs + o] = acc[n / 2 + k];
+            out[( 2 * k + 1 ) * outputs + o] = acc[n + n / 2 + k];
+        }
+    }
+}
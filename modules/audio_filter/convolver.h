@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * convolver.h: partitioned convolution engine
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_CONVOLVER_H
+#define VLC_AUDIO_CONVOLVER_H
+
+/**
+ * Partitioned convolution
+ *
+ * Each output is the sum of the inputs convolved with the impulse responses
+ * of their paths to that output: the HRIRs of every speaker to both ears for
+ * a binaural renderer, or one room correction response per channel.
+ *
+ * The responses are cut in partitions of one block, transformed once, and
+ * the blocks of input are convolved in the frequency domain with uniform
+ * partitions and overlap-save: the output of a block is ready as soon as the
+ * block is in, whatever the lengths of the responses, for a fixed latency of
+ * one block.
+ */
+typedef struct convolver convolver_t;
+
+/**
+ * Create a convolver
+ *
+ * \param block the frames per block, a power of 2, 8 at least
+ * \param inputs the input channels
+ * \param outputs the output channels
+ * \return the convolver, without any path, or NULL on error
+ */
+convolver_t *convolver_New( unsigned block, unsigned inputs,
+                            unsigned outputs );
+
+/**
+ * Delete a convolver
+ */
+void convolver_Delete( convolver_t *conv );
+
+/**
+ * Set the impulse response of the path from an input to an output
+ *
+ * A path without a response does not cost anything.
+ *
+ * \param ir the impulse response, or NULL to remove the path
+ * \param length the samples of the response
+ */
+int convolver_SetResponse( convolver_t *conv, unsigned input,
+                           unsigned output, const float *ir, size_t length );
+
+/**
+ * Convolve one block
+ *
+ * \param in the block of interleaved input samples
+ * \param out the block of interleaved output samples, overwritten
+ */
+void convolver_Process( convolver_t *conv, const float *in, float *out );
+
+/**
+ * Forget the past input
+ */
+void convolver_Reset( convolver_t *conv );
+
+#endif
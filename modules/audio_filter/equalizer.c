@@ -33,14 +33,24 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_charset.h>
+#include <vlc_cpu.h>
 
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
 #include "equalizer_presets.h"
 
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -104,22 +114,30 @@ typedef struct
 {
     /* Filter static config */
     int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
 
     /* Filter dyn config */
     float *f_amp;   /* Per band amp */
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
-    /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
-
-    /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    /* The amps in use, which follow the configured ones block after block */
+    float *f_cur_amp;
+    float f_cur_gamp;
+
+    /* Filter vectors: each one holds 4 lanes, of the 4 / i_width bands of
+     * the channels, or of 4 channels of a band */
+    unsigned i_channels;
+    unsigned i_width;   /* channels per vector: 1, 2 or 4 */
+    unsigned i_chunks;  /* vectors of channels */
+    unsigned i_vectors; /* vectors of bands, per chunk */
+    unsigned i_pairs;   /* pairs of vectors, per chunk, with the padding */
+    float *p_coeffs;    /* alpha, beta, gamma and amp of each vector */
+    float *p_state[2];  /* y(n-1) and y(n-2) of each vector, for each pass */
+    float *p_delta;     /* x(n) - x(n-2) of a chunk */
+    float *p_acc;       /* sums of the bands of a chunk */
+    float *p_history[2];/* x(n-2) and x(n-1) of each channel, for each pass */
+    void (*pf_bands)( float *, const float *, unsigned,
+                      const float *, float *, unsigned );
 
     vlc_mutex_t lock;
 } filter_sys_t;
@@ -127,7 +145,9 @@ typedef struct
 static block_t *DoWork( filter_t *, block_t * );
 
 #define EQZ_IN_FACTOR (0.25f)
-static int  EqzInit( filter_t *, int );
+#define EQZ_BLOCK     (128)   /* samples filtered with the same amps */
+#define EQZ_SMOOTH    (0.25f) /* part of an amp change applied per block */
+static int  EqzInit( filter_t *, int, unsigned );
 static void EqzFilter( filter_t *, float *, float *, int, int );
 static void EqzClean( filter_t * );
 
@@ -155,7 +175,9 @@ static int Open( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     vlc_mutex_init( &p_sys->lock );
-    if( EqzInit( p_filter, p_filter->fmt_in.audio.i_rate ) != VLC_SUCCESS )
+    if( EqzInit( p_filter, p_filter->fmt_in.audio.i_rate,
+                 aout_FormatNbChannels( &p_filter->fmt_in.audio ) )
+        != VLC_SUCCESS )
     {
         free( p_sys );
         return VLC_EGENERIC;
@@ -219,11 +241,15 @@ static void EqzCoeffs( int i_rate, float f_octave_percent,
     const float *f_freq_table_10b = b_use_vlc_freqs
                                   ? f_vlc_frequency_table_10b
                                   : f_iso_frequency_table_10b;
-    float f_rate = (float) i_rate;
-    float f_nyquist_freq = 0.5f * f_rate;
-    float f_octave_factor = powf( 2.0f, 0.5f * f_octave_percent );
-    float f_octave_factor_1 = 0.5f * ( f_octave_factor + 1.0f );
-    float f_octave_factor_2 = 0.5f * ( f_octave_factor - 1.0f );
+    /* Computed in double precision and rounded once, so that the
+     * coefficients do not depend on the floating point optimizations: the
+     * poles of the low bands are close to the unit circle, and the response
+     * is sensitive to the last bits of the coefficients */
+    double f_rate = (double) i_rate;
+    double f_nyquist_freq = 0.5 * f_rate;
+    double f_octave_factor = pow( 2.0, 0.5 * f_octave_percent );
+    double f_octave_factor_1 = 0.5 * ( f_octave_factor + 1.0 );
+    double f_octave_factor_2 = 0.5 * ( f_octave_factor - 1.0 );
 
     p_eqz_config->i_band = EQZ_BANDS_MAX;
 
@@ -235,17 +261,17 @@ static void EqzCoeffs( int i_rate, float f_octave_percent,
 
         if( f_freq <= f_nyquist_freq )
         {
-            float f_theta_1 = ( 2.0f * (float) M_PI * f_freq ) / f_rate;
-            float f_theta_2 = f_theta_1 / f_octave_factor;
-            float f_sin     = sinf( f_theta_2 );
-            float f_sin_prd = sinf( f_theta_2 * f_octave_factor_1 )
-                            * sinf( f_theta_2 * f_octave_factor_2 );
-            float f_sin_hlf = f_sin * 0.5f;
-            float f_den     = f_sin_hlf + f_sin_prd;
+            double f_theta_1 = ( 2.0 * M_PI * f_freq ) / f_rate;
+            double f_theta_2 = f_theta_1 / f_octave_factor;
+            double f_sin     = sin( f_theta_2 );
+            double f_sin_prd = sin( f_theta_2 * f_octave_factor_1 )
+                             * sin( f_theta_2 * f_octave_factor_2 );
+            double f_sin_hlf = f_sin * 0.5;
+            double f_den     = f_sin_hlf + f_sin_prd;
 
             p_eqz_config->band[i].f_alpha = f_sin_prd / f_den;
             p_eqz_config->band[i].f_beta  = ( f_sin_hlf - f_sin_prd ) / f_den;
-            p_eqz_config->band[i].f_gamma = f_sin * cosf( f_theta_1 ) / f_den;
+            p_eqz_config->band[i].f_gamma = f_sin * cos( f_theta_1 ) / f_den;
         }
         else
         {
@@ -274,11 +300,252 @@ static inline float EqzConvertdB( float db )
     return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
 }
 
-static int EqzInit( filter_t *p_filter, int i_rate )
+/*****************************************************************************
+ * Band filters
+ *****************************************************************************
+ * Each vector runs the IIR of 4 lanes over a block, and adds the output
+ * weighted by the amp of its lanes to the sums of the bands. The vectors go
+ * by pairs, with the alpha, beta, gamma and amp of both, then y(n-1) and
+ * y(n-2) of both: the vector that pads the last pair has no coefficients.
+ * Each vector of a pair has its own sums, 8 per sample.
+ *****************************************************************************/
+static void EqzBands_c( float *restrict acc, const float *restrict delta,
+                        unsigned i_samples, const float *restrict coeffs,
+                        float *restrict state, unsigned i_vectors )
+{
+    for( unsigned i = 0; i < i_samples; i++ )
+    {
+        float o[8] = { 0.0f };
+
+        for( unsigned v = 0; v < i_vectors; v++ )
+        {
+            const float *c = &coeffs[32 * ( v / 2 ) + 4 * ( v % 2 )];
+            float *s = &state[16 * ( v / 2 ) + 4 * ( v % 2 )];
+
+            for( unsigned l = 0; l < 4; l++ )
+            {
+                float y = ( c[l] * delta[4 * i + l] - c[8 + l] * s[8 + l] ) +
+                          c[16 + l] * s[l];
+
+                s[8 + l] = s[l];
+                s[l] = y;
+                o[4 * ( v % 2 ) + l] += y * c[24 + l];
+            }
+        }
+        for( unsigned l = 0; l < 8; l++ )
+            acc[8 * i + l] += o[l];
+    }
+}
+
+#ifdef CAN_COMPILE_SSE
+/* Runs the IIR of a vector for one sample, returns the weighted output */
+VLC_SSE
+static inline __m128 EqzBiquad_sse( const float *c, __m128 d,
+                                    __m128 *y1, __m128 *y2 )
+{
+    const __m128 y = _mm_add_ps( _mm_sub_ps(
+                _mm_mul_ps( _mm_load_ps( &c[0] ), d ),
+                _mm_mul_ps( _mm_load_ps( &c[8] ), *y2 ) ),
+            _mm_mul_ps( _mm_load_ps( &c[16] ), *y1 ) );
+
+    *y2 = *y1;
+    *y1 = y;
+    return _mm_mul_ps( y, _mm_load_ps( &c[24] ) );
+}
+
+VLC_SSE
+static void EqzBands_sse( float *restrict acc, const float *restrict delta,
+                          unsigned i_samples, const float *restrict coeffs,
+                          float *restrict state, unsigned i_vectors )
+{
+    unsigned v = 0;
+
+    /* Two pairs at once hide the latency of each other's recursion, with
+     * the padding vector if the last pair has one */
+    for( ; v + 2 < i_vectors; v += 4, coeffs += 64, state += 32 )
+    {
+        __m128 y01 = _mm_load_ps( &state[0] ), y02 = _mm_load_ps( &state[8] );
+        __m128 y11 = _mm_load_ps( &state[4] ), y12 = _mm_load_ps( &state[12] );
+        __m128 y21 = _mm_load_ps( &state[16] ), y22 = _mm_load_ps( &state[24] );
+        __m128 y31 = _mm_load_ps( &state[20] ), y32 = _mm_load_ps( &state[28] );
+
+        for( unsigned i = 0; i < i_samples; i++ )
+        {
+            const __m128 d = _mm_load_ps( &delta[4 * i] );
+            __m128 o0 = _mm_load_ps( &acc[8 * i] );
+            __m128 o1 = _mm_load_ps( &acc[8 * i + 4] );
+
+            o0 = _mm_add_ps( o0, EqzBiquad_sse( &coeffs[0], d, &y01, &y02 ) );
+            o1 = _mm_add_ps( o1, EqzBiquad_sse( &coeffs[4], d, &y11, &y12 ) );
+            o0 = _mm_add_ps( o0, EqzBiquad_sse( &coeffs[32], d, &y21, &y22 ) );
+            o1 = _mm_add_ps( o1, EqzBiquad_sse( &coeffs[36], d, &y31, &y32 ) );
+            _mm_store_ps( &acc[8 * i], o0 );
+            _mm_store_ps( &acc[8 * i + 4], o1 );
+        }
+        _mm_store_ps( &state[0], y01 );
+        _mm_store_ps( &state[8], y02 );
+        _mm_store_ps( &state[4], y11 );
+        _mm_store_ps( &state[12], y12 );
+        _mm_store_ps( &state[16], y21 );
+        _mm_store_ps( &state[24], y22 );
+        _mm_store_ps( &state[20], y31 );
+        _mm_store_ps( &state[28], y32 );
+    }
+
+    for( ; v < i_vectors; v += 2, coeffs += 32, state += 16 )
+    {
+        __m128 y01 = _mm_load_ps( &state[0] ), y02 = _mm_load_ps( &state[8] );
+        __m128 y11 = _mm_load_ps( &state[4] ), y12 = _mm_load_ps( &state[12] );
+
+        for( unsigned i = 0; i < i_samples; i++ )
+        {
+            const __m128 d = _mm_load_ps( &delta[4 * i] );
+
+            _mm_store_ps( &acc[8 * i], _mm_add_ps( _mm_load_ps( &acc[8 * i] ),
+                EqzBiquad_sse( &coeffs[0], d, &y01, &y02 ) ) );
+            _mm_store_ps( &acc[8 * i + 4], _mm_add_ps( _mm_load_ps( &acc[8 * i + 4] ),
+                EqzBiquad_sse( &coeffs[4], d, &y11, &y12 ) ) );
+        }
+        _mm_store_ps( &state[0], y01 );
+        _mm_store_ps( &state[8], y02 );
+        _mm_store_ps( &state[4], y11 );
+        _mm_store_ps( &state[12], y12 );
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* Both vectors of a pair are in the halves of a register */
+VLC_AVX2
+static inline __m256 EqzBiquad_avx2( const float *c, __m256 d,
+                                     __m256 *y1, __m256 *y2 )
+{
+    const __m256 y = _mm256_add_ps( _mm256_sub_ps(
+                _mm256_mul_ps( _mm256_load_ps( &c[0] ), d ),
+                _mm256_mul_ps( _mm256_load_ps( &c[8] ), *y2 ) ),
+            _mm256_mul_ps( _mm256_load_ps( &c[16] ), *y1 ) );
+
+    *y2 = *y1;
+    *y1 = y;
+    return _mm256_mul_ps( y, _mm256_load_ps( &c[24] ) );
+}
+
+VLC_AVX2
+static void EqzBands_avx2( float *restrict acc, const float *restrict delta,
+                           unsigned i_samples, const float *restrict coeffs,
+                           float *restrict state, unsigned i_vectors )
+{
+    unsigned v = 0;
+
+    for( ; v + 2 < i_vectors; v += 4, coeffs += 64, state += 32 )
+    {
+        __m256 y01 = _mm256_load_ps( &state[0] ), y02 = _mm256_load_ps( &state[8] );
+        __m256 y11 = _mm256_load_ps( &state[16] ), y12 = _mm256_load_ps( &state[24] );
+
+        for( unsigned i = 0; i < i_samples; i++ )
+        {
+            const __m256 d = _mm256_broadcast_ps( (const __m128 *)&delta[4 * i] );
+            __m256 o = _mm256_load_ps( &acc[8 * i] );
+
+            o = _mm256_add_ps( o, EqzBiquad_avx2( &coeffs[0], d, &y01, &y02 ) );
+            o = _mm256_add_ps( o, EqzBiquad_avx2( &coeffs[32], d, &y11, &y12 ) );
+            _mm256_store_ps( &acc[8 * i], o );
+        }
+        _mm256_store_ps( &state[0], y01 );
+        _mm256_store_ps( &state[8], y02 );
+        _mm256_store_ps( &state[16], y11 );
+        _mm256_store_ps( &state[24], y12 );
+    }
+
+    for( ; v < i_vectors; v += 2, coeffs += 32, state += 16 )
+    {
+        __m256 y01 = _mm256_load_ps( &state[0] ), y02 = _mm256_load_ps( &state[8] );
+
+        for( unsigned i = 0; i < i_samples; i++ )
+        {
+            const __m256 d = _mm256_broadcast_ps( (const __m128 *)&delta[4 * i] );
+
+            _mm256_store_ps( &acc[8 * i], _mm256_add_ps(
+                _mm256_load_ps( &acc[8 * i] ),
+                EqzBiquad_avx2( &coeffs[0], d, &y01, &y02 ) ) );
+        }
+        _mm256_store_ps( &state[0], y01 );
+        _mm256_store_ps( &state[8], y02 );
+    }
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void EqzBands_neon( float *restrict acc, const float *restrict delta,
+                           unsigned i_samples, const float *restrict coeffs,
+                           float *restrict state, unsigned i_vectors )
+{
+    for( unsigned v = 0; v < i_vectors; v += 2, coeffs += 32, state += 16 )
+    {
+        const float32x4_t alpha0 = vld1q_f32( &coeffs[0] );
+        const float32x4_t alpha1 = vld1q_f32( &coeffs[4] );
+        const float32x4_t beta0  = vld1q_f32( &coeffs[8] );
+        const float32x4_t beta1  = vld1q_f32( &coeffs[12] );
+        const float32x4_t gamma0 = vld1q_f32( &coeffs[16] );
+        const float32x4_t gamma1 = vld1q_f32( &coeffs[20] );
+        const float32x4_t amp0   = vld1q_f32( &coeffs[24] );
+        const float32x4_t amp1   = vld1q_f32( &coeffs[28] );
+        float32x4_t y01 = vld1q_f32( &state[0] ), y11 = vld1q_f32( &state[4] );
+        float32x4_t y02 = vld1q_f32( &state[8] ), y12 = vld1q_f32( &state[12] );
+
+        for( unsigned i = 0; i < i_samples; i++ )
+        {
+            const float32x4_t d = vld1q_f32( &delta[4 * i] );
+            float32x4_t y0 = vaddq_f32( vsubq_f32( vmulq_f32( alpha0, d ),
+                                                   vmulq_f32( beta0, y02 ) ),
+                                        vmulq_f32( gamma0, y01 ) );
+            float32x4_t y1 = vaddq_f32( vsubq_f32( vmulq_f32( alpha1, d ),
+                                                   vmulq_f32( beta1, y12 ) ),
+                                        vmulq_f32( gamma1, y11 ) );
+            y02 = y01;
+            y01 = y0;
+            y12 = y11;
+            y11 = y1;
+
+            vst1q_f32( &acc[8 * i], vaddq_f32( vld1q_f32( &acc[8 * i] ),
+                                               vmulq_f32( y0, amp0 ) ) );
+            vst1q_f32( &acc[8 * i + 4], vaddq_f32( vld1q_f32( &acc[8 * i + 4] ),
+                                                   vmulq_f32( y1, amp1 ) ) );
+        }
+        vst1q_f32( &state[0], y01 );
+        vst1q_f32( &state[4], y11 );
+        vst1q_f32( &state[8], y02 );
+        vst1q_f32( &state[12], y12 );
+    }
+}
+#endif
+
+/* Index of the alpha (0), beta (1), gamma (2) or amp (3) lanes of a vector */
+static inline unsigned EqzCoeff( unsigned v, unsigned i_coeff )
+{
+    return 32 * ( v / 2 ) + 8 * i_coeff + 4 * ( v % 2 );
+}
+
+static void EqzSetAmps( filter_sys_t *p_sys )
+{
+    const unsigned i_width = p_sys->i_width;
+
+    for( unsigned v = 0; v < p_sys->i_vectors; v++ )
+        for( unsigned l = 0; l < 4; l++ )
+        {
+            const unsigned i_band = v * ( 4 / i_width ) + l / i_width;
+
+            p_sys->p_coeffs[EqzCoeff( v, 3 ) + l] =
+                i_band < (unsigned)p_sys->i_band ? p_sys->f_cur_amp[i_band]
+                                                 : 0.0f;
+        }
+}
+
+static int EqzInit( filter_t *p_filter, int i_rate, unsigned i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
     int i_ret = VLC_ENOMEM;
@@ -288,48 +555,68 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 
     /* Create the static filter config */
     p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_gamma = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
+    p_sys->i_channels = i_channels;
+    p_sys->i_width = i_channels <= 2 ? i_channels : 4;
+    p_sys->i_chunks = ( i_channels + 3 ) / 4;
+    const unsigned i_width = p_sys->i_width;
+    const unsigned i_bands = 4 / i_width;
+    p_sys->i_vectors = ( p_sys->i_band + i_bands - 1 ) / i_bands;
+    p_sys->i_pairs = ( p_sys->i_vectors + 1 ) / 2;
+
+    /* One allocation for all the vectors, with the history at the end as
+     * its size does not keep the alignment */
+    size_t i_coeffs = 32 * p_sys->i_pairs;
+    size_t i_state = 16 * p_sys->i_pairs * p_sys->i_chunks;
+    size_t i_size = i_coeffs + 2 * i_state + 12 * EQZ_BLOCK + 4 * i_channels;
+
+    p_sys->f_amp = vlc_alloc( p_sys->i_band, sizeof(float) );
+    p_sys->f_cur_amp = vlc_alloc( p_sys->i_band, sizeof(float) );
+    p_sys->p_coeffs = aligned_alloc( 32, ( ( i_size * sizeof(float) + 31 )
+                                           & ~(size_t)31 ) );
+    if( !p_sys->f_amp || !p_sys->f_cur_amp || !p_sys->p_coeffs )
         goto error;
 
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
-    }
+    memset( p_sys->p_coeffs, 0, i_size * sizeof(float) );
+    p_sys->p_state[0] = p_sys->p_coeffs + i_coeffs;
+    p_sys->p_state[1] = p_sys->p_state[0] + i_state;
+    p_sys->p_delta = p_sys->p_state[1] + i_state;
+    p_sys->p_acc = p_sys->p_delta + 4 * EQZ_BLOCK;
+    p_sys->p_history[0] = p_sys->p_acc + 8 * EQZ_BLOCK;
+    p_sys->p_history[1] = p_sys->p_history[0] + 2 * i_channels;
+
+    for( unsigned v = 0; v < p_sys->i_vectors; v++ )
+        for( unsigned l = 0; l < 4; l++ )
+        {
+            const unsigned i_band = v * i_bands + l / i_width;
+            if( i_band >= (unsigned)p_sys->i_band )
+                continue;
+            p_sys->p_coeffs[EqzCoeff( v, 0 ) + l] = cfg.band[i_band].f_alpha;
+            p_sys->p_coeffs[EqzCoeff( v, 1 ) + l] = cfg.band[i_band].f_beta;
+            p_sys->p_coeffs[EqzCoeff( v, 2 ) + l] = cfg.band[i_band].f_gamma;
+        }
+
+    p_sys->pf_bands = EqzBands_c;
+#ifdef CAN_COMPILE_SSE
+    if( vlc_CPU_SSE() )
+        p_sys->pf_bands = EqzBands_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        p_sys->pf_bands = EqzBands_avx2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->pf_bands = EqzBands_neon;
+#endif
 
     /* Filter dyn config */
     p_sys->b_2eqz = false;
     p_sys->f_gamp = 1.0f;
-    p_sys->f_amp  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_amp )
-        goto error;
-
     for( i = 0; i < p_sys->i_band; i++ )
     {
         p_sys->f_amp[i] = 0.0f;
     }
 
-    /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
-
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
@@ -354,12 +641,16 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Err(p_filter, "No preset selected");
         free( val2.psz_string );
-        free( p_sys->f_amp );
         i_ret = VLC_EGENERIC;
         goto error;
     }
     free( val2.psz_string );
 
+    /* Start with the configured amps, without smoothing */
+    memcpy( p_sys->f_cur_amp, p_sys->f_amp, p_sys->i_band * sizeof(float) );
+    p_sys->f_cur_gamp = p_sys->f_gamp;
+    EqzSetAmps( p_sys );
+
     /* Add our own callbacks */
     var_AddCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_AddCallback( p_aout, "equalizer-bands", BandsCallback, p_sys );
@@ -372,78 +663,169 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Dbg( p_filter, "   %.2f Hz -> factor:%f alpha:%f beta:%f gamma:%f",
                  cfg.band[i].f_frequency, p_sys->f_amp[i],
-                 p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
+                 cfg.band[i].f_alpha, cfg.band[i].f_beta,
+                 cfg.band[i].f_gamma );
     }
     return VLC_SUCCESS;
 
 error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
+    free( p_sys->f_amp );
+    free( p_sys->f_cur_amp );
+    aligned_free( p_sys->p_coeffs );
     return i_ret;
 }
 
-static void EqzFilter( filter_t *p_filter, float *out, float *in,
-                       int i_samples, int i_channels )
+/* Moves the amps in use toward the configured ones, so that the changes
+ * are spread over a few blocks rather than heard as clicks */
+static void EqzSmooth( filter_sys_t *p_sys, const float *f_amp, float f_gamp )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    bool b_changed = false;
 
-    vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
+    for( int i = 0; i < p_sys->i_band; i++ )
     {
-        for( ch = 0; ch < i_channels; ch++ )
-        {
-            const float x = in[ch];
-            float o = 0.0f;
+        const float d = f_amp[i] - p_sys->f_cur_amp[i];
+        if( d == 0.0f )
+            continue;
+        if( fabsf( d ) < 1e-5f )
+            p_sys->f_cur_amp[i] = f_amp[i];
+        else
+            p_sys->f_cur_amp[i] += EQZ_SMOOTH * d;
+        b_changed = true;
+    }
+    if( b_changed )
+        EqzSetAmps( p_sys );
 
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
+    const float d = f_gamp - p_sys->f_cur_gamp;
+    if( fabsf( d ) < 1e-5f )
+        p_sys->f_cur_gamp = f_gamp;
+    else
+        p_sys->f_cur_gamp += EQZ_SMOOTH * d;
+}
 
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
+/* Filters the samples of a pass, in place for the second one */
+static void EqzPass( filter_sys_t *p_sys, unsigned i_pass, float *out,
+                     const float *in, unsigned i_samples, float f_gain )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const unsigned i_width = p_sys->i_width;
+    float *restrict history = p_sys->p_history[i_pass];
+    float *restrict delta = p_sys->p_delta;
+    float *restrict acc = p_sys->p_acc;
 
-                o += y * p_sys->f_amp[j];
+    for( unsigned c = 0; c < p_sys->i_chunks; c++ )
+    {
+        /* The lanes hold the channels of the chunk, the last one again
+         * after the end, or the channels again for each band */
+        const unsigned i_first = 4 * c;
+        const unsigned i_last = __MIN( i_first + 4, i_channels );
+        const float *x = &in[i_first];
+        unsigned lanes[4];
+
+        for( unsigned l = 0; l < 4; l++ )
+            lanes[l] = i_width < 4 ? l % i_width
+                                   : __MIN( i_first + l, i_channels - 1 )
+                                     - i_first;
+
+        for( unsigned i = 0; i < __MIN( i_samples, 2 ); i++ )
+            for( unsigned l = 0; l < 4; l++ )
+                delta[4 * i + l] = x[i * i_channels + lanes[l]]
+                                 - history[i * i_channels + i_first + lanes[l]];
+        if( i_width == 1 )
+            for( unsigned i = 2; i < i_samples; i++ )
+            {
+                const float d = x[i] - x[i - 2];
+                for( unsigned l = 0; l < 4; l++ )
+                    delta[4 * i + l] = d;
             }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
+        else if( i_width == 2 )
+            for( unsigned i = 2; i < i_samples; i++ )
+                for( unsigned l = 0; l < 4; l++ )
+                    delta[4 * i + l] = x[2 * i + ( l & 1 )]
+                                     - x[2 * ( i - 2 ) + ( l & 1 )];
+        else if( i_last - i_first == 4 )
+            for( unsigned i = 2; i < i_samples; i++ )
+                for( unsigned l = 0; l < 4; l++ )
+                    delta[4 * i + l] = x[i * i_channels + l]
+                                     - x[( i - 2 ) * i_channels + l];
+        else
+            for( unsigned i = 2; i < i_samples; i++ )
+                for( unsigned l = 0; l < 4; l++ )
+                    delta[4 * i + l] = x[i * i_channels + lanes[l]]
+                                     - x[( i - 2 ) * i_channels + lanes[l]];
 
-            /* Second filter */
-            if( p_sys->b_2eqz )
+        for( unsigned ch = i_first; ch < i_last; ch++ )
+        {
+            history[ch] = i_samples >= 2
+                        ? in[( i_samples - 2 ) * i_channels + ch]
+                        : history[i_channels + ch];
+            history[i_channels + ch] = in[( i_samples - 1 ) * i_channels + ch];
+        }
+        memset( acc, 0, 8 * i_samples * sizeof(float) );
+
+        p_sys->pf_bands( acc, delta, i_samples, p_sys->p_coeffs,
+                         p_sys->p_state[i_pass] + 16 * c * p_sys->i_pairs,
+                         p_sys->i_vectors );
+
+        /* We add source PCM + filtered PCM, with the sums of the bands */
+        float *y = &out[i_first];
+        if( i_width == 1 )
+            for( unsigned i = 0; i < i_samples; i++ )
             {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
+                const float *a = &acc[8 * i];
+                const float o = ( ( a[0] + a[4] ) + ( a[1] + a[5] ) )
+                              + ( ( a[2] + a[6] ) + ( a[3] + a[7] ) );
+                y[i] = f_gain * ( EQZ_IN_FACTOR * x[i] + o );
+            }
+        else if( i_width == 2 )
+            for( unsigned i = 0; i < i_samples; i++ )
+                for( unsigned l = 0; l < 2; l++ )
                 {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
+                    const float *a = &acc[8 * i];
+                    const float o = ( a[l] + a[4 + l] )
+                                  + ( a[2 + l] + a[6 + l] );
+                    y[2 * i + l] = f_gain * ( EQZ_IN_FACTOR * x[2 * i + l] + o );
+                }
+        else
+            for( unsigned i = 0; i < i_samples; i++ )
+                for( unsigned l = 0; l < i_last - i_first; l++ )
+                    y[i * i_channels + l] =
+                        f_gain * ( EQZ_IN_FACTOR * x[i * i_channels + l]
+                                   + ( acc[8 * i + l] + acc[8 * i + 4 + l] ) );
+    }
+}
 
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
+static void EqzFilter( filter_t *p_filter, float *out, float *in,
+                       int i_samples, int i_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    float f_amp[EQZ_BANDS_MAX];
 
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
+    vlc_mutex_lock( &p_sys->lock );
+    memcpy( f_amp, p_sys->f_amp, p_sys->i_band * sizeof(float) );
+    const float f_gamp = p_sys->f_gamp;
+    const bool b_2eqz = p_sys->b_2eqz;
+    vlc_mutex_unlock( &p_sys->lock );
 
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
+    while( i_samples > 0 )
+    {
+        const unsigned i_block = __MIN( i_samples, EQZ_BLOCK );
+
+        EqzSmooth( p_sys, f_amp, f_gamp );
+        const float f_cur_gamp = p_sys->f_cur_gamp;
+
+        if( b_2eqz )
+        {
+            /* Second filter */
+            EqzPass( p_sys, 0, out, in, i_block, 1.0f );
+            EqzPass( p_sys, 1, out, out, i_block, f_cur_gamp * f_cur_gamp );
         }
+        else
+            EqzPass( p_sys, 0, out, in, i_block, f_cur_gamp );
 
-        in  += i_channels;
-        out += i_channels;
+        in  += i_block * i_channels;
+        out += i_block * i_channels;
+        i_samples -= i_block;
     }
-    vlc_mutex_unlock( &p_sys->lock );
 }
 
 static void EqzClean( filter_t *p_filter )
@@ -456,14 +838,11 @@ static void EqzClean( filter_t *p_filter )
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
 
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-
+    aligned_free( p_sys->p_coeffs );
+    free( p_sys->f_cur_amp );
     free( p_sys->f_amp );
 }
 
-
 static int PresetCallback( vlc_object_t *p_aout, char const *psz_cmd,
                          vlc_value_t oldval, vlc_value_t newval, void *p_data )
 {
@@ -0,0 +1,1053 @@
+/*****************************************************************************
+ * loudness.c: loudness normalizer, compressor and true peak limiter
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * One pass does what the compressor and the volume normalizer did in turn:
+ *  - the integrated loudness of the input is measured as in EBU R128 / ITU-R
+ *    BS.1770 (K-weighting, 400 ms blocks overlapping by 75%, absolute and
+ *    relative gates), and the gain moves slowly towards the target loudness;
+ *  - a feed-forward compressor reduces the peaks above its threshold;
+ *  - a look-ahead limiter keeps the true peaks, estimated with 4 times
+ *    oversampling, under the ceiling.
+ *
+ * The samples are copied to frames of vectors of 4 channels, so that the
+ * K-weighting filters and the true peak interpolation of all the channels
+ * run in SIMD lanes. Only the gain computer runs once per frame. The output
+ * is delayed by the look-ahead, 5 ms.
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_cpu.h>
+
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define TARGET_TEXT N_("Target loudness")
+#define TARGET_LONGTEXT N_("Integrated loudness of the output, in LUFS. " \
+    "-18 LUFS is the ReplayGain reference level, -23 LUFS the EBU R128 " \
+    "broadcast one.")
+
+#define MAX_GAIN_TEXT N_("Maximum gain")
+#define MAX_GAIN_LONGTEXT N_("Quiet programs are not amplified beyond this " \
+    "gain, in dB.")
+
+#define CEILING_TEXT N_("True peak ceiling")
+#define CEILING_LONGTEXT N_("The limiter keeps the true peaks of the output " \
+    "under this level, in dBTP.")
+
+#define THRESHOLD_TEXT N_("Compressor threshold")
+#define THRESHOLD_LONGTEXT N_("The normalized peaks above this level are " \
+    "compressed, in dBFS.")
+
+#define RATIO_TEXT N_("Compressor ratio")
+#define RATIO_LONGTEXT N_("Set the ratio (n:1), 1 to disable the compressor.")
+
+vlc_module_begin()
+    set_shortname( N_("Loudness") )
+    set_description( N_("Loudness normalizer with a true peak limiter") )
+    set_capability( "audio filter", 0 )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+
+    add_float_with_range( "loudness-target", -18.f, -40.f, 0.f,
+                          TARGET_TEXT, TARGET_LONGTEXT, false )
+    add_float_with_range( "loudness-max-gain", 12.f, 0.f, 30.f,
+                          MAX_GAIN_TEXT, MAX_GAIN_LONGTEXT, false )
+    add_float_with_range( "loudness-ceiling", -1.f, -12.f, 0.f,
+                          CEILING_TEXT, CEILING_LONGTEXT, false )
+    add_float_with_range( "loudness-threshold", -10.f, -40.f, 0.f,
+                          THRESHOLD_TEXT, THRESHOLD_LONGTEXT, false )
+    add_float_with_range( "loudness-ratio", 2.f, 1.f, 20.f,
+                          RATIO_TEXT, RATIO_LONGTEXT, false )
+    set_callbacks( Open, Close )
+    add_shortcut( "loudness" )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+
+#define LOUDNESS_CHUNK   256  /* frames processed at a time */
+#define HOPS_PER_BLOCK   4    /* 100 ms hops of a 400 ms gating block */
+#define HIST_MIN         (-70.) /* absolute gate, LUFS */
+#define HIST_BINS        800  /* block loudness histogram, by 0.1 LU */
+#define RELATIVE_GATE    (-10.) /* LU */
+#define LOOKAHEAD        0.005 /* s */
+#define MIN_GAIN         (-30.f) /* dB */
+#define GAIN_SLEW        3.f  /* dB/s of the normalization gain */
+#define COMP_KNEE        6.f  /* dB */
+#define COMP_ATTACK      0.005 /* s */
+#define COMP_RELEASE     0.15  /* s */
+#define LIMIT_RELEASE    0.05  /* s */
+#define COMP_INTERVAL    16    /* frames between the compressor updates */
+
+/* The true peak is interpolated at 3 points between the samples n-6 and
+ * n-5, from the samples n-11 to n, as in BS.1770 annex 2. */
+#define TP_PHASES 3
+#define TP_TAPS   12
+#define TP_DELAY  (TP_TAPS / 2)
+
+/* K-weighting: 2 biquads, b0 b1 b2 a1 a2 each */
+#define KW_COEFFS 10
+
+/* The kernels process the lanes of the frames of stride lanes, from the
+ * given pointers on, and keep the state variables of a lane stride apart */
+typedef void (*kweight_fn)( const float *, float *, const float *, size_t,
+                            unsigned, unsigned, float * );
+typedef void (*true_peak_fn)( const float *, const float *, size_t,
+                              unsigned, unsigned, float * );
+
+typedef struct
+{
+    unsigned i_rate;
+    unsigned i_channels;
+    unsigned i_stride;   /* lanes per frame, the channels in vectors of 4 */
+    float   *p_lanes;    /* aligned storage of the arrays of lanes */
+
+    /* Measurement */
+    float    p_kcoeffs[KW_COEFFS];
+    float   *p_kstate;   /* 4 state variables of all the lanes */
+    float   *p_ksums;    /* squares of the lanes since the hop start */
+    float   *p_weights;  /* of the lanes in the loudness */
+    unsigned i_hop_frames, i_hop_left;
+    double   p_hops[HOPS_PER_BLOCK]; /* weighted mean squares */
+    unsigned i_hops;
+    double   p_hist_energy[HIST_BINS];
+    uint64_t p_hist_count[HIST_BINS];
+    kweight_fn pf_kweight;
+
+    /* Normalization */
+    float f_target, f_max_gain;
+    float f_gain;        /* dB, applied */
+    float f_gain_target; /* dB */
+    vlc_tick_t i_next_pts;
+
+    /* Dynamics */
+    unsigned i_look;     /* frames of look-ahead */
+    unsigned i_delay;    /* frames from the input to the output */
+    float   *p_delay;    /* i_delay + CHUNK frames of input samples */
+    float   *p_comp;     /* normalization and compressor gains of the same */
+    float    p_tp_coeffs[TP_PHASES * TP_TAPS];
+    float    p_peaks[LOUDNESS_CHUNK];
+    true_peak_fn pf_true_peak;
+
+    float f_threshold, f_slope; /* dB, and 1/ratio - 1 */
+    float f_comp_env, f_comp_gain;   /* of the last update, the gain in dB */
+    float f_comp_attack, f_comp_release; /* per update */
+    float f_comp_peak;   /* since the last update */
+    float f_comp_lin, f_comp_step;
+    unsigned i_comp_left;
+
+    float f_ceiling;
+    /* Sliding minimum of the limiter gains over i_look + 1 frames, in a
+     * ring of increasing gains */
+    struct limit_gain
+    {
+        uint64_t i_pos;
+        float    f_gain;
+    }       *p_min;
+    unsigned i_min_first, i_min_count, i_min_size;
+    uint64_t i_pos;
+    /* Moving average of their envelope over i_look frames */
+    float   *p_avg;
+    unsigned i_avg_pos;
+    double   f_avg_sum;
+    float    f_limit_env, f_limit_release;
+} filter_sys_t;
+
+/*****************************************************************************
+ * K-weighting, and the sums of the squares of the filtered samples
+ *****************************************************************************/
+
+static void KWeight_c( const float *restrict c, float *restrict state,
+                       const float *restrict x, size_t frames,
+                       unsigned stride, unsigned lanes, float *restrict sums )
+{
+    for( unsigned l = 0; l < lanes; l++ )
+    {
+        float z1 = state[l], z2 = state[stride + l];
+        float z3 = state[2 * stride + l], z4 = state[3 * stride + l];
+        float acc = 0.f;
+
+        for( size_t i = 0; i < frames; i++ )
+        {
+            const float u = x[i * stride + l];
+            const float v = c[0] * u + z1;
+            z1 = c[1] * u - c[3] * v + z2;
+            z2 = c[2] * u - c[4] * v;
+            const float y = c[5] * v + z3;
+            z3 = c[6] * v - c[8] * y + z4;
+            z4 = c[7] * v - c[9] * y;
+            acc += y * y;
+        }
+        state[l] = z1;
+        state[stride + l] = z2;
+        state[2 * stride + l] = z3;
+        state[3 * stride + l] = z4;
+        sums[l] += acc;
+    }
+}
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static void KWeight_sse( const float *restrict c, float *restrict state,
+                         const float *restrict x, size_t frames,
+                         unsigned stride, unsigned lanes, float *restrict sums )
+{
+    __m128 k[KW_COEFFS];
+
+    for( unsigned j = 0; j < KW_COEFFS; j++ )
+        k[j] = _mm_set1_ps( c[j] );
+
+    for( unsigned l = 0; l < lanes; l += 4 )
+    {
+        __m128 z1 = _mm_load_ps( &state[l] );
+        __m128 z2 = _mm_load_ps( &state[stride + l] );
+        __m128 z3 = _mm_load_ps( &state[2 * stride + l] );
+        __m128 z4 = _mm_load_ps( &state[3 * stride + l] );
+        __m128 acc = _mm_setzero_ps();
+
+        for( size_t i = 0; i < frames; i++ )
+        {
+            const __m128 u = _mm_load_ps( &x[i * stride + l] );
+            const __m128 v = _mm_add_ps( _mm_mul_ps( k[0], u ), z1 );
+            z1 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( k[1], u ),
+                                         _mm_mul_ps( k[3], v ) ), z2 );
+            z2 = _mm_sub_ps( _mm_mul_ps( k[2], u ), _mm_mul_ps( k[4], v ) );
+            const __m128 y = _mm_add_ps( _mm_mul_ps( k[5], v ), z3 );
+            z3 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( k[6], v ),
+                                         _mm_mul_ps( k[8], y ) ), z4 );
+            z4 = _mm_sub_ps( _mm_mul_ps( k[7], v ), _mm_mul_ps( k[9], y ) );
+            acc = _mm_add_ps( acc, _mm_mul_ps( y, y ) );
+        }
+        _mm_store_ps( &state[l], z1 );
+        _mm_store_ps( &state[stride + l], z2 );
+        _mm_store_ps( &state[2 * stride + l], z3 );
+        _mm_store_ps( &state[3 * stride + l], z4 );
+        _mm_store_ps( &sums[l], _mm_add_ps( _mm_load_ps( &sums[l] ), acc ) );
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static void KWeight_avx2( const float *restrict c, float *restrict state,
+                          const float *restrict x, size_t frames,
+                          unsigned stride, unsigned lanes, float *restrict sums )
+{
+    __m256 k[KW_COEFFS];
+    unsigned l = 0;
+
+    for( unsigned j = 0; j < KW_COEFFS; j++ )
+        k[j] = _mm256_set1_ps( c[j] );
+
+    for( ; l + 8 <= lanes; l += 8 )
+    {
+        __m256 z1 = _mm256_loadu_ps( &state[l] );
+        __m256 z2 = _mm256_loadu_ps( &state[stride + l] );
+        __m256 z3 = _mm256_loadu_ps( &state[2 * stride + l] );
+        __m256 z4 = _mm256_loadu_ps( &state[3 * stride + l] );
+        __m256 acc = _mm256_setzero_ps();
+
+        for( size_t i = 0; i < frames; i++ )
+        {
+            const __m256 u = _mm256_loadu_ps( &x[i * stride + l] );
+            const __m256 v = _mm256_add_ps( _mm256_mul_ps( k[0], u ), z1 );
+            z1 = _mm256_add_ps( _mm256_sub_ps( _mm256_mul_ps( k[1], u ),
+                                               _mm256_mul_ps( k[3], v ) ), z2 );
+            z2 = _mm256_sub_ps( _mm256_mul_ps( k[2], u ),
+                                _mm256_mul_ps( k[4], v ) );
+            const __m256 y = _mm256_add_ps( _mm256_mul_ps( k[5], v ), z3 );
+            z3 = _mm256_add_ps( _mm256_sub_ps( _mm256_mul_ps( k[6], v ),
+                                               _mm256_mul_ps( k[8], y ) ), z4 );
+            z4 = _mm256_sub_ps( _mm256_mul_ps( k[7], v ),
+                                _mm256_mul_ps( k[9], y ) );
+            acc = _mm256_add_ps( acc, _mm256_mul_ps( y, y ) );
+        }
+        _mm256_storeu_ps( &state[l], z1 );
+        _mm256_storeu_ps( &state[stride + l], z2 );
+        _mm256_storeu_ps( &state[2 * stride + l], z3 );
+        _mm256_storeu_ps( &state[3 * stride + l], z4 );
+        _mm256_storeu_ps( &sums[l],
+                          _mm256_add_ps( _mm256_loadu_ps( &sums[l] ), acc ) );
+    }
+
+    /* The last vector of an odd count */
+    if( l < lanes )
+        KWeight_sse( c, state + l, x + l, frames, stride, lanes - l,
+                     sums + l );
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void KWeight_neon( const float *restrict c, float *restrict state,
+                          const float *restrict x, size_t frames,
+                          unsigned stride, unsigned lanes, float *restrict sums )
+{
+    float32x4_t k[KW_COEFFS];
+
+    for( unsigned j = 0; j < KW_COEFFS; j++ )
+        k[j] = vdupq_n_f32( c[j] );
+
+    for( unsigned l = 0; l < lanes; l += 4 )
+    {
+        float32x4_t z1 = vld1q_f32( &state[l] );
+        float32x4_t z2 = vld1q_f32( &state[stride + l] );
+        float32x4_t z3 = vld1q_f32( &state[2 * stride + l] );
+        float32x4_t z4 = vld1q_f32( &state[3 * stride + l] );
+        float32x4_t acc = vdupq_n_f32( 0.f );
+
+        for( size_t i = 0; i < frames; i++ )
+        {
+            const float32x4_t u = vld1q_f32( &x[i * stride + l] );
+            const float32x4_t v = vmlaq_f32( z1, k[0], u );
+            z1 = vaddq_f32( vmlsq_f32( vmulq_f32( k[1], u ), k[3], v ), z2 );
+            z2 = vmlsq_f32( vmulq_f32( k[2], u ), k[4], v );
+            const float32x4_t y = vmlaq_f32( z3, k[5], v );
+            z3 = vaddq_f32( vmlsq_f32( vmulq_f32( k[6], v ), k[8], y ), z4 );
+            z4 = vmlsq_f32( vmulq_f32( k[7], v ), k[9], y );
+            acc = vmlaq_f32( acc, y, y );
+        }
+        vst1q_f32( &state[l], z1 );
+        vst1q_f32( &state[stride + l], z2 );
+        vst1q_f32( &state[2 * stride + l], z3 );
+        vst1q_f32( &state[3 * stride + l], z4 );
+        vst1q_f32( &sums[l], vaddq_f32( vld1q_f32( &sums[l] ), acc ) );
+    }
+}
+#endif
+
+/*****************************************************************************
+ * True peaks: the largest sample or interpolated value of the frames
+ *****************************************************************************/
+
+static void TruePeak_c( const float *restrict h, const float *restrict x,
+                        size_t frames, unsigned stride, unsigned lanes,
+                        float *restrict peaks )
+{
+    for( size_t i = 0; i < frames; i++ )
+    {
+        const float *frame = x + i * stride;
+        float peak = peaks[i];
+
+        for( unsigned l = 0; l < lanes; l++ )
+        {
+            peak = __MAX( peak, fabsf( ( frame - TP_DELAY * stride )[l] ) );
+            for( unsigned p = 0; p < TP_PHASES; p++ )
+            {
+                float acc = 0.f;
+                for( unsigned k = 0; k < TP_TAPS; k++ )
+                    acc += h[p * TP_TAPS + k] * ( frame - k * stride )[l];
+                peak = __MAX( peak, fabsf( acc ) );
+            }
+        }
+        peaks[i] = peak;
+    }
+}
+
+/* The SIMD versions interpolate 2 frames at a time, for enough independent
+ * sums to hide the latency of the additions */
+#define TP_FRAMES 2
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static inline float TruePeakMax_sse( __m128 s, __m128 a, __m128 b, __m128 c )
+{
+    const __m128 sign = _mm_set1_ps( -0.f );
+    __m128 peak = _mm_max_ps( _mm_andnot_ps( sign, s ),
+                              _mm_andnot_ps( sign, a ) );
+    peak = _mm_max_ps( peak, _mm_max_ps( _mm_andnot_ps( sign, b ),
+                                         _mm_andnot_ps( sign, c ) ) );
+    peak = _mm_max_ps( peak, _mm_movehl_ps( peak, peak ) );
+    peak = _mm_max_ss( peak, _mm_shuffle_ps( peak, peak, 1 ) );
+    return _mm_cvtss_f32( peak );
+}
+
+VLC_SSE
+static void TruePeak_sse( const float *restrict h, const float *restrict x,
+                          size_t frames, unsigned stride, unsigned lanes,
+                          float *restrict peaks )
+{
+    for( unsigned l = 0; l < lanes; l += 4 )
+        for( size_t i = 0; i < frames; i += TP_FRAMES )
+        {
+            const float *frame = x + i * stride + l;
+            __m128 a0 = _mm_setzero_ps(), a1 = a0, a2 = a0;
+            __m128 b0 = a0, b1 = a0, b2 = a0;
+
+            for( unsigned k = 0; k < TP_TAPS; k++ )
+            {
+                const __m128 h0 = _mm_set1_ps( h[k] );
+                const __m128 h1 = _mm_set1_ps( h[TP_TAPS + k] );
+                const __m128 h2 = _mm_set1_ps( h[2 * TP_TAPS + k] );
+                const __m128 s = _mm_load_ps( frame - k * stride );
+                const __m128 t = _mm_load_ps( frame + stride - k * stride );
+
+                a0 = _mm_add_ps( a0, _mm_mul_ps( h0, s ) );
+                a1 = _mm_add_ps( a1, _mm_mul_ps( h1, s ) );
+                a2 = _mm_add_ps( a2, _mm_mul_ps( h2, s ) );
+                b0 = _mm_add_ps( b0, _mm_mul_ps( h0, t ) );
+                b1 = _mm_add_ps( b1, _mm_mul_ps( h1, t ) );
+                b2 = _mm_add_ps( b2, _mm_mul_ps( h2, t ) );
+            }
+
+            const float *sample = frame - TP_DELAY * stride;
+            peaks[i] = __MAX( peaks[i], TruePeakMax_sse(
+                                  _mm_load_ps( sample ), a0, a1, a2 ) );
+            if( i + 1 < frames )
+                peaks[i + 1] = __MAX( peaks[i + 1], TruePeakMax_sse(
+                                  _mm_load_ps( sample + stride ), b0, b1, b2 ) );
+        }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static inline float TruePeakMax_avx2( __m256 s, __m256 a, __m256 b, __m256 c )
+{
+    const __m256 sign = _mm256_set1_ps( -0.f );
+    __m256 peak = _mm256_max_ps( _mm256_andnot_ps( sign, s ),
+                                 _mm256_andnot_ps( sign, a ) );
+    peak = _mm256_max_ps( peak, _mm256_max_ps( _mm256_andnot_ps( sign, b ),
+                                               _mm256_andnot_ps( sign, c ) ) );
+    __m128 half = _mm_max_ps( _mm256_castps256_ps128( peak ),
+                              _mm256_extractf128_ps( peak, 1 ) );
+    half = _mm_max_ps( half, _mm_movehl_ps( half, half ) );
+    half = _mm_max_ss( half, _mm_shuffle_ps( half, half, 1 ) );
+    return _mm_cvtss_f32( half );
+}
+
+VLC_AVX2
+static void TruePeak_avx2( const float *restrict h, const float *restrict x,
+                           size_t frames, unsigned stride, unsigned lanes,
+                           float *restrict peaks )
+{
+    unsigned l = 0;
+
+    for( ; l + 8 <= lanes; l += 8 )
+        for( size_t i = 0; i < frames; i += TP_FRAMES )
+        {
+            const float *frame = x + i * stride + l;
+            __m256 a0 = _mm256_setzero_ps(), a1 = a0, a2 = a0;
+            __m256 b0 = a0, b1 = a0, b2 = a0;
+
+            for( unsigned k = 0; k < TP_TAPS; k++ )
+            {
+                const __m256 h0 = _mm256_set1_ps( h[k] );
+                const __m256 h1 = _mm256_set1_ps( h[TP_TAPS + k] );
+                const __m256 h2 = _mm256_set1_ps( h[2 * TP_TAPS + k] );
+                const __m256 s = _mm256_loadu_ps( frame - k * stride );
+                const __m256 t = _mm256_loadu_ps( frame + stride - k * stride );
+
+                a0 = _mm256_add_ps( a0, _mm256_mul_ps( h0, s ) );
+                a1 = _mm256_add_ps( a1, _mm256_mul_ps( h1, s ) );
+                a2 = _mm256_add_ps( a2, _mm256_mul_ps( h2, s ) );
+                b0 = _mm256_add_ps( b0, _mm256_mul_ps( h0, t ) );
+                b1 = _mm256_add_ps( b1, _mm256_mul_ps( h1, t ) );
+                b2 = _mm256_add_ps( b2, _mm256_mul_ps( h2, t ) );
+            }
+
+            const float *sample = frame - TP_DELAY * stride;
+            peaks[i] = __MAX( peaks[i], TruePeakMax_avx2(
+                                  _mm256_loadu_ps( sample ), a0, a1, a2 ) );
+            if( i + 1 < frames )
+                peaks[i + 1] = __MAX( peaks[i + 1], TruePeakMax_avx2(
+                            _mm256_loadu_ps( sample + stride ), b0, b1, b2 ) );
+        }
+
+    /* The last vector of an odd count */
+    if( l < lanes )
+        TruePeak_sse( h, x + l, frames, stride, lanes - l, peaks );
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static inline float TruePeakMax_neon( float32x4_t s, float32x4_t a,
+                                      float32x4_t b, float32x4_t c )
+{
+    const float32x4_t peak = vmaxq_f32( vmaxq_f32( vabsq_f32( s ),
+                                                   vabsq_f32( a ) ),
+                                        vmaxq_f32( vabsq_f32( b ),
+                                                   vabsq_f32( c ) ) );
+    return vmaxvq_f32( peak );
+}
+
+static void TruePeak_neon( const float *restrict h, const float *restrict x,
+                           size_t frames, unsigned stride, unsigned lanes,
+                           float *restrict peaks )
+{
+    for( unsigned l = 0; l < lanes; l += 4 )
+        for( size_t i = 0; i < frames; i += TP_FRAMES )
+        {
+            const float *frame = x + i * stride + l;
+            float32x4_t a0 = vdupq_n_f32( 0.f ), a1 = a0, a2 = a0;
+            float32x4_t b0 = a0, b1 = a0, b2 = a0;
+
+            for( unsigned k = 0; k < TP_TAPS; k++ )
+            {
+                const float32x4_t s = vld1q_f32( frame - k * stride );
+                const float32x4_t t = vld1q_f32( frame + stride - k * stride );
+
+                a0 = vmlaq_n_f32( a0, s, h[k] );
+                a1 = vmlaq_n_f32( a1, s, h[TP_TAPS + k] );
+                a2 = vmlaq_n_f32( a2, s, h[2 * TP_TAPS + k] );
+                b0 = vmlaq_n_f32( b0, t, h[k] );
+                b1 = vmlaq_n_f32( b1, t, h[TP_TAPS + k] );
+                b2 = vmlaq_n_f32( b2, t, h[2 * TP_TAPS + k] );
+            }
+
+            const float *sample = frame - TP_DELAY * stride;
+            peaks[i] = __MAX( peaks[i], TruePeakMax_neon(
+                                  vld1q_f32( sample ), a0, a1, a2 ) );
+            if( i + 1 < frames )
+                peaks[i + 1] = __MAX( peaks[i + 1], TruePeakMax_neon(
+                                  vld1q_f32( sample + stride ), b0, b1, b2 ) );
+        }
+}
+#endif
+
+/*****************************************************************************
+ * Measurement
+ *****************************************************************************/
+
+/* Add up the last hop and, once per block, the integrated loudness */
+static void EndHop( filter_sys_t *p_sys )
+{
+    double energy = 0.;
+
+    for( unsigned l = 0; l < p_sys->i_stride; l++ )
+    {
+        energy += p_sys->p_weights[l] * p_sys->p_ksums[l];
+        p_sys->p_ksums[l] = 0.f;
+    }
+    memmove( &p_sys->p_hops[0], &p_sys->p_hops[1],
+             ( HOPS_PER_BLOCK - 1 ) * sizeof (double) );
+    p_sys->p_hops[HOPS_PER_BLOCK - 1] = energy / p_sys->i_hop_frames;
+    p_sys->i_hop_left = p_sys->i_hop_frames;
+
+    if( p_sys->i_hops < HOPS_PER_BLOCK
+     && ++p_sys->i_hops < HOPS_PER_BLOCK )
+        return;
+
+    double block = 0.;
+    for( unsigned i = 0; i < HOPS_PER_BLOCK; i++ )
+        block += p_sys->p_hops[i];
+    block /= HOPS_PER_BLOCK;
+
+    /* Under the absolute gate, and silence, do not count */
+    const double loudness = -0.691 + 10. * log10( block );
+    if( !( loudness > HIST_MIN ) )
+        return;
+
+    unsigned bin = ( loudness - HIST_MIN ) * 10.;
+    if( bin >= HIST_BINS )
+        bin = HIST_BINS - 1;
+    p_sys->p_hist_energy[bin] += block;
+    p_sys->p_hist_count[bin]++;
+
+    /* The relative gate, then the loudness of the blocks above it */
+    double sum = 0.;
+    uint64_t count = 0;
+    for( unsigned i = 0; i < HIST_BINS; i++ )
+    {
+        sum += p_sys->p_hist_energy[i];
+        count += p_sys->p_hist_count[i];
+    }
+
+    const double gate = -0.691 + 10. * log10( sum / count ) + RELATIVE_GATE;
+    unsigned first = 0;
+    if( gate > HIST_MIN )
+        first = ( gate - HIST_MIN ) * 10.;
+
+    sum = 0.;
+    count = 0;
+    for( unsigned i = first; i < HIST_BINS; i++ )
+    {
+        sum += p_sys->p_hist_energy[i];
+        count += p_sys->p_hist_count[i];
+    }
+
+    const float integrated = -0.691 + 10. * log10( sum / count );
+    p_sys->f_gain_target = VLC_CLIP( p_sys->f_target - integrated,
+                                     MIN_GAIN, p_sys->f_max_gain );
+}
+
+/*****************************************************************************
+ * Dynamics
+ *****************************************************************************/
+
+/* The minimum of the gains of the last i_look + 1 frames */
+static float SlidingMin( filter_sys_t *p_sys, float f_gain )
+{
+    const uint64_t pos = p_sys->i_pos++;
+    const unsigned size = p_sys->i_min_size;
+    struct limit_gain *ring = p_sys->p_min;
+
+    /* the ring indexes wrap without a division, at every frame */
+    unsigned last = p_sys->i_min_first + p_sys->i_min_count;
+    if( last >= size )
+        last -= size;
+    while( p_sys->i_min_count > 0 )
+    {
+        const unsigned prev = last == 0 ? size - 1 : last - 1;
+        if( ring[prev].f_gain < f_gain )
+            break;
+        last = prev;
+        p_sys->i_min_count--;
+    }
+
+    ring[last].i_pos = pos;
+    ring[last].f_gain = f_gain;
+    p_sys->i_min_count++;
+
+    if( ring[p_sys->i_min_first].i_pos + p_sys->i_look + 1 <= pos )
+    {
+        if( ++p_sys->i_min_first == size )
+            p_sys->i_min_first = 0;
+        p_sys->i_min_count--;
+    }
+    return ring[p_sys->i_min_first].f_gain;
+}
+
+/* The compressor gain, from the peaks since the last update, ramps from
+ * its last value to the new one until the next update */
+static void CompressorUpdate( filter_sys_t *p_sys )
+{
+    float gain = 0.f;
+    float env = p_sys->f_comp_env * p_sys->f_comp_release;
+
+    if( p_sys->f_comp_peak > env )
+        env = p_sys->f_comp_peak;
+    p_sys->f_comp_env = env;
+    p_sys->f_comp_peak = 0.f;
+    p_sys->i_comp_left = COMP_INTERVAL;
+
+    const float over = env > 1e-6f ? 20.f * log10f( env ) - p_sys->f_threshold
+                                   : -120.f;
+    if( 2.f * over >= COMP_KNEE )
+        gain = p_sys->f_slope * over;
+    else if( 2.f * over > -COMP_KNEE )
+    {
+        const float knee = over + COMP_KNEE / 2.f;
+        gain = p_sys->f_slope * knee * knee / ( 2.f * COMP_KNEE );
+    }
+    /* the envelope releases, the gain attacks */
+    if( gain < p_sys->f_comp_gain )
+        gain = p_sys->f_comp_gain
+             + ( gain - p_sys->f_comp_gain ) * p_sys->f_comp_attack;
+    p_sys->f_comp_gain = gain;
+    p_sys->f_comp_step = ( powf( 10.f, gain / 20.f ) - p_sys->f_comp_lin )
+                       / COMP_INTERVAL;
+}
+
+/* The gains of the n frames of the peaks, from the normalization gain of
+ * the first one and its increment */
+static void GainComputer( filter_sys_t *p_sys, size_t n, float g0, float dg )
+{
+    const double avg_scale = 1. / p_sys->i_look;
+
+    for( size_t i = 0; i < n; i++ )
+    {
+        /* The normalization and compressor gains of the sample at the peak */
+        float gain = g0 + dg * ( i + 1 );
+        const float peak = p_sys->p_peaks[i] * gain;
+
+        if( p_sys->f_slope < 0.f )
+        {
+            if( p_sys->i_comp_left == 0 )
+                CompressorUpdate( p_sys );
+            p_sys->f_comp_peak = __MAX( p_sys->f_comp_peak, peak );
+            p_sys->i_comp_left--;
+            p_sys->f_comp_lin += p_sys->f_comp_step;
+            gain *= p_sys->f_comp_lin;
+        }
+        p_sys->p_comp[p_sys->i_delay + i - TP_DELAY] = gain;
+
+        /* The limiter takes the smallest gain of the look-ahead, releases it
+         * exponentially and averages it over the look-ahead: the gain of each
+         * sample is under the ones of its peak and of its previous one. */
+        const float level = p_sys->p_peaks[i] * gain;
+        const float min = SlidingMin( p_sys, level > p_sys->f_ceiling
+                                             ? p_sys->f_ceiling / level : 1.f );
+        float env = p_sys->f_limit_env;
+        env = min < env ? min : min - ( min - env ) * p_sys->f_limit_release;
+        p_sys->f_limit_env = env;
+
+        p_sys->f_avg_sum += env - p_sys->p_avg[p_sys->i_avg_pos];
+        p_sys->p_avg[p_sys->i_avg_pos] = env;
+        if( ++p_sys->i_avg_pos == p_sys->i_look )
+        {
+            /* Do not let the rounding errors add up */
+            p_sys->i_avg_pos = 0;
+            p_sys->f_avg_sum = 0.;
+            for( unsigned j = 0; j < p_sys->i_look; j++ )
+                p_sys->f_avg_sum += p_sys->p_avg[j];
+        }
+
+        /* The total gain of the output frame */
+        p_sys->p_peaks[i] = p_sys->p_comp[i] * p_sys->f_avg_sum * avg_scale;
+    }
+}
+
+/*****************************************************************************
+ * Processing
+ *****************************************************************************/
+
+static void ProcessChunk( filter_sys_t *p_sys, const float *p_in,
+                          float *p_out, size_t n )
+{
+    const unsigned i_channels = p_sys->i_channels;
+    const unsigned i_stride = p_sys->i_stride;
+    float *x = p_sys->p_delay + (size_t)p_sys->i_delay * i_stride;
+
+    /* The padding lanes stay silent */
+    for( size_t i = 0; i < n; i++ )
+        for( unsigned c = 0; c < i_channels; c++ )
+            x[i * i_stride + c] = p_in[i * i_channels + c];
+
+    p_sys->pf_kweight( p_sys->p_kcoeffs, p_sys->p_kstate, x, n, i_stride,
+                       i_stride, p_sys->p_ksums );
+    p_sys->i_hop_left -= n;
+    if( p_sys->i_hop_left == 0 )
+        EndHop( p_sys );
+
+    /* The normalization gain ramps of GAIN_SLEW at most */
+    const float slew = GAIN_SLEW * n / p_sys->i_rate;
+    const float delta = VLC_CLIP( p_sys->f_gain_target - p_sys->f_gain,
+                                  -slew, slew );
+    const float g0 = powf( 10.f, p_sys->f_gain / 20.f );
+    p_sys->f_gain += delta;
+    const float g1 = powf( 10.f, p_sys->f_gain / 20.f );
+
+    memset( p_sys->p_peaks, 0, n * sizeof (float) );
+    p_sys->pf_true_peak( p_sys->p_tp_coeffs, x, n, i_stride, i_stride,
+                         p_sys->p_peaks );
+    GainComputer( p_sys, n, g0, ( g1 - g0 ) / n );
+
+    for( size_t i = 0; i < n; i++ )
+    {
+        const float g = p_sys->p_peaks[i];
+        for( unsigned c = 0; c < i_channels; c++ )
+            p_out[i * i_channels + c] = p_sys->p_delay[i * i_stride + c] * g;
+    }
+
+    memmove( p_sys->p_delay, p_sys->p_delay + n * i_stride,
+             (size_t)p_sys->i_delay * i_stride * sizeof (float) );
+    memmove( p_sys->p_comp, p_sys->p_comp + n,
+             p_sys->i_delay * sizeof (float) );
+}
+
+static void Process( filter_sys_t *p_sys, const float *p_in, float *p_out,
+                     size_t i_frames )
+{
+    const unsigned i_channels = p_sys->i_channels;
+
+    while( i_frames > 0 )
+    {
+        size_t n = __MIN( i_frames, LOUDNESS_CHUNK );
+        n = __MIN( n, p_sys->i_hop_left );
+
+        ProcessChunk( p_sys, p_in, p_out, n );
+        p_in += n * i_channels;
+        p_out += n * i_channels;
+        i_frames -= n;
+    }
+}
+
+static block_t *DoWork( filter_t *p_filter, block_t *p_block )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    float *p_samples = (float *)p_block->p_buffer;
+
+    Process( p_sys, p_samples, p_samples, p_block->i_nb_samples );
+    if( p_block->i_pts != VLC_TICK_INVALID )
+        p_sys->i_next_pts = p_block->i_pts
+                          + vlc_tick_from_samples( p_block->i_nb_samples,
+                                                   p_sys->i_rate );
+    return p_block;
+}
+
+static void ResetDynamics( filter_sys_t *p_sys )
+{
+    memset( p_sys->p_delay, 0, (size_t)p_sys->i_delay * p_sys->i_stride
+                               * sizeof (float) );
+    memset( p_sys->p_kstate, 0, 4 * p_sys->i_stride * sizeof (float) );
+    for( unsigned i = 0; i < p_sys->i_delay + LOUDNESS_CHUNK; i++ )
+        p_sys->p_comp[i] = 1.f;
+    p_sys->f_comp_env = 0.f;
+    p_sys->f_comp_gain = 0.f;
+    p_sys->f_comp_peak = 0.f;
+    p_sys->f_comp_lin = 1.f;
+    p_sys->f_comp_step = 0.f;
+    p_sys->i_comp_left = 0;
+
+    p_sys->i_min_first = 0;
+    p_sys->i_min_count = 0;
+    for( unsigned i = 0; i < p_sys->i_look; i++ )
+        p_sys->p_avg[i] = 1.f;
+    p_sys->i_avg_pos = 0;
+    p_sys->f_avg_sum = p_sys->i_look;
+    p_sys->f_limit_env = 1.f;
+    p_sys->i_next_pts = VLC_TICK_INVALID;
+}
+
+/* The loudness of the program still holds after a seek */
+static void Flush( filter_t *p_filter )
+{
+    ResetDynamics( p_filter->p_sys );
+}
+
+/* Push the delayed frames out */
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const size_t i_frames = p_sys->i_delay;
+    block_t *p_block = block_Alloc( i_frames * p_sys->i_channels
+                                    * sizeof (float) );
+    if( p_block == NULL )
+        return NULL;
+
+    memset( p_block->p_buffer, 0, p_block->i_buffer );
+    p_block->i_nb_samples = i_frames;
+    p_block->i_pts = p_block->i_dts = p_sys->i_next_pts;
+    p_block->i_length = vlc_tick_from_samples( i_frames, p_sys->i_rate );
+    p_block = DoWork( p_filter, p_block );
+    ResetDynamics( p_sys );
+    return p_block;
+}
+
+/*****************************************************************************
+ * Open: initialize the filter
+ *****************************************************************************/
+
+/* Biquad of a shelf or a high pass, as in BS.1770, at any rate */
+static void KWeightInit( float *c, unsigned i_rate )
+{
+    /* high shelf of +4 dB at high frequencies */
+    double f0 = 1681.974450955533, Q = 0.7071752369554196;
+    const double G = 3.999843853973347;
+    double K = tan( M_PI * f0 / i_rate );
+    const double Vh = pow( 10., G / 20. );
+    const double Vb = pow( Vh, 0.4996667741545416 );
+    double a0 = 1. + K / Q + K * K;
+
+    c[0] = ( Vh + Vb * K / Q + K * K ) / a0;
+    c[1] = 2. * ( K * K - Vh ) / a0;
+    c[2] = ( Vh - Vb * K / Q + K * K ) / a0;
+    c[3] = 2. * ( K * K - 1. ) / a0;
+    c[4] = ( 1. - K / Q + K * K ) / a0;
+
+    /* revised low frequency B-curve high pass */
+    f0 = 38.13547087602444;
+    Q = 0.5003270373238773;
+    K = tan( M_PI * f0 / i_rate );
+    a0 = 1. + K / Q + K * K;
+
+    c[5] = 1.;
+    c[6] = -2.;
+    c[7] = 1.;
+    c[8] = 2. * ( K * K - 1. ) / a0;
+    c[9] = ( 1. - K / Q + K * K ) / a0;
+}
+
+/* Windowed sinc interpolation at the quarters between 2 samples */
+static void TruePeakInit( float *h )
+{
+    for( unsigned p = 0; p < TP_PHASES; p++ )
+    {
+        double sum = 0.;
+        double taps[TP_TAPS];
+
+        for( unsigned k = 0; k < TP_TAPS; k++ )
+        {
+            const double t = (double)TP_DELAY - k - ( p + 1 ) / 4.;
+            const double w = cos( M_PI * t / ( TP_TAPS + 1 ) );
+            taps[k] = ( t != 0. ? sin( M_PI * t ) / ( M_PI * t ) : 1. )
+                    * w * w;
+            sum += taps[k];
+        }
+        for( unsigned k = 0; k < TP_TAPS; k++ )
+            h[p * TP_TAPS + k] = taps[k] / sum;
+    }
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    vlc_object_t *p_aout = vlc_object_parent(p_filter);
+    const unsigned i_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+
+    if( i_rate == 0 || i_channels == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof (*p_sys) );
+    if( p_sys == NULL )
+        return VLC_ENOMEM;
+
+    p_sys->i_rate = i_rate;
+    p_sys->i_channels = i_channels;
+    p_sys->i_stride = ( i_channels + 3 ) & ~3u;
+    p_sys->i_hop_frames = p_sys->i_hop_left = ( i_rate + 5 ) / 10;
+    p_sys->i_look = __MAX( lround( LOOKAHEAD * i_rate ), TP_TAPS );
+    p_sys->i_delay = p_sys->i_look + TP_DELAY - 1;
+
+    const unsigned i_stride = p_sys->i_stride;
+    /* the true peak kernels may read a few frames past the chunk */
+    const size_t i_lanes = ( 4 + 1 + 1 + p_sys->i_delay + LOUDNESS_CHUNK
+                             + TP_FRAMES ) * (size_t)i_stride;
+    p_sys->p_lanes = aligned_alloc( 32, ( i_lanes * sizeof (float) + 31 )
+                                        & ~(size_t)31 );
+    p_sys->p_comp = vlc_alloc( p_sys->i_delay + LOUDNESS_CHUNK,
+                               sizeof (float) );
+    p_sys->i_min_size = p_sys->i_look + 2;
+    p_sys->p_min = vlc_alloc( p_sys->i_min_size, sizeof (*p_sys->p_min) );
+    p_sys->p_avg = vlc_alloc( p_sys->i_look, sizeof (float) );
+    if( p_sys->p_lanes == NULL || p_sys->p_comp == NULL
+     || p_sys->p_min == NULL || p_sys->p_avg == NULL )
+    {
+        aligned_free( p_sys->p_lanes );
+        free( p_sys->p_comp );
+        free( p_sys->p_min );
+        free( p_sys->p_avg );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    memset( p_sys->p_lanes, 0, i_lanes * sizeof (float) );
+    p_sys->p_kstate = p_sys->p_lanes;
+    p_sys->p_ksums = p_sys->p_kstate + 4 * i_stride;
+    p_sys->p_weights = p_sys->p_ksums + i_stride;
+    p_sys->p_delay = p_sys->p_weights + i_stride;
+
+    /* The surround channels weigh +1.5 dB, the LFE does not count */
+    const uint32_t i_physical = p_filter->fmt_in.audio.i_physical_channels;
+    unsigned c = 0;
+    for( unsigned i = 0; pi_vlc_chan_order_wg4[i] != 0; i++ )
+    {
+        const uint32_t chan = pi_vlc_chan_order_wg4[i];
+        if( !( i_physical & chan ) )
+            continue;
+        if( chan == AOUT_CHAN_LFE )
+            p_sys->p_weights[c] = 0.f;
+        else if( chan & ( AOUT_CHANS_FRONT | AOUT_CHAN_CENTER ) )
+            p_sys->p_weights[c] = 1.f;
+        else
+            p_sys->p_weights[c] = 1.41f;
+        c++;
+    }
+    for( ; c < i_channels; c++ ) /* not in the physical channels */
+        p_sys->p_weights[c] = 1.f;
+
+    KWeightInit( p_sys->p_kcoeffs, i_rate );
+    TruePeakInit( p_sys->p_tp_coeffs );
+
+    p_sys->f_target = var_CreateGetFloat( p_aout, "loudness-target" );
+    p_sys->f_max_gain = var_CreateGetFloat( p_aout, "loudness-max-gain" );
+    p_sys->f_ceiling = powf( 10.f, var_CreateGetFloat( p_aout,
+                                            "loudness-ceiling" ) / 20.f );
+    p_sys->f_threshold = var_CreateGetFloat( p_aout, "loudness-threshold" );
+    const float f_ratio = var_CreateGetFloat( p_aout, "loudness-ratio" );
+    p_sys->f_slope = f_ratio > 1.f ? 1.f / f_ratio - 1.f : 0.f;
+    p_sys->f_comp_attack = -expm1( -COMP_INTERVAL / ( COMP_ATTACK * i_rate ) );
+    p_sys->f_comp_release = exp( -COMP_INTERVAL / ( COMP_RELEASE * i_rate ) );
+    p_sys->f_limit_release = exp( -1. / ( LIMIT_RELEASE * i_rate ) );
+    ResetDynamics( p_sys );
+
+    p_sys->pf_kweight = KWeight_c;
+    p_sys->pf_true_peak = TruePeak_c;
+#ifdef CAN_COMPILE_SSE
+    if( vlc_CPU_SSE() )
+    {
+        p_sys->pf_kweight = KWeight_sse;
+        p_sys->pf_true_peak = TruePeak_sse;
+    }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_kweight = KWeight_avx2;
+        p_sys->pf_true_peak = TruePeak_avx2;
+    }
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+    {
+        p_sys->pf_kweight = KWeight_neon;
+        p_sys->pf_true_peak = TruePeak_neon;
+    }
+#endif
+
+    p_filter->p_sys = p_sys;
+    p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare( &p_filter->fmt_in.audio );
+    p_filter->fmt_out.audio = p_filter->fmt_in.audio;
+    p_filter->pf_audio_filter = DoWork;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+
+    msg_Dbg( p_filter, "loudness target %.1f LUFS, %u frames of look-ahead",
+             p_sys->f_target, p_sys->i_look );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close: destroy the filter
+ *****************************************************************************/
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    aligned_free( p_sys->p_lanes );
+    free( p_sys->p_comp );
+    free( p_sys->p_min );
+    free( p_sys->p_avg );
+    free( p_sys );
+}
@@ -0,0 +1,751 @@
+/*****************************************************************************
+ * polyphase.c : polyphase windowed-sinc audio resampler
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************
+ * The output samples are inner products of the input with a Kaiser windowed
+ * sinc, whose phases are computed once in a bank: for a ratio of out/in
+ * rates reduced to L/M, a bank of a multiple of L phases holds every phase
+ * the conversion needs. A position between two phases, which the small rate
+ * changes of the audio output synchronization give, is the linear
+ * interpolation of the products of both phases.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+static int  OpenConverter( vlc_object_t * );
+static int  OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define QUALITY_TEXT N_("Resampling quality")
+#define QUALITY_LONGTEXT N_("Resampling quality: the higher, the longer " \
+    "the filter, the flatter the pass band and the lower the aliasing.")
+
+static const int quality_values[] = { 0, 1, 2 };
+static const char *const quality_texts[] = {
+    N_("Low"), N_("Medium"), N_("High"),
+};
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_shortname( N_("Polyphase") )
+    set_description( N_("Polyphase windowed-sinc audio resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    add_integer( "polyphase-resampler-quality", 1,
+                 QUALITY_TEXT, QUALITY_LONGTEXT, true )
+        change_integer_list( quality_values, quality_texts )
+    set_capability( "audio converter", 30 )
+    set_callbacks( OpenConverter, Close )
+
+    add_submodule()
+    set_capability( "audio resampler", 30 )
+    set_callbacks( OpenResampler, Close )
+    add_shortcut( "polyphase" )
+vlc_module_end ()
+
+/* Taps of the filter when upsampling, the cutoff relative to the lowest
+ * Nyquist frequency, the beta of the Kaiser window, and the phases of a bank
+ * at least: the stop band is about 65, 90 and 110 dB down. */
+static const struct
+{
+    unsigned taps;
+    double   rolloff;
+    double   beta;
+    unsigned phases;
+} tiers[] = {
+    { 16, .85,  6.0,  64 },
+    { 32, .91,  8.6, 128 },
+    { 64, .95, 11.0, 256 },
+};
+
+/* Beyond that many phases per reduced ratio, the bank is interpolated */
+#define MAX_EXACT_PHASES 1024
+/* The longest filter, for downsampling */
+#define MAX_TAPS 512
+/* The bank is designed again when its cutoff is this far off */
+#define CUTOFF_TOLERANCE .01
+/* Back at a rate that falls on the phases, the position moves to the nearest
+ * phase by this much per output sample at most, in 2^-32 of phase: a change
+ * of rate far below what anyone can hear, and no discontinuity. */
+#define PHASE_NUDGE (UINT32_C(1) << 20)
+
+struct bank
+{
+    unsigned in_rate;  /**< input rate the bank was designed for */
+    double   cutoff;   /**< relative to the input Nyquist frequency */
+    unsigned phases;   /**< phases per input sample */
+    bool     identity; /**< the first phase is a unit impulse */
+    float   *coefs;    /**< phases + 1 rows of taps, aligned */
+};
+
+/* One output sample: where it starts in the history, and which phases */
+struct resampler_step
+{
+    uint32_t offset;
+    uint32_t phase;
+    float    frac;     /**< 0 if the phase is exact */
+};
+
+typedef void (*resample_fn)( float *restrict, unsigned, const float *restrict,
+                             const float *restrict, unsigned,
+                             const struct resampler_step *, size_t );
+
+typedef struct
+{
+    unsigned taps;
+    unsigned channels;
+    unsigned out_rate;
+    unsigned quality;
+
+    struct bank  banks[2]; /**< the nominal one, and the last other one */
+    struct bank *bank;
+
+    float  *history;       /**< planar, stride floats per channel */
+    size_t  stride;
+    size_t  frames;        /**< frames in the history */
+    size_t  base;          /**< first frame of the next window */
+    uint64_t position;     /**< phase of the next window, 32.32 fixed point */
+
+    struct resampler_step *steps;
+    size_t  steps_size;
+
+    resample_fn resample;
+} filter_sys_t;
+
+/*****************************************************************************
+ * Inner products
+ *****************************************************************************/
+static inline float Dot_c( const float *x, const float *h, unsigned taps )
+{
+    float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f;
+
+    for( unsigned j = 0; j < taps; j += 4 )
+    {
+        a0 += x[j + 0] * h[j + 0];
+        a1 += x[j + 1] * h[j + 1];
+        a2 += x[j + 2] * h[j + 2];
+        a3 += x[j + 3] * h[j + 3];
+    }
+    return ( a0 + a1 ) + ( a2 + a3 );
+}
+
+static void Resample_c( float *restrict out, unsigned channels,
+                        const float *restrict x, const float *restrict coefs,
+                        unsigned taps, const struct resampler_step *steps,
+                        size_t count )
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        const struct resampler_step *s = &steps[i];
+        const float *h = &coefs[s->phase * taps];
+        const float a = Dot_c( &x[s->offset], h, taps );
+
+        if( s->frac == 0.f )
+            out[i * channels] = a;
+        else
+        {
+            const float b = Dot_c( &x[s->offset], h + taps, taps );
+            out[i * channels] = a + ( b - a ) * s->frac;
+        }
+    }
+}
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static inline float Sum_sse( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+}
+
+VLC_SSE
+static void Resample_sse( float *restrict out, unsigned channels,
+                          const float *restrict x, const float *restrict coefs,
+                          unsigned taps, const struct resampler_step *steps,
+                          size_t count )
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        const struct resampler_step *s = &steps[i];
+        const float *h = &coefs[s->phase * taps];
+        const float *in = &x[s->offset];
+
+        if( s->frac == 0.f )
+        {
+            __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+            for( unsigned j = 0; j < taps; j += 8 )
+            {
+                a0 = _mm_add_ps( a0, _mm_mul_ps( _mm_loadu_ps( &in[j] ),
+                                                 _mm_load_ps( &h[j] ) ) );
+                a1 = _mm_add_ps( a1, _mm_mul_ps( _mm_loadu_ps( &in[j + 4] ),
+                                                 _mm_load_ps( &h[j + 4] ) ) );
+            }
+            out[i * channels] = Sum_sse( _mm_add_ps( a0, a1 ) );
+        }
+        else
+        {
+            /* both phases at once, for one load of the input */
+            __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+            for( unsigned j = 0; j < taps; j += 4 )
+            {
+                const __m128 v = _mm_loadu_ps( &in[j] );
+                a = _mm_add_ps( a, _mm_mul_ps( v, _mm_load_ps( &h[j] ) ) );
+                b = _mm_add_ps( b, _mm_mul_ps( v,
+                                           _mm_load_ps( &h[taps + j] ) ) );
+            }
+            const float fa = Sum_sse( a ), fb = Sum_sse( b );
+            out[i * channels] = fa + ( fb - fa ) * s->frac;
+        }
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static inline float Sum_avx2( __m256 v )
+{
+    __m128 h = _mm_add_ps( _mm256_castps256_ps128( v ),
+                           _mm256_extractf128_ps( v, 1 ) );
+    h = _mm_add_ps( h, _mm_movehl_ps( h, h ) );
+    h = _mm_add_ss( h, _mm_shuffle_ps( h, h, 1 ) );
+    return _mm_cvtss_f32( h );
+}
+
+VLC_AVX2
+static void Resample_avx2( float *restrict out, unsigned channels,
+                           const float *restrict x, const float *restrict coefs,
+                           unsigned taps, const struct resampler_step *steps,
+                           size_t count )
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        const struct resampler_step *s = &steps[i];
+        const float *h = &coefs[s->phase * taps];
+        const float *in = &x[s->offset];
+
+        if( s->frac == 0.f )
+        {
+            __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+            unsigned j = 0;
+            for( ; j + 16 <= taps; j += 16 )
+            {
+                a0 = _mm256_add_ps( a0,
+                        _mm256_mul_ps( _mm256_loadu_ps( &in[j] ),
+                                       _mm256_load_ps( &h[j] ) ) );
+                a1 = _mm256_add_ps( a1,
+                        _mm256_mul_ps( _mm256_loadu_ps( &in[j + 8] ),
+                                       _mm256_load_ps( &h[j + 8] ) ) );
+            }
+            if( j < taps )
+                a0 = _mm256_add_ps( a0,
+                        _mm256_mul_ps( _mm256_loadu_ps( &in[j] ),
+                                       _mm256_load_ps( &h[j] ) ) );
+            out[i * channels] = Sum_avx2( _mm256_add_ps( a0, a1 ) );
+        }
+        else
+        {
+            __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+            for( unsigned j = 0; j < taps; j += 8 )
+            {
+                const __m256 v = _mm256_loadu_ps( &in[j] );
+                a = _mm256_add_ps( a,
+                        _mm256_mul_ps( v, _mm256_load_ps( &h[j] ) ) );
+                b = _mm256_add_ps( b,
+                        _mm256_mul_ps( v, _mm256_load_ps( &h[taps + j] ) ) );
+            }
+            const float fa = Sum_avx2( a ), fb = Sum_avx2( b );
+            out[i * channels] = fa + ( fb - fa ) * s->frac;
+        }
+    }
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void Resample_neon( float *restrict out, unsigned channels,
+                           const float *restrict x, const float *restrict coefs,
+                           unsigned taps, const struct resampler_step *steps,
+                           size_t count )
+{
+    for( size_t i = 0; i < count; i++ )
+    {
+        const struct resampler_step *s = &steps[i];
+        const float *h = &coefs[s->phase * taps];
+        const float *in = &x[s->offset];
+
+        if( s->frac == 0.f )
+        {
+            float32x4_t a0 = vdupq_n_f32( 0.f ), a1 = vdupq_n_f32( 0.f );
+            for( unsigned j = 0; j < taps; j += 8 )
+            {
+                a0 = vfmaq_f32( a0, vld1q_f32( &in[j] ), vld1q_f32( &h[j] ) );
+                a1 = vfmaq_f32( a1, vld1q_f32( &in[j + 4] ),
+                                vld1q_f32( &h[j + 4] ) );
+            }
+            out[i * channels] = vaddvq_f32( vaddq_f32( a0, a1 ) );
+        }
+        else
+        {
+            float32x4_t a = vdupq_n_f32( 0.f ), b = vdupq_n_f32( 0.f );
+            for( unsigned j = 0; j < taps; j += 4 )
+            {
+                const float32x4_t v = vld1q_f32( &in[j] );
+                a = vfmaq_f32( a, v, vld1q_f32( &h[j] ) );
+                b = vfmaq_f32( b, v, vld1q_f32( &h[taps + j] ) );
+            }
+            const float fa = vaddvq_f32( a ), fb = vaddvq_f32( b );
+            out[i * channels] = fa + ( fb - fa ) * s->frac;
+        }
+    }
+}
+#endif
+
+/*****************************************************************************
+ * Filter bank
+ *****************************************************************************/
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; term > sum * 1e-12; k++ )
+    {
+        const double t = x / ( 2. * k );
+        term *= t * t;
+        sum += term;
+    }
+    return sum;
+}
+
+static double Cutoff( const filter_sys_t *p_sys, unsigned in_rate,
+                      unsigned nominal_rate )
+{
+    const double cutoff = in_rate > p_sys->out_rate
+                        ? (double)p_sys->out_rate / in_rate : 1.;
+
+    /* Without a conversion, the resampler only corrects the drift, and
+     * passes the band through */
+    if( nominal_rate == p_sys->out_rate )
+        return cutoff;
+    return cutoff * tiers[p_sys->quality].rolloff;
+}
+
+static int BankInit( filter_sys_t *p_sys, struct bank *bank,
+                     unsigned in_rate, double cutoff )
+{
+    const unsigned taps = p_sys->taps;
+    const unsigned min_phases = tiers[p_sys->quality].phases;
+    const unsigned l = p_sys->out_rate / GCD( in_rate, p_sys->out_rate );
+    unsigned phases;
+
+    if( l <= MAX_EXACT_PHASES )
+        phases = l * ( ( min_phases + l - 1 ) / l );
+    else
+        phases = min_phases;
+
+    float *coefs = aligned_alloc( 32, ( phases + 1 ) * taps * sizeof (float) );
+    if( unlikely( coefs == NULL ) )
+        return VLC_ENOMEM;
+
+    const double beta = tiers[p_sys->quality].beta;
+    const double half = taps / 2.;
+    const double norm = BesselI0( beta );
+
+    for( unsigned p = 0; p <= phases; p++ )
+    {
+        float *h = &coefs[p * taps];
+        double sum = 0.;
+
+        for( unsigned j = 0; j < taps; j++ )
+        {
+            const double t = j - ( half - 1. ) - (double)p / phases;
+            const double r = t / half;
+            double v = 0.;
+
+            if( fabs( r ) < 1. )
+            {
+                const double x = M_PI * cutoff * t;
+                v = cutoff * ( t != 0. ? sin( x ) / x : 1. )
+                  * BesselI0( beta * sqrt( 1. - r * r ) ) / norm;
+            }
+            h[j] = v;
+            sum += v;
+        }
+        /* unity gain at DC on every phase */
+        for( unsigned j = 0; j < taps; j++ )
+            h[j] /= sum;
+    }
+
+    bank->identity = cutoff == 1.;
+    if( bank->identity )
+        for( unsigned j = 0; j < taps; j++ )
+            coefs[j] = j == taps / 2 - 1;
+
+    aligned_free( bank->coefs );
+    bank->coefs = coefs;
+    bank->in_rate = in_rate;
+    bank->cutoff = cutoff;
+    bank->phases = phases;
+    return VLC_SUCCESS;
+}
+
+/* Picks the bank for the current input rate, and moves the position to its
+ * phases */
+static int BankSelect( filter_t *p_filter, unsigned in_rate )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct bank *bank = p_sys->bank;
+    const double cutoff = Cutoff( p_sys, in_rate, p_sys->banks[0].in_rate );
+
+    if( fabs( cutoff - bank->cutoff ) <= bank->cutoff * CUTOFF_TOLERANCE )
+        return VLC_SUCCESS;
+
+    bank = &p_sys->banks[0];
+    if( fabs( cutoff - bank->cutoff ) > bank->cutoff * CUTOFF_TOLERANCE )
+    {
+        bank = &p_sys->banks[1];
+        if( bank->coefs == NULL
+         || fabs( cutoff - bank->cutoff ) > bank->cutoff * CUTOFF_TOLERANCE )
+        {
+            if( BankInit( p_sys, bank, in_rate, cutoff ) )
+                return VLC_ENOMEM;
+            msg_Dbg( p_filter, "filter bank of %u phases for %u Hz",
+                     bank->phases, in_rate );
+        }
+    }
+
+    p_sys->position = (double)p_sys->position * bank->phases
+                    / p_sys->bank->phases;
+    p_sys->bank = bank;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Resampling
+ *****************************************************************************/
+static void Reset( filter_sys_t *p_sys )
+{
+    /* The first output is centered on the first input sample */
+    p_sys->frames = p_sys->taps / 2 - 1;
+    p_sys->base = 0;
+    p_sys->position = 0;
+    for( unsigned c = 0; c < p_sys->channels; c++ )
+        memset( &p_sys->history[c * p_sys->stride], 0,
+                p_sys->frames * sizeof (float) );
+}
+
+static int Append( filter_sys_t *p_sys, const float *in, size_t count )
+{
+    if( p_sys->frames + count > p_sys->stride )
+    {
+        const size_t stride = p_sys->frames + count;
+        float *history = vlc_alloc( p_sys->channels,
+                                    stride * sizeof (float) );
+        if( unlikely( history == NULL ) )
+            return VLC_ENOMEM;
+        for( unsigned c = 0; c < p_sys->channels; c++ )
+            memcpy( &history[c * stride], &p_sys->history[c * p_sys->stride],
+                    p_sys->frames * sizeof (float) );
+        free( p_sys->history );
+        p_sys->history = history;
+        p_sys->stride = stride;
+    }
+
+    for( unsigned c = 0; c < p_sys->channels; c++ )
+    {
+        float *x = &p_sys->history[c * p_sys->stride + p_sys->frames];
+
+        if( in != NULL )
+            for( size_t i = 0; i < count; i++ )
+                x[i] = in[i * p_sys->channels + c];
+        else
+            memset( x, 0, count * sizeof (float) );
+    }
+    p_sys->frames += count;
+    return VLC_SUCCESS;
+}
+
+/* Lists the windows of the output samples that the history holds */
+static size_t Schedule( filter_sys_t *p_sys, unsigned in_rate, size_t max )
+{
+    const unsigned phases = p_sys->bank->phases;
+    const uint64_t wrap = (uint64_t)phases << 32;
+    const uint64_t num = (uint64_t)phases * in_rate;
+    const uint64_t step = ( num / p_sys->out_rate ) << 32
+                        | ( ( num % p_sys->out_rate ) << 32 ) / p_sys->out_rate;
+    /* On a rate that falls on the phases, go back on them, or on the input
+     * samples if the bank only delays them */
+    const bool nudge = (uint32_t)step == 0;
+    const uint64_t grain = p_sys->bank->identity ? wrap : UINT64_C(1) << 32;
+    size_t base = p_sys->base;
+    uint64_t position = p_sys->position;
+    size_t count = 0;
+
+    while( base + p_sys->taps <= p_sys->frames && count < max )
+    {
+        struct resampler_step *s = &p_sys->steps[count++];
+        const uint32_t frac = position;
+
+        s->offset = base;
+        s->phase = position >> 32;
+        s->frac = frac * 0x1p-32f;
+
+        position += step;
+        if( nudge && position % grain != 0 )
+        {
+            const uint64_t ahead = position % grain;
+            if( ahead < grain / 2 )
+                position -= __MIN( ahead, PHASE_NUDGE );
+            else
+                position += __MIN( grain - ahead, PHASE_NUDGE );
+        }
+        if( position >= wrap )
+        {
+            const uint64_t samples = ( position >> 32 ) / phases;
+            base += samples;
+            position -= ( samples * phases ) << 32;
+        }
+    }
+
+    p_sys->base = base;
+    p_sys->position = position;
+    return count;
+}
+
+static block_t *Process( filter_t *p_filter, const float *in, size_t count )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned channels = p_sys->channels;
+    const unsigned taps = p_sys->taps;
+
+    if( BankSelect( p_filter, in_rate ) || Append( p_sys, in, count ) )
+        return NULL;
+
+    const struct bank *bank = p_sys->bank;
+    if( p_sys->frames + 1 < taps + p_sys->base )
+        return NULL;
+    const size_t windows = p_sys->frames + 1 - taps - p_sys->base;
+
+    /* one more output for the rounding, and maybe one for the nudges */
+    const size_t max = (double)windows * p_sys->out_rate / in_rate + 2;
+    if( max > p_sys->steps_size )
+    {
+        struct resampler_step *steps = vlc_alloc( max, sizeof (*steps) );
+        if( unlikely( steps == NULL ) )
+            return NULL;
+        free( p_sys->steps );
+        p_sys->steps = steps;
+        p_sys->steps_size = max;
+    }
+
+    block_t *p_out = block_Alloc( max * channels * sizeof (float) );
+    if( unlikely( p_out == NULL ) )
+        return NULL;
+
+    float *out = (float *)p_out->p_buffer;
+    size_t done;
+
+    if( bank->identity && p_sys->position == 0
+     && in_rate == p_sys->out_rate )
+    {
+        /* Nothing to interpolate: it is only a delay */
+        done = __MIN( windows, max );
+        for( unsigned c = 0; c < channels; c++ )
+        {
+            const float *x = &p_sys->history[c * p_sys->stride + p_sys->base
+                                             + taps / 2 - 1];
+            for( size_t i = 0; i < done; i++ )
+                out[i * channels + c] = x[i];
+        }
+        p_sys->base += done;
+    }
+    else
+    {
+        done = Schedule( p_sys, in_rate, max );
+        for( unsigned c = 0; c < channels; c++ )
+            p_sys->resample( &out[c], channels,
+                             &p_sys->history[c * p_sys->stride],
+                             bank->coefs, taps, p_sys->steps, done );
+    }
+
+    /* Keep what the next windows need */
+    const size_t kept = p_sys->frames - p_sys->base;
+    for( unsigned c = 0; c < channels; c++ )
+    {
+        float *x = &p_sys->history[c * p_sys->stride];
+        memmove( x, &x[p_sys->base], kept * sizeof (float) );
+    }
+    p_sys->frames = kept;
+    p_sys->base = 0;
+
+    p_out->i_nb_samples = done;
+    p_out->i_buffer = done * channels * sizeof (float);
+    p_out->i_length = vlc_tick_from_samples( done, p_sys->out_rate );
+    return p_out;
+}
+
+static block_t *Resample( filter_t *p_filter, block_t *p_in )
+{
+    block_t *p_out = Process( p_filter, (const float *)p_in->p_buffer,
+                              p_in->i_nb_samples );
+    if( p_out != NULL )
+        p_out->i_pts = p_in->i_pts;
+    block_Release( p_in );
+    return p_out;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    Reset( p_filter->p_sys );
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    /* Center the last windows about the last input samples */
+    block_t *p_out = Process( p_filter, NULL, p_sys->taps / 2 );
+    Reset( p_sys );
+    return p_out;
+}
+
+/*****************************************************************************
+ * Open: allocate the resampler
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const audio_format_t *in = &p_filter->fmt_in.audio;
+    const audio_format_t *out = &p_filter->fmt_out.audio;
+
+    if( in->i_format != VLC_CODEC_FL32 || out->i_format != VLC_CODEC_FL32
+     || in->i_channels != out->i_channels
+     || in->i_physical_channels != out->i_physical_channels
+     || in->i_rate == 0 || out->i_rate == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof (*p_sys) );
+    if( unlikely( p_sys == NULL ) )
+        return VLC_ENOMEM;
+
+    int64_t quality = var_InheritInteger( p_this,
+                                          "polyphase-resampler-quality" );
+    quality = VLC_CLIP( quality, 0, (int64_t)ARRAY_SIZE(tiers) - 1 );
+
+    /* Downsampling needs longer filters, for the lower cutoff */
+    unsigned taps = tiers[quality].taps;
+    if( in->i_rate > out->i_rate )
+        taps = ceil( (double)taps * in->i_rate / out->i_rate );
+    taps = __MIN( ( taps + 7 ) & ~7u, MAX_TAPS );
+
+    p_sys->taps = taps;
+    p_sys->channels = aout_FormatNbChannels( in );
+    p_sys->out_rate = out->i_rate;
+    p_sys->quality = quality;
+    p_filter->p_sys = p_sys;
+
+    p_sys->resample = Resample_c;
+#ifdef CAN_COMPILE_SSE
+    if( vlc_CPU_SSE() )
+        p_sys->resample = Resample_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        p_sys->resample = Resample_avx2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->resample = Resample_neon;
+#endif
+
+    p_sys->stride = 4 * taps;
+    p_sys->history = vlc_alloc( p_sys->channels,
+                                p_sys->stride * sizeof (float) );
+    if( unlikely( p_sys->history == NULL )
+     || BankInit( p_sys, &p_sys->banks[0], in->i_rate,
+                  Cutoff( p_sys, in->i_rate, in->i_rate ) ) )
+    {
+        Close( p_this );
+        return VLC_ENOMEM;
+    }
+    p_sys->bank = &p_sys->banks[0];
+    Reset( p_sys );
+
+    msg_Dbg( p_filter, "%u taps, %u phases, to convert %u Hz to %u Hz",
+             taps, p_sys->bank->phases, in->i_rate, out->i_rate );
+
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static int OpenConverter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return Open( p_this );
+}
+
+static int OpenResampler( vlc_object_t *p_this )
+{
+    return Open( p_this );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    aligned_free( p_sys->banks[1].coefs );
+    aligned_free( p_sys->banks[0].coefs );
+    free( p_sys->steps );
+    free( p_sys->history );
+    free( p_sys );
+}
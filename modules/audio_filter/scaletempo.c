@@ -32,10 +32,23 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
+#include <vlc_cpu.h>
 
 #include <stdatomic.h>
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
+#include <float.h>
+#include <math.h>
+
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -129,6 +142,13 @@ typedef struct
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*dot_product)( const float *a, const float *b, unsigned n );
+    /* best overlap by FFT, for the large searches */
+    unsigned  fft_size;
+    unsigned *fft_bitrev;
+    float    *fft_twiddles; /* cosines then sines, fft_size / 2 each */
+    float    *fft_re;
+    float    *fft_im;
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -136,16 +156,85 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/*****************************************************************************
+ * dot_product: correlation of the overlap with a search position
+ *****************************************************************************/
+static float dot_product_c( const float *a, const float *b, unsigned n )
+{
+    float corr = 0;
+    for( unsigned i = 0; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static float dot_product_sse( const float *a, const float *b, unsigned n )
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    /* two accumulators to hide the latency of the additions */
+    for( ; i + 8 <= n; i += 8 )
+    {
+        acc0 = _mm_add_ps( acc0, _mm_mul_ps( _mm_loadu_ps( &a[i] ),
+                                             _mm_loadu_ps( &b[i] ) ) );
+        acc1 = _mm_add_ps( acc1, _mm_mul_ps( _mm_loadu_ps( &a[i + 4] ),
+                                             _mm_loadu_ps( &b[i + 4] ) ) );
+    }
+    acc0 = _mm_add_ps( acc0, acc1 );
+    acc0 = _mm_add_ps( acc0, _mm_movehl_ps( acc0, acc0 ) );
+    acc0 = _mm_add_ss( acc0, _mm_shuffle_ps( acc0, acc0, 1 ) );
+    return _mm_cvtss_f32( acc0 ) + dot_product_c( &a[i], &b[i], n - i );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static float dot_product_avx2( const float *a, const float *b, unsigned n )
+{
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        acc0 = _mm256_add_ps( acc0, _mm256_mul_ps( _mm256_loadu_ps( &a[i] ),
+                                                   _mm256_loadu_ps( &b[i] ) ) );
+        acc1 = _mm256_add_ps( acc1, _mm256_mul_ps( _mm256_loadu_ps( &a[i + 8] ),
+                                                   _mm256_loadu_ps( &b[i + 8] ) ) );
+    }
+    acc0 = _mm256_add_ps( acc0, acc1 );
+    __m128 acc = _mm_add_ps( _mm256_castps256_ps128( acc0 ),
+                             _mm256_extractf128_ps( acc0, 1 ) );
+    acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+    acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+    return _mm_cvtss_f32( acc ) + dot_product_c( &a[i], &b[i], n - i );
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static float dot_product_neon( const float *a, const float *b, unsigned n )
+{
+    float32x4_t acc0 = vdupq_n_f32( 0 ), acc1 = vdupq_n_f32( 0 );
+    unsigned i = 0;
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+        acc0 = vfmaq_f32( acc0, vld1q_f32( &a[i] ), vld1q_f32( &b[i] ) );
+        acc1 = vfmaq_f32( acc1, vld1q_f32( &a[i + 4] ), vld1q_f32( &b[i + 4] ) );
+    }
+    return vaddvq_f32( vaddq_f32( acc0, acc1 ) )
+         + dot_product_c( &a[i], &b[i], n - i );
+}
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
-static unsigned best_overlap_offset_float( filter_t *p_filter )
+static void pre_correlate( filter_sys_t *p )
 {
-    filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
-    float best_corr = INT_MIN;
-    unsigned best_off = 0;
-    unsigned i, off;
+    float *pw, *po, *ppc;
+    unsigned i;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -154,15 +243,22 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
       *ppc++ = *pw++ * *po++;
     }
+}
+
+static unsigned best_overlap_offset_float( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    float *search_start;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    unsigned off;
+    const unsigned samples = p->samples_overlap - p->samples_per_frame;
+
+    pre_correlate( p );
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = p->dot_product( p->buf_pre_corr, search_start, samples );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -173,6 +269,160 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/*****************************************************************************
+ * best_overlap_offset_fft: the same, with the correlations of every offset
+ * computed at once in the frequency domain
+ *****************************************************************************/
+
+/* In place radix-2 transform of fft_size complex numbers, split in real and
+ * imaginary parts, inverse without the normalization */
+static void fft( filter_sys_t *p, float *re, float *im, bool inverse )
+{
+    const unsigned n = p->fft_size;
+    const float *cosines = p->fft_twiddles;
+    const float *sines = p->fft_twiddles + n / 2;
+    const float sign = inverse ? 1.f : -1.f;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        unsigned j = p->fft_bitrev[i];
+        if( j > i )
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for( unsigned half = 1, step = n / 2; half < n; half *= 2, step /= 2 )
+    {
+        for( unsigned start = 0; start < n; start += 2 * half )
+        {
+            float *re0 = &re[start], *im0 = &im[start];
+            float *re1 = &re[start + half], *im1 = &im[start + half];
+
+            for( unsigned k = 0; k < half; k++ )
+            {
+                const float wr = cosines[k * step];
+                const float wi = sign * sines[k * step];
+                const float tr = re1[k] * wr - im1[k] * wi;
+                const float ti = re1[k] * wi + im1[k] * wr;
+
+                re1[k] = re0[k] - tr;
+                im1[k] = im0[k] - ti;
+                re0[k] += tr;
+                im0[k] += ti;
+            }
+        }
+    }
+}
+
+/* Cost of the transforms, relatively to the size times its logarithm, in
+ * dot product multiplications */
+#define FFT_COST_FACTOR 40
+
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned n = p->fft_size;
+    const unsigned samples = p->samples_overlap - p->samples_per_frame;
+    const unsigned searched = samples
+                            + ( p->frames_search - 1 ) * p->samples_per_frame;
+    const float *search_start = (float *)p->buf_queue + p->samples_per_frame;
+    float *re = p->fft_re, *im = p->fft_im;
+
+    const float *pc = p->buf_pre_corr;
+    double energy_pc = 0, energy_search = 0;
+
+    pre_correlate( p );
+    for( unsigned i = 0; i < samples; i++ )
+        energy_pc += pc[i] * pc[i];
+    for( unsigned i = 0; i < searched; i++ )
+        energy_search += search_start[i] * search_start[i];
+    if( energy_pc == 0 || energy_search == 0 )
+        return 0;
+
+    /* both real signals are transformed at once, as one complex signal,
+     * with the same energy, or the smaller one would be lost in the
+     * rounding errors of the larger one */
+    const float gain = sqrt( energy_search / energy_pc );
+    for( unsigned i = 0; i < samples; i++ )
+        re[i] = pc[i] * gain;
+    memset( re + samples, 0, ( n - samples ) * sizeof(*re) );
+    memcpy( im, search_start, searched * sizeof(*im) );
+    memset( im + searched, 0, ( n - searched ) * sizeof(*im) );
+    fft( p, re, im, false );
+
+    /* conj(A) * B, from Z = A + iB: A = (Z[k] + conj(Z[-k])) / 2 and
+     * B = (Z[k] - conj(Z[-k])) / 2i, the constant factor does not matter */
+    for( unsigned k = 0; k <= n / 2; k++ )
+    {
+        const unsigned m = ( n - k ) & ( n - 1 );
+        const float ar = re[k] + re[m], ai = im[k] - im[m];
+        const float br = im[k] + im[m], bi = re[m] - re[k];
+        const float pr = ar * br + ai * bi;
+        const float pi = ar * bi - ai * br;
+
+        /* the product is hermitian, as the correlation is real */
+        re[k] = pr; im[k] = pi;
+        re[m] = pr; im[m] = -pi;
+    }
+    fft( p, re, im, true );
+
+    float best_fft = INT_MIN;
+    for( unsigned off = 0; off < p->frames_search; off++ )
+        best_fft = __MAX( best_fft, re[off * p->samples_per_frame] );
+
+    /* the offsets which may be the best, within the rounding errors of the
+     * transforms, are compared with their exact correlations */
+    const float bound = 4.f * n * FLT_EPSILON * ctz( n )
+                      * energy_search;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    for( unsigned off = 0; off < p->frames_search; off++ )
+    {
+        if( re[off * p->samples_per_frame] < best_fft - 2.f * bound )
+            continue;
+
+        const float corr = p->dot_product( pc, search_start
+                                               + off * p->samples_per_frame,
+                                           samples );
+        if( corr > best_corr )
+        {
+            best_corr = corr;
+            best_off  = off;
+        }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
+static int init_fft( filter_sys_t *p, unsigned bits )
+{
+    const unsigned n = 1u << bits;
+
+    p->fft_size     = n;
+    p->fft_bitrev   = vlc_alloc( n, sizeof(*p->fft_bitrev) );
+    p->fft_twiddles = vlc_alloc( n, sizeof(*p->fft_twiddles) );
+    p->fft_re       = vlc_alloc( n, sizeof(*p->fft_re) );
+    p->fft_im       = vlc_alloc( n, sizeof(*p->fft_im) );
+    if( !p->fft_bitrev || !p->fft_twiddles || !p->fft_re || !p->fft_im )
+        return VLC_ENOMEM;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        unsigned r = 0;
+        for( unsigned b = 0; b < bits; b++ )
+            r |= ( ( i >> b ) & 1 ) << ( bits - 1 - b );
+        p->fft_bitrev[i] = r;
+    }
+    for( unsigned i = 0; i < n / 2; i++ )
+    {
+        p->fft_twiddles[i]         = cos( 2 * M_PI * i / n );
+        p->fft_twiddles[n / 2 + i] = sin( 2 * M_PI * i / n );
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -352,6 +602,35 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+
+        p->dot_product = dot_product_c;
+#ifdef CAN_COMPILE_SSE
+        if( vlc_CPU_SSE() )
+            p->dot_product = dot_product_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+        if( vlc_CPU_AVX2() )
+            p->dot_product = dot_product_avx2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+        if( vlc_CPU_ARM_NEON() )
+            p->dot_product = dot_product_neon;
+#endif
+
+        /* the transforms cost less than the dot products of every offset
+         * for the large windows, the factor is a measured tradeoff */
+        unsigned samples = p->samples_overlap - p->samples_per_frame;
+        unsigned searched = samples + ( p->frames_search - 1 ) * p->samples_per_frame;
+        unsigned bits = 0;
+        while( ( 1u << bits ) < searched )
+            bits++;
+        double cost_fft = FFT_COST_FACTOR * (double)( 1u << bits ) * bits;
+        if( (double)samples * p->frames_search > cost_fft )
+        {
+            if( init_fft( p, bits ) != VLC_SUCCESS )
+                return VLC_ENOMEM;
+            p->best_overlap_offset = best_overlap_offset_fft;
+        }
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -381,13 +660,14 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search%s, %i queue, %s mode",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
              (int)( p->bytes_standing / p->bytes_per_frame ),
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
+             p->best_overlap_offset == best_overlap_offset_fft ? " (fft)" : "",
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
              "fl32");
 
@@ -430,6 +710,10 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->fft_bitrev     = NULL;
+    p_sys->fft_twiddles   = NULL;
+    p_sys->fft_re         = NULL;
+    p_sys->fft_im         = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -525,6 +809,10 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->fft_bitrev );
+    free( p_sys->fft_twiddles );
+    free( p_sys->fft_re );
+    free( p_sys->fft_im );
     free( p_sys );
 }
 
@@ -4,8 +4,23 @@
 // http://www.dreampoint.co.uk
 // This code is public domain
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
 #include "allpass.hpp"
 #include <stddef.h>
+#include <assert.h>
+
+#ifdef CAN_COMPILE_SSE2
+# include <emmintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
 
 allpass::allpass()
 {
@@ -35,4 +50,86 @@ float allpass::getfeedback()
     return feedback;
 }
 
+// As for the combs, the delay is longer than the block, which is processed
+// as vectors, with the denormals flushed to zero in the SIMD versions.
+
+static void allpassblock(float *buffer, float *inout, int numsamples,
+                         float feedback)
+{
+    for (int i=0; i<numsamples; i++)
+    {
+        float input = inout[i];
+        float bufout = undenormalise(buffer[i]);
+
+        inout[i] = -input + bufout;
+        buffer[i] = input + (bufout*feedback);
+    }
+}
+
+#ifdef CAN_COMPILE_SSE2
+VLC_SSE
+static void allpassblock_sse2(float *buffer, float *inout, int numsamples,
+                              float feedback)
+{
+    const __m128 f = _mm_set1_ps(feedback);
+    int i = 0;
+
+    for (; i+4<=numsamples; i+=4)
+    {
+        __m128 input = _mm_loadu_ps(&inout[i]);
+        __m128 bufout = _mm_loadu_ps(&buffer[i]);
+
+        _mm_storeu_ps(&inout[i], _mm_sub_ps(bufout, input));
+        _mm_storeu_ps(&buffer[i], _mm_add_ps(input, _mm_mul_ps(bufout, f)));
+    }
+    allpassblock(&buffer[i], &inout[i], numsamples-i, feedback);
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void allpassblock_neon(float *buffer, float *inout, int numsamples,
+                              float feedback)
+{
+    int i = 0;
+
+    for (; i+4<=numsamples; i+=4)
+    {
+        float32x4_t input = vld1q_f32(&inout[i]);
+        float32x4_t bufout = vld1q_f32(&buffer[i]);
+
+        vst1q_f32(&inout[i], vsubq_f32(bufout, input));
+        vst1q_f32(&buffer[i], vaddq_f32(input, vmulq_n_f32(bufout, feedback)));
+    }
+    allpassblock(&buffer[i], &inout[i], numsamples-i, feedback);
+}
+#endif
+
+void allpass::processblock(float *inout, int numsamples)
+{
+    void (*process)(float *, float *, int, float) = allpassblock;
+#ifdef CAN_COMPILE_SSE2
+    if (vlc_CPU_SSE2())
+        process = allpassblock_sse2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if (vlc_CPU_ARM_NEON())
+        process = allpassblock_neon;
+#endif
+
+    assert(numsamples <= bufsize);
+    while (numsamples > 0)
+    {
+        int count = bufsize - bufidx;
+        if (count > numsamples)
+            count = numsamples;
+
+        process(&buffer[bufidx], inout, count, feedback);
+
+        bufidx += count;
+        if (bufidx >= bufsize) bufidx = 0;
+        inout += count;
+        numsamples -= count;
+    }
+}
+
 //ends
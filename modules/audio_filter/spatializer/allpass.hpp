@@ -13,7 +13,8 @@ class allpass
 public:
         allpass();
     void    setbuffer(float *buf, int size);
-    inline  float    process(float inp);
+    // Filters a block, at most as long as the buffer, in place
+    void    processblock(float *inout, int numsamples);
     void    mute();
     void    setfeedback(float val);
     float    getfeedback();
@@ -25,23 +26,6 @@ public:
 };
 
 
-// Big to inline - but crucial for speed
-
-inline float allpass::process(float input)
-{
-    float output;
-    float bufout;
-
-    bufout = undenormalise( buffer[bufidx] );
-
-    output = -input + bufout;
-    buffer[bufidx] = input + (bufout*feedback);
-
-    if(++bufidx>=bufsize) bufidx = 0;
-
-    return output;
-}
-
 #endif//_allpass
 
 //ends
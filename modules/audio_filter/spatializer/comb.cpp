@@ -4,12 +4,26 @@
 // http://www.dreampoint.co.uk
 // This code is public domain
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
 #include "comb.hpp"
 #include <stddef.h>
+#include <assert.h>
+
+#ifdef CAN_COMPILE_SSE2
+# include <emmintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
 
 comb::comb()
 {
-    filterstore = 0;
     bufidx = 0;
     buffer = NULL;
 }
@@ -47,4 +61,94 @@ float comb::getfeedback()
     return feedback;
 }
 
+// The delay is longer than the block, so that the samples read in a block
+// were all written before it, and the block is processed as vectors. The
+// SIMD versions run with the denormals flushed to zero, see denormals.h.
+
+static void combblock(float *buffer, const float *input, float *output,
+                      int numsamples, float damp2, float feedback)
+{
+    for (int i=0; i<numsamples; i++)
+    {
+        float bufout = undenormalise(buffer[i]);
+        float filterstore = undenormalise(bufout*damp2);
+
+        buffer[i] = input[i] + filterstore*feedback;
+        output[i] += bufout;
+    }
+}
+
+#ifdef CAN_COMPILE_SSE2
+VLC_SSE
+static void combblock_sse2(float *buffer, const float *input, float *output,
+                           int numsamples, float damp2, float feedback)
+{
+    const __m128 d = _mm_set1_ps(damp2);
+    const __m128 f = _mm_set1_ps(feedback);
+    int i = 0;
+
+    for (; i+4<=numsamples; i+=4)
+    {
+        __m128 bufout = _mm_loadu_ps(&buffer[i]);
+        __m128 filterstore = _mm_mul_ps(bufout, d);
+
+        _mm_storeu_ps(&buffer[i], _mm_add_ps(_mm_loadu_ps(&input[i]),
+                                             _mm_mul_ps(filterstore, f)));
+        _mm_storeu_ps(&output[i], _mm_add_ps(_mm_loadu_ps(&output[i]),
+                                             bufout));
+    }
+    combblock(&buffer[i], &input[i], &output[i], numsamples-i, damp2, feedback);
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void combblock_neon(float *buffer, const float *input, float *output,
+                           int numsamples, float damp2, float feedback)
+{
+    int i = 0;
+
+    for (; i+4<=numsamples; i+=4)
+    {
+        float32x4_t bufout = vld1q_f32(&buffer[i]);
+        float32x4_t filterstore = vmulq_n_f32(bufout, damp2);
+
+        // not fused, to match the other versions
+        vst1q_f32(&buffer[i], vaddq_f32(vld1q_f32(&input[i]),
+                                        vmulq_n_f32(filterstore, feedback)));
+        vst1q_f32(&output[i], vaddq_f32(vld1q_f32(&output[i]), bufout));
+    }
+    combblock(&buffer[i], &input[i], &output[i], numsamples-i, damp2, feedback);
+}
+#endif
+
+void comb::processblock(const float *input, float *output, int numsamples)
+{
+    void (*process)(float *, const float *, float *, int, float, float) =
+        combblock;
+#ifdef CAN_COMPILE_SSE2
+    if (vlc_CPU_SSE2())
+        process = combblock_sse2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if (vlc_CPU_ARM_NEON())
+        process = combblock_neon;
+#endif
+
+    assert(numsamples <= bufsize);
+    while (numsamples > 0)
+    {
+        int count = bufsize - bufidx;
+        if (count > numsamples)
+            count = numsamples;
+
+        process(&buffer[bufidx], input, output, count, damp2, feedback);
+
+        bufidx += count;
+        if (bufidx >= bufsize) bufidx = 0;
+        input += count;
+        output += count;
+        numsamples -= count;
+    }
+}
+
 // ends
@@ -18,7 +18,8 @@ class comb
 public:
     comb();
     void    setbuffer(float *buf, int size);
-    inline  float    process(float inp);
+    // Adds the output of a block, at most as long as the buffer, to output
+    void    processblock(const float *input, float *output, int numsamples);
     void    mute();
     void    setdamp(float val);
     float    getdamp();
@@ -26,7 +27,6 @@ public:
     float    getfeedback();
 private:
     float    feedback;
-    float    filterstore;
     float    damp1;
     float    damp2;
     float    *buffer;
@@ -35,26 +35,6 @@ private:
 };
 
 
-// Big to inline - but crucial for speed
-
-inline float comb::process(float input)
-{
-/* FIXME
-* comb::process is not really ear-friendly the tunning values must
-* be changed*/
-    float output;
-
-    output = undenormalise( buffer[bufidx] );
-
-    filterstore = undenormalise(output*damp2);
-
-    buffer[bufidx] = input + filterstore*feedback;
-
-    if(++bufidx>=bufsize) bufidx = 0;
-
-    return output;
-}
-
 #endif //_comb_
 
 //ends
@@ -10,8 +10,16 @@
 #endif
 
 #include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
 #include "denormals.h"
 
+#ifdef CAN_COMPILE_SSE2
+# include <emmintrin.h>
+#endif
+
 /* fpclassify() is C99, cannot be compiled into a C++90 file (on some systems) */
 float undenormalise( float f )
 {
@@ -19,3 +27,41 @@ float undenormalise( float f )
         return 0.0;
     return f;
 }
+
+/* The SIMD filters rely on this mode instead of undenormalise() */
+unsigned denormals_disable( void )
+{
+#ifdef CAN_COMPILE_SSE2
+    if( vlc_CPU_SSE2() )
+    {
+        unsigned csr = _mm_getcsr();
+        /* flush to zero and denormals are zero */
+        _mm_setcsr( csr | 0x8040 );
+        return csr;
+    }
+#endif
+#if defined(CAN_COMPILE_ARM64) && defined(__aarch64__)
+    if( vlc_CPU_ARM_NEON() )
+    {
+        uint64_t fpcr;
+        __asm__ volatile( "mrs %0, fpcr" : "=r" (fpcr) );
+        /* FZ flushes both the inputs and the results */
+        __asm__ volatile( "msr fpcr, %0" :: "r" (fpcr | (UINT64_C(1) << 24)) );
+        return fpcr;
+    }
+#endif
+    return 0;
+}
+
+void denormals_restore( unsigned mode )
+{
+#ifdef CAN_COMPILE_SSE2
+    if( vlc_CPU_SSE2() )
+        _mm_setcsr( mode );
+#endif
+#if defined(CAN_COMPILE_ARM64) && defined(__aarch64__)
+    if( vlc_CPU_ARM_NEON() )
+        __asm__ volatile( "msr fpcr, %0" :: "r" ((uint64_t)mode) );
+#endif
+    (void) mode;
+}
@@ -10,9 +10,17 @@
 
 
 #ifdef __cplusplus
-extern "C"
+extern "C" {
 #endif
 float undenormalise( float );
 
+/* Makes the SIMD unit flush the denormals to zero, if the filters use it,
+ * and returns the previous mode to restore */
+unsigned denormals_disable( void );
+void denormals_restore( unsigned );
+#ifdef __cplusplus
+}
+#endif
+
 #endif//_denormals_
 
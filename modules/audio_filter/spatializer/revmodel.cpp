@@ -89,70 +89,77 @@ void revmodel::mute()
  * /param long numsamples  number of samples to be processed
  * /param int skip             number of channels in the audio stream
  *****************************************************************************/
-void revmodel::processreplace(float *inputL, float *outputL, long /* numsamples */, int skip)
+void revmodel::processreplace(float *inputL, float *outputL, long numsamples, int skip)
 {
-    float outL,outR,input;
-    float inputR;
-    int i;
+    process(inputL, outputL, numsamples, skip, false);
+}
+
+void revmodel::processmix(float *inputL, float *outputL, long numsamples, int skip)
+{
+    process(inputL, outputL, numsamples, skip, true);
+}
 
-    outL = outR = 0;
-        /* TODO this module supports only 2 audio channels, let's improve this */
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
+/* The samples are processed by blocks, where each filter runs at once,
+ * between the first two channels and those contiguous buffers. The other
+ * channels are left untouched. */
+void revmodel::process(float *inputL, float *outputL, long numsamples, int skip, bool mix)
+{
+    float input[blocksize], inputR[blocksize];
+    float outL[blocksize], outR[blocksize];
+    unsigned mode = denormals_disable();
+
+    while (numsamples > 0)
+    {
+        int count = numsamples < blocksize ? numsamples : blocksize;
+        int i;
+
+        for (i=0; i<count; i++)
+        {
+            /* TODO this module supports only 2 audio channels, let's improve this */
+            inputR[i] = inputL[i*skip + (skip > 1)];
+            input[i] = (inputL[i*skip] + inputR[i]) * gain;
+            outL[i] = outR[i] = 0;
+        }
 
         // Accumulate comb filters in parallel
         for(i=0; i<numcombs; i++)
         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
+            combL[i].processblock(input, outL, count);
+            combR[i].processblock(input, outR, count);
         }
 
         // Feed through allpasses in series
         for(i=0; i<numallpasses; i++)
         {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
+            allpassL[i].processblock(outL, count);
+            allpassR[i].processblock(outR, count);
         }
 
-        // Calculate output REPLACING anything already there
-        outputL[0] = (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] = (outR*wet1 + outL*wet2 + inputR*dry);
-}
-
-void revmodel::processmix(float *inputL, float *outputL, long /* numsamples */, int skip)
-{
-    float outL,outR,input;
-    float inputR;
-
-    outL = outR = 0;
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
-
-        // Accumulate comb filters in parallel
-        for(int i=0; i<numcombs; i++)
+        // Calculate output REPLACING or MIXING with anything already there
+        for (i=0; i<count; i++)
         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
+            float left = outL[i]*wet1 + outR[i]*wet2 + inputR[i]*dry;
+            float right = outR[i]*wet1 + outL[i]*wet2 + inputR[i]*dry;
+
+            if (mix)
+                outputL[i*skip] += left;
+            else
+                outputL[i*skip] = left;
+            if (skip > 1)
+            {
+                if (mix)
+                    outputL[i*skip + 1] += right;
+                else
+                    outputL[i*skip + 1] = right;
+            }
         }
 
-        // Feed through allpasses in series
-        for(int i=0; i<numallpasses; i++)
-        {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
-        }
+        inputL += count*skip;
+        outputL += count*skip;
+        numsamples -= count;
+    }
 
-        // Calculate output REPLACING anything already there
-        outputL[0] += (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] += (outR*wet1 + outL*wet2 + inputR*dry);
+    denormals_restore(mode);
 }
 
 void revmodel::update()
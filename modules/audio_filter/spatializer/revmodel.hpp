@@ -35,6 +35,8 @@ public:
     void    setmode(float value);
 private:
     void    update();
+    void    process(float *input, float *output, long numsamples, int skip,
+                    bool mix);
 private:
     float    gain;
     float    roomsize,roomsize1;
@@ -24,6 +24,8 @@ const float initialwidth     = 1;
 const float initialmode      = 0;
 const float freezemode       = 0.5f;
 const int   stereospread     = 23;
+// Samples processed at once, no more than the shortest delay
+const int   blocksize        = 128;
 
 // These values assume 44.1KHz sample rate
 // they will probably be OK for 48KHz sample rate
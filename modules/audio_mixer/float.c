@@ -33,6 +33,17 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include <vlc_cpu.h>
+
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
 
 /*****************************************************************************
  * Local prototypes
@@ -50,22 +61,254 @@ vlc_module_begin ()
     set_callback( Create )
 vlc_module_end ()
 
-/**
- * Mixes a new output buffer
- */
-static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
-                        float f_multiplier )
+/*****************************************************************************
+ * Kernels
+ *****************************************************************************
+ * The amplifiers multiply the n samples by amp. The ramps multiply the
+ * samples of frame f, of the given number of channels, by
+ * from + step * (f + 1), so that the last frame gets the new gain.
+ *****************************************************************************/
+static void Amplify_c( float *p, size_t n, float amp )
 {
-    if( f_multiplier == 1.f )
-        return; /* nothing to do */
+    for( size_t i = 0; i < n; i++ )
+        p[i] *= amp;
+}
 
-    float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= f_multiplier;
+static void Ramp_c( float *p, size_t frames, unsigned channels,
+                    float from, float step )
+{
+    for( size_t f = 0; f < frames; f++ )
+    {
+        const float amp = from + step * (float)(f + 1);
+        for( unsigned c = 0; c < channels; c++ )
+            *(p++) *= amp;
+    }
+}
 
-    (void) p_volume;
+/* The ramps run over the samples by runs of whole frames filling whole
+ * vectors, as many vectors as the channels, or 4 at least so that they do
+ * not wait on each other. first holds the frame numbers of the lanes, from
+ * 1, in the first run; RampFrames() returns the frames of a run. */
+#define RAMP_MAX_CHANNELS 64
+
+static inline unsigned RampFrames( float *first, unsigned lanes,
+                                   unsigned channels )
+{
+    const unsigned frames = lanes * (channels < 4 ? 4 / channels : 1);
+
+    for( unsigned i = 0; i < frames * channels; i++ )
+        first[i] = i / channels + 1;
+    return frames;
+}
+
+/* Ramps the samples from i to n, that the vectors did not cover */
+static inline void RampTail( float *p, size_t i, size_t n,
+                             unsigned channels, float from, float step )
+{
+    for( ; i < n; i++ )
+        p[i] *= from + step * (float)(i / channels + 1);
+}
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static void Amplify_sse( float *p, size_t n, float amp )
+{
+    const __m128 a = _mm_set1_ps( amp );
+    size_t i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        _mm_storeu_ps( p + i,      _mm_mul_ps( _mm_loadu_ps( p + i ), a ) );
+        _mm_storeu_ps( p + i + 4,  _mm_mul_ps( _mm_loadu_ps( p + i + 4 ), a ) );
+        _mm_storeu_ps( p + i + 8,  _mm_mul_ps( _mm_loadu_ps( p + i + 8 ), a ) );
+        _mm_storeu_ps( p + i + 12, _mm_mul_ps( _mm_loadu_ps( p + i + 12 ), a ) );
+    }
+    for( ; i + 4 <= n; i += 4 )
+        _mm_storeu_ps( p + i, _mm_mul_ps( _mm_loadu_ps( p + i ), a ) );
+    for( ; i < n; i++ )
+        p[i] *= amp;
+}
+
+VLC_SSE
+static void Ramp_sse( float *p, size_t frames, unsigned channels,
+                      float from, float step )
+{
+    const size_t n = frames * channels;
+    size_t i = 0;
+
+    if( channels <= RAMP_MAX_CHANNELS )
+    {
+        const __m128 f = _mm_set1_ps( from ), s = _mm_set1_ps( step );
+        float first[4 * RAMP_MAX_CHANNELS];
+        const unsigned run = RampFrames( first, 4, channels ) * channels;
+        const __m128 next = _mm_set1_ps( run / channels );
+        __m128 base = _mm_setzero_ps();
+
+        for( ; i + run <= n; i += run )
+        {
+            for( unsigned j = 0; j < run; j += 4 )
+            {
+                const __m128 frame = _mm_add_ps( base,
+                                                 _mm_loadu_ps( first + j ) );
+                const __m128 a = _mm_add_ps( f, _mm_mul_ps( s, frame ) );
+                _mm_storeu_ps( p + i + j,
+                               _mm_mul_ps( _mm_loadu_ps( p + i + j ), a ) );
+            }
+            base = _mm_add_ps( base, next );
+        }
+    }
+    RampTail( p, i, n, channels, from, step );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static void Amplify_avx2( float *p, size_t n, float amp )
+{
+    const __m256 a = _mm256_set1_ps( amp );
+    size_t i = 0;
+
+    for( ; i + 32 <= n; i += 32 )
+    {
+        _mm256_storeu_ps( p + i,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i ), a ) );
+        _mm256_storeu_ps( p + i + 8,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i + 8 ), a ) );
+        _mm256_storeu_ps( p + i + 16,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i + 16 ), a ) );
+        _mm256_storeu_ps( p + i + 24,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i + 24 ), a ) );
+    }
+    for( ; i + 8 <= n; i += 8 )
+        _mm256_storeu_ps( p + i,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + i ), a ) );
+    for( ; i < n; i++ )
+        p[i] *= amp;
 }
 
+VLC_AVX2
+static void Ramp_avx2( float *p, size_t frames, unsigned channels,
+                       float from, float step )
+{
+    const size_t n = frames * channels;
+    size_t i = 0;
+
+    if( channels <= RAMP_MAX_CHANNELS )
+    {
+        const __m256 f = _mm256_set1_ps( from ), s = _mm256_set1_ps( step );
+        float first[8 * RAMP_MAX_CHANNELS];
+        const unsigned run = RampFrames( first, 8, channels ) * channels;
+        const __m256 next = _mm256_set1_ps( run / channels );
+        __m256 base = _mm256_setzero_ps();
+
+        for( ; i + run <= n; i += run )
+        {
+            for( unsigned j = 0; j < run; j += 8 )
+            {
+                const __m256 frame =
+                    _mm256_add_ps( base, _mm256_loadu_ps( first + j ) );
+                const __m256 a = _mm256_add_ps( f, _mm256_mul_ps( s, frame ) );
+                _mm256_storeu_ps( p + i + j,
+                    _mm256_mul_ps( _mm256_loadu_ps( p + i + j ), a ) );
+            }
+            base = _mm256_add_ps( base, next );
+        }
+    }
+    RampTail( p, i, n, channels, from, step );
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void Amplify_neon( float *p, size_t n, float amp )
+{
+    size_t i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        vst1q_f32( p + i,      vmulq_n_f32( vld1q_f32( p + i ), amp ) );
+        vst1q_f32( p + i + 4,  vmulq_n_f32( vld1q_f32( p + i + 4 ), amp ) );
+        vst1q_f32( p + i + 8,  vmulq_n_f32( vld1q_f32( p + i + 8 ), amp ) );
+        vst1q_f32( p + i + 12, vmulq_n_f32( vld1q_f32( p + i + 12 ), amp ) );
+    }
+    for( ; i + 4 <= n; i += 4 )
+        vst1q_f32( p + i, vmulq_n_f32( vld1q_f32( p + i ), amp ) );
+    for( ; i < n; i++ )
+        p[i] *= amp;
+}
+
+static void Ramp_neon( float *p, size_t frames, unsigned channels,
+                       float from, float step )
+{
+    const size_t n = frames * channels;
+    size_t i = 0;
+
+    if( channels <= RAMP_MAX_CHANNELS )
+    {
+        const float32x4_t f = vdupq_n_f32( from );
+        float first[4 * RAMP_MAX_CHANNELS];
+        const unsigned run = RampFrames( first, 4, channels ) * channels;
+        const float32x4_t next = vdupq_n_f32( run / channels );
+        float32x4_t base = vdupq_n_f32( 0 );
+
+        for( ; i + run <= n; i += run )
+        {
+            for( unsigned j = 0; j < run; j += 4 )
+            {
+                const float32x4_t frame = vaddq_f32( base,
+                                                     vld1q_f32( first + j ) );
+                const float32x4_t a = vaddq_f32( f, vmulq_n_f32( frame, step ) );
+                vst1q_f32( p + i + j, vmulq_f32( vld1q_f32( p + i + j ), a ) );
+            }
+            base = vaddq_f32( base, next );
+        }
+    }
+    RampTail( p, i, n, channels, from, step );
+}
+#endif
+
+/**
+ * Mixes a new output buffer
+ */
+#define FILTER_FL32( name ) \
+static void FilterFL32_##name( audio_volume_t *p_volume, block_t *p_buffer, \
+                               float f_multiplier ) \
+{ \
+    if( f_multiplier == 1.f ) \
+        return; /* nothing to do */ \
+\
+    Amplify_##name( (float *)p_buffer->p_buffer, \
+                    p_buffer->i_buffer / sizeof (float), f_multiplier ); \
+    (void) p_volume; \
+} \
+\
+static void RampFL32_##name( audio_volume_t *p_volume, block_t *p_buffer, \
+                             float f_from, float f_to ) \
+{ \
+    const size_t i_frames = p_buffer->i_nb_samples; \
+    const size_t i_samples = p_buffer->i_buffer / sizeof (float); \
+\
+    if( f_from == f_to || i_frames == 0 || i_samples % i_frames != 0 \
+     || i_samples == 0 ) \
+    { \
+        FilterFL32_##name( p_volume, p_buffer, f_to ); \
+        return; \
+    } \
+\
+    Ramp_##name( (float *)p_buffer->p_buffer, i_frames, \
+                 i_samples / i_frames, f_from, (f_to - f_from) / i_frames ); \
+}
+
+FILTER_FL32( c )
+#ifdef CAN_COMPILE_SSE
+FILTER_FL32( sse )
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+FILTER_FL32( avx2 )
+#endif
+#ifdef CAN_COMPILE_ARM64
+FILTER_FL32( neon )
+#endif
+
 static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
@@ -80,6 +323,31 @@ static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
     (void) p_volume;
 }
 
+static void RampFL64( audio_volume_t *p_volume, block_t *p_buffer,
+                      float f_from, float f_to )
+{
+    const size_t i_frames = p_buffer->i_nb_samples;
+    const size_t i_samples = p_buffer->i_buffer / sizeof (double);
+
+    if( f_from == f_to || i_frames == 0 || i_samples % i_frames != 0
+     || i_samples == 0 )
+    {
+        FilterFL64( p_volume, p_buffer, f_to );
+        return;
+    }
+
+    const unsigned i_channels = i_samples / i_frames;
+    const double from = f_from, step = ((double)f_to - f_from) / i_frames;
+    double *p = (double *)p_buffer->p_buffer;
+
+    for( size_t f = 0; f < i_frames; f++ )
+    {
+        const double mult = from + step * (f + 1);
+        for( unsigned c = 0; c < i_channels; c++ )
+            *(p++) *= mult;
+    }
+}
+
 /**
  * Initializes the mixer
  */
@@ -90,10 +358,33 @@ static int Create( vlc_object_t *p_this )
     switch (p_volume->format)
     {
         case VLC_CODEC_FL32:
-            p_volume->amplify = FilterFL32;
+            p_volume->amplify = FilterFL32_c;
+            p_volume->amplify_ramp = RampFL32_c;
+#ifdef CAN_COMPILE_SSE
+            if( vlc_CPU_SSE() )
+            {
+                p_volume->amplify = FilterFL32_sse;
+                p_volume->amplify_ramp = RampFL32_sse;
+            }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+            if( vlc_CPU_AVX2() )
+            {
+                p_volume->amplify = FilterFL32_avx2;
+                p_volume->amplify_ramp = RampFL32_avx2;
+            }
+#endif
+#ifdef CAN_COMPILE_ARM64
+            if( vlc_CPU_ARM_NEON() )
+            {
+                p_volume->amplify = FilterFL32_neon;
+                p_volume->amplify_ramp = RampFL32_neon;
+            }
+#endif
             break;
         case VLC_CODEC_FL64:
             p_volume->amplify = FilterFL64;
+            p_volume->amplify_ramp = RampFL64;
             break;
         default:
             return -1;
@@ -522,8 +522,14 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
     }
     sys->rate = fmt->i_rate;
 
+    /* With a latency budget, the whole buffer fits in it, by 4 periods */
+    const vlc_tick_t budget = aout_LatencyBudget(aout);
+    if (budget > 0)
+        msg_Dbg (aout, "latency budget: %"PRId64" ms",
+                 MS_FROM_VLC_TICK(budget));
+
 #if 1 /* work-around for period-long latency outputs (e.g. PulseAudio): */
-    param = AOUT_MIN_PREPARE_TIME;
+    param = budget > 0 ? budget / 4 : AOUT_MIN_PREPARE_TIME;
     val = snd_pcm_hw_params_set_period_time_near (pcm, hw, &param, NULL);
     if (val)
     {
@@ -532,7 +538,7 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
     }
 #endif
     /* Set buffer size */
-    param = AOUT_MAX_ADVANCE_TIME;
+    param = budget > 0 ? budget : AOUT_MAX_ADVANCE_TIME;
     val = snd_pcm_hw_params_set_buffer_time_near (pcm, hw, &param, NULL);
     if (val)
     {
@@ -832,6 +832,18 @@ static int Start(audio_output_t *aout, audio_sample_format_t *restrict fmt)
         attr.tlength = pa_usec_to_bytes(3 * AOUT_MIN_PREPARE_TIME, &ss);
     }
 
+    /* With a latency budget, the server latency, which includes the
+     * buffers of the server (or the PipeWire quantum), fits in it */
+    const vlc_tick_t budget = aout_LatencyBudget(aout);
+    if (budget > 0)
+    {
+        flags |= PA_STREAM_ADJUST_LATENCY;
+        attr.tlength = pa_usec_to_bytes(budget, &ss);
+        attr.minreq = pa_usec_to_bytes(budget / 4, &ss);
+        msg_Dbg(aout, "latency budget: %"PRId64" ms",
+                MS_FROM_VLC_TICK(budget));
+    }
+
     if (encoding != PA_ENCODING_PCM)
     {
         pa_format_info_set_channels(formatv, ss.channels);
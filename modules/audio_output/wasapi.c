@@ -860,6 +860,24 @@ static HRESULT Start(aout_stream_t *s, audio_sample_format_t *restrict pfmt,
     if (sys->s24s32)
         msg_Dbg(s, "audio device configured as s24");
 
+    /* With a latency budget, the buffer fits in it, but it cannot be
+     * shorter than two periods of the device */
+    const vlc_tick_t budget = aout_LatencyBudget(s);
+    if (budget > 0 && !b_spdif && !b_hdmi)
+    {
+        REFERENCE_TIME defP, minP;
+        buffer_duration = MSFTIME_FROM_VLC_TICK(budget);
+        if (SUCCEEDED(IAudioClient_GetDevicePeriod(sys->client, &defP, &minP)))
+        {
+            const REFERENCE_TIME period =
+                shared_mode == AUDCLNT_SHAREMODE_EXCLUSIVE ? minP : defP;
+            if (buffer_duration < 2 * period)
+                buffer_duration = 2 * period;
+        }
+        msg_Dbg(s, "latency budget: %"PRId64" ms, buffer: %"PRIu64"00 ns",
+                MS_FROM_VLC_TICK(budget), buffer_duration);
+    }
+
     hr = IAudioClient_Initialize(sys->client, shared_mode, 0, buffer_duration,
                                  0, pwf, sid);
     CoTaskMemFree(pwf_closest);
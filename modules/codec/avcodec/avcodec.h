@@ -112,6 +112,11 @@ int ffmpeg_OpenCodec( decoder_t *p_dec, AVCodecContext *, const AVCodec * );
 #define THREADS_TEXT N_( "Threads" )
 #define THREADS_LONGTEXT N_( "Number of threads used for decoding, 0 meaning auto" )
 
+#define THREADS_BUDGET_TEXT N_( "Threads budget" )
+#define THREADS_BUDGET_LONGTEXT N_( \
+    "Total number of automatic decoding threads shared by all the video " \
+    "decoders, 0 meaning the number of CPUs plus one." )
+
 /*
  * Encoder options
  */
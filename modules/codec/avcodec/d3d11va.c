@@ -296,7 +296,7 @@ static int Open(vlc_va_t *va, AVCodecContext *ctx, enum PixelFormat hwfmt, const
     }
 
     final_fmt.i_chroma = sys->render_fmt->fourcc;
-    err = va_pool_SetupDecoder(va, sys->va_pool, ctx, &final_fmt, sys->hw.surface_count);
+    err = va_pool_SetupDecoder(va, sys->va_pool, ctx, &final_fmt, &sys->hw.surface_count);
     if (err != VLC_SUCCESS)
         goto error;
 
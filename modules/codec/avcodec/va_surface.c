@@ -38,12 +38,16 @@
 
 #include "avcodec.h"
 
-#define MAX_GET_RETRIES  ((VLC_TICK_FROM_SEC(1) + VOUT_OUTMEM_SLEEP) / VOUT_OUTMEM_SLEEP)
+#define GET_TIMEOUT      VLC_TICK_FROM_SEC(1)
+/* extra surfaces for the next pool of the decoder after a starvation */
+#define GROW_STEP        4
+#define GROW_VAR         "avcodec-va-extra-surfaces"
 
 struct vlc_va_surface_t {
     size_t               index;
     atomic_uintptr_t     refcount; // 1 ref for the surface existance, 1 per surface/clone in-flight
     va_pool_t            *va_pool;
+    unsigned             gets; // times handed to the decoder, protected by the pool lock
 };
 
 struct va_pool_t
@@ -58,6 +62,17 @@ struct va_pool_t
     struct va_pool_cfg callbacks;
 
     atomic_uintptr_t  poolrefs; // 1 ref for the pool creator, 1 ref per surface alive
+
+    vlc_va_t     *va; /* valid until va_pool_Close() */
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait; /* signaled when a surface goes back to the pool */
+
+    /* statistics, protected by lock */
+    size_t       in_use;
+    size_t       peak_in_use;
+    unsigned     waits;
+    unsigned     timeouts;
+    vlc_tick_t   wait_time;
 };
 
 static void va_pool_AddRef(va_pool_t *va_pool)
@@ -77,32 +92,43 @@ static void va_pool_Release(va_pool_t *va_pool)
 
 /* */
 int va_pool_SetupDecoder(vlc_va_t *va, va_pool_t *va_pool, AVCodecContext *avctx,
-                         const video_format_t *fmt, size_t count)
+                         const video_format_t *fmt, unsigned *count)
 {
-    if ( va_pool->surface_count >= count &&
+    /* a previous pool of this decoder ran out of surfaces */
+    vlc_object_t *parent = vlc_object_parent(va);
+    int64_t extra = var_Type(parent, GROW_VAR) ? var_GetInteger(parent, GROW_VAR) : 0;
+    if (extra > 0 && *count < MAX_SURFACE_COUNT)
+    {
+        unsigned grown = __MIN(*count + extra, MAX_SURFACE_COUNT);
+        msg_Dbg(va, "growing surface pool from %u to %u", *count, grown);
+        *count = grown;
+    }
+
+    if ( va_pool->surface_count >= *count &&
          va_pool->surface_width  == fmt->i_width &&
          va_pool->surface_height == fmt->i_height )
     {
         msg_Dbg(va, "reusing surface pool");
+        *count = va_pool->surface_count;
         goto done;
     }
 
     /* */
-    msg_Dbg(va, "va_pool_SetupDecoder id %d %dx%d count: %zu", avctx->codec_id, avctx->coded_width, avctx->coded_height, count);
+    msg_Dbg(va, "va_pool_SetupDecoder id %d %dx%d count: %u", avctx->codec_id, avctx->coded_width, avctx->coded_height, *count);
 
-    if (count > MAX_SURFACE_COUNT)
+    if (*count > MAX_SURFACE_COUNT)
     {
-        msg_Err(va, "too many surfaces requested %zu (max %d)", count, MAX_SURFACE_COUNT);
+        msg_Err(va, "too many surfaces requested %u (max %d)", *count, MAX_SURFACE_COUNT);
         return VLC_EGENERIC;
     }
 
-    int err = va_pool->callbacks.pf_create_decoder_surfaces(va, avctx->codec_id, fmt, count);
+    int err = va_pool->callbacks.pf_create_decoder_surfaces(va, avctx->codec_id, fmt, *count);
     if (err != VLC_SUCCESS)
         return err;
 
     va_pool->surface_width  = fmt->i_width;
     va_pool->surface_height = fmt->i_height;
-    va_pool->surface_count = count;
+    va_pool->surface_count = *count;
 
     for (size_t i = 0; i < va_pool->surface_count; i++) {
         vlc_va_surface_t *surface = &va_pool->surface[i];
@@ -110,6 +136,7 @@ int va_pool_SetupDecoder(vlc_va_t *va, va_pool_t *va_pool, AVCodecContext *avctx
         va_pool_AddRef(va_pool);
         surface->index = i;
         surface->va_pool = va_pool;
+        surface->gets = 0;
     }
 done:
     va_pool->callbacks.pf_setup_avcodec_ctx(va_pool->callbacks.opaque, avctx);
@@ -128,6 +155,9 @@ static vlc_va_surface_t *GetSurface(va_pool_t *va_pool)
             /* the copy should have added an extra reference */
             atomic_fetch_sub(&surface->refcount, 1);
             va_surface_AddRef(surface);
+            surface->gets++;
+            if (++va_pool->in_use > va_pool->peak_in_use)
+                va_pool->peak_in_use = va_pool->in_use;
             return surface;
         }
     }
@@ -136,20 +166,33 @@ static vlc_va_surface_t *GetSurface(va_pool_t *va_pool)
 
 vlc_va_surface_t *va_pool_Get(va_pool_t *va_pool)
 {
-    unsigned tries = MAX_GET_RETRIES;
     vlc_va_surface_t *surface;
 
     if (va_pool->surface_count == 0)
         return NULL;
 
-    while ((surface = GetSurface(va_pool)) == NULL)
+    vlc_mutex_lock(&va_pool->lock);
+    surface = GetSurface(va_pool);
+    if (surface == NULL)
     {
-        if (--tries == 0)
-            return NULL;
-        /* Pool empty. Wait for some time as in src/input/decoder.c.
-         * XXX: Both this and the core should use a semaphore or a CV. */
-        vlc_tick_sleep(VOUT_OUTMEM_SLEEP);
+        /* Pool empty, wait until the vout or the decoder returns a surface */
+        vlc_tick_t start = vlc_tick_now();
+        vlc_tick_t deadline = start + GET_TIMEOUT;
+
+        va_pool->waits++;
+        while ((surface = GetSurface(va_pool)) == NULL)
+        {
+            if (vlc_cond_timedwait(&va_pool->wait, &va_pool->lock, deadline))
+            {
+                surface = GetSurface(va_pool);
+                break;
+            }
+        }
+        va_pool->wait_time += vlc_tick_now() - start;
+        if (surface == NULL)
+            va_pool->timeouts++;
     }
+    vlc_mutex_unlock(&va_pool->lock);
     return surface;
 }
 
@@ -160,10 +203,19 @@ void va_surface_AddRef(vlc_va_surface_t *surface)
 
 void va_surface_Release(vlc_va_surface_t *surface)
 {
-    if (atomic_fetch_sub(&surface->refcount, 1) != 1)
-        return;
+    va_pool_t *va_pool = surface->va_pool;
+    uintptr_t refs = atomic_fetch_sub(&surface->refcount, 1);
 
-    va_pool_Release(surface->va_pool);
+    if (refs == 2)
+    {
+        /* back in the pool, the surface reference keeps the pool alive */
+        vlc_mutex_lock(&va_pool->lock);
+        va_pool->in_use--;
+        vlc_cond_signal(&va_pool->wait);
+        vlc_mutex_unlock(&va_pool->lock);
+    }
+    else if (refs == 1)
+        va_pool_Release(va_pool);
 }
 
 size_t va_surface_GetIndex(const vlc_va_surface_t *surface)
@@ -173,6 +225,34 @@ size_t va_surface_GetIndex(const vlc_va_surface_t *surface)
 
 void va_pool_Close(va_pool_t *va_pool)
 {
+    vlc_va_t *va = va_pool->va;
+
+    vlc_mutex_lock(&va_pool->lock);
+    if (va_pool->surface_count > 0)
+    {
+        unsigned min_gets = UINT_MAX, max_gets = 0;
+        for (unsigned i = 0; i < va_pool->surface_count; i++)
+        {
+            min_gets = __MIN(min_gets, va_pool->surface[i].gets);
+            max_gets = __MAX(max_gets, va_pool->surface[i].gets);
+        }
+        msg_Dbg(va, "surface pool: %zu/%zu used at most, %u-%u uses per "
+                "surface, %u wait(s) for %"PRId64" ms, %u timeout(s)",
+                va_pool->peak_in_use, va_pool->surface_count, min_gets,
+                max_gets, va_pool->waits, MS_FROM_VLC_TICK(va_pool->wait_time),
+                va_pool->timeouts);
+    }
+
+    if (va_pool->waits > 0)
+    {
+        /* let the next pool of this decoder start bigger */
+        vlc_object_t *parent = vlc_object_parent(va);
+        if (var_Create(parent, GROW_VAR, VLC_VAR_INTEGER) == VLC_SUCCESS)
+            var_SetInteger(parent, GROW_VAR,
+                           var_GetInteger(parent, GROW_VAR) + GROW_STEP);
+    }
+    vlc_mutex_unlock(&va_pool->lock);
+
     for (unsigned i = 0; i < va_pool->surface_count; i++)
         va_surface_Release(&va_pool->surface[i]);
     va_pool->surface_count = 0;
@@ -197,6 +277,12 @@ va_pool_t * va_pool_Create(vlc_va_t *va, const struct va_pool_cfg *cbs)
 
     va_pool->surface_count = 0;
     atomic_init(&va_pool->poolrefs, 1);
+    va_pool->va = va;
+    vlc_mutex_init(&va_pool->lock);
+    vlc_cond_init(&va_pool->wait);
+    va_pool->in_use = va_pool->peak_in_use = 0;
+    va_pool->waits = va_pool->timeouts = 0;
+    va_pool->wait_time = 0;
 
     return va_pool;
 }
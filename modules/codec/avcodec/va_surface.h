@@ -80,11 +80,16 @@ void va_pool_Close(va_pool_t *);
  *
  * The pf_create_decoder_surfaces callback of the pool configuration is called.
  * If it succeeds, the pf_setup_avcodec_ctx callback will be called afterwards.
+ *
+ * The count is the minimum amount of surfaces. It is updated with the amount
+ * actually allocated, which is larger if a previous pool of the same decoder
+ * ran out of surfaces.
  */
-int va_pool_SetupDecoder(vlc_va_t *, va_pool_t *, AVCodecContext *, const video_format_t *, size_t count);
+int va_pool_SetupDecoder(vlc_va_t *, va_pool_t *, AVCodecContext *, const video_format_t *, unsigned *count);
 
 /**
- * Get a reference to an available surface or NULL on timeout
+ * Get a reference to an available surface, waiting for one to be released
+ * if needed, or NULL on timeout
  */
 vlc_va_surface_t *va_pool_Get(va_pool_t *);
 
@@ -281,7 +281,7 @@ static int Create(vlc_va_t *va, AVCodecContext *ctx, enum PixelFormat hwfmt, con
         goto error;
 
     fmt_out->i_chroma = i_vlc_chroma;
-    int err = va_pool_SetupDecoder(va, sys->va_pool, ctx, fmt_out, count);
+    int err = va_pool_SetupDecoder(va, sys->va_pool, ctx, fmt_out, &count);
     if (err != VLC_SUCCESS)
         goto error;
 
@@ -89,10 +89,13 @@ typedef struct
     int     i_late_frames;
     int64_t i_last_output_frame;
     vlc_tick_t i_last_late_delay;
+    /* running average of the time spent decoding a block */
+    vlc_tick_t i_decode_time;
 
     /* for direct rendering */
     bool        b_direct_rendering;
     atomic_bool b_dr_failure;
+    unsigned    i_dr_copies; /* pictures copied while using DR, under lock */
 
     /* Hack to force display of still pictures */
     bool b_first_frame;
@@ -111,11 +114,103 @@ typedef struct
     unsigned decoder_width;
     unsigned decoder_height;
 
+    /* threads accounted in the process budget, 0 if not accounted */
+    unsigned i_threads_wanted;
+    unsigned i_threads_generation;
+
     /* Protect dec->fmt_out, decoder_Update*() and decoder_NewPicture()
      * functions */
     vlc_mutex_t lock;
 } decoder_sys_t;
 
+/*****************************************************************************
+ * Decoding threads budget
+ *****************************************************************************
+ * The threads are shared between all the video decoders of the process, so
+ * that several concurrent streams do not oversubscribe the CPU. Each decoder
+ * gets a part of the budget proportional to the threads it would use alone.
+ *****************************************************************************/
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned    budget;
+    unsigned    wanted; /* sum of the threads wanted by the decoders */
+    atomic_uint generation; /* bumped when a decoder comes or goes */
+} lavc_threads = { VLC_STATIC_MUTEX, 0, 0, 0 };
+
+static unsigned ThreadsShareLocked( unsigned wanted )
+{
+    unsigned share = (uint64_t)lavc_threads.budget * wanted
+                   / lavc_threads.wanted;
+    return VLC_CLIP( share, 1, wanted );
+}
+
+static unsigned ThreadsRegister( decoder_t *p_dec, unsigned wanted,
+                                 unsigned *pi_generation )
+{
+    int64_t budget = var_InheritInteger( p_dec, "avcodec-threads-budget" );
+    if( budget <= 0 )
+        budget = vlc_GetCPUCount() + 1;
+
+    vlc_mutex_lock( &lavc_threads.lock );
+    lavc_threads.budget = __MIN( budget, UINT_MAX );
+    lavc_threads.wanted += wanted;
+    unsigned share = ThreadsShareLocked( wanted );
+    *pi_generation = atomic_fetch_add_explicit( &lavc_threads.generation, 1,
+                                                memory_order_relaxed ) + 1;
+    vlc_mutex_unlock( &lavc_threads.lock );
+    return share;
+}
+
+static void ThreadsUnregister( unsigned wanted )
+{
+    vlc_mutex_lock( &lavc_threads.lock );
+    assert( lavc_threads.wanted >= wanted );
+    lavc_threads.wanted -= wanted;
+    atomic_fetch_add_explicit( &lavc_threads.generation, 1,
+                               memory_order_relaxed );
+    vlc_mutex_unlock( &lavc_threads.lock );
+}
+
+static unsigned ThreadsShare( unsigned wanted )
+{
+    vlc_mutex_lock( &lavc_threads.lock );
+    unsigned share = ThreadsShareLocked( wanted );
+    vlc_mutex_unlock( &lavc_threads.lock );
+    return share;
+}
+
+/* Threads a decoder would use alone, depending on the codec and size */
+static unsigned GetWantedThreads( decoder_t *p_dec, const AVCodec *p_codec )
+{
+    unsigned i_count = vlc_GetCPUCount();
+    if( i_count > 1 )
+        i_count++;
+
+#if VLC_WINSTORE_APP
+    unsigned i_max = 6;
+#else
+    const video_format_t *fmt = &p_dec->fmt_in.video;
+    uint64_t i_pixels = (uint64_t)fmt->i_width * fmt->i_height;
+    bool b_heavy = p_codec->id == AV_CODEC_ID_HEVC;
+    unsigned i_max;
+
+    if( i_pixels > 0 && i_pixels <= 720 * 576 )
+        i_max = 4;
+    else if( i_pixels <= 1920 * 1088 ) /* or unknown */
+        i_max = b_heavy ? 10 : 6;
+    else
+    {
+        b_heavy = b_heavy || p_codec->id == AV_CODEC_ID_VP9;
+# if LIBAVCODEC_VERSION_CHECK( 57, 26, 0, 83, 101 )
+        b_heavy = b_heavy || p_codec->id == AV_CODEC_ID_AV1;
+# endif
+        i_max = b_heavy ? 16 : 8;
+    }
+#endif
+    return __MIN( i_count, i_max );
+}
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -163,6 +258,22 @@ static int lavc_GetVideoFormat(decoder_t *dec, video_format_t *restrict fmt,
             fmt->i_chroma = VLC_CODEC_RGB32;
 
         avcodec_align_dimensions2(ctx, &width, &height, aligns);
+
+        /* Pad the width so that picture_Setup() gives pitches matching the
+         * libavcodec alignment, for direct rendering into output pictures */
+        const vlc_chroma_description_t *dsc =
+            vlc_fourcc_GetChromaDescription(fmt->i_chroma);
+        if (dsc != NULL)
+        {
+            int align = 1;
+            for (unsigned i = 0; i < dsc->plane_count; i++)
+            {
+                int modulo = aligns[i] * dsc->p[i].w.den;
+                if (modulo > align)
+                    align = modulo;
+            }
+            width = (width + align - 1) / align * align;
+        }
     }
 
     if( width == 0 || height == 0 || width > 8192 || height > 8192 ||
@@ -489,10 +600,7 @@ static int OpenVideoCodec( decoder_t *p_dec )
     }
 
     if( var_InheritBool(p_dec, "low-delay") )
-    {
         ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
-        ctx->active_thread_type = FF_THREAD_SLICE;
-    }
 
     ret = ffmpeg_OpenCodec( p_dec, ctx, codec );
     if( ret < 0 )
@@ -619,23 +727,6 @@ int InitVideoDec( vlc_object_t *obj )
     p_context->opaque = p_dec;
     p_context->reordered_opaque = 0;
 
-    int i_thread_count = var_InheritInteger( p_dec, "avcodec-threads" );
-    if( i_thread_count <= 0 )
-    {
-        i_thread_count = vlc_GetCPUCount();
-        if( i_thread_count > 1 )
-            i_thread_count++;
-
-        //FIXME: take in count the decoding time
-#if VLC_WINSTORE_APP
-        i_thread_count = __MIN( i_thread_count, 6 );
-#else
-        i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 10 : 6 );
-#endif
-    }
-    i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 32 : 16 );
-    msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
-    p_context->thread_count = i_thread_count;
     p_context->thread_safe_callbacks = true;
 
     switch( p_codec->id )
@@ -658,6 +749,27 @@ int InitVideoDec( vlc_object_t *obj )
             break;
     }
 
+    /* Frame threads delay the output by one frame per thread */
+    if( var_InheritBool( p_dec, "low-delay" ) )
+        p_context->thread_type &= FF_THREAD_SLICE;
+
+    int i_thread_count = var_InheritInteger( p_dec, "avcodec-threads" );
+    if( i_thread_count <= 0 )
+    {
+        unsigned i_wanted = GetWantedThreads( p_dec, p_codec );
+        if( p_context->thread_type != 0 )
+        {
+            i_thread_count = ThreadsRegister( p_dec, i_wanted,
+                                              &p_sys->i_threads_generation );
+            p_sys->i_threads_wanted = i_wanted;
+        }
+        else
+            i_thread_count = i_wanted;
+    }
+    i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 32 : 16 );
+    msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
+    p_context->thread_count = i_thread_count;
+
     if( p_context->thread_type & FF_THREAD_FRAME )
         p_dec->i_extra_picture_buffers = 2 * p_context->thread_count;
 
@@ -668,6 +780,7 @@ int InitVideoDec( vlc_object_t *obj )
     p_sys->b_from_preroll = false;
     p_sys->i_last_output_frame = -1;
     p_sys->framedrop = FRAMEDROP_NONE;
+    p_sys->i_decode_time = 0;
 
     /* Set output properties */
     if( GetVlcChroma( &p_dec->fmt_out.video, p_context->pix_fmt ) != VLC_SUCCESS )
@@ -693,6 +806,8 @@ int InitVideoDec( vlc_object_t *obj )
     /* ***** Open the codec ***** */
     if( OpenVideoCodec( p_dec ) < 0 )
     {
+        if( p_sys->i_threads_wanted > 0 )
+            ThreadsUnregister( p_sys->i_threads_wanted );
         free( p_sys );
         avcodec_free_context( &p_context );
         return VLC_EGENERIC;
@@ -754,10 +869,12 @@ static block_t * filter_earlydropped_blocks( decoder_t *p_dec, block_t *block )
         p_sys->i_last_late_delay = INT64_MAX;
     }
 
-    if( p_sys->i_late_frames == 0 )
+    if( p_sys->i_late_frames == 0
+     && p_sys->framedrop == FRAMEDROP_AGGRESSIVE_RECOVER )
         p_sys->framedrop = FRAMEDROP_NONE;
 
-    if( p_sys->framedrop == FRAMEDROP_NONE && p_sys->i_late_frames < 11 )
+    if( p_sys->framedrop != FRAMEDROP_AGGRESSIVE_RECOVER
+     && p_sys->i_late_frames < 11 )
         return block;
 
     if( p_sys->i_last_output_frame >= 0 &&
@@ -817,6 +934,32 @@ static void update_late_frame_count( decoder_t *p_dec, block_t *p_block,
    vlc_tick_t i_threshold = i_next_pts != VLC_TICK_INVALID
                           ? (i_next_pts - i_pts) / 2 : VLC_TICK_FROM_MS(20);
 
+   /* Predict lateness from the decoding time: if the next frames are not
+    * expected to be decoded before their display date, skip the non
+    * reference ones in the decoder, before they are decoded late and
+    * dropped by the vout. */
+   if( i_display_date != VLC_TICK_INVALID && p_sys->b_hurry_up
+    && p_dec->b_frame_drop_allowed && !p_sys->b_from_preroll )
+   {
+       vlc_tick_t i_slack = i_display_date - current_time;
+
+       if( p_sys->framedrop == FRAMEDROP_NONE
+        && i_slack < p_sys->i_decode_time )
+       {
+           msg_Dbg( p_dec, "decoding is getting late (%"PRId64" ms ahead, "
+                    "%"PRId64" ms per block), skipping non reference frames",
+                    MS_FROM_VLC_TICK(i_slack),
+                    MS_FROM_VLC_TICK(p_sys->i_decode_time) );
+           p_sys->framedrop = FRAMEDROP_NONREF;
+       }
+       else if( p_sys->framedrop == FRAMEDROP_NONREF
+             && i_slack > 4 * p_sys->i_decode_time + i_threshold )
+       {
+           msg_Dbg( p_dec, "decoding caught up, decoding all frames" );
+           p_sys->framedrop = FRAMEDROP_NONE;
+       }
+   }
+
    if( i_display_date != VLC_TICK_INVALID && i_display_date + i_threshold <= current_time )
    {
        /* Out of preroll, consider only late frames on rising delay */
@@ -1270,6 +1413,9 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
                 break;
             }
 
+            if( p_sys->b_direct_rendering )
+                p_sys->i_dr_copies++;
+
             /* Fill picture_t from AVFrame */
             if( lavc_CopyPicture( p_dec, p_pic, frame ) != VLC_SUCCESS )
             {
@@ -1376,7 +1522,37 @@ static int DecodeVideo( decoder_t *p_dec, block_t *p_block )
         }
     }
 
-    return DecodeBlock( p_dec, pp_block );
+    if( p_block == NULL )
+        return DecodeBlock( p_dec, pp_block );
+
+    /* Follow the budget when other decoders came or went, from a keyframe
+     * only, as reopening the codec restarts the decoding from there */
+    if( p_sys->i_threads_wanted > 0 && p_sys->p_va == NULL &&
+        (p_block->i_flags & BLOCK_FLAG_TYPE_I) &&
+        !(p_block->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED) &&
+        atomic_load_explicit( &lavc_threads.generation,
+                              memory_order_relaxed ) != p_sys->i_threads_generation )
+    {
+        p_sys->i_threads_generation =
+            atomic_load_explicit( &lavc_threads.generation,
+                                  memory_order_relaxed );
+        unsigned i_share = ThreadsShare( p_sys->i_threads_wanted );
+        unsigned i_count = p_sys->p_context->thread_count;
+        if( i_share >= 2 * i_count || i_count >= 2 * i_share )
+        {
+            msg_Dbg( p_dec, "threads budget changed (%u -> %u), reloading",
+                     i_count, i_share );
+            DecodeBlock( p_dec, NULL );
+            return VLCDEC_RELOAD;
+        }
+    }
+
+    /* Update the decoding time model, with frame threads too, as the
+     * decoder blocks when all its threads are busy. */
+    vlc_tick_t start = vlc_tick_now();
+    int ret = DecodeBlock( p_dec, pp_block );
+    p_sys->i_decode_time += (vlc_tick_now() - start - p_sys->i_decode_time) / 8;
+    return ret;
 }
 
 /*****************************************************************************
@@ -1397,11 +1573,18 @@ void EndVideoDec( vlc_object_t *obj )
 
     cc_Flush( &p_sys->cc );
 
+    if( p_sys->i_dr_copies > 0 )
+        msg_Dbg( p_dec, "direct rendering fallback: %u picture(s) copied",
+                 p_sys->i_dr_copies );
+
     avcodec_free_context( &ctx );
 
     if( p_sys->p_va )
         vlc_va_Delete( p_sys->p_va );
 
+    if( p_sys->i_threads_wanted > 0 )
+        ThreadsUnregister( p_sys->i_threads_wanted );
+
     free( p_sys );
 }
 
@@ -1521,7 +1704,10 @@ static int lavc_dr_GetFrame(struct AVCodecContext *ctx, AVFrame *frame)
 
     picture_t *pic = decoder_NewPicture(dec);
     if (pic == NULL)
+    {
+        msg_Dbg(dec, "no output picture available for direct rendering");
         return -1;
+    }
 
     int width = frame->width;
     int height = frame->height;
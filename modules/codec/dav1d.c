@@ -54,6 +54,9 @@ static void CloseDecoder(vlc_object_t *);
 #define THREAD_FRAMES_LONGTEXT N_( "Max number of threads used for frame decoding, default 0=auto" )
 #define THREAD_TILES_TEXT N_("Tiles Threads")
 #define THREAD_TILES_LONGTEXT N_( "Max number of threads used for tile decoding, default 0=auto" )
+#define FILM_GRAIN_TEXT N_("Apply film grain")
+#define FILM_GRAIN_LONGTEXT N_( "Synthesize the film grain signaled by the " \
+    "stream. Disabling it saves a significant part of the decoding time." )
 
 
 vlc_module_begin ()
@@ -68,6 +71,8 @@ vlc_module_begin ()
                 THREAD_FRAMES_TEXT, THREAD_FRAMES_LONGTEXT, false)
     add_integer("dav1d-thread-tiles", 0,
                 THREAD_TILES_TEXT, THREAD_TILES_LONGTEXT, false)
+    add_bool("dav1d-film-grain", true,
+             FILM_GRAIN_TEXT, FILM_GRAIN_LONGTEXT, true)
 vlc_module_end ()
 
 /*****************************************************************************
@@ -78,6 +83,7 @@ typedef struct
     Dav1dSettings s;
     Dav1dContext *c;
     cc_data_t cc;
+    bool b_grain_skipped;
 } decoder_sys_t;
 
 struct user_data_s
@@ -334,6 +340,12 @@ static int Decode(decoder_t *dec, block_t *block)
                     b_output_error = true;
                     break;
                 }
+                if (!p_sys->s.apply_grain && !p_sys->b_grain_skipped &&
+                    img.frame_hdr && img.frame_hdr->film_grain.present)
+                {
+                    msg_Dbg(dec, "film grain signaled but not applied");
+                    p_sys->b_grain_skipped = true;
+                }
                 pic->b_progressive = true; /* codec does not support interlacing */
                 pic->date = img.m.timestamp;
                 decoder_QueueVideo(dec, pic);
@@ -386,7 +398,15 @@ static int OpenDecoder(vlc_object_t *p_this)
         p_sys->s.n_tile_threads = VLC_CLIP(vlc_GetCPUCount(), 1, 4);
     p_sys->s.n_frame_threads = var_InheritInteger(p_this, "dav1d-thread-frames");
     if (p_sys->s.n_frame_threads == 0)
-        p_sys->s.n_frame_threads = __MAX(1, vlc_GetCPUCount());
+    {
+        /* each frame thread delays the output by one frame */
+        if (var_InheritBool(p_this, "low-delay"))
+            p_sys->s.n_frame_threads = 1;
+        else
+            p_sys->s.n_frame_threads = __MAX(1, vlc_GetCPUCount());
+    }
+    p_sys->s.apply_grain = var_InheritBool(p_this, "dav1d-film-grain");
+    p_sys->b_grain_skipped = false;
     p_sys->s.allocator.cookie = dec;
     p_sys->s.allocator.alloc_picture_callback = NewPicture;
     p_sys->s.allocator.release_picture_callback = FreePicture;
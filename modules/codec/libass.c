@@ -101,6 +101,26 @@ static void SubpictureUpdate( subpicture_t *,
                               vlc_tick_t );
 static void SubpictureDestroy( subpicture_t * );
 
+#define LIBASS_MAX_REGION 4
+
+typedef struct
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} rectangle_t;
+
+/* Picture drawn for a region during the previous update, kept so that
+ * an identical region can reuse it instead of being blended again */
+typedef struct
+{
+    int         i_width;
+    int         i_height;
+    uint32_t    i_hash;
+    picture_t   *p_picture;
+} libass_region_cache_t;
+
 typedef struct
 {
     decoder_sys_t *p_dec_sys;
@@ -109,17 +129,13 @@ typedef struct
     vlc_tick_t    i_pts;
 
     ASS_Image     *p_img;
-} libass_spu_updater_sys_t;
 
-typedef struct
-{
-    int x0;
-    int y0;
-    int x1;
-    int y1;
-} rectangle_t;
+    libass_region_cache_t cache[LIBASS_MAX_REGION];
+    int           i_cache;
+} libass_spu_updater_sys_t;
 
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
+static uint32_t RegionHash( const rectangle_t *p_region, const ASS_Image *p_img );
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
 
 //#define DEBUG_REGION
@@ -372,6 +388,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     }
 
     p_spu_sys->p_img = NULL;
+    p_spu_sys->i_cache = 0;
     p_spu_sys->p_dec_sys = p_sys;
     p_spu_sys->i_subs_len = p_block->i_buffer;
     p_spu_sys->p_subs_data = malloc( p_block->i_buffer );
@@ -476,15 +493,14 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
      * reinstanciate a lot the scaler, and as we do not support subpel blending
      * it looks ugly (text unaligned).
      */
-    const int i_max_region = 4;
-    rectangle_t region[i_max_region];
-    const int i_region = BuildRegions( region, i_max_region, p_img, fmt.i_width, fmt.i_height );
+    rectangle_t region[LIBASS_MAX_REGION];
+    const int i_region = BuildRegions( region, LIBASS_MAX_REGION, p_img, fmt.i_width, fmt.i_height );
 
-    if( i_region <= 0 )
-    {
-        vlc_mutex_unlock( &p_sys->lock );
-        return;
-    }
+    /* Pictures of the previous update, reused by identical regions */
+    libass_region_cache_t cache[LIBASS_MAX_REGION];
+    const int i_cache = p_spusys->i_cache;
+    memcpy( cache, p_spusys->cache, i_cache * sizeof(*cache) );
+    p_spusys->i_cache = 0;
 
     /* Allocate the regions and draw them */
     subpicture_region_t **pp_region_last = &p_subpic->p_region;
@@ -493,6 +509,7 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
     {
         subpicture_region_t *r;
         video_format_t fmt_region;
+        libass_region_cache_t *p_cached = NULL;
 
         /* */
         fmt_region = fmt;
@@ -508,8 +525,38 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         r->i_y = region[i].y0;
         r->i_align = SUBPICTURE_ALIGN_TOP | SUBPICTURE_ALIGN_LEFT;
 
-        /* */
-        RegionDraw( r, p_img );
+        /* Regions whose content only moved, or did not change at all, keep
+         * their previous picture: it is not blended again, and renderers
+         * caching uploads per picture (OpenGL atlas) do not upload it again */
+        const uint32_t i_hash = RegionHash( &region[i], p_img );
+        for( int j = 0; j < i_cache; j++ )
+        {
+            if( cache[j].p_picture != NULL &&
+                cache[j].i_width == (int)fmt_region.i_width &&
+                cache[j].i_height == (int)fmt_region.i_height &&
+                cache[j].i_hash == i_hash )
+            {
+                p_cached = &cache[j];
+                break;
+            }
+        }
+
+        if( p_cached )
+        {
+            picture_Release( r->p_picture );
+            r->p_picture = p_cached->p_picture;
+            p_cached->p_picture = NULL;
+        }
+        else
+        {
+            RegionDraw( r, p_img );
+        }
+
+        libass_region_cache_t *p_entry = &p_spusys->cache[p_spusys->i_cache++];
+        p_entry->i_width = fmt_region.i_width;
+        p_entry->i_height = fmt_region.i_height;
+        p_entry->i_hash = i_hash;
+        p_entry->p_picture = picture_Hold( r->p_picture );
 
         /* */
         *pp_region_last = r;
@@ -517,11 +564,18 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
     }
     vlc_mutex_unlock( &p_sys->lock );
 
+    for( int j = 0; j < i_cache; j++ )
+    {
+        if( cache[j].p_picture != NULL )
+            picture_Release( cache[j].p_picture );
+    }
 }
 static void SubpictureDestroy( subpicture_t *p_subpic )
 {
     libass_spu_updater_sys_t *p_spusys = p_subpic->updater.p_sys;
 
+    for( int i = 0; i < p_spusys->i_cache; i++ )
+        picture_Release( p_spusys->cache[i].p_picture );
     DecSysRelease( p_spusys->p_dec_sys );
     free( p_spusys->p_subs_data );
     free( p_spusys );
@@ -681,6 +735,42 @@ static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_i
     return i_region;
 }
 
+static bool RegionContains( const rectangle_t *p_region, const ASS_Image *p_img )
+{
+    return p_img->dst_x >= p_region->x0 && p_img->dst_x + p_img->w <= p_region->x1 &&
+           p_img->dst_y >= p_region->y0 && p_img->dst_y + p_img->h <= p_region->y1;
+}
+
+static uint32_t HashBytes( uint32_t i_hash, const void *p_data, size_t i_size )
+{
+    const uint8_t *p = p_data;
+    for( size_t i = 0; i < i_size; i++ )
+        i_hash = ( i_hash ^ p[i] ) * 16777619u;
+    return i_hash;
+}
+
+/* Signature of what RegionDraw would produce for a region, relative to its
+ * origin so that a moved but otherwise identical region matches */
+static uint32_t RegionHash( const rectangle_t *p_region, const ASS_Image *p_img )
+{
+    uint32_t i_hash = 2166136261u;
+
+    for( ; p_img != NULL; p_img = p_img->next )
+    {
+        if( !RegionContains( p_region, p_img ) )
+            continue;
+
+        const int p_desc[5] = {
+            p_img->dst_x - p_region->x0, p_img->dst_y - p_region->y0,
+            p_img->w, p_img->h, (int)p_img->color,
+        };
+        i_hash = HashBytes( i_hash, p_desc, sizeof(p_desc) );
+        for( int y = 0; y < p_img->h; y++ )
+            i_hash = HashBytes( i_hash, &p_img->bitmap[y*p_img->stride], p_img->w );
+    }
+    return i_hash;
+}
+
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
 {
     const plane_t *p = &p_region->p_picture->p[0];
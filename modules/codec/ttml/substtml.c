@@ -85,6 +85,10 @@ typedef struct
 typedef struct
 {
     vlc_dictionary_t regions;
+    /* attributes resolved per style references list and per region id,
+     * so that each cue walks the document only once per reference */
+    vlc_dictionary_t styles_cache;
+    vlc_dictionary_t regions_cache;
     tt_node_t *      p_rootnode; /* for now. FIXME: split header */
     ttml_length_t    root_extent_h, root_extent_v;
     unsigned         i_cell_resolution_v;
@@ -594,56 +598,84 @@ static void DictionaryMerge( const vlc_dictionary_t *p_src, vlc_dictionary_t *p_
     }
 }
 
-static void DictMergeWithStyleID( ttml_context_t *p_ctx, const char *psz_styles,
-                                  vlc_dictionary_t *p_dst )
+static void CachedDictDelete( void *p_dict, void *p_obj )
 {
-    assert(p_ctx->p_rootnode);
-    char *psz_dup;
-    if( psz_styles && p_ctx->p_rootnode && (psz_dup = strdup( psz_styles )) )
-    {
-        /* Use temp dict instead of reverse token processing to
-         * resolve styles in specified order */
-        vlc_dictionary_t tempdict;
-        vlc_dictionary_init( &tempdict, 0 );
+    VLC_UNUSED( p_obj );
+    vlc_dictionary_clear( p_dict, NULL, NULL );
+    free( p_dict );
+}
 
-        char *saveptr;
-        char *psz_id = strtok_r( psz_dup, " ", &saveptr );
-        while( psz_id )
-        {
-            /* Lookup referenced style ID */
-            const tt_node_t *p_node = FindNode( p_ctx->p_rootnode,
-                                                "style", -1, psz_id );
-            if( p_node )
-                DictionaryMerge( &p_node->attr_dict, &tempdict, true );
+static vlc_dictionary_t * ResolveStyleID( ttml_context_t *p_ctx, const char *psz_styles )
+{
+    vlc_dictionary_t *p_resolved =
+            vlc_dictionary_value_for_key( &p_ctx->styles_cache, psz_styles );
+    if( p_resolved != kVLCDictionaryNotFound )
+        return p_resolved;
 
-            psz_id = strtok_r( NULL, " ", &saveptr );
-        }
+    char *psz_dup = strdup( psz_styles );
+    p_resolved = malloc( sizeof(*p_resolved) );
+    if( !psz_dup || !p_resolved )
+    {
+        free( psz_dup );
+        free( p_resolved );
+        return NULL;
+    }
+    vlc_dictionary_init( p_resolved, 0 );
 
-        if( !vlc_dictionary_is_empty( &tempdict ) )
-            DictionaryMerge( &tempdict, p_dst, false );
+    /* Use temp dict instead of reverse token processing to
+     * resolve styles in specified order */
+    char *saveptr;
+    char *psz_id = strtok_r( psz_dup, " ", &saveptr );
+    while( psz_id )
+    {
+        /* Lookup referenced style ID */
+        const tt_node_t *p_node = FindNode( p_ctx->p_rootnode,
+                                            "style", -1, psz_id );
+        if( p_node )
+            DictionaryMerge( &p_node->attr_dict, p_resolved, true );
 
-        vlc_dictionary_clear( &tempdict, NULL, NULL );
-        free( psz_dup );
+        psz_id = strtok_r( NULL, " ", &saveptr );
     }
+    free( psz_dup );
+
+    vlc_dictionary_insert( &p_ctx->styles_cache, psz_styles, p_resolved );
+    return p_resolved;
 }
 
-static void DictMergeWithRegionID( ttml_context_t *p_ctx, const char *psz_id,
-                                   vlc_dictionary_t *p_dst )
+static void DictMergeWithStyleID( ttml_context_t *p_ctx, const char *psz_styles,
+                                  vlc_dictionary_t *p_dst )
 {
     assert(p_ctx->p_rootnode);
-    if( psz_id && p_ctx->p_rootnode )
+    if( psz_styles && p_ctx->p_rootnode )
     {
-        const tt_node_t *p_regionnode = FindNode( p_ctx->p_rootnode,
-                                                 "region", -1, psz_id );
-        if( !p_regionnode )
-            return;
+        const vlc_dictionary_t *p_resolved = ResolveStyleID( p_ctx, psz_styles );
+        if( p_resolved && !vlc_dictionary_is_empty( p_resolved ) )
+            DictionaryMerge( p_resolved, p_dst, false );
+    }
+}
+
+static vlc_dictionary_t * ResolveRegionID( ttml_context_t *p_ctx, const char *psz_id )
+{
+    vlc_dictionary_t *p_resolved =
+            vlc_dictionary_value_for_key( &p_ctx->regions_cache, psz_id );
+    if( p_resolved != kVLCDictionaryNotFound )
+        return p_resolved;
 
-        DictionaryMerge( &p_regionnode->attr_dict, p_dst, false );
+    p_resolved = malloc( sizeof(*p_resolved) );
+    if( !p_resolved )
+        return NULL;
+    vlc_dictionary_init( p_resolved, 0 );
+
+    const tt_node_t *p_regionnode = FindNode( p_ctx->p_rootnode,
+                                             "region", -1, psz_id );
+    if( p_regionnode )
+    {
+        DictionaryMerge( &p_regionnode->attr_dict, p_resolved, false );
 
         const char *psz_styleid = (const char *)
                 vlc_dictionary_value_for_key( &p_regionnode->attr_dict, "style" );
         if( psz_styleid )
-            DictMergeWithStyleID( p_ctx, psz_styleid, p_dst );
+            DictMergeWithStyleID( p_ctx, psz_styleid, p_resolved );
 
         for( const tt_basenode_t *p_child = p_regionnode->p_child;
                                   p_child; p_child = p_child->p_next )
@@ -654,10 +686,25 @@ static void DictMergeWithRegionID( ttml_context_t *p_ctx, const char *psz_id,
             const tt_node_t *p_node = (const tt_node_t *) p_child;
             if( !tt_node_NameCompare( p_node->psz_node_name, "style" ) )
             {
-                DictionaryMerge( &p_node->attr_dict, p_dst, false );
+                DictionaryMerge( &p_node->attr_dict, p_resolved, false );
             }
         }
     }
+
+    vlc_dictionary_insert( &p_ctx->regions_cache, psz_id, p_resolved );
+    return p_resolved;
+}
+
+static void DictMergeWithRegionID( ttml_context_t *p_ctx, const char *psz_id,
+                                   vlc_dictionary_t *p_dst )
+{
+    assert(p_ctx->p_rootnode);
+    if( psz_id && p_ctx->p_rootnode )
+    {
+        const vlc_dictionary_t *p_resolved = ResolveRegionID( p_ctx, psz_id );
+        if( p_resolved && !vlc_dictionary_is_empty( p_resolved ) )
+            DictionaryMerge( p_resolved, p_dst, false );
+    }
 }
 
 static void DictToTTMLStyle( ttml_context_t *p_ctx, const vlc_dictionary_t *p_dict,
@@ -1093,7 +1140,11 @@ static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playback
             context.p_rootnode = p_rootnode;
 
             vlc_dictionary_init( &context.regions, 1 );
+            vlc_dictionary_init( &context.styles_cache, 0 );
+            vlc_dictionary_init( &context.regions_cache, 0 );
             ConvertNodesToRegionContent( &context, p_bodynode, NULL, NULL, playbacktime );
+            vlc_dictionary_clear( &context.styles_cache, CachedDictDelete, NULL );
+            vlc_dictionary_clear( &context.regions_cache, CachedDictDelete, NULL );
 
             for( int i = 0; i < context.regions.i_size; ++i )
             {
@@ -44,6 +44,7 @@
 #include <vlc_player.h>
 #include <vlc_playlist.h>
 #include <vlc_actions.h>
+#include <vlc_memstats.h>
 
 #include <sys/types.h>
 #include <unistd.h>
@@ -1181,6 +1182,38 @@ out:
     aout_Release(p_aout);
 }
 
+static void MemoryStatistics(intf_thread_t *intf)
+{
+    static const char *const kinds[] = {
+        [VLC_MEMSTATS_BLOCK] = "block",
+        [VLC_MEMSTATS_PICTURE] = "picture",
+        [VLC_MEMSTATS_OBJRES] = "objres",
+    };
+    struct vlc_memstats_entry *entries;
+    ssize_t count = vlc_memstats_Get(&entries);
+
+    /* disabled unless VLC_MEMSTATS is set */
+    if (count <= 0)
+        return;
+
+    msg_print(intf, "+----[ begin of memory accounting ]");
+    msg_print(intf, "| %10s %8s %10s %8s %-7s %s", _("live KiB"),
+              _("live"), _("KiB/s"), _("allocs/s"), _("type"), _("site"));
+    /* only the sites holding the most memory */
+    for (ssize_t i = 0; i < count && i < 32; i++)
+    {
+        const struct vlc_memstats_entry *e = &entries[i];
+
+        msg_print(intf, "| %10.0f %8zu %10.1f %8.1f %-7s %s:%s (%p)",
+                  e->live_bytes / 1024., e->live_count,
+                  e->byte_rate / 1024., e->count_rate, kinds[e->kind],
+                  e->module ? e->module : "?", e->symbol ? e->symbol : "?",
+                  e->caller);
+    }
+    msg_print(intf, "+----[ end of memory accounting ]");
+    vlc_memstats_Release(entries, count);
+}
+
 static void Statistics(intf_thread_t *intf)
 {
     vlc_player_t *player = vlc_playlist_GetPlayer(intf->p_sys->playlist);
@@ -1234,6 +1267,8 @@ static void Statistics(intf_thread_t *intf)
         msg_print(intf,  "+----[ end of statistical info ]" );
     }
     vlc_player_Unlock(player);
+
+    MemoryStatistics(intf);
 }
 
 static void Quit(intf_thread_t *intf)
@@ -0,0 +1,132 @@
+/*
+ * Metrics.cpp
+ *****************************************************************************
+ * Copyright (C) 2016 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Metrics.hpp"
+#include "ID.hpp"
+#include "http/SegmentCache.hpp"
+#include "playlist/BaseRepresentation.h"
+#include "playlist/BaseAdaptationSet.h"
+
+#include <vlc_variables.h>
+
+using namespace adaptive;
+using namespace adaptive::http;
+using namespace adaptive::playlist;
+
+Metrics::Metrics(vlc_object_t *obj, SegmentCache *cache_)
+{
+    p_obj = obj;
+    cache = cache_;
+    vlc_mutex_init(&lock);
+}
+
+Metrics::~Metrics()
+{
+    std::set<std::string>::const_iterator it;
+    for(it = vars.begin(); it != vars.end(); ++it)
+        var_Destroy(p_obj, (*it).c_str());
+}
+
+std::string Metrics::varName(const ID &id, const char *psz_metric) const
+{
+    return std::string("adaptive-") + id.str() + "-" + psz_metric;
+}
+
+void Metrics::setInteger(const std::string &name, int64_t value)
+{
+    vlc_mutex_locker locker(&lock);
+    if(vars.find(name) == vars.end())
+    {
+        if(var_Create(p_obj, name.c_str(), VLC_VAR_INTEGER) != VLC_SUCCESS)
+            return;
+        vars.insert(name);
+    }
+    var_SetInteger(p_obj, name.c_str(), value);
+}
+
+void Metrics::setString(const std::string &name, const std::string &value)
+{
+    vlc_mutex_locker locker(&lock);
+    if(vars.find(name) == vars.end())
+    {
+        if(var_Create(p_obj, name.c_str(), VLC_VAR_STRING) != VLC_SUCCESS)
+            return;
+        vars.insert(name);
+    }
+    var_SetString(p_obj, name.c_str(), value.c_str());
+}
+
+void Metrics::updateCacheStats()
+{
+    if(!cache || !cache->isEnabled())
+        return;
+    uint64_t hits, misses;
+    cache->getStats(&hits, &misses);
+    setInteger("adaptive-cache-hits", hits);
+    setInteger("adaptive-cache-misses", misses);
+}
+
+void Metrics::updateDownloadRate(const ID &id, size_t size, vlc_tick_t time)
+{
+    if(size == 0 || time <= 0)
+        return;
+    setInteger(varName(id, "bandwidth"), size * 8 * CLOCK_FREQ / time);
+    setInteger(varName(id, "download-size"), size);
+    setInteger(varName(id, "download-time"), time);
+    updateCacheStats();
+}
+
+void Metrics::updateLatency(const ID &id, vlc_tick_t latency)
+{
+    setInteger(varName(id, "ttfb"), latency);
+}
+
+void Metrics::updateAheadTime(const ID &id, vlc_tick_t ahead)
+{
+    setInteger(varName(id, "ahead"), ahead);
+}
+
+void Metrics::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+        case SegmentTrackerEvent::SWITCHING:
+        {
+            BaseRepresentation *rep = event.u.switching.next;
+            if(rep && rep->getAdaptationSet())
+            {
+                const ID &id = rep->getAdaptationSet()->getID();
+                setString(varName(id, "representation"), rep->getID().str());
+                setInteger(varName(id, "representation-bandwidth"), rep->getBandwidth());
+            }
+            break;
+        }
+        case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+            setInteger(varName(*event.u.buffering_level.id, "buffer"),
+                       event.u.buffering_level.current);
+            updateCacheStats();
+            break;
+        default:
+            break;
+    }
+}
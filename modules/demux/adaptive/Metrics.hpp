@@ -0,0 +1,67 @@
+/*
+ * Metrics.hpp
+ *****************************************************************************
+ * Copyright (C) 2016 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "SegmentTracker.hpp"
+#include "logic/IDownloadRateObserver.h"
+
+#include <vlc_common.h>
+
+#include <set>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class SegmentCache;
+    }
+
+    class ID;
+
+    /* Publishes per stream playback and download statistics as object
+       variables, named adaptive-<stream id>-<metric>, for monitoring */
+    class Metrics : public IDownloadRateObserver,
+                    public SegmentTrackerListenerInterface
+    {
+        public:
+            Metrics(vlc_object_t *, http::SegmentCache *);
+            virtual ~Metrics();
+
+            virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t); /* impl */
+            virtual void trackerEvent(const SegmentTrackerEvent &); /* impl */
+            void updateLatency(const ID &, vlc_tick_t);
+            void updateAheadTime(const ID &, vlc_tick_t);
+
+        private:
+            std::string varName(const ID &, const char *) const;
+            void setInteger(const std::string &, int64_t);
+            void setString(const std::string &, const std::string &);
+            void updateCacheStats();
+
+            vlc_object_t *p_obj;
+            http::SegmentCache *cache;
+            vlc_mutex_t lock;
+            std::set<std::string> vars;
+    };
+}
+
+#endif // METRICS_HPP
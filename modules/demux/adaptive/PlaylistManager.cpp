@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
 #include <vlc_demux.h>
@@ -157,6 +158,15 @@ bool PlaylistManager::start()
     if(b_thread)
         return false;
 
+    /* Request init and first segments of all streams at once,
+       instead of each stream waiting for the previous ones */
+    if(var_InheritBool(p_demux, "adaptive-fast-start"))
+    {
+        std::vector<AbstractStream *>::const_iterator it;
+        for(it=streams.begin(); it!=streams.end(); ++it)
+            (*it)->prefetchStart();
+    }
+
     b_thread = !vlc_clone(&thread, managerThread,
                           static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT);
     if(!b_thread)
@@ -809,6 +819,18 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             if(predictivelogic)
                 conn->setDownloadRateObserver(predictivelogic);
             logic = predictivelogic;
+            break;
+        }
+        case AbstractAdaptationLogic::Hybrid:
+        {
+            char *psz_estimator = var_InheritString(p_demux, "adaptive-estimator");
+            AbstractAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(obj, psz_estimator ? psz_estimator : "");
+            free(psz_estimator);
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
         }
 
         default:
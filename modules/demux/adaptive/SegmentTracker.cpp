@@ -29,6 +29,11 @@
 #include "playlist/Segment.h"
 #include "playlist/SegmentChunk.hpp"
 #include "logic/AbstractAdaptationLogic.h"
+#include "logic/Representationselectors.hpp"
+#include "SharedResources.hpp"
+#include "Metrics.hpp"
+
+#include <limits>
 
 using namespace adaptive;
 using namespace adaptive::logic;
@@ -82,6 +87,7 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     resources = res;
     first = true;
     curNumber = next = 0;
+    nextPart = 0;
     initializing = true;
     index_sent = false;
     init_sent = false;
@@ -89,6 +95,8 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNKNOWN;
+    if(resources && resources->getMetrics())
+        registerListener(resources->getMetrics());
 }
 
 SegmentTracker::~SegmentTracker()
@@ -96,6 +104,43 @@ SegmentTracker::~SegmentTracker()
     reset();
 }
 
+void SegmentTracker::dropPrefetched()
+{
+    while(!prefetched.empty())
+    {
+        delete prefetched.front();
+        prefetched.pop_front();
+    }
+}
+
+void SegmentTracker::prefetchStart(AbstractConnectionManager *connManager)
+{
+    if(!adaptationSet || curRepresentation)
+        return;
+
+    /* Smallest first download, the logic will take over on next segment */
+    RepresentationSelector selector(std::numeric_limits<int>::max(),
+                                    std::numeric_limits<int>::max());
+    BaseRepresentation *rep = selector.lowest(adaptationSet);
+    if(!rep)
+        return;
+
+    notify(SegmentTrackerEvent(curRepresentation, rep));
+    curRepresentation = rep;
+
+    /* init, index, then the first media chunk */
+    for(;;)
+    {
+        const bool b_initializing = initializing;
+        SegmentChunk *chunk = getNextChunk(false, connManager);
+        if(!chunk)
+            break;
+        prefetched.push_back(chunk);
+        if(!b_initializing)
+            break;
+    }
+}
+
 void SegmentTracker::setAdaptationLogic(AbstractAdaptationLogic *logic_)
 {
     logic = logic_;
@@ -154,6 +199,7 @@ bool SegmentTracker::segmentsListReady() const
 
 void SegmentTracker::reset()
 {
+    dropPrefetched();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -171,6 +217,13 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     if(!adaptationSet)
         return NULL;
 
+    if(!prefetched.empty())
+    {
+        SegmentChunk *chunk = prefetched.front();
+        prefetched.pop_front();
+        return chunk;
+    }
+
     /* Ensure we don't keep chaining init/index without data */
     if( initializing )
     {
@@ -180,6 +233,10 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
             switch_allowed = true;
     }
 
+    /* Parts after the first one can't be switched */
+    if( nextPart )
+        switch_allowed = false;
+
     if( !switch_allowed ||
        (curRepresentation && !curRepresentation->getAdaptationSet()->isSegmentAligned()) )
         rep = curRepresentation;
@@ -251,7 +308,22 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         init_sent = true;
         segment = rep->getSegment(BaseRepresentation::INFOTYPE_INIT);
         if(segment)
+        {
+            /* Saves a round trip when the index directly follows */
+            ISegment *indexSegment = (!index_sent) ?
+                        rep->getSegment(BaseRepresentation::INFOTYPE_INDEX) : NULL;
+            if(indexSegment && indexSegment->canCoalesceAfter(segment, next, rep))
+            {
+                SegmentChunk *chunk = indexSegment->toCoalescedChunk(resources, connManager,
+                                                                     next, rep, segment);
+                if(chunk)
+                {
+                    index_sent = true;
+                    return chunk;
+                }
+            }
             return segment->toChunk(resources, connManager, next, rep);
+        }
     }
 
     if(!index_sent)
@@ -264,11 +336,28 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
 
     bool b_gap = false;
     segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA, next, &next, &b_gap);
+    if(segment && nextPart && segment->isComplete() && !segment->getPart(nextPart))
+    {
+        /* All parts were delivered before segment completion */
+        nextPart = 0;
+        segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA, next + 1, &next, &b_gap);
+    }
     if(!segment)
     {
         return NULL;
     }
 
+    /* Low latency: deliver parts of the segment still being published */
+    ISegment *part = NULL;
+    if(nextPart || !segment->isComplete())
+    {
+        part = segment->getPart(nextPart);
+        if(!part)
+            return NULL; /* wait for next part to be published */
+        if(nextPart)
+            b_gap = false;
+    }
+
     if(initializing)
     {
         b_gap = false;
@@ -276,14 +365,15 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+    ISegment *delivered = part ? part : segment;
+    SegmentChunk *chunk = delivered->toChunk(resources, connManager, next, rep);
 
     /* Notify new segment length for stats / logic */
     if(chunk)
     {
         const Timescale timescale = rep->inheritTimescale();
         notify(SegmentTrackerEvent(rep->getAdaptationSet()->getID(),
-                                   timescale.ToTime(segment->duration.Get())));
+                                   timescale.ToTime(delivered->duration.Get())));
     }
 
     /* We need to check segment/chunk format changes, as we can't rely on representation's (HLS)*/
@@ -302,7 +392,15 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     if(chunk)
     {
         curNumber = next;
-        next++;
+        if(part && (!segment->isComplete() || segment->getPart(nextPart + 1)))
+        {
+            nextPart++;
+        }
+        else
+        {
+            nextPart = 0;
+            next++;
+        }
     }
 
     return chunk;
@@ -335,6 +433,7 @@ bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool try
 
 void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
 {
+    dropPrefetched();
     if(restarted)
     {
         initializing = true;
@@ -342,6 +441,7 @@ void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
         init_sent = false;
     }
     curNumber = next = segnumber;
+    nextPart = 0;
 }
 
 vlc_tick_t SegmentTracker::getPlaybackTime() const
@@ -386,6 +486,8 @@ void SegmentTracker::notifyBufferingState(bool enabled) const
 void SegmentTracker::notifyBufferingLevel(vlc_tick_t min, vlc_tick_t current, vlc_tick_t target) const
 {
     notify(SegmentTrackerEvent(adaptationSet->getID(), min, current, target));
+    if(resources && resources->getMetrics())
+        resources->getMetrics()->updateAheadTime(adaptationSet->getID(), getMinAheadTime());
 }
 
 void SegmentTracker::registerListener(SegmentTrackerListenerInterface *listener)
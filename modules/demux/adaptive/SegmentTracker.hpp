@@ -127,6 +127,8 @@ namespace adaptive
             bool segmentsListReady() const;
             void reset();
             SegmentChunk* getNextChunk(bool, AbstractConnectionManager *);
+            /* Startup: starts init and first media downloads at lowest rate */
+            void prefetchStart(AbstractConnectionManager *);
             bool setPositionByTime(vlc_tick_t, bool, bool);
             void setPositionByNumber(uint64_t, bool);
             vlc_tick_t getPlaybackTime() const; /* Current segment start time if selected */
@@ -140,12 +142,15 @@ namespace adaptive
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            void dropPrefetched();
+            std::list<SegmentChunk *> prefetched;
             bool first;
             bool initializing;
             bool index_sent;
             bool init_sent;
             uint64_t next;
             uint64_t curNumber;
+            std::size_t nextPart;
             StreamFormat format;
             SharedResources *resources;
             AbstractAdaptationLogic *logic;
@@ -24,7 +24,9 @@
 #include "SharedResources.hpp"
 #include "http/AuthStorage.hpp"
 #include "http/HTTPConnectionManager.h"
+#include "http/SegmentCache.hpp"
 #include "encryption/Keyring.hpp"
+#include "Metrics.hpp"
 
 #include <vlc_common.h>
 
@@ -38,11 +40,17 @@ SharedResources::SharedResources(vlc_object_t *obj, bool local)
     if(m && local)
         m->setLocalConnectionsAllowed();
     connManager = m;
+    segmentCache = new SegmentCache(obj, (size_t) var_InheritInteger(obj, "adaptive-cachesize") << 20);
+    metrics = new Metrics(obj, segmentCache);
+    if(m)
+        m->setMetrics(metrics);
 }
 
 SharedResources::~SharedResources()
 {
     delete connManager;
+    delete metrics;
+    delete segmentCache;
     delete encryptionKeyring;
     delete authStorage;
 }
@@ -61,3 +69,13 @@ AbstractConnectionManager * SharedResources::getConnManager()
 {
     return connManager;
 }
+
+SegmentCache * SharedResources::getSegmentCache()
+{
+    return segmentCache;
+}
+
+Metrics * SharedResources::getMetrics()
+{
+    return metrics;
+}
@@ -28,6 +28,7 @@ namespace adaptive
     {
         class AuthStorage;
         class AbstractConnectionManager;
+        class SegmentCache;
     }
 
     namespace encryption
@@ -35,6 +36,8 @@ namespace adaptive
         class Keyring;
     }
 
+    class Metrics;
+
     using namespace http;
     using namespace encryption;
 
@@ -46,11 +49,15 @@ namespace adaptive
             AuthStorage *getAuthStorage();
             Keyring     *getKeyring();
             AbstractConnectionManager *getConnManager();
+            SegmentCache *getSegmentCache();
+            Metrics     *getMetrics();
 
         private:
             AuthStorage *authStorage;
             Keyring *encryptionKeyring;
             AbstractConnectionManager *connManager;
+            SegmentCache *segmentCache;
+            Metrics *metrics;
     };
 }
 
@@ -141,6 +141,13 @@ void AbstractStream::prepareRestart(bool b_discontinuity)
     }
 }
 
+void AbstractStream::prefetchStart()
+{
+    vlc_mutex_locker locker(&lock);
+    if(valid && !disabled)
+        segmentTracker->prefetchStart(connManager);
+}
+
 void AbstractStream::setLanguage(const std::string &lang)
 {
     language = lang;
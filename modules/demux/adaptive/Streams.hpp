@@ -91,6 +91,7 @@ namespace adaptive
         bool getMediaPlaybackTimes(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *,
                                    vlc_tick_t *, vlc_tick_t *) const;
         void runUpdates();
+        void prefetchStart();
 
         /* Used by demuxers fake streams */
         virtual std::string getContentType(); /* impl */
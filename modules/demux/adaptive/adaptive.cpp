@@ -73,6 +73,30 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
+#define ADAPT_ESTIMATOR_TEXT N_("Throughput estimator")
+#define ADAPT_ESTIMATOR_LONGTEXT N_("Download rate estimation used by the hybrid logic")
+
+#define ADAPT_WORKERS_TEXT N_("Download workers")
+#define ADAPT_WORKERS_LONGTEXT N_("Number of segments downloaded in parallel, " \
+                                  "scheduled fairly across the streams")
+
+#define ADAPT_HTTP2_TEXT N_("Use HTTP/2 when available")
+#define ADAPT_HTTP2_LONGTEXT N_("Share a single multiplexed HTTP/2 session " \
+                                "per HTTPS server for all requests")
+
+#define ADAPT_CACHE_TEXT N_("Segment cache size (MiB)")
+#define ADAPT_CACHE_LONGTEXT N_("Memory used to keep downloaded segments for " \
+                                "reuse on quality switches or seeks. 0 disables it.")
+
+#define ADAPT_SHAREDTTL_TEXT N_("Cross session keys lifetime (s)")
+#define ADAPT_SHAREDTTL_LONGTEXT N_("Keeps encryption keys, and cookies when not " \
+                                    "provided by the player, for reuse by next " \
+                                    "adaptive streams. 0 disables sharing.")
+
+#define ADAPT_FASTSTART_TEXT N_("Fast start")
+#define ADAPT_FASTSTART_LONGTEXT N_("Download the initialization and first segments " \
+                                    "of all streams in parallel, at the lowest quality")
+
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
@@ -80,6 +104,7 @@ static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
                                 AbstractAdaptationLogic::NearOptimal,
+                                AbstractAdaptationLogic::Hybrid,
                                 AbstractAdaptationLogic::RateBased,
                                 AbstractAdaptationLogic::FixedRate,
                                 AbstractAdaptationLogic::AlwaysLowest,
@@ -89,6 +114,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -97,11 +123,21 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Throughput and Buffer Hybrid"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
                                            N_("Highest Bandwidth/Quality")};
 
+static const char *const ppsz_estimators_values[] = {
+                                "harmonic",
+                                "ewma",
+                                "percentile"};
+
+static const char *const ppsz_estimators[] = { N_("Harmonic mean"),
+                                               N_("Exponential moving average"),
+                                               N_("Sliding percentile")};
+
 static_assert( ARRAY_SIZE( pi_logics ) == ARRAY_SIZE( ppsz_logics ),
     "pi_logics and ppsz_logics shall have the same number of elements" );
 
@@ -116,11 +152,23 @@ vlc_module_begin ()
         set_subcategory( SUBCAT_INPUT_DEMUX )
         add_string( "adaptive-logic",  "", ADAPT_LOGIC_TEXT, NULL, false )
             change_string_list( ppsz_logics_values, ppsz_logics )
+        add_string( "adaptive-estimator", "harmonic", ADAPT_ESTIMATOR_TEXT,
+                    ADAPT_ESTIMATOR_LONGTEXT, true )
+            change_string_list( ppsz_estimators_values, ppsz_estimators )
         add_integer( "adaptive-maxwidth",  0,
                      ADAPT_WIDTH_TEXT,  ADAPT_WIDTH_TEXT,  false )
         add_integer( "adaptive-maxheight", 0,
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
+        add_integer_with_range( "adaptive-workers", 3, 1, 8,
+                                ADAPT_WORKERS_TEXT, ADAPT_WORKERS_LONGTEXT, true )
+        add_bool   ( "adaptive-http2", true, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true )
+        add_integer_with_range( "adaptive-cachesize", 32, 0, 1024,
+                                ADAPT_CACHE_TEXT, ADAPT_CACHE_LONGTEXT, true )
+        add_integer( "adaptive-shared-ttl", 0,
+                     ADAPT_SHAREDTTL_TEXT, ADAPT_SHAREDTTL_LONGTEXT, true )
+        add_bool   ( "adaptive-fast-start", false, ADAPT_FASTSTART_TEXT,
+                     ADAPT_FASTSTART_LONGTEXT, true )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
         set_callbacks( Open, Close )
 vlc_module_end ()
@@ -268,17 +316,16 @@ static PlaylistManager * HandleDash(demux_t *p_demux, DOMParser &xmlParser,
                                     const std::string & playlisturl,
                                     AbstractAdaptationLogic::LogicType logic)
 {
-    if(!xmlParser.reset(p_demux->s) || !xmlParser.parse(true))
+    if(!xmlParser.reset(p_demux->s))
     {
         msg_Err(p_demux, "Cannot parse MPD");
         return NULL;
     }
-    IsoffMainParser mpdparser(xmlParser.getRootNode(), VLC_OBJECT(p_demux),
-                              p_demux->s, playlisturl);
-    MPD *p_playlist = mpdparser.parse();
+    IsoffMainParser mpdparser(VLC_OBJECT(p_demux), p_demux->s, playlisturl);
+    MPD *p_playlist = mpdparser.parse(xmlParser);
     if(p_playlist == NULL)
     {
-        msg_Err( p_demux, "Cannot create/unknown MPD for profile");
+        msg_Err( p_demux, "Cannot parse MPD or unknown MPD for profile");
         return NULL;
     }
 
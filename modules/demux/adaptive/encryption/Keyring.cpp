@@ -26,14 +26,28 @@
 #include "../tools/Retrieve.hpp"
 
 #include <vlc_block.h>
+#include <vlc_cxx_helpers.hpp>
 
 #include <algorithm>
 
 using namespace adaptive::encryption;
 
+namespace
+{
+    struct SharedKey
+    {
+        KeyringKey key;
+        vlc_tick_t expiry;
+    };
+}
+
+static vlc::threads::mutex sharedlock;
+static std::map<std::string, SharedKey> sharedkeys;
+
 Keyring::Keyring(vlc_object_t *obj_)
 {
     obj = obj_;
+    sharedttl = VLC_TICK_FROM_SEC(var_InheritInteger(obj, "adaptive-shared-ttl"));
     vlc_mutex_init(&lock);
 }
 
@@ -41,6 +55,53 @@ Keyring::~Keyring()
 {
 }
 
+KeyringKey Keyring::getSharedKey(const std::string &uri)
+{
+    KeyringKey key;
+    vlc::threads::mutex_locker locker(sharedlock);
+    std::map<std::string, SharedKey>::iterator it = sharedkeys.find(uri);
+    if(it != sharedkeys.end())
+    {
+        if((*it).second.expiry > vlc_tick_now())
+            key = (*it).second.key;
+        else
+            sharedkeys.erase(it);
+    }
+    return key;
+}
+
+void Keyring::storeSharedKey(const std::string &uri, const KeyringKey &key, vlc_tick_t ttl)
+{
+    const vlc_tick_t now = vlc_tick_now();
+    vlc::threads::mutex_locker locker(sharedlock);
+    /* purge expired ones */
+    std::map<std::string, SharedKey>::iterator it = sharedkeys.begin();
+    while(it != sharedkeys.end())
+    {
+        if((*it).second.expiry <= now)
+            sharedkeys.erase(it++);
+        else
+            ++it;
+    }
+    if(sharedkeys.size() >= Keyring::MAX_KEYS)
+        return;
+    SharedKey shared;
+    shared.key = key;
+    shared.expiry = now + ttl;
+    sharedkeys[uri] = shared;
+}
+
+void Keyring::insertKey(const std::string &uri, const KeyringKey &key)
+{
+    keys.insert(std::pair<std::string, KeyringKey>(uri, key));
+    lru.push_front(uri);
+    if(lru.size() > Keyring::MAX_KEYS)
+    {
+        keys.erase(keys.find(lru.back()));
+        lru.pop_back();
+    }
+}
+
 KeyringKey Keyring::getKey(SharedResources *resources, const std::string &uri)
 {
     KeyringKey key;
@@ -49,25 +110,31 @@ KeyringKey Keyring::getKey(SharedResources *resources, const std::string &uri)
     std::map<std::string, KeyringKey>::iterator it = keys.find(uri);
     if(it == keys.end())
     {
-        /* Pretty bad inside the lock */
-        msg_Dbg(obj, "Retrieving AES key %s", uri.c_str());
-        block_t *p_block = Retrieve::HTTP(resources, uri);
-        if(p_block)
+        /* Might have been fetched by a previous session */
+        if(sharedttl > 0)
+            key = getSharedKey(uri);
+
+        if(key.empty())
         {
-            if(p_block->i_buffer == 16)
+            /* Pretty bad inside the lock */
+            msg_Dbg(obj, "Retrieving AES key %s", uri.c_str());
+            block_t *p_block = Retrieve::HTTP(resources, uri);
+            if(p_block)
             {
-                key.resize(16);
-                memcpy(&key[0], p_block->p_buffer, 16);
-                keys.insert(std::pair<std::string, KeyringKey>(uri, key));
-                lru.push_front(uri);
-                if(lru.size() > Keyring::MAX_KEYS)
+                if(p_block->i_buffer == 16)
                 {
-                    keys.erase(keys.find(lru.back()));
-                    lru.pop_back();
+                    key.resize(16);
+                    memcpy(&key[0], p_block->p_buffer, 16);
+                    if(sharedttl > 0)
+                        storeSharedKey(uri, key, sharedttl);
                 }
+                block_Release(p_block);
             }
-            block_Release(p_block);
         }
+        else msg_Dbg(obj, "Reusing shared AES key %s", uri.c_str());
+
+        if(!key.empty())
+            insertKey(uri, key);
     }
     else
     {
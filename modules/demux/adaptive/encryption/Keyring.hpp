@@ -44,10 +44,15 @@ namespace adaptive
 
             private:
                 static const int MAX_KEYS = 50;
+                void insertKey(const std::string &, const KeyringKey &);
+                /* process wide storage, shared by all instances */
+                static KeyringKey getSharedKey(const std::string &);
+                static void storeSharedKey(const std::string &, const KeyringKey &, vlc_tick_t);
                 std::map<std::string, KeyringKey> keys;
                 std::list<std::string> lru;
                 vlc_object_t *obj;
                 vlc_mutex_t lock;
+                vlc_tick_t sharedttl;
         };
     }
 }
@@ -24,13 +24,47 @@
 #include "AuthStorage.hpp"
 #include "ConnectionParams.hpp"
 
+#include <vlc_cxx_helpers.hpp>
+
 using namespace adaptive::http;
 
+namespace
+{
+    /* Process wide jar, used across sessions when the player has none */
+    class SharedCookieJar
+    {
+        public:
+            SharedCookieJar() : p_jar( NULL ) {}
+            ~SharedCookieJar()
+            {
+                if( p_jar )
+                    vlc_http_cookies_destroy( p_jar );
+            }
+            vlc_http_cookie_jar_t * get()
+            {
+                vlc::threads::mutex_locker locker( lock );
+                if( !p_jar )
+                    p_jar = vlc_http_cookies_new();
+                return p_jar;
+            }
+
+        private:
+            vlc::threads::mutex lock;
+            vlc_http_cookie_jar_t *p_jar;
+    };
+}
+
+static SharedCookieJar sharedjar;
+
 AuthStorage::AuthStorage( vlc_object_t *p_obj )
 {
     if ( var_InheritBool( p_obj, "http-forward-cookies" ) )
+    {
         p_cookies_jar = static_cast<vlc_http_cookie_jar_t *>
                 (var_InheritAddress( p_obj, "http-cookies" ));
+        if( !p_cookies_jar && var_InheritInteger( p_obj, "adaptive-shared-ttl" ) > 0 )
+            p_cookies_jar = sharedjar.get();
+    }
     else
         p_cookies_jar = NULL;
 }
@@ -47,6 +81,11 @@ void AuthStorage::addCookie( const std::string &cookie, const ConnectionParams &
                             params.getHostname().c_str(), params.getPath().c_str() );
 }
 
+vlc_http_cookie_jar_t * AuthStorage::getCookieJar() const
+{
+    return p_cookies_jar;
+}
+
 std::string AuthStorage::getCookie( const ConnectionParams &params, bool secure )
 {
     if( !p_cookies_jar )
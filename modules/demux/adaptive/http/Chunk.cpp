@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -210,9 +211,19 @@ block_t * HTTPChunkSource::read(size_t readsize)
     }
 
     vlc_tick_t time = vlc_tick_now();
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
-    time = vlc_tick_now() - time;
-    if(ret < 0)
+    const vlc_tick_t idle = connection->getIdleTime();
+    /* connection can return partial data (chunked transfer) */
+    size_t copied = 0;
+    ssize_t ret = 0;
+    while(copied < readsize)
+    {
+        ret = connection->read(&p_block->p_buffer[copied], readsize - copied);
+        if(ret <= 0)
+            break;
+        copied += ret;
+    }
+    time = vlc_tick_now() - time - (connection->getIdleTime() - idle);
+    if(ret < 0 && copied == 0)
     {
         block_Release(p_block);
         p_block = NULL;
@@ -220,11 +231,11 @@ block_t * HTTPChunkSource::read(size_t readsize)
     }
     else
     {
-        p_block->i_buffer = (size_t) ret;
+        p_block->i_buffer = copied;
         consumed += p_block->i_buffer;
-        if((size_t)ret < readsize)
+        if(copied < readsize)
             eof = true;
-        if(ret && time)
+        if(copied && time > 0)
             connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
     }
 
@@ -265,12 +276,10 @@ bool HTTPChunkSource::prepare()
         {
             if(requeststatus == RequestStatus::Redirection)
             {
-                HTTPConnection *httpconn = dynamic_cast<HTTPConnection *>(connection);
-                if(httpconn)
-                    connparams = httpconn->getRedirection();
+                connparams = connection->getRedirection();
                 connection->setUsed(false);
                 connection = NULL;
-                if(httpconn)
+                if(!connparams.getUrl().empty())
                     continue;
             }
             break;
@@ -296,13 +305,19 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     HTTPChunkSource(url, manager, sourceid, access),
     p_head     (NULL),
     pp_tail    (&p_head),
-    buffered     (0)
+    buffered     (0),
+    downloaded   (0)
 {
     vlc_cond_init(&avail);
     done = false;
     eof = false;
     held = false;
     downloadstart = 0;
+    cache = NULL;
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    filter = NULL;
+    p_filterpending = NULL;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -312,7 +327,7 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
 
     vlc_mutex_lock(&lock);
     done = true;
-    if(held) /* wait release if not in queue but currently downloaded */
+    while(held) /* wait release if not in queue but currently downloaded */
         vlc_cond_wait(&avail, &lock);
 
     if(p_head)
@@ -322,6 +337,10 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+    if(p_cachehead)
+        block_ChainRelease(p_cachehead);
+    if(p_filterpending)
+        block_Release(p_filterpending);
     vlc_mutex_unlock(&lock);
 }
 
@@ -344,6 +363,77 @@ void HTTPChunkBufferedSource::release()
     vlc_cond_signal(&avail);
 }
 
+void HTTPChunkBufferedSource::setCache(SegmentCache *cache_, const std::string &url)
+{
+    vlc_mutex_locker locker( &lock );
+    cache = cache_;
+    cacheurl = url;
+}
+
+void HTTPChunkBufferedSource::setFilter(ChunkFilterInterface *filter_)
+{
+    vlc_mutex_locker locker( &lock );
+    filter = filter_;
+}
+
+block_t * HTTPChunkBufferedSource::applyFilter(block_t *p_block, bool b_last)
+{
+    /* Called from the downloader only, so processing overlaps the
+     * next reads instead of delaying the demuxer */
+    if(p_filterpending)
+    {
+        if(p_block)
+            block_ChainAppend(&p_filterpending, p_block);
+        p_block = block_ChainGather(p_filterpending);
+        p_filterpending = NULL;
+        if(!p_block)
+            return NULL;
+    }
+
+    if(!p_block)
+        return NULL;
+
+    size_t size = p_block->i_buffer;
+    if(!b_last)
+    {
+        /* always hold back a unit, as processing the end of data differs */
+        const size_t align = filter->getFilterAlignment();
+        size_t keep = size % align;
+        if(keep == 0)
+            keep = align;
+        if(size <= keep)
+        {
+            p_filterpending = p_block;
+            return NULL;
+        }
+        p_filterpending = block_Alloc(keep);
+        if(!p_filterpending)
+        {
+            block_Release(p_block);
+            return NULL;
+        }
+        size -= keep;
+        memcpy(p_filterpending->p_buffer, &p_block->p_buffer[size], keep);
+    }
+
+    p_block->i_buffer = filter->filterData(p_block->p_buffer, size, b_last);
+    if(p_block->i_buffer == 0)
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+    return p_block;
+}
+
+void HTTPChunkBufferedSource::dropCacheCopy()
+{
+    if(p_cachehead)
+        block_ChainRelease(p_cachehead);
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    cache = NULL;
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     vlc_mutex_lock(&lock);
@@ -359,8 +449,8 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     if(readsize < HTTPChunkSource::CHUNK_SIZE)
         readsize = HTTPChunkSource::CHUNK_SIZE;
 
-    if(contentLength && readsize > contentLength - buffered)
-        readsize = contentLength - buffered;
+    if(contentLength && readsize > contentLength - downloaded)
+        readsize = contentLength - downloaded;
 
     vlc_mutex_unlock(&lock);
 
@@ -376,30 +466,77 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         size_t size;
         vlc_tick_t time;
     } rate = {0,0};
+    block_t *p_tocache = NULL;
+    SegmentCache *tocache = NULL;
 
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
     if(ret <= 0)
     {
         block_Release(p_block);
         p_block = NULL;
+        /* flush any held back data */
+        if(filter && ret == 0)
+            p_block = applyFilter(NULL, true);
         vlc_mutex_locker locker( &lock );
+        if(p_block)
+        {
+            buffered += p_block->i_buffer;
+            block_ChainLastAppend(&pp_tail, p_block);
+        }
         done = true;
-        rate.size = buffered + consumed;
-        rate.time = vlc_tick_now() - downloadstart;
+        rate.size = downloaded;
+        rate.time = vlc_tick_now() - downloadstart - connection->getIdleTime();
         downloadstart = 0;
+        /* clean end of data */
+        if(ret == 0 && cache && requeststatus == RequestStatus::Success)
+        {
+            tocache = cache;
+            p_tocache = p_cachehead;
+            p_cachehead = NULL;
+        }
+        dropCacheCopy();
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
+        vlc_mutex_lock(&lock);
+        downloaded += p_block->i_buffer;
+        /* cache keeps the data as received */
+        if(cache)
+        {
+            block_t *p_copy = block_Duplicate(p_block);
+            if(p_copy)
+                block_ChainLastAppend(&pp_cachetail, p_copy);
+            else
+                dropCacheCopy();
+        }
+        /* Short reads are no longer EOF, as chunked transfers return
+         * data as soon as available. Only stop on known length */
+        const bool b_last = contentLength && downloaded >= contentLength;
+        vlc_mutex_unlock(&lock);
+
+        if(filter)
+            p_block = applyFilter(p_block, b_last);
+
         vlc_mutex_locker locker( &lock );
-        buffered += p_block->i_buffer;
-        block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        if(p_block)
+        {
+            buffered += p_block->i_buffer;
+            block_ChainLastAppend(&pp_tail, p_block);
+        }
+        if(b_last)
         {
             done = true;
-            rate.size = buffered + consumed;
-            rate.time = vlc_tick_now() - downloadstart;
+            rate.size = downloaded;
+            rate.time = vlc_tick_now() - downloadstart - connection->getIdleTime();
             downloadstart = 0;
+            if(cache && requeststatus == RequestStatus::Success)
+            {
+                tocache = cache;
+                p_tocache = p_cachehead;
+                p_cachehead = NULL;
+            }
+            dropCacheCopy();
         }
     }
 
@@ -408,6 +545,9 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         connManager->updateDownloadRate(sourceid, rate.size, rate.time);
     }
 
+    if(p_tocache)
+        tocache->put(cacheurl, bytesRange, getContentType(), p_tocache);
+
     vlc_cond_signal(&avail);
 }
 
@@ -416,7 +556,10 @@ bool HTTPChunkBufferedSource::prepare()
     if(!prepared)
     {
         downloadstart = vlc_tick_now();
-        return HTTPChunkSource::prepare();
+        if(!HTTPChunkSource::prepare())
+            return false;
+        /* request sent and headers received: time to first byte */
+        connManager->updateLatency(sourceid, vlc_tick_now() - downloadstart);
     }
     return true;
 }
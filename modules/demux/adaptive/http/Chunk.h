@@ -41,6 +41,17 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class SegmentCache;
+
+        class ChunkFilterInterface
+        {
+            public:
+                virtual ~ChunkFilterInterface() {}
+                /* In place processing of downloaded data, returns resulting size */
+                virtual size_t filterData(uint8_t *, size_t, bool) = 0;
+                /* Data is always passed in multiples of */
+                virtual size_t getFilterAlignment() const = 0;
+        };
 
         class AbstractChunkSource
         {
@@ -128,6 +139,8 @@ namespace adaptive
                 virtual bool       hasMoreData     () const; /* impl */
                 void               hold();
                 void               release();
+                void               setCache(SegmentCache *, const std::string &);
+                void               setFilter(ChunkFilterInterface *);
 
             protected:
                 virtual bool       prepare(); /* reimpl */
@@ -135,14 +148,23 @@ namespace adaptive
                 bool               isDone() const;
 
             private:
+                void               dropCacheCopy();
+                block_t *          applyFilter(block_t *, bool);
                 block_t            *p_head; /* read cache buffer */
                 block_t           **pp_tail;
                 size_t              buffered; /* read cache size */
+                size_t              downloaded; /* raw received size */
                 bool                done;
                 bool                eof;
                 vlc_tick_t          downloadstart;
                 vlc_cond_t          avail;
                 bool                held;
+                SegmentCache       *cache;
+                std::string         cacheurl;
+                block_t            *p_cachehead; /* copy for the cache */
+                block_t           **pp_cachetail;
+                ChunkFilterInterface *filter;
+                block_t            *p_filterpending; /* unaligned or held back data */
         };
 
         class HTTPChunk : public AbstractChunk
@@ -25,39 +25,41 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
+#include <algorithm>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Downloader(unsigned workers_)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
     killed = false;
-    thread_handle_valid = false;
+    workers = VLC_CLIP(workers_, 1, MAX_WORKERS);
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(thread_handles.size() < workers)
     {
-        return false;
+        vlc_thread_t th;
+        if(vlc_clone(&th, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        thread_handles.push_back(th);
     }
-    thread_handle_valid = true;
-    return true;
+    return !thread_handles.empty();
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    std::vector<vlc_thread_t>::const_iterator it;
+    for(it = thread_handles.begin(); it != thread_handles.end(); ++it)
+        vlc_join(*it, NULL);
 }
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
@@ -71,8 +73,23 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
-    source->release();
-    chunks.remove(source);
+    std::list<HTTPChunkBufferedSource *>::iterator it =
+            std::find(current.begin(), current.end(), source);
+    if(it != current.end())
+    {
+        /* A worker is reading it: don't wait, the worker will
+         * release the source once it finds it cancelled. */
+        current.erase(it);
+    }
+    else
+    {
+        it = std::find(chunks.begin(), chunks.end(), source);
+        if(it != chunks.end())
+        {
+            chunks.erase(it);
+            source->release();
+        }
+    }
     vlc_mutex_unlock(&lock);
 }
 
@@ -91,27 +108,77 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+bool Downloader::isStreamActive(const ID &id) const
+{
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = current.begin(); it != current.end(); ++it)
+        if((*it)->sourceid == id)
+            return true;
+    return false;
+}
+
+HTTPChunkBufferedSource * Downloader::getNextSource()
+{
+    /* Pick the oldest pending source of a stream that has no
+     * read in progress, so streams progress at the same time
+     * while each stream's segments still complete in order */
+    std::list<HTTPChunkBufferedSource *>::iterator it;
+    for(it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        HTTPChunkBufferedSource *source = *it;
+        if(!isStreamActive(source->sourceid))
+        {
+            chunks.erase(it);
+            current.push_back(source);
+            return source;
+        }
+    }
+    return NULL;
+}
+
+void Downloader::requeue(HTTPChunkBufferedSource *source)
+{
+    /* Goes behind other streams, but stays ahead of its
+     * own stream next segments */
+    std::list<HTTPChunkBufferedSource *>::iterator it;
+    for(it = chunks.begin(); it != chunks.end(); ++it)
+        if((*it)->sourceid == source->sourceid)
+            break;
+    chunks.insert(it, source);
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source = NULL;
+        while(!killed && (source = getNextSource()) == NULL)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        vlc_mutex_unlock(&lock);
+        DownloadSource(source);
+        vlc_mutex_lock(&lock);
+
+        std::list<HTTPChunkBufferedSource *>::iterator it =
+                std::find(current.begin(), current.end(), source);
+        if(it == current.end()) /* cancelled while reading */
+        {
+            source->release();
+        }
+        else
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
+            current.erase(it);
             if(source->isDone())
-            {
-                chunks.pop_front();
                 source->release();
-            }
+            else
+                requeue(source);
         }
+        /* stream slot freed, wake up other workers */
+        vlc_cond_broadcast(&waitcond);
     }
     vlc_mutex_unlock(&lock);
 }
@@ -24,6 +24,7 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -34,22 +35,30 @@ namespace adaptive
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
+                static const unsigned MAX_WORKERS = 8;
+
             private:
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                bool isStreamActive(const ID &) const;
+                HTTPChunkBufferedSource * getNextSource();
+                void requeue(HTTPChunkBufferedSource *);
+                std::vector<vlc_thread_t> thread_handles;
+                unsigned     workers;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
                 bool         killed;
+                /* pending sources, served round robin */
                 std::list<HTTPChunkBufferedSource *> chunks;
+                /* sources currently read by a worker, at most one per stream */
+                std::list<HTTPChunkBufferedSource *> current;
         };
 
     }
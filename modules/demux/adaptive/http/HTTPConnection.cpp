@@ -22,6 +22,7 @@
 #endif
 
 #include "HTTPConnection.hpp"
+#include "LibVLCHTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "AuthStorage.hpp"
 #include "Transport.hpp"
@@ -39,6 +40,7 @@ AbstractConnection::AbstractConnection(vlc_object_t *p_object_)
     available = true;
     bytesRead = 0;
     contentLength = 0;
+    idleTime = 0;
 }
 
 AbstractConnection::~AbstractConnection()
@@ -65,6 +67,16 @@ const std::string & AbstractConnection::getContentType() const
     return contentType;
 }
 
+const ConnectionParams & AbstractConnection::getRedirection() const
+{
+    return locationparams;
+}
+
+vlc_tick_t AbstractConnection::getIdleTime() const
+{
+    return idleTime;
+}
+
 HTTPConnection::HTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
                                Transport *socket_, const ConnectionParams &proxy, bool persistent)
     : AbstractConnection( p_object_ )
@@ -143,6 +155,7 @@ enum RequestStatus
     queryOk = false;
     chunked = false;
     chunked_eof = false;
+    idleTime = 0;
     chunkLength = 0;
 
     /* Set new path for this query */
@@ -229,7 +242,7 @@ ssize_t HTTPConnection::read(void *p_buffer, size_t len)
     if(ret >= 0)
         bytesRead += ret;
 
-    if(ret < 0 || (size_t)ret < len || /* set EOF */
+    if(ret < 0 || (chunked ? chunked_eof : (size_t)ret < len) || /* set EOF */
        (contentLength == bytesRead && connectionClose))
     {
         transport->disconnect();
@@ -318,7 +331,12 @@ ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
         /* adapted from access/http/chunked.c */
         if(chunkLength == 0)
         {
+            const vlc_tick_t waitstart = vlc_tick_now();
             std::string line = readLine();
+            /* Waiting for the server to produce the next chunk (live
+             * chunked transfer) must not count as transfer time */
+            if(bytesRead + copied > 0)
+                idleTime += vlc_tick_now() - waitstart;
             int end;
             if (std::sscanf(line.c_str(), "%zx%n", &chunkLength, &end) < 1
                     || (line[end] != '\0' && line[end] != ';' /* ignore extension(s) */))
@@ -351,6 +369,9 @@ ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
             ssize_t in = transport->read(&crlf, 2);
             if(in < 2 || memcmp(crlf, "\r\n", 2))
                 return (copied == 0) ? -1 : copied;
+            /* Don't wait for the next chunk to return data */
+            if(copied > 0)
+                break;
         }
     }
 
@@ -463,11 +484,6 @@ std::string HTTPConnection::extraRequestHeaders() const
     return ss.str();
 }
 
-const ConnectionParams & HTTPConnection::getRedirection() const
-{
-    return locationparams;
-}
-
 StreamUrlConnection::StreamUrlConnection(vlc_object_t *p_object)
     : AbstractConnection(p_object)
 {
@@ -640,12 +656,14 @@ ConnectionFactory::ConnectionFactory( AuthStorage *authstorage )
 {
     native = new NativeConnectionFactory( authstorage );
     streamurl = new StreamUrlConnectionFactory();
+    http2 = new LibVLCHTTPConnectionFactory( authstorage );
 }
 
 ConnectionFactory::~ConnectionFactory()
 {
     delete native;
     delete streamurl;
+    delete http2;
 }
 
 AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
@@ -654,7 +672,13 @@ AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
     bool b_streamurl = var_InheritBool(p_object, "adaptive-use-access");
     if(!b_streamurl && !params.usesAccess())
     {
-        return native->createConnection(p_object, params);
+        AbstractConnection *conn = NULL;
+        if(params.getScheme() == "https" &&
+           var_InheritBool(p_object, "adaptive-http2"))
+            conn = http2->createConnection(p_object, params);
+        if(!conn)
+            conn = native->createConnection(p_object, params);
+        return conn;
     }
     else
     {
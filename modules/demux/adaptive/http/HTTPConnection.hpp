@@ -52,16 +52,20 @@ namespace adaptive
 
                 virtual size_t  getContentLength() const;
                 virtual const std::string & getContentType() const;
+                virtual const ConnectionParams & getRedirection() const;
+                virtual vlc_tick_t getIdleTime() const;
                 virtual void    setUsed( bool ) = 0;
 
             protected:
                 vlc_object_t      *p_object;
                 ConnectionParams   params;
+                ConnectionParams   locationparams;
                 bool               available;
                 size_t             contentLength;
                 std::string        contentType;
                 BytesRange         bytesRange;
                 size_t             bytesRead;
+                vlc_tick_t         idleTime;
         };
 
         class HTTPConnection : public AbstractConnection
@@ -77,7 +81,6 @@ namespace adaptive
                 virtual ssize_t read        (void *p_buffer, size_t len);
 
                 void setUsed( bool );
-                const ConnectionParams &getRedirection() const;
                 static const unsigned MAX_REDIRECTS = 3;
 
             protected:
@@ -98,7 +101,6 @@ namespace adaptive
                 std::string useragent;
 
                 AuthStorage        *authStorage;
-                ConnectionParams    locationparams;
                 ConnectionParams    proxyparams;
                 bool                connectionClose;
                 bool                chunked;
@@ -166,6 +168,7 @@ namespace adaptive
            private:
                NativeConnectionFactory *native;
                StreamUrlConnectionFactory *streamurl;
+               AbstractConnectionFactory *http2;
        };
     }
 }
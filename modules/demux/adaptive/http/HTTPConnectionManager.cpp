@@ -30,6 +30,7 @@
 #include "ConnectionParams.hpp"
 #include "Transport.hpp"
 #include "Downloader.hpp"
+#include "../Metrics.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
 
@@ -40,6 +41,7 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = NULL;
+    metrics = NULL;
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
@@ -51,6 +53,19 @@ void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid,
 {
     if(rateObserver)
         rateObserver->updateDownloadRate(sourceid, size, time);
+    if(metrics)
+        metrics->updateDownloadRate(sourceid, size, time);
+}
+
+void AbstractConnectionManager::updateLatency(const adaptive::ID &sourceid, vlc_tick_t latency)
+{
+    if(metrics)
+        metrics->updateLatency(sourceid, latency);
+}
+
+void AbstractConnectionManager::setMetrics(Metrics *m)
+{
+    metrics = m;
 }
 
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
@@ -64,16 +79,18 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    int64_t workers = var_InheritInteger(p_object, "adaptive-workers");
+    downloader = new (std::nothrow) Downloader(workers > 0 ? workers : 1);
+    if(downloader)
+        downloader->start();
     factory = new ConnectionFactory(storage);
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
-    delete factory;
     this->closeAllConnections();
+    delete factory;
 }
 
 void HTTPConnectionManager::closeAllConnections      ()
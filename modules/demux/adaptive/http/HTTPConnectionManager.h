@@ -34,6 +34,8 @@
 
 namespace adaptive
 {
+    class Metrics;
+
     namespace http
     {
         class ConnectionParams;
@@ -55,12 +57,15 @@ namespace adaptive
 
                 virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t); /* impl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                void updateLatency(const ID &, vlc_tick_t);
+                void setMetrics(Metrics *);
 
             protected:
                 vlc_object_t                                       *p_object;
 
             private:
                 IDownloadRateObserver                              *rateObserver;
+                Metrics                                            *metrics;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -0,0 +1,329 @@
+/*
+ * LibVLCHTTPConnection.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "LibVLCHTTPConnection.hpp"
+#include "AuthStorage.hpp"
+
+#include <vlc_block.h>
+
+extern "C"
+{
+    #include "../../../access/http/message.h"
+    #include "../../../access/http/resource.h"
+    #include "../../../access/http/connmgr.h"
+}
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace adaptive::http;
+
+static int adaptive_http_res_req(const struct vlc_http_resource *,
+                                 struct vlc_http_msg *req, void *opaque)
+{
+    const BytesRange *range = static_cast<const BytesRange *>(opaque);
+
+    vlc_http_msg_add_header(req, "Cache-Control", "no-cache");
+    if(range->isValid())
+    {
+        if(range->getEndByte())
+            vlc_http_msg_add_header(req, "Range", "bytes=%zu-%zu",
+                                    range->getStartByte(), range->getEndByte());
+        else
+            vlc_http_msg_add_header(req, "Range", "bytes=%zu-",
+                                    range->getStartByte());
+    }
+    return 0;
+}
+
+static int adaptive_http_res_resp(const struct vlc_http_resource *,
+                                  const struct vlc_http_msg *, void *)
+{
+    /* status is checked by the connection */
+    return 0;
+}
+
+static const struct vlc_http_resource_cbs adaptive_http_res_callbacks =
+{
+    adaptive_http_res_req,
+    adaptive_http_res_resp,
+    nullptr,
+};
+
+LibVLCHTTPOrigin::LibVLCHTTPOrigin(vlc_object_t *p_object, AuthStorage *auth,
+                                   const ConnectionParams &params)
+{
+    vlc_mutex_init(&lock);
+    manager = vlc_http_mgr_create(p_object, auth ? auth->getCookieJar() : NULL);
+    scheme = params.getScheme();
+    hostname = params.getHostname();
+    port = params.getPort();
+}
+
+LibVLCHTTPOrigin::~LibVLCHTTPOrigin()
+{
+    if(manager)
+        vlc_http_mgr_destroy(manager);
+}
+
+bool LibVLCHTTPOrigin::matches(const ConnectionParams &params) const
+{
+    return params.getScheme() == scheme &&
+           params.getHostname() == hostname &&
+           params.getPort() == port;
+}
+
+struct vlc_http_mgr * LibVLCHTTPOrigin::getManager() const
+{
+    return manager;
+}
+
+struct vlc_http_msg * LibVLCHTTPOrigin::open(struct vlc_http_resource *res,
+                                             void *opaque)
+{
+    /* The manager is not thread-safe. Streams opened on the shared
+     * HTTP/2 session can then be read concurrently. */
+    vlc_mutex_locker locker(&lock);
+    return vlc_http_res_open(res, opaque);
+}
+
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_,
+                                           LibVLCHTTPOrigin *origin_)
+    : AbstractConnection( p_object_ )
+{
+    origin = origin_;
+    resource = NULL;
+    pending = NULL;
+    char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
+    useragent = psz_useragent ? std::string(psz_useragent) : std::string("");
+    free(psz_useragent);
+    for(std::string::iterator it = useragent.begin(); it != useragent.end(); ++it)
+        if(!std::isprint(*it))
+            *it = ' ';
+}
+
+LibVLCHTTPConnection::~LibVLCHTTPConnection()
+{
+    reset();
+}
+
+void LibVLCHTTPConnection::reset()
+{
+    if(pending)
+    {
+        block_Release(pending);
+        pending = NULL;
+    }
+    if(resource)
+    {
+        /* closes (resets) our stream only, not the session */
+        vlc_http_res_destroy(resource);
+        resource = NULL;
+    }
+    bytesRead = 0;
+    contentLength = 0;
+    contentType = std::string();
+    bytesRange = BytesRange();
+}
+
+bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
+{
+    return available && !params_.usesAccess() && origin->matches(params_);
+}
+
+enum RequestStatus
+    LibVLCHTTPConnection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+
+    /* Set new path for this query */
+    params.setPath(path);
+    locationparams = ConnectionParams();
+
+    msg_Dbg(p_object, "Retrieving %s @%zu", params.getUrl().c_str(),
+                      range.isValid() ? range.getStartByte() : 0);
+
+    resource = static_cast<struct vlc_http_resource *>(malloc(sizeof(*resource)));
+    if(!resource)
+        return RequestStatus::GenericError;
+
+    if(vlc_http_res_init(resource, &adaptive_http_res_callbacks, origin->getManager(),
+                         params.getUrl().c_str(),
+                         useragent.empty() ? NULL : useragent.c_str(), NULL))
+    {
+        free(resource);
+        resource = NULL;
+        return RequestStatus::GenericError;
+    }
+
+    BytesRange requestedrange = range;
+    resource->response = origin->open(resource, &requestedrange);
+    if(resource->response == NULL)
+    {
+        reset();
+        return RequestStatus::GenericError;
+    }
+
+    int status = vlc_http_msg_get_status(resource->response);
+    if(status >= 300 && status < 400)
+    {
+        char *psz_location = vlc_http_res_get_redirect(resource);
+        if(psz_location)
+        {
+            locationparams = ConnectionParams(psz_location);
+            free(psz_location);
+        }
+        reset();
+        return locationparams.getUrl().empty() ? RequestStatus::GenericError
+                                               : RequestStatus::Redirection;
+    }
+    else if(status == 401)
+    {
+        reset();
+        return RequestStatus::Unauthorized;
+    }
+    else if(status == 404)
+    {
+        reset();
+        return RequestStatus::NotFound;
+    }
+    else if(status >= 400)
+    {
+        reset();
+        return RequestStatus::GenericError;
+    }
+
+    char *psz_type = vlc_http_res_get_type(resource);
+    if(psz_type)
+    {
+        contentType = std::string(psz_type);
+        free(psz_type);
+    }
+
+    bytesRange = range;
+    if(range.isValid() && range.getEndByte() > 0)
+    {
+        contentLength = range.getEndByte() - range.getStartByte() + 1;
+    }
+    else
+    {
+        uintmax_t size = vlc_http_msg_get_size(resource->response);
+        if(size != (uintmax_t) -1)
+            contentLength = size;
+    }
+
+    return RequestStatus::Success;
+}
+
+ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
+{
+    if(!resource || !resource->response)
+        return -1;
+
+    if(contentLength && len > contentLength - bytesRead)
+        len = contentLength - bytesRead;
+
+    uint8_t *p_dst = static_cast<uint8_t *>(p_buffer);
+    size_t copied = 0;
+    while(copied < len)
+    {
+        if(!pending)
+        {
+            block_t *p_block = vlc_http_msg_read(resource->response);
+            if(p_block == NULL) /* end of stream */
+                break;
+            if(p_block == vlc_http_error)
+            {
+                if(copied == 0)
+                    return -1;
+                break;
+            }
+            pending = p_block;
+        }
+
+        const size_t toCopy = std::min(pending->i_buffer, len - copied);
+        memcpy(&p_dst[copied], pending->p_buffer, toCopy);
+        copied += toCopy;
+        pending->p_buffer += toCopy;
+        pending->i_buffer -= toCopy;
+        if(pending->i_buffer == 0)
+        {
+            block_Release(pending);
+            pending = NULL;
+            /* Return received data without waiting for next frames */
+            break;
+        }
+    }
+
+    bytesRead += copied;
+    return copied;
+}
+
+void LibVLCHTTPConnection::setUsed( bool b )
+{
+    available = !b;
+    if(available)
+        reset();
+}
+
+LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth )
+    : AbstractConnectionFactory()
+{
+    authStorage = auth;
+    vlc_mutex_init(&lock);
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    std::map<std::string, LibVLCHTTPOrigin *>::iterator it;
+    for(it = origins.begin(); it != origins.end(); ++it)
+        delete (*it).second;
+}
+
+AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                                   const ConnectionParams &params)
+{
+    if(params.getScheme() != "https" || params.getHostname().empty())
+        return NULL;
+
+    std::string key = params.getHostname();
+    key.append(":").append(std::to_string(params.getPort()));
+
+    vlc_mutex_locker locker(&lock);
+    LibVLCHTTPOrigin *origin;
+    std::map<std::string, LibVLCHTTPOrigin *>::iterator it = origins.find(key);
+    if(it == origins.end())
+    {
+        origin = new (std::nothrow) LibVLCHTTPOrigin(p_object, authStorage, params);
+        if(!origin || !origin->getManager())
+        {
+            delete origin;
+            return NULL;
+        }
+        origins.insert(std::pair<std::string, LibVLCHTTPOrigin *>(key, origin));
+    }
+    else origin = (*it).second;
+
+    return new (std::nothrow) LibVLCHTTPConnection(p_object, origin);
+}
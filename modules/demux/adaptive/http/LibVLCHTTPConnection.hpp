@@ -0,0 +1,92 @@
+/*
+ * LibVLCHTTPConnection.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef LIBVLCHTTPCONNECTION_HPP
+#define LIBVLCHTTPCONNECTION_HPP
+
+#include "HTTPConnection.hpp"
+
+#include <map>
+
+struct vlc_http_mgr;
+struct vlc_http_resource;
+struct vlc_http_msg;
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* One libvlc HTTP manager per origin: over https, ALPN
+         * negotiates HTTP/2 and all requests to that origin are
+         * multiplexed over a single TLS session */
+        class LibVLCHTTPOrigin
+        {
+            public:
+                LibVLCHTTPOrigin(vlc_object_t *, AuthStorage *,
+                                 const ConnectionParams &);
+                ~LibVLCHTTPOrigin();
+                bool matches(const ConnectionParams &) const;
+                struct vlc_http_msg * open(struct vlc_http_resource *, void *);
+                struct vlc_http_mgr * getManager() const;
+
+            private:
+                struct vlc_http_mgr *manager;
+                vlc_mutex_t          lock;
+                std::string          scheme;
+                std::string          hostname;
+                uint16_t             port;
+        };
+
+        class LibVLCHTTPConnection : public AbstractConnection
+        {
+            public:
+                LibVLCHTTPConnection(vlc_object_t *, LibVLCHTTPOrigin *);
+                virtual ~LibVLCHTTPConnection();
+
+                virtual bool    canReuse     (const ConnectionParams &) const;
+                virtual enum RequestStatus
+                                request     (const std::string& path, const BytesRange & = BytesRange());
+                virtual ssize_t read        (void *p_buffer, size_t len);
+
+                virtual void    setUsed( bool );
+
+            protected:
+                void reset();
+                LibVLCHTTPOrigin          *origin;
+                struct vlc_http_resource  *resource;
+                block_t                   *pending;
+                std::string                useragent;
+        };
+
+        class LibVLCHTTPConnectionFactory : public AbstractConnectionFactory
+        {
+            public:
+                LibVLCHTTPConnectionFactory( AuthStorage * );
+                virtual ~LibVLCHTTPConnectionFactory();
+                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
+
+            private:
+                AuthStorage *authStorage;
+                vlc_mutex_t  lock;
+                std::map<std::string, LibVLCHTTPOrigin *> origins;
+        };
+    }
+}
+
+#endif // LIBVLCHTTPCONNECTION_HPP
@@ -0,0 +1,192 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+
+#include <sstream>
+
+using namespace adaptive::http;
+
+CachedChunkSource::CachedChunkSource(block_t *p_block, const std::string &type)
+{
+    p_data = p_block;
+    contentType = type;
+    contentLength = p_block ? p_block->i_buffer : 0;
+}
+
+CachedChunkSource::~CachedChunkSource()
+{
+    if(p_data)
+        block_Release(p_data);
+}
+
+block_t * CachedChunkSource::readBlock()
+{
+    block_t *p_block = p_data;
+    p_data = NULL;
+    return p_block;
+}
+
+block_t * CachedChunkSource::read(size_t size)
+{
+    if(!p_data || size >= p_data->i_buffer)
+        return readBlock();
+
+    block_t *p_block = block_Alloc(size);
+    if(p_block)
+    {
+        memcpy(p_block->p_buffer, p_data->p_buffer, size);
+        p_data->p_buffer += size;
+        p_data->i_buffer -= size;
+    }
+    return p_block;
+}
+
+bool CachedChunkSource::hasMoreData() const
+{
+    return p_data != NULL;
+}
+
+std::string CachedChunkSource::getContentType() const
+{
+    return contentType;
+}
+
+SegmentCache::SegmentCache(vlc_object_t *obj_, size_t size)
+{
+    obj = obj_;
+    maxsize = size;
+    cursize = 0;
+    hits = misses = 0;
+    vlc_mutex_init(&lock);
+}
+
+SegmentCache::~SegmentCache()
+{
+    if(hits || misses)
+        msg_Dbg(obj, "Segment cache %" PRIu64 " hits %" PRIu64 " misses",
+                hits, misses);
+    evict(0);
+}
+
+bool SegmentCache::isEnabled() const
+{
+    return maxsize > 0;
+}
+
+std::string SegmentCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << url;
+    if(range.isValid())
+        os << "#" << range.getStartByte() << "-" << range.getEndByte();
+    return os.str();
+}
+
+AbstractChunkSource * SegmentCache::getSource(const std::string &url,
+                                              const BytesRange &range)
+{
+    if(!isEnabled())
+        return NULL;
+
+    const std::string key = makeKey(url, range);
+
+    vlc_mutex_locker locker(&lock);
+    std::map<std::string, std::list<Entry>::iterator>::iterator it = entries.find(key);
+    if(it == entries.end())
+    {
+        misses++;
+        return NULL;
+    }
+
+    /* move to front */
+    lru.splice(lru.begin(), lru, (*it).second);
+
+    block_t *p_block = block_Duplicate((*it).second->p_data);
+    if(!p_block)
+        return NULL;
+    CachedChunkSource *source = new (std::nothrow) CachedChunkSource(p_block, (*it).second->contentType);
+    if(!source)
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+    hits++;
+    return source;
+}
+
+void SegmentCache::put(const std::string &url, const BytesRange &range,
+                       const std::string &type, block_t *p_chain)
+{
+    block_t *p_block = block_ChainGather(p_chain);
+    if(!p_block)
+        return;
+
+    /* Don't let a single entry flush most of the cache */
+    if(!isEnabled() || p_block->i_buffer > maxsize / 4)
+    {
+        block_Release(p_block);
+        return;
+    }
+
+    const std::string key = makeKey(url, range);
+
+    vlc_mutex_locker locker(&lock);
+    if(entries.find(key) != entries.end())
+    {
+        block_Release(p_block);
+        return;
+    }
+
+    evict(maxsize - p_block->i_buffer);
+
+    Entry entry;
+    entry.key = key;
+    entry.contentType = type;
+    entry.p_data = p_block;
+    lru.push_front(entry);
+    entries.insert(std::pair<std::string, std::list<Entry>::iterator>(key, lru.begin()));
+    cursize += p_block->i_buffer;
+}
+
+void SegmentCache::evict(size_t target)
+{
+    while(cursize > target && !lru.empty())
+    {
+        Entry &entry = lru.back();
+        cursize -= entry.p_data->i_buffer;
+        block_Release(entry.p_data);
+        entries.erase(entry.key);
+        lru.pop_back();
+    }
+}
+
+void SegmentCache::getStats(uint64_t *hits_, uint64_t *misses_) const
+{
+    vlc_mutex_locker locker(&lock);
+    *hits_ = hits;
+    *misses_ = misses;
+}
@@ -0,0 +1,84 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include "Chunk.h"
+#include "BytesRange.hpp"
+
+#include <vlc_common.h>
+
+#include <map>
+#include <list>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class CachedChunkSource : public AbstractChunkSource
+        {
+            public:
+                CachedChunkSource(block_t *, const std::string &);
+                virtual ~CachedChunkSource();
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual std::string getContentType  () const; /* reimpl */
+
+            private:
+                block_t *p_data;
+                std::string contentType;
+        };
+
+        /* Byte budgeted LRU of complete downloads, shared by all streams */
+        class SegmentCache
+        {
+            public:
+                SegmentCache(vlc_object_t *, size_t);
+                ~SegmentCache();
+                bool isEnabled() const;
+                AbstractChunkSource * getSource(const std::string &, const BytesRange &);
+                void put(const std::string &, const BytesRange &,
+                         const std::string &, block_t *);
+                void getStats(uint64_t *, uint64_t *) const;
+
+            private:
+                struct Entry
+                {
+                    std::string key;
+                    std::string contentType;
+                    block_t *p_data;
+                };
+                static std::string makeKey(const std::string &, const BytesRange &);
+                void evict(size_t);
+                std::list<Entry> lru;
+                std::map<std::string, std::list<Entry>::iterator> entries;
+                vlc_object_t *obj;
+                size_t maxsize;
+                size_t cursize;
+                uint64_t hits;
+                uint64_t misses;
+                mutable vlc_mutex_t lock;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -0,0 +1,244 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+#include "ThroughputEstimator.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../playlist/BasePeriod.h"
+#include "../http/Chunk.h"
+#include "../tools/Debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput and buffer hybrid, RobustMPC like lookahead
+ * A Control-Theoretic Approach for Dynamic Adaptive Video Streaming over HTTP
+ * https://dl.acm.org/doi/10.1145/2785956.2787486
+ *
+ * Each candidate quality is simulated over the next segments using the
+ * throughput estimate, discounted by the worst recent prediction error,
+ * and scored on quality, switch magnitude and rebuffering.
+ */
+
+#define HORIZON         5
+#define MAX_ERRORS      5
+#define SWITCH_PENALTY  1.0
+#define DEFAULT_SEGMENT_DURATION VLC_TICK_FROM_SEC(4)
+
+HybridContext::HybridContext()
+    : buffering_level( 0 )
+    , buffering_target( VLC_TICK_FROM_SEC(30) )
+    , segment_duration( 0 )
+{ }
+
+HybridAdaptationLogic::HybridAdaptationLogic(vlc_object_t *obj, const std::string &estimatorname)
+    : AbstractAdaptationLogic(obj)
+    , usedBps( 0 )
+{
+    estimator = ThroughputEstimator::create(estimatorname);
+    vlc_mutex_init(&lock);
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+    delete estimator;
+}
+
+double HybridAdaptationLogic::getScore(const BaseRepresentation *rep, const BaseRepresentation *prevRep,
+                                       const HybridContext &ctx, unsigned bps, double maxMbps) const
+{
+    const double segduration = secf_from_vlc_tick(ctx.segment_duration ? ctx.segment_duration
+                                                                      : DEFAULT_SEGMENT_DURATION);
+    const double target = secf_from_vlc_tick(ctx.buffering_target);
+    const double mbps = rep->getBandwidth() / 1000000.0;
+
+    double buffer = secf_from_vlc_tick(ctx.buffering_level);
+    double rebuffer = 0.0;
+    for(unsigned i=0; i<HORIZON; i++)
+    {
+        const double dltime = rep->getBandwidth() * segduration / bps;
+        if(dltime > buffer)
+        {
+            rebuffer += dltime - buffer;
+            buffer = 0.0;
+        }
+        else buffer -= dltime;
+        buffer = std::min(buffer + segduration, target);
+    }
+
+    double score = HORIZON * mbps - maxMbps * rebuffer;
+    if(prevRep)
+        score -= SWITCH_PENALTY * std::fabs(mbps - prevRep->getBandwidth() / 1000000.0);
+    return score;
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, HybridContext>::const_iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end() || !estimator)
+    {
+        vlc_mutex_unlock(&lock);
+        return selector.lowest(adaptSet);
+    }
+    const HybridContext ctxcopy = (*it).second;
+
+    /* robust estimate */
+    double maxerror = 0.0;
+    std::list<double>::const_iterator eit;
+    for(eit = errors.begin(); eit != errors.end(); ++eit)
+        maxerror = std::max(maxerror, *eit);
+    const unsigned bps = getAvailableBw(estimator->getEstimate() / (1.0 + maxerror), prevRep);
+
+    vlc_mutex_unlock(&lock);
+
+    if(bps == 0)
+        return prevRep ? prevRep : selector.lowest(adaptSet);
+
+    BaseRepresentation *highest = selector.highest(adaptSet);
+    if(!highest)
+        return NULL;
+    const double maxMbps = highest->getBandwidth() / 1000000.0;
+
+    BaseRepresentation *best = NULL;
+    BaseRepresentation *prev = NULL;
+    double bestscore = 0.0;
+    for(BaseRepresentation *rep = selector.lowest(adaptSet);
+                            rep && rep != prev; rep = selector.higher(adaptSet, rep))
+    {
+        const double score = getScore(rep, prevRep, ctxcopy, bps, maxMbps);
+        if(best == NULL || score > bestscore)
+        {
+            best = rep;
+            bestscore = score;
+        }
+        prev = rep;
+    }
+
+    BwDebug( msg_Info(p_obj, "buffering level %.2fs rep %" PRIu64 " kBps est %u kBps",
+             secf_from_vlc_tick(ctxcopy.buffering_level), best ? best->getBandwidth()/8000 : 0, bps / 8000); );
+
+    return best;
+}
+
+unsigned HybridAdaptationLogic::getAvailableBw(unsigned i_bw, const BaseRepresentation *curRep) const
+{
+    unsigned i_remain = i_bw;
+    if(i_remain > usedBps)
+        i_remain -= usedBps;
+    else
+        i_remain = 0;
+    if(curRep)
+        i_remain += curRep->getBandwidth();
+    return i_remain > i_bw ? i_bw : i_remain;
+}
+
+void HybridAdaptationLogic::updateDownloadRate(const ID &, size_t dlsize, vlc_tick_t time)
+{
+    if(unlikely(time <= 0) || !estimator)
+        return;
+
+    const double actual = (double) CLOCK_FREQ * dlsize * 8 / time;
+
+    vlc_mutex_lock(&lock);
+    const unsigned predicted = estimator->getEstimate();
+    if(predicted && actual > 0.0)
+    {
+        errors.push_back(std::fabs(predicted - actual) / actual);
+        if(errors.size() > MAX_ERRORS)
+            errors.pop_front();
+    }
+    estimator->push(dlsize, time);
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+    case SegmentTrackerEvent::SWITCHING:
+        {
+            vlc_mutex_lock(&lock);
+            if(event.u.switching.prev)
+                usedBps -= event.u.switching.prev->getBandwidth();
+            if(event.u.switching.next)
+                usedBps += event.u.switching.next->getBandwidth();
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_STATE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            if(event.u.buffering.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                    streams.insert(std::pair<ID, HybridContext>(id, HybridContext()));
+            }
+            else
+            {
+                std::map<ID, HybridContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                    streams.erase(it);
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+        {
+            const ID &id = *event.u.buffering_level.id;
+            vlc_mutex_lock(&lock);
+            HybridContext &ctx = streams[id];
+            ctx.buffering_level = event.u.buffering_level.current;
+            ctx.buffering_target = event.u.buffering_level.target;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::SEGMENT_CHANGE:
+        {
+            const ID &id = *event.u.segment.id;
+            vlc_mutex_lock(&lock);
+            std::map<ID, HybridContext>::iterator it = streams.find(id);
+            if(it != streams.end())
+                (*it).second.segment_duration = event.u.segment.duration;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
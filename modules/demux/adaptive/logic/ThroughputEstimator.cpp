@@ -0,0 +1,130 @@
+/*
+ * ThroughputEstimator.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "ThroughputEstimator.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+using namespace adaptive::logic;
+
+ThroughputEstimator * ThroughputEstimator::create(const std::string &name)
+{
+    if(name == "ewma")
+        return new (std::nothrow) EWMAThroughputEstimator();
+    else if(name == "percentile")
+        return new (std::nothrow) PercentileThroughputEstimator();
+    else
+        return new (std::nothrow) HarmonicMeanThroughputEstimator();
+}
+
+EWMAThroughputEstimator::EWMA::EWMA(vlc_tick_t h)
+{
+    halflife = h;
+    estimate = 0.0;
+    totalweight = 0.0;
+}
+
+void EWMAThroughputEstimator::EWMA::push(double value, vlc_tick_t duration)
+{
+    const double alpha = std::pow(0.5, (double) duration / halflife);
+    estimate = value * (1.0 - alpha) + alpha * estimate;
+    totalweight += duration;
+}
+
+double EWMAThroughputEstimator::EWMA::get() const
+{
+    /* remove the zero initial estimate bias */
+    const double zerofactor = 1.0 - std::pow(0.5, totalweight / halflife);
+    return (zerofactor > 0.0) ? estimate / zerofactor : 0.0;
+}
+
+EWMAThroughputEstimator::EWMAThroughputEstimator(vlc_tick_t fasthl, vlc_tick_t slowhl)
+    : fast(fasthl), slow(slowhl)
+{
+}
+
+void EWMAThroughputEstimator::push(size_t size, vlc_tick_t time)
+{
+    if(unlikely(time <= 0))
+        return;
+    const double bps = (double) CLOCK_FREQ * size * 8 / time;
+    fast.push(bps, time);
+    slow.push(bps, time);
+}
+
+unsigned EWMAThroughputEstimator::getEstimate() const
+{
+    return std::min(fast.get(), slow.get());
+}
+
+HarmonicMeanThroughputEstimator::HarmonicMeanThroughputEstimator(unsigned w)
+{
+    window = std::max(w, 1U);
+}
+
+void HarmonicMeanThroughputEstimator::push(size_t size, vlc_tick_t time)
+{
+    if(unlikely(time <= 0) || size == 0)
+        return;
+    samples.push_back((double) CLOCK_FREQ * size * 8 / time);
+    if(samples.size() > window)
+        samples.pop_front();
+}
+
+unsigned HarmonicMeanThroughputEstimator::getEstimate() const
+{
+    if(samples.empty())
+        return 0;
+    double invsum = 0.0;
+    std::list<double>::const_iterator it;
+    for(it = samples.begin(); it != samples.end(); ++it)
+        invsum += 1.0 / *it;
+    return samples.size() / invsum;
+}
+
+PercentileThroughputEstimator::PercentileThroughputEstimator(unsigned w, unsigned p)
+{
+    window = std::max(w, 1U);
+    percentile = std::min(p, 100U);
+}
+
+void PercentileThroughputEstimator::push(size_t size, vlc_tick_t time)
+{
+    if(unlikely(time <= 0))
+        return;
+    samples.push_back(CLOCK_FREQ * size * 8 / time);
+    if(samples.size() > window)
+        samples.pop_front();
+}
+
+unsigned PercentileThroughputEstimator::getEstimate() const
+{
+    if(samples.empty())
+        return 0;
+    std::vector<unsigned> sorted(samples.begin(), samples.end());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[(sorted.size() - 1) * percentile / 100];
+}
@@ -0,0 +1,100 @@
+/*
+ * ThroughputEstimator.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef THROUGHPUTESTIMATOR_HPP
+#define THROUGHPUTESTIMATOR_HPP
+
+#include <vlc_common.h>
+
+#include <list>
+#include <string>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        /* Download rate estimation, usable by any adaptation logic */
+        class ThroughputEstimator
+        {
+            public:
+                virtual ~ThroughputEstimator() {}
+                virtual void push(size_t, vlc_tick_t) = 0;
+                virtual unsigned getEstimate() const = 0; /* bps */
+
+                static ThroughputEstimator * create(const std::string &);
+        };
+
+        /* Dual exponentially weighted moving average, weighted
+         * by download duration. Returns the lowest of both */
+        class EWMAThroughputEstimator : public ThroughputEstimator
+        {
+            public:
+                EWMAThroughputEstimator(vlc_tick_t = VLC_TICK_FROM_SEC(3),
+                                        vlc_tick_t = VLC_TICK_FROM_SEC(8));
+                virtual void push(size_t, vlc_tick_t); /* impl */
+                virtual unsigned getEstimate() const; /* impl */
+
+            private:
+                class EWMA
+                {
+                    public:
+                        EWMA(vlc_tick_t);
+                        void push(double, vlc_tick_t);
+                        double get() const;
+
+                    private:
+                        vlc_tick_t halflife;
+                        double estimate;
+                        double totalweight;
+                };
+                EWMA fast;
+                EWMA slow;
+        };
+
+        /* Harmonic mean of the last samples, robust to spikes */
+        class HarmonicMeanThroughputEstimator : public ThroughputEstimator
+        {
+            public:
+                HarmonicMeanThroughputEstimator(unsigned = 5);
+                virtual void push(size_t, vlc_tick_t); /* impl */
+                virtual unsigned getEstimate() const; /* impl */
+
+            private:
+                std::list<double> samples;
+                unsigned window;
+        };
+
+        /* Percentile over a sliding window of samples */
+        class PercentileThroughputEstimator : public ThroughputEstimator
+        {
+            public:
+                PercentileThroughputEstimator(unsigned = 10, unsigned = 30);
+                virtual void push(size_t, vlc_tick_t); /* impl */
+                virtual unsigned getEstimate() const; /* impl */
+
+            private:
+                std::list<unsigned> samples;
+                unsigned window;
+                unsigned percentile;
+        };
+    }
+}
+
+#endif // THROUGHPUTESTIMATOR_HPP
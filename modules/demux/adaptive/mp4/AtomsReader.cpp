@@ -22,14 +22,39 @@
 #endif
 
 #include "AtomsReader.hpp"
-#include <new>
+#include <cstring>
 
 using namespace adaptive::mp4;
 
+Atom::Atom()
+{
+    type = 0;
+    offset = 0;
+    size = 0;
+    headersize = 0;
+    p_data = NULL;
+}
+
+const uint8_t * Atom::getPayload() const
+{
+    return p_data + headersize;
+}
+
+size_t Atom::getPayloadSize() const
+{
+    return size - headersize;
+}
+
+bool Atom::isUUID(const UUID_t &uuid) const
+{
+    return type == ATOM_uuid && !memcmp(&p_data[headersize - 16], &uuid, 16);
+}
+
 AtomsReader::AtomsReader(vlc_object_t *object_)
 {
     object = object_;
-    rootbox = NULL;
+    p_data = NULL;
+    i_data = 0;
 }
 
 AtomsReader::~AtomsReader()
@@ -39,34 +64,91 @@ AtomsReader::~AtomsReader()
 
 void AtomsReader::clean()
 {
-    MP4_BoxFree(rootbox);
-    rootbox = NULL;
+    p_data = NULL;
+    i_data = 0;
 }
 
 bool AtomsReader::parseBlock(block_t *p_block)
 {
-    if(rootbox)
-        clean();
+    /* Only a view, block must outlive lookups */
+    p_data = p_block->p_buffer;
+    i_data = p_block->i_buffer;
+    return true;
+}
 
-    stream_t *stream = vlc_stream_MemoryNew( object, p_block->p_buffer, p_block->i_buffer, true);
-    if (stream)
+bool AtomsReader::readAtom(const uint8_t *p, size_t i_remain, size_t offset, Atom *atom) const
+{
+    if(i_remain < 8)
+        return false;
+
+    uint64_t size = GetDWBE(p);
+    size_t headersize = 8;
+    atom->type = VLC_FOURCC(p[4], p[5], p[6], p[7]);
+    if(size == 1)
     {
-        rootbox = MP4_BoxNew(ATOM_root);
-        if(!rootbox)
-        {
-            vlc_stream_Delete(stream);
+        if(i_remain < 16)
             return false;
-        }
-        memset(rootbox, 0, sizeof(*rootbox));
-        rootbox->i_type = ATOM_root;
-        rootbox->i_size = p_block->i_buffer;
-        if ( MP4_ReadBoxContainerChildren( stream, rootbox, NULL ) == 1 )
+        size = GetQWBE(&p[8]);
+        headersize += 8;
+    }
+    else if(size == 0) /* up to end */
+    {
+        size = i_remain;
+    }
+
+    if(atom->type == ATOM_uuid)
+        headersize += 16;
+
+    if(size < headersize || size > i_remain)
+        return false;
+
+    atom->p_data = p;
+    atom->offset = offset;
+    atom->size = size;
+    atom->headersize = headersize;
+    return true;
+}
+
+bool AtomsReader::find(const char *psz_path, Atom *atom, const UUID_t *uuid) const
+{
+    const uint8_t *p = p_data;
+    size_t i_remain = i_data;
+    size_t offset = 0;
+
+    if(!p)
+        return false;
+
+    while(*psz_path)
+    {
+        if(strlen(psz_path) < 4)
+            return false;
+        const vlc_fourcc_t type = VLC_FOURCC(psz_path[0], psz_path[1],
+                                             psz_path[2], psz_path[3]);
+        psz_path += 4;
+        if(*psz_path == '/')
+            psz_path++;
+        const bool b_last = (*psz_path == 0);
+
+        /* lookup among siblings */
+        bool b_found = false;
+        while(readAtom(p, i_remain, offset, atom))
         {
-#ifndef NDEBUG
-            MP4_BoxDumpStructure(stream, rootbox);
-#endif
+            if(atom->type == type && (!b_last || !uuid || atom->isUUID(*uuid)))
+            {
+                b_found = true;
+                break;
+            }
+            p += atom->size;
+            offset += atom->size;
+            i_remain -= atom->size;
         }
-        vlc_stream_Delete(stream);
+        if(!b_found)
+            return false;
+
+        /* descend into children */
+        p = atom->getPayload();
+        i_remain = atom->getPayloadSize();
+        offset = atom->offset + atom->headersize;
     }
 
     return true;
@@ -30,6 +30,22 @@ namespace adaptive
 {
     namespace mp4
     {
+        /* Header view of a box inside the parsed data */
+        class Atom
+        {
+            public:
+                Atom();
+                const uint8_t * getPayload() const;
+                size_t getPayloadSize() const;
+                bool isUUID(const UUID_t &) const;
+                uint32_t type;
+                size_t offset; /* from start of parsed data */
+                size_t size;
+                size_t headersize;
+                const uint8_t *p_data; /* points to box start */
+        };
+
+        /* Walks box headers in place, without building a box tree */
         class AtomsReader
         {
             public:
@@ -39,8 +55,14 @@ namespace adaptive
                 bool parseBlock(block_t *);
 
             protected:
+                /* ex: "moof/traf/tfhd", optionally matching uuid on last one */
+                bool find(const char *, Atom *, const UUID_t * = NULL) const;
                 vlc_object_t *object;
-                MP4_Box_t *rootbox;
+
+            private:
+                bool readAtom(const uint8_t *, size_t, size_t, Atom *) const;
+                const uint8_t *p_data;
+                size_t i_data;
         };
     }
 }
@@ -34,6 +34,8 @@
 #include "../http/BytesRange.hpp"
 #include "../http/HTTPConnectionManager.h"
 #include "../http/Downloader.hpp"
+#include "../http/SegmentCache.hpp"
+#include "../SharedResources.hpp"
 #include <cassert>
 
 using namespace adaptive::http;
@@ -82,12 +84,72 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                                 size_t index, BaseRepresentation *rep)
 {
     const std::string url = getUrlSegment().toString(index, rep);
+    const BytesRange range = (startByte != endByte) ? BytesRange(startByte, endByte)
+                                                    : BytesRange();
+    return toChunk(res, connManager, url, range, rep);
+}
+
+bool ISegment::canCoalesceAfter(const ISegment *prev, size_t index,
+                                BaseRepresentation *rep) const
+{
+    if(!prev || prev == this || startByte == endByte ||
+       prev->startByte == prev->endByte || prev->endByte + 1 != startByte)
+        return false;
+    /* Decryption context would differ */
+    if(encryption.method != CommonEncryption::Method::NONE ||
+       prev->encryption.method != CommonEncryption::Method::NONE)
+        return false;
+    return getUrlSegment().toString(index, rep) ==
+           prev->getUrlSegment().toString(index, rep);
+}
+
+SegmentChunk* ISegment::toCoalescedChunk(SharedResources *res, AbstractConnectionManager *connManager,
+                                         size_t index, BaseRepresentation *rep,
+                                         const ISegment *prev)
+{
+    if(!canCoalesceAfter(prev, index, rep))
+        return NULL;
+    /* Our chunk type handles the data, which is just preceded
+     * by the previous segment one, as it would have been demuxed */
+    return toChunk(res, connManager, getUrlSegment().toString(index, rep),
+                   BytesRange(prev->startByte, endByte), rep);
+}
+
+SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager *connManager,
+                                const std::string &url, const BytesRange &range,
+                                BaseRepresentation *rep)
+{
+    /* Segment might have been fetched by another representation or before seek */
+    SegmentCache *cache = res ? res->getSegmentCache() : NULL;
+    if( cache && cache->isEnabled() )
+    {
+        AbstractChunkSource *cached = cache->getSource(url, range);
+        if( cached )
+        {
+            SegmentChunk *chunk = createChunk(cached, rep);
+            if(!chunk)
+            {
+                delete cached;
+                return NULL;
+            }
+            chunk->discontinuity = discontinuity;
+            if(!prepareChunk(res, chunk, rep))
+            {
+                delete chunk;
+                return NULL;
+            }
+            return chunk;
+        }
+    }
+
     HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
                                                                                  rep->getAdaptationSet()->getID());
     if( source )
     {
-        if(startByte != endByte)
-            source->setBytesRange(BytesRange(startByte, endByte));
+        if(range.isValid())
+            source->setBytesRange(range);
+        if( cache && cache->isEnabled() )
+            source->setCache(cache, url);
 
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
@@ -157,6 +219,16 @@ bool ISegment::contains(size_t byte) const
             (!endByte || byte <= endByte) );
 }
 
+bool ISegment::isComplete() const
+{
+    return true;
+}
+
+ISegment * ISegment::getPart(std::size_t) const
+{
+    return NULL;
+}
+
 int ISegment::compare(ISegment *other) const
 {
     if(duration.Get())
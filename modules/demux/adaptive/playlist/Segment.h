@@ -65,6 +65,13 @@ namespace adaptive
                 virtual SegmentChunk*                   toChunk         (SharedResources *, AbstractConnectionManager *,
                                                                          size_t, BaseRepresentation *);
                 virtual SegmentChunk*                   createChunk     (AbstractChunkSource *, BaseRepresentation *) = 0;
+                /* Single request for a segment and its directly preceding one
+                 * in the same resource (init and index) */
+                bool                                    canCoalesceAfter(const ISegment *, size_t,
+                                                                         BaseRepresentation *) const;
+                SegmentChunk*                           toCoalescedChunk(SharedResources *, AbstractConnectionManager *,
+                                                                         size_t, BaseRepresentation *,
+                                                                         const ISegment *);
                 virtual void                            setByteRange    (size_t start, size_t end);
                 virtual void                            setSequenceNumber(uint64_t);
                 virtual uint64_t                        getSequenceNumber() const;
@@ -75,6 +82,10 @@ namespace adaptive
                 virtual void                            debug           (vlc_object_t *,int = 0) const;
                 virtual bool                            contains        (size_t byte) const;
                 virtual int                             compare         (ISegment *) const;
+                /* Low latency: segment can be delivered as parts, and
+                 * is not complete while still being published */
+                virtual bool                            isComplete      () const;
+                virtual ISegment *                      getPart         (std::size_t) const;
                 void                                    setEncryption   (CommonEncryption &);
                 int                                     getClassId      () const;
                 Property<stime_t>       startTime;
@@ -87,6 +98,9 @@ namespace adaptive
                 virtual bool                            prepareChunk    (SharedResources *,
                                                                          SegmentChunk *,
                                                                          BaseRepresentation *);
+                SegmentChunk*                           toChunk         (SharedResources *, AbstractConnectionManager *,
+                                                                         const std::string &, const BytesRange &,
+                                                                         BaseRepresentation *);
                 CommonEncryption        encryption;
                 size_t                  startByte;
                 size_t                  endByte;
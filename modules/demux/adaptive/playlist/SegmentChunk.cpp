@@ -39,10 +39,14 @@ SegmentChunk::SegmentChunk(AbstractChunkSource *source, BaseRepresentation *rep_
 {
     rep = rep_;
     encryptionSession = NULL;
+    b_sourcedecrypts = false;
 }
 
 SegmentChunk::~SegmentChunk()
 {
+    /* source might still be decrypting from the downloader */
+    delete source;
+    source = NULL;
     delete encryptionSession;
 }
 
@@ -50,7 +54,7 @@ bool SegmentChunk::decrypt(block_t **pp_block)
 {
     block_t *p_block = *pp_block;
 
-    if(encryptionSession)
+    if(encryptionSession && !b_sourcedecrypts)
     {
         bool b_last = isEmpty();
         p_block->i_buffer = encryptionSession->decrypt(p_block->p_buffer,
@@ -75,8 +79,27 @@ StreamFormat SegmentChunk::getStreamFormat() const
         return StreamFormat();
 }
 
+size_t SegmentChunk::filterData(uint8_t *p_data, size_t i_data, bool b_last)
+{
+    i_data = encryptionSession->decrypt(p_data, i_data, b_last);
+    if(b_last)
+        encryptionSession->close();
+    return i_data;
+}
+
+size_t SegmentChunk::getFilterAlignment() const
+{
+    return 16;
+}
+
 void SegmentChunk::setEncryptionSession(CommonEncryptionSession *s)
 {
     delete encryptionSession;
     encryptionSession = s;
+    /* Let the downloader decrypt as data arrives when it can,
+     * must happen before the source is started */
+    HTTPChunkBufferedSource *bufsource = dynamic_cast<HTTPChunkBufferedSource *>(source);
+    b_sourcedecrypts = (s && bufsource);
+    if(bufsource)
+        bufsource->setFilter(b_sourcedecrypts ? this : NULL);
 }
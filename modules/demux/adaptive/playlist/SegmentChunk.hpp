@@ -38,7 +38,8 @@ namespace adaptive
 
         class BaseRepresentation;
 
-        class SegmentChunk : public AbstractChunk
+        class SegmentChunk : public AbstractChunk,
+                             public ChunkFilterInterface
         {
         public:
             SegmentChunk(AbstractChunkSource *, BaseRepresentation *);
@@ -50,8 +51,11 @@ namespace adaptive
         protected:
             bool         decrypt(block_t **);
             virtual void onDownload(block_t **); /* impl */
+            virtual size_t filterData(uint8_t *, size_t, bool); /* impl */
+            virtual size_t getFilterAlignment() const; /* impl */
             BaseRepresentation *rep;
             CommonEncryptionSession *encryptionSession;
+            bool         b_sourcedecrypts;
         };
 
     }
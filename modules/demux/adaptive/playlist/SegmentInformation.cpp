@@ -645,6 +645,20 @@ void SegmentInformation::updateSegmentList(SegmentList *list, bool restamp)
     }
 }
 
+void SegmentInformation::updateSegmentList(SegmentList *list, bool restamp,
+                                           uint64_t firstnumber)
+{
+    if(segmentList)
+    {
+        segmentList->updateWith(list, restamp, firstnumber);
+        delete list;
+    }
+    else
+    {
+        segmentList = list;
+    }
+}
+
 void SegmentInformation::setSegmentBase(SegmentBase *base)
 {
     if(segmentBase)
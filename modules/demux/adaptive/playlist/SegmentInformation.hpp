@@ -83,7 +83,7 @@ namespace adaptive
                 bool getSegmentNumberByTime(vlc_tick_t, uint64_t *) const;
                 bool getPlaybackTimeDurationBySegmentNumber(uint64_t, vlc_tick_t *, vlc_tick_t *) const;
                 uint64_t getLiveSegmentNumberByTime(uint64_t, vlc_tick_t) const;
-                uint64_t getLiveStartSegmentNumber(uint64_t) const;
+                virtual uint64_t getLiveStartSegmentNumber(uint64_t) const;
                 bool     getMediaPlaybackRange(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *) const;
                 virtual void updateWith(SegmentInformation *);
                 virtual void mergeWithTimeline(SegmentTimeline *); /* ! don't use with global merge */
@@ -102,6 +102,7 @@ namespace adaptive
 
             public:
                 void updateSegmentList(SegmentList *, bool = false);
+                void updateSegmentList(SegmentList *, bool, uint64_t);
                 void setSegmentBase(SegmentBase *);
                 void setSegmentTemplate(MediaSegmentTemplate *);
                 virtual Url getUrlSegment() const; /* impl */
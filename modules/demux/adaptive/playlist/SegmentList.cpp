@@ -75,13 +75,25 @@ void SegmentList::addSegment(ISegment *seg)
 
 void SegmentList::updateWith(SegmentList *updated, bool b_restamp)
 {
-    const ISegment * lastSegment = (segments.empty()) ? NULL : segments.back();
-    const ISegment * prevSegment = lastSegment;
-
     if(updated->segments.empty())
         return;
 
-    uint64_t firstnumber = updated->segments.front()->getSequenceNumber();
+    updateWith(updated, b_restamp, updated->segments.front()->getSequenceNumber());
+}
+
+void SegmentList::updateWith(SegmentList *updated, bool b_restamp, uint64_t firstnumber)
+{
+    /* Our last segment might have been still in progress (low latency parts) */
+    if(!segments.empty() && !segments.back()->isComplete() && !updated->segments.empty() &&
+       updated->segments.back()->getSequenceNumber() >= segments.back()->getSequenceNumber())
+    {
+        totalLength -= segments.back()->duration.Get();
+        delete segments.back();
+        segments.pop_back();
+    }
+
+    const ISegment * lastSegment = (segments.empty()) ? NULL : segments.back();
+    const ISegment * prevSegment = lastSegment;
 
     std::vector<ISegment *>::iterator it;
     for(it = updated->segments.begin(); it != updated->segments.end(); ++it)
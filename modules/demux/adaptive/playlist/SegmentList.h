@@ -45,6 +45,7 @@ namespace adaptive
                 ISegment *              getSegmentByNumber(uint64_t);
                 void                    addSegment(ISegment *seg);
                 void                    updateWith(SegmentList *, bool = false);
+                void                    updateWith(SegmentList *, bool, uint64_t);
                 void                    pruneBySegmentNumber(uint64_t);
                 void                    pruneByPlaybackTime(vlc_tick_t);
                 bool                    getSegmentNumberByScaledTime(stime_t, uint64_t *) const;
@@ -53,6 +53,7 @@ MediaSegmentTemplate::MediaSegmentTemplate( SegmentInformation *parent ) :
     debugName = "SegmentTemplate";
     classId = Segment::CLASSID_SEGMENT;
     startNumber = std::numeric_limits<uint64_t>::max();
+    availabilityTimeOffset = 0;
     segmentTimeline = NULL;
     initialisationSegment.Set( NULL );
     templated = true;
@@ -135,6 +136,19 @@ stime_t MediaSegmentTemplate::inheritDuration() const
     return 0;
 }
 
+vlc_tick_t MediaSegmentTemplate::inheritAvailabilityTimeOffset() const
+{
+    const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
+                                                                : NULL;
+    for( ; ulevel ; ulevel = ulevel->parent )
+    {
+        if( ulevel->mediaSegmentTemplate &&
+            ulevel->mediaSegmentTemplate->availabilityTimeOffset > 0 )
+            return ulevel->mediaSegmentTemplate->availabilityTimeOffset;
+    }
+    return 0;
+}
+
 SegmentTimeline * MediaSegmentTemplate::inheritSegmentTimeline() const
 {
     const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
@@ -160,6 +174,8 @@ uint64_t MediaSegmentTemplate::getLiveTemplateNumber(vlc_tick_t playbacktime) co
         vlc_tick_t streamstart =
                 vlc_tick_from_sec(parentSegmentInformation->getPlaylist()->availabilityStartTime.Get());
         streamstart += parentSegmentInformation->getPeriodStart();
+        /* segments can be made available before completion (chunked) */
+        streamstart -= inheritAvailabilityTimeOffset();
         stime_t elapsed = timescale.ToScaled(playbacktime - streamstart);
         number += elapsed / dur;
     }
@@ -186,6 +202,11 @@ void MediaSegmentTemplate::setStartNumber( uint64_t v )
     startNumber = v;
 }
 
+void MediaSegmentTemplate::setAvailabilityTimeOffset( vlc_tick_t v )
+{
+    availabilityTimeOffset = v;
+}
+
 void MediaSegmentTemplate::setSegmentTimeline( SegmentTimeline *v )
 {
     delete segmentTimeline;
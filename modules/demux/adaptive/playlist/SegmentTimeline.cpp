@@ -44,99 +44,83 @@ SegmentTimeline::SegmentTimeline(uint64_t scale)
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
 void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
+    Element element(number, d, r, t);
+    if(!elements.empty() && !t)
     {
-        if(!elements.empty() && !t)
-        {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
-        }
-        elements.push_back(element);
-        totalLength += (d * (r + 1));
+        const Element &el = elements.back();
+        element.t = el.t + el.length();
     }
+    elements.push_back(element);
+    totalLength += element.length();
 }
 
-stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
+std::vector<SegmentTimeline::Element>::const_iterator
+    SegmentTimeline::findByScaledTime(stime_t scaled) const
 {
-    stime_t totalscaledtime = 0;
+    /* last element starting at or before that time */
+    std::vector<Element>::const_iterator it =
+        std::upper_bound(elements.begin(), elements.end(), scaled, Element::timeLess);
+    if(it == elements.begin())
+        return elements.end();
+    return --it;
+}
 
-    std::list<Element *>::const_reverse_iterator it;
-    for(it = elements.rbegin(); it != elements.rend(); ++it)
-    {
-        const Element *el = *it;
+std::vector<SegmentTimeline::Element>::const_iterator
+    SegmentTimeline::findByNumber(uint64_t number) const
+{
+    /* last element starting at or before that number */
+    std::vector<Element>::const_iterator it =
+        std::upper_bound(elements.begin(), elements.end(), number, Element::numberLess);
+    if(it == elements.begin())
+        return elements.end();
+    return --it;
+}
 
-        if(number < el->number)
-        {
-            totalscaledtime += (el->d * (el->r + 1));
-            break;
-        }
-        else if(number <= el->number + el->r)
-        {
-            totalscaledtime += el->d * (el->number + el->r - number);
-        }
-        else break;
-    }
+stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
+{
+    if(elements.empty())
+        return 0;
 
-    return totalscaledtime;
+    const Element &el = elements.back();
+    if(number < el.number)
+        return el.length();
+    else if(number <= el.number + el.r)
+        return el.d * (el.number + el.r - number);
+    return 0;
 }
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    const Element *prevel = NULL;
-    std::list<Element *>::const_iterator it;
-
-    if(!elements.size())
+    if(elements.empty())
         return 0;
 
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(scaled >= el->t)
-        {
-            if((uint64_t)scaled < el->t + (el->d * el->r))
-                return el->number + (scaled - el->t) / el->d;
-        }
-        /* might have been discontinuity */
-        else
-        {
-            if(prevel) /* > prev but < current */
-                return prevel->number + prevel->r;
-            else /* << first of the list */
-                return el->number;
-        }
-        prevel = el;
-    }
+    std::vector<Element>::const_iterator it = findByScaledTime(scaled);
+    if(it == elements.end()) /* << first of the list */
+        return elements.front().number;
 
-    /* time is >> any of the list */
-    return prevel->number + prevel->r;
+    const Element &el = *it;
+    if((uint64_t)scaled < el.t + (el.d * el.r))
+        return el.number + (scaled - el.t) / el.d;
+
+    /* last repeat, discontinuity gap or >> any of the list */
+    return el.number + el.r;
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(number >= el->number)
-        {
-            if(number <= el->number + el->r)
-            {
-                *time = el->t + el->d * (number - el->number);
-                *duration = el->d;
-                return true;
-            }
-        }
-    }
-    return false;
+    std::vector<Element>::const_iterator it = findByNumber(number);
+    if(it == elements.end() || number > (*it).number + (*it).r)
+        return false;
+
+    const Element &el = *it;
+    *time = el.t + el.d * (number - el.number);
+    *duration = el.d;
+    return true;
 }
 
 stime_t SegmentTimeline::getScaledPlaybackTimeByElementNumber(uint64_t number) const
@@ -156,15 +140,15 @@ uint64_t SegmentTimeline::maxElementNumber() const
     if(elements.empty())
         return 0;
 
-    const Element *e = elements.back();
-    return e->number + e->r;
+    const Element &e = elements.back();
+    return e.number + e.r;
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
     if(elements.empty())
         return 0;
-    return elements.front()->number;
+    return elements.front().number;
 }
 
 void SegmentTimeline::pruneByPlaybackTime(vlc_tick_t time)
@@ -176,32 +160,39 @@ void SegmentTimeline::pruneByPlaybackTime(vlc_tick_t time)
 
 size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
 {
+    if(elements.empty() || elements.front().number >= number)
+        return 0;
+
     size_t prunednow = 0;
-    while(elements.size())
+    std::vector<Element>::iterator first = elements.begin();
+    std::vector<Element>::iterator it = first +
+            (findByNumber(number) - elements.cbegin());
+
+    /* drop all fully expired elements at once */
+    for(std::vector<Element>::iterator del = first; del != it; ++del)
     {
-        Element *el = elements.front();
-        if(el->number >= number)
-        {
-            break;
-        }
-        else if(el->number + el->r >= number)
-        {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
-            prunednow += count;
-            break;
-        }
-        else
-        {
-            prunednow += el->r + 1;
-            elements.pop_front();
-            totalLength -= (el->d * (el->r + 1));
-            delete el;
-        }
+        prunednow += (*del).r + 1;
+        totalLength -= (*del).length();
+    }
+
+    Element &el = *it;
+    if(el.number + el.r >= number)
+    {
+        uint64_t count = number - el.number;
+        el.number += count;
+        el.t += count * el.d;
+        el.r -= count;
+        prunednow += count;
+    }
+    else
+    {
+        prunednow += el.r + 1;
+        totalLength -= el.length();
+        ++it;
     }
 
+    elements.erase(first, it);
+
     return prunednow;
 }
 
@@ -209,40 +200,44 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
 {
     if(elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
+        elements.swap(other.elements);
+        other.elements.clear();
+        totalLength = other.totalLength;
         return;
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    elements.reserve(elements.size() + other.elements.size());
+
+    /* Live updates mostly repeat the known elements: skip at once the ones
+       ending before our last element */
+    std::vector<Element>::const_iterator it =
+            std::lower_bound(other.elements.begin(), other.elements.end(),
+                             elements.back().t, Element::endsBefore);
+    for(; it != other.elements.end(); ++it)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
+        const Element &el = *it;
+        Element &last = elements.back();
 
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
+        if(last.contains(el.t)) /* Same element, but prev could have been middle of repeat */
         {
-            const uint64_t count = (el->t - last->t) / last->d;
-            totalLength -= (last->d * (last->r + 1));
-            last->r = std::max(last->r, el->r + count);
-            totalLength += (last->d * (last->r + 1));
-            delete el;
+            const uint64_t count = (el.t - last.t) / last.d;
+            totalLength -= last.length();
+            last.r = std::max(last.r, el.r + count);
+            totalLength += last.length();
         }
-        else if(el->t < last->t)
+        else if(el.t < last.t)
         {
-            delete el;
+            continue;
         }
         else /* Did not exist in previous list */
         {
-            totalLength += (el->d * (el->r + 1));
-            elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            Element added = el;
+            added.number = last.number + last.r + 1;
+            totalLength += added.length();
+            elements.push_back(added);
         }
     }
+    other.elements.clear();
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -251,9 +246,9 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
+    std::vector<Element>::const_iterator it;
     for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+        (*it).debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -271,6 +266,26 @@ bool SegmentTimeline::Element::contains(stime_t time) const
     return false;
 }
 
+bool SegmentTimeline::Element::timeLess(stime_t time, const Element &el)
+{
+    return time < el.t;
+}
+
+bool SegmentTimeline::Element::endsBefore(const Element &el, stime_t time)
+{
+    return el.t + (stime_t)(el.r + 1) * el.d <= time;
+}
+
+bool SegmentTimeline::Element::numberLess(uint64_t number, const Element &el)
+{
+    return number < el.number;
+}
+
+stime_t SegmentTimeline::Element::length() const
+{
+    return d * (r + 1);
+}
+
 void SegmentTimeline::Element::debug(vlc_object_t *obj, int indent) const
 {
     std::stringstream ss;
@@ -25,7 +25,7 @@
 
 #include "SegmentInfoCommon.h"
 #include <vlc_common.h>
-#include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -53,8 +53,11 @@ namespace adaptive
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
+                /* sorted by both time and number, allowing binary searches */
+                std::vector<Element> elements;
                 stime_t totalLength;
+                std::vector<Element>::const_iterator findByScaledTime(stime_t) const;
+                std::vector<Element>::const_iterator findByNumber(uint64_t) const;
 
                 class Element
                 {
@@ -62,6 +65,10 @@ namespace adaptive
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
                         bool contains(stime_t) const;
+                        stime_t  length() const;
+                        static bool timeLess(stime_t, const Element &);
+                        static bool numberLess(uint64_t, const Element &);
+                        static bool endsBefore(const Element &, stime_t);
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
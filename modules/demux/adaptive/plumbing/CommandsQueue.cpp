@@ -29,9 +29,13 @@
 #include <vlc_meta.h>
 #include <algorithm>
 #include <set>
+#include <typeinfo>
 
 using namespace adaptive;
 
+/* Max number of recycled send commands kept around */
+#define COMMANDS_POOL_SIZE 1024
+
 enum
 {
     ES_OUT_PRIVATE_COMMAND_ADD = ES_OUT_PRIVATE_START,
@@ -185,8 +189,31 @@ void EsOutMetaCommand::Execute( es_out_t *out )
  * Commands Default Factory
  */
 
+CommandsFactory::CommandsFactory()
+{
+    vlc_mutex_init(&lock);
+}
+
+CommandsFactory::~CommandsFactory()
+{
+    std::vector<EsOutSendCommand *>::const_iterator it;
+    for( it = pool.begin(); it != pool.end(); ++it )
+        delete *it;
+}
+
 EsOutSendCommand * CommandsFactory::createEsOutSendCommand( FakeESOutID *id, block_t *p_block ) const
 {
+    vlc_mutex_lock(&lock);
+    if( !pool.empty() )
+    {
+        EsOutSendCommand *command = pool.back();
+        pool.pop_back();
+        vlc_mutex_unlock(&lock);
+        command->p_fakeid = id;
+        command->p_block = p_block;
+        return command;
+    }
+    vlc_mutex_unlock(&lock);
     return new (std::nothrow) EsOutSendCommand( id, p_block );
 }
 
@@ -226,6 +253,43 @@ EsOutMetaCommand * CommandsFactory::createEsOutMetaCommand( int group, const vlc
     return NULL;
 }
 
+bool CommandsFactory::recycle( AbstractCommand *command ) const
+{
+    /* Only our own send commands, derived factories can return anything */
+    if( command->getType() != ES_OUT_PRIVATE_COMMAND_SEND ||
+        typeid(*command) != typeid(EsOutSendCommand) ||
+        pool.size() >= COMMANDS_POOL_SIZE )
+        return false;
+
+    EsOutSendCommand *sendcommand = static_cast<EsOutSendCommand *>(command);
+    if( sendcommand->p_block )
+    {
+        block_Release( sendcommand->p_block );
+        sendcommand->p_block = NULL;
+    }
+    pool.push_back( sendcommand );
+    return true;
+}
+
+void CommandsFactory::release( AbstractCommand *command ) const
+{
+    vlc_mutex_locker locker(&lock);
+    if( !recycle( command ) )
+        delete command;
+}
+
+void CommandsFactory::release( std::list<AbstractCommand *> &commands ) const
+{
+    vlc_mutex_locker locker(&lock);
+    std::list<AbstractCommand *>::const_iterator it;
+    for( it = commands.begin(); it != commands.end(); ++it )
+    {
+        if( !recycle( *it ) )
+            delete *it;
+    }
+    commands.clear();
+}
+
 /*
  * Commands Queue management
  */
@@ -274,7 +338,7 @@ void CommandsQueue::Schedule( AbstractCommand *command )
 {
     if( b_drop )
     {
-        delete command;
+        commandsFactory->release( command );
     }
     else if( command->getType() == ES_OUT_SET_GROUP_PCR )
     {
@@ -364,10 +428,10 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         b_draining = false;
 
     /* Now execute our selected commands */
-    while( !output.empty() )
+    std::list<AbstractCommand *>::const_iterator it;
+    for( it = output.begin(); it != output.end(); ++it )
     {
-        AbstractCommand *command = output.front();
-        output.pop_front();
+        AbstractCommand *command = *it;
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
         {
@@ -377,8 +441,10 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         }
 
         command->Execute( out );
-        delete command;
     }
+    /* and dispose the whole executed range at once */
+    commandsFactory->release( output );
+
     pcr = lastdts; /* Warn! no PCR update/lock release until execution */
 
 
@@ -400,11 +466,7 @@ void CommandsQueue::Commit()
 void CommandsQueue::Abort( bool b_reset )
 {
     commands.splice( commands.end(), incoming );
-    while( !commands.empty() )
-    {
-        delete commands.front();
-        commands.pop_front();
-    }
+    commandsFactory->release( commands );
 
     if( b_reset )
     {
@@ -25,6 +25,7 @@
 
 #include <atomic>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -137,7 +138,8 @@ namespace adaptive
     class CommandsFactory
     {
         public:
-            virtual ~CommandsFactory() {}
+            CommandsFactory();
+            virtual ~CommandsFactory();
             virtual EsOutSendCommand * createEsOutSendCommand( FakeESOutID *, block_t * ) const;
             virtual EsOutDelCommand * createEsOutDelCommand( FakeESOutID * ) const;
             virtual EsOutAddCommand * createEsOutAddCommand( FakeESOutID * ) const;
@@ -145,6 +147,14 @@ namespace adaptive
             virtual EsOutControlResetPCRCommand * creatEsOutControlResetPCRCommand() const;
             virtual EsOutDestroyCommand * createEsOutDestroyCommand() const;
             virtual EsOutMetaCommand * createEsOutMetaCommand( int, const vlc_meta_t * ) const;
+            /* Disposes commands, send ones are recycled for next allocations */
+            virtual void release( AbstractCommand * ) const;
+            void release( std::list<AbstractCommand *> & ) const;
+
+        private:
+            bool recycle( AbstractCommand * ) const;
+            mutable vlc_mutex_t lock;
+            mutable std::vector<EsOutSendCommand *> pool;
     };
 
     /* Queuing for doing all the stuff in order */
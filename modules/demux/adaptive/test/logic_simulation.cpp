@@ -0,0 +1,352 @@
+/*****************************************************************************
+ * logic_simulation.cpp: adaptation logics network simulation
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Replays bandwidth traces against the adaptation logics, simulating the
+ * download/playback loop of a single video stream, and reports per logic
+ * startup delay, rebuffering, average bitrate and switches.
+ *
+ * Usage: adaptive_logic_test [trace...]
+ * A trace file contains one "<duration_ms> <kbps>" step per line, which is
+ * the reduced form of the usual FCC or 4G/LTE throughput datasets. Without
+ * arguments, a few synthetic traces are used.
+ *
+ * This is a tool to compare the logics, not a test: it is built with
+ * "make check" but not run, as the results have no pass/fail criterion.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../playlist/AbstractPlaylist.hpp"
+#include "../playlist/BasePeriod.h"
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../logic/AlwaysBestAdaptationLogic.h"
+#include "../logic/RateBasedAdaptationLogic.h"
+#include "../logic/PredictiveAdaptationLogic.hpp"
+#include "../logic/NearOptimalAdaptationLogic.hpp"
+#include "../logic/HybridAdaptationLogic.hpp"
+#include "../SegmentTracker.hpp"
+#include "../ID.hpp"
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+
+#define SEGMENT_DURATION    VLC_TICK_FROM_SEC(2)
+#define SEGMENTS_COUNT      150
+#define MIN_BUFFERING       VLC_TICK_FROM_SEC(6)
+#define MAX_BUFFERING       VLC_TICK_FROM_SEC(30)
+#define REQUEST_LATENCY     VLC_TICK_FROM_MS(50)
+
+namespace
+{
+    class SimulatedPlaylist : public AbstractPlaylist
+    {
+        public:
+            SimulatedPlaylist() : AbstractPlaylist(NULL) {}
+            virtual bool isLive() const { return false; } /* impl */
+            virtual void debug() {} /* impl */
+    };
+
+    struct TraceStep
+    {
+        vlc_tick_t duration;
+        uint64_t   bps;
+    };
+
+    class BandwidthTrace
+    {
+        public:
+            BandwidthTrace(const std::string &name_) : name(name_), length(0) {}
+
+            void add(vlc_tick_t duration, uint64_t bps)
+            {
+                if(duration <= 0)
+                    return;
+                TraceStep step;
+                step.duration = duration;
+                step.bps = bps;
+                steps.push_back(step);
+                length += duration;
+            }
+
+            bool isEmpty() const
+            {
+                return length == 0;
+            }
+
+            /* Time required to transfer size bytes, starting at time.
+               The trace loops when shorter than the session. */
+            vlc_tick_t transferTime(vlc_tick_t time, uint64_t size) const
+            {
+                double bits = size * 8.0;
+                vlc_tick_t elapsed = 0;
+                vlc_tick_t offset = time % length;
+                std::vector<TraceStep>::const_iterator it = steps.begin();
+                while(offset >= (*it).duration)
+                {
+                    offset -= (*it).duration;
+                    ++it;
+                }
+                for(;;)
+                {
+                    const vlc_tick_t remain = (*it).duration - offset;
+                    const double stepbits = (double) (*it).bps * remain / CLOCK_FREQ;
+                    if(stepbits >= bits)
+                        return elapsed + (vlc_tick_t)(bits * CLOCK_FREQ / (*it).bps);
+                    bits -= stepbits;
+                    elapsed += remain;
+                    offset = 0;
+                    if(++it == steps.end())
+                        it = steps.begin();
+                }
+            }
+
+            std::string name;
+
+        private:
+            std::vector<TraceStep> steps;
+            vlc_tick_t length;
+    };
+
+    struct SimulationResult
+    {
+        vlc_tick_t startup;
+        unsigned   rebuffers;
+        vlc_tick_t stalled;
+        uint64_t   avgbitrate;
+        unsigned   switches;
+    };
+}
+
+static bool LoadTrace(const char *psz_path, BandwidthTrace &trace)
+{
+    FILE *fp = vlc_fopen(psz_path, "r");
+    if(!fp)
+        return false;
+    unsigned ms, kbps;
+    while(fscanf(fp, "%u %u", &ms, &kbps) == 2)
+    {
+        /* a zero throughput step would never complete a transfer */
+        trace.add(VLC_TICK_FROM_MS(ms), kbps ? kbps * UINT64_C(1000) : 1000);
+    }
+    fclose(fp);
+    return !trace.isEmpty();
+}
+
+static void BuildTraces(std::vector<BandwidthTrace> &traces)
+{
+    BandwidthTrace stable("stable 5Mbps");
+    stable.add(VLC_TICK_FROM_SEC(60), 5000000);
+    traces.push_back(stable);
+
+    BandwidthTrace drop("drop 8Mbps to 800kbps");
+    drop.add(VLC_TICK_FROM_SEC(60), 8000000);
+    drop.add(VLC_TICK_FROM_SEC(30), 800000);
+    drop.add(VLC_TICK_FROM_SEC(60), 8000000);
+    traces.push_back(drop);
+
+    /* cellular like variations, 1s steps */
+    static const unsigned mobile[] = { 4200, 3900, 5100, 2100, 800, 650, 1500, 3200,
+                                       6900, 7400, 5200, 2400, 1100, 400, 300, 900,
+                                       2600, 4100, 4800, 3300, 1900, 2200, 5600, 6100 };
+    BandwidthTrace fluctuating("fluctuating mobile");
+    for(size_t i=0; i<ARRAY_SIZE(mobile); i++)
+        fluctuating.add(VLC_TICK_FROM_SEC(1), mobile[i] * UINT64_C(1000));
+    traces.push_back(fluctuating);
+}
+
+static bool Simulate(AbstractAdaptationLogic *logic, const BandwidthTrace &trace,
+                     BaseAdaptationSet *adaptSet, SimulationResult *result)
+{
+    const ID &id = adaptSet->getID();
+    BaseRepresentation *prevRep = NULL;
+    vlc_tick_t now = 0;
+    vlc_tick_t buffering = 0;
+    bool b_playing = false;
+    uint64_t totalbitrate = 0;
+
+    result->startup = 0;
+    result->rebuffers = 0;
+    result->stalled = 0;
+    result->switches = 0;
+    result->avgbitrate = 0;
+
+    logic->trackerEvent(SegmentTrackerEvent(id, true));
+
+    for(unsigned i=0; i<SEGMENTS_COUNT; i++)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(adaptSet, prevRep);
+        if(rep == NULL)
+            return false;
+
+        if(rep != prevRep)
+        {
+            logic->trackerEvent(SegmentTrackerEvent(prevRep, rep));
+            if(prevRep)
+                result->switches++;
+            prevRep = rep;
+        }
+
+        const uint64_t size = rep->getBandwidth() * SEGMENT_DURATION / CLOCK_FREQ / 8;
+        const vlc_tick_t dltime = REQUEST_LATENCY + trace.transferTime(now, size);
+        now += dltime;
+
+        if(b_playing)
+        {
+            if(dltime > buffering)
+            {
+                result->rebuffers++;
+                result->stalled += dltime - buffering;
+                buffering = 0;
+                b_playing = false;
+            }
+            else buffering -= dltime;
+        }
+
+        logic->updateDownloadRate(id, size, dltime);
+        logic->trackerEvent(SegmentTrackerEvent(id, SEGMENT_DURATION));
+
+        buffering += SEGMENT_DURATION;
+        totalbitrate += rep->getBandwidth();
+
+        if(!b_playing && buffering >= MIN_BUFFERING)
+        {
+            if(result->startup == 0)
+                result->startup = now;
+            b_playing = true;
+        }
+
+        /* buffer full, wait for playback to drain it */
+        if(b_playing && buffering > MAX_BUFFERING)
+        {
+            now += buffering - MAX_BUFFERING;
+            buffering = MAX_BUFFERING;
+        }
+
+        logic->trackerEvent(SegmentTrackerEvent(id, MIN_BUFFERING,
+                                                buffering, MAX_BUFFERING));
+    }
+
+    logic->trackerEvent(SegmentTrackerEvent(id, false));
+
+    result->avgbitrate = totalbitrate / SEGMENTS_COUNT;
+    return true;
+}
+
+static AbstractAdaptationLogic * CreateLogic(unsigned i, const char **ppsz_name)
+{
+    switch(i)
+    {
+        case 0:
+            *ppsz_name = "alwaysbest";
+            return new (std::nothrow) AlwaysBestAdaptationLogic(NULL);
+        case 1:
+            *ppsz_name = "ratebased";
+            return new (std::nothrow) RateBasedAdaptationLogic(NULL);
+        case 2:
+            *ppsz_name = "predictive";
+            return new (std::nothrow) PredictiveAdaptationLogic(NULL);
+        case 3:
+            *ppsz_name = "nearoptimal";
+            return new (std::nothrow) NearOptimalAdaptationLogic(NULL);
+        case 4:
+            *ppsz_name = "hybrid";
+            return new (std::nothrow) HybridAdaptationLogic(NULL, "");
+        default:
+            return NULL;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const uint64_t bitrates[] = { 300000, 750000, 1200000,
+                                         2400000, 4800000, 8000000 };
+
+    std::vector<BandwidthTrace> traces;
+    for(int i=1; i<argc; i++)
+    {
+        BandwidthTrace trace(argv[i]);
+        if(!LoadTrace(argv[i], trace))
+        {
+            fprintf(stderr, "can't load trace %s\n", argv[i]);
+            return 1;
+        }
+        traces.push_back(trace);
+    }
+    if(traces.empty())
+        BuildTraces(traces);
+
+    SimulatedPlaylist *playlist = new SimulatedPlaylist();
+    BasePeriod *period = new BasePeriod(playlist);
+    BaseAdaptationSet *adaptSet = new BaseAdaptationSet(period);
+    adaptSet->setID(ID("video"));
+    for(size_t i=0; i<ARRAY_SIZE(bitrates); i++)
+    {
+        BaseRepresentation *rep = new BaseRepresentation(adaptSet);
+        rep->setBandwidth(bitrates[i]);
+        adaptSet->addRepresentation(rep);
+    }
+    period->addAdaptationSet(adaptSet);
+    playlist->addPeriod(period);
+
+    int i_ret = 0;
+    std::vector<BandwidthTrace>::const_iterator it;
+    for(it = traces.begin(); it != traces.end(); ++it)
+    {
+        printf("trace: %s\n", (*it).name.c_str());
+        printf("  %-12s %10s %10s %10s %12s %9s\n", "logic", "startup",
+               "rebuffers", "stalled", "avg kbps", "switches");
+        const char *psz_name;
+        AbstractAdaptationLogic *logic;
+        for(unsigned i=0; (logic = CreateLogic(i, &psz_name)); i++)
+        {
+            SimulationResult result;
+            if(!Simulate(logic, *it, adaptSet, &result))
+            {
+                fprintf(stderr, "logic %s failed selecting a representation\n",
+                        psz_name);
+                i_ret = 1;
+            }
+            else
+            {
+                printf("  %-12s %9.2fs %10u %9.2fs %12" PRIu64 " %9u\n", psz_name,
+                       secf_from_vlc_tick(result.startup), result.rebuffers,
+                       secf_from_vlc_tick(result.stalled),
+                       result.avgbitrate / 1000, result.switches);
+            }
+            delete logic;
+        }
+    }
+
+    delete playlist;
+
+    return i_ret;
+}
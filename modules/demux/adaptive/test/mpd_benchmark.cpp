@@ -0,0 +1,287 @@
+/*****************************************************************************
+ * mpd_benchmark.cpp: DASH MPD parsing benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Compares the time and the peak C++ heap of the DOM and the streaming
+ * parsing of an MPD.
+ *
+ * Usage: adaptive_mpd_benchmark [mpd]
+ * Without argument, a multi-period MPD with long SegmentTimelines is
+ * generated. The xml reader is a plugin: VLC_PLUGIN_PATH must point to the
+ * modules directory.
+ *
+ * Like adaptive_logic_test, this is built with "make check" but not run.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../dash/mpd/IsoffMainParser.h"
+#include "../../dash/mpd/MPD.h"
+#include "../xml/DOMParser.h"
+
+#include "../../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_fs.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <sstream>
+#include <string>
+
+using namespace adaptive;
+using namespace dash::mpd;
+
+#define ITERATIONS 5
+
+/* Accounting of the C++ heap: the nodes, their strings and the MPD
+ * objects. The C allocations of the xml reader are not included. */
+static size_t heap_current;
+static size_t heap_peak;
+
+union heap_header
+{
+    size_t size;
+    std::max_align_t align;
+};
+
+static void *heap_alloc(size_t size)
+{
+    heap_header *h = (heap_header *) malloc(sizeof(*h) + size);
+    if(!h)
+        return NULL;
+    h->size = size;
+    heap_current += size;
+    if(heap_current > heap_peak)
+        heap_peak = heap_current;
+    return h + 1;
+}
+
+static void heap_free(void *p)
+{
+    if(!p)
+        return;
+    heap_header *h = (heap_header *) p - 1;
+    heap_current -= h->size;
+    free(h);
+}
+
+void *operator new(size_t size)
+{
+    void *p = heap_alloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return heap_alloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return heap_alloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    heap_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    heap_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    heap_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    heap_free(p);
+}
+
+/* Periods of AdaptationSets, each one with its SegmentTimeline */
+static std::string GenerateMPD(unsigned periods, unsigned sets,
+                               unsigned representations, unsigned segments)
+{
+    std::ostringstream mpd;
+
+    mpd << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\" "
+           "profiles=\"urn:mpeg:dash:profile:isoff-live:2011\" "
+           "minBufferTime=\"PT2S\" mediaPresentationDuration=\"PT"
+        << periods * segments * 2 << "S\">\n";
+    for(unsigned p = 0; p < periods; p++)
+    {
+        mpd << " <Period id=\"p" << p << "\" start=\"PT"
+            << p * segments * 2 << "S\">\n";
+        for(unsigned a = 0; a < sets; a++)
+        {
+            mpd << "  <AdaptationSet id=\"" << a << "\" mimeType=\"video/mp4\" "
+                   "segmentAlignment=\"true\">\n"
+                   "   <SegmentTemplate timescale=\"90000\" "
+                   "initialization=\"init-$RepresentationID$.mp4\" "
+                   "media=\"seg-$RepresentationID$-$Time$.m4s\">\n"
+                   "    <SegmentTimeline>\n";
+            /* slightly varying durations, as encoders produce */
+            uint64_t t = 0;
+            for(unsigned s = 0; s < segments; s++)
+            {
+                const unsigned d = 180000 + ((s * 7919) % 5) * 1800;
+                mpd << "     <S t=\"" << t << "\" d=\"" << d << "\"/>\n";
+                t += d;
+            }
+            mpd << "    </SegmentTimeline>\n"
+                   "   </SegmentTemplate>\n";
+            for(unsigned r = 0; r < representations; r++)
+                mpd << "   <Representation id=\"p" << p << "a" << a << "r" << r
+                    << "\" bandwidth=\"" << (r + 1) * 800000
+                    << "\" codecs=\"avc1.64001f\" width=\"" << 320 * (r + 1)
+                    << "\" height=\"" << 180 * (r + 1) << "\"/>\n";
+            mpd << "  </AdaptationSet>\n";
+        }
+        mpd << " </Period>\n";
+    }
+    mpd << "</MPD>\n";
+    return mpd.str();
+}
+
+static bool LoadMPD(const char *psz_path, std::string &mpd)
+{
+    FILE *fp = vlc_fopen(psz_path, "rb");
+    if(!fp)
+        return false;
+    char buf[65536];
+    size_t len;
+    while((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+        mpd.append(buf, len);
+    fclose(fp);
+    return !mpd.empty();
+}
+
+struct BenchmarkResult
+{
+    vlc_tick_t time;
+    size_t     peak;
+};
+
+static bool Parse(vlc_object_t *obj, const std::string &data, bool b_streaming,
+                  BenchmarkResult *result)
+{
+    stream_t *s = vlc_stream_MemoryNew(obj, (uint8_t *) data.data(),
+                                       data.size(), true);
+    if(!s)
+        return false;
+
+    const size_t base = heap_current;
+    heap_peak = heap_current;
+    const vlc_tick_t start = vlc_tick_now();
+
+    MPD *mpd;
+    {
+        xml::DOMParser parser(s);
+        if(b_streaming)
+        {
+            IsoffMainParser mpdparser(obj, s, "http://localhost/");
+            mpd = mpdparser.parse(parser);
+        }
+        else if(parser.parse(true))
+        {
+            IsoffMainParser mpdparser(parser.getRootNode(), obj, s,
+                                      "http://localhost/");
+            mpd = mpdparser.parse();
+        }
+        else mpd = NULL;
+    }
+
+    result->time = vlc_tick_now() - start;
+    result->peak = heap_peak - base;
+    vlc_stream_Delete(s);
+    if(!mpd)
+        return false;
+    delete mpd;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data;
+    if(argc > 1)
+    {
+        if(!LoadMPD(argv[1], data))
+        {
+            fprintf(stderr, "can't load %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else data = GenerateMPD(4, 6, 6, 3000);
+
+    static const char *args[] = { "--ignore-config", "--quiet" };
+    libvlc_int_t *vlc = libvlc_InternalCreate();
+    if(!vlc)
+        return 1;
+    if(libvlc_InternalInit(vlc, ARRAY_SIZE(args), args) != VLC_SUCCESS)
+    {
+        libvlc_InternalDestroy(vlc);
+        return 1;
+    }
+
+    int i_ret = 0;
+    printf("MPD: %zu KiB\n", data.size() / 1024);
+    printf("  %-10s %12s %14s\n", "parser", "best time", "peak C++ heap");
+    for(int streaming = 0; streaming < 2; streaming++)
+    {
+        BenchmarkResult best = { INT64_MAX, 0 };
+        for(unsigned i = 0; i < ITERATIONS; i++)
+        {
+            BenchmarkResult result;
+            if(!Parse(VLC_OBJECT(vlc), data, streaming, &result))
+            {
+                fprintf(stderr, "parsing failed\n");
+                i_ret = 1;
+                break;
+            }
+            if(result.time < best.time)
+                best.time = result.time;
+            if(result.peak > best.peak)
+                best.peak = result.peak;
+        }
+        printf("  %-10s %10.1fms %10zu KiB\n", streaming ? "streaming" : "DOM",
+               MS_FROM_VLC_TICK((double) best.time), best.peak / 1024);
+    }
+
+    libvlc_InternalCleanup(vlc);
+    libvlc_InternalDestroy(vlc);
+    return i_ret;
+}
@@ -28,7 +28,6 @@
 #include "DOMParser.h"
 
 #include <vector>
-#include <stack>
 #include <vlc_xml.h>
 
 using namespace adaptive::xml;
@@ -58,7 +57,7 @@ Node*   DOMParser::getRootNode              ()
 {
     return this->root;
 }
-bool    DOMParser::parse                    (bool b)
+bool    DOMParser::parse                    (bool b, ElementHandler *handler)
 {
     if(!stream)
         return false;
@@ -69,7 +68,7 @@ bool    DOMParser::parse                    (bool b)
     struct vlc_logger *const logger = vlc_reader->obj.logger;
     if(!b)
         vlc_reader->obj.logger = NULL;
-    root = processNode(b);
+    root = processNode(b, handler);
     vlc_reader->obj.logger = logger;
     if ( root == NULL )
         return false;
@@ -90,11 +89,24 @@ bool DOMParser::reset(stream_t *s)
     return !!vlc_reader;
 }
 
-Node* DOMParser::processNode(bool b_strict)
+bool DOMParser::endNode(std::vector<Node *> &lifo, ElementHandler *handler)
+{
+    Node *node = lifo.back();
+    lifo.pop_back();
+    if(handler && !lifo.empty() && handler->onElementEnd(node, lifo))
+    {
+        lifo.back()->removeSubNode(node);
+        delete node;
+        return true;
+    }
+    return false;
+}
+
+Node* DOMParser::processNode(bool b_strict, ElementHandler *handler)
 {
     const char *data;
     int type;
-    std::stack<Node *> lifo;
+    std::vector<Node *> lifo;
 
     while( (type = xml_ReaderNextNode(vlc_reader, &data)) > 0 )
     {
@@ -107,22 +119,22 @@ Node* DOMParser::processNode(bool b_strict)
                 if(node)
                 {
                     if(!lifo.empty())
-                        lifo.top()->addSubNode(node);
-                    lifo.push(node);
+                        lifo.back()->addSubNode(node);
+                    lifo.push_back(node);
 
                     node->setName(std::string(data));
                     addAttributesToNode(node);
                 }
 
                 if(empty && lifo.size() > 1)
-                    lifo.pop();
+                    endNode(lifo, handler);
                 break;
             }
 
             case XML_READER_TEXT:
             {
                 if(!lifo.empty())
-                    lifo.top()->setText(std::string(data));
+                    lifo.back()->setText(std::string(data));
                 break;
             }
 
@@ -131,10 +143,13 @@ Node* DOMParser::processNode(bool b_strict)
                 if(lifo.empty())
                     return NULL;
 
-                Node *node = lifo.top();
-                lifo.pop();
-                if(lifo.empty())
+                if(lifo.size() == 1)
+                {
+                    Node *node = lifo.back();
+                    lifo.pop_back();
                     return node;
+                }
+                endNode(lifo, handler);
             }
 
             default:
@@ -142,10 +157,7 @@ Node* DOMParser::processNode(bool b_strict)
         }
     }
 
-    while( lifo.size() > 1 )
-        lifo.pop();
-
-    Node *node = (!lifo.empty()) ? lifo.top() : NULL;
+    Node *node = (!lifo.empty()) ? lifo.front() : NULL;
 
     if(b_strict && node)
     {
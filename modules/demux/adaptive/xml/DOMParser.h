@@ -37,11 +37,23 @@ namespace adaptive
         class DOMParser
         {
             public:
+                /* Streaming mode: handler is called on each completed
+                 * element and can consume it, so only the part of the
+                 * tree still being parsed stays in memory */
+                class ElementHandler
+                {
+                    public:
+                        virtual ~ElementHandler() {}
+                        /* ancestors are from root to parent. Returning
+                         * true deletes the element and its subtree */
+                        virtual bool onElementEnd(Node *, const std::vector<Node *> &ancestors) = 0;
+                };
+
                 DOMParser           ();
                 DOMParser           (stream_t *stream);
                 virtual ~DOMParser  ();
 
-                bool                parse       (bool);
+                bool                parse       (bool, ElementHandler * = NULL);
                 bool                reset       (stream_t *);
                 Node*               getRootNode ();
                 void                print       ();
@@ -52,7 +64,8 @@ namespace adaptive
 
                 xml_reader_t        *vlc_reader;
 
-                Node*   processNode             (bool);
+                Node*   processNode             (bool, ElementHandler *);
+                bool    endNode                 (std::vector<Node *> &, ElementHandler *);
                 void    addAttributesToNode     (Node *node);
                 void    print                   (Node *node, int offset);
         };
@@ -27,6 +27,7 @@
 
 #include "Node.h"
 
+#include <algorithm>
 #include <cassert>
 #include <vlc_common.h>
 #include <vlc_xml.h>
@@ -53,6 +54,14 @@ void                                Node::addSubNode            (Node *node)
 {
     this->subNodes.push_back(node);
 }
+void                                Node::removeSubNode         (Node *node)
+{
+    /* most likely the last added one */
+    std::vector<Node *>::reverse_iterator it =
+            std::find(this->subNodes.rbegin(), this->subNodes.rend(), node);
+    if(it != this->subNodes.rend())
+        this->subNodes.erase(--(it.base()));
+}
 const std::string&                  Node::getName               () const
 {
     return this->name;
@@ -41,6 +41,7 @@ namespace adaptive
 
                 const std::vector<Node *>&          getSubNodes         () const;
                 void                                addSubNode          (Node *node);
+                void                                removeSubNode       (Node *node);
                 const std::string&                  getName             () const;
                 void                                setName             (const std::string& name);
                 bool                                hasAttribute        (const std::string& name) const;
@@ -118,7 +118,6 @@ typedef struct
 
 typedef struct
 {
-    vlc_fourcc_t i_id;
     uint32_t     i_flags;
     uint64_t     i_pos;
     uint32_t     i_length;
@@ -126,16 +125,57 @@ typedef struct
 
 } avi_entry_t;
 
+/* The index is stored packed, by blocks of AVI_INDEX_BLOCK entries: the
+ * positions and the cumulated lengths are relative to the first entry of
+ * the block. Entries that cannot be packed are stored apart. */
+#define AVI_INDEX_BLOCK     256
+#define AVI_INDEX_KEYFRAME  UINT32_C(0x80000000)
+#define AVI_INDEX_WIDE      UINT32_MAX
+
+typedef struct
+{
+    uint32_t i_pos;
+    uint32_t i_lengthtotal;
+    uint32_t i_length;      /* with AVI_INDEX_KEYFRAME, or AVI_INDEX_WIDE */
+} avi_packed_entry_t;
+
+typedef struct
+{
+    uint64_t i_pos;
+    uint64_t i_lengthtotal;
+} avi_index_block_t;
+
 typedef struct
 {
-    uint32_t        i_size;
-    uint32_t        i_max;
-    avi_entry_t     *p_entry;
+    uint32_t    i_entry;
+    avi_entry_t entry;
+} avi_wide_entry_t;
+
+typedef struct
+{
+    uint32_t            i_size;
+    uint32_t            i_max;
+    avi_packed_entry_t  *p_entry;
+    avi_index_block_t   *p_block;
+
+    uint32_t            i_wide;
+    uint32_t            i_wide_max;
+    avi_wide_entry_t    *p_wide;
+
+    uint64_t            i_total;    /* sum of the lengths of the entries */
+    bool                b_keyframe_all;
+
+    /* OpenDML super index, the sub-indexes are loaded on demand, in order */
+    avi_chunk_indx_t    *p_super;
+    uint32_t            i_super_next;
 
 } avi_index_t;
 static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
-static void avi_index_Append( avi_index_t *, uint64_t *, avi_entry_t * );
+static void avi_index_Append( avi_index_t *, uint64_t *, const avi_entry_t * );
+static avi_entry_t avi_index_Get( const avi_index_t *, uint32_t );
+static uint32_t avi_index_FindByte( const avi_index_t *, uint64_t );
+static uint32_t avi_index_FindPos( const avi_index_t *, uint64_t );
 
 typedef struct
 {
@@ -219,6 +259,9 @@ static int AVI_PacketSearch   ( demux_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static bool AVI_IndexLoadNext( demux_t *, avi_index_t *, uint64_t * );
+static bool AVI_IndexHas     ( demux_t *, avi_track_t *, uint32_t );
+static uint64_t AVI_IndexGetCount( const avi_track_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -716,8 +759,8 @@ aviindex:
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         const avi_track_t *tk = p_sys->track[i];
-        if( tk->fmt.i_cat == VIDEO_ES && tk->idx.p_entry )
-            i_idx_totalframes = __MAX(i_idx_totalframes, tk->idx.i_size);
+        if( tk->fmt.i_cat == VIDEO_ES && tk->idx.i_size > 0 )
+            i_idx_totalframes = __MAX(i_idx_totalframes, AVI_IndexGetCount( tk ));
     }
     if( i_idx_totalframes != p_avih->i_totalframes &&
         p_sys->i_length < VLC_TICK_FROM_US( p_avih->i_totalframes *
@@ -790,9 +833,11 @@ aviindex:
             p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
             tk->i_rate == p_auds->p_wf->nSamplesPerSec )
         {
-            int64_t i_track_length =
-                tk->idx.p_entry[tk->idx.i_size-1].i_length +
-                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
+            /* the whole index is needed */
+            while( AVI_IndexLoadNext( p_demux, &tk->idx,
+                                      &p_sys->i_movi_lastchunk_pos ) )
+                ;
+            int64_t i_track_length = tk->idx.i_total;
             vlc_tick_t i_length = VLC_TICK_FROM_US( p_avih->i_totalframes *
                                                     p_avih->i_microsecperframe );
 
@@ -1030,9 +1075,9 @@ static int Demux_Seekable( demux_t *p_demux )
         avi_track_t *tk = p_sys->track[i_track];
 
         toread[i_track].b_ok = tk->b_activated && !tk->b_eof;
-        if( tk->i_idxposc < tk->idx.i_size )
+        if( AVI_IndexHas( p_demux, tk, tk->i_idxposc ) )
         {
-            toread[i_track].i_posf = tk->idx.p_entry[tk->i_idxposc].i_pos;
+            toread[i_track].i_posf = avi_index_Get( &tk->idx, tk->i_idxposc ).i_pos;
            if( tk->i_idxposb > 0 )
            {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1162,11 +1207,9 @@ static int Demux_Seekable( demux_t *p_demux )
 
                     /* add this chunk to the index */
                     avi_entry_t index;
-                    index.i_id     = avi_pk.i_fourcc;
                     index.i_flags  = AVI_GetKeyFlag(tk->fmt.i_codec, avi_pk.i_peek);
                     index.i_pos    = avi_pk.i_pos;
                     index.i_length = avi_pk.i_size;
-                    index.i_lengthtotal = index.i_length;
                     avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
 
                     /* do we will read this data ? */
@@ -1195,6 +1238,7 @@ static int Demux_Seekable( demux_t *p_demux )
 
         /* Set the track to use */
         tk = p_sys->track[i_track];
+        const avi_entry_t entry = avi_index_Get( &tk->idx, tk->i_idxposc );
 
         /* read thoses data */
         if( tk->i_samplesize )
@@ -1213,13 +1257,12 @@ static int Demux_Seekable( demux_t *p_demux )
                     i_toread = __MAX( i_toread, 100 );
                 }
             }
-            i_size = __MIN( tk->idx.p_entry[tk->i_idxposc].i_length -
-                                tk->i_idxposb,
+            i_size = __MIN( entry.i_length - tk->i_idxposb,
                             (size_t) i_toread );
         }
         else
         {
-            i_size = tk->idx.p_entry[tk->i_idxposc].i_length;
+            i_size = entry.i_length;
         }
 
         if( tk->i_idxposb == 0 )
@@ -1237,7 +1280,7 @@ static int Demux_Seekable( demux_t *p_demux )
         }
 
         p_frame->i_pts = VLC_TICK_0 + AVI_GetPTS( tk );
-        if( tk->idx.p_entry[tk->i_idxposc].i_flags&AVIIF_KEYFRAME )
+        if( entry.i_flags&AVIIF_KEYFRAME )
         {
             p_frame->i_flags = BLOCK_FLAG_TYPE_I;
         }
@@ -1255,8 +1298,7 @@ static int Demux_Seekable( demux_t *p_demux )
             }
             toread[i_track].i_toread -= i_size;
             tk->i_idxposb += i_size;
-            if( tk->i_idxposb >=
-                    tk->idx.p_entry[tk->i_idxposc].i_length )
+            if( tk->i_idxposb >= entry.i_length )
             {
                 tk->i_idxposb = 0;
                 tk->i_idxposc++;
@@ -1264,20 +1306,18 @@ static int Demux_Seekable( demux_t *p_demux )
         }
         else
         {
-            int i_length = tk->idx.p_entry[tk->i_idxposc].i_length;
-
             tk->i_idxposc++;
             if( tk->fmt.i_cat == AUDIO_ES )
             {
-                tk->i_blockno += tk->i_blocksize > 0 ? ( i_length + tk->i_blocksize - 1 ) / tk->i_blocksize : 1;
+                tk->i_blockno += tk->i_blocksize > 0 ? ( entry.i_length + tk->i_blocksize - 1 ) / tk->i_blocksize : 1;
             }
             toread[i_track].i_toread--;
         }
 
-        if( tk->i_idxposc < tk->idx.i_size)
+        if( AVI_IndexHas( p_demux, tk, tk->i_idxposc ) )
         {
             toread[i_track].i_posf =
-                tk->idx.p_entry[tk->i_idxposc].i_pos;
+                avi_index_Get( &tk->idx, tk->i_idxposc ).i_pos;
             if( tk->i_idxposb > 0 )
             {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1522,8 +1562,22 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
                 goto failandresetpos;
             }
 
-            while( i_pos >= p_stream->idx.p_entry[p_stream->i_idxposc].i_pos +
-               p_stream->idx.p_entry[p_stream->i_idxposc].i_length + 8 )
+            /* look for the chunk in the index, then in the file if the
+             * index ends before i_pos */
+            while( avi_index_Get( &p_stream->idx, p_stream->idx.i_size - 1 ).i_pos +
+                   avi_index_Get( &p_stream->idx, p_stream->idx.i_size - 1 ).i_length + 8 <= i_pos &&
+                   AVI_IndexLoadNext( p_demux, &p_stream->idx,
+                                      &p_sys->i_movi_lastchunk_pos ) )
+                ;
+            if( AVI_StreamChunkSet( p_demux, i_stream,
+                                    avi_index_FindPos( &p_stream->idx, i_pos ) ) )
+            {
+                msg_Warn( p_demux, "cannot seek" );
+                goto failandresetpos;
+            }
+
+            while( i_pos >= avi_index_Get( &p_stream->idx, p_stream->i_idxposc ).i_pos +
+                   avi_index_Get( &p_stream->idx, p_stream->i_idxposc ).i_length + 8 )
             {
                 /* search after i_idxposc */
                 if( AVI_StreamChunkSet( p_demux,
@@ -1788,13 +1842,11 @@ static vlc_tick_t AVI_GetPTS( avi_track_t *tk )
         if( idx >= tk->idx.i_size )
         {
             /* use the last entry */
-            idx = tk->idx.i_size - 1;
-            i_count = tk->idx.p_entry[idx].i_lengthtotal
-                    + tk->idx.p_entry[idx].i_length;
+            i_count = tk->idx.i_total;
         }
         else
         {
-            i_count = tk->idx.p_entry[idx].i_lengthtotal;
+            i_count = avi_index_Get( &tk->idx, idx ).i_lengthtotal;
         }
         return AVI_GetDPTS( tk, i_count + tk->i_idxposb );
     }
@@ -1852,11 +1904,9 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
             /* add this chunk to the index */
             avi_entry_t index;
-            index.i_id     = avi_pk.i_fourcc;
             index.i_flags  = AVI_GetKeyFlag(tk_pk->fmt.i_codec, avi_pk.i_peek);
             index.i_pos    = avi_pk.i_pos;
             index.i_length = avi_pk.i_size;
-            index.i_lengthtotal = index.i_length;
             avi_index_Append( &tk_pk->idx, &p_sys->i_movi_lastchunk_pos, &index );
 
             if( avi_pk.i_stream == i_stream  )
@@ -1882,7 +1932,7 @@ static int AVI_StreamChunkSet( demux_t *p_demux, unsigned int i_stream,
     p_stream->i_idxposc = i_ck;
     p_stream->i_idxposb = 0;
 
-    if(  i_ck >= p_stream->idx.i_size )
+    if( !AVI_IndexHas( p_demux, p_stream, i_ck ) )
     {
         p_stream->i_idxposc = p_stream->idx.i_size - 1;
         do
@@ -1907,43 +1957,23 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
     demux_sys_t *p_sys = p_demux->p_sys;
     avi_track_t *p_stream = p_sys->track[i_stream];
 
-    if( ( p_stream->idx.i_size > 0 )
-        &&( i_byte < p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_lengthtotal +
-                p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_length ) )
+    while( i_byte >= p_stream->idx.i_total &&
+           AVI_IndexLoadNext( p_demux, &p_stream->idx,
+                              &p_sys->i_movi_lastchunk_pos ) )
+        ;
+
+    if( i_byte < p_stream->idx.i_total )
     {
         /* index is valid to find the ck */
-        /* uses dichototmie to be fast enougth */
-        int i_idxposc = __MIN( p_stream->i_idxposc, p_stream->idx.i_size - 1 );
-        int i_idxmax  = p_stream->idx.i_size;
-        int i_idxmin  = 0;
-        for( ;; )
-        {
-            if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal > i_byte )
-            {
-                i_idxmax  = i_idxposc ;
-                i_idxposc = ( i_idxmin + i_idxposc ) / 2 ;
-            }
-            else
-            {
-                if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal +
-                        p_stream->idx.p_entry[i_idxposc].i_length <= i_byte)
-                {
-                    i_idxmin  = i_idxposc ;
-                    i_idxposc = (i_idxmax + i_idxposc ) / 2 ;
-                }
-                else
-                {
-                    p_stream->i_idxposc = i_idxposc;
-                    p_stream->i_idxposb = i_byte -
-                            p_stream->idx.p_entry[i_idxposc].i_lengthtotal;
-                    return VLC_SUCCESS;
-                }
-            }
-        }
-
+        p_stream->i_idxposc = avi_index_FindByte( &p_stream->idx, i_byte );
+        p_stream->i_idxposb = i_byte -
+            avi_index_Get( &p_stream->idx, p_stream->i_idxposc ).i_lengthtotal;
+        return VLC_SUCCESS;
     }
     else
     {
+        avi_entry_t entry;
+
         p_stream->i_idxposc = p_stream->idx.i_size - 1;
         p_stream->i_idxposb = 0;
         do
@@ -1954,11 +1984,10 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                 return VLC_EGENERIC;
             }
 
-        } while( p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal +
-                    p_stream->idx.p_entry[p_stream->i_idxposc].i_length <= i_byte );
+            entry = avi_index_Get( &p_stream->idx, p_stream->i_idxposc );
+        } while( entry.i_lengthtotal + entry.i_length <= i_byte );
 
-        p_stream->i_idxposb = i_byte -
-                       p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal;
+        p_stream->i_idxposb = i_byte - entry.i_lengthtotal;
         return VLC_SUCCESS;
     }
 }
@@ -1992,7 +2021,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             {
                 if( tk->i_blocksize > 0 )
                 {
-                    tk->i_blockno += ( tk->idx.p_entry[i].i_length + tk->i_blocksize - 1 ) / tk->i_blocksize;
+                    tk->i_blockno += ( avi_index_Get( &tk->idx, i ).i_length + tk->i_blocksize - 1 ) / tk->i_blocksize;
                 }
                 else
                 {
@@ -2013,7 +2042,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             //if( i_date < i_oldpts || 1 )
             {
                 while( p_stream->i_idxposc > 0 &&
-                   !( p_stream->idx.p_entry[p_stream->i_idxposc].i_flags &
+                   !( avi_index_Get( &p_stream->idx, p_stream->i_idxposc ).i_flags &
                                                                 AVIIF_KEYFRAME ) )
                 {
                     if( AVI_StreamChunkSet( p_demux,
@@ -2028,7 +2057,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             else
             {
                 while( p_stream->i_idxposc < p_stream->idx.i_size &&
-                        !( p_stream->idx.p_entry[p_stream->i_idxposc].i_flags &
+                        !( avi_index_Get( &p_stream->idx, p_stream->i_idxposc ).i_flags &
                                                                 AVIIF_KEYFRAME ) )
                 {
                     if( AVI_StreamChunkSet( p_demux,
@@ -2263,16 +2292,16 @@ static int AVI_PacketSearch( demux_t *p_demux )
  ****************************************************************************/
 static void avi_index_Init( avi_index_t *p_index )
 {
-    p_index->i_size  = 0;
-    p_index->i_max   = 0;
-    p_index->p_entry = NULL;
+    memset( p_index, 0, sizeof( *p_index ) );
 }
 static void avi_index_Clean( avi_index_t *p_index )
 {
     free( p_index->p_entry );
+    free( p_index->p_block );
+    free( p_index->p_wide );
 }
 static void avi_index_Append( avi_index_t *p_index, uint64_t *pi_last_pos,
-                              avi_entry_t *p_entry )
+                              const avi_entry_t *p_entry )
 {
     /* Update last chunk position */
     if( *pi_last_pos < p_entry->i_pos )
@@ -2281,25 +2310,130 @@ static void avi_index_Append( avi_index_t *p_index, uint64_t *pi_last_pos,
     /* add the entry */
     if( p_index->i_size >= p_index->i_max )
     {
-        p_index->i_max += 16384;
-        p_index->p_entry = realloc_or_free( p_index->p_entry,
-                                            p_index->i_max * sizeof( *p_index->p_entry ) );
-        if( !p_index->p_entry )
+        const uint32_t i_max = p_index->i_max + 16384;
+        avi_packed_entry_t *p_packed =
+            realloc( p_index->p_entry, i_max * sizeof( *p_packed ) );
+        if( !p_packed )
+            return;
+        p_index->p_entry = p_packed;
+
+        avi_index_block_t *p_block =
+            realloc( p_index->p_block,
+                     i_max / AVI_INDEX_BLOCK * sizeof( *p_block ) );
+        if( !p_block )
             return;
+        p_index->p_block = p_block;
+        p_index->i_max = i_max;
+    }
+
+    const uint32_t i_entry = p_index->i_size;
+    avi_index_block_t *p_block = &p_index->p_block[i_entry / AVI_INDEX_BLOCK];
+    if( i_entry % AVI_INDEX_BLOCK == 0 )
+    {
+        p_block->i_pos = p_entry->i_pos;
+        p_block->i_lengthtotal = p_index->i_total;
     }
-    /* calculate cumulate length */
-    if( p_index->i_size > 0 )
+
+    avi_packed_entry_t *p_packed = &p_index->p_entry[i_entry];
+    if( p_entry->i_pos >= p_block->i_pos &&
+        p_entry->i_pos - p_block->i_pos <= UINT32_MAX &&
+        p_index->i_total - p_block->i_lengthtotal <= UINT32_MAX &&
+        p_entry->i_length < AVI_INDEX_KEYFRAME - 1 )
+    {
+        p_packed->i_pos = p_entry->i_pos - p_block->i_pos;
+        p_packed->i_lengthtotal = p_index->i_total - p_block->i_lengthtotal;
+        p_packed->i_length = p_entry->i_length;
+        if( p_entry->i_flags & AVIIF_KEYFRAME )
+            p_packed->i_length |= AVI_INDEX_KEYFRAME;
+    }
+    else
+    {
+        /* chunk out of order or too far away, very unlikely */
+        if( p_index->i_wide >= p_index->i_wide_max )
+        {
+            const uint32_t i_max = p_index->i_wide_max + 64;
+            avi_wide_entry_t *p_wide =
+                realloc( p_index->p_wide, i_max * sizeof( *p_wide ) );
+            if( !p_wide )
+                return;
+            p_index->p_wide = p_wide;
+            p_index->i_wide_max = i_max;
+        }
+        avi_wide_entry_t *p_wide = &p_index->p_wide[p_index->i_wide++];
+        p_wide->i_entry = i_entry;
+        p_wide->entry = *p_entry;
+        p_wide->entry.i_lengthtotal = p_index->i_total;
+        p_packed->i_length = AVI_INDEX_WIDE;
+    }
+
+    p_index->i_total += p_entry->i_length;
+    p_index->i_size++;
+}
+static avi_entry_t avi_index_Get( const avi_index_t *p_index, uint32_t i_entry )
+{
+    const avi_packed_entry_t *p_packed = &p_index->p_entry[i_entry];
+    avi_entry_t entry;
+
+    if( p_packed->i_length != AVI_INDEX_WIDE )
     {
-        p_entry->i_lengthtotal =
-            p_index->p_entry[p_index->i_size - 1].i_length +
-                p_index->p_entry[p_index->i_size - 1].i_lengthtotal;
+        const avi_index_block_t *p_block =
+            &p_index->p_block[i_entry / AVI_INDEX_BLOCK];
+
+        entry.i_flags = p_packed->i_length & AVI_INDEX_KEYFRAME ? AVIIF_KEYFRAME : 0;
+        entry.i_pos = p_block->i_pos + p_packed->i_pos;
+        entry.i_length = p_packed->i_length & ~AVI_INDEX_KEYFRAME;
+        entry.i_lengthtotal = p_block->i_lengthtotal + p_packed->i_lengthtotal;
     }
     else
     {
-        p_entry->i_lengthtotal = 0;
+        /* the wide entries are sorted */
+        uint32_t i_min = 0, i_max = p_index->i_wide;
+        while( i_max - i_min > 1 )
+        {
+            uint32_t i_mid = ( i_min + i_max ) / 2;
+            if( p_index->p_wide[i_mid].i_entry <= i_entry )
+                i_min = i_mid;
+            else
+                i_max = i_mid;
+        }
+        assert( p_index->p_wide[i_min].i_entry == i_entry );
+        entry = p_index->p_wide[i_min].entry;
     }
 
-    p_index->p_entry[p_index->i_size++] = *p_entry;
+    if( p_index->b_keyframe_all )
+        entry.i_flags |= AVIIF_KEYFRAME;
+    return entry;
+}
+/* Entry containing the byte i_byte of the track, i_byte must be lower
+ * than i_total */
+static uint32_t avi_index_FindByte( const avi_index_t *p_index, uint64_t i_byte )
+{
+    uint32_t i_min = 0, i_max = p_index->i_size;
+    while( i_max - i_min > 1 )
+    {
+        uint32_t i_mid = ( i_min + i_max ) / 2;
+        if( avi_index_Get( p_index, i_mid ).i_lengthtotal <= i_byte )
+            i_min = i_mid;
+        else
+            i_max = i_mid;
+    }
+    return i_min;
+}
+/* First entry ending after the file position i_pos, or the last entry,
+ * assuming the chunks of a track are stored in order */
+static uint32_t avi_index_FindPos( const avi_index_t *p_index, uint64_t i_pos )
+{
+    uint32_t i_min = 0, i_max = p_index->i_size - 1;
+    while( i_min < i_max )
+    {
+        uint32_t i_mid = ( i_min + i_max ) / 2;
+        avi_entry_t entry = avi_index_Get( p_index, i_mid );
+        if( entry.i_pos + entry.i_length + 8 <= i_pos )
+            i_min = i_mid + 1;
+        else
+            i_max = i_mid;
+    }
+    return i_min;
 }
 
 static int AVI_IndexFind_idx1( demux_t *p_demux,
@@ -2391,11 +2525,9 @@ static int AVI_IndexLoad_idx1( demux_t *p_demux,
             (i_cat == p_sys->track[i_stream]->fmt.i_cat || i_cat == UNKNOWN_ES ) )
         {
             avi_entry_t index;
-            index.i_id     = p_idx1->entry[i_index].i_fourcc;
             index.i_flags  = p_idx1->entry[i_index].i_flags&(~AVIIF_FIXKEYFRAME);
             index.i_pos    = p_idx1->entry[i_index].i_pos + i_offset;
             index.i_length = p_idx1->entry[i_index].i_length;
-            index.i_lengthtotal = index.i_length;
 
             avi_index_Append( &p_index[i_stream], pi_last_offset, &index );
         }
@@ -2410,14 +2542,14 @@ static int AVI_IndexLoad_idx1( demux_t *p_demux,
             if( p_sys->track[i_index]->i_samplesize )
             {
                 i_length = AVI_GetDPTS( p_sys->track[i_index],
-                                        p_index[i_index].p_entry[i].i_lengthtotal );
+                                        avi_index_Get( &p_index[i_index], i ).i_lengthtotal );
             }
             else
             {
                 i_length = AVI_GetDPTS( p_sys->track[i_index], i );
             }
             msg_Dbg( p_demux, "index stream %d @%ld time %ld", i_index,
-                     p_index[i_index].p_entry[i].i_pos, i_length );
+                     avi_index_Get( &p_index[i_index], i ).i_pos, i_length );
         }
     }
 #endif
@@ -2437,11 +2569,9 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     {
         for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
         {
-            index.i_id     = p_indx->i_id;
             index.i_flags  = p_indx->idx.std[i].i_size & 0x80000000 ? 0 : AVIIF_KEYFRAME;
             index.i_pos    = p_indx->i_baseoffset + p_indx->idx.std[i].i_offset - 8;
             index.i_length = p_indx->idx.std[i].i_size&0x7fffffff;
-            index.i_lengthtotal = index.i_length;
 
             avi_index_Append( p_index, pi_max_offset, &index );
         }
@@ -2450,11 +2580,9 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     {
         for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
         {
-            index.i_id     = p_indx->i_id;
             index.i_flags  = p_indx->idx.field[i].i_size & 0x80000000 ? 0 : AVIIF_KEYFRAME;
             index.i_pos    = p_indx->i_baseoffset + p_indx->idx.field[i].i_offset - 8;
             index.i_length = p_indx->idx.field[i].i_size;
-            index.i_lengthtotal = index.i_length;
 
             avi_index_Append( p_index, pi_max_offset, &index );
         }
@@ -2465,6 +2593,71 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     }
 }
 
+static bool AVI_IndexLoadNext( demux_t *p_demux, avi_index_t *p_index,
+                               uint64_t *pi_last_offset )
+{
+    avi_chunk_indx_t *p_super = p_index->p_super;
+    if( p_super == NULL || p_index->i_super_next >= p_super->i_entriesinuse )
+        return false;
+
+    const uint32_t i_size = p_index->i_size;
+    const uint64_t i_pos = vlc_stream_Tell( p_demux->s );
+    avi_chunk_t ck_sub;
+
+    /* skip the empty sub-indexes */
+    while( p_index->i_size == i_size &&
+           p_index->i_super_next < p_super->i_entriesinuse )
+    {
+        const unsigned i = p_index->i_super_next++;
+        if( vlc_stream_Seek( p_demux->s, p_super->idx.super[i].i_offset ) ||
+            AVI_ChunkRead( p_demux->s, &ck_sub, NULL  ) )
+        {
+            p_index->i_super_next = p_super->i_entriesinuse;
+            break;
+        }
+        if( ck_sub.indx.i_indextype == AVI_INDEX_OF_CHUNKS )
+            __Parse_indx( p_demux, p_index, pi_last_offset, &ck_sub.indx );
+        AVI_ChunkClean( p_demux->s, &ck_sub );
+    }
+
+    if( vlc_stream_Seek( p_demux->s, i_pos ) )
+        msg_Err( p_demux, "cannot seek back after loading a sub-index" );
+    return p_index->i_size > i_size;
+}
+
+/* be sure that the entry i_entry is loaded, if it is in the index */
+static bool AVI_IndexHas( demux_t *p_demux, avi_track_t *tk, uint32_t i_entry )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    while( i_entry >= tk->idx.i_size )
+    {
+        if( !AVI_IndexLoadNext( p_demux, &tk->idx, &p_sys->i_movi_lastchunk_pos ) )
+            return false;
+    }
+    return true;
+}
+
+/* Number of entries, or of bytes for the tracks with a sample size, with
+ * an estimation for the sub-indexes not loaded yet */
+static uint64_t AVI_IndexGetCount( const avi_track_t *tk )
+{
+    uint64_t i_count = tk->i_samplesize ? tk->idx.i_total : tk->idx.i_size;
+    const avi_chunk_indx_t *p_super = tk->idx.p_super;
+
+    if( p_super != NULL )
+    {
+        for( uint32_t i = tk->idx.i_super_next; i < p_super->i_entriesinuse; i++ )
+        {
+            /* the duration is in stream ticks */
+            uint64_t i_duration = p_super->idx.super[i].i_duration;
+            i_count += tk->i_samplesize ? i_duration * tk->i_samplesize
+                                        : i_duration;
+        }
+    }
+    return i_count;
+}
+
 static void AVI_IndexLoad_indx( demux_t *p_demux,
                                 avi_index_t p_index[], uint64_t *pi_last_offset )
 {
@@ -2501,19 +2694,17 @@ static void AVI_IndexLoad_indx( demux_t *p_demux,
         {
             if ( !p_sys->b_seekable )
                 return;
-            avi_chunk_t    ck_sub;
-            for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
-            {
-                if( vlc_stream_Seek( p_demux->s,
-                                     p_indx->idx.super[i].i_offset ) ||
-                    AVI_ChunkRead( p_demux->s, &ck_sub, NULL  ) )
-                {
-                    break;
-                }
-                if( ck_sub.indx.i_indextype == AVI_INDEX_OF_CHUNKS )
-                    __Parse_indx( p_demux, &p_index[i_stream], pi_last_offset, &ck_sub.indx );
-                AVI_ChunkClean( p_demux->s, &ck_sub );
-            }
+            p_index[i_stream].p_super = p_indx;
+            p_index[i_stream].i_super_next = 0;
+
+            /* Without idx1 to compare with, the sub-indexes are loaded
+             * when the playback or a seek reaches them */
+            if( p_sys->b_odml )
+                AVI_IndexLoadNext( p_demux, &p_index[i_stream], pi_last_offset );
+            else
+                while( AVI_IndexLoadNext( p_demux, &p_index[i_stream],
+                                          pi_last_offset ) )
+                    ;
         }
         else
         {
@@ -2549,12 +2740,14 @@ static void AVI_IndexLoad( demux_t *p_demux )
         if( p_idx_indx[i].i_size > p_idx_idx1[i].i_size )
         {
             msg_Dbg( p_demux, "selected ODML index for stream[%u]", i );
+            avi_index_Clean( &p_sys->track[i]->idx );
             p_sys->track[i]->idx = p_idx_indx[i];
             avi_index_Clean( &p_idx_idx1[i] );
         }
         else
         {
             msg_Dbg( p_demux, "selected standard index for stream[%u]", i );
+            avi_index_Clean( &p_sys->track[i]->idx );
             p_sys->track[i]->idx = p_idx_idx1[i];
             avi_index_Clean( &p_idx_indx[i] );
         }
@@ -2568,12 +2761,11 @@ static void AVI_IndexLoad( demux_t *p_demux )
         /* Fix key flag */
         bool b_key = false;
         for( unsigned j = 0; !b_key && j < p_index->i_size; j++ )
-            b_key = p_index->p_entry[j].i_flags & AVIIF_KEYFRAME;
+            b_key = avi_index_Get( p_index, j ).i_flags & AVIIF_KEYFRAME;
         if( !b_key )
         {
             msg_Err( p_demux, "no key frame set for track %u", i );
-            for( unsigned j = 0; j < p_index->i_size; j++ )
-                p_index->p_entry[j].i_flags |= AVIIF_KEYFRAME;
+            p_index->b_keyframe_all = true;
         }
 
         /* */
@@ -2651,11 +2843,9 @@ static void AVI_IndexCreate( demux_t *p_demux )
             avi_track_t *tk = p_sys->track[pk.i_stream];
 
             avi_entry_t index;
-            index.i_id      = pk.i_fourcc;
             index.i_flags   = AVI_GetKeyFlag(tk->fmt.i_codec, pk.i_peek);
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
-            index.i_lengthtotal = pk.i_size;
             avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
         }
         else
@@ -2973,7 +3163,7 @@ static int AVI_TrackStopFinishedStreams( demux_t *p_demux )
     for( i = 0; i < p_sys->i_track; i++ )
     {
         avi_track_t *tk = p_sys->track[i];
-        if( tk->i_idxposc >= tk->idx.i_size )
+        if( !AVI_IndexHas( p_demux, tk, tk->i_idxposc ) )
         {
             tk->b_eof = true;
         }
@@ -3000,21 +3190,12 @@ static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
         vlc_tick_t i_length;
 
         /* fix length for each stream */
-        if( tk->idx.i_size < 1 || !tk->idx.p_entry )
+        if( tk->idx.i_size < 1 )
         {
             continue;
         }
 
-        if( tk->i_samplesize )
-        {
-            i_length = AVI_GetDPTS( tk,
-                                    tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
-                                        tk->idx.p_entry[tk->idx.i_size-1].i_length );
-        }
-        else
-        {
-            i_length = AVI_GetDPTS( tk, tk->idx.i_size );
-        }
+        i_length = AVI_GetDPTS( tk, AVI_IndexGetCount( tk ) );
 
         msg_Dbg( p_demux,
                  "stream[%d] length:%"PRId64" (based on index)",
@@ -115,23 +115,16 @@ bool DASHManager::updatePlaylist()
         }
 
         xml::DOMParser parser(mpdstream);
-        if(!parser.parse(true))
-        {
-            vlc_stream_Delete(mpdstream);
-            block_Release(p_block);
-            return false;
-        }
-
-        IsoffMainParser mpdparser(parser.getRootNode(), VLC_OBJECT(p_demux),
-                                  mpdstream, Helper::getDirectoryPath(url).append("/"));
-        MPD *newmpd = mpdparser.parse();
-        if(newmpd)
-        {
-            playlist->updateWith(newmpd);
-            delete newmpd;
-        }
+        IsoffMainParser mpdparser(VLC_OBJECT(p_demux), mpdstream,
+                                  Helper::getDirectoryPath(url).append("/"));
+        MPD *newmpd = mpdparser.parse(parser);
         vlc_stream_Delete(mpdstream);
         block_Release(p_block);
+        if(!newmpd)
+            return false;
+
+        playlist->updateWith(newmpd);
+        delete newmpd;
     }
 
     return true;
@@ -39,26 +39,58 @@ bool IndexReader::parseIndex(block_t *p_block, BaseRepresentation *rep, uint64_t
     if(!rep || !parseBlock(p_block))
         return false;
 
-    MP4_Box_t *sidxbox = MP4_BoxGet(rootbox, "sidx");
-    if (sidxbox)
+    Atom sidxbox;
+    if(!find("sidx", &sidxbox))
+        return true;
+
+    const uint8_t *p = sidxbox.getPayload();
+    size_t i_payload = sidxbox.getPayloadSize();
+
+    /* version/flags reference_ID timescale, then v0 4+4 or v1 8+8, reserved count */
+    if(i_payload < 12)
+        return false;
+    const uint8_t i_version = p[0];
+    const uint32_t i_timescale = GetDWBE(&p[8]);
+    p += 12; i_payload -= 12;
+
+    uint64_t i_first_offset;
+    if(i_version == 0)
+    {
+        if(i_payload < 8)
+            return false;
+        i_first_offset = GetDWBE(&p[4]);
+        p += 8; i_payload -= 8;
+    }
+    else
+    {
+        if(i_payload < 16)
+            return false;
+        i_first_offset = GetQWBE(&p[8]);
+        p += 16; i_payload -= 16;
+    }
+
+    if(i_payload < 4)
+        return false;
+    const uint16_t i_count = GetWBE(&p[2]);
+    p += 4; i_payload -= 4;
+    if(i_payload / 12 < i_count)
+        return false;
+
+    Representation::SplitPoint point;
+    std::vector<Representation::SplitPoint> splitlist;
+    /* sidx refers to offsets from end of sidx pos in the file + first offset */
+    point.offset = i_first_offset + i_fileoffset + sidxbox.offset + sidxbox.size;
+    point.time = 0;
+    for(uint16_t i=0; i<i_count && i_timescale; i++)
     {
-        Representation::SplitPoint point;
-        std::vector<Representation::SplitPoint> splitlist;
-        MP4_Box_data_sidx_t *sidx = sidxbox->data.p_sidx;
-        /* sidx refers to offsets from end of sidx pos in the file + first offset */
-        point.offset = sidx->i_first_offset + i_fileoffset + sidxbox->i_pos + sidxbox->i_size;
-        point.time = 0;
-        for(uint16_t i=0; i<sidx->i_reference_count && sidx->i_timescale; i++)
-        {
-            splitlist.push_back(point);
-            point.offset += sidx->p_items[i].i_referenced_size;
-            point.duration = vlc_tick_from_samples( sidx->p_items[i].i_subsegment_duration,
-                    sidx->i_timescale );
-            point.time += point.duration;
-        }
-        rep->SplitUsingIndex(splitlist);
-        rep->getPlaylist()->debug();
+        splitlist.push_back(point);
+        point.offset += GetDWBE(p) & 0x7fffffff; /* referenced_size */
+        point.duration = vlc_tick_from_samples(GetDWBE(&p[4]), i_timescale);
+        point.time += point.duration;
+        p += 12;
     }
+    rep->SplitUsingIndex(splitlist);
+    rep->getPlaylist()->debug();
 
     return true;
 }
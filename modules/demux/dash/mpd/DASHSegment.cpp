@@ -31,6 +31,8 @@
 #include "../mp4/IndexReader.hpp"
 #include "../../adaptive/playlist/AbstractPlaylist.hpp"
 
+#include <vlc_block.h>
+
 using namespace adaptive::playlist;
 using namespace dash::mpd;
 using namespace dash::mp4;
@@ -38,23 +40,42 @@ using namespace dash::mp4;
 DashIndexChunk::DashIndexChunk(AbstractChunkSource *source, BaseRepresentation *rep)
     : SegmentChunk(source, rep)
 {
-
+    p_index = NULL;
 }
 
 DashIndexChunk::~DashIndexChunk()
 {
-
+    if(p_index)
+        block_ChainRelease(p_index);
 }
 
 void DashIndexChunk::onDownload(block_t **pp_block)
 {
     decrypt(pp_block);
 
-    if(!rep || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 )
+    if(!rep)
+        return;
+
+    /* Index can span multiple reads, or follow the
+     * init data when both were requested at once */
+    if((*pp_block)->i_buffer)
+    {
+        block_t *p_dup = block_Duplicate(*pp_block);
+        if(p_dup)
+            block_ChainAppend(&p_index, p_dup);
+    }
+
+    if(!isEmpty() || !p_index)
         return;
 
-    IndexReader br(rep->getPlaylist()->getVLCObject());
-    br.parseIndex(*pp_block, rep, getStartByteInFile());
+    block_t *p_gathered = block_ChainGather(p_index);
+    p_index = NULL;
+    if(p_gathered)
+    {
+        IndexReader br(rep->getPlaylist()->getVLCObject());
+        br.parseIndex(p_gathered, rep, getStartByteInFile());
+        block_Release(p_gathered);
+    }
 }
 
 DashIndexSegment::DashIndexSegment(ICanonicalUrl *parent) :
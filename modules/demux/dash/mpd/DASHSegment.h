@@ -41,6 +41,9 @@ namespace dash
                 DashIndexChunk(AbstractChunkSource *, BaseRepresentation *);
                 ~DashIndexChunk();
                 virtual void onDownload(block_t **); /* reimpl */
+
+            private:
+                block_t *p_index; /* gathered until complete */
         };
 
         class DashIndexSegment : public IndexSegment
@@ -44,6 +44,7 @@
 #include "../../adaptive/tools/Debug.hpp"
 #include "../../adaptive/tools/Conversions.hpp"
 #include <vlc_stream.h>
+#include <vlc_charset.h>
 #include <cstdio>
 #include <limits>
 
@@ -58,10 +59,29 @@ IsoffMainParser::IsoffMainParser    (Node *root_, vlc_object_t *p_object_,
     p_stream = stream;
     p_object = p_object_;
     playlisturl = streambaseurl_;
+    streamedMPD = NULL;
+    streamedPeriod = NULL;
+    streamedPeriodId = 0;
+    streamedAdaptationSetId = 0;
+}
+
+IsoffMainParser::IsoffMainParser    (vlc_object_t *p_object_,
+                                     stream_t *stream, const std::string & streambaseurl_)
+{
+    root = NULL;
+    p_stream = stream;
+    p_object = p_object_;
+    playlisturl = streambaseurl_;
+    streamedMPD = NULL;
+    streamedPeriod = NULL;
+    streamedPeriodId = 0;
+    streamedAdaptationSetId = 0;
 }
 
 IsoffMainParser::~IsoffMainParser   ()
 {
+    delete streamedPeriod;
+    delete streamedMPD;
 }
 
 void IsoffMainParser::parseMPDBaseUrl(MPD *mpd, Node *root)
@@ -74,7 +94,7 @@ void IsoffMainParser::parseMPDBaseUrl(MPD *mpd, Node *root)
     mpd->setPlaylistUrl( Helper::getDirectoryPath(playlisturl).append("/") );
 }
 
-MPD * IsoffMainParser::parse()
+MPD * IsoffMainParser::createMPD()
 {
     MPD *mpd = new (std::nothrow) MPD(p_object, getProfile());
     if(mpd)
@@ -82,12 +102,69 @@ MPD * IsoffMainParser::parse()
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation"), mpd);
         parseMPDBaseUrl(mpd, root);
+    }
+    return mpd;
+}
+
+MPD * IsoffMainParser::parse()
+{
+    MPD *mpd = createMPD();
+    if(mpd)
+    {
         parsePeriods(mpd, root);
         mpd->debug();
     }
     return mpd;
 }
 
+MPD * IsoffMainParser::parse(DOMParser &parser)
+{
+    if(!parser.parse(true, this))
+        return NULL;
+
+    root = parser.getRootNode();
+    if(!streamedMPD) /* no Period */
+        streamedMPD = createMPD();
+
+    MPD *mpd = streamedMPD;
+    streamedMPD = NULL;
+    if(mpd)
+        mpd->debug();
+    return mpd;
+}
+
+bool IsoffMainParser::onElementEnd(Node *node, const std::vector<Node *> &ancestors)
+{
+    /* MPD schema stores MPD and Period properties before
+     * the Period and AdaptationSet children */
+    if(ancestors.size() == 1 && node->getName() == "Period")
+    {
+        root = ancestors.front();
+        if(!streamedMPD && !(streamedMPD = createMPD()))
+            return false;
+        if(!streamedPeriod)
+            streamedPeriod = createPeriod(node, streamedMPD, &streamedPeriodId);
+        if(streamedPeriod)
+            streamedMPD->addPeriod(streamedPeriod);
+        streamedPeriod = NULL;
+        streamedAdaptationSetId = 0;
+        return true;
+    }
+    else if(ancestors.size() == 2 && node->getName() == "AdaptationSet" &&
+            ancestors.back()->getName() == "Period")
+    {
+        root = ancestors.front();
+        if(!streamedMPD && !(streamedMPD = createMPD()))
+            return false;
+        if(!streamedPeriod &&
+           !(streamedPeriod = createPeriod(ancestors.back(), streamedMPD, &streamedPeriodId)))
+            return false;
+        parseAdaptationSet(node, streamedPeriod, &streamedAdaptationSetId);
+        return true;
+    }
+    return false;
+}
+
 void    IsoffMainParser::parseMPDAttributes   (MPD *mpd, xml::Node *node)
 {
     const std::map<std::string, std::string> & attr = node->getAttributes();
@@ -133,6 +210,22 @@ void    IsoffMainParser::parseMPDAttributes   (MPD *mpd, xml::Node *node)
         mpd->suggestedPresentationDelay.Set(IsoTime(it->second));
 }
 
+Period * IsoffMainParser::createPeriod(Node *periodNode, MPD *mpd, uint64_t *nextid)
+{
+    Period *period = new (std::nothrow) Period(mpd);
+    if (!period)
+        return NULL;
+    parseSegmentInformation(periodNode, period, nextid);
+    if(periodNode->hasAttribute("start"))
+        period->startTime.Set(IsoTime(periodNode->getAttributeValue("start")));
+    if(periodNode->hasAttribute("duration"))
+        period->duration.Set(IsoTime(periodNode->getAttributeValue("duration")));
+    std::vector<Node *> baseUrls = DOMHelper::getChildElementByTagName(periodNode, "BaseURL");
+    if(!baseUrls.empty())
+        period->baseUrl.Set( new Url( baseUrls.front()->getText() ) );
+    return period;
+}
+
 void IsoffMainParser::parsePeriods(MPD *mpd, Node *root)
 {
     std::vector<Node *> periods = DOMHelper::getElementByTagName(root, "Period", false);
@@ -141,18 +234,9 @@ void IsoffMainParser::parsePeriods(MPD *mpd, Node *root)
 
     for(it = periods.begin(); it != periods.end(); ++it)
     {
-        Period *period = new (std::nothrow) Period(mpd);
+        Period *period = createPeriod(*it, mpd, &nextid);
         if (!period)
             continue;
-        parseSegmentInformation(*it, period, &nextid);
-        if((*it)->hasAttribute("start"))
-            period->startTime.Set(IsoTime((*it)->getAttributeValue("start")));
-        if((*it)->hasAttribute("duration"))
-            period->duration.Set(IsoTime((*it)->getAttributeValue("duration")));
-        std::vector<Node *> baseUrls = DOMHelper::getChildElementByTagName(*it, "BaseURL");
-        if(!baseUrls.empty())
-            period->baseUrl.Set( new Url( baseUrls.front()->getText() ) );
-
         parseAdaptationSets(*it, period);
         mpd->addPeriod(period);
     }
@@ -182,6 +266,13 @@ size_t IsoffMainParser::parseSegmentTemplate(Node *templateNode, SegmentInformat
     if(templateNode->hasAttribute("duration"))
         mediaTemplate->duration.Set(Integer<stime_t>(templateNode->getAttributeValue("duration")));
 
+    if(templateNode->hasAttribute("availabilityTimeOffset"))
+    {
+        const std::string offset = templateNode->getAttributeValue("availabilityTimeOffset");
+        if(offset != "INF")
+            mediaTemplate->setAvailabilityTimeOffset(vlc_tick_from_sec(us_strtod(offset.c_str(), NULL)));
+    }
+
     InitSegmentTemplate *initTemplate = NULL;
 
     if(templateNode->hasAttribute("initialization"))
@@ -216,72 +307,75 @@ size_t IsoffMainParser::parseSegmentInformation(Node *node, SegmentInformation *
     return total;
 }
 
-void    IsoffMainParser::parseAdaptationSets  (Node *periodNode, Period *period)
+void    IsoffMainParser::parseAdaptationSet   (Node *node, Period *period, uint64_t *nextid)
 {
-    std::vector<Node *> adaptationSets = DOMHelper::getElementByTagName(periodNode, "AdaptationSet", false);
-    std::vector<Node *>::const_iterator it;
-    uint64_t nextid = 0;
-
-    for(it = adaptationSets.begin(); it != adaptationSets.end(); ++it)
-    {
-        AdaptationSet *adaptationSet = new AdaptationSet(period);
-        if(!adaptationSet)
-            continue;
-        if((*it)->hasAttribute("mimeType"))
-            adaptationSet->setMimeType((*it)->getAttributeValue("mimeType"));
+    AdaptationSet *adaptationSet = new AdaptationSet(period);
+    if(!adaptationSet)
+        return;
+    if(node->hasAttribute("mimeType"))
+        adaptationSet->setMimeType(node->getAttributeValue("mimeType"));
 
-        if((*it)->hasAttribute("lang"))
-            adaptationSet->setLang((*it)->getAttributeValue("lang"));
+    if(node->hasAttribute("lang"))
+        adaptationSet->setLang(node->getAttributeValue("lang"));
 
-        if((*it)->hasAttribute("bitstreamSwitching"))
-            adaptationSet->setBitswitchAble((*it)->getAttributeValue("bitstreamSwitching") == "true");
+    if(node->hasAttribute("bitstreamSwitching"))
+        adaptationSet->setBitswitchAble(node->getAttributeValue("bitstreamSwitching") == "true");
 
-        if((*it)->hasAttribute("segmentAlignment"))
-            adaptationSet->setSegmentAligned((*it)->getAttributeValue("segmentAlignment") == "true");
+    if(node->hasAttribute("segmentAlignment"))
+        adaptationSet->setSegmentAligned(node->getAttributeValue("segmentAlignment") == "true");
 
-        Node *baseUrl = DOMHelper::getFirstChildElementByName((*it), "BaseURL");
-        if(baseUrl)
-            adaptationSet->baseUrl.Set(new Url(baseUrl->getText()));
+    Node *baseUrl = DOMHelper::getFirstChildElementByName(node, "BaseURL");
+    if(baseUrl)
+        adaptationSet->baseUrl.Set(new Url(baseUrl->getText()));
 
-        Node *role = DOMHelper::getFirstChildElementByName((*it), "Role");
-        if(role && role->hasAttribute("schemeIdUri") && role->hasAttribute("value"))
+    Node *role = DOMHelper::getFirstChildElementByName(node, "Role");
+    if(role && role->hasAttribute("schemeIdUri") && role->hasAttribute("value"))
+    {
+        std::string uri = role->getAttributeValue("schemeIdUri");
+        if(uri == "urn:mpeg:dash:role:2011")
         {
-            std::string uri = role->getAttributeValue("schemeIdUri");
-            if(uri == "urn:mpeg:dash:role:2011")
-            {
-                const std::string &rolevalue = role->getAttributeValue("value");
-                adaptationSet->description.Set(rolevalue);
-                if(rolevalue == "main")
-                    adaptationSet->setRole(Role::ROLE_MAIN);
-                else if(rolevalue == "alternate")
-                    adaptationSet->setRole(Role::ROLE_ALTERNATE);
-                else if(rolevalue == "supplementary")
-                    adaptationSet->setRole(Role::ROLE_SUPPLEMENTARY);
-                else if(rolevalue == "commentary")
-                    adaptationSet->setRole(Role::ROLE_COMMENTARY);
-                else if(rolevalue == "dub")
-                    adaptationSet->setRole(Role::ROLE_DUB);
-                else if(rolevalue == "caption")
-                    adaptationSet->setRole(Role::ROLE_CAPTION);
-                else if(rolevalue == "subtitle")
-                    adaptationSet->setRole(Role::ROLE_SUBTITLE);
-            }
+            const std::string &rolevalue = role->getAttributeValue("value");
+            adaptationSet->description.Set(rolevalue);
+            if(rolevalue == "main")
+                adaptationSet->setRole(Role::ROLE_MAIN);
+            else if(rolevalue == "alternate")
+                adaptationSet->setRole(Role::ROLE_ALTERNATE);
+            else if(rolevalue == "supplementary")
+                adaptationSet->setRole(Role::ROLE_SUPPLEMENTARY);
+            else if(rolevalue == "commentary")
+                adaptationSet->setRole(Role::ROLE_COMMENTARY);
+            else if(rolevalue == "dub")
+                adaptationSet->setRole(Role::ROLE_DUB);
+            else if(rolevalue == "caption")
+                adaptationSet->setRole(Role::ROLE_CAPTION);
+            else if(rolevalue == "subtitle")
+                adaptationSet->setRole(Role::ROLE_SUBTITLE);
         }
+    }
 
-        parseSegmentInformation(*it, adaptationSet, &nextid);
+    parseSegmentInformation(node, adaptationSet, nextid);
 
-        parseRepresentations((*it), adaptationSet);
+    parseRepresentations(node, adaptationSet);
 
 #ifdef ADAPTATIVE_ADVANCED_DEBUG
-        if(adaptationSet->description.Get().empty())
-            adaptationSet->description.Set(adaptationSet->getID().str());
+    if(adaptationSet->description.Get().empty())
+        adaptationSet->description.Set(adaptationSet->getID().str());
 #endif
 
-        if(!adaptationSet->getRepresentations().empty())
-            period->addAdaptationSet(adaptationSet);
-        else
-            delete adaptationSet;
-    }
+    if(!adaptationSet->getRepresentations().empty())
+        period->addAdaptationSet(adaptationSet);
+    else
+        delete adaptationSet;
+}
+
+void    IsoffMainParser::parseAdaptationSets  (Node *periodNode, Period *period)
+{
+    std::vector<Node *> adaptationSets = DOMHelper::getElementByTagName(periodNode, "AdaptationSet", false);
+    std::vector<Node *>::const_iterator it;
+    uint64_t nextid = 0;
+
+    for(it = adaptationSets.begin(); it != adaptationSets.end(); ++it)
+        parseAdaptationSet(*it, period, &nextid);
 }
 void    IsoffMainParser::parseRepresentations (Node *adaptationSetNode, AdaptationSet *adaptationSet)
 {
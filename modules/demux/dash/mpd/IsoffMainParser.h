@@ -30,6 +30,7 @@
 #endif
 
 #include "../../adaptive/playlist/SegmentInfoCommon.h"
+#include "../../adaptive/xml/DOMParser.h"
 #include "Profile.hpp"
 
 #include <cstdlib>
@@ -60,18 +61,27 @@ namespace dash
         using namespace adaptive::playlist;
         using namespace adaptive;
 
-        class IsoffMainParser
+        class IsoffMainParser : public xml::DOMParser::ElementHandler
         {
             public:
                 IsoffMainParser             (xml::Node *root, vlc_object_t *p_object,
                                              stream_t *p_stream, const std::string &);
+                IsoffMainParser             (vlc_object_t *p_object,
+                                             stream_t *p_stream, const std::string &);
                 virtual ~IsoffMainParser    ();
                 MPD *   parse();
+                /* streaming mode, builds each Period and AdaptationSet as soon as
+                 * it is read and releases its xml nodes */
+                MPD *   parse(xml::DOMParser &);
+                virtual bool onElementEnd(xml::Node *, const std::vector<xml::Node *> &); /* impl */
 
             private:
                 mpd::Profile getProfile     () const;
+                MPD *   createMPD           ();
+                Period *createPeriod        (xml::Node *periodNode, MPD *, uint64_t *);
                 void    parseMPDBaseUrl     (MPD *, xml::Node *);
                 void    parseMPDAttributes  (MPD *, xml::Node *);
+                void    parseAdaptationSet  (xml::Node *, Period *period, uint64_t *);
                 void    parseAdaptationSets (xml::Node *periodNode, Period *period);
                 void    parseRepresentations(xml::Node *adaptationSetNode, AdaptationSet *adaptationSet);
                 void    parseInitSegment    (xml::Node *, Initializable<Segment> *, SegmentInformation *);
@@ -87,6 +97,12 @@ namespace dash
                 vlc_object_t    *p_object;
                 stream_t        *p_stream;
                 std::string      playlisturl;
+
+                /* streaming state */
+                MPD             *streamedMPD;
+                Period          *streamedPeriod;
+                uint64_t         streamedPeriodId;
+                uint64_t         streamedAdaptationSetId;
         };
     }
 }
@@ -32,10 +32,29 @@ HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
 {
     setSequenceNumber(seq);
     utcTime = 0;
+    b_complete = true;
 }
 
 HLSSegment::~HLSSegment()
 {
+    std::vector<HLSSegment *>::iterator it;
+    for(it = parts.begin(); it != parts.end(); ++it)
+        delete *it;
+}
+
+bool HLSSegment::isComplete() const
+{
+    return b_complete;
+}
+
+ISegment * HLSSegment::getPart(std::size_t index) const
+{
+    return (index < parts.size()) ? parts[index] : NULL;
+}
+
+void HLSSegment::addPart(HLSSegment *part)
+{
+    parts.push_back(part);
 }
 
 bool HLSSegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRepresentation *rep)
@@ -40,9 +40,14 @@ namespace hls
                 virtual ~HLSSegment();
                 vlc_tick_t getUTCTime() const;
                 virtual int compare(ISegment *) const; /* reimpl */
+                virtual bool isComplete() const; /* reimpl */
+                virtual ISegment * getPart(std::size_t) const; /* reimpl */
+                void addPart(HLSSegment *);
 
             protected:
                 vlc_tick_t utcTime;
+                bool b_complete;
+                std::vector<HLSSegment *> parts;
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *); /* reimpl */
         };
@@ -42,6 +42,7 @@
 #include <map>
 #include <cctype>
 #include <algorithm>
+#include <ctime>
 
 using namespace adaptive;
 using namespace adaptive::playlist;
@@ -157,7 +158,30 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUrl().toString());
+    std::string url = rep->getPlaylistUrl().toString();
+    std::list<std::string> directives;
+    if(rep->canBlockReload())
+    {
+        /* Blocking reload, returns as soon as the next part or segment is published */
+        std::ostringstream os;
+        os.imbue(std::locale("C"));
+        os << "_HLS_msn=" << rep->nextMediaSequence;
+        directives.push_back(os.str());
+        if(rep->partTarget)
+        {
+            os.str("");
+            os << "_HLS_part=" << rep->nextPartNumber;
+            directives.push_back(os.str());
+        }
+    }
+    if(rep->canRequestDelta())
+        directives.push_back("_HLS_skip=YES");
+
+    std::list<std::string>::const_iterator dit;
+    for(dit = directives.begin(); dit != directives.end(); ++dit)
+        url.append((url.find('?') == std::string::npos) ? "?" : "&").append(*dit);
+
+    block_t *p_block = Retrieve::HTTP(resources, url);
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -171,11 +195,20 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representati
             releaseTagsList(tagslist);
         }
         block_Release(p_block);
+        rep->lastUpdateTime = time(NULL);
         return true;
     }
     return false;
 }
 
+static void releaseParts(std::vector<HLSSegment *> &parts)
+{
+    std::vector<HLSSegment *>::const_iterator it;
+    for(it = parts.begin(); it != parts.end(); ++it)
+        delete *it;
+    parts.clear();
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -211,22 +244,48 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
-void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::list<Tag *> &tagslist)
+void M3U8Parser::parseSegments(vlc_object_t *p_obj, Representation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
 
+    /* On refresh, segments we already have are not recreated */
+    bool b_known = false;
+    uint64_t lastKnownNumber = 0;
+    if(rep->b_loaded)
+    {
+        std::vector<ISegment *> known;
+        rep->getSegments(SegmentInformation::INFOTYPE_MEDIA, known);
+        /* a segment still in progress needs to be replaced */
+        if(!known.empty() && !known.back()->isComplete())
+            known.pop_back();
+        if(!known.empty())
+        {
+            b_known = true;
+            lastKnownNumber = known.back()->getSequenceNumber();
+        }
+    }
+
     rep->setTimescale(100);
     rep->b_loaded = true;
+    rep->canSkipUntil = 0;
+    rep->b_skip_failed = false;
+    rep->b_block_reload = false;
+    rep->partHoldBack = 0;
 
     vlc_tick_t totalduration = 0;
     vlc_tick_t nzStartTime = 0;
     vlc_tick_t absReferenceTime = VLC_TICK_INVALID;
     uint64_t sequenceNumber = 0;
+    uint64_t firstSequenceNumber = 0;
     bool discontinuity = false;
     std::size_t prevbyterangeoffset = 0;
     const SingleValueTag *ctx_byterange = NULL;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
+    std::vector<HLSSegment *> ctx_parts;
+    std::size_t publishedParts = 0;
+    vlc_tick_t nzPartsDuration = 0;
+    std::size_t prevpartoffset = 0;
 
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
@@ -235,9 +294,109 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         switch(tag->getType())
         {
             /* using static cast as attribute type permits avoiding class check */
+            case AttributesTag::EXTXPART:
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const AttributesTag *parttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *uriAttr = parttag->getAttributeByName("URI");
+                if(!uriAttr)
+                    break;
+
+                const bool b_hint = (tag->getType() == AttributesTag::EXTXPRELOADHINT);
+                if(b_hint)
+                {
+                    const Attribute *typeAttr = parttag->getAttributeByName("TYPE");
+                    if(!typeAttr || typeAttr->value != "PART")
+                        break;
+                }
+
+                vlc_tick_t nzPartDuration = rep->partTarget;
+                const Attribute *durAttr = parttag->getAttributeByName("DURATION");
+                if(durAttr)
+                    nzPartDuration = vlc_tick_from_sec(durAttr->floatingPoint());
+
+                HLSSegment *part = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+                if(!part)
+                    break;
+                part->setSourceUrl(uriAttr->quotedString());
+                part->startTime.Set(rep->getTimescale().ToScaled(nzStartTime + nzPartsDuration));
+                part->duration.Set(rep->getTimescale().ToScaled(nzPartDuration));
+
+                if(b_hint)
+                {
+                    const Attribute *startAttr = parttag->getAttributeByName("BYTERANGE-START");
+                    const Attribute *lengthAttr = parttag->getAttributeByName("BYTERANGE-LENGTH");
+                    if(startAttr || lengthAttr)
+                    {
+                        const std::size_t start = startAttr ? startAttr->decimal() : 0;
+                        part->setByteRange(start, lengthAttr ? start + lengthAttr->decimal() - 1 : 0);
+                    }
+                }
+                else
+                {
+                    const Attribute *byterangeAttr = parttag->getAttributeByName("BYTERANGE");
+                    if(byterangeAttr)
+                    {
+                        std::pair<std::size_t,std::size_t> range = byterangeAttr->unescapeQuotes().getByteRange();
+                        if(range.first == 0)
+                            range.first = prevpartoffset;
+                        prevpartoffset = range.first + range.second;
+                        part->setByteRange(range.first, prevpartoffset - 1);
+                    }
+                    nzPartsDuration += nzPartDuration;
+                    publishedParts++;
+                }
+
+                if(discontinuity && ctx_parts.empty())
+                    part->discontinuity = true;
+
+                if(encryption.method != CommonEncryption::Method::NONE)
+                    part->setEncryption(encryption);
+
+                ctx_parts.push_back(part);
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *targetAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("PART-TARGET");
+                if(targetAttr)
+                    rep->partTarget = vlc_tick_from_sec(targetAttr->floatingPoint());
+            }
+            break;
+
             case SingleValueTag::EXTXMEDIASEQUENCE:
             {
                 sequenceNumber = (static_cast<const SingleValueTag*>(tag))->getValue().decimal();
+                firstSequenceNumber = sequenceNumber;
+            }
+            break;
+
+            case AttributesTag::EXTXSKIP:
+            {
+                /* Delta update: skipped segments are the ones we already have */
+                const Attribute *skipAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("SKIPPED-SEGMENTS");
+                const uint64_t skipped = skipAttr ? skipAttr->decimal() : 0;
+                if(skipped && (!b_known || lastKnownNumber + 1 < sequenceNumber + skipped))
+                {
+                    msg_Warn(p_obj, "Can't apply playlist delta update, missing segments");
+                    rep->b_skip_failed = true;
+                }
+                sequenceNumber += skipped;
+                discontinuity = false;
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const Attribute *skipAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("CAN-SKIP-UNTIL");
+                if(skipAttr)
+                    rep->canSkipUntil = vlc_tick_from_sec(skipAttr->floatingPoint());
+                const Attribute *blockAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_block_reload = (blockAttr && blockAttr->value == "YES");
+                const Attribute *holdbackAttr = static_cast<const AttributesTag *>(tag)->getAttributeByName("PART-HOLD-BACK");
+                if(holdbackAttr)
+                    rep->partHoldBack = vlc_tick_from_sec(holdbackAttr->floatingPoint());
             }
             break;
 
@@ -257,12 +416,6 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     break;
                 }
 
-                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
-                if(!segment)
-                    break;
-
-                segment->setSourceUrl(uritag->getValue().value);
-
                 /* Need to use EXTXTARGETDURATION as default as some can't properly set segment one */
                 double duration = rep->targetDuration;
                 if(ctx_extinf)
@@ -273,6 +426,45 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     ctx_extinf = NULL;
                 }
                 const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
+
+                if(b_known && sequenceNumber <= lastKnownNumber)
+                {
+                    /* Already in our list, only keep the running state */
+                    sequenceNumber++;
+                    nzStartTime += nzDuration;
+                    totalduration += nzDuration;
+                    if(absReferenceTime != VLC_TICK_INVALID)
+                        absReferenceTime += nzDuration;
+                    if(ctx_byterange)
+                    {
+                        std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
+                        if(range.first == 0)
+                            range.first = prevbyterangeoffset;
+                        prevbyterangeoffset = range.first + range.second;
+                        ctx_byterange = NULL;
+                    }
+                    discontinuity = false;
+                    releaseParts(ctx_parts);
+                    nzPartsDuration = 0;
+                    prevpartoffset = 0;
+                    publishedParts = 0;
+                    break;
+                }
+
+                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
+                if(!segment)
+                    break;
+
+                segment->setSourceUrl(uritag->getValue().value);
+
+                std::vector<HLSSegment *>::const_iterator pit;
+                for(pit = ctx_parts.begin(); pit != ctx_parts.end(); ++pit)
+                    segment->addPart(*pit);
+                ctx_parts.clear();
+                nzPartsDuration = 0;
+                prevpartoffset = 0;
+                publishedParts = 0;
+
                 segment->duration.Set(duration * (uint64_t) rep->getTimescale());
                 segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
                 nzStartTime += nzDuration;
@@ -362,6 +554,29 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         }
     }
 
+    /* Remaining parts belong to the segment still being published */
+    if(!ctx_parts.empty())
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+        if(segment)
+        {
+            segment->b_complete = false;
+            segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
+            segment->duration.Set(rep->getTimescale().ToScaled(nzPartsDuration));
+            segment->discontinuity = discontinuity;
+            if(encryption.method != CommonEncryption::Method::NONE)
+                segment->setEncryption(encryption);
+            std::vector<HLSSegment *>::const_iterator pit;
+            for(pit = ctx_parts.begin(); pit != ctx_parts.end(); ++pit)
+                segment->addPart(*pit);
+            ctx_parts.clear();
+            segmentList->addSegment(segment);
+        }
+        else releaseParts(ctx_parts);
+    }
+    rep->nextMediaSequence = sequenceNumber;
+    rep->nextPartNumber = publishedParts;
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -371,7 +586,7 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         rep->getPlaylist()->duration.Set(totalduration);
     }
 
-    rep->updateSegmentList(segmentList, true);
+    rep->updateSegmentList(segmentList, true, firstSequenceNumber);
 }
 M3U8 * M3U8Parser::parse(vlc_object_t *p_object, stream_t *p_stream, const std::string &playlisturl)
 {
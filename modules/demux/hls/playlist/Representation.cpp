@@ -44,6 +44,14 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
     b_loaded = false;
     nextUpdateTime = 0;
     targetDuration = 0;
+    lastUpdateTime = 0;
+    canSkipUntil = 0;
+    b_skip_failed = false;
+    b_block_reload = false;
+    partTarget = 0;
+    partHoldBack = 0;
+    nextMediaSequence = 0;
+    nextPartNumber = 0;
     streamFormat = StreamFormat::UNKNOWN;
 }
 
@@ -125,6 +133,11 @@ void Representation::scheduleNextUpdate(uint64_t number)
 
     nextUpdateTime = now + SEC_FROM_VLC_TICK(minbuffer);
 
+    /* Blocking reloads are held by the server until the next part or
+     * segment is available, so we can reload right away near live edge */
+    if(canBlockReload() && getMinAheadTime(number) <= vlc_tick_from_sec(targetDuration))
+        nextUpdateTime = 0;
+
     msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "s",
             getID().str().c_str(), (int64_t) nextUpdateTime - now);
 
@@ -136,6 +149,45 @@ bool Representation::needsUpdate() const
     return !b_loaded || (isLive() && nextUpdateTime < time(NULL));
 }
 
+bool Representation::canRequestDelta() const
+{
+    /* Delta updates are only valid if our previous load is recent enough,
+     * half of the skip boundary as per the server control advertisement */
+    if(!b_loaded || !isLive() || !canSkipUntil || b_skip_failed)
+        return false;
+    return vlc_tick_from_sec(time(NULL) - lastUpdateTime) < canSkipUntil / 2;
+}
+
+bool Representation::canBlockReload() const
+{
+    return b_loaded && isLive() && b_block_reload;
+}
+
+uint64_t Representation::getLiveStartSegmentNumber(uint64_t def) const
+{
+    if(!partTarget)
+        return BaseRepresentation::getLiveStartSegmentNumber(def);
+
+    /* Low latency, start from the segment containing the parts hold back */
+    std::vector<ISegment *> list;
+    getSegments(INFOTYPE_MEDIA, list);
+    if(list.empty())
+        return def;
+
+    const Timescale timescale = inheritTimescale();
+    const vlc_tick_t holdback = partHoldBack ? partHoldBack : 3 * partTarget;
+    const ISegment *back = list.back();
+    const stime_t start = back->startTime.Get() + back->duration.Get() - timescale.ToScaled(holdback);
+
+    std::vector<ISegment *>::const_reverse_iterator it;
+    for(it = list.rbegin(); it != list.rend(); ++it)
+    {
+        if((*it)->startTime.Get() <= start)
+            return (*it)->getSequenceNumber();
+    }
+    return list.front()->getSequenceNumber();
+}
+
 bool Representation::runLocalUpdates(SharedResources *res)
 {
     const time_t now = time(NULL);
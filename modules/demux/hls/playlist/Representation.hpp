@@ -52,6 +52,9 @@ namespace hls
                 virtual void debug(vlc_object_t *, int) const;  /* reimpl */
                 virtual bool runLocalUpdates(SharedResources *); /* reimpl */
                 virtual uint64_t translateSegmentNumber(uint64_t, const SegmentInformation *) const; /* reimpl */
+                virtual uint64_t getLiveStartSegmentNumber(uint64_t) const; /* reimpl */
+                bool canRequestDelta() const;
+                bool canBlockReload() const;
 
             private:
                 StreamFormat streamFormat;
@@ -59,6 +62,14 @@ namespace hls
                 bool b_loaded;
                 time_t nextUpdateTime;
                 time_t targetDuration;
+                time_t lastUpdateTime;
+                vlc_tick_t canSkipUntil;
+                bool b_skip_failed;
+                bool b_block_reload;
+                vlc_tick_t partTarget;
+                vlc_tick_t partHoldBack;
+                uint64_t nextMediaSequence;
+                std::size_t nextPartNumber;
                 Url playlistUrl;
         };
     }
@@ -320,6 +320,11 @@ Tag * TagFactory::createTagByName(const std::string &name, const std::string &va
         {"EXT-X-MEDIA",                     AttributesTag::EXTXMEDIA},
         {"EXT-X-STREAM-INF",                AttributesTag::EXTXSTREAMINF},
         {"EXT-X-SESSION-KEY",               AttributesTag::EXTXSESSIONKEY},
+        {"EXT-X-SKIP",                      AttributesTag::EXTXSKIP},
+        {"EXT-X-SERVER-CONTROL",            AttributesTag::EXTXSERVERCONTROL},
+        {"EXT-X-PART",                      AttributesTag::EXTXPART},
+        {"EXT-X-PART-INF",                  AttributesTag::EXTXPARTINF},
+        {"EXT-X-PRELOAD-HINT",              AttributesTag::EXTXPRELOADHINT},
         {"EXTINF",                          ValuesListTag::EXTINF},
         {"",                                SingleValueTag::URI},
         {NULL,                              0},
@@ -356,6 +361,11 @@ Tag * TagFactory::createTagByName(const std::string &name, const std::string &va
         case AttributesTag::EXTXMAP:
         case AttributesTag::EXTXMEDIA:
         case AttributesTag::EXTXSTREAMINF:
+        case AttributesTag::EXTXSKIP:
+        case AttributesTag::EXTXSERVERCONTROL:
+        case AttributesTag::EXTXPART:
+        case AttributesTag::EXTXPARTINF:
+        case AttributesTag::EXTXPRELOADHINT:
             return new (std::nothrow) AttributesTag(exttagmapping[i].i, value);
         }
 
@@ -98,6 +98,11 @@ namespace hls
                     EXTXMEDIA,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXSKIP,
+                    EXTXSERVERCONTROL,
+                    EXTXPART,
+                    EXTXPARTINF,
+                    EXTXPRELOADHINT,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
@@ -33,6 +33,7 @@ namespace mkv {
 demux_sys_t::~demux_sys_t()
 {
     size_t i;
+    WaitPrefetch();
     for ( i=0; i<streams.size(); i++ )
         delete streams[i];
     for ( i=0; i<opened_segments.size(); i++ )
@@ -48,7 +49,7 @@ demux_sys_t::~demux_sys_t()
 }
 
 
-bool demux_sys_t::AnalyseAllSegmentsFound( demux_t *p_demux, matroska_stream_c *p_stream1 )
+bool demux_sys_t::AnalyseAllSegmentsFound( demux_t *p_demux, matroska_stream_c *p_stream1, bool b_initial )
 {
     int i_upper_lvl = 0;
     EbmlElement *p_l0;
@@ -106,7 +107,11 @@ bool demux_sys_t::AnalyseAllSegmentsFound( demux_t *p_demux, matroska_stream_c *
         {
             matroska_segment_c *p_segment1 = new matroska_segment_c( *this, p_stream1->estream, (KaxSegment*)p_l0 );
 
-            p_segment1->Preload();
+            /* the other files are only fully parsed if they are used */
+            if ( b_initial )
+                p_segment1->Preload();
+            else
+                p_segment1->PreloadInfo();
 
             if ( !p_segment1->p_segment_uid ||
                  FindSegment( *p_segment1->p_segment_uid ) == NULL)
@@ -268,7 +273,7 @@ bool demux_sys_t::FreeUnused()
 
     auto sgIt = std::remove_if(begin(opened_segments), end(opened_segments),
                 [](const matroska_segment_c* p_sg) {
-        return !p_sg->b_preloaded;
+        return !p_sg->b_preloaded && !p_sg->b_referenced;
     });
     for (auto it = sgIt; it != end(opened_segments); ++it)
         delete *it;
@@ -279,6 +284,10 @@ bool demux_sys_t::FreeUnused()
 
 bool demux_sys_t::PreparePlayback( virtual_segment_c & new_vsegment, vlc_tick_t i_mk_date )
 {
+    WaitPrefetch();
+    if ( new_vsegment.CurrentSegment() != NULL )
+        new_vsegment.CurrentSegment()->Preload();
+
     if ( p_current_vsegment != &new_vsegment )
     {
         if ( p_current_vsegment->CurrentSegment() != NULL )
@@ -315,6 +324,69 @@ void demux_sys_t::JumpTo( virtual_segment_c & vsegment, virtual_chapter_c & vcha
     }
 }
 
+void demux_sys_t::LoadAttachments()
+{
+    matroska_segment_c *p_current = p_current_vsegment ? p_current_vsegment->CurrentSegment() : NULL;
+
+    WaitPrefetch();
+    for (size_t i=0; i<opened_segments.size(); i++)
+    {
+        /* the linked segments may carry fonts used by the main one, don't
+         * move the position of the file being played to find them */
+        if ( p_current == NULL || &opened_segments[i]->es != &p_current->es )
+            opened_segments[i]->Preload();
+        opened_segments[i]->LoadAttachments();
+    }
+}
+
+static void *PrefetchThread( void *data )
+{
+    matroska_segment_c *p_segment = static_cast<matroska_segment_c *>( data );
+
+    p_segment->Preload();
+    return NULL;
+}
+
+/* Preload the linked segment of the next ordered chapter in the background,
+ * shortly before the playback crosses into it */
+void demux_sys_t::PrefetchNextSegment()
+{
+    static const vlc_tick_t i_prefetch_delay = VLC_TICK_FROM_SEC(10);
+
+    if ( p_prefetch_segment != NULL || i_pts == VLC_TICK_INVALID )
+        return;
+
+    virtual_edition_c *p_vedition = p_current_vsegment->CurrentEdition();
+    virtual_chapter_c *p_vchapter = p_current_vsegment->CurrentChapter();
+    if ( p_vedition == NULL || !p_vedition->b_ordered || p_vchapter == NULL ||
+         p_vchapter->i_mk_virtual_stop_time < 0 ||
+         i_pts - VLC_TICK_0 < p_vchapter->i_mk_virtual_stop_time - i_prefetch_delay )
+        return;
+
+    virtual_chapter_c *p_next = p_vedition->getChapterbyTimecode( p_vchapter->i_mk_virtual_stop_time );
+    if ( p_next == NULL || p_next->segment.b_preloaded )
+        return;
+
+    /* the segments of the same file share the file position */
+    if ( &p_next->segment.es == &p_vchapter->segment.es )
+        return;
+
+    msg_Dbg( &demuxer, "prefetching the segment of chapter %s",
+             p_next->p_chapter ? p_next->p_chapter->str_name.c_str() : "" );
+    if ( vlc_clone( &prefetch_thread, PrefetchThread, &p_next->segment,
+                    VLC_THREAD_PRIORITY_LOW ) == 0 )
+        p_prefetch_segment = &p_next->segment;
+}
+
+void demux_sys_t::WaitPrefetch()
+{
+    if ( p_prefetch_segment == NULL )
+        return;
+
+    vlc_join( prefetch_thread, NULL );
+    p_prefetch_segment = NULL;
+}
+
 matroska_segment_c *demux_sys_t::FindSegment( const EbmlBinary & uid ) const
 {
     for (size_t i=0; i<opened_segments.size(); i++)
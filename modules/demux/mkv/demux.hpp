@@ -54,6 +54,7 @@ public:
         ,p_current_vsegment(NULL)
         ,dvd_interpretor( *this )
         ,i_duration(-1)
+        ,p_prefetch_segment(NULL)
         ,ev(&demux)
     {
         vlc_mutex_init( &lock_demuxer );
@@ -89,6 +90,10 @@ public:
     /* duration of the stream */
     vlc_tick_t              i_duration;
 
+    /* linked segment being preloaded before its chapter is reached */
+    matroska_segment_c      *p_prefetch_segment;
+    vlc_thread_t            prefetch_thread;
+
     matroska_segment_c *FindSegment( const EbmlBinary & uid ) const;
     virtual_chapter_c *BrowseCodecPrivate( unsigned int codec_id,
                                         bool (*match)(const chapter_codec_cmds_c &data, const void *p_cookie, size_t i_cookie_size ),
@@ -101,8 +106,11 @@ public:
     bool PreloadLinked();
     bool FreeUnused();
     bool PreparePlayback( virtual_segment_c & new_vsegment, vlc_tick_t i_mk_date );
-    bool AnalyseAllSegmentsFound( demux_t *p_demux, matroska_stream_c * );
+    bool AnalyseAllSegmentsFound( demux_t *p_demux, matroska_stream_c *, bool b_initial );
     void JumpTo( virtual_segment_c & vsegment, virtual_chapter_c & vchapter );
+    void LoadAttachments();
+    void PrefetchNextSegment();
+    void WaitPrefetch();
 
     uint8_t        palette[4][4];
     vlc_mutex_t    lock_demuxer;
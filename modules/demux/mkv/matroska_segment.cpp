@@ -27,6 +27,13 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
+
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+
+#include <errno.h>
 
 #include <new>
 #include <iterator>
@@ -61,12 +68,23 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,sys(demuxer)
     ,ep( EbmlParser(&estream, p_seg, &demuxer.demuxer ))
     ,b_preloaded(false)
+    ,b_referenced(false)
     ,b_ref_external_segments(false)
+    ,b_attachments_loaded(false)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    if( b_preloaded && _seeker._index_modified &&
+        !_seeker._ranges_searched.empty() &&
+        var_InheritBool( &sys.demuxer, "mkv-index-cache" ) )
+    {
+        std::string path = IndexCachePath();
+        if( !path.empty() && !_seeker.save_index( path.c_str() ) )
+            msg_Warn( &sys.demuxer, "could not write index cache %s", path.c_str() );
+    }
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -568,6 +586,32 @@ bool matroska_segment_c::SameFamily( const matroska_segment_c & of_segment ) con
     return false;
 }
 
+/* Only parse the segment information (identity and family), enough to
+ * find the linked segments; the rest is parsed by Preload() when needed */
+bool matroska_segment_c::PreloadInfo( )
+{
+    if ( b_preloaded || i_info_position >= 0 )
+        return true;
+
+    EbmlElement *el = NULL;
+
+    ep.Reset( &sys.demuxer );
+
+    while( ( el = ep.Get() ) != NULL )
+    {
+        if( MKV_IS_ID( el, KaxInfo ) )
+        {
+            msg_Dbg(  &sys.demuxer, "|   + Information" );
+            ParseInfo( static_cast<KaxInfo*>( el ) );
+            i_info_position = el->GetElementPosition();
+            return true;
+        }
+        else if( MKV_IS_ID( el, KaxCluster ) )
+            break;
+    }
+    return false;
+}
+
 bool matroska_segment_c::Preload( )
 {
     if ( b_preloaded )
@@ -653,7 +697,12 @@ bool matroska_segment_c::Preload( )
             msg_Dbg( &sys.demuxer, "|   + Attachments" );
             if( i_attachments_position < 0 )
             {
-                ParseAttachments( ka_ptr );
+                /* defer the (possibly large) data until it's requested */
+                if( !sys.b_seekable )
+                {
+                    ParseAttachments( ka_ptr );
+                    b_attachments_loaded = true;
+                }
                 i_attachments_position = el->GetElementPosition();
             }
         }
@@ -682,6 +731,13 @@ bool matroska_segment_c::Preload( )
 
     ComputeTrackPriority();
 
+    if( sys.b_seekable && var_InheritBool( &sys.demuxer, "mkv-index-cache" ) )
+    {
+        std::string path = IndexCachePath();
+        if( !path.empty() && _seeker.load_index( path.c_str() ) )
+            msg_Dbg( &sys.demuxer, "loaded index cache %s", path.c_str() );
+    }
+
     b_preloaded = true;
 
     if( cluster )
@@ -690,6 +746,56 @@ bool matroska_segment_c::Preload( )
     return true;
 }
 
+/* Cached index location, keyed by the file url, size and segment identity */
+std::string matroska_segment_c::IndexCachePath() const
+{
+    vlc_stream_io_callback *io_callback = dynamic_cast<vlc_stream_io_callback *>( &es.I_O() );
+    if( io_callback == NULL || io_callback->getStream() == NULL )
+        return std::string();
+
+    stream_t *s = io_callback->getStream();
+    uint64_t i_size;
+    if( s->psz_url == NULL || vlc_stream_GetSize( s, &i_size ) != VLC_SUCCESS )
+        return std::string();
+
+    struct md5_s md5;
+    uint8_t buf[8];
+    InitMD5( &md5 );
+    AddMD5( &md5, s->psz_url, strlen( s->psz_url ) );
+    SetQWBE( buf, i_size );
+    AddMD5( &md5, buf, sizeof(buf) );
+    SetQWBE( buf, segment->GetElementPosition() );
+    AddMD5( &md5, buf, sizeof(buf) );
+    if( p_segment_uid )
+        AddMD5( &md5, p_segment_uid->GetBuffer(), p_segment_uid->GetSize() );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    std::string path;
+    if( psz_hash && psz_cachedir )
+    {
+        std::string dir = std::string( psz_cachedir ) + DIR_SEP "mkv-index";
+        if( vlc_mkdir( psz_cachedir, 0700 ) == 0 || errno == EEXIST )
+        {
+            if( vlc_mkdir( dir.c_str(), 0700 ) == 0 || errno == EEXIST )
+                path = dir + DIR_SEP + psz_hash + ".idx";
+        }
+    }
+    free( psz_cachedir );
+    free( psz_hash );
+    return path;
+}
+
+void matroska_segment_c::LoadAttachments()
+{
+    if( b_attachments_loaded || i_attachments_position < 0 )
+        return;
+    LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_attachments_position );
+    /* don't retry on broken files */
+    b_attachments_loaded = true;
+}
+
 /* Here we try to load elements that were found in Seek Heads, but not yet parsed */
 bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int64_t i_element_position )
 {
@@ -756,9 +862,10 @@ bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int
     else if( MKV_CHECKED_PTR_DECL ( ka_ptr, KaxAttachments, el ) )
     {
         msg_Dbg( &sys.demuxer, "|   + Attachments" );
-        if( i_attachments_position < 0 )
+        if( !b_attachments_loaded )
         {
             ParseAttachments( ka_ptr );
+            b_attachments_loaded = true;
             i_attachments_position = i_element_position;
         }
     }
@@ -136,8 +136,12 @@ public:
     demux_sys_t                    & sys;
     EbmlParser                     ep;
     bool                           b_preloaded;
+    /* played by an ordered chapter, only preloaded once it is reached */
+    bool                           b_referenced;
     bool                           b_ref_external_segments;
+    bool                           b_attachments_loaded;
 
+    bool PreloadInfo();
     bool Preload();
     bool PreloadFamily( const matroska_segment_c & segment );
     bool PreloadClusters( uint64 i_cluster_position );
@@ -152,6 +156,9 @@ public:
     bool ESCreate( );
     void ESDestroy( );
 
+    /* attachments are only parsed once requested */
+    void LoadAttachments();
+
     static bool CompareSegmentUIDs( const matroska_segment_c * item_a, const matroska_segment_c * item_b );
 
     bool SameFamily( const matroska_segment_c & of_segment ) const;
@@ -172,6 +179,7 @@ private:
     bool TrackInit( mkv_track_t * p_tk );
     void ComputeTrackPriority();
     void EnsureDuration();
+    std::string IndexCachePath() const;
 
     SegmentSeeker _seeker;
 
@@ -182,7 +182,8 @@ void matroska_segment_c::ParseSeekHead( KaxSeekHead *seekhead )
                 else if( id == EBML_ID(KaxAttachments) )
                 {
                     msg_Dbg( &sys.demuxer, "|   - attachments at %" PRId64, i_pos );
-                    LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_pos );
+                    if( i_attachments_position < 0 )
+                        i_attachments_position = i_pos;
                 }
 #ifdef MKV_DEBUG
                 else if( id != EBML_ID(KaxCluster) && id != EBML_ID(EbmlVoid) &&
@@ -28,6 +28,8 @@
 #include "util.hpp"
 #include "stream_io_callback.hpp"
 
+#include <vlc_fs.h>
+
 #include <sstream>
 #include <limits>
 
@@ -46,6 +48,24 @@ namespace {
 
     template<class It> It prev_( It it ) { return --it; }
     template<class It> It next_( It it ) { return ++it; }
+
+    static const char index_magic[8] = { 'V','L','C','M','K','V','I','1' };
+
+    bool write_u64( FILE * p_file, uint64_t i_value )
+    {
+        uint8_t buf[8];
+        SetQWBE( buf, i_value );
+        return fwrite( buf, sizeof(buf), 1, p_file ) == 1;
+    }
+
+    bool read_u64( FILE * p_file, uint64_t * pi_value )
+    {
+        uint8_t buf[8];
+        if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+            return false;
+        *pi_value = GetQWBE( buf );
+        return true;
+    }
 }
 
 namespace mkv {
@@ -59,6 +79,7 @@ SegmentSeeker::add_cluster_position( fptr_t fpos )
       fpos
     );
 
+    _index_modified = true;
     return _cluster_positions.insert( insertion_point, fpos );
 }
 
@@ -85,6 +106,7 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
     else
     {
         it = _clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) ).first;
+        _index_modified = true;
     }
 
     // ------------------------------------------------------------------
@@ -129,6 +151,7 @@ SegmentSeeker::add_seekpoint( track_id_t track_id, Seekpoint sp )
     {
         seekpoints.insert( it, sp );
     }
+    _index_modified = true;
 }
 
 SegmentSeeker::tracks_seekpoint_t
@@ -419,6 +442,8 @@ SegmentSeeker::mark_range_as_searched( Range data )
 
         _ranges_searched = merged;
     }
+
+    _index_modified = true;
 }
 
 
@@ -450,6 +475,158 @@ SegmentSeeker::get_search_areas( fptr_t start, fptr_t end ) const
     return areas_to_search;
 }
 
+bool
+SegmentSeeker::load_index( const char * psz_path )
+{
+    FILE * p_file = vlc_fopen( psz_path, "rb" );
+    if( p_file == NULL )
+        return false;
+
+    /* read everything aside, so that a truncated file does not leave a
+     * partial index behind */
+    SegmentSeeker loaded;
+    char magic[sizeof(index_magic)];
+    uint64_t i_count, i_track_count;
+    bool b_ok = fread( magic, sizeof(magic), 1, p_file ) == 1 &&
+                !memcmp( magic, index_magic, sizeof(magic) );
+
+    if( b_ok && ( b_ok = read_u64( p_file, &i_count ) ) )
+    {
+        for( uint64_t i = 0; b_ok && i < i_count; i++ )
+        {
+            uint64_t i_start, i_end;
+            b_ok = read_u64( p_file, &i_start ) && read_u64( p_file, &i_end );
+            if( b_ok )
+                loaded._ranges_searched.push_back( Range( i_start, i_end ) );
+        }
+    }
+
+    if( b_ok && ( b_ok = read_u64( p_file, &i_count ) ) )
+    {
+        for( uint64_t i = 0; b_ok && i < i_count; i++ )
+        {
+            uint64_t i_fpos;
+            b_ok = read_u64( p_file, &i_fpos );
+            if( b_ok )
+                loaded._cluster_positions.push_back( i_fpos );
+        }
+    }
+
+    if( b_ok && ( b_ok = read_u64( p_file, &i_count ) ) )
+    {
+        for( uint64_t i = 0; b_ok && i < i_count; i++ )
+        {
+            uint64_t i_fpos, i_pts, i_duration, i_size;
+            b_ok = read_u64( p_file, &i_fpos ) && read_u64( p_file, &i_pts ) &&
+                   read_u64( p_file, &i_duration ) && read_u64( p_file, &i_size );
+            if( b_ok )
+            {
+                Cluster cinfo = { i_fpos, vlc_tick_t( i_pts ), vlc_tick_t( i_duration ), i_size };
+                loaded._clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) );
+            }
+        }
+    }
+
+    if( b_ok && ( b_ok = read_u64( p_file, &i_track_count ) ) )
+    {
+        for( uint64_t i = 0; b_ok && i < i_track_count; i++ )
+        {
+            uint64_t i_track_id;
+            b_ok = read_u64( p_file, &i_track_id ) && read_u64( p_file, &i_count );
+            for( uint64_t j = 0; b_ok && j < i_count; j++ )
+            {
+                uint64_t i_fpos, i_pts, i_trust;
+                b_ok = read_u64( p_file, &i_fpos ) && read_u64( p_file, &i_pts ) &&
+                       read_u64( p_file, &i_trust );
+                if( b_ok )
+                    loaded._tracks_seekpoints[ track_id_t( i_track_id ) ].push_back(
+                        Seekpoint( i_fpos, vlc_tick_t( i_pts ),
+                                   Seekpoint::TrustLevel( int64_t( i_trust ) ) ) );
+            }
+        }
+    }
+
+    fclose( p_file );
+
+    if( !b_ok )
+        return false;
+
+    /* merge with what was already found from the cues */
+
+    for( ranges_t::const_iterator it = loaded._ranges_searched.begin();
+         it != loaded._ranges_searched.end(); ++it )
+        mark_range_as_searched( *it );
+
+    for( cluster_positions_t::const_iterator it = loaded._cluster_positions.begin();
+         it != loaded._cluster_positions.end(); ++it )
+    {
+        if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), *it ) )
+            add_cluster_position( *it );
+    }
+
+    _clusters.insert( loaded._clusters.begin(), loaded._clusters.end() );
+
+    for( tracks_seekpoints_t::const_iterator it = loaded._tracks_seekpoints.begin();
+         it != loaded._tracks_seekpoints.end(); ++it )
+    {
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+            add_seekpoint( it->first, *sp );
+    }
+
+    _index_modified = false;
+    return true;
+}
+
+bool
+SegmentSeeker::save_index( const char * psz_path ) const
+{
+    std::string tmppath = std::string( psz_path ) + ".tmp";
+    FILE * p_file = vlc_fopen( tmppath.c_str(), "wb" );
+    if( p_file == NULL )
+        return false;
+
+    bool b_ok = fwrite( index_magic, sizeof(index_magic), 1, p_file ) == 1;
+
+    b_ok = b_ok && write_u64( p_file, _ranges_searched.size() );
+    for( ranges_t::const_iterator it = _ranges_searched.begin();
+         b_ok && it != _ranges_searched.end(); ++it )
+        b_ok = write_u64( p_file, it->start ) && write_u64( p_file, it->end );
+
+    b_ok = b_ok && write_u64( p_file, _cluster_positions.size() );
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin();
+         b_ok && it != _cluster_positions.end(); ++it )
+        b_ok = write_u64( p_file, *it );
+
+    b_ok = b_ok && write_u64( p_file, _clusters.size() );
+    for( cluster_map_t::const_iterator it = _clusters.begin();
+         b_ok && it != _clusters.end(); ++it )
+        b_ok = write_u64( p_file, it->second.fpos ) &&
+               write_u64( p_file, it->second.pts ) &&
+               write_u64( p_file, it->second.duration ) &&
+               write_u64( p_file, it->second.size );
+
+    b_ok = b_ok && write_u64( p_file, _tracks_seekpoints.size() );
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin();
+         b_ok && it != _tracks_seekpoints.end(); ++it )
+    {
+        b_ok = write_u64( p_file, it->first ) && write_u64( p_file, it->second.size() );
+        for( seekpoints_t::const_iterator sp = it->second.begin();
+             b_ok && sp != it->second.end(); ++sp )
+            b_ok = write_u64( p_file, sp->fpos ) && write_u64( p_file, sp->pts ) &&
+                   write_u64( p_file, int64_t( sp->trust_level ) );
+    }
+
+    if( fclose( p_file ) != 0 )
+        b_ok = false;
+
+    if( !b_ok || vlc_rename( tmppath.c_str(), psz_path ) != 0 )
+    {
+        vlc_unlink( tmppath.c_str() );
+        return false;
+    }
+    return true;
+}
+
 void
 SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
 {
@@ -119,11 +119,18 @@ class SegmentSeeker
         void mark_range_as_searched( Range );
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
+        /* on-disk copy of the discovered index, see mkv-index-cache */
+        bool load_index( const char * psz_path );
+        bool save_index( const char * psz_path ) const;
+
+        SegmentSeeker() : _index_modified( false ) { }
+
     public:
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
         cluster_positions_t _cluster_positions;
         cluster_map_t       _clusters;
+        bool                _index_modified;
 };
 
 } // namespace
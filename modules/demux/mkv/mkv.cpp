@@ -80,6 +80,11 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-index-cache", false,
+            N_("Cache seek index"),
+            N_("Store the seek points and cluster positions found while scanning files "
+               "without (or with sparse) cues, so that later opens seek instantly."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -133,7 +138,7 @@ static int Open( vlc_object_t * p_this )
     }
     p_sys->streams.push_back( p_stream );
 
-    if( !p_sys->AnalyseAllSegmentsFound( p_demux, p_stream ) )
+    if( !p_sys->AnalyseAllSegmentsFound( p_demux, p_stream, true ) )
     {
         msg_Err( p_demux, "cannot find KaxSegment or missing mandatory KaxInfo" );
         goto error;
@@ -217,7 +222,7 @@ static int Open( vlc_object_t * p_this )
                             {
                                 matroska_stream_c *p_stream = new matroska_stream_c( p_file_stream, true );
 
-                                if ( !p_sys->AnalyseAllSegmentsFound( p_demux, p_stream ) )
+                                if ( !p_sys->AnalyseAllSegmentsFound( p_demux, p_stream, false ) )
                                 {
                                     msg_Dbg( p_demux, "the file '%s' will not be used", s_filename.c_str() );
                                     delete p_stream;
@@ -310,6 +315,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             ppp_attach = va_arg( args, input_attachment_t*** );
             pi_int = va_arg( args, int * );
 
+            p_sys->LoadAttachments();
             if( p_sys->stored_attachments.size() <= 0 )
                 return VLC_EGENERIC;
 
@@ -333,6 +339,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         case DEMUX_GET_META:
             p_meta = va_arg( args, vlc_meta_t* );
+            p_sys->LoadAttachments(); /* cover art */
             vlc_meta_Merge( p_meta, p_sys->meta );
             return VLC_SUCCESS;
 
@@ -730,6 +737,8 @@ static int Demux( demux_t *p_demux)
         p_vsegment = p_sys->p_current_vsegment;
     }
 
+    p_sys->PrefetchNextSegment();
+
     matroska_segment_c *p_segment = p_vsegment->CurrentSegment();
     if ( p_segment == NULL )
         return VLC_DEMUXER_EOF;
@@ -912,7 +921,7 @@ bool matroska_stream_c::isUsed() const
 {
     for( size_t j = 0; j < segments.size(); j++ )
     {
-        if( segments[j]->b_preloaded )
+        if( segments[j]->b_preloaded || segments[j]->b_referenced )
             return true;
     }
     return false;
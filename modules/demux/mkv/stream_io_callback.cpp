@@ -23,6 +23,8 @@
 
 #include "stream_io_callback.hpp"
 
+#include <algorithm>
+
 namespace mkv {
 
 /*****************************************************************************
@@ -32,21 +34,82 @@ vlc_stream_io_callback::vlc_stream_io_callback( stream_t *s_, bool b_owner_ )
                        : s( s_), b_owner( b_owner_ )
 {
     mb_eof = false;
+    p_buffer = static_cast<uint8_t *>( malloc( BUFFER_SIZE ) );
+    i_buffer = 0;
+    i_buffer_offset = 0;
+    i_buffer_start = s ? vlc_stream_Tell( s ) : 0;
+    i_reads = 0;
+    i_stream_reads = 0;
+}
+
+vlc_stream_io_callback::~vlc_stream_io_callback()
+{
+    if( s && i_reads )
+        msg_Dbg( s, "%" PRIu64 " element reads done with %" PRIu64 " stream reads",
+                 i_reads, i_stream_reads );
+    free( p_buffer );
+    if( b_owner )
+        vlc_stream_Delete( s );
+}
+
+void vlc_stream_io_callback::dropBuffer( uint64_t i_pos )
+{
+    i_buffer = 0;
+    i_buffer_offset = 0;
+    i_buffer_start = i_pos;
 }
 
-uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
+uint32 vlc_stream_io_callback::read( void *p_buffer_out, size_t i_size )
 {
     if( i_size <= 0 || mb_eof )
         return 0;
 
-    int i_ret = vlc_stream_Read( s, p_buffer, i_size );
-    return i_ret < 0 ? 0 : i_ret;
+    i_reads++;
+
+    uint8_t *p_out = static_cast<uint8_t *>( p_buffer_out );
+    size_t i_done = 0;
+
+    while( i_done < i_size )
+    {
+        if( i_buffer_offset < i_buffer )
+        {
+            size_t i_copy = std::min( i_size - i_done, i_buffer - i_buffer_offset );
+            memcpy( &p_out[i_done], &p_buffer[i_buffer_offset], i_copy );
+            i_buffer_offset += i_copy;
+            i_done += i_copy;
+            continue;
+        }
+
+        /* window consumed, the stream is now at its end */
+        dropBuffer( i_buffer_start + i_buffer );
+
+        ssize_t i_ret;
+        i_stream_reads++;
+        if( p_buffer == NULL || i_size - i_done >= BUFFER_SIZE )
+        {
+            /* large payloads go straight to the caller */
+            i_ret = vlc_stream_Read( s, &p_out[i_done], i_size - i_done );
+            if( i_ret <= 0 )
+                break;
+            i_done += i_ret;
+            i_buffer_start += i_ret;
+        }
+        else
+        {
+            i_ret = vlc_stream_Read( s, p_buffer, BUFFER_SIZE );
+            if( i_ret <= 0 )
+                break;
+            i_buffer = i_ret;
+        }
+    }
+
+    return i_done;
 }
 
 void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
 {
     int64_t i_pos, i_size;
-    int64_t i_current = vlc_stream_Tell( s );
+    int64_t i_current = position();
 
     switch( mode )
     {
@@ -68,7 +131,10 @@ void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
             // if previous setFilePointer() failed we may be back in the available data
             i_size = stream_Size( s );
             if ( i_size != 0 && i_pos < i_size )
+            {
+                dropBuffer( i_pos );
                 mb_eof = vlc_stream_Seek( s, i_pos ) != VLC_SUCCESS;
+            }
         }
         return;
     }
@@ -80,6 +146,16 @@ void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
     }
 
     mb_eof = false;
+
+    /* seeking within the window, including skipping forward over it */
+    if( (uint64_t) i_pos >= i_buffer_start &&
+        (uint64_t) i_pos <= i_buffer_start + i_buffer )
+    {
+        i_buffer_offset = i_pos - i_buffer_start;
+        return;
+    }
+
+    dropBuffer( i_pos );
     if( vlc_stream_Seek( s, i_pos ) )
     {
         mb_eof = true;
@@ -91,7 +167,7 @@ uint64 vlc_stream_io_callback::getFilePointer( void )
 {
     if ( s == NULL )
         return 0;
-    return vlc_stream_Tell( s );
+    return position();
 }
 
 size_t vlc_stream_io_callback::write(const void *, size_t )
@@ -111,7 +187,7 @@ uint64 vlc_stream_io_callback::toRead( void )
     if( i_size <= 0 )
         return UINT64_MAX;
 
-    return static_cast<uint64>( i_size - vlc_stream_Tell( s ) );
+    return static_cast<uint64>( i_size - position() );
 }
 
 } // namespace
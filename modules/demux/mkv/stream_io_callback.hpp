@@ -46,16 +46,28 @@ class vlc_stream_io_callback: public IOCallback
     bool           mb_eof;
     bool           b_owner;
 
+    /* read-ahead window, so that the many small element reads from
+     * libebml do not each end up as a stream read */
+    enum { BUFFER_SIZE = 256 * 1024 };
+    uint8_t        *p_buffer;
+    size_t         i_buffer;        /* valid bytes */
+    size_t         i_buffer_offset; /* read position in the window */
+    uint64_t       i_buffer_start;  /* stream offset of the window */
+
+    /* profiling */
+    uint64_t       i_reads;
+    uint64_t       i_stream_reads;
+
+    uint64_t       position() const { return i_buffer_start + i_buffer_offset; }
+    void           dropBuffer( uint64_t );
+
   public:
     vlc_stream_io_callback( stream_t *, bool owner );
 
-    virtual ~vlc_stream_io_callback()
-    {
-        if( b_owner )
-            vlc_stream_Delete( s );
-    }
+    virtual ~vlc_stream_io_callback();
 
     bool IsEOF() const { return mb_eof; }
+    stream_t * getStream() const { return s; }
 
     virtual uint32   read            ( void *p_buffer, size_t i_size);
     virtual void     setFilePointer  ( int64_t i_offset, seek_mode mode = seek_beginning );
@@ -62,7 +62,11 @@ virtual_chapter_c * virtual_chapter_c::CreateVirtualChapter( chapter_item_c * p_
         return NULL;
     }
 
-    p_segment->Preload();
+    /* linked segments of ordered chapters are only parsed when reached */
+    if( b_ordered )
+        p_segment->b_referenced = true;
+    else
+        p_segment->Preload();
 
     vlc_tick_t start = ( b_ordered )? usertime_offset : p_chap->i_start_time;
     vlc_tick_t tmp = usertime_offset;
@@ -524,6 +528,13 @@ bool virtual_segment_c::Seek( demux_t & demuxer, vlc_tick_t i_mk_date,
 
     if ( p_vchapter != NULL && CurrentEdition() )
     {
+        if( p_current_vchapter == NULL || &p_current_vchapter->segment != &p_vchapter->segment )
+        {
+            /* the segment may have been prefetched, or not parsed yet */
+            p_sys->WaitPrefetch();
+            p_vchapter->segment.Preload();
+        }
+
         vlc_tick_t i_mk_time_offset = p_vchapter->i_mk_virtual_start_time - ( ( p_vchapter->p_chapter )? p_vchapter->p_chapter->i_start_time : 0 );
         if (CurrentEdition()->b_ordered)
             p_sys->i_mk_chapter_time = p_vchapter->i_mk_virtual_start_time - p_vchapter->segment.i_mk_start_time - ( ( p_vchapter->p_chapter )? p_vchapter->p_chapter->i_start_time : 0 ) /* + VLC_TICK_0 */;
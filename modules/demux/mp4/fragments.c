@@ -30,6 +30,7 @@ void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index )
     {
         free( p_index->pi_pos );
         free( p_index->p_times );
+        free( p_index->pb_sync );
         free( p_index );
     }
 }
@@ -42,27 +43,74 @@ mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_n
     if( p_index )
     {
         p_index->p_times = calloc( (size_t)i_num * i_tracks, sizeof(*p_index->p_times) );
+        p_index->pb_sync = calloc( (size_t)i_num * i_tracks, sizeof(*p_index->pb_sync) );
         p_index->pi_pos = calloc( i_num, sizeof(*p_index->pi_pos) );
-        if( !p_index->p_times || !p_index->pi_pos )
+        if( !p_index->p_times || !p_index->pb_sync || !p_index->pi_pos )
         {
             MP4_Fragments_Index_Delete( p_index );
             return NULL;
         }
-        p_index->i_entries = i_num;
+        p_index->i_entries = 0;
+        p_index->i_alloc = i_num;
         p_index->i_last_time = 0;
         p_index->i_tracks = i_tracks;
     }
     return p_index;
 }
 
+bool MP4_Fragments_Index_Add( mp4_fragments_index_t *p_index, uint64_t i_pos )
+{
+    if( p_index->i_entries == p_index->i_alloc )
+    {
+        const size_t i_tracks = p_index->i_tracks;
+        if( p_index->i_alloc > UINT_MAX / 2 ||
+            SIZE_MAX / (p_index->i_alloc * 2) < i_tracks * sizeof(stime_t) )
+            return false;
+        const size_t i_alloc = p_index->i_alloc * 2;
+
+        uint64_t *pi_pos = realloc( p_index->pi_pos, i_alloc * sizeof(*pi_pos) );
+        if( !pi_pos )
+            return false;
+        p_index->pi_pos = pi_pos;
+
+        stime_t *p_times = realloc( p_index->p_times, i_alloc * i_tracks * sizeof(*p_times) );
+        if( !p_times )
+            return false;
+        p_index->p_times = p_times;
+
+        bool *pb_sync = realloc( p_index->pb_sync, i_alloc * i_tracks * sizeof(*pb_sync) );
+        if( !pb_sync )
+            return false;
+        p_index->pb_sync = pb_sync;
+
+        p_index->i_alloc = i_alloc;
+    }
+
+    const size_t i_entry = p_index->i_entries++;
+    p_index->pi_pos[i_entry] = i_pos;
+    for( unsigned i=0; i<p_index->i_tracks; i++ )
+    {
+        p_index->p_times[i_entry * p_index->i_tracks + i] = 0;
+        p_index->pb_sync[i_entry * p_index->i_tracks + i] = false;
+    }
+    return true;
+}
+
 stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
                                               unsigned i_track_index, uint64_t i_moof_pos )
 {
-    for( size_t i=0; i<p_index->i_entries; i++ )
+    /* first entry not before the moof */
+    size_t lo = 0, hi = p_index->i_entries;
+    while( lo < hi )
     {
-        if( p_index->pi_pos[i] >= i_moof_pos )
-            return p_index->p_times[i * p_index->i_tracks + i_track_index];
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_index->pi_pos[mid] < i_moof_pos )
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    if( lo < p_index->i_entries )
+        return p_index->p_times[lo * p_index->i_tracks + i_track_index];
     return 0;
 }
 
@@ -78,18 +126,32 @@ bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index, stime_t *pi_tim
         i_track_index >= p_index->i_tracks )
         return false;
 
-    for( size_t i=1; i<p_index->i_entries; i++ )
+    const size_t i_tracks = p_index->i_tracks;
+
+    /* first entry starting after the time */
+    size_t lo = 1, hi = p_index->i_entries;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_index->p_times[mid * i_tracks + i_track_index] > *pi_time )
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    /* prefer starting from a fragment the track can be decoded from */
+    size_t i_entry = lo - 1;
+    for( size_t i = i_entry + 1; i > 0; i-- )
     {
-        if( p_index->p_times[i * p_index->i_tracks + i_track_index] > *pi_time )
+        if( p_index->pb_sync[(i - 1) * i_tracks + i_track_index] )
         {
-            *pi_time = p_index->p_times[(i - 1) * p_index->i_tracks + i_track_index];
-            *pi_pos = p_index->pi_pos[i - 1];
-            return true;
+            i_entry = i - 1;
+            break;
         }
     }
 
-    *pi_time = p_index->p_times[(size_t)(p_index->i_entries - 1) * p_index->i_tracks];
-    *pi_pos = p_index->pi_pos[p_index->i_entries - 1];
+    *pi_time = p_index->p_times[i_entry * i_tracks + i_track_index];
+    *pi_pos = p_index->pi_pos[i_entry];
     return true;
 }
 
@@ -27,13 +27,17 @@ typedef struct mp4_fragments_index_t
 {
     uint64_t *pi_pos;
     stime_t  *p_times; // movie scaled
+    bool     *pb_sync; // fragment starts with a sync sample, per track
     unsigned i_entries;
+    unsigned i_alloc;
     stime_t i_last_time; // movie scaled
     unsigned i_tracks;
 } mp4_fragments_index_t;
 
 void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index );
 mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_num );
+/* appends an entry, which times and sync flags are then set by the caller */
+bool MP4_Fragments_Index_Add( mp4_fragments_index_t *p_index, uint64_t i_pos );
 
 stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
                                               unsigned i_track_index, uint64_t i_moof_pos );
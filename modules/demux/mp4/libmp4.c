@@ -42,6 +42,9 @@
  * The input method HAS to be seekable
  */
 
+/* stsz tables with more entries are not loaded in lazy mode */
+#define MP4_STSZ_LAZY_COUNT (1 << 16)
+
 /* convert 16.16 fixed point to floating point */
 static double conv_fx( int32_t fx ) {
     double fp = fx;
@@ -2846,11 +2849,22 @@ static void MP4_FreeBox_stsz( MP4_Box_t *p_box )
     free( p_box->data.p_stsz->i_entry_size );
 }
 
+/* Only boxes parsed from the file itself, not from a decompressed
+ * moov, can have their content read again later */
+static bool MP4_BoxIsFromFile( const MP4_Box_t *p_box )
+{
+    while( p_box->p_father )
+        p_box = p_box->p_father;
+    return p_box->i_type == ATOM_root;
+}
+
 static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
 {
     uint32_t count;
 
-    MP4_READBOX_ENTER( MP4_Box_data_stsz_t, MP4_FreeBox_stsz );
+    /* entries are read directly from the stream below */
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_stsz_t,
+                               mp4_box_headersize( p_box ) + 12, MP4_FreeBox_stsz );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stsz );
 
@@ -2860,18 +2874,29 @@ static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
 
     if( p_box->data.p_stsz->i_sample_size == 0 )
     {
-        if( UINT64_C(4) * count > i_read )
+        if( p_box->i_size < header_size + 12 ||
+            UINT64_C(4) * count > p_box->i_size - header_size - 12 )
+            MP4_READBOX_EXIT( 0 );
+
+        if( count >= MP4_STSZ_LAZY_COUNT && MP4_BoxIsFromFile( p_box ) &&
+            var_InheritBool( p_stream, "mp4-lazy-sample-tables" ) )
+        {
+            /* read by windows when demuxing */
+            p_box->data.p_stsz->b_lazy = true;
+            MP4_READBOX_EXIT( 1 );
+        }
+
+        uint32_t *p_entries = vlc_alloc( count, sizeof(uint32_t) );
+        if( unlikely( !p_entries ) )
             MP4_READBOX_EXIT( 0 );
+        p_box->data.p_stsz->i_entry_size = p_entries;
 
-        p_box->data.p_stsz->i_entry_size =
-            vlc_alloc( count, sizeof(uint32_t) );
-        if( unlikely( !p_box->data.p_stsz->i_entry_size ) )
+        if( vlc_stream_Read( p_stream, p_entries, UINT64_C(4) * count ) !=
+            (ssize_t) (UINT64_C(4) * count) )
             MP4_READBOX_EXIT( 0 );
 
         for( uint32_t i = 0; i < count; i++ )
-        {
-            MP4_GET4BYTES( p_box->data.p_stsz->i_entry_size[i] );
-        }
+            p_entries[i] = GetDWBE( &p_entries[i] );
     }
     else
         p_box->data.p_stsz->i_entry_size = NULL;
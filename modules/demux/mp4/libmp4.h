@@ -899,10 +899,14 @@ typedef struct MP4_Box_data_stsz_s
     uint32_t i_sample_size;
     uint32_t i_sample_count;
 
-    uint32_t *i_entry_size; /* array , empty if i_sample_size != 0 */
+    uint32_t *i_entry_size; /* array , empty if i_sample_size != 0 or b_lazy */
+    bool     b_lazy; /* entries left in the file, see MP4_STSZ_ENTRIES_POS */
 
 } MP4_Box_data_stsz_t;
 
+/* file position of the stsz entries */
+#define MP4_STSZ_ENTRIES_POS( p_box ) ( ( p_box )->i_pos + mp4_box_headersize( p_box ) + 12 )
+
 typedef struct MP4_Box_data_stz2_s
 {
     uint8_t  i_version;
@@ -50,6 +50,11 @@ static void Close( vlc_object_t * );
 
 #define CFG_PREFIX "mp4-"
 
+#define MP4_LAZY_TEXT     N_("Read sample tables on demand")
+#define MP4_LAZY_LONGTEXT N_("Don't load large sample size tables at open, but " \
+    "read them from the file while playing. Lowers memory use and open time " \
+    "on long recordings.")
+
 #define MP4_M4A_TEXT     N_("M4A audio only")
 #define MP4_M4A_LONGTEXT N_("Ignore non audio tracks from iTunes audio files")
 
@@ -68,6 +73,7 @@ vlc_module_begin ()
 
     add_category_hint("Hacks", NULL)
     add_bool( CFG_PREFIX"m4a-audioonly", false, MP4_M4A_TEXT, MP4_M4A_LONGTEXT, true )
+    add_bool( CFG_PREFIX"lazy-sample-tables", true, MP4_LAZY_TEXT, MP4_LAZY_LONGTEXT, true )
 
     add_submodule()
         set_category( CAT_INPUT )
@@ -2477,20 +2483,21 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         p_demux_track->i_sample_size = stsz->i_sample_size;
         p_demux_track->p_sample_size = NULL;
     }
+    else if( stsz->b_lazy )
+    {
+        /* 2: each sample can have a different size, read from the file */
+        p_demux_track->i_sample_size = 0;
+        p_demux_track->p_sample_size = NULL;
+        p_demux_track->stsz_window.s = p_demux->s;
+        p_demux_track->stsz_window.i_pos = MP4_STSZ_ENTRIES_POS( p_box );
+    }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 3: each sample can have a different size, use the box table */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
+        p_demux_track->p_sample_size = stsz->i_entry_size;
         if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+            return VLC_EGENERIC;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -3512,8 +3519,7 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
+    free( p_track->stsz_window.p_entries );
 
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
@@ -3627,6 +3633,45 @@ static inline uint32_t MP4_GetFixedSampleSize( const mp4_track_t *p_track,
     return i_size;
 }
 
+/* count of stsz entries read at once when the table isn't loaded */
+#define MP4_STSZ_WINDOW 4096
+
+static uint32_t MP4_TrackGetSampleSize( mp4_track_t *p_track, uint32_t i_sample )
+{
+    if( p_track->p_sample_size )
+        return p_track->p_sample_size[i_sample];
+
+    /* Read the entries from the file, the stream position is restored
+     * by the caller before reading samples data */
+    if( i_sample - p_track->stsz_window.i_first >= p_track->stsz_window.i_count )
+    {
+        if( !p_track->stsz_window.p_entries )
+        {
+            p_track->stsz_window.p_entries = vlc_alloc( MP4_STSZ_WINDOW, sizeof(uint32_t) );
+            if( !p_track->stsz_window.p_entries )
+                return 0;
+        }
+
+        /* aligned, as sizes are usually summed from the chunk start */
+        const uint32_t i_first = i_sample - i_sample % MP4_STSZ_WINDOW;
+        const uint32_t i_count = __MIN( MP4_STSZ_WINDOW, p_track->i_sample_count - i_first );
+        uint32_t *p_entries = p_track->stsz_window.p_entries;
+        p_track->stsz_window.i_first = i_first;
+        p_track->stsz_window.i_count = 0;
+        if( MP4_Seek( p_track->stsz_window.s, p_track->stsz_window.i_pos +
+                                              UINT64_C(4) * i_first ) != VLC_SUCCESS ||
+            vlc_stream_Read( p_track->stsz_window.s, p_entries,
+                             4 * i_count ) != (ssize_t) (4 * i_count) )
+            return 0;
+
+        for( uint32_t i = 0; i < i_count; i++ )
+            p_entries[i] = GetDWBE( &p_entries[i] );
+        p_track->stsz_window.i_count = i_count;
+    }
+
+    return p_track->stsz_window.p_entries[i_sample - p_track->stsz_window.i_first];
+}
+
 static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samples )
 {
     uint32_t i_size = 0;
@@ -3640,7 +3685,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         *pi_nb_samples = 1;
 
         if( p_track->i_sample_size == 0 ) /* all sizes are different */
-            return p_track->p_sample_size[p_track->i_sample];
+            return MP4_TrackGetSampleSize( p_track, p_track->i_sample );
         else
             return p_track->i_sample_size;
     }
@@ -3673,7 +3718,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         if( p_track->i_sample_size == 0 )
         {
             *pi_nb_samples = 1;
-            return p_track->p_sample_size[p_track->i_sample];
+            return MP4_TrackGetSampleSize( p_track, p_track->i_sample );
         }
 
         if( p_soun->i_qt_version == 1 )
@@ -3684,7 +3729,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
                 if ( p_track->i_sample_size )
                     return p_track->i_sample_size;
                 else
-                    return p_track->p_sample_size[p_track->i_sample];
+                    return MP4_TrackGetSampleSize( p_track, p_track->i_sample );
             }
             else if ( p_soun->i_compressionid != 0 || p_soun->i_bytes_per_sample > 1 ) /* compressed */
             {
@@ -3767,7 +3812,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         {
             (*pi_nb_samples)++;
             if ( p_track->i_sample_size == 0 )
-                i_size += p_track->p_sample_size[i];
+                i_size += MP4_TrackGetSampleSize( p_track, i );
             else
                 i_size += MP4_GetFixedSampleSize( p_track, p_soun );
 
@@ -3838,7 +3883,7 @@ static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
         for( i_sample = p_track->chunk[p_track->i_chunk].i_sample_first;
              i_sample < p_track->i_sample; i_sample++ )
         {
-            i_pos += p_track->p_sample_size[i_sample];
+            i_pos += MP4_TrackGetSampleSize( p_track, i_sample );
         }
     }
 
@@ -4135,6 +4180,78 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
     return true;
 }
 
+/* Tells if the track first sample in this traf is a sync sample,
+ * see ISO/IEC 14496-12 8.8.3.1 sample_is_non_sync_sample */
+static bool FragFirstSampleIsSync( MP4_Box_t *p_moov, MP4_Box_t *p_traf )
+{
+    const MP4_Box_t *p_tfhd = MP4_BoxGet( p_traf, "tfhd" );
+    const MP4_Box_t *p_trun = MP4_BoxGet( p_traf, "trun" );
+    if( !p_tfhd || !BOXDATA(p_tfhd) || !p_trun || !BOXDATA(p_trun) )
+        return false;
+
+    const MP4_Box_data_trun_t *p_trundata = BOXDATA(p_trun);
+    uint32_t i_flags;
+    if( p_trundata->i_flags & MP4_TRUN_FIRST_FLAGS )
+        i_flags = p_trundata->i_first_sample_flags;
+    else if( (p_trundata->i_flags & MP4_TRUN_SAMPLE_FLAGS) && p_trundata->i_sample_count )
+        i_flags = p_trundata->p_samples[0].i_flags;
+    else if( BOXDATA(p_tfhd)->i_flags & MP4_TFHD_DFLT_SAMPLE_FLAGS )
+        i_flags = BOXDATA(p_tfhd)->i_default_sample_flags;
+    else
+    {
+        MP4_Box_t *p_trex = MP4_GetTrexByTrackID( p_moov, BOXDATA(p_tfhd)->i_track_ID );
+        if( !p_trex || !BOXDATA(p_trex) )
+            return false;
+        i_flags = BOXDATA(p_trex)->i_default_sample_flags;
+    }
+
+    return !(i_flags & 0x00010000);
+}
+
+/* Adds the moof start times to the fragments index, pi_track_times
+ * carrying the tracks end times over moofs without tfdt */
+static bool FragIndexAddMoof( demux_t *p_demux, MP4_Box_t *p_moof, stime_t *pi_track_times )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    mp4_fragments_index_t *p_index = p_sys->p_fragsindex;
+
+    const bool b_first = ( p_index->i_entries == 0 );
+    if( !MP4_Fragments_Index_Add( p_index, p_moof->i_pos ) )
+        return false;
+    const size_t i_entry = p_index->i_entries - 1;
+
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        MP4_Box_t *p_tfdt = NULL;
+        MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
+        if( p_traf )
+        {
+            p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+            p_index->pb_sync[i_entry * p_sys->i_tracks + i] =
+                    FragFirstSampleIsSync( p_sys->p_moov, p_traf );
+        }
+
+        if( p_tfdt && BOXDATA(p_tfdt) )
+        {
+            pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
+        }
+        else if( b_first ) /* Set first fragment time offset from moov */
+        {
+            stime_t i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
+            pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
+        }
+
+        stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
+        p_index->p_times[i_entry * p_sys->i_tracks + i] = i_movietime;
+
+        stime_t i_duration = 0;
+        if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
+            pi_track_times[i] += i_duration;
+    }
+
+    return true;
+}
+
 static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -4149,63 +4266,43 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 
     if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) )
     {
-        MP4_ReadBoxContainerChildren( p_demux->s, p_vroot, NULL ); /* Get the rest of the file */
         p_sys->b_fragments_probed = true;
 
-        const unsigned i_moof = MP4_BoxCount( p_vroot, "/moof" );
-        if( i_moof )
+        p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, 64 );
+        stime_t *pi_track_times = calloc( p_sys->i_tracks, sizeof(*pi_track_times) );
+        if( !p_sys->p_fragsindex || !pi_track_times )
         {
-            *pb_fragmented = true;
-            p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, i_moof );
-            if( !p_sys->p_fragsindex )
-            {
-                MP4_BoxFree( p_vroot );
-                return VLC_EGENERIC;
-            }
-
-            stime_t *pi_track_times = calloc( p_sys->i_tracks, sizeof(*pi_track_times) );
-            if( !pi_track_times )
-            {
-                MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
-                p_sys->p_fragsindex = NULL;
-                MP4_BoxFree( p_vroot );
-                return VLC_EGENERIC;
-            }
+            free( pi_track_times );
+            MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+            p_sys->p_fragsindex = NULL;
+            MP4_BoxFree( p_vroot );
+            return VLC_EGENERIC;
+        }
 
-            unsigned index = 0;
+        /* Get the rest of the file, one moof at a time, so that memory
+         * does not grow with the fragments count */
+        for( ;; )
+        {
+            const uint64_t i_chunk_pos = vlc_stream_Tell( p_demux->s );
+            MP4_Box_t *p_chunk = MP4_BoxGetNextChunk( p_demux->s );
+            if( !p_chunk )
+                break;
 
-            for( MP4_Box_t *p_moof = p_vroot->p_first; p_moof; p_moof = p_moof->p_next )
+            for( MP4_Box_t *p_moof = p_chunk->p_first; p_moof; p_moof = p_moof->p_next )
             {
-                if( p_moof->i_type != ATOM_moof )
-                    continue;
-
-                for( unsigned i=0; i<p_sys->i_tracks; i++ )
-                {
-                    MP4_Box_t *p_tfdt = NULL;
-                    MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
-                    if( p_traf )
-                        p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
-
-                    if( p_tfdt && BOXDATA(p_tfdt) )
-                    {
-                        pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
-                    }
-                    else if( index == 0 ) /* Set first fragment time offset from moov */
-                    {
-                        stime_t i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
-                        pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
-                    }
-
-                    stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                    p_sys->p_fragsindex->p_times[index * p_sys->i_tracks + i] = i_movietime;
+                if( p_moof->i_type == ATOM_moof &&
+                    !FragIndexAddMoof( p_demux, p_moof, pi_track_times ) )
+                    break;
+            }
 
-                    stime_t i_duration = 0;
-                    if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
-                        pi_track_times[i] += i_duration;
-                }
+            MP4_BoxFree( p_chunk );
+            if( vlc_stream_Tell( p_demux->s ) <= i_chunk_pos )
+                break;
+        }
 
-                p_sys->p_fragsindex->pi_pos[index++] = p_moof->i_pos;
-            }
+        if( p_sys->p_fragsindex->i_entries )
+        {
+            *pb_fragmented = true;
 
             for( unsigned i=0; i<p_sys->i_tracks; i++ )
             {
@@ -4213,12 +4310,17 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
                 if( p_sys->p_fragsindex->i_last_time < i_movietime )
                     p_sys->p_fragsindex->i_last_time = i_movietime;
             }
-
-            free( pi_track_times );
 #ifdef MP4_VERBOSE
             MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
 #endif
         }
+        else
+        {
+            MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+            p_sys->p_fragsindex = NULL;
+        }
+
+        free( pi_track_times );
     }
     else
     {
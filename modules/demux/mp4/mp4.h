@@ -129,8 +129,18 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* stsz table, NULL if not loaded */
+
+    /* window of the sizes read from the file when the stsz table
+     * isn't loaded, see MP4_TrackGetSampleSize */
+    struct
+    {
+        stream_t *s;
+        uint64_t  i_pos;
+        uint32_t *p_entries;
+        uint32_t  i_first;
+        uint32_t  i_count;
+    } stsz_window;
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
@@ -35,6 +35,7 @@
 #include <vlc_codec.h>
 #include <vlc_codecs.h>
 #include <vlc_input.h>
+#include <vlc_vector.h>
 
 #include "../../packetizer/a52.h"
 #include "../../packetizer/dts_header.h"
@@ -88,6 +89,10 @@ static int Control( demux_t *, int, va_list );
 #define BASE_PROBE_SIZE (8000)
 #define WAV_EXTRA_PROBE_SIZE (44000/2*2*2)
 
+/* Mpga seek table: one entry per interval, frame headers read by chunks */
+#define MPGA_INDEX_INTERVAL VLC_TICK_FROM_SEC(1)
+#define MPGA_SCAN_SIZE (1 << 16)
+
 typedef struct
 {
     vlc_fourcc_t i_codec;
@@ -128,6 +133,12 @@ typedef struct
     seekpoint_t *p_seekpoint;
 } chap_entry_t;
 
+typedef struct
+{
+    vlc_tick_t i_time;
+    uint64_t i_pos;
+} frame_entry_t;
+
 typedef struct
 {
     codec_t codec;
@@ -167,6 +178,16 @@ typedef struct
         bool b_lame;
     } xing;
 
+    /* Mpga seek table, built from the frame headers when seeking */
+    struct
+    {
+        struct VLC_VECTOR(frame_entry_t) entries;
+        uint64_t i_pos;     /* next frame to scan */
+        uint64_t i_samples; /* samples before that frame */
+        unsigned i_rate;
+        bool b_done;
+    } frames;
+
     float rgf_replay_gain[AUDIO_REPLAY_GAIN_MAX];
     float rgf_replay_peak[AUDIO_REPLAY_GAIN_MAX];
 
@@ -198,6 +219,7 @@ static int MlpInit( demux_t *p_demux );
 
 static bool Parse( demux_t *p_demux, block_t **pp_output );
 static uint64_t SeekByMlltTable( demux_t *p_demux, vlc_tick_t *pi_time );
+static uint64_t SeekByFrameTable( demux_t *p_demux, vlc_tick_t *pi_time );
 
 static const codec_t p_codecs[] = {
     { VLC_CODEC_MP4A, false, "mp4 audio",  AacProbe,  AacInit },
@@ -240,6 +262,7 @@ static int OpenCommon( demux_t *p_demux,
     p_sys->p_packetized_data = NULL;
     p_sys->chapters.i_current = 0;
     TAB_INIT(p_sys->chapters.i_count, p_sys->chapters.p_entry);
+    vlc_vector_init( &p_sys->frames.entries );
 
     if( vlc_stream_Seek( p_demux->s, p_sys->i_stream_offset ) )
     {
@@ -420,6 +443,7 @@ static void Close( vlc_object_t * p_this )
     TAB_CLEAN( p_sys->chapters.i_count, p_sys->chapters.p_entry );
     if( p_sys->mllt.p_bits )
         free( p_sys->mllt.p_bits );
+    vlc_vector_destroy( &p_sys->frames.entries );
     demux_PacketizerDestroy( p_sys->p_packetizer );
     free( p_sys );
 }
@@ -467,6 +491,15 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             va_list ap;
             int i_ret;
 
+            /* All the frames were counted */
+            if( p_sys->frames.b_done && p_sys->frames.i_rate )
+            {
+                *va_arg( args, vlc_tick_t * ) =
+                    vlc_tick_from_samples( p_sys->frames.i_samples,
+                                           p_sys->frames.i_rate );
+                return VLC_SUCCESS;
+            }
+
             va_copy ( ap, args );
             i_ret = demux_vaControlHelper( p_demux->s, p_sys->i_stream_offset,
                                     -1, p_sys->i_bitrate_avg, 1, i_query, ap );
@@ -500,6 +533,19 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 uint64_t i_pos = SeekByMlltTable( p_demux, &i_time );
                 return MovetoTimePos( p_demux, i_time, i_pos );
             }
+            if( p_sys->codec.i_codec == VLC_CODEC_MPGA )
+            {
+                /* Reading the frame headers is only worth it if the
+                 * stream is local, it is read up to the target */
+                bool b_fastseek = false;
+                vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fastseek );
+                if( b_fastseek )
+                {
+                    vlc_tick_t i_time = va_arg(args, vlc_tick_t);
+                    uint64_t i_pos = SeekByFrameTable( p_demux, &i_time );
+                    return MovetoTimePos( p_demux, i_time, i_pos );
+                }
+            }
             /* FIXME TODO: implement a high precision seek (with mp3 parsing)
              * needed for multi-input */
             break;
@@ -913,6 +959,155 @@ static int MpgaGetFrameSamples( uint32_t h )
     }
 }
 
+/* Size of the frame in bytes, 0 if unknown (free format) */
+static unsigned MpgaGetFrameSize( uint32_t h, unsigned *pi_rate )
+{
+    static const uint16_t ppi_bitrate[2][3][16] =
+    {
+        { /* v1 */
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+            { 0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+            { 0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 0 },
+        },
+        { /* v2 and v2.5 */
+            { 0, 32, 48, 56,  64,  80,  96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+            { 0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+            { 0,  8, 16, 24,  32,  40,  48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+        },
+    };
+    static const uint16_t pi_samplerate[3] = { 44100, 48000, 32000 };
+
+    const int i_layer = 3 - ((h >> 17) & 0x03);
+    const unsigned i_version = (h >> 19) & 0x03; /* 3: v1, 2: v2, 0: v2.5 */
+    const unsigned i_bitrate =
+        ppi_bitrate[MPGA_VERSION(h)][i_layer][(h >> 12) & 0x0F] * 1000;
+    const unsigned i_padding = (h >> 9) & 0x01;
+
+    *pi_rate = pi_samplerate[(h >> 10) & 0x03] >> (i_version == 3 ? 0 : i_version == 2 ? 1 : 2);
+    if( i_bitrate == 0 )
+        return 0;
+    if( i_layer == 0 )
+        return (12 * i_bitrate / *pi_rate + i_padding) * 4;
+    return MpgaGetFrameSamples( h ) / 8 * i_bitrate / *pi_rate + i_padding;
+}
+
+/* Reads the frame headers up to i_time, without decoding. The table is
+ * kept and extended by the next seeks. */
+static void MpgaScanFrames( demux_t *p_demux, vlc_tick_t i_time )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t *p_buf = malloc( MPGA_SCAN_SIZE );
+    if( !p_buf )
+        return;
+
+    uint64_t i_base = p_sys->frames.i_pos; /* position of p_buf[0] */
+    size_t i_buf = 0, i_off = 0, i_skipped = 0;
+
+    if( vlc_stream_Seek( p_demux->s, p_sys->i_stream_offset + i_base ) )
+    {
+        free( p_buf );
+        return;
+    }
+
+    while( !p_sys->frames.b_done &&
+           ( !p_sys->frames.i_rate ||
+             vlc_tick_from_samples( p_sys->frames.i_samples,
+                                    p_sys->frames.i_rate ) <= i_time ) )
+    {
+        if( i_off + 4 > i_buf )
+        {
+            if( i_off > i_buf )
+            {   /* the last frame ends after the buffer */
+                ssize_t i_skip = i_off - i_buf;
+                if( vlc_stream_Read( p_demux->s, NULL, i_skip ) != i_skip )
+                {
+                    p_sys->frames.b_done = true;
+                    break;
+                }
+                i_buf = i_off;
+            }
+            if( i_buf > i_off )
+                memmove( p_buf, &p_buf[i_off], i_buf - i_off );
+            i_base += i_off;
+            i_buf -= i_off;
+            i_off = 0;
+
+            ssize_t i_read = vlc_stream_Read( p_demux->s, &p_buf[i_buf],
+                                              MPGA_SCAN_SIZE - i_buf );
+            if( i_read <= 0 )
+            {
+                p_sys->frames.b_done = true;
+                break;
+            }
+            i_buf += i_read;
+            continue;
+        }
+
+        const uint32_t h = GetDWBE( &p_buf[i_off] );
+        unsigned i_rate = 0;
+        unsigned i_size = MpgaCheckSync( &p_buf[i_off] )
+                        ? MpgaGetFrameSize( h, &i_rate ) : 0;
+        if( i_size == 0 ||
+            ( p_sys->frames.i_rate && i_rate != p_sys->frames.i_rate ) )
+        {   /* lost sync: garbage or tags */
+            if( ++i_skipped > MPGA_SCAN_SIZE )
+                p_sys->frames.b_done = true;
+            i_off++;
+            p_sys->frames.i_pos = i_base + i_off;
+            continue;
+        }
+        i_skipped = 0;
+
+        if( !p_sys->frames.i_rate )
+            p_sys->frames.i_rate = i_rate;
+
+        const vlc_tick_t i_frame_time =
+            vlc_tick_from_samples( p_sys->frames.i_samples, i_rate );
+        const size_t i_count = p_sys->frames.entries.size;
+        if( i_count == 0 || i_frame_time >=
+            p_sys->frames.entries.data[i_count - 1].i_time + MPGA_INDEX_INTERVAL )
+        {
+            frame_entry_t entry = { i_frame_time, i_base + i_off };
+            vlc_vector_push( &p_sys->frames.entries, entry );
+        }
+
+        p_sys->frames.i_samples += MpgaGetFrameSamples( h );
+        i_off += i_size;
+        p_sys->frames.i_pos = i_base + i_off;
+    }
+
+    free( p_buf );
+    if( p_sys->frames.b_done )
+        msg_Dbg( p_demux, "%zu seek points in %"PRIu64" samples",
+                 p_sys->frames.entries.size, p_sys->frames.i_samples );
+}
+
+static uint64_t SeekByFrameTable( demux_t *p_demux, vlc_tick_t *pi_time )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    MpgaScanFrames( p_demux, *pi_time );
+
+    /* last entry at or before the time */
+    size_t i_min = 0, i_max = p_sys->frames.entries.size;
+    while( i_min < i_max )
+    {
+        size_t i_mid = (i_min + i_max) / 2;
+        if( p_sys->frames.entries.data[i_mid].i_time <= *pi_time )
+            i_min = i_mid + 1;
+        else
+            i_max = i_mid;
+    }
+
+    if( i_min == 0 )
+    {
+        *pi_time = 0;
+        return 0;
+    }
+    *pi_time = p_sys->frames.entries.data[i_min - 1].i_time;
+    return p_sys->frames.entries.data[i_min - 1].i_pos;
+}
+
 static int MpgaProbe( demux_t *p_demux, uint64_t *pi_offset )
 {
     const uint16_t rgi_twocc[] = { WAVE_FORMAT_MPEG, WAVE_FORMAT_MPEGLAYER3, WAVE_FORMAT_UNKNOWN };
@@ -34,8 +34,12 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
 
 #include "ts_pid.h"
+#include "ts_sync.h"
 #include "ts_streams.h"
 #include "ts_streams_private.h"
 #include "ts_pes.h"
@@ -61,6 +65,7 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -120,6 +125,16 @@ static void Close ( vlc_object_t * );
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 #define TS_GENERATED_PCR_OFFSET_TEXT "Offset in ms for generated PCR"
 
+#define INDEX_CACHE_TEXT N_("Cache seek index")
+#define INDEX_CACHE_LONGTEXT N_("Store the PCR and random access positions found " \
+    "while playing seekable files, so that later seeks on the same files are " \
+    "done with a single read.")
+
+#define SEND_THREADS_TEXT N_("Sending threads")
+#define SEND_THREADS_LONGTEXT N_("Number of threads sending the programs data " \
+    "to the decoders or stream output, 0 to send from the demuxer thread. " \
+    "Useful when demuxing many programs at once.")
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -157,12 +172,15 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-index-cache", false, INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT, true )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT, true )
     add_bool( "ts-pmtfix-waitdata", true, TS_SKIP_GHOST_PROGRAM_TEXT, NULL, true )
     add_bool( "ts-patfix", true, TS_PATFIX_TEXT, NULL, true )
     add_bool( "ts-pcr-offsetfix", true, TS_OFFSETFIX_TEXT, NULL, true )
     add_integer_with_range( "ts-generated-pcr-offset", 120, 0, 500,
                             TS_GENERATED_PCR_OFFSET_TEXT, NULL, true )
+    add_integer_with_range( "ts-send-threads", 0, 0, 16,
+                            SEND_THREADS_TEXT, SEND_THREADS_LONGTEXT, true )
 
     add_obsolete_bool( "ts-silent" );
 
@@ -195,8 +213,18 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
+static const uint8_t * PeekTSPacket( demux_t *p_demux );
 static block_t* ReadTSPacket( demux_t *p_demux );
+#define TS_READAHEAD_PACKETS 64
+
+/* seek index entries interval and max distance to the seek time */
+#define TS_INDEX_SPACING    VLC_TICK_FROM_MS(400)
+#define TS_INDEX_TOLERANCE  VLC_TICK_FROM_MS(1000)
+static uint64_t TellStream( demux_sys_t *p_sys );
+static int SeekStream( demux_sys_t *p_sys, uint64_t i_pos );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
+static void IndexPacket( demux_t *p_demux, const ts_pid_t *, const block_t *, stime_t );
+static char * IndexCachePath( demux_t *p_demux );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
@@ -214,44 +242,19 @@ static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_o
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s,
-                     &p_peek, i_offset + TS_PACKET_SIZE_MAX ) < i_offset + TS_PACKET_SIZE_MAX )
+    /* First sync byte within a packet, followed by 3 others */
+    ssize_t i_peek = vlc_stream_Peek( p_demux->s, &p_peek,
+                                      i_offset + TS_PACKET_SIZE_MAX + TS_SYNC_DETECT_SPAN );
+    if( i_peek < i_offset + TS_PACKET_SIZE_MAX )
         return -1;
 
-    for( int i_sync = 0; i_sync < TS_PACKET_SIZE_MAX; i_sync++ )
+    unsigned i_size;
+    const uint8_t *p_sync = ts_sync_Detect( &p_peek[i_offset], &p_peek[i_peek], &i_size );
+    if( p_sync )
     {
-        if( p_peek[i_offset + i_sync] != 0x47 )
-            continue;
-
-        /* Check next 3 sync bytes */
-        int i_peek = i_offset + TS_PACKET_SIZE_MAX * 3 + i_sync + 1;
-        if( ( vlc_stream_Peek( p_demux->s, &p_peek, i_peek ) ) < i_peek )
-        {
-            msg_Dbg( p_demux, "cannot peek" );
-            return -1;
-        }
-        if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_188] == 0x47 &&
-            p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_188] == 0x47 &&
-            p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_188] == 0x47 )
-        {
-            return TS_PACKET_SIZE_188;
-        }
-        else if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_192] == 0x47 &&
-                 p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_192] == 0x47 &&
-                 p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_192] == 0x47 )
-        {
-            if( i_sync == 4 )
-            {
-                *pi_header_size = 4; /* BluRay TS packets have 4-byte header */
-            }
-            return TS_PACKET_SIZE_192;
-        }
-        else if( p_peek[i_offset + i_sync + 1 * TS_PACKET_SIZE_204] == 0x47 &&
-                 p_peek[i_offset + i_sync + 2 * TS_PACKET_SIZE_204] == 0x47 &&
-                 p_peek[i_offset + i_sync + 3 * TS_PACKET_SIZE_204] == 0x47 )
-        {
-            return TS_PACKET_SIZE_204;
-        }
+        if( i_size == TS_PACKET_SIZE_192 && p_sync - &p_peek[i_offset] == 4 )
+            *pi_header_size = 4; /* BluRay TS packets have 4-byte header */
+        return i_size;
     }
 
     if( p_demux->obj.force )
@@ -409,6 +412,8 @@ static int Open( vlc_object_t *p_this )
 
     vlc_dictionary_init( &p_sys->attachments, 0 );
 
+    ts_index_Init( &p_sys->seekindex );
+
     p_sys->patfix.i_first_dts = -1;
     p_sys->patfix.i_timesourcepid = 0;
     p_sys->patfix.status = var_CreateGetBool( p_demux, "ts-patfix" ) ? PAT_WAITING : PAT_FIXTRIED;
@@ -530,11 +535,27 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    /* Only worth for random access files */
+    p_sys->b_index = p_sys->b_canfastseek && !p_sys->b_access_control;
+    p_sys->b_index_cache = p_sys->b_index && !p_demux->b_preparsing &&
+                           var_InheritBool( p_demux, "ts-index-cache" );
+    if( p_sys->b_index_cache )
+    {
+        char *psz_path = IndexCachePath( p_demux );
+        if( psz_path && ts_index_Load( &p_sys->seekindex, psz_path ) )
+            msg_Dbg( p_demux, "loaded index cache %s", psz_path );
+        free( psz_path );
+    }
+
     if( !p_sys->b_access_control && var_CreateGetBool( p_demux, "ts-pmtfix-waitdata" ) )
         p_sys->es_creation = DELAY_ES;
     else
         p_sys->es_creation = CREATE_ES;
 
+    int i_send_threads = var_InheritInteger( p_demux, "ts-send-threads" );
+    if( i_send_threads > 0 && !p_demux->b_preparsing )
+        p_sys->p_sender = ts_sender_New( p_this, p_demux->out, i_send_threads );
+
     /* Preparse time */
     if( p_demux->b_preparsing && p_sys->b_canseek )
     {
@@ -560,6 +581,12 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( p_sys->p_sender )
+    {
+        ts_sender_Delete( p_sys->p_sender );
+        p_sys->p_sender = NULL;
+    }
+
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
     vlc_mutex_lock( &p_sys->csa_lock );
@@ -590,6 +617,17 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    if( p_sys->b_index_cache && p_sys->seekindex.b_modified )
+    {
+        char *psz_path = IndexCachePath( p_demux );
+        if( psz_path && !ts_index_Save( &p_sys->seekindex, psz_path ) )
+            msg_Warn( p_demux, "could not write index cache %s", psz_path );
+        free( psz_path );
+    }
+    ts_index_Clean( &p_sys->seekindex );
+
+    if( p_sys->readahead.p_block )
+        block_Release( p_sys->readahead.p_block );
     free( p_sys );
 }
 
@@ -637,7 +675,8 @@ static int Demux( demux_t *p_demux )
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        const uint8_t *p_peek;
+        if( !(p_peek = PeekTSPacket( p_demux )) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -650,6 +689,35 @@ static int Demux( demux_t *p_demux )
             p_sys->b_start_record = false;
         }
 
+        /* Packets for an unselected ES that carry nothing else than payload
+         * don't need to be copied at all, just keep the continuity state */
+        if( !p_sys->b_access_control && p_sys->es_creation != DELAY_ES &&
+            SEEN( GetPID( p_sys, 0 ) ) &&
+            (p_peek[3] & 0x20) == 0 && /* no adaptation field, so no PCR */
+            (p_peek[1] & 0x80) == 0 )
+        {
+            ts_pid_t *p_pid = GetPID( p_sys, ((p_peek[1]&0x1f)<<8)|p_peek[2] );
+            if( p_pid->type == TYPE_STREAM && SEEN(p_pid) &&
+                !(p_pid->i_flags & FLAG_FILTERED) &&
+                !(p_peek[3] & 0xc0) == !SCRAMBLED(*p_pid) )
+            {
+                if( (p_peek[3] & 0x10) && p_sys->b_cc_check )
+                {
+                    p_pid->i_cc = p_peek[3] & 0x0f;
+                    p_pid->i_dup = 0;
+                    memcpy( p_pid->prevpktbytes, &p_peek[1], PREVPKTKEEPBYTES );
+                }
+                p_sys->b_end_preparse = true;
+                p_sys->readahead.i_pos += p_sys->i_packet_size;
+                continue;
+            }
+        }
+
+        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        {
+            return VLC_DEMUXER_EOF;
+        }
+
         /* Early reject truncated packets from hw devices */
         if( unlikely(p_pkt->i_buffer < TS_PACKET_SIZE_188) )
         {
@@ -692,6 +760,9 @@ static int Demux( demux_t *p_demux )
         if( i_pcr >= 0 )
             PCRHandle( p_demux, p_pid, i_pcr );
 
+        if( p_sys->b_index )
+            IndexPacket( p_demux, p_pid, p_pkt, i_pcr );
+
         /* Probe streams to build PAT/PMT after MIN_PAT_INTERVAL in case we don't see any PAT */
         if( !SEEN( GetPID( p_sys, 0 ) ) &&
             (p_pid->probed.i_fourcc == 0 || p_pid->i_pid == p_sys->patfix.i_timesourcepid) &&
@@ -905,6 +976,10 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
     }
 
+    /* queries can change or depend on the es_out state */
+    if( p_sys->p_sender )
+        ts_sender_Drain( p_sys->p_sender );
+
     switch( i_query )
     {
     case DEMUX_CAN_SEEK:
@@ -952,7 +1027,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TellStream( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -999,7 +1074,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            SeekStream( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1451,6 +1526,17 @@ static block_t * ConvertPESBlock( demux_t *p_demux, ts_es_t *p_es,
     return p_block;
 }
 
+static void SendBlock( demux_t *p_demux, const ts_es_t *p_es, es_out_id_t *id,
+                       block_t *p_block )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->p_sender )
+        ts_sender_Send( p_sys->p_sender, p_es->p_program->i_number, id, p_block );
+    else
+        es_out_Send( p_demux->out, id, p_block );
+}
+
 /****************************************************************************
  * fanouts current block to all subdecoders / shared pid es
  ****************************************************************************/
@@ -1489,7 +1575,7 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
                     {
                         block_t *p_dup = block_Duplicate( p_block );
                         if( p_dup )
-                            es_out_Send( p_demux->out, p_extra_es->id, p_dup );
+                            SendBlock( p_demux, p_es_send, p_extra_es->id, p_dup );
                     }
                     p_extra_es = p_extra_es->p_next;
                 }
@@ -1500,14 +1586,14 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
                     {
                         block_t *p_dup = block_Duplicate( p_block );
                         if( p_dup )
-                            es_out_Send( p_demux->out, p_es_send->id, p_dup );
+                            SendBlock( p_demux, p_es_send, p_es_send->id, p_dup );
                     }
                 }
                 else
                 {
                     if( p_es_send->id )
                     {
-                        es_out_Send( p_demux->out, p_es_send->id, p_block );
+                        SendBlock( p_demux, p_es_send, p_es_send->id, p_block );
                         p_block = NULL;
                     }
                 }
@@ -1758,79 +1844,256 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data );
 }
 
-static block_t* ReadTSPacket( demux_t *p_demux )
+static uint64_t TellStream( demux_sys_t *p_sys )
+{
+    return vlc_stream_Tell( p_sys->stream ) -
+           ( p_sys->readahead.i_buffer - p_sys->readahead.i_pos );
+}
+
+static int SeekStream( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    TsDropReadAhead( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+/* Takes the next block of streams providing blocks (chained demuxers) as
+ * read-ahead buffer, instead of copying it.
+ * Returns false if no block could be taken, or if it is smaller than i_min
+ * and needs to be completed by FillReadAhead. */
+static bool TakeReadAhead( demux_t *p_demux, size_t i_min )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->stream->pf_block == NULL ||
+        p_sys->readahead.i_pos < p_sys->readahead.i_buffer )
+        return false;
+
+    block_t *p_block = vlc_stream_ReadBlock( p_sys->stream );
+    if( p_block )
+    {
+        block_t *p_shared = block_Share( p_block );
+        if( !p_shared )
+            block_Release( p_block );
+        p_block = p_shared;
+    }
+    if( !p_block )
+        return false;
+
+    if( p_sys->readahead.p_block )
+        block_Release( p_sys->readahead.p_block );
+    p_sys->readahead.p_block = p_block;
+    p_sys->readahead.p_buffer = p_block->p_buffer;
+    p_sys->readahead.i_size = p_block->i_buffer;
+    p_sys->readahead.i_buffer = p_block->i_buffer;
+    p_sys->readahead.i_pos = 0;
+    p_sys->readahead.i_synced = 0;
+    return p_block->i_buffer >= i_min;
+}
+
+/* Moves the unread data to the start of a new buffer and reads until at
+ * least i_min bytes are available.
+ * The previous buffer is left untouched, as it is still referenced by the
+ * packets returned by ReadTSPacket. */
+static bool FillReadAhead( demux_t *p_demux, size_t i_min )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( TakeReadAhead( p_demux, i_min ) )
+        return true;
+
+    /* When the stream provides blocks, only read what is missing, so that
+     * the remainder of its block can be taken by the next call */
+    const bool b_block = p_sys->stream->pf_block != NULL;
+
+    if( unlikely(p_sys->readahead.p_block == NULL) ||
+        p_sys->readahead.i_pos > 0 || p_sys->readahead.i_size < i_min )
+    {
+        const size_t i_size = b_block ? __MAX( i_min, p_sys->i_packet_size )
+                                      : TS_READAHEAD_PACKETS * p_sys->i_packet_size;
+        block_t *p_block = block_Alloc( i_size );
+        if( p_block )
+        {
+            block_t *p_shared = block_Share( p_block );
+            if( !p_shared )
+                block_Release( p_block );
+            p_block = p_shared;
+        }
+        if( !p_block )
+            return false;
+
+        size_t i_left = p_sys->readahead.i_buffer - p_sys->readahead.i_pos;
+        if( p_sys->readahead.p_block )
+        {
+            memcpy( p_block->p_buffer,
+                    &p_sys->readahead.p_buffer[p_sys->readahead.i_pos], i_left );
+            block_Release( p_sys->readahead.p_block );
+        }
+        p_sys->readahead.p_block = p_block;
+        p_sys->readahead.p_buffer = p_block->p_buffer;
+        p_sys->readahead.i_size = i_size;
+        p_sys->readahead.i_synced = ( p_sys->readahead.i_synced > p_sys->readahead.i_pos )
+                                  ? p_sys->readahead.i_synced - p_sys->readahead.i_pos : 0;
+        p_sys->readahead.i_buffer = i_left;
+        p_sys->readahead.i_pos = 0;
+    }
+
+    if( unlikely(i_min > p_sys->readahead.i_size) )
+        return false;
+
+    while( p_sys->readahead.i_buffer < i_min )
+    {
+        /* don't wait for a full buffer on live streams */
+        const size_t i_toread = b_block ? i_min - p_sys->readahead.i_buffer
+                                        : p_sys->readahead.i_size - p_sys->readahead.i_buffer;
+        ssize_t i_read = vlc_stream_ReadPartial( p_sys->stream,
+                            &p_sys->readahead.p_buffer[p_sys->readahead.i_buffer],
+                            i_toread );
+        if( i_read <= 0 )
+            return false;
+        p_sys->readahead.i_buffer += i_read;
+    }
+
+    return true;
+}
+
+/* Descrambles the packets in the read-ahead buffer range, at once */
+static void DecryptReadAhead( demux_sys_t *p_sys, size_t i_start, size_t i_end )
+{
+    uint8_t *pp_pkts[TS_READAHEAD_PACKETS];
+    int i_pkts = 0;
+
+    for( size_t i_offset = i_start; i_offset < i_end && i_pkts < TS_READAHEAD_PACKETS;
+         i_offset += p_sys->i_packet_size )
+    {
+        uint8_t *p = &p_sys->readahead.p_buffer[i_offset + p_sys->i_packet_header_size];
+        if( p[3]&0x80 )
+            pp_pkts[i_pkts++] = p;
+    }
+
+    if( i_pkts )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        if( p_sys->csa )
+            csa_DecryptPackets( p_sys->csa, pp_pkts, i_pkts, p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+}
+
+/* Checks the sync byte of all complete packets following the current one */
+static void CheckReadAheadSync( demux_sys_t *p_sys )
+{
+    const uint8_t *p_buffer = p_sys->readahead.p_buffer;
+    const size_t i_start = __MAX( p_sys->readahead.i_synced, p_sys->readahead.i_pos );
+    size_t i_offset = i_start;
+
+    for( ; i_offset + p_sys->i_packet_size <= p_sys->readahead.i_buffer;
+           i_offset += p_sys->i_packet_size )
+    {
+        if( p_buffer[i_offset + p_sys->i_packet_header_size] != 0x47 )
+            break;
+    }
+    p_sys->readahead.i_synced = i_offset;
+
+    /* Synchronized packets are descrambled by batches, saving a lot over
+     * per packet descrambling when processing them */
+    if( p_sys->csa )
+        DecryptReadAhead( p_sys, i_start, i_offset );
+}
+
+static bool ResyncReadAhead( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
+    const size_t i_sync = p_sys->i_packet_header_size + p_sys->i_packet_size;
+    size_t i_skipped = 0;
 
-    block_t     *p_pkt;
+    msg_Warn( p_demux, "lost synchro" );
 
-    /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    for( ;; )
+    {
+        /* Two consecutive sync bytes are needed */
+        if( p_sys->readahead.i_buffer - p_sys->readahead.i_pos <= i_sync &&
+            !FillReadAhead( p_demux, i_sync + 1 ) )
+        {
+            msg_Dbg( p_demux, "eof ?" );
+            return false;
+        }
+
+        const uint8_t *p_buffer = p_sys->readahead.p_buffer;
+        const uint8_t *p_end = &p_buffer[p_sys->readahead.i_buffer];
+        const uint8_t *p_sync = ts_sync_Find( &p_buffer[p_sys->readahead.i_pos +
+                                                        p_sys->i_packet_header_size],
+                                              p_end, p_sys->i_packet_size );
+        size_t i_pos = p_sync ? (size_t)(p_sync - p_buffer) - p_sys->i_packet_header_size
+                              : p_sys->readahead.i_buffer - i_sync;
+
+        i_skipped += i_pos - p_sys->readahead.i_pos;
+        p_sys->readahead.i_pos = i_pos;
+
+        if( p_sync )
+            break;
+
+        /* keep the tail, it might contain the beginning of the next packet */
+        if( !FillReadAhead( p_demux, p_sys->readahead.i_buffer - p_sys->readahead.i_pos + 1 ) )
+        {
+            msg_Dbg( p_demux, "eof ?" );
+            return false;
+        }
+    }
+
+    msg_Dbg( p_demux, "skipping %zu bytes of garbage", i_skipped );
+
+    p_sys->readahead.i_synced = p_sys->readahead.i_pos;
+    CheckReadAheadSync( p_sys );
+    return true;
+}
+
+/* Returns the next synchronized packet, after the optional packet header,
+ * without consuming it. Data is read by batches of TS_READAHEAD_PACKETS. */
+static const uint8_t * PeekTSPacket( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->readahead.i_pos + p_sys->i_packet_size > p_sys->readahead.i_buffer &&
+        !FillReadAhead( p_demux, p_sys->i_packet_size ) )
     {
         int64_t size = stream_Size( p_sys->stream );
         if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
             msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TellStream( p_sys ) );
         return NULL;
     }
 
-    if( p_pkt->i_buffer < TS_HEADER_SIZE + p_sys->i_packet_header_size )
+    if( p_sys->readahead.i_pos >= p_sys->readahead.i_synced )
     {
-        block_Release( p_pkt );
-        return NULL;
+        CheckReadAheadSync( p_sys );
+        /* Check sync byte and re-sync if needed */
+        if( p_sys->readahead.i_synced == p_sys->readahead.i_pos &&
+            !ResyncReadAhead( p_demux ) )
+            return NULL;
     }
 
     /* Skip header (BluRay streams).
      * re-sync logic would do this (by adjusting packet start), but this would result in losing first and last ts packets.
      * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
      */
-    p_pkt->p_buffer += p_sys->i_packet_header_size;
-    p_pkt->i_buffer -= p_sys->i_packet_header_size;
+    return &p_sys->readahead.p_buffer[p_sys->readahead.i_pos + p_sys->i_packet_header_size];
+}
 
-    /* Check sync byte and re-sync if needed */
-    if( p_pkt->p_buffer[0] != 0x47 )
-    {
-        msg_Warn( p_demux, "lost synchro" );
-        block_Release( p_pkt );
-        for( ;; )
-        {
-            const uint8_t *p_peek;
-            int i_peek = 0;
-            unsigned i_skip = 0;
+static block_t* ReadTSPacket( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
 
-            i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
-                    p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
-            {
-                msg_Dbg( p_demux, "eof ?" );
-                return NULL;
-            }
+    const uint8_t *p_data = PeekTSPacket( p_demux );
+    if( !p_data )
+        return NULL;
 
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
-            msg_Dbg( p_demux, "skipping %d bytes of garbage", i_skip );
-            if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
-                return NULL;
+    /* The packet shares the read-ahead buffer instead of copying it */
+    const size_t i_size = p_sys->i_packet_size - p_sys->i_packet_header_size;
+    block_t *p_pkt = block_View( p_sys->readahead.p_block,
+                                 p_data - p_sys->readahead.p_buffer, i_size );
+    p_sys->readahead.i_pos += p_sys->i_packet_size;
 
-            if( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                break;
-            }
-        }
-        if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
-        {
-            msg_Dbg( p_demux, "eof ?" );
-            return NULL;
-        }
-    }
     return p_pkt;
 }
 
@@ -1942,13 +2205,23 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return SeekStream( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    /* Already played or cached there */
+    if( p_sys->b_index )
+    {
+        const ts_index_entry_t *p_entry =
+                ts_index_Lookup( &p_sys->seekindex, p_pmt->i_number, i_scaledtime,
+                                 TO_SCALE_NZ(TS_INDEX_TOLERANCE) );
+        if( p_entry && SeekStream( p_sys, p_entry->i_pos ) == VLC_SUCCESS )
+            return VLC_SUCCESS;
+    }
+
+    const uint64_t i_initial_pos = TellStream( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1964,7 +2237,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( SeekStream( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1978,7 +2251,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TellStream( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2035,13 +2308,87 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( SeekStream( p_sys, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
 }
 
+/* Records seek points for the programs using that PCR or that random
+ * access packet */
+static void IndexPacket( demux_t *p_demux, const ts_pid_t *p_pid,
+                         const block_t *p_pkt, stime_t i_pcr )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    const bool b_random_access = ( p_pkt->p_buffer[3] & 0x20 ) && /* adaptation field */
+                                 p_pkt->p_buffer[4] > 0 &&
+                                 ( p_pkt->p_buffer[5] & 0x40 );
+    if( i_pcr < 0 && !b_random_access )
+        return;
+
+    if( GetPID(p_sys, 0)->type != TYPE_PAT )
+        return;
+
+    const uint64_t i_pos = TellStream( p_sys ) - p_sys->i_packet_size;
+    const ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        if( p_pmt->pcr.b_disable || p_pmt->pcr.i_first < 0 )
+            continue;
+
+        stime_t i_time;
+        if( i_pcr >= 0 && p_pmt->i_pid_pcr == p_pid->i_pid )
+            i_time = TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+        else if( b_random_access && SETANDVALID(p_pmt->pcr.i_current) &&
+                 PIDReferencedByProgram( p_pmt, p_pid->i_pid ) )
+            i_time = p_pmt->pcr.i_current;
+        else
+            continue;
+
+        ts_index_Add( &p_sys->seekindex, p_pmt->i_number, i_pos, i_time,
+                      b_random_access, TO_SCALE_NZ(TS_INDEX_SPACING) );
+    }
+}
+
+/* Cached index location, keyed by the file url and size */
+static char * IndexCachePath( demux_t *p_demux )
+{
+    stream_t *s = p_demux->s;
+    uint64_t i_size;
+    if( s->psz_url == NULL || vlc_stream_GetSize( s, &i_size ) != VLC_SUCCESS )
+        return NULL;
+
+    struct md5_s md5;
+    uint8_t buf[8];
+    InitMD5( &md5 );
+    AddMD5( &md5, s->psz_url, strlen( s->psz_url ) );
+    SetQWBE( buf, i_size );
+    AddMD5( &md5, buf, sizeof(buf) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_path = NULL;
+    if( psz_hash && psz_cachedir &&
+       ( vlc_mkdir( psz_cachedir, 0700 ) == 0 || errno == EEXIST ) )
+    {
+        char *psz_dir;
+        if( asprintf( &psz_dir, "%s"DIR_SEP"ts-index", psz_cachedir ) != -1 )
+        {
+            if( ( vlc_mkdir( psz_dir, 0700 ) == 0 || errno == EEXIST ) &&
+                asprintf( &psz_path, "%s"DIR_SEP"%s.idx", psz_dir, psz_hash ) == -1 )
+                psz_path = NULL;
+            free( psz_dir );
+        }
+    }
+    free( psz_cachedir );
+    free( psz_hash );
+    return psz_path;
+}
+
 static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_pcr, bool *pb_found )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2117,7 +2464,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TellStream( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2145,7 +2492,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellStream( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2158,7 +2505,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( SeekStream( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2168,7 +2515,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( SeekStream( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2177,7 +2524,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellStream( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2190,7 +2537,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( SeekStream( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2200,7 +2547,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( SeekStream( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2248,17 +2595,20 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
 
     if ( p_sys->i_pmt_es )
     {
-        es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
+        if( p_sys->p_sender )
+            ts_sender_SetGroupPCR( p_sys->p_sender, p_pmt->i_number, FROM_SCALE(i_pcr) );
+        else
+            es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TellStream( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TellStream( p_sys );
             }
         }
     }
@@ -20,6 +20,9 @@
 #ifndef VLC_TS_H
 #define VLC_TS_H
 
+#include "ts_index.h"
+#include "ts_sender.h"
+
 #ifdef HAVE_ARIBB24
     typedef struct arib_instance_t arib_instance_t;
 #endif
@@ -71,9 +74,25 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* packets read ahead from the stream, see PeekTSPacket */
+    struct
+    {
+        block_t *p_block;  /* shared, packets are views of it */
+        uint8_t *p_buffer;
+        size_t   i_size;
+        size_t   i_buffer; /* read bytes */
+        size_t   i_pos;    /* next packet */
+        size_t   i_synced; /* packets sync byte checked up to there */
+    } readahead;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
+    /* seek points recorded while playing, see ts_index.h */
+    ts_index_t  seekindex;
+    bool        b_index;
+    bool        b_index_cache;
+
     ts_standards_e standard;
 
     struct
@@ -105,6 +124,9 @@ struct demux_sys_t
     bool        b_split_es;
     bool        b_valid_scrambling;
 
+    /* es_out calls threads, NULL when sending from the demux thread */
+    ts_sender_t *p_sender;
+
     bool        b_trust_pcr;
     bool        b_check_pcr_offset;
     unsigned    i_generated_pcr_dpb_offset;
@@ -146,6 +168,15 @@ struct demux_sys_t
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
 
+/* drops packets read ahead from the stream, which needs to be done
+ * when seeking or replacing the stream */
+static inline void TsDropReadAhead( demux_sys_t *p_sys )
+{
+    p_sys->readahead.i_buffer = 0;
+    p_sys->readahead.i_pos = 0;
+    p_sys->readahead.i_synced = 0;
+}
+
 bool ProgramIsSelected( demux_sys_t *, uint16_t i_pgrm );
 
 void UpdatePESFilters( demux_t *p_demux, bool b_all );
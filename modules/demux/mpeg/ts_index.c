@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * ts_index.c: MPEG TS seek index
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+
+#include <stdio.h>
+
+#include "ts_index.h"
+
+static const char index_magic[8] = { 'V', 'L', 'C', 'T', 'S', 'I', '1', '\0' };
+
+void ts_index_Init( ts_index_t *p_index )
+{
+    p_index->p_entries = NULL;
+    p_index->i_count = 0;
+    p_index->i_alloc = 0;
+    p_index->b_modified = false;
+}
+
+void ts_index_Clean( ts_index_t *p_index )
+{
+    free( p_index->p_entries );
+    ts_index_Init( p_index );
+}
+
+/* first entry not before program/position */
+static size_t LowerBound( const ts_index_t *p_index, uint16_t i_program, uint64_t i_pos )
+{
+    size_t lo = 0, hi = p_index->i_count;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const ts_index_entry_t *e = &p_index->p_entries[mid];
+        if( e->i_program < i_program ||
+           (e->i_program == i_program && e->i_pos < i_pos) )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static bool TooClose( const ts_index_entry_t *e, stime_t i_time,
+                      bool b_random_access, stime_t i_spacing )
+{
+    stime_t i_diff = ( e->i_time > i_time ) ? e->i_time - i_time : i_time - e->i_time;
+    return i_diff < i_spacing && ( e->b_random_access || !b_random_access );
+}
+
+bool ts_index_Add( ts_index_t *p_index, uint16_t i_program, uint64_t i_pos,
+                   stime_t i_time, bool b_random_access, stime_t i_spacing )
+{
+    size_t i = LowerBound( p_index, i_program, i_pos );
+    const ts_index_entry_t *p_prev = NULL, *p_next = NULL;
+    if( i > 0 && p_index->p_entries[i - 1].i_program == i_program )
+        p_prev = &p_index->p_entries[i - 1];
+    if( i < p_index->i_count && p_index->p_entries[i].i_program == i_program )
+        p_next = &p_index->p_entries[i];
+
+    if( p_next && p_next->i_pos == i_pos )
+        return false;
+    if( ( p_prev && p_prev->i_time > i_time ) ||
+        ( p_next && p_next->i_time < i_time ) )
+        return false;
+    if( ( p_prev && TooClose( p_prev, i_time, b_random_access, i_spacing ) ) ||
+        ( p_next && TooClose( p_next, i_time, b_random_access, i_spacing ) ) )
+        return false;
+
+    if( p_index->i_count == p_index->i_alloc )
+    {
+        size_t i_alloc = p_index->i_alloc ? p_index->i_alloc * 2 : 256;
+        ts_index_entry_t *p_realloc = realloc( p_index->p_entries,
+                                               i_alloc * sizeof(*p_realloc) );
+        if( !p_realloc )
+            return false;
+        p_index->p_entries = p_realloc;
+        p_index->i_alloc = i_alloc;
+    }
+
+    memmove( &p_index->p_entries[i + 1], &p_index->p_entries[i],
+             (p_index->i_count - i) * sizeof(*p_index->p_entries) );
+    ts_index_entry_t *e = &p_index->p_entries[i];
+    e->i_pos = i_pos;
+    e->i_time = i_time;
+    e->i_program = i_program;
+    e->b_random_access = b_random_access;
+    p_index->i_count++;
+    p_index->b_modified = true;
+    return true;
+}
+
+const ts_index_entry_t * ts_index_Lookup( const ts_index_t *p_index, uint16_t i_program,
+                                          stime_t i_time, stime_t i_tolerance )
+{
+    const size_t i_first = LowerBound( p_index, i_program, 0 );
+
+    /* past the last entry of the program not after i_time */
+    size_t lo = i_first, hi = p_index->i_count;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const ts_index_entry_t *e = &p_index->p_entries[mid];
+        if( e->i_program == i_program && e->i_time <= i_time )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if( lo == i_first )
+        return NULL;
+
+    const ts_index_entry_t *p_entry = &p_index->p_entries[lo - 1];
+    if( i_time - p_entry->i_time > i_tolerance )
+        return NULL; /* not indexed there */
+
+    for( size_t i = lo; i > i_first; i-- )
+    {
+        const ts_index_entry_t *e = &p_index->p_entries[i - 1];
+        if( p_entry->i_time - e->i_time >= i_tolerance )
+            break;
+        if( e->b_random_access )
+            return e;
+    }
+
+    return p_entry;
+}
+
+static bool ReadU64( FILE *p_file, uint64_t *pi_value )
+{
+    uint8_t buf[8];
+    if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+        return false;
+    *pi_value = GetQWBE( buf );
+    return true;
+}
+
+static bool WriteU64( FILE *p_file, uint64_t i_value )
+{
+    uint8_t buf[8];
+    SetQWBE( buf, i_value );
+    return fwrite( buf, sizeof(buf), 1, p_file ) == 1;
+}
+
+bool ts_index_Load( ts_index_t *p_index, const char *psz_path )
+{
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    if( p_file == NULL )
+        return false;
+
+    char magic[sizeof(index_magic)];
+    uint64_t i_count;
+    bool b_ok = fread( magic, sizeof(magic), 1, p_file ) == 1 &&
+                !memcmp( magic, index_magic, sizeof(magic) ) &&
+                ReadU64( p_file, &i_count );
+
+    const bool b_modified = p_index->b_modified;
+    for( uint64_t i = 0; b_ok && i < i_count; i++ )
+    {
+        uint64_t i_program, i_pos, i_time, i_flags;
+        b_ok = ReadU64( p_file, &i_program ) && ReadU64( p_file, &i_pos ) &&
+               ReadU64( p_file, &i_time ) && ReadU64( p_file, &i_flags ) &&
+               i_program <= UINT16_MAX && (int64_t) i_time >= 0;
+        /* inconsistent entries are just ignored */
+        if( b_ok )
+            ts_index_Add( p_index, i_program, i_pos, i_time, i_flags & 1, 0 );
+    }
+    p_index->b_modified = b_modified;
+
+    fclose( p_file );
+    return b_ok;
+}
+
+bool ts_index_Save( const ts_index_t *p_index, const char *psz_path )
+{
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.tmp", psz_path ) == -1 )
+        return false;
+
+    FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+    if( p_file == NULL )
+    {
+        free( psz_tmp );
+        return false;
+    }
+
+    bool b_ok = fwrite( index_magic, sizeof(index_magic), 1, p_file ) == 1 &&
+                WriteU64( p_file, p_index->i_count );
+    for( size_t i = 0; b_ok && i < p_index->i_count; i++ )
+    {
+        const ts_index_entry_t *e = &p_index->p_entries[i];
+        b_ok = WriteU64( p_file, e->i_program ) && WriteU64( p_file, e->i_pos ) &&
+               WriteU64( p_file, e->i_time ) && WriteU64( p_file, e->b_random_access );
+    }
+
+    if( fclose( p_file ) != 0 )
+        b_ok = false;
+
+    if( !b_ok || vlc_rename( psz_tmp, psz_path ) != 0 )
+    {
+        vlc_unlink( psz_tmp );
+        b_ok = false;
+    }
+    free( psz_tmp );
+    return b_ok;
+}
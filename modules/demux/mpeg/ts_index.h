@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * ts_index.h: MPEG TS seek index
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+#include "timestamps.h"
+
+/* Positions of PCR and random access packets, per program, as seen while
+ * playing. Times are program PCR times on the 90kHz scale, past wrap
+ * around. Entries are kept sorted by program then position, and times
+ * only grow with positions inside a program. */
+typedef struct
+{
+    uint64_t i_pos;
+    stime_t  i_time;
+    uint16_t i_program;
+    bool     b_random_access;
+} ts_index_entry_t;
+
+typedef struct
+{
+    ts_index_entry_t *p_entries;
+    size_t i_count;
+    size_t i_alloc;
+    bool   b_modified; /* has entries not loaded from file */
+} ts_index_t;
+
+void ts_index_Init( ts_index_t * );
+void ts_index_Clean( ts_index_t * );
+
+/* Adds an entry unless another one of the same program is closer than
+ * i_spacing, or it would break the times order (discontinuity) */
+bool ts_index_Add( ts_index_t *, uint16_t i_program, uint64_t i_pos,
+                   stime_t i_time, bool b_random_access, stime_t i_spacing );
+
+/* Returns the entry to seek to for reaching i_time, which is the last
+ * entry before it if no further than i_tolerance, or a random access one
+ * preceding that one by less than i_tolerance */
+const ts_index_entry_t * ts_index_Lookup( const ts_index_t *, uint16_t i_program,
+                                          stime_t i_time, stime_t i_tolerance );
+
+bool ts_index_Load( ts_index_t *, const char *psz_path );
+bool ts_index_Save( const ts_index_t *, const char *psz_path );
+
+#endif
@@ -42,8 +42,7 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->pp_all = NULL;
     p_list->i_all = 0;
     p_list->i_all_alloc = 0;
-    p_list->i_last_pid = 0;
-    p_list->p_last = NULL;
+    memset( p_list->pp_table, 0, sizeof(p_list->pp_table) );
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -89,8 +88,8 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
         case 0x1FFF:
             return &p_list->dummy;
         default:
-            if( p_list->i_last_pid == i_pid )
-                return p_list->p_last;
+            if( likely(i_pid < TS_PID_COUNT) && p_list->pp_table[i_pid] )
+                return p_list->pp_table[i_pid];
         break;
     }
 
@@ -152,8 +151,8 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
 
     }
 
-    p_list->p_last = p_pid;
-    p_list->i_last_pid = i_pid;
+    if( likely(i_pid < TS_PID_COUNT) )
+        p_list->pp_table[i_pid] = p_pid;
 
     return p_pid;
 }
@@ -0,0 +1,202 @@
+/*****************************************************************************
+ * ts_sender.c: MPEG TS per program es_out sending threads
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_es_out.h>
+#include <vlc_block.h>
+
+#include "ts_sender.h"
+
+/* max queued commands per thread before the demux thread waits */
+#define TS_SENDER_MAX_QUEUED 2000
+
+typedef struct ts_sender_cmd_t ts_sender_cmd_t;
+struct ts_sender_cmd_t
+{
+    ts_sender_cmd_t *p_next;
+    int              i_program;
+    es_out_id_t     *id;    /* NULL for PCR */
+    block_t         *p_block;
+    vlc_tick_t       i_pcr;
+};
+
+typedef struct
+{
+    ts_sender_t     *p_sender;
+    vlc_thread_t     thread;
+    vlc_mutex_t      lock;
+    vlc_cond_t       wait;  /* new command or exit */
+    vlc_cond_t       done;  /* command processed */
+    ts_sender_cmd_t *p_first;
+    ts_sender_cmd_t **pp_last;
+    unsigned         i_queued; /* including the one in progress */
+    bool             b_exit;
+} ts_sender_thread_t;
+
+struct ts_sender_t
+{
+    vlc_object_t       *p_obj;
+    es_out_t           *out;
+    unsigned            i_threads;
+    ts_sender_thread_t  threads[];
+};
+
+static void *Run( void *p_data )
+{
+    ts_sender_thread_t *p_thread = p_data;
+    es_out_t *out = p_thread->p_sender->out;
+
+    vlc_mutex_lock( &p_thread->lock );
+    for( ;; )
+    {
+        while( !p_thread->p_first && !p_thread->b_exit )
+            vlc_cond_wait( &p_thread->wait, &p_thread->lock );
+
+        ts_sender_cmd_t *p_cmd = p_thread->p_first;
+        if( !p_cmd )
+            break;
+        p_thread->p_first = p_cmd->p_next;
+        if( !p_thread->p_first )
+            p_thread->pp_last = &p_thread->p_first;
+        vlc_mutex_unlock( &p_thread->lock );
+
+        if( p_cmd->id )
+            es_out_Send( out, p_cmd->id, p_cmd->p_block );
+        else
+            es_out_Control( out, ES_OUT_SET_GROUP_PCR, p_cmd->i_program, p_cmd->i_pcr );
+        free( p_cmd );
+
+        vlc_mutex_lock( &p_thread->lock );
+        p_thread->i_queued--;
+        vlc_cond_broadcast( &p_thread->done );
+    }
+    vlc_mutex_unlock( &p_thread->lock );
+
+    return NULL;
+}
+
+ts_sender_t * ts_sender_New( vlc_object_t *p_obj, es_out_t *out, unsigned i_threads )
+{
+    ts_sender_t *p_sender = malloc( sizeof(*p_sender) +
+                                    i_threads * sizeof(ts_sender_thread_t) );
+    if( !p_sender )
+        return NULL;
+    p_sender->p_obj = p_obj;
+    p_sender->out = out;
+    p_sender->i_threads = 0;
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        ts_sender_thread_t *p_thread = &p_sender->threads[i];
+        p_thread->p_sender = p_sender;
+        vlc_mutex_init( &p_thread->lock );
+        vlc_cond_init( &p_thread->wait );
+        vlc_cond_init( &p_thread->done );
+        p_thread->p_first = NULL;
+        p_thread->pp_last = &p_thread->p_first;
+        p_thread->i_queued = 0;
+        p_thread->b_exit = false;
+
+        if( vlc_clone( &p_thread->thread, Run, p_thread, VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+        p_sender->i_threads++;
+    }
+
+    if( p_sender->i_threads == 0 )
+    {
+        free( p_sender );
+        return NULL;
+    }
+
+    msg_Dbg( p_obj, "sending programs data from %u threads", p_sender->i_threads );
+    return p_sender;
+}
+
+void ts_sender_Delete( ts_sender_t *p_sender )
+{
+    for( unsigned i = 0; i < p_sender->i_threads; i++ )
+    {
+        ts_sender_thread_t *p_thread = &p_sender->threads[i];
+        vlc_mutex_lock( &p_thread->lock );
+        p_thread->b_exit = true;
+        vlc_cond_signal( &p_thread->wait );
+        vlc_mutex_unlock( &p_thread->lock );
+        /* queued commands are still processed */
+        vlc_join( p_thread->thread, NULL );
+    }
+    free( p_sender );
+}
+
+static void Queue( ts_sender_t *p_sender, ts_sender_cmd_t *p_cmd )
+{
+    ts_sender_thread_t *p_thread =
+            &p_sender->threads[(unsigned) p_cmd->i_program % p_sender->i_threads];
+
+    p_cmd->p_next = NULL;
+    vlc_mutex_lock( &p_thread->lock );
+    while( p_thread->i_queued >= TS_SENDER_MAX_QUEUED )
+        vlc_cond_wait( &p_thread->done, &p_thread->lock );
+    *p_thread->pp_last = p_cmd;
+    p_thread->pp_last = &p_cmd->p_next;
+    p_thread->i_queued++;
+    vlc_cond_signal( &p_thread->wait );
+    vlc_mutex_unlock( &p_thread->lock );
+}
+
+void ts_sender_Send( ts_sender_t *p_sender, int i_program, es_out_id_t *id, block_t *p_block )
+{
+    ts_sender_cmd_t *p_cmd = malloc( sizeof(*p_cmd) );
+    if( unlikely(!p_cmd) )
+    {
+        block_Release( p_block );
+        return;
+    }
+    p_cmd->i_program = i_program;
+    p_cmd->id = id;
+    p_cmd->p_block = p_block;
+    Queue( p_sender, p_cmd );
+}
+
+void ts_sender_SetGroupPCR( ts_sender_t *p_sender, int i_program, vlc_tick_t i_pcr )
+{
+    ts_sender_cmd_t *p_cmd = malloc( sizeof(*p_cmd) );
+    if( unlikely(!p_cmd) )
+        return;
+    p_cmd->i_program = i_program;
+    p_cmd->id = NULL;
+    p_cmd->p_block = NULL;
+    p_cmd->i_pcr = i_pcr;
+    Queue( p_sender, p_cmd );
+}
+
+void ts_sender_Drain( ts_sender_t *p_sender )
+{
+    for( unsigned i = 0; i < p_sender->i_threads; i++ )
+    {
+        ts_sender_thread_t *p_thread = &p_sender->threads[i];
+        vlc_mutex_lock( &p_thread->lock );
+        while( p_thread->i_queued > 0 )
+            vlc_cond_wait( &p_thread->done, &p_thread->lock );
+        vlc_mutex_unlock( &p_thread->lock );
+    }
+}
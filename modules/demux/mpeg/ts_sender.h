@@ -0,0 +1,38 @@
+/*****************************************************************************
+ * ts_sender.h: MPEG TS per program es_out sending threads
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_SENDER_H
+#define VLC_TS_SENDER_H
+
+/* Queues the data and PCR of each program to one of a few threads, which
+ * do the es_out calls. Programs are spread over threads by number, so
+ * ordering is kept inside each program. Any es_out change on the demux
+ * thread (ES removal, seek, ...) must be preceded by ts_sender_Drain. */
+typedef struct ts_sender_t ts_sender_t;
+
+ts_sender_t * ts_sender_New( vlc_object_t *, es_out_t *, unsigned i_threads );
+void ts_sender_Delete( ts_sender_t * );
+
+void ts_sender_Send( ts_sender_t *, int i_program, es_out_id_t *, block_t * );
+void ts_sender_SetGroupPCR( ts_sender_t *, int i_program, vlc_tick_t );
+
+/* waits for all queued data to be sent */
+void ts_sender_Drain( ts_sender_t * );
+
+#endif
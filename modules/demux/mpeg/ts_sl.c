@@ -178,6 +178,8 @@ void SLPackets_Section_Handler( demux_t *p_demux,
 
                     if( p_es->id )
                     {
+                        if( p_sys->p_sender )
+                            ts_sender_Drain( p_sys->p_sender );
                         es_out_Del( p_demux->out, p_es->id );
                         p_sys->i_pmt_es--;
                     }
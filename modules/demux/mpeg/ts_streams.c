@@ -194,6 +194,8 @@ static void ts_pes_es_Clean( demux_t *p_demux, ts_es_t *p_es )
     if( p_es->id )
     {
         /* Ensure we don't wait for overlap hacks #14257 */
+        if( p_sys->p_sender )
+            ts_sender_Drain( p_sys->p_sender );
         es_out_Control( p_demux->out, ES_OUT_SET_ES_STATE, p_es->id, false );
         es_out_Del( p_demux->out, p_es->id );
         p_sys->i_pmt_es--;
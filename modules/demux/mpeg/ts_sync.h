@@ -0,0 +1,209 @@
+/*****************************************************************************
+ * ts_sync.h: Transport Stream sync byte lookup helpers
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_SYNC_H
+#define VLC_TS_SYNC_H
+
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS)
+   #include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+   #include <arm_neon.h>
+#endif
+
+#define TS_SYNC_BYTE 0x47
+
+/* Candidate sizes for detection, by order of preference */
+#define TS_SYNC_DETECT_COUNT 3
+static const unsigned ts_sync_detect_sizes[TS_SYNC_DETECT_COUNT] = { 188, 192, 204 };
+/* Detection validates the 3 following sync bytes */
+#define TS_SYNC_DETECT_SPAN (3 * 204)
+
+/* Looks up the first sync byte followed by another one i_stride bytes later.
+ * Only positions with the second byte before end are considered. */
+static inline const uint8_t * ts_sync_Find_C( const uint8_t *p, const uint8_t *end,
+                                              size_t i_stride )
+{
+    for( ; p + i_stride < end; p++ )
+    {
+        if( p[0] == TS_SYNC_BYTE && p[i_stride] == TS_SYNC_BYTE )
+            return p;
+    }
+    return NULL;
+}
+
+static inline bool ts_sync_DetectAt( const uint8_t *p, unsigned *pi_size )
+{
+    for( int i = 0; i < TS_SYNC_DETECT_COUNT; i++ )
+    {
+        const unsigned s = ts_sync_detect_sizes[i];
+        if( p[s] == TS_SYNC_BYTE && p[2 * s] == TS_SYNC_BYTE && p[3 * s] == TS_SYNC_BYTE )
+        {
+            *pi_size = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Looks up the first sync byte followed by 3 others at one of the candidate
+ * packet sizes. Only positions with TS_SYNC_DETECT_SPAN bytes after them
+ * before end are considered. */
+static inline const uint8_t * ts_sync_Detect_C( const uint8_t *p, const uint8_t *end,
+                                                unsigned *pi_size )
+{
+    for( ; p + TS_SYNC_DETECT_SPAN < end; p++ )
+    {
+        if( p[0] == TS_SYNC_BYTE && ts_sync_DetectAt( p, pi_size ) )
+            return p;
+    }
+    return NULL;
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+
+__attribute__ ((__target__ ("sse2")))
+static inline unsigned ts_sync_Match_SSE2( const uint8_t *p, __m128i sync )
+{
+    return _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) p ), sync ) );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static inline const uint8_t * ts_sync_Find_SSE2( const uint8_t *p, const uint8_t *end,
+                                                 size_t i_stride )
+{
+    const __m128i sync = _mm_set1_epi8( TS_SYNC_BYTE );
+
+    for( ; p + i_stride + 16 <= end; p += 16 )
+    {
+        unsigned match = ts_sync_Match_SSE2( p, sync );
+        if( match )
+            match &= ts_sync_Match_SSE2( p + i_stride, sync );
+        if( match )
+            return p + ctz( match );
+    }
+
+    return ts_sync_Find_C( p, end, i_stride );
+}
+
+/* Tests the 3 candidate sizes on 16 positions at once */
+__attribute__ ((__target__ ("sse2")))
+static inline const uint8_t * ts_sync_Detect_SSE2( const uint8_t *p, const uint8_t *end,
+                                                   unsigned *pi_size )
+{
+    const __m128i sync = _mm_set1_epi8( TS_SYNC_BYTE );
+
+    for( ; p + TS_SYNC_DETECT_SPAN + 16 <= end; p += 16 )
+    {
+        unsigned first = ts_sync_Match_SSE2( p, sync );
+        if( !first )
+            continue;
+
+        unsigned match = 0;
+        for( int i = 0; i < TS_SYNC_DETECT_COUNT; i++ )
+        {
+            const unsigned s = ts_sync_detect_sizes[i];
+            match |= first & ts_sync_Match_SSE2( p + s, sync )
+                           & ts_sync_Match_SSE2( p + 2 * s, sync )
+                           & ts_sync_Match_SSE2( p + 3 * s, sync );
+        }
+        if( match )
+        {
+            p += ctz( match );
+            ts_sync_DetectAt( p, pi_size ); /* pick by preference */
+            return p;
+        }
+    }
+
+    return ts_sync_Detect_C( p, end, pi_size );
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+static inline const uint8_t * ts_sync_Find_NEON( const uint8_t *p, const uint8_t *end,
+                                                 size_t i_stride )
+{
+    const uint8x16_t sync = vdupq_n_u8( TS_SYNC_BYTE );
+
+    for( ; p + i_stride + 16 <= end; p += 16 )
+    {
+        uint8x16_t match = vandq_u8( vceqq_u8( vld1q_u8( p ), sync ),
+                                     vceqq_u8( vld1q_u8( p + i_stride ), sync ) );
+        if( vmaxvq_u8( match ) )
+            return ts_sync_Find_C( p, p + 16 + i_stride, i_stride );
+    }
+
+    return ts_sync_Find_C( p, end, i_stride );
+}
+
+static inline const uint8_t * ts_sync_Detect_NEON( const uint8_t *p, const uint8_t *end,
+                                                   unsigned *pi_size )
+{
+    const uint8x16_t sync = vdupq_n_u8( TS_SYNC_BYTE );
+
+    for( ; p + TS_SYNC_DETECT_SPAN + 16 <= end; p += 16 )
+    {
+        uint8x16_t first = vceqq_u8( vld1q_u8( p ), sync );
+        if( !vmaxvq_u8( first ) )
+            continue;
+
+        uint8x16_t match = vdupq_n_u8( 0 );
+        for( int i = 0; i < TS_SYNC_DETECT_COUNT; i++ )
+        {
+            const unsigned s = ts_sync_detect_sizes[i];
+            uint8x16_t m = vandq_u8( first, vceqq_u8( vld1q_u8( p + s ), sync ) );
+            m = vandq_u8( m, vceqq_u8( vld1q_u8( p + 2 * s ), sync ) );
+            m = vandq_u8( m, vceqq_u8( vld1q_u8( p + 3 * s ), sync ) );
+            match = vorrq_u8( match, m );
+        }
+        if( vmaxvq_u8( match ) )
+            return ts_sync_Detect_C( p, p + 16 + TS_SYNC_DETECT_SPAN, pi_size );
+    }
+
+    return ts_sync_Detect_C( p, end, pi_size );
+}
+
+#endif
+
+static inline const uint8_t * ts_sync_Find( const uint8_t *p, const uint8_t *end,
+                                            size_t i_stride )
+{
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return ts_sync_Find_SSE2( p, end, i_stride );
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    return ts_sync_Find_NEON( p, end, i_stride );
+#endif
+    return ts_sync_Find_C( p, end, i_stride );
+}
+
+static inline const uint8_t * ts_sync_Detect( const uint8_t *p, const uint8_t *end,
+                                              unsigned *pi_size )
+{
+#if defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        return ts_sync_Detect_SSE2( p, end, pi_size );
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    return ts_sync_Detect_NEON( p, end, pi_size );
+#endif
+    return ts_sync_Detect_C( p, end, pi_size );
+}
+
+#endif
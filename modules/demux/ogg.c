@@ -36,6 +36,7 @@
 #include <vlc_plugin.h>
 #include <vlc_access.h>
 #include <vlc_demux.h>
+#include <vlc_vector.h>
 #include <vlc_meta.h>
 #include <vlc_input.h>
 
@@ -276,6 +277,7 @@ static void Close( vlc_object_t *p_this )
     if( p_sys->p_old_stream )
         Ogg_LogicalStreamDelete( p_demux, p_sys->p_old_stream );
 
+    oggseek_cache_clean( p_sys );
     free( p_sys );
 }
 
@@ -379,6 +381,7 @@ static int Demux( demux_t * p_demux )
     ogg_packet  oggpacket;
     int         i_stream;
     bool b_canseek;
+    int64_t     i_pagepos = -1;
 
     int i_active_streams = p_sys->i_streams;
     for ( int i=0; i < p_sys->i_streams; i++ )
@@ -461,6 +464,11 @@ static int Demux( demux_t * p_demux )
          */
         if( Ogg_ReadPage( p_demux, &p_sys->current_page ) != VLC_SUCCESS )
             return VLC_DEMUXER_EOF; /* EOF */
+        if( p_sys->i_total_length > 0 )
+            i_pagepos = vlc_stream_Tell( p_demux->s )
+                      - ( p_sys->oy.fill - p_sys->oy.returned )
+                      - p_sys->current_page.header_len
+                      - p_sys->current_page.body_len;
         /* Test for End of Stream */
         if( ogg_page_eos( &p_sys->current_page ) )
         {
@@ -513,6 +521,14 @@ static int Demux( demux_t * p_demux )
             {
                 continue;
             }
+
+            /* remember where the pages are, to bound the next seeks */
+            int64_t i_granule = ogg_page_granulepos( &p_sys->current_page );
+            if( i_pagepos > 0 && i_granule > 0 )
+                OggSeek_IndexAdd( p_stream,
+                                  Ogg_GranuleToTime( p_stream, i_granule,
+                                                     !p_stream->b_contiguous, false ),
+                                  i_pagepos );
         }
 
         /* clear the finished flag if pages after eos (ex: after a seek) */
@@ -2203,7 +2219,7 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
         p_stream->p_es = NULL;
 
         /* initialise kframe index */
-        p_stream->idx=NULL;
+        vlc_vector_init( &p_stream->idx );
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2309,10 +2325,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    vlc_vector_destroy( &p_stream->idx );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
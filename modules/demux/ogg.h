@@ -42,6 +42,10 @@
 
 #define OGGDS_RESOLUTION     10000000
 
+/* Blocks of the file kept while seeking */
+#define OGGSEEK_CACHE_BLOCKS     8
+#define OGGSEEK_CACHE_BLOCK_SIZE (1 << 14)
+
 typedef struct oggseek_index_entry demux_index_entry_t;
 typedef struct ogg_skeleton_t ogg_skeleton_t;
 
@@ -92,8 +96,8 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_first_frame_index;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* index of the pages seen while playing and seeking, sorted */
+    struct VLC_VECTOR(demux_index_entry_t) idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -197,6 +201,15 @@ typedef struct
     /* current page being parsed */
     ogg_page current_page;
 
+    /* blocks of the file read while seeking, shared by the bisection probes
+     * and the search of the keyframe */
+    struct
+    {
+        int64_t i_block;
+        uint8_t *p_data;
+    } seekcache[OGGSEEK_CACHE_BLOCKS];
+    unsigned i_seekcache_next;
+
     /* */
     vlc_meta_t          *p_meta;
     int                 cur_seekpoint;
@@ -30,6 +30,7 @@
 #include <vlc_common.h>
 #include <vlc_codecs.h>
 #include <vlc_es.h>
+#include <vlc_vector.h>
 
 #include "ogg.h"
 #include "ogg_granule.h"
@@ -36,6 +36,7 @@
 
 #include <vlc_common.h>
 #include <vlc_demux.h>
+#include <vlc_vector.h>
 
 #include <ogg/ogg.h>
 #include <limits.h>
@@ -60,115 +61,148 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
-
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+/* first entry at or after i_pagepos */
+static size_t OggSeekIndexLookup( const logical_stream_t *p_stream,
+                                  int64_t i_pagepos )
 {
-    demux_index_entry_t *idx_next;
+    size_t i_min = 0, i_max = p_stream->idx.size;
 
-    while ( idx != NULL )
+    while ( i_min < i_max )
     {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
+        size_t i_mid = ( i_min + i_max ) / 2;
+        if ( p_stream->idx.data[i_mid].i_pagepos < i_pagepos )
+            i_min = i_mid + 1;
+        else
+            i_max = i_mid;
     }
-}
-
-
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( void )
-{
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    return i_min;
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
    time stamps) */
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
-                                             vlc_tick_t i_timestamp,
-                                             int64_t i_pagepos )
+void OggSeek_IndexAdd ( logical_stream_t *p_stream,
+                        vlc_tick_t i_timestamp,
+                        int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
+    if ( p_stream == NULL ) return;
 
-    if ( p_stream == NULL ) return NULL;
+    if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 ) return;
 
-    idx = p_stream->idx;
+    size_t i = OggSeekIndexLookup( p_stream, i_pagepos );
 
-    if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 ) return NULL;
+    /* keep the index small, the entries only bound the bisection */
+    if ( i < p_stream->idx.size &&
+         ( p_stream->idx.data[i].i_pagepos == i_pagepos ||
+           p_stream->idx.data[i].i_value - i_timestamp < OGGSEEK_INDEX_INTERVAL ) )
+        return;
+    if ( i > 0 &&
+         i_timestamp - p_stream->idx.data[i - 1].i_value < OGGSEEK_INDEX_INTERVAL )
+        return;
 
-    if ( idx == NULL )
-    {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
-    }
+    demux_index_entry_t entry = {
+        .i_value = i_timestamp,
+        .i_pagepos = i_pagepos,
+    };
+    vlc_vector_insert( &p_stream->idx, i, entry );
+}
 
-    while ( idx != NULL )
-    {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
-    }
+static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestamp,
+                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+{
+    /* the timestamps increase with the positions: look for the first entry
+     * after i_timestamp */
+    size_t i_min = 0, i_max = p_stream->idx.size;
 
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
+    while ( i_min < i_max )
     {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
-    }
-    else
-    {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        size_t i_mid = ( i_min + i_max ) / 2;
+        if ( p_stream->idx.data[i_mid].i_value <= i_timestamp )
+            i_min = i_mid + 1;
+        else
+            i_max = i_mid;
     }
 
-    if ( idx->p_next != NULL )
-    {
-        idx->p_next->p_prev = idx;
-    }
+    if ( i_min < p_stream->idx.size )
+        *pi_pos_upper = p_stream->idx.data[i_min].i_pagepos;
+    if ( i_min == 0 )
+        return false;
+    *pi_pos_lower = p_stream->idx.data[i_min - 1].i_pagepos;
+    return true;
+}
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
+/************************************************************
+* cache of the blocks read while seeking
+*************************************************************/
 
-    return idx;
+void oggseek_cache_clean ( demux_sys_t *p_sys )
+{
+    for ( unsigned i = 0; i < OGGSEEK_CACHE_BLOCKS; i++ )
+        free( p_sys->seekcache[i].p_data );
 }
 
-static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+/* Reads i_size bytes at i_pos. The bisection probes and the search of the
+ * keyframe that follows read the same regions several times: full blocks
+ * are kept, so that each region is requested only once to the stream. */
+static int64_t cache_read( demux_t *p_demux, int64_t i_pos,
+                           uint8_t *p_buf, int64_t i_size )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    demux_sys_t *p_sys  = p_demux->p_sys;
+    int64_t i_done = 0;
 
-    while ( idx != NULL )
+    while ( i_done < i_size )
     {
-        if ( idx->i_value <= i_timestamp )
+        const int64_t i_block = ( i_pos + i_done ) / OGGSEEK_CACHE_BLOCK_SIZE;
+        const int64_t i_offset = ( i_pos + i_done ) % OGGSEEK_CACHE_BLOCK_SIZE;
+        const int64_t i_chunk = __MIN( i_size - i_done,
+                                       OGGSEEK_CACHE_BLOCK_SIZE - i_offset );
+        const uint8_t *p_data = NULL;
+
+        for ( unsigned i = 0; i < OGGSEEK_CACHE_BLOCKS; i++ )
         {
-            if ( !idx->p_next ) /* found on last index */
+            if ( p_sys->seekcache[i].p_data != NULL &&
+                 p_sys->seekcache[i].i_block == i_block )
             {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
+                p_data = p_sys->seekcache[i].p_data;
+                break;
             }
-            if ( idx->p_next->i_value > i_timestamp )
+        }
+
+        if ( p_data == NULL )
+        {
+            unsigned i = p_sys->i_seekcache_next;
+            if ( p_sys->seekcache[i].p_data == NULL )
+                p_sys->seekcache[i].p_data = malloc( OGGSEEK_CACHE_BLOCK_SIZE );
+            uint8_t *p_block = p_sys->seekcache[i].p_data;
+            p_sys->seekcache[i].i_block = -1;
+
+            if ( p_block == NULL ||
+                 vlc_stream_Seek( p_demux->s, i_block * OGGSEEK_CACHE_BLOCK_SIZE ) )
+                break;
+
+            ssize_t i_read = vlc_stream_Read( p_demux->s, p_block,
+                                              OGGSEEK_CACHE_BLOCK_SIZE );
+            if ( i_read < OGGSEEK_CACHE_BLOCK_SIZE )
             {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
+                /* end of the file: not kept, it may grow */
+                if ( i_read > i_offset )
+                {
+                    int64_t i_copy = __MIN( i_chunk, i_read - i_offset );
+                    memcpy( &p_buf[i_done], &p_block[i_offset], i_copy );
+                    i_done += i_copy;
+                }
+                break;
             }
+
+            p_sys->seekcache[i].i_block = i_block;
+            p_sys->i_seekcache_next = ( i + 1 ) % OGGSEEK_CACHE_BLOCKS;
+            p_data = p_block;
         }
-        idx = idx->p_next;
+
+        memcpy( &p_buf[i_done], &p_data[i_offset], i_chunk );
+        i_done += i_chunk;
     }
 
-    return false;
+    return i_done;
 }
 
 /*********************************************************************
@@ -191,6 +225,18 @@ static void seek_byte( demux_t *p_demux, int64_t i_pos )
 }
 
 
+/* move the probes to offset i_pos and update the sync, the data is read
+ * through the cache so the stream is left untouched */
+
+static void probe_byte( demux_t *p_demux, int64_t i_pos )
+{
+    demux_sys_t *p_sys  = p_demux->p_sys;
+
+    ogg_sync_reset( &p_sys->oy );
+
+    p_sys->i_input_position = i_pos;
+    p_sys->b_page_waiting = false;
+}
 
 /* read bytes from the ogg file to try to find a page start */
 
@@ -214,11 +260,12 @@ static int64_t get_data( demux_t *p_demux, int64_t i_bytes_to_read )
 
     i_bytes_to_read = __MIN( i_bytes_to_read, INT_MAX );
 
-    seek_byte ( p_demux, p_sys->i_input_position );
+    probe_byte ( p_demux, p_sys->i_input_position );
 
     buf = ogg_sync_buffer( &p_sys->oy, i_bytes_to_read );
 
-    i_result = vlc_stream_Read( p_demux->s, buf, i_bytes_to_read );
+    i_result = cache_read( p_demux, p_sys->i_input_position,
+                           (uint8_t *)buf, i_bytes_to_read );
 
     ogg_sync_wrote( &p_sys->oy, i_result );
     return i_result;
@@ -334,7 +381,7 @@ static int64_t find_first_page_granule( demux_t *p_demux,
 
     ogg_packet op;
 
-    seek_byte( p_demux, i_pos1 );
+    probe_byte( p_demux, i_pos1 );
 
     if ( i_pos1 == p_stream->i_data_start )
         return p_sys->i_input_position;
@@ -380,7 +427,7 @@ static int64_t find_first_page_granule( demux_t *p_demux,
 
     };
 
-    seek_byte( p_demux, p_sys->i_input_position );
+    probe_byte( p_demux, p_sys->i_input_position );
     ogg_stream_reset( &p_stream->os );
 
     while( 1 )
@@ -513,7 +560,7 @@ static int64_t OggForwardSeekToFrame( demux_t *p_demux, int64_t i_pos1, int64_t
     demux_sys_t *p_sys  = p_demux->p_sys;
 
     i_bytes_to_read = i_pos2 - i_pos1 + 1;
-    seek_byte( p_demux, i_pos1 );
+    probe_byte( p_demux, i_pos1 );
     if ( i_bytes_to_read > OGGSEEK_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
 
     OggDebug(
@@ -553,7 +600,7 @@ static int64_t OggForwardSeekToFrame( demux_t *p_demux, int64_t i_pos1, int64_t
         p_sys->i_input_position += i_bytes_read;
     };
 
-    seek_byte( p_demux, p_sys->i_input_position );
+    probe_byte( p_demux, p_sys->i_input_position );
     ogg_stream_reset( &p_stream->os );
 
     ogg_packet op;
@@ -588,6 +635,9 @@ static int64_t OggForwardSeekToFrame( demux_t *p_demux, int64_t i_pos1, int64_t
 
         if ( OggSeekToPacket( p_demux, p_stream, i_granulepos, &lastpacket, b_fastseek ) )
         {
+            /* the page is waiting, the demuxer continues after it */
+            if ( vlc_stream_Seek( p_demux->s, p_sys->i_input_position + i_result ) )
+                return SEGMENT_NOT_FOUND;
             p_sys->i_input_position = lastpacket.i_pos;
             p_stream->i_skip_frames = 0;
             return p_sys->i_input_position;
@@ -693,7 +743,8 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
 
         if ( current.i_pos != -1 && current.i_granule != -1 )
         {
-            /* found a page */
+            /* found a page, remember it for the next seeks */
+            OggSeek_IndexAdd( p_stream, current.i_timestamp, current.i_pos );
 
             if ( current.i_timestamp <= i_targettime )
             {
@@ -905,12 +956,6 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
         p_sys->i_input_position = i_pagepos;
         seek_byte( p_demux, p_sys->i_input_position );
     }
-    /* Insert keyframe position into index */
-    OggNoDebug(
-    if ( i_pagepos >= p_stream->i_data_start )
-        OggSeek_IndexAdd( p_stream, i_time, i_pagepos )
-    );
-
     OggDebug( msg_Dbg( p_demux, "=================== Seeked To %"PRId64" time %"PRId64, i_pagepos, i_time ) );
     return i_pagepos;
 }
@@ -937,25 +982,24 @@ int64_t oggseek_read_page( demux_t *p_demux )
     demux_sys_t *p_sys  = p_demux->p_sys;
 
     /* store position of this page */
-    i_in_pos = p_ogg->i_input_position = vlc_stream_Tell( p_demux->s );
+    i_in_pos = p_ogg->i_input_position;
 
     if ( p_sys->b_page_waiting) {
         msg_Warn( p_demux, "Ogg page already loaded" );
         return 0;
     }
 
-    if ( vlc_stream_Read ( p_demux->s, header, PAGE_HEADER_BYTES ) < PAGE_HEADER_BYTES )
+    if ( cache_read( p_demux, i_in_pos, header, PAGE_HEADER_BYTES ) < PAGE_HEADER_BYTES )
     {
-        vlc_stream_Seek( p_demux->s, i_in_pos );
         msg_Dbg ( p_demux, "Reached clean EOF in ogg file" );
         return 0;
     }
 
     i_nsegs = header[ PAGE_HEADER_BYTES - 1 ];
 
-    if ( vlc_stream_Read ( p_demux->s, header+PAGE_HEADER_BYTES, i_nsegs ) < i_nsegs )
+    if ( cache_read( p_demux, i_in_pos + PAGE_HEADER_BYTES,
+                     header + PAGE_HEADER_BYTES, i_nsegs ) < i_nsegs )
     {
-        vlc_stream_Seek( p_demux->s, i_in_pos );
         msg_Warn ( p_demux, "Reached broken EOF in ogg file" );
         return 0;
     }
@@ -973,8 +1017,9 @@ int64_t oggseek_read_page( demux_t *p_demux )
 
     memcpy( buf, header, PAGE_HEADER_BYTES + i_nsegs );
 
-    i_result = vlc_stream_Read ( p_demux->s, (uint8_t*)buf + PAGE_HEADER_BYTES + i_nsegs,
-                             i_page_size - PAGE_HEADER_BYTES - i_nsegs );
+    i_result = cache_read( p_demux, i_in_pos + PAGE_HEADER_BYTES + i_nsegs,
+                           (uint8_t*)buf + PAGE_HEADER_BYTES + i_nsegs,
+                           i_page_size - PAGE_HEADER_BYTES - i_nsegs );
 
     ogg_sync_wrote( &p_ogg->oy, i_result + PAGE_HEADER_BYTES + i_nsegs );
 
@@ -42,32 +42,45 @@ bool IndexReader::parseIndex(block_t *p_block, BaseRepresentation *rep)
         return false;
 
     /* Do track ID fixup */
-    const MP4_Box_t *tfhd_box = MP4_BoxGet( rootbox, "moof/traf/tfhd" );
-    if ( tfhd_box )
-        SetDWBE( &p_block->p_buffer[tfhd_box->i_pos + 8 + 4], 0x01 );
+    Atom tfhd_box;
+    if ( find( "moof/traf/tfhd", &tfhd_box ) && tfhd_box.getPayloadSize() >= 8 )
+        SetDWBE( &p_block->p_buffer[tfhd_box.offset + tfhd_box.headersize + 4], 0x01 );
 
     if(!rep->getPlaylist()->isLive())
         return true;
 
-    const MP4_Box_t *uuid_box = MP4_BoxGet( rootbox, "moof/traf/uuid" );
-    while( uuid_box && uuid_box->i_type == ATOM_uuid )
-    {
-        if ( !CmpUUID( &uuid_box->i_uuid, &TfrfBoxUUID ) )
-            break;
-        uuid_box = uuid_box->p_next;
-    }
+    Atom uuid_box;
+    if( !find( "moof/traf/uuid", &uuid_box, &TfrfBoxUUID ) )
+        return false;
 
-    if(!uuid_box)
+    const uint8_t *p = uuid_box.getPayload();
+    size_t i_payload = uuid_box.getPayloadSize();
+    if( i_payload < 5 )
+        return false;
+    const uint8_t i_version = p[0];
+    const uint8_t i_fragment_count = p[4];
+    const size_t i_fieldsize = (i_version == 0) ? 8 : 16;
+    p += 5; i_payload -= 5;
+    if( i_payload / i_fieldsize < i_fragment_count )
         return false;
 
     SegmentTimeline *timelineadd = new (std::nothrow) SegmentTimeline(rep->inheritTimescale());
     if (timelineadd)
     {
-        const MP4_Box_data_tfrf_t *p_tfrfdata = uuid_box->data.p_tfrf;
-        for ( uint8_t i=0; i<p_tfrfdata->i_fragment_count; i++ )
+        for ( uint8_t i=0; i<i_fragment_count; i++ )
         {
-            uint64_t dur = p_tfrfdata->p_tfrf_data_fields[i].i_fragment_duration;
-            uint64_t stime = p_tfrfdata->p_tfrf_data_fields[i].i_fragment_abs_time;
+            uint64_t stime, dur;
+            if( i_version == 0 )
+            {
+                stime = GetDWBE( p );
+                dur = GetDWBE( &p[4] );
+            }
+            else
+            {
+                stime = GetQWBE( p );
+                dur = GetQWBE( &p[8] );
+            }
+            p += i_fieldsize;
             timelineadd->addElement(i+1, dur, 0, stime);
         }
 
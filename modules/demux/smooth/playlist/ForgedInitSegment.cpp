@@ -62,10 +62,14 @@ ForgedInitSegment::ForgedInitSegment(ICanonicalUrl *parent,
     fourcc = 0;
     es_type = UNKNOWN_ES;
     track_id = 1;
+    forgedmoov = NULL;
+    vlc_mutex_init(&lock);
 }
 
 ForgedInitSegment::~ForgedInitSegment()
 {
+    if(forgedmoov)
+        block_Release(forgedmoov);
     free(extradata);
 }
 
@@ -321,10 +325,17 @@ block_t * ForgedInitSegment::buildMoovBox()
 SegmentChunk* ForgedInitSegment::toChunk(SharedResources *, AbstractConnectionManager *,
                                          size_t, BaseRepresentation *rep)
 {
-    block_t *moov = buildMoovBox();
-    if(moov)
+    block_t *copy = NULL;
     {
-        MemoryChunkSource *source = new (std::nothrow) MemoryChunkSource(moov);
+        vlc_mutex_locker locker(&lock);
+        if(!forgedmoov)
+            forgedmoov = buildMoovBox();
+        if(forgedmoov)
+            copy = block_Duplicate(forgedmoov);
+    }
+    if(copy)
+    {
+        MemoryChunkSource *source = new (std::nothrow) MemoryChunkSource(copy);
         if( source )
         {
             SegmentChunk *chunk = new (std::nothrow) SegmentChunk(source, rep);
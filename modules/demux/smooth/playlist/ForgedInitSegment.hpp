@@ -25,6 +25,7 @@
 
 #include <vlc_es.h>
 #include <vlc_codecs.h>
+#include <vlc_threads.h>
 
 namespace smooth
 {
@@ -59,6 +60,10 @@ namespace smooth
                 void fromWaveFormatEx(const uint8_t *p_data, size_t i_data);
                 void fromVideoInfoHeader(const uint8_t *p_data, size_t i_data);
                 block_t * buildMoovBox();
+                /* forged once, as all the parameters are set by the parser,
+                 * and reused for every (re)start or quality switch */
+                block_t *forgedmoov;
+                vlc_mutex_t lock;
                 std::string data;
                 std::string type;
                 std::string language;
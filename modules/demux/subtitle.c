@@ -104,22 +104,38 @@ enum subtitle_type_e
     SUB_TYPE_SCC,      /* Scenarist Closed Caption */
 };
 
+/* Above this size, the texts are not kept in memory but read again from
+ * the stream when they are sent (seekable streams only) */
+#define SUB_STREAMING_SIZE (8 << 20)
+/* Lines kept while streaming, the parsers only step back one line */
+#define TEXT_STREAM_LINES  4
+
 typedef struct
 {
     size_t  i_line_count;
     size_t  i_line;
     char    **line;
+
+    /* streaming: the lines are read on demand, only the last ones kept */
+    stream_t *s;
+    uint64_t i_offset[TEXT_STREAM_LINES];
 } text_t;
 
 static int  TextLoad( text_t *, stream_t *s );
+static int  TextStream( text_t *, stream_t *s );
 static void TextUnload( text_t * );
+static uint64_t TextTell( text_t * );
 
 typedef struct
 {
     vlc_tick_t i_start;
     vlc_tick_t i_stop;
 
-    char    *psz_text;
+    char    *psz_text;  /* NULL while streaming */
+
+    /* streaming: where and in which order the subtitle was read */
+    uint64_t i_offset;
+    size_t   i_idx;
 } subtitle_t;
 
 typedef struct
@@ -175,6 +191,8 @@ typedef struct
     subs_properties_t props;
 
     block_t * (*pf_convert)( const subtitle_t * );
+    /* streaming mode: parser reading the texts again */
+    int  (*pf_reread)( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t*, size_t );
 } demux_sys_t;
 
 static int  ParseMicroDvd   ( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t *, size_t );
@@ -234,6 +252,7 @@ static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
 static void Fix( demux_t * );
+static block_t *ReadBlock( demux_t *, const subtitle_t * );
 static char * get_language_from_filename( const char * );
 
 /*****************************************************************************
@@ -282,6 +301,27 @@ static block_t *ToEIA608Block( const subtitle_t *p_subtitle )
     return p_block;
 }
 
+/* The subtitles of these formats start on a line and their text does not
+ * depend on the ones before, they can be parsed again on their own. */
+static bool CanStream( enum subtitle_type_e i_type )
+{
+    switch( i_type )
+    {
+        case SUB_TYPE_MICRODVD:
+        case SUB_TYPE_SUBRIP:
+        case SUB_TYPE_SUBVIEWER:
+        case SUB_TYPE_SSA1:
+        case SUB_TYPE_SSA2_4:
+        case SUB_TYPE_ASS:
+        case SUB_TYPE_VPLAYER:
+        case SUB_TYPE_MPL2:
+        case SUB_TYPE_SBV:
+            return true;
+        default:
+            return false;
+    }
+}
+
 /*****************************************************************************
  * Module initializer
  *****************************************************************************/
@@ -312,6 +352,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->f_rate = 1.0;
 
     p_sys->pf_convert = ToTextBlock;
+    p_sys->pf_reread = NULL;
 
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
@@ -633,9 +674,26 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* Huge files are only indexed, if they can be read again */
+    uint64_t i_size;
+    bool b_can_seek = false;
+    if( ( e_bom == UTF8BOM || e_bom == NOBOM ) &&
+        CanStream( p_sys->props.i_type ) &&
+        vlc_stream_GetSize( p_demux->s, &i_size ) == VLC_SUCCESS &&
+        i_size >= SUB_STREAMING_SIZE &&
+        vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_can_seek ) == VLC_SUCCESS &&
+        b_can_seek )
+    {
+        msg_Dbg( p_demux, "indexing subtitles of %"PRIu64" bytes", i_size );
+        p_sys->pf_reread = pf_read;
+    }
+
     /* Load the whole file */
     text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    if( p_sys->pf_reread )
+        TextStream( &txtlines, p_demux->s );
+    else
+        TextLoad( &txtlines, p_demux->s );
 
     /* Parse it */
     for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
@@ -653,11 +711,17 @@ static int Open ( vlc_object_t *p_this )
             p_sys->subtitles.p_array = p_realloc;
         }
 
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_count];
+        p_subtitle->i_offset = TextTell( &txtlines );
+        p_subtitle->i_idx = p_sys->subtitles.i_count;
+
         if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
-                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
-                     p_sys->subtitles.i_count ) )
+                     p_subtitle, p_sys->subtitles.i_count ) )
             break;
 
+        if( p_sys->pf_reread )
+            FREENULL( p_subtitle->psz_text );
+
         p_sys->subtitles.i_count++;
     }
     /* Unload */
@@ -858,7 +922,8 @@ static int Demux( demux_t *p_demux )
 
         if( p_subtitle->i_start >= 0 )
         {
-            block_t *p_block = p_sys->pf_convert( p_subtitle );
+            block_t *p_block = p_sys->pf_reread ? ReadBlock( p_demux, p_subtitle )
+                                                : p_sys->pf_convert( p_subtitle );
             if( p_block )
             {
                 p_block->i_dts =
@@ -886,6 +951,39 @@ static int Demux( demux_t *p_demux )
 }
 
 
+/*****************************************************************************
+ * ReadBlock: parse the text of an indexed subtitle again
+ *****************************************************************************/
+static block_t *ReadBlock( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    text_t txt;
+
+    if( vlc_stream_Seek( p_demux->s, p_subtitle->i_offset ) ||
+        TextStream( &txt, p_demux->s ) )
+        return NULL;
+
+    /* the header and the frame rate are already known */
+    subs_properties_t props = p_sys->props;
+    props.psz_header = NULL;
+
+    subtitle_t sub = { .psz_text = NULL };
+    block_t *p_block = NULL;
+    if( p_sys->pf_reread( VLC_OBJECT(p_demux), &props, &txt, &sub,
+                          p_subtitle->i_idx ) == VLC_SUCCESS )
+    {
+        p_block = p_sys->pf_convert( &sub );
+        free( sub.psz_text );
+    }
+    else
+        msg_Warn( p_demux, "cannot read the subtitle at %"PRIu64,
+                  p_subtitle->i_offset );
+
+    free( props.psz_header );
+    TextUnload( &txt );
+    return p_block;
+}
+
 static int subtitle_cmp( const void *first, const void *second )
 {
     vlc_tick_t result = ((subtitle_t *)(first))->i_start - ((subtitle_t *)(second))->i_start;
@@ -912,6 +1010,7 @@ static int TextLoad( text_t *txt, stream_t *s )
     i_line_max          = 500;
     txt->i_line_count   = 0;
     txt->i_line         = 0;
+    txt->s              = NULL;
     txt->line           = calloc( i_line_max, sizeof( char * ) );
     if( !txt->line )
         return VLC_ENOMEM;
@@ -944,9 +1043,24 @@ static int TextLoad( text_t *txt, stream_t *s )
 
     return VLC_SUCCESS;
 }
+static int TextStream( text_t *txt, stream_t *s )
+{
+    txt->i_line_count   = 0;
+    txt->i_line         = 0;
+    txt->s              = s;
+    txt->line           = calloc( TEXT_STREAM_LINES, sizeof( char * ) );
+    return txt->line ? VLC_SUCCESS : VLC_ENOMEM;
+}
 static void TextUnload( text_t *txt )
 {
-    if( txt->i_line_count )
+    if( txt->s )
+    {
+        if( txt->line )
+            for( size_t i = 0; i < TEXT_STREAM_LINES; i++ )
+                free( txt->line[i] );
+        free( txt->line );
+    }
+    else if( txt->i_line_count )
     {
         for( size_t i = 0; i < txt->i_line_count; i++ )
             free( txt->line[i] );
@@ -956,11 +1070,37 @@ static void TextUnload( text_t *txt )
     txt->i_line_count = 0;
 }
 
+/* offset of the next line in the stream, streaming only */
+static uint64_t TextTell( text_t *txt )
+{
+    if( !txt->s )
+        return 0;
+    if( txt->i_line < txt->i_line_count )
+        return txt->i_offset[txt->i_line % TEXT_STREAM_LINES];
+    return vlc_stream_Tell( txt->s );
+}
+
 static char *TextGetLine( text_t *txt )
 {
+    if( txt->s && txt->line && txt->i_line >= txt->i_line_count )
+    {
+        const size_t i = txt->i_line_count % TEXT_STREAM_LINES;
+        uint64_t i_offset = vlc_stream_Tell( txt->s );
+        char *psz = vlc_stream_ReadLine( txt->s );
+
+        if( psz == NULL )
+            return NULL;
+        free( txt->line[i] );
+        txt->line[i] = psz;
+        txt->i_offset[i] = i_offset;
+        txt->i_line_count++;
+    }
+
     if( txt->i_line >= txt->i_line_count )
         return( NULL );
 
+    if( txt->s )
+        return txt->line[txt->i_line++ % TEXT_STREAM_LINES];
     return txt->line[txt->i_line++];
 }
 static void TextPreviousLine( text_t *txt )
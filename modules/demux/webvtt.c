@@ -61,6 +61,8 @@ typedef struct
         webvtt_cue_t *p_array;
         size_t  i_alloc;
         size_t  i_count;
+        /* highest stop time of the cues up to each index, for lookups */
+        vlc_tick_t *p_max_stop;
     } cues;
 
     struct
@@ -313,12 +315,53 @@ static int index_Compare( const void *a_, const void *b_ )
 
 static size_t getIndexByTime( demux_sys_t *p_sys, vlc_tick_t i_time )
 {
-    for( size_t i=0; i<p_sys->index.i_count; i++ )
+    size_t i_low = 0, i_high = p_sys->index.i_count;
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_sys->index.p_array[i_mid].time < i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return ( i_low < p_sys->index.i_count ) ? i_low : 0;
+}
+
+static void BuildCuesMaxStop( demux_sys_t *p_sys )
+{
+    if( p_sys->cues.i_count == 0 )
+        return;
+
+    p_sys->cues.p_max_stop = vlc_alloc( p_sys->cues.i_count, sizeof(vlc_tick_t) );
+    if( !p_sys->cues.p_max_stop )
+        return;
+
+    vlc_tick_t i_max = p_sys->cues.p_array[0].i_stop;
+    for( size_t i=0; i<p_sys->cues.i_count; i++ )
+    {
+        i_max = __MAX( i_max, p_sys->cues.p_array[i].i_stop );
+        p_sys->cues.p_max_stop[i] = i_max;
+    }
+}
+
+/* First cue that can still be active at i_time: all the previous ones
+ * have already stopped. Cues being sorted by start time, the lookup only
+ * needs to walk from there to the first cue starting after i_time. */
+static size_t getFirstActiveCue( demux_sys_t *p_sys, vlc_tick_t i_time )
+{
+    if( !p_sys->cues.p_max_stop )
+        return 0;
+
+    size_t i_low = 0, i_high = p_sys->cues.i_count;
+    while( i_low < i_high )
     {
-        if( p_sys->index.p_array[i].time >= i_time )
-            return i;
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_sys->cues.p_max_stop[i_mid] <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
-    return 0;
+    return i_low;
 }
 
 static void BuildIndex( demux_t *p_demux )
@@ -352,7 +395,7 @@ static block_t *demux_From( demux_t *p_demux, vlc_tick_t i_start )
 
     block_t *p_list = NULL;
     block_t **pp_append = &p_list;
-    for( size_t i=0; i<p_sys->cues.i_count; i++ )
+    for( size_t i=getFirstActiveCue( p_sys, i_start ); i<p_sys->cues.i_count; i++ )
     {
         const webvtt_cue_t *p_cue = &p_sys->cues.p_array[i];
         if( p_cue->i_start > i_start )
@@ -396,6 +439,7 @@ static int ReadWEBVTT( demux_t *p_demux )
     if( !ctx.b_ordered )
         qsort( p_sys->cues.p_array, p_sys->cues.i_count, sizeof(webvtt_cue_t), cue_Compare );
 
+    BuildCuesMaxStop( p_sys );
     BuildIndex( p_demux );
 
     memstream_Grab( &ctx.regions, &p_sys->regions_headers.p_data,
@@ -731,6 +775,7 @@ void webvtt_CloseDemux( vlc_object_t *p_this )
     for( size_t i=0; i< p_sys->cues.i_count; i++ )
         webvtt_cue_Clean( &p_sys->cues.p_array[i] );
     free( p_sys->cues.p_array );
+    free( p_sys->cues.p_max_stop );
 
     free( p_sys->index.p_array );
 
@@ -34,18 +34,39 @@
 
 #include "qt.hpp"
 
-EPGItem::EPGItem( const vlc_epg_event_t *data, EPGView *view, EPGProgram *prog )
+EPGEvent::EPGEvent( const vlc_epg_event_t *data )
+    : m_duration( 0 ), m_id( data->i_id ), m_rating( 0 )
+{
+    setData( data );
+}
+
+EPGItem::EPGItem( EPGView *view )
     : QGraphicsItem()
 {
     m_view = view;
-    program = prog;
-    m_id = data->i_id;
-    setData( data );
+    program = NULL;
+    m_event = NULL;
     m_boundingRect.setHeight( TRACKS_HEIGHT );
     setFlags( QGraphicsItem::ItemIsSelectable | QGraphicsItem::ItemIsFocusable);
     setAcceptHoverEvents( true );
 }
 
+void EPGItem::bind( EPGProgram *prog, const EPGEvent *event )
+{
+    prepareGeometryChange();
+    program = prog;
+    m_event = event;
+    m_boundingRect.setWidth( event->duration() );
+    setToolTip( event->name() );
+    updatePos();
+    update();
+}
+
+void EPGItem::refresh()
+{
+    bind( program, m_event );
+}
+
 QRectF EPGItem::boundingRect() const
 {
     return m_boundingRect;
@@ -68,7 +89,7 @@ void EPGItem::paint( QPainter *painter, const QStyleOptionGraphicsItem *option,
 
     QLinearGradient gradient( mapped.topLeft(), mapped.bottomLeft() );
 
-    if ( program->getCurrent() == this )
+    if ( program->getCurrent() == m_event )
         gradientColor.setRgb( 244, 125, 0 , 255 );
     else
         gradientColor.setRgb( 201, 217, 242 );
@@ -100,9 +121,9 @@ void EPGItem::paint( QPainter *painter, const QStyleOptionGraphicsItem *option,
 
     painter->setPen( Qt::black );
     /* Draw the title. */
-    painter->drawText( mapped, Qt::AlignTop | Qt::AlignLeft, fm.elidedText( m_name, Qt::ElideRight, mapped.width() ) );
+    painter->drawText( mapped, Qt::AlignTop | Qt::AlignLeft, fm.elidedText( m_event->name(), Qt::ElideRight, mapped.width() ) );
 
-    if ( m_rating > 0 && mapped.width() > 40 )
+    if ( m_event->rating() > 0 && mapped.width() > 40 )
     {
         QRectF iconsRect = QRectF( mapped.bottomRight(), mapped.bottomRight() );
         iconsRect.adjust( -20, -20, 0, 0 );
@@ -111,45 +132,45 @@ void EPGItem::paint( QPainter *painter, const QStyleOptionGraphicsItem *option,
         f.setPixelSize( 8 );
         painter->setFont( f );
         painter->drawRect( iconsRect );
-        painter->drawText( iconsRect, Qt::AlignCenter, QString("%1+").arg( m_rating ) );
+        painter->drawText( iconsRect, Qt::AlignCenter, QString("%1+").arg( m_event->rating() ) );
         painter->restore();
     }
 
     mapped.adjust( 0, 20, 0, 0 );
 
-    QDateTime m_end = m_start.addSecs( m_duration );
+    QDateTime m_end = m_event->end();
     f.setPixelSize( 10 );
     f.setItalic( true );
     painter->setFont( f );
 
     /* Draw the hours. */
     painter->drawText( mapped, Qt::AlignTop | Qt::AlignLeft,
-                       fm.elidedText( start().toString( "hh:mm" ) + " - " +
+                       fm.elidedText( m_event->start().toString( "hh:mm" ) + " - " +
                                       m_end.toString( "hh:mm" ),
                                       Qt::ElideRight, mapped.width() ) );
 }
 
-const QDateTime& EPGItem::start() const
+const QDateTime& EPGEvent::start() const
 {
     return m_start;
 }
 
-QDateTime EPGItem::end() const
+QDateTime EPGEvent::end() const
 {
     return QDateTime( m_start ).addSecs( m_duration );
 }
 
-uint32_t EPGItem::duration() const
+uint32_t EPGEvent::duration() const
 {
     return m_duration;
 }
 
-uint16_t EPGItem::eventID() const
+uint16_t EPGEvent::eventID() const
 {
     return m_id;
 }
 
-bool EPGItem::setData( const vlc_epg_event_t *data )
+bool EPGEvent::setData( const vlc_epg_event_t *data )
 {
     QDateTime newtime = QDateTime::fromTime_t( data->i_start );
     QString newname = qfu( data->psz_name );
@@ -164,11 +185,10 @@ bool EPGItem::setData( const vlc_epg_event_t *data )
     {
         m_start = newtime;
         m_name = newname;
-        setToolTip( newname );
         m_description = newdesc;
         m_shortDescription = newshortdesc;
-        setDuration( data->i_duration );
-        setRating( data->i_rating );
+        m_duration = data->i_duration;
+        m_rating = data->i_rating;
         m_descitems.clear();
         for( int i=0; i<data->i_description_items; i++ )
         {
@@ -176,40 +196,27 @@ bool EPGItem::setData( const vlc_epg_event_t *data )
                                   QString(data->description_items[i].psz_key),
                                   QString(data->description_items[i].psz_value)));
         }
-        updatePos();
-        prepareGeometryChange();
         return true;
     }
     return false;
 }
 
-bool EPGItem::endsBefore( const QDateTime &ref ) const
+bool EPGEvent::endsBefore( const QDateTime &ref ) const
 {
     return m_start.addSecs( m_duration ) < ref;
 }
 
-bool EPGItem::playsAt( const QDateTime & ref ) const
+bool EPGEvent::playsAt( const QDateTime & ref ) const
 {
     return (m_start <= ref) && !endsBefore( ref );
 }
 
-const QList<QPair<QString, QString>> & EPGItem::descriptionItems() const
+const QList<QPair<QString, QString>> & EPGEvent::descriptionItems() const
 {
     return m_descitems;
 }
 
-void EPGItem::setDuration( uint32_t duration )
-{
-    m_duration = duration;
-    m_boundingRect.setWidth( duration );
-}
-
-void EPGItem::setRating( uint8_t i_rating )
-{
-    m_rating = i_rating;
-}
-
-QString EPGItem::description() const
+QString EPGEvent::description() const
 {
     if( m_description.isEmpty() )
         return m_shortDescription;
@@ -223,9 +230,9 @@ QString EPGItem::description() const
 void EPGItem::updatePos()
 {
     QDateTime overallmin = m_view->startTime();
-    if( overallmin.isValid() )
+    if( overallmin.isValid() && m_event )
     {
-        int x = m_view->startTime().secsTo( m_start );
+        int x = m_view->startTime().secsTo( m_event->start() );
         setPos( x, program->getPosition() * TRACKS_HEIGHT );
     }
 }
@@ -249,6 +256,6 @@ void EPGItem::mouseDoubleClickEvent( QGraphicsSceneMouseEvent * )
 void EPGItem::focusInEvent( QFocusEvent * event )
 {
     event->accept();
-    m_view->focusItem( this );
+    m_view->focusItem( m_event );
     update();
 }
@@ -34,13 +34,11 @@ class QString;
 class EPGView;
 class EPGProgram;
 
-class EPGItem : public QGraphicsItem
+/* Data of an EPG event, kept for every event of every channel */
+class EPGEvent
 {
 public:
-    EPGItem( const vlc_epg_event_t *data, EPGView *view, EPGProgram * );
-
-    QRectF boundingRect() const Q_DECL_OVERRIDE;
-    void paint( QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0 ) Q_DECL_OVERRIDE;
+    explicit EPGEvent( const vlc_epg_event_t *data );
 
     const QDateTime& start() const;
     QDateTime end() const;
@@ -51,13 +49,36 @@ public:
     QString description() const;
     int rating() const { return m_rating; }
     bool setData( const vlc_epg_event_t * );
-    void setDuration( uint32_t duration );
-    void setRating( uint8_t i_rating );
-    void updatePos();
     bool endsBefore( const QDateTime & ) const;
     bool playsAt( const QDateTime & ) const;
     const QList<QPair<QString, QString>> &descriptionItems() const;
 
+private:
+    QDateTime   m_start;
+    uint32_t    m_duration;
+    uint16_t    m_id;
+    QString     m_name;
+    QString     m_description;
+    QString     m_shortDescription;
+    QList<QPair<QString, QString>> m_descitems;
+    uint8_t     m_rating;
+};
+
+/* Graphics item of a visible event, recycled by the view when the event
+ * gets out of sight */
+class EPGItem : public QGraphicsItem
+{
+public:
+    explicit EPGItem( EPGView *view );
+
+    QRectF boundingRect() const Q_DECL_OVERRIDE;
+    void paint( QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0 ) Q_DECL_OVERRIDE;
+
+    void bind( EPGProgram *, const EPGEvent * );
+    void refresh();
+    const EPGEvent *event() const { return m_event; }
+    void updatePos();
+
 protected:
     void focusInEvent( QFocusEvent * event ) Q_DECL_OVERRIDE;
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent * ) Q_DECL_OVERRIDE;
@@ -67,16 +88,8 @@ protected:
 private:
     EPGProgram *program;
     EPGView     *m_view;
+    const EPGEvent *m_event;
     QRectF      m_boundingRect;
-
-    QDateTime   m_start;
-    uint32_t    m_duration;
-    uint16_t    m_id;
-    QString     m_name;
-    QString     m_description;
-    QString     m_shortDescription;
-    QList<QPair<QString, QString>> m_descitems;
-    uint8_t     m_rating;
 };
 
 #endif // EPGITEM_H
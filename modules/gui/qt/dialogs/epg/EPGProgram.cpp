@@ -49,7 +49,7 @@ size_t EPGProgram::getPosition() const
     return pos;
 }
 
-const EPGItem * EPGProgram::getCurrent() const
+const EPGEvent * EPGProgram::getCurrent() const
 {
     return current;
 }
@@ -71,27 +71,23 @@ void EPGProgram::activate()
 
 void EPGProgram::pruneEvents( const QDateTime &date )
 {
-    QMap<QDateTime, const EPGItem *>::iterator it = eventsbytime.begin();
+    QMap<QDateTime, const EPGEvent *>::iterator it = eventsbytime.begin();
     for( ; it != eventsbytime.end(); )
     {
-        const EPGItem *item = *it;
-        if( item->endsBefore( date ) ) /* Expired item ? */
+        const EPGEvent *event = *it;
+        if( event->endsBefore( date ) ) /* Expired item ? */
         {
-            EPGItem *modifiableitem = eventsbyid.take( item->eventID() );
-            view->scene()->removeItem( modifiableitem );
-            delete modifiableitem;
+            EPGEvent *modifiableevent = eventsbyid.take( event->eventID() );
+            view->releaseEvent( modifiableevent );
+            if( current == modifiableevent )
+                current = NULL;
+            delete modifiableevent;
             it = eventsbytime.erase( it );
         }
         else break;
     }
 }
 
-void EPGProgram::updateEventPos()
-{
-    foreach( EPGItem *item, eventsbyid )
-        item->updatePos();
-}
-
 void EPGProgram::updateEvents( const vlc_epg_event_t * const * pp_events, size_t i_events,
                                const vlc_epg_event_t *p_current, QDateTime *mindate )
 {
@@ -102,39 +98,40 @@ void EPGProgram::updateEvents( const vlc_epg_event_t * const * pp_events, size_t
         if( !mindate->isValid() || eventStart < *mindate )
             *mindate = eventStart;
 
-        EPGItem *epgItem = NULL;
-        QHash<uint32_t, EPGItem *>::iterator it = eventsbyid.find( p_event->i_id );
+        EPGEvent *epgEvent = NULL;
+        QHash<uint32_t, EPGEvent *>::iterator it = eventsbyid.find( p_event->i_id );
         if ( it != eventsbyid.end() )
         {
-            epgItem = *it;
+            epgEvent = *it;
 
             /* Update our existing programs */
-            if( eventStart != epgItem->start() )
+            if( eventStart != epgEvent->start() )
             {
-                eventsbytime.remove( epgItem->start() );
-                eventsbytime.insert( eventStart, epgItem );
+                eventsbytime.remove( epgEvent->start() );
+                eventsbytime.insert( eventStart, epgEvent );
             }
 
-            epgItem->setData( p_event ); /* updates our entry */
+            /* updates our entry, and its item if visible */
+            if( epgEvent->setData( p_event ) )
+                view->updateEvent( epgEvent );
         }
         else if( !eventsbytime.contains( eventStart ) /* !Inconsistency */ )
         {
-            /* Insert a new program entry */
-            epgItem = new EPGItem( p_event, view, this );
+            /* Insert a new program entry, its item is only created by the
+             * view once visible */
+            epgEvent = new EPGEvent( p_event );
 
             /* Effectively insert our new program */
-            eventsbyid.insert( p_event->i_id, epgItem );
-            eventsbytime.insert( eventStart, epgItem );
-
-            view->scene()->addItem( epgItem );
+            eventsbyid.insert( p_event->i_id, epgEvent );
+            eventsbytime.insert( eventStart, epgEvent );
 
             /* First Insert, needs to focus by default then */
             if( !view->hasFocus() )
-                view->focusItem( epgItem );
+                view->focusItem( epgEvent );
         }
 
         if( p_current == p_event )
-            current = epgItem;
+            current = epgEvent;
     }
 }
 
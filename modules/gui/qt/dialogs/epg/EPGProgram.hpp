@@ -29,7 +29,7 @@
 #include <QDateTime>
 
 class EPGView;
-class EPGItem;
+class EPGEvent;
 
 class EPGProgram : public QObject
 {
@@ -42,19 +42,18 @@ class EPGProgram : public QObject
         void pruneEvents( const QDateTime & );
         void updateEvents( const vlc_epg_event_t * const *, size_t, const vlc_epg_event_t *,
                            QDateTime * );
-        void updateEventPos();
         size_t getPosition() const;
         void setPosition( size_t );
         void activate();
-        const EPGItem * getCurrent() const;
+        const EPGEvent * getCurrent() const;
         const QString & getName() const;
         static bool lessThan( const EPGProgram *, const EPGProgram * );
 
-        QHash<uint32_t, EPGItem *> eventsbyid;
-        QMap<QDateTime, const EPGItem *> eventsbytime;
+        QHash<uint32_t, EPGEvent *> eventsbyid;
+        QMap<QDateTime, const EPGEvent *> eventsbytime;
 
     private:
-        const EPGItem *current;
+        const EPGEvent *current;
         EPGView *view;
         size_t pos;
 
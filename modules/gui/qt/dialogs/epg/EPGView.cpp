@@ -31,6 +31,8 @@
 #include <QMatrix>
 #include <QPaintEvent>
 #include <QRectF>
+#include <QResizeEvent>
+#include <QSet>
 
 EPGGraphicsScene::EPGGraphicsScene( QObject *parent ) : QGraphicsScene( parent )
 {}
@@ -97,6 +99,7 @@ void EPGView::setScale( double scaleFactor )
     QMatrix matrix;
     matrix.scale( scaleFactor, 1 );
     setMatrix( matrix );
+    updateVisibleItems();
 }
 
 const QDateTime& EPGView::startTime() const
@@ -155,9 +158,14 @@ bool EPGView::updateEPG( const vlc_epg_t * const *pp_epg, size_t i_epg )
 void EPGView::reset()
 {
     /* clean our items storage and remove them from the scene */
+    qDeleteAll(m_items);
+    m_items.clear();
+    qDeleteAll(m_recycledItems);
+    m_recycledItems.clear();
     qDeleteAll(programs.values());
     programs.clear();
     m_startTime = m_maxTime = QDateTime();
+    scene()->setSceneRect( QRectF() );
 }
 
 void EPGView::walkItems( bool b_cleanup )
@@ -174,7 +182,7 @@ void EPGView::walkItems( bool b_cleanup )
 
         if( !program->eventsbytime.isEmpty() )
         {
-            const EPGItem *last = (program->eventsbytime.end() - 1).value();
+            const EPGEvent *last = (program->eventsbytime.end() - 1).value();
             if( !maxTime.isValid() ||
                  last->start().addSecs( last->duration() ) > maxTime )
             {
@@ -192,12 +200,113 @@ void EPGView::walkItems( bool b_cleanup )
     m_startTime = m_updtMinTime;
     m_maxTime = maxTime;
 
+    /* the items are not all in the scene, so it can't compute its size */
+    if( m_startTime.isValid() && m_maxTime.isValid() )
+        scene()->setSceneRect( 0, 0, m_startTime.secsTo( m_maxTime ),
+                               programs.count() * TRACKS_HEIGHT );
+
     if ( b_rangechanged )
     {
-        foreach( EPGProgram *program, programs )
-            program->updateEventPos();
+        foreach( EPGItem *item, m_items )
+            item->updatePos();
         emit rangeChanged( m_startTime, m_maxTime );
     }
+
+    updateVisibleItems();
+}
+
+void EPGView::updateVisibleItems()
+{
+    if( !m_startTime.isValid() )
+        return;
+
+    /* keep half a screen of margin, so that small scrolls only move items */
+    QRectF visible = mapToScene( viewport()->rect() ).boundingRect();
+    visible.adjust( -visible.width() / 2, -TRACKS_HEIGHT,
+                    visible.width() / 2, TRACKS_HEIGHT );
+    QDateTime from = m_startTime.addSecs( visible.left() );
+    QDateTime to = m_startTime.addSecs( visible.right() );
+
+    QSet<const EPGEvent *> visibleEvents;
+    foreach( EPGProgram *program, programs )
+    {
+        qreal y = program->getPosition() * TRACKS_HEIGHT;
+        if( y + TRACKS_HEIGHT < visible.top() || y > visible.bottom() )
+            continue;
+
+        QMap<QDateTime, const EPGEvent *>::const_iterator it =
+            program->eventsbytime.lowerBound( from );
+        /* the previous event may still be airing */
+        if( it != program->eventsbytime.constBegin() )
+            --it;
+        for( ; it != program->eventsbytime.constEnd() && it.key() <= to; ++it )
+        {
+            const EPGEvent *event = *it;
+            if( event->endsBefore( from ) )
+                continue;
+            visibleEvents.insert( event );
+            if( m_items.contains( event ) )
+                continue;
+
+            EPGItem *item;
+            if( !m_recycledItems.isEmpty() )
+            {
+                item = m_recycledItems.takeLast();
+                item->setVisible( true );
+            }
+            else
+            {
+                item = new EPGItem( this );
+                scene()->addItem( item );
+            }
+            item->bind( program, event );
+            m_items.insert( event, item );
+        }
+    }
+
+    QHash<const EPGEvent *, EPGItem *>::iterator it = m_items.begin();
+    while( it != m_items.end() )
+    {
+        if( !visibleEvents.contains( it.key() ) )
+        {
+            recycleItem( *it );
+            it = m_items.erase( it );
+        }
+        else
+            ++it;
+    }
+}
+
+void EPGView::recycleItem( EPGItem *item )
+{
+    item->setVisible( false );
+    m_recycledItems.append( item );
+}
+
+void EPGView::updateEvent( const EPGEvent *event )
+{
+    EPGItem *item = m_items.value( event );
+    if( item )
+        item->refresh();
+}
+
+void EPGView::releaseEvent( const EPGEvent *event )
+{
+    EPGItem *item = m_items.take( event );
+    if( item )
+        recycleItem( item );
+}
+
+void EPGView::scrollContentsBy( int dx, int dy )
+{
+    QGraphicsView::scrollContentsBy( dx, dy );
+    updateVisibleItems();
+}
+
+void EPGView::resizeEvent( QResizeEvent *event )
+{
+    QGraphicsView::resizeEvent( event );
+    updateVisibleItems();
 }
 
 void EPGView::cleanup()
@@ -210,9 +319,9 @@ EPGView::~EPGView()
     reset();
 }
 
-void EPGView::focusItem( EPGItem *epgItem )
+void EPGView::focusItem( const EPGEvent *event )
 {
-    emit itemFocused( epgItem );
+    emit itemFocused( event );
 }
 
 void EPGView::activateProgram( int id )
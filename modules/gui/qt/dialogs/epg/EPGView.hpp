@@ -36,6 +36,7 @@
 #include <QDateTime>
 
 class EPGItem;
+class EPGEvent;
 
 #define TRACKS_HEIGHT 60
 
@@ -68,14 +69,21 @@ public:
     bool            hasValidData() const;
     void            activateProgram( int );
 
+    void            updateEvent( const EPGEvent * );
+    void            releaseEvent( const EPGEvent * );
+
 signals:
     void            rangeChanged( const QDateTime&, const QDateTime& );
-    void            itemFocused( EPGItem * );
+    void            itemFocused( const EPGEvent * );
     void            programAdded( const EPGProgram * );
     void            programActivated( int );
 
 protected:
+    void            scrollContentsBy( int, int ) Q_DECL_OVERRIDE;
+    void            resizeEvent( QResizeEvent * ) Q_DECL_OVERRIDE;
+
     void            walkItems( bool );
+    void            updateVisibleItems();
     QDateTime       m_epgTime;
     QDateTime       m_startTime;
     QDateTime       m_maxTime;
@@ -84,10 +92,16 @@ protected:
     int             m_duration;
 
 public slots:
-    void            focusItem( EPGItem * );
+    void            focusItem( const EPGEvent * );
 
 private:
+    void            recycleItem( EPGItem * );
+
     QHash<uint16_t, EPGProgram*> programs;
+
+    /* Only the visible events have an item in the scene */
+    QHash<const EPGEvent *, EPGItem *> m_items;
+    QList<EPGItem *> m_recycledItems;
 };
 
 #endif // EPGVIEW_H
@@ -77,8 +77,8 @@ EPGWidget::EPGWidget( QWidget *parent ) : QWidget( parent )
              m_rulerWidget, setOffset(int) );
     CONNECT( m_epgView->verticalScrollBar(), valueChanged(int),
              m_channelsWidget, setOffset(int) );
-    connect( m_epgView, SIGNAL( itemFocused(EPGItem*)),
-             this, SIGNAL(itemSelectionChanged(EPGItem*)) );
+    connect( m_epgView, SIGNAL( itemFocused(const EPGEvent*)),
+             this, SIGNAL(itemSelectionChanged(const EPGEvent*)) );
     CONNECT( m_epgView, programAdded(const EPGProgram *), m_channelsWidget, addProgram(const EPGProgram *) );
     CONNECT( m_epgView, programActivated(int), this, activateProgram(int) );
 }
@@ -32,7 +32,7 @@
 #include <QStackedWidget>
 
 class EPGView;
-class EPGItem;
+class EPGEvent;
 class EPGRuler;
 class EPGChannels;
 
@@ -63,7 +63,7 @@ private:
     bool b_input_type_known;
 
 signals:
-    void itemSelectionChanged( EPGItem * );
+    void itemSelectionChanged( const EPGEvent * );
     void programActivated( int );
 };
 
@@ -75,7 +75,7 @@ EpgDialog::EpgDialog( intf_thread_t *_p_intf ): QVLCFrame( _p_intf )
     layout->addWidget( epg, 10 );
     layout->addWidget( descBox );
 
-    CONNECT( epg, itemSelectionChanged( EPGItem *), this, displayEvent( EPGItem *) );
+    CONNECT( epg, itemSelectionChanged( const EPGEvent *), this, displayEvent( const EPGEvent *) );
     CONNECT( epg, programActivated(int), THEMIM, changeProgram(int) );
     CONNECT( THEMIM, epgChanged(), this, scheduleUpdate() );
     CONNECT( THEMIM, inputChanged( bool ), this, inputChanged() );
@@ -132,7 +132,7 @@ void EpgDialog::scheduleUpdate()
         timer->start( 5000 );
 }
 
-void EpgDialog::displayEvent( EPGItem *epgItem )
+void EpgDialog::displayEvent( const EPGEvent *epgItem )
 {
     if( !epgItem )
     {
@@ -30,7 +30,7 @@
 class QLabel;
 class QTextEdit;
 class QTimer;
-class EPGItem;
+class EPGEvent;
 class EPGWidget;
 
 class EpgDialog : public QVLCFrame, public Singleton<EpgDialog>
@@ -55,7 +55,7 @@ private slots:
     void inputChanged();
     void updateInfos();
     void timeout();
-    void displayEvent( EPGItem * );
+    void displayEvent( const EPGEvent * );
 };
 
 #endif
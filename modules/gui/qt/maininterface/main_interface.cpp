@@ -35,6 +35,7 @@
 #include "widgets/native/customwidgets.hpp"               // qtEventToVLCKey, QVLCStackedWidget
 #include "util/qt_dirs.hpp"                     // toNativeSeparators
 #include "util/imagehelper.hpp"
+#include "util/artwork_provider.hpp"
 
 #include "widgets/native/interface_widgets.hpp"     // bgWidget, videoWidget
 #include "dialogs/firstrun/firstrun.hpp"                 // First Run
@@ -65,6 +66,7 @@
 #include "player/playercontrolbarmodel.hpp"
 
 #include "voutwindow/qvoutwindowdummy.hpp"
+#include "voutwindow/qvoutwindowgl.hpp"
 
 #include "util/qml_main_context.hpp"
 
@@ -100,6 +102,7 @@
 
 #include <QTimer>
 #include <QtQml/QQmlContext>
+#include <QtQml/QQmlEngine>
 #include <QtQuick/QQuickItem>
 
 
@@ -185,7 +188,10 @@ MainInterface::MainInterface( intf_thread_t *_p_intf ) : QVLCMW( _p_intf ),
 #endif
 
     // TODO: handle Wayland/X11/Win32 windows
-    m_videoRenderer.reset(new QVoutWindowDummy(this));
+    if (QOpenGLContext::supportsThreadedOpenGL())
+        m_videoRenderer.reset(new QVoutWindowGL(this));
+    else
+        m_videoRenderer.reset(new QVoutWindowDummy(this));
 
     /**************************
      *  UI and Widgets design
@@ -396,6 +402,10 @@ void MainInterface::createMainWidget( QSettings * )
     QmlMainContext* mainCtx = new QmlMainContext(p_intf, this, mediacenterView);
 
 
+    /* the engine takes the ownership of the provider */
+    mediacenterView->engine()->addImageProvider( QStringLiteral( "artwork" ),
+        new ArtworkImageProvider( var_InheritInteger( p_intf, "qt-artwork-cache-size" ) * 1024 ) );
+
     QQmlContext *rootCtx = mediacenterView->rootContext();
 
     rootCtx->setContextProperty( "history", navigation_history );
@@ -78,13 +78,13 @@ QHash<int, QByteArray> MLAlbumModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLAlbum>> MLAlbumModel::fetch( )
+std::vector<std::unique_ptr<MLAlbum>> MLAlbumModel::fetch(const vlc_ml_query_params_t& query)
 {
     ml_unique_ptr<vlc_ml_album_list_t> album_list;
     if ( m_parent.id <= 0 )
-        album_list.reset( vlc_ml_list_albums(m_ml, &m_query_param ) );
+        album_list.reset( vlc_ml_list_albums(m_ml, &query ) );
     else
-        album_list.reset( vlc_ml_list_albums_of(m_ml, &m_query_param, m_parent.type, m_parent.id ) );
+        album_list.reset( vlc_ml_list_albums_of(m_ml, &query, m_parent.type, m_parent.id ) );
     if ( album_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLAlbum>> res;
@@ -108,9 +108,13 @@ void MLAlbumModel::onVlcMlEvent(const vlc_ml_event_t* event)
     switch( event->i_type )
     {
         case VLC_ML_EVENT_ALBUM_ADDED:
+            onEntityAdded();
+            break;
         case VLC_ML_EVENT_ALBUM_DELETED:
+            onEntityDeleted( event->deletion.i_entity_id );
+            break;
         case VLC_ML_EVENT_ALBUM_UPDATED:
-            m_need_reset = true;
+            onEntityUpdated( event->modification.i_entity_id );
             break;
         case VLC_ML_EVENT_ARTIST_DELETED:
             if ( m_parent.id != 0 && m_parent.type == VLC_ML_PARENT_ARTIST &&
@@ -150,9 +154,9 @@ vlc_ml_sorting_criteria_t MLAlbumModel::roleToCriteria(int role) const
     }
 }
 
-size_t MLAlbumModel::countTotalElements() const
+size_t MLAlbumModel::countTotalElements(const vlc_ml_query_params_t& query) const
 {
-    auto queryParams = m_query_param;
+    auto queryParams = query;
     queryParams.i_offset = 0;
     queryParams.i_nbResults = 0;
     if ( m_parent.id <= 0 )
@@ -54,8 +54,8 @@ public:
     Q_INVOKABLE QHash<int, QByteArray> roleNames() const override;
 
 private:
-    std::vector<std::unique_ptr<MLAlbum>> fetch() override;
-    size_t countTotalElements() const override;
+    std::vector<std::unique_ptr<MLAlbum>> fetch(const vlc_ml_query_params_t& query) override;
+    size_t countTotalElements(const vlc_ml_query_params_t& query) const override;
     vlc_ml_sorting_criteria_t roleToCriteria(int role) const override;
     vlc_ml_sorting_criteria_t nameToCriteria(QByteArray name) const override;
     QByteArray criteriaToName(vlc_ml_sorting_criteria_t criteria) const override;
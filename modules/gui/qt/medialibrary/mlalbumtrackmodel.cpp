@@ -108,9 +108,9 @@ QHash<int, QByteArray> MLAlbumTrackModel::roleNames() const
     };
 }
 
-size_t MLAlbumTrackModel::countTotalElements() const
+size_t MLAlbumTrackModel::countTotalElements(const vlc_ml_query_params_t& query) const
 {
-    auto queryParams = m_query_param;
+    auto queryParams = query;
     queryParams.i_offset = 0;
     queryParams.i_nbResults = 0;
     if ( m_parent.id <= 0 )
@@ -118,14 +118,14 @@ size_t MLAlbumTrackModel::countTotalElements() const
     return vlc_ml_count_media_of(m_ml, &queryParams, m_parent.type, m_parent.id );
 }
 
-std::vector<std::unique_ptr<MLAlbumTrack>> MLAlbumTrackModel::fetch()
+std::vector<std::unique_ptr<MLAlbumTrack>> MLAlbumTrackModel::fetch(const vlc_ml_query_params_t& query)
 {
     ml_unique_ptr<vlc_ml_media_list_t> media_list;
 
     if ( m_parent.id <= 0 )
-        media_list.reset( vlc_ml_list_audio_media(m_ml, &m_query_param) );
+        media_list.reset( vlc_ml_list_audio_media(m_ml, &query) );
     else
-        media_list.reset( vlc_ml_list_media_of(m_ml, &m_query_param, m_parent.type, m_parent.id ) );
+        media_list.reset( vlc_ml_list_media_of(m_ml, &query, m_parent.type, m_parent.id ) );
     if ( media_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLAlbumTrack>> res;
@@ -164,13 +164,13 @@ void MLAlbumTrackModel::onVlcMlEvent(const vlc_ml_event_t* event)
     {
         case VLC_ML_EVENT_MEDIA_ADDED:
             if ( event->creation.p_media->i_subtype == VLC_ML_MEDIA_SUBTYPE_ALBUMTRACK )
-                m_need_reset = true;
+                onEntityAdded();
             break;
         case VLC_ML_EVENT_MEDIA_UPDATED:
+            onEntityUpdated( event->modification.i_entity_id );
+            break;
         case VLC_ML_EVENT_MEDIA_DELETED:
-            // FIXME: Not optimal, this will trigger a clean/refresh for video
-            // media as well, but this needs fixing in the medialibrary
-            m_need_reset = true;
+            onEntityDeleted( event->deletion.i_entity_id );
             break;
         case VLC_ML_EVENT_ALBUM_UPDATED:
             if ( m_parent.id != 0 && m_parent.type == VLC_ML_PARENT_ALBUM &&
@@ -75,13 +75,13 @@ QHash<int, QByteArray> MLArtistModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLArtist>> MLArtistModel::fetch()
+std::vector<std::unique_ptr<MLArtist>> MLArtistModel::fetch(const vlc_ml_query_params_t& query)
 {
     ml_unique_ptr<vlc_ml_artist_list_t> artist_list;
     if ( m_parent.id <= 0 )
-        artist_list.reset( vlc_ml_list_artists(m_ml, &m_query_param, false) );
+        artist_list.reset( vlc_ml_list_artists(m_ml, &query, false) );
     else
-        artist_list.reset( vlc_ml_list_artist_of(m_ml, &m_query_param, m_parent.type, m_parent.id) );
+        artist_list.reset( vlc_ml_list_artist_of(m_ml, &query, m_parent.type, m_parent.id) );
     if ( artist_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLArtist>> res;
@@ -90,9 +90,9 @@ std::vector<std::unique_ptr<MLArtist>> MLArtistModel::fetch()
     return res;
 }
 
-size_t MLArtistModel::countTotalElements() const
+size_t MLArtistModel::countTotalElements(const vlc_ml_query_params_t& query) const
 {
-    auto queryParams = m_query_param;
+    auto queryParams = query;
     queryParams.i_offset = 0;
     queryParams.i_nbResults = 0;
 
@@ -127,9 +127,13 @@ void MLArtistModel::onVlcMlEvent(const vlc_ml_event_t* event)
     switch (event->i_type)
     {
         case VLC_ML_EVENT_ARTIST_ADDED:
+            onEntityAdded();
+            break;
         case VLC_ML_EVENT_ARTIST_UPDATED:
+            onEntityUpdated( event->modification.i_entity_id );
+            break;
         case VLC_ML_EVENT_ARTIST_DELETED:
-            m_need_reset = true;
+            onEntityDeleted( event->deletion.i_entity_id );
             break;
         case VLC_ML_EVENT_GENRE_DELETED:
             if ( m_parent.id != 0 && m_parent.type == VLC_ML_PARENT_GENRE &&
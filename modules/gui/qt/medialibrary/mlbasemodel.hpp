@@ -24,9 +24,19 @@
 #endif
 #include "vlc_common.h"
 
+#include <algorithm>
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 #include <QObject>
 #include <QAbstractListModel>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
 #include "vlc_media_library.h"
 #include "mlqmltypes.hpp"
 #include "medialib.hpp"
@@ -111,43 +121,92 @@ protected:
     std::atomic_bool m_is_reloading;
 };
 
+/**
+ * Runs a function on a QThreadPool, the functor overload of
+ * QThreadPool::start() needing Qt 5.15
+ */
+class MLFetchTask : public QRunnable
+{
+public:
+    explicit MLFetchTask(std::function<void()> fun)
+        : m_fun(std::move(fun))
+    {
+    }
+
+    void run() override
+    {
+        m_fun();
+    }
+
+private:
+    std::function<void()> m_fun;
+};
+
 /**
  * Implements a basic sliding window.
  * const_cast & immutable are unavoidable, since all access member functions
  * are marked as const. fetchMore & canFetchMore don't allow for the full size
  * to be known (so the scrollbar would grow as we scroll, until we displayed all
  * elements), and implies having all elements loaded in RAM at all time.
+ *
+ * The windows are fetched on a worker thread, never from the GUI thread:
+ * rows of a window not loaded yet have no data (placeholders) until the
+ * fetch completes and dataChanged is emitted. A few windows are cached, and
+ * the next ones in the scroll direction are read ahead.
+ *
+ * Medialibrary events are not handled by resetting the model: they are
+ * accumulated and applied at most once per frame, removing the deleted rows
+ * which are cached, refreshing the cached windows and adjusting the row count.
  */
 template <typename T>
 class MLSlidingWindowModel : public MLBaseModel
 {
 public:
     static constexpr size_t BatchSize = 100;
+    static constexpr size_t CachedWindows = 6;
+    static constexpr size_t ReadAheadWindows = 2;
+    /* Events are applied in batches, at most once per frame */
+    static constexpr int UpdateIntervalMs = 16;
 
     MLSlidingWindowModel(QObject* parent = nullptr)
         : MLBaseModel(parent)
         , m_initialized(false)
+        , m_init_pending(false)
+        , m_total_count(0)
+        , m_generation(0)
+        , m_use_clock(0)
+        , m_last_offset(0)
+        , m_entity_added(false)
+        , m_update_scheduled(false)
     {
         m_query_param.i_nbResults = BatchSize;
+        /* one worker: fetches are served in request order */
+        m_fetch_pool.setMaxThreadCount(1);
+
+        m_update_timer.setSingleShot(true);
+        m_update_timer.setInterval(UpdateIntervalMs);
+        QObject::connect(&m_update_timer, &QTimer::timeout, this, [this]() {
+            applyUpdates();
+        });
+    }
+
+    virtual ~MLSlidingWindowModel()
+    {
+        m_fetch_pool.clear();
+        m_fetch_pool.waitForDone();
     }
 
     int rowCount(const QModelIndex &parent) const override
     {
         if (parent.isValid())
             return 0;
-        vlc_mutex_locker lock( &m_item_lock );
         if ( m_initialized == false )
-        {
-            m_item_list = const_cast<MLSlidingWindowModel<T>*>(this)->fetch();
-            m_total_count = countTotalElements();
-            m_initialized = true;
-        }
+            const_cast<MLSlidingWindowModel<T>*>(this)->requestInit();
         return m_total_count;
     }
 
     virtual T* get(unsigned int idx) const
     {
-        vlc_mutex_locker lock( &m_item_lock );
         T* obj = item( idx );
         if (!obj)
             return nullptr;
@@ -159,38 +218,64 @@ public:
         vlc_mutex_locker lock( &m_item_lock );
         m_query_param.i_offset = 0;
         m_initialized = false;
+        m_init_pending = false;
         m_total_count = 0;
-        m_item_list.clear();
+        m_windows.clear();
+        m_pending.clear();
+        m_last_offset = 0;
+        /* the model is reloaded, no need to apply the pending events */
+        m_entity_added = false;
+        m_updated_ids.clear();
+        m_deleted_ids.clear();
+        /* results of the fetches in flight are now stale */
+        m_generation++;
     }
 
 protected:
     T* item(unsigned int idx) const
     {
-        // Must be called in a locked context
+        // Must be called from the GUI thread, the only one modifying the cache
+        auto self = const_cast<MLSlidingWindowModel<T>*>(this);
+
         if ( m_initialized == false )
         {
-            m_total_count = countTotalElements();
-            if ( m_total_count > 0 )
-                m_item_list = const_cast<MLSlidingWindowModel<T>*>(this)->fetch();
-            m_initialized = true;
+            self->requestInit();
+            return nullptr;
         }
 
-        if ( m_total_count == 0 || idx >= m_total_count || idx < 0 )
+        if ( m_total_count == 0 || idx >= m_total_count )
             return nullptr;
 
-        if ( idx < m_query_param.i_offset ||  idx >= m_query_param.i_offset + m_item_list.size() )
+        size_t offset = idx - idx % BatchSize;
+        if ( offset != m_last_offset )
         {
-            if (m_query_param.i_nbResults == 0)
-                m_query_param.i_offset = 0;
-            else
-                m_query_param.i_offset = idx - idx % m_query_param.i_nbResults;
-            m_item_list = const_cast<MLSlidingWindowModel<T>*>(this)->fetch();
+            /* read ahead in the scroll direction */
+            bool forward = offset > m_last_offset;
+            for ( size_t i = 1; i <= ReadAheadWindows; i++ )
+            {
+                if ( !forward && offset < i * BatchSize )
+                    break;
+                size_t next = forward ? offset + i * BatchSize
+                                      : offset - i * BatchSize;
+                if ( next >= m_total_count )
+                    break;
+                self->requestWindow( next );
+            }
+            m_last_offset = offset;
+        }
+
+        auto it = m_windows.find( offset );
+        if ( it == m_windows.end() )
+        {
+            self->requestWindow( offset );
+            return nullptr;
         }
+        it->second.last_use = ++m_use_clock;
 
         //db has changed
-        if ( idx - m_query_param.i_offset >= m_item_list.size() || idx - m_query_param.i_offset < 0 )
+        if ( idx - offset >= it->second.items.size() )
             return nullptr;
-        return m_item_list[idx - m_query_param.i_offset].get();
+        return it->second.items[idx - offset].get();
     }
 
     virtual void onVlcMlEvent(const vlc_ml_event_t* event) override
@@ -200,13 +285,16 @@ protected:
             case VLC_ML_EVENT_MEDIA_THUMBNAIL_GENERATED:
             {
                 if (event->media_thumbnail_generated.b_success) {
-                    int idx = static_cast<int>(m_query_param.i_offset);
-                    for ( const auto& it : m_item_list ) {
-                        if (it->getId().id == event->media_thumbnail_generated.p_media->i_id) {
-                            thumbnailUpdated(idx);
-                            break;
+                    vlc_mutex_locker lock( &m_item_lock );
+                    for ( const auto& window : m_windows ) {
+                        int idx = static_cast<int>(window.first);
+                        for ( const auto& it : window.second.items ) {
+                            if (it->getId().id == event->media_thumbnail_generated.p_media->i_id) {
+                                thumbnailUpdated(idx);
+                                break;
+                            }
+                            idx += 1;
                         }
-                        idx += 1;
                     }
                 }
                 break;
@@ -217,17 +305,316 @@ protected:
         MLBaseModel::onVlcMlEvent( event );
     }
 
-private:
-    virtual size_t countTotalElements() const = 0;
-    virtual std::vector<std::unique_ptr<T>> fetch() = 0;
-    virtual void thumbnailUpdated( int ) {}
+    /* Called from the medialibrary thread by the derived models, for the
+     * events about the entities they list */
+    void onEntityAdded()
+    {
+        vlc_mutex_locker lock( &m_item_lock );
+        m_entity_added = true;
+        scheduleUpdate();
+    }
 
-protected:
-    mutable std::vector<std::unique_ptr<T>> m_item_list;
+    void onEntityUpdated(int64_t id)
+    {
+        vlc_mutex_locker lock( &m_item_lock );
+        m_updated_ids.insert( id );
+        scheduleUpdate();
+    }
+
+    void onEntityDeleted(int64_t id)
+    {
+        vlc_mutex_locker lock( &m_item_lock );
+        m_updated_ids.erase( id );
+        m_deleted_ids.insert( id );
+        scheduleUpdate();
+    }
 
 private:
-    mutable bool m_initialized;
-    mutable size_t m_total_count;
+    using ItemList = std::vector<std::unique_ptr<T>>;
+
+    struct Window
+    {
+        ItemList items;
+        uint64_t last_use;
+    };
+
+    /* Snapshot of the query for the worker, the pattern being owned by the
+     * model and replaced from the GUI thread */
+    std::function<vlc_ml_query_params_t()> makeQuery(size_t offset, size_t count) const
+    {
+        vlc_ml_query_params_t query = m_query_param;
+        std::string pattern = query.psz_pattern ? query.psz_pattern : "";
+        bool has_pattern = query.psz_pattern != nullptr;
+        query.i_offset = offset;
+        query.i_nbResults = count;
+        auto storage = std::make_shared<std::string>( std::move( pattern ) );
+        return [query, storage, has_pattern]() mutable {
+            query.psz_pattern = has_pattern ? storage->c_str() : nullptr;
+            return query;
+        };
+    }
+
+    void requestInit()
+    {
+        if ( m_init_pending )
+            return;
+        m_init_pending = true;
+
+        auto query = makeQuery( 0, BatchSize );
+        uint64_t generation = m_generation;
+        m_fetch_pool.start( new MLFetchTask( [this, query, generation]() mutable {
+            vlc_ml_query_params_t params = query();
+            auto items = std::make_shared<ItemList>( fetch( params ) );
+            size_t count = items->empty() ? 0 : countTotalElements( params );
+            QMetaObject::invokeMethod( this, [this, generation, count, items]() {
+                onInitFetched( generation, count, std::move( *items ) );
+            }, Qt::QueuedConnection );
+        } ) );
+    }
+
+    void requestWindow(size_t offset)
+    {
+        if ( m_windows.count( offset ) || m_pending.count( offset ) )
+            return;
+        m_pending.insert( offset );
+
+        auto query = makeQuery( offset, BatchSize );
+        uint64_t generation = m_generation;
+        m_fetch_pool.start( new MLFetchTask( [this, query, generation, offset]() mutable {
+            vlc_ml_query_params_t params = query();
+            auto items = std::make_shared<ItemList>( fetch( params ) );
+            QMetaObject::invokeMethod( this, [this, generation, offset, items]() {
+                onWindowFetched( generation, offset, std::move( *items ) );
+            }, Qt::QueuedConnection );
+        } ) );
+    }
+
+    void insertWindow(size_t offset, ItemList items)
+    {
+        vlc_mutex_locker lock( &m_item_lock );
+        m_windows[offset] = Window{ std::move( items ), ++m_use_clock };
+        while ( m_windows.size() > CachedWindows )
+        {
+            auto lru = m_windows.begin();
+            for ( auto it = m_windows.begin(); it != m_windows.end(); ++it )
+                if ( it->second.last_use < lru->second.last_use )
+                    lru = it;
+            m_windows.erase( lru );
+        }
+    }
+
+    void onInitFetched(uint64_t generation, size_t count, ItemList items)
+    {
+        if ( generation != m_generation )
+            return;
+        m_init_pending = false;
+
+        if ( count == 0 )
+        {
+            m_initialized = true;
+            return;
+        }
+        beginInsertRows( QModelIndex(), 0, static_cast<int>( count ) - 1 );
+        m_total_count = count;
+        m_initialized = true;
+        insertWindow( 0, std::move( items ) );
+        endInsertRows();
+    }
+
+    void onWindowFetched(uint64_t generation, size_t offset, ItemList items)
+    {
+        if ( generation != m_generation )
+            return;
+        m_pending.erase( offset );
+        if ( items.empty() )
+            return;
+        size_t last = std::min( offset + items.size(), m_total_count );
+        insertWindow( offset, std::move( items ) );
+        if ( last > offset )
+            emit dataChanged( index( static_cast<int>( offset ) ),
+                              index( static_cast<int>( last ) - 1 ) );
+    }
+
+    /* Must be called with m_item_lock held */
+    void scheduleUpdate()
+    {
+        if ( m_update_scheduled )
+            return;
+        m_update_scheduled = true;
+        /* the timer lives in the GUI thread */
+        QMetaObject::invokeMethod( this, [this]() {
+            m_update_timer.start();
+        }, Qt::QueuedConnection );
+    }
+
+    /* Returns the row of a cached entity, or -1 */
+    int findCachedRow(int64_t id) const
+    {
+        for ( const auto& window : m_windows )
+        {
+            const ItemList& items = window.second.items;
+            for ( size_t i = 0; i < items.size(); i++ )
+                if ( items[i]->getId().id == id )
+                    return static_cast<int>( window.first + i );
+        }
+        return -1;
+    }
+
+    void applyUpdates()
+    {
+        std::set<int64_t> updated;
+        std::set<int64_t> deleted;
+        bool added;
+        {
+            vlc_mutex_locker lock( &m_item_lock );
+            updated.swap( m_updated_ids );
+            deleted.swap( m_deleted_ids );
+            added = m_entity_added;
+            m_entity_added = false;
+            m_update_scheduled = false;
+        }
+
+        /* nothing loaded yet: the first fetch will see the changes */
+        if ( m_initialized == false )
+            return;
+
+        /* the deleted entities outside of the cache, and the added ones,
+         * have an unknown position: the count has to be fetched again */
+        bool recount = added;
+        for ( int64_t id : deleted )
+        {
+            int row = findCachedRow( id );
+            if ( row < 0 )
+            {
+                recount = true;
+                continue;
+            }
+            beginRemoveRows( QModelIndex(), row, row );
+            {
+                vlc_mutex_locker lock( &m_item_lock );
+                auto it = m_windows.upper_bound( static_cast<size_t>( row ) );
+                --it;
+                ItemList& items = it->second.items;
+                items.erase( items.begin() + ( row - it->first ) );
+            }
+            m_total_count--;
+            endRemoveRows();
+            /* the following cached rows are now shifted */
+            recount = true;
+        }
+
+        std::vector<size_t> offsets;
+        for ( const auto& window : m_windows )
+        {
+            if ( recount )
+            {
+                offsets.push_back( window.first );
+                continue;
+            }
+            for ( const auto& item : window.second.items )
+            {
+                if ( updated.count( item->getId().id ) )
+                {
+                    offsets.push_back( window.first );
+                    break;
+                }
+            }
+        }
+        if ( recount == false && offsets.empty() )
+            return;
+        requestRefresh( recount, offsets );
+    }
+
+    void requestRefresh(bool recount, const std::vector<size_t>& offsets)
+    {
+        std::vector<std::pair<size_t, std::function<vlc_ml_query_params_t()>>> queries;
+        for ( size_t offset : offsets )
+            queries.emplace_back( offset, makeQuery( offset, BatchSize ) );
+        auto count_query = makeQuery( 0, BatchSize );
+        uint64_t generation = m_generation;
+        m_fetch_pool.start( new MLFetchTask( [this, queries, count_query, recount, generation]() mutable {
+            using Windows = std::vector<std::pair<size_t, ItemList>>;
+            auto windows = std::make_shared<Windows>();
+            for ( auto& query : queries )
+            {
+                vlc_ml_query_params_t params = query.second();
+                windows->emplace_back( query.first, fetch( params ) );
+            }
+            ssize_t count = -1;
+            if ( recount )
+                count = countTotalElements( count_query() );
+            QMetaObject::invokeMethod( this, [this, generation, count, windows]() {
+                onRefreshFetched( generation, count, *windows );
+            }, Qt::QueuedConnection );
+        } ) );
+    }
+
+    void onRefreshFetched(uint64_t generation, ssize_t count,
+                          std::vector<std::pair<size_t, ItemList>>& windows)
+    {
+        if ( generation != m_generation )
+            return;
+
+        if ( count >= 0 && static_cast<size_t>( count ) > m_total_count )
+        {
+            beginInsertRows( QModelIndex(), static_cast<int>( m_total_count ),
+                             static_cast<int>( count ) - 1 );
+            m_total_count = count;
+            endInsertRows();
+        }
+        else if ( count >= 0 && static_cast<size_t>( count ) < m_total_count )
+        {
+            beginRemoveRows( QModelIndex(), static_cast<int>( count ),
+                             static_cast<int>( m_total_count ) - 1 );
+            m_total_count = count;
+            {
+                vlc_mutex_locker lock( &m_item_lock );
+                m_windows.erase( m_windows.lower_bound( m_total_count ),
+                                 m_windows.end() );
+            }
+            endRemoveRows();
+        }
+
+        for ( auto& window : windows )
+        {
+            size_t offset = window.first;
+            if ( offset >= m_total_count )
+                continue;
+            size_t last = std::min( offset + BatchSize, m_total_count );
+            if ( window.second.empty() )
+            {
+                vlc_mutex_locker lock( &m_item_lock );
+                m_windows.erase( offset );
+            }
+            else
+                insertWindow( offset, std::move( window.second ) );
+            emit dataChanged( index( static_cast<int>( offset ) ),
+                              index( static_cast<int>( last ) - 1 ) );
+        }
+    }
+
+    /* Called from the worker thread, with a query snapshot */
+    virtual size_t countTotalElements(const vlc_ml_query_params_t& query) const = 0;
+    virtual ItemList fetch(const vlc_ml_query_params_t& query) = 0;
+    virtual void thumbnailUpdated( int ) {}
+
+    /* The cache is only modified from the GUI thread, under m_item_lock
+     * for the readers from other threads */
+    mutable std::map<size_t, Window> m_windows;
+    std::set<size_t> m_pending;
+    bool m_initialized;
+    bool m_init_pending;
+    size_t m_total_count;
+    uint64_t m_generation;
+    mutable uint64_t m_use_clock;
+    mutable size_t m_last_offset;
+    /* Events not applied yet, protected by m_item_lock */
+    bool m_entity_added;
+    std::set<int64_t> m_updated_ids;
+    std::set<int64_t> m_deleted_ids;
+    bool m_update_scheduled;
+    QTimer m_update_timer;
+    QThreadPool m_fetch_pool;
 };
 
 #endif // MLBASEMODEL_HPP
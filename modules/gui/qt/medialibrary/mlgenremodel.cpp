@@ -80,10 +80,10 @@ QHash<int, QByteArray> MLGenreModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLGenre>> MLGenreModel::fetch()
+std::vector<std::unique_ptr<MLGenre>> MLGenreModel::fetch(const vlc_ml_query_params_t& query)
 {
     ml_unique_ptr<vlc_ml_genre_list_t> genre_list(
-        vlc_ml_list_genres(m_ml, &m_query_param)
+        vlc_ml_list_genres(m_ml, &query)
     );
     if ( genre_list == nullptr )
         return {};
@@ -93,9 +93,9 @@ std::vector<std::unique_ptr<MLGenre>> MLGenreModel::fetch()
     return res;
 }
 
-size_t MLGenreModel::countTotalElements() const
+size_t MLGenreModel::countTotalElements(const vlc_ml_query_params_t& query) const
 {
-    auto queryParams = m_query_param;
+    auto queryParams = query;
     queryParams.i_offset = 0;
     queryParams.i_nbResults = 0;
     return vlc_ml_count_genres( m_ml, &queryParams );
@@ -106,9 +106,13 @@ void MLGenreModel::onVlcMlEvent(const vlc_ml_event_t* event)
     switch (event->i_type)
     {
         case VLC_ML_EVENT_GENRE_ADDED:
+            onEntityAdded();
+            break;
         case VLC_ML_EVENT_GENRE_UPDATED:
+            onEntityUpdated( event->modification.i_entity_id );
+            break;
         case VLC_ML_EVENT_GENRE_DELETED:
-            m_need_reset = true;
+            onEntityDeleted( event->deletion.i_entity_id );
             break;
     }
     MLSlidingWindowModel::onVlcMlEvent(event);
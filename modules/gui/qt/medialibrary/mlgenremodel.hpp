@@ -40,8 +40,8 @@ public:
     QVariant data(const QModelIndex &index, int role) const override;
 
 private:
-    std::vector<std::unique_ptr<MLGenre>> fetch() override;
-    size_t countTotalElements() const override;
+    std::vector<std::unique_ptr<MLGenre>> fetch(const vlc_ml_query_params_t& query) override;
+    size_t countTotalElements(const vlc_ml_query_params_t& query) const override;
     void onVlcMlEvent(const vlc_ml_event_t* event) override;
     void thumbnailUpdated(int idx) override;
     vlc_ml_sorting_criteria_t roleToCriteria(int role) const override;
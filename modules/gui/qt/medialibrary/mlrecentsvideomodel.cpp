@@ -92,10 +92,10 @@ QHash<int, QByteArray> MLRecentsVideoModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLVideo> > MLRecentsVideoModel::fetch()
+std::vector<std::unique_ptr<MLVideo> > MLRecentsVideoModel::fetch(const vlc_ml_query_params_t& query)
 {
     ml_unique_ptr<vlc_ml_media_list_t> media_list{ vlc_ml_list_history(
-                m_ml, &m_query_param ) };
+                m_ml, &query ) };
     if ( media_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLVideo>> res;
@@ -109,7 +109,7 @@ std::vector<std::unique_ptr<MLVideo> > MLRecentsVideoModel::fetch()
     return res;
 }
 
-size_t MLRecentsVideoModel::countTotalElements() const
+size_t MLRecentsVideoModel::countTotalElements(const vlc_ml_query_params_t&) const
 {
 
     if(numberOfItemsToShow == -1){
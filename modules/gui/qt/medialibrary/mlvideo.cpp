@@ -128,7 +128,20 @@ MLVideo::MLVideo(const MLVideo& video, QObject* parent)
     , m_mrl( video.m_mrl )
     , m_progress( video.m_progress )
     , m_playCount( video.m_playCount )
+    , m_thumbnailGenerated( video.m_thumbnailGenerated )
+    , m_ml_event_handle( nullptr, [this](vlc_ml_event_callback_t* cb ) {
+        assert( m_ml != nullptr );
+        vlc_ml_event_unregister_callback( m_ml, cb );
+    })
+{
+}
+
+MLVideo::~MLVideo()
 {
+    /* Not displayed anymore, don't delay the thumbnails of the visible
+     * media with this one */
+    if ( m_ml_event_handle != nullptr && m_thumbnailGenerated == false )
+        vlc_ml_media_cancel_thumbnail( m_ml, m_id.id, VLC_ML_THUMBNAIL_SMALL );
 }
 
 void MLVideo::onMlEvent( void* data, const vlc_ml_event_t* event )
@@ -52,6 +52,7 @@ class MLVideo : public QObject
 
 public:
     MLVideo(vlc_medialibrary_t *ml, const vlc_ml_media_t *data, QObject *parent = nullptr);
+    ~MLVideo();
 
     MLParentId getId() const;
     QString getTitle() const;
@@ -109,10 +109,10 @@ QHash<int, QByteArray> MLVideoModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLVideo> > MLVideoModel::fetch()
+std::vector<std::unique_ptr<MLVideo> > MLVideoModel::fetch(const vlc_ml_query_params_t& query)
 {
     ml_unique_ptr<vlc_ml_media_list_t> media_list{ vlc_ml_list_video_media(
-                m_ml, &m_query_param ) };
+                m_ml, &query ) };
     if ( media_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLVideo>> res;
@@ -121,9 +121,9 @@ std::vector<std::unique_ptr<MLVideo> > MLVideoModel::fetch()
     return res;
 }
 
-size_t MLVideoModel::countTotalElements() const
+size_t MLVideoModel::countTotalElements(const vlc_ml_query_params_t& query) const
 {
-    vlc_ml_query_params_t params = m_query_param;
+    vlc_ml_query_params_t params = query;
     params.i_offset = 0;
     params.i_nbResults = 0;
     return vlc_ml_count_video_media(m_ml, &params);
@@ -159,9 +159,14 @@ void MLVideoModel::onVlcMlEvent(const vlc_ml_event_t* event)
     switch (event->i_type)
     {
         case VLC_ML_EVENT_MEDIA_ADDED:
+            if ( event->creation.p_media->i_type == VLC_ML_MEDIA_TYPE_VIDEO )
+                onEntityAdded();
+            break;
         case VLC_ML_EVENT_MEDIA_UPDATED:
+            onEntityUpdated( event->modification.i_entity_id );
+            break;
         case VLC_ML_EVENT_MEDIA_DELETED:
-            m_need_reset = true;
+            onEntityDeleted( event->deletion.i_entity_id );
             break;
         default:
             break;
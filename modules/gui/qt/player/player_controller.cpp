@@ -37,6 +37,8 @@
 #include <QDir>
 #include <QSignalMapper>
 #include <QMessageBox>
+#include <QGuiApplication>
+#include <QScreen>
 
 #include <assert.h>
 
@@ -216,6 +218,121 @@ void PlayerControllerPrivate::UpdateSpuOrder(vlc_es_id_t *es_id, enum vlc_vout_o
     }
 }
 
+void PlayerControllerPrivate::requestFlush(unsigned pending)
+{
+    vlc_mutex_assert( &m_pending_lock );
+    m_pending |= pending;
+    if ( m_flush_scheduled )
+        return;
+    m_flush_scheduled = true;
+    // The timer must be started from its thread
+    callAsync([this](){
+        if ( !m_flush_timer.isActive() )
+            m_flush_timer.start();
+    });
+}
+
+void PlayerControllerPrivate::flushPendingUpdates()
+{
+    Q_Q(PlayerController);
+    unsigned pending;
+    struct vlc_player_timer_point time;
+    vlc_tick_t discontinuity;
+    float buffering;
+    struct input_stats_t stats;
+    {
+        vlc_mutex_locker locker( &m_pending_lock );
+        pending = m_pending;
+        time = m_pending_time;
+        discontinuity = m_pending_discontinuity;
+        buffering = m_pending_buffering;
+        stats = m_pending_stats;
+        m_pending = 0;
+        m_flush_scheduled = false;
+    }
+
+    if ( pending & PENDING_DISCONTINUITY )
+        applyTimerDiscontinuity( discontinuity );
+    if ( pending & PENDING_TIME )
+        applyTimerUpdate( time );
+    if ( ( pending & PENDING_BUFFERING ) && m_buffering != buffering )
+    {
+        m_buffering = buffering;
+        emit q->bufferingChanged( m_buffering );
+    }
+    if ( pending & PENDING_STATS )
+    {
+        m_stats = stats;
+        emit q->statisticsUpdated( m_stats );
+    }
+}
+
+void PlayerControllerPrivate::applyTimerUpdate(const struct vlc_player_timer_point& point)
+{
+    Q_Q(PlayerController);
+
+    m_player_time = point;
+    bool lengthOrRateChanged = false;
+
+    if (m_length != m_player_time.length)
+    {
+        m_length = m_player_time.length;
+        emit q->lengthChanged(m_length);
+
+        lengthOrRateChanged = true;
+    }
+    if (m_rate != m_player_time.rate)
+    {
+        m_rate = m_player_time.rate;
+        emit q->rateChanged(m_rate);
+
+        lengthOrRateChanged = true;
+    }
+
+    vlc_tick_t system_now = vlc_tick_now();
+    if (interpolateTime(system_now) == VLC_SUCCESS)
+    {
+        if (lengthOrRateChanged || !m_position_timer.isActive())
+        {
+            q->updatePosition();
+
+            if (m_player_time.system_date != INT64_MAX)
+            {
+                // Setup the position update interval, depending on media
+                // length and rate.  XXX: VLC_TICK_FROM_MS(1) is an educated
+                // guess, it should be also calculated according to the slider
+                // size.
+
+                vlc_tick_t interval =
+                    m_length / m_player_time.rate / VLC_TICK_FROM_MS(1);
+                if (interval < POSITION_MIN_UPDATE_INTERVAL)
+                    interval = POSITION_MIN_UPDATE_INTERVAL;
+
+                m_position_timer.start(MS_FROM_VLC_TICK(interval));
+            }
+        }
+        q->updateTime(system_now, lengthOrRateChanged);
+    }
+}
+
+void PlayerControllerPrivate::applyTimerDiscontinuity(vlc_tick_t system_date)
+{
+    Q_Q(PlayerController);
+
+    if (system_date != VLC_TICK_INVALID
+     && interpolateTime(system_date) == VLC_SUCCESS)
+    {
+        // The discontinuity event got a valid system date, update the time
+        // properties.
+        q->updatePosition();
+        q->updateTime(system_date, false);
+    }
+
+    // And stop the timers.
+    m_position_timer.stop();
+    m_time_timer.stop();
+}
+
 int PlayerControllerPrivate::interpolateTime(vlc_tick_t system_now)
 {
     vlc_tick_t new_time;
@@ -360,11 +477,9 @@ void on_player_error_changed(vlc_player_t *, enum vlc_player_error , void *data)
 static void on_player_buffering(vlc_player_t *, float new_buffering, void *data)
 {
     PlayerControllerPrivate* that = static_cast<PlayerControllerPrivate*>(data);
-    msg_Dbg( that->p_intf, "on_player_buffering");
-    that->callAsync([that,new_buffering](){
-        that->m_buffering = new_buffering;
-        emit that->q_func()->bufferingChanged( new_buffering );
-    });
+    vlc_mutex_locker locker( &that->m_pending_lock );
+    that->m_pending_buffering = new_buffering;
+    that->requestFlush( PlayerControllerPrivate::PENDING_BUFFERING );
 }
 
 static void on_player_capabilities_changed(vlc_player_t *, int old_caps, int new_caps, void *data)
@@ -667,11 +782,9 @@ static void on_player_signal_changed(vlc_player_t *, float quality, float streng
 static void on_player_stats_changed(vlc_player_t *, const struct input_stats_t *stats, void *data)
 {
     PlayerControllerPrivate* that = static_cast<PlayerControllerPrivate*>(data);
-    struct input_stats_t stats_tmp = *stats;
-    that->callAsync([that,stats_tmp] () {
-        that->m_stats = stats_tmp;
-        emit that->q_func()->statisticsUpdated( that->m_stats );
-    });
+    vlc_mutex_locker locker( &that->m_pending_lock );
+    that->m_pending_stats = *stats;
+    that->requestFlush( PlayerControllerPrivate::PENDING_STATS );
 }
 
 static void on_player_atobloop_changed(vlc_player_t *, enum vlc_player_abloop state, vlc_tick_t time, float, void *data)
@@ -859,74 +972,19 @@ static void on_player_timer_update(const struct vlc_player_timer_point *point,
                                    void *data)
 {
     PlayerControllerPrivate* that = static_cast<PlayerControllerPrivate*>(data);
-    that->callAsync([that,point_copy = *point](){
-        PlayerController* q = that->q_func();
-
-        that->m_player_time = point_copy;
-        bool lengthOrRateChanged = false;
-
-        if (that->m_length != that->m_player_time.length)
-        {
-            that->m_length = that->m_player_time.length;
-            emit q->lengthChanged(that->m_length);
-
-            lengthOrRateChanged = true;
-        }
-        if (that->m_rate != that->m_player_time.rate)
-        {
-            that->m_rate = that->m_player_time.rate;
-            emit q->rateChanged(that->m_rate);
-
-            lengthOrRateChanged = true;
-        }
-
-        vlc_tick_t system_now = vlc_tick_now();
-        if (that->interpolateTime(system_now) == VLC_SUCCESS)
-        {
-            if (lengthOrRateChanged || !that->m_position_timer.isActive())
-            {
-                q->updatePosition();
-
-                if (that->m_player_time.system_date != INT64_MAX)
-                {
-                    // Setup the position update interval, depending on media
-                    // length and rate.  XXX: VLC_TICK_FROM_MS(1) is an educated
-                    // guess, it should be also calculated according to the slider
-                    // size.
-
-                    vlc_tick_t interval =
-                        that->m_length / that->m_player_time.rate / VLC_TICK_FROM_MS(1);
-                    if (interval < POSITION_MIN_UPDATE_INTERVAL)
-                        interval = POSITION_MIN_UPDATE_INTERVAL;
-
-                    that->m_position_timer.start(MS_FROM_VLC_TICK(interval));
-                }
-            }
-            q->updateTime(system_now, lengthOrRateChanged);
-        }
-
-    });
+    vlc_mutex_locker locker( &that->m_pending_lock );
+    that->m_pending_time = *point;
+    that->requestFlush( PlayerControllerPrivate::PENDING_TIME );
 }
 
 static void on_player_timer_discontinuity(vlc_tick_t system_date, void *data)
 {
     PlayerControllerPrivate* that = static_cast<PlayerControllerPrivate*>(data);
-    that->callAsync([that,system_date](){
-        PlayerController* q = that->q_func();
-
-        if (system_date != VLC_TICK_INVALID
-         && that->interpolateTime(system_date) == VLC_SUCCESS)
-        {
-            // The discontinuity event got a valid system date, update the time
-            // properties.
-            q->updatePosition();
-            q->updateTime(system_date, false);
-        }
-
-        // And stop the timers.
-        that->m_position_timer.stop();
-        that->m_time_timer.stop();
-    });
+    vlc_mutex_locker locker( &that->m_pending_lock );
+    // The previous points are outdated
+    that->m_pending &= ~PlayerControllerPrivate::PENDING_TIME;
+    that->m_pending_discontinuity = system_date;
+    that->requestFlush( PlayerControllerPrivate::PENDING_DISCONTINUITY );
 }
 
 } //extern "C"
@@ -1018,6 +1076,17 @@ PlayerControllerPrivate::PlayerControllerPrivate(PlayerController *playercontrol
     m_time_timer.setSingleShot( true );
     m_time_timer.setTimerType( Qt::PreciseTimer );
 
+    // The high rate events are coalesced and applied once per frame
+    vlc_mutex_init( &m_pending_lock );
+    QScreen* screen = QGuiApplication::primaryScreen();
+    qreal refreshRate = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60.;
+    m_flush_timer.setSingleShot( true );
+    m_flush_timer.setTimerType( Qt::PreciseTimer );
+    m_flush_timer.setInterval( qMax( 1, qRound( 1000. / refreshRate ) ) );
+    QObject::connect( &m_flush_timer, &QTimer::timeout, q_ptr, [this]() {
+        flushPendingUpdates();
+    });
+
     // Initialise fullscreen to match the player state
     m_fullscreen = vlc_player_vout_IsFullscreen( m_player );
 }
@@ -48,6 +48,18 @@ public:
     void UpdateSpuOrder(vlc_es_id_t *es_id, enum vlc_vout_order spu_order);
     int interpolateTime(vlc_tick_t system_now);
 
+    enum {
+        PENDING_TIME          = 0x1,
+        PENDING_DISCONTINUITY = 0x2,
+        PENDING_BUFFERING     = 0x4,
+        PENDING_STATS         = 0x8,
+    };
+    ///mark @a pending values as changed, with m_pending_lock held
+    void requestFlush(unsigned pending);
+    void flushPendingUpdates();
+    void applyTimerUpdate(const struct vlc_player_timer_point& point);
+    void applyTimerDiscontinuity(vlc_tick_t system_date);
+
     ///call function @a fun on object thread
     template <typename Fun>
     void callAsync(Fun&& fun)
@@ -105,6 +117,16 @@ public:
     QTimer m_position_timer;
     QTimer m_time_timer;
 
+    //latest values from the player threads, protected by m_pending_lock
+    vlc_mutex_t m_pending_lock;
+    unsigned m_pending = 0;
+    bool m_flush_scheduled = false;
+    struct vlc_player_timer_point m_pending_time;
+    vlc_tick_t m_pending_discontinuity = VLC_TICK_INVALID;
+    float m_pending_buffering = 0.f;
+    struct input_stats_t m_pending_stats;
+    QTimer m_flush_timer;
+
     //title/chapters/menu
     TitleListModel m_titleList;
     ChapterListModel m_chapterList;
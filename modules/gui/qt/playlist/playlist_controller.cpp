@@ -33,6 +33,7 @@ static QVector<PlaylistItem> toVec(vlc_playlist_item_t *const items[],
                                    size_t len)
 {
     QVector<PlaylistItem> vec;
+    vec.reserve(len);
     for (size_t i = 0; i < len; ++i)
         vec.push_back(items[i]);
     return vec;
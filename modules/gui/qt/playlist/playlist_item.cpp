@@ -24,10 +24,7 @@ PlaylistItem::PlaylistItem(vlc_playlist_item_t* item)
 {
     d = new Data();
     if (item)
-    {
         d->item.reset(item);
-        sync();
-    }
 }
 
 bool PlaylistItem::isSelected() const
@@ -42,30 +39,44 @@ void PlaylistItem::setSelected(bool selected)
 
 QString PlaylistItem::getTitle() const
 {
+    load();
     return d->title;
 }
 
 QString PlaylistItem::getArtist() const
 {
+    load();
     return d->artist;
 }
 
 QString PlaylistItem::getAlbum() const
 {
+    load();
     return d->album;
 }
 
 QUrl PlaylistItem::getArtwork() const
 {
+    load();
     return d->artwork;
 }
 
 vlc_tick_t PlaylistItem::getDuration() const
 {
+    load();
     return d->duration;
 }
 
 void PlaylistItem::sync() {
+    d->loaded = false;
+    load();
+}
+
+void PlaylistItem::load() const {
+    if (d->loaded || !d->item)
+        return;
+    d->loaded = true;
+
     input_item_t *media = vlc_playlist_item_GetMedia(d->item.get());
     vlc_mutex_lock(&media->lock);
     d->title = media->psz_name;
@@ -41,9 +41,12 @@ using PlaylistItemPtr = vlc_shared_data_ptr_type(vlc_playlist_item_t,
 /**
  * Playlist item wrapper.
  *
- * It contains both the PlaylistItemPtr and cached data saved while the playlist
- * is locked, so that the fields may be read without synchronization or race
- * conditions.
+ * It contains both the PlaylistItemPtr and cached data, so that the fields may
+ * be read without synchronization or race conditions.
+ *
+ * The metadata are read from the media (under its lock) on first access only,
+ * so that wrapping a huge number of items, most of them never displayed, is
+ * cheap.
  */
 class PlaylistItem
 {
@@ -77,21 +80,25 @@ public:
     vlc_tick_t getDuration() const;
 
 
+    /* read the metadata again from the media */
     void sync();
 
 private:
+    void load() const;
+
     struct Data : public QSharedData {
         PlaylistItemPtr item;
 
         bool selected = false;
 
-        /* cached values */
-        QString title;
-        QString artist;
-        QString album;
-        QUrl artwork;
+        /* cached values, loaded lazily */
+        mutable bool loaded = false;
+        mutable QString title;
+        mutable QString artist;
+        mutable QString album;
+        mutable QUrl artwork;
 
-        vlc_tick_t duration;
+        mutable vlc_tick_t duration = 0;
     };
 
     QExplicitlySharedDataPointer<Data> d;
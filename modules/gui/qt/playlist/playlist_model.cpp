@@ -34,6 +34,7 @@ static QVector<PlaylistItem> toVec(vlc_playlist_item_t *const items[],
                                    size_t len)
 {
     QVector<PlaylistItem> vec;
+    vec.reserve(len);
     for (size_t i = 0; i < len; ++i)
         vec.push_back(items[i]);
     return vec;
@@ -59,6 +60,7 @@ on_playlist_items_reset(vlc_playlist_t *playlist,
                         size_t len, void *userdata)
 {
     PlaylistListModelPrivate *that = static_cast<PlaylistListModelPrivate *>(userdata);
+    that->m_pendingInsertion.reset();
     QVector<PlaylistItem> newContent = toVec(items, len);
     that->callAsync([=]() {
         if (that->m_playlist != playlist)
@@ -73,11 +75,33 @@ on_playlist_items_added(vlc_playlist_t *playlist, size_t index,
                         void *userdata)
 {
     PlaylistListModelPrivate *that = static_cast<PlaylistListModelPrivate *>(userdata);
-    QVector<PlaylistItem> added = toVec(items, len);
+
+    /* Contiguous insertions not delivered yet are merged, so that adding a
+     * folder item by item results in a single range insertion */
+    auto pending = that->m_pendingInsertion;
+    if (pending && index == pending->index + static_cast<size_t>(pending->items.size()))
+    {
+        for (size_t i = 0; i < len; ++i)
+            pending->items.push_back(items[i]);
+        return;
+    }
+
+    auto insertion = std::make_shared<PlaylistListModelPrivate::PendingInsertion>();
+    insertion->index = index;
+    insertion->items = toVec(items, len);
+    that->m_pendingInsertion = insertion;
+
     that->callAsync([=]() {
+        QVector<PlaylistItem> added;
+        {
+            PlaylistLocker locker(playlist);
+            if (that->m_pendingInsertion == insertion)
+                that->m_pendingInsertion.reset();
+            added.swap(insertion->items);
+        }
         if (that->m_playlist != playlist)
             return;
-        that->onItemsAdded(added, index);
+        that->onItemsAdded(added, insertion->index);
     });
 }
 
@@ -86,6 +110,7 @@ on_playlist_items_moved(vlc_playlist_t *playlist, size_t index, size_t count,
                         size_t target, void *userdata)
 {
     PlaylistListModelPrivate *that = static_cast<PlaylistListModelPrivate *>(userdata);
+    that->m_pendingInsertion.reset();
     that->callAsync([=]() {
         if (that->m_playlist != playlist)
             return;
@@ -98,6 +123,7 @@ on_playlist_items_removed(vlc_playlist_t *playlist, size_t index, size_t count,
                           void *userdata)
 {
     PlaylistListModelPrivate *that = static_cast<PlaylistListModelPrivate *>(userdata);
+    that->m_pendingInsertion.reset();
     that->callAsync([=](){
         if (that->m_playlist != playlist)
             return;
@@ -111,6 +137,7 @@ on_playlist_items_updated(vlc_playlist_t *playlist, size_t index,
                           void *userdata)
 {
     PlaylistListModelPrivate *that = static_cast<PlaylistListModelPrivate *>(userdata);
+    that->m_pendingInsertion.reset();
     QVector<PlaylistItem> updated = toVec(items, len);
     that->callAsync([=](){
         if (that->m_playlist != playlist)
@@ -127,6 +154,7 @@ on_playlist_current_item_changed(vlc_playlist_t *playlist, ssize_t index,
                                  void *userdata)
 {
     PlaylistListModelPrivate *that = static_cast<PlaylistListModelPrivate *>(userdata);
+    that->m_pendingInsertion.reset();
     that->callAsync([=](){
         if (that->m_playlist != playlist)
             return;
@@ -21,6 +21,7 @@
 #define PLAYLIST_MODEL_P_HPP
 
 #include "playlist_model.hpp"
+#include <memory>
 
 namespace vlc {
 namespace playlist {
@@ -60,6 +61,14 @@ public:
     vlc_playlist_t* m_playlist = nullptr;
     vlc_playlist_listener_id *m_listener = nullptr;
 
+    /* insertion queued to the UI thread, which may still be extended by
+     * the following contiguous insertions (protected by the playlist lock) */
+    struct PendingInsertion {
+        size_t index;
+        QVector<PlaylistItem> items;
+    };
+    std::shared_ptr<PendingInsertion> m_pendingInsertion;
+
     /* access only from the UI thread */
     QVector<PlaylistItem> m_items;
     ssize_t m_current = -1;
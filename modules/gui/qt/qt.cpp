@@ -205,6 +205,11 @@ static void ShowDialog   ( intf_thread_t *, int, int, intf_dialog_args_t * );
 #define QT_BGCONE_EXPANDS_TEXT N_( "Expanding background cone or art" )
 #define QT_BGCONE_EXPANDS_LONGTEXT N_( "Background art fits window's size." )
 
+#define QT_ARTWORK_CACHE_TEXT N_( "Artwork cache size (MiB)" )
+#define QT_ARTWORK_CACHE_LONGTEXT N_( "Memory used to keep the scaled " \
+                                      "album arts and thumbnails of the " \
+                                      "media library views." )
+
 #define QT_DISABLE_VOLUME_KEYS_TEXT N_( "Ignore keyboard volume buttons." )
 #define QT_DISABLE_VOLUME_KEYS_LONGTEXT N_(                                             \
     "With this option checked, the volume up, volume down and mute buttons on your "    \
@@ -341,6 +346,9 @@ vlc_module_begin ()
     add_bool( "qt-bgcone-expands", false, QT_BGCONE_EXPANDS_TEXT,
               QT_BGCONE_EXPANDS_LONGTEXT, true )
 
+    add_integer_with_range( "qt-artwork-cache-size", 64, 4, 1024,
+                            QT_ARTWORK_CACHE_TEXT, QT_ARTWORK_CACHE_LONGTEXT, true )
+
     add_bool( "qt-icon-change", true, ICONCHANGE_TEXT, ICONCHANGE_LONGTEXT, true )
 
     add_integer_with_range( "qt-max-volume", 125, 60, 300, VOLUME_MAX_TEXT, VOLUME_MAX_TEXT, true)
@@ -568,6 +576,8 @@ static void *Thread( void *obj )
 
     // at the moment, the vout is created in another thread than the rendering thread
     QApplication::setAttribute( Qt::AA_DontCheckOpenGLContextThreadAffinity );
+    // the vout renders in textures shared with the scene graph
+    QApplication::setAttribute( Qt::AA_ShareOpenGLContexts );
     QQuickWindow::setDefaultAlphaBuffer(true);
 
     QQuickStyle::setStyle("fusion");
@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * ( at your option ) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "artwork_provider.hpp"
+
+#include <algorithm>
+
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QUrl>
+
+ArtworkCache::ArtworkCache(int budget_kb)
+{
+    m_cache.setMaxCost( budget_kb );
+}
+
+bool ArtworkCache::find(const QString& key, QImage* image)
+{
+    QMutexLocker lock( &m_lock );
+    QImage* cached = m_cache.object( key );
+    if ( cached == nullptr )
+        return false;
+    *image = *cached;
+    return true;
+}
+
+void ArtworkCache::insert(const QString& key, const QImage& image)
+{
+    QMutexLocker lock( &m_lock );
+    /* the cost is the size of the pixels, in kB */
+    int cost = std::max( 1, image.bytesPerLine() * image.height() / 1024 );
+    m_cache.insert( key, new QImage( image ), cost );
+}
+
+namespace {
+
+class ArtworkResponse : public QQuickImageResponse, public QRunnable
+{
+public:
+    ArtworkResponse(ArtworkCache* cache, const QString& id, const QSize& requestedSize)
+        : m_cache( cache )
+        , m_id( id )
+        , m_requested_size( requestedSize )
+    {
+        /* the response is owned by the QML engine */
+        setAutoDelete( false );
+    }
+
+    QQuickTextureFactory* textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage( m_image );
+    }
+
+    void run() override
+    {
+        QString key = m_id + QLatin1Char( '@' )
+            + QString::number( m_requested_size.width() ) + QLatin1Char( 'x' )
+            + QString::number( m_requested_size.height() );
+
+        if ( !m_cache->find( key, &m_image ) )
+        {
+            m_image = decode();
+            if ( !m_image.isNull() )
+                m_cache->insert( key, m_image );
+        }
+        emit finished();
+    }
+
+private:
+    QString localPath() const
+    {
+        QUrl url( m_id );
+        if ( url.scheme() == QLatin1String( "qrc" ) )
+            return QLatin1Char( ':' ) + url.path();
+        if ( url.isLocalFile() )
+            return url.toLocalFile();
+        return m_id;
+    }
+
+    QImage decode() const
+    {
+        QImageReader reader( localPath() );
+        QSize size = reader.size();
+
+        /* decode directly at the displayed size, the grids crop the
+         * artworks so the whole requested area must be covered */
+        if ( size.isValid() && ( m_requested_size.width() > 0 || m_requested_size.height() > 0 ) )
+        {
+            QSize target = m_requested_size;
+            if ( target.width() <= 0 )
+                target.setWidth( size.width() * target.height() / size.height() );
+            else if ( target.height() <= 0 )
+                target.setHeight( size.height() * target.width() / size.width() );
+            target = size.scaled( target, Qt::KeepAspectRatioByExpanding );
+            /* never upscale */
+            if ( target.width() < size.width() )
+                reader.setScaledSize( target );
+        }
+
+        QImage image = reader.read();
+        if ( image.isNull() )
+            return image;
+        return image.convertToFormat( image.hasAlphaChannel()
+                                      ? QImage::Format_ARGB32_Premultiplied
+                                      : QImage::Format_RGB32 );
+    }
+
+    ArtworkCache* m_cache;
+    QString m_id;
+    QSize m_requested_size;
+    QImage m_image;
+};
+
+}
+
+ArtworkImageProvider::ArtworkImageProvider(int budget_kb)
+    : m_cache( budget_kb )
+{
+    /* leave cores to the GUI and the render threads */
+    m_pool.setMaxThreadCount( std::max( 1, QThread::idealThreadCount() - 2 ) );
+}
+
+ArtworkImageProvider::~ArtworkImageProvider()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QQuickImageResponse* ArtworkImageProvider::requestImageResponse(const QString& id,
+                                                                const QSize& requestedSize)
+{
+    ArtworkResponse* response = new ArtworkResponse( &m_cache, id, requestedSize );
+    m_pool.start( response );
+    return response;
+}
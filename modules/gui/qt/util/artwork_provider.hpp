@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * ( at your option ) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef ARTWORK_PROVIDER_HPP
+#define ARTWORK_PROVIDER_HPP
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+#include <QQuickAsyncImageProvider>
+
+/**
+ * LRU cache of the scaled artworks, bounded by the memory used by the
+ * images. It is shared by all the views using the provider.
+ */
+class ArtworkCache
+{
+public:
+    explicit ArtworkCache(int budget_kb);
+
+    bool find(const QString& key, QImage* image);
+    void insert(const QString& key, const QImage& image);
+
+private:
+    QMutex m_lock;
+    QCache<QString, QImage> m_cache;
+};
+
+/**
+ * Image provider for the album arts and the thumbnails, available as
+ * "image://artwork/<mrl>". The images are decoded at the requested size
+ * (the sourceSize of the Image) on a thread pool, never on the GUI thread.
+ */
+class ArtworkImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    explicit ArtworkImageProvider(int budget_kb);
+    ~ArtworkImageProvider();
+
+    QQuickImageResponse* requestImageResponse(const QString& id,
+                                              const QSize& requestedSize) override;
+
+private:
+    ArtworkCache m_cache;
+    QThreadPool m_pool;
+};
+
+#endif // ARTWORK_PROVIDER_HPP
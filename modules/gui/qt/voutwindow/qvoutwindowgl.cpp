@@ -0,0 +1,251 @@
+/*****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "qvoutwindowgl.hpp"
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGSimpleTextureNode>
+#include <QOpenGLFunctions>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+
+VideoSurfaceGL::VideoSurfaceGL(QVoutWindowGL* renderer, QObject* parent)
+    : VideoSurfaceProvider(parent)
+    , m_renderer(renderer)
+{
+}
+
+QSGNode* VideoSurfaceGL::updatePaintNode(QQuickItem* item, QSGNode* oldNode, QQuickItem::UpdatePaintNodeData*)
+{
+    QSGSimpleTextureNode* node = static_cast<QSGSimpleTextureNode*>(oldNode);
+
+    QSize size;
+    GLuint textureId = m_renderer->getVideoTexture(&size);
+    if (textureId == 0)
+    {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node)
+    {
+        node = new QSGSimpleTextureNode();
+        /* the framebuffers are upside down */
+        node->setTextureCoordinatesTransform(QSGSimpleTextureNode::MirrorVertically);
+        node->setOwnsTexture(true);
+    }
+
+    /* only the texture wrapper is created, the scene graph samples the
+     * texture the vout rendered in */
+    QSGTexture* texture = node->texture();
+    if (!texture || static_cast<GLuint>(texture->textureId()) != textureId
+        || texture->textureSize() != size)
+    {
+        node->setTexture(item->window()->createTextureFromId(textureId, size,
+                                                             QQuickWindow::TextureIsOpaque));
+    }
+    node->setRect(item->boundingRect());
+    node->markDirty(QSGNode::DirtyMaterial);
+    return node;
+}
+
+QVoutWindowGL::QVoutWindowGL(MainInterface*, QObject* parent)
+    : QVoutWindow(parent)
+    , m_surfaceProvider(new VideoSurfaceGL(this, this))
+{
+    /* a QOffscreenSurface must be created on the GUI thread */
+    QOpenGLContext* shareContext = QOpenGLContext::globalShareContext();
+    m_surface = new QOffscreenSurface(nullptr, this);
+    m_surface->setFormat(shareContext ? shareContext->format()
+                                      : QSurfaceFormat::defaultFormat());
+    m_surface->create();
+}
+
+QVoutWindowGL::~QVoutWindowGL()
+{
+}
+
+bool QVoutWindowGL::setupVoutWindow(vout_window_t* window)
+{
+    if (QOpenGLContext::globalShareContext() == nullptr || !m_surface->isValid())
+        return false;
+
+    /* the vout this window is created for */
+    vlc_object_t* vout = vlc_object_parent(window);
+
+    /* don't override a video output chosen by the user */
+    char* modlist = var_InheritString(vout, "vout");
+    bool forced = modlist != nullptr && strcmp(modlist, "any") != 0;
+    free(modlist);
+    if (forced)
+        return false;
+
+    if (!QVoutWindow::setupVoutWindow(window))
+        return false;
+
+    /* the video is not drawn on a native window but in our textures */
+    window->type = VOUT_WINDOW_TYPE_DUMMY;
+
+    bool gles = QOpenGLContext::openGLModuleType() == QOpenGLContext::LibGLES;
+    var_Create(vout, "vout", VLC_VAR_STRING);
+    var_SetString(vout, "vout", gles ? "gles2" : "gl");
+    var_Create(vout, gles ? "gles2" : "gl", VLC_VAR_STRING);
+    var_SetString(vout, gles ? "gles2" : "gl", "vgl");
+
+    var_Create(vout, "vout-cb-type", VLC_VAR_INTEGER);
+    var_SetInteger(vout, "vout-cb-type", gles ? libvlc_video_engine_gles2
+                                              : libvlc_video_engine_opengl);
+    static const struct {
+        const char* name;
+        void* value;
+    } callbacks[] = {
+        { "vout-cb-setup", reinterpret_cast<void*>(&QVoutWindowGL::setup) },
+        { "vout-cb-cleanup", reinterpret_cast<void*>(&QVoutWindowGL::cleanup) },
+        { "vout-cb-update-output", reinterpret_cast<void*>(&QVoutWindowGL::resizeRenderTextures) },
+        { "vout-cb-swap", reinterpret_cast<void*>(&QVoutWindowGL::swap) },
+        { "vout-cb-make-current", reinterpret_cast<void*>(&QVoutWindowGL::makeCurrent) },
+        { "vout-cb-get-proc-address", reinterpret_cast<void*>(&QVoutWindowGL::getProcAddress) },
+    };
+    for (const auto& cb : callbacks)
+    {
+        var_Create(vout, cb.name, VLC_VAR_ADDRESS);
+        var_SetAddress(vout, cb.name, cb.value);
+    }
+    var_Create(vout, "vout-cb-opaque", VLC_VAR_ADDRESS);
+    var_SetAddress(vout, "vout-cb-opaque", this);
+    return true;
+}
+
+VideoSurfaceProvider* QVoutWindowGL::getVideoSurfaceProvider()
+{
+    return m_surfaceProvider;
+}
+
+GLuint QVoutWindowGL::getVideoTexture(QSize* size)
+{
+    QMutexLocker lock(&m_textLock);
+    if (m_updated)
+    {
+        std::swap(m_pendingIdx, m_displayIdx);
+        m_updated = false;
+        m_hasFrame = true;
+    }
+    if (!m_hasFrame)
+        return 0;
+    *size = m_size;
+    return m_fbo[m_displayIdx]->texture();
+}
+
+bool QVoutWindowGL::setup(void** opaque, const libvlc_video_setup_device_cfg_t*,
+                          libvlc_video_setup_device_info_t*)
+{
+    QVoutWindowGL* that = static_cast<QVoutWindowGL*>(*opaque);
+
+    /* only one vout can render in the textures */
+    if (that->m_ctx)
+        return false;
+
+    /* the context shares its textures with the scene graph contexts */
+    std::unique_ptr<QOpenGLContext> ctx(new QOpenGLContext());
+    ctx->setShareContext(QOpenGLContext::globalShareContext());
+    ctx->setFormat(that->m_surface->format());
+    if (!ctx->create())
+        return false;
+    that->m_ctx = std::move(ctx);
+    return true;
+}
+
+void QVoutWindowGL::cleanup(void* opaque)
+{
+    QVoutWindowGL* that = static_cast<QVoutWindowGL*>(opaque);
+
+    that->m_ctx->makeCurrent(that->m_surface);
+    {
+        QMutexLocker lock(&that->m_textLock);
+        for (auto& fbo : that->m_fbo)
+            fbo.reset();
+        that->m_updated = false;
+        that->m_hasFrame = false;
+    }
+    that->m_ctx->doneCurrent();
+    that->m_ctx.reset();
+
+    emit that->m_surfaceProvider->update();
+}
+
+bool QVoutWindowGL::resizeRenderTextures(void* opaque, const libvlc_video_render_cfg_t* cfg,
+                                         libvlc_video_output_cfg_t* render_cfg)
+{
+    QVoutWindowGL* that = static_cast<QVoutWindowGL*>(opaque);
+
+    /* called with the context current */
+    QSize size(cfg->width, cfg->height);
+    {
+        QMutexLocker lock(&that->m_textLock);
+        for (auto& fbo : that->m_fbo)
+            fbo.reset(new QOpenGLFramebufferObject(size));
+        that->m_size = size;
+        that->m_updated = false;
+        that->m_hasFrame = false;
+    }
+    that->m_fbo[that->m_renderIdx]->bind();
+
+    render_cfg->opengl_format = GL_RGBA;
+    render_cfg->full_range = true;
+    render_cfg->colorspace = libvlc_video_colorspace_BT709;
+    render_cfg->primaries = libvlc_video_primaries_BT709;
+    render_cfg->transfer = libvlc_video_transfer_func_SRGB;
+    return true;
+}
+
+void QVoutWindowGL::swap(void* opaque)
+{
+    QVoutWindowGL* that = static_cast<QVoutWindowGL*>(opaque);
+
+    /* the frame must be complete before the scene graph samples it */
+    that->m_ctx->functions()->glFlush();
+    {
+        QMutexLocker lock(&that->m_textLock);
+        std::swap(that->m_renderIdx, that->m_pendingIdx);
+        that->m_updated = true;
+    }
+    that->m_fbo[that->m_renderIdx]->bind();
+
+    emit that->m_surfaceProvider->update();
+}
+
+bool QVoutWindowGL::makeCurrent(void* opaque, bool current)
+{
+    QVoutWindowGL* that = static_cast<QVoutWindowGL*>(opaque);
+
+    if (!current)
+    {
+        that->m_ctx->doneCurrent();
+        return true;
+    }
+    if (!that->m_ctx->makeCurrent(that->m_surface))
+        return false;
+    if (that->m_fbo[that->m_renderIdx])
+        that->m_fbo[that->m_renderIdx]->bind();
+    return true;
+}
+
+void* QVoutWindowGL::getProcAddress(void* opaque, const char* fct_name)
+{
+    QVoutWindowGL* that = static_cast<QVoutWindowGL*>(opaque);
+    return reinterpret_cast<void*>(that->m_ctx->getProcAddress(fct_name));
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VIDEORENDERERGL_HPP
+#define VIDEORENDERERGL_HPP
+
+#include <QMutex>
+#include <QSize>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOffscreenSurface>
+#include <memory>
+#include <vlc/libvlc.h>
+#include <vlc/libvlc_picture.h>
+#include <vlc/libvlc_media.h>
+#include <vlc/libvlc_renderer_discoverer.h>
+#include <vlc/libvlc_media_player.h>
+#include "qvoutwindow.hpp"
+#include "videosurface.hpp"
+
+class QVoutWindowGL;
+
+/*
+ * Video surface provider displaying the textures rendered by the vout
+ */
+class VideoSurfaceGL : public VideoSurfaceProvider
+{
+    Q_OBJECT
+public:
+    VideoSurfaceGL(QVoutWindowGL* renderer, QObject* parent = nullptr);
+    QSGNode* updatePaintNode(QQuickItem* item, QSGNode* oldNode, QQuickItem::UpdatePaintNodeData*) override;
+
+private:
+    QVoutWindowGL* m_renderer = nullptr;
+};
+
+/*
+ * Renders the video through the OpenGL callbacks of the vout ("vgl" module).
+ * The vout draws in textures shared with the Qt Quick scene graph, which
+ * samples them directly: the frames are never copied nor read back.
+ *
+ * Three buffers are rotated: the vout renders in one of them, the last
+ * complete frame waits in another, and the scene graph displays the third.
+ */
+class QVoutWindowGL : public QVoutWindow
+{
+    Q_OBJECT
+public:
+    QVoutWindowGL(MainInterface* p_mi, QObject *parent = nullptr);
+    ~QVoutWindowGL();
+
+    bool setupVoutWindow(vout_window_t* voutWindow) override;
+    VideoSurfaceProvider* getVideoSurfaceProvider() override;
+
+    /* called by the surface, from the scene graph thread */
+    GLuint getVideoTexture(QSize* size);
+
+private:
+    static bool setup(void** opaque, const libvlc_video_setup_device_cfg_t *cfg,
+                      libvlc_video_setup_device_info_t *out);
+    static void cleanup(void* opaque);
+    static bool resizeRenderTextures(void* opaque, const libvlc_video_render_cfg_t *cfg,
+                                     libvlc_video_output_cfg_t *render_cfg);
+    static void swap(void* opaque);
+    static bool makeCurrent(void* opaque, bool current);
+    static void* getProcAddress(void* opaque, const char* fct_name);
+
+    VideoSurfaceGL* m_surfaceProvider = nullptr;
+
+    /* created on the GUI thread, the context is created by the vout */
+    QOffscreenSurface* m_surface = nullptr;
+    std::unique_ptr<QOpenGLContext> m_ctx;
+
+    QMutex m_textLock;
+    QSize m_size;
+    std::unique_ptr<QOpenGLFramebufferObject> m_fbo[3];
+    size_t m_renderIdx = 0;
+    size_t m_displayIdx = 1;
+    size_t m_pendingIdx = 2;
+    /* a rendered frame is waiting in the pending buffer */
+    bool m_updated = false;
+    /* the displayed buffer holds a frame of the current size */
+    bool m_hasFrame = false;
+};
+
+#endif // VIDEORENDERERGL_HPP
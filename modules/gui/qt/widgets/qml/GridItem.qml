@@ -141,7 +141,8 @@ Item {
                     Layout.preferredHeight: _picHeight
                     Layout.alignment: Qt.AlignHCenter
 
-                    source: image
+                    /* decoded at the displayed size and cached off the GUI thread */
+                    source: image.toString() !== "" ? "image://artwork/" + image : ""
 
                     RowLayout {
                         anchors {
@@ -27,10 +27,15 @@
 #include "ft2_err.h"
 #include "../utils/ustring.hpp"
 
+#include <cstring>
+
 #ifdef HAVE_FRIBIDI
 # include <fribidi.h>
 #endif
 
+/// Number of rendered strings kept in the cache
+#define TEXT_RUN_CACHE_SIZE 64
+
 
 FT2Font::FT2Font( intf_thread_t *pIntf, const std::string &rName, int size ):
     GenericFont( pIntf ), m_name( rName ), m_buffer( NULL ), m_size( size ),
@@ -41,6 +46,9 @@ FT2Font::FT2Font( intf_thread_t *pIntf, const std::string &rName, int size ):
 
 FT2Font::~FT2Font()
 {
+    TextRunList_t::iterator run;
+    for( run = m_textRunCache.begin(); run != m_textRunCache.end(); ++run )
+        delete (*run).m_pBitmap;
     GlyphMap_t::iterator iter;
     for( iter = m_glyphCache.begin(); iter != m_glyphCache.end(); ++iter )
         FT_Done_Glyph( (*iter).second.m_glyph );
@@ -137,6 +145,58 @@ bool FT2Font::init()
 
 GenericBitmap *FT2Font::drawString( const UString &rString, uint32_t color,
                                     int maxWidth ) const
+{
+    // Check if freetype has been initialized
+    if( !m_face )
+    {
+        return NULL;
+    }
+
+    // The same strings are drawn again and again (list items, texts
+    // updated periodically...), so look for it in the cache first
+    std::vector<uint32_t> text( rString.u_str(),
+                                rString.u_str() + rString.length() );
+    TextRunList_t::iterator it;
+    for( it = m_textRunCache.begin(); it != m_textRunCache.end(); ++it )
+    {
+        if( (*it).m_color == color && (*it).m_maxWidth == maxWidth &&
+            (*it).m_text == text )
+            break;
+    }
+
+    if( it != m_textRunCache.end() )
+    {
+        // Move it in front of the list
+        m_textRunCache.splice( m_textRunCache.begin(), m_textRunCache, it );
+    }
+    else
+    {
+        TextRun_t run;
+        run.m_text = text;
+        run.m_color = color;
+        run.m_maxWidth = maxWidth;
+        run.m_pBitmap = renderString( rString, color, maxWidth );
+        m_textRunCache.push_front( run );
+
+        if( m_textRunCache.size() > TEXT_RUN_CACHE_SIZE )
+        {
+            delete m_textRunCache.back().m_pBitmap;
+            m_textRunCache.pop_back();
+        }
+    }
+
+    // The caller owns the returned bitmap, give it a copy
+    const FT2Bitmap *pCached = m_textRunCache.front().m_pBitmap;
+    BitmapImpl *pBmp = new BitmapImpl( getIntf(), pCached->getWidth(),
+                                       pCached->getHeight() );
+    memcpy( pBmp->getData(), pCached->getData(),
+            pCached->getWidth() * pCached->getHeight() * 4 );
+    return pBmp;
+}
+
+
+FT2Bitmap *FT2Font::renderString( const UString &rString, uint32_t color,
+                                  int maxWidth ) const
 {
     uint32_t code;
     int n;
@@ -145,12 +205,6 @@ GenericBitmap *FT2Font::drawString( const UString &rString, uint32_t color,
     int yMin = 0, yMax = 0;
     uint32_t *pString = (uint32_t*)rString.u_str();
 
-    // Check if freetype has been initialized
-    if( !m_face )
-    {
-        return NULL;
-    }
-
     // Get the length of the string
     int len = rString.length();
 
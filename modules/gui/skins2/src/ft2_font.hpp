@@ -27,12 +27,15 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_GLYPH_H
+#include <list>
 #include <string>
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "generic_font.hpp"
 
 class UString;
+class FT2Bitmap;
 
 
 /// Freetype2 font
@@ -61,7 +64,19 @@ private:
         int m_index;
         int m_advance;
     } Glyph_t;
-    typedef std::map<uint32_t,Glyph_t> GlyphMap_t;
+    /// The references to the glyphs must stay valid when new ones are
+    /// added, which is the case with a node based container
+    typedef std::unordered_map<uint32_t,Glyph_t> GlyphMap_t;
+
+    /// Rendered string, kept to serve the same draw requests again
+    typedef struct
+    {
+        std::vector<uint32_t> m_text;
+        uint32_t m_color;
+        int m_maxWidth;
+        FT2Bitmap *m_pBitmap;
+    } TextRun_t;
+    typedef std::list<TextRun_t> TextRunList_t;
 
     /// File name
     const std::string m_name;
@@ -77,9 +92,14 @@ private:
     int m_height, m_ascender, m_descender;
     /// Glyph cache
     mutable GlyphMap_t m_glyphCache;
+    /// Cache of the last rendered strings, most recently used first
+    mutable TextRunList_t m_textRunCache;
 
     /// Get the glyph corresponding to the given code
     Glyph_t &getGlyph( uint32_t code ) const;
+    /// Render a string on a new bitmap
+    FT2Bitmap *renderString( const UString &rString,
+                             uint32_t color, int maxWidth ) const;
     bool error( unsigned err, const char *msg );
 };
 
@@ -25,6 +25,7 @@
 #include "top_window.hpp"
 #include "os_factory.hpp"
 #include "os_graphics.hpp"
+#include "os_timer.hpp"
 #include "var_manager.hpp"
 #include "anchor.hpp"
 #include "../controls/ctrl_generic.hpp"
@@ -41,13 +42,19 @@ GenericLayout::GenericLayout( intf_thread_t *pIntf, int width, int height,
     m_rect( 0, 0, width, height ),
     m_minWidth( minWidth ), m_maxWidth( maxWidth ),
     m_minHeight( minHeight ), m_maxHeight( maxHeight ), m_pVideoCtrlSet(),
-    m_visible( false ), m_pVarActive( NULL )
+    m_visible( false ), m_pVarActive( NULL ),
+    m_lastRefresh( VLC_TICK_INVALID ), m_refreshPending( false ),
+    m_cmdRefresh( this )
 {
     // Get the OSFactory
     OSFactory *pOsFactory = OSFactory::instance( getIntf() );
     // Create the graphics buffer
     m_pImage = pOsFactory->createOSGraphics( width, height );
 
+    // Create the timer limiting the redraws
+    m_pTimer = pOsFactory->createOSTimer( m_cmdRefresh );
+    m_refreshDelay = 1000 / var_InheritInteger( pIntf, "skins2-fps" );
+
     // Create the "active layout" variable and register it in the manager
     m_pVarActive = new VarBoolImpl( pIntf );
     VarManager::instance( pIntf )->registerVar( VariablePtr( m_pVarActive ) );
@@ -56,6 +63,7 @@ GenericLayout::GenericLayout( intf_thread_t *pIntf, int width, int height,
 
 GenericLayout::~GenericLayout()
 {
+    delete m_pTimer;
     delete m_pImage;
 
     std::list<Anchor*>::const_iterator it;
@@ -165,8 +173,87 @@ void GenericLayout::onControlUpdate( const CtrlGeneric &rCtrl,
         rect inter;
         if( rect::intersect( layout, region, &inter ) )
         {
-            refreshRect( inter.x, inter.y, inter.width, inter.height );
+            addDirtyRect( inter );
+        }
+    }
+}
+
+
+void GenericLayout::addDirtyRect( const rect &rRect )
+{
+    // Merge the rectangle with the pending ones when the union does not
+    // cover much more than both of them, so that overlapping or adjacent
+    // updates are drawn once
+    rect dirty = rRect;
+    std::list<rect>::iterator it = m_dirtyRects.begin();
+    while( it != m_dirtyRects.end() )
+    {
+        rect join;
+        rect::join( dirty, *it, &join );
+        if( join.width * join.height <=
+            ( dirty.width * dirty.height + it->width * it->height ) * 5 / 4 )
+        {
+            dirty = join;
+            m_dirtyRects.erase( it );
+            // the merged rectangle may now overlap the previous ones
+            it = m_dirtyRects.begin();
         }
+        else
+            ++it;
+    }
+    m_dirtyRects.push_back( dirty );
+
+    // Don't let the list grow with many small scattered updates
+    if( m_dirtyRects.size() > 8 )
+    {
+        rect bounds = m_dirtyRects.front();
+        for( it = m_dirtyRects.begin(); it != m_dirtyRects.end(); ++it )
+            rect::join( bounds, *it, &bounds );
+        m_dirtyRects.clear();
+        m_dirtyRects.push_back( bounds );
+    }
+
+    if( m_refreshPending )
+        return;
+    m_refreshPending = true;
+
+    // Redraw at once if the last redraw is old enough, or wait for the
+    // next frame
+    int delay = 0;
+    if( m_lastRefresh != VLC_TICK_INVALID )
+    {
+        vlc_tick_t next = m_lastRefresh + VLC_TICK_FROM_MS( m_refreshDelay );
+        vlc_tick_t now = vlc_tick_now();
+        if( next > now )
+            delay = MS_FROM_VLC_TICK( next - now );
+    }
+    m_pTimer->start( delay, true );
+}
+
+
+void GenericLayout::CmdRefresh::execute()
+{
+    m_pParent->m_refreshPending = false;
+    if( !m_pParent->m_visible || m_pParent->m_dirtyRects.empty() )
+        return;
+
+    m_pParent->m_lastRefresh = vlc_tick_now();
+
+    std::list<rect> dirtyRects;
+    dirtyRects.swap( m_pParent->m_dirtyRects );
+
+    std::list<rect>::const_iterator it;
+    for( it = dirtyRects.begin(); it != dirtyRects.end(); ++it )
+        m_pParent->drawRect( it->x, it->y, it->width, it->height );
+
+    // Refresh the associated window
+    TopWindow *pWindow = m_pParent->getWindow();
+    if( pWindow )
+    {
+        // first apply new shape to the window
+        pWindow->updateShape();
+        for( it = dirtyRects.begin(); it != dirtyRects.end(); ++it )
+            pWindow->invalidateRect( it->x, it->y, it->width, it->height );
     }
 }
 
@@ -209,6 +296,21 @@ void GenericLayout::refreshRect( int x, int y, int width, int height )
     if( !m_visible )
         return;
 
+    drawRect( x, y, width, height );
+
+    // Refresh the associated window
+    TopWindow *pWindow = getWindow();
+    if( pWindow )
+    {
+        // first apply new shape to the window
+        pWindow->updateShape();
+        pWindow->invalidateRect( x, y, width, height );
+    }
+}
+
+
+void GenericLayout::drawRect( int x, int y, int width, int height )
+{
     // update the transparency global mask
     m_pImage->clear( x, y, width, height );
 
@@ -222,15 +324,6 @@ void GenericLayout::refreshRect( int x, int y, int width, int height )
             pCtrl->draw( *m_pImage, x, y, width, height );
         }
     }
-
-    // Refresh the associated window
-    TopWindow *pWindow = getWindow();
-    if( pWindow )
-    {
-        // first apply new shape to the window
-        pWindow->updateShape();
-        pWindow->invalidateRect( x, y, width, height );
-    }
 }
 
 
@@ -257,6 +350,10 @@ void GenericLayout::onShow()
 void GenericLayout::onHide()
 {
     m_visible = false;
+
+    m_pTimer->stop();
+    m_refreshPending = false;
+    m_dirtyRects.clear();
 }
 
 
@@ -26,6 +26,7 @@
 
 #include "skin_common.hpp"
 #include "top_window.hpp"
+#include "../commands/cmd_generic.hpp"
 #include "../utils/pointer.hpp"
 #include "../utils/position.hpp"
 
@@ -33,6 +34,7 @@
 
 class Anchor;
 class OSGraphics;
+class OSTimer;
 class CtrlGeneric;
 class CtrlVideo;
 class VarBoolImpl;
@@ -127,7 +129,9 @@ public:
     /**
      * The arguments indicate the size of the rectangle to refresh,
      * and the offset (from the control position) of this rectangle.
-     * Use a negative width or height to refresh the layout completely
+     * Use a negative width or height to refresh the layout completely.
+     * The rectangles are merged and redrawn at most "skins2-fps" times
+     * per second.
      */
     virtual void onControlUpdate( const CtrlGeneric &rCtrl,
                                   int width, int height,
@@ -150,6 +154,12 @@ public:
     VarBoolImpl &getActiveVar() { return *m_pVarActive; }
 
 private:
+    /// Draw the controls in a rectangle of the image
+    void drawRect( int x, int y, int width, int height );
+
+    /// Add a rectangle to redraw, merging it with the pending ones
+    void addDirtyRect( const rect &rRect );
+
     /// Parent window of the layout
     TopWindow *m_pWindow;
     /// Layout original size
@@ -176,6 +186,18 @@ private:
      * layout). This way, we avoid using a setActiveLayoutInner method.
      */
     mutable VarBoolImpl *m_pVarActive;
+    /// Rectangles waiting to be redrawn
+    std::list<rect> m_dirtyRects;
+    /// Minimum delay between two redraws, in ms
+    int m_refreshDelay;
+    /// Date of the last redraw
+    vlc_tick_t m_lastRefresh;
+    /// Timer delaying the redraws
+    OSTimer *m_pTimer;
+    bool m_refreshPending;
+
+    /// Callback to redraw the pending rectangles
+    DEFINE_CALLBACK( GenericLayout, Refresh );
 };
 
 
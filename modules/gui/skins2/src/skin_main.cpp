@@ -469,6 +469,9 @@ static void WindowClose( vout_window_t *pWnd )
 #define SKINS2_TRANSPARENCY_LONG N_("You can disable all transparency effects"\
     " if you want. This is mainly useful when moving windows does not behave" \
     " correctly.")
+#define SKINS2_FPS      N_("Maximum refresh rate")
+#define SKINS2_FPS_LONG N_("Maximum number of times per second the windows " \
+    "are redrawn. Lower values reduce the CPU usage of animated skins.")
 #define SKINS2_PLAYLIST N_("Use a skinned playlist")
 #define SKINS2_PLAYLIST_LONG N_("Use a skinned playlist")
 #define SKINS2_VIDEO N_("Display video in a skinned window if any")
@@ -491,6 +494,8 @@ vlc_module_begin ()
 #endif
     add_bool( "skins2-transparency", false, SKINS2_TRANSPARENCY,
               SKINS2_TRANSPARENCY_LONG, false );
+    add_integer_with_range( "skins2-fps", 30, 1, 120, SKINS2_FPS,
+                            SKINS2_FPS_LONG, true );
 
     add_bool( "skinned-playlist", true, SKINS2_PLAYLIST,
               SKINS2_PLAYLIST_LONG, false );
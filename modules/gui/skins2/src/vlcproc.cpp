@@ -772,7 +772,7 @@ void VlcProc::on_vout_changed( vlc_value_t newVal )
 
     // keep new vout held and install callback
     m_pVout = pVout;
-    var_AddCallback( m_pVout, "mouse-moved", genericCallback, this );
+    var_AddDeferredCallback( m_pVout, "mouse-moved", genericCallback, this );
 }
 
 void VlcProc::on_audio_filter_changed( vlc_value_t newVal )
@@ -176,6 +176,27 @@ vlc_vaapi_ReleaseBufferHandle(vlc_object_t *o, VADisplay dpy, VABufferID buf_id)
 error: return VLC_EGENERIC;
 }
 
+#if VA_CHECK_VERSION(1, 1, 0)
+int
+vlc_vaapi_ExportSurfaceHandle(vlc_object_t *o, VADisplay dpy,
+                              VASurfaceID surface, uint32_t mem_type,
+                              uint32_t flags, void *descriptor)
+{
+    VA_CALL(o, vaExportSurfaceHandle, dpy, surface, mem_type, flags,
+            descriptor);
+    return VLC_SUCCESS;
+error: return VLC_EGENERIC;
+}
+#endif
+
+int
+vlc_vaapi_SyncSurface(vlc_object_t *o, VADisplay dpy, VASurfaceID surface)
+{
+    VA_CALL(o, vaSyncSurface, dpy, surface);
+    return VLC_SUCCESS;
+error: return VLC_EGENERIC;
+}
+
 /*****************
  * VAAPI queries *
  *****************/
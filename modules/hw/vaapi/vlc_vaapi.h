@@ -105,6 +105,19 @@ vlc_vaapi_AcquireBufferHandle(vlc_object_t *o, VADisplay dpy, VABufferID buf_id,
 int
 vlc_vaapi_ReleaseBufferHandle(vlc_object_t *o, VADisplay dpy, VABufferID buf_id);
 
+#if VA_CHECK_VERSION(1, 1, 0)
+/* Exports the surface memory, 'descriptor' depends on 'mem_type'. The
+ * returned file descriptors must be closed by the caller. */
+int
+vlc_vaapi_ExportSurfaceHandle(vlc_object_t *o, VADisplay dpy,
+                              VASurfaceID surface, uint32_t mem_type,
+                              uint32_t flags, void *descriptor);
+#endif
+
+/* Waits for the pending operations on the surface to complete. */
+int
+vlc_vaapi_SyncSurface(vlc_object_t *o, VADisplay dpy, VASurfaceID surface);
+
 /*****************
  * VAAPI queries *
  *****************/
@@ -652,17 +652,164 @@ int vlclua_add_modules_path( lua_State *L, const char *psz_filename )
     return 0;
 }
 
+/*****************************************************************************
+ * Compiled scripts cache
+ *
+ * The same scripts are loaded over and over, all the playlist scripts being
+ * probed for each URL for instance: their compiled chunks are kept, and
+ * reused as long as the script files are not modified.
+ *****************************************************************************/
+#define VLCLUA_CHUNKS_MAX_SIZE (4 << 20)
+
+typedef struct vlclua_chunk_t
+{
+    struct vlclua_chunk_t *p_next;
+    char *psz_path;
+    time_t i_mtime;
+    off_t i_size;
+    char *p_data;
+    size_t i_data;
+} vlclua_chunk_t;
+
+static vlc_mutex_t chunks_lock = VLC_STATIC_MUTEX;
+static vlclua_chunk_t *p_chunks = NULL;
+static size_t i_chunks_size = 0;
+
+__attribute__((destructor))
+static void vlclua_chunks_free( void )
+{
+    while( p_chunks != NULL )
+    {
+        vlclua_chunk_t *p_chunk = p_chunks;
+        p_chunks = p_chunk->p_next;
+        free( p_chunk->psz_path );
+        free( p_chunk->p_data );
+        free( p_chunk );
+    }
+}
+
+typedef struct
+{
+    char *p_data;
+    size_t i_data;
+    bool b_error;
+} vlclua_dump_t;
+
+static int vlclua_chunk_writer( lua_State *L, const void *p, size_t i_size,
+                                void *opaque )
+{
+    vlclua_dump_t *p_dump = opaque;
+    VLC_UNUSED( L );
+
+    char *p_data = realloc( p_dump->p_data, p_dump->i_data + i_size );
+    if( unlikely( p_data == NULL ) )
+    {
+        p_dump->b_error = true;
+        return 1;
+    }
+    memcpy( p_data + p_dump->i_data, p, i_size );
+    p_dump->p_data = p_data;
+    p_dump->i_data += i_size;
+    return 0;
+}
+
+/** Replacement for luaL_loadfile, reusing the compiled chunks */
+static int vlclua_loadfile( lua_State *L, const char *psz_path )
+{
+    struct stat st;
+    vlclua_chunk_t *p_chunk;
+    int i_ret;
+
+    if( vlc_stat( psz_path, &st ) )
+        return luaL_loadfile( L, psz_path ); /* for the error message */
+
+    vlc_mutex_lock( &chunks_lock );
+    for( p_chunk = p_chunks; p_chunk != NULL; p_chunk = p_chunk->p_next )
+    {
+        if( !strcmp( p_chunk->psz_path, psz_path )
+         && p_chunk->i_mtime == st.st_mtime && p_chunk->i_size == st.st_size )
+        {
+            i_ret = luaL_loadbuffer( L, p_chunk->p_data, p_chunk->i_data,
+                                     psz_path );
+            vlc_mutex_unlock( &chunks_lock );
+            return i_ret;
+        }
+    }
+    vlc_mutex_unlock( &chunks_lock );
+
+    i_ret = luaL_loadfile( L, psz_path );
+    if( i_ret )
+        return i_ret;
+
+    vlclua_dump_t dump = { NULL, 0, false };
+#if LUA_VERSION_NUM >= 503
+    lua_dump( L, vlclua_chunk_writer, &dump, 0 );
+#else
+    lua_dump( L, vlclua_chunk_writer, &dump );
+#endif
+    if( dump.b_error || dump.i_data == 0 )
+    {
+        free( dump.p_data );
+        return 0;
+    }
+
+    vlc_mutex_lock( &chunks_lock );
+    for( p_chunk = p_chunks; p_chunk != NULL; p_chunk = p_chunk->p_next )
+        if( !strcmp( p_chunk->psz_path, psz_path ) )
+            break;
+
+    if( p_chunk != NULL )
+    {   /* the script was modified */
+        i_chunks_size -= p_chunk->i_data;
+        free( p_chunk->p_data );
+    }
+    else if( i_chunks_size + dump.i_data <= VLCLUA_CHUNKS_MAX_SIZE
+          && ( p_chunk = malloc( sizeof( *p_chunk ) ) ) != NULL )
+    {
+        p_chunk->psz_path = strdup( psz_path );
+        if( unlikely( p_chunk->psz_path == NULL ) )
+        {
+            free( p_chunk );
+            p_chunk = NULL;
+        }
+        else
+        {
+            p_chunk->p_next = p_chunks;
+            p_chunks = p_chunk;
+        }
+    }
+
+    if( p_chunk != NULL )
+    {
+        p_chunk->i_mtime = st.st_mtime;
+        p_chunk->i_size = st.st_size;
+        p_chunk->p_data = dump.p_data;
+        p_chunk->i_data = dump.i_data;
+        i_chunks_size += dump.i_data;
+    }
+    else
+        free( dump.p_data );
+    vlc_mutex_unlock( &chunks_lock );
+    return 0;
+}
+
+static int vlclua_dolocalfile( lua_State *L, const char *psz_path )
+{
+    return vlclua_loadfile( L, psz_path )
+        || lua_pcall( L, 0, LUA_MULTRET, 0 );
+}
+
 /** Replacement for luaL_dofile, using VLC's input capabilities */
 int vlclua_dofile( vlc_object_t *p_this, lua_State *L, const char *curi )
 {
     char *uri = ToLocaleDup( curi );
     if( !strstr( uri, "://" ) ) {
-        int ret = luaL_dofile( L, uri );
+        int ret = vlclua_dolocalfile( L, uri );
         free( uri );
         return ret;
     }
     if( !strncasecmp( uri, "file://", 7 ) ) {
-        int ret = luaL_dofile( L, uri + 7 );
+        int ret = vlclua_dolocalfile( L, uri + 7 );
         free( uri );
         return ret;
     }
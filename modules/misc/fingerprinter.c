@@ -39,11 +39,22 @@
  * Local prototypes
  *****************************************************************************/
 
-struct fingerprinter_sys_t
+typedef struct
 {
+    /* holds the "fingerprint-data" of the player of this worker */
+    vlc_object_t *obj;
+    fingerprinter_thread_t *owner;
     vlc_thread_t thread;
     vlc_player_t *player;
     vlc_player_listener_id *listener_id;
+    vlc_cond_t cond;
+    bool b_working;
+} fingerprinter_worker_t;
+
+struct fingerprinter_sys_t
+{
+    fingerprinter_worker_t *workers;
+    unsigned i_workers;
 
     struct
     {
@@ -55,8 +66,6 @@ struct fingerprinter_sys_t
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
-        vlc_cond_t          cond;
-        bool                b_working;
     } processing;
 };
 
@@ -68,12 +77,18 @@ static void *Run(void *);
 /*****************************************************************************
  * Module descriptor
  ****************************************************************************/
+#define THREADS_TEXT N_("Fingerprinting threads")
+#define THREADS_LONGTEXT N_("Number of tracks fingerprinted at the same time " \
+    "(0 for half of the CPU cores).")
+
 vlc_module_begin ()
     set_category(CAT_ADVANCED)
     set_subcategory(SUBCAT_ADVANCED_MISC)
     set_shortname(N_("acoustid"))
     set_description(N_("Track fingerprinter (based on Acoustid)"))
     set_capability("fingerprinter", 10)
+    add_integer("fingerprinter-threads", 0, THREADS_TEXT, THREADS_LONGTEXT, true)
+        change_integer_range(0, 32)
     set_callbacks(Open, Close)
 vlc_module_end ()
 
@@ -93,6 +108,7 @@ static int EnqueueRequest( fingerprinter_thread_t *f, fingerprint_request_t *r )
 static void QueueIncomingRequests( fingerprinter_sys_t *p_sys )
 {
     vlc_mutex_lock( &p_sys->incoming.lock );
+    vlc_mutex_lock( &p_sys->processing.lock );
 
     for( size_t i = vlc_array_count( &p_sys->incoming.queue ); i > 0 ; i-- )
     {
@@ -101,6 +117,7 @@ static void QueueIncomingRequests( fingerprinter_sys_t *p_sys )
             fingerprint_request_Delete( r );
     }
     vlc_array_clear( &p_sys->incoming.queue );
+    vlc_mutex_unlock( &p_sys->processing.lock );
     vlc_mutex_unlock(&p_sys->incoming.lock);
 }
 
@@ -135,15 +152,15 @@ static void player_on_state_changed(vlc_player_t *player,
                                     void *p_user_data)
 {
     VLC_UNUSED(player);
-    fingerprinter_sys_t *p_sys = p_user_data;
+    fingerprinter_worker_t *p_worker = p_user_data;
     if (new_state == VLC_PLAYER_STATE_STOPPED)
     {
-        p_sys->processing.b_working = false;
-        vlc_cond_signal( &p_sys->processing.cond );
+        p_worker->b_working = false;
+        vlc_cond_signal( &p_worker->cond );
     }
 }
 
-static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
+static void DoFingerprint( fingerprinter_worker_t *p_worker,
                            acoustid_fingerprint_t *fp,
                            const char *psz_uri )
 {
@@ -152,10 +169,10 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
          return;
 
     char *psz_sout_option;
-    /* Note: need at -max- 2 channels, but we can't guess it before playing */
-    /* the stereo upmix could make the mono tracks fingerprint to differ :/ */
+    /* Chromaprint downmixes to mono and resamples to 11025Hz anyway: do it
+     * in the transcode filters so that less audio goes through the chain */
     if ( asprintf( &psz_sout_option,
-                   "sout=#transcode{acodec=%s,channels=2}:chromaprint",
+                   "sout=#transcode{acodec=%s,channels=1,samplerate=11025}:chromaprint",
                    ( VLC_CODEC_S16L == VLC_CODEC_S16N ) ? "s16l" : "s16b" )
          == -1 )
     {
@@ -165,9 +182,16 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
 
     input_item_AddOption( p_item, psz_sout_option, VLC_INPUT_OPTION_TRUSTED );
     free( psz_sout_option );
-    if ( fp->i_duration )
+
+    /* Don't demux nor decode past what the fingerprint needs */
+    unsigned i_stop = var_InheritInteger( p_worker->obj, "duration" );
+    if ( fp->i_duration && ( !i_stop || fp->i_duration < i_stop ) )
+        i_stop = fp->i_duration;
+    else if ( i_stop )
+        i_stop++; /* let the last decoded block reach the duration */
+    if ( i_stop )
     {
-        if ( asprintf( &psz_sout_option, "stop-time=%u", fp->i_duration ) == -1 )
+        if ( asprintf( &psz_sout_option, "stop-time=%u", i_stop ) == -1 )
         {
             input_item_Release( p_item );
             return;
@@ -182,31 +206,86 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     chroma_fingerprint.psz_fingerprint = NULL;
     chroma_fingerprint.i_duration = fp->i_duration;
 
-    var_Create( p_fingerprinter, "fingerprint-data", VLC_VAR_ADDRESS );
-    var_SetAddress( p_fingerprinter, "fingerprint-data", &chroma_fingerprint );
+    var_SetAddress( p_worker->obj, "fingerprint-data", &chroma_fingerprint );
 
-    vlc_player_t *player = p_fingerprinter->p_sys->player;
+    vlc_player_t *player = p_worker->player;
     vlc_player_Lock(player);
 
-    p_fingerprinter->p_sys->processing.b_working = true;
+    p_worker->b_working = true;
 
     int ret = vlc_player_SetCurrentMedia(player, p_item);
     if (ret == VLC_SUCCESS)
         ret = vlc_player_Start(player);
-    input_item_Release(p_item);
 
     if (ret == VLC_SUCCESS)
     {
-        while( p_fingerprinter->p_sys->processing.b_working )
-            vlc_player_CondWait(player,
-                                &p_fingerprinter->p_sys->processing.cond);
+        while( p_worker->b_working )
+            vlc_player_CondWait(player, &p_worker->cond);
 
         fp->psz_fingerprint = chroma_fingerprint.psz_fingerprint;
         if( !fp->i_duration ) /* had not given hint */
-            fp->i_duration = chroma_fingerprint.i_duration;
+        {
+            /* the session stopped early, prefer the length of the track */
+            vlc_tick_t i_length = input_item_GetDuration( p_item );
+            if( i_length > 0 )
+                fp->i_duration = SEC_FROM_VLC_TICK( i_length );
+            else
+                fp->i_duration = chroma_fingerprint.i_duration;
+        }
     }
 
     vlc_player_Unlock(player);
+    input_item_Release(p_item);
+}
+
+/*****************************************************************************
+ * Workers:
+ *****************************************************************************/
+
+static int WorkerInit( fingerprinter_thread_t *p_fingerprinter,
+                       fingerprinter_worker_t *p_worker )
+{
+    p_worker->owner = p_fingerprinter;
+    p_worker->b_working = false;
+    vlc_cond_init( &p_worker->cond );
+
+    p_worker->obj = vlc_object_create( p_fingerprinter, sizeof (vlc_object_t) );
+    if ( !p_worker->obj )
+        return VLC_ENOMEM;
+    var_Create( p_worker->obj, "fingerprint-data", VLC_VAR_ADDRESS );
+
+    p_worker->player = vlc_player_New( p_worker->obj,
+                                       VLC_PLAYER_LOCK_NORMAL, NULL, NULL );
+    if ( !p_worker->player )
+        goto error;
+
+    static const struct vlc_player_cbs cbs = {
+        .on_state_changed = player_on_state_changed,
+    };
+
+    vlc_player_Lock(p_worker->player);
+    p_worker->listener_id =
+        vlc_player_AddListener(p_worker->player, &cbs, p_worker);
+    vlc_player_Unlock(p_worker->player);
+    if ( !p_worker->listener_id )
+    {
+        vlc_player_Delete( p_worker->player );
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    vlc_object_delete( p_worker->obj );
+    return VLC_ENOMEM;
+}
+
+static void WorkerClean( fingerprinter_worker_t *p_worker )
+{
+    vlc_player_Lock(p_worker->player);
+    vlc_player_RemoveListener(p_worker->player, p_worker->listener_id);
+    vlc_player_Unlock(p_worker->player);
+    vlc_player_Delete(p_worker->player);
+    vlc_object_delete( p_worker->obj );
 }
 
 /*****************************************************************************
@@ -226,25 +305,25 @@ static int Open(vlc_object_t *p_this)
     var_SetString(p_fingerprinter, "vout", "dummy");
     var_Create(p_fingerprinter, "aout", VLC_VAR_STRING);
     var_SetString(p_fingerprinter, "aout", "dummy");
-    p_sys->player = vlc_player_New(VLC_OBJECT(p_fingerprinter),
-                                   VLC_PLAYER_LOCK_NORMAL, NULL, NULL );
-    if (!p_sys->player)
+
+    /* Each worker plays its own track, at the decoding speed */
+    unsigned i_workers = var_InheritInteger(p_fingerprinter,
+                                            "fingerprinter-threads");
+    if (i_workers == 0)
+        i_workers = __MAX(vlc_GetCPUCount() / 2, 1);
+
+    p_sys->workers = vlc_alloc(i_workers, sizeof (*p_sys->workers));
+    if (!p_sys->workers)
     {
         free(p_sys);
         return VLC_ENOMEM;
     }
-
-    static const struct vlc_player_cbs cbs = {
-        .on_state_changed = player_on_state_changed,
-    };
-
-    vlc_player_Lock(p_sys->player);
-    p_sys->listener_id =
-        vlc_player_AddListener(p_sys->player, &cbs, p_fingerprinter->p_sys);
-    vlc_player_Unlock(p_sys->player);
-    if (!p_sys->listener_id)
+    for (p_sys->i_workers = 0; p_sys->i_workers < i_workers; p_sys->i_workers++)
+        if (WorkerInit(p_fingerprinter, &p_sys->workers[p_sys->i_workers]))
+            break;
+    if (p_sys->i_workers == 0)
     {
-        vlc_player_Delete(p_sys->player);
+        free(p_sys->workers);
         free(p_sys);
         return VLC_ENOMEM;
     }
@@ -253,7 +332,7 @@ static int Open(vlc_object_t *p_this)
     vlc_mutex_init( &p_sys->incoming.lock );
 
     vlc_array_init( &p_sys->processing.queue );
-    vlc_cond_init( &p_sys->processing.cond );
+    vlc_mutex_init( &p_sys->processing.lock );
 
     vlc_array_init( &p_sys->results.queue );
     vlc_mutex_init( &p_sys->results.lock );
@@ -263,11 +342,19 @@ static int Open(vlc_object_t *p_this)
     p_fingerprinter->pf_apply = ApplyResult;
 
     var_Create( p_fingerprinter, "results-available", VLC_VAR_BOOL );
-    if( vlc_clone( &p_sys->thread, Run, p_fingerprinter,
-                   VLC_THREAD_PRIORITY_LOW ) )
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
     {
-        msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
-        goto error;
+        if( vlc_clone( &p_sys->workers[i].thread, Run, &p_sys->workers[i],
+                       VLC_THREAD_PRIORITY_LOW ) )
+        {
+            msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
+            for( unsigned j = i; j < p_sys->i_workers; j++ )
+                WorkerClean( &p_sys->workers[j] );
+            p_sys->i_workers = i;
+            if( i == 0 )
+                goto error;
+            break;
+        }
     }
 
     return VLC_SUCCESS;
@@ -286,8 +373,10 @@ static void Close(vlc_object_t *p_this)
     fingerprinter_thread_t   *p_fingerprinter = (fingerprinter_thread_t*) p_this;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    vlc_cancel( p_sys->thread );
-    vlc_join( p_sys->thread, NULL );
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+        vlc_cancel( p_sys->workers[i].thread );
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+        vlc_join( p_sys->workers[i].thread, NULL );
 
     CleanSys( p_sys );
     free( p_sys );
@@ -307,10 +396,9 @@ static void CleanSys( fingerprinter_sys_t *p_sys )
         fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->results.queue, i ) );
     vlc_array_clear( &p_sys->results.queue );
 
-    vlc_player_Lock(p_sys->player);
-    vlc_player_RemoveListener(p_sys->player, p_sys->listener_id);
-    vlc_player_Unlock(p_sys->player);
-    vlc_player_Delete(p_sys->player);
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+        WorkerClean( &p_sys->workers[i] );
+    free( p_sys->workers );
 }
 
 static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_fingerprint_t *p_f )
@@ -339,7 +427,8 @@ static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_finger
  *****************************************************************************/
 static void *Run( void *opaque )
 {
-    fingerprinter_thread_t *p_fingerprinter = opaque;
+    fingerprinter_worker_t *p_worker = opaque;
+    fingerprinter_thread_t *p_fingerprinter = p_worker->owner;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
     /* main loop */
@@ -351,11 +440,27 @@ static void *Run( void *opaque )
 
         vlc_testcancel();
 
-        bool results_available = false;
-        while( vlc_array_count( &p_sys->processing.queue ) )
+        for (;;)
         {
             int canc = vlc_savecancel();
-            fingerprint_request_t *p_data = vlc_array_item_at_index( &p_sys->processing.queue, 0 );
+
+            // the fingerprint request must not exist both in the
+            // processing and results queue, even in case of thread
+            // cancellation, so take it out of the queue before working
+            fingerprint_request_t *p_data = NULL;
+            vlc_mutex_lock( &p_sys->processing.lock );
+            if( vlc_array_count( &p_sys->processing.queue ) )
+            {
+                p_data = vlc_array_item_at_index( &p_sys->processing.queue, 0 );
+                vlc_array_remove( &p_sys->processing.queue, 0 );
+            }
+            vlc_mutex_unlock( &p_sys->processing.lock );
+
+            if( p_data == NULL )
+            {
+                vlc_restorecancel(canc);
+                break;
+            }
 
             char *psz_uri = input_item_GetURI( p_data->p_item );
             if ( psz_uri != NULL )
@@ -367,7 +472,7 @@ static void *Run( void *opaque )
                 if ( p_data->i_duration )
                      acoustid_print.i_duration = p_data->i_duration;
 
-                DoFingerprint( p_fingerprinter, &acoustid_print, psz_uri );
+                DoFingerprint( p_worker, &acoustid_print, psz_uri );
                 free( psz_uri );
 
                 acoustid_config_t cfg = { .p_obj = VLC_OBJECT(p_fingerprinter),
@@ -381,28 +486,22 @@ static void *Run( void *opaque )
                     free( acoustid_print.results.p_results );
                 free( acoustid_print.psz_fingerprint );
             }
-            vlc_restorecancel(canc);
 
             /* copy results */
+            bool results_available = false;
             vlc_mutex_lock( &p_sys->results.lock );
             if( vlc_array_append( &p_sys->results.queue, p_data ) )
                 fingerprint_request_Delete( p_data );
             else
                 results_available = true;
             vlc_mutex_unlock( &p_sys->results.lock );
+            vlc_restorecancel(canc);
 
-            // the fingerprint request must not exist both in the
-            // processing and results queue, even in case of thread
-            // cancellation, so remove it immediately
-            vlc_array_remove( &p_sys->processing.queue, 0 );
+            if ( results_available )
+                var_TriggerCallback( p_fingerprinter, "results-available" );
 
             vlc_testcancel();
         }
-
-        if ( results_available )
-        {
-            var_TriggerCallback( p_fingerprinter, "results-available" );
-        }
     }
 
     vlc_assert_unreachable();
@@ -32,6 +32,18 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_LINUX_TLS_H
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+# include <linux/tls.h>
+# ifndef TCP_ULP
+#  define TCP_ULP 31
+# endif
+# ifndef SOL_TLS
+#  define SOL_TLS 282
+# endif
+#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -47,6 +59,8 @@ typedef struct vlc_tls_gnutls
     vlc_tls_t tls;
     gnutls_session_t session;
     vlc_object_t *obj;
+    bool ktls; /* try to offload the records encryption to the kernel */
+    bool ktls_tx; /* the kernel encrypts the sent records */
 } vlc_tls_gnutls_t;
 
 static void gnutls_Banner(vlc_object_t *obj)
@@ -127,6 +141,159 @@ static ssize_t vlc_gnutls_writev(gnutls_transport_ptr_t ptr,
     return sock->ops->writev(sock, iov, iovcnt);
 }
 
+#ifdef HAVE_LINUX_TLS_H
+/*
+ * Kernel TLS (Linux): once the handshake is complete, the sending keys are
+ * handed over to the kernel which then encrypts the records. The data is
+ * written to the socket as is, without going through GnuTLS. Receiving
+ * (and all the handshake messages) still goes through GnuTLS.
+ */
+static int gnutls_KeyUpdateHook(gnutls_session_t session, unsigned type,
+                                unsigned when, unsigned incoming,
+                                const gnutls_datum_t *msg)
+{
+    /* The kernel sending keys cannot be updated from here. */
+    (void) session; (void) type; (void) when; (void) incoming; (void) msg;
+    return GNUTLS_E_UNIMPLEMENTED_FEATURE;
+}
+
+static void gnutls_KTLSNonce(unsigned char *salt, unsigned char *iv,
+                             const gnutls_datum_t *giv,
+                             const unsigned char *seq, unsigned version)
+{
+    memcpy(salt, giv->data, 4);
+    if (version == TLS_1_2_VERSION)
+        memcpy(iv, seq, 8); /* explicit nonce = sequence number */
+    else
+        memcpy(iv, giv->data + 4, 8);
+}
+
+static void gnutls_KTLSEnable(vlc_tls_gnutls_t *priv)
+{
+    gnutls_session_t session = priv->session;
+    vlc_tls_t *sock = gnutls_transport_get_ptr(session);
+
+    /* Only directly on top of a TCP socket */
+    int fd = (sock->p == NULL) ? vlc_tls_GetFD(sock) : -1;
+    if (fd == -1)
+        return;
+
+    unsigned version;
+    switch (gnutls_protocol_get_version(session))
+    {
+        case GNUTLS_TLS1_2:
+            version = TLS_1_2_VERSION;
+            break;
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+        case GNUTLS_TLS1_3:
+            version = TLS_1_3_VERSION;
+            break;
+#endif
+        default:
+            return;
+    }
+
+    gnutls_datum_t mac, iv, key;
+    unsigned char seq[8];
+
+    if (gnutls_record_get_state(session, 0, &mac, &iv, &key, seq) != 0)
+        return;
+
+    union
+    {
+        struct tls12_crypto_info_aes_gcm_128 gcm128;
+        struct tls12_crypto_info_aes_gcm_256 gcm256;
+    } info;
+    socklen_t infolen;
+
+    memset(&info, 0, sizeof (info));
+
+    switch (gnutls_cipher_get(session))
+    {
+        case GNUTLS_CIPHER_AES_128_GCM:
+            if (key.size != sizeof (info.gcm128.key) || iv.size < 4
+             || (version == TLS_1_3_VERSION && iv.size != 12))
+                return;
+            info.gcm128.info.version = version;
+            info.gcm128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+            memcpy(info.gcm128.key, key.data, key.size);
+            gnutls_KTLSNonce(info.gcm128.salt, info.gcm128.iv, &iv, seq,
+                             version);
+            memcpy(info.gcm128.rec_seq, seq, sizeof (seq));
+            infolen = sizeof (info.gcm128);
+            break;
+
+        case GNUTLS_CIPHER_AES_256_GCM:
+            if (key.size != sizeof (info.gcm256.key) || iv.size < 4
+             || (version == TLS_1_3_VERSION && iv.size != 12))
+                return;
+            info.gcm256.info.version = version;
+            info.gcm256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+            memcpy(info.gcm256.key, key.data, key.size);
+            gnutls_KTLSNonce(info.gcm256.salt, info.gcm256.iv, &iv, seq,
+                             version);
+            memcpy(info.gcm256.rec_seq, seq, sizeof (seq));
+            infolen = sizeof (info.gcm256);
+            break;
+
+        default:
+            msg_Dbg(priv->obj, "kernel TLS not supported with %s",
+                    gnutls_cipher_get_name(gnutls_cipher_get(session)));
+            return;
+    }
+
+    if (setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof ("tls"))
+     || setsockopt(fd, SOL_TLS, TLS_TX, &info, infolen))
+    {
+        msg_Dbg(priv->obj, "kernel TLS not available: %s",
+                vlc_strerror_c(errno));
+        memset(&info, 0, sizeof (info));
+        return;
+    }
+    memset(&info, 0, sizeof (info));
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+    if (version == TLS_1_3_VERSION)
+        gnutls_handshake_set_hook_function(session,
+                                           GNUTLS_HANDSHAKE_KEY_UPDATE,
+                                           GNUTLS_HOOK_PRE,
+                                           gnutls_KeyUpdateHook);
+#endif
+    priv->ktls_tx = true;
+    msg_Dbg(priv->obj, " - kernel TLS sending enabled");
+}
+
+static int gnutls_KTLSBye(vlc_tls_gnutls_t *priv)
+{
+    vlc_tls_t *sock = gnutls_transport_get_ptr(priv->session);
+    /* close_notify warning alert, sent by the kernel in an alert record */
+    static const unsigned char alert[2] = { 1, 0 };
+    struct iovec iov = {
+        .iov_base = (void *)alert,
+        .iov_len = sizeof (alert),
+    };
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (unsigned char))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof (control.buf),
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (unsigned char));
+    *CMSG_DATA(cmsg) = 21; /* alert record */
+
+    return (sendmsg(vlc_tls_GetFD(sock), &msg, MSG_NOSIGNAL) < 0) ? -1 : 0;
+}
+#endif
+
 static int gnutls_GetFD(vlc_tls_t *tls, short *restrict events)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
@@ -166,6 +333,14 @@ static ssize_t gnutls_Send (vlc_tls_t *tls, const struct iovec *iov,
     gnutls_session_t session = priv->session;
     ssize_t val;
 
+#ifdef HAVE_LINUX_TLS_H
+    if (priv->ktls_tx)
+    {
+        vlc_tls_t *sock = gnutls_transport_get_ptr(session);
+        return sock->ops->writev(sock, iov, count);
+    }
+#endif
+
     if (!gnutls_record_check_corked(session))
     {
         gnutls_record_cork(session);
@@ -191,6 +366,12 @@ static int gnutls_Shutdown(vlc_tls_t *tls, bool duplex)
     gnutls_session_t session = priv->session;
     ssize_t val;
 
+#ifdef HAVE_LINUX_TLS_H
+    /* GnuTLS cannot send anymore, the kernel owns the sending state */
+    if (priv->ktls_tx)
+        return gnutls_KTLSBye(priv);
+#endif
+
     /* Flush any pending data */
     val = gnutls_record_uncork(session, 0);
     if (val < 0)
@@ -295,6 +476,8 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
 
     priv->session = session;
     priv->obj = obj;
+    priv->ktls = false;
+    priv->ktls_tx = false;
 
     vlc_tls_t *tls = &priv->tls;
 
@@ -352,6 +535,10 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
         msg_Dbg(obj, " - encrypt then MAC (RFC7366) enabled");
     if (flags & GNUTLS_SFLAGS_FALSE_START)
         msg_Dbg(obj, " - false start (RFC7918) enabled");
+#ifdef HAVE_LINUX_TLS_H
+    if (priv->ktls)
+        gnutls_KTLSEnable(priv);
+#endif
 
     if (alp != NULL)
     {
@@ -373,6 +560,93 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
     return 0;
 }
 
+/*
+ * Client session resumption data, by server name, so that reconnecting to
+ * the same server spares the full handshake and certificate verification.
+ * This is shared by all credentials, as they are typically short-lived.
+ */
+#define GNUTLS_RESUME_MAX 16
+
+static struct
+{
+    vlc_mutex_t lock;
+    char *hosts[GNUTLS_RESUME_MAX];
+    gnutls_datum_t data[GNUTLS_RESUME_MAX];
+    unsigned next;
+} gnutls_resume = { VLC_STATIC_MUTEX, { NULL }, { { NULL, 0 } }, 0 };
+
+static void gnutls_SessionSave(gnutls_session_t session)
+{
+    char host[256];
+    size_t len = sizeof (host);
+    unsigned type;
+    gnutls_datum_t data;
+
+    if (gnutls_server_name_get(session, host, &len, &type, 0) != 0
+     || type != GNUTLS_NAME_DNS)
+        return;
+    if (gnutls_session_get_data2(session, &data) != 0)
+        return;
+
+    char *name = strdup(host);
+    if (unlikely(name == NULL))
+    {
+        gnutls_free(data.data);
+        return;
+    }
+
+    vlc_mutex_lock(&gnutls_resume.lock);
+    unsigned i;
+
+    for (i = 0; i < GNUTLS_RESUME_MAX; i++)
+        if (gnutls_resume.hosts[i] != NULL
+         && !strcmp(gnutls_resume.hosts[i], host))
+            break;
+
+    if (i == GNUTLS_RESUME_MAX)
+    {
+        i = gnutls_resume.next;
+        gnutls_resume.next = (i + 1) % GNUTLS_RESUME_MAX;
+    }
+
+    free(gnutls_resume.hosts[i]);
+    gnutls_free(gnutls_resume.data[i].data);
+    gnutls_resume.hosts[i] = name;
+    gnutls_resume.data[i] = data;
+    vlc_mutex_unlock(&gnutls_resume.lock);
+}
+
+static void gnutls_SessionResume(gnutls_session_t session, const char *host)
+{
+    vlc_mutex_lock(&gnutls_resume.lock);
+    for (unsigned i = 0; i < GNUTLS_RESUME_MAX; i++)
+        if (gnutls_resume.hosts[i] != NULL
+         && !strcmp(gnutls_resume.hosts[i], host))
+        {   /* TLS 1.3 tickets should be used only once */
+            gnutls_session_set_data(session, gnutls_resume.data[i].data,
+                                    gnutls_resume.data[i].size);
+            free(gnutls_resume.hosts[i]);
+            gnutls_free(gnutls_resume.data[i].data);
+            gnutls_resume.hosts[i] = NULL;
+            gnutls_resume.data[i].data = NULL;
+            break;
+        }
+    vlc_mutex_unlock(&gnutls_resume.lock);
+}
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+/* TLS 1.3 tickets are sent by the server after the handshake. */
+static int gnutls_TicketHook(gnutls_session_t session, unsigned type,
+                             unsigned when, unsigned incoming,
+                             const gnutls_datum_t *msg)
+{
+    if (gnutls_protocol_get_version(session) == GNUTLS_TLS1_3)
+        gnutls_SessionSave(session);
+    (void) type; (void) when; (void) incoming; (void) msg;
+    return 0;
+}
+#endif
+
 static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
                                            vlc_tls_t *sk, const char *hostname,
                                            const char *const *alpn)
@@ -388,10 +662,18 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
     gnutls_dh_set_prime_bits (session, 1024);
 
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
+        gnutls_SessionResume(session, hostname);
+    }
 
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+    gnutls_handshake_set_hook_function(session,
+                                       GNUTLS_HANDSHAKE_NEW_SESSION_TICKET,
+                                       GNUTLS_HOOK_POST, gnutls_TicketHook);
+#endif
     return &priv->tls;
 }
 
@@ -418,8 +700,11 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
         goto error;
     }
 
+    if (gnutls_session_is_resumed(session))
+        msg_Dbg(obj, " - session resumed");
+
     if (status == 0) /* Good certificate */
-        return 0;
+        goto ok;
 
     /* Bad certificate */
     gnutls_datum_t desc;
@@ -457,7 +742,7 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     {
         case 0:
             msg_Dbg(obj, "certificate key match for %s", host);
-            return 0;
+            goto ok;
         case GNUTLS_E_NO_CERTIFICATE_FOUND:
             msg_Dbg(obj, "no known certificates for %s", host);
             msg = N_("However, the security certificate presented by the "
@@ -521,6 +806,11 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
         default:
             goto error;
     }
+ok:
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+    if (gnutls_protocol_get_version(session) != GNUTLS_TLS1_3)
+#endif
+        gnutls_SessionSave(session);
     return 0;
 
 error:
@@ -599,6 +889,7 @@ typedef struct vlc_tls_creds_sys
 {
     gnutls_certificate_credentials_t x509_cred;
     gnutls_dh_params_t dh_params;
+    bool ktls;
 } vlc_tls_creds_sys_t;
 
 /**
@@ -611,7 +902,11 @@ static vlc_tls_t *gnutls_ServerSessionOpen(vlc_tls_server_t *crd,
     vlc_tls_creds_sys_t *sys = crd->sys;
     vlc_tls_gnutls_t *priv = gnutls_SessionOpen(VLC_OBJECT(crd), GNUTLS_SERVER,
                                                 sys->x509_cred, sk, alpn);
-    return (priv != NULL) ? &priv->tls : NULL;
+    if (priv == NULL)
+        return NULL;
+
+    priv->ktls = sys->ktls;
+    return &priv->tls;
 }
 
 static void gnutls_ServerDestroy(vlc_tls_server_t *crd)
@@ -711,6 +1006,12 @@ static int OpenServer(vlc_tls_server_t *crd, const char *cert, const char *key)
 
     msg_Dbg (crd, "ciphers parameters loaded");
 
+#ifdef HAVE_LINUX_TLS_H
+    sys->ktls = var_InheritBool(crd, "gnutls-ktls");
+#else
+    sys->ktls = false;
+#endif
+
     crd->ops = &gnutls_ServerOps;
     crd->sys = sys;
     return VLC_SUCCESS;
@@ -751,6 +1052,12 @@ static const char *const priorities_text[] = {
     N_("Export (include insecure ciphers)"),
 };
 
+#define KTLS_TEXT N_("Kernel TLS offload")
+#define KTLS_LONGTEXT N_( \
+    "Let the operating system kernel encrypt the data sent by the TLS " \
+    "servers (AES-GCM cipher suites only). This spares a copy of the " \
+    "data and the encryption in user space.")
+
 vlc_module_begin ()
     set_shortname( "GNU TLS" )
     set_description( N_("GNU TLS transport layer security") )
@@ -765,6 +1072,9 @@ vlc_module_begin ()
     add_string ("gnutls-priorities", "NORMAL", PRIORITIES_TEXT,
                 PRIORITIES_LONGTEXT, false)
         change_string_list (priorities_values, priorities_text)
+#if defined (ENABLE_SOUT) && defined (HAVE_LINUX_TLS_H)
+    add_bool("gnutls-ktls", false, KTLS_TEXT, KTLS_LONGTEXT, true)
+#endif
 #ifdef ENABLE_SOUT
     add_submodule ()
         set_description( N_("GNU TLS server") )
@@ -24,10 +24,18 @@
 
 #include "medialibrary.h"
 
+#include <algorithm>
+
 MetadataExtractor::MetadataExtractor( vlc_object_t* parent )
-    : m_currentCtx( nullptr )
+    : m_nbLocal( 0 )
+    , m_nbNetwork( 0 )
+    , m_stopped( false )
     , m_obj( parent )
 {
+    m_maxLocal = std::max<int64_t>( 1,
+                    var_InheritInteger( parent, "ml-parser-local-threads" ) );
+    m_maxNetwork = std::max<int64_t>( 1,
+                    var_InheritInteger( parent, "ml-parser-network-threads" ) );
 }
 
 void MetadataExtractor::onParserEnded( ParseContext& ctx, int status )
@@ -37,7 +45,30 @@ void MetadataExtractor::onParserEnded( ParseContext& ctx, int status )
     // We need to probe the item now, but not from the input thread
     ctx.success = status == VLC_SUCCESS;
     ctx.needsProbing = true;
-    ctx.mde->m_cond.signal();
+    ctx.mde->m_cond.broadcast();
+}
+
+bool MetadataExtractor::acquireSlot( ParseContext& ctx )
+{
+    // Called with m_mutex held
+    auto& nbRunning = ctx.network ? m_nbNetwork : m_nbLocal;
+    const auto maxRunning = ctx.network ? m_maxNetwork : m_maxLocal;
+    while ( nbRunning >= maxRunning && m_stopped == false )
+        m_cond.wait( m_mutex );
+    if ( m_stopped == true )
+        return false;
+    nbRunning++;
+    m_contexts.push_back( &ctx );
+    return true;
+}
+
+void MetadataExtractor::releaseSlot( ParseContext& ctx )
+{
+    // Called with m_mutex held
+    auto& nbRunning = ctx.network ? m_nbNetwork : m_nbLocal;
+    nbRunning--;
+    m_contexts.erase( std::find( begin( m_contexts ), end( m_contexts ), &ctx ) );
+    m_cond.broadcast();
 }
 
 void MetadataExtractor::populateItem( medialibrary::parser::IItem& item, input_item_t* inputItem )
@@ -147,27 +178,36 @@ medialibrary::parser::Status MetadataExtractor::run( medialibrary::parser::IItem
     if ( ctx.inputItem == nullptr )
         return medialibrary::parser::Status::Fatal;
 
+    ctx.network = item.mrl().compare( 0, 7, "file://" ) != 0;
+
     const input_item_parser_cbs_t cbs = {
         &MetadataExtractor::onParserEnded,
         &MetadataExtractor::onParserSubtreeAdded,
     };
-    m_currentCtx = &ctx;
     ctx.inputItem->i_preparse_depth = 1;
-    ctx.inputParser = {
-        input_item_Parse( ctx.inputItem.get(), m_obj, &cbs,
-                          std::addressof( ctx ) ),
-        &input_item_parser_id_Release
-    };
-    if ( ctx.inputParser == nullptr )
-    {
-        m_currentCtx = nullptr;
-        return medialibrary::parser::Status::Fatal;
-    }
 
+    // The preparser only runs the demuxer: no decoder nor output is created,
+    // which is all we need to extract the metadata and the tracks. Several
+    // items can be parsed at once, up to the limit of their device kind.
+    bool success = false;
     {
         vlc::threads::mutex_locker lock( m_mutex );
+        if ( acquireSlot( ctx ) == false )
+            return medialibrary::parser::Status::Fatal;
+
+        ctx.inputParser = {
+            input_item_Parse( ctx.inputItem.get(), m_obj, &cbs,
+                              std::addressof( ctx ) ),
+            &input_item_parser_id_Release
+        };
+        if ( ctx.inputParser == nullptr )
+        {
+            releaseSlot( ctx );
+            return medialibrary::parser::Status::Fatal;
+        }
+
         auto deadline = vlc_tick_now() + VLC_TICK_FROM_SEC( 5 );
-        while ( ctx.needsProbing == false && ctx.inputParser != nullptr )
+        while ( ctx.needsProbing == false )
         {
             auto res = m_cond.timedwait( m_mutex, deadline );
             if ( res != 0 )
@@ -177,10 +217,11 @@ medialibrary::parser::Status MetadataExtractor::run( medialibrary::parser::IItem
                 break;
             }
         }
-        m_currentCtx = nullptr;
+        success = ctx.needsProbing && ctx.success;
+        releaseSlot( ctx );
     }
 
-    if ( !ctx.success || ctx.inputParser == nullptr )
+    if ( !success )
         return medialibrary::parser::Status::Fatal;
 
     if ( item.fileType() == medialibrary::IFile::Type::Playlist &&
@@ -218,6 +259,8 @@ void MetadataExtractor::onRestarted()
 void MetadataExtractor::stop()
 {
     vlc::threads::mutex_locker lock{ m_mutex };
-    if ( m_currentCtx != nullptr )
-        input_item_parser_id_Interrupt( m_currentCtx->inputParser.get() );
+    m_stopped = true;
+    for ( auto ctx : m_contexts )
+        input_item_parser_id_Interrupt( ctx->inputParser.get() );
+    m_cond.broadcast();
 }
@@ -179,29 +179,44 @@ static bool request_metadata_sync( libvlc_int_t *libvlc, input_item_t *media,
 void
 SDDirectory::read() const
 {
-    auto media = vlc::wrap_cptr( input_item_New(m_mrl.c_str(), m_mrl.c_str()),
-                                 &input_item_Release );
-    if (!media)
-        throw std::bad_alloc();
+    auto listing = m_fs.cachedListing(m_mrl);
+    if (!listing)
+    {
+        auto media = vlc::wrap_cptr( input_item_New(m_mrl.c_str(), m_mrl.c_str()),
+                                     &input_item_Release );
+        if (!media)
+            throw std::bad_alloc();
 
-    std::vector<InputItemPtr> children;
+        std::vector<InputItemPtr> children;
 
-    auto status = request_metadata_sync( m_fs.libvlc(), media.get(), &children);
+        auto status = request_metadata_sync( m_fs.libvlc(), media.get(), &children);
 
-    if ( status == false )
-        throw medialibrary::fs::errors::System( EIO,
-            "Failed to browse network directory: Unknown error" );
+        if ( status == false )
+            throw medialibrary::fs::errors::System( EIO,
+                "Failed to browse network directory: Unknown error" );
 
-    for (const InputItemPtr &m : children)
-    {
-        const char *mrl = m.get()->psz_uri;
-        enum input_item_type_e type = m->i_type;
-        if (type == ITEM_TYPE_DIRECTORY)
-            m_dirs.push_back(std::make_shared<SDDirectory>(mrl, m_fs));
-        else if (type == ITEM_TYPE_FILE)
-            m_files.push_back(std::make_shared<SDFile>(mrl));
+        auto newListing = std::make_shared<SDDirectoryListing>();
+        newListing->date = vlc_tick_now();
+        for (const InputItemPtr &m : children)
+        {
+            const char *mrl = m.get()->psz_uri;
+            enum input_item_type_e type = m->i_type;
+            if (type == ITEM_TYPE_DIRECTORY)
+                newListing->dirs.emplace_back(mrl);
+            else if (type == ITEM_TYPE_FILE)
+                newListing->files.push_back(std::make_shared<SDFile>(mrl));
+        }
+        m_fs.cacheListing(m_mrl, newListing);
+        listing = std::move(newListing);
     }
 
+    /* the files are immutable and can be shared, but the directories cache
+     * their own content, so they are created for each listing */
+    m_files = listing->files;
+    m_dirs.reserve(listing->dirs.size());
+    for (const std::string &mrl : listing->dirs)
+        m_dirs.push_back(std::make_shared<SDDirectory>(mrl, m_fs));
+
     m_read_done = true;
 }
 
@@ -67,6 +67,9 @@ namespace vlc {
 
 using namespace ::medialibrary;
 
+/* how long a directory listing is reused before browsing it again */
+#define LISTING_CACHE_DELAY VLC_TICK_FROM_SEC(60)
+
 SDFileSystemFactory::SDFileSystemFactory(vlc_object_t *parent,
                                          const std::string &scheme)
     : m_parent(parent)
@@ -195,6 +198,41 @@ SDFileSystemFactory::libvlc() const
     return vlc_object_instance(m_parent);
 }
 
+std::shared_ptr<const SDDirectoryListing>
+SDFileSystemFactory::cachedListing(const std::string &mrl)
+{
+    vlc::threads::mutex_locker locker(m_listingsMutex);
+
+    auto it = m_listings.find(mrl);
+    if (it == m_listings.end())
+        return nullptr;
+    if (it->second->date + LISTING_CACHE_DELAY < vlc_tick_now())
+    {
+        m_listings.erase(it);
+        return nullptr;
+    }
+    return it->second;
+}
+
+void
+SDFileSystemFactory::cacheListing(const std::string &mrl,
+                                  std::shared_ptr<const SDDirectoryListing> listing)
+{
+    vlc::threads::mutex_locker locker(m_listingsMutex);
+
+    /* drop the expired listings, so that the cache only holds the
+     * directories being scanned */
+    vlc_tick_t now = vlc_tick_now();
+    for (auto it = m_listings.begin(); it != m_listings.end(); )
+    {
+        if (it->second->date + LISTING_CACHE_DELAY < now)
+            it = m_listings.erase(it);
+        else
+            ++it;
+    }
+    m_listings[mrl] = std::move(listing);
+}
+
 void
 SDFileSystemFactory::onDeviceAdded(input_item_t *media)
 {
@@ -254,6 +292,16 @@ SDFileSystemFactory::onDeviceRemoved(input_item_t *media)
             m_callbacks->onDeviceUnmounted( *(*it), mrl );
         }
     }
+
+    /* the content may change before the device is mounted again */
+    vlc::threads::mutex_locker locker(m_listingsMutex);
+    for (auto it = m_listings.begin(); it != m_listings.end(); )
+    {
+        if (it->first.compare(0, mrl.length(), mrl) == 0)
+            it = m_listings.erase(it);
+        else
+            ++it;
+    }
 }
 
   } /* namespace medialibrary */
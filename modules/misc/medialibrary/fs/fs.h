@@ -22,6 +22,8 @@
 #define SD_FS_H
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <vlc_common.h>
 #include <vlc_threads.h>
@@ -45,6 +47,14 @@ namespace vlc {
 using namespace ::medialibrary;
 using namespace ::medialibrary::fs;
 
+/* Result of a directory browsing, shared by all the directory instances
+ * created for the same mrl while it is cached */
+struct SDDirectoryListing {
+    vlc_tick_t date;
+    std::vector<std::shared_ptr<fs::IFile>> files;
+    std::vector<std::string> dirs;
+};
+
 class SDFileSystemFactory : public IFileSystemFactory {
 public:
     SDFileSystemFactory(vlc_object_t *m_parent,
@@ -83,6 +93,16 @@ public:
     libvlc_int_t *
     libvlc() const;
 
+    /* Browsing a network directory is slow, and the media library lists
+     * the same directories repeatedly, for instance to create each of their
+     * files, so the listings are kept for a while */
+    std::shared_ptr<const SDDirectoryListing>
+    cachedListing(const std::string &mrl);
+
+    void
+    cacheListing(const std::string &mrl,
+                 std::shared_ptr<const SDDirectoryListing> listing);
+
     /* public to be called from C callback */
     void onDeviceAdded(input_item_t *media);
     void onDeviceRemoved(input_item_t *media);
@@ -97,6 +117,10 @@ private:
     std::vector<std::shared_ptr<IDevice>> m_devices;
     using SdPtr = std::unique_ptr<services_discovery_t, decltype(&vlc_sd_Destroy)>;
     std::vector<SdPtr> m_sds;
+
+    vlc::threads::mutex m_listingsMutex;
+    std::unordered_map<std::string,
+                       std::shared_ptr<const SDDirectoryListing>> m_listings;
 };
 
   } /* namespace medialibrary */
@@ -39,6 +39,7 @@
 #include <medialibrary/IShow.h>
 #include <medialibrary/IPlaylist.h>
 
+#include <algorithm>
 #include <sstream>
 #include <initializer_list>
 
@@ -314,6 +315,13 @@ void MediaLibrary::onMediaThumbnailReady( medialibrary::MediaPtr media,
                                           medialibrary::ThumbnailSizeType sizeType,
                                           bool success )
 {
+    {
+        vlc::threads::mutex_locker lock( m_thumbnailLock );
+        if ( m_thumbnailInFlight.mediaId == media->id() )
+            m_thumbnailInFlight.mediaId = 0;
+    }
+    dispatchThumbnails();
+
     vlc_ml_event_t ev;
     ev.i_type = VLC_ML_EVENT_MEDIA_THUMBNAIL_GENERATED;
     ev.media_thumbnail_generated.b_success = success;
@@ -356,6 +364,8 @@ void MediaLibrary::onRescanStarted()
 
 MediaLibrary::MediaLibrary( vlc_medialibrary_module_t* ml )
     : m_vlc_ml( ml )
+    , m_thumbnailInFlight{}
+    , m_thumbnailDeadline( VLC_TICK_INVALID )
 {
     m_ml.reset( NewMediaLibrary() );
 
@@ -584,6 +594,13 @@ int MediaLibrary::Control( int query, va_list args )
         case VLC_ML_MEDIA_ADD_EXTERNAL_MRL:
         case VLC_ML_MEDIA_SET_TYPE:
             return controlMedia( query, args );
+        case VLC_ML_MEDIA_CANCEL_THUMBNAIL:
+        {
+            auto mediaId = va_arg( args, int64_t );
+            auto sizeType = va_arg( args, int );
+            cancelThumbnail( mediaId, sizeType );
+            return VLC_SUCCESS;
+        }
         default:
             return VLC_EGENERIC;
     }
@@ -1153,6 +1170,72 @@ int MediaLibrary::setMeta( medialibrary::IMedia& media,
     return VLC_SUCCESS;
 }
 
+void MediaLibrary::queueThumbnail( const ThumbnailRequest& request )
+{
+    {
+        vlc::threads::mutex_locker lock( m_thumbnailLock );
+        if ( m_thumbnailInFlight.mediaId == request.mediaId &&
+             m_thumbnailInFlight.sizeType == request.sizeType )
+            return;
+        /* A request already queued is moved to the front */
+        auto it = std::find_if( begin( m_thumbnailQueue ), end( m_thumbnailQueue ),
+                                [&request]( const ThumbnailRequest& r ) {
+            return r.mediaId == request.mediaId && r.sizeType == request.sizeType;
+        });
+        if ( it != end( m_thumbnailQueue ) )
+            m_thumbnailQueue.erase( it );
+        /* The oldest requests are the least likely to still be displayed,
+         * they will be requested again if needed */
+        if ( m_thumbnailQueue.size() >= 256 )
+            m_thumbnailQueue.erase( begin( m_thumbnailQueue ) );
+        m_thumbnailQueue.push_back( request );
+    }
+    dispatchThumbnails();
+}
+
+void MediaLibrary::cancelThumbnail( int64_t mediaId, int sizeType )
+{
+    vlc::threads::mutex_locker lock( m_thumbnailLock );
+    auto it = std::find_if( begin( m_thumbnailQueue ), end( m_thumbnailQueue ),
+                            [mediaId, sizeType]( const ThumbnailRequest& r ) {
+        return r.mediaId == mediaId && r.sizeType == sizeType;
+    });
+    if ( it != end( m_thumbnailQueue ) )
+        m_thumbnailQueue.erase( it );
+}
+
+void MediaLibrary::dispatchThumbnails()
+{
+    for ( ;; )
+    {
+        ThumbnailRequest request;
+        {
+            vlc::threads::mutex_locker lock( m_thumbnailLock );
+            /* Don't wait forever on a request the medialibrary dropped */
+            if ( m_thumbnailInFlight.mediaId != 0 &&
+                 vlc_tick_now() < m_thumbnailDeadline )
+                return;
+            m_thumbnailInFlight.mediaId = 0;
+            if ( m_thumbnailQueue.empty() )
+                return;
+            request = m_thumbnailQueue.back();
+            m_thumbnailQueue.pop_back();
+            m_thumbnailInFlight = request;
+            m_thumbnailDeadline = vlc_tick_now() + VLC_TICK_FROM_SEC( 10 );
+        }
+
+        auto m = m_ml->media( request.mediaId );
+        if ( m != nullptr &&
+             m->requestThumbnail( static_cast<medialibrary::ThumbnailSizeType>( request.sizeType ),
+                                  request.width, request.height, request.position ) == true )
+            return;
+
+        vlc::threads::mutex_locker lock( m_thumbnailLock );
+        if ( m_thumbnailInFlight.mediaId == request.mediaId )
+            m_thumbnailInFlight.mediaId = 0;
+    }
+}
+
 int MediaLibrary::controlMedia( int query, va_list args )
 {
     auto mediaId = va_arg( args, int64_t );
@@ -1200,9 +1283,8 @@ int MediaLibrary::controlMedia( int query, va_list args )
             auto width = va_arg( args, uint32_t );
             auto height = va_arg( args, uint32_t );
             auto position = va_arg( args, double );
-            auto res = m->requestThumbnail( static_cast<medialibrary::ThumbnailSizeType>( sizeType ),
-                                            width, height, position );
-            return res == true ? VLC_SUCCESS : VLC_EGENERIC;
+            queueThumbnail( ThumbnailRequest{ mediaId, sizeType, width, height, position } );
+            return VLC_SUCCESS;
         }
         case VLC_ML_MEDIA_ADD_EXTERNAL_MRL:
         {
@@ -1640,6 +1722,12 @@ static void Close( vlc_object_t* obj )
 #define ML_FOLDER_TEXT _( "Folders discovered by the media library" )
 #define ML_FOLDER_LONGTEXT _( "Semicolon separated list of folders to discover " \
                               "media from" )
+#define ML_LOCAL_THREADS_TEXT _( "Concurrent local parsers" )
+#define ML_LOCAL_THREADS_LONGTEXT _( "Maximum number of local files " \
+                                     "parsed at the same time" )
+#define ML_NETWORK_THREADS_TEXT _( "Concurrent network parsers" )
+#define ML_NETWORK_THREADS_LONGTEXT _( "Maximum number of network files " \
+                                       "parsed at the same time" )
 
 vlc_module_begin()
     set_shortname(N_("media library"))
@@ -1649,4 +1737,8 @@ vlc_module_begin()
     set_capability("medialibrary", 100)
     set_callbacks(Open, Close)
     add_string( "ml-folders", nullptr, ML_FOLDER_TEXT, ML_FOLDER_LONGTEXT, false )
+    add_integer_with_range( "ml-parser-local-threads", 4, 1, 32,
+                            ML_LOCAL_THREADS_TEXT, ML_LOCAL_THREADS_LONGTEXT, true )
+    add_integer_with_range( "ml-parser-network-threads", 2, 1, 32,
+                            ML_NETWORK_THREADS_TEXT, ML_NETWORK_THREADS_LONGTEXT, true )
 vlc_module_end()
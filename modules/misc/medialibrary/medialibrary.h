@@ -36,6 +36,7 @@
 #include <vlc_cxx_helpers.hpp>
 
 #include <cstdarg>
+#include <vector>
 
 struct vlc_event_t;
 struct vlc_object_t;
@@ -52,6 +53,7 @@ private:
         ParseContext( MetadataExtractor* mde, medialibrary::parser::IItem& item )
             : needsProbing( false )
             , success( false )
+            , network( false )
             , mde( mde )
             , item( item )
             , inputItem( nullptr, &input_item_Release )
@@ -61,6 +63,7 @@ private:
 
         bool needsProbing;
         bool success;
+        bool network;
         MetadataExtractor* mde;
         medialibrary::parser::IItem& item;
         std::unique_ptr<input_item_t, decltype(&input_item_Release)> inputItem;
@@ -85,6 +88,8 @@ private:
     virtual void stop() override;
 
     void onParserEnded( ParseContext& ctx, int status );
+    bool acquireSlot( ParseContext& ctx );
+    void releaseSlot( ParseContext& ctx );
     void addSubtree( ParseContext& ctx, input_item_node_t *root );
     void populateItem( medialibrary::parser::IItem& item, input_item_t* inputItem );
 
@@ -95,7 +100,16 @@ private:
 private:
     vlc::threads::condition_variable m_cond;
     vlc::threads::mutex m_mutex;
-    ParseContext* m_currentCtx;
+    // Parsers currently running, all interrupted by stop()
+    std::vector<ParseContext*> m_contexts;
+    // Number of parsers running and allowed to run per device kind, since
+    // a network share is slowed down by concurrent accesses while a local
+    // drive is not
+    unsigned m_nbLocal;
+    unsigned m_nbNetwork;
+    unsigned m_maxLocal;
+    unsigned m_maxNetwork;
+    bool m_stopped;
     vlc_object_t* m_obj;
 };
 
@@ -142,7 +156,19 @@ public:
     void* Get( int query, va_list args );
 
 private:
+    struct ThumbnailRequest
+    {
+        int64_t mediaId;
+        int sizeType;
+        uint32_t width;
+        uint32_t height;
+        double position;
+    };
+
     int controlMedia( int query, va_list args );
+    void queueThumbnail( const ThumbnailRequest& request );
+    void cancelThumbnail( int64_t mediaId, int sizeType );
+    void dispatchThumbnails();
     int getMeta( const medialibrary::IMedia& media, int meta, char** result );
     int getMeta( const medialibrary::IMedia& media, vlc_ml_playback_states_all* result );
     int setMeta( medialibrary::IMedia& media, int meta, const char* value );
@@ -165,6 +191,13 @@ private:
     std::unique_ptr<Logger> m_logger;
     std::unique_ptr<medialibrary::IMediaLibrary> m_ml;
 
+    /* The medialibrary generates thumbnails one at a time, in request order.
+     * Requests are kept here, and forwarded one by one, latest first */
+    vlc::threads::mutex m_thumbnailLock;
+    std::vector<ThumbnailRequest> m_thumbnailQueue;
+    ThumbnailRequest m_thumbnailInFlight;
+    vlc_tick_t m_thumbnailDeadline;
+
     // IMediaLibraryCb interface
 public:
     virtual void onMediaAdded(std::vector<medialibrary::MediaPtr> media) override;
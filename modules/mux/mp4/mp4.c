@@ -54,6 +54,17 @@
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
 
+#define FRAGMENTED_TEXT N_("Create fragmented files")
+#define FRAGMENTED_LONGTEXT N_(\
+    "Write the samples as movie fragments while recording, instead of " \
+    "keeping their index in memory until the end. Memory use does " \
+    "not grow with the recording length, and files stay playable if " \
+    "the recording is interrupted.")
+
+#define FRAGLENGTH_TEXT N_("Fragments duration")
+#define FRAGLENGTH_LONGTEXT N_(\
+    "Target duration of the movie fragments, in milliseconds.")
+
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
 static void CloseFrag  (vlc_object_t *);
@@ -69,6 +80,10 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", false,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_bool(SOUT_CFG_PREFIX "fragmented", false,
+             FRAGMENTED_TEXT, FRAGMENTED_LONGTEXT, true)
+    add_integer_with_range(SOUT_CFG_PREFIX "fragment-length", 1500, 100, 60000,
+                           FRAGLENGTH_TEXT, FRAGLENGTH_LONGTEXT, true)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -88,7 +103,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "fragmented", "fragment-length", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -146,6 +161,7 @@ typedef struct
     mp4_fragentry_t *p_held_entry;
     mp4_fragqueue_t  read;
     mp4_fragqueue_t  towrite;
+    mp4_fragentry_t *p_recycled; /* written entries, for reuse */
     vlc_tick_t       i_last_iframe_time;
     vlc_tick_t       i_written_duration;
     mp4_fragindex_t *p_indexentries;
@@ -172,6 +188,9 @@ typedef struct
 
 
     /* mp4frag */
+    bool           b_fragmented;
+    bool           b_mfra;
+    vlc_tick_t     i_fragment_length;
     vlc_tick_t     i_written_duration;
     uint32_t       i_mfhd_sequence;
 } sout_mux_sys_t;
@@ -201,6 +220,12 @@ static void mp4_stream_Delete(mp4_stream_t *p_stream)
         free(p_stream->towrite.p_first);
         p_stream->towrite.p_first = p_next;
     }
+    while(p_stream->p_recycled)
+    {
+        mp4_fragentry_t *p_next = p_stream->p_recycled->p_next;
+        free(p_stream->p_recycled);
+        p_stream->p_recycled = p_next;
+    }
     free(p_stream->p_indexentries);
 
     free(p_stream);
@@ -277,6 +302,8 @@ static int Open(vlc_object_t *p_this)
         if(!strcmp(p_mux->psz_mux, "mp4frag") || !strcmp(p_mux->psz_mux, "mp4stream"))
             options |= FRAGMENTED;
     }
+    if(var_GetBool(p_mux, SOUT_CFG_PREFIX "fragmented"))
+        options |= FRAGMENTED;
 
     p_sys->b_3gp = p_mux->psz_mux && !strcmp(p_mux->psz_mux, "3gp");
 
@@ -292,6 +319,12 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_written_duration= 0;
     p_sys->i_start_dts = VLC_TICK_INVALID;
     p_sys->i_mfhd_sequence = 1;
+    p_sys->b_fragmented = !!(options & FRAGMENTED);
+    /* indexes refer to moof by absolute position */
+    p_sys->b_mfra = p_sys->b_fragmented &&
+                    !(p_mux->psz_mux && !strcmp(p_mux->psz_mux, "mp4stream"));
+    p_sys->i_fragment_length = VLC_TICK_FROM_MS(
+                var_GetInteger(p_mux, SOUT_CFG_PREFIX "fragment-length"));
 
     p_mux->p_sys        = p_sys;
     p_mux->pf_control   = Control;
@@ -320,6 +353,12 @@ static void Close(vlc_object_t *p_this)
     sout_mux_t      *p_mux = (sout_mux_t*)p_this;
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
 
+    if (p_sys->b_fragmented)
+    {
+        CloseFrag(p_this);
+        return;
+    }
+
     msg_Dbg(p_mux, "Close");
 
     /* Update mdat size */
@@ -901,8 +940,6 @@ static void box_send(sout_mux_t *p_mux,  bo_t *box)
 /***************************************************************************
     MP4 Live submodule
 ****************************************************************************/
-#define FRAGMENT_LENGTH  VLC_TICK_FROM_MS(1500)
-
 #define ENQUEUE_ENTRY(object, entry) \
     do {\
         if (object.p_last)\
@@ -1214,7 +1251,8 @@ static void WriteFragmentMDAT(sout_mux_t *p_mux, size_t i_total_size)
             sout_AccessOutWrite(p_mux->p_access, p_entry->p_block);
 
             p_stream->towrite.p_first = p_entry->p_next;
-            free(p_entry);
+            p_entry->p_next = p_stream->p_recycled;
+            p_stream->p_recycled = p_entry;
             if (!p_stream->towrite.p_first)
                 p_stream->towrite.p_last = NULL;
         }
@@ -1288,7 +1326,7 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
     bo_t *moof = NULL;
-    vlc_tick_t i_barrier_time = p_sys->i_written_duration + FRAGMENT_LENGTH;
+    vlc_tick_t i_barrier_time = p_sys->i_written_duration + p_sys->i_fragment_length;
     size_t i_mdat_size = 0;
     bool b_has_samples = false;
 
@@ -1406,7 +1444,7 @@ static void CloseFrag(vlc_object_t *p_this)
 
     /* Write indexes, but only for non streamed content
        as they refer to moof by absolute position */
-    if (!strcmp(p_mux->psz_mux, "mp4frag"))
+    if (p_sys->b_mfra)
     {
         bo_t *mfra = GetMfraBox(p_mux);
         if (mfra)
@@ -1476,7 +1514,7 @@ static int MuxFrag(sout_mux_t *p_mux)
         p_stream->p_held_entry = NULL;
 
         if (p_stream->b_hasiframes && (p_heldblock->i_flags & BLOCK_FLAG_TYPE_I) &&
-            mp4mux_track_GetDuration(p_stream->tinfo) - p_sys->i_written_duration < FRAGMENT_LENGTH)
+            mp4mux_track_GetDuration(p_stream->tinfo) - p_sys->i_written_duration < p_sys->i_fragment_length)
         {
             /* Flag the last iframe time, we'll use it as boundary so it will start
                next fragment */
@@ -1491,9 +1529,20 @@ static int MuxFrag(sout_mux_t *p_mux)
 
 
     /* set temp entry */
-    p_stream->p_held_entry = malloc(sizeof(mp4_fragentry_t));
-    if (unlikely(!p_stream->p_held_entry))
-        return VLC_ENOMEM;
+    if (p_stream->p_recycled)
+    {
+        p_stream->p_held_entry = p_stream->p_recycled;
+        p_stream->p_recycled = p_stream->p_recycled->p_next;
+    }
+    else
+    {
+        p_stream->p_held_entry = malloc(sizeof(mp4_fragentry_t));
+        if (unlikely(!p_stream->p_held_entry))
+        {
+            block_Release(p_currentblock);
+            return VLC_ENOMEM;
+        }
+    }
 
     p_stream->p_held_entry->p_block  = p_currentblock;
     p_stream->p_held_entry->i_run    = p_stream->i_current_run;
@@ -1529,7 +1578,7 @@ static int MuxFrag(sout_mux_t *p_mux)
     p_sys->i_written_duration = i_min_written_duration;
 
     /* we have prerolled enough to know all streams, and have enough date to create a fragment */
-    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= FRAGMENT_LENGTH)
+    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= p_sys->i_fragment_length)
         WriteFragments(p_mux, false);
 
     return VLC_SUCCESS;
@@ -28,6 +28,8 @@
 
 #include <vlc_common.h>
 
+#include <assert.h>
+
 #include "csa.h"
 
 struct csa_t
@@ -610,3 +612,659 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+
+/*****************************************************************************
+ * Batch (de)scrambling
+ *****************************************************************************
+ * The stream cypher is bitsliced: every bit of its state is stored in a
+ * word holding that bit for CSA_BATCH packets, so that one clock of the
+ * cypher runs for all packets at once using only logical operations.
+ * The block cypher is still run per 8 bytes block, using the tables.
+ *****************************************************************************/
+#if defined(__AVX2__)
+# include <immintrin.h>
+typedef __m256i csa_word_t;
+# define W_AND(a,b)     _mm256_and_si256(a,b)
+# define W_OR(a,b)      _mm256_or_si256(a,b)
+# define W_XOR(a,b)     _mm256_xor_si256(a,b)
+# define W_ANDNOT(a,b)  _mm256_andnot_si256(a,b)
+# define W_ZERO         _mm256_setzero_si256()
+# define W_ONES         _mm256_set1_epi32(-1)
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+typedef __m128i csa_word_t;
+# define W_AND(a,b)     _mm_and_si128(a,b)
+# define W_OR(a,b)      _mm_or_si128(a,b)
+# define W_XOR(a,b)     _mm_xor_si128(a,b)
+# define W_ANDNOT(a,b)  _mm_andnot_si128(a,b)
+# define W_ZERO         _mm_setzero_si128()
+# define W_ONES         _mm_set1_epi32(-1)
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+typedef uint32x4_t csa_word_t;
+# define W_AND(a,b)     vandq_u32(a,b)
+# define W_OR(a,b)      vorrq_u32(a,b)
+# define W_XOR(a,b)     veorq_u32(a,b)
+# define W_ANDNOT(a,b)  vbicq_u32(b,a)
+# define W_ZERO         vdupq_n_u32(0)
+# define W_ONES         vdupq_n_u32(UINT32_MAX)
+#else
+typedef uint64_t csa_word_t;
+# define W_AND(a,b)     ((a) & (b))
+# define W_OR(a,b)      ((a) | (b))
+# define W_XOR(a,b)     ((a) ^ (b))
+# define W_ANDNOT(a,b)  (~(a) & (b))
+# define W_ZERO         UINT64_C(0)
+# define W_ONES         UINT64_MAX
+#endif
+#define W_NOT(a)        W_XOR(a, W_ONES)
+#define W_MUX(s,a,b)    W_XOR(a, W_AND(s, W_XOR(a,b))) /* s ? b : a */
+
+/* Packet n is bit n%8 of byte n/8 of the words memory */
+#define CSA_BATCH       (8 * sizeof(csa_word_t))
+
+typedef struct
+{
+    csa_word_t A[11][4];
+    csa_word_t B[11][4];
+    csa_word_t X[4], Y[4], Z[4];
+    csa_word_t D[4], E[4], F[4];
+    csa_word_t p, q, r;
+} csa_bs_state_t;
+
+typedef struct
+{
+    uint8_t *p_sb;      /* first cyphered block, stream cypher input */
+    uint8_t *p_data;    /* bytes to xor with the stream */
+    int      i_data;
+} csa_bs_lane_t;
+
+/* 35 bits are selected from A to feed 7 s-boxes. The s-boxes are boolean
+ * functions of 5 inputs (x4 is the msb of the table index in
+ * csa_StreamCypher), with 2 outputs (o[1] being the msb) */
+static inline void csa_BsSbox1( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_NOT(x4);
+    const csa_word_t t1 = W_OR(x2, t0);
+    const csa_word_t t2 = W_OR(x2, x4);
+    const csa_word_t t3 = W_XOR(t1, W_AND(x0, W_XOR(t1, t2)));
+    const csa_word_t t4 = W_XOR(x2, x4);
+    const csa_word_t t5 = W_ANDNOT(x0, t4);
+    const csa_word_t t6 = W_XOR(t3, W_AND(x1, W_XOR(t3, t5)));
+    const csa_word_t t7 = W_NOT(x2);
+    const csa_word_t t8 = W_NOT(t4);
+    const csa_word_t t9 = W_XOR(x0, t8);
+    const csa_word_t t10 = W_XOR(t7, W_AND(x1, W_XOR(t7, t9)));
+    const csa_word_t t11 = W_XOR(t6, W_AND(x3, W_XOR(t6, t10)));
+    const csa_word_t t12 = W_AND(x0, t4);
+    const csa_word_t t13 = W_XOR(x1, t12);
+    const csa_word_t t14 = W_XOR(t1, W_AND(x0, W_XOR(t1, x2)));
+    const csa_word_t t15 = W_AND(x2, x4);
+    const csa_word_t t16 = W_XOR(t15, W_AND(x0, W_XOR(t15, t4)));
+    const csa_word_t t17 = W_XOR(t14, W_AND(x1, W_XOR(t14, t16)));
+    const csa_word_t t18 = W_XOR(t13, W_AND(x3, W_XOR(t13, t17)));
+    o[1] = t11;
+    o[0] = t18;
+}
+
+static inline void csa_BsSbox2( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_NOT(x1);
+    const csa_word_t t1 = W_OR(x2, t0);
+    const csa_word_t t2 = W_XOR(x3, t1);
+    const csa_word_t t3 = W_XOR(t0, W_AND(x3, W_XOR(t0, x2)));
+    const csa_word_t t4 = W_XOR(t2, W_AND(x4, W_XOR(t2, t3)));
+    const csa_word_t t5 = W_XOR(x2, x1);
+    const csa_word_t t6 = W_XOR(x3, t5);
+    const csa_word_t t7 = W_OR(x2, x1);
+    const csa_word_t t8 = W_NOT(t1);
+    const csa_word_t t9 = W_XOR(t7, W_AND(x3, W_XOR(t7, t8)));
+    const csa_word_t t10 = W_XOR(t6, W_AND(x4, W_XOR(t6, t9)));
+    const csa_word_t t11 = W_XOR(t4, W_AND(x0, W_XOR(t4, t10)));
+    const csa_word_t t12 = W_NOT(t5);
+    const csa_word_t t13 = W_XOR(x3, t0);
+    const csa_word_t t14 = W_XOR(t12, W_AND(x4, W_XOR(t12, t13)));
+    const csa_word_t t15 = W_NOT(x2);
+    const csa_word_t t16 = W_XOR(t0, W_AND(x3, W_XOR(t0, t15)));
+    const csa_word_t t17 = W_XOR(x3, t15);
+    const csa_word_t t18 = W_XOR(t16, W_AND(x4, W_XOR(t16, t17)));
+    const csa_word_t t19 = W_XOR(t14, W_AND(x0, W_XOR(t14, t18)));
+    o[1] = t11;
+    o[0] = t19;
+}
+
+static inline void csa_BsSbox3( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_NOT(x4);
+    const csa_word_t t1 = W_ANDNOT(x1, t0);
+    const csa_word_t t2 = W_OR(x2, t1);
+    const csa_word_t t3 = W_XOR(x1, x4);
+    const csa_word_t t4 = W_XOR(x2, t3);
+    const csa_word_t t5 = W_XOR(t2, W_AND(x0, W_XOR(t2, t4)));
+    const csa_word_t t6 = W_ANDNOT(x1, x4);
+    const csa_word_t t7 = W_XOR(x2, t6);
+    const csa_word_t t8 = W_XOR(x1, W_AND(x2, W_XOR(x1, t6)));
+    const csa_word_t t9 = W_XOR(t7, W_AND(x0, W_XOR(t7, t8)));
+    const csa_word_t t10 = W_XOR(t5, W_AND(x3, W_XOR(t5, t9)));
+    const csa_word_t t11 = W_XOR(x2, x4);
+    const csa_word_t t12 = W_XOR(t3, W_AND(x0, W_XOR(t3, t11)));
+    const csa_word_t t13 = W_XOR(x3, t12);
+    o[1] = t10;
+    o[0] = t13;
+}
+
+static inline void csa_BsSbox4( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_NOT(x1);
+    const csa_word_t t1 = W_OR(x0, t0);
+    const csa_word_t t2 = W_XOR(x2, t1);
+    const csa_word_t t3 = W_XOR(x0, t0);
+    const csa_word_t t4 = W_XOR(t2, W_AND(x3, W_XOR(t2, t3)));
+    const csa_word_t t5 = W_NOT(W_AND(x0, t0));
+    const csa_word_t t6 = W_XOR(t5, W_AND(x2, W_XOR(t5, x0)));
+    const csa_word_t t7 = W_NOT(t5);
+    const csa_word_t t8 = W_XOR(t7, W_AND(x2, W_XOR(t7, t3)));
+    const csa_word_t t9 = W_XOR(t6, W_AND(x3, W_XOR(t6, t8)));
+    const csa_word_t t10 = W_XOR(t4, W_AND(x4, W_XOR(t4, t9)));
+    const csa_word_t t11 = W_NOT(t4);
+    const csa_word_t t12 = W_XOR(t9, W_AND(x4, W_XOR(t9, t11)));
+    o[1] = t12;
+    o[0] = t10;
+}
+
+static inline void csa_BsSbox5( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_NOT(x3);
+    const csa_word_t t1 = W_XOR(x1, t0);
+    const csa_word_t t2 = W_OR(x1, t0);
+    const csa_word_t t3 = W_XOR(t1, W_AND(x2, W_XOR(t1, t2)));
+    const csa_word_t t4 = W_XOR(x2, t2);
+    const csa_word_t t5 = W_XOR(t3, W_AND(x4, W_XOR(t3, t4)));
+    const csa_word_t t6 = W_AND(x1, x3);
+    const csa_word_t t7 = W_XOR(t6, W_AND(x2, W_XOR(t6, t0)));
+    const csa_word_t t8 = W_XOR(t7, W_AND(x4, W_XOR(t7, t1)));
+    const csa_word_t t9 = W_XOR(t5, W_AND(x0, W_XOR(t5, t8)));
+    const csa_word_t t10 = W_XOR(x2, t6);
+    const csa_word_t t11 = W_NOT(t1);
+    const csa_word_t t12 = W_XOR(x3, W_AND(x2, W_XOR(x3, t11)));
+    const csa_word_t t13 = W_XOR(t10, W_AND(x4, W_XOR(t10, t12)));
+    const csa_word_t t14 = W_OR(x1, x3);
+    const csa_word_t t15 = W_XOR(t14, W_AND(x2, W_XOR(t14, t6)));
+    const csa_word_t t16 = W_XOR(x4, t15);
+    const csa_word_t t17 = W_XOR(t13, W_AND(x0, W_XOR(t13, t16)));
+    o[1] = t9;
+    o[0] = t17;
+}
+
+static inline void csa_BsSbox6( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_XOR(x4, x1);
+    const csa_word_t t1 = W_XOR(x2, t0);
+    const csa_word_t t2 = W_XOR(t0, W_AND(x3, W_XOR(t0, t1)));
+    const csa_word_t t3 = W_OR(x4, x1);
+    const csa_word_t t4 = W_XOR(x2, t3);
+    const csa_word_t t5 = W_AND(x4, x1);
+    const csa_word_t t6 = W_XOR(x2, t5);
+    const csa_word_t t7 = W_XOR(t4, W_AND(x3, W_XOR(t4, t6)));
+    const csa_word_t t8 = W_XOR(t2, W_AND(x0, W_XOR(t2, t7)));
+    const csa_word_t t9 = W_NOT(x1);
+    const csa_word_t t10 = W_OR(x4, t9);
+    const csa_word_t t11 = W_AND(x2, t10);
+    const csa_word_t t12 = W_XOR(t11, W_AND(x3, W_XOR(t11, x1)));
+    const csa_word_t t13 = W_NOT(t6);
+    const csa_word_t t14 = W_NOT(t5);
+    const csa_word_t t15 = W_XOR(t9, W_AND(x2, W_XOR(t9, t14)));
+    const csa_word_t t16 = W_XOR(t13, W_AND(x3, W_XOR(t13, t15)));
+    const csa_word_t t17 = W_XOR(t12, W_AND(x0, W_XOR(t12, t16)));
+    o[1] = t8;
+    o[0] = t17;
+}
+
+static inline void csa_BsSbox7( csa_word_t x4, csa_word_t x3, csa_word_t x2,
+                                csa_word_t x1, csa_word_t x0, csa_word_t o[2] )
+{
+    const csa_word_t t0 = W_XOR(x0, x2);
+    const csa_word_t t1 = W_ANDNOT(x4, t0);
+    const csa_word_t t2 = W_XOR(x3, t1);
+    const csa_word_t t3 = W_NOT(x2);
+    const csa_word_t t4 = W_OR(x0, t3);
+    const csa_word_t t5 = W_XOR(t3, W_AND(x4, W_XOR(t3, t4)));
+    const csa_word_t t6 = W_AND(x0, x2);
+    const csa_word_t t7 = W_XOR(t0, W_AND(x4, W_XOR(t0, t6)));
+    const csa_word_t t8 = W_XOR(t5, W_AND(x3, W_XOR(t5, t7)));
+    const csa_word_t t9 = W_XOR(t2, W_AND(x1, W_XOR(t2, t8)));
+    const csa_word_t t10 = W_XOR(x4, t0);
+    const csa_word_t t11 = W_NOT(x0);
+    const csa_word_t t12 = W_XOR(x4, t11);
+    const csa_word_t t13 = W_XOR(t10, W_AND(x3, W_XOR(t10, t12)));
+    const csa_word_t t14 = W_XOR(x4, t6);
+    const csa_word_t t15 = W_ANDNOT(x0, t3);
+    const csa_word_t t16 = W_XOR(t4, W_AND(x4, W_XOR(t4, t15)));
+    const csa_word_t t17 = W_XOR(t14, W_AND(x3, W_XOR(t14, t16)));
+    const csa_word_t t18 = W_XOR(t13, W_AND(x1, W_XOR(t13, t17)));
+    o[1] = t9;
+    o[0] = t18;
+}
+
+/* One clock of the stream cypher, see csa_StreamCypher. The initialisation
+ * inputs in_a and in_b are NULL when generating. Returns the 2 output
+ * bits in po[1] and po[0]. */
+static void csa_BsClock( csa_bs_state_t *s, const csa_word_t *in_a,
+                         const csa_word_t *in_b, csa_word_t po[2] )
+{
+    csa_word_t (*A)[4] = s->A;
+    csa_word_t (*B)[4] = s->B;
+    csa_word_t s1[2], s2[2], s3[2], s4[2], s5[2], s6[2], s7[2];
+    csa_word_t extra_B[4], next_A1[4], next_B1[4], sum[4];
+
+    csa_BsSbox1( A[4][0], A[1][2], A[6][1], A[7][3], A[9][0], s1 );
+    csa_BsSbox2( A[2][1], A[3][2], A[6][3], A[7][0], A[9][1], s2 );
+    csa_BsSbox3( A[1][3], A[2][0], A[5][1], A[5][3], A[6][2], s3 );
+    csa_BsSbox4( A[3][3], A[1][1], A[2][3], A[4][2], A[8][0], s4 );
+    csa_BsSbox5( A[5][2], A[4][3], A[6][0], A[8][1], A[9][2], s5 );
+    csa_BsSbox6( A[3][1], A[4][1], A[5][0], A[7][2], A[9][3], s6 );
+    csa_BsSbox7( A[2][2], A[3][0], A[7][1], A[8][2], A[8][3], s7 );
+
+    extra_B[3] = W_XOR( W_XOR( B[3][0], B[6][1] ), W_XOR( B[7][2], B[9][3] ) );
+    extra_B[2] = W_XOR( W_XOR( B[6][0], B[8][1] ), W_XOR( B[3][3], B[4][2] ) );
+    extra_B[1] = W_XOR( W_XOR( B[5][3], B[8][2] ), W_XOR( B[4][0], B[5][1] ) );
+    extra_B[0] = W_XOR( W_XOR( B[9][2], B[6][3] ), W_XOR( B[3][1], B[8][0] ) );
+
+    for( int i = 0; i < 4; i++ )
+    {
+        /* T1 and T2 */
+        next_A1[i] = W_XOR( A[10][i], s->X[i] );
+        next_B1[i] = W_XOR( W_XOR( B[7][i], B[10][i] ), s->Y[i] );
+        if( in_a )
+        {
+            next_A1[i] = W_XOR( next_A1[i], W_XOR( s->D[i], in_a[i] ) );
+            next_B1[i] = W_XOR( next_B1[i], in_b[i] );
+        }
+    }
+
+    /* if p=1, rotate left */
+    const csa_word_t b3 = next_B1[3];
+    next_B1[3] = W_MUX( s->p, b3, next_B1[2] );
+    next_B1[2] = W_MUX( s->p, next_B1[2], next_B1[1] );
+    next_B1[1] = W_MUX( s->p, next_B1[1], next_B1[0] );
+    next_B1[0] = W_MUX( s->p, next_B1[0], b3 );
+
+    /* T3 and T4, sum and carry of Z + E + r */
+    csa_word_t carry = s->r;
+    for( int i = 0; i < 4; i++ )
+    {
+        const csa_word_t ze = W_XOR( s->Z[i], s->E[i] );
+        s->D[i] = W_XOR( ze, extra_B[i] );
+        sum[i] = W_XOR( ze, carry );
+        carry = W_OR( W_AND( s->Z[i], s->E[i] ), W_AND( carry, ze ) );
+    }
+    for( int i = 0; i < 4; i++ )
+    {
+        const csa_word_t next_E = s->F[i];
+        s->F[i] = W_MUX( s->q, s->E[i], sum[i] );
+        s->E[i] = next_E;
+    }
+    s->r = W_MUX( s->q, s->r, carry );
+
+    memmove( &A[2], &A[1], 9 * sizeof(A[1]) );
+    memmove( &B[2], &B[1], 9 * sizeof(B[1]) );
+    memcpy( A[1], next_A1, sizeof(next_A1) );
+    memcpy( B[1], next_B1, sizeof(next_B1) );
+
+    s->X[3] = s4[0]; s->X[2] = s3[0]; s->X[1] = s2[1]; s->X[0] = s1[1];
+    s->Y[3] = s6[0]; s->Y[2] = s5[0]; s->Y[1] = s4[1]; s->Y[0] = s3[1];
+    s->Z[3] = s2[0]; s->Z[2] = s1[0]; s->Z[1] = s6[1]; s->Z[0] = s5[1];
+    s->p = s7[1];
+    s->q = s7[0];
+
+    /* 2 output bits are a function of the 4 bits of D */
+    po[1] = W_XOR( s->D[3], s->D[2] );
+    po[0] = W_XOR( s->D[1], s->D[0] );
+}
+
+/* Transposes the 8x8 bits matrix made of the 8 bytes of x */
+static inline uint64_t csa_Transpose8x8( uint64_t x )
+{
+    uint64_t t;
+    t = ( x ^ ( x >> 7 ) ) & UINT64_C(0x00AA00AA00AA00AA);
+    x ^= t ^ ( t << 7 );
+    t = ( x ^ ( x >> 14 ) ) & UINT64_C(0x0000CCCC0000CCCC);
+    x ^= t ^ ( t << 14 );
+    t = ( x ^ ( x >> 28 ) ) & UINT64_C(0x00000000F0F0F0F0);
+    x ^= t ^ ( t << 28 );
+    return x;
+}
+
+/* Xors the stream cypher output, initialised from each lane first block,
+ * with the lanes data */
+static void csa_BsStreamXor( const uint8_t ck[8], const csa_bs_lane_t *p_lanes,
+                             unsigned i_lanes )
+{
+    csa_bs_state_t s;
+    uint8_t planes[8][CSA_BATCH / 8];
+    csa_word_t bits[8];
+    int i_data = 0;
+
+    assert( i_lanes <= CSA_BATCH );
+    memset( &s, 0, sizeof(s) );
+
+    /* load first 32 bits of CK into A[1]..A[8]
+     * load last  32 bits of CK into B[1]..B[8] */
+    for( int i = 0; i < 4; i++ )
+    {
+        for( int j = 0; j < 4; j++ )
+        {
+            s.A[1+2*i+0][j] = ( ck[i]   >> (4+j) ) & 1 ? W_ONES : W_ZERO;
+            s.A[1+2*i+1][j] = ( ck[i]   >> j )     & 1 ? W_ONES : W_ZERO;
+            s.B[1+2*i+0][j] = ( ck[4+i] >> (4+j) ) & 1 ? W_ONES : W_ZERO;
+            s.B[1+2*i+1][j] = ( ck[4+i] >> j )     & 1 ? W_ONES : W_ZERO;
+        }
+    }
+    for( unsigned i = 0; i < i_lanes; i++ )
+        i_data = __MAX( i_data, p_lanes[i].i_data );
+
+    /* initialisation, 4 clocks by input byte */
+    for( int i = 0; i < 8; i++ )
+    {
+        for( unsigned g = 0; g < CSA_BATCH / 8; g++ )
+        {
+            uint64_t x = 0;
+            for( unsigned j = 0; j < 8 && 8 * g + j < i_lanes; j++ )
+                x |= (uint64_t) p_lanes[8 * g + j].p_sb[i] << ( 8 * j );
+            x = csa_Transpose8x8( x );
+            for( int j = 0; j < 8; j++ )
+                planes[j][g] = x >> ( 8 * j );
+        }
+        for( int j = 0; j < 8; j++ )
+            memcpy( &bits[j], planes[j], sizeof(bits[j]) );
+
+        const csa_word_t *in1 = &bits[4], *in2 = &bits[0];
+        csa_word_t op[2];
+        for( int j = 0; j < 4; j++ )
+        {
+            if( j % 2 )
+                csa_BsClock( &s, in2, in1, op );
+            else
+                csa_BsClock( &s, in1, in2, op );
+        }
+    }
+
+    /* generation, 4 clocks by output byte */
+    for( int i = 0; i < i_data; i++ )
+    {
+        for( int j = 0; j < 4; j++ )
+        {
+            csa_word_t op[2];
+            csa_BsClock( &s, NULL, NULL, op );
+            bits[7 - 2 * j] = op[1];
+            bits[6 - 2 * j] = op[0];
+        }
+        for( int j = 0; j < 8; j++ )
+            memcpy( planes[j], &bits[j], sizeof(bits[j]) );
+
+        for( unsigned g = 0; 8 * g < i_lanes; g++ )
+        {
+            uint64_t x = 0;
+            for( int j = 0; j < 8; j++ )
+                x |= (uint64_t) planes[j][g] << ( 8 * j );
+            x = csa_Transpose8x8( x );
+            for( unsigned j = 0; j < 8 && 8 * g + j < i_lanes; j++ )
+            {
+                const csa_bs_lane_t *p_lane = &p_lanes[8 * g + j];
+                if( i < p_lane->i_data )
+                    p_lane->p_data[i] ^= x >> ( 8 * j );
+            }
+        }
+    }
+}
+
+/* Number of blocks (de)cyphered together, so that the tables lookups of
+ * one block don't wait for the previous ones */
+#define CSA_BLOCKS 4
+
+static void csa_BlockDecypherX( const uint8_t kk[57], const uint8_t *ib[CSA_BLOCKS],
+                                uint8_t *bd[CSA_BLOCKS] )
+{
+    int R[CSA_BLOCKS][9];
+
+    for( int l = 0; l < CSA_BLOCKS; l++ )
+        for( int i = 0; i < 8; i++ )
+            R[l][i+1] = ib[l][i];
+
+    // loop over kk[56]..kk[1]
+    for( int i = 56; i > 0; i-- )
+    {
+        for( int l = 0; l < CSA_BLOCKS; l++ )
+        {
+            const int sbox_out = block_sbox[ kk[i]^R[l][7] ];
+            const int perm_out = block_perm[sbox_out];
+            const int next_R8 = R[l][7];
+
+            R[l][7] = R[l][6] ^ perm_out;
+            R[l][6] = R[l][5];
+            R[l][5] = R[l][4] ^ R[l][8] ^ sbox_out;
+            R[l][4] = R[l][3] ^ R[l][8] ^ sbox_out;
+            R[l][3] = R[l][2] ^ R[l][8] ^ sbox_out;
+            R[l][2] = R[l][1];
+            R[l][1] = R[l][8] ^ sbox_out;
+            R[l][8] = next_R8;
+        }
+    }
+
+    for( int l = 0; l < CSA_BLOCKS; l++ )
+        for( int i = 0; i < 8; i++ )
+            bd[l][i] = R[l][i+1];
+}
+
+static void csa_BlockCypherX( const uint8_t kk[57], const uint8_t bd[CSA_BLOCKS][8],
+                              uint8_t *ib[CSA_BLOCKS] )
+{
+    int R[CSA_BLOCKS][9];
+
+    for( int l = 0; l < CSA_BLOCKS; l++ )
+        for( int i = 0; i < 8; i++ )
+            R[l][i+1] = bd[l][i];
+
+    // loop over kk[1]..kk[56]
+    for( int i = 1; i <= 56; i++ )
+    {
+        for( int l = 0; l < CSA_BLOCKS; l++ )
+        {
+            const int sbox_out = block_sbox[ kk[i]^R[l][8] ];
+            const int perm_out = block_perm[sbox_out];
+            const int next_R1 = R[l][2];
+
+            R[l][2] = R[l][3] ^ R[l][1];
+            R[l][3] = R[l][4] ^ R[l][1];
+            R[l][4] = R[l][5] ^ R[l][1];
+            R[l][5] = R[l][6];
+            R[l][6] = R[l][7] ^ perm_out;
+            R[l][7] = R[l][8];
+            R[l][8] = R[l][1] ^ sbox_out;
+            R[l][1] = next_R1;
+        }
+    }
+
+    for( int l = 0; l < CSA_BLOCKS; l++ )
+        for( int i = 0; i < 8; i++ )
+            ib[l][i] = R[l][i+1];
+}
+
+/* Decyphers the lanes blocks, each one xor'ed with the next cyphered one */
+static void csa_BsBlockDecypher( const uint8_t kk[57], const csa_bs_lane_t *p_lanes,
+                                 unsigned i_lanes )
+{
+    uint8_t scratch[8] = { 0 };
+    uint8_t out[188/8][8];
+
+    for( unsigned j = 0; j < i_lanes; j++ )
+    {
+        uint8_t *p_block = p_lanes[j].p_sb;
+        const int n = ( p_lanes[j].i_data + 8 ) / 8;
+
+        for( int b = 0; b < n; b += CSA_BLOCKS )
+        {
+            const uint8_t *ib[CSA_BLOCKS];
+            uint8_t *bd[CSA_BLOCKS];
+            for( int l = 0; l < CSA_BLOCKS; l++ )
+            {
+                ib[l] = b + l < n ? &p_block[8*(b+l)] : scratch;
+                bd[l] = b + l < n ? out[b+l] : scratch;
+            }
+            csa_BlockDecypherX( kk, ib, bd );
+        }
+
+        for( int b = 0; b < n; b++ )
+            for( int l = 0; l < 8; l++ )
+                p_block[8*b+l] = out[b][l] ^ ( b + 1 < n ? p_block[8*(b+1)+l] : 0 );
+    }
+}
+
+/* Cyphers the lanes blocks from the last one, each one xor'ed with the next
+ * cyphered one. The blocks of a packet depend on each other, so blocks of
+ * CSA_BLOCKS packets are cyphered together. */
+static void csa_BsBlockCypher( const uint8_t kk[57], const csa_bs_lane_t *p_lanes,
+                               unsigned i_lanes )
+{
+    uint8_t scratch[CSA_BLOCKS][8];
+
+    for( unsigned g = 0; g < i_lanes; g += CSA_BLOCKS )
+    {
+        int n[CSA_BLOCKS];
+        int i_max = 0;
+        for( int l = 0; l < CSA_BLOCKS; l++ )
+        {
+            n[l] = g + l < i_lanes ? ( p_lanes[g+l].i_data + 8 ) / 8 : 0;
+            i_max = __MAX( i_max, n[l] );
+        }
+
+        for( int t = 0; t < i_max; t++ )
+        {
+            uint8_t bd[CSA_BLOCKS][8];
+            uint8_t *ib[CSA_BLOCKS];
+            for( int l = 0; l < CSA_BLOCKS; l++ )
+            {
+                const int b = n[l] - 1 - t;
+                if( b < 0 )
+                {
+                    memset( bd[l], 0, 8 );
+                    ib[l] = scratch[l];
+                    continue;
+                }
+                uint8_t *p_block = p_lanes[g+l].p_sb;
+                for( int i = 0; i < 8; i++ )
+                    bd[l][i] = p_block[8*b+i] ^ ( b + 1 < n[l] ? p_block[8*(b+1)+i] : 0 );
+                ib[l] = &p_block[8*b];
+            }
+            csa_BlockCypherX( kk, bd, ib );
+        }
+    }
+}
+
+/* Returns the scrambled payload offset, or -1 if too short for batching */
+static int csa_PayloadOffset( const uint8_t *pkt, int i_pkt_size )
+{
+    int i_hdr = 4;
+    if( pkt[3]&0x20 )
+        i_hdr += pkt[4] + 1;
+    return i_pkt_size - i_hdr >= 8 ? i_hdr : -1;
+}
+
+/*****************************************************************************
+ * csa_DecryptPackets:
+ *****************************************************************************/
+void csa_DecryptPackets( csa_t *c, uint8_t **pp_pkts, int i_pkts, int i_pkt_size )
+{
+    csa_bs_lane_t lanes[2][CSA_BATCH];
+    uint8_t *pkts[2][CSA_BATCH];
+    unsigned i_lanes[2] = { 0, 0 };
+
+    for( int i = 0; i <= i_pkts; i++ )
+    {
+        if( i < i_pkts )
+        {
+            uint8_t *pkt = pp_pkts[i];
+            if( (pkt[3]&0x80) == 0 )
+                continue;
+            const int i_hdr = csa_PayloadOffset( pkt, i_pkt_size );
+            if( i_hdr < 0 )
+            {
+                csa_Decrypt( c, pkt, i_pkt_size );
+                continue;
+            }
+
+            const int k = ( pkt[3]&0x40 ) ? 1 : 0;
+            csa_bs_lane_t *p_lane = &lanes[k][i_lanes[k]];
+            p_lane->p_sb = &pkt[i_hdr];
+            p_lane->p_data = &pkt[i_hdr + 8];
+            p_lane->i_data = i_pkt_size - i_hdr - 8;
+            pkts[k][i_lanes[k]++] = pkt;
+
+            if( i_lanes[k] < CSA_BATCH )
+                continue;
+        }
+
+        for( int k = 0; k < 2; k++ )
+        {
+            if( i_lanes[k] == 0 || ( i < i_pkts && i_lanes[k] < CSA_BATCH ) )
+                continue;
+
+            /* xor with the stream, starting after the first block */
+            csa_BsStreamXor( k ? c->o_ck : c->e_ck, lanes[k], i_lanes[k] );
+
+            for( unsigned j = 0; j < i_lanes[k]; j++ )
+                pkts[k][j][3] &= 0x3f;
+            csa_BsBlockDecypher( k ? c->o_kk : c->e_kk, lanes[k], i_lanes[k] );
+            i_lanes[k] = 0;
+        }
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptPackets:
+ *****************************************************************************/
+void csa_EncryptPackets( csa_t *c, uint8_t **pp_pkts, int i_pkts, int i_pkt_size )
+{
+    csa_bs_lane_t lanes[CSA_BATCH];
+    unsigned i_lanes = 0;
+    uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+
+    for( int i = 0; i < i_pkts; i++ )
+    {
+        uint8_t *pkt = pp_pkts[i];
+        const int i_hdr = csa_PayloadOffset( pkt, i_pkt_size );
+        if( i_hdr < 0 )
+        {
+            csa_Encrypt( c, pkt, i_pkt_size );
+            continue;
+        }
+
+        /* set transport scrambling control */
+        pkt[3] |= c->use_odd ? 0xc0 : 0x80;
+
+        csa_bs_lane_t *p_lane = &lanes[i_lanes++];
+        p_lane->p_sb = &pkt[i_hdr];
+        p_lane->p_data = &pkt[i_hdr + 8];
+        p_lane->i_data = i_pkt_size - i_hdr - 8;
+
+        if( i_lanes == CSA_BATCH )
+        {
+            csa_BsBlockCypher( kk, lanes, i_lanes );
+            csa_BsStreamXor( ck, lanes, i_lanes );
+            i_lanes = 0;
+        }
+    }
+
+    if( i_lanes )
+    {
+        csa_BsBlockCypher( kk, lanes, i_lanes );
+        csa_BsStreamXor( ck, lanes, i_lanes );
+    }
+}
@@ -187,6 +187,11 @@ static const char *const ts_standards_list_text[] =
     "The encryption routines subtract the TS-header from the value before " \
     "encrypting." )
 
+#define OUTBLOCK_TEXT N_("Packets per output block")
+#define OUTBLOCK_LONGTEXT N_("Number of TS packets written at once " \
+  "to the access output. The default of 7 packets matches the usual " \
+  "UDP and RTP payload size; 1 writes each packet in its own block.")
+
 #define SOUT_CFG_PREFIX "sout-ts-"
 #define MAX_PMT 64       /* Maximum number of programs. FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
 #define MAX_PMT_PID 64       /* Maximum pids in each pmt.  FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
@@ -194,6 +199,8 @@ static const char *const ts_standards_list_text[] =
   #error "MAX_SDT_DESC < MAX_PMT"
 #endif
 
+#define TS_PACKETS_POOL_MAX 512 /* Recycled 188 bytes packets blocks */
+
 #define BLOCK_FLAG_NO_KEYFRAME (1 << BLOCK_FLAG_PRIVATE_SHIFT) /* This is not a key frame for bitrate shaping */
 
 vlc_module_begin ()
@@ -237,6 +244,9 @@ vlc_module_begin ()
     add_string( SOUT_CFG_PREFIX "csa-use", "1",  CU_TEXT,   CU_LONGTEXT,   true)
     add_integer(SOUT_CFG_PREFIX "csa-pkt", 188,  CPKT_TEXT, CPKT_LONGTEXT, true)
 
+    add_integer_with_range(SOUT_CFG_PREFIX "packets-per-block", 7, 1, 64,
+                           OUTBLOCK_TEXT, OUTBLOCK_LONGTEXT, true)
+
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -249,7 +259,7 @@ static const char *const ppsz_sout_options[] = {
     "netid", "sdtdesc",
     "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
-    "muxpmt", "program-pmt", "alignment",
+    "muxpmt", "program-pmt", "alignment", "packets-per-block",
     NULL
 };
 
@@ -385,6 +395,11 @@ typedef struct
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
     bool            b_crypt_video;
+
+    /* output */
+    int             i_packets_per_block;
+    block_t         *p_packets_pool;
+    unsigned        i_packets_pool;
 } sout_mux_sys_t;
 
 
@@ -481,6 +496,8 @@ static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
+static block_t *TSPacketNew( sout_mux_sys_t *p_sys );
+static void TSPacketRelease( sout_mux_sys_t *p_sys, block_t *p_ts );
 static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts );
 
 static csa_t *csaSetup( vlc_object_t *p_this )
@@ -740,6 +757,10 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
+    p_sys->i_packets_per_block = var_GetInteger( p_mux, SOUT_CFG_PREFIX "packets-per-block" );
+    p_sys->p_packets_pool = NULL;
+    p_sys->i_packets_pool = 0;
+
     p_mux->p_sys        = p_sys;
 
     p_sys->csa = csaSetup(p_this);
@@ -777,6 +798,8 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->sdt.desc[i].psz_provider );
     }
 
+    block_ChainRelease( p_sys->p_packets_pool );
+
     free( p_sys );
 }
 
@@ -1786,6 +1809,26 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         i_pcr_length = i_packet_count;
     }
 
+    const size_t i_out_size = (size_t)p_sys->i_packets_per_block * 188;
+    block_t *p_out = NULL;
+
+    /* Scramble all packets at once, the PCR being set later in the
+     * adaptation field which is left in clear */
+    uint8_t *pp_scrambled[i_packet_count > 0 ? i_packet_count : 1];
+    int i_scrambled = 0;
+    for( block_t *p_ts = p_chain_ts->p_first; p_ts && i_scrambled < i_packet_count;
+         p_ts = p_ts->p_next )
+    {
+        if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+            pp_scrambled[i_scrambled++] = p_ts->p_buffer;
+    }
+    if( i_scrambled )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_EncryptPackets( p_sys->csa, pp_scrambled, i_scrambled, p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
     for (int i = 0; i < i_packet_count; i++ )
     {
@@ -1800,24 +1843,83 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
             /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
             TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
         }
-        if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+        /* latency */
+        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+
+        if( p_sys->i_packets_per_block == 1 )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            sout_AccessOutWrite( p_mux->p_access, p_ts );
+            continue;
         }
 
-        /* latency */
-        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+        /* Start a new output block on full ones, and on the packets
+         * access outputs cut or start clients on */
+        if( p_out && ( p_out->i_buffer + p_ts->i_buffer > i_out_size ||
+                       (p_ts->i_flags & (BLOCK_FLAG_HEADER|BLOCK_FLAG_TYPE_I)) ) )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_out );
+            p_out = NULL;
+        }
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        if( p_out == NULL )
+        {
+            p_out = block_Alloc( i_out_size );
+            if( unlikely(p_out == NULL) )
+            {
+                sout_AccessOutWrite( p_mux->p_access, p_ts );
+                continue;
+            }
+            p_out->i_buffer = 0;
+            p_out->i_dts = p_ts->i_dts;
+            p_out->i_flags = p_ts->i_flags & (BLOCK_FLAG_HEADER|BLOCK_FLAG_TYPE_I);
+        }
+
+        memcpy( &p_out->p_buffer[p_out->i_buffer], p_ts->p_buffer, p_ts->i_buffer );
+        p_out->i_buffer += p_ts->i_buffer;
+        p_out->i_length += p_ts->i_length;
+        p_out->i_flags |= p_ts->i_flags & BLOCK_FLAG_CLOCK;
+
+        TSPacketRelease( p_sys, p_ts );
     }
+
+    if( p_out )
+        sout_AccessOutWrite( p_mux->p_access, p_out );
+}
+
+/* Packets blocks are recycled once copied to output blocks */
+static block_t *TSPacketNew( sout_mux_sys_t *p_sys )
+{
+    block_t *p_ts = p_sys->p_packets_pool;
+    if( p_ts == NULL )
+        return block_Alloc( 188 );
+
+    p_sys->p_packets_pool = p_ts->p_next;
+    p_sys->i_packets_pool--;
+
+    p_ts->p_next = NULL;
+    p_ts->i_flags = 0;
+    p_ts->i_nb_samples = 0;
+    p_ts->i_pts = p_ts->i_dts = VLC_TICK_INVALID;
+    p_ts->i_length = 0;
+    return p_ts;
+}
+
+static void TSPacketRelease( sout_mux_sys_t *p_sys, block_t *p_ts )
+{
+    if( p_sys->i_packets_pool >= TS_PACKETS_POOL_MAX || p_ts->i_buffer != 188 )
+    {
+        block_Release( p_ts );
+        return;
+    }
+
+    p_ts->p_next = p_sys->p_packets_pool;
+    p_sys->p_packets_pool = p_ts;
+    p_sys->i_packets_pool++;
 }
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1837,7 +1939,7 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    block_t *p_ts = TSPacketNew( p_mux->p_sys );
 
     if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
     {
@@ -89,11 +89,13 @@ typedef struct
     {
         block_t *p_block;
         h264_sequence_parameter_set_t *p_sps;
+        uint32_t i_hash;
     } sps[H264_SPS_ID_MAX + 1];
     struct
     {
         block_t *p_block;
         h264_picture_parameter_set_t *p_pps;
+        uint32_t i_hash;
     } pps[H264_PPS_ID_MAX + 1];
     const h264_sequence_parameter_set_t *p_active_sps;
     const h264_picture_parameter_set_t *p_active_pps;
@@ -161,8 +163,8 @@ static const uint8_t p_h264_startcode[3] = { 0x00, 0x00, 0x01 };
  * Helpers
  *****************************************************************************/
 
-static void StoreSPS( decoder_sys_t *p_sys, uint8_t i_id,
-                      block_t *p_block, h264_sequence_parameter_set_t *p_sps )
+static void StoreSPS( decoder_sys_t *p_sys, uint8_t i_id, block_t *p_block,
+                      h264_sequence_parameter_set_t *p_sps, uint32_t i_hash )
 {
     if( p_sys->sps[i_id].p_block )
         block_Release( p_sys->sps[i_id].p_block );
@@ -172,10 +174,11 @@ static void StoreSPS( decoder_sys_t *p_sys, uint8_t i_id,
         p_sys->p_active_sps = NULL;
     p_sys->sps[i_id].p_block = p_block;
     p_sys->sps[i_id].p_sps = p_sps;
+    p_sys->sps[i_id].i_hash = i_hash;
 }
 
-static void StorePPS( decoder_sys_t *p_sys, uint8_t i_id,
-                      block_t *p_block, h264_picture_parameter_set_t *p_pps )
+static void StorePPS( decoder_sys_t *p_sys, uint8_t i_id, block_t *p_block,
+                      h264_picture_parameter_set_t *p_pps, uint32_t i_hash )
 {
     if( p_sys->pps[i_id].p_block )
         block_Release( p_sys->pps[i_id].p_block );
@@ -185,6 +188,29 @@ static void StorePPS( decoder_sys_t *p_sys, uint8_t i_id,
         p_sys->p_active_pps = NULL;
     p_sys->pps[i_id].p_block = p_block;
     p_sys->pps[i_id].p_pps = p_pps;
+    p_sys->pps[i_id].i_hash = i_hash;
+}
+
+/* Broadcasts repeat the same sets on every IDR: the stored sets are
+ * looked up by a hash of their bytes, so that repeats are not parsed again */
+static uint32_t HashXPS( const uint8_t *p_buf, size_t i_buf )
+{
+    uint32_t i_hash = 2166136261u; /* FNV-1a */
+    for( size_t i = 0; i < i_buf; i++ )
+        i_hash = ( i_hash ^ p_buf[i] ) * 16777619u;
+    return i_hash;
+}
+
+static bool MatchXPS( const block_t *p_stored, uint32_t i_stored_hash,
+                      const uint8_t *p_buf, size_t i_buf, uint32_t i_hash )
+{
+    if( p_stored == NULL || i_stored_hash != i_hash )
+        return false;
+
+    const uint8_t *p_stored_buf = p_stored->p_buffer;
+    size_t i_stored_buf = p_stored->i_buffer;
+    return hxxx_strip_AnnexB_startcode( &p_stored_buf, &i_stored_buf ) &&
+           i_stored_buf == i_buf && !memcmp( p_stored_buf, p_buf, i_buf );
 }
 
 static void ActivateSets( decoder_t *p_dec, const h264_sequence_parameter_set_t *p_sps,
@@ -336,7 +362,7 @@ static int Open( vlc_object_t *p_this )
     }
 
     packetizer_Init( &p_sys->packetizer,
-                     p_h264_startcode, sizeof(p_h264_startcode), startcode_FindAnnexB,
+                     p_h264_startcode, sizeof(p_h264_startcode), startcode_FindAnnexB_Select(),
                      p_h264_startcode, 1, 5,
                      PacketizeReset, PacketizeParse, PacketizeValidate, PacketizeDrain,
                      p_dec );
@@ -475,9 +501,9 @@ static void Close( vlc_object_t *p_this )
 
     DropStoredNAL( p_sys );
     for( i = 0; i <= H264_SPS_ID_MAX; i++ )
-        StoreSPS( p_sys, i, NULL, NULL );
+        StoreSPS( p_sys, i, NULL, NULL, 0 );
     for( i = 0; i <= H264_PPS_ID_MAX; i++ )
-        StorePPS( p_sys, i, NULL, NULL );
+        StorePPS( p_sys, i, NULL, NULL, 0 );
 
     packetizer_Clean( &p_sys->packetizer );
 
@@ -1077,6 +1103,18 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    const uint32_t i_hash = HashXPS( p_buffer, i_buffer );
+    for( size_t i = 0; i <= H264_SPS_ID_MAX; i++ )
+    {
+        if( MatchXPS( p_sys->sps[i].p_block, p_sys->sps[i].i_hash,
+                      p_buffer, i_buffer, i_hash ) )
+        {   /* Same SPS, keep its decoded version */
+            block_Release( p_sys->sps[i].p_block );
+            p_sys->sps[i].p_block = p_frag;
+            return;
+        }
+    }
+
     h264_sequence_parameter_set_t *p_sps = h264_decode_sps( p_buffer, i_buffer, true );
     if( !p_sps )
     {
@@ -1089,7 +1127,7 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
     if( !p_sys->sps[p_sps->i_id].p_sps )
         msg_Dbg( p_dec, "found NAL_SPS (sps_id=%d)", p_sps->i_id );
 
-    StoreSPS( p_sys, p_sps->i_id, p_frag, p_sps );
+    StoreSPS( p_sys, p_sps->i_id, p_frag, p_sps, i_hash );
 }
 
 static void PutPPS( decoder_t *p_dec, block_t *p_frag )
@@ -1104,6 +1142,18 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    const uint32_t i_hash = HashXPS( p_buffer, i_buffer );
+    for( size_t i = 0; i <= H264_PPS_ID_MAX; i++ )
+    {
+        if( MatchXPS( p_sys->pps[i].p_block, p_sys->pps[i].i_hash,
+                      p_buffer, i_buffer, i_hash ) )
+        {   /* Same PPS, keep its decoded version */
+            block_Release( p_sys->pps[i].p_block );
+            p_sys->pps[i].p_block = p_frag;
+            return;
+        }
+    }
+
     h264_picture_parameter_set_t *p_pps = h264_decode_pps( p_buffer, i_buffer, true );
     if( !p_pps )
     {
@@ -1116,7 +1166,7 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
     if( !p_sys->pps[p_pps->i_id].p_pps )
         msg_Dbg( p_dec, "found NAL_PPS (pps_id=%d sps_id=%d)", p_pps->i_id, p_pps->i_sps_id );
 
-    StorePPS( p_sys, p_pps->i_id, p_frag, p_pps );
+    StorePPS( p_sys, p_pps->i_id, p_frag, p_pps, i_hash );
 }
 
 static void GetSPSPPS( uint8_t i_pps_id, void *priv,
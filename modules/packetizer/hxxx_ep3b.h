@@ -20,6 +20,8 @@
  *****************************************************************************/
 #include <vlc_bits.h>
 
+#include "startcode_helper.h"
+
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
     for( size_t i=0; i<i_count; i++ )
@@ -83,9 +85,19 @@ static void hxxx_bsfw_ep3b_ctx_init( struct hxxx_bsfw_ep3b_ctx_s *ctx )
 
 static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
 {
-    /* compute final size */
-    unsigned i_prev = 0;
-    size_t i = 0;
+    if( p_end - p < 2 )
+        return p_end - p;
+
+    /* The first byte is never tracked and the last one never escaped, so
+     * nothing is stripped before the first 0x00 0x00 0x03 within them */
+    const uint8_t *p_ep3b = startcode_FindEP3B( p + 1, p_end - 1 );
+    if( p_ep3b == NULL )
+        return p_end - p;
+
+    /* compute final size, from the 2 zeros state */
+    unsigned i_prev = ( p_ep3b - 1 > p && p_ep3b[-1] == 0 ) ? 0x03 : 0x01;
+    size_t i = p_ep3b - p;
+    p = p_ep3b;
     while( p < p_end )
     {
         uint8_t *n = hxxx_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
@@ -110,6 +122,13 @@ static size_t hxxx_bsfw_byte_forward_ep3b( bs_t *s, size_t i_count )
     if( s->p >= s->p_end )
         return 0;
 
+    if( ctx->i_bytesize == (size_t)(s->p_end - s->p_start) )
+    {   /* nothing to strip */
+        s->p = ( (size_t)(s->p_end - s->p) > i_count ) ? s->p + i_count : s->p_end;
+        ctx->i_bytepos += i_count;
+        return i_count;
+    }
+
     s->p = hxxx_ep3b_to_rbsp( s->p, s->p_end, &ctx->i_prev, i_count );
     ctx->i_bytepos += i_count;
     return i_count;
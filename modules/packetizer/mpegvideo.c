@@ -218,7 +218,7 @@ static int Open( vlc_object_t *p_this )
 
     /* Misc init */
     packetizer_Init( &p_sys->packetizer,
-                     p_mp2v_startcode, sizeof(p_mp2v_startcode), startcode_FindAnnexB,
+                     p_mp2v_startcode, sizeof(p_mp2v_startcode), startcode_FindAnnexB_Select(),
                      NULL, 0, 4,
                      PacketizeReset, PacketizeParse, PacketizeValidate, PacketizeDrain,
                      p_dec );
@@ -22,9 +22,15 @@
 
 #include <vlc_cpu.h>
 
-#if !defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+#if defined(HAVE_SSE2_INTRINSICS)
    #include <emmintrin.h>
 #endif
+#if defined(HAVE_AVX2_INTRINSICS)
+   #include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+   #include <arm_neon.h>
+#endif
 
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
  * by using a 4 times faster trick than single byte lookup. */
@@ -57,7 +63,7 @@ static inline const uint8_t * startcode_FindAnnexB_SSE2( const uint8_t *p, const
             return p;
     }
 
-    if( p == end )
+    if( p > end )
         return NULL;
 
     alignedend = end - ((intptr_t) end & 15);
@@ -140,16 +146,211 @@ static inline const uint8_t * startcode_FindAnnexB_Bits( const uint8_t *p, const
 }
 #undef TRY_MATCH
 
+/* Looks up the first 0x00 0x00 i_last sequence lying entirely before end.
+ * The vector versions check the 3 bytes on 16 or 32 positions at once,
+ * and do not need any alignment. */
+static inline const uint8_t * startcode_Find_C( const uint8_t *p, const uint8_t *end,
+                                                uint8_t i_last )
+{
+    for( ; end - p >= 3; p++ )
+    {
+        if( p[0] == 0 && p[1] == 0 && p[2] == i_last )
+            return p;
+    }
+    return NULL;
+}
+
+#if defined(HAVE_AVX2_INTRINSICS)
+
+VLC_AVX2
+static inline const uint8_t * startcode_Find_AVX2( const uint8_t *p, const uint8_t *end,
+                                                   uint8_t i_last )
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    const __m256i last = _mm256_set1_epi8( i_last );
+
+    for( ; end - p >= 32 + 2; p += 32 )
+    {
+        uint32_t match = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8( _mm256_loadu_si256( (const __m256i *) p ), zeros ) );
+        if( !match )
+            continue;
+        match &= _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8( _mm256_loadu_si256( (const __m256i *) (p + 1) ), zeros ) );
+        match &= _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8( _mm256_loadu_si256( (const __m256i *) (p + 2) ), last ) );
+        if( match )
+            return p + ctz( match );
+    }
+
+    return startcode_Find_C( p, end, i_last );
+}
+
+VLC_AVX2
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_AVX2( p, end, 0x01 );
+}
+
+#endif
+
+#if defined(HAVE_SSE2_INTRINSICS)
+
+__attribute__ ((__target__ ("sse2")))
+static inline const uint8_t * startcode_Find_SSE2( const uint8_t *p, const uint8_t *end,
+                                                   uint8_t i_last )
+{
+    const __m128i zeros = _mm_setzero_si128();
+    const __m128i last = _mm_set1_epi8( i_last );
+
+    for( ; end - p >= 16 + 2; p += 16 )
+    {
+        unsigned match = _mm_movemask_epi8(
+            _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) p ), zeros ) );
+        if( !match )
+            continue;
+        match &= _mm_movemask_epi8(
+            _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) (p + 1) ), zeros ) );
+        match &= _mm_movemask_epi8(
+            _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) (p + 2) ), last ) );
+        if( match )
+            return p + ctz( match );
+    }
+
+    return startcode_Find_C( p, end, i_last );
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+static inline const uint8_t * startcode_Find_NEON( const uint8_t *p, const uint8_t *end,
+                                                   uint8_t i_last )
+{
+    const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+    const uint8x16_t last = vdupq_n_u8( i_last );
+
+    for( ; end - p >= 16 + 2; p += 16 )
+    {
+        uint8x16_t match = vceqq_u8( vld1q_u8( p ), zeros );
+        if( !vmaxvq_u8( match ) )
+            continue;
+        match = vandq_u8( match, vceqq_u8( vld1q_u8( p + 1 ), zeros ) );
+        match = vandq_u8( match, vceqq_u8( vld1q_u8( p + 2 ), last ) );
+        if( vmaxvq_u8( match ) )
+            return startcode_Find_C( p, p + 16 + 2, i_last );
+    }
+
+    return startcode_Find_C( p, end, i_last );
+}
+
+static inline const uint8_t * startcode_FindAnnexB_NEON( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_NEON( p, end, 0x01 );
+}
+
+#endif
+
+static inline const uint8_t * startcode_FindEP3B_C( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_C( p, end, 0x03 );
+}
+
+#if defined(HAVE_AVX2_INTRINSICS)
+VLC_AVX2
+static inline const uint8_t * startcode_FindEP3B_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_AVX2( p, end, 0x03 );
+}
+#endif
+
+#if defined(HAVE_SSE2_INTRINSICS)
+__attribute__ ((__target__ ("sse2")))
+static inline const uint8_t * startcode_FindEP3B_SSE2( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_SSE2( p, end, 0x03 );
+}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+static inline const uint8_t * startcode_FindEP3B_NEON( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_NEON( p, end, 0x03 );
+}
+#endif
+
+typedef const uint8_t * (*startcode_find_t)( const uint8_t *, const uint8_t * );
+
+/* Implementations of the AnnexB startcode lookup, for vlc_CPU_select() */
+static inline const struct vlc_cpu_impl * startcode_FindAnnexB_Impls( size_t *pi_count )
+{
+    static const struct vlc_cpu_impl impls[] = {
+#if defined(HAVE_AVX2_INTRINSICS)
+        VLC_CPU_IMPL( "avx2", VLC_CPU_AVX2, startcode_FindAnnexB_AVX2 ),
+#endif
 #if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+        VLC_CPU_IMPL( "sse2", VLC_CPU_SSE2, startcode_FindAnnexB_SSE2 ),
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+        VLC_CPU_IMPL( "neon", VLC_CPU_ARM_NEON, startcode_FindAnnexB_NEON ),
+#endif
+        VLC_CPU_IMPL( "c", 0, startcode_FindAnnexB_Bits ),
+    };
+    *pi_count = ARRAY_SIZE(impls);
+    return impls;
+}
+
+/* Implementations of the emulation prevention three byte lookup */
+static inline const struct vlc_cpu_impl * startcode_FindEP3B_Impls( size_t *pi_count )
+{
+    static const struct vlc_cpu_impl impls[] = {
+#if defined(HAVE_AVX2_INTRINSICS)
+        VLC_CPU_IMPL( "avx2", VLC_CPU_AVX2, startcode_FindEP3B_AVX2 ),
+#endif
+#if defined(HAVE_SSE2_INTRINSICS)
+        VLC_CPU_IMPL( "sse2", VLC_CPU_SSE2, startcode_FindEP3B_SSE2 ),
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+        VLC_CPU_IMPL( "neon", VLC_CPU_ARM_NEON, startcode_FindEP3B_NEON ),
+#endif
+        VLC_CPU_IMPL( "c", 0, startcode_FindEP3B_C ),
+    };
+    *pi_count = ARRAY_SIZE(impls);
+    return impls;
+}
+
+/* Resolves the AnnexB startcode lookup once, e.g. when opening a packetizer */
+static inline startcode_find_t startcode_FindAnnexB_Select( void )
+{
+    size_t i_count;
+    const struct vlc_cpu_impl *impls = startcode_FindAnnexB_Impls( &i_count );
+    return (startcode_find_t) vlc_CPU_select( impls, i_count )->func;
+}
+
 static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
 {
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
     if (vlc_CPU_SSE2())
         return startcode_FindAnnexB_SSE2(p, end);
-    else
-        return startcode_FindAnnexB_Bits(p, end);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    return startcode_FindAnnexB_NEON(p, end);
+#endif
+    return startcode_FindAnnexB_Bits(p, end);
 }
-#else
-    #define startcode_FindAnnexB startcode_FindAnnexB_Bits
+
+/* Looks up the first 0x00 0x00 0x03 sequence, as candidate emulation
+ * prevention three byte */
+static inline const uint8_t * startcode_FindEP3B( const uint8_t *p, const uint8_t *end )
+{
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+        return startcode_Find_AVX2(p, end, 0x03);
 #endif
+#if defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        return startcode_Find_SSE2(p, end, 0x03);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    return startcode_Find_NEON(p, end, 0x03);
+#endif
+    return startcode_Find_C(p, end, 0x03);
+}
 
 #endif
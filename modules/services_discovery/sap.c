@@ -75,6 +75,11 @@
 #define SAP_V4_LINK_ADDRESS     "224.0.0.255"
 #define ADD_SESSION 1
 
+/* Buckets of the announcements hash table */
+#define SAP_HASH_SIZE 1024
+/* Slots of the timeout wheel, one per second */
+#define SAP_WHEEL_SIZE 4096
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -208,6 +213,9 @@ struct sap_announce_t
     sdp_t       *p_sdp;
 
     input_item_t * p_item;
+
+    sap_announce_t *p_hash_next;  /* Next in the hash bucket */
+    sap_announce_t *p_wheel_next; /* Next in the timeout wheel slot */
 };
 
 typedef struct
@@ -218,9 +226,16 @@ typedef struct
     int i_fd;
     int *pi_fd;
 
-    /* Table of announces */
+    /* Table of announces, hashed by source and message id hash.
+     * The announces without id hash (SAPv0) are matched by session. */
     int i_announces;
-    struct sap_announce_t **pp_announces;
+    sap_announce_t *pp_hash[SAP_HASH_SIZE];
+    sap_announce_t *p_unhashed;
+
+    /* Timeout wheel: the announces are checked on the second of their
+     * expected timeout, and moved further if they were refreshed since. */
+    sap_announce_t *pp_wheel[SAP_WHEEL_SIZE];
+    vlc_tick_t i_wheel_time; /* second of the next slot to check */
 
     /* Modes */
     bool  b_strict;
@@ -250,6 +265,9 @@ typedef struct
     static sdp_t *ParseSDP (vlc_object_t *p_sd, const char *psz_sdp);
     static sap_announce_t *CreateAnnounce( services_discovery_t *, uint32_t *, uint16_t, sdp_t * );
     static int RemoveAnnounce( services_discovery_t *p_sd, sap_announce_t *p_announce );
+    static void ExpireAnnounces( services_discovery_t *p_sd, vlc_tick_t now );
+    static size_t AnnounceHash( const uint32_t *i_source, uint16_t i_hash );
+    static void RefreshAnnounce( sap_announce_t *p_announce );
 
 /* Helper functions */
     static inline attribute_t *MakeAttribute (const char *str);
@@ -304,7 +322,13 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_parse = var_CreateGetBool( p_sd, "sap-parse" );
 
     p_sys->i_announces = 0;
-    p_sys->pp_announces = NULL;
+    for( int i = 0; i < SAP_HASH_SIZE; i++ )
+        p_sys->pp_hash[i] = NULL;
+    p_sys->p_unhashed = NULL;
+    for( int i = 0; i < SAP_WHEEL_SIZE; i++ )
+        p_sys->pp_wheel[i] = NULL;
+    vlc_tick_t now = vlc_tick_now();
+    p_sys->i_wheel_time = now - now % VLC_TICK_FROM_SEC(1);
     /* TODO: create sockets here, and fix racy sockets table */
     if (vlc_clone (&p_sys->thread, Run, p_sd, VLC_THREAD_PRIORITY_LOW))
     {
@@ -420,11 +444,13 @@ static void Close( vlc_object_t *p_this )
     }
     FREENULL( p_sys->pi_fd );
 
-    for( i = p_sys->i_announces  - 1;  i>= 0; i-- )
+    for( i = 0; i < SAP_HASH_SIZE; i++ )
     {
-        RemoveAnnounce( p_sd, p_sys->pp_announces[i] );
+        while( p_sys->pp_hash[i] != NULL )
+            RemoveAnnounce( p_sd, p_sys->pp_hash[i] );
     }
-    FREENULL( p_sys->pp_announces );
+    while( p_sys->p_unhashed != NULL )
+        RemoveAnnounce( p_sd, p_sys->p_unhashed );
 
     free( p_sys );
 }
@@ -566,37 +592,18 @@ static void *Run( void *data )
 
         vlc_tick_t now = vlc_tick_now();
 
-        /* A 1 hour timeout correspond to the RFC Implicit timeout.
-         * This timeout is tuned in the following loop. */
-        timeout = 1000 * 60 * 60;
-
         /* Check for items that need deletion */
-        for( int i = 0; i < p_sys->i_announces; i++ )
-        {
-            sap_announce_t * p_announce = p_sys->pp_announces[i];
-            vlc_tick_t i_last_period = now - p_announce->i_last;
-
-            /* Remove the announcement, if the last announcement was 1 hour ago
-             * or if the last packet emitted was 10 times the average time
-             * between two packets */
-            if( ( p_announce->i_period_trust > 5 && i_last_period > 10 * p_announce->i_period ) ||
-                i_last_period > p_sys->i_timeout )
-            {
-                RemoveAnnounce( p_sd, p_announce );
-            }
-            else
-            {
-                /* Compute next timeout */
-                if( p_announce->i_period_trust > 5 )
-                    timeout = __MIN(MS_FROM_VLC_TICK(10 * p_announce->i_period - i_last_period), timeout);
-                timeout = __MIN(MS_FROM_VLC_TICK(p_sys->i_timeout - i_last_period), timeout);
-            }
-        }
+        ExpireAnnounces( p_sd, now );
 
         if( !p_sys->i_announces )
             timeout = -1; /* We can safely poll indefinitely. */
-        else if( timeout < 200 )
-            timeout = 200; /* Don't wakeup too fast. */
+        else
+        {
+            /* Wake up for the next slot of the wheel */
+            timeout = MS_FROM_VLC_TICK(p_sys->i_wheel_time - now);
+            if( timeout < 200 )
+                timeout = 200; /* Don't wakeup too fast. */
+        }
     }
     vlc_assert_unreachable ();
 }
@@ -706,6 +713,29 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
     if (buf > end)
         return VLC_EGENERIC;
 
+    /* The message id hash changes with the announced session, so a known
+     * announcement is only refreshed, without decompressing nor parsing.
+     *
+     * We don't support delete announcement as they can easily
+     * Be used to highjack an announcement by a third party.
+     * Instead we cleverly implement Implicit Announcement removal. */
+    if( i_hash != 0 )
+    {
+        sap_announce_t *p_announce = p_sys->pp_hash[AnnounceHash( i_source, i_hash )];
+
+        while( p_announce != NULL
+            && ( p_announce->i_hash != i_hash
+              || memcmp( p_announce->i_source, i_source, sizeof(i_source) ) ) )
+            p_announce = p_announce->p_hash_next;
+
+        if( p_announce != NULL )
+        {
+            if( !b_need_delete )
+                RefreshAnnounce( p_announce );
+            return VLC_SUCCESS;
+        }
+    }
+
     uint8_t *decomp = NULL;
     if( b_compressed )
     {
@@ -777,38 +807,19 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
         goto error;
     }
 
-    for( int i = 0 ; i < p_sys->i_announces ; i++ )
+    if( !i_hash )
     {
-        sap_announce_t * p_announce = p_sys->pp_announces[i];
-        /* FIXME: slow */
-        if( ( !i_hash && IsSameSession( p_announce->p_sdp, p_sdp ) )
-            || ( i_hash && p_announce->i_hash == i_hash
-                 && !memcmp(p_announce->i_source, i_source, sizeof(i_source)) ) )
+        for( sap_announce_t *p_announce = p_sys->p_unhashed; p_announce != NULL;
+             p_announce = p_announce->p_hash_next )
         {
-            /* We don't support delete announcement as they can easily
-             * Be used to highjack an announcement by a third party.
-             * Instead we cleverly implement Implicit Announcement removal.
-             *
-             * if( b_need_delete )
-             *    RemoveAnnounce( p_sd, p_sys->pp_announces[i]);
-             * else
-             */
-
-            if( !b_need_delete )
+            if( IsSameSession( p_announce->p_sdp, p_sdp ) )
             {
-                /* No need to go after six, as we start to trust the
-                 * average period at six */
-                if( p_announce->i_period_trust <= 5 )
-                    p_announce->i_period_trust++;
-
-                /* Compute the average period */
-                vlc_tick_t now = vlc_tick_now();
-                p_announce->i_period = ( p_announce->i_period * (p_announce->i_period_trust-1) + (now - p_announce->i_last) ) / p_announce->i_period_trust;
-                p_announce->i_last = now;
+                if( !b_need_delete )
+                    RefreshAnnounce( p_announce );
+                FreeSDP( p_sdp );
+                free (decomp);
+                return VLC_SUCCESS;
             }
-            FreeSDP( p_sdp );
-            free (decomp);
-            return VLC_SUCCESS;
         }
     }
 
@@ -821,6 +832,89 @@ error:
     return VLC_EGENERIC;
 }
 
+static size_t AnnounceHash( const uint32_t *i_source, uint16_t i_hash )
+{
+    uint32_t h = i_hash;
+
+    for( int i = 0; i < 4; i++ )
+        h = ( h ^ i_source[i] ) * 0x01000193; /* FNV prime */
+    return ( h ^ ( h >> 16 ) ) % SAP_HASH_SIZE;
+}
+
+static void RefreshAnnounce( sap_announce_t *p_announce )
+{
+    /* No need to go after six, as we start to trust the
+     * average period at six */
+    if( p_announce->i_period_trust <= 5 )
+        p_announce->i_period_trust++;
+
+    /* Compute the average period */
+    vlc_tick_t now = vlc_tick_now();
+    p_announce->i_period = ( p_announce->i_period * (p_announce->i_period_trust-1) + (now - p_announce->i_last) ) / p_announce->i_period_trust;
+    p_announce->i_last = now;
+}
+
+/* Remove the announcement, if the last announcement was 1 hour ago
+ * or if the last packet emitted was 10 times the average time
+ * between two packets */
+static vlc_tick_t AnnounceDeadline( const services_discovery_sys_t *p_sys,
+                                    const sap_announce_t *p_announce )
+{
+    vlc_tick_t i_deadline = p_announce->i_last + p_sys->i_timeout;
+
+    if( p_announce->i_period_trust > 5 )
+        i_deadline = __MIN( i_deadline,
+                            p_announce->i_last + 10 * p_announce->i_period );
+    return i_deadline;
+}
+
+static void WheelInsert( services_discovery_sys_t *p_sys,
+                         sap_announce_t *p_announce )
+{
+    vlc_tick_t i_deadline = AnnounceDeadline( p_sys, p_announce );
+
+    /* Later timeouts are checked again when the wheel went round */
+    if( i_deadline > p_sys->i_wheel_time + VLC_TICK_FROM_SEC(SAP_WHEEL_SIZE - 1) )
+        i_deadline = p_sys->i_wheel_time + VLC_TICK_FROM_SEC(SAP_WHEEL_SIZE - 1);
+    if( i_deadline < p_sys->i_wheel_time )
+        i_deadline = p_sys->i_wheel_time;
+
+    size_t i_slot = ( i_deadline / VLC_TICK_FROM_SEC(1) ) % SAP_WHEEL_SIZE;
+    p_announce->p_wheel_next = p_sys->pp_wheel[i_slot];
+    p_sys->pp_wheel[i_slot] = p_announce;
+}
+
+static void ExpireAnnounces( services_discovery_t *p_sd, vlc_tick_t now )
+{
+    services_discovery_sys_t *p_sys = p_sd->p_sys;
+
+    /* After a long sleep, the whole wheel is checked once */
+    if( now - p_sys->i_wheel_time >= VLC_TICK_FROM_SEC(SAP_WHEEL_SIZE) )
+        p_sys->i_wheel_time = now - now % VLC_TICK_FROM_SEC(1)
+                            - VLC_TICK_FROM_SEC(SAP_WHEEL_SIZE - 1);
+
+    while( p_sys->i_wheel_time <= now )
+    {
+        size_t i_slot = ( p_sys->i_wheel_time / VLC_TICK_FROM_SEC(1) )
+                        % SAP_WHEEL_SIZE;
+        sap_announce_t *p_announce = p_sys->pp_wheel[i_slot];
+
+        p_sys->pp_wheel[i_slot] = NULL;
+        p_sys->i_wheel_time += VLC_TICK_FROM_SEC(1);
+
+        while( p_announce != NULL )
+        {
+            sap_announce_t *p_next = p_announce->p_wheel_next;
+
+            if( now > AnnounceDeadline( p_sys, p_announce ) )
+                RemoveAnnounce( p_sd, p_announce );
+            else
+                WheelInsert( p_sys, p_announce );
+            p_announce = p_next;
+        }
+    }
+}
+
 sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint32_t *i_source, uint16_t i_hash,
                                 sdp_t *p_sdp )
 {
@@ -901,7 +995,13 @@ sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint32_t *i_source,
         services_discovery_AddItemCat(p_sd, p_input, psz_value);
     }
 
-    TAB_APPEND( p_sys->i_announces, p_sys->pp_announces, p_sap );
+    sap_announce_t **pp_head = i_hash ? &p_sys->pp_hash[AnnounceHash( i_source, i_hash )]
+                                      : &p_sys->p_unhashed;
+    p_sap->p_hash_next = *pp_head;
+    *pp_head = p_sap;
+    p_sys->i_announces++;
+
+    WheelInsert( p_sys, p_sap );
 
     return p_sap;
 }
@@ -1577,8 +1677,17 @@ static int RemoveAnnounce( services_discovery_t *p_sd,
         p_announce->p_item = NULL;
     }
 
+    /* The announce is not in the timeout wheel anymore: it is only removed
+     * when it timed out, or when closing */
     services_discovery_sys_t *p_sys = p_sd->p_sys;
-    TAB_REMOVE(p_sys->i_announces, p_sys->pp_announces, p_announce);
+    sap_announce_t **pp = p_announce->i_hash
+        ? &p_sys->pp_hash[AnnounceHash( p_announce->i_source, p_announce->i_hash )]
+        : &p_sys->p_unhashed;
+
+    while( *pp != p_announce )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_announce->p_hash_next;
+    p_sys->i_announces--;
     free( p_announce );
 
     return VLC_SUCCESS;
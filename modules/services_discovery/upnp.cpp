@@ -40,6 +40,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <algorithm>
+#include <list>
 #include <set>
 #include <string>
 
@@ -183,19 +184,11 @@ vlc_module_begin()
 vlc_module_end()
 
 /*
- * Extracts the result document from a SOAP response
+ * Parses the DIDL-Lite document of a Browse result
  */
-IXML_Document* parseBrowseResult( IXML_Document* p_doc )
+IXML_Document* parseBrowseResult( const char* psz_raw_didl )
 {
-    assert( p_doc );
-
-    // ixml*_getElementsByTagName will ultimately only case the pointer to a Node
-    // pointer, and pass it to a private function. Don't bother have a IXML_Document
-    // version of getChildElementValue
-    const char* psz_raw_didl = xml_getChildElementValue( (IXML_Element*)p_doc, "Result" );
-
-    if( !psz_raw_didl )
-        return NULL;
+    assert( psz_raw_didl );
 
     /* First, try parsing the buffer as is */
     IXML_Document* p_result_doc = ixmlParseBuffer( psz_raw_didl );
@@ -1157,38 +1150,128 @@ int MediaServer::sendActionCb( Upnp_EventType eventType,
 {
     if( eventType != UPNP_CONTROL_ACTION_COMPLETE )
         return 0;
-    IXML_Document** pp_sendActionResult = (IXML_Document** )p_cookie;
+    BrowseResult* result = (BrowseResult* )p_cookie;
     const UpnpActionComplete *p_result = (const UpnpActionComplete *)p_event;
 
-    /* The only way to dup the result is to print it and parse it again */
-    DOMString tmpStr = ixmlPrintNode( ( IXML_Node * ) UpnpActionComplete_get_ActionResult( p_result ) );
-    if (tmpStr == NULL)
+    /* Only copy the values used from the response, the document is
+     * destroyed after the callback */
+    // ixml*_getElementsByTagName will ultimately only case the pointer to a Node
+    // pointer, and pass it to a private function. Don't bother have a IXML_Document
+    // version of getChildElementValue
+    IXML_Element* p_response = (IXML_Element*)UpnpActionComplete_get_ActionResult( p_result );
+    if ( p_response == NULL )
         return 0;
 
-    *pp_sendActionResult = ixmlParseBuffer( tmpStr );
-    ixmlFreeDOMString( tmpStr );
+    const char* psz_didl = xml_getChildElementValue( p_response, "Result" );
+    if ( psz_didl == NULL )
+        return 0;
+    result->didl = psz_didl;
+
+    const char* psz_value = xml_getChildElementValue( p_response, "NumberReturned" );
+    if ( psz_value )
+        result->returned = strtoul( psz_value, NULL, 10 );
+    psz_value = xml_getChildElementValue( p_response, "TotalMatches" );
+    if ( psz_value )
+        result->total = strtoul( psz_value, NULL, 10 );
+    psz_value = xml_getChildElementValue( p_response, "UpdateID" );
+    if ( psz_value )
+        result->updateId = strtoul( psz_value, NULL, 10 );
+    result->ok = true;
     return 0;
 }
 
 /* Access part */
-IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
-                                           const char* psz_browser_flag_,
-                                           const char* psz_filter_,
-                                           const char* psz_requested_count_,
-                                           const char* psz_sort_criteria_ )
+
+/* Items requested per Browse action, some servers don't understand "0" as
+ * "no-limit" */
+#define BROWSE_PAGE_SIZE 1000
+/* Browse actions sent ahead of the page being parsed */
+#define BROWSE_MAX_PENDING 4
+
+namespace
+{
+
+/*
+ * Browse results of the containers visited recently: a container is not
+ * fetched again as long as the server reports the same update ID and number
+ * of children for it
+ */
+struct BrowseCacheEntry
+{
+    std::string key;
+    unsigned int updateId;
+    unsigned int total;
+    std::vector<std::string> pages;
+    size_t size;
+};
+
+#define BROWSE_CACHE_MAX_SIZE (32 << 20)
+
+vlc::threads::mutex browseCacheLock;
+std::list<BrowseCacheEntry> browseCache; /* most recently used first */
+size_t browseCacheSize = 0;
+
+bool browseCacheFind( const std::string& key, unsigned int updateId,
+                      unsigned int total, std::vector<std::string>* pages )
+{
+    vlc::threads::mutex_locker lock( browseCacheLock );
+    for ( auto it = browseCache.begin(); it != browseCache.end(); ++it )
+    {
+        if ( it->key != key )
+            continue;
+        if ( it->updateId != updateId || it->total != total )
+            return false;
+        browseCache.splice( browseCache.begin(), browseCache, it );
+        *pages = it->pages;
+        return true;
+    }
+    return false;
+}
+
+void browseCacheInsert( BrowseCacheEntry&& entry )
+{
+    vlc::threads::mutex_locker lock( browseCacheLock );
+    for ( auto it = browseCache.begin(); it != browseCache.end(); ++it )
+    {
+        if ( it->key == entry.key )
+        {
+            browseCacheSize -= it->size;
+            browseCache.erase( it );
+            break;
+        }
+    }
+    if ( entry.size > BROWSE_CACHE_MAX_SIZE )
+        return;
+    while ( browseCacheSize + entry.size > BROWSE_CACHE_MAX_SIZE )
+    {
+        browseCacheSize -= browseCache.back().size;
+        browseCache.pop_back();
+    }
+    browseCacheSize += entry.size;
+    browseCache.push_front( std::move( entry ) );
+}
+
+}
+
+Upnp_i11e_cb* MediaServer::_browseAction( unsigned int startIndex,
+                                          unsigned int count,
+                                          BrowseResult* result )
 {
     IXML_Document* p_action = NULL;
-    IXML_Document* p_response = NULL;
     Upnp_i11e_cb *i11eCb = NULL;
     access_sys_t *sys = (access_sys_t *)m_access->p_sys;
+    char psz_start_index[11], psz_requested_count[11];
 
     int i_res;
 
     if ( vlc_killed() )
         return NULL;
 
+    snprintf( psz_start_index, sizeof( psz_start_index ), "%u", startIndex );
+    snprintf( psz_requested_count, sizeof( psz_requested_count ), "%u", count );
+
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "ObjectID", psz_object_id_ ? psz_object_id_ : "0" );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "ObjectID", m_psz_objectId ? m_psz_objectId : "0" );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1198,7 +1281,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "BrowseFlag", psz_browser_flag_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "BrowseFlag", "BrowseDirectChildren" );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1208,7 +1291,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "Filter", psz_filter_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "Filter", "*" );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1218,7 +1301,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", "0" );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", psz_start_index );
     if ( i_res != UPNP_E_SUCCESS )
     {
         msg_Dbg( m_access, "AddToAction 'StartingIndex' failed: %s",
@@ -1227,7 +1310,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", psz_requested_count_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", psz_requested_count );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1237,7 +1320,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "SortCriteria", psz_sort_criteria_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "SortCriteria", "" );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1248,7 +1331,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     /* Setup an interruptible callback that will call sendActionCb if not
      * interrupted by vlc_interrupt_kill */
-    i11eCb = new Upnp_i11e_cb( sendActionCb, &p_response );
+    i11eCb = new Upnp_i11e_cb( sendActionCb, result );
     i_res = UpnpSendActionAsync( sys->p_upnp->handle(),
               m_psz_root,
               CONTENT_DIRECTORY_SERVICE_TYPE,
@@ -1260,36 +1343,36 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     {
         msg_Err( m_access, "%s when trying the send() action with URL: %s",
                 UpnpGetErrorMessage( i_res ), m_access->psz_location );
+        /* the callback will never be called */
+        delete i11eCb;
+        i11eCb = NULL;
     }
-    /* Wait for the callback to fill p_response or wait for an interrupt */
-    i11eCb->waitAndRelease();
 
 browseActionCleanup:
     ixmlDocument_free( p_action );
-    return p_response;
+    return i11eCb;
 }
 
 /*
- * Fetches and parses the UPNP response
+ * Sends a Browse action and waits for its result
  */
-bool MediaServer::fetchContents()
+bool MediaServer::browse( unsigned int startIndex, unsigned int count,
+                          BrowseResult* result )
 {
-    IXML_Document* p_response = _browseAction( m_psz_objectId,
-                                      "BrowseDirectChildren",
-                                      "*",
-                                      // Some servers don't understand "0" as "no-limit"
-                                      "5000", /* RequestedCount */
-                                      "" /* SortCriteria */
-                                      );
-    if ( !p_response )
-    {
-        msg_Err( m_access, "No response from browse() action" );
+    Upnp_i11e_cb* i11eCb = _browseAction( startIndex, count, result );
+    if ( !i11eCb )
         return false;
-    }
-
-    IXML_Document* p_result = parseBrowseResult( p_response );
+    /* Wait for the callback to fill the result or wait for an interrupt */
+    i11eCb->waitAndRelease();
+    return result->ok;
+}
 
-    ixmlDocument_free( p_response );
+/*
+ * Parses a DIDL-Lite document and adds its items to the node
+ */
+bool MediaServer::addContents( const char* psz_didl )
+{
+    IXML_Document* p_result = parseBrowseResult( psz_didl );
 
     if ( !p_result )
     {
@@ -1323,6 +1406,129 @@ bool MediaServer::fetchContents()
     return true;
 }
 
+/*
+ * Fetches and parses the UPNP response
+ *
+ * The children are fetched by pages. The first page gives the number of
+ * children, the following pages are then requested ahead of the one being
+ * parsed, and parsed in order as they arrive.
+ */
+bool MediaServer::fetchContents()
+{
+    BrowseResult first;
+    if ( !browse( 0, BROWSE_PAGE_SIZE, &first ) )
+    {
+        msg_Err( m_access, "No response from browse() action" );
+        return false;
+    }
+    if ( !addContents( first.didl.c_str() ) )
+        return false;
+
+    unsigned int next = first.returned;
+    if ( first.returned == 0 || next >= first.total )
+        return true;
+
+    /* the servers may return less children than requested */
+    unsigned int pageSize = std::min<unsigned int>( first.returned, BROWSE_PAGE_SIZE );
+
+    std::string key = std::string( m_psz_root ) + "|"
+                    + ( m_psz_objectId ? m_psz_objectId : "0" );
+    std::vector<std::string> pages;
+    if ( browseCacheFind( key, first.updateId, first.total, &pages ) )
+    {
+        msg_Dbg( m_access, "container unchanged (update ID %u), using the cache",
+                 first.updateId );
+        for ( size_t i = 1; i < pages.size(); i++ )
+            if ( !addContents( pages[i].c_str() ) )
+                return false;
+        return true;
+    }
+
+    BrowseCacheEntry entry;
+    entry.key = key;
+    entry.updateId = first.updateId;
+    entry.total = first.total;
+    entry.size = first.didl.size();
+    entry.pages.push_back( std::move( first.didl ) );
+
+    struct PendingBrowse
+    {
+        unsigned int startIndex;
+        unsigned int count;
+        Upnp_i11e_cb* i11eCb;
+        BrowseResult result;
+    };
+    std::list<PendingBrowse> pending;
+    unsigned int requested = next;
+    bool success = true;
+
+    while ( success && next < entry.total )
+    {
+        while ( pending.size() < BROWSE_MAX_PENDING && requested < entry.total )
+        {
+            pending.emplace_back();
+            PendingBrowse& req = pending.back();
+            req.startIndex = requested;
+            req.count = std::min( pageSize, entry.total - requested );
+            req.i11eCb = _browseAction( req.startIndex, req.count, &req.result );
+            if ( !req.i11eCb )
+            {
+                pending.pop_back();
+                break;
+            }
+            requested += req.count;
+        }
+        if ( pending.empty() )
+        {
+            success = false;
+            break;
+        }
+
+        PendingBrowse& req = pending.front();
+        req.i11eCb->waitAndRelease();
+        if ( !req.result.ok || !addContents( req.result.didl.c_str() ) )
+        {
+            success = false;
+            pending.pop_front();
+            break;
+        }
+        next = req.startIndex + req.result.returned;
+        entry.size += req.result.didl.size();
+        entry.pages.push_back( std::move( req.result.didl ) );
+
+        /* fetch the children missing from a short page before parsing the
+         * following ones */
+        unsigned int end = req.startIndex + req.count;
+        unsigned int returned = req.result.returned;
+        pending.pop_front();
+        while ( returned > 0 && next < end )
+        {
+            BrowseResult missing;
+            if ( !browse( next, end - next, &missing )
+              || !addContents( missing.didl.c_str() ) )
+            {
+                success = false;
+                break;
+            }
+            returned = missing.returned;
+            next += missing.returned;
+            entry.size += missing.didl.size();
+            entry.pages.push_back( std::move( missing.didl ) );
+        }
+        if ( returned == 0 )
+            break;
+        next = end;
+    }
+
+    /* the remaining actions write in the list until they complete */
+    for ( auto& req : pending )
+        req.i11eCb->waitAndRelease();
+
+    if ( success && next >= entry.total )
+        browseCacheInsert( std::move( entry ) );
+    return success;
+}
+
 static int ReadDirectory( stream_t *p_access, input_item_node_t* p_node )
 {
     MediaServer server( p_access, p_node );
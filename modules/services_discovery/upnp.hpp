@@ -109,11 +109,23 @@ private:
     MediaServer(const MediaServer&);
     MediaServer& operator=(const MediaServer&);
 
+    /* Result of a Browse action */
+    struct BrowseResult
+    {
+        std::string didl;
+        unsigned int returned = 0;
+        unsigned int total = 0;
+        unsigned int updateId = 0;
+        bool ok = false;
+    };
+
     bool addContainer( IXML_Element* containerElement );
     bool addItem( IXML_Element* itemElement );
+    bool addContents( const char* psz_didl );
 
-    IXML_Document* _browseAction(const char*, const char*,
-            const char*, const char*, const char* );
+    Upnp_i11e_cb* _browseAction( unsigned int startIndex, unsigned int count,
+                                 BrowseResult* result );
+    bool browse( unsigned int startIndex, unsigned int count, BrowseResult* result );
     static int sendActionCb( Upnp_EventType, UpnpEventPtr, void *);
 
 private:
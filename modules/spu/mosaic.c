@@ -54,6 +54,12 @@ static int MosaicCallback   ( vlc_object_t *, char const *, vlc_value_t,
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
+typedef struct
+{
+    picture_t *p_source;      /* Last bridged picture shown in the tile */
+    picture_t *p_converted;   /* Same picture at the size of the tile */
+} mosaic_tile_t;
+
 typedef struct
 {
     vlc_mutex_t lock;         /* Internal filter lock */
@@ -78,6 +84,9 @@ typedef struct
     int i_offsets_length;
 
     vlc_tick_t i_delay;
+
+    mosaic_tile_t *p_tiles;   /* Converted pictures, per bridged ES */
+    int i_tiles;
 } filter_sys_t;
 
 /*****************************************************************************
@@ -289,6 +298,8 @@ static int CreateFilter( vlc_object_t *p_this )
         return VLC_ENOMEM;
 
     p_filter->pf_sub_source = Filter;
+    p_sys->p_tiles = NULL;
+    p_sys->i_tiles = 0;
 
     vlc_mutex_init( &p_sys->lock );
     vlc_mutex_lock( &p_sys->lock );
@@ -406,6 +417,16 @@ static void DestroyFilter( vlc_object_t *p_this )
         image_HandlerDelete( p_sys->p_image );
     }
 
+    for( int i_index = 0; i_index < p_sys->i_tiles; i_index++ )
+    {
+        mosaic_tile_t *p_tile = &p_sys->p_tiles[i_index];
+        if( p_tile->p_source )
+            picture_Release( p_tile->p_source );
+        if( p_tile->p_converted )
+            picture_Release( p_tile->p_converted );
+    }
+    free( p_sys->p_tiles );
+
     if( p_sys->i_order_length )
     {
         for( int i_index = 0; i_index < p_sys->i_order_length; i_index++ )
@@ -424,6 +445,63 @@ static void DestroyFilter( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Tiles
+ *****************************************************************************/
+typedef struct
+{
+    picture_t *p_picture;     /* Bridged picture to show, NULL if none */
+    int i_real_index;
+    int i_x, i_y;
+    int i_alpha;
+} mosaic_input_t;
+
+static void ResetTile( mosaic_tile_t *p_tile )
+{
+    if( p_tile->p_source )
+        picture_Release( p_tile->p_source );
+    if( p_tile->p_converted )
+        picture_Release( p_tile->p_converted );
+    p_tile->p_source = p_tile->p_converted = NULL;
+}
+
+/**
+ * Returns a reference to the picture converted to fmt_out. The bridges
+ * usually run slower than the mosaic, so the last conversion of each tile
+ * is kept and the picture is only converted again once it changed. When
+ * the bridge already scaled the picture to the size of the tile (its
+ * width and height options), it is used as is.
+ */
+static picture_t *ConvertTile( filter_sys_t *p_sys, mosaic_tile_t *p_tile,
+                               picture_t *p_picture,
+                               const video_format_t *p_fmt_in,
+                               video_format_t *p_fmt_out )
+{
+    picture_t *p_converted = p_tile->p_converted;
+
+    if( p_tile->p_source == p_picture && p_converted != NULL
+     && p_converted->format.i_chroma == p_fmt_out->i_chroma
+     && p_converted->format.i_width == p_fmt_out->i_width
+     && p_converted->format.i_height == p_fmt_out->i_height )
+        return picture_Hold( p_converted );
+
+    if( p_fmt_in->i_chroma == p_fmt_out->i_chroma
+     && p_fmt_in->i_width == p_fmt_out->i_width
+     && p_fmt_in->i_height == p_fmt_out->i_height )
+        p_converted = picture_Hold( p_picture );
+    else
+        p_converted = image_Convert( p_sys->p_image, p_picture,
+                                     p_fmt_in, p_fmt_out );
+
+    ResetTile( p_tile );
+    if( p_converted != NULL )
+    {
+        p_tile->p_source = picture_Hold( p_picture );
+        p_tile->p_converted = picture_Hold( p_converted );
+    }
+    return p_converted;
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -518,17 +596,41 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
     row_inner_height = ( ( p_sys->i_height - ( p_sys->i_rows - 1 )
                        * p_sys->i_borderh ) / p_sys->i_rows );
 
+    /* Only pick the pictures to show while the bridges are locked: the
+     * conversions and the regions are done after, so that the bridge
+     * threads are not blocked for the whole composition. */
+    int i_es_num = p_bridge->i_es_num;
+    mosaic_input_t *p_inputs = vlc_alloc( i_es_num, sizeof(*p_inputs) );
+    if( i_es_num > p_sys->i_tiles )
+    {
+        mosaic_tile_t *p_tiles = realloc( p_sys->p_tiles,
+                                          i_es_num * sizeof(*p_tiles) );
+        if( p_tiles != NULL )
+        {
+            memset( &p_tiles[p_sys->i_tiles], 0,
+                    ( i_es_num - p_sys->i_tiles ) * sizeof(*p_tiles) );
+            p_sys->p_tiles = p_tiles;
+            p_sys->i_tiles = i_es_num;
+        }
+    }
+    if( p_inputs == NULL || i_es_num > p_sys->i_tiles )
+    {
+        free( p_inputs );
+        vlc_global_unlock( VLC_MOSAIC_MUTEX );
+        vlc_mutex_unlock( &p_sys->lock );
+        return p_spu;
+    }
+
     i_real_index = 0;
 
-    for( int i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
+    for( int i_index = 0; i_index < i_es_num; i_index++ )
     {
         bridged_es_t *p_es = p_bridge->pp_es[i_index];
-        video_format_t fmt_in, fmt_out;
-        picture_t *p_converted;
+        mosaic_input_t *p_input = &p_inputs[i_index];
 
+        p_input->p_picture = NULL;
         if ( p_es->b_empty )
             continue;
-
         while ( p_es->p_picture != NULL
                  && p_es->p_picture->date + p_sys->i_delay < date )
         {
@@ -578,6 +680,30 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             if ( i == p_sys->i_order_length )
                 i_real_index = ++i_greatest_real_index_used;
         }
+        p_input->p_picture = picture_Hold( p_es->p_picture );
+        p_input->i_real_index = i_real_index;
+        p_input->i_x = p_es->i_x;
+        p_input->i_y = p_es->i_y;
+        p_input->i_alpha = p_es->i_alpha;
+    }
+
+    vlc_global_unlock( VLC_MOSAIC_MUTEX );
+
+    for( int i_index = 0; i_index < i_es_num; i_index++ )
+    {
+        mosaic_input_t *p_input = &p_inputs[i_index];
+        mosaic_tile_t *p_tile = &p_sys->p_tiles[i_index];
+        picture_t *p_picture = p_input->p_picture;
+        video_format_t fmt_in, fmt_out;
+        picture_t *p_converted;
+
+        if ( p_picture == NULL )
+        {
+            ResetTile( p_tile );
+            continue;
+        }
+
+        i_real_index = p_input->i_real_index;
         i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
         i_col = i_real_index % p_sys->i_cols ;
 
@@ -587,9 +713,9 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         if ( !p_sys->b_keep )
         {
             /* Convert the images */
-            fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
-            fmt_in.i_height = p_es->p_picture->format.i_height;
-            fmt_in.i_width = p_es->p_picture->format.i_width;
+            fmt_in.i_chroma = p_picture->format.i_chroma;
+            fmt_in.i_height = p_picture->format.i_height;
+            fmt_in.i_width = p_picture->format.i_width;
 
             if( fmt_in.i_chroma == VLC_CODEC_YUVA ||
                 fmt_in.i_chroma == VLC_CODEC_RGBA )
@@ -617,20 +743,21 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
+            p_converted = ConvertTile( p_sys, p_tile, p_picture,
+                                       &fmt_in, &fmt_out );
             if( !p_converted )
             {
                 msg_Warn( p_filter,
                            "image resizing and chroma conversion failed" );
                 video_format_Clean( &fmt_in );
                 video_format_Clean( &fmt_out );
+                picture_Release( p_picture );
                 continue;
             }
         }
         else
         {
-            p_converted = p_es->p_picture;
+            p_converted = picture_Hold( p_picture );
             fmt_in.i_width = fmt_out.i_width = p_converted->format.i_width;
             fmt_in.i_height = fmt_out.i_height = p_converted->format.i_height;
             fmt_in.i_chroma = fmt_out.i_chroma = p_converted->format.i_chroma;
@@ -638,11 +765,17 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             fmt_out.i_visible_height = fmt_out.i_height;
         }
 
+        picture_Release( p_picture );
+
+        /* The blending only reads the region picture: share the converted
+         * picture instead of copying its pixels */
         p_region = subpicture_region_New( &fmt_out );
-        /* FIXME the copy is probably not needed anymore */
         if( p_region )
-            picture_Copy( p_region->p_picture, p_converted );
-        if( !p_sys->b_keep )
+        {
+            picture_Release( p_region->p_picture );
+            p_region->p_picture = p_converted;
+        }
+        else
             picture_Release( p_converted );
 
         if( !p_region )
@@ -650,16 +783,19 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             video_format_Clean( &fmt_in );
             video_format_Clean( &fmt_out );
             msg_Err( p_filter, "cannot allocate SPU region" );
+            for( int i = i_index + 1; i < i_es_num; i++ )
+                if( p_inputs[i].p_picture != NULL )
+                    picture_Release( p_inputs[i].p_picture );
+            free( p_inputs );
             subpicture_Delete( p_spu );
-            vlc_global_unlock( VLC_MOSAIC_MUTEX );
             vlc_mutex_unlock( &p_sys->lock );
             return NULL;
         }
 
-        if( p_es->i_x >= 0 && p_es->i_y >= 0 )
+        if( p_input->i_x >= 0 && p_input->i_y >= 0 )
         {
-            p_region->i_x = p_es->i_x;
-            p_region->i_y = p_es->i_y;
+            p_region->i_x = p_input->i_x;
+            p_region->i_y = p_input->i_y;
         }
         else if( p_sys->i_position == position_offsets )
         {
@@ -705,7 +841,7 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             }
         }
         p_region->i_align = p_sys->i_align;
-        p_region->i_alpha = p_es->i_alpha;
+        p_region->i_alpha = p_input->i_alpha;
 
         if( p_region_prev == NULL )
         {
@@ -722,7 +858,7 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         p_region_prev = p_region;
     }
 
-    vlc_global_unlock( VLC_MOSAIC_MUTEX );
+    free( p_inputs );
     vlc_mutex_unlock( &p_sys->lock );
 
     return p_spu;
@@ -77,9 +77,16 @@ struct private_sys_t
     uint64_t i_offset;
 
     uint8_t buffer[ 8192 ];
+    uint64_t i_buffer_offset; /* position of the buffer in the source */
+    size_t i_buffer_len;
     bool b_seekable_source;
     bool b_seekable_archive;
 
+    /* the entry is stored uncompressed and contiguous in the source, at
+     * i_data_offset: it is read directly from the source */
+    bool b_direct;
+    uint64_t i_data_offset;
+
     libarchive_callback_t** pp_callback_data;
     size_t i_callback_data;
 };
@@ -188,6 +195,9 @@ static la_ssize_t libarchive_read_cb( libarchive_t* p_arc, void* p_obj,
     stream_t*  p_source = p_cb->p_source;
     private_sys_t* p_sys = p_cb->p_sys;
 
+    p_sys->i_buffer_offset = vlc_stream_Tell( p_source );
+    p_sys->i_buffer_len = 0;
+
     ssize_t i_ret = vlc_stream_Read( p_source, &p_sys->buffer,
       sizeof( p_sys->buffer ) );
 
@@ -199,6 +209,7 @@ static la_ssize_t libarchive_read_cb( libarchive_t* p_arc, void* p_obj,
         return ARCHIVE_FATAL;
     }
 
+    p_sys->i_buffer_len = i_ret;
     *pp_dst = &p_sys->buffer;
     return i_ret;
 }
@@ -403,6 +414,71 @@ static int archive_extractor_reset( stream_extractor_t* p_extractor )
     return VLC_SUCCESS;
 }
 
+/**
+ * Checks whether the entry is stored uncompressed, in one piece, in the
+ * source, so that it can be read and seeked without libarchive.
+ *
+ * libarchive hands over the data of such entries without copying them,
+ * straight from the buffer filled by libarchive_read_cb: the position of
+ * the first data block in this buffer gives the offset of the entry in
+ * the source. Compressed, encrypted or filtered data is never returned
+ * from this buffer.
+ */
+static int archive_map_entry( stream_extractor_t* p_extractor )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+    libarchive_t* p_arc = p_sys->p_archive;
+
+    if( !p_sys->b_seekable_source || p_sys->i_callback_data != 1
+     || archive_filter_count( p_arc ) != 1
+     || !archive_entry_size_is_set( p_sys->p_entry )
+     || archive_entry_size( p_sys->p_entry ) <= 0
+     || archive_entry_sparse_count( p_sys->p_entry ) != 0 )
+        return VLC_EGENERIC;
+
+    switch( archive_format( p_arc ) & ARCHIVE_FORMAT_BASE_MASK )
+    {
+        case ARCHIVE_FORMAT_ZIP:
+        case ARCHIVE_FORMAT_RAR:
+        case ARCHIVE_FORMAT_TAR:
+        case ARCHIVE_FORMAT_7ZIP:
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    void const* p_block;
+    size_t i_block;
+    la_int64_t i_block_offset;
+
+    if( archive_read_data_block( p_arc, &p_block, &i_block,
+                                 &i_block_offset ) == ARCHIVE_OK
+     && i_block_offset == 0
+     && (uintptr_t)p_block >= (uintptr_t)p_sys->buffer
+     && (uintptr_t)p_block + i_block
+        <= (uintptr_t)p_sys->buffer + p_sys->i_buffer_len )
+    {
+        uint64_t i_data_offset = p_sys->i_buffer_offset
+            + ( (uint8_t const*)p_block - p_sys->buffer );
+        uint64_t i_source_size;
+
+        if( vlc_stream_GetSize( p_extractor->source, &i_source_size )
+         || i_data_offset + archive_entry_size( p_sys->p_entry ) <= i_source_size )
+        {
+            msg_Dbg( p_extractor, "entry stored at offset %"PRIu64
+                     ", reading it directly", i_data_offset );
+            p_sys->i_data_offset = i_data_offset;
+            p_sys->b_direct = true;
+            return VLC_SUCCESS;
+        }
+    }
+
+    /* the data consumed by the check must be read again */
+    if( archive_extractor_reset( p_extractor ) )
+        msg_Err( p_extractor, "unable to reset libarchive handle" );
+    return VLC_EGENERIC;
+}
+
 /* ------------------------------------------------------------------------- */
 
 static private_sys_t* setup( vlc_object_t* obj, stream_t* source )
@@ -498,6 +574,8 @@ static int Control( stream_extractor_t* p_extractor, int i_query, va_list args )
     switch( i_query )
     {
         case STREAM_CAN_FASTSEEK:
+            if( p_sys->b_direct )
+                return vlc_stream_vaControl( p_extractor->source, i_query, args );
             *va_arg( args, bool* ) = false;
             break;
 
@@ -577,6 +655,28 @@ static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_siz
     if( p_sys->b_eof )
         return 0;
 
+    if( p_sys->b_direct )
+    {
+        uint64_t i_left = archive_entry_size( p_sys->p_entry ) - p_sys->i_offset;
+        uint64_t i_pos = p_sys->i_data_offset + p_sys->i_offset;
+
+        if( i_left == 0 )
+            goto eof;
+        if( i_size > i_left )
+            i_size = i_left;
+
+        if( vlc_stream_Tell( p_extractor->source ) != i_pos
+         && vlc_stream_Seek( p_extractor->source, i_pos ) )
+            goto fatal_error;
+
+        i_ret = vlc_stream_Read( p_extractor->source, p_data, i_size );
+        if( i_ret <= 0 )
+            goto eof;
+
+        p_sys->i_offset += i_ret;
+        return i_ret;
+    }
+
     i_ret = archive_read_data( p_arc,
       p_data ? p_data :                        dummy_buffer,
       p_data ? i_size : __MIN( i_size, sizeof( dummy_buffer ) ) );
@@ -639,6 +739,13 @@ static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
 
     p_sys->b_eof = false;
 
+    if( p_sys->b_direct )
+    {
+        /* the source is seeked by the next Read */
+        p_sys->i_offset = i_req;
+        return VLC_SUCCESS;
+    }
+
     if( !p_sys->b_seekable_archive || p_sys->b_dead
       || archive_seek_data( p_sys->p_archive, i_req, SEEK_SET ) < 0 )
     {
@@ -745,6 +852,13 @@ static int ExtractorOpen( vlc_object_t* p_obj )
     }
 
     p_extractor->p_sys = p_sys;
+
+    if( archive_map_entry( p_extractor ) && p_sys->b_dead )
+    {
+        CommonClose( p_sys );
+        return VLC_EGENERIC;
+    }
+
     p_extractor->pf_read = Read;
     p_extractor->pf_control = Control;
     p_extractor->pf_seek = Seek;
@@ -37,7 +37,6 @@ typedef struct chunk_s
     uint64_t    timestamp;
     uint32_t    frag_num;
     uint32_t    seg_num;
-    uint32_t    frun_entry; /* Used to speed things up in vod situations */
 
     uint32_t    data_len;
 
@@ -50,12 +49,14 @@ typedef struct chunk_s
     uint8_t     *data;
     bool        failed;
     bool        eof;
+    bool        downloading;
 } chunk_t;
 
 typedef struct segment_run_s
 {
     uint32_t first_segment;
     uint32_t fragments_per_segment;
+    uint64_t first_fragment; /* number of the first fragment of the run */
 } segment_run_t;
 
 typedef struct fragment_run_s
@@ -71,7 +72,6 @@ typedef struct hds_stream_s
     /* linked-list of chunks */
     chunk_t        *chunks_head;
     chunk_t        *chunks_livereadpos;
-    chunk_t        *chunks_downloadpos;
 
     char*          quality_segment_modifier;
 
@@ -90,6 +90,7 @@ typedef struct hds_stream_s
 
     vlc_mutex_t    abst_lock;
 
+    /* protects the list of chunks */
     vlc_mutex_t    dl_lock;
     vlc_cond_t     dl_cond;
 
@@ -108,6 +109,7 @@ typedef struct hds_stream_s
     char*          server_entries[MAX_HDS_SERVERS];
     uint8_t        server_entry_count;
 
+    /* the runs are sorted, as required by the specification */
 #define MAX_HDS_SEGMENT_RUNS 256
     segment_run_t  segment_runs[MAX_HDS_SEGMENT_RUNS];
     uint8_t        segment_run_count;
@@ -122,11 +124,15 @@ typedef struct hds_stream_s
 
 #define BITRATE_AS_BYTES_PER_SECOND 1024/8
 
+/* fragments downloaded in parallel, the origins have a high latency */
+#define HDS_DOWNLOAD_THREADS 4
+
 typedef struct
 {
     char         *base_url;    /* URL common part for chunks */
     vlc_thread_t live_thread;
-    vlc_thread_t dl_thread;
+    vlc_thread_t dl_threads[HDS_DOWNLOAD_THREADS];
+    unsigned     dl_thread_count;
 
     /* we pend on peek until some number of segments arrives; otherwise
      * the downstream system dies in case of playback */
@@ -655,6 +661,18 @@ static void parse_BootstrapData( vlc_object_t* p_this,
            data_end > data_p &&
            (data_p = parse_asrt( p_this, s, data_p, data_end )) );
 
+    /* the fragments are numbered from 1 across all the segments */
+    uint64_t first_fragment = 1;
+    for( unsigned i = 0; i < s->segment_run_count; i++ )
+    {
+        s->segment_runs[i].first_fragment = first_fragment;
+        if( i + 1 < s->segment_run_count )
+            first_fragment +=
+                (uint64_t)( s->segment_runs[i+1].first_segment -
+                            s->segment_runs[i].first_segment ) *
+                s->segment_runs[i].fragments_per_segment;
+    }
+
     if( ! data_p )
     {
         msg_Warn( p_this, "Couldn't find afrt data" );
@@ -753,11 +771,12 @@ static uint32_t find_chunk_mdat( vlc_object_t* p_this,
     return chunkdata_end - ((uint8_t*)boxdata);
 }
 
-/* returns data ptr if valid (updating the chunk itself
-   tells the reader that the chunk is safe to read, which is not yet correct)*/
+/* returns data ptr if valid, the chunk is only updated by the caller
+   as the reader may be looking at it */
 static uint8_t* download_chunk( stream_t *s,
                                 stream_sys_t* sys,
-                                hds_stream_t* stream, chunk_t* chunk )
+                                hds_stream_t* stream, const chunk_t* chunk,
+                                uint32_t* data_len )
 {
     const char* quality = "";
     char* server_base = sys->base_url;
@@ -803,17 +822,16 @@ static uint8_t* download_chunk( stream_t *s,
     {
         msg_Err(s, "Failed to download fragment %s", fragment_url );
         free( fragment_url );
-        chunk->failed = true;
         return NULL;
     }
     free( fragment_url );
 
     int64_t size = stream_Size( download_stream );
-    chunk->data_len = (uint32_t) size;
 
     if( size > MAX_REQUEST_SIZE )
     {
         msg_Err(s, "Strangely-large chunk of %"PRIi64" Bytes", size );
+        vlc_stream_Delete( download_stream );
         return NULL;
     }
 
@@ -821,31 +839,25 @@ static uint8_t* download_chunk( stream_t *s,
     if( ! data )
     {
         msg_Err(s, "Couldn't allocate chunk" );
+        vlc_stream_Delete( download_stream );
         return NULL;
     }
 
     int read = vlc_stream_Read( download_stream, data,
                             size );
+    vlc_stream_Delete( download_stream );
     if( read < 0 )
         read = 0;
-    chunk->data_len = read;
 
     if( read < size )
     {
         msg_Err( s, "Requested %"PRIi64" bytes, "\
                  "but only got %d", size, read );
-        data = realloc( chunk->data, read );
-        if( data != NULL )
-            chunk->data = data;
-        chunk->failed = true;
+        free( data );
         return NULL;
     }
-    else
-    {
-        chunk->failed = false;
-    }
 
-    vlc_stream_Delete( download_stream );
+    *data_len = read;
     return data;
 }
 
@@ -867,46 +879,48 @@ static void* download_thread( void* p )
 
     while( ! sys->closed )
     {
-        if( ! hds_stream->chunks_downloadpos )
-        {
-            chunk_t* chunk = hds_stream->chunks_head;
-            while(chunk && chunk->data )
-            {
-                chunk = chunk->next;
-            }
+        /* the next chunk no other thread is downloading */
+        chunk_t* chunk = hds_stream->chunks_head;
+        while( chunk && ( chunk->data || chunk->downloading ) )
+            chunk = chunk->next;
 
-            if( chunk && ! chunk->data )
-                hds_stream->chunks_downloadpos = chunk;
+        if( ! chunk )
+        {
+            vlc_cond_wait( & hds_stream->dl_cond,
+                           & hds_stream->dl_lock );
+            continue;
         }
 
-        while( hds_stream->chunks_downloadpos )
+        chunk->downloading = true;
+        vlc_mutex_unlock( & hds_stream->dl_lock );
+
+        /* the chunk stays in the list: the readers only drop the chunks
+         * they have read */
+        uint32_t data_len = 0;
+        uint8_t *data = download_chunk( s, sys, hds_stream, chunk,
+                                        & data_len );
+        uint8_t *mdat_data = NULL;
+        uint32_t mdat_len = 0;
+        if( data )
         {
-            chunk_t *chunk = hds_stream->chunks_downloadpos;
-
-            uint8_t *data = download_chunk( (stream_t*)p_this,
-                                            sys,
-                                            hds_stream,
-                                            chunk );
+            mdat_len = find_chunk_mdat( p_this, data, data + data_len,
+                                        & mdat_data );
+            if( mdat_len == 0 )
+                mdat_len = data_len - (mdat_data - data);
+        }
 
-            if( ! chunk->failed )
-            {
-                chunk->mdat_len =
-                    find_chunk_mdat( p_this,
-                                     data,
-                                     data + chunk->data_len,
-                                     & chunk->mdat_data );
-                if( chunk->mdat_len == 0 ) {
-                    chunk->mdat_len = chunk->data_len - (chunk->mdat_data - data);
-                }
-                hds_stream->chunks_downloadpos = chunk->next;
-                chunk->data = data;
+        vlc_mutex_lock( & hds_stream->dl_lock );
+        chunk->downloading = false;
+        chunk->failed = data == NULL;
+        if( data )
+        {
+            chunk->data_len = data_len;
+            chunk->mdat_data = mdat_data;
+            chunk->mdat_len = mdat_len;
+            chunk->data = data;
 
-                sys->chunk_count++;
-            }
+            sys->chunk_count++;
         }
-
-        vlc_cond_wait( & hds_stream->dl_cond,
-                       & hds_stream->dl_lock );
     }
 
     vlc_mutex_unlock( & hds_stream->dl_lock );
@@ -915,6 +929,48 @@ static void* download_thread( void* p )
     return NULL;
 }
 
+/* number of fragment runs starting at or before the fragment */
+static uint32_t count_fragment_runs( const hds_stream_t* hds_stream,
+                                     uint32_t frag_num )
+{
+    uint32_t lo = 0, hi = hds_stream->fragment_run_count;
+
+    while( lo < hi )
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if( hds_stream->fragment_runs[mid].fragment_number_start <= frag_num )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* number of the segment holding the fragment */
+static uint32_t find_segment( const hds_stream_t* hds_stream,
+                              uint32_t frag_num )
+{
+    unsigned lo = 0, hi = hds_stream->segment_run_count;
+
+    if( hi == 0 )
+        return 0;
+
+    while( lo < hi )
+    {
+        unsigned mid = (lo + hi) / 2;
+        if( hds_stream->segment_runs[mid].first_fragment <= frag_num )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    const segment_run_t* srun = hds_stream->segment_runs + (lo ? lo - 1 : 0);
+    if( srun->fragments_per_segment == 0 || frag_num < srun->first_fragment )
+        return srun->first_segment;
+    return srun->first_segment +
+        (frag_num - srun->first_fragment) / srun->fragments_per_segment;
+}
+
 static chunk_t* generate_new_chunk(
     vlc_object_t* p_this,
     chunk_t* last_chunk,
@@ -935,10 +991,11 @@ static chunk_t* generate_new_chunk(
         chunk->timestamp = last_chunk->timestamp + last_chunk->duration;
         chunk->frag_num = last_chunk->frag_num + 1;
 
-        if( ! sys->live )
-        {
-            frun_entry = last_chunk->frun_entry;
-        }
+        /* start from the run of the fragment, the bootstrap of a live
+         * stream grows at each update */
+        uint32_t runs = count_fragment_runs( hds_stream, chunk->frag_num );
+        if( runs > 0 )
+            frun_entry = runs - 1;
     }
     else
     {
@@ -1009,29 +1066,7 @@ static chunk_t* generate_new_chunk(
         return NULL;
     }
 
-    int srun_entry = 0;
-    unsigned int segment = 0;
-    uint64_t fragments_accum = chunk->frag_num;
-    for( srun_entry = 0; srun_entry < hds_stream->segment_run_count;
-         srun_entry++ )
-    {
-        segment = hds_stream->segment_runs[srun_entry].first_segment +
-            (chunk->frag_num - fragments_accum ) / hds_stream->segment_runs[srun_entry].fragments_per_segment;
-
-        if( srun_entry + 1 == hds_stream->segment_run_count ||
-            hds_stream->segment_runs[srun_entry+1].first_segment > segment )
-        {
-            break;
-        }
-
-        fragments_accum += (
-            (hds_stream->segment_runs[srun_entry+1].first_segment -
-             hds_stream->segment_runs[srun_entry].first_segment) *
-            hds_stream->segment_runs[srun_entry].fragments_per_segment );
-    }
-
-    chunk->seg_num = segment;
-    chunk->frun_entry = frun_entry;
+    chunk->seg_num = find_segment( hds_stream, chunk->frag_num );
 
     if( ! sys->live )
     {
@@ -1079,7 +1114,7 @@ static void maintain_live_chunks(
     }
 
     if( dl )
-        vlc_cond_signal( & hds_stream->dl_cond );
+        vlc_cond_broadcast( & hds_stream->dl_cond );
 
     chunk = hds_stream->chunks_head;
     while( chunk && chunk->data && chunk->mdat_pos >= chunk->mdat_len && chunk->next )
@@ -1159,7 +1194,9 @@ static void* live_thread( void* p )
                 parse_BootstrapData( p_this, hds_stream,
                                      data, data + read );
                 vlc_mutex_unlock( & hds_stream->abst_lock );
+                vlc_mutex_lock( & hds_stream->dl_lock );
                 maintain_live_chunks( p_this, hds_stream );
+                vlc_mutex_unlock( & hds_stream->dl_lock );
             }
 
             free( data );
@@ -1636,6 +1673,25 @@ static void SysCleanup( stream_sys_t *p_sys )
     free( p_sys->base_url );
 }
 
+static void StopDownloads( stream_sys_t *p_sys )
+{
+    // TODO: Change here for selectable stream
+    hds_stream_t *stream = vlc_array_count(&p_sys->hds_streams) ?
+        p_sys->hds_streams.pp_elems[0] : NULL;
+
+    if (stream)
+        vlc_mutex_lock( & stream->dl_lock );
+    p_sys->closed = true;
+    if (stream)
+    {
+        vlc_cond_broadcast( & stream->dl_cond );
+        vlc_mutex_unlock( & stream->dl_lock );
+    }
+
+    for( unsigned i = 0; i < p_sys->dl_thread_count; i++ )
+        vlc_join( p_sys->dl_threads[i], NULL );
+}
+
 static int Open( vlc_object_t *p_this )
 {
     stream_t *s = (stream_t*)p_this;
@@ -1684,7 +1740,12 @@ static int Open( vlc_object_t *p_this )
     s->pf_seek = NULL;
     s->pf_control = Control;
 
-    if( vlc_clone( &p_sys->dl_thread, download_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
+    while( p_sys->dl_thread_count < HDS_DOWNLOAD_THREADS &&
+           !vlc_clone( &p_sys->dl_threads[p_sys->dl_thread_count],
+                       download_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
+        p_sys->dl_thread_count++;
+
+    if( p_sys->dl_thread_count == 0 )
     {
         goto error;
     }
@@ -1694,6 +1755,7 @@ static int Open( vlc_object_t *p_this )
 
         if( vlc_clone( &p_sys->live_thread, live_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
         {
+            StopDownloads( p_sys );
             goto error;
         }
     }
@@ -1711,15 +1773,7 @@ static void Close( vlc_object_t *p_this )
     stream_t *s = (stream_t*)p_this;
     stream_sys_t *p_sys = s->p_sys;
 
-    // TODO: Change here for selectable stream
-    hds_stream_t *stream = vlc_array_count(&p_sys->hds_streams) ?
-        p_sys->hds_streams.pp_elems[0] : NULL;
-
-    p_sys->closed = true;
-    if (stream)
-        vlc_cond_signal( & stream->dl_cond );
-
-    vlc_join( p_sys->dl_thread, NULL );
+    StopDownloads( p_sys );
 
     if( p_sys->live )
     {
@@ -1839,7 +1893,7 @@ static unsigned read_chunk_data(
         }
 
         if( dl )
-            vlc_cond_signal( & stream->dl_cond );
+            vlc_cond_broadcast( & stream->dl_cond );
     }
 
     return ( ((uint8_t*)buffer) - ((uint8_t*)buffer_start));
@@ -1865,7 +1919,10 @@ static ssize_t Read( stream_t *s, void *buffer, size_t i_read )
     if ( header_unfinished( p_sys ) )
         return send_flv_header( stream, p_sys, buffer, i_read );
 
-    return read_chunk_data( (vlc_object_t*)s, buffer, i_read, stream );
+    vlc_mutex_lock( & stream->dl_lock );
+    ssize_t val = read_chunk_data( (vlc_object_t*)s, buffer, i_read, stream );
+    vlc_mutex_unlock( & stream->dl_lock );
+    return val;
 }
 
 static int Control( stream_t *s, int i_query, va_list args )
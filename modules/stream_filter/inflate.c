@@ -22,6 +22,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <zlib.h>
@@ -29,69 +30,182 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_stream.h>
+#include <vlc_interrupt.h>
+
+/* Decompressed data produced ahead of the reader */
+#define INFLATE_OUTPUT_SIZE (1 << 18)
 
 typedef struct
 {
+    /* Thread data */
     z_stream zstream;
+    bool gzip;
+    bool member_end;
+    unsigned members;
+    unsigned char input[16384];
+
+    /* Shared data */
+    vlc_mutex_t lock;
+    vlc_cond_t wait_data;
+    vlc_cond_t wait_space;
     bool eof;
-    unsigned char buffer[16384];
+    bool error;
+    bool paused;
+    bool closing;
+    size_t start;
+    size_t length;
+    unsigned char output[INFLATE_OUTPUT_SIZE];
+
+    /* Serializes the accesses to the source stream */
+    vlc_mutex_t source_lock;
+
+    vlc_thread_t thread;
+    vlc_interrupt_t *interrupt;
 } stream_sys_t;
 
-static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
+/**
+ * Decompresses some data.
+ * @return byte count, 0 at the end of the data, -1 on error.
+ */
+static ssize_t Inflate(stream_t *stream, unsigned char *buf, size_t buflen)
 {
     stream_sys_t *sys = stream->p_sys;
-    ssize_t val;
-
-    if (sys->eof || unlikely(buflen == 0))
-        return 0;
 
     sys->zstream.next_out = buf;
     sys->zstream.avail_out = buflen;
 
-    if (sys->zstream.avail_in == 0)
-        sys->zstream.next_in = sys->buffer;
+    while (sys->zstream.avail_out == buflen)
+    {
+        if (sys->zstream.avail_in == 0)
+        {
+            vlc_mutex_lock(&sys->source_lock);
+            ssize_t val = vlc_stream_Read(stream->s, sys->input,
+                                          sizeof (sys->input));
+            vlc_mutex_unlock(&sys->source_lock);
 
-    val = (sys->buffer + sizeof (sys->buffer))
-        - (sys->zstream.next_in + sys->zstream.avail_in);
+            if (val <= 0)
+            {
+                if (sys->member_end)
+                    msg_Dbg(stream, "end of stream");
+                else
+                    msg_Err(stream, "unexpected end of stream");
+                return 0;
+            }
+            sys->zstream.next_in = sys->input;
+            sys->zstream.avail_in = val;
+        }
 
-    if (val > 0)
-    {   /* Fill input buffer if there is space left */
-        val = vlc_stream_Read(stream->s,
-                          sys->zstream.next_in + sys->zstream.avail_in, val);
-        if (val >= 0)
-            sys->zstream.avail_in += val;
+        if (sys->member_end)
+        {   /* gzip files may be made of several concatenated members */
+            if (!sys->gzip || sys->zstream.next_in[0] != 0x1F)
+                return 0;
+            inflateReset(&sys->zstream);
+            sys->member_end = false;
+        }
+
+        int val = inflate(&sys->zstream, Z_SYNC_FLUSH);
+        switch (val)
+        {
+            case Z_STREAM_END:
+                sys->member_end = true;
+                sys->members++;
+                /* fall through */
+            case Z_OK:
+            case Z_BUF_ERROR: /* more input needed */
+                break;
+            case Z_DATA_ERROR:
+                if (sys->members > 0 && sys->zstream.total_out == 0)
+                {
+                    msg_Warn(stream, "trailing garbage ignored");
+                    return 0;
+                }
+                msg_Err(stream, "corrupt stream");
+                return -1;
+            default:
+                msg_Err(stream, "unhandled decompression error (%d)", val);
+                return -1;
+        }
     }
 
-    if (sys->zstream.avail_in == 0)
+    return buflen - sys->zstream.avail_out;
+}
+
+/**
+ * Decompresses ahead of the reader, into the circular output buffer.
+ */
+static void *Thread(void *data)
+{
+    stream_t *stream = data;
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_interrupt_set(sys->interrupt);
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
     {
-        msg_Err(stream, "unexpected end of stream");
-        return 0;
+        while (!sys->closing
+            && (sys->paused || sys->length == INFLATE_OUTPUT_SIZE))
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+        if (sys->closing)
+            break;
+
+        /* The reader only touches the data, the free space is ours */
+        size_t offset = (sys->start + sys->length) % INFLATE_OUTPUT_SIZE;
+        size_t space = __MIN(INFLATE_OUTPUT_SIZE - sys->length,
+                             INFLATE_OUTPUT_SIZE - offset);
+        vlc_mutex_unlock(&sys->lock);
+
+        ssize_t val = Inflate(stream, sys->output + offset, space);
+
+        vlc_mutex_lock(&sys->lock);
+        if (val <= 0)
+        {
+            sys->eof = true;
+            sys->error = val < 0;
+            vlc_cond_signal(&sys->wait_data);
+            break;
+        }
+        sys->length += val;
+        vlc_cond_signal(&sys->wait_data);
     }
+    vlc_mutex_unlock(&sys->lock);
+    return NULL;
+}
 
-    val = inflate(&sys->zstream, Z_SYNC_FLUSH);
-    switch (val)
+static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+    size_t copy;
+
+    if (unlikely(buflen == 0))
+        return 0;
+
+    vlc_mutex_lock(&sys->lock);
+    while (sys->length == 0 && !sys->eof)
     {
-        case Z_STREAM_END:
-            msg_Dbg(stream, "end of stream");
-            sys->eof = true;
-            /* fall through */
-        case Z_OK:
-            return buflen - sys->zstream.avail_out;
-        case Z_DATA_ERROR:
-            msg_Err(stream, "corrupt stream");
-            sys->eof = true;
-            return -1;
-        case Z_BUF_ERROR:
-            if (sys->zstream.next_in == sys->buffer)
-                break;
+        void *data[2];
 
-            memmove(sys->buffer, sys->zstream.next_in, sys->zstream.avail_in);
-            sys->zstream.next_in = sys->buffer;
-            return Read(stream, buf, buflen);
+        vlc_interrupt_forward_start(sys->interrupt, data);
+        vlc_cond_wait(&sys->wait_data, &sys->lock);
+        vlc_interrupt_forward_stop(data);
     }
 
-    msg_Err(stream, "unhandled decompression error (%zd)", val);
-    return -1;
+    if (sys->length == 0)
+    {
+        vlc_mutex_unlock(&sys->lock);
+        return sys->error ? -1 : 0;
+    }
+
+    copy = __MIN(buflen, sys->length);
+    /* Do not step past the edge of the circular buffer */
+    copy = __MIN(copy, INFLATE_OUTPUT_SIZE - sys->start);
+
+    memcpy(buf, sys->output + sys->start, copy);
+    sys->start = (sys->start + copy) % INFLATE_OUTPUT_SIZE;
+    sys->length -= copy;
+    vlc_cond_signal(&sys->wait_space);
+    vlc_mutex_unlock(&sys->lock);
+    return copy;
 }
 
 static int Seek(stream_t *stream, uint64_t offset)
@@ -102,20 +216,39 @@ static int Seek(stream_t *stream, uint64_t offset)
 
 static int Control(stream_t *stream, int query, va_list args)
 {
+    stream_sys_t *sys = stream->p_sys;
+    int ret;
+
     switch (query)
     {
         case STREAM_CAN_SEEK:
         case STREAM_CAN_FASTSEEK:
             *va_arg(args, bool *) = false;
             break;
+        case STREAM_SET_PAUSE_STATE:
+        {
+            bool paused = va_arg(args, unsigned);
+
+            vlc_mutex_lock(&sys->lock);
+            sys->paused = paused;
+            vlc_cond_signal(&sys->wait_space);
+            vlc_mutex_unlock(&sys->lock);
+
+            vlc_mutex_lock(&sys->source_lock);
+            vlc_stream_Control(stream->s, STREAM_SET_PAUSE_STATE, paused);
+            vlc_mutex_unlock(&sys->source_lock);
+            break;
+        }
         case STREAM_CAN_PAUSE:
         case STREAM_CAN_CONTROL_PACE:
         case STREAM_GET_PTS_DELAY:
         case STREAM_GET_META:
         case STREAM_GET_CONTENT_TYPE:
         case STREAM_GET_SIGNAL:
-        case STREAM_SET_PAUSE_STATE:
-            return vlc_stream_vaControl(stream->s, query, args);
+            vlc_mutex_lock(&sys->source_lock);
+            ret = vlc_stream_vaControl(stream->s, query, args);
+            vlc_mutex_unlock(&sys->source_lock);
+            return ret;
         case STREAM_GET_SIZE:
         case STREAM_GET_TITLE_INFO:
         case STREAM_GET_TITLE:
@@ -155,12 +288,20 @@ static int Open(vlc_object_t *obj)
     if (unlikely(sys == NULL))
         return VLC_ENOMEM;
 
-    sys->zstream.next_in = sys->buffer;
+    sys->zstream.next_in = sys->input;
     sys->zstream.avail_in = 0;
     sys->zstream.zalloc = Z_NULL;
     sys->zstream.zfree = Z_NULL;
     sys->zstream.opaque = Z_NULL;
+    sys->gzip = bits > 15;
+    sys->member_end = false;
+    sys->members = 0;
     sys->eof = false;
+    sys->error = false;
+    sys->paused = false;
+    sys->closing = false;
+    sys->start = 0;
+    sys->length = 0;
 
     int ret = inflateInit2(&sys->zstream, bits);
     if (ret != Z_OK)
@@ -169,7 +310,28 @@ static int Open(vlc_object_t *obj)
         return (ret == Z_MEM_ERROR) ? VLC_ENOMEM : VLC_EGENERIC;
     }
 
+    sys->interrupt = vlc_interrupt_create();
+    if (unlikely(sys->interrupt == NULL))
+    {
+        inflateEnd(&sys->zstream);
+        free(sys);
+        return VLC_ENOMEM;
+    }
+
+    vlc_mutex_init(&sys->lock);
+    vlc_mutex_init(&sys->source_lock);
+    vlc_cond_init(&sys->wait_data);
+    vlc_cond_init(&sys->wait_space);
     stream->p_sys = sys;
+
+    if (vlc_clone(&sys->thread, Thread, stream, VLC_THREAD_PRIORITY_INPUT))
+    {
+        vlc_interrupt_destroy(sys->interrupt);
+        inflateEnd(&sys->zstream);
+        free(sys);
+        return VLC_ENOMEM;
+    }
+
     stream->pf_read = Read;
     stream->pf_seek = Seek;
     stream->pf_control = Control;
@@ -181,6 +343,14 @@ static void Close (vlc_object_t *obj)
     stream_t *stream = (stream_t *)obj;
     stream_sys_t *sys = stream->p_sys;
 
+    vlc_mutex_lock(&sys->lock);
+    sys->closing = true;
+    vlc_cond_signal(&sys->wait_space);
+    vlc_mutex_unlock(&sys->lock);
+    vlc_interrupt_kill(sys->interrupt);
+    vlc_join(sys->thread, NULL);
+    vlc_interrupt_destroy(sys->interrupt);
+
     inflateEnd(&sys->zstream);
     free(sys);
 }
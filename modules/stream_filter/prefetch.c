@@ -35,6 +35,25 @@
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
 
+/* Upstream reads are kept short enough to not delay seeks */
+#define PREFETCH_READ_MIN      (16 << 10)
+#define PREFETCH_READ_MAX      (1 << 20)
+#define PREFETCH_READ_DURATION VLC_TICK_FROM_MS(100)
+/* Data read ahead once the consumption rate is known */
+#define PREFETCH_HORIZON       20 /* seconds */
+#define PREFETCH_AHEAD_MIN     (1 << 20)
+/* Recently read ranges kept across seeks */
+#define PREFETCH_RANGES        4
+#define PREFETCH_RANGE_SIZE    (1 << 20)
+
+struct stream_range
+{
+    uint64_t offset;
+    size_t   length;
+    unsigned last_use;
+    char    *data;
+};
+
 struct stream_ctrl
 {
     struct stream_ctrl *next;
@@ -74,6 +93,19 @@ typedef struct
     size_t       buffer_size;
     char        *buffer;
     size_t       seek_threshold;
+    uint64_t     seek_origin; /* read offset before the last seek */
+
+    /* measured rates, in bytes per second, 0 if unknown */
+    uint64_t     read_rate;
+    uint64_t     read_bytes;
+    vlc_tick_t   read_time;
+    uint64_t     consume_rate;
+    uint64_t     consumed;
+    vlc_tick_t   consume_start;
+
+    struct stream_range ranges[PREFETCH_RANGES];
+    unsigned     range_uses;
+    bool         tail_pending;
 
     struct stream_ctrl *controls;
 } stream_sys_t;
@@ -86,10 +118,28 @@ static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
     vlc_mutex_unlock(&sys->lock);
     assert(length > 0);
 
+    vlc_tick_t start = vlc_tick_now();
     ssize_t val = vlc_stream_ReadPartial(stream->s, buf, length);
+    vlc_tick_t duration = vlc_tick_now() - start;
 
     vlc_mutex_lock(&sys->lock);
     vlc_restorecancel(canc);
+
+    /* Measure the throughput over the time spent reading */
+    if (val > 0)
+    {
+        sys->read_bytes += val;
+        sys->read_time += duration;
+        if (sys->read_time >= VLC_TICK_FROM_MS(500))
+        {
+            uint64_t rate = sys->read_bytes * CLOCK_FREQ / sys->read_time;
+
+            sys->read_rate = sys->read_rate ? (3 * sys->read_rate + rate) / 4
+                                            : rate;
+            sys->read_bytes = 0;
+            sys->read_time = 0;
+        }
+    }
     return val;
 }
 
@@ -129,6 +179,213 @@ static int ThreadControl(stream_t *stream, int query, ...)
     return ret;
 }
 
+/**
+ * Copies data out of the circular buffer.
+ */
+static void BufferCopy(const stream_sys_t *sys, char *buf, uint64_t offset,
+                       size_t length)
+{
+    assert(offset >= sys->buffer_offset);
+    assert(offset + length <= sys->buffer_offset + sys->buffer_length);
+
+    while (length > 0)
+    {
+        size_t pos = offset % sys->buffer_size;
+        size_t copy = __MIN(length, sys->buffer_size - pos);
+
+        memcpy(buf, sys->buffer + pos, copy);
+        buf += copy;
+        offset += copy;
+        length -= copy;
+    }
+}
+
+static void RangeDrop(struct stream_range *range)
+{
+    free(range->data);
+    range->data = NULL;
+    range->length = 0;
+}
+
+/**
+ * Gets a free slot for a new range, dropping ranges it would overlap.
+ */
+static struct stream_range *RangeNew(stream_sys_t *sys, uint64_t offset,
+                                     size_t length)
+{
+    struct stream_range *lru = NULL;
+
+    for (unsigned i = 0; i < PREFETCH_RANGES; i++)
+    {
+        struct stream_range *range = &sys->ranges[i];
+
+        if (range->data != NULL && range->offset < offset + length
+         && offset < range->offset + range->length)
+            RangeDrop(range);
+        if (lru == NULL || (lru->data != NULL
+         && (range->data == NULL || range->last_use < lru->last_use)))
+            lru = range;
+    }
+
+    RangeDrop(lru);
+    lru->data = malloc(length);
+    if (unlikely(lru->data == NULL))
+        return NULL;
+    lru->offset = offset;
+    lru->length = length;
+    lru->last_use = ++sys->range_uses;
+    return lru;
+}
+
+/**
+ * Keeps the buffered data around the last read position, before the
+ * buffer is discarded for a seek.
+ */
+static void RangeSave(stream_sys_t *sys)
+{
+    uint64_t start = sys->buffer_offset;
+    uint64_t end = sys->buffer_offset + sys->buffer_length;
+
+    if (sys->seek_origin > start + PREFETCH_RANGE_SIZE / 2)
+        start = sys->seek_origin - PREFETCH_RANGE_SIZE / 2;
+    if (end > start + PREFETCH_RANGE_SIZE)
+        end = start + PREFETCH_RANGE_SIZE;
+    if (start >= end)
+        return;
+
+    struct stream_range *range = RangeNew(sys, start, end - start);
+    if (range != NULL)
+        BufferCopy(sys, range->data, start, end - start);
+}
+
+static struct stream_range *RangeFind(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < PREFETCH_RANGES; i++)
+    {
+        struct stream_range *range = &sys->ranges[i];
+
+        if (range->data != NULL && range->offset <= offset
+         && offset < range->offset + range->length)
+        {
+            range->last_use = ++sys->range_uses;
+            return range;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Moves the buffer to a new offset, starting from a saved range if the
+ * offset was already read.
+ */
+static int ThreadSeekBuffer(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->buffer_length > 0)
+        RangeSave(sys);
+    if (sys->size != (uint64_t)-1 && offset + PREFETCH_RANGE_SIZE >= sys->size)
+        sys->tail_pending = false; /* the consumer reads it already */
+
+    struct stream_range *range = RangeFind(sys, offset);
+    uint64_t upstream = offset;
+
+    sys->buffer_offset = offset;
+    sys->buffer_length = 0;
+    if (range != NULL)
+    {
+        size_t length = range->offset + range->length - offset;
+
+        if (length > sys->buffer_size)
+            length = sys->buffer_size;
+        for (size_t done = 0; done < length;)
+        {
+            size_t pos = (offset + done) % sys->buffer_size;
+            size_t copy = __MIN(length - done, sys->buffer_size - pos);
+
+            memcpy(sys->buffer + pos,
+                   range->data + (offset + done - range->offset), copy);
+            done += copy;
+        }
+        sys->buffer_length = length;
+        upstream += length;
+        vlc_cond_signal(&sys->wait_data);
+    }
+
+    if (upstream == sys->size)
+    {   /* the range reaches the end of the stream */
+        sys->eof = true;
+        return 0;
+    }
+    sys->eof = false;
+    return ThreadSeek(stream, upstream);
+}
+
+/**
+ * Reads the end of the stream ahead, where many file formats store
+ * their index. This is done once, while the buffer is full enough.
+ */
+static int ThreadReadTail(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint64_t resume = sys->buffer_offset + sys->buffer_length;
+    uint64_t offset = sys->size - PREFETCH_RANGE_SIZE;
+
+    sys->tail_pending = false;
+    if (resume >= offset)
+        return 0;
+
+    struct stream_range *range = RangeNew(sys, offset, PREFETCH_RANGE_SIZE);
+    if (range == NULL)
+        return 0;
+
+    msg_Dbg(stream, "reading the stream tail (offset %"PRIu64")", offset);
+    if (ThreadSeek(stream, offset))
+        range->length = 0;
+
+    size_t length = 0;
+    while (length < range->length)
+    {
+        ssize_t val = ThreadRead(stream, range->data + length,
+                                 range->length - length);
+        if (val <= 0)
+            break;
+        length += val;
+    }
+
+    if (length == 0)
+        RangeDrop(range);
+    else
+        range->length = length;
+
+    return ThreadSeek(stream, resume);
+}
+
+/**
+ * Returns how much data to read ahead of the consumer.
+ */
+static size_t ReadAheadTarget(const stream_sys_t *sys)
+{
+    /* Without enough margin over the consumption, fill the buffer */
+    if (sys->consume_rate == 0
+     || sys->read_rate < sys->consume_rate + sys->consume_rate / 4)
+        return sys->buffer_size;
+
+    uint64_t target = sys->consume_rate * PREFETCH_HORIZON;
+    if (target < PREFETCH_AHEAD_MIN)
+        target = PREFETCH_AHEAD_MIN;
+    return __MIN(target, sys->buffer_size);
+}
+
+static size_t ReadSize(const stream_sys_t *sys)
+{
+    if (sys->read_rate == 0)
+        return PREFETCH_READ_MAX;
+
+    uint64_t size = sys->read_rate * PREFETCH_READ_DURATION / CLOCK_FREQ;
+    return __MAX(PREFETCH_READ_MIN, __MIN(size, PREFETCH_READ_MAX));
+}
+
 static void *Thread(void *data)
 {
     stream_t *stream = data;
@@ -170,13 +427,8 @@ static void *Thread(void *data)
 
         if (stream_offset < sys->buffer_offset)
         {   /* Need to seek backward */
-            if (ThreadSeek(stream, stream_offset) == 0)
-            {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
+            if (ThreadSeekBuffer(stream, stream_offset) == 0)
                 assert(!sys->error);
-                sys->eof = false;
-            }
             else
             {
                 sys->error = true;
@@ -206,13 +458,8 @@ static void *Thread(void *data)
         if (sys->can_seek
          && history >= (sys->buffer_length + sys->seek_threshold))
         {
-            if (ThreadSeek(stream, stream_offset) == 0)
-            {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
+            if (ThreadSeekBuffer(stream, stream_offset) == 0)
                 assert(!sys->error);
-                assert(!sys->eof);
-            }
             else
             {   /* Seek failure is not necessarily fatal here. We could read
                  * data instead until the desired seek offset. But in practice,
@@ -227,6 +474,22 @@ static void *Thread(void *data)
 
         assert(sys->buffer_size >= sys->buffer_length);
 
+        if (history < sys->buffer_length
+         && sys->buffer_length - history >= ReadAheadTarget(sys))
+        {   /* Enough data ahead */
+            if (sys->tail_pending)
+            {
+                if (ThreadReadTail(stream))
+                {
+                    sys->error = true;
+                    vlc_cond_signal(&sys->wait_data);
+                }
+                continue;
+            }
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            continue;
+        }
+
         size_t len = sys->buffer_size - sys->buffer_length;
         if (len == 0)
         {   /* Buffer is full */
@@ -248,6 +511,8 @@ static void *Thread(void *data)
          /* Do not step past the sharp edge of the circular buffer */
         if (offset + len > sys->buffer_size)
             len = sys->buffer_size - offset;
+        if (len > ReadSize(sys))
+            len = ReadSize(sys);
 
         ssize_t val = ThreadRead(stream, sys->buffer + offset, len);
         if (val < 0)
@@ -276,6 +541,7 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    sys->seek_origin = sys->stream_offset;
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -340,6 +606,19 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 
     memcpy(buf, sys->buffer + offset, copy);
     sys->stream_offset += copy;
+
+    /* Measure the consumption rate over periods of a few seconds */
+    vlc_tick_t now = vlc_tick_now();
+    sys->consumed += copy;
+    if (now - sys->consume_start >= VLC_TICK_FROM_SEC(4))
+    {
+        uint64_t rate = sys->consumed * CLOCK_FREQ / (now - sys->consume_start);
+
+        sys->consume_rate = sys->consume_rate ? (sys->consume_rate + rate) / 2
+                                              : rate;
+        sys->consumed = 0;
+        sys->consume_start = now;
+    }
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -469,6 +748,16 @@ static int Open(vlc_object_t *obj)
     sys->buffer_length = 0;
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->seek_origin = 0;
+    sys->read_rate = 0;
+    sys->read_bytes = 0;
+    sys->read_time = 0;
+    sys->consume_rate = 0;
+    sys->consumed = 0;
+    sys->consume_start = vlc_tick_now();
+    for (unsigned i = 0; i < PREFETCH_RANGES; i++)
+        sys->ranges[i].data = NULL;
+    sys->range_uses = 0;
     sys->controls = NULL;
 
     uint64_t size = stream_Size(stream->s);
@@ -482,6 +771,11 @@ static int Open(vlc_object_t *obj)
     if (sys->buffer == NULL)
         goto error;
 
+    /* Only worth it if the whole stream does not fit in the buffer */
+    sys->tail_pending = sys->can_seek && size > sys->buffer_size
+                     && size > 4 * PREFETCH_RANGE_SIZE
+                     && var_InheritBool(obj, "prefetch-tail");
+
     sys->interrupt = vlc_interrupt_create();
     if (unlikely(sys->interrupt == NULL))
         goto error;
@@ -531,6 +825,8 @@ static void Close (vlc_object_t *obj)
         sys->controls = ctrl->next;
         free(ctrl);
     }
+    for (unsigned i = 0; i < PREFETCH_RANGES; i++)
+        free(sys->ranges[i].data);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -551,4 +847,7 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_bool("prefetch-tail", true, N_("Read the stream end ahead"),
+             N_("Read the end of seekable streams in advance, as it often "
+                "contains the index of the file."), true)
 vlc_module_end()
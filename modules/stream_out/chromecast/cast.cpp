@@ -39,6 +39,7 @@
 #include <vlc_modules.h>
 #include <vlc_httpd.h>
 
+#include <algorithm>
 #include <cassert>
 
 #define TRANSCODING_NONE 0x0
@@ -64,6 +65,7 @@ struct sout_access_out_sys_t
     void fifo_put_back(block_t *);
     ssize_t write(sout_access_out_t *p_access, block_t *p_block);
     void close();
+    size_t takeDropped();
 
 
 private:
@@ -80,6 +82,7 @@ private:
     block_t           *m_copy_chain;
     block_t           **m_copy_last;
     size_t             m_copy_size;
+    size_t             m_dropped;
     bool               m_eof;
     std::string        m_mime;
 };
@@ -105,6 +108,9 @@ struct sout_stream_sys_t
         , perf_warning_shown( false )
         , transcoding_state( TRANSCODING_NONE )
         , venc_opt_idx ( -1 )
+        , venc_cache_codec( 0 )
+        , venc_cache_quality( -1 )
+        , quality_penalty( 0 )
         , out_streams_added( 0 )
     {
         assert(p_intf != NULL);
@@ -151,6 +157,14 @@ struct sout_stream_sys_t
     bool                               perf_warning_shown;
     int                                transcoding_state;
     int                                venc_opt_idx;
+    /* Last selected video encoder options, reused across seeks as long as
+     * the source format and the quality don't change */
+    std::string                        venc_cache;
+    vlc_fourcc_t                       venc_cache_codec;
+    video_format_t                     venc_cache_fmt;
+    int                                venc_cache_quality;
+    /* Conversion quality steps lost because the receiver couldn't keep up */
+    int                                quality_penalty;
     std::vector<sout_stream_id_sys_t*> streams;
     std::vector<sout_stream_id_sys_t*> out_streams;
     unsigned int                       out_streams_added;
@@ -158,6 +172,8 @@ struct sout_stream_sys_t
 
 private:
     std::string GetAcodecOption( sout_stream_t *, vlc_fourcc_t *, const audio_format_t *, int );
+    std::string GetVcodecOption( sout_stream_t *, vlc_fourcc_t *, const video_format_t *, int );
+    int GetConversionQuality( sout_stream_t * );
     bool UpdateOutput( sout_stream_t * );
 };
 
@@ -343,6 +359,7 @@ sout_access_out_sys_t::sout_access_out_sys_t(httpd_host_t *httpd_host,
     , m_client(NULL)
     , m_header(NULL)
     , m_copy_chain(NULL)
+    , m_dropped(0)
     , m_eof(true)
 {
     m_fifo = block_FifoNew();
@@ -586,6 +603,7 @@ ssize_t sout_access_out_sys_t::write(sout_access_out_t *p_access, block_t *p_blo
             {
                 block_t *p_drop = vlc_fifo_DequeueUnlocked(m_fifo);
                 msg_Warn(p_access, "httpd buffer full: dropping %zuB", p_drop->i_buffer);
+                m_dropped += p_drop->i_buffer;
                 block_Release(p_drop);
             }
         }
@@ -600,6 +618,15 @@ ssize_t sout_access_out_sys_t::write(sout_access_out_t *p_access, block_t *p_blo
     return i_len;
 }
 
+size_t sout_access_out_sys_t::takeDropped()
+{
+    vlc_fifo_Lock(m_fifo);
+    size_t i_dropped = m_dropped;
+    m_dropped = 0;
+    vlc_fifo_Unlock(m_fifo);
+    return i_dropped;
+}
+
 void sout_access_out_sys_t::close()
 {
     vlc_fifo_Lock(m_fifo);
@@ -928,6 +955,54 @@ sout_stream_sys_t::GetAcodecOption( sout_stream_t *p_stream, vlc_fourcc_t *p_cod
     return ssout.str();
 }
 
+std::string
+sout_stream_sys_t::GetVcodecOption( sout_stream_t *p_stream, vlc_fourcc_t *p_codec_video,
+                                    const video_format_t *p_vid, int i_quality )
+{
+    /* Probing the encoders means creating and destroying a test chain per
+     * candidate: do it once and reuse the result when the chain is only
+     * restarted (seek, EOF reset) for the same source. */
+    if ( !venc_cache.empty() && venc_cache_quality == i_quality
+      && venc_cache_fmt.i_width == p_vid->i_width
+      && venc_cache_fmt.i_height == p_vid->i_height
+      && venc_cache_fmt.i_frame_rate == p_vid->i_frame_rate
+      && venc_cache_fmt.i_frame_rate_base == p_vid->i_frame_rate_base )
+    {
+        msg_Dbg( p_stream, "Converting video to %.4s (cached)",
+                 (const char*)&venc_cache_codec );
+        *p_codec_video = venc_cache_codec;
+        return venc_cache;
+    }
+
+    venc_cache = vlc_sout_renderer_GetVcodecOption( p_stream,
+                                { VLC_CODEC_H264, VLC_CODEC_VP8 },
+                                p_codec_video, p_vid, i_quality );
+    venc_cache_codec = *p_codec_video;
+    venc_cache_fmt = *p_vid;
+    venc_cache_quality = i_quality;
+    return venc_cache;
+}
+
+int sout_stream_sys_t::GetConversionQuality( sout_stream_t *p_stream )
+{
+    int i_quality = var_InheritInteger( p_stream, SOUT_CFG_PREFIX "conversion-quality" );
+
+    /* The httpd fifo only overflows when the receiver reads slower than we
+     * produce: the link can't sustain the current bitrate, so lower it for
+     * the next chain. LOWCPU trades bitrate for speed, don't step into it. */
+    if ( access_out_live.takeDropped() > 0 && ( transcoding_state & TRANSCODING_VIDEO )
+      && i_quality + quality_penalty < CONVERSION_QUALITY_LOW )
+    {
+        quality_penalty++;
+        msg_Warn( p_stream, "receiver can't keep up, lowering conversion quality" );
+    }
+
+    if ( i_quality < CONVERSION_QUALITY_LOW )
+        i_quality = std::min( i_quality + quality_penalty,
+                              (int) CONVERSION_QUALITY_LOW );
+    return i_quality;
+}
+
 bool sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
 {
     assert( p_stream->p_sys == this );
@@ -1036,7 +1111,7 @@ bool sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
                 config_PutInt(RENDERER_CFG_PREFIX "show-perf-warning", 0 );
         }
 
-        const int i_quality = var_InheritInteger( p_stream, SOUT_CFG_PREFIX "conversion-quality" );
+        const int i_quality = GetConversionQuality( p_stream );
 
         /* TODO: provide audio samplerate and channels */
         ssout << "transcode{";
@@ -1049,10 +1124,8 @@ bool sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
         if ( i_codec_video == 0 && p_original_video )
         {
             try {
-                ssout << vlc_sout_renderer_GetVcodecOption( p_stream,
-                                        { VLC_CODEC_H264, VLC_CODEC_VP8 },
-                                        &i_codec_video,
-                                        &p_original_video->video, i_quality );
+                ssout << GetVcodecOption( p_stream, &i_codec_video,
+                                          &p_original_video->video, i_quality );
                 new_transcoding_state |= TRANSCODING_VIDEO;
             } catch(const std::exception& e) {
                 return false;
@@ -137,6 +137,12 @@
     "Default caching value for outbound RTP streams. This " \
     "value should be set in milliseconds." )
 
+#define PACING_TEXT N_("Pacing rate (kb/s)")
+#define PACING_LONGTEXT N_( \
+    "Spreads the packets sent to every destination so that they never " \
+    "exceed this rate by more than a few packets, instead of sending the " \
+    "packets of a whole frame back to back. 0 disables pacing." )
+
 #define PROTO_TEXT N_("Transport protocol")
 #define PROTO_LONGTEXT N_( \
     "This selects which transport protocol to use for RTP." )
@@ -227,6 +233,8 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", MS_FROM_VLC_TICK(DEFAULT_PTS_DELAY),
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "pacing", 0,
+                 PACING_TEXT, PACING_LONGTEXT, true )
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
@@ -247,7 +255,7 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
     "mux", "sap", "description", "url", "email",
-    "proto", "rtcp-mux", "caching",
+    "proto", "rtcp-mux", "caching", "pacing",
 #ifdef HAVE_SRTP
     "key", "salt",
 #endif
@@ -318,6 +326,15 @@ typedef struct
     sout_stream_id_sys_t **es;
 } sout_stream_sys_t;
 
+/* Most packets sent to a destination in one system call */
+#define RTP_BATCH_MAX 32
+/* Pacing bucket depth, in packets */
+#define RTP_PACING_BURST 4
+/* Room after the payload for the SRTP authentication tag */
+#define RTP_PACKET_TRAILER 10
+
+typedef struct rtp_packet_pool_t rtp_packet_pool_t;
+
 typedef struct rtp_sink_t
 {
     int rtp_fd;
@@ -361,8 +378,125 @@ struct sout_stream_id_sys_t
 
     block_fifo_t     *p_fifo;
     vlc_tick_t        i_caching;
+    uint64_t          i_pacing; /* bytes per second, 0 if unpaced */
+    rtp_packet_pool_t *pool;
 };
 
+/*****************************************************************************
+ * Packet pool: recycles MTU-sized packet buffers between the packetizers
+ * and the sending thread.
+ *****************************************************************************/
+struct rtp_packet_pool_t
+{
+    vlc_mutex_t lock;
+    block_t    *p_free;
+    size_t      i_size;   /* buffer size of every pooled packet */
+    unsigned    i_used;   /* packets out of the pool */
+    bool        b_closed;
+};
+
+typedef struct
+{
+    block_t            self;
+    rtp_packet_pool_t *p_pool;
+} rtp_packet_t;
+
+static void rtp_packet_pool_Release( block_t *p_block )
+{
+    rtp_packet_t *p_packet = container_of( p_block, rtp_packet_t, self );
+    rtp_packet_pool_t *p_pool = p_packet->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->i_used--;
+    bool b_destroy = p_pool->b_closed && p_pool->i_used == 0;
+    if( p_pool->b_closed )
+        free( p_packet );
+    else
+    {
+        p_block->p_next = p_pool->p_free;
+        p_pool->p_free = p_block;
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( b_destroy )
+        free( p_pool );
+}
+
+static const struct vlc_block_callbacks rtp_packet_cbs =
+{
+    rtp_packet_pool_Release,
+};
+
+static rtp_packet_pool_t *rtp_packet_pool_New( size_t i_size )
+{
+    rtp_packet_pool_t *p_pool = malloc( sizeof(*p_pool) );
+    if( unlikely(p_pool == NULL) )
+        return NULL;
+    vlc_mutex_init( &p_pool->lock );
+    p_pool->p_free = NULL;
+    p_pool->i_size = i_size;
+    p_pool->i_used = 0;
+    p_pool->b_closed = false;
+    return p_pool;
+}
+
+static void rtp_packet_pool_Close( rtp_packet_pool_t *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    block_t *p_free = p_pool->p_free;
+    p_pool->p_free = NULL;
+    p_pool->b_closed = true;
+    bool b_destroy = p_pool->i_used == 0;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    while( p_free != NULL )
+    {
+        block_t *p_next = p_free->p_next;
+        free( container_of( p_free, rtp_packet_t, self ) );
+        p_free = p_next;
+    }
+    if( b_destroy )
+        free( p_pool );
+}
+
+/**
+ * Allocates a packet of the given size, RTP header included, from the
+ * packet pool of the ES.
+ */
+block_t *rtp_packet_alloc( sout_stream_id_sys_t *id, size_t size )
+{
+    rtp_packet_pool_t *p_pool = id->pool;
+    rtp_packet_t *p_packet = NULL;
+
+    if( size > p_pool->i_size )
+        return block_Alloc( size );
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( p_pool->p_free != NULL )
+    {
+        block_t *p_block = p_pool->p_free;
+        p_pool->p_free = p_block->p_next;
+        p_packet = container_of( p_block, rtp_packet_t, self );
+    }
+    else
+    {
+        p_packet = malloc( sizeof(*p_packet) + p_pool->i_size );
+        if( unlikely(p_packet == NULL) )
+        {
+            vlc_mutex_unlock( &p_pool->lock );
+            return NULL;
+        }
+        p_packet->p_pool = p_pool;
+    }
+    p_pool->i_used++;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    block_t *p_block = block_Init( &p_packet->self, &rtp_packet_cbs,
+                                   p_packet + 1, p_pool->i_size );
+    p_block->i_buffer = size;
+    return p_block;
+}
+
 /*****************************************************************************
  * Open:
  *****************************************************************************/
@@ -917,6 +1051,14 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->b_first_packet = true;
     id->i_caching =
         VLC_TICK_FROM_MS(var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching"));
+    id->i_pacing =
+        var_GetInteger( p_stream, SOUT_CFG_PREFIX "pacing" ) * UINT64_C(1000) / 8;
+    id->pool = rtp_packet_pool_New( id->i_mtu + RTP_PACKET_TRAILER );
+    if( unlikely(id->pool == NULL) )
+    {
+        free( id );
+        return NULL;
+    }
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1146,6 +1288,8 @@ static void Del( sout_stream_t *p_stream, void *_id )
         vlc_join( id->thread, NULL );
         block_FifoRelease( id->p_fifo );
     }
+    if( likely(id->pool != NULL) )
+        rtp_packet_pool_Close( id->pool );
 
     free( id->rtp_fmt.fmtp );
 
@@ -1302,95 +1446,222 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Handles a failed send, returns false if the connection is broken */
+static bool rtp_sink_error( int fd, const block_t *out )
+{
+    switch( net_errno )
+    {
+        case EAGAIN:
+#if (EWOULDBLOCK != EAGAIN)
+        case EWOULDBLOCK:
+#endif
+        case ENOBUFS:
+        case ENOMEM:
+            return true;
+    }
+
+    int type;
+    getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &(socklen_t){ sizeof(type) });
+    if( type != SOCK_DGRAM )
+        return false; /* Broken connection */
+
+    /* ICMP soft error: ignore and retry */
+    send( fd, out->p_buffer, out->i_buffer, 0 );
+    return true;
+}
+
+/* Sends a batch of packets to one destination */
+static bool rtp_sink_send( int fd, block_t *const *pkts, unsigned n )
+{
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[RTP_BATCH_MAX];
+    struct iovec iov[RTP_BATCH_MAX];
+
+    assert( n <= RTP_BATCH_MAX );
+    for( unsigned i = 0; i < n; i++ )
+    {
+        iov[i].iov_base = pkts[i]->p_buffer;
+        iov[i].iov_len = pkts[i]->i_buffer;
+        memset( &msgs[i], 0, sizeof(msgs[i]) );
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for( unsigned i = 0; i < n; )
+    {
+        int val = sendmmsg( fd, &msgs[i], n - i, 0 );
+        if( val > 0 )
+        {
+            i += val;
+            continue;
+        }
+        if( val < 0 && errno == EINTR )
+            continue;
+        /* skip the failing packet, as a single send() would */
+        if( !rtp_sink_error( fd, pkts[i] ) )
+            return false;
+        i++;
+    }
+#else
+    for( unsigned i = 0; i < n; i++ )
+        if( send( fd, pkts[i]->p_buffer, pkts[i]->i_buffer, 0 ) == -1
+         && !rtp_sink_error( fd, pkts[i] ) )
+            return false;
+#endif
+    return true;
+}
+
+static void rtp_send_packets( sout_stream_id_sys_t *id,
+                              block_t *const *pkts, unsigned n )
+{
+    vlc_mutex_lock( &id->lock_sink );
+    unsigned deadc = 0; /* How many dead sockets? */
+    int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
+
+    for( int i = 0; i < id->sinkc; i++ )
+    {
+#ifdef HAVE_SRTP
+        if( !id->srtp ) /* FIXME: SRTCP support */
+#endif
+            for( unsigned j = 0; j < n; j++ )
+                SendRTCP( id->sinkv[i].rtcp, pkts[j] );
+
+        if( !rtp_sink_send( id->sinkv[i].rtp_fd, pkts, n ) )
+            deadv[deadc++] = id->sinkv[i].rtp_fd;
+    }
+    id->i_seq_sent_next = ntohs(((uint16_t *) pkts[n - 1]->p_buffer)[1]) + 1;
+    vlc_mutex_unlock( &id->lock_sink );
+
+    for( unsigned i = 0; i < deadc; i++ )
+    {
+        msg_Dbg( id->p_stream, "removing socket %d", deadv[i] );
+        rtp_del_sink( id, deadv[i] );
+    }
+}
+
+#ifdef HAVE_SRTP
+static block_t *rtp_srtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{
+    /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + RTP_PACKET_TRAILER );
+    if( unlikely(out == NULL) )
+        return NULL;
+    out->i_buffer = len;
+
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + RTP_PACKET_TRAILER );
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     vlc_tick_t i_caching = id->i_caching;
+    block_t *pending = NULL; /* next packet, not due yet */
+
+    /* Token bucket, in bytes */
+    const uint64_t rate = id->i_pacing;
+    const uint64_t burst = (uint64_t)RTP_PACING_BURST * id->i_mtu;
+    uint64_t tokens = burst;
+    vlc_tick_t refill = vlc_tick_now();
 
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
+        block_t *pkts[RTP_BATCH_MAX];
+        unsigned n = 0;
+
+        block_t *out = pending;
+        pending = NULL;
+        if( out == NULL )
+            out = block_FifoGet( id->p_fifo );
         block_cleanup_push (out);
+        vlc_tick_wait (out->i_dts + i_caching);
+        vlc_cleanup_pop ();
+
+        int canc = vlc_savecancel ();
+        pkts[n++] = out;
+
+        /* Send the packets that are due by now along */
+        vlc_tick_t now = vlc_tick_now();
+        vlc_fifo_Lock( id->p_fifo );
+        while( n < RTP_BATCH_MAX && !vlc_fifo_IsEmpty( id->p_fifo ) )
+        {
+            out = vlc_fifo_DequeueUnlocked( id->p_fifo );
+            if( out->i_dts + i_caching > now )
+            {
+                pending = out;
+                break;
+            }
+            pkts[n++] = out;
+        }
+        vlc_fifo_Unlock( id->p_fifo );
 
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
+        {
+            unsigned kept = 0;
+            for( unsigned i = 0; i < n; i++ )
             {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
+                out = rtp_srtp_protect( id, pkts[i] );
+                if( out != NULL )
+                    pkts[kept++] = out;
             }
-            else
-                out->i_buffer = len;
+            n = kept;
         }
-        if (out)
-            vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
 #endif
 
-        ssize_t len = out->i_buffer;
-        int canc = vlc_savecancel ();
-
-        vlc_mutex_lock( &id->lock_sink );
-        unsigned deadc = 0; /* How many dead sockets? */
-        int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
-
-        for( int i = 0; i < id->sinkc; i++ )
+        for( unsigned i = 0; i < n; )
         {
-#ifdef HAVE_SRTP
-            if( !id->srtp ) /* FIXME: SRTCP support */
-#endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+            unsigned j = n;
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
+            if( rate )
             {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
+                for( ;; )
+                {
+                    now = vlc_tick_now();
+                    tokens += (now - refill) * rate / CLOCK_FREQ;
+                    if( tokens > burst )
+                        tokens = burst;
+                    refill = now;
+                    if( tokens >= pkts[i]->i_buffer )
+                        break;
+                    vlc_tick_wait( now + vlc_tick_from_samples(
+                                   pkts[i]->i_buffer - tokens, rate ) + 1 );
+                }
+
+                tokens -= pkts[i]->i_buffer;
+                for( j = i + 1; j < n && tokens >= pkts[j]->i_buffer; j++ )
+                    tokens -= pkts[j]->i_buffer;
             }
-        }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
-        vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
 
-        for( unsigned i = 0; i < deadc; i++ )
-        {
-            msg_Dbg( id->p_stream, "removing socket %d", deadv[i] );
-            rtp_del_sink( id, deadv[i] );
+            rtp_send_packets( id, &pkts[i], j - i );
+            i = j;
         }
+
+        for( unsigned i = 0; i < n; i++ )
+            block_Release( pkts[i] );
         vlc_restorecancel (canc);
     }
     return NULL;
 }
 
 
+
 /* This thread dequeues incoming connections (DCCP streaming) */
 static void *rtp_listen_thread( void *data )
 {
@@ -1632,7 +1903,7 @@ static ssize_t AccessOutGrabberWriteBuffer( sout_stream_t *p_stream,
         if( p_sys->packet == NULL )
         {
             /* allocate a new packet */
-            p_sys->packet = block_Alloc( id->i_mtu );
+            p_sys->packet = rtp_packet_alloc( id, id->i_mtu );
             /* m-bit is discontinuity for MPEG1/2 PS and TS, RFC2250 2.1 */
             rtp_packetize_common( id, p_sys->packet, b_dis, i_dts );
             p_sys->packet->i_buffer = 12;
@@ -718,7 +718,7 @@ int rtp_packetize_xiph_config( sout_stream_id_sys_t *id, const char *fmtp,
     for( int i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 18 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 18 + i_payload );
 
         unsigned fragtype, numpkts;
         if (i_count == 1)
@@ -772,7 +772,7 @@ static int rtp_packetize_xiph( sout_stream_id_sys_t *id, block_t *in )
     for( int i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 18 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 18 + i_payload );
 
         unsigned fragtype, numpkts;
         if (i_count == 1)
@@ -828,7 +828,7 @@ static int rtp_packetize_mpa( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 16 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 16 + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, (i == i_count - 1)?1:0, in->i_pts );
@@ -906,7 +906,7 @@ static int rtp_packetize_mpv( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 16 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 16 + i_payload );
         /* MBZ:5 T:1 TR:10 AN:1 N:1 S:1 B:1 E:1 P:3 FBV:1 BFC:3 FFV:1 FFC:3 */
         uint32_t      h = ( i_temporal_ref << 16 )|
                           ( b_sequence_start << 13 )|
@@ -948,7 +948,7 @@ static int rtp_packetize_ac3( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 14 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 14 + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, (i == i_count - 1)?1:0, in->i_pts );
@@ -997,7 +997,7 @@ static int rtp_packetize_split( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 12 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 12 + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, (i == i_count - 1),
@@ -1026,7 +1026,7 @@ static int rtp_packetize_pcm(sout_stream_id_sys_t *id, block_t *in)
         unsigned duration = (in->i_length * max) / in->i_buffer;
         bool marker = (in->i_flags & BLOCK_FLAG_DISCONTINUITY) != 0;
 
-        block_t *out = block_Alloc(12 + max);
+        block_t *out = rtp_packet_alloc(id, 12 + max);
         if (unlikely(out == NULL))
         {
             block_Release(in);
@@ -1058,7 +1058,7 @@ static int rtp_packetize_swab(sout_stream_id_sys_t *id, block_t *in)
         vlc_tick_t duration = (in->i_length * payload) / in->i_buffer;
         bool marker = (in->i_flags & BLOCK_FLAG_DISCONTINUITY) != 0;
 
-        block_t *out = block_Alloc(12 + payload);
+        block_t *out = rtp_packet_alloc(id, 12 + payload);
         if (unlikely(out == NULL))
         {
             block_Release(in);
@@ -1098,7 +1098,7 @@ static int rtp_packetize_mp4a_latm( sout_stream_id_sys_t *id, block_t *in )
 
         if( i != 0 )
             latmhdrsize = 0;
-        out = block_Alloc( 12 + latmhdrsize + i_payload );
+        out = rtp_packet_alloc( id, 12 + latmhdrsize + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, ((i == i_count - 1) ? 1 : 0),
@@ -1145,7 +1145,7 @@ static int rtp_packetize_mp4a( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 16 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 16 + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, ((i == i_count - 1)?1:0),
@@ -1207,7 +1207,7 @@ static int rtp_packetize_h263( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int      i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( RTP_H263_PAYLOAD_START + i_payload );
+        block_t *out = rtp_packet_alloc( id, RTP_H263_PAYLOAD_START + i_payload );
         b_p_bit = (i == 0) ? 1 : 0;
         h = ( b_p_bit << 10 )|
             ( b_v_bit << 9  )|
@@ -1256,7 +1256,7 @@ rtp_packetize_h264_nal( sout_stream_id_sys_t *id,
     if( i_data <= i_max )
     {
         /* Single NAL unit packet */
-        block_t *out = block_Alloc( 12 + i_data );
+        block_t *out = rtp_packet_alloc( id, 12 + i_data );
         out->i_dts    = i_dts;
         out->i_length = i_length;
 
@@ -1279,7 +1279,7 @@ rtp_packetize_h264_nal( sout_stream_id_sys_t *id,
         for( i = 0; i < i_count; i++ )
         {
             const int i_payload = __MIN( i_data, i_max-2 );
-            block_t *out = block_Alloc( 12 + 2 + i_payload );
+            block_t *out = rtp_packet_alloc( id, 12 + 2 + i_payload );
             out->i_dts    = i_dts + i * i_length / i_count;
             out->i_length = i_length / i_count;
 
@@ -1335,7 +1335,7 @@ rtp_packetize_h265_nal( sout_stream_id_sys_t *id,
     if( i_data <= i_max )
     {
         /* Single NAL unit packet */
-        block_t *out = block_Alloc( 12 + i_data );
+        block_t *out = rtp_packet_alloc( id, 12 + i_data );
         out->i_dts    = i_dts;
         out->i_length = i_length;
 
@@ -1360,7 +1360,7 @@ rtp_packetize_h265_nal( sout_stream_id_sys_t *id,
         for( size_t i = 0; i < i_count; i++ )
         {
             const size_t i_payload = __MIN( i_data, i_max-3 );
-            block_t *out = block_Alloc( 12 + 3 + i_payload );
+            block_t *out = rtp_packet_alloc( id, 12 + 3 + i_payload );
             out->i_dts    = i_dts + i * i_length / i_count;
             out->i_length = i_length / i_count;
 
@@ -1414,7 +1414,7 @@ static int rtp_packetize_amr( sout_stream_id_sys_t *id, block_t *in )
     for( i = 0; i < i_count; i++ )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 14 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 14 + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, ((i == i_count - 1)?1:0),
@@ -1467,7 +1467,7 @@ static int rtp_packetize_t140( sout_stream_id_sys_t *id, block_t *in )
             }
         }
 
-        block_t *out = block_Alloc( 12 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 12 + i_payload );
         if( out == NULL )
         {
             block_Release(in);
@@ -1524,7 +1524,7 @@ static int rtp_packetize_spx( sout_stream_id_sys_t *id, block_t *in )
       Allocate a new RTP p_output block of the appropriate size.
       Allow for 12 extra bytes of RTP header.
     */
-    p_out = block_Alloc( 12 + i_payload_size );
+    p_out = rtp_packet_alloc( id, 12 + i_payload_size );
 
     if ( i_payload_padding )
     {
@@ -1580,7 +1580,7 @@ static int rtp_packetize_g726( sout_stream_id_sys_t *id, block_t *in, int i_pad
     while( i_data > 0 )
     {
         int           i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( 12 + i_payload );
+        block_t *out = rtp_packet_alloc( id, 12 + i_payload );
 
         /* rtp common header */
         rtp_packetize_common( id, out, 0,
@@ -1641,7 +1641,7 @@ static int rtp_packetize_vp8( sout_stream_id_sys_t *id, block_t *in )
     for( int i = 0; i < i_count; i++ )
     {
         int i_payload = __MIN( i_max, i_data );
-        block_t *out = block_Alloc( RTP_VP8_PAYLOAD_START + i_payload );
+        block_t *out = rtp_packet_alloc( id, RTP_VP8_PAYLOAD_START + i_payload );
         if ( out == NULL )
         {
             block_Release(in);
@@ -1710,7 +1710,7 @@ static int rtp_packetize_rawvideo( sout_stream_id_sys_t *id, block_t *in, vlc_fo
             return VLC_EGENERIC;
         }
 
-        block_t *out = block_Alloc( RTP_HEADER_LEN + i_payload );
+        block_t *out = rtp_packet_alloc( id, RTP_HEADER_LEN + i_payload );
         if( unlikely( out == NULL ) )
         {
             block_Release( in );
@@ -1947,7 +1947,7 @@ static int rtp_packetize_jpeg( sout_stream_id_sys_t *id, block_t *in )
         if ( i_payload <= 0 )
             goto error;
 
-        block_t *out = block_Alloc( 12 + hdr_size + i_payload );
+        block_t *out = rtp_packet_alloc( id, 12 + hdr_size + i_payload );
         if( out == NULL )
         {
             block_Release( in );
@@ -92,20 +92,66 @@ unsigned AES3AudioBuffer::read(void *dstbuf, unsigned count, vlc_tick_t from,
     assert(count + dstpad <= orig);
 #endif
 
+    if(i_codec != VLC_CODEC_S16N)
+    {
+        assert(bytestream.i_block_offset == 0 || skip == 0);
+        assert(bytestream.p_block == NULL || bytestream.p_block->i_buffer < 4 ||
+               GetWBE(&bytestream.p_block->p_buffer[4]) == 0xf872);
+    }
+
+    if(dstbuf == NULL)
+        return 0;
+
+    const size_t srcstride = FramesToBytes(1);
+    const size_t dststride = sizeof(uint16_t) * 2 * dstbufframeswidth;
+    uint8_t *dst = reinterpret_cast<uint8_t *>(dstbuf) +
+                   dstpad * dststride + sizeof(uint16_t) * dstbufsubframeidx.index();
+
+    /* Single pass over the blocks, instead of looking up every sample
+     * from the first block, while the pushing thread waits */
     bytestream_mutex.lock();
-    uint8_t *dst = reinterpret_cast<uint8_t *>(dstbuf);
-    for(unsigned i=0; i<count; i++)
+    block_t *p_block = bytestream.p_block;
+    size_t srcoffset = bytestream.i_block_offset + FramesToBytes(skip) +
+                       sizeof(uint16_t) * srcchannelidx.index();
+    for(unsigned i=0; i<count; )
     {
-       size_t srcoffset = sizeof(uint16_t) * ((i + skip) * buffersubframes + srcchannelidx.index());
-       size_t dstoffset = sizeof(uint16_t) * ((i + dstpad) * 2 * dstbufframeswidth + dstbufsubframeidx.index());
-       if(i_codec != VLC_CODEC_S16N)
-       {
-           assert(bytestream.i_block_offset == 0 || skip == 0);
-           assert(bytestream.p_block->i_buffer < 4 ||
-                  GetWBE(&bytestream.p_block->p_buffer[4]) == 0xf872);
-       }
-       if(dst)
-            block_PeekOffsetBytes(&bytestream, srcoffset, &dst[dstoffset], sizeof(uint16_t));
+        while(p_block && srcoffset >= p_block->i_buffer)
+        {
+            srcoffset -= p_block->i_buffer;
+            p_block = p_block->p_next;
+        }
+        if(!p_block)
+            break;
+
+        if(srcoffset + sizeof(uint16_t) > p_block->i_buffer)
+        {
+            /* sample split across blocks */
+            uint8_t sample[sizeof(uint16_t)];
+            unsigned got = 0;
+            size_t off = srcoffset;
+            for(block_t *b = p_block; b && got < sizeof(sample); b = b->p_next, off = 0)
+                while(off < b->i_buffer && got < sizeof(sample))
+                    sample[got++] = b->p_buffer[off++];
+            if(got < sizeof(sample))
+                break;
+            memcpy(dst, sample, sizeof(sample));
+            dst += dststride;
+            srcoffset += srcstride;
+            i++;
+            continue;
+        }
+
+        unsigned n = (p_block->i_buffer - srcoffset - sizeof(uint16_t)) / srcstride + 1;
+        n = std::min(n, count - i);
+        const uint8_t *src = &p_block->p_buffer[srcoffset];
+        for(unsigned j=0; j<n; j++)
+        {
+            memcpy(dst, src, sizeof(uint16_t));
+            dst += dststride;
+            src += srcstride;
+        }
+        srcoffset += n * srcstride;
+        i += n;
     }
     bytestream_mutex.unlock();
 
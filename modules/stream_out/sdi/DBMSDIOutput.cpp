@@ -30,6 +30,7 @@
 
 #include "DBMHelper.hpp"
 #include "DBMSDIOutput.hpp"
+#include "DBMVideoFrame.hpp"
 #include "SDIStream.hpp"
 #include "SDIAudioMultiplex.hpp"
 #include "SDIGenerator.hpp"
@@ -50,6 +51,7 @@
 #define DECKLINK_CARD_BUFFER (CLOCK_FREQ)
 #define DECKLINK_PREROLL (CLOCK_FREQ*3/4)
 #define DECKLINK_SCHED_OFFSET (CLOCK_FREQ/20)
+#define DECKLINK_FRAME_POOL_SIZE 8
 
 static_assert(DECKLINK_CARD_BUFFER > DECKLINK_PREROLL + DECKLINK_SCHED_OFFSET, "not in card buffer limits");
 
@@ -65,6 +67,7 @@ DBMSDIOutput::DBMSDIOutput(sout_stream_t *p_stream) :
     lasttimestamp = 0;
     b_running = false;
     streamStartTime = VLC_TICK_INVALID;
+    framepool = NULL;
     vlc_mutex_init(&feeder.lock);
     vlc_cond_init(&feeder.cond);
 }
@@ -90,6 +93,9 @@ DBMSDIOutput::~DBMSDIOutput()
     }
     if(p_card)
         p_card->Release();
+    /* frames still held by the driver keep their pictures */
+    if(framepool)
+        picture_pool_Release(framepool);
 }
 
 AbstractStream *DBMSDIOutput::Add(const es_format_t *fmt)
@@ -715,40 +721,59 @@ int DBMSDIOutput::ProcessVideo(picture_t *picture, block_t *p_cc)
     return doProcessVideo(picture, p_cc);
 }
 
+picture_t *DBMSDIOutput::getFramePicture(long rowbytes, long h)
+{
+    /* Plain bytes buffers, of at least rowbytes per line */
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_GREY);
+    fmt.i_width = fmt.i_visible_width = rowbytes;
+    fmt.i_height = fmt.i_visible_height = h;
+
+    if(!framepool)
+    {
+        framepool = picture_pool_NewFromFormat(&fmt, DECKLINK_FRAME_POOL_SIZE);
+        if(!framepool)
+            return NULL;
+    }
+
+    /* The pool only runs out if the card buffers more frames */
+    picture_t *pic = picture_pool_Get(framepool);
+    if(!pic)
+        pic = picture_NewFromFormat(&fmt);
+    return pic;
+}
+
 int DBMSDIOutput::doProcessVideo(picture_t *picture, block_t *p_cc)
 {
     HRESULT result;
     int w, h, stride, length, ret = VLC_EGENERIC;
     BMDTimeValue scheduleTime;
-    IDeckLinkMutableVideoFrame *pDLVideoFrame = NULL;
+    DBMVideoFrame *pDLVideoFrame = NULL;
     w = video.configuredfmt.video.i_visible_width;
     h = video.configuredfmt.video.i_visible_height;
 
     if(FAKE_DRIVER)
         goto end;
 
-    result = p_output->CreateVideoFrame(w, h, w*3,
-                                        video.tenbits ? bmdFormat10BitYUV : bmdFormat8BitYUV,
-                                        bmdFrameFlagDefault, &pDLVideoFrame);
-    if(result != S_OK) {
-        msg_Err(p_stream, "Failed to create video frame: 0x%X", result);
-        goto error;
-    }
-
-    void *frame_bytes;
-    pDLVideoFrame->GetBytes((void**)&frame_bytes);
-    stride = pDLVideoFrame->GetRowBytes();
-
     if (video.tenbits)
     {
         IDeckLinkVideoFrameAncillary *vanc;
         void *buf;
 
+        picture_t *framepic = getFramePicture(((w + 47) / 48) * 128, h);
+        if(!framepic) {
+            msg_Err(p_stream, "Failed to create video frame");
+            goto error;
+        }
+        stride = framepic->p[0].i_pitch;
+        pDLVideoFrame = new DBMVideoFrame(framepic, w, h, stride, bmdFormat10BitYUV);
+
         result = p_output->CreateAncillaryData(bmdFormat10BitYUV, &vanc);
         if (result != S_OK) {
             msg_Err(p_stream, "Failed to create vanc: %d", result);
             goto error;
         }
+        pDLVideoFrame->setAncillaryData(vanc);
 
         result = vanc->GetBufferForVerticalBlankingLine(ancillary.afd_line, &buf);
         if (result != S_OK) {
@@ -770,23 +795,16 @@ int DBMSDIOutput::doProcessVideo(picture_t *picture, block_t *p_cc)
             captions.FillBuffer(reinterpret_cast<uint8_t*>(buf), stride);
         }
 
-        sdi::V210::Convert(picture, stride, frame_bytes);
-
-        result = pDLVideoFrame->SetAncillaryData(vanc);
-        vanc->Release();
-        if (result != S_OK) {
-            msg_Err(p_stream, "Failed to set vanc: %d", result);
-            goto error;
-        }
+        sdi::V210::Convert(picture, stride, framepic->p[0].p_pixels);
     }
-    else for(int y = 0; y < h; ++y) {
-        uint8_t *dst = (uint8_t *)frame_bytes + stride * y;
-        const uint8_t *src = (const uint8_t *)picture->p[0].p_pixels +
-                picture->p[0].i_pitch * y;
-        memcpy(dst, src, w * 2 /* bpp */);
+    else
+    {
+        /* UYVY pictures are in the card layout: output them directly,
+         * the card takes any row size */
+        pDLVideoFrame = new DBMVideoFrame(picture_Hold(picture), w, h,
+                                          picture->p[0].i_pitch, bmdFormat8BitYUV);
     }
 
-
     // compute frame duration in CLOCK_FREQ units
     length = (frameduration * CLOCK_FREQ) / timescale;
     picture->date -= clock.offset;
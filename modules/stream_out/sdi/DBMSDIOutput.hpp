@@ -24,6 +24,7 @@
 #include "SDIOutput.hpp"
 
 #include <vlc_es.h>
+#include <vlc_picture_pool.h>
 #include "../../access/vlc_decklink.h"
 
 namespace sdi_sout
@@ -78,6 +79,9 @@ namespace sdi_sout
             void feederThread();
             int doSchedule();
             int doProcessVideo(picture_t *, block_t *);
+            picture_t *getFramePicture(long, long);
+            /* pictures frames are converted into, in the card layout */
+            picture_pool_t *framepool;
             int FeedOneFrame();
             int FeedAudio(vlc_tick_t, vlc_tick_t, bool);
             void checkClockDrift();
@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * DBMVideoFrame.cpp: Decklink SDI video frame over a picture
+ *****************************************************************************
+ * Copyright © 2021 VideoLabs, VideoLAN and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DBMVideoFrame.hpp"
+
+using namespace sdi_sout;
+
+DBMVideoFrame::DBMVideoFrame(picture_t *pic, long w, long h,
+                             long rb, BMDPixelFormat fmt)
+    : refcount(1)
+{
+    picture = pic;
+    ancillary = NULL;
+    width = w;
+    height = h;
+    rowbytes = rb;
+    pixelformat = fmt;
+}
+
+DBMVideoFrame::~DBMVideoFrame()
+{
+    if(ancillary)
+        ancillary->Release();
+    picture_Release(picture);
+}
+
+void DBMVideoFrame::setAncillaryData(IDeckLinkVideoFrameAncillary *vanc)
+{
+    if(ancillary)
+        ancillary->Release();
+    ancillary = vanc;
+}
+
+HRESULT STDMETHODCALLTYPE DBMVideoFrame::QueryInterface(REFIID, LPVOID *)
+{
+    return E_NOINTERFACE;
+}
+
+ULONG STDMETHODCALLTYPE DBMVideoFrame::AddRef()
+{
+    return ++refcount;
+}
+
+ULONG STDMETHODCALLTYPE DBMVideoFrame::Release()
+{
+    ULONG count = --refcount;
+    if(count == 0)
+        delete this;
+    return count;
+}
+
+long STDMETHODCALLTYPE DBMVideoFrame::GetWidth()
+{
+    return width;
+}
+
+long STDMETHODCALLTYPE DBMVideoFrame::GetHeight()
+{
+    return height;
+}
+
+long STDMETHODCALLTYPE DBMVideoFrame::GetRowBytes()
+{
+    return rowbytes;
+}
+
+BMDPixelFormat STDMETHODCALLTYPE DBMVideoFrame::GetPixelFormat()
+{
+    return pixelformat;
+}
+
+BMDFrameFlags STDMETHODCALLTYPE DBMVideoFrame::GetFlags()
+{
+    return bmdFrameFlagDefault;
+}
+
+HRESULT STDMETHODCALLTYPE DBMVideoFrame::GetBytes(void **buffer)
+{
+    *buffer = picture->p[0].p_pixels;
+    return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE DBMVideoFrame::GetTimecode(BMDTimecodeFormat,
+                                                     IDeckLinkTimecode **timecode)
+{
+    *timecode = NULL;
+    return S_FALSE;
+}
+
+HRESULT STDMETHODCALLTYPE DBMVideoFrame::GetAncillaryData(IDeckLinkVideoFrameAncillary **vanc)
+{
+    if(!ancillary)
+    {
+        *vanc = NULL;
+        return S_FALSE;
+    }
+    ancillary->AddRef();
+    *vanc = ancillary;
+    return S_OK;
+}
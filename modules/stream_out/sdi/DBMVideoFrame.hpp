@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * DBMVideoFrame.hpp: Decklink SDI video frame over a picture
+ *****************************************************************************
+ * Copyright © 2021 VideoLabs, VideoLAN and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef DBMVIDEOFRAME_HPP
+#define DBMVIDEOFRAME_HPP
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "../../access/vlc_decklink.h"
+
+#include <atomic>
+
+namespace sdi_sout
+{
+    /* Video frame scheduled from the pixels of a picture, which it holds
+     * until the driver has output it: the picture is either the one to
+     * output, when its layout is the card's, or a pooled picture the
+     * output is converted into. */
+    class DBMVideoFrame : public IDeckLinkVideoFrame
+    {
+        public:
+            DBMVideoFrame(picture_t *, long, long, long, BMDPixelFormat);
+            void setAncillaryData(IDeckLinkVideoFrameAncillary *);
+
+            virtual HRESULT STDMETHODCALLTYPE QueryInterface (REFIID, LPVOID *);
+            virtual ULONG STDMETHODCALLTYPE AddRef ();
+            virtual ULONG STDMETHODCALLTYPE Release ();
+
+            virtual long STDMETHODCALLTYPE GetWidth ();
+            virtual long STDMETHODCALLTYPE GetHeight ();
+            virtual long STDMETHODCALLTYPE GetRowBytes ();
+            virtual BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat ();
+            virtual BMDFrameFlags STDMETHODCALLTYPE GetFlags ();
+            virtual HRESULT STDMETHODCALLTYPE GetBytes (void **);
+            virtual HRESULT STDMETHODCALLTYPE GetTimecode (BMDTimecodeFormat,
+                                                           IDeckLinkTimecode **);
+            virtual HRESULT STDMETHODCALLTYPE GetAncillaryData (IDeckLinkVideoFrameAncillary **);
+
+        private:
+            ~DBMVideoFrame();
+            std::atomic<ULONG> refcount;
+            picture_t *picture;
+            IDeckLinkVideoFrameAncillary *ancillary;
+            long width;
+            long height;
+            long rowbytes;
+            BMDPixelFormat pixelformat;
+    };
+}
+
+#endif // DBMVIDEOFRAME_HPP
@@ -24,8 +24,20 @@
 
 #include "V210.hpp"
 
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
 #include <vlc_picture.h>
 
+#ifdef HAVE_SSSE3_INTRINSICS
+# include <tmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
 using namespace sdi;
 
 static inline unsigned clip(unsigned a)
@@ -41,18 +53,155 @@ static inline void put_le32(uint8_t **p, uint32_t d)
     (*p) += 4;
 }
 
-void V210::Convert(const picture_t *pic, unsigned dst_stride, void *frame_bytes)
+/*
+ * The SIMD packers below write the same words as the C code, 6 pixels (16
+ * bytes) per 128-bit lane. The Y samples and the interleaved U and V samples
+ * are shuffled into the fields of the 4 words:
+ *   U0 Y0 V0 | Y1 U1 Y2 | V1 Y3 U2 | Y4 V2 Y5
+ * the 2 low fields as the 16-bit halves of each word, merged with a multiply
+ * add, the high field alone, shifted in place. They return the number of
+ * pixels packed, a multiple of 6, and leave the end of the line to the C code.
+ */
+#if defined(HAVE_SSSE3_INTRINSICS) || defined(HAVE_AVX2_INTRINSICS) || \
+    defined(CAN_COMPILE_ARM64)
+# define Z 0x80
+/* low fields: U0 Y0 | Y1 U1 | V1 Y3 | Y4 V2 */
+static const uint8_t shuf_lo_y[16]  = { Z,Z, 0,1, 2,3, Z,Z, Z,Z, 6,7, 8,9, Z,Z };
+static const uint8_t shuf_lo_uv[16] = { 0,1, Z,Z, Z,Z, 4,5, 6,7, Z,Z, Z,Z,10,11 };
+/* high fields: V0 Y2 U2 Y5 */
+static const uint8_t shuf_hi_y[16]  = { Z,Z, Z,Z, 4,5, Z,Z, Z,Z, Z,Z,10,11, Z,Z };
+static const uint8_t shuf_hi_uv[16] = { 2,3, Z,Z, Z,Z, Z,Z, 8,9, Z,Z, Z,Z, Z,Z };
+# undef Z
+#endif
+
+#ifdef HAVE_SSSE3_INTRINSICS
+/* clip() on unsigned 16-bit lanes, with SSE2 saturating arithmetic only */
+VLC_SSSE3
+static inline __m128i clip_ssse3(__m128i x)
 {
-    unsigned width = pic->format.i_width;
-    unsigned height = pic->format.i_height;
-    unsigned payload_size = ((width * 8 + 11) / 12) * 4;
-    unsigned line_padding = (payload_size < dst_stride) ? dst_stride - payload_size : 0;
-    unsigned h, w;
-    uint8_t *dst = (uint8_t*)frame_bytes;
+    x = _mm_sub_epi16(x, _mm_subs_epu16(x, _mm_set1_epi16(1019)));
+    return _mm_add_epi16(_mm_subs_epu16(x, _mm_set1_epi16(4)), _mm_set1_epi16(4));
+}
+
+VLC_SSSE3
+static unsigned PackLineSSSE3(const uint16_t *y, const uint16_t *u,
+                              const uint16_t *v, unsigned width, uint8_t *dst)
+{
+    const __m128i lo_y  = _mm_loadu_si128((const __m128i *)shuf_lo_y);
+    const __m128i lo_uv = _mm_loadu_si128((const __m128i *)shuf_lo_uv);
+    const __m128i hi_y  = _mm_loadu_si128((const __m128i *)shuf_hi_y);
+    const __m128i hi_uv = _mm_loadu_si128((const __m128i *)shuf_hi_uv);
+    const __m128i mul   = _mm_set1_epi32(1 | (1024 << 16));
+    unsigned w;
+
+    for (w = 0; w + 16 <= width; w += 6) {
+        const __m128i yv = clip_ssse3(_mm_loadu_si128((const __m128i *)&y[w]));
+        const __m128i uv = clip_ssse3(_mm_unpacklo_epi16(
+                _mm_loadu_si128((const __m128i *)&u[w / 2]),
+                _mm_loadu_si128((const __m128i *)&v[w / 2])));
+
+        const __m128i lo = _mm_or_si128(_mm_shuffle_epi8(yv, lo_y),
+                                        _mm_shuffle_epi8(uv, lo_uv));
+        const __m128i hi = _mm_or_si128(_mm_shuffle_epi8(yv, hi_y),
+                                        _mm_shuffle_epi8(uv, hi_uv));
+        _mm_storeu_si128((__m128i *)dst,
+                         _mm_or_si128(_mm_madd_epi16(lo, mul),
+                                      _mm_slli_epi32(hi, 20)));
+        dst += 16;
+    }
+    return w;
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* Two groups of 6 pixels, one per 128-bit lane */
+VLC_AVX2
+static inline __m256i load2_avx2(const uint16_t *p, unsigned offset)
+{
+    return _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+            _mm_loadu_si128((const __m128i *)&p[offset]), 1);
+}
+
+VLC_AVX2
+static unsigned PackLineAVX2(const uint16_t *y, const uint16_t *u,
+                             const uint16_t *v, unsigned width, uint8_t *dst)
+{
+    const __m256i lo_y  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shuf_lo_y));
+    const __m256i lo_uv = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shuf_lo_uv));
+    const __m256i hi_y  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shuf_hi_y));
+    const __m256i hi_uv = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shuf_hi_uv));
+    const __m256i mul   = _mm256_set1_epi32(1 | (1024 << 16));
+    const __m256i min   = _mm256_set1_epi16(4);
+    const __m256i max   = _mm256_set1_epi16(1019);
+    unsigned w;
+
+    for (w = 0; w + 22 <= width; w += 12) {
+        const __m256i yv = _mm256_min_epu16(_mm256_max_epu16(
+                load2_avx2(&y[w], 6), min), max);
+        const __m256i uv = _mm256_min_epu16(_mm256_max_epu16(
+                _mm256_unpacklo_epi16(load2_avx2(&u[w / 2], 3),
+                                      load2_avx2(&v[w / 2], 3)), min), max);
+
+        const __m256i lo = _mm256_or_si256(_mm256_shuffle_epi8(yv, lo_y),
+                                           _mm256_shuffle_epi8(uv, lo_uv));
+        const __m256i hi = _mm256_or_si256(_mm256_shuffle_epi8(yv, hi_y),
+                                           _mm256_shuffle_epi8(uv, hi_uv));
+        _mm256_storeu_si256((__m256i *)dst,
+                            _mm256_or_si256(_mm256_madd_epi16(lo, mul),
+                                            _mm256_slli_epi32(hi, 20)));
+        dst += 32;
+    }
+    return w;
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static unsigned PackLineNEON(const uint16_t *y, const uint16_t *u,
+                             const uint16_t *v, unsigned width, uint8_t *dst)
+{
+    const uint8x16_t lo_y  = vld1q_u8(shuf_lo_y);
+    const uint8x16_t lo_uv = vld1q_u8(shuf_lo_uv);
+    const uint8x16_t hi_y  = vld1q_u8(shuf_hi_y);
+    const uint8x16_t hi_uv = vld1q_u8(shuf_hi_uv);
+    const uint16x8_t min   = vdupq_n_u16(4);
+    const uint16x8_t max   = vdupq_n_u16(1019);
+    unsigned w;
+
+    for (w = 0; w + 16 <= width; w += 6) {
+        const uint16x8_t yv = vminq_u16(vmaxq_u16(vld1q_u16(&y[w]), min), max);
+        const uint16x8_t uv = vminq_u16(vmaxq_u16(
+                vzip1q_u16(vld1q_u16(&u[w / 2]), vld1q_u16(&v[w / 2])), min), max);
+
+        /* Out of range indices give zeroes, as with pshufb */
+        const uint32x4_t lo = vreinterpretq_u32_u8(vorrq_u8(
+                vqtbl1q_u8(vreinterpretq_u8_u16(yv), lo_y),
+                vqtbl1q_u8(vreinterpretq_u8_u16(uv), lo_uv)));
+        const uint32x4_t hi = vreinterpretq_u32_u8(vorrq_u8(
+                vqtbl1q_u8(vreinterpretq_u8_u16(yv), hi_y),
+                vqtbl1q_u8(vreinterpretq_u8_u16(uv), hi_uv)));
+        /* The fields are below 1024: the 10 low bits of the word are the
+         * first field, the second one moves from bit 16 to bit 10 */
+        const uint32x4_t out = vorrq_u32(
+                vbslq_u32(vdupq_n_u32(0x3ff), lo, vshrq_n_u32(lo, 6)),
+                vshlq_n_u32(hi, 20));
+        vst1q_u8(dst, vreinterpretq_u8_u32(out));
+        dst += 16;
+    }
+    return w;
+}
+#endif
 
-    const uint16_t *y = (const uint16_t*)pic->p[0].p_pixels;
-    const uint16_t *u = (const uint16_t*)pic->p[1].p_pixels;
-    const uint16_t *v = (const uint16_t*)pic->p[2].p_pixels;
+/* Packs the pixels of a line from w, a multiple of 6 */
+static void PackLineC(const uint16_t *y, const uint16_t *u, const uint16_t *v,
+                      unsigned w, unsigned width, uint8_t *dst)
+{
+    uint32_t val = 0;
+
+    y += w;
+    u += w / 2;
+    v += w / 2;
+    dst += w / 6 * 16;
 
 #define WRITE_PIXELS(a, b, c)           \
     do {                                \
@@ -62,39 +211,94 @@ void V210::Convert(const picture_t *pic, unsigned dst_stride, void *frame_bytes)
         put_le32(&dst, val);           \
     } while (0)
 
-    for (h = 0; h < height; h++) {
-        uint32_t val = 0;
-        for (w = 0; w + 5 < width; w += 6) {
-            WRITE_PIXELS(u, y, v);
-            WRITE_PIXELS(y, u, y);
-            WRITE_PIXELS(v, y, u);
-            WRITE_PIXELS(y, v, y);
-        }
-        if (w + 1 < width) {
-            WRITE_PIXELS(u, y, v);
-
-            val = clip(*y++);
-            if (w + 2 == width)
-                put_le32(&dst, val);
-#undef WRITE_PIXELS
-        }
-        if (w + 3 < width) {
-            val |= (clip(*u++) << 10) | (clip(*y++) << 20);
-            put_le32(&dst, val);
+    for (; w + 5 < width; w += 6) {
+        WRITE_PIXELS(u, y, v);
+        WRITE_PIXELS(y, u, y);
+        WRITE_PIXELS(v, y, u);
+        WRITE_PIXELS(y, v, y);
+    }
+    if (w + 1 < width) {
+        WRITE_PIXELS(u, y, v);
 
-            val = clip(*v++) | (clip(*y++) << 10);
+        val = clip(*y++);
+        if (w + 2 == width)
             put_le32(&dst, val);
-        }
+#undef WRITE_PIXELS
+    }
+    if (w + 3 < width) {
+        val |= (clip(*u++) << 10) | (clip(*y++) << 20);
+        put_le32(&dst, val);
 
-        memset(dst, 0, line_padding);
-        dst += line_padding;
+        val = clip(*v++) | (clip(*y++) << 10);
+        put_le32(&dst, val);
+    }
+}
+
+static void PackLine(const uint16_t *y, const uint16_t *u, const uint16_t *v,
+                     unsigned width, uint8_t *dst)
+{
+    unsigned w = 0;
+
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        w = PackLineAVX2(y, u, v, width, dst);
+#endif
+#ifdef HAVE_SSSE3_INTRINSICS
+    if (vlc_CPU_SSSE3())
+        w += PackLineSSSE3(&y[w], &u[w / 2], &v[w / 2], width - w,
+                           &dst[w / 6 * 16]);
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if (vlc_CPU_ARM_NEON())
+        w = PackLineNEON(y, u, v, width, dst);
+#endif
 
-        y += pic->p[0].i_pitch / 2 - width;
-        u += pic->p[1].i_pitch / 2 - width / 2;
-        v += pic->p[2].i_pitch / 2 - width / 2;
+    PackLineC(y, u, v, w, width, dst);
+}
+
+struct v210_job
+{
+    const picture_t *pic;
+    uint8_t *dst;
+    unsigned line_size;
+    unsigned line_padding;
+};
+
+static void ConvertSlice(filter_t *, void *data, unsigned slice, unsigned slices)
+{
+    const struct v210_job *job = static_cast<const struct v210_job *>(data);
+    const picture_t *pic = job->pic;
+    int first, end;
+
+    filter_GetSliceLines(pic->format.i_height, slice, slices, &first, &end);
+    for (int h = first; h < end; h++) {
+        uint8_t *dst = &job->dst[h * job->line_size];
+
+        PackLine((const uint16_t *)&pic->p[0].p_pixels[h * pic->p[0].i_pitch],
+                 (const uint16_t *)&pic->p[1].p_pixels[h * pic->p[1].i_pitch],
+                 (const uint16_t *)&pic->p[2].p_pixels[h * pic->p[2].i_pitch],
+                 pic->format.i_width, dst);
+        memset(&dst[job->line_size - job->line_padding], 0, job->line_padding);
     }
 }
 
+void V210::Convert(const picture_t *pic, unsigned dst_stride, void *frame_bytes)
+{
+    unsigned width = pic->format.i_width;
+    unsigned payload_size = ((width * 8 + 11) / 12) * 4;
+    unsigned line_padding = (payload_size < dst_stride) ? dst_stride - payload_size : 0;
+
+    struct v210_job job;
+    job.pic = pic;
+    job.dst = (uint8_t*)frame_bytes;
+    job.line_size = payload_size + line_padding;
+    job.line_padding = line_padding;
+
+    /* The lines are independent: pack them on the shared slice threads,
+     * which hand the (absent) filter back to the callback */
+    filter_RunSlices(NULL, pic->format.i_height, ConvertSlice, &job);
+}
+
 void V210::Convert(const uint16_t *src, size_t srccount, void *out)
 {
     uint8_t *dst = reinterpret_cast<uint8_t *>(out);
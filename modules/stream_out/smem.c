@@ -36,6 +36,12 @@
  *
  * the video-data and audio-data pointers will be passed to lock/unlock function
  *
+ * Instead of the prerender and postrender callbacks, a lend callback can be
+ * given: it receives a pointer to the data of the stream output, without any
+ * copy, along with a reference and the function to call with this reference
+ * once the data is not used anymore, possibly from another thread. All the
+ * references must be released before the stream output is destroyed.
+ *
  ******************************************************************************/
 
 /*****************************************************************************
@@ -73,6 +79,14 @@
 #define LT_AUDIO_POSTRENDER_CALLBACK N_( "Address of the audio postrender callback function. " \
                                         "This function will be called when the render is into the buffer." )
 
+#define T_VIDEO_LEND_CALLBACK N_( "Video lend callback" )
+#define LT_VIDEO_LEND_CALLBACK N_( "Address of the video lend callback function. " \
+                                   "This function will receive the video buffers without copy." )
+
+#define T_AUDIO_LEND_CALLBACK N_( "Audio lend callback" )
+#define LT_AUDIO_LEND_CALLBACK N_( "Address of the audio lend callback function. " \
+                                   "This function will receive the audio buffers without copy." )
+
 #define T_VIDEO_DATA N_( "Video Callback data" )
 #define LT_VIDEO_DATA N_( "Data for the video callback function." )
 
@@ -106,6 +120,10 @@ vlc_module_begin ()
         change_volatile()
     add_string( SOUT_PREFIX_AUDIO "postrender-callback", "0", T_AUDIO_POSTRENDER_CALLBACK, LT_AUDIO_POSTRENDER_CALLBACK, true )
         change_volatile()
+    add_string( SOUT_PREFIX_VIDEO "lend-callback", "0", T_VIDEO_LEND_CALLBACK, LT_VIDEO_LEND_CALLBACK, true )
+        change_volatile()
+    add_string( SOUT_PREFIX_AUDIO "lend-callback", "0", T_AUDIO_LEND_CALLBACK, LT_AUDIO_LEND_CALLBACK, true )
+        change_volatile()
     add_string( SOUT_PREFIX_VIDEO "data", "0", T_VIDEO_DATA, LT_VIDEO_DATA, true )
         change_volatile()
     add_string( SOUT_PREFIX_AUDIO "data", "0", T_AUDIO_DATA, LT_VIDEO_DATA, true )
@@ -121,7 +139,8 @@ vlc_module_end ()
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
     "video-prerender-callback", "audio-prerender-callback",
-    "video-postrender-callback", "audio-postrender-callback", "video-data", "audio-data", "time-sync", NULL
+    "video-postrender-callback", "audio-postrender-callback",
+    "video-lend-callback", "audio-lend-callback", "video-data", "audio-data", "time-sync", NULL
 };
 
 static void *Add( sout_stream_t *, const es_format_t * );
@@ -147,6 +166,8 @@ typedef struct
     void ( *pf_audio_prerender_callback ) ( void* p_audio_data, uint8_t** pp_pcm_buffer, size_t size );
     void ( *pf_video_postrender_callback ) ( void* p_video_data, uint8_t* p_pixel_buffer, int width, int height, int pixel_pitch, size_t size, vlc_tick_t pts );
     void ( *pf_audio_postrender_callback ) ( void* p_audio_data, uint8_t* p_pcm_buffer, unsigned int channels, unsigned int rate, unsigned int nb_samples, unsigned int bits_per_sample, size_t size, vlc_tick_t pts );
+    void ( *pf_video_lend_callback ) ( void* p_video_data, void* p_ref, void ( *pf_release ) ( void* p_ref ), const uint8_t* p_pixel_buffer, int width, int height, int pixel_pitch, size_t size, vlc_tick_t pts );
+    void ( *pf_audio_lend_callback ) ( void* p_audio_data, void* p_ref, void ( *pf_release ) ( void* p_ref ), const uint8_t* p_pcm_buffer, unsigned int channels, unsigned int rate, unsigned int nb_samples, unsigned int bits_per_sample, size_t size, vlc_tick_t pts );
     bool time_sync;
 } sout_stream_sys_t;
 
@@ -232,6 +253,15 @@ static int Open( vlc_object_t *p_this )
     if (p_sys->pf_audio_postrender_callback == NULL)
         p_sys->pf_audio_postrender_callback = AudioPostrenderDefaultCallback;
 
+    /* the lend callbacks replace the prerender and postrender ones */
+    psz_tmp = var_GetString( p_stream, SOUT_PREFIX_VIDEO "lend-callback" );
+    p_sys->pf_video_lend_callback = (void (*) (void*, void*, void (*) (void*), const uint8_t*, int, int, int, size_t, vlc_tick_t))(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+
+    psz_tmp = var_GetString( p_stream, SOUT_PREFIX_AUDIO "lend-callback" );
+    p_sys->pf_audio_lend_callback = (void (*) (void*, void*, void (*) (void*), const uint8_t*, unsigned int, unsigned int, unsigned int, unsigned int, size_t, vlc_tick_t))(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+
     /* Setting stream out module callbacks */
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
@@ -353,6 +383,20 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
     return VLC_SUCCESS;
 }
 
+/* Releases a buffer lent to the application */
+static void LentBufferRelease( void *p_ref )
+{
+    block_Release( (block_t *)p_ref );
+}
+
+/* Detaches the first block of the chain, to lend it */
+static block_t *LendBuffer( block_t *p_buffer )
+{
+    block_ChainRelease( p_buffer->p_next );
+    p_buffer->p_next = NULL;
+    return p_buffer;
+}
+
 static int SendVideo( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
@@ -360,6 +404,16 @@ static int SendVideo( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
     size_t i_size = p_buffer->i_buffer;
     uint8_t* p_pixels = NULL;
 
+    if( p_sys->pf_video_lend_callback != NULL )
+    {
+        p_buffer = LendBuffer( p_buffer );
+        p_sys->pf_video_lend_callback( id->p_data, p_buffer, LentBufferRelease,
+                                       p_buffer->p_buffer,
+                                       id->format.video.i_width, id->format.video.i_height,
+                                       id->format.video.i_bits_per_pixel, i_size, p_buffer->i_pts );
+        return VLC_SUCCESS;
+    }
+
     /* Calling the prerender callback to get user buffer */
     p_sys->pf_video_prerender_callback( id->p_data, &p_pixels, i_size );
 
@@ -397,6 +451,17 @@ static int SendAudio( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
     }
 
     i_samples = i_size / ( ( id->format.audio.i_bitspersample / 8 ) * id->format.audio.i_channels );
+
+    if( p_sys->pf_audio_lend_callback != NULL )
+    {
+        p_buffer = LendBuffer( p_buffer );
+        p_sys->pf_audio_lend_callback( id->p_data, p_buffer, LentBufferRelease,
+                                       p_buffer->p_buffer,
+                                       id->format.audio.i_channels, id->format.audio.i_rate, i_samples,
+                                       id->format.audio.i_bitspersample, i_size, p_buffer->i_pts );
+        return VLC_SUCCESS;
+    }
+
     /* Calling the prerender callback to get user buffer */
     p_sys->pf_audio_prerender_callback( id->p_data, &p_pcm_buffer, i_size );
     if (!p_pcm_buffer)
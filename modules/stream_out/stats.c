@@ -33,6 +33,16 @@
 #include <vlc_block.h>
 #include <vlc_md5.h>
 #include <vlc_fs.h>
+#include <vlc_list.h>
+#include <vlc_memstream.h>
+
+#define SOUT_CFG_PREFIX "sout-stats-"
+
+/* Aggregating mode */
+#define STATS_WINDOWS 8   /* sliding bitrate window, in intervals */
+#define STATS_BUCKETS 16  /* log2 histograms */
+#define STATS_JITTER_UNIT VLC_TICK_FROM_US(100)
+#define STATS_BITRATE_UNIT 16000 /* bit/s */
 
 /*****************************************************************************
  * Local prototypes
@@ -41,8 +51,33 @@ typedef struct
 {
     FILE *output;
     char *prefix;
+
+    /* Aggregating mode, when interval > 0 */
+    vlc_tick_t interval;
+    vlc_mutex_t lock;
+    struct vlc_list ids;
 } sout_stream_sys_t;
 
+typedef struct
+{
+    vlc_tick_t interval_start;
+    vlc_tick_t last_arrival;
+    vlc_tick_t last_dts;
+    uint64_t bytes;
+    uint64_t blocks;
+    uint64_t window_bytes[STATS_WINDOWS];
+    unsigned window;
+    vlc_tick_t jitter;
+    vlc_tick_t jitter_max;
+    uint32_t jitter_hist[STATS_BUCKETS];
+    uint32_t bitrate_hist[STATS_BUCKETS];
+    uint64_t dts_violations;
+    uint64_t dts_missing;
+    vlc_tick_t offset_min;
+    vlc_tick_t offset_max;
+    vlc_tick_t wander;
+} stats_es_t;
+
 typedef struct
 {
     int id;
@@ -51,8 +86,178 @@ typedef struct
     const char *type;
     vlc_tick_t previous_dts,track_duration;
     struct md5_s hash;
+
+    stats_es_t stats;
+    char *report;           /* last JSON report of this ES, under lock */
+    struct vlc_list node;
 } sout_stream_id_sys_t;
 
+static inline unsigned StatsBucket( uint64_t value )
+{
+    unsigned bucket = value ? 64 - vlc_clzll( value ) : 0;
+    return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1;
+}
+
+static void StatsPrintHistogram( struct vlc_memstream *ms, const char *name,
+                                 const uint32_t *hist )
+{
+    vlc_memstream_printf( ms, ",\"%s\":[", name );
+    for( unsigned i = 0; i < STATS_BUCKETS; i++ )
+        vlc_memstream_printf( ms, "%s%"PRIu32, i ? "," : "", hist[i] );
+    vlc_memstream_putc( ms, ']' );
+}
+
+/* Gather the last reports of all ES, publish them as variable and output
+ * line. Called with the lock held. */
+static void StatsPublish( sout_stream_t *p_stream )
+{
+    sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
+    struct vlc_memstream ms;
+    sout_stream_id_sys_t *id;
+    bool first = true;
+
+    if( vlc_memstream_open( &ms ) )
+        return;
+
+    vlc_memstream_printf( &ms, "{\"prefix\":\"%s\",\"es\":[",
+                          p_sys->prefix ? p_sys->prefix : "" );
+    vlc_list_foreach( id, &p_sys->ids, node )
+    {
+        if( id->report == NULL )
+            continue;
+        if( !first )
+            vlc_memstream_putc( &ms, ',' );
+        vlc_memstream_puts( &ms, id->report );
+        first = false;
+    }
+    vlc_memstream_puts( &ms, "]}" );
+
+    if( vlc_memstream_close( &ms ) )
+        return;
+
+    var_SetString( p_stream->p_sout, SOUT_CFG_PREFIX "report", ms.ptr );
+    if( p_sys->output )
+    {
+        fprintf( p_sys->output, "%s\n", ms.ptr );
+        fflush( p_sys->output );
+    }
+    else
+        msg_Dbg( p_stream, "%s", ms.ptr );
+    free( ms.ptr );
+}
+
+/* Close the current interval of an ES: fold it in the sliding window and
+ * histograms, and refresh its report. */
+static void StatsInterval( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                           vlc_tick_t now )
+{
+    sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
+    stats_es_t *st = &id->stats;
+    vlc_tick_t elapsed = now - st->interval_start;
+    struct vlc_memstream ms;
+
+    uint64_t bitrate = elapsed > 0
+        ? st->window_bytes[st->window] * 8 * CLOCK_FREQ / elapsed : 0;
+    st->bitrate_hist[StatsBucket( bitrate / STATS_BITRATE_UNIT )]++;
+
+    uint64_t window_bytes = 0;
+    for( unsigned i = 0; i < STATS_WINDOWS; i++ )
+        window_bytes += st->window_bytes[i];
+    uint64_t window_bitrate = window_bytes * 8 * CLOCK_FREQ
+                            / ( STATS_WINDOWS * p_sys->interval );
+
+    if( st->offset_max >= st->offset_min )
+        st->wander = st->offset_max - st->offset_min;
+
+    st->window = ( st->window + 1 ) % STATS_WINDOWS;
+    st->window_bytes[st->window] = 0;
+    st->interval_start = now;
+    st->offset_min = INT64_MAX;
+    st->offset_max = INT64_MIN;
+
+    if( vlc_memstream_open( &ms ) )
+        return;
+    vlc_memstream_printf( &ms, "{\"id\":%d,\"type\":\"%s\",\"bytes\":%"PRIu64
+                          ",\"blocks\":%"PRIu64",\"bitrate\":%"PRIu64
+                          ",\"bitrate_window\":%"PRIu64",\"jitter_us\":%"PRId64
+                          ",\"jitter_max_us\":%"PRId64",\"clock_wander_us\":%"PRId64
+                          ",\"dts_violations\":%"PRIu64",\"dts_missing\":%"PRIu64,
+                          id->id, id->type, st->bytes, st->blocks, bitrate,
+                          window_bitrate, US_FROM_VLC_TICK( st->jitter ),
+                          US_FROM_VLC_TICK( st->jitter_max ),
+                          US_FROM_VLC_TICK( st->wander ),
+                          st->dts_violations, st->dts_missing );
+    StatsPrintHistogram( &ms, "jitter_hist", st->jitter_hist );
+    StatsPrintHistogram( &ms, "bitrate_hist", st->bitrate_hist );
+    vlc_memstream_putc( &ms, '}' );
+    if( vlc_memstream_close( &ms ) )
+        return;
+
+    vlc_mutex_lock( &p_sys->lock );
+    free( id->report );
+    id->report = ms.ptr;
+    StatsPublish( p_stream );
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
+/* Per block accounting: a handful of integer operations, everything else
+ * is deferred to the end of the interval */
+static void StatsSend( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                       const block_t *p_block )
+{
+    sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
+    stats_es_t *st = &id->stats;
+    const vlc_tick_t now = vlc_tick_now();
+
+    if( st->interval_start == VLC_TICK_INVALID )
+        st->interval_start = now;
+
+    for( ; p_block != NULL; p_block = p_block->p_next )
+    {
+        st->bytes += p_block->i_buffer;
+        st->blocks++;
+        st->window_bytes[st->window] += p_block->i_buffer;
+
+        if( p_block->i_dts == VLC_TICK_INVALID )
+        {
+            st->dts_missing++;
+            continue;
+        }
+
+        if( st->last_dts != VLC_TICK_INVALID )
+        {
+            if( p_block->i_dts <= st->last_dts )
+                st->dts_violations++;
+            else
+            {
+                /* RFC 3550 interarrival jitter, in the DTS timebase */
+                vlc_tick_t d = ( now - st->last_arrival )
+                             - ( p_block->i_dts - st->last_dts );
+                if( d < 0 )
+                    d = -d;
+                st->jitter += ( d - st->jitter ) / 16;
+                if( d > st->jitter_max )
+                    st->jitter_max = d;
+                st->jitter_hist[StatsBucket( d / STATS_JITTER_UNIT )]++;
+            }
+        }
+
+        /* The spread of DTS against arrival time over an interval is how
+         * much the stream clock wanders from ours */
+        vlc_tick_t offset = p_block->i_dts - now;
+        if( offset < st->offset_min )
+            st->offset_min = offset;
+        if( offset > st->offset_max )
+            st->offset_max = offset;
+
+        st->last_dts = p_block->i_dts;
+        st->last_arrival = now;
+    }
+
+    if( now - st->interval_start >= p_sys->interval )
+        StatsInterval( p_stream, id, now );
+}
+
 static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
 {
     sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
@@ -84,6 +289,19 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->track_duration = 0;
     InitMD5( &id->hash );
 
+    memset( &id->stats, 0, sizeof( id->stats ) );
+    id->stats.interval_start = VLC_TICK_INVALID;
+    id->stats.last_dts = VLC_TICK_INVALID;
+    id->stats.offset_min = INT64_MAX;
+    id->stats.offset_max = INT64_MIN;
+    id->report = NULL;
+    if( p_sys->interval > 0 )
+    {
+        vlc_mutex_lock( &p_sys->lock );
+        vlc_list_append( &id->node, &p_sys->ids );
+        vlc_mutex_unlock( &p_sys->lock );
+    }
+
     msg_Dbg( p_stream, "%s: Adding track type:%s id:%d", p_sys->prefix, id->type, id->id);
     return id;
 }
@@ -93,6 +311,19 @@ static void Del( sout_stream_t *p_stream, void *_id )
     sout_stream_sys_t *p_sys = (sout_stream_sys_t *)p_stream->p_sys;
     sout_stream_id_sys_t *id = (sout_stream_id_sys_t *)_id;
 
+    if( p_sys->interval > 0 )
+    {
+        StatsInterval( p_stream, id, vlc_tick_now() );
+        vlc_mutex_lock( &p_sys->lock );
+        vlc_list_remove( &id->node );
+        vlc_mutex_unlock( &p_sys->lock );
+        msg_Dbg( p_stream, "%s: Removing track type:%s id:%d final:%s",
+                 p_sys->prefix, id->type, id->id, id->report ? id->report : "" );
+        free( id->report );
+        free( id );
+        return;
+    }
+
     EndMD5( &id->hash );
     char *outputhash = psz_md5_hash( &id->hash );
     unsigned int num,den;
@@ -116,6 +347,12 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
     sout_stream_id_sys_t *id = (sout_stream_id_sys_t *)_id;
     struct md5_s hash;
 
+    if( p_sys->interval > 0 )
+    {
+        StatsSend( p_stream, id, p_buffer );
+        return VLC_SUCCESS;
+    }
+
     block_t *p_block = p_buffer;
     while ( p_block != NULL )
     {
@@ -155,11 +392,9 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
  * Open:
  *****************************************************************************/
 static const char *ppsz_sout_options[] = {
-    "output", "prefix", NULL
+    "output", "prefix", "interval", NULL
 };
 
-#define SOUT_CFG_PREFIX "sout-stats-"
-
 static int Open(sout_stream_t *p_stream)
 {
     sout_stream_sys_t *p_sys;
@@ -174,6 +409,11 @@ static int Open(sout_stream_t *p_stream)
                    p_stream->p_cfg );
 
 
+    p_sys->interval = VLC_TICK_FROM_MS(
+            var_InheritInteger( p_stream, SOUT_CFG_PREFIX "interval" ) );
+    vlc_mutex_init( &p_sys->lock );
+    vlc_list_init( &p_sys->ids );
+
     outputFile = var_InheritString( p_stream, SOUT_CFG_PREFIX "output" );
 
     if( outputFile )
@@ -185,13 +425,16 @@ static int Open(sout_stream_t *p_stream)
             free( p_sys );
             free( outputFile );
             return VLC_EGENERIC;
-        } else {
+        } else if( p_sys->interval == 0 ) {
             fprintf( p_sys->output,"#prefix\ttrack\ttype\tsegment_number\tdts_difference\tlength\tmd5\n");
         }
         free( outputFile );
     }
     p_sys->prefix = var_InheritString( p_stream, SOUT_CFG_PREFIX "prefix" );
 
+    if( p_sys->interval > 0 )
+        var_Create( p_stream->p_sout, SOUT_CFG_PREFIX "report", VLC_VAR_STRING );
+
     p_stream->p_sys     = p_sys;
     return VLC_SUCCESS;
 }
@@ -279,6 +522,9 @@ static void Close( vlc_object_t * p_this )
     if( p_sys->output )
         fclose( p_sys->output );
 
+    if( p_sys->interval > 0 )
+        var_Destroy( p_stream->p_sout, SOUT_CFG_PREFIX "report" );
+
     free( p_sys->prefix );
     free( p_sys );
 }
@@ -290,6 +536,11 @@ static void Close( vlc_object_t * p_this )
 #define OUTPUT_LONGTEXT N_( \
     "Writes stats to file instead of stdout" )
 #define PREFIX_TEXT N_("Prefix to show on output line")
+#define INTERVAL_TEXT N_("Aggregation interval (ms)")
+#define INTERVAL_LONGTEXT N_( \
+    "Instead of one line per block, aggregate bitrate, jitter, DTS and " \
+    "clock statistics per ES and report them as JSON at this interval, in " \
+    "the output file and the sout-stats-report variable. 0 disables." )
 
 vlc_module_begin()
     set_shortname( N_("Stats"))
@@ -301,6 +552,7 @@ vlc_module_begin()
     set_callbacks( OutputOpen, Close )
     add_string( SOUT_CFG_PREFIX "output", "", OUTPUT_TEXT,OUTPUT_LONGTEXT, false );
     add_string( SOUT_CFG_PREFIX "prefix", "stats", PREFIX_TEXT,PREFIX_TEXT, false );
+    add_integer( SOUT_CFG_PREFIX "interval", 0, INTERVAL_TEXT, INTERVAL_LONGTEXT, false );
     add_submodule()
     set_capability( "sout filter", 0 )
     add_shortcut( "stats" )
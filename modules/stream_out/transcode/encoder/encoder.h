@@ -45,6 +45,11 @@ typedef struct
                 int          i_priority;
                 uint32_t     pool_size;
             } threads;
+            struct
+            {
+                unsigned int i_count;
+                unsigned int i_length;
+            } chunks;
         } video;
         struct
         {
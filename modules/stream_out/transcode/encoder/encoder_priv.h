@@ -18,6 +18,8 @@
  *****************************************************************************/
 #include <vlc_picture_fifo.h>
 
+typedef struct transcode_chunk_t transcode_chunk_t;
+
 struct transcode_encoder_t
 {
     encoder_t       *p_encoder;
@@ -31,6 +33,19 @@ struct transcode_encoder_t
     /* output buffers */
     block_t         *p_buffers;
     bool b_threaded;
+
+    /* chunked encoding: consecutive runs of pictures are encoded by
+     * independent encoder instances and output in submission order */
+    struct
+    {
+        const transcode_encoder_config_t *p_cfg;
+        es_format_t        fmt_out;  /* output format before encoder open */
+        vlc_thread_t      *p_threads;
+        unsigned           i_threads;
+        transcode_chunk_t *p_first;  /* oldest chunk not output yet */
+        transcode_chunk_t *p_next;   /* oldest chunk not taken by a worker */
+        transcode_chunk_t *p_last;   /* chunk being fed */
+    } chunks;
 };
 
 int transcode_encoder_audio_open( transcode_encoder_t *p_enc,
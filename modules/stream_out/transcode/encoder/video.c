@@ -403,6 +403,268 @@ static void* EncoderThread( void *obj )
     return NULL;
 }
 
+struct transcode_chunk_t
+{
+    picture_fifo_t    *pp_pics;
+    unsigned           i_pics;   /* pictures pushed so far */
+    bool               b_closed; /* no more pictures will be pushed */
+    bool               b_done;   /* encoded and drained */
+    block_t           *p_out;
+    transcode_chunk_t *p_next;
+};
+
+struct chunk_encoder_owner
+{
+    encoder_t enc;
+    encoder_t *p_parent;
+};
+
+static vlc_decoder_device *ChunkGetEncoderDevice( encoder_t *enc )
+{
+    struct chunk_encoder_owner *p_owner =
+        container_of( enc, struct chunk_encoder_owner, enc );
+    encoder_t *p_parent = p_owner->p_parent;
+
+    if( !p_parent->cbs || !p_parent->cbs->video.get_device )
+        return NULL;
+    return p_parent->cbs->video.get_device( p_parent );
+}
+
+static const struct encoder_owner_callbacks chunk_encoder_cbs = {
+    { ChunkGetEncoderDevice, }
+};
+
+static transcode_chunk_t * ChunkNew( void )
+{
+    transcode_chunk_t *p_chunk = calloc( 1, sizeof(*p_chunk) );
+    if( !p_chunk )
+        return NULL;
+    p_chunk->pp_pics = picture_fifo_New();
+    if( !p_chunk->pp_pics )
+    {
+        free( p_chunk );
+        return NULL;
+    }
+    return p_chunk;
+}
+
+static void ChunkDelete( transcode_chunk_t *p_chunk )
+{
+    picture_fifo_Delete( p_chunk->pp_pics );
+    block_ChainRelease( p_chunk->p_out );
+    free( p_chunk );
+}
+
+/* Opens a fresh encoder instance with the configuration of the main one,
+ * so that each chunk starts with a keyframe and its own rate control */
+static encoder_t * ChunkEncoderOpen( transcode_encoder_t *p_enc )
+{
+    const transcode_encoder_config_t *p_cfg = p_enc->chunks.p_cfg;
+    struct chunk_encoder_owner *p_owner = (struct chunk_encoder_owner *)
+        sout_EncoderCreate( p_enc->p_encoder, sizeof(*p_owner) );
+    if( !p_owner )
+        return NULL;
+
+    encoder_t *p_encoder = &p_owner->enc;
+    p_owner->p_parent = p_enc->p_encoder;
+    p_encoder->cbs = &chunk_encoder_cbs;
+    p_encoder->i_threads = p_cfg->video.threads.i_count;
+    p_encoder->p_cfg = p_cfg->p_config_chain;
+    p_encoder->vctx_in = p_enc->p_encoder->vctx_in;
+    es_format_Copy( &p_encoder->fmt_in, &p_enc->p_encoder->fmt_in );
+    es_format_Copy( &p_encoder->fmt_out, &p_enc->chunks.fmt_out );
+
+    p_encoder->p_module = module_need( p_encoder, "encoder", p_cfg->psz_name, true );
+    if( !p_encoder->p_module )
+    {
+        es_format_Clean( &p_encoder->fmt_in );
+        es_format_Clean( &p_encoder->fmt_out );
+        vlc_object_delete( p_encoder );
+        return NULL;
+    }
+    return p_encoder;
+}
+
+static void ChunkEncoderClose( encoder_t *p_encoder )
+{
+    module_unneed( p_encoder, p_encoder->p_module );
+    es_format_Clean( &p_encoder->fmt_in );
+    es_format_Clean( &p_encoder->fmt_out );
+    vlc_object_delete( p_encoder );
+}
+
+/* Moves the output of the leading finished chunks, in order. Called locked */
+static void ChunkOutput( transcode_encoder_t *p_enc )
+{
+    transcode_chunk_t *p_chunk;
+    while( (p_chunk = p_enc->chunks.p_first) != NULL && p_chunk->b_done )
+    {
+        p_enc->chunks.p_first = p_chunk->p_next;
+        if( p_enc->chunks.p_last == p_chunk )
+            p_enc->chunks.p_last = NULL;
+        block_ChainAppend( &p_enc->p_buffers, p_chunk->p_out );
+        p_chunk->p_out = NULL;
+        ChunkDelete( p_chunk );
+    }
+}
+
+static void* ChunkEncoderThread( void *obj )
+{
+    transcode_encoder_t *p_enc = obj;
+    int canc = vlc_savecancel ();
+
+    vlc_mutex_lock( &p_enc->lock_out );
+
+    for( ;; )
+    {
+        while( !p_enc->b_abort && p_enc->chunks.p_next == NULL )
+            vlc_cond_wait( &p_enc->cond, &p_enc->lock_out );
+
+        transcode_chunk_t *p_chunk = p_enc->chunks.p_next;
+        if( p_chunk == NULL )
+            break; /* aborted and nothing left to encode */
+        p_enc->chunks.p_next = p_chunk->p_next;
+
+        vlc_mutex_unlock( &p_enc->lock_out );
+        encoder_t *p_encoder = ChunkEncoderOpen( p_enc );
+        if( !p_encoder )
+            msg_Err( p_enc->p_encoder, "cannot open chunk encoder" );
+        vlc_mutex_lock( &p_enc->lock_out );
+
+        for( ;; )
+        {
+            picture_t *p_pic;
+            while( (p_pic = picture_fifo_Pop( p_chunk->pp_pics )) == NULL &&
+                   !p_chunk->b_closed )
+                vlc_cond_wait( &p_enc->cond, &p_enc->lock_out );
+            if( p_pic == NULL )
+                break;
+            vlc_sem_post( &p_enc->picture_pool_has_room );
+
+            /* release lock while encoding */
+            vlc_mutex_unlock( &p_enc->lock_out );
+            block_t *p_block = NULL;
+            if( p_encoder )
+                p_block = p_encoder->pf_encode_video( p_encoder, p_pic );
+            picture_Release( p_pic );
+            vlc_mutex_lock( &p_enc->lock_out );
+
+            block_ChainAppend( &p_chunk->p_out, p_block );
+        }
+
+        vlc_mutex_unlock( &p_enc->lock_out );
+        block_t *p_tail = NULL;
+        if( p_encoder )
+        {
+            block_t *p_block;
+            do {
+                p_block = p_encoder->pf_encode_video( p_encoder, NULL );
+                block_ChainAppend( &p_tail, p_block );
+            } while( p_block );
+            ChunkEncoderClose( p_encoder );
+        }
+        vlc_mutex_lock( &p_enc->lock_out );
+
+        block_ChainAppend( &p_chunk->p_out, p_tail );
+        p_chunk->b_done = true;
+        ChunkOutput( p_enc );
+    }
+
+    vlc_mutex_unlock( &p_enc->lock_out );
+
+    vlc_restorecancel (canc);
+
+    return NULL;
+}
+
+static void StopEncoderThreads( transcode_encoder_t *p_enc )
+{
+    vlc_mutex_lock( &p_enc->lock_out );
+    p_enc->b_abort = true;
+    if( p_enc->chunks.p_last )
+        p_enc->chunks.p_last->b_closed = true;
+    vlc_cond_broadcast( &p_enc->cond );
+    vlc_mutex_unlock( &p_enc->lock_out );
+
+    if( p_enc->chunks.i_threads )
+    {
+        for( unsigned i = 0; i < p_enc->chunks.i_threads; i++ )
+            vlc_join( p_enc->chunks.p_threads[i], NULL );
+        free( p_enc->chunks.p_threads );
+        p_enc->chunks.p_threads = NULL;
+        p_enc->chunks.i_threads = 0;
+        es_format_Clean( &p_enc->chunks.fmt_out );
+        /* every chunk got output by the last worker */
+        assert( p_enc->chunks.p_first == NULL );
+    }
+    else
+    {
+        vlc_join( p_enc->thread, NULL );
+    }
+}
+
+static int StartChunkEncoderThreads( transcode_encoder_t *p_enc,
+                                     const transcode_encoder_config_t *p_cfg )
+{
+    p_enc->chunks.p_threads = vlc_alloc( p_cfg->video.chunks.i_count,
+                                         sizeof(*p_enc->chunks.p_threads) );
+    if( !p_enc->chunks.p_threads )
+        return VLC_ENOMEM;
+
+    p_enc->chunks.p_cfg = p_cfg;
+    p_enc->chunks.p_first = p_enc->chunks.p_next = p_enc->chunks.p_last = NULL;
+    p_enc->chunks.i_threads = 0;
+
+    for( unsigned i = 0; i < p_cfg->video.chunks.i_count; i++ )
+    {
+        if( vlc_clone( &p_enc->chunks.p_threads[i], ChunkEncoderThread, p_enc,
+                       p_cfg->video.threads.i_priority ) )
+            break;
+        p_enc->chunks.i_threads++;
+    }
+
+    if( p_enc->chunks.i_threads == 0 )
+    {
+        free( p_enc->chunks.p_threads );
+        p_enc->chunks.p_threads = NULL;
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void PushChunkPicture( transcode_encoder_t *p_enc, picture_t *p_pic )
+{
+    transcode_chunk_t *p_chunk = p_enc->chunks.p_last;
+
+    if( p_chunk && p_chunk->i_pics >= p_enc->chunks.p_cfg->video.chunks.i_length )
+    {
+        p_chunk->b_closed = true;
+        p_chunk = NULL;
+    }
+
+    if( p_chunk == NULL )
+    {
+        p_chunk = ChunkNew();
+        if( !p_chunk )
+        {
+            vlc_sem_post( &p_enc->picture_pool_has_room );
+            return;
+        }
+        if( p_enc->chunks.p_last )
+            p_enc->chunks.p_last->p_next = p_chunk;
+        p_enc->chunks.p_last = p_chunk;
+        if( !p_enc->chunks.p_first )
+            p_enc->chunks.p_first = p_chunk;
+        if( !p_enc->chunks.p_next )
+            p_enc->chunks.p_next = p_chunk;
+    }
+
+    picture_Hold( p_pic );
+    picture_fifo_Push( p_chunk->pp_pics, p_pic );
+    p_chunk->i_pics++;
+    vlc_cond_broadcast( &p_enc->cond );
+}
+
 int transcode_encoder_video_drain( transcode_encoder_t *p_enc, block_t **out )
 {
     if( !p_enc->b_threaded )
@@ -416,13 +678,7 @@ int transcode_encoder_video_drain( transcode_encoder_t *p_enc, block_t **out )
     else
     {
         if( p_enc->b_threaded && !p_enc->b_abort )
-        {
-            vlc_mutex_lock( &p_enc->lock_out );
-            p_enc->b_abort = true;
-            vlc_cond_signal( &p_enc->cond );
-            vlc_mutex_unlock( &p_enc->lock_out );
-            vlc_join( p_enc->thread, NULL );
-        }
+            StopEncoderThreads( p_enc );
         block_ChainAppend( out, transcode_encoder_get_output_async( p_enc ) );
     }
     return VLC_SUCCESS;
@@ -431,13 +687,7 @@ int transcode_encoder_video_drain( transcode_encoder_t *p_enc, block_t **out )
 void transcode_encoder_video_close( transcode_encoder_t *p_enc )
 {
     if( p_enc->b_threaded && !p_enc->b_abort )
-    {
-        vlc_mutex_lock( &p_enc->lock_out );
-        p_enc->b_abort = true;
-        vlc_cond_signal( &p_enc->cond );
-        vlc_mutex_unlock( &p_enc->lock_out );
-        vlc_join( p_enc->thread, NULL );
-    }
+        StopEncoderThreads( p_enc );
 
     /* Close encoder */
     module_unneed( p_enc->p_encoder, p_enc->p_encoder->p_module );
@@ -450,10 +700,20 @@ int transcode_encoder_video_open( transcode_encoder_t *p_enc,
     p_enc->p_encoder->i_threads = p_cfg->video.threads.i_count;
     p_enc->p_encoder->p_cfg = p_cfg->p_config_chain;
 
+    const bool b_chunked = p_cfg->video.chunks.i_count > 1 &&
+                           p_cfg->video.chunks.i_length > 0;
+    /* chunk encoders are opened from the format the main one was given */
+    if( b_chunked )
+        es_format_Copy( &p_enc->chunks.fmt_out, &p_enc->p_encoder->fmt_out );
+
     p_enc->p_encoder->p_module =
         module_need( p_enc->p_encoder, "encoder", p_cfg->psz_name, true );
     if( !p_enc->p_encoder->p_module )
+    {
+        if( b_chunked )
+            es_format_Clean( &p_enc->chunks.fmt_out );
         return VLC_EGENERIC;
+    }
 
     p_enc->p_encoder->fmt_in.video.i_chroma = p_enc->p_encoder->fmt_in.i_codec;
 
@@ -461,11 +721,30 @@ int transcode_encoder_video_open( transcode_encoder_t *p_enc,
     p_enc->p_encoder->fmt_out.i_codec =
         vlc_fourcc_GetCodec( VIDEO_ES, p_enc->p_encoder->fmt_out.i_codec );
 
-    vlc_sem_init( &p_enc->picture_pool_has_room, p_cfg->video.threads.pool_size );
     vlc_cond_init( &p_enc->cond );
     p_enc->p_buffers = NULL;
     p_enc->b_abort = false;
 
+    if( b_chunked )
+    {
+        /* Every worker needs a whole chunk queued to run concurrently with
+         * the others, as pictures are produced in presentation order */
+        vlc_sem_init( &p_enc->picture_pool_has_room,
+                      __MAX( p_cfg->video.threads.pool_size,
+                             p_cfg->video.chunks.i_count * p_cfg->video.chunks.i_length ) );
+        if( StartChunkEncoderThreads( p_enc, p_cfg ) )
+        {
+            es_format_Clean( &p_enc->chunks.fmt_out );
+            module_unneed( p_enc->p_encoder, p_enc->p_encoder->p_module );
+            p_enc->p_encoder->p_module = NULL;
+            return VLC_EGENERIC;
+        }
+        p_enc->b_threaded = true;
+        return VLC_SUCCESS;
+    }
+
+    vlc_sem_init( &p_enc->picture_pool_has_room, p_cfg->video.threads.pool_size );
+
     if( p_cfg->video.threads.i_count > 0 )
     {
         if( vlc_clone( &p_enc->thread, EncoderThread, p_enc, p_cfg->video.threads.i_priority ) )
@@ -489,6 +768,12 @@ block_t * transcode_encoder_video_encode( transcode_encoder_t *p_enc, picture_t
 
     vlc_sem_wait( &p_enc->picture_pool_has_room );
     vlc_mutex_lock( &p_enc->lock_out );
+    if( p_enc->chunks.i_threads )
+    {
+        PushChunkPicture( p_enc, p_pic );
+        vlc_mutex_unlock( &p_enc->lock_out );
+        return NULL;
+    }
     picture_Hold( p_pic );
     picture_fifo_Push( p_enc->pp_pics, p_pic );
     vlc_cond_signal( &p_enc->cond );
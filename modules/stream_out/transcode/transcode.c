@@ -75,6 +75,16 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define VLADDER_TEXT N_("Video renditions")
+#define VLADDER_LONGTEXT N_( \
+    "Comma separated list of extra video renditions to encode from the same " \
+    "decoded pictures, as WIDTHxHEIGHT or WIDTHxHEIGHT@KBPS. Each rendition " \
+    "is output as an extra elementary stream whose id is the source id plus " \
+    "1000 times its rank." )
+#define VLADDER_CASCADE_TEXT N_("Cascade video renditions")
+#define VLADDER_CASCADE_LONGTEXT N_( \
+    "Scale each rendition from the previous one instead of the main " \
+    "encoder input. Renditions must then be listed by decreasing size." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -126,9 +136,24 @@
 #define HP_LONGTEXT N_( \
     "Runs the optional encoder thread at the OUTPUT priority instead of " \
     "VIDEO." )
+#define FILTER_THREAD_TEXT N_("Filter thread")
+#define FILTER_THREAD_LONGTEXT N_( \
+    "Runs the video filters, the overlays and the encoder feeding on their " \
+    "own thread, so that decoding and filtering overlap. Up to pool-size " \
+    "decoded pictures are queued for it." )
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
+#define CHUNKS_TEXT N_("Parallel chunk encoders")
+#define CHUNKS_LONGTEXT N_( \
+    "Number of independent video encoder instances used to encode " \
+    "consecutive chunks of the stream concurrently. The encoded chunks are " \
+    "output in order. Meant for file to file transcoding, 0 or 1 disables." )
+#define CHUNK_LENGTH_TEXT N_("Chunk length")
+#define CHUNK_LENGTH_LONGTEXT N_( \
+    "Number of pictures per chunk when chunk encoders are used. Each chunk " \
+    "starts with a keyframe and up to chunks times this many pictures are " \
+    "queued in memory." )
 
 
 static const char *const ppsz_deinterlace_type[] =
@@ -177,6 +202,10 @@ vlc_module_begin ()
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list(SOUT_CFG_PREFIX "vfilter", "video filter", NULL,
                     VFILTER_TEXT, VFILTER_LONGTEXT)
+    add_string( SOUT_CFG_PREFIX "vladder", NULL, VLADDER_TEXT,
+                VLADDER_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "vladder-cascade", false, VLADDER_CASCADE_TEXT,
+              VLADDER_CASCADE_LONGTEXT, true )
 
     set_section( N_("Audio"), NULL )
     add_module(SOUT_CFG_PREFIX "aenc", "encoder", NULL,
@@ -213,8 +242,16 @@ vlc_module_begin ()
         change_integer_range( 0, 32 )
     add_integer( SOUT_CFG_PREFIX "pool-size", 10, POOL_TEXT, POOL_LONGTEXT, true )
         change_integer_range( 1, 1000 )
+    add_integer( SOUT_CFG_PREFIX "chunks", 0, CHUNKS_TEXT,
+                 CHUNKS_LONGTEXT, true )
+        change_integer_range( 0, 32 )
+    add_integer( SOUT_CFG_PREFIX "chunk-length", 120, CHUNK_LENGTH_TEXT,
+                 CHUNK_LENGTH_LONGTEXT, true )
+        change_integer_range( 1, 10000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
+    add_bool( SOUT_CFG_PREFIX "filter-thread", false, FILTER_THREAD_TEXT,
+              FILTER_THREAD_LONGTEXT, true )
 
 vlc_module_end ()
 
@@ -224,6 +261,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
+    "chunks", "chunk-length", "filter-thread", "vladder", "vladder-cascade",
     NULL
 };
 
@@ -325,6 +363,8 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
 
     p_cfg->video.threads.i_count = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
     p_cfg->video.threads.pool_size = var_GetInteger( p_stream, SOUT_CFG_PREFIX "pool-size" );
+    p_cfg->video.chunks.i_count = var_GetInteger( p_stream, SOUT_CFG_PREFIX "chunks" );
+    p_cfg->video.chunks.i_length = var_GetInteger( p_stream, SOUT_CFG_PREFIX "chunk-length" );
 
     if( var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" ) )
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_OUTPUT;
@@ -332,6 +372,50 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_VIDEO;
 }
 
+static void SetVideoLadderConfig( sout_stream_t *p_stream, sout_stream_sys_t *p_sys )
+{
+    p_sys->b_vladder_cascade =
+        var_GetBool( p_stream, SOUT_CFG_PREFIX "vladder-cascade" );
+
+    char *psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "vladder" );
+    if( !psz_string )
+        return;
+
+    char *psz_save;
+    for( char *psz_rung = strtok_r( psz_string, ",", &psz_save );
+         psz_rung; psz_rung = strtok_r( NULL, ",", &psz_save ) )
+    {
+        unsigned i_width, i_height, i_bitrate = 0;
+        if( sscanf( psz_rung, "%ux%u@%u", &i_width, &i_height, &i_bitrate ) < 2 ||
+            i_width == 0 || i_height == 0 )
+        {
+            msg_Warn( p_stream, "invalid video rendition `%s'", psz_rung );
+            continue;
+        }
+
+        transcode_encoder_config_t *p_cfgs =
+            realloc( p_sys->p_vladder_cfg,
+                     (p_sys->i_vladder + 1) * sizeof(*p_cfgs) );
+        if( !p_cfgs )
+            break;
+        p_sys->p_vladder_cfg = p_cfgs;
+
+        /* Same encoder and options, only the size and bitrate differ */
+        transcode_encoder_config_t *p_cfg = &p_cfgs[p_sys->i_vladder++];
+        *p_cfg = p_sys->venc_cfg;
+        p_cfg->video.f_scale = 0;
+        p_cfg->video.i_width = i_width;
+        p_cfg->video.i_height = i_height;
+        p_cfg->video.i_maxwidth = p_cfg->video.i_maxheight = 0;
+        if( i_bitrate )
+            p_cfg->video.i_bitrate = i_bitrate * 1000;
+
+        msg_Dbg( p_stream, "video rendition %ux%u %u kbps", i_width, i_height,
+                 p_cfg->video.i_bitrate / 1000 );
+    }
+    free( psz_string );
+}
+
 static void SetSPUEncoderConfig( sout_stream_t *p_stream, transcode_encoder_config_t *p_cfg )
 {
     char *psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "senc" );
@@ -420,6 +504,9 @@ static int Open( vlc_object_t *p_this )
                  p_sys->venc_cfg.video.i_bitrate / 1000 );
     }
 
+    if( p_sys->venc_cfg.i_codec )
+        SetVideoLadderConfig( p_stream, p_sys );
+
     /* Video Filter Parameters */
     sout_filters_config_init( &p_sys->vfilters_cfg );
 
@@ -439,6 +526,9 @@ static int Open( vlc_object_t *p_this )
         free( psz_string );
     }
 
+    p_sys->vfilters_cfg.video.b_threaded =
+        var_GetBool( p_stream, SOUT_CFG_PREFIX "filter-thread" );
+
     /* Subpictures SOURCES parameters (not releated to subtitles stream) */
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "sfilter" );
     if( psz_string && *psz_string )
@@ -480,6 +570,7 @@ static void Close( vlc_object_t * p_this )
     sout_stream_t       *p_stream = (sout_stream_t*)p_this;
     sout_stream_sys_t   *p_sys = p_stream->p_sys;
 
+    free( p_sys->p_vladder_cfg );
     transcode_encoder_config_clean( &p_sys->venc_cfg );
     sout_filters_config_clean( &p_sys->vfilters_cfg );
 
@@ -693,7 +784,7 @@ static void Del( sout_stream_t *p_stream, void *_id )
             if( id == p_sys->id_video )
                 p_sys->id_video = NULL;
             vlc_mutex_unlock( &p_sys->lock );
-            transcode_video_clean( id );
+            transcode_video_clean( p_stream, id );
             break;
         case SPU_ES:
             decoder_Destroy( id->p_decoder );
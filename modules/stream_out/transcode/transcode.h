@@ -17,6 +17,7 @@ typedef struct
             config_chain_t  *p_deinterlace_cfg;
             char            *psz_spu_sources;
             bool             b_reorient;
+            bool             b_threaded; /**< Filter on a separate thread */
         } video;
     };
 } sout_filters_config_t;
@@ -52,6 +53,10 @@ typedef struct
     /* Video */
     transcode_encoder_config_t venc_cfg;
     sout_filters_config_t vfilters_cfg;
+    /* Extra video renditions, shallow copies of venc_cfg */
+    transcode_encoder_config_t *p_vladder_cfg;
+    size_t          i_vladder;
+    bool            b_vladder_cascade;
 
     /* SPU */
     transcode_encoder_config_t senc_cfg;
@@ -130,6 +135,14 @@ struct sout_stream_id_sys_t
              spu_t           *p_spu;
              vlc_decoder_device *dec_dev;
              vlc_video_context *enc_vctx_in;
+             struct transcode_filter_stage *p_filter_stage;
+             struct transcode_video_rung *p_rungs; /**< Extra renditions */
+             size_t          i_rungs;
+             struct
+             {
+                 vlc_tick_t decode, filter, encode;
+                 unsigned   i_pictures;
+             } stats; /**< Time spent in each stage */
          };
          struct
          {
@@ -207,7 +220,7 @@ int  transcode_audio_init   ( sout_stream_t *, const es_format_t *,
 
 /* VIDEO */
 
-void transcode_video_clean  ( sout_stream_id_sys_t * );
+void transcode_video_clean  ( sout_stream_t *, sout_stream_id_sys_t * );
 int  transcode_video_process( sout_stream_t *, sout_stream_id_sys_t *,
                                      block_t *, block_t ** );
 int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
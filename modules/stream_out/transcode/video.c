@@ -87,6 +87,11 @@ static void debug_format( sout_stream_t *p_stream, const es_format_t *fmt )
              fmt->video.orientation );
 }
 
+struct transcode_filter_stage;
+static int FilterStageStart( sout_stream_t *, sout_stream_id_sys_t *,
+                             unsigned, int );
+static void FilterStageStop( struct transcode_filter_stage * );
+
 static vlc_decoder_device * transcode_video_filter_hold_device(vlc_object_t *o, void *sys)
 {
     sout_stream_id_sys_t *id = sys;
@@ -168,6 +173,215 @@ static picture_t *transcode_dequeue_all_pics( sout_stream_id_sys_t *id )
     return p_pics;
 }
 
+static void tag_last_block_with_flag( block_t **out, int i_flag )
+{
+    block_t *p_last = *out;
+    if( p_last )
+    {
+        while( p_last->p_next )
+            p_last = p_last->p_next;
+        p_last->i_flags |= i_flag;
+    }
+}
+
+/* Renditions get ES ids spaced from the source one so that they can be
+ * selected apart downstream */
+#define LADDER_ES_ID_STEP 1000
+
+struct transcode_video_rung
+{
+    const transcode_encoder_config_t *p_cfg;
+    transcode_encoder_t *encoder;
+    filter_chain_t      *p_scale; /* set once the encoder is open */
+    void                *downstream_id;
+    block_t             *p_out;   /* protected by fifo.lock */
+};
+
+static void transcode_video_ladder_init( sout_stream_t *p_stream,
+                                         sout_stream_id_sys_t *id,
+                                         const es_format_t *p_fmt_in )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    id->p_rungs = vlc_alloc( p_sys->i_vladder, sizeof(*id->p_rungs) );
+    if( !id->p_rungs )
+        return;
+
+    for( size_t i = 0; i < p_sys->i_vladder; i++ )
+    {
+        struct encoder_owner *p_enc_owner = (struct encoder_owner *)
+            sout_EncoderCreate( p_stream, sizeof(struct encoder_owner) );
+        if( unlikely(p_enc_owner == NULL) )
+            break;
+        p_enc_owner->id = id;
+        p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
+
+        struct transcode_video_rung *p_rung = &id->p_rungs[id->i_rungs];
+        p_rung->encoder = transcode_encoder_new( &p_enc_owner->enc, p_fmt_in );
+        if( !p_rung->encoder )
+            break;
+        p_rung->p_cfg = &p_sys->p_vladder_cfg[i];
+        p_rung->p_scale = NULL;
+        p_rung->downstream_id = NULL;
+        p_rung->p_out = NULL;
+        id->i_rungs++;
+    }
+}
+
+/* Opens the missing rung encoders once the main one is, and scales them
+ * from its input format */
+static void transcode_video_ladder_open( sout_stream_t *p_stream,
+                                         sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    const es_format_t *p_src = transcode_encoder_format_in( id->encoder );
+
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        struct transcode_video_rung *p_rung = &id->p_rungs[i];
+
+        if( !transcode_encoder_opened( p_rung->encoder ) )
+        {
+            transcode_encoder_video_configure( VLC_OBJECT(p_stream),
+                                               &p_src->video, p_rung->p_cfg,
+                                               &p_src->video, NULL,
+                                               p_rung->encoder );
+            if( transcode_encoder_open( p_rung->encoder, p_rung->p_cfg ) != VLC_SUCCESS )
+            {
+                msg_Err( p_stream, "cannot open encoder for rendition %ux%u",
+                         p_rung->p_cfg->video.i_width, p_rung->p_cfg->video.i_height );
+                continue;
+            }
+
+            const es_format_t *p_dst = transcode_encoder_format_in( p_rung->encoder );
+            p_rung->p_scale = filter_chain_NewVideo( p_stream, false, NULL );
+            if( p_rung->p_scale )
+            {
+                filter_chain_Reset( p_rung->p_scale, p_src, NULL, p_dst );
+                if( filter_chain_AppendConverter( p_rung->p_scale, NULL ) )
+                    transcode_remove_filters( &p_rung->p_scale );
+            }
+            if( !p_rung->p_scale )
+            {
+                msg_Err( p_stream, "cannot scale to rendition %ux%u",
+                         p_dst->video.i_visible_width, p_dst->video.i_visible_height );
+                transcode_encoder_close( p_rung->encoder );
+                continue;
+            }
+        }
+
+        if( !p_rung->downstream_id )
+        {
+            es_format_t fmt_orig = id->p_decoder->fmt_in; /* shallow */
+            fmt_orig.i_id += (i + 1) * LADDER_ES_ID_STEP;
+            p_rung->downstream_id =
+                id->pf_transcode_downstream_add( p_stream, &fmt_orig,
+                                                 transcode_encoder_format_out( p_rung->encoder ) );
+            if( !p_rung->downstream_id )
+                msg_Err( p_stream, "cannot output rendition %ux%u",
+                         p_rung->p_cfg->video.i_width, p_rung->p_cfg->video.i_height );
+        }
+
+        if( p_sys->b_vladder_cascade )
+            p_src = transcode_encoder_format_in( p_rung->encoder );
+    }
+}
+
+/* Encodes a main encoder input picture into every opened rendition */
+static void transcode_video_ladder_encode( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           picture_t *p_pic )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    picture_t *p_src = picture_Hold( p_pic );
+
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        struct transcode_video_rung *p_rung = &id->p_rungs[i];
+        if( !p_rung->p_scale )
+            continue;
+
+        picture_t *p_scaled = filter_chain_VideoFilter( p_rung->p_scale,
+                                                        picture_Hold( p_src ) );
+        if( !p_scaled )
+            continue;
+
+        block_t *p_block = transcode_encoder_encode( p_rung->encoder, p_scaled );
+        if( p_block )
+        {
+            vlc_mutex_lock( &id->fifo.lock );
+            block_ChainAppend( &p_rung->p_out, p_block );
+            vlc_mutex_unlock( &id->fifo.lock );
+        }
+
+        if( p_sys->b_vladder_cascade )
+        {
+            picture_Release( p_src );
+            p_src = p_scaled;
+        }
+        else
+            picture_Release( p_scaled );
+    }
+
+    picture_Release( p_src );
+}
+
+/* Sends the renditions output, draining the encoders on b_drain and
+ * closing them as well on b_eos */
+static void transcode_video_ladder_output( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           bool b_drain, bool b_eos )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        struct transcode_video_rung *p_rung = &id->p_rungs[i];
+
+        vlc_mutex_lock( &id->fifo.lock );
+        block_t *p_out = p_rung->p_out;
+        p_rung->p_out = NULL;
+        vlc_mutex_unlock( &id->fifo.lock );
+
+        if( transcode_encoder_opened( p_rung->encoder ) )
+        {
+            if( id->p_enccfg->video.threads.i_count >= 1 ||
+                id->p_enccfg->video.chunks.i_count > 1 )
+                block_ChainAppend( &p_out,
+                                   transcode_encoder_get_output_async( p_rung->encoder ) );
+
+            if( b_drain || b_eos )
+                transcode_encoder_drain( p_rung->encoder, &p_out );
+
+            if( b_eos )
+            {
+                transcode_encoder_close( p_rung->encoder );
+                transcode_remove_filters( &p_rung->p_scale );
+                tag_last_block_with_flag( &p_out, BLOCK_FLAG_END_OF_SEQUENCE );
+            }
+        }
+
+        if( p_out && p_rung->downstream_id )
+            sout_StreamIdSend( p_stream->p_next, p_rung->downstream_id, p_out );
+        else
+            block_ChainRelease( p_out );
+    }
+}
+
+static void transcode_video_ladder_clean( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        struct transcode_video_rung *p_rung = &id->p_rungs[i];
+        transcode_encoder_close( p_rung->encoder );
+        transcode_encoder_delete( p_rung->encoder );
+        transcode_remove_filters( &p_rung->p_scale );
+        block_ChainRelease( p_rung->p_out );
+        if( p_rung->downstream_id )
+            sout_StreamIdDel( p_stream->p_next, p_rung->downstream_id );
+    }
+    free( id->p_rungs );
+}
+
 int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
                           sout_stream_id_sys_t *id )
 {
@@ -275,8 +489,16 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     /* Will use this format as encoder input for now */
     transcode_encoder_update_format_in( id->encoder, &encoder_tested_fmt_in );
 
+    if( ((sout_stream_sys_t *)p_stream->p_sys)->i_vladder )
+        transcode_video_ladder_init( p_stream, id, &encoder_tested_fmt_in );
+
     es_format_Clean( &encoder_tested_fmt_in );
 
+    if( id->p_filterscfg->video.b_threaded &&
+        FilterStageStart( p_stream, id, id->p_enccfg->video.threads.pool_size,
+                          id->p_enccfg->video.threads.i_priority ) )
+        msg_Warn( p_stream, "cannot start the filter thread, filtering inline" );
+
     return VLC_SUCCESS;
 }
 
@@ -421,8 +643,21 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_clean( sout_stream_id_sys_t *id )
+void transcode_video_clean( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
 {
+    if( id->p_filter_stage )
+        FilterStageStop( id->p_filter_stage );
+
+    transcode_video_ladder_clean( p_stream, id );
+
+    if( id->stats.i_pictures )
+        msg_Dbg( p_stream, "%u pictures, average decode %"PRId64" us, "
+                 "filter %"PRId64" us, encode %"PRId64" us",
+                 id->stats.i_pictures,
+                 US_FROM_VLC_TICK( id->stats.decode ) / id->stats.i_pictures,
+                 US_FROM_VLC_TICK( id->stats.filter ) / id->stats.i_pictures,
+                 US_FROM_VLC_TICK( id->stats.encode ) / id->stats.i_pictures );
+
     /* Close encoder */
     transcode_encoder_close( id->encoder );
     transcode_encoder_delete( id->encoder );
@@ -514,15 +749,189 @@ static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic
     return p_pic;
 }
 
-static void tag_last_block_with_flag( block_t **out, int i_flag )
+static void transcode_video_filter_encode( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id,
+                                          picture_t *p_pic, block_t **out )
 {
-    block_t *p_last = *out;
-    if( p_last )
+    vlc_tick_t i_start = vlc_tick_now();
+    vlc_tick_t i_encode = 0;
+
+    /* Run the filter and output chains; first with the picture,
+     * and then with NULL as many times as we need until they
+     * stop outputting frames.
+     */
+    for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
     {
-        while( p_last->p_next )
-            p_last = p_last->p_next;
-        p_last->i_flags |= i_flag;
+        /* Run filter chain */
+        filter_chain_t * primary_chains[] = { id->p_f_chain,
+                                              id->p_conv_nonstatic,
+                                              id->p_conv_static };
+        for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
+        {
+            if( !primary_chains[i] )
+                continue;
+            p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
+        }
+
+        if( !p_in )
+            break;
+
+        for ( ;; p_in = NULL /* drain second time */ )
+        {
+            /* Run user specified filter chain */
+            filter_chain_t * secondary_chains[] = { id->p_uf_chain,
+                                                    id->p_final_conv_static };
+            for( size_t i=0; p_in && i<ARRAY_SIZE(secondary_chains); i++ )
+            {
+                if( !secondary_chains[i] )
+                    continue;
+                p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
+            }
+
+            if( !p_in )
+                break;
+
+            /* Blend subpictures */
+            p_in = RenderSubpictures( id, p_in );
+
+            if( p_in )
+            {
+                vlc_tick_t i_encode_start = vlc_tick_now();
+                if( id->i_rungs )
+                    transcode_video_ladder_encode( p_stream, id, p_in );
+                block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
+                i_encode += vlc_tick_now() - i_encode_start;
+                if( p_encoded )
+                    block_ChainAppend( out, p_encoded );
+                picture_Release( p_in );
+            }
+        }
+    }
+
+    id->stats.encode += i_encode;
+    id->stats.filter += vlc_tick_now() - i_start - i_encode;
+    id->stats.i_pictures++;
+}
+
+struct transcode_filter_stage
+{
+    sout_stream_t  *p_stream;
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;    /* picture queued or stop requested */
+    vlc_cond_t      done;    /* room in the queue or stage went idle */
+    picture_t      *p_first;
+    picture_t     **pp_last;
+    unsigned        i_pics;
+    unsigned        i_max;
+    bool            b_busy;
+    bool            b_stop;
+    block_t        *p_out;
+};
+
+static void *FilterStageThread( void *data )
+{
+    sout_stream_id_sys_t *id = data;
+    struct transcode_filter_stage *p_stage = id->p_filter_stage;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &p_stage->lock );
+    for( ;; )
+    {
+        while( !p_stage->b_stop && p_stage->p_first == NULL )
+            vlc_cond_wait( &p_stage->wait, &p_stage->lock );
+
+        picture_t *p_pic = p_stage->p_first;
+        if( p_pic == NULL )
+            break;
+        p_stage->p_first = p_pic->p_next;
+        if( p_stage->p_first == NULL )
+            p_stage->pp_last = &p_stage->p_first;
+        p_pic->p_next = NULL;
+        p_stage->i_pics--;
+        p_stage->b_busy = true;
+        vlc_cond_signal( &p_stage->done );
+        vlc_mutex_unlock( &p_stage->lock );
+
+        block_t *p_out = NULL;
+        transcode_video_filter_encode( p_stage->p_stream, id, p_pic, &p_out );
+
+        vlc_mutex_lock( &p_stage->lock );
+        block_ChainAppend( &p_stage->p_out, p_out );
+        p_stage->b_busy = false;
+        vlc_cond_signal( &p_stage->done );
+    }
+    vlc_mutex_unlock( &p_stage->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+static void FilterStagePush( struct transcode_filter_stage *p_stage,
+                             picture_t *p_pic )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    while( p_stage->i_pics >= p_stage->i_max )
+        vlc_cond_wait( &p_stage->done, &p_stage->lock );
+    *p_stage->pp_last = p_pic;
+    p_stage->pp_last = &p_pic->p_next;
+    p_stage->i_pics++;
+    vlc_cond_signal( &p_stage->wait );
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+/* Picks up the stage output, after all queued pictures when b_wait is set,
+ * as needed before touching the filters or the encoder */
+static void FilterStageCollect( struct transcode_filter_stage *p_stage,
+                                bool b_wait, block_t **out )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    while( b_wait && (p_stage->p_first || p_stage->b_busy) )
+        vlc_cond_wait( &p_stage->done, &p_stage->lock );
+    block_ChainAppend( out, p_stage->p_out );
+    p_stage->p_out = NULL;
+    vlc_mutex_unlock( &p_stage->lock );
+}
+
+static int FilterStageStart( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                             unsigned i_max, int i_priority )
+{
+    struct transcode_filter_stage *p_stage = malloc( sizeof(*p_stage) );
+    if( !p_stage )
+        return VLC_ENOMEM;
+
+    vlc_mutex_init( &p_stage->lock );
+    vlc_cond_init( &p_stage->wait );
+    vlc_cond_init( &p_stage->done );
+    p_stage->p_first = NULL;
+    p_stage->pp_last = &p_stage->p_first;
+    p_stage->i_pics = 0;
+    p_stage->i_max = __MAX( i_max, 1 );
+    p_stage->b_busy = false;
+    p_stage->b_stop = false;
+    p_stage->p_out = NULL;
+    p_stage->p_stream = p_stream;
+
+    id->p_filter_stage = p_stage;
+    if( vlc_clone( &p_stage->thread, FilterStageThread, id, i_priority ) )
+    {
+        id->p_filter_stage = NULL;
+        free( p_stage );
+        return VLC_EGENERIC;
     }
+    return VLC_SUCCESS;
+}
+
+static void FilterStageStop( struct transcode_filter_stage *p_stage )
+{
+    vlc_mutex_lock( &p_stage->lock );
+    p_stage->b_stop = true;
+    vlc_cond_signal( &p_stage->wait );
+    vlc_mutex_unlock( &p_stage->lock );
+    vlc_join( p_stage->thread, NULL );
+
+    block_ChainRelease( p_stage->p_out );
+    free( p_stage );
 }
 
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
@@ -532,7 +941,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
     bool b_eos = in && (in->i_flags & BLOCK_FLAG_END_OF_SEQUENCE);
 
+    vlc_tick_t i_decode_start = vlc_tick_now();
     int ret = id->p_decoder->pf_decode( id->p_decoder, in );
+    id->stats.decode += vlc_tick_now() - i_decode_start;
     if( ret != VLCDEC_SUCCESS )
         return VLC_EGENERIC;
 
@@ -556,6 +967,10 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         if( p_pic && ( unlikely(!transcode_encoder_opened(id->encoder)) ||
               !video_format_IsSimilar( &id->decoder_out.video, &p_pic->format ) ) )
         {
+            /* Let the pending pictures go through the current filters */
+            if( id->p_filter_stage )
+                FilterStageCollect( id->p_filter_stage, true, out );
+
             if( !transcode_encoder_opened(id->encoder) ) /* Configure Encoder input/output */
             {
                 assert( !id->p_f_chain && !id->p_uf_chain );
@@ -656,59 +1071,23 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                    (char *) &id->p_enccfg->i_codec );
                 goto error;
             }
-        }
 
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
-        {
-            /* Run filter chain */
-            filter_chain_t * primary_chains[] = { id->p_f_chain,
-                                                  id->p_conv_nonstatic,
-                                                  id->p_conv_static };
-            for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
-            {
-                if( !primary_chains[i] )
-                    continue;
-                p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
-            }
-
-            if( !p_in )
-                break;
-
-            for ( ;; p_in = NULL /* drain second time */ )
-            {
-                /* Run user specified filter chain */
-                filter_chain_t * secondary_chains[] = { id->p_uf_chain,
-                                                        id->p_final_conv_static };
-                for( size_t i=0; p_in && i<ARRAY_SIZE(secondary_chains); i++ )
-                {
-                    if( !secondary_chains[i] )
-                        continue;
-                    p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
-                }
-
-                if( !p_in )
-                    break;
-
-                /* Blend subpictures */
-                p_in = RenderSubpictures( id, p_in );
-
-                if( p_in )
-                {
-                    block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
-                    if( p_encoded )
-                        block_ChainAppend( out, p_encoded );
-                    picture_Release( p_in );
-                }
-            }
+            if( id->i_rungs )
+                transcode_video_ladder_open( p_stream, id );
         }
 
+        if( id->p_filter_stage && p_pic )
+            FilterStagePush( id->p_filter_stage, p_pic );
+        else if( p_pic )
+            transcode_video_filter_encode( p_stream, id, p_pic, out );
+
         if( b_eos )
         {
             msg_Info( p_stream, "Drain/restart on EOS" );
+            if( id->p_filter_stage )
+                FilterStageCollect( id->p_filter_stage, true, out );
+            if( id->i_rungs )
+                transcode_video_ladder_output( p_stream, id, false, true );
             if( transcode_encoder_drain( id->encoder, out ) != VLC_SUCCESS )
                 goto error;
             transcode_encoder_close( id->encoder );
@@ -729,7 +1108,12 @@ error:
         id->b_error = true;
     } while( p_pics );
 
-    if( id->p_enccfg->video.threads.i_count >= 1 )
+    if( id->p_filter_stage )
+        FilterStageCollect( id->p_filter_stage,
+                            in == NULL && !id->b_error, out );
+
+    if( id->p_enccfg->video.threads.i_count >= 1 ||
+        id->p_enccfg->video.chunks.i_count > 1 )
     {
         /* Pick up any return data the encoder thread wants to output. */
         block_ChainAppend( out, transcode_encoder_get_output_async( id->encoder ) );
@@ -745,6 +1129,10 @@ error:
             msg_Warn( p_stream, "Flushing failed");
     }
 
+    if( id->i_rungs )
+        transcode_video_ladder_output( p_stream, id,
+                                       unlikely( !id->b_error && in == NULL ), false );
+
     if( b_eos )
         tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
 
@@ -70,6 +70,10 @@
 #include "freetype.h"
 #include "text_layout.h"
 
+/* Memory limits of the layout caches */
+#define GLYPH_CACHE_SIZE   (4 * 1024 * 1024)
+#define SHAPING_CACHE_SIZE (512 * 1024)
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -1433,6 +1437,10 @@ static int Create( vlc_object_t *p_this )
     vlc_dictionary_init( &p_sys->family_map, 50 );
     vlc_dictionary_init( &p_sys->fallback_map, 20 );
 
+    /* Caches of the text layout */
+    LRU_Init( &p_sys->glyph_cache, 256, GLYPH_CACHE_SIZE, FreeCachedGlyph );
+    LRU_Init( &p_sys->shaping_cache, 64, SHAPING_CACHE_SIZE, free );
+
     p_sys->i_scale = 100;
 
     /* default style to apply to uncomplete segmeents styles */
@@ -1553,6 +1561,14 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    /* Layout caches */
+    msg_Dbg( p_filter, "glyph cache: %u hit(s), %u miss(es), shaping cache: "
+             "%u hit(s), %u miss(es)",
+             p_sys->glyph_cache.i_hits, p_sys->glyph_cache.i_misses,
+             p_sys->shaping_cache.i_hits, p_sys->shaping_cache.i_misses );
+    LRU_Clean( &p_sys->glyph_cache );
+    LRU_Clean( &p_sys->shaping_cache );
+
     /* Text styles */
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
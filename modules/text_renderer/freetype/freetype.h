@@ -40,6 +40,7 @@
 
 #include <vlc_text_style.h>                             /* text_style_t */
 #include <vlc_arrays.h>                                 /* vlc_dictionary_t */
+#include "lru.h"                                        /* lru_cache_t */
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -110,6 +111,12 @@ typedef struct
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /** Loaded glyphs, by face, glyph index, style and outline */
+    lru_cache_t       glyph_cache;
+
+    /** HarfBuzz shaping results, by face, script, direction and text */
+    lru_cache_t       shaping_cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
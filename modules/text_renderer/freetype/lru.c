@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * lru.c : Least recently used cache for the text renderer
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include "lru.h"
+
+typedef struct
+{
+    struct vlc_list node;
+    char           *psz_key;
+    void           *p_value;
+    size_t          i_cost;
+} lru_entry_t;
+
+void LRU_Init( lru_cache_t *p_cache, int i_buckets, size_t i_max_cost,
+               void ( *pf_free )( void * ) )
+{
+    vlc_dictionary_init( &p_cache->map, i_buckets );
+    vlc_list_init( &p_cache->entries );
+    p_cache->i_cost = 0;
+    p_cache->i_max_cost = i_max_cost;
+    p_cache->pf_free = pf_free;
+    p_cache->i_hits = 0;
+    p_cache->i_misses = 0;
+}
+
+static void DeleteEntry( lru_cache_t *p_cache, lru_entry_t *p_entry )
+{
+    vlc_list_remove( &p_entry->node );
+    p_cache->i_cost -= p_entry->i_cost;
+    p_cache->pf_free( p_entry->p_value );
+    free( p_entry->psz_key );
+    free( p_entry );
+}
+
+void LRU_Clean( lru_cache_t *p_cache )
+{
+    lru_entry_t *p_entry;
+
+    vlc_dictionary_clear( &p_cache->map, NULL, NULL );
+    vlc_list_foreach( p_entry, &p_cache->entries, node )
+        DeleteEntry( p_cache, p_entry );
+    assert( p_cache->i_cost == 0 );
+}
+
+void *LRU_Get( lru_cache_t *p_cache, const char *psz_key )
+{
+    lru_entry_t *p_entry = vlc_dictionary_value_for_key( &p_cache->map, psz_key );
+    if( p_entry == kVLCDictionaryNotFound )
+    {
+        p_cache->i_misses++;
+        return NULL;
+    }
+
+    p_cache->i_hits++;
+    vlc_list_remove( &p_entry->node );
+    vlc_list_prepend( &p_entry->node, &p_cache->entries );
+    return p_entry->p_value;
+}
+
+int LRU_Put( lru_cache_t *p_cache, const char *psz_key, void *p_value, size_t i_cost )
+{
+    lru_entry_t *p_entry = malloc( sizeof( *p_entry ) );
+    if( unlikely( !p_entry ) )
+    {
+        p_cache->pf_free( p_value );
+        return VLC_ENOMEM;
+    }
+    p_entry->psz_key = strdup( psz_key );
+    if( unlikely( !p_entry->psz_key ) )
+    {
+        free( p_entry );
+        p_cache->pf_free( p_value );
+        return VLC_ENOMEM;
+    }
+    p_entry->p_value = p_value;
+    p_entry->i_cost = i_cost;
+
+    /* Replace a previous value, so that its entry is not leaked */
+    lru_entry_t *p_old = vlc_dictionary_value_for_key( &p_cache->map, psz_key );
+    if( p_old != kVLCDictionaryNotFound )
+    {
+        vlc_dictionary_remove_value_for_key( &p_cache->map, psz_key, NULL, NULL );
+        DeleteEntry( p_cache, p_old );
+    }
+
+    vlc_dictionary_insert( &p_cache->map, psz_key, p_entry );
+    vlc_list_prepend( &p_entry->node, &p_cache->entries );
+    p_cache->i_cost += i_cost;
+
+    while( p_cache->i_cost > p_cache->i_max_cost )
+    {
+        lru_entry_t *p_last = vlc_list_last_entry_or_null( &p_cache->entries,
+                                                           lru_entry_t, node );
+        if( p_last == p_entry )
+            break;
+        vlc_dictionary_remove_value_for_key( &p_cache->map, p_last->psz_key,
+                                             NULL, NULL );
+        DeleteEntry( p_cache, p_last );
+    }
+    return VLC_SUCCESS;
+}
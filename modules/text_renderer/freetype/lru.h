@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * lru.h : Least recently used cache for the text renderer
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FREETYPE_LRU_H
+#define VLC_FREETYPE_LRU_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Least recently used cache, bounded by the cost of its values
+ */
+
+#include <vlc_arrays.h>
+#include <vlc_list.h>
+
+typedef struct
+{
+    vlc_dictionary_t map;     /**< key -> lru_entry_t */
+    struct vlc_list  entries; /**< most recently used first */
+    size_t           i_cost;
+    size_t           i_max_cost;
+    void          ( *pf_free )( void *p_value );
+
+    unsigned         i_hits;
+    unsigned         i_misses;
+} lru_cache_t;
+
+void  LRU_Init( lru_cache_t *, int i_buckets, size_t i_max_cost,
+                void ( *pf_free )( void * ) );
+void  LRU_Clean( lru_cache_t * );
+
+/**
+ * Look a value up and mark it as the most recently used.
+ * The value stays owned by the cache.
+ *
+ * \return the value or NULL if the key is not cached
+ */
+void *LRU_Get( lru_cache_t *, const char *psz_key );
+
+/**
+ * Insert a value the cache takes ownership of.
+ * Least recently used values are dropped to stay below the maximum cost,
+ * except the inserted one.
+ *
+ * \return VLC_SUCCESS, or VLC_ENOMEM if the value was freed
+ */
+int   LRU_Put( lru_cache_t *, const char *psz_key, void *p_value, size_t i_cost );
+
+/** @} */
+
+#endif
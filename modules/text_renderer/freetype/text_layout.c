@@ -41,6 +41,7 @@
 #include <vlc_common.h>
 #include <vlc_filter.h>
 #include <vlc_text_style.h>
+#include <vlc_memstream.h>
 
 /* Freetype */
 #include <ft2build.h>
@@ -112,6 +113,7 @@ typedef struct run_desc_t
     hb_glyph_info_t            *p_glyph_infos;
     hb_glyph_position_t        *p_glyph_positions;
     unsigned int                i_glyph_count;
+    struct shaped_run_t        *p_shaped; /* copy of a cached shaping */
 #endif
 
 } run_desc_t;
@@ -717,6 +719,62 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
 }
 
 #ifdef HAVE_HARFBUZZ
+/**
+ * Shaping result of a run, in a single allocation
+ */
+typedef struct shaped_run_t
+{
+    unsigned int         i_count;
+    hb_glyph_info_t     *p_infos;
+    hb_glyph_position_t *p_positions;
+} shaped_run_t;
+
+/* Longer runs are not worth caching, they are rarely repeated */
+#define SHAPING_CACHE_MAX_RUN 512
+
+static size_t ShapedRunSize( unsigned int i_count )
+{
+    return sizeof( shaped_run_t )
+         + i_count * ( sizeof( hb_glyph_info_t ) + sizeof( hb_glyph_position_t ) );
+}
+
+static shaped_run_t *NewShapedRun( unsigned int i_count,
+                                   const hb_glyph_info_t *p_infos,
+                                   const hb_glyph_position_t *p_positions )
+{
+    shaped_run_t *p_shaped = malloc( ShapedRunSize( i_count ) );
+    if( unlikely( !p_shaped ) )
+        return NULL;
+
+    p_shaped->i_count = i_count;
+    p_shaped->p_infos = (hb_glyph_info_t *) &p_shaped[1];
+    p_shaped->p_positions = (hb_glyph_position_t *) &p_shaped->p_infos[i_count];
+    memcpy( p_shaped->p_infos, p_infos, i_count * sizeof( *p_infos ) );
+    memcpy( p_shaped->p_positions, p_positions, i_count * sizeof( *p_positions ) );
+    return p_shaped;
+}
+
+/**
+ * The face identifies the font file and size, the codepoints are the run text
+ */
+static char *ShapedRunKey( const paragraph_t *p_paragraph, const run_desc_t *p_run )
+{
+    int i_count = p_run->i_end_offset - p_run->i_start_offset;
+    if( i_count > SHAPING_CACHE_MAX_RUN )
+        return NULL;
+
+    struct vlc_memstream stream;
+    vlc_memstream_open( &stream );
+    vlc_memstream_printf( &stream, "%p %d %d:", (void *) p_run->p_face,
+                          (int) p_run->script, (int) p_run->direction );
+    for( int i = p_run->i_start_offset; i < p_run->i_end_offset; ++i )
+        vlc_memstream_printf( &stream, "%x,",
+                              (unsigned) p_paragraph->p_code_points[ i ] );
+    if( vlc_memstream_close( &stream ) )
+        return NULL;
+    return stream.ptr;
+}
+
 /**
  * Shape an itemized paragraph using HarfBuzz.
  * This is where the glyphs of complex scripts get their positions
@@ -732,6 +790,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     filter_sys_t *p_sys = p_filter->p_sys;
     int i_total_glyphs = 0;
     int i_ret = VLC_EGENERIC;
+    char *psz_key = NULL;
 
     if( p_paragraph->i_size <= 0 || p_paragraph->i_runs_count <= 0 )
     {
@@ -770,6 +829,28 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        /* Karaoke and scrolling texts shape the same runs again and again */
+        psz_key = ShapedRunKey( p_paragraph, p_run );
+        const shaped_run_t *p_cached =
+            psz_key ? LRU_Get( &p_sys->shaping_cache, psz_key ) : NULL;
+        if( p_cached )
+        {
+            free( psz_key );
+            psz_key = NULL;
+            p_run->p_shaped = NewShapedRun( p_cached->i_count, p_cached->p_infos,
+                                            p_cached->p_positions );
+            if( !p_run->p_shaped )
+            {
+                i_ret = VLC_ENOMEM;
+                goto error;
+            }
+            p_run->p_glyph_infos = p_run->p_shaped->p_infos;
+            p_run->p_glyph_positions = p_run->p_shaped->p_positions;
+            p_run->i_glyph_count = p_run->p_shaped->i_count;
+            i_total_glyphs += p_run->i_glyph_count;
+            continue;
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
@@ -812,6 +893,18 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             goto error;
         }
 
+        if( psz_key )
+        {
+            shaped_run_t *p_shaped = NewShapedRun( p_run->i_glyph_count,
+                                                   p_run->p_glyph_infos,
+                                                   p_run->p_glyph_positions );
+            if( p_shaped )
+                LRU_Put( &p_sys->shaping_cache, psz_key, p_shaped,
+                         ShapedRunSize( p_shaped->i_count ) + strlen( psz_key ) );
+            free( psz_key );
+            psz_key = NULL;
+        }
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -883,8 +976,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -892,12 +988,14 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     return VLC_SUCCESS;
 
 error:
+    free( psz_key );
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
         if( p_paragraph->p_runs[ i ].p_hb_font )
             hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
         if( p_paragraph->p_runs[ i ].p_buffer )
             hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
 
     if( p_new_paragraph )
@@ -997,6 +1095,106 @@ static int ZeroNsmAdvance( paragraph_t *p_paragraph )
 #endif
 #endif
 
+/**
+ * Loaded glyph, with its outline, as cached for a face, style and outline
+ * thickness
+ */
+typedef struct
+{
+    FT_Glyph  p_glyph;
+    FT_Glyph  p_outline;
+    FT_Vector advance;
+} cached_glyph_t;
+
+void FreeCachedGlyph( void *p_value )
+{
+    cached_glyph_t *p_cached = p_value;
+
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+static size_t GlyphCost( FT_Glyph p_glyph )
+{
+    if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph) p_glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph) p_glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * (size_t) abs( p_bitmap->pitch );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+/**
+ * Get a glyph loaded with the style and outline, from the cache or from the
+ * face. The glyph stays owned by the cache.
+ */
+static const cached_glyph_t *LoadCachedGlyph( filter_t *p_filter, FT_Face p_face,
+                                              int i_glyph_index,
+                                              const text_style_t *p_style,
+                                              int i_outline_radius )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    char psz_key[64];
+
+    snprintf( psz_key, sizeof( psz_key ), "%p %d %x %d", (void *) p_face,
+              i_glyph_index,
+              p_style->i_style_flags & ( STYLE_BOLD | STYLE_ITALIC ),
+              i_outline_radius );
+
+    cached_glyph_t *p_cached = LRU_Get( &p_sys->glyph_cache, psz_key );
+    if( p_cached )
+        return p_cached;
+
+    if( FT_Load_Glyph( p_face, i_glyph_index,
+                       FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+     && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+        return NULL;
+
+    if( ( p_style->i_style_flags & STYLE_BOLD )
+          && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+        FT_GlyphSlot_Embolden( p_face->glyph );
+    if( ( p_style->i_style_flags & STYLE_ITALIC )
+          && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+        FT_GlyphSlot_Oblique( p_face->glyph );
+
+    p_cached = malloc( sizeof( *p_cached ) );
+    if( unlikely( !p_cached ) )
+        return NULL;
+
+    if( FT_Get_Glyph( p_face->glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return NULL;
+    }
+    p_cached->advance = p_face->glyph->advance;
+
+    size_t i_cost = sizeof( *p_cached ) + GlyphCost( p_cached->p_glyph );
+    p_cached->p_outline = NULL;
+    if( i_outline_radius >= 0 )
+    {
+        p_cached->p_outline = p_cached->p_glyph;
+        if( FT_Glyph_StrokeBorder( &p_cached->p_outline,
+                                   p_sys->p_stroker, 0, 0 ) )
+            p_cached->p_outline = NULL;
+        else
+            i_cost += GlyphCost( p_cached->p_outline );
+    }
+
+    if( LRU_Put( &p_sys->glyph_cache, psz_key, p_cached, i_cost ) )
+        return NULL;
+    return p_cached;
+}
+
 /**
  * Load the glyphs of a paragraph. When shaping with HarfBuzz the glyph indices
  * have already been determined at this point, as well as the advance values.
@@ -1039,14 +1237,15 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_outline_radius = -1; /* no outline */
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_outline_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
-                            i_radius,
+                            i_outline_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
@@ -1101,30 +1300,22 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+            const cached_glyph_t *p_cached =
+                LoadCachedGlyph( p_filter, p_face, i_glyph_index,
+                                 p_style, i_outline_radius );
+            if( !p_cached )
                 SKIP_GLYPH( p_bitmaps )
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
-
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+            /* The layout transforms and renders its own copies */
+            if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
                 SKIP_GLYPH( p_bitmaps )
 
 #undef SKIP_GLYPH
 
-            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
-            }
+            p_bitmaps->p_outline = 0;
+            if( p_cached->p_outline
+             && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+                p_bitmaps->p_outline = 0;
 
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
@@ -1132,8 +1323,8 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = p_cached->advance.x;
+                p_bitmaps->i_y_advance = p_cached->advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
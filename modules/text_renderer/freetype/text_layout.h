@@ -61,6 +61,11 @@ struct line_desc_t
 };
 
 void FreeLines( line_desc_t *p_lines );
+
+/**
+ * Free a glyph of the glyph cache
+ */
+void FreeCachedGlyph( void *p_value );
 line_desc_t *NewLine( int i_count );
 
 /**
@@ -34,6 +34,14 @@
 #include <vlc_cpu.h>
 #include <assert.h>
 
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define CAN_COMPILE_NEON
+#endif
+
 #include "copy.h"
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
@@ -613,6 +621,334 @@ static void SSE_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
 #undef COPY64
 #endif /* CAN_COMPILE_SSE2 */
 
+#ifdef COPY_TEST_NOOPTIM
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
+# undef vlc_CPU_ARM_NEON
+# define vlc_CPU_ARM_NEON() (0)
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* The AVX2 versions only handle 8-bit planes without shift. Lines are copied
+ * directly to the destination: the streaming loads fetch whole 64 bytes
+ * lines from USWC memory, so the bounce through the cache is not needed. */
+#define AVX2_LOAD(aligned, p) ((aligned) \
+    ? _mm256_stream_load_si256((__m256i *)(p)) \
+    : _mm256_loadu_si256((const __m256i *)(p)))
+
+VLC_AVX2
+static void AVX2_CopyPlane(uint8_t *dst, size_t dst_pitch,
+                           const uint8_t *src, size_t src_pitch,
+                           unsigned height)
+{
+    const size_t copy_pitch = __MIN(src_pitch, dst_pitch);
+
+    _mm_mfence();
+    for (unsigned y = 0; y < height; y++)
+    {
+        const bool aligned = ((uintptr_t)src & 0x1f) == 0;
+        size_t x = 0;
+
+        for (; x + 63 < copy_pitch; x += 64)
+        {
+            __m256i a = AVX2_LOAD(aligned, &src[x]);
+            __m256i b = AVX2_LOAD(aligned, &src[x + 32]);
+            _mm256_storeu_si256((__m256i *)&dst[x], a);
+            _mm256_storeu_si256((__m256i *)&dst[x + 32], b);
+        }
+        if (x < copy_pitch)
+            memcpy(&dst[x], &src[x], copy_pitch - x);
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_mfence();
+}
+
+VLC_AVX2
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch, unsigned height)
+{
+    const size_t copy_pitch = __MIN(__MIN(src_pitch / 2, dstu_pitch), dstv_pitch);
+    /* Gathers U then V within each 128-bit lane */
+    const __m256i shuffle = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                             1, 3, 5, 7, 9, 11, 13, 15,
+                                             0, 2, 4, 6, 8, 10, 12, 14,
+                                             1, 3, 5, 7, 9, 11, 13, 15);
+
+    _mm_mfence();
+    for (unsigned y = 0; y < height; y++)
+    {
+        const bool aligned = ((uintptr_t)src & 0x1f) == 0;
+        size_t x = 0;
+
+        for (; x + 31 < copy_pitch; x += 32)
+        {
+            __m256i a = AVX2_LOAD(aligned, &src[2 * x]);
+            __m256i b = AVX2_LOAD(aligned, &src[2 * x + 32]);
+            /* u0-7 u8-15 | v0-7 v8-15, and the same for the next 16 pairs */
+            a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, shuffle), 0xd8);
+            b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, shuffle), 0xd8);
+            _mm256_storeu_si256((__m256i *)&dstu[x],
+                                _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)&dstv[x],
+                                _mm256_permute2x128_si256(a, b, 0x31));
+        }
+        for (; x < copy_pitch; x++)
+        {
+            dstu[x] = src[2 * x + 0];
+            dstv[x] = src[2 * x + 1];
+        }
+
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+    _mm_mfence();
+}
+
+VLC_AVX2
+static void AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned height)
+{
+    const size_t copy_pitch = __MIN(__MIN(dst_pitch / 2, srcu_pitch), srcv_pitch);
+
+    _mm_mfence();
+    for (unsigned y = 0; y < height; y++)
+    {
+        const bool aligned = (((uintptr_t)srcu | (uintptr_t)srcv) & 0x1f) == 0;
+        size_t x = 0;
+
+        for (; x + 31 < copy_pitch; x += 32)
+        {
+            __m256i u = AVX2_LOAD(aligned, &srcu[x]);
+            __m256i v = AVX2_LOAD(aligned, &srcv[x]);
+            /* pairs 0-7 16-23 and 8-15 24-31 */
+            __m256i lo = _mm256_unpacklo_epi8(u, v);
+            __m256i hi = _mm256_unpackhi_epi8(u, v);
+            _mm256_storeu_si256((__m256i *)&dst[2 * x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&dst[2 * x + 32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+        for (; x < copy_pitch; x++)
+        {
+            dst[2 * x + 0] = srcu[x];
+            dst[2 * x + 1] = srcv[x];
+        }
+
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst  += dst_pitch;
+    }
+    _mm_mfence();
+}
+#undef AVX2_LOAD
+
+static void AVX2_Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
+                                const size_t src_pitch[static 3],
+                                unsigned height)
+{
+    for (unsigned n = 0; n < 3; n++)
+    {
+        const unsigned d = n > 0 ? 2 : 1;
+        AVX2_CopyPlane(dst->p[n].p_pixels, dst->p[n].i_pitch,
+                       src[n], src_pitch[n], (height+d-1)/d);
+    }
+}
+
+static void AVX2_Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
+                                  const size_t src_pitch[static 2],
+                                  unsigned height)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                   src[0], src_pitch[0], height);
+    AVX2_CopyPlane(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                   src[1], src_pitch[1], (height+1) / 2);
+}
+
+static void AVX2_Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                                 const size_t src_pitch[static 2],
+                                 unsigned height)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                   src[0], src_pitch[0], height);
+    AVX2_SplitUV(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                 dst->p[2].p_pixels, dst->p[2].i_pitch,
+                 src[1], src_pitch[1], (height+1) / 2);
+}
+
+static void AVX2_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                                 const size_t src_pitch[static 3],
+                                 unsigned height)
+{
+    AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                   src[0], src_pitch[0], height);
+    AVX2_InterleaveUV(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                      src[U_PLANE], src_pitch[U_PLANE],
+                      src[V_PLANE], src_pitch[V_PLANE], (height+1) / 2);
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+#ifdef CAN_COMPILE_NEON
+/* The 16-bit versions shift with vshlq, which shifts right for negative
+ * counts: bitshift is the opposite of its count. */
+static void NEON_CopyPlane16(uint8_t *dst, size_t dst_pitch,
+                             const uint8_t *src, size_t src_pitch,
+                             unsigned height, int bitshift)
+{
+    const size_t copy_pitch = __MIN(src_pitch, dst_pitch) / 2;
+    const int16x8_t shift = vdupq_n_s16(-bitshift);
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        const uint16_t *src16 = (const uint16_t *) src;
+        uint16_t *dst16 = (uint16_t *) dst;
+        size_t x = 0;
+
+        for (; x + 7 < copy_pitch; x += 8)
+            vst1q_u16(&dst16[x], vshlq_u16(vld1q_u16(&src16[x]), shift));
+        for (; x < copy_pitch; x++)
+            dst16[x] = bitshift > 0 ? src16[x] >> bitshift
+                                    : src16[x] << -bitshift;
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+}
+
+static void NEON_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch, unsigned height)
+{
+    const size_t copy_pitch = __MIN(__MIN(src_pitch / 2, dstu_pitch), dstv_pitch);
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        size_t x = 0;
+
+        for (; x + 15 < copy_pitch; x += 16)
+        {
+            uint8x16x2_t uv = vld2q_u8(&src[2 * x]);
+            vst1q_u8(&dstu[x], uv.val[0]);
+            vst1q_u8(&dstv[x], uv.val[1]);
+        }
+        for (; x < copy_pitch; x++)
+        {
+            dstu[x] = src[2 * x + 0];
+            dstv[x] = src[2 * x + 1];
+        }
+
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+
+static void NEON_SplitUV16(uint8_t *dstu, size_t dstu_pitch,
+                           uint8_t *dstv, size_t dstv_pitch,
+                           const uint8_t *src, size_t src_pitch,
+                           unsigned height, int bitshift)
+{
+    const size_t copy_pitch = __MIN(__MIN(src_pitch / 4, dstu_pitch / 2),
+                                    dstv_pitch / 2);
+    const int16x8_t shift = vdupq_n_s16(-bitshift);
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        const uint16_t *src16 = (const uint16_t *) src;
+        uint16_t *dstu16 = (uint16_t *) dstu;
+        uint16_t *dstv16 = (uint16_t *) dstv;
+        size_t x = 0;
+
+        for (; x + 7 < copy_pitch; x += 8)
+        {
+            uint16x8x2_t uv = vld2q_u16(&src16[2 * x]);
+            vst1q_u16(&dstu16[x], vshlq_u16(uv.val[0], shift));
+            vst1q_u16(&dstv16[x], vshlq_u16(uv.val[1], shift));
+        }
+        for (; x < copy_pitch; x++)
+        {
+            const uint16_t u = src16[2 * x + 0], v = src16[2 * x + 1];
+            dstu16[x] = bitshift > 0 ? u >> bitshift : u << -bitshift;
+            dstv16[x] = bitshift > 0 ? v >> bitshift : v << -bitshift;
+        }
+
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+
+static void NEON_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned height)
+{
+    const size_t copy_pitch = __MIN(__MIN(dst_pitch / 2, srcu_pitch), srcv_pitch);
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        size_t x = 0;
+
+        for (; x + 15 < copy_pitch; x += 16)
+        {
+            uint8x16x2_t uv = { { vld1q_u8(&srcu[x]), vld1q_u8(&srcv[x]) } };
+            vst2q_u8(&dst[2 * x], uv);
+        }
+        for (; x < copy_pitch; x++)
+        {
+            dst[2 * x + 0] = srcu[x];
+            dst[2 * x + 1] = srcv[x];
+        }
+
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst  += dst_pitch;
+    }
+}
+
+static void NEON_InterleaveUV16(uint8_t *dst, size_t dst_pitch,
+                                const uint8_t *srcu, size_t srcu_pitch,
+                                const uint8_t *srcv, size_t srcv_pitch,
+                                unsigned height, int bitshift)
+{
+    const size_t copy_pitch = __MIN(__MIN(dst_pitch / 4, srcu_pitch / 2),
+                                    srcv_pitch / 2);
+    const int16x8_t shift = vdupq_n_s16(-bitshift);
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        const uint16_t *srcu16 = (const uint16_t *) srcu;
+        const uint16_t *srcv16 = (const uint16_t *) srcv;
+        uint16_t *dst16 = (uint16_t *) dst;
+        size_t x = 0;
+
+        for (; x + 7 < copy_pitch; x += 8)
+        {
+            uint16x8x2_t uv = { {
+                vshlq_u16(vld1q_u16(&srcu16[x]), shift),
+                vshlq_u16(vld1q_u16(&srcv16[x]), shift),
+            } };
+            vst2q_u16(&dst16[2 * x], uv);
+        }
+        for (; x < copy_pitch; x++)
+        {
+            const uint16_t u = srcu16[x], v = srcv16[x];
+            dst16[2 * x + 0] = bitshift > 0 ? u >> bitshift : u << -bitshift;
+            dst16[2 * x + 1] = bitshift > 0 ? v >> bitshift : v << -bitshift;
+        }
+
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst  += dst_pitch;
+    }
+}
+#endif /* CAN_COMPILE_NEON */
+
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
                       unsigned height, int bitshift)
@@ -652,6 +988,11 @@ void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
     assert(src); assert(src_pitch);
     assert(height);
 
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                              src, src_pitch, height);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE4_1())
         return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
@@ -668,6 +1009,10 @@ void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
                       const copy_cache_t *cache)
 {
     ASSERT_2PLANES;
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_SP(dst, src, src_pitch, height);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
@@ -745,6 +1090,10 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                      const copy_cache_t *cache)
 {
     ASSERT_2PLANES;
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_SP_to_P(dst, src, src_pitch, height);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
@@ -754,6 +1103,12 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
 
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height, 0);
+#ifdef CAN_COMPILE_NEON
+    if (vlc_CPU_ARM_NEON())
+        return NEON_SplitUV(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                            dst->p[2].p_pixels, dst->p[2].i_pitch,
+                            src[1], src_pitch[1], (height+1)/2);
+#endif
     SplitPlanes(dst->p[1].p_pixels, dst->p[1].i_pitch,
                 dst->p[2].p_pixels, dst->p[2].i_pitch,
                 src[1], src_pitch[1], (height+1)/2);
@@ -773,6 +1128,17 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
     VLC_UNUSED(cache);
 #endif
 
+#ifdef CAN_COMPILE_NEON
+    if (vlc_CPU_ARM_NEON())
+    {
+        NEON_CopyPlane16(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                         src[0], src_pitch[0], height, bitshift);
+        NEON_SplitUV16(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                       dst->p[2].p_pixels, dst->p[2].i_pitch,
+                       src[1], src_pitch[1], (height+1)/2, bitshift);
+        return;
+    }
+#endif
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height, bitshift);
     SplitPlanes16(dst->p[1].p_pixels, dst->p[1].i_pitch,
@@ -821,6 +1187,10 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
                      const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_SP(dst, src, src_pitch, height);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
@@ -830,6 +1200,13 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
 
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height, 0);
+#ifdef CAN_COMPILE_NEON
+    if (vlc_CPU_ARM_NEON())
+        return NEON_InterleaveUV(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                                 src[U_PLANE], src_pitch[U_PLANE],
+                                 src[V_PLANE], src_pitch[V_PLANE],
+                                 (height+1) / 2);
+#endif
 
     const unsigned copy_lines = (height+1) / 2;
     unsigned copy_pitch = src_pitch[1];
@@ -859,6 +1236,18 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     (void) cache;
 #endif
 
+#ifdef CAN_COMPILE_NEON
+    if (vlc_CPU_ARM_NEON())
+    {
+        NEON_CopyPlane16(dst->p[0].p_pixels, dst->p[0].i_pitch,
+                         src[0], src_pitch[0], height, bitshift);
+        NEON_InterleaveUV16(dst->p[1].p_pixels, dst->p[1].i_pitch,
+                            src[U_PLANE], src_pitch[U_PLANE],
+                            src[V_PLANE], src_pitch[V_PLANE],
+                            (height+1) / 2, bitshift);
+        return;
+    }
+#endif
     CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch,
               src[0], src_pitch[0], height, bitshift);
 
@@ -886,6 +1275,10 @@ void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
                     const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy420_P_to_P(dst, src, src_pitch, height);
+#endif
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_P(dst, src, src_pitch, height, cache);
@@ -1106,6 +1499,82 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     return picture_NewFromResource(fmt, &rsc);
 }
 
+#define BENCH_WIDTH    1920
+#define BENCH_HEIGHT   1080
+#define BENCH_DURATION VLC_TICK_FROM_MS(100)
+
+/* Reports the throughput of the conversions, from aligned pictures as the
+ * decoders provide them */
+static void bench(void)
+{
+    for (size_t i = 0; i < NB_CONVS; ++i)
+    {
+        const struct test_conv *conv = &convs[i];
+        const vlc_chroma_description_t *src_dsc =
+            vlc_fourcc_GetChromaDescription(conv->src_chroma);
+        assert(src_dsc);
+
+        video_format_t fmt;
+        video_format_Init(&fmt, 0);
+        video_format_Setup(&fmt, conv->src_chroma, BENCH_WIDTH, BENCH_HEIGHT,
+                           BENCH_WIDTH, BENCH_HEIGHT, 1, 1);
+        picture_t *src = picture_NewFromFormat(&fmt);
+        assert(src);
+        piccheck(src, src_dsc, true);
+
+        size_t bytes = 0;
+        for (int p = 0; p < src->i_planes; ++p)
+            bytes += src->p[p].i_visible_pitch * src->p[p].i_visible_lines;
+
+        copy_cache_t cache;
+        int ret = CopyInitCache(&cache, src->format.i_width
+                                * src_dsc->pixel_size);
+        assert(ret == VLC_SUCCESS);
+
+        const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                          src->p[U_PLANE].p_pixels,
+                                          src->p[V_PLANE].p_pixels };
+        const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                           src->p[U_PLANE].i_pitch,
+                                           src->p[V_PLANE].i_pitch };
+
+        for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+        {
+            const struct test_dst *test_dst = &conv->dsts[f];
+            fmt.i_chroma = test_dst->chroma;
+            picture_t *dst = picture_NewFromFormat(&fmt);
+            assert(dst);
+
+            unsigned frames = 0;
+            const vlc_tick_t start = vlc_tick_now();
+            vlc_tick_t elapsed;
+            do
+            {
+                if (test_dst->bitshift == 0)
+                    test_dst->conv(dst, src_planes, src_pitches,
+                                   BENCH_HEIGHT, &cache);
+                else
+                    test_dst->conv16(dst, src_planes, src_pitches,
+                                     BENCH_HEIGHT, test_dst->bitshift,
+                                     &cache);
+                frames++;
+                elapsed = vlc_tick_now() - start;
+            }
+            while (elapsed < BENCH_DURATION);
+
+            const double seconds = secf_from_vlc_tick(elapsed);
+            fprintf(stderr, "bench: %u x %u %4.4s -> %4.4s: %.0f frames/s, "
+                    "%.0f MiB/s\n", BENCH_WIDTH, BENCH_HEIGHT,
+                    (const char *) &src->format.i_chroma,
+                    (const char *) &dst->format.i_chroma,
+                    frames / seconds, frames * bytes / seconds / 1048576.);
+            picture_Release(dst);
+        }
+        picture_Release(src);
+        CopyCleanCache(&cache);
+    }
+}
+
 int main(void)
 {
     alarm(10);
@@ -1182,6 +1651,8 @@ int main(void)
             CopyCleanCache(&cache);
         }
     }
+
+    bench();
     return 0;
 }
 
@@ -21,10 +21,17 @@
  *****************************************************************************/
 #include <limits.h>
 
-#if !defined (SSE2) && !defined (MMX)
+#if !defined (SSE2) && !defined (MMX) && !defined (AVX2) && !defined (NEON)
 # define PLAIN
 #endif
 
+#if defined (AVX2)
+/** Narrowest picture converted, one block of I420_RGB_BLOCK pixels */
+# define I420_RGB_MIN_WIDTH 32
+#elif defined (NEON)
+# define I420_RGB_MIN_WIDTH 16
+#endif
+
 /** Number of entries in RGB palette/colormap */
 #define CMAP_RGB2_SIZE 256
 
@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * i420_rgb_avx2.h: AVX2 YUV transformation intrinsics
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The arithmetic is the one of the SSE2 conversion (i420_rgb_sse2.h), on 32
+ * pixels at once, so that both produce the same pixels.
+ *
+ * Each 128-bit lane of the registers holds half of the pixels: the even and
+ * odd pixels are interleaved within the lanes, and the lanes are reordered
+ * when storing.
+ */
+
+#include <immintrin.h>
+
+#define VLC_TARGET VLC_AVX2
+
+/* Number of pixels converted by each call */
+#define I420_RGB_BLOCK 32
+
+VLC_TARGET
+static inline void I420_RGB_YUV( const uint8_t *p_y, const uint8_t *p_u,
+                                 const uint8_t *p_v, __m256i *p_r,
+                                 __m256i *p_g, __m256i *p_b )
+{
+    const __m256i u = _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i *)p_u ) );
+    const __m256i v = _mm256_cvtepu8_epi16( _mm_loadu_si128( (__m128i *)p_v ) );
+    const __m256i y = _mm256_loadu_si256( (__m256i *)p_y );
+
+    /* Chroma contributions, one per pair of pixels */
+    const __m256i c128 = _mm256_set1_epi16( 0x0080 );
+    const __m256i cu = _mm256_slli_epi16( _mm256_subs_epi16( u, c128 ), 3 );
+    const __m256i cv = _mm256_slli_epi16( _mm256_subs_epi16( v, c128 ), 3 );
+    const __m256i cb = _mm256_mulhi_epi16( cu, _mm256_set1_epi16( 0x4093 ) );
+    const __m256i cr = _mm256_mulhi_epi16( cv, _mm256_set1_epi16( 0x3312 ) );
+    const __m256i cg = _mm256_adds_epi16(
+                _mm256_mulhi_epi16( cu, _mm256_set1_epi16( (short)0xf37d ) ),
+                _mm256_mulhi_epi16( cv, _mm256_set1_epi16( (short)0xe5fc ) ) );
+
+    /* Luma of the even and of the odd pixels */
+    const __m256i y16 = _mm256_subs_epu8( y, _mm256_set1_epi8( 0x10 ) );
+    const __m256i coef = _mm256_set1_epi16( 0x253f );
+    const __m256i ye = _mm256_mulhi_epi16( _mm256_slli_epi16(
+                _mm256_and_si256( y16, _mm256_set1_epi16( 0x00ff ) ), 3 ), coef );
+    const __m256i yo = _mm256_mulhi_epi16( _mm256_slli_epi16(
+                _mm256_srli_epi16( y16, 8 ), 3 ), coef );
+
+    /* Packed as 8 even then 8 odd pixels per lane, interleave them back */
+    const __m256i order = _mm256_setr_epi8( 0, 8, 1, 9, 2, 10, 3, 11,
+                                            4, 12, 5, 13, 6, 14, 7, 15,
+                                            0, 8, 1, 9, 2, 10, 3, 11,
+                                            4, 12, 5, 13, 6, 14, 7, 15 );
+    *p_r = _mm256_shuffle_epi8( _mm256_packus_epi16(
+                _mm256_adds_epi16( cr, ye ), _mm256_adds_epi16( cr, yo ) ), order );
+    *p_g = _mm256_shuffle_epi8( _mm256_packus_epi16(
+                _mm256_adds_epi16( cg, ye ), _mm256_adds_epi16( cg, yo ) ), order );
+    *p_b = _mm256_shuffle_epi8( _mm256_packus_epi16(
+                _mm256_adds_epi16( cb, ye ), _mm256_adds_epi16( cb, yo ) ), order );
+}
+
+/* lo holds the pixels 0-7 and 16-23, hi the pixels 8-15 and 24-31 */
+VLC_TARGET
+static inline void I420_RGB_Store16( uint16_t *p_buffer, __m256i lo, __m256i hi )
+{
+    _mm256_storeu_si256( (__m256i *)p_buffer,
+                         _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 16),
+                         _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+}
+
+/* Stores the bytes c0, c1, c2, c3 of each pixel, in memory order */
+VLC_TARGET
+static inline void I420_RGB_Store32( uint32_t *p_buffer, __m256i c0, __m256i c1,
+                                     __m256i c2, __m256i c3 )
+{
+    const __m256i lo01 = _mm256_unpacklo_epi8( c0, c1 );
+    const __m256i lo23 = _mm256_unpacklo_epi8( c2, c3 );
+    const __m256i hi01 = _mm256_unpackhi_epi8( c0, c1 );
+    const __m256i hi23 = _mm256_unpackhi_epi8( c2, c3 );
+
+    const __m256i p0 = _mm256_unpacklo_epi16( lo01, lo23 ); /* 0-3, 16-19 */
+    const __m256i p1 = _mm256_unpackhi_epi16( lo01, lo23 ); /* 4-7, 20-23 */
+    const __m256i p2 = _mm256_unpacklo_epi16( hi01, hi23 ); /* 8-11, 24-27 */
+    const __m256i p3 = _mm256_unpackhi_epi16( hi01, hi23 ); /* 12-15, 28-31 */
+
+    _mm256_storeu_si256( (__m256i *)p_buffer,
+                         _mm256_permute2x128_si256( p0, p1, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 8),
+                         _mm256_permute2x128_si256( p2, p3, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 16),
+                         _mm256_permute2x128_si256( p0, p1, 0x31 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 24),
+                         _mm256_permute2x128_si256( p2, p3, 0x31 ) );
+}
+
+VLC_TARGET
+static inline void I420_RGB_Block_R5G5B5( uint16_t *p_buffer,
+                                          const uint8_t *p_y,
+                                          const uint8_t *p_u,
+                                          const uint8_t *p_v )
+{
+    __m256i r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+
+    const __m256i mask = _mm256_set1_epi8( (char)0xf8 );
+    const __m256i zero = _mm256_setzero_si256();
+    b = _mm256_srli_epi16( _mm256_and_si256( b, mask ), 3 );
+    r = _mm256_srli_epi16( _mm256_and_si256( r, mask ), 1 );
+    g = _mm256_and_si256( g, mask );
+
+    I420_RGB_Store16( p_buffer,
+        _mm256_or_si256( _mm256_unpacklo_epi8( b, r ),
+                         _mm256_slli_epi16( _mm256_unpacklo_epi8( g, zero ), 2 ) ),
+        _mm256_or_si256( _mm256_unpackhi_epi8( b, r ),
+                         _mm256_slli_epi16( _mm256_unpackhi_epi8( g, zero ), 2 ) ) );
+}
+
+VLC_TARGET
+static inline void I420_RGB_Block_R5G6B5( uint16_t *p_buffer,
+                                          const uint8_t *p_y,
+                                          const uint8_t *p_u,
+                                          const uint8_t *p_v )
+{
+    __m256i r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+
+    const __m256i mask = _mm256_set1_epi8( (char)0xf8 );
+    const __m256i zero = _mm256_setzero_si256();
+    b = _mm256_srli_epi16( _mm256_and_si256( b, mask ), 3 );
+    r = _mm256_and_si256( r, mask );
+    g = _mm256_and_si256( g, _mm256_set1_epi8( (char)0xfc ) );
+
+    I420_RGB_Store16( p_buffer,
+        _mm256_or_si256( _mm256_unpacklo_epi8( b, r ),
+                         _mm256_slli_epi16( _mm256_unpacklo_epi8( g, zero ), 3 ) ),
+        _mm256_or_si256( _mm256_unpackhi_epi8( b, r ),
+                         _mm256_slli_epi16( _mm256_unpackhi_epi8( g, zero ), 3 ) ) );
+}
+
+VLC_TARGET
+static inline void I420_RGB_Block_A8R8G8B8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    __m256i r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, b, g, r, _mm256_setzero_si256() );
+}
+
+VLC_TARGET
+static inline void I420_RGB_Block_R8G8B8A8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    __m256i r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, _mm256_setzero_si256(), b, g, r );
+}
+
+VLC_TARGET
+static inline void I420_RGB_Block_B8G8R8A8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    __m256i r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, _mm256_setzero_si256(), r, g, b );
+}
+
+VLC_TARGET
+static inline void I420_RGB_Block_A8B8G8R8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    __m256i r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, r, g, b, _mm256_setzero_si256() );
+}
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * i420_rgb_neon.h: AArch64 NEON YUV transformation intrinsics
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The arithmetic is the one of the SSE2 conversion (i420_rgb_sse2.h), on 16
+ * pixels at once, so that both produce the same pixels. The 32-bit ARM
+ * conversions are in modules/arm_neon.
+ */
+
+#include <arm_neon.h>
+
+#define VLC_TARGET
+
+/* Number of pixels converted by each call */
+#define I420_RGB_BLOCK 16
+
+/* High half of the products, as _mm_mulhi_epi16() */
+static inline int16x8_t I420_RGB_MulHi( int16x8_t a, int16_t b )
+{
+    return vcombine_s16( vshrn_n_s32( vmull_n_s16( vget_low_s16( a ), b ), 16 ),
+                         vshrn_n_s32( vmull_n_s16( vget_high_s16( a ), b ), 16 ) );
+}
+
+static inline void I420_RGB_YUV( const uint8_t *p_y, const uint8_t *p_u,
+                                 const uint8_t *p_v, uint8x16_t *p_r,
+                                 uint8x16_t *p_g, uint8x16_t *p_b )
+{
+    const int16x8_t c128 = vdupq_n_s16( 128 );
+    const int16x8_t u = vreinterpretq_s16_u16( vmovl_u8( vld1_u8( p_u ) ) );
+    const int16x8_t v = vreinterpretq_s16_u16( vmovl_u8( vld1_u8( p_v ) ) );
+    /* Deinterleaved as even and odd pixels */
+    const uint8x8x2_t y = vld2_u8( p_y );
+
+    /* Chroma contributions, one per pair of pixels */
+    const int16x8_t cu = vshlq_n_s16( vqsubq_s16( u, c128 ), 3 );
+    const int16x8_t cv = vshlq_n_s16( vqsubq_s16( v, c128 ), 3 );
+    const int16x8_t cb = I420_RGB_MulHi( cu, 0x4093 );
+    const int16x8_t cr = I420_RGB_MulHi( cv, 0x3312 );
+    const int16x8_t cg = vqaddq_s16( I420_RGB_MulHi( cu, (int16_t)0xf37d ),
+                                     I420_RGB_MulHi( cv, (int16_t)0xe5fc ) );
+
+    const uint8x8_t c16 = vdup_n_u8( 0x10 );
+    const int16x8_t ye = I420_RGB_MulHi( vreinterpretq_s16_u16(
+                vshll_n_u8( vqsub_u8( y.val[0], c16 ), 3 ) ), 0x253f );
+    const int16x8_t yo = I420_RGB_MulHi( vreinterpretq_s16_u16(
+                vshll_n_u8( vqsub_u8( y.val[1], c16 ), 3 ) ), 0x253f );
+
+    const uint8x8x2_t r = vzip_u8( vqmovun_s16( vqaddq_s16( cr, ye ) ),
+                                   vqmovun_s16( vqaddq_s16( cr, yo ) ) );
+    const uint8x8x2_t g = vzip_u8( vqmovun_s16( vqaddq_s16( cg, ye ) ),
+                                   vqmovun_s16( vqaddq_s16( cg, yo ) ) );
+    const uint8x8x2_t b = vzip_u8( vqmovun_s16( vqaddq_s16( cb, ye ) ),
+                                   vqmovun_s16( vqaddq_s16( cb, yo ) ) );
+    *p_r = vcombine_u8( r.val[0], r.val[1] );
+    *p_g = vcombine_u8( g.val[0], g.val[1] );
+    *p_b = vcombine_u8( b.val[0], b.val[1] );
+}
+
+static inline void I420_RGB_Block_R5G5B5( uint16_t *p_buffer,
+                                          const uint8_t *p_y,
+                                          const uint8_t *p_u,
+                                          const uint8_t *p_v )
+{
+    uint8x16_t r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+
+    /* Insert the top bits of each component below the previous ones */
+    uint16x8_t lo = vshll_n_u8( vget_low_u8( r ), 7 );
+    uint16x8_t hi = vshll_n_u8( vget_high_u8( r ), 7 );
+    lo = vsriq_n_u16( lo, vshll_n_u8( vget_low_u8( g ), 8 ), 6 );
+    hi = vsriq_n_u16( hi, vshll_n_u8( vget_high_u8( g ), 8 ), 6 );
+    lo = vsriq_n_u16( lo, vshll_n_u8( vget_low_u8( b ), 8 ), 11 );
+    hi = vsriq_n_u16( hi, vshll_n_u8( vget_high_u8( b ), 8 ), 11 );
+    vst1q_u16( p_buffer, lo );
+    vst1q_u16( p_buffer + 8, hi );
+}
+
+static inline void I420_RGB_Block_R5G6B5( uint16_t *p_buffer,
+                                          const uint8_t *p_y,
+                                          const uint8_t *p_u,
+                                          const uint8_t *p_v )
+{
+    uint8x16_t r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+
+    uint16x8_t lo = vshll_n_u8( vget_low_u8( r ), 8 );
+    uint16x8_t hi = vshll_n_u8( vget_high_u8( r ), 8 );
+    lo = vsriq_n_u16( lo, vshll_n_u8( vget_low_u8( g ), 8 ), 5 );
+    hi = vsriq_n_u16( hi, vshll_n_u8( vget_high_u8( g ), 8 ), 5 );
+    lo = vsriq_n_u16( lo, vshll_n_u8( vget_low_u8( b ), 8 ), 11 );
+    hi = vsriq_n_u16( hi, vshll_n_u8( vget_high_u8( b ), 8 ), 11 );
+    vst1q_u16( p_buffer, lo );
+    vst1q_u16( p_buffer + 8, hi );
+}
+
+/* Stores the bytes c0, c1, c2, c3 of each pixel, in memory order */
+static inline void I420_RGB_Store32( uint32_t *p_buffer, uint8x16_t c0,
+                                     uint8x16_t c1, uint8x16_t c2,
+                                     uint8x16_t c3 )
+{
+    const uint8x16x4_t pixels = { { c0, c1, c2, c3 } };
+    vst4q_u8( (uint8_t *)p_buffer, pixels );
+}
+
+static inline void I420_RGB_Block_A8R8G8B8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    uint8x16_t r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, b, g, r, vdupq_n_u8( 0 ) );
+}
+
+static inline void I420_RGB_Block_R8G8B8A8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    uint8x16_t r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, vdupq_n_u8( 0 ), b, g, r );
+}
+
+static inline void I420_RGB_Block_B8G8R8A8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    uint8x16_t r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, vdupq_n_u8( 0 ), r, g, b );
+}
+
+static inline void I420_RGB_Block_A8B8G8R8( uint32_t *p_buffer,
+                                            const uint8_t *p_y,
+                                            const uint8_t *p_u,
+                                            const uint8_t *p_v )
+{
+    uint8x16_t r, g, b;
+    I420_RGB_YUV( p_y, p_u, p_v, &r, &g, &b );
+    I420_RGB_Store32( p_buffer, r, g, b, vdupq_n_u8( 0 ) );
+}
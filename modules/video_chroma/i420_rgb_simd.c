@@ -0,0 +1,484 @@
+/*****************************************************************************
+ * i420_rgb_simd.c : AVX2 and NEON YUV to bitmap RGB conversions for vlc
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#include "i420_rgb.h"
+#if defined (AVX2)
+# include "i420_rgb_avx2.h"
+#elif defined (NEON)
+# include "i420_rgb_neon.h"
+#endif
+
+static_assert( I420_RGB_BLOCK == I420_RGB_MIN_WIDTH,
+               "the line tail is converted over the previous pixels" );
+
+#ifndef I420_RGB_TEST
+/*****************************************************************************
+ * SetOffset: build offset array for conversion functions
+ *****************************************************************************
+ * This function will build an offset array used in later conversion functions.
+ * It will also set horizontal and vertical scaling indicators.
+ *****************************************************************************/
+static void SetOffset( int i_width, int i_height, int i_pic_width,
+                       int i_pic_height, bool *pb_hscale,
+                       unsigned int *pi_vscale, int *p_offset )
+{
+    /*
+     * Prepare horizontal offset array
+     */
+    if( i_pic_width - i_width == 0 )
+    {   /* No horizontal scaling: YUV conversion is done directly to picture */
+        *pb_hscale = 0;
+    }
+    else if( i_pic_width - i_width > 0 )
+    {   /* Prepare scaling array for horizontal extension */
+        int i_scale_count = i_pic_width;
+
+        *pb_hscale = 1;
+        for( int i_x = i_width; i_x--; )
+        {
+            while( (i_scale_count -= i_width) > 0 )
+            {
+                *p_offset++ = 0;
+            }
+            *p_offset++ = 1;
+            i_scale_count += i_pic_width;
+        }
+    }
+    else /* if( i_pic_width - i_width < 0 ) */
+    {   /* Prepare scaling array for horizontal reduction */
+        int i_scale_count = i_pic_width;
+
+        *pb_hscale = 1;
+        for( int i_x = i_pic_width; i_x--; )
+        {
+            *p_offset = 1;
+            while( (i_scale_count -= i_pic_width) > 0 )
+            {
+                *p_offset += 1;
+            }
+            p_offset++;
+            i_scale_count += i_width;
+        }
+    }
+
+    /*
+     * Set vertical scaling indicator
+     */
+    if( i_pic_height - i_height == 0 )
+        *pi_vscale = 0;
+    else if( i_pic_height - i_height > 0 )
+        *pi_vscale = 1;
+    else /* if( i_pic_height - i_height < 0 ) */
+        *pi_vscale = -1;
+}
+
+/*****************************************************************************
+ * I420_RGB_CONVERT: conversion function body
+ *****************************************************************************
+ * The lines are converted by blocks of I420_RGB_BLOCK pixels, the last block
+ * being moved back over the previous pixels when the width is not a multiple
+ * of it (Activate() refuses narrower pictures). TYPE is the pixel type, and
+ * BLOCK the block conversion function.
+ *****************************************************************************/
+#define I420_RGB_CONVERT( TYPE, BLOCK )                                       \
+    filter_sys_t *p_sys = p_filter->p_sys;                                    \
+                                                                              \
+    TYPE     *p_pic = (TYPE*)p_dest->p->p_pixels;                             \
+    uint8_t  *p_y   = p_src->Y_PIXELS;                                        \
+    uint8_t  *p_u   = p_src->U_PIXELS;                                        \
+    uint8_t  *p_v   = p_src->V_PIXELS;                                        \
+                                                                              \
+    bool  b_hscale;                         /* horizontal scaling type */     \
+    unsigned int i_vscale;                  /* vertical scaling type */       \
+    unsigned int i_x, i_y;                  /* horizontal and vertical indexes */ \
+                                                                              \
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset                \
+                           + p_filter->fmt_in.video.i_visible_width;          \
+    const unsigned i_height = p_filter->fmt_in.video.i_y_offset               \
+                            + p_filter->fmt_in.video.i_visible_height;        \
+    const int i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch; \
+    const int i_rewind = (-i_width) & (I420_RGB_BLOCK - 1);                   \
+    int         i_scale_count;                       /* scale modulo counter */ \
+    int         i_chroma_width = i_width / 2;                 /* chroma width */ \
+    TYPE *      p_pic_start;       /* beginning of the current line for copy */ \
+                                                                              \
+    /* Conversion buffer pointer */                                           \
+    TYPE *      p_buffer_start;                                               \
+    TYPE *      p_buffer;                                                     \
+                                                                              \
+    /* Offset array pointer */                                                \
+    int *       p_offset_start = p_sys->p_offset;                             \
+    int *       p_offset;                                                     \
+                                                                              \
+    const int i_source_margin = p_src->p[0].i_pitch                           \
+                                 - p_src->p[0].i_visible_pitch                \
+                                 - p_filter->fmt_in.video.i_x_offset;         \
+    const int i_source_margin_c = p_src->p[1].i_pitch                         \
+                                 - p_src->p[1].i_visible_pitch                \
+                                 - ( p_filter->fmt_in.video.i_x_offset / 2 ); \
+                                                                              \
+    SetOffset( i_width, i_height,                                             \
+               (p_filter->fmt_out.video.i_x_offset + p_filter->fmt_out.video.i_visible_width), \
+               (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height), \
+               &b_hscale, &i_vscale, p_offset_start );                        \
+                                                                              \
+    if(b_hscale &&                                                            \
+       AllocateOrGrow(&p_sys->p_buffer, &p_sys->i_buffer_size,                \
+                      i_width, p_sys->i_bytespp))                             \
+        return;                                                               \
+    else p_buffer_start = (TYPE*)p_sys->p_buffer;                             \
+                                                                              \
+    /*                                                                        \
+     * Perform conversion                                                     \
+     */                                                                       \
+    i_scale_count = ( i_vscale == 1 ) ?                                       \
+                    (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) : \
+                    i_height;                                                 \
+                                                                              \
+    for( i_y = 0; i_y < i_height; i_y++ )                                     \
+    {                                                                         \
+        p_pic_start = p_pic;                                                  \
+        p_buffer = b_hscale ? p_buffer_start : p_pic;                         \
+                                                                              \
+        for( i_x = i_width / I420_RGB_BLOCK; i_x--; )                         \
+        {                                                                     \
+            BLOCK( p_buffer, p_y, p_u, p_v );                                 \
+            p_y += I420_RGB_BLOCK;                                            \
+            p_u += I420_RGB_BLOCK / 2;                                        \
+            p_v += I420_RGB_BLOCK / 2;                                        \
+            p_buffer += I420_RGB_BLOCK;                                       \
+        }                                                                     \
+        /* Here we do some duplicate conversions, but at least we have all    \
+         * the pixels */                                                      \
+        if( i_rewind )                                                        \
+        {                                                                     \
+            p_y -= i_rewind;                                                  \
+            p_u -= i_rewind >> 1;                                             \
+            p_v -= i_rewind >> 1;                                             \
+            p_buffer -= i_rewind;                                             \
+                                                                              \
+            BLOCK( p_buffer, p_y, p_u, p_v );                                 \
+            p_y += I420_RGB_BLOCK;                                            \
+            p_u += I420_RGB_BLOCK / 2;                                        \
+            p_v += I420_RGB_BLOCK / 2;                                        \
+        }                                                                     \
+        SCALE_WIDTH;                                                          \
+        SCALE_HEIGHT( 420, sizeof(TYPE) );                                    \
+                                                                              \
+        p_y += i_source_margin;                                               \
+        if( i_y % 2 )                                                         \
+        {                                                                     \
+            p_u += i_source_margin_c;                                         \
+            p_v += i_source_margin_c;                                         \
+        }                                                                     \
+    }
+
+VLC_TARGET
+void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    I420_RGB_CONVERT( uint16_t, I420_RGB_Block_R5G5B5 )
+}
+
+VLC_TARGET
+void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    I420_RGB_CONVERT( uint16_t, I420_RGB_Block_R5G6B5 )
+}
+
+VLC_TARGET
+void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    I420_RGB_CONVERT( uint32_t, I420_RGB_Block_A8R8G8B8 )
+}
+
+VLC_TARGET
+void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    I420_RGB_CONVERT( uint32_t, I420_RGB_Block_R8G8B8A8 )
+}
+
+VLC_TARGET
+void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    I420_RGB_CONVERT( uint32_t, I420_RGB_Block_B8G8R8A8 )
+}
+
+VLC_TARGET
+void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+{
+    I420_RGB_CONVERT( uint32_t, I420_RGB_Block_A8B8G8R8 )
+}
+
+#else /* I420_RGB_TEST */
+
+/*
+ * Checks the block conversions against a scalar version of the SSE2
+ * arithmetic, and reports their throughput.
+ */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_WIDTH  1920
+#define TEST_HEIGHT 1080
+#define TEST_FRAMES 20
+
+static int16_t MulHi( int a, int16_t b )
+{
+    return (a * b) >> 16;
+}
+
+static int16_t AddS( int a, int b )
+{
+    return VLC_CLIP( a + b, INT16_MIN, INT16_MAX );
+}
+
+static uint8_t PackUS( int16_t a )
+{
+    return VLC_CLIP( a, 0, 255 );
+}
+
+static void Reference( unsigned y, unsigned u, unsigned v,
+                       uint8_t *r, uint8_t *g, uint8_t *b )
+{
+    const int cu = (u - 128) * 8, cv = (v - 128) * 8;
+    const int16_t yy = MulHi( (y > 16 ? y - 16 : 0) * 8, 0x253f );
+
+    *r = PackUS( AddS( MulHi( cv, 0x3312 ), yy ) );
+    *g = PackUS( AddS( AddS( MulHi( cu, (int16_t)0xf37d ),
+                             MulHi( cv, (int16_t)0xe5fc ) ), yy ) );
+    *b = PackUS( AddS( MulHi( cu, 0x4093 ), yy ) );
+}
+
+static uint32_t Pack32( uint8_t c0, uint8_t c1, uint8_t c2, uint8_t c3 )
+{
+    uint32_t pixel;
+    memcpy( &pixel, (const uint8_t[]){ c0, c1, c2, c3 }, 4 );
+    return pixel;
+}
+
+static uint32_t Expected_R5G5B5( uint8_t r, uint8_t g, uint8_t b )
+{
+    return ((r & 0xf8) << 7) | ((g & 0xf8) << 2) | (b >> 3);
+}
+
+static uint32_t Expected_R5G6B5( uint8_t r, uint8_t g, uint8_t b )
+{
+    return ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+}
+
+static uint32_t Expected_A8R8G8B8( uint8_t r, uint8_t g, uint8_t b )
+{
+    return Pack32( b, g, r, 0 );
+}
+
+static uint32_t Expected_R8G8B8A8( uint8_t r, uint8_t g, uint8_t b )
+{
+    return Pack32( 0, b, g, r );
+}
+
+static uint32_t Expected_B8G8R8A8( uint8_t r, uint8_t g, uint8_t b )
+{
+    return Pack32( 0, r, g, b );
+}
+
+static uint32_t Expected_A8B8G8R8( uint8_t r, uint8_t g, uint8_t b )
+{
+    return Pack32( r, g, b, 0 );
+}
+
+#define TEST_BLOCK( name )                                                    \
+VLC_TARGET                                                                    \
+static void Test_##name( void *p_buffer, const uint8_t *p_y,                  \
+                         const uint8_t *p_u, const uint8_t *p_v )             \
+{                                                                             \
+    I420_RGB_Block_##name( p_buffer, p_y, p_u, p_v );                         \
+}
+TEST_BLOCK( R5G5B5 )
+TEST_BLOCK( R5G6B5 )
+TEST_BLOCK( A8R8G8B8 )
+TEST_BLOCK( R8G8B8A8 )
+TEST_BLOCK( B8G8R8A8 )
+TEST_BLOCK( A8B8G8R8 )
+#undef TEST_BLOCK
+
+static const struct
+{
+    const char *name;
+    unsigned bytespp;
+    void (*block)( void *, const uint8_t *, const uint8_t *, const uint8_t * );
+    uint32_t (*expected)( uint8_t, uint8_t, uint8_t );
+} formats[] = {
+#define FORMAT( name, bytespp ) { #name, bytespp, Test_##name, Expected_##name }
+    FORMAT( R5G5B5, 2 ),
+    FORMAT( R5G6B5, 2 ),
+    FORMAT( A8R8G8B8, 4 ),
+    FORMAT( R8G8B8A8, 4 ),
+    FORMAT( B8G8R8A8, 4 ),
+    FORMAT( A8B8G8R8, 4 ),
+#undef FORMAT
+};
+
+static uint32_t GetPixel( const uint8_t *p_line, unsigned bytespp, unsigned x )
+{
+    if( bytespp == 2 )
+    {
+        uint16_t pixel;
+        memcpy( &pixel, p_line + 2 * x, 2 );
+        return pixel;
+    }
+    uint32_t pixel;
+    memcpy( &pixel, p_line + 4 * x, 4 );
+    return pixel;
+}
+
+/* Converts a line and compares each of its pixels with the reference */
+static void CheckLine( unsigned format, const uint8_t *p_y, const uint8_t *p_u,
+                       const uint8_t *p_v, unsigned i_width, uint8_t *p_line )
+{
+    for( unsigned x = 0; x < i_width; x += I420_RGB_BLOCK )
+        formats[format].block( p_line + x * formats[format].bytespp,
+                               p_y + x, p_u + x / 2, p_v + x / 2 );
+
+    for( unsigned x = 0; x < i_width; x++ )
+    {
+        uint8_t r, g, b;
+        Reference( p_y[x], p_u[x / 2], p_v[x / 2], &r, &g, &b );
+
+        const uint32_t expected = formats[format].expected( r, g, b );
+        const uint32_t pixel = GetPixel( p_line, formats[format].bytespp, x );
+        if( pixel != expected )
+        {
+            fprintf( stderr, "error: %s pixel %u of YUV %u,%u,%u: "
+                     "0x%08"PRIx32" vs 0x%08"PRIx32"\n", formats[format].name,
+                     x, p_y[x], p_u[x / 2], p_v[x / 2], pixel, expected );
+            assert( !"pixel doesn't match" );
+        }
+    }
+}
+
+int main( void )
+{
+#if defined (AVX2)
+    if( !vlc_CPU_AVX2() )
+#else
+    if( !vlc_CPU_ARM_NEON() )
+#endif
+        return 77;
+
+    uint8_t *p_y = malloc( TEST_WIDTH * TEST_HEIGHT );
+    uint8_t *p_u = malloc( TEST_WIDTH * TEST_HEIGHT / 4 );
+    uint8_t *p_v = malloc( TEST_WIDTH * TEST_HEIGHT / 4 );
+    uint8_t *p_rgb = malloc( TEST_WIDTH * TEST_HEIGHT * 4 );
+    assert( p_y && p_u && p_v && p_rgb );
+
+    /* Every chroma pair with every luma, then random lines so that the
+     * chroma differs between the pixel pairs */
+    uint8_t y_ramp[256], u_line[128], v_line[128];
+    for( unsigned i = 0; i < 256; i++ )
+        y_ramp[i] = i;
+
+    srand( 42 );
+    for( unsigned f = 0; f < ARRAY_SIZE(formats); f++ )
+    {
+        for( unsigned u = 0; u < 256; u++ )
+            for( unsigned v = 0; v < 256; v++ )
+            {
+                memset( u_line, u, sizeof(u_line) );
+                memset( v_line, v, sizeof(v_line) );
+                CheckLine( f, y_ramp, u_line, v_line, 256, p_rgb );
+            }
+
+        for( unsigned i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++ )
+            p_y[i] = rand();
+        for( unsigned i = 0; i < TEST_WIDTH * TEST_HEIGHT / 4; i++ )
+        {
+            p_u[i] = rand();
+            p_v[i] = rand();
+        }
+        for( unsigned line = 0; line < 64; line++ )
+            CheckLine( f, p_y + line * TEST_WIDTH, p_u + line * TEST_WIDTH / 2,
+                       p_v + line * TEST_WIDTH / 2, TEST_WIDTH, p_rgb );
+    }
+
+    /* Throughput of the block conversions, against the scalar reference */
+    for( unsigned f = 0; f < ARRAY_SIZE(formats); f++ )
+    {
+        const unsigned bytespp = formats[f].bytespp;
+
+        vlc_tick_t start = vlc_tick_now();
+        for( unsigned frame = 0; frame < TEST_FRAMES; frame++ )
+            for( unsigned line = 0; line < TEST_HEIGHT; line++ )
+            {
+                const unsigned c = (line / 2) * (TEST_WIDTH / 2);
+                uint8_t *p_line = p_rgb + line * TEST_WIDTH * bytespp;
+
+                for( unsigned x = 0; x < TEST_WIDTH; x += I420_RGB_BLOCK )
+                    formats[f].block( p_line + x * bytespp,
+                                      p_y + line * TEST_WIDTH + x,
+                                      p_u + c + x / 2, p_v + c + x / 2 );
+            }
+        const vlc_tick_t simd = vlc_tick_now() - start;
+
+        start = vlc_tick_now();
+        for( unsigned frame = 0; frame < TEST_FRAMES; frame++ )
+            for( unsigned line = 0; line < TEST_HEIGHT; line++ )
+            {
+                const unsigned c = (line / 2) * (TEST_WIDTH / 2);
+                uint8_t *p_line = p_rgb + line * TEST_WIDTH * bytespp;
+
+                for( unsigned x = 0; x < TEST_WIDTH; x++ )
+                {
+                    uint8_t r, g, b;
+                    Reference( p_y[line * TEST_WIDTH + x], p_u[c + x / 2],
+                               p_v[c + x / 2], &r, &g, &b );
+
+                    const uint32_t pixel = formats[f].expected( r, g, b );
+                    memcpy( p_line + x * bytespp, &pixel, bytespp );
+                }
+            }
+        const vlc_tick_t scalar = vlc_tick_now() - start;
+
+        const double pixels = (double)TEST_WIDTH * TEST_HEIGHT * TEST_FRAMES;
+        printf( "%-8s %8.1f Mpixel/s (scalar %6.1f Mpixel/s)\n",
+                formats[f].name,
+                pixels / __MAX( US_FROM_VLC_TICK( simd ), 1 ),
+                pixels / __MAX( US_FROM_VLC_TICK( scalar ), 1 ) );
+    }
+
+    free( p_rgb );
+    free( p_v );
+    free( p_u );
+    free( p_y );
+    return 0;
+}
+
+#endif
@@ -57,6 +57,11 @@ static void CloseScaler( vlc_object_t * );
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_( \
+    "Number of threads converting the pictures by slices " \
+    "(0 = number of CPUs).")
+
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 static const char *const ppsz_mode_descriptions[] =
 { N_("Fast bilinear"), N_("Bilinear"), N_("Bicubic (good quality)"),
@@ -73,6 +78,8 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer_with_range( "swscale-threads", 0, 0, 16,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
 vlc_module_end ()
 
 /* Version checking */
@@ -81,6 +88,14 @@ vlc_module_end ()
  * Local prototypes
  ****************************************************************************/
 
+/* Horizontal band of the picture, converted with its own context */
+typedef struct
+{
+    struct SwsContext *ctx;
+    unsigned i_y;
+    unsigned i_height;
+} scaler_slice_t;
+
 /**
  * Internal swscale filter structure.
  */
@@ -105,11 +120,36 @@ typedef struct
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    /* Slices of the conversion, cached with ctx */
+    scaler_slice_t *p_slices;
+    unsigned i_slices;
+
+    /* Workers converting the slices along with the filter thread */
+    struct
+    {
+        vlc_thread_t *p_threads;
+        unsigned i_threads;
+        vlc_mutex_t lock;
+        vlc_cond_t wait;
+        vlc_cond_t done;
+        bool b_quit;
+
+        /* current picture, protected by lock */
+        picture_t *p_src;
+        picture_t *p_dst;
+        int i_plane_count;
+        unsigned i_next;    /* next slice to convert */
+        unsigned i_jobs;    /* slices of the picture */
+        unsigned i_pending; /* slices not converted yet */
+    } pool;
 } filter_sys_t;
 
 static picture_t *Filter( filter_t *, picture_t * );
 static int  Init( filter_t * );
 static void Clean( filter_t * );
+static int  StartWorkers( filter_t * );
+static void StopWorkers( filter_t * );
 
 typedef struct
 {
@@ -139,6 +179,11 @@ static int GetSwsCpuMask(void);
 /* XXX is it always 3 even for BIG_ENDIAN (blend.c seems to think so) ? */
 #define OFFSET_A (3)
 
+/* Slices are multiple of it, so that they start on a chroma line for every
+ * subsampling, and are not smaller than it: contexts have a fixed cost */
+#define SLICE_ALIGN (16)
+#define SLICE_MIN_HEIGHT (64)
+
 /*****************************************************************************
  * OpenScaler: probe the filter and return score
  *****************************************************************************/
@@ -183,6 +228,12 @@ static int OpenScaler( vlc_object_t *p_this )
     memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
     memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
 
+    /* The filter thread converts a slice too */
+    unsigned i_threads = var_InheritInteger( p_filter, "swscale-threads" );
+    if( i_threads == 0 )
+        i_threads = __MIN( vlc_GetCPUCount(), 16 );
+    p_sys->pool.i_threads = i_threads - 1;
+
     if( Init( p_filter ) )
     {
         if( p_sys->p_filter )
@@ -191,6 +242,15 @@ static int OpenScaler( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    if( StartWorkers( p_filter ) )
+    {
+        Clean( p_filter );
+        if( p_sys->p_filter )
+            sws_freeFilter( p_sys->p_filter );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     /* */
     p_filter->pf_video_filter = Filter;
 
@@ -214,6 +274,7 @@ static void CloseScaler( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    StopWorkers( p_filter );
     Clean( p_filter );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
@@ -412,6 +473,50 @@ static int Init( filter_t *p_filter )
         else
             p_sys->ctxA = ctx;
     }
+
+    /* Bands can only be converted independently if no line is scaled
+     * from the neighbour ones */
+    unsigned i_slices = 0;
+    if( !cfg.b_copy && p_sys->ctx &&
+        p_fmti->i_visible_height == p_fmto->i_visible_height )
+        i_slices = __MIN( p_sys->pool.i_threads + 1,
+                          p_fmti->i_visible_height / SLICE_MIN_HEIGHT );
+    if( i_slices > 1 )
+    {
+        const unsigned i_height = p_fmti->i_visible_height;
+        const unsigned i_slice_height =
+            (i_height / i_slices) & ~(SLICE_ALIGN - 1);
+
+        p_sys->p_slices = vlc_alloc( i_slices, sizeof(*p_sys->p_slices) );
+        if( !p_sys->p_slices )
+        {
+            Clean( p_filter );
+            return VLC_ENOMEM;
+        }
+        for( unsigned i = 0; i < i_slices; i++ )
+        {
+            scaler_slice_t *p_slice = &p_sys->p_slices[i];
+
+            p_slice->i_y = i * i_slice_height;
+            p_slice->i_height = i + 1 < i_slices ? i_slice_height
+                                                 : i_height - p_slice->i_y;
+            p_slice->ctx = sws_getContext( i_fmti_visible_width, p_slice->i_height, cfg.i_fmti,
+                                           i_fmto_visible_width, p_slice->i_height, cfg.i_fmto,
+                                           cfg.i_sws_flags | p_sys->i_cpu_mask,
+                                           p_sys->p_filter, NULL, 0 );
+            if( !p_slice->ctx )
+            {
+                /* Convert the whole picture at once instead */
+                msg_Warn( p_filter, "could not init SwScaler slices" );
+                while( i-- > 0 )
+                    sws_freeContext( p_sys->p_slices[i].ctx );
+                FREENULL( p_sys->p_slices );
+                i_slices = 0;
+                break;
+            }
+        }
+        p_sys->i_slices = i_slices;
+    }
     if( p_sys->ctxA )
     {
         p_sys->p_src_a = picture_New( VLC_CODEC_GREY, i_fmti_visible_width, p_fmti->i_visible_height, 0, 1 );
@@ -487,6 +592,12 @@ static void Clean( filter_t *p_filter )
     if( p_sys->ctx )
         sws_freeContext( p_sys->ctx );
 
+    for( unsigned i = 0; i < p_sys->i_slices; i++ )
+        sws_freeContext( p_sys->p_slices[i].ctx );
+    free( p_sys->p_slices );
+    p_sys->p_slices = NULL;
+    p_sys->i_slices = 0;
+
     /* We have to set it to null has we call be called again :( */
     p_sys->ctx = NULL;
     p_sys->ctxA = NULL;
@@ -499,8 +610,8 @@ static void Clean( filter_t *p_filter )
 static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
                        const vlc_chroma_description_t *desc,
                        const video_format_t *fmt,
-                       const picture_t *p_picture, unsigned planes,
-                       bool b_swap_uv )
+                       const picture_t *p_picture, unsigned i_y,
+                       unsigned planes, bool b_swap_uv )
 {
     unsigned i = 0;
 
@@ -517,7 +628,7 @@ static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
         pp_pixel[i] = p->p_pixels
             + (((fmt->i_x_offset * desc->p[i].w.num) / desc->p[i].w.den)
                 * p->i_pixel_pitch)
-            + (((fmt->i_y_offset * desc->p[i].h.num) / desc->p[i].h.den)
+            + ((((fmt->i_y_offset + i_y) * desc->p[i].h.num) / desc->p[i].h.den)
                 * p->i_pitch);
         pi_pitch[i] = p->i_pitch;
     }
@@ -584,7 +695,8 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
 }
 
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
-                     picture_t *p_dst, picture_t *p_src, int i_height,
+                     picture_t *p_dst, picture_t *p_src,
+                     unsigned i_y, int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -594,7 +706,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     int src_stride[4], dst_stride[4];
 
     GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
-               p_src, i_plane_count, b_swap_uvi );
+               p_src, i_y, i_plane_count, b_swap_uvi );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
         memset( palette, 0, sizeof(palette) );
@@ -606,7 +718,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     }
 
     GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
-               p_dst, i_plane_count, b_swap_uvo );
+               p_dst, i_y, i_plane_count, b_swap_uvo );
 
     for (size_t i = 0; i < ARRAY_SIZE(src); i++)
         csrc[i] = src[i];
@@ -620,6 +732,118 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+/* Converts the slices of the current picture until there are none left.
+ * Called with the pool lock held. */
+static void ConvertPendingSlices( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    while( p_sys->pool.i_next < p_sys->pool.i_jobs )
+    {
+        const scaler_slice_t *p_slice = &p_sys->p_slices[p_sys->pool.i_next++];
+        picture_t *p_src = p_sys->pool.p_src;
+        picture_t *p_dst = p_sys->pool.p_dst;
+        const int i_plane_count = p_sys->pool.i_plane_count;
+
+        vlc_mutex_unlock( &p_sys->pool.lock );
+        Convert( p_filter, p_slice->ctx, p_dst, p_src,
+                 p_slice->i_y, p_slice->i_height, i_plane_count,
+                 p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        vlc_mutex_lock( &p_sys->pool.lock );
+
+        if( --p_sys->pool.i_pending == 0 )
+            vlc_cond_signal( &p_sys->pool.done );
+    }
+}
+
+static void *Worker( void *data )
+{
+    filter_t *p_filter = data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_mutex_lock( &p_sys->pool.lock );
+    while( !p_sys->pool.b_quit )
+    {
+        if( p_sys->pool.i_next < p_sys->pool.i_jobs )
+            ConvertPendingSlices( p_filter );
+        else
+            vlc_cond_wait( &p_sys->pool.wait, &p_sys->pool.lock );
+    }
+    vlc_mutex_unlock( &p_sys->pool.lock );
+    return NULL;
+}
+
+static void ConvertSlices( filter_t *p_filter, picture_t *p_dst,
+                           picture_t *p_src, int i_plane_count )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_mutex_lock( &p_sys->pool.lock );
+    p_sys->pool.p_src = p_src;
+    p_sys->pool.p_dst = p_dst;
+    p_sys->pool.i_plane_count = i_plane_count;
+    p_sys->pool.i_next = 0;
+    p_sys->pool.i_jobs = p_sys->i_slices;
+    p_sys->pool.i_pending = p_sys->i_slices;
+    vlc_cond_broadcast( &p_sys->pool.wait );
+
+    ConvertPendingSlices( p_filter );
+    while( p_sys->pool.i_pending > 0 )
+        vlc_cond_wait( &p_sys->pool.done, &p_sys->pool.lock );
+
+    p_sys->pool.i_jobs = 0;
+    vlc_mutex_unlock( &p_sys->pool.lock );
+}
+
+static int StartWorkers( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_mutex_init( &p_sys->pool.lock );
+    vlc_cond_init( &p_sys->pool.wait );
+    vlc_cond_init( &p_sys->pool.done );
+    p_sys->pool.b_quit = false;
+    p_sys->pool.i_next = p_sys->pool.i_jobs = p_sys->pool.i_pending = 0;
+
+    const unsigned i_threads = p_sys->pool.i_threads;
+    p_sys->pool.i_threads = 0;
+    if( i_threads == 0 )
+        return VLC_SUCCESS;
+
+    p_sys->pool.p_threads = vlc_alloc( i_threads, sizeof(vlc_thread_t) );
+    if( !p_sys->pool.p_threads )
+        return VLC_ENOMEM;
+
+    /* Missing workers only make the conversion slower, since the filter
+     * thread converts the slices left */
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        if( vlc_clone( &p_sys->pool.p_threads[i], Worker, p_filter,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        {
+            msg_Warn( p_filter, "could only start %u of %u threads",
+                      i, i_threads );
+            break;
+        }
+        p_sys->pool.i_threads++;
+    }
+    return VLC_SUCCESS;
+}
+
+static void StopWorkers( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_mutex_lock( &p_sys->pool.lock );
+    p_sys->pool.b_quit = true;
+    vlc_cond_broadcast( &p_sys->pool.wait );
+    vlc_mutex_unlock( &p_sys->pool.lock );
+
+    for( unsigned i = 0; i < p_sys->pool.i_threads; i++ )
+        vlc_join( p_sys->pool.p_threads[i], NULL );
+    free( p_sys->pool.p_threads );
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -667,8 +891,12 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         /* Even if alpha is unused, swscale expects the pointer to be set */
         const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        if( p_sys->i_slices > 1 )
+            ConvertSlices( p_filter, p_dst, p_src, n_planes );
+        else
+            Convert( p_filter, p_sys->ctx, p_dst, p_src, 0,
+                     p_fmti->i_visible_height, n_planes,
+                     p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     }
     if( p_sys->ctxA )
     {
@@ -680,7 +908,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         else
             plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
+        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a, 0,
                  p_fmti->i_visible_height, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
             InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
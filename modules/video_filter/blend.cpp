@@ -84,6 +84,26 @@ public:
     {
         return true;
     }
+    /* Row access for the vectorized blending: first pixel of the current
+     * line of a plane subsampled by rx and ry */
+    uint8_t *getPixels(unsigned plane, unsigned rx, unsigned ry,
+                       unsigned size) const
+    {
+        return &picture->p[plane].p_pixels[(y / ry) * picture->p[plane].i_pitch
+                                           + (x / rx) * size];
+    }
+    int getPitch(unsigned plane) const
+    {
+        return picture->p[plane].i_pitch;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
 
 protected:
     template <unsigned ry>
@@ -527,10 +547,296 @@ private:
     G g;
 };
 
+
+/*
+ * Row blending, used by the Blend<> specializations below for the most
+ * common formats. They produce the same pixels as the generic Blend<>.
+ */
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define BLEND_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+# define BLEND_NEON
+#endif
+
+/* Pixels blended at once, for the blending alpha buffer */
+#define BLEND_CHUNK 256
+
+#if defined(BLEND_SSE2)
+/* merge() on 16-bit lanes: (255 - f) * d + s * f fits in 16 bits */
+static inline __m128i merge16(__m128i d, __m128i s, __m128i f)
+{
+    const __m128i v = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_sub_epi16(_mm_set1_epi16(255), f), d),
+        _mm_mullo_epi16(s, f));
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(v, 8), v),
+                                        _mm_set1_epi16(1)), 8);
+}
+
+static inline __m128i div255_16(__m128i v)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(v, 8), v),
+                                        _mm_set1_epi16(1)), 8);
+}
+#elif defined(BLEND_NEON)
+static inline uint16x8_t merge16(uint16x8_t d, uint16x8_t s, uint16x8_t f)
+{
+    const uint16x8_t v = vmlaq_u16(vmulq_u16(vsubq_u16(vdupq_n_u16(255), f), d),
+                                   s, f);
+    return vshrq_n_u16(vaddq_u16(vaddq_u16(vshrq_n_u16(v, 8), v),
+                                 vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x8_t merge8(uint8x8_t d, uint8x8_t s, uint8x8_t f)
+{
+    return vmovn_u16(merge16(vmovl_u8(d), vmovl_u8(s), vmovl_u8(f)));
+}
+#endif
+
+/* Computes the blending alphas of a span, returns false if it is fully
+ * transparent */
+static bool BlendAlphaRow(uint8_t *a, const uint8_t *src_a, unsigned count,
+                          unsigned alpha)
+{
+    unsigned x = 0;
+    bool visible = false;
+#if defined(BLEND_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha16 = _mm_set1_epi16(alpha);
+    __m128i any = zero;
+    for (; x + 16 <= count; x += 16) {
+        const __m128i sa = _mm_loadu_si128((const __m128i *)&src_a[x]);
+        const __m128i lo = div255_16(_mm_mullo_epi16(_mm_unpacklo_epi8(sa, zero), alpha16));
+        const __m128i hi = div255_16(_mm_mullo_epi16(_mm_unpackhi_epi8(sa, zero), alpha16));
+        const __m128i v = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128((__m128i *)&a[x], v);
+        any = _mm_or_si128(any, v);
+    }
+    visible = _mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) != 0xffff;
+#elif defined(BLEND_NEON)
+    uint8x16_t any = vdupq_n_u8(0);
+    for (; x + 16 <= count; x += 16) {
+        const uint8x16_t sa = vld1q_u8(&src_a[x]);
+        const uint16x8_t lo = vmulq_n_u16(vmovl_u8(vget_low_u8(sa)), alpha);
+        const uint16x8_t hi = vmulq_n_u16(vmovl_u8(vget_high_u8(sa)), alpha);
+        const uint16x8_t one = vdupq_n_u16(1);
+        const uint8x16_t v = vcombine_u8(
+            vshrn_n_u16(vaddq_u16(vaddq_u16(vshrq_n_u16(lo, 8), lo), one), 8),
+            vshrn_n_u16(vaddq_u16(vaddq_u16(vshrq_n_u16(hi, 8), hi), one), 8));
+        vst1q_u8(&a[x], v);
+        any = vorrq_u8(any, v);
+    }
+    visible = vmaxvq_u8(any) != 0;
+#endif
+    for (; x < count; x++) {
+        a[x] = div255(alpha * src_a[x]);
+        visible |= a[x] != 0;
+    }
+    return visible;
+}
+
+/* dst[x] blended with src[x] */
+static void MergeRow(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                     unsigned count)
+{
+    unsigned x = 0;
+#if defined(BLEND_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= count; x += 16) {
+        const __m128i f = _mm_loadu_si128((const __m128i *)&a[x]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(f, zero)) == 0xffff)
+            continue;
+        const __m128i s = _mm_loadu_si128((const __m128i *)&src[x]);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[x]);
+        const __m128i lo = merge16(_mm_unpacklo_epi8(d, zero),
+                                   _mm_unpacklo_epi8(s, zero),
+                                   _mm_unpacklo_epi8(f, zero));
+        const __m128i hi = merge16(_mm_unpackhi_epi8(d, zero),
+                                   _mm_unpackhi_epi8(s, zero),
+                                   _mm_unpackhi_epi8(f, zero));
+        _mm_storeu_si128((__m128i *)&dst[x], _mm_packus_epi16(lo, hi));
+    }
+#elif defined(BLEND_NEON)
+    for (; x + 8 <= count; x += 8) {
+        const uint8x8_t f = vld1_u8(&a[x]);
+        if (vmaxv_u8(f) == 0)
+            continue;
+        vst1_u8(&dst[x], merge8(vld1_u8(&dst[x]), vld1_u8(&src[x]), f));
+    }
+#endif
+    for (; x < count; x++)
+        if (a[x] > 0)
+            ::merge(&dst[x], src[x], a[x]);
+}
+
+/* dst[x] blended with src[2 * x], for horizontally subsampled chroma */
+static void MergeRowHalf(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                         unsigned count, unsigned src_count)
+{
+    unsigned x = 0;
+#if defined(BLEND_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0x00ff);
+    for (; 2 * x + 16 <= src_count; x += 8) {
+        const __m128i f = _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[2 * x]), even);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(f, zero)) == 0xffff)
+            continue;
+        const __m128i s = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[2 * x]), even);
+        const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&dst[x]), zero);
+        _mm_storel_epi64((__m128i *)&dst[x], _mm_packus_epi16(merge16(d, s, f), zero));
+    }
+#elif defined(BLEND_NEON)
+    for (; 2 * x + 16 <= src_count; x += 8) {
+        const uint8x8_t f = vld2_u8(&a[2 * x]).val[0];
+        if (vmaxv_u8(f) == 0)
+            continue;
+        vst1_u8(&dst[x], merge8(vld1_u8(&dst[x]), vld2_u8(&src[2 * x]).val[0], f));
+    }
+#endif
+    for (; x < count; x++)
+        if (a[2 * x] > 0)
+            ::merge(&dst[x], src[2 * x], a[2 * x]);
+}
+
+/* dst[2 * x] and dst[2 * x + 1] blended with src_0[2 * x] and src_1[2 * x],
+ * for the interleaved chroma of semi-planar formats */
+static void MergeRowHalfInterleaved(uint8_t *dst, const uint8_t *src_0,
+                                    const uint8_t *src_1, const uint8_t *a,
+                                    unsigned count, unsigned src_count)
+{
+    unsigned x = 0;
+#if defined(BLEND_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0x00ff);
+    for (; 2 * x + 16 <= src_count; x += 8) {
+        const __m128i f = _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[2 * x]), even);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(f, zero)) == 0xffff)
+            continue;
+        const __m128i s0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src_0[2 * x]), even);
+        const __m128i s1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src_1[2 * x]), even);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[2 * x]);
+        const __m128i d0 = merge16(_mm_and_si128(d, even), s0, f);
+        const __m128i d1 = merge16(_mm_srli_epi16(d, 8), s1, f);
+        _mm_storeu_si128((__m128i *)&dst[2 * x],
+                         _mm_or_si128(d0, _mm_slli_epi16(d1, 8)));
+    }
+#elif defined(BLEND_NEON)
+    for (; 2 * x + 16 <= src_count; x += 8) {
+        const uint8x8_t f = vld2_u8(&a[2 * x]).val[0];
+        if (vmaxv_u8(f) == 0)
+            continue;
+        uint8x8x2_t d = vld2_u8(&dst[2 * x]);
+        d.val[0] = merge8(d.val[0], vld2_u8(&src_0[2 * x]).val[0], f);
+        d.val[1] = merge8(d.val[1], vld2_u8(&src_1[2 * x]).val[0], f);
+        vst2_u8(&dst[2 * x], d);
+    }
+#endif
+    for (; x < count; x++) {
+        if (a[2 * x] > 0) {
+            ::merge(&dst[2 * x + 0], src_0[2 * x], a[2 * x]);
+            ::merge(&dst[2 * x + 1], src_1[2 * x], a[2 * x]);
+        }
+    }
+}
+
+/* RGBA source blended into 4 bytes pixels, whose red and blue are swapped
+ * if swap_rb, and whose 4th byte is either kept or blended as alpha */
+template <bool has_alpha, bool swap_rb>
+static void MergeRowRGBX(uint8_t *dst, const uint8_t *src, unsigned count,
+                         unsigned alpha)
+{
+    unsigned x = 0;
+#if defined(BLEND_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha16 = _mm_set1_epi16(alpha);
+    const __m128i rgb = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i opaque = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    for (; x + 4 <= count; x += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * x]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(s, 24), zero)) == 0xffff)
+            continue;
+        if (swap_rb) {
+            const __m128i rb = _mm_and_si128(s, _mm_set1_epi32(0x00ff00ff));
+            s = _mm_or_si128(_mm_and_si128(s, _mm_set1_epi32(0xff00ff00)),
+                             _mm_or_si128(_mm_srli_epi32(rb, 16),
+                                          _mm_slli_epi32(rb, 16)));
+        }
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * x]);
+        __m128i out[2];
+        for (unsigned i = 0; i < 2; i++) {
+            const __m128i s16 = i ? _mm_unpackhi_epi8(s, zero) : _mm_unpacklo_epi8(s, zero);
+            __m128i d16 = i ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+            /* alpha of each pixel in its 4 lanes */
+            const __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s16,
+                                   _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m128i a = div255_16(_mm_mullo_epi16(sa, alpha16));
+            if (has_alpha) {
+                const __m128i da = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d16,
+                                       _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                /* the pixels left transparent are not touched at all */
+                const __m128i f = _mm_andnot_si128(_mm_cmpeq_epi16(a, zero),
+                                      _mm_sub_epi16(_mm_set1_epi16(255), da));
+                d16 = merge16(d16, s16, _mm_and_si128(f, rgb));
+                d16 = merge16(d16, _mm_or_si128(_mm_and_si128(s16, rgb), opaque), a);
+            } else {
+                d16 = merge16(d16, s16, _mm_and_si128(a, rgb));
+            }
+            out[i] = d16;
+        }
+        _mm_storeu_si128((__m128i *)&dst[4 * x], _mm_packus_epi16(out[0], out[1]));
+    }
+#elif defined(BLEND_NEON)
+    for (; x + 8 <= count; x += 8) {
+        const uint8x8x4_t s = vld4_u8(&src[4 * x]);
+        if (vmaxv_u8(s.val[3]) == 0)
+            continue;
+        const uint16x8_t a16 = vmulq_n_u16(vmovl_u8(s.val[3]), alpha);
+        const uint8x8_t a = vshrn_n_u16(vaddq_u16(vaddq_u16(vshrq_n_u16(a16, 8), a16),
+                                                  vdupq_n_u16(1)), 8);
+        uint8x8x4_t d = vld4_u8(&dst[4 * x]);
+        const uint8x8_t r = s.val[swap_rb ? 2 : 0];
+        const uint8x8_t b = s.val[swap_rb ? 0 : 2];
+        if (has_alpha) {
+            /* the pixels left transparent are not touched at all */
+            const uint8x8_t f = vand_u8(vsub_u8(vdup_n_u8(255), d.val[3]),
+                                        vtst_u8(a, a));
+            d.val[0] = merge8(d.val[0], r, f);
+            d.val[1] = merge8(d.val[1], s.val[1], f);
+            d.val[2] = merge8(d.val[2], b, f);
+            d.val[3] = merge8(d.val[3], vdup_n_u8(255), a);
+        }
+        d.val[0] = merge8(d.val[0], r, a);
+        d.val[1] = merge8(d.val[1], s.val[1], a);
+        d.val[2] = merge8(d.val[2], b, a);
+        vst4_u8(&dst[4 * x], d);
+    }
+#endif
+    for (; x < count; x++) {
+        const uint8_t *s = &src[4 * x];
+        uint8_t *d = &dst[4 * x];
+        const unsigned a = div255(alpha * s[3]);
+        if (a <= 0)
+            continue;
+        const unsigned r = s[swap_rb ? 2 : 0];
+        const unsigned b = s[swap_rb ? 0 : 2];
+        if (has_alpha) {
+            ::merge(&d[0], r, 255 - d[3]);
+            ::merge(&d[1], s[1], 255 - d[3]);
+            ::merge(&d[2], b, 255 - d[3]);
+        }
+        ::merge(&d[0], r, a);
+        ::merge(&d[1], s[1], a);
+        ::merge(&d[2], b, a);
+        if (has_alpha)
+            ::merge(&d[3], 255, a);
+    }
+}
+
 } // namespace
 
 template <class TDst, class TSrc, class TConvert>
-void Blend(const CPicture &dst_data, const CPicture &src_data,
+void BlendPixels(const CPicture &dst_data, const CPicture &src_data,
            unsigned width, unsigned height, int alpha)
 {
     TSrc src(src_data);
@@ -558,6 +864,139 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+template <class TDst, class TSrc, class TConvert>
+void Blend(const CPicture &dst_data, const CPicture &src_data,
+           unsigned width, unsigned height, int alpha)
+{
+    BlendPixels<TDst, TSrc, TConvert>(dst_data, src_data, width, height, alpha);
+}
+
+/* YUVA into 4:2:0: the chroma of the even lines and columns are blended
+ * with the source pixel there, as CPictureYUVPlanar::merge() does */
+template <bool semiplanar, bool swap_uv>
+static void BlendYUVA420(const CPicture &dst_data, const CPicture &src_data,
+                         unsigned width, unsigned height, unsigned alpha)
+{
+    uint8_t *dst_y = dst_data.getPixels(0, 1, 1, 1);
+    uint8_t *dst_u, *dst_v;
+    if (semiplanar) {
+        dst_u = dst_data.getPixels(1, 2, 2, 2);
+        dst_v = NULL;
+    } else {
+        dst_u = dst_data.getPixels(swap_uv ? 2 : 1, 2, 2, 1);
+        dst_v = dst_data.getPixels(swap_uv ? 1 : 2, 2, 2, 1);
+    }
+    const uint8_t *src[4];
+    for (unsigned i = 0; i < 4; i++)
+        src[i] = src_data.getPixels(i, 1, 1, 1);
+
+    /* first source column on an even destination column */
+    const unsigned odd = dst_data.getX() % 2;
+    unsigned y = dst_data.getY();
+
+    for (unsigned row = 0; row < height; row++, y++) {
+        for (unsigned x = 0; x < width; x += BLEND_CHUNK) {
+            const unsigned count = __MIN(width - x, BLEND_CHUNK);
+            uint8_t a[BLEND_CHUNK];
+
+            if (!BlendAlphaRow(a, &src[3][x], count, alpha))
+                continue;
+            MergeRow(&dst_y[x], &src[0][x], a, count);
+
+            if (y % 2 != 0 || count <= odd)
+                continue;
+            const unsigned c = (dst_data.getX() + x + odd) / 2
+                             - dst_data.getX() / 2;
+            const unsigned chroma_count = (count - odd + 1) / 2;
+            if (semiplanar)
+                MergeRowHalfInterleaved(&dst_u[2 * c],
+                                        &src[swap_uv ? 2 : 1][x + odd],
+                                        &src[swap_uv ? 1 : 2][x + odd],
+                                        &a[odd], chroma_count, count - odd);
+            else {
+                MergeRowHalf(&dst_u[c], &src[1][x + odd], &a[odd],
+                             chroma_count, count - odd);
+                MergeRowHalf(&dst_v[c], &src[2][x + odd], &a[odd],
+                             chroma_count, count - odd);
+            }
+        }
+
+        dst_y += dst_data.getPitch(0);
+        if (y % 2 != 0) {
+            dst_u += dst_data.getPitch(semiplanar ? 1 : swap_uv ? 2 : 1);
+            if (!semiplanar)
+                dst_v += dst_data.getPitch(swap_uv ? 1 : 2);
+        }
+        for (unsigned i = 0; i < 4; i++)
+            src[i] += src_data.getPitch(i);
+    }
+}
+
+template <bool has_alpha, bool swap_rb>
+static void BlendRGBA(const CPicture &dst_data, const CPicture &src_data,
+                      unsigned width, unsigned height, unsigned alpha)
+{
+    uint8_t *dst = dst_data.getPixels(0, 1, 1, 4);
+    const uint8_t *src = src_data.getPixels(0, 1, 1, 4);
+
+    for (unsigned row = 0; row < height; row++) {
+        MergeRowRGBX<has_alpha, swap_rb>(dst, src, width, alpha);
+        dst += dst_data.getPitch(0);
+        src += src_data.getPitch(0);
+    }
+}
+
+#define BLEND_YUVA420(picture, semiplanar, swap_uv) \
+template <> \
+void Blend<picture, CPictureYUVA, compose<convertNone, convertNone> >( \
+        const CPicture &dst_data, const CPicture &src_data, \
+        unsigned width, unsigned height, int alpha) \
+{ \
+    if (alpha > 255) \
+        BlendPixels<picture, CPictureYUVA, compose<convertNone, convertNone> >( \
+            dst_data, src_data, width, height, alpha); \
+    else \
+        BlendYUVA420<semiplanar, swap_uv>(dst_data, src_data, width, height, alpha); \
+}
+BLEND_YUVA420(CPictureI420_8, false, false)
+BLEND_YUVA420(CPictureYV12,   false, true)
+BLEND_YUVA420(CPictureNV12,   true,  false)
+BLEND_YUVA420(CPictureNV21,   true,  true)
+#undef BLEND_YUVA420
+
+/* RGBA and BGRA */
+template <>
+void Blend<CPictureRGBA, CPictureRGBA, compose<convertNone, convertNone> >(
+        const CPicture &dst_data, const CPicture &src_data,
+        unsigned width, unsigned height, int alpha)
+{
+    if (alpha > 255)
+        BlendPixels<CPictureRGBA, CPictureRGBA, compose<convertNone, convertNone> >(
+            dst_data, src_data, width, height, alpha);
+    else if (dst_data.getFormat()->i_chroma == VLC_CODEC_BGRA)
+        BlendRGBA<true, true>(dst_data, src_data, width, height, alpha);
+    else
+        BlendRGBA<true, false>(dst_data, src_data, width, height, alpha);
+}
+
+template <>
+void Blend<CPictureRGB32, CPictureRGBA, compose<convertNone, convertNone> >(
+        const CPicture &dst_data, const CPicture &src_data,
+        unsigned width, unsigned height, int alpha)
+{
+    int r, g, b;
+    if (alpha <= 255
+     && GetPackedRgbIndexes(dst_data.getFormat(), &r, &g, &b) == VLC_SUCCESS
+     && g == 1 && r + b == 2) {
+        if (r == 2)
+            BlendRGBA<false, true>(dst_data, src_data, width, height, alpha);
+        else
+            BlendRGBA<false, false>(dst_data, src_data, width, height, alpha);
+    } else
+        BlendPixels<CPictureRGB32, CPictureRGBA, compose<convertNone, convertNone> >(
+            dst_data, src_data, width, height, alpha);
+}
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
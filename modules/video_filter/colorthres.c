@@ -46,6 +46,8 @@ static int  Create    ( vlc_object_t * );
 static void Destroy   ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void FilterSlice( filter_t *, picture_t *, const picture_t *,
+                         unsigned, unsigned );
 static picture_t *FilterPacked( filter_t *, picture_t * );
 
 /*****************************************************************************
@@ -116,6 +118,7 @@ static int Create( vlc_object_t *p_this )
     {
         CASE_PLANAR_YUV
             p_filter->pf_video_filter = Filter;
+            p_filter->pf_video_filter_slice = FilterSlice;
             break;
 
         CASE_PACKED_YUV_422
@@ -204,36 +207,42 @@ static bool IsSimilar( int u, int v,
  * waits until it is displayed and switch the two rendering buffers, preparing
  * next frame.
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( filter_t *p_filter, picture_t *p_outpic,
+                         const picture_t *p_pic,
+                         unsigned i_slice, unsigned i_slices )
 {
-    picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
     int i_simthres = atomic_load( &p_sys->i_simthres );
     int i_satthres = atomic_load( &p_sys->i_satthres );
     int i_color = atomic_load( &p_sys->i_color );
+    int i_first, i_end;
 
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
+    /* Copy the Y plane */
+    if( p_outpic != p_pic )
     {
-        picture_Release( p_pic );
-        return NULL;
+        const plane_t *p_src = &p_pic->p[Y_PLANE];
+        plane_t *p_dst = &p_outpic->p[Y_PLANE];
+
+        filter_GetSliceLines( p_src->i_visible_lines, i_slice, i_slices,
+                              &i_first, &i_end );
+        for( int y = i_first; y < i_end; y++ )
+            memcpy( &p_dst->p_pixels[y * p_dst->i_pitch],
+                    &p_src->p_pixels[y * p_src->i_pitch],
+                    __MIN( p_dst->i_visible_pitch, p_src->i_visible_pitch ) );
     }
 
-    /* Copy the Y plane */
-    plane_CopyPixels( &p_outpic->p[Y_PLANE], &p_pic->p[Y_PLANE] );
-
     /*
      * Do the U and V planes
      */
     int refu, refv, reflength;
     GetReference( &refu, &refv, &reflength, i_color );
 
-    for( int y = 0; y < p_pic->p[U_PLANE].i_visible_lines; y++ )
+    filter_GetSliceLines( p_pic->p[U_PLANE].i_visible_lines, i_slice, i_slices,
+                          &i_first, &i_end );
+    for( int y = i_first; y < i_end; y++ )
     {
-        uint8_t *p_src_u = &p_pic->p[U_PLANE].p_pixels[y * p_pic->p[U_PLANE].i_pitch];
-        uint8_t *p_src_v = &p_pic->p[V_PLANE].p_pixels[y * p_pic->p[V_PLANE].i_pitch];
+        const uint8_t *p_src_u = &p_pic->p[U_PLANE].p_pixels[y * p_pic->p[U_PLANE].i_pitch];
+        const uint8_t *p_src_v = &p_pic->p[V_PLANE].p_pixels[y * p_pic->p[V_PLANE].i_pitch];
         uint8_t *p_dst_u = &p_outpic->p[U_PLANE].p_pixels[y * p_outpic->p[U_PLANE].i_pitch];
         uint8_t *p_dst_v = &p_outpic->p[V_PLANE].p_pixels[y * p_outpic->p[V_PLANE].i_pitch];
 
@@ -256,6 +265,22 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             p_src_v++;
         }
     }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    FilterSlice( p_filter, p_outpic, p_pic, 0, 1 );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
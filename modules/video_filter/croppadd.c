@@ -225,6 +225,17 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
+    /* Without padding, the output is a region of the input planes: share
+     * them instead of copying the pixels */
+    if( p_sys->i_paddtop == 0 && p_sys->i_paddbottom == 0
+     && p_sys->i_paddleft == 0 && p_sys->i_paddright == 0 )
+    {
+        p_outpic = picture_CloneRegion( p_pic, &p_filter->fmt_out.video,
+                                        p_sys->i_cropleft, p_sys->i_croptop );
+        if( p_outpic )
+            return CopyInfoAndRelease( p_outpic, p_pic );
+    }
+
     /* Request output picture */
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
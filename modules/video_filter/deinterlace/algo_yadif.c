@@ -38,6 +38,13 @@
 
 #include "algo_yadif.h"
 
+#ifdef HAVE_AVX2_INTRINSICS
+#   include <immintrin.h>
+#endif
+#if defined(CAN_COMPILE_ARM64)
+#   include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Yadif (Yet Another DeInterlacing Filter).
  *****************************************************************************/
@@ -46,6 +53,436 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+/* The SIMD line filters below compute the same pixels as FILTER from yadif.h,
+ * on 16 (AVX2) or 8 (NEON) pixels at once, in 16-bit lanes. The pixels left
+ * at the end of the lines go through the C filter. */
+
+#ifdef HAVE_AVX2_INTRINSICS
+#define LOAD_AVX2(p) _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)(p) ) )
+#define ABSDIFF_AVX2(a, b) _mm256_abs_epi16( _mm256_sub_epi16( a, b ) )
+
+/* Score of the spatial direction j, as CHECK(j) */
+VLC_AVX2
+static inline __m256i yadif_score_avx2( const uint8_t *cur, int mrefs,
+                                        int prefs, int j )
+{
+    return _mm256_add_epi16( _mm256_add_epi16(
+            ABSDIFF_AVX2( LOAD_AVX2( &cur[mrefs - 1 + j] ),
+                          LOAD_AVX2( &cur[prefs - 1 - j] ) ),
+            ABSDIFF_AVX2( LOAD_AVX2( &cur[mrefs + j] ),
+                          LOAD_AVX2( &cur[prefs - j] ) ) ),
+            ABSDIFF_AVX2( LOAD_AVX2( &cur[mrefs + 1 + j] ),
+                          LOAD_AVX2( &cur[prefs + 1 - j] ) ) );
+}
+
+VLC_AVX2
+static inline __m256i yadif_pred_avx2( const uint8_t *cur, int mrefs,
+                                       int prefs, int j )
+{
+    return _mm256_srli_epi16( _mm256_add_epi16( LOAD_AVX2( &cur[mrefs + j] ),
+                                                LOAD_AVX2( &cur[prefs - j] ) ), 1 );
+}
+
+VLC_AVX2
+static void yadif_filter_line_avx2( uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                    uint8_t *next, int w, int prefs, int mrefs,
+                                    int parity, int mode )
+{
+    const uint8_t *prev2 = parity ? prev : cur;
+    const uint8_t *next2 = parity ? cur  : next;
+    int x;
+
+    for( x = 0; x + 16 <= w; x += 16 )
+    {
+        const __m256i c = LOAD_AVX2( &cur[mrefs + x] );
+        const __m256i e = LOAD_AVX2( &cur[prefs + x] );
+        const __m256i p2 = LOAD_AVX2( &prev2[x] );
+        const __m256i n2 = LOAD_AVX2( &next2[x] );
+        const __m256i d = _mm256_srli_epi16( _mm256_add_epi16( p2, n2 ), 1 );
+
+        const __m256i td0 = ABSDIFF_AVX2( p2, n2 );
+        const __m256i td1 = _mm256_srli_epi16( _mm256_add_epi16(
+                ABSDIFF_AVX2( LOAD_AVX2( &prev[mrefs + x] ), c ),
+                ABSDIFF_AVX2( LOAD_AVX2( &prev[prefs + x] ), e ) ), 1 );
+        const __m256i td2 = _mm256_srli_epi16( _mm256_add_epi16(
+                ABSDIFF_AVX2( LOAD_AVX2( &next[mrefs + x] ), c ),
+                ABSDIFF_AVX2( LOAD_AVX2( &next[prefs + x] ), e ) ), 1 );
+        __m256i diff = _mm256_max_epi16( _mm256_max_epi16(
+                _mm256_srli_epi16( td0, 1 ), td1 ), td2 );
+
+        __m256i spatial_pred = _mm256_srli_epi16( _mm256_add_epi16( c, e ), 1 );
+        __m256i spatial_score = _mm256_sub_epi16(
+                yadif_score_avx2( &cur[x], mrefs, prefs, 0 ),
+                _mm256_set1_epi16( 1 ) );
+
+        /* The second direction of each side is only checked when the first
+         * one is better, as the nested CHECK() do */
+        for( int j = -1; j <= 1; j += 2 )
+        {
+            __m256i score = yadif_score_avx2( &cur[x], mrefs, prefs, j );
+            __m256i better = _mm256_cmpgt_epi16( spatial_score, score );
+            spatial_score = _mm256_blendv_epi8( spatial_score, score, better );
+            spatial_pred = _mm256_blendv_epi8( spatial_pred,
+                    yadif_pred_avx2( &cur[x], mrefs, prefs, j ), better );
+
+            score = yadif_score_avx2( &cur[x], mrefs, prefs, 2 * j );
+            better = _mm256_and_si256( better,
+                                       _mm256_cmpgt_epi16( spatial_score, score ) );
+            spatial_score = _mm256_blendv_epi8( spatial_score, score, better );
+            spatial_pred = _mm256_blendv_epi8( spatial_pred,
+                    yadif_pred_avx2( &cur[x], mrefs, prefs, 2 * j ), better );
+        }
+
+        if( mode < 2 )
+        {
+            const __m256i b = _mm256_srli_epi16( _mm256_add_epi16(
+                    LOAD_AVX2( &prev2[2 * mrefs + x] ),
+                    LOAD_AVX2( &next2[2 * mrefs + x] ) ), 1 );
+            const __m256i f = _mm256_srli_epi16( _mm256_add_epi16(
+                    LOAD_AVX2( &prev2[2 * prefs + x] ),
+                    LOAD_AVX2( &next2[2 * prefs + x] ) ), 1 );
+            const __m256i de = _mm256_sub_epi16( d, e );
+            const __m256i dc = _mm256_sub_epi16( d, c );
+            const __m256i bc = _mm256_sub_epi16( b, c );
+            const __m256i fe = _mm256_sub_epi16( f, e );
+            const __m256i max = _mm256_max_epi16( _mm256_max_epi16( de, dc ),
+                                                  _mm256_min_epi16( bc, fe ) );
+            const __m256i min = _mm256_min_epi16( _mm256_min_epi16( de, dc ),
+                                                  _mm256_max_epi16( bc, fe ) );
+            diff = _mm256_max_epi16( _mm256_max_epi16( diff, min ),
+                    _mm256_sub_epi16( _mm256_setzero_si256(), max ) );
+        }
+
+        spatial_pred = _mm256_min_epi16( _mm256_max_epi16( spatial_pred,
+                _mm256_sub_epi16( d, diff ) ), _mm256_add_epi16( d, diff ) );
+
+        const __m256i pixels = _mm256_permute4x64_epi64(
+                _mm256_packus_epi16( spatial_pred, spatial_pred ), 0xd8 );
+        _mm_storeu_si128( (__m128i *)&dst[x], _mm256_castsi256_si128( pixels ) );
+    }
+
+    if( x < w )
+        yadif_filter_line_c( &dst[x], &prev[x], &cur[x], &next[x], w - x,
+                             prefs, mrefs, parity, mode );
+}
+#undef ABSDIFF_AVX2
+#undef LOAD_AVX2
+#endif
+
+#if defined(CAN_COMPILE_ARM64)
+#define LOAD_NEON(p) vreinterpretq_s16_u16( vmovl_u8( vld1_u8( p ) ) )
+
+static inline int16x8_t yadif_score_neon( const uint8_t *cur, int mrefs,
+                                          int prefs, int j )
+{
+    return vaddq_s16( vaddq_s16(
+            vabdq_s16( LOAD_NEON( &cur[mrefs - 1 + j] ),
+                       LOAD_NEON( &cur[prefs - 1 - j] ) ),
+            vabdq_s16( LOAD_NEON( &cur[mrefs + j] ),
+                       LOAD_NEON( &cur[prefs - j] ) ) ),
+            vabdq_s16( LOAD_NEON( &cur[mrefs + 1 + j] ),
+                       LOAD_NEON( &cur[prefs + 1 - j] ) ) );
+}
+
+static inline int16x8_t yadif_pred_neon( const uint8_t *cur, int mrefs,
+                                         int prefs, int j )
+{
+    return vshrq_n_s16( vaddq_s16( LOAD_NEON( &cur[mrefs + j] ),
+                                   LOAD_NEON( &cur[prefs - j] ) ), 1 );
+}
+
+static void yadif_filter_line_neon( uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                    uint8_t *next, int w, int prefs, int mrefs,
+                                    int parity, int mode )
+{
+    const uint8_t *prev2 = parity ? prev : cur;
+    const uint8_t *next2 = parity ? cur  : next;
+    int x;
+
+    for( x = 0; x + 8 <= w; x += 8 )
+    {
+        const int16x8_t c = LOAD_NEON( &cur[mrefs + x] );
+        const int16x8_t e = LOAD_NEON( &cur[prefs + x] );
+        const int16x8_t p2 = LOAD_NEON( &prev2[x] );
+        const int16x8_t n2 = LOAD_NEON( &next2[x] );
+        const int16x8_t d = vshrq_n_s16( vaddq_s16( p2, n2 ), 1 );
+
+        const int16x8_t td0 = vabdq_s16( p2, n2 );
+        const int16x8_t td1 = vshrq_n_s16( vaddq_s16(
+                vabdq_s16( LOAD_NEON( &prev[mrefs + x] ), c ),
+                vabdq_s16( LOAD_NEON( &prev[prefs + x] ), e ) ), 1 );
+        const int16x8_t td2 = vshrq_n_s16( vaddq_s16(
+                vabdq_s16( LOAD_NEON( &next[mrefs + x] ), c ),
+                vabdq_s16( LOAD_NEON( &next[prefs + x] ), e ) ), 1 );
+        int16x8_t diff = vmaxq_s16( vmaxq_s16( vshrq_n_s16( td0, 1 ), td1 ), td2 );
+
+        int16x8_t spatial_pred = vshrq_n_s16( vaddq_s16( c, e ), 1 );
+        int16x8_t spatial_score = vsubq_s16(
+                yadif_score_neon( &cur[x], mrefs, prefs, 0 ), vdupq_n_s16( 1 ) );
+
+        for( int j = -1; j <= 1; j += 2 )
+        {
+            int16x8_t score = yadif_score_neon( &cur[x], mrefs, prefs, j );
+            uint16x8_t better = vcgtq_s16( spatial_score, score );
+            spatial_score = vbslq_s16( better, score, spatial_score );
+            spatial_pred = vbslq_s16( better,
+                    yadif_pred_neon( &cur[x], mrefs, prefs, j ), spatial_pred );
+
+            score = yadif_score_neon( &cur[x], mrefs, prefs, 2 * j );
+            better = vandq_u16( better, vcgtq_s16( spatial_score, score ) );
+            spatial_score = vbslq_s16( better, score, spatial_score );
+            spatial_pred = vbslq_s16( better,
+                    yadif_pred_neon( &cur[x], mrefs, prefs, 2 * j ), spatial_pred );
+        }
+
+        if( mode < 2 )
+        {
+            const int16x8_t b = vshrq_n_s16( vaddq_s16(
+                    LOAD_NEON( &prev2[2 * mrefs + x] ),
+                    LOAD_NEON( &next2[2 * mrefs + x] ) ), 1 );
+            const int16x8_t f = vshrq_n_s16( vaddq_s16(
+                    LOAD_NEON( &prev2[2 * prefs + x] ),
+                    LOAD_NEON( &next2[2 * prefs + x] ) ), 1 );
+            const int16x8_t de = vsubq_s16( d, e );
+            const int16x8_t dc = vsubq_s16( d, c );
+            const int16x8_t bc = vsubq_s16( b, c );
+            const int16x8_t fe = vsubq_s16( f, e );
+            const int16x8_t max = vmaxq_s16( vmaxq_s16( de, dc ),
+                                             vminq_s16( bc, fe ) );
+            const int16x8_t min = vminq_s16( vminq_s16( de, dc ),
+                                             vmaxq_s16( bc, fe ) );
+            diff = vmaxq_s16( vmaxq_s16( diff, min ), vnegq_s16( max ) );
+        }
+
+        spatial_pred = vminq_s16( vmaxq_s16( spatial_pred, vsubq_s16( d, diff ) ),
+                                  vaddq_s16( d, diff ) );
+        vst1_u8( &dst[x], vqmovun_s16( spatial_pred ) );
+    }
+
+    if( x < w )
+        yadif_filter_line_c( &dst[x], &prev[x], &cur[x], &next[x], w - x,
+                             prefs, mrefs, parity, mode );
+}
+#undef LOAD_NEON
+#endif
+
+/* Slices are at least that many lines high, so that the threads are not
+ * woken up for small pictures */
+#define SLICE_MIN_HEIGHT (32)
+
+/* Filters the lines of the slice i_slice out of i_slices, of every plane */
+static void FilterSlice( filter_t *p_filter, picture_t *p_dst, int i_field,
+                         int yadif_parity, unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const yadif_filter_line_t filter = p_sys->yadif.pf_filter_line;
+
+    picture_t *p_prev = p_sys->context.pp_history[0];
+    picture_t *p_cur  = p_sys->context.pp_history[1];
+    picture_t *p_next = p_sys->context.pp_history[2];
+
+    for( int n = 0; n < p_dst->i_planes; n++ )
+    {
+        const plane_t *prevp = &p_prev->p[n];
+        const plane_t *curp  = &p_cur->p[n];
+        const plane_t *nextp = &p_next->p[n];
+        plane_t *dstp        = &p_dst->p[n];
+
+        /* The first and last lines are duplicated from their neighbours */
+        const int i_lines = dstp->i_visible_lines;
+        const int i_first = __MAX( 1, i_lines * (int)i_slice / (int)i_slices );
+        const int i_last  = __MIN( i_lines - 1,
+                                   i_lines * (int)(i_slice + 1) / (int)i_slices );
+
+        for( int y = i_first; y < i_last; y++ )
+        {
+            if( (y % 2) == i_field  ||  yadif_parity == 2 )
+            {
+                memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                            &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+            }
+            else
+            {
+                int mode;
+                /* Spatial checks only when enough data */
+                mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+                assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+                filter( &dstp->p_pixels[y * dstp->i_pitch],
+                        &prevp->p_pixels[y * prevp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch],
+                        &nextp->p_pixels[y * nextp->i_pitch],
+                        dstp->i_visible_pitch,
+                        y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                        y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                        yadif_parity,
+                        mode );
+            }
+
+            /* We duplicate the first and last lines */
+            if( y == 1 )
+                memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+            else if( y == dstp->i_visible_lines - 2 )
+                memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+        }
+    }
+}
+
+/* Filters the slices of the current field until there are none left.
+ * Called with the lock held. */
+static void FilterPendingSlices( filter_t *p_filter )
+{
+    yadif_sys_t *p_yadif = &((filter_sys_t *)p_filter->p_sys)->yadif;
+
+    while( p_yadif->i_next < p_yadif->i_jobs )
+    {
+        const unsigned i_slice = p_yadif->i_next++;
+        picture_t *p_dst = p_yadif->p_dst;
+        const int i_field = p_yadif->i_field;
+        const int i_parity = p_yadif->i_parity;
+        const unsigned i_slices = p_yadif->i_jobs;
+
+        vlc_mutex_unlock( &p_yadif->lock );
+        FilterSlice( p_filter, p_dst, i_field, i_parity, i_slice, i_slices );
+        vlc_mutex_lock( &p_yadif->lock );
+
+        if( --p_yadif->i_pending == 0 )
+            vlc_cond_signal( &p_yadif->done );
+    }
+}
+
+static void *Worker( void *data )
+{
+    filter_t *p_filter = data;
+    yadif_sys_t *p_yadif = &((filter_sys_t *)p_filter->p_sys)->yadif;
+
+    vlc_mutex_lock( &p_yadif->lock );
+    while( !p_yadif->b_quit )
+    {
+        if( p_yadif->i_next < p_yadif->i_jobs )
+            FilterPendingSlices( p_filter );
+        else
+            vlc_cond_wait( &p_yadif->wait, &p_yadif->lock );
+    }
+    vlc_mutex_unlock( &p_yadif->lock );
+    return NULL;
+}
+
+static void FilterSlices( filter_t *p_filter, picture_t *p_dst, int i_field,
+                          int yadif_parity )
+{
+    yadif_sys_t *p_yadif = &((filter_sys_t *)p_filter->p_sys)->yadif;
+
+    unsigned i_slices = __MIN( p_yadif->i_threads + 1,
+                    (unsigned)p_dst->p[0].i_visible_lines / SLICE_MIN_HEIGHT );
+    if( i_slices <= 1 )
+    {
+        FilterSlice( p_filter, p_dst, i_field, yadif_parity, 0, 1 );
+        return;
+    }
+
+    vlc_mutex_lock( &p_yadif->lock );
+    p_yadif->p_dst = p_dst;
+    p_yadif->i_field = i_field;
+    p_yadif->i_parity = yadif_parity;
+    p_yadif->i_next = 0;
+    p_yadif->i_jobs = i_slices;
+    p_yadif->i_pending = i_slices;
+    vlc_cond_broadcast( &p_yadif->wait );
+
+    FilterPendingSlices( p_filter );
+    while( p_yadif->i_pending > 0 )
+        vlc_cond_wait( &p_yadif->done, &p_yadif->lock );
+
+    p_yadif->i_jobs = 0;
+    vlc_mutex_unlock( &p_yadif->lock );
+}
+
+int YadifInit( filter_t *p_filter, unsigned i_threads )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    yadif_sys_t *p_yadif = &p_sys->yadif;
+
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX2() )
+        p_yadif->pf_filter_line = yadif_filter_line_avx2;
+    else
+#endif
+#if defined(HAVE_X86ASM)
+    if( vlc_CPU_SSSE3() )
+        p_yadif->pf_filter_line = vlcpriv_yadif_filter_line_ssse3;
+    else
+    if( vlc_CPU_SSE2() )
+        p_yadif->pf_filter_line = vlcpriv_yadif_filter_line_sse2;
+    else
+#if defined(__i386__)
+    if( vlc_CPU_MMXEXT() )
+        p_yadif->pf_filter_line = vlcpriv_yadif_filter_line_mmxext;
+    else
+#endif
+#endif
+#if defined(CAN_COMPILE_ARM64)
+    if( vlc_CPU_ARM_NEON() )
+        p_yadif->pf_filter_line = yadif_filter_line_neon;
+    else
+#endif
+        p_yadif->pf_filter_line = yadif_filter_line_c;
+
+    if( p_sys->chroma->pixel_size == 2 )
+        p_yadif->pf_filter_line = yadif_filter_line_c_16bit;
+
+    vlc_mutex_init( &p_yadif->lock );
+    vlc_cond_init( &p_yadif->wait );
+    vlc_cond_init( &p_yadif->done );
+    p_yadif->b_quit = false;
+    p_yadif->i_next = p_yadif->i_jobs = p_yadif->i_pending = 0;
+    p_yadif->p_threads = NULL;
+    p_yadif->i_threads = 0;
+
+    /* The filter thread filters a slice too */
+    if( i_threads == 0 )
+        i_threads = __MIN( vlc_GetCPUCount(), 16 );
+    if( --i_threads == 0 )
+        return VLC_SUCCESS;
+
+    p_yadif->p_threads = vlc_alloc( i_threads, sizeof(vlc_thread_t) );
+    if( !p_yadif->p_threads )
+        return VLC_ENOMEM;
+
+    /* Missing workers only make the filtering slower, since the filter
+     * thread filters the slices left */
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        if( vlc_clone( &p_yadif->p_threads[i], Worker, p_filter,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        {
+            msg_Warn( p_filter, "could only start %u of %u threads",
+                      i, i_threads );
+            break;
+        }
+        p_yadif->i_threads++;
+    }
+    return VLC_SUCCESS;
+}
+
+void YadifClean( filter_t *p_filter )
+{
+    yadif_sys_t *p_yadif = &((filter_sys_t *)p_filter->p_sys)->yadif;
+
+    vlc_mutex_lock( &p_yadif->lock );
+    p_yadif->b_quit = true;
+    vlc_cond_broadcast( &p_yadif->wait );
+    vlc_mutex_unlock( &p_yadif->lock );
+
+    for( unsigned i = 0; i < p_yadif->i_threads; i++ )
+        vlc_join( p_yadif->p_threads[i], NULL );
+    free( p_yadif->p_threads );
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -108,71 +545,7 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
-
-#if defined(HAVE_X86ASM)
-        if( vlc_CPU_SSSE3() )
-            filter = vlcpriv_yadif_filter_line_ssse3;
-        else
-        if( vlc_CPU_SSE2() )
-            filter = vlcpriv_yadif_filter_line_sse2;
-        else
-#if defined(__i386__)
-        if( vlc_CPU_MMXEXT() )
-            filter = vlcpriv_yadif_filter_line_mmxext;
-        else
-#endif
-#endif
-            filter = yadif_filter_line_c;
-
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
-
-        for( int n = 0; n < p_dst->i_planes; n++ )
-        {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
-        }
+        FilterSlices( p_filter, p_dst, i_field, yadif_parity );
 
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
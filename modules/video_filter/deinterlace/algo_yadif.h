@@ -34,10 +34,59 @@
 struct filter_t;
 struct picture_t;
 
+/*****************************************************************************
+ * Data structures
+ *****************************************************************************/
+
+/** Yadif line filter: C, SSE2, SSSE3, AVX2, NEON, ... */
+typedef void (*yadif_filter_line_t)( uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                     uint8_t *next, int w, int prefs, int mrefs,
+                                     int parity, int mode );
+
+/** Algorithm-specific state for Yadif. */
+typedef struct
+{
+    yadif_filter_line_t pf_filter_line;
+
+    /* Workers filtering slices of the field along with the filter thread */
+    vlc_thread_t *p_threads;
+    unsigned i_threads;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    vlc_cond_t done;
+    bool b_quit;
+
+    /* current field, protected by lock */
+    picture_t *p_dst;
+    int i_field;
+    int i_parity;
+    unsigned i_next;    /* next slice to filter */
+    unsigned i_jobs;    /* slices of the field */
+    unsigned i_pending; /* slices not filtered yet */
+} yadif_sys_t;
+
 /*****************************************************************************
  * Functions
  *****************************************************************************/
 
+/**
+ * Sets up the Yadif state: selects the line filter for the CPU and the pixel
+ * size, and starts the threads filtering the slices of the fields.
+ *
+ * @param p_filter The filter instance. Must be non-NULL.
+ * @param i_threads Number of threads filtering a field, 0 for one per CPU.
+ * @return VLC error code (int).
+ * @see YadifClean()
+ */
+int YadifInit( filter_t *p_filter, unsigned i_threads );
+
+/**
+ * Stops the threads started by YadifInit().
+ *
+ * @param p_filter The filter instance. Must be non-NULL.
+ */
+void YadifClean( filter_t *p_filter );
+
 /**
  * Yadif (Yet Another DeInterlacing Filter) from FFmpeg.
  * One field is copied as-is (i_field), the other is interpolated.
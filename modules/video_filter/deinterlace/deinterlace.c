@@ -294,6 +294,10 @@ static void Close( vlc_object_t *p_this );
                                     "in the Phosphor framerate doubler. "\
                                     "Default: Low.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads filtering the pictures by "\
+                            "slices with Yadif, 0 for one per CPU.")
+
 vlc_module_begin ()
     set_description( N_("Deinterlacing video filter") )
     set_shortname( N_("Deinterlace" ))
@@ -313,6 +317,9 @@ vlc_module_begin ()
                 PHOSPHOR_DIMMER_LONGTEXT, true )
         change_integer_list( phosphor_dimmer_list, phosphor_dimmer_list_text )
         change_safe ()
+    add_integer_with_range( FILTER_CFG_PREFIX "threads", 0, 0, 16,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
+        change_safe ()
     add_shortcut( "deinterlace" )
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -328,7 +335,7 @@ vlc_module_end ()
  * and reading logic for them implemented in Open().
  */
 static const char *const ppsz_filter_options[] = {
-    "mode", "phosphor-chroma", "phosphor-dimmer",
+    "mode", "phosphor-chroma", "phosphor-dimmer", "threads",
     NULL
 };
 
@@ -418,6 +425,12 @@ static void SetFilterMethod( filter_t *p_filter, const char *mode, bool pack )
     msg_Err( p_filter, "unknown deinterlace mode \"%s\"", mode );
 }
 
+static bool IsYadif( const filter_sys_t *p_sys )
+{
+    return p_sys->context.pf_render_single_pic == RenderYadifSingle
+        || p_sys->context.pf_render_ordered == RenderYadif;
+}
+
 /**
  * Get the output video format of the chosen deinterlace method
  * for the given input video format.
@@ -535,6 +548,16 @@ notsupp:
     char *psz_mode = var_InheritString( p_filter, FILTER_CFG_PREFIX "mode" );
     SetFilterMethod( p_filter, psz_mode, packed );
 
+    if( IsYadif( p_sys )
+     && YadifInit( p_filter, var_GetInteger( p_filter,
+                                             FILTER_CFG_PREFIX "threads" ) ) )
+    {
+        YadifClean( p_filter );
+        free( psz_mode );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     IVTCClearState( p_filter );
 
 #if defined(CAN_COMPILE_C_ALTIVEC)
@@ -663,5 +686,7 @@ void Close( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
 
     Flush( p_filter );
+    if( IsYadif( p_filter->p_sys ) )
+        YadifClean( p_filter );
     free( p_filter->p_sys );
 }
@@ -81,6 +81,7 @@ typedef struct
     union {
         phosphor_sys_t phosphor; /**< Phosphor algorithm state. */
         ivtc_sys_t ivtc;         /**< IVTC algorithm state. */
+        yadif_sys_t yadif;       /**< Yadif algorithm state. */
     };
 } filter_sys_t;
 
@@ -44,7 +44,7 @@ static int  Create    ( vlc_object_t * );
 static void Destroy   ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
-static void FilterErase( filter_t *, picture_t *, picture_t * );
+static void FilterErase( filter_t *, picture_t * );
 static int EraseCallback( vlc_object_t *, char const *,
                           vlc_value_t, vlc_value_t, void * );
 
@@ -205,34 +205,28 @@ static void Destroy( vlc_object_t *p_this )
  *****************************************************************************/
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
-    picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_pic ) return NULL;
 
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    /* If the mask is empty: just copy the image */
+    /* The mask is erased in place: the planes are only copied if they are
+     * shared with another picture. Without mask, the picture is forwarded. */
     vlc_mutex_lock( &p_sys->lock );
     if( p_sys->p_mask )
-        FilterErase( p_filter, p_pic, p_outpic );
-    else
-        picture_CopyPixels( p_outpic, p_pic );
+    {
+        p_pic = picture_MakeWritable( p_pic );
+        if( p_pic )
+            FilterErase( p_filter, p_pic );
+    }
     vlc_mutex_unlock( &p_sys->lock );
 
-    return CopyInfoAndRelease( p_outpic, p_pic );
+    return p_pic;
 }
 
 /*****************************************************************************
  * FilterErase
  *****************************************************************************/
-static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
-                                             picture_t *p_outpic )
+static void FilterErase( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -240,12 +234,12 @@ static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
     const int i_mask_visible_pitch = p_sys->p_mask->p[A_PLANE].i_visible_pitch;
     const int i_mask_visible_lines = p_sys->p_mask->p[A_PLANE].i_visible_lines;
 
-    for( int i_plane = 0; i_plane < p_inpic->i_planes; i_plane++ )
+    for( int i_plane = 0; i_plane < p_pic->i_planes; i_plane++ )
     {
-        const int i_pitch = p_outpic->p[i_plane].i_pitch;
+        const int i_pitch = p_pic->p[i_plane].i_pitch;
         const int i_2pitch = i_pitch<<1;
-        const int i_visible_pitch = p_inpic->p[i_plane].i_visible_pitch;
-        const int i_visible_lines = p_inpic->p[i_plane].i_visible_lines;
+        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
 
         uint8_t *p_mask = p_sys->p_mask->A_PIXELS;
         int i_x = p_sys->i_x, i_y = p_sys->i_y;
@@ -254,8 +248,8 @@ static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
         int i_width  = i_mask_visible_pitch;
 
         const bool b_line_factor = ( i_plane /* U_PLANE or V_PLANE */ &&
-            !( p_inpic->format.i_chroma == VLC_CODEC_I422
-            || p_inpic->format.i_chroma == VLC_CODEC_J422 ) );
+            !( p_pic->format.i_chroma == VLC_CODEC_I422
+            || p_pic->format.i_chroma == VLC_CODEC_J422 ) );
 
         if( i_plane ) /* U_PLANE or V_PLANE */
         {
@@ -270,11 +264,8 @@ static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
         i_height = __MIN( i_visible_lines - i_y, i_height );
         i_width  = __MIN( i_visible_pitch - i_x, i_width  );
 
-        /* Copy original pixel buffer */
-        plane_CopyPixels( &p_outpic->p[i_plane], &p_inpic->p[i_plane] );
-
         /* Horizontal linear interpolation of masked areas */
-        uint8_t *p_outpix = p_outpic->p[i_plane].p_pixels + i_y*i_pitch + i_x;
+        uint8_t *p_outpix = p_pic->p[i_plane].p_pixels + i_y*i_pitch + i_x;
         for( int y = 0; y < i_height;
              y++, p_mask += i_mask_pitch, p_outpix += i_pitch )
         {
@@ -382,7 +373,7 @@ static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
         /* Make sure that we start at least 2 lines from the top (since our
          * bluring algorithm uses the 2 previous lines) */
         int y = __MAX(i_y,2);
-        p_outpix = p_outpic->p[i_plane].p_pixels + (i_y+y)*i_pitch + i_x;
+        p_outpix = p_pic->p[i_plane].p_pixels + (i_y+y)*i_pitch + i_x;
         for( ; y < i_height; y++, p_mask += i_mask_pitch, p_outpix += i_pitch )
         {
             for( int x = 0; x < i_width; x++ )
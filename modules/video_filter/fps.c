@@ -28,10 +28,20 @@
 # include "config.h"
 #endif
 
+#include <limits.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#ifdef CAN_COMPILE_SSE2
+# include <emmintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
 
 static int Open( vlc_object_t *p_this);
 static void Close( vlc_object_t *p_this);
@@ -41,6 +51,21 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture);
 
 #define FPS_TEXT N_( "Frame rate" )
 
+#define INTERPOLATE_TEXT N_( "Motion compensated interpolation" )
+#define INTERPOLATE_LONGTEXT N_( "Interpolate the added frames along the " \
+    "motion between the surrounding ones, rather than repeating frames, " \
+    "when the frame rate increases (planar 8-bit YUV only)." )
+#define QUALITY_TEXT N_( "Interpolation quality" )
+#define QUALITY_LONGTEXT N_( "Larger search ranges follow faster motion, " \
+    "smaller blocks follow smaller objects, both at the expense of speed." )
+
+static const int pi_quality_values[] = { 0, 1, 2 };
+static const char *const ppsz_quality_texts[] = {
+    N_("Fast (16x16 blocks, 8 pixels range)"),
+    N_("Normal (16x16 blocks, 16 pixels range)"),
+    N_("High (8x8 blocks, 32 pixels range)"),
+};
+
 vlc_module_begin ()
     set_description( N_("FPS conversion video filter") )
     set_shortname( N_("FPS Converter" ))
@@ -50,23 +75,502 @@ vlc_module_begin ()
 
     add_shortcut( "fps" )
     add_string( CFG_PREFIX "fps", NULL, FPS_TEXT, FPS_TEXT, false )
+    add_bool( CFG_PREFIX "interpolate", false, INTERPOLATE_TEXT,
+              INTERPOLATE_LONGTEXT, false )
+    add_integer( CFG_PREFIX "quality", 1, QUALITY_TEXT, QUALITY_LONGTEXT,
+                 false )
+        change_integer_list( pi_quality_values, ppsz_quality_texts )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "fps",
+    "fps", "interpolate", "quality",
     NULL
 };
 
+/* Block side, in luma pixels, and search range, in luma pixels between the
+ * two pictures, of each quality */
+static const struct
+{
+    unsigned i_block;
+    int      i_range;
+} mc_qualities[] = {
+    { 16, 8 },
+    { 16, 16 },
+    { 8, 32 },
+};
+
+/* Half of the motion between the two pictures, from the middle time
+ * (the vectors only have even coordinates) */
+typedef struct
+{
+    int8_t x;
+    int8_t y;
+} mc_vector_t;
+
+/* Mean absolute difference of a block above which its motion is not
+ * trusted: the pictures are blended where it is */
+#define MC_FALLBACK_DIFF 24
+
 /* We'll store pointer for previous picture we have received
    and copy that if needed on framerate increase (not preferred)*/
 typedef struct
 {
     date_t          next_output_pts; /**< output calculated PTS */
     picture_t       *p_previous_pic;
+    vlc_tick_t      i_previous_date; /**< original date of p_previous_pic */
     vlc_tick_t      i_output_frame_interval;
+
+    /* Motion compensated interpolation */
+    bool            b_interpolate;
+    struct
+    {
+        unsigned     i_block;
+        int          i_range; /**< maximum half vector coordinate */
+        unsigned     i_blocks_x;
+        unsigned     i_blocks_y;
+        int          pi_div_x[PICTURE_PLANE_MAX]; /**< plane subsampling */
+        int          pi_div_y[PICTURE_PLANE_MAX];
+        bool         b_estimated; /**< for the current input pictures */
+        mc_vector_t *p_vectors; /**< of the current input pictures */
+        mc_vector_t *p_predictors; /**< of the previous input pictures */
+        unsigned    *p_sad;
+
+        unsigned (*pf_sad)( const uint8_t *, ptrdiff_t, const uint8_t *,
+                            ptrdiff_t, unsigned );
+        void (*pf_blend)( uint8_t *, const uint8_t *, const uint8_t *,
+                          unsigned, unsigned );
+    } mc;
 } filter_sys_t;
 
+/*****************************************************************************
+ * Motion estimation and compensation
+ *****************************************************************************
+ * The motion is estimated once per pair of input pictures, for the blocks
+ * of a picture in the middle time: each vector links a block of the
+ * previous picture to a block of the current one, symmetrically around the
+ * interpolated block. The candidates are the vectors of the neighbour
+ * blocks or of the previous pair, refined with a logarithmic search.
+ *
+ * The interpolated pictures then blend both blocks, moved in proportion of
+ * their distance to the output date.
+ *****************************************************************************/
+
+static unsigned BlockSAD( const uint8_t *p_a, ptrdiff_t i_a_pitch,
+                          const uint8_t *p_b, ptrdiff_t i_b_pitch,
+                          unsigned i_size )
+{
+    unsigned i_sad = 0;
+    for( unsigned y = 0; y < i_size; y++ )
+        for( unsigned x = 0; x < i_size; x++ )
+            i_sad += abs( p_a[y * i_a_pitch + x] - p_b[y * i_b_pitch + x] );
+    return i_sad;
+}
+
+/* Weight of b from 1 to 255 */
+static void Blend( uint8_t *p_dst, const uint8_t *p_a, const uint8_t *p_b,
+                   unsigned i_width, unsigned i_weight )
+{
+    for( unsigned x = 0; x < i_width; x++ )
+        p_dst[x] = ( p_a[x] * ( 256 - i_weight ) + p_b[x] * i_weight
+                     + 128 ) >> 8;
+}
+
+#ifdef CAN_COMPILE_SSE2
+VLC_SSE
+static unsigned BlockSADSSE2( const uint8_t *p_a, ptrdiff_t i_a_pitch,
+                              const uint8_t *p_b, ptrdiff_t i_b_pitch,
+                              unsigned i_size )
+{
+    __m128i sad = _mm_setzero_si128();
+
+    if( i_size == 16 )
+    {
+        for( unsigned y = 0; y < 16; y++ )
+            sad = _mm_add_epi64( sad, _mm_sad_epu8(
+                _mm_loadu_si128( (const __m128i *)&p_a[y * i_a_pitch] ),
+                _mm_loadu_si128( (const __m128i *)&p_b[y * i_b_pitch] ) ) );
+        sad = _mm_add_epi64( sad, _mm_srli_si128( sad, 8 ) );
+    }
+    else
+    {
+        for( unsigned y = 0; y < i_size; y++ )
+            sad = _mm_add_epi64( sad, _mm_sad_epu8(
+                _mm_loadl_epi64( (const __m128i *)&p_a[y * i_a_pitch] ),
+                _mm_loadl_epi64( (const __m128i *)&p_b[y * i_b_pitch] ) ) );
+    }
+    return _mm_cvtsi128_si32( sad );
+}
+
+VLC_SSE
+static void BlendSSE2( uint8_t *p_dst, const uint8_t *p_a, const uint8_t *p_b,
+                       unsigned i_width, unsigned i_weight )
+{
+    const __m128i wa = _mm_set1_epi16( 256 - i_weight );
+    const __m128i wb = _mm_set1_epi16( i_weight );
+    const __m128i round = _mm_set1_epi16( 128 );
+    const __m128i zero = _mm_setzero_si128();
+    unsigned x = 0;
+
+    for( ; x + 16 <= i_width; x += 16 )
+    {
+        const __m128i a = _mm_loadu_si128( (const __m128i *)&p_a[x] );
+        const __m128i b = _mm_loadu_si128( (const __m128i *)&p_b[x] );
+        /* at most 255 * 256 + 128: no overflow of the unsigned words */
+        const __m128i lo = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16(
+            _mm_mullo_epi16( _mm_unpacklo_epi8( a, zero ), wa ),
+            _mm_mullo_epi16( _mm_unpacklo_epi8( b, zero ), wb ) ), round ), 8 );
+        const __m128i hi = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16(
+            _mm_mullo_epi16( _mm_unpackhi_epi8( a, zero ), wa ),
+            _mm_mullo_epi16( _mm_unpackhi_epi8( b, zero ), wb ) ), round ), 8 );
+        _mm_storeu_si128( (__m128i *)&p_dst[x], _mm_packus_epi16( lo, hi ) );
+    }
+    Blend( &p_dst[x], &p_a[x], &p_b[x], i_width - x, i_weight );
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static unsigned BlockSADNEON( const uint8_t *p_a, ptrdiff_t i_a_pitch,
+                              const uint8_t *p_b, ptrdiff_t i_b_pitch,
+                              unsigned i_size )
+{
+    uint16x8_t sad = vdupq_n_u16( 0 );
+
+    if( i_size == 16 )
+    {
+        for( unsigned y = 0; y < 16; y++ )
+        {
+            const uint8x16_t a = vld1q_u8( &p_a[y * i_a_pitch] );
+            const uint8x16_t b = vld1q_u8( &p_b[y * i_b_pitch] );
+            sad = vabal_u8( sad, vget_low_u8( a ), vget_low_u8( b ) );
+            sad = vabal_u8( sad, vget_high_u8( a ), vget_high_u8( b ) );
+        }
+    }
+    else
+    {
+        for( unsigned y = 0; y < i_size; y++ )
+            sad = vabal_u8( sad, vld1_u8( &p_a[y * i_a_pitch] ),
+                            vld1_u8( &p_b[y * i_b_pitch] ) );
+    }
+    return vaddlvq_u16( sad );
+}
+
+static void BlendNEON( uint8_t *p_dst, const uint8_t *p_a, const uint8_t *p_b,
+                       unsigned i_width, unsigned i_weight )
+{
+    const uint8x8_t wa = vdup_n_u8( 256 - i_weight );
+    const uint8x8_t wb = vdup_n_u8( i_weight );
+    unsigned x = 0;
+
+    for( ; x + 16 <= i_width; x += 16 )
+    {
+        const uint8x16_t a = vld1q_u8( &p_a[x] );
+        const uint8x16_t b = vld1q_u8( &p_b[x] );
+        const uint16x8_t lo = vmlal_u8( vmull_u8( vget_low_u8( a ), wa ),
+                                        vget_low_u8( b ), wb );
+        const uint16x8_t hi = vmlal_u8( vmull_u8( vget_high_u8( a ), wa ),
+                                        vget_high_u8( b ), wb );
+        vst1q_u8( &p_dst[x], vcombine_u8( vrshrn_n_u16( lo, 8 ),
+                                          vrshrn_n_u16( hi, 8 ) ) );
+    }
+    Blend( &p_dst[x], &p_a[x], &p_b[x], i_width - x, i_weight );
+}
+#endif
+
+typedef struct
+{
+    const picture_t *p_prev;
+    const picture_t *p_cur;
+    picture_t       *p_out;
+    unsigned        i_weight; /**< of the current picture, from 1 to 255 */
+} mc_job_t;
+
+/* The block rows starting in the lines of a slice */
+static void GetSliceBlocks( filter_sys_t *p_sys, int i_lines, unsigned slice,
+                            unsigned slices, unsigned *pi_first,
+                            unsigned *pi_end )
+{
+    const unsigned i_block = p_sys->mc.i_block;
+    int first, end;
+
+    filter_GetSliceLines( i_lines, slice, slices, &first, &end );
+    *pi_first = ( first + i_block - 1 ) / i_block;
+    *pi_end = __MIN( ( end + i_block - 1 ) / i_block, p_sys->mc.i_blocks_y );
+}
+
+/* Cost of a half vector, or UINT_MAX if a block is outside the pictures */
+static unsigned VectorCost( filter_sys_t *p_sys, const plane_t *p_prev,
+                            const plane_t *p_cur, int x, int y, int hx, int hy,
+                            unsigned *pi_sad )
+{
+    const int i_block = p_sys->mc.i_block;
+    const int i_range = p_sys->mc.i_range;
+
+    if( abs( hx ) > i_range || abs( hy ) > i_range
+     || x - abs( hx ) < 0 || x + abs( hx ) + i_block > p_cur->i_visible_pitch
+     || y - abs( hy ) < 0 || y + abs( hy ) + i_block > p_cur->i_visible_lines )
+        return UINT_MAX;
+
+    const unsigned i_sad = p_sys->mc.pf_sad(
+        &p_prev->p_pixels[( y - hy ) * p_prev->i_pitch + x - hx], p_prev->i_pitch,
+        &p_cur->p_pixels[( y + hy ) * p_cur->i_pitch + x + hx], p_cur->i_pitch,
+        i_block );
+    *pi_sad = i_sad;
+    /* favour short vectors, for a smoother motion field */
+    return i_sad + ( abs( hx ) + abs( hy ) ) * i_block * i_block / 32;
+}
+
+static void EstimateSlice( filter_t *p_filter, void *p_data,
+                           unsigned slice, unsigned slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const mc_job_t *p_job = p_data;
+    const plane_t *p_prev = &p_job->p_prev->p[Y_PLANE];
+    const plane_t *p_cur = &p_job->p_cur->p[Y_PLANE];
+    const unsigned i_bx = p_sys->mc.i_blocks_x, i_by = p_sys->mc.i_blocks_y;
+    const int i_block = p_sys->mc.i_block;
+    unsigned first, end;
+
+    GetSliceBlocks( p_sys, p_cur->i_visible_lines, slice, slices,
+                    &first, &end );
+
+    for( unsigned by = first; by < end; by++ )
+    {
+        for( unsigned bx = 0; bx < i_bx; bx++ )
+        {
+            const int x = bx * i_block, y = by * i_block;
+            const mc_vector_t *p_pred = p_sys->mc.p_predictors;
+            mc_vector_t candidates[5] = { { 0, 0 } };
+            unsigned i_candidates = 1;
+
+            /* only the blocks of this slice and of the previous pair, so
+             * that the vectors do not depend on the slices */
+            if( bx > 0 )
+                candidates[i_candidates++] = p_sys->mc.p_vectors[by * i_bx + bx - 1];
+            candidates[i_candidates++] = p_pred[by * i_bx + bx];
+            if( bx + 1 < i_bx )
+                candidates[i_candidates++] = p_pred[by * i_bx + bx + 1];
+            if( by + 1 < i_by )
+                candidates[i_candidates++] = p_pred[( by + 1 ) * i_bx + bx];
+
+            int hx = 0, hy = 0;
+            unsigned i_sad = 0;
+            unsigned i_best = VectorCost( p_sys, p_prev, p_cur, x, y, 0, 0,
+                                          &i_sad );
+            for( unsigned i = 1; i < i_candidates; i++ )
+            {
+                unsigned i_cand_sad;
+                const unsigned i_cost = VectorCost( p_sys, p_prev, p_cur, x, y,
+                                                    candidates[i].x,
+                                                    candidates[i].y,
+                                                    &i_cand_sad );
+                if( i_cost < i_best )
+                {
+                    i_best = i_cost;
+                    i_sad = i_cand_sad;
+                    hx = candidates[i].x;
+                    hy = candidates[i].y;
+                }
+            }
+
+            /* logarithmic search around the best candidate */
+            for( int i_step = ( p_sys->mc.i_range + 1 ) / 2; i_step > 0;
+                 i_step /= 2 )
+            {
+                const int cx = hx, cy = hy;
+                for( int dy = -i_step; dy <= i_step; dy += i_step )
+                    for( int dx = -i_step; dx <= i_step; dx += i_step )
+                    {
+                        unsigned i_cand_sad;
+                        const unsigned i_cost =
+                            VectorCost( p_sys, p_prev, p_cur, x, y,
+                                        cx + dx, cy + dy, &i_cand_sad );
+                        if( i_cost < i_best )
+                        {
+                            i_best = i_cost;
+                            i_sad = i_cand_sad;
+                            hx = cx + dx;
+                            hy = cy + dy;
+                        }
+                    }
+            }
+
+            p_sys->mc.p_vectors[by * i_bx + bx] = (mc_vector_t){ hx, hy };
+            p_sys->mc.p_sad[by * i_bx + bx] = i_sad;
+        }
+    }
+}
+
+static int RoundDiv( int n, int d )
+{
+    return n >= 0 ? ( n + d / 2 ) / d : -( ( -n + d / 2 ) / d );
+}
+
+static void CompensateSlice( filter_t *p_filter, void *p_data,
+                             unsigned slice, unsigned slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const mc_job_t *p_job = p_data;
+    const unsigned i_bx = p_sys->mc.i_blocks_x, i_by = p_sys->mc.i_blocks_y;
+    const unsigned i_block = p_sys->mc.i_block;
+    const unsigned w = p_job->i_weight;
+    const plane_t *p_luma = &p_job->p_cur->p[Y_PLANE];
+    unsigned first, end;
+
+    GetSliceBlocks( p_sys, p_luma->i_visible_lines, slice, slices,
+                    &first, &end );
+
+    for( int i = 0; i < p_job->p_out->i_planes; i++ )
+    {
+        const plane_t *p_prev = &p_job->p_prev->p[i];
+        const plane_t *p_cur = &p_job->p_cur->p[i];
+        plane_t *p_out = &p_job->p_out->p[i];
+        const int i_width = p_out->i_visible_pitch;
+        const int i_height = p_out->i_visible_lines;
+        const int sx = p_sys->mc.pi_div_x[i];
+        const int sy = p_sys->mc.pi_div_y[i];
+
+        for( unsigned by = first; by < end; by++ )
+        {
+            const int y0 = by * i_block / sy;
+            const int y1 = by + 1 == i_by ? i_height
+                                          : (int)( ( by + 1 ) * i_block / sy );
+
+            for( unsigned bx = 0; bx < i_bx; bx++ )
+            {
+                const int x0 = bx * i_block / sx;
+                const int x1 = bx + 1 == i_bx ? i_width
+                                              : (int)( ( bx + 1 ) * i_block / sx );
+                mc_vector_t v = p_sys->mc.p_vectors[by * i_bx + bx];
+
+                if( p_sys->mc.p_sad[by * i_bx + bx]
+                        > MC_FALLBACK_DIFF * i_block * i_block )
+                    v = (mc_vector_t){ 0, 0 };
+
+                /* the vector goes from the previous to the current picture:
+                 * 2 * v in luma pixels */
+                const int px = VLC_CLIP( x0 - RoundDiv( 2 * v.x * (int)w, 256 * sx ),
+                                         0, i_width - ( x1 - x0 ) );
+                const int py = VLC_CLIP( y0 - RoundDiv( 2 * v.y * (int)w, 256 * sy ),
+                                         0, i_height - ( y1 - y0 ) );
+                const int cx = VLC_CLIP( x0 + RoundDiv( 2 * v.x * (int)( 256 - w ), 256 * sx ),
+                                         0, i_width - ( x1 - x0 ) );
+                const int cy = VLC_CLIP( y0 + RoundDiv( 2 * v.y * (int)( 256 - w ), 256 * sy ),
+                                         0, i_height - ( y1 - y0 ) );
+
+                for( int y = 0; y < y1 - y0; y++ )
+                    p_sys->mc.pf_blend(
+                        &p_out->p_pixels[( y0 + y ) * p_out->i_pitch + x0],
+                        &p_prev->p_pixels[( py + y ) * p_prev->i_pitch + px],
+                        &p_cur->p_pixels[( cy + y ) * p_cur->i_pitch + cx],
+                        x1 - x0, w );
+            }
+        }
+    }
+}
+
+/* Interpolates the picture at the given date, or returns NULL to repeat the
+ * previous picture */
+static picture_t *Interpolate( filter_t *p_filter, picture_t *p_prev,
+                               picture_t *p_cur, vlc_tick_t i_date )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const vlc_tick_t i_prev_date = p_sys->i_previous_date;
+
+    if( i_date <= i_prev_date || i_date >= p_cur->date )
+        return NULL;
+
+    const unsigned i_weight = __MIN( ( i_date - i_prev_date ) * 256
+                                     / ( p_cur->date - i_prev_date ), 255 );
+    if( i_weight == 0 )
+        return NULL;
+
+    picture_t *p_out = picture_NewFromFormat( &p_filter->fmt_out.video );
+    if( p_out == NULL )
+        return NULL;
+    picture_CopyProperties( p_out, p_prev );
+
+    mc_job_t job = {
+        .p_prev = p_prev, .p_cur = p_cur, .p_out = p_out, .i_weight = i_weight,
+    };
+    const unsigned i_lines = p_cur->p[Y_PLANE].i_visible_lines;
+
+    if( !p_sys->mc.b_estimated )
+    {
+        mc_vector_t *p_vectors = p_sys->mc.p_vectors;
+        p_sys->mc.p_vectors = p_sys->mc.p_predictors;
+        p_sys->mc.p_predictors = p_vectors;
+        filter_RunSlices( p_filter, i_lines, EstimateSlice, &job );
+        p_sys->mc.b_estimated = true;
+    }
+    filter_RunSlices( p_filter, i_lines, CompensateSlice, &job );
+    return p_out;
+}
+
+static int OpenInterpolation( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmt = &p_filter->fmt_in.video;
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( p_fmt->i_chroma );
+
+    if( p_dsc == NULL || p_dsc->pixel_size != 1 || p_dsc->plane_count < 3
+     || !vlc_fourcc_IsYUV( p_fmt->i_chroma ) )
+    {
+        msg_Warn( p_filter, "Cannot interpolate %4.4s pictures",
+                  (const char *)&p_fmt->i_chroma );
+        return VLC_EGENERIC;
+    }
+
+    unsigned i_quality = var_InheritInteger( p_filter, CFG_PREFIX "quality" );
+    i_quality = __MIN( i_quality, ARRAY_SIZE(mc_qualities) - 1 );
+    p_sys->mc.i_block = mc_qualities[i_quality].i_block;
+    p_sys->mc.i_range = mc_qualities[i_quality].i_range / 2;
+    p_sys->mc.i_blocks_x = p_fmt->i_visible_width / p_sys->mc.i_block;
+    p_sys->mc.i_blocks_y = p_fmt->i_visible_height / p_sys->mc.i_block;
+    if( p_sys->mc.i_blocks_x == 0 || p_sys->mc.i_blocks_y == 0 )
+        return VLC_EGENERIC;
+    for( unsigned i = 0; i < p_dsc->plane_count; i++ )
+    {
+        p_sys->mc.pi_div_x[i] = p_dsc->p[i].w.den / p_dsc->p[i].w.num;
+        p_sys->mc.pi_div_y[i] = p_dsc->p[i].h.den / p_dsc->p[i].h.num;
+    }
+
+    const size_t i_blocks = p_sys->mc.i_blocks_x * p_sys->mc.i_blocks_y;
+    p_sys->mc.p_vectors = calloc( i_blocks, sizeof(mc_vector_t) );
+    p_sys->mc.p_predictors = calloc( i_blocks, sizeof(mc_vector_t) );
+    p_sys->mc.p_sad = vlc_alloc( i_blocks, sizeof(*p_sys->mc.p_sad) );
+    if( !p_sys->mc.p_vectors || !p_sys->mc.p_predictors || !p_sys->mc.p_sad )
+    {
+        free( p_sys->mc.p_sad );
+        free( p_sys->mc.p_predictors );
+        free( p_sys->mc.p_vectors );
+        return VLC_ENOMEM;
+    }
+    p_sys->mc.b_estimated = false;
+
+    p_sys->mc.pf_sad = BlockSAD;
+    p_sys->mc.pf_blend = Blend;
+#ifdef CAN_COMPILE_SSE2
+    if( vlc_CPU_SSE2() )
+    {
+        p_sys->mc.pf_sad = BlockSADSSE2;
+        p_sys->mc.pf_blend = BlendSSE2;
+    }
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+    {
+        p_sys->mc.pf_sad = BlockSADNEON;
+        p_sys->mc.pf_blend = BlendNEON;
+    }
+#endif
+
+    msg_Dbg( p_filter, "Interpolating with %ux%u blocks, %d pixels range",
+             p_sys->mc.i_block, p_sys->mc.i_block, 2 * p_sys->mc.i_range );
+    return VLC_SUCCESS;
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -94,6 +598,8 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
         if( p_sys->p_previous_pic )
             picture_Release( p_sys->p_previous_pic );
         p_sys->p_previous_pic = picture_Hold( p_picture );
+        p_sys->i_previous_date = p_picture->date;
+        p_sys->mc.b_estimated = false;
         date_Increment( &p_sys->next_output_pts, 1 );
         return p_picture;
     }
@@ -105,32 +611,55 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
         if( p_sys->p_previous_pic )
             picture_Release( p_sys->p_previous_pic );
         p_sys->p_previous_pic = p_picture;
+        p_sys->i_previous_date = p_picture->date;
+        p_sys->mc.b_estimated = false;
         return NULL;
     }
 
-    p_sys->p_previous_pic->date = date_Get( &p_sys->next_output_pts );
-    date_Increment( &p_sys->next_output_pts, 1 );
-
-    picture_t *last_pic = p_sys->p_previous_pic;
+    picture_t *p_prev = p_sys->p_previous_pic;
+    picture_t *p_first = NULL, *last_pic = NULL;
+    bool b_prev_output = false;
     /* Duplicating pictures are not that effective and framerate increase
         should be avoided, it's only here as filter should work in that direction too*/
-    while( unlikely( (date_Get( &p_sys->next_output_pts ) + p_sys->i_output_frame_interval ) < p_picture->date ) )
+    do
     {
+        const vlc_tick_t i_date = date_Get( &p_sys->next_output_pts );
         picture_t *p_tmp = NULL;
-        p_tmp = picture_NewFromFormat( &p_filter->fmt_out.video );
-
-        picture_Copy( p_tmp, p_sys->p_previous_pic);
-        p_tmp->date = date_Get( &p_sys->next_output_pts );
-        p_tmp->p_next = NULL;
 
-        last_pic->p_next = p_tmp;
-        last_pic = p_tmp;
+        if( p_sys->b_interpolate )
+            p_tmp = Interpolate( p_filter, p_prev, p_picture, i_date );
+        if( p_tmp == NULL && !b_prev_output )
+        {
+            p_tmp = p_prev;
+            b_prev_output = true;
+        }
+        else if( p_tmp == NULL )
+        {
+            p_tmp = picture_NewFromFormat( &p_filter->fmt_out.video );
+            if( p_tmp != NULL )
+                picture_Copy( p_tmp, p_prev );
+        }
+
+        if( p_tmp != NULL )
+        {
+            p_tmp->date = i_date;
+            p_tmp->p_next = NULL;
+            if( last_pic != NULL )
+                last_pic->p_next = p_tmp;
+            else
+                p_first = p_tmp;
+            last_pic = p_tmp;
+        }
         date_Increment( &p_sys->next_output_pts, 1 );
     }
+    while( unlikely( (date_Get( &p_sys->next_output_pts ) + p_sys->i_output_frame_interval ) < p_picture->date ) );
 
-    last_pic = p_sys->p_previous_pic;
+    if( !b_prev_output )
+        picture_Release( p_prev );
     p_sys->p_previous_pic = p_picture;
-    return last_pic;
+    p_sys->i_previous_date = p_picture->date;
+    p_sys->mc.b_estimated = false;
+    return p_first;
 }
 
 static int Open( vlc_object_t *p_this)
@@ -138,7 +667,7 @@ static int Open( vlc_object_t *p_this)
     filter_t *p_filter = (filter_t*)p_this;
     filter_sys_t *p_sys;
 
-    p_sys = p_filter->p_sys = malloc( sizeof( *p_sys ) );
+    p_sys = p_filter->p_sys = calloc( 1, sizeof( *p_sys ) );
 
     if( unlikely( !p_sys ) )
         return VLC_ENOMEM;
@@ -178,6 +707,9 @@ static int Open( vlc_object_t *p_this)
 
     p_sys->p_previous_pic = NULL;
 
+    p_sys->b_interpolate = var_InheritBool( p_filter, CFG_PREFIX "interpolate" )
+                        && OpenInterpolation( p_filter ) == VLC_SUCCESS;
+
     p_filter->pf_video_filter = Filter;
     return VLC_SUCCESS;
 }
@@ -188,5 +720,8 @@ static void Close( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
     if( p_sys->p_previous_pic )
         picture_Release( p_sys->p_previous_pic );
+    free( p_sys->mc.p_sad );
+    free( p_sys->mc.p_predictors );
+    free( p_sys->mc.p_vectors );
     free( p_sys );
 }
@@ -88,6 +88,16 @@ vlc_module_end()
 #else
 #   define HAVE_SSSE3 0
 #endif
+#ifdef HAVE_AVX2_INTRINSICS
+#   define HAVE_AVX2 1
+#else
+#   define HAVE_AVX2 0
+#endif
+#ifdef CAN_COMPILE_ARM64
+#   define HAVE_NEON64 1
+#else
+#   define HAVE_NEON64 0
+#endif
 // FIXME too restrictive
 #ifdef __x86_64__
 #   define HAVE_6REGS 1
@@ -101,6 +111,31 @@ vlc_module_end()
 static picture_t *Filter(filter_t *, picture_t *);
 static int Callback(vlc_object_t *, char const *, vlc_value_t, vlc_value_t, void *);
 
+/* Planar chromas of more than 8 bits, in the CPU endianness */
+static bool IsHighBitDepth(vlc_fourcc_t fourcc)
+{
+    switch (fourcc) {
+#ifdef WORDS_BIGENDIAN
+    case VLC_CODEC_I420_10B:
+    case VLC_CODEC_I420_12B:
+    case VLC_CODEC_I422_10B:
+    case VLC_CODEC_I422_12B:
+    case VLC_CODEC_I444_10B:
+    case VLC_CODEC_I444_12B:
+#else
+    case VLC_CODEC_I420_10L:
+    case VLC_CODEC_I420_12L:
+    case VLC_CODEC_I422_10L:
+    case VLC_CODEC_I422_12L:
+    case VLC_CODEC_I444_10L:
+    case VLC_CODEC_I444_12L:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
 typedef struct
 {
     vlc_mutex_t      lock;
@@ -116,7 +151,8 @@ static int Open(vlc_object_t *object)
     const vlc_fourcc_t fourcc = filter->fmt_in.video.i_chroma;
 
     const vlc_chroma_description_t *chroma = vlc_fourcc_GetChromaDescription(fourcc);
-    if (!chroma || chroma->plane_count < 3 || chroma->pixel_size != 1) {
+    if (!chroma || chroma->plane_count < 3 ||
+        (chroma->pixel_size != 1 && !IsHighBitDepth(fourcc))) {
         msg_Err(filter, "Unsupported chroma (%4.4s)", (char*)&fourcc);
         return VLC_EGENERIC;
     }
@@ -136,6 +172,7 @@ static int Open(vlc_object_t *object)
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
     cfg->radius      = 0;
+    cfg->depth       = chroma->pixel_bits;
     cfg->buf         = NULL;
 
 #if HAVE_SSE2 && HAVE_6REGS
@@ -156,6 +193,23 @@ static int Open(vlc_object_t *object)
 #endif
         cfg->filter_line = filter_line_c;
 
+#if HAVE_AVX2
+    if (vlc_CPU_AVX2()) {
+        cfg->blur_line16   = blur_line16_avx2;
+        cfg->filter_line16 = filter_line16_avx2;
+    } else
+#endif
+#if HAVE_NEON64
+    if (vlc_CPU_ARM_NEON()) {
+        cfg->blur_line16   = blur_line16_neon;
+        cfg->filter_line16 = filter_line16_neon;
+    } else
+#endif
+    {
+        cfg->blur_line16   = blur_line16_c;
+        cfg->filter_line16 = filter_line16_c;
+    }
+
     filter->p_sys           = sys;
     filter->pf_video_filter = Filter;
     return VLC_SUCCESS;
@@ -208,8 +262,13 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
                  cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
         r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
         if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
+            if (chroma->pixel_size == 2)
+                filter_plane16(cfg, (uint16_t *)dstp->p_pixels,
+                               (const uint16_t *)srcp->p_pixels, w, h,
+                               dstp->i_pitch / 2, srcp->i_pitch / 2, r);
+            else
+                filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
+                             w, h, dstp->i_pitch, srcp->i_pitch, r);
         } else {
             plane_CopyPixels(dstp, srcp);
         }
@@ -26,16 +26,34 @@
  * So now we have a smoothed and higher bitdepth version of all the shallow
  * gradients, while leaving detailed areas untouched.
  * Dither it back to 8bit.
+ *
+ * The samples of more than 8 bits are blurred at 8-bit precision, with
+ * the fractional bits of the sums, so that the blur works similarly, and
+ * dithered back to their depth.
  */
 
+#if HAVE_AVX2
+# include <immintrin.h>
+#endif
+#if HAVE_NEON64
+# include <arm_neon.h>
+#endif
+
 struct vf_priv_s {
     int thresh;
     int radius;
+    int depth;
     uint16_t *buf;
     void (*filter_line)(uint8_t *dst, uint8_t *src, uint16_t *dc,
                         int width, int thresh, const uint16_t *dithers);
     void (*blur_line)(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
                       uint8_t *src, int sstride, int width);
+    void (*filter_line16)(uint16_t *dst, const uint16_t *src,
+                          const uint16_t *dc, int width, int thresh,
+                          const uint16_t *dithers, int depth);
+    void (*blur_line16)(uint16_t *dc, uint16_t *buf, const uint16_t *buf1,
+                        const uint16_t *src, int sstride, int width,
+                        int depth);
 };
 
 static alignas (16) const uint16_t pw_7f[8] = {127,127,127,127,127,127,127,127};
@@ -222,6 +240,197 @@ static void blur_line_sse2(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
 }
 #endif // HAVE_6REGS && HAVE_SSE2
 
+static void filter_line16_c(uint16_t *dst, const uint16_t *src,
+                            const uint16_t *dc, int width, int thresh,
+                            const uint16_t *dithers, int depth)
+{
+    const int shift = 15 - depth, max = (1 << depth) - 1;
+
+    for( int x = 0; x < width; x++, dc += x&1 ) {
+        int pix = src[x]<<shift;
+        int delta = dc[0] - pix;
+        int m = abs(delta) * thresh >> 16;
+        m = FFMAX(0, 127-m);
+        m = m*m*delta >> 14;
+        pix += m + (dithers[x&7] >> (depth - 8));
+        dst[x] = VLC_CLIP(pix>>shift, 0, max);
+    }
+}
+
+static void blur_line16_c(uint16_t *dc, uint16_t *buf, const uint16_t *buf1,
+                          const uint16_t *src, int sstride, int width,
+                          int depth)
+{
+    const int shift = depth - 8, round = 1 << (shift - 1);
+
+    for( int x = 0; x < width; x++ ) {
+        int v = buf1[x] + ((src[2*x] + src[2*x+1] + src[2*x+sstride] +
+                            src[2*x+1+sstride] + round) >> shift);
+        int old = buf[x];
+        buf[x] = v;
+        dc[x] = v - old;
+    }
+}
+
+#if HAVE_AVX2
+VLC_AVX2
+static void filter_line16_avx2(uint16_t *dst, const uint16_t *src,
+                               const uint16_t *dc, int width, int thresh,
+                               const uint16_t *dithers, int depth)
+{
+    const int end = width & ~15;
+    const __m128i shift = _mm_cvtsi32_si128(15 - depth);
+    const __m256i vthresh = _mm256_set1_epi16(thresh);
+    const __m256i v127 = _mm256_set1_epi16(127);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16((1 << depth) - 1);
+    const __m256i dither = _mm256_srl_epi16(
+            _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)dithers)),
+            _mm_cvtsi32_si128(depth - 8));
+
+    for (int x = 0; x < end; x += 16) {
+        __m256i pix = _mm256_sll_epi16(
+                _mm256_loadu_si256((const __m256i *)&src[x]), shift);
+        /* one blurred value for 2 pixels */
+        __m256i d = _mm256_permute4x64_epi64(_mm256_castsi128_si256(
+                _mm_loadu_si128((const __m128i *)&dc[x / 2])), 0x50);
+        d = _mm256_unpacklo_epi16(d, d);
+
+        __m256i delta = _mm256_sub_epi16(d, pix);
+        __m256i m = _mm256_mulhi_epu16(_mm256_abs_epi16(delta), vthresh);
+        m = _mm256_min_epi16(_mm256_sub_epi16(m, v127), zero); // m = -max(0, 127-m)
+        m = _mm256_slli_epi16(_mm256_mullo_epi16(m, m), 1);
+        pix = _mm256_adds_epi16(pix, dither);
+        pix = _mm256_adds_epi16(pix, _mm256_mulhrs_epi16(m, delta)); // m*m*delta >> 14
+        pix = _mm256_sra_epi16(pix, shift);
+        pix = _mm256_min_epi16(_mm256_max_epi16(pix, zero), max);
+        _mm256_storeu_si256((__m256i *)&dst[x], pix);
+    }
+    if (end < width)
+        filter_line16_c(dst + end, src + end, dc + end / 2, width - end,
+                        thresh, dithers, depth);
+}
+
+VLC_AVX2
+static void blur_line16_avx2(uint16_t *dc, uint16_t *buf, const uint16_t *buf1,
+                             const uint16_t *src, int sstride, int width,
+                             int depth)
+{
+    const int end = width & ~15;
+    const __m128i shift = _mm_cvtsi32_si128(depth - 8);
+    const __m256i round = _mm256_set1_epi32(1 << (depth - 9));
+    const __m256i one = _mm256_set1_epi16(1);
+
+    for (int x = 0; x < end; x += 16) {
+        const uint16_t *s = &src[2 * x];
+        __m256i lo = _mm256_add_epi16(
+                _mm256_loadu_si256((const __m256i *)s),
+                _mm256_loadu_si256((const __m256i *)&s[sstride]));
+        __m256i hi = _mm256_add_epi16(
+                _mm256_loadu_si256((const __m256i *)&s[16]),
+                _mm256_loadu_si256((const __m256i *)&s[16 + sstride]));
+        /* sums of the pairs of columns */
+        lo = _mm256_srl_epi32(_mm256_add_epi32(_mm256_madd_epi16(lo, one), round), shift);
+        hi = _mm256_srl_epi32(_mm256_add_epi32(_mm256_madd_epi16(hi, one), round), shift);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+
+        v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i *)&buf1[x]));
+        __m256i old = _mm256_loadu_si256((const __m256i *)&buf[x]);
+        _mm256_storeu_si256((__m256i *)&buf[x], v);
+        _mm256_storeu_si256((__m256i *)&dc[x], _mm256_sub_epi16(v, old));
+    }
+    if (end < width)
+        blur_line16_c(dc + end, buf + end, buf1 + end, src + 2 * end, sstride,
+                      width - end, depth);
+}
+#endif // HAVE_AVX2
+
+#if HAVE_NEON64
+static void filter_line16_neon(uint16_t *dst, const uint16_t *src,
+                               const uint16_t *dc, int width, int thresh,
+                               const uint16_t *dithers, int depth)
+{
+    const int end = width & ~7;
+    const int16x8_t shift = vdupq_n_s16(15 - depth);
+    const int16x8_t rshift = vdupq_n_s16(depth - 15);
+    const uint16x8_t vthresh = vdupq_n_u16(thresh);
+    const int16x8_t v127 = vdupq_n_s16(127);
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t max = vdupq_n_s16((1 << depth) - 1);
+    const int16x8_t dither = vreinterpretq_s16_u16(
+            vshlq_u16(vld1q_u16(dithers), vdupq_n_s16(8 - depth)));
+
+    for (int x = 0; x < end; x += 8) {
+        int16x8_t pix = vreinterpretq_s16_u16(vshlq_u16(vld1q_u16(&src[x]), shift));
+        /* one blurred value for 2 pixels */
+        const uint16x4_t d4 = vld1_u16(&dc[x / 2]);
+        const int16x8_t d = vreinterpretq_s16_u16(
+                vcombine_u16(vzip1_u16(d4, d4), vzip2_u16(d4, d4)));
+
+        const int16x8_t delta = vsubq_s16(d, pix);
+        const uint16x8_t a = vreinterpretq_u16_s16(vabsq_s16(delta));
+        const uint16x8_t t = vcombine_u16(
+                vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(vthresh)), 16),
+                vshrn_n_u32(vmull_high_u16(a, vthresh), 16));
+        int16x8_t m = vminq_s16(vsubq_s16(vreinterpretq_s16_u16(t), v127), zero);
+        m = vshlq_n_s16(vmulq_s16(m, m), 1);
+        pix = vqaddq_s16(pix, dither);
+        pix = vqaddq_s16(pix, vqrdmulhq_s16(m, delta)); // m*m*delta >> 14
+        pix = vshlq_s16(pix, rshift);
+        pix = vminq_s16(vmaxq_s16(pix, zero), max);
+        vst1q_u16(&dst[x], vreinterpretq_u16_s16(pix));
+    }
+    if (end < width)
+        filter_line16_c(dst + end, src + end, dc + end / 2, width - end,
+                        thresh, dithers, depth);
+}
+
+static void blur_line16_neon(uint16_t *dc, uint16_t *buf, const uint16_t *buf1,
+                             const uint16_t *src, int sstride, int width,
+                             int depth)
+{
+    const int end = width & ~7;
+    const int32x4_t shift = vdupq_n_s32(8 - depth);
+    const uint32x4_t round = vdupq_n_u32(1 << (depth - 9));
+
+    for (int x = 0; x < end; x += 8) {
+        const uint16_t *s = &src[2 * x];
+        /* even and odd columns */
+        const uint16x8x2_t l0 = vld2q_u16(s);
+        const uint16x8x2_t l1 = vld2q_u16(&s[sstride]);
+        const uint16x8_t c0 = vaddq_u16(l0.val[0], l1.val[0]);
+        const uint16x8_t c1 = vaddq_u16(l0.val[1], l1.val[1]);
+        const uint32x4_t lo = vshlq_u32(vaddq_u32(vaddl_u16(vget_low_u16(c0),
+                                        vget_low_u16(c1)), round), shift);
+        const uint32x4_t hi = vshlq_u32(vaddq_u32(vaddl_high_u16(c0, c1),
+                                        round), shift);
+        const uint16x8_t v = vaddq_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)),
+                                       vld1q_u16(&buf1[x]));
+        const uint16x8_t old = vld1q_u16(&buf[x]);
+        vst1q_u16(&buf[x], v);
+        vst1q_u16(&dc[x], vsubq_u16(v, old));
+    }
+    if (end < width)
+        blur_line16_c(dc + end, buf + end, buf1 + end, src + 2 * end, sstride,
+                      width - end, depth);
+}
+#endif // HAVE_NEON64
+
+static void blur_dc(uint16_t *dc, int width, int r, uint32_t dc_factor)
+{
+    int x, v;
+    for (x=v=0; x<r; x++)
+        v += dc[x];
+    for (; x<width/2; x++) {
+        v += dc[x] - dc[x-r];
+        dc[x-r] = v * dc_factor >> 16;
+    }
+    for (; x<(width+r+1)/2; x++)
+        dc[x-r] = v * dc_factor >> 16;
+    for (x=-r/2; x<0; x++)
+        dc[x] = dc[0];
+}
+
 static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
                          int width, int height, int dstride, int sstride, int r)
 {
@@ -240,18 +449,8 @@ static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
             int mod = ((y+r)/2)%r;
             uint16_t *buf0 = buf+mod*bstride;
             uint16_t *buf1 = buf+(mod?mod-1:r-1)*bstride;
-            int x, v;
             ctx->blur_line(dc, buf0, buf1, src+(y+r)*sstride, sstride, width/2);
-            for (x=v=0; x<r; x++)
-                v += dc[x];
-            for (; x<width/2; x++) {
-                v += dc[x] - dc[x-r];
-                dc[x-r] = v * dc_factor >> 16;
-            }
-            for (; x<(width+r+1)/2; x++)
-                dc[x-r] = v * dc_factor >> 16;
-            for (x=-r/2; x<0; x++)
-                dc[x] = dc[0];
+            blur_dc(dc, width, r, dc_factor);
         }
         if (y == r) {
             for (y=0; y<r; y++)
@@ -264,3 +463,38 @@ static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
     }
 }
 
+/* Same as filter_plane() on samples of ctx->depth bits, the strides being
+ * in samples */
+static void filter_plane16(struct vf_priv_s *ctx, uint16_t *dst,
+                           const uint16_t *src, int width, int height,
+                           int dstride, int sstride, int r)
+{
+    int bstride = ((width+15)&~15)/2;
+    int y;
+    uint32_t dc_factor = (1<<21)/(r*r);
+    uint16_t *dc = ctx->buf+16;
+    uint16_t *buf = ctx->buf+bstride+32;
+    int thresh = ctx->thresh;
+    int depth = ctx->depth;
+
+    memset(dc, 0, (bstride+16)*sizeof(*buf));
+    for (y=0; y<r; y++)
+        ctx->blur_line16(dc, buf+y*bstride, buf+(y-1)*bstride, src+2*y*sstride, sstride, width/2, depth);
+    for (;;) {
+        if (y < height-r) {
+            int mod = ((y+r)/2)%r;
+            uint16_t *buf0 = buf+mod*bstride;
+            uint16_t *buf1 = buf+(mod?mod-1:r-1)*bstride;
+            ctx->blur_line16(dc, buf0, buf1, src+(y+r)*sstride, sstride, width/2, depth);
+            blur_dc(dc, width, r, dc_factor);
+        }
+        if (y == r) {
+            for (y=0; y<r; y++)
+                ctx->filter_line16(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7], depth);
+        }
+        ctx->filter_line16(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7], depth);
+        if (++y >= height) break;
+        ctx->filter_line16(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7], depth);
+        if (++y >= height) break;
+    }
+}
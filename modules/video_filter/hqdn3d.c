@@ -30,10 +30,15 @@
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
 
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+
 
 #include "hqdn3d.h"
 
@@ -86,6 +91,8 @@ static const char *const filter_options[] = {
 /*****************************************************************************
  * filter_sys_t
  *****************************************************************************/
+struct hqdn3d_plane;
+
 typedef struct
 {
     const vlc_chroma_description_t *chroma;
@@ -95,8 +102,232 @@ typedef struct
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
+
+    /* Horizontally filtered plane, NULL if not filtering by slices */
+    uint32_t *spatial;
+    void (*pf_columns)(const struct hqdn3d_plane *, const uint32_t *,
+                       unsigned int *, int, int);
 } filter_sys_t;
 
+/*****************************************************************************
+ * Slices
+ *****************************************************************************
+ * The recursions of deNoise() only go from the left pixel, the pixel above
+ * and the pixel of the previous frame. So the horizontal pass is done by
+ * bands of lines into sys->spatial, then the vertical and temporal passes by
+ * bands of columns, which gives the same pixels on several threads.
+ *****************************************************************************/
+#define COLUMNS_ALIGN 16
+
+struct hqdn3d_plane
+{
+    const uint8_t *src;
+    uint8_t *dst;
+    int src_pitch, dst_pitch;
+    int w, h;
+    unsigned short *frame;
+    int *spatial, *temporal;
+};
+
+/* Filters 4 lines at once, so that their recursions run in parallel */
+static void SpatialLines(const struct hqdn3d_plane *p, uint32_t *out,
+                         int first, int end)
+{
+    const int pitch = p->src_pitch, w = p->w;
+    int *coefs = p->spatial;
+    int y = first;
+
+    for (; y + 4 <= end; y += 4) {
+        const uint8_t *s0 = &p->src[y * pitch], *s1 = s0 + pitch,
+                      *s2 = s1 + pitch, *s3 = s2 + pitch;
+        uint32_t *o0 = &out[y * w], *o1 = o0 + w, *o2 = o1 + w, *o3 = o2 + w;
+        unsigned int a0 = o0[0] = s0[0] << 16, a1 = o1[0] = s1[0] << 16,
+                     a2 = o2[0] = s2[0] << 16, a3 = o3[0] = s3[0] << 16;
+
+        for (int x = 1; x < w; x++) {
+            o0[x] = a0 = LowPassMul(a0, s0[x] << 16, coefs);
+            o1[x] = a1 = LowPassMul(a1, s1[x] << 16, coefs);
+            o2[x] = a2 = LowPassMul(a2, s2[x] << 16, coefs);
+            o3[x] = a3 = LowPassMul(a3, s3[x] << 16, coefs);
+        }
+    }
+
+    for (; y < end; y++) {
+        const uint8_t *s = &p->src[y * pitch];
+        uint32_t *o = &out[y * w];
+        unsigned int a = o[0] = s[0] << 16;
+
+        for (int x = 1; x < w; x++)
+            o[x] = a = LowPassMul(a, s[x] << 16, coefs);
+    }
+
+    /* deNoiseSpacial() filters the whole first line from its first pixel */
+    if (first == 0 && !p->temporal[0]) {
+        const unsigned int a = out[0];
+        for (int x = 1; x < w; x++)
+            out[x] = LowPassMul(a, p->src[x] << 16, coefs);
+    }
+}
+
+static void DenoiseColumns(const struct hqdn3d_plane *p, const uint32_t *in,
+                           unsigned int *line, int x0, int x1)
+{
+    int *temporal = p->temporal[0] ? p->temporal : NULL;
+
+    for (int y = 0; y < p->h; y++) {
+        const uint32_t *src = &in[y * p->w];
+        unsigned short *frame = &p->frame[y * p->w];
+        uint8_t *dst = &p->dst[y * p->dst_pitch];
+
+        for (int x = x0; x < x1; x++) {
+            unsigned int pixel = src[x];
+            if (y > 0)
+                pixel = LowPassMul(line[x], pixel, p->spatial);
+            line[x] = pixel;
+            if (temporal) {
+                pixel = LowPassMul(frame[x] << 8, pixel, temporal);
+                frame[x] = (pixel + 0x1000007F) >> 8;
+            }
+            dst[x] = (pixel + 0x10007FFF) >> 16;
+        }
+    }
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* LowPassMul() on 8 pixels, the coefficients being gathered */
+VLC_AVX2
+static inline __m256i LowPassMulAVX2(__m256i prev, __m256i curr,
+                                     const int *coefs)
+{
+    __m256i d = _mm256_add_epi32(_mm256_sub_epi32(prev, curr),
+                                 _mm256_set1_epi32(0x7FF));
+    return _mm256_add_epi32(curr,
+        _mm256_i32gather_epi32(coefs + 16*256, _mm256_srai_epi32(d, 12), 4));
+}
+
+VLC_AVX2
+static void DenoiseColumnsAVX2(const struct hqdn3d_plane *p, const uint32_t *in,
+                               unsigned int *line, int x0, int x1)
+{
+    const int *temporal = p->temporal[0] ? p->temporal : NULL;
+    const int end = x0 + ((x1 - x0) & ~15);
+    const __m256i round_frame = _mm256_set1_epi32(0x7F);
+    const __m256i round_dst = _mm256_set1_epi32(0x7FFF);
+    const __m256i mask16 = _mm256_set1_epi32(0xFFFF);
+    const __m256i mask8 = _mm256_set1_epi32(0xFF);
+
+    for (int y = 0; y < p->h; y++) {
+        const uint32_t *src = &in[y * p->w];
+        unsigned short *frame = &p->frame[y * p->w];
+        uint8_t *dst = &p->dst[y * p->dst_pitch];
+
+        for (int x = x0; x < end; x += 16) {
+            __m256i lo = _mm256_loadu_si256((const __m256i *)&src[x]);
+            __m256i hi = _mm256_loadu_si256((const __m256i *)&src[x + 8]);
+
+            if (y > 0) {
+                lo = LowPassMulAVX2(
+                        _mm256_loadu_si256((const __m256i *)&line[x]), lo,
+                        p->spatial);
+                hi = LowPassMulAVX2(
+                        _mm256_loadu_si256((const __m256i *)&line[x + 8]), hi,
+                        p->spatial);
+            }
+            _mm256_storeu_si256((__m256i *)&line[x], lo);
+            _mm256_storeu_si256((__m256i *)&line[x + 8], hi);
+
+            if (temporal) {
+                __m256i prev = _mm256_loadu_si256((const __m256i *)&frame[x]);
+                lo = LowPassMulAVX2(_mm256_slli_epi32(_mm256_cvtepu16_epi32(
+                            _mm256_castsi256_si128(prev)), 8), lo, temporal);
+                hi = LowPassMulAVX2(_mm256_slli_epi32(_mm256_cvtepu16_epi32(
+                            _mm256_extracti128_si256(prev, 1)), 8), hi, temporal);
+
+                /* truncated as the C code, without saturation */
+                __m256i flo = _mm256_and_si256(_mm256_srai_epi32(
+                            _mm256_add_epi32(lo, round_frame), 8), mask16);
+                __m256i fhi = _mm256_and_si256(_mm256_srai_epi32(
+                            _mm256_add_epi32(hi, round_frame), 8), mask16);
+                _mm256_storeu_si256((__m256i *)&frame[x],
+                    _mm256_permute4x64_epi64(_mm256_packus_epi32(flo, fhi), 0xD8));
+            }
+
+            __m256i dlo = _mm256_and_si256(_mm256_srai_epi32(
+                        _mm256_add_epi32(lo, round_dst), 16), mask8);
+            __m256i dhi = _mm256_and_si256(_mm256_srai_epi32(
+                        _mm256_add_epi32(hi, round_dst), 16), mask8);
+            __m256i d16 = _mm256_permute4x64_epi64(
+                        _mm256_packus_epi32(dlo, dhi), 0xD8);
+            _mm_storeu_si128((__m128i *)&dst[x],
+                _mm_packus_epi16(_mm256_castsi256_si128(d16),
+                                 _mm256_extracti128_si256(d16, 1)));
+        }
+    }
+
+    if (end < x1)
+        DenoiseColumns(p, in, line, end, x1);
+}
+#endif
+
+static void SpatialSlice(filter_t *filter, void *data,
+                         unsigned slice, unsigned slices)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const struct hqdn3d_plane *p = data;
+    int first, end;
+
+    filter_GetSliceLines(p->h, slice, slices, &first, &end);
+
+    if (!p->spatial[0])
+        deNoiseTemporal((unsigned char *)&p->src[first * p->src_pitch],
+                        &p->dst[first * p->dst_pitch], &p->frame[first * p->w],
+                        p->w, end - first, p->src_pitch, p->dst_pitch,
+                        p->temporal);
+    else
+        SpatialLines(p, sys->spatial, first, end);
+}
+
+static void ColumnsSlice(filter_t *filter, void *data,
+                         unsigned slice, unsigned slices)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const struct hqdn3d_plane *p = data;
+    int first, end;
+
+    filter_GetSliceLines((p->w + COLUMNS_ALIGN - 1) / COLUMNS_ALIGN,
+                         slice, slices, &first, &end);
+    sys->pf_columns(p, sys->spatial, sys->cfg.Line, first * COLUMNS_ALIGN,
+                    __MIN(end * COLUMNS_ALIGN, p->w));
+}
+
+static void DenoiseSlices(filter_t *filter, const plane_t *src, plane_t *dst,
+                          int i, int *spatial, int *temporal)
+{
+    filter_sys_t *sys = filter->p_sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+    const int w = sys->w[i], h = sys->h[i];
+
+    if (!cfg->Frame[i]) {
+        cfg->Frame[i] = vlc_alloc(w * h, sizeof(unsigned short));
+        if (!cfg->Frame[i])
+            return;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                cfg->Frame[i][y * w + x] = src->p_pixels[y * src->i_pitch + x] << 8;
+    }
+
+    struct hqdn3d_plane plane = {
+        .src = src->p_pixels, .dst = dst->p_pixels,
+        .src_pitch = src->i_pitch, .dst_pitch = dst->i_pitch,
+        .w = w, .h = h, .frame = cfg->Frame[i],
+        .spatial = spatial, .temporal = temporal,
+    };
+
+    filter_RunSlices(filter, h, SpatialSlice, &plane);
+    if (spatial[0])
+        filter_RunSlices(filter, w, ColumnsSlice, &plane);
+}
+
 /*****************************************************************************
  * Open
  *****************************************************************************/
@@ -109,7 +340,7 @@ static int Open(vlc_object_t *this)
     const video_format_t *fmt_out = &filter->fmt_out.video;
     const vlc_fourcc_t fourcc_in  = fmt_in->i_chroma;
     const vlc_fourcc_t fourcc_out = fmt_out->i_chroma;
-    int wmax = 0;
+    int wmax = 0, hmax = 0;
 
     const vlc_chroma_description_t *chroma =
             vlc_fourcc_GetChromaDescription(fourcc_in);
@@ -136,6 +367,7 @@ static int Open(vlc_object_t *this)
         sys->w[i] = fmt_in->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        if (sys->h[i] > hmax) hmax = sys->h[i];
     }
     cfg->Line = malloc(wmax*sizeof(unsigned int));
     if (!cfg->Line) {
@@ -143,6 +375,21 @@ static int Open(vlc_object_t *this)
         return VLC_ENOMEM;
     }
 
+    /* Slices only pay for their intermediate plane on several CPUs */
+    if (vlc_GetCPUCount() > 1) {
+        sys->spatial = vlc_alloc(wmax * hmax, sizeof(uint32_t));
+        if (!sys->spatial) {
+            free(cfg->Line);
+            free(sys);
+            return VLC_ENOMEM;
+        }
+    }
+    sys->pf_columns = DenoiseColumns;
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        sys->pf_columns = DenoiseColumnsAVX2;
+#endif
+
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
                       filter->p_cfg);
 
@@ -183,6 +430,7 @@ static void Close(vlc_object_t *this)
         free(cfg->Frame[i]);
     }
     free(cfg->Line);
+    free(sys->spatial);
     free(sys);
 }
 
@@ -218,24 +466,18 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    for (int i = 0; i < 3; ++i) {
+        int *spatial = cfg->Coefs[i ? 2 : 0];
+        int *temporal = cfg->Coefs[i ? 3 : 1];
+
+        if (sys->spatial)
+            DenoiseSlices(filter, &src->p[i], &dst->p[i], i, spatial, temporal);
+        else
+            deNoise(src->p[i].p_pixels, dst->p[i].p_pixels,
+                    cfg->Line, &cfg->Frame[i], sys->w[i], sys->h[i],
+                    src->p[i].i_pitch, dst->p[i].i_pitch,
+                    spatial, spatial, temporal);
+    }
 
     if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
     {
@@ -41,6 +41,8 @@ static int  Create      ( vlc_object_t * );
 static void Destroy     ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void FilterSlice( filter_t *, picture_t *, const picture_t *,
+                         unsigned, unsigned );
 
 /*****************************************************************************
  * Module descriptor
@@ -77,6 +79,7 @@ static int Create( vlc_object_t *p_this )
         return VLC_EGENERIC;
 
     p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_filter_slice = FilterSlice;
     return VLC_SUCCESS;
 }
 
@@ -97,28 +100,29 @@ static void Destroy( vlc_object_t *p_this )
  * until it is displayed and switch the two rendering buffers, preparing next
  * frame.
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( filter_t *p_filter, picture_t *p_outpic,
+                         const picture_t *p_pic,
+                         unsigned i_slice, unsigned i_slices )
 {
-    picture_t *p_outpic;
+    VLC_UNUSED(p_filter);
     int i_planes;
 
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        msg_Warn( p_filter, "can't get output picture" );
-        picture_Release( p_pic );
-        return NULL;
-    }
-
     if( p_pic->format.i_chroma == VLC_CODEC_YUVA )
     {
         /* We don't want to invert the alpha plane */
         i_planes = p_pic->i_planes - 1;
-        memcpy(
-            p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
-            p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
+        if( p_outpic != p_pic )
+        {
+            const plane_t *p_alpha = &p_pic->p[A_PLANE];
+            int i_first, i_end;
+            filter_GetSliceLines( p_alpha->i_lines, i_slice, i_slices,
+                                  &i_first, &i_end );
+
+            memcpy(
+                &p_outpic->p[A_PLANE].p_pixels[i_first * p_alpha->i_pitch],
+                &p_alpha->p_pixels[i_first * p_alpha->i_pitch],
+                p_alpha->i_pitch * (i_end - i_first) );
+        }
     }
     else
     {
@@ -127,24 +131,32 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     for( int i_index = 0 ; i_index < i_planes ; i_index++ )
     {
-        uint8_t *p_in, *p_in_end, *p_line_end, *p_out;
+        const uint8_t *p_in, *p_in_end, *p_line_end;
+        uint8_t *p_out;
+        int i_first, i_end;
+
+        filter_GetSliceLines( p_pic->p[i_index].i_visible_lines,
+                              i_slice, i_slices, &i_first, &i_end );
 
-        p_in = p_pic->p[i_index].p_pixels;
-        p_in_end = p_in + p_pic->p[i_index].i_visible_lines
-                           * p_pic->p[i_index].i_pitch;
+        p_in = p_pic->p[i_index].p_pixels
+             + i_first * p_pic->p[i_index].i_pitch;
+        p_in_end = p_pic->p[i_index].p_pixels
+                 + i_end * p_pic->p[i_index].i_pitch;
 
-        p_out = p_outpic->p[i_index].p_pixels;
+        p_out = p_outpic->p[i_index].p_pixels
+              + i_first * p_outpic->p[i_index].i_pitch;
 
         while( p_in < p_in_end )
         {
-            uint64_t *p_in64, *p_out64;
+            const uint64_t *p_in64;
+            uint64_t *p_out64;
 
             p_line_end = p_in + p_pic->p[i_index].i_visible_pitch - 64;
 
-            p_in64 = (uint64_t*)p_in;
+            p_in64 = (const uint64_t*)p_in;
             p_out64 = (uint64_t*)p_out;
 
-            while( p_in64 < (uint64_t *)p_line_end )
+            while( p_in64 < (const uint64_t *)p_line_end )
             {
                 /* Do 64 pixels at a time */
                 *p_out64++ = ~*p_in64++; *p_out64++ = ~*p_in64++;
@@ -153,7 +165,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                 *p_out64++ = ~*p_in64++; *p_out64++ = ~*p_in64++;
             }
 
-            p_in = (uint8_t*)p_in64;
+            p_in = (const uint8_t*)p_in64;
             p_out = (uint8_t*)p_out64;
             p_line_end += 64;
 
@@ -168,6 +180,38 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                      - p_outpic->p[i_index].i_visible_pitch;
         }
     }
+}
+
+struct invert_job
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+};
+
+static void InvertSlice( filter_t *p_filter, void *data,
+                         unsigned i_slice, unsigned i_slices )
+{
+    const struct invert_job *job = data;
+    FilterSlice( p_filter, job->p_outpic, job->p_pic, i_slice, i_slices );
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        msg_Warn( p_filter, "can't get output picture" );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    struct invert_job job = { .p_pic = p_pic, .p_outpic = p_outpic };
+    filter_RunSlices( p_filter, p_pic->p[Y_PLANE].i_visible_lines,
+                      InvertSlice, &job );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
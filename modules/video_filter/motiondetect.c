@@ -33,8 +33,16 @@
 #include <vlc_sout.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#ifdef CAN_COMPILE_SSE2
+# include <emmintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -43,6 +51,22 @@ static void Destroy   ( vlc_object_t * );
 
 #define FILTER_PREFIX "motiondetect-"
 
+#define BLOCKS_TEXT N_("Block detection")
+#define BLOCKS_LONGTEXT N_("Compare the 8x8 blocks of a downscaled luma " \
+    "plane rather than all the pixels, which is much faster. Whether " \
+    "there is motion and the number of moving blocks are reported in the " \
+    "\"" FILTER_PREFIX "motion\" and \"" FILTER_PREFIX "blocks\" " \
+    "variables of the filter.")
+#define SCALE_TEXT N_("Downscaling")
+#define SCALE_LONGTEXT N_("Number of times the luma plane is halved " \
+    "before the blocks are compared.")
+#define THRESHOLD_TEXT N_("Threshold")
+#define THRESHOLD_LONGTEXT N_("Mean absolute difference of the pixels of " \
+    "a block above which it is moving.")
+#define DRAW_TEXT N_("Draw the moving shapes")
+#define DRAW_LONGTEXT N_("Draw rectangles around the moving shapes, in " \
+    "block detection. Otherwise the pictures are passed through untouched.")
+
 vlc_module_begin ()
     set_description( N_("Motion detect video filter") )
     set_shortname( N_( "Motion Detect" ))
@@ -50,6 +74,14 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     set_capability( "video filter", 0 )
 
+    add_bool( FILTER_PREFIX "block-mode", false, BLOCKS_TEXT,
+              BLOCKS_LONGTEXT, false )
+    add_integer_with_range( FILTER_PREFIX "scale", 2, 0, 3,
+                            SCALE_TEXT, SCALE_LONGTEXT, false )
+    add_integer_with_range( FILTER_PREFIX "threshold", 10, 1, 255,
+                            THRESHOLD_TEXT, THRESHOLD_LONGTEXT, false )
+    add_bool( FILTER_PREFIX "draw", true, DRAW_TEXT, DRAW_LONGTEXT, false )
+
     add_shortcut( "motion" )
     set_callbacks( Create, Destroy )
 vlc_module_end ()
@@ -59,19 +91,49 @@ vlc_module_end ()
  * Local prototypes
  *****************************************************************************/
 static picture_t *Filter( filter_t *, picture_t * );
+static int CreateBlocks( filter_t * );
+static picture_t *FilterBlocks( filter_t *, picture_t * );
 static void GaussianConvolution( uint32_t *, uint32_t *, int, int, int );
 static int FindShapes( uint32_t *, uint32_t *, int, int, int,
                        int *, int *, int *, int *, int *);
 static void Draw( filter_t *p_filter, uint8_t *p_pix, int i_pix_pitch, int i_pix_size );
 #define NUM_COLORS (5000)
 
+static const char *const ppsz_filter_options[] = {
+    "block-mode", "scale", "threshold", "draw", NULL
+};
+
+/* Side of the compared blocks, in downscaled pixels */
+#define BLOCK_SIZE 8
+
 typedef struct
 {
     bool is_yuv_planar;
+    bool b_draw;
     picture_t *p_old;
     uint32_t *p_buf;
     uint32_t *p_buf2;
 
+    /* Block detection: the downscaled luma planes of the current and the
+     * previous pictures, so that no picture is held */
+    bool b_blocks;
+    bool b_has_old;
+    unsigned i_level;
+    unsigned i_threshold; /* sum of the absolute differences of a block */
+    uint8_t *p_luma[2];
+    unsigned i_cur;
+    size_t i_luma_pitch;
+    unsigned i_blocks_x;
+    unsigned i_blocks_y;
+    uint16_t *p_sad;
+    uint8_t *p_moving;
+    unsigned *p_stack;
+    unsigned i_moving;
+
+    void (*pf_downscale)( uint8_t *, const uint8_t *, size_t, unsigned );
+    void (*pf_sad)( uint16_t *, const uint8_t *, const uint8_t *, size_t,
+                    unsigned );
+
     /* */
     int i_colors;
     int colors[NUM_COLORS];
@@ -109,12 +171,24 @@ static int Create( vlc_object_t *p_this )
     p_filter->pf_video_filter = Filter;
 
     /* Allocate structure */
-    p_filter->p_sys = p_sys = malloc( sizeof( filter_sys_t ) );
+    p_filter->p_sys = p_sys = calloc( 1, sizeof( filter_sys_t ) );
     if( p_filter->p_sys == NULL )
         return VLC_ENOMEM;
 
+    config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
+                       p_filter->p_cfg );
+
     p_sys->is_yuv_planar = is_yuv_planar;
+    p_sys->b_draw = var_CreateGetBool( p_filter, FILTER_PREFIX "draw" );
     p_sys->p_old = NULL;
+
+    if( var_CreateGetBool( p_filter, FILTER_PREFIX "block-mode" ) )
+    {
+        if( is_yuv_planar )
+            return CreateBlocks( p_filter );
+        msg_Warn( p_filter, "Block detection needs planar YUV" );
+    }
+
     p_sys->p_buf  = calloc( p_fmt->i_width * p_fmt->i_height, sizeof(*p_sys->p_buf) );
     p_sys->p_buf2 = calloc( p_fmt->i_width * p_fmt->i_height, sizeof(*p_sys->p_buf) );
 
@@ -122,6 +196,7 @@ static int Create( vlc_object_t *p_this )
     {
         free( p_sys->p_buf2 );
         free( p_sys->p_buf );
+        free( p_sys );
         return VLC_ENOMEM;
     }
 
@@ -136,6 +211,16 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    if( p_sys->b_blocks )
+    {
+        var_Destroy( p_filter, FILTER_PREFIX "motion" );
+        var_Destroy( p_filter, FILTER_PREFIX "blocks" );
+    }
+    free( p_sys->p_stack );
+    free( p_sys->p_moving );
+    free( p_sys->p_sad );
+    free( p_sys->p_luma[1] );
+    free( p_sys->p_luma[0] );
     free( p_sys->p_buf2 );
     free( p_sys->p_buf );
     if( p_sys->p_old )
@@ -260,6 +345,9 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_inpic )
     if( !p_inpic )
         return NULL;
 
+    if( p_sys->b_blocks )
+        return FilterBlocks( p_filter, p_inpic );
+
     picture_t *p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -312,6 +400,339 @@ exit:
 }
 
 
+/*****************************************************************************
+ * Block detection
+ *****************************************************************************
+ * The luma plane is halved a few times, then the sums of the absolute
+ * differences of its 8x8 blocks with the ones of the previous picture are
+ * compared to the threshold. The moving blocks are grouped in shapes, the
+ * blocks touching each other being in the same shape.
+ *****************************************************************************/
+
+/* Halves two lines into one, as the average of the averages of the columns:
+ * width is the output width */
+static void Downscale( uint8_t *p_dst, const uint8_t *p_src, size_t i_pitch,
+                       unsigned i_width )
+{
+    for( unsigned x = 0; x < i_width; x++ )
+    {
+        const unsigned a = ( p_src[2*x] + p_src[i_pitch+2*x] + 1 ) >> 1;
+        const unsigned b = ( p_src[2*x+1] + p_src[i_pitch+2*x+1] + 1 ) >> 1;
+        p_dst[x] = ( a + b + 1 ) >> 1;
+    }
+}
+
+/* Sums of the absolute differences of a line of blocks */
+static void BlockSAD( uint16_t *p_sad, const uint8_t *p_a, const uint8_t *p_b,
+                      size_t i_pitch, unsigned i_blocks )
+{
+    for( unsigned i = 0; i < i_blocks; i++ )
+    {
+        unsigned sad = 0;
+        for( unsigned y = 0; y < BLOCK_SIZE; y++ )
+            for( unsigned x = 0; x < BLOCK_SIZE; x++ )
+                sad += abs( p_a[y*i_pitch+i*BLOCK_SIZE+x]
+                          - p_b[y*i_pitch+i*BLOCK_SIZE+x] );
+        p_sad[i] = sad;
+    }
+}
+
+#ifdef CAN_COMPILE_SSE2
+VLC_SSE
+static void DownscaleSSE2( uint8_t *p_dst, const uint8_t *p_src,
+                           size_t i_pitch, unsigned i_width )
+{
+    const __m128i mask = _mm_set1_epi16( 0x00ff );
+    unsigned x = 0;
+
+    for( ; x + 16 <= i_width; x += 16 )
+    {
+        const __m128i lo = _mm_avg_epu8(
+            _mm_loadu_si128( (const __m128i *)&p_src[2*x] ),
+            _mm_loadu_si128( (const __m128i *)&p_src[i_pitch+2*x] ) );
+        const __m128i hi = _mm_avg_epu8(
+            _mm_loadu_si128( (const __m128i *)&p_src[2*x+16] ),
+            _mm_loadu_si128( (const __m128i *)&p_src[i_pitch+2*x+16] ) );
+        const __m128i l = _mm_avg_epu16( _mm_and_si128( lo, mask ),
+                                         _mm_srli_epi16( lo, 8 ) );
+        const __m128i h = _mm_avg_epu16( _mm_and_si128( hi, mask ),
+                                         _mm_srli_epi16( hi, 8 ) );
+        _mm_storeu_si128( (__m128i *)&p_dst[x], _mm_packus_epi16( l, h ) );
+    }
+    Downscale( &p_dst[x], &p_src[2*x], i_pitch, i_width - x );
+}
+
+VLC_SSE
+static void BlockSADSSE2( uint16_t *p_sad, const uint8_t *p_a,
+                          const uint8_t *p_b, size_t i_pitch,
+                          unsigned i_blocks )
+{
+    unsigned i = 0;
+
+    /* Two blocks at once, one in each half of the registers */
+    for( ; i + 2 <= i_blocks; i += 2 )
+    {
+        __m128i sad = _mm_setzero_si128();
+        for( unsigned y = 0; y < BLOCK_SIZE; y++ )
+            sad = _mm_add_epi64( sad, _mm_sad_epu8(
+                _mm_loadu_si128( (const __m128i *)&p_a[y*i_pitch+i*BLOCK_SIZE] ),
+                _mm_loadu_si128( (const __m128i *)&p_b[y*i_pitch+i*BLOCK_SIZE] ) ) );
+        p_sad[i] = _mm_cvtsi128_si32( sad );
+        p_sad[i+1] = _mm_extract_epi16( sad, 4 );
+    }
+    BlockSAD( &p_sad[i], &p_a[i*BLOCK_SIZE], &p_b[i*BLOCK_SIZE], i_pitch,
+              i_blocks - i );
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void DownscaleNEON( uint8_t *p_dst, const uint8_t *p_src,
+                           size_t i_pitch, unsigned i_width )
+{
+    unsigned x = 0;
+
+    for( ; x + 16 <= i_width; x += 16 )
+    {
+        /* Deinterleaved as even and odd columns */
+        const uint8x16x2_t a = vld2q_u8( &p_src[2*x] );
+        const uint8x16x2_t b = vld2q_u8( &p_src[i_pitch+2*x] );
+        vst1q_u8( &p_dst[x], vrhaddq_u8( vrhaddq_u8( a.val[0], b.val[0] ),
+                                         vrhaddq_u8( a.val[1], b.val[1] ) ) );
+    }
+    Downscale( &p_dst[x], &p_src[2*x], i_pitch, i_width - x );
+}
+
+static void BlockSADNEON( uint16_t *p_sad, const uint8_t *p_a,
+                          const uint8_t *p_b, size_t i_pitch,
+                          unsigned i_blocks )
+{
+    unsigned i = 0;
+
+    for( ; i + 2 <= i_blocks; i += 2 )
+    {
+        uint16x8_t lo = vdupq_n_u16( 0 ), hi = vdupq_n_u16( 0 );
+        for( unsigned y = 0; y < BLOCK_SIZE; y++ )
+        {
+            const uint8x16_t a = vld1q_u8( &p_a[y*i_pitch+i*BLOCK_SIZE] );
+            const uint8x16_t b = vld1q_u8( &p_b[y*i_pitch+i*BLOCK_SIZE] );
+            lo = vabal_u8( lo, vget_low_u8( a ), vget_low_u8( b ) );
+            hi = vabal_u8( hi, vget_high_u8( a ), vget_high_u8( b ) );
+        }
+        p_sad[i] = vaddvq_u16( lo );
+        p_sad[i+1] = vaddvq_u16( hi );
+    }
+    BlockSAD( &p_sad[i], &p_a[i*BLOCK_SIZE], &p_b[i*BLOCK_SIZE], i_pitch,
+              i_blocks - i );
+}
+#endif
+
+static int CreateBlocks( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmt = &p_filter->fmt_in.video;
+
+    p_sys->b_blocks = true;
+    p_sys->i_level = var_CreateGetInteger( p_filter, FILTER_PREFIX "scale" );
+    p_sys->i_threshold = BLOCK_SIZE * BLOCK_SIZE *
+        var_CreateGetInteger( p_filter, FILTER_PREFIX "threshold" );
+
+    const unsigned i_width = p_fmt->i_width >> p_sys->i_level;
+    const unsigned i_height = p_fmt->i_height >> p_sys->i_level;
+    p_sys->i_blocks_x = i_width / BLOCK_SIZE;
+    p_sys->i_blocks_y = i_height / BLOCK_SIZE;
+    /* padded so that the lines of the first halving fit */
+    p_sys->i_luma_pitch = ( ( p_fmt->i_width + 1 ) / 2 + 15 ) & ~15;
+    if( p_sys->i_level == 0 )
+        p_sys->i_luma_pitch = ( p_fmt->i_width + 15 ) & ~15;
+
+    const size_t i_blocks = p_sys->i_blocks_x * p_sys->i_blocks_y;
+    const size_t i_lines = p_sys->i_level ? ( p_fmt->i_height + 1 ) / 2
+                                          : p_fmt->i_height;
+    p_sys->p_luma[0] = malloc( p_sys->i_luma_pitch * i_lines );
+    p_sys->p_luma[1] = malloc( p_sys->i_luma_pitch * i_lines );
+    p_sys->p_sad = vlc_alloc( i_blocks, sizeof(*p_sys->p_sad) );
+    p_sys->p_moving = malloc( i_blocks );
+    p_sys->p_stack = vlc_alloc( i_blocks, sizeof(*p_sys->p_stack) );
+    if( i_blocks == 0 || !p_sys->p_luma[0] || !p_sys->p_luma[1]
+     || !p_sys->p_sad || !p_sys->p_moving || !p_sys->p_stack )
+    {
+        free( p_sys->p_stack );
+        free( p_sys->p_moving );
+        free( p_sys->p_sad );
+        free( p_sys->p_luma[1] );
+        free( p_sys->p_luma[0] );
+        free( p_sys );
+        return i_blocks ? VLC_ENOMEM : VLC_EGENERIC;
+    }
+
+    p_sys->pf_downscale = Downscale;
+    p_sys->pf_sad = BlockSAD;
+#ifdef CAN_COMPILE_SSE2
+    if( vlc_CPU_SSE2() )
+    {
+        p_sys->pf_downscale = DownscaleSSE2;
+        p_sys->pf_sad = BlockSADSSE2;
+    }
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if( vlc_CPU_ARM_NEON() )
+    {
+        p_sys->pf_downscale = DownscaleNEON;
+        p_sys->pf_sad = BlockSADNEON;
+    }
+#endif
+
+    var_Create( p_filter, FILTER_PREFIX "motion", VLC_VAR_BOOL );
+    var_Create( p_filter, FILTER_PREFIX "blocks", VLC_VAR_INTEGER );
+    return VLC_SUCCESS;
+}
+
+/* Downscales the luma plane of the picture in the current buffer */
+static void PrepareBlocks( filter_sys_t *p_sys, const picture_t *p_pic,
+                           const video_format_t *p_fmt )
+{
+    const plane_t *p_plane = &p_pic->p[Y_PLANE];
+    uint8_t *p_luma = p_sys->p_luma[p_sys->i_cur];
+    const size_t i_pitch = p_sys->i_luma_pitch;
+    unsigned i_width = p_fmt->i_width, i_height = p_fmt->i_height;
+
+    if( p_sys->i_level == 0 )
+    {
+        for( unsigned y = 0; y < i_height; y++ )
+            memcpy( &p_luma[y*i_pitch], &p_plane->p_pixels[y*p_plane->i_pitch],
+                    i_width );
+        return;
+    }
+
+    i_width /= 2;
+    i_height /= 2;
+    for( unsigned y = 0; y < i_height; y++ )
+        p_sys->pf_downscale( &p_luma[y*i_pitch],
+                             &p_plane->p_pixels[2*y*p_plane->i_pitch],
+                             p_plane->i_pitch, i_width );
+
+    /* The next halvings are in place: the lines and the pixels are written
+     * after they are read */
+    for( unsigned i = 1; i < p_sys->i_level; i++ )
+    {
+        i_width /= 2;
+        i_height /= 2;
+        for( unsigned y = 0; y < i_height; y++ )
+            p_sys->pf_downscale( &p_luma[y*i_pitch], &p_luma[2*y*i_pitch],
+                                 i_pitch, i_width );
+    }
+}
+
+/* Groups the touching moving blocks in shapes, with their rectangles in
+ * picture pixels, for Draw() */
+static void FindBlockShapes( filter_sys_t *p_sys )
+{
+    const unsigned i_bx = p_sys->i_blocks_x, i_by = p_sys->i_blocks_y;
+    const int i_size = BLOCK_SIZE << p_sys->i_level;
+    uint8_t *p_moving = p_sys->p_moving;
+
+    p_sys->i_colors = 1;
+    for( unsigned i = 0; i < i_bx * i_by; i++ )
+    {
+        if( !p_moving[i] || p_sys->i_colors == NUM_COLORS )
+            continue;
+
+        const int c = p_sys->i_colors++;
+        unsigned x_min = i % i_bx, x_max = x_min;
+        unsigned y_min = i / i_bx, y_max = y_min;
+        unsigned i_stack = 0;
+
+        p_moving[i] = 0;
+        p_sys->p_stack[i_stack++] = i;
+        while( i_stack > 0 )
+        {
+            const unsigned j = p_sys->p_stack[--i_stack];
+            const unsigned x = j % i_bx, y = j / i_bx;
+
+            x_min = __MIN( x_min, x );
+            x_max = __MAX( x_max, x );
+            y_min = __MIN( y_min, y );
+            y_max = __MAX( y_max, y );
+
+            for( unsigned ny = y ? y - 1 : 0; ny <= y + 1 && ny < i_by; ny++ )
+                for( unsigned nx = x ? x - 1 : 0; nx <= x + 1 && nx < i_bx; nx++ )
+                    if( p_moving[ny*i_bx+nx] )
+                    {
+                        p_moving[ny*i_bx+nx] = 0;
+                        p_sys->p_stack[i_stack++] = ny*i_bx+nx;
+                    }
+        }
+
+        p_sys->colors[c] = c;
+        p_sys->color_x_min[c] = x_min * i_size;
+        p_sys->color_x_max[c] = ( x_max + 1 ) * i_size - 1;
+        p_sys->color_y_min[c] = y_min * i_size;
+        p_sys->color_y_max[c] = ( y_max + 1 ) * i_size - 1;
+    }
+}
+
+static picture_t *FilterBlocks( filter_t *p_filter, picture_t *p_inpic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmt = &p_filter->fmt_in.video;
+
+    PrepareBlocks( p_sys, p_inpic, p_fmt );
+
+    unsigned i_moving = 0;
+    p_sys->i_colors = 0;
+    if( p_sys->b_has_old )
+    {
+        const uint8_t *p_cur = p_sys->p_luma[p_sys->i_cur];
+        const uint8_t *p_old = p_sys->p_luma[!p_sys->i_cur];
+        const size_t i_pitch = p_sys->i_luma_pitch;
+        const unsigned i_bx = p_sys->i_blocks_x;
+
+        for( unsigned y = 0; y < p_sys->i_blocks_y; y++ )
+        {
+            const size_t i_offset = y * BLOCK_SIZE * i_pitch;
+            uint16_t *p_sad = &p_sys->p_sad[y*i_bx];
+
+            p_sys->pf_sad( p_sad, &p_cur[i_offset], &p_old[i_offset],
+                           i_pitch, i_bx );
+            for( unsigned x = 0; x < i_bx; x++ )
+            {
+                const bool b_moving = p_sad[x] > p_sys->i_threshold;
+                p_sys->p_moving[y*i_bx+x] = b_moving;
+                i_moving += b_moving;
+            }
+        }
+        if( i_moving > 0 && p_sys->b_draw )
+            FindBlockShapes( p_sys );
+    }
+    p_sys->b_has_old = true;
+    p_sys->i_cur = !p_sys->i_cur;
+
+    /* Only report the changes */
+    if( i_moving != p_sys->i_moving )
+    {
+        if( ( i_moving > 0 ) != ( p_sys->i_moving > 0 ) )
+            var_SetBool( p_filter, FILTER_PREFIX "motion", i_moving > 0 );
+        var_SetInteger( p_filter, FILTER_PREFIX "blocks", i_moving );
+        p_sys->i_moving = i_moving;
+    }
+
+    if( !p_sys->b_draw )
+        return p_inpic;
+
+    picture_t *p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_inpic );
+        return NULL;
+    }
+    picture_Copy( p_outpic, p_inpic );
+    picture_Release( p_inpic );
+
+    Draw( p_filter, p_outpic->p[Y_PLANE].p_pixels, p_outpic->p[Y_PLANE].i_pitch, 1 );
+    return p_outpic;
+}
+
+
 /*****************************************************************************
  * Gaussian Convolution
  *****************************************************************************
@@ -159,7 +159,7 @@ static void Destroy( vlc_object_t *p_this )
 #define IS_YUV_420_10BITS(fmt) (fmt == VLC_CODEC_I420_10L ||    \
                                 fmt == VLC_CODEC_I420_10B)
 
-#define SHARPEN_FRAME(maxval, data_t)                                   \
+#define SHARPEN_LINES(maxval, data_t)                                   \
     do                                                                  \
     {                                                                   \
         assert((maxval) >= 0);                                          \
@@ -168,11 +168,12 @@ static void Destroy( vlc_object_t *p_this )
         const unsigned data_sz = sizeof(data_t);                        \
         const int i_src_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
         const int i_out_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_sys->sigma);         \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        if( i_first == 0 )                                              \
+            memcpy(p_out, p_src, i_visible_pitch);                      \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = __MAX(i_first, 1);                            \
+             i < __MIN(i_end, i_visible_lines - 1); i++ )               \
         {                                                               \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
@@ -199,19 +200,66 @@ static void Destroy( vlc_object_t *p_this )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
+        if( i_end == i_visible_lines )                                  \
+            memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],      \
+                   &p_src[(i_visible_lines - 1) * i_src_line_len],      \
+                   i_visible_pitch);                                    \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+struct sharpen_job
 {
+    picture_t *p_pic;
     picture_t *p_outpic;
+    int sigma;
+};
+
+static void CopySliceLines( plane_t *p_dst, const plane_t *p_src,
+                            unsigned i_slice, unsigned i_slices )
+{
+    const int i_width = __MIN( p_dst->i_visible_pitch, p_src->i_visible_pitch );
+    int i_first, i_end;
+    filter_GetSliceLines( __MIN( p_dst->i_visible_lines,
+                                 p_src->i_visible_lines ),
+                          i_slice, i_slices, &i_first, &i_end );
+
+    for( int y = i_first; y < i_end; y++ )
+        memcpy( &p_dst->p_pixels[y * p_dst->i_pitch],
+                &p_src->p_pixels[y * p_src->i_pitch], i_width );
+}
+
+static void SharpenSlice( filter_t *p_filter, void *data,
+                          unsigned i_slice, unsigned i_slices )
+{
+    VLC_UNUSED(p_filter);
+    const struct sharpen_job *job = data;
+    picture_t *p_pic = job->p_pic;
+    picture_t *p_outpic = job->p_outpic;
+    const int sigma = job->sigma;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
 
+    int i_first_line, i_end_line;
+    filter_GetSliceLines( i_visible_lines, i_slice, i_slices,
+                          &i_first_line, &i_end_line );
+    const unsigned i_first = i_first_line, i_end = i_end_line;
+
+    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
+        SHARPEN_LINES(255, uint8_t);
+    else
+        SHARPEN_LINES(1023, uint16_t);
+
+    CopySliceLines( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE],
+                    i_slice, i_slices );
+    CopySliceLines( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE],
+                    i_slice, i_slices );
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -221,13 +269,14 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
-    else
-        SHARPEN_FRAME(1023, uint16_t);
-
-    plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
-    plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
+    /* The same strength for all the slices */
+    struct sharpen_job job = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .sigma = atomic_load(&p_sys->sigma),
+    };
+    filter_RunSlices( p_filter, p_pic->p[Y_PLANE].i_visible_lines,
+                      SharpenSlice, &job );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -80,6 +80,7 @@ struct vout_display_sys_t
 static void PictureRender (vout_display_t *, picture_t *, subpicture_t *, vlc_tick_t);
 static void PictureDisplay (vout_display_t *, picture_t *);
 static int Control (vout_display_t *, int, va_list);
+static picture_pool_t *Pool (vout_display_t *, unsigned);
 
 /**
  * Allocates a surface and an OpenGL context for video output.
@@ -146,6 +147,7 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     vd->prepare = PictureRender;
     vd->display = PictureDisplay;
     vd->control = Control;
+    vd->pool = Pool;
     vd->close = Close;
     return VLC_SUCCESS;
 
@@ -206,6 +208,19 @@ static void PictureDisplay (vout_display_t *vd, picture_t *pic)
     }
 }
 
+static picture_pool_t *Pool (vout_display_t *vd, unsigned count)
+{
+    vout_display_sys_t *sys = vd->sys;
+    picture_pool_t *pool = NULL;
+
+    if (vlc_gl_MakeCurrent (sys->gl) == VLC_SUCCESS)
+    {
+        pool = vout_display_opengl_GetPool (sys->vgl, count);
+        vlc_gl_ReleaseCurrent (sys->gl);
+    }
+    return pool;
+}
+
 static int Control (vout_display_t *vd, int query, va_list ap)
 {
     vout_display_sys_t *sys = vd->sys;
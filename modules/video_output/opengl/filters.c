@@ -0,0 +1,759 @@
+/*****************************************************************************
+ * filters.c: OpenGL video filters
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "filters.h"
+
+#include <assert.h>
+#include <math.h>
+#include <vlc_common.h>
+#include <vlc_charset.h>
+#include <vlc_configuration.h>
+
+#include "gl_util.h"
+
+/* The filters are the GL versions of the adjust, sharpen, transform and
+ * yadif video filters, with the same options. Each one is a fragment shader
+ * drawing the output of the previous one into its own texture, and the last
+ * one draws in the viewport. */
+
+enum gl_filter_type
+{
+    FILTER_COPY,
+    FILTER_ADJUST,
+    FILTER_SHARPEN,
+    FILTER_TRANSFORM,
+    FILTER_DEINTERLACE,
+};
+
+/* Texture coordinates of the corners, in the vertex order, from which each
+ * output corner is taken */
+static const struct
+{
+    char name[16];
+    bool swap; /* swap the width and the height */
+    GLfloat coords[8];
+} transforms[] = {
+    { "90",            true,  { 1, 0, 1, 1, 0, 0, 0, 1 } },
+    { "180",           false, { 1, 1, 0, 1, 1, 0, 0, 0 } },
+    { "270",           true,  { 0, 1, 0, 0, 1, 1, 1, 0 } },
+    { "hflip",         false, { 1, 0, 0, 0, 1, 1, 0, 1 } },
+    { "vflip",         false, { 0, 1, 1, 1, 0, 0, 1, 0 } },
+    { "transpose",     true,  { 1, 1, 1, 0, 0, 1, 0, 0 } },
+    { "antitranspose", true,  { 0, 0, 0, 1, 1, 0, 1, 1 } },
+};
+
+static const GLfloat identity_coords[8] = { 0, 0, 1, 0, 0, 1, 1, 1 };
+
+struct gl_filter
+{
+    enum gl_filter_type type;
+
+    GLuint program_id;
+    struct {
+        GLint vertex_pos;
+        GLint tex_coords_in;
+    } aloc;
+    struct {
+        GLint sampler;
+        GLint prev_sampler;
+        GLint texel;
+        GLint field;
+        GLint contrast;
+        GLint brightness;
+        GLint hue;
+        GLint saturation;
+        GLint gamma;
+        GLint sigma;
+    } uloc;
+
+    union {
+        struct {
+            float contrast;
+            float brightness;
+            float hue;
+            float saturation;
+            float gamma;
+        } adjust;
+        float sigma;
+        unsigned transform; /* index in transforms[] */
+    };
+
+    /* output, unused by the last filter */
+    GLuint texture;
+    GLsizei width;
+    GLsizei height;
+};
+
+struct vlc_gl_filters
+{
+    vlc_gl_t *gl;
+    const struct vlc_gl_api *api;
+    const opengl_vtable_t *vt; /* for convenience, same as &api->vt */
+
+    struct gl_filter *filters;
+    unsigned count;
+
+    GLuint framebuffer;
+    GLint default_framebuffer;
+    GLuint vertex_buffer;
+
+    /* pictures drawn by the renderer: the current one and the previous one,
+     * for the deinterlacer */
+    GLuint input[2];
+    unsigned current;
+    bool has_previous;
+    GLsizei width;
+    GLsizei height;
+
+    bool progressive;
+    bool top_field_first;
+
+    struct {
+        int x;
+        int y;
+        unsigned width;
+        unsigned height;
+    } viewport;
+};
+
+static const char *const VERTEX_SHADER_SRC =
+#if defined(USE_OPENGL_ES2)
+    "#version 100\n"
+#else
+    "#version 120\n"
+#endif
+    "attribute vec2 vertex_pos;\n"
+    "attribute vec2 tex_coords_in;\n"
+    "varying vec2 tex_coords;\n"
+    "void main() {\n"
+    "  tex_coords = tex_coords_in;\n"
+    "  gl_Position = vec4(vertex_pos, 0.0, 1.0);\n"
+    "}\n";
+
+/* The deinterlacer counts the lines with floats */
+static const char *const FRAGMENT_SHADER_HEADER =
+#if defined(USE_OPENGL_ES2)
+    "#version 100\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+#else
+    "#version 120\n"
+#endif
+    "uniform sampler2D sampler;\n"
+    "uniform vec2 texel;\n"
+    "varying vec2 tex_coords;\n";
+
+static const char *const COPY_SHADER_SRC =
+    "void main() {\n"
+    "  gl_FragColor = texture2D(sampler, tex_coords);\n"
+    "}\n";
+
+/* As the adjust filter, on the BT.601 YCbCr of the pixels */
+static const char *const ADJUST_SHADER_SRC =
+    "uniform float contrast;\n"
+    "uniform float brightness;\n"
+    "uniform vec2 hue;\n" /* cosine and sine */
+    "uniform float saturation;\n"
+    "uniform float gamma;\n" /* inverse */
+    "const mat3 to_yuv = mat3(0.299, -0.168736,  0.5,\n"
+    "                         0.587, -0.331264, -0.418688,\n"
+    "                         0.114,  0.5,      -0.081312);\n"
+    "const mat3 to_rgb = mat3(1.0,    1.0,      1.0,\n"
+    "                         0.0,   -0.344136, 1.772,\n"
+    "                         1.402, -0.714136, 0.0);\n"
+    "void main() {\n"
+    "  vec4 color = texture2D(sampler, tex_coords);\n"
+    "  vec3 yuv = to_yuv * color.rgb;\n"
+    "  yuv.x = pow(clamp(contrast * (yuv.x - 0.5) + brightness - 0.5,\n"
+    "                    0.0, 1.0), gamma);\n"
+    "  yuv.yz = mat2(hue.x, -hue.y, hue.y, hue.x) * yuv.yz * saturation;\n"
+    "  gl_FragColor = vec4(clamp(to_rgb * yuv, 0.0, 1.0), color.a);\n"
+    "}\n";
+
+/* As the sharpen filter: the difference with the 8 neighbours is added */
+static const char *const SHARPEN_SHADER_SRC =
+    "uniform float sigma;\n"
+    "void main() {\n"
+    "  vec4 color = texture2D(sampler, tex_coords);\n"
+    "  vec3 sum = vec3(0.0);\n"
+    "  for (int y = -1; y <= 1; y++)\n"
+    "    for (int x = -1; x <= 1; x++)\n"
+    "      sum += texture2D(sampler, tex_coords + vec2(x, y) * texel).rgb;\n"
+    "  vec3 diff = clamp(9.0 * color.rgb - sum, -1.0, 1.0);\n"
+    "  gl_FragColor = vec4(clamp(color.rgb + sigma * diff, 0.0, 1.0),\n"
+    "                      color.a);\n"
+    "}\n";
+
+/* Yadif, on the previous and the current pictures only: the next picture is
+ * the current one, as when Yadif reaches the end of the stream. The lines of
+ * the first field are kept, the others are interpolated at the time of this
+ * field. The texture is upside down: the rows count from the bottom. */
+static const char *const DEINTERLACE_SHADER_SRC =
+    "uniform sampler2D prev_sampler;\n"
+    "uniform float field;\n" /* parity of the kept rows */
+    "vec4 cur(float x, float y) {\n"
+    "  return texture2D(sampler, tex_coords + vec2(x, y) * texel);\n"
+    "}\n"
+    "vec4 prev(float x, float y) {\n"
+    "  return texture2D(prev_sampler, tex_coords + vec2(x, y) * texel);\n"
+    "}\n"
+    "float score(float k) {\n"
+    "  vec3 s = abs(cur(k - 1.0, 1.0).rgb - cur(-k - 1.0, -1.0).rgb)\n"
+    "         + abs(cur(k, 1.0).rgb - cur(-k, -1.0).rgb)\n"
+    "         + abs(cur(k + 1.0, 1.0).rgb - cur(-k + 1.0, -1.0).rgb);\n"
+    "  return s.r + s.g + s.b;\n"
+    "}\n"
+    "void main() {\n"
+    "  vec4 color = cur(0.0, 0.0);\n"
+    "  if (mod(floor(gl_FragCoord.y), 2.0) == field) {\n"
+    "    gl_FragColor = color;\n"
+    "    return;\n"
+    "  }\n"
+    "  vec4 c = cur(0.0, 1.0);\n"
+    "  vec4 e = cur(0.0, -1.0);\n"
+    "  vec4 p = prev(0.0, 0.0);\n"
+    "  vec4 d = (p + color) * 0.5;\n"
+    "  vec4 b = (prev(0.0, 2.0) + cur(0.0, 2.0)) * 0.5;\n"
+    "  vec4 f = (prev(0.0, -2.0) + cur(0.0, -2.0)) * 0.5;\n"
+    /* temporal difference */
+    "  vec4 diff = max(abs(p - color) * 0.5,\n"
+    "                  (abs(prev(0.0, 1.0) - c) + abs(prev(0.0, -1.0) - e))\n"
+    "                  * 0.5);\n"
+    "  vec4 hi = max(max(d - e, d - c), min(b - c, f - e));\n"
+    "  vec4 lo = min(min(d - e, d - c), max(b - c, f - e));\n"
+    "  diff = max(diff, max(lo, -hi));\n"
+    /* edge directed spatial interpolation */
+    "  vec4 spatial = (c + e) * 0.5;\n"
+    "  float best = score(0.0);\n"
+    "  float s = score(-1.0);\n"
+    "  if (s < best) {\n"
+    "    best = s;\n"
+    "    spatial = (cur(-1.0, 1.0) + cur(1.0, -1.0)) * 0.5;\n"
+    "  }\n"
+    "  s = score(1.0);\n"
+    "  if (s < best)\n"
+    "    spatial = (cur(1.0, 1.0) + cur(-1.0, -1.0)) * 0.5;\n"
+    "  gl_FragColor = vec4(clamp(spatial, d - diff, d + diff).rgb,\n"
+    "                      color.a);\n"
+    "}\n";
+
+static float
+ChainFloat(const config_chain_t *cfg, const char *name, float def,
+           float min, float max)
+{
+    for (; cfg != NULL; cfg = cfg->p_next)
+        if (cfg->psz_name != NULL && cfg->psz_value != NULL
+         && !strcmp(cfg->psz_name, name))
+            return VLC_CLIP(us_strtof(cfg->psz_value, NULL), min, max);
+    return def;
+}
+
+static const char *
+ChainString(const config_chain_t *cfg, const char *name, const char *def)
+{
+    for (; cfg != NULL; cfg = cfg->p_next)
+        if (cfg->psz_name != NULL && cfg->psz_value != NULL
+         && !strcmp(cfg->psz_name, name))
+            return cfg->psz_value;
+    return def;
+}
+
+static int
+ParseFilter(vlc_gl_t *gl, struct gl_filter *filter, const char *name,
+            const config_chain_t *cfg)
+{
+    if (!strcmp(name, "adjust"))
+    {
+        filter->type = FILTER_ADJUST;
+        filter->adjust.contrast = ChainFloat(cfg, "contrast", 1.f, 0.f, 2.f);
+        filter->adjust.brightness = ChainFloat(cfg, "brightness", 1.f, 0.f, 2.f);
+        filter->adjust.hue = ChainFloat(cfg, "hue", 0.f, -180.f, 180.f);
+        filter->adjust.saturation = ChainFloat(cfg, "saturation", 1.f, 0.f, 3.f);
+        filter->adjust.gamma = ChainFloat(cfg, "gamma", 1.f, .01f, 10.f);
+    }
+    else if (!strcmp(name, "sharpen"))
+    {
+        filter->type = FILTER_SHARPEN;
+        filter->sigma = ChainFloat(cfg, "sigma", .05f, 0.f, 2.f);
+    }
+    else if (!strcmp(name, "transform"))
+    {
+        const char *type = ChainString(cfg, "type", "90");
+
+        filter->type = FILTER_TRANSFORM;
+        for (filter->transform = 0;
+             strcmp(transforms[filter->transform].name, type); )
+            if (++filter->transform == ARRAY_SIZE(transforms))
+            {
+                msg_Err(gl, "unknown transform type %s", type);
+                return VLC_EGENERIC;
+            }
+    }
+    else if (!strcmp(name, "deinterlace") || !strcmp(name, "yadif"))
+        filter->type = FILTER_DEINTERLACE;
+    else
+    {
+        msg_Err(gl, "unknown OpenGL filter %s", name);
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int
+BuildFilter(struct vlc_gl_filters *filters, struct gl_filter *filter)
+{
+    const opengl_vtable_t *vt = filters->vt;
+    const char *body;
+
+    switch (filter->type)
+    {
+        case FILTER_ADJUST:
+            body = ADJUST_SHADER_SRC;
+            break;
+        case FILTER_SHARPEN:
+            body = SHARPEN_SHADER_SRC;
+            break;
+        case FILTER_DEINTERLACE:
+            body = DEINTERLACE_SHADER_SRC;
+            break;
+        default:
+            body = COPY_SHADER_SRC;
+            break;
+    }
+
+    const char *fragment[] = { FRAGMENT_SHADER_HEADER, body };
+    filter->program_id =
+        vlc_gl_BuildProgram(VLC_OBJECT(filters->gl), vt,
+                            1, (const char **) &VERTEX_SHADER_SRC,
+                            ARRAY_SIZE(fragment), fragment);
+    if (!filter->program_id)
+        return VLC_EGENERIC;
+
+    const GLuint id = filter->program_id;
+    filter->aloc.vertex_pos = vt->GetAttribLocation(id, "vertex_pos");
+    filter->aloc.tex_coords_in = vt->GetAttribLocation(id, "tex_coords_in");
+    filter->uloc.sampler = vt->GetUniformLocation(id, "sampler");
+    if (filter->aloc.vertex_pos == -1 || filter->aloc.tex_coords_in == -1
+     || filter->uloc.sampler == -1)
+    {
+        msg_Err(filters->gl, "Unable to get the OpenGL filter locations");
+        return VLC_EGENERIC;
+    }
+
+    /* -1 for the uniforms that this filter does not use, which are ignored
+     * by glUniform*() */
+    filter->uloc.prev_sampler = vt->GetUniformLocation(id, "prev_sampler");
+    filter->uloc.texel = vt->GetUniformLocation(id, "texel");
+    filter->uloc.field = vt->GetUniformLocation(id, "field");
+    filter->uloc.contrast = vt->GetUniformLocation(id, "contrast");
+    filter->uloc.brightness = vt->GetUniformLocation(id, "brightness");
+    filter->uloc.hue = vt->GetUniformLocation(id, "hue");
+    filter->uloc.saturation = vt->GetUniformLocation(id, "saturation");
+    filter->uloc.gamma = vt->GetUniformLocation(id, "gamma");
+    filter->uloc.sigma = vt->GetUniformLocation(id, "sigma");
+    return VLC_SUCCESS;
+}
+
+static struct gl_filter *
+AppendFilter(struct vlc_gl_filters *filters)
+{
+    struct gl_filter *array =
+        realloc(filters->filters, (filters->count + 1) * sizeof (*array));
+    if (array == NULL)
+        return NULL;
+    filters->filters = array;
+
+    struct gl_filter *filter = &array[filters->count++];
+    memset(filter, 0, sizeof (*filter));
+    filter->type = FILTER_COPY;
+    return filter;
+}
+
+struct vlc_gl_filters *
+vlc_gl_filters_New(vlc_gl_t *gl, const struct vlc_gl_api *api,
+                   const char *spec)
+{
+    const opengl_vtable_t *vt = &api->vt;
+
+    if (spec == NULL || *spec == '\0')
+        return NULL;
+
+    if (vt->GenFramebuffers == NULL || vt->BindFramebuffer == NULL
+     || vt->FramebufferTexture2D == NULL || vt->DeleteFramebuffers == NULL
+     || vt->CheckFramebufferStatus == NULL || !api->supports_npot)
+    {
+        msg_Warn(gl, "OpenGL filters not supported");
+        return NULL;
+    }
+
+    struct vlc_gl_filters *filters = calloc(1, sizeof (*filters));
+    if (filters == NULL)
+        return NULL;
+
+    filters->gl = gl;
+    filters->api = api;
+    filters->vt = vt;
+    filters->progressive = true;
+
+    char *next = strdup(spec);
+    bool deinterlace = false;
+    while (next != NULL && *next != '\0')
+    {
+        char *name;
+        config_chain_t *cfg;
+        char *buf = next;
+
+        next = config_ChainCreate(&name, &cfg, buf);
+        free(buf);
+        if (name == NULL)
+        {
+            config_ChainDestroy(cfg);
+            continue;
+        }
+
+        struct gl_filter filter = { .type = FILTER_COPY };
+        int ret = ParseFilter(gl, &filter, name, cfg);
+        config_ChainDestroy(cfg);
+        free(name);
+        if (ret != VLC_SUCCESS)
+            goto error;
+
+        /* The deinterlacer needs the rows of the drawn pictures: it always
+         * runs first, once */
+        if (filter.type == FILTER_DEINTERLACE && deinterlace)
+            continue;
+
+        struct gl_filter *slot = AppendFilter(filters);
+        if (slot == NULL)
+            goto error;
+        if (filter.type == FILTER_DEINTERLACE)
+        {
+            memmove(&filters->filters[1], &filters->filters[0],
+                    (filters->count - 1) * sizeof (*slot));
+            slot = &filters->filters[0];
+            deinterlace = true;
+        }
+        *slot = filter;
+    }
+    free(next);
+    next = NULL;
+
+    if (filters->count == 0)
+        goto error;
+
+    /* The deinterlacer draws rows, not in the viewport */
+    if (filters->filters[filters->count - 1].type == FILTER_DEINTERLACE
+     && AppendFilter(filters) == NULL)
+        goto error;
+
+    for (unsigned i = 0; i < filters->count; i++)
+        if (BuildFilter(filters, &filters->filters[i]) != VLC_SUCCESS)
+            goto error;
+
+    vt->GenFramebuffers(1, &filters->framebuffer);
+    vt->GenBuffers(1, &filters->vertex_buffer);
+
+    GL_ASSERT_NOERROR(vt);
+    return filters;
+
+error:
+    free(next);
+    msg_Warn(gl, "Could not create the OpenGL filters \"%s\"", spec);
+    vlc_gl_filters_Delete(filters);
+    return NULL;
+}
+
+static void
+DeleteTextures(struct vlc_gl_filters *filters)
+{
+    const opengl_vtable_t *vt = filters->vt;
+
+    for (unsigned i = 0; i < filters->count; i++)
+    {
+        struct gl_filter *filter = &filters->filters[i];
+        if (filter->texture)
+            vt->DeleteTextures(1, &filter->texture);
+        filter->texture = 0;
+        filter->width = filter->height = 0;
+    }
+    for (unsigned i = 0; i < 2; i++)
+        if (filters->input[i])
+            vt->DeleteTextures(1, &filters->input[i]);
+    filters->input[0] = filters->input[1] = 0;
+}
+
+void
+vlc_gl_filters_Delete(struct vlc_gl_filters *filters)
+{
+    const opengl_vtable_t *vt = filters->vt;
+
+    DeleteTextures(filters);
+    for (unsigned i = 0; i < filters->count; i++)
+        if (filters->filters[i].program_id)
+            vt->DeleteProgram(filters->filters[i].program_id);
+    if (filters->framebuffer)
+        vt->DeleteFramebuffers(1, &filters->framebuffer);
+    if (filters->vertex_buffer)
+        vt->DeleteBuffers(1, &filters->vertex_buffer);
+
+    free(filters->filters);
+    free(filters);
+}
+
+void
+vlc_gl_filters_SetViewport(struct vlc_gl_filters *filters, int x, int y,
+                           unsigned width, unsigned height)
+{
+    filters->viewport.x = x;
+    filters->viewport.y = y;
+    filters->viewport.width = width;
+    filters->viewport.height = height;
+}
+
+static GLuint
+NewTexture(const opengl_vtable_t *vt, GLsizei width, GLsizei height)
+{
+    GLuint texture;
+
+    vt->GenTextures(1, &texture);
+    vt->BindTexture(GL_TEXTURE_2D, texture);
+    vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    vt->TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                   GL_UNSIGNED_BYTE, NULL);
+    return texture;
+}
+
+static int
+AttachTexture(struct vlc_gl_filters *filters, GLuint texture)
+{
+    const opengl_vtable_t *vt = filters->vt;
+
+    vt->FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_TEXTURE_2D, texture, 0);
+    if (vt->CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        msg_Err(filters->gl, "OpenGL filter framebuffer incomplete");
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+int
+vlc_gl_filters_Prepare(struct vlc_gl_filters *filters,
+                       const picture_t *picture,
+                       unsigned width, unsigned height)
+{
+    const opengl_vtable_t *vt = filters->vt;
+
+    if ((GLsizei)width != filters->width || (GLsizei)height != filters->height)
+    {
+        DeleteTextures(filters);
+        filters->input[0] = NewTexture(vt, width, height);
+        filters->input[1] = NewTexture(vt, width, height);
+        filters->width = width;
+        filters->height = height;
+        filters->has_previous = false;
+    }
+    else
+    {
+        filters->current ^= 1;
+        filters->has_previous = true;
+    }
+
+    filters->progressive = picture->b_progressive;
+    filters->top_field_first = picture->b_top_field_first;
+    GL_ASSERT_NOERROR(vt);
+    return VLC_SUCCESS;
+}
+
+bool
+vlc_gl_filters_Begin(struct vlc_gl_filters *filters)
+{
+    const opengl_vtable_t *vt = filters->vt;
+
+    if (filters->width == 0)
+        return false;
+
+    vt->GetIntegerv(GL_FRAMEBUFFER_BINDING, &filters->default_framebuffer);
+    vt->BindFramebuffer(GL_FRAMEBUFFER, filters->framebuffer);
+    if (AttachTexture(filters, filters->input[filters->current])
+            != VLC_SUCCESS)
+    {
+        vt->BindFramebuffer(GL_FRAMEBUFFER, filters->default_framebuffer);
+        return false;
+    }
+    vt->Viewport(0, 0, filters->width, filters->height);
+    return true;
+}
+
+static void
+DrawFilter(struct vlc_gl_filters *filters, const struct gl_filter *filter,
+           GLuint input, GLsizei width, GLsizei height,
+           const GLfloat scale[2])
+{
+    const opengl_vtable_t *vt = filters->vt;
+    const GLfloat *coords = identity_coords;
+
+    vt->UseProgram(filter->program_id);
+
+    vt->ActiveTexture(GL_TEXTURE0);
+    vt->BindTexture(GL_TEXTURE_2D, input);
+    vt->Uniform1i(filter->uloc.sampler, 0);
+    vt->Uniform2f(filter->uloc.texel, 1.f / width, 1.f / height);
+
+    switch (filter->type)
+    {
+        case FILTER_ADJUST:
+        {
+            const float hue = filter->adjust.hue * (float)(M_PI / 180.);
+            vt->Uniform1f(filter->uloc.contrast, filter->adjust.contrast);
+            vt->Uniform1f(filter->uloc.brightness, filter->adjust.brightness);
+            vt->Uniform2f(filter->uloc.hue, cosf(hue), sinf(hue));
+            vt->Uniform1f(filter->uloc.saturation, filter->adjust.saturation);
+            vt->Uniform1f(filter->uloc.gamma, 1.f / filter->adjust.gamma);
+            break;
+        }
+        case FILTER_SHARPEN:
+            vt->Uniform1f(filter->uloc.sigma, filter->sigma);
+            break;
+        case FILTER_TRANSFORM:
+            coords = transforms[filter->transform].coords;
+            break;
+        case FILTER_DEINTERLACE:
+        {
+            /* the rows count from the bottom */
+            const unsigned first = filters->top_field_first ? 0 : 1;
+            vt->ActiveTexture(GL_TEXTURE1);
+            vt->BindTexture(GL_TEXTURE_2D, filters->has_previous
+                            ? filters->input[filters->current ^ 1] : input);
+            vt->Uniform1i(filter->uloc.prev_sampler, 1);
+            vt->Uniform1f(filter->uloc.field, (height - 1 - first) & 1);
+            vt->ActiveTexture(GL_TEXTURE0);
+            break;
+        }
+        default:
+            break;
+    }
+
+    const GLfloat vertices[] = {
+        -scale[0], -scale[1], coords[0], coords[1],
+         scale[0], -scale[1], coords[2], coords[3],
+        -scale[0],  scale[1], coords[4], coords[5],
+         scale[0],  scale[1], coords[6], coords[7],
+    };
+
+    vt->BindBuffer(GL_ARRAY_BUFFER, filters->vertex_buffer);
+    vt->BufferData(GL_ARRAY_BUFFER, sizeof (vertices), vertices,
+                   GL_STREAM_DRAW);
+    vt->EnableVertexAttribArray(filter->aloc.vertex_pos);
+    vt->VertexAttribPointer(filter->aloc.vertex_pos, 2, GL_FLOAT, GL_FALSE,
+                            4 * sizeof (GLfloat), (const void *) 0);
+    vt->EnableVertexAttribArray(filter->aloc.tex_coords_in);
+    vt->VertexAttribPointer(filter->aloc.tex_coords_in, 2, GL_FLOAT, GL_FALSE,
+                            4 * sizeof (GLfloat),
+                            (const void *) (2 * sizeof (GLfloat)));
+
+    vt->DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+int
+vlc_gl_filters_Draw(struct vlc_gl_filters *filters)
+{
+    const opengl_vtable_t *vt = filters->vt;
+    GLuint input = filters->input[filters->current];
+    GLsizei width = filters->width, height = filters->height;
+    bool swapped = false;
+
+    for (unsigned i = 0; i < filters->count; i++)
+    {
+        struct gl_filter *filter = &filters->filters[i];
+        const bool last = i == filters->count - 1;
+        GLsizei out_width = width, out_height = height;
+        GLfloat scale[2] = { 1.f, 1.f };
+
+        if (filter->type == FILTER_DEINTERLACE && filters->progressive)
+            continue;
+
+        if (filter->type == FILTER_TRANSFORM
+         && transforms[filter->transform].swap)
+        {
+            out_width = height;
+            out_height = width;
+            swapped = !swapped;
+        }
+
+        if (last)
+        {
+            vt->BindFramebuffer(GL_FRAMEBUFFER, filters->default_framebuffer);
+            vt->Viewport(filters->viewport.x, filters->viewport.y,
+                         filters->viewport.width, filters->viewport.height);
+            vt->Clear(GL_COLOR_BUFFER_BIT);
+
+            /* The viewport has the aspect ratio of the picture before the
+             * filters: fit the rotated picture inside */
+            if (swapped && filters->viewport.height > 0)
+            {
+                const float ar = (float) filters->viewport.width
+                                 / filters->viewport.height;
+                if (ar > 1.f)
+                    scale[0] = 1.f / (ar * ar);
+                else
+                    scale[1] = ar * ar;
+            }
+        }
+        else
+        {
+            if (filter->width != out_width || filter->height != out_height)
+            {
+                if (filter->texture)
+                    vt->DeleteTextures(1, &filter->texture);
+                filter->texture = NewTexture(vt, out_width, out_height);
+                filter->width = out_width;
+                filter->height = out_height;
+            }
+            if (AttachTexture(filters, filter->texture) != VLC_SUCCESS)
+            {
+                vt->BindFramebuffer(GL_FRAMEBUFFER,
+                                    filters->default_framebuffer);
+                return VLC_EGENERIC;
+            }
+            vt->Viewport(0, 0, out_width, out_height);
+        }
+
+        DrawFilter(filters, filter, input, width, height, scale);
+
+        input = filter->texture;
+        width = out_width;
+        height = out_height;
+    }
+
+    GL_ASSERT_NOERROR(vt);
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * filters.h: OpenGL video filters
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_GL_FILTERS_H
+#define VLC_GL_FILTERS_H
+
+#include <vlc_common.h>
+#include <vlc_opengl.h>
+#include <vlc_picture.h>
+
+#include "gl_api.h"
+
+/**
+ * OpenGL filters
+ *
+ * The renderer draws the picture, at its size, into a texture, which the
+ * filters process one after the other before it is drawn in the viewport.
+ * Everything stays in textures, so hardware decoded pictures are filtered
+ * without being copied back to the CPU.
+ */
+struct vlc_gl_filters;
+
+/**
+ * Create the filters
+ *
+ * \param gl the GL context
+ * \param api the OpenGL API
+ * \param spec the filters, separated by ':', with their options in a
+ *             configuration chain: "adjust{contrast=1.2}:sharpen"
+ * \return the filters, or NULL if none is requested or on error
+ */
+struct vlc_gl_filters *
+vlc_gl_filters_New(vlc_gl_t *gl, const struct vlc_gl_api *api,
+                   const char *spec);
+
+/**
+ * Delete the filters
+ *
+ * \param filters the filters
+ */
+void
+vlc_gl_filters_Delete(struct vlc_gl_filters *filters);
+
+/**
+ * Set the viewport where the filtered picture is drawn
+ */
+void
+vlc_gl_filters_SetViewport(struct vlc_gl_filters *filters, int x, int y,
+                           unsigned width, unsigned height);
+
+/**
+ * Signal a new picture, before it is drawn
+ *
+ * The previous picture is kept for the deinterlacer.
+ *
+ * \param filters the filters
+ * \param picture the picture, which is not held
+ * \param width the width of the drawn picture
+ * \param height the height of the drawn picture
+ */
+int
+vlc_gl_filters_Prepare(struct vlc_gl_filters *filters,
+                       const picture_t *picture,
+                       unsigned width, unsigned height);
+
+/**
+ * Bind the framebuffer where the renderer must draw the picture
+ *
+ * The viewport is set to the picture size.
+ *
+ * \param filters the filters
+ * \return false if the picture must be drawn without the filters
+ */
+bool
+vlc_gl_filters_Begin(struct vlc_gl_filters *filters);
+
+/**
+ * Run the filters and draw the result in the viewport of the framebuffer
+ * bound before vlc_gl_filters_Begin()
+ *
+ * \param filters the filters
+ */
+int
+vlc_gl_filters_Draw(struct vlc_gl_filters *filters);
+
+#endif
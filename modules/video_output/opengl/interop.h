@@ -93,6 +93,20 @@ struct vlc_gl_interop_ops {
     const float *
     (*get_transform_matrix)(const struct vlc_gl_interop *interop);
 
+    /**
+     * Callback to allocate pictures the decoder can render into
+     *
+     * This function pointer can be NULL. The pictures are in the interop
+     * format, and update_textures() uploads them without copy. The pool and
+     * its pictures remain valid after the interop is closed.
+     *
+     * \param interop the OpenGL interop
+     * \param count number of pictures
+     * \return a picture pool, or NULL
+     */
+    picture_pool_t *
+    (*get_pool)(const struct vlc_gl_interop *interop, unsigned count);
+
     /**
      * Called before the interop is destroyed
      *
@@ -31,11 +31,17 @@
 #include "internal.h"
 
 #define PBO_DISPLAY_COUNT 2 /* Double buffering */
+#define PBO_PERSISTENT_COUNT 3 /* Pictures in flight with persistent mapping */
+#define PBO_MAX_COUNT PBO_PERSISTENT_COUNT
+#define POOL_MAX_COUNT 64 /* Pictures handed out to decoders */
 typedef struct
 {
     PFNGLDELETEBUFFERSPROC DeleteBuffers;
+    PFNGLDELETESYNCPROC DeleteSync;
     GLuint      buffers[PICTURE_PLANE_MAX];
     size_t      bytes[PICTURE_PLANE_MAX];
+    GLsync      fence; /* last upload from the persistent buffers */
+    vlc_gl_t   *gl; /* held by the pictures of the decoder pool */
 } picture_sys_t;
 
 struct priv
@@ -44,9 +50,18 @@ struct priv
     void * texture_temp_buf;
     size_t texture_temp_buf_size;
     struct {
-        picture_t *display_pics[PBO_DISPLAY_COUNT];
+        picture_t *display_pics[PBO_MAX_COUNT];
+        size_t display_count;
         size_t display_idx;
     } pbo;
+    struct {
+        /* held until the interop is closed, to recognize them */
+        picture_t *pics[POOL_MAX_COUNT];
+        size_t count;
+        /* uploaded, held until the GPU is done reading them */
+        picture_t *uploading[POOL_MAX_COUNT];
+        size_t uploading_count;
+    } pool;
 };
 
 static void
@@ -54,6 +69,20 @@ pbo_picture_destroy(picture_t *pic)
 {
     picture_sys_t *picsys = pic->p_sys;
 
+    if (picsys->gl != NULL)
+    {
+        /* The decoder pool pictures can be released last by any thread, after
+         * the display is closed: the buffers stay mapped until the context
+         * is destroyed, which deletes them. */
+        assert(picsys->fence == NULL);
+        vlc_gl_Release(picsys->gl);
+        free(picsys);
+        return;
+    }
+
+    if (picsys->fence != NULL)
+        picsys->DeleteSync(picsys->fence);
+    /* deleting the buffers also unmaps them */
     picsys->DeleteBuffers(pic->i_planes, picsys->buffers);
 
     free(picsys);
@@ -79,6 +108,7 @@ pbo_picture_create(const struct vlc_gl_interop *interop)
 
     interop->vt->GenBuffers(pic->i_planes, picsys->buffers);
     picsys->DeleteBuffers = interop->vt->DeleteBuffers;
+    picsys->DeleteSync = interop->vt->DeleteSync;
 
     /* XXX: needed since picture_NewFromResource override pic planes */
     if (picture_Setup(pic, &interop->fmt))
@@ -129,17 +159,52 @@ pbo_data_alloc(const struct vlc_gl_interop *interop, picture_t *pic)
 }
 
 static int
-pbo_pics_alloc(const struct vlc_gl_interop *interop)
+persistent_data_alloc(const struct vlc_gl_interop *interop, picture_t *pic,
+                      GLbitfield access)
+{
+    picture_sys_t *picsys = pic->p_sys;
+    const GLbitfield flags = access | GL_MAP_PERSISTENT_BIT
+                           | GL_MAP_COHERENT_BIT;
+
+    interop->vt->GetError();
+
+    for (int i = 0; i < pic->i_planes; ++i)
+    {
+        interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, picsys->buffers[i]);
+        interop->vt->BufferStorage(GL_PIXEL_UNPACK_BUFFER, picsys->bytes[i],
+                                   NULL, flags | GL_CLIENT_STORAGE_BIT);
+        /* the planes point to the mapping for the whole picture life */
+        pic->p[i].p_pixels =
+            interop->vt->MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                        picsys->bytes[i], flags);
+
+        if (interop->vt->GetError() != GL_NO_ERROR
+         || pic->p[i].p_pixels == NULL)
+        {
+            msg_Err(interop->gl, "could not map persistent PBO buffers");
+            return VLC_EGENERIC;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static int
+pbo_pics_alloc(const struct vlc_gl_interop *interop, bool persistent)
 {
     struct priv *priv = interop->priv;
-    for (size_t i = 0; i < PBO_DISPLAY_COUNT; ++i)
+    priv->pbo.display_count = persistent ? PBO_PERSISTENT_COUNT
+                                         : PBO_DISPLAY_COUNT;
+    for (size_t i = 0; i < priv->pbo.display_count; ++i)
     {
         picture_t *pic = priv->pbo.display_pics[i] =
             pbo_picture_create(interop);
         if (pic == NULL)
             goto error;
 
-        if (pbo_data_alloc(interop, pic) != VLC_SUCCESS)
+        int ret = persistent ? persistent_data_alloc(interop, pic,
+                                                     GL_MAP_WRITE_BIT)
+                             : pbo_data_alloc(interop, pic);
+        if (ret != VLC_SUCCESS)
             goto error;
     }
 
@@ -148,8 +213,12 @@ pbo_pics_alloc(const struct vlc_gl_interop *interop)
 
     return VLC_SUCCESS;
 error:
-    for (size_t i = 0; i < PBO_DISPLAY_COUNT && priv->pbo.display_pics[i]; ++i)
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    for (size_t i = 0; i < priv->pbo.display_count && priv->pbo.display_pics[i]; ++i)
+    {
         picture_Release(priv->pbo.display_pics[i]);
+        priv->pbo.display_pics[i] = NULL;
+    }
     return VLC_EGENERIC;
 }
 
@@ -163,7 +232,7 @@ tc_pbo_update(const struct vlc_gl_interop *interop, GLuint *textures,
 
     picture_t *display_pic = priv->pbo.display_pics[priv->pbo.display_idx];
     picture_sys_t *p_sys = display_pic->p_sys;
-    priv->pbo.display_idx = (priv->pbo.display_idx + 1) % PBO_DISPLAY_COUNT;
+    priv->pbo.display_idx = (priv->pbo.display_idx + 1) % priv->pbo.display_count;
 
     for (int i = 0; i < pic->i_planes; i++)
     {
@@ -171,6 +240,9 @@ tc_pbo_update(const struct vlc_gl_interop *interop, GLuint *textures,
         const GLvoid *data = pic->p[i].p_pixels;
         interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER,
                            p_sys->buffers[i]);
+        /* orphan the previous storage, instead of waiting for its upload */
+        interop->vt->BufferData(GL_PIXEL_UNPACK_BUFFER, p_sys->bytes[i], NULL,
+                                GL_DYNAMIC_DRAW);
         interop->vt->BufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
 
         interop->vt->ActiveTexture(GL_TEXTURE0 + i);
@@ -190,6 +262,201 @@ tc_pbo_update(const struct vlc_gl_interop *interop, GLuint *textures,
     return VLC_SUCCESS;
 }
 
+static bool
+pool_has_picture(const struct priv *priv, const picture_t *pic)
+{
+    for (size_t i = 0; i < priv->pool.count; ++i)
+        if (priv->pool.pics[i]->p_sys == pic->p_sys)
+            return true;
+    return false;
+}
+
+/* Gives the uploaded pool pictures back to the decoder once the GPU is done
+ * reading them, waiting at most timeout nanoseconds for each one */
+static void
+pool_release_uploaded(const struct vlc_gl_interop *interop, GLuint64 timeout)
+{
+    struct priv *priv = interop->priv;
+    size_t count = 0;
+
+    for (size_t i = 0; i < priv->pool.uploading_count; ++i)
+    {
+        picture_t *pic = priv->pool.uploading[i];
+        picture_sys_t *picsys = pic->p_sys;
+
+        GLenum ret = interop->vt->ClientWaitSync(picsys->fence,
+                                                 GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                 timeout);
+        if (ret == GL_TIMEOUT_EXPIRED)
+        {
+            priv->pool.uploading[count++] = pic;
+            continue;
+        }
+
+        interop->vt->DeleteSync(picsys->fence);
+        picsys->fence = NULL;
+        picture_Release(pic);
+    }
+    priv->pool.uploading_count = count;
+}
+
+static picture_pool_t *
+tc_persistent_get_pool(const struct vlc_gl_interop *interop, unsigned count)
+{
+    struct priv *priv = interop->priv;
+
+    if (count == 0 || count > POOL_MAX_COUNT - priv->pool.count)
+        return NULL;
+
+    picture_t *pics[count];
+    unsigned i;
+
+    for (i = 0; i < count; ++i)
+    {
+        picture_t *pic = pbo_picture_create(interop);
+        if (pic == NULL)
+            goto error;
+
+        /* decoders also read the pictures, for the motion compensation */
+        if (persistent_data_alloc(interop, pic,
+                                  GL_MAP_READ_BIT | GL_MAP_WRITE_BIT)
+                != VLC_SUCCESS)
+        {
+            picture_Release(pic);
+            goto error;
+        }
+
+        picture_sys_t *picsys = pic->p_sys;
+        picsys->gl = interop->gl;
+        vlc_gl_Hold(picsys->gl);
+        pics[i] = pic;
+    }
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    picture_pool_t *pool = picture_pool_New(count, pics);
+    if (pool == NULL)
+        goto error;
+
+    for (i = 0; i < count; ++i)
+        priv->pool.pics[priv->pool.count++] = picture_Hold(pics[i]);
+    return pool;
+
+error:
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    while (i > 0)
+        picture_Release(pics[--i]);
+    return NULL;
+}
+
+/* The decoder rendered into the mapped buffers, only the upload to the
+ * textures is left */
+static void
+tc_persistent_update_pool(const struct vlc_gl_interop *interop,
+                          GLuint *textures, const GLsizei *tex_width,
+                          const GLsizei *tex_height, picture_t *pic)
+{
+    struct priv *priv = interop->priv;
+    picture_sys_t *p_sys = pic->p_sys;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const plane_t *plane = &pic->p[i];
+
+        interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, p_sys->buffers[i]);
+
+        interop->vt->ActiveTexture(GL_TEXTURE0 + i);
+        interop->vt->BindTexture(interop->tex_target, textures[i]);
+
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, plane->i_pitch
+            * tex_width[i] / (plane->i_visible_pitch ? plane->i_visible_pitch : 1));
+
+        interop->vt->TexSubImage2D(interop->tex_target, 0, 0, 0, tex_width[i], tex_height[i],
+                                   interop->texs[i].format, interop->texs[i].type, NULL);
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    /* Hold the picture, so that the decoder does not get it back before the
+     * upload is done. A picture displayed again is held only once. */
+    if (p_sys->fence != NULL)
+        interop->vt->DeleteSync(p_sys->fence);
+    else
+    {
+        assert(priv->pool.uploading_count < POOL_MAX_COUNT);
+        priv->pool.uploading[priv->pool.uploading_count++] = picture_Hold(pic);
+    }
+    p_sys->fence = interop->vt->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    /* turn off pbo */
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+static int
+tc_persistent_update(const struct vlc_gl_interop *interop, GLuint *textures,
+                     const GLsizei *tex_width, const GLsizei *tex_height,
+                     picture_t *pic, const size_t *plane_offset)
+{
+    (void) plane_offset; assert(plane_offset == NULL);
+    struct priv *priv = interop->priv;
+
+    pool_release_uploaded(interop, 0);
+
+    if (pool_has_picture(priv, pic))
+    {
+        tc_persistent_update_pool(interop, textures, tex_width, tex_height,
+                                  pic);
+        return VLC_SUCCESS;
+    }
+
+    picture_t *display_pic = priv->pbo.display_pics[priv->pbo.display_idx];
+    picture_sys_t *p_sys = display_pic->p_sys;
+    priv->pbo.display_idx = (priv->pbo.display_idx + 1) % priv->pbo.display_count;
+
+    /* Wait for the last upload from these buffers, which is usually done
+     * already as the ring holds several pictures in flight */
+    if (p_sys->fence != NULL)
+    {
+        GLenum ret;
+        do
+            ret = interop->vt->ClientWaitSync(p_sys->fence,
+                                              GL_SYNC_FLUSH_COMMANDS_BIT,
+                                              UINT64_C(1000000000));
+        while (ret == GL_TIMEOUT_EXPIRED);
+
+        interop->vt->DeleteSync(p_sys->fence);
+        p_sys->fence = NULL;
+        if (ret == GL_WAIT_FAILED)
+            return VLC_EGENERIC;
+    }
+
+    /* Write into the mapped buffers directly, the upload to the textures
+     * is then done asynchronously by the GPU */
+    picture_CopyPixels(display_pic, pic);
+
+    for (int i = 0; i < display_pic->i_planes; i++)
+    {
+        const plane_t *plane = &display_pic->p[i];
+
+        interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, p_sys->buffers[i]);
+
+        interop->vt->ActiveTexture(GL_TEXTURE0 + i);
+        interop->vt->BindTexture(interop->tex_target, textures[i]);
+
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, plane->i_pitch
+            * tex_width[i] / (plane->i_visible_pitch ? plane->i_visible_pitch : 1));
+
+        interop->vt->TexSubImage2D(interop->tex_target, 0, 0, 0, tex_width[i], tex_height[i],
+                                   interop->texs[i].format, interop->texs[i].type, NULL);
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    p_sys->fence = interop->vt->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    /* turn off pbo */
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return VLC_SUCCESS;
+}
+
 static int
 tc_common_allocate_textures(const struct vlc_gl_interop *interop, GLuint *textures,
                             const GLsizei *tex_width, const GLsizei *tex_height)
@@ -287,7 +554,14 @@ void
 opengl_interop_generic_deinit(struct vlc_gl_interop *interop)
 {
     struct priv *priv = interop->priv;
-    for (size_t i = 0; i < PBO_DISPLAY_COUNT && priv->pbo.display_pics[i]; ++i)
+
+    /* The decoder may keep its pool: only the uploads must be finished */
+    while (priv->pool.uploading_count > 0)
+        pool_release_uploaded(interop, UINT64_C(1000000000));
+    for (size_t i = 0; i < priv->pool.count; ++i)
+        picture_Release(priv->pool.pics[i]);
+
+    for (size_t i = 0; i < priv->pbo.display_count && priv->pbo.display_pics[i]; ++i)
         picture_Release(priv->pbo.display_pics[i]);
     free(priv->texture_temp_buf);
     free(priv);
@@ -374,9 +648,31 @@ opengl_interop_generic_init(struct vlc_gl_interop *interop, bool allow_dr)
             (vlc_gl_StrHasToken(interop->api->extensions, "GL_ARB_pixel_buffer_object") ||
              vlc_gl_StrHasToken(interop->api->extensions, "GL_EXT_pixel_buffer_object"));
 
+        /* Persistent mapping: OpenGL 4.4, or GL(ES) with buffer storage */
+        const bool has_storage =
+            strverscmp((const char *)ogl_version, "4.4") >= 0 ||
+            vlc_gl_StrHasToken(interop->api->extensions, "GL_ARB_buffer_storage") ||
+            vlc_gl_StrHasToken(interop->api->extensions, "GL_EXT_buffer_storage");
+
+        const bool supports_persistent = has_pbo && has_storage
+            && interop->vt->BufferStorage && interop->vt->MapBufferRange
+            && interop->vt->FenceSync && interop->vt->DeleteSync
+            && interop->vt->ClientWaitSync;
+
         const bool supports_pbo = has_pbo && interop->vt->BufferData
             && interop->vt->BufferSubData;
-        if (supports_pbo && pbo_pics_alloc(interop) == VLC_SUCCESS)
+        if (supports_persistent && pbo_pics_alloc(interop, true) == VLC_SUCCESS)
+        {
+            static const struct vlc_gl_interop_ops persistent_ops = {
+                .allocate_textures = tc_common_allocate_textures,
+                .update_textures = tc_persistent_update,
+                .get_pool = tc_persistent_get_pool,
+                .close = opengl_interop_generic_deinit,
+            };
+            interop->ops = &persistent_ops;
+            msg_Dbg(interop->gl, "Persistent PBO support enabled");
+        }
+        else if (supports_pbo && pbo_pics_alloc(interop, false) == VLC_SUCCESS)
         {
             static const struct vlc_gl_interop_ops pbo_ops = {
                 .allocate_textures = tc_common_allocate_textures,
@@ -23,6 +23,7 @@
 #endif
 
 #include <assert.h>
+#include <stdint.h>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -32,6 +33,7 @@
 #include <vlc_vout_window.h>
 #include <vlc_codec.h>
 #include <vlc_plugin.h>
+#include <vlc_fs.h>
 
 #include "gl_api.h"
 #include "interop.h"
@@ -46,6 +48,33 @@ typedef void *GLeglImageOES;
 typedef void (*PFNGLEGLIMAGETARGETTEXTURE2DOESPROC)(GLenum target, GLeglImageOES image);
 #endif
 
+#ifndef EGL_EXT_image_dma_buf_import_modifiers
+#define EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT 0x3443
+#define EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT 0x3444
+#endif
+
+#define DRM_FORMAT_MOD_LINEAR   UINT64_C(0)
+#define DRM_FORMAT_MOD_INVALID  ((UINT64_C(1) << 56) - 1)
+
+/* The decoder surfaces come from a fixed pool, of at most 64 surfaces (see
+ * modules/codec/avcodec/va_surface.h) */
+#define VAEGL_CACHE_SIZE 64
+
+/* EGL images of a VA surface, kept as long as the interop */
+struct vaegl_surface
+{
+    VASurfaceID  surface;
+    unsigned     num_planes;
+    EGLImageKHR  egl_images[3];
+    uint64_t     last_use;
+
+    /* exported with vaExportSurfaceHandle() */
+    int          fds[4];
+    unsigned     num_fds;
+    /* or derived, if image_id is valid */
+    VAImage      va_image;
+};
+
 struct priv
 {
     VADisplay vadpy;
@@ -55,19 +84,22 @@ struct priv
     unsigned fourcc;
     EGLint drm_fourccs[3];
 
-    struct {
-        picture_t *  pic;
-        VAImage      va_image;
-        VABufferInfo va_buffer_info;
-        void *       egl_images[3];
-    } last;
+    bool can_export; /* vaExportSurfaceHandle() can be used */
+    bool has_modifiers; /* EGL_EXT_image_dma_buf_import_modifiers */
+
+    struct vaegl_surface cache[VAEGL_CACHE_SIZE];
+    unsigned cache_count;
+    uint64_t use_count;
+
+    picture_t *last_pic; /* held until the next picture is bound */
 };
 
 static EGLImageKHR
 vaegl_image_create(const struct vlc_gl_interop *interop, EGLint w, EGLint h,
-                   EGLint fourcc, EGLint fd, EGLint offset, EGLint pitch)
+                   EGLint fourcc, EGLint fd, EGLint offset, EGLint pitch,
+                   uint64_t modifier)
 {
-    EGLint attribs[] = {
+    EGLint attribs[17] = {
         EGL_WIDTH, w,
         EGL_HEIGHT, h,
         EGL_LINUX_DRM_FOURCC_EXT, fourcc,
@@ -77,6 +109,15 @@ vaegl_image_create(const struct vlc_gl_interop *interop, EGLint w, EGLint h,
         EGL_NONE
     };
 
+    if (modifier != DRM_FORMAT_MOD_INVALID)
+    {
+        attribs[12] = EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT;
+        attribs[13] = modifier & 0xffffffff;
+        attribs[14] = EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT;
+        attribs[15] = modifier >> 32;
+        attribs[16] = EGL_NONE;
+    }
+
     return interop->gl->egl.createImageKHR(interop->gl, EGL_LINUX_DMA_BUF_EXT,
                                            NULL, attribs);
 }
@@ -88,18 +129,179 @@ vaegl_image_destroy(const struct vlc_gl_interop *interop, EGLImageKHR image)
 }
 
 static void
-vaegl_release_last_pic(const struct vlc_gl_interop *interop, struct priv *priv)
+vaegl_surface_release(const struct vlc_gl_interop *interop,
+                      struct vaegl_surface *entry)
 {
+    struct priv *priv = interop->priv;
     vlc_object_t *o = VLC_OBJECT(interop->gl);
 
-    for (unsigned i = 0; i < priv->last.va_image.num_planes; ++i)
-        vaegl_image_destroy(interop, priv->last.egl_images[i]);
+    for (unsigned i = 0; i < entry->num_planes; ++i)
+        if (entry->egl_images[i] != NULL)
+            vaegl_image_destroy(interop, entry->egl_images[i]);
 
-    vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, priv->last.va_image.buf);
+    for (unsigned i = 0; i < entry->num_fds; ++i)
+        vlc_close(entry->fds[i]);
 
-    vlc_vaapi_DestroyImage(o, priv->vadpy, priv->last.va_image.image_id);
+    if (entry->va_image.image_id != VA_INVALID_ID)
+    {
+        vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, entry->va_image.buf);
+        vlc_vaapi_DestroyImage(o, priv->vadpy, entry->va_image.image_id);
+    }
+}
+
+#if VA_CHECK_VERSION(1, 1, 0)
+/* Imports the DRM PRIME layers of the surface, one per plane */
+static int
+vaegl_surface_export(const struct vlc_gl_interop *interop,
+                     struct vaegl_surface *entry,
+                     const GLsizei *tex_width, const GLsizei *tex_height)
+{
+    struct priv *priv = interop->priv;
+    VADRMPRIMESurfaceDescriptor desc;
+
+    if (vlc_vaapi_ExportSurfaceHandle(VLC_OBJECT(interop->gl), priv->vadpy,
+                                      entry->surface,
+                                      VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                                      VA_EXPORT_SURFACE_READ_ONLY
+                                    | VA_EXPORT_SURFACE_SEPARATE_LAYERS,
+                                      &desc))
+        return VLC_EGENERIC;
 
-    picture_Release(priv->last.pic);
+    entry->num_fds = desc.num_objects;
+    for (unsigned i = 0; i < desc.num_objects; ++i)
+        entry->fds[i] = desc.objects[i].fd;
+
+    if (desc.num_layers != entry->num_planes)
+        return VLC_EGENERIC;
+
+    for (unsigned i = 0; i < desc.num_layers; ++i)
+    {
+        const unsigned obj = desc.layers[i].object_index[0];
+        uint64_t modifier = desc.objects[obj].drm_format_modifier;
+
+        if (!priv->has_modifiers)
+        {
+            /* Only linear buffers can be imported without the modifier */
+            if (modifier != DRM_FORMAT_MOD_LINEAR
+             && modifier != DRM_FORMAT_MOD_INVALID)
+                return VLC_EGENERIC;
+            modifier = DRM_FORMAT_MOD_INVALID;
+        }
+
+        entry->egl_images[i] =
+            vaegl_image_create(interop, tex_width[i], tex_height[i],
+                               desc.layers[i].drm_format,
+                               desc.objects[obj].fd,
+                               desc.layers[i].offset[0],
+                               desc.layers[i].pitch[0], modifier);
+        if (entry->egl_images[i] == NULL)
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+#endif
+
+static int
+vaegl_surface_derive(const struct vlc_gl_interop *interop,
+                     struct vaegl_surface *entry,
+                     const GLsizei *tex_width, const GLsizei *tex_height)
+{
+    struct priv *priv = interop->priv;
+    vlc_object_t *o = VLC_OBJECT(interop->gl);
+    VAImage va_image;
+
+    if (vlc_vaapi_DeriveImage(o, priv->vadpy, entry->surface, &va_image))
+        return VLC_EGENERIC;
+    assert(va_image.format.fourcc == priv->fourcc);
+
+    VABufferInfo va_buffer_info = (VABufferInfo) {
+        .mem_type = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME
+    };
+    if (vlc_vaapi_AcquireBufferHandle(o, priv->vadpy, va_image.buf,
+                                      &va_buffer_info))
+    {
+        vlc_vaapi_DestroyImage(o, priv->vadpy, va_image.image_id);
+        return VLC_EGENERIC;
+    }
+    entry->va_image = va_image;
+
+    for (unsigned i = 0; i < entry->num_planes; ++i)
+    {
+        entry->egl_images[i] =
+            vaegl_image_create(interop, tex_width[i], tex_height[i],
+                               priv->drm_fourccs[i], va_buffer_info.handle,
+                               va_image.offsets[i], va_image.pitches[i],
+                               DRM_FORMAT_MOD_INVALID);
+        if (entry->egl_images[i] == NULL)
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Gets the EGL images of a surface, creating them on its first use */
+static struct vaegl_surface *
+vaegl_surface_get(const struct vlc_gl_interop *interop, VASurfaceID surface,
+                  const GLsizei *tex_width, const GLsizei *tex_height)
+{
+    struct priv *priv = interop->priv;
+    struct vaegl_surface *entry = NULL;
+
+    for (unsigned i = 0; i < priv->cache_count; ++i)
+        if (priv->cache[i].surface == surface)
+        {
+            entry = &priv->cache[i];
+            entry->last_use = ++priv->use_count;
+            return entry;
+        }
+
+    if (priv->cache_count < VAEGL_CACHE_SIZE)
+        entry = &priv->cache[priv->cache_count++];
+    else
+    {
+        /* More surfaces than expected: replace the least recently used */
+        entry = &priv->cache[0];
+        for (unsigned i = 1; i < VAEGL_CACHE_SIZE; ++i)
+            if (priv->cache[i].last_use < entry->last_use)
+                entry = &priv->cache[i];
+        vaegl_surface_release(interop, entry);
+    }
+
+    const vlc_chroma_description_t *desc =
+        vlc_fourcc_GetChromaDescription(interop->sw_fmt.i_chroma);
+    *entry = (struct vaegl_surface) {
+        .surface = surface,
+        .num_planes = desc->plane_count,
+        .last_use = ++priv->use_count,
+        .va_image = { .image_id = VA_INVALID_ID },
+    };
+
+#if VA_CHECK_VERSION(1, 1, 0)
+    if (priv->can_export)
+    {
+        if (vaegl_surface_export(interop, entry, tex_width, tex_height)
+                == VLC_SUCCESS)
+            return entry;
+
+        msg_Warn(interop->gl, "surface export failed, deriving images");
+        priv->can_export = false;
+        vaegl_surface_release(interop, entry);
+        *entry = (struct vaegl_surface) {
+            .surface = surface,
+            .num_planes = desc->plane_count,
+            .last_use = priv->use_count,
+            .va_image = { .image_id = VA_INVALID_ID },
+        };
+    }
+#endif
+
+    if (vaegl_surface_derive(interop, entry, tex_width, tex_height))
+    {
+        vaegl_surface_release(interop, entry);
+        /* Keep the cache dense */
+        *entry = priv->cache[--priv->cache_count];
+        return NULL;
+    }
+    return entry;
 }
 
 static int
@@ -155,76 +357,34 @@ tc_vaegl_update(const struct vlc_gl_interop *interop, GLuint *textures,
 {
     (void) plane_offset;
     struct priv *priv = interop->priv;
-    vlc_object_t *o = VLC_OBJECT(interop->gl);
-    VAImage va_image;
-    VABufferInfo va_buffer_info;
-    EGLImageKHR egl_images[3] = { };
-    bool release_image = false, release_buffer_info = false;
+    const VASurfaceID surface = vlc_vaapi_PicGetSurface(pic);
 
-    if (pic == priv->last.pic)
-    {
-        va_image = priv->last.va_image;
-        va_buffer_info = priv->last.va_buffer_info;
-        for (unsigned i = 0; i < priv->last.va_image.num_planes; ++i)
-            egl_images[i] = priv->last.egl_images[i];
-    }
-    else
-    {
-        if (vlc_vaapi_DeriveImage(o, priv->vadpy, vlc_vaapi_PicGetSurface(pic),
-                                  &va_image))
-            goto error;
-        release_image = true;
-
-        assert(va_image.format.fourcc == priv->fourcc);
+    struct vaegl_surface *entry =
+        vaegl_surface_get(interop, surface, tex_width, tex_height);
+    if (entry == NULL)
+        return VLC_EGENERIC;
 
-        va_buffer_info = (VABufferInfo) {
-            .mem_type = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME
-        };
-        if (vlc_vaapi_AcquireBufferHandle(o, priv->vadpy, va_image.buf,
-                                          &va_buffer_info))
-            goto error;
-        release_buffer_info = true;
-    }
+    /* The exported buffers are not synchronized with the decoder, unlike
+     * derived images */
+    if (entry->va_image.image_id == VA_INVALID_ID
+     && vlc_vaapi_SyncSurface(VLC_OBJECT(interop->gl), priv->vadpy, surface))
+        return VLC_EGENERIC;
 
-    for (unsigned i = 0; i < va_image.num_planes; ++i)
+    for (unsigned i = 0; i < entry->num_planes; ++i)
     {
-        egl_images[i] =
-            vaegl_image_create(interop, tex_width[i], tex_height[i],
-                               priv->drm_fourccs[i], va_buffer_info.handle,
-                               va_image.offsets[i], va_image.pitches[i]);
-        if (egl_images[i] == NULL)
-            goto error;
-
         interop->vt->BindTexture(interop->tex_target, textures[i]);
-
-        priv->glEGLImageTargetTexture2DOES(interop->tex_target, egl_images[i]);
+        priv->glEGLImageTargetTexture2DOES(interop->tex_target,
+                                           entry->egl_images[i]);
     }
 
-    if (pic != priv->last.pic)
+    if (pic != priv->last_pic)
     {
-        if (priv->last.pic != NULL)
-            vaegl_release_last_pic(interop, priv);
-        priv->last.pic = picture_Hold(pic);
-        priv->last.va_image = va_image;
-        priv->last.va_buffer_info = va_buffer_info;
-        for (unsigned i = 0; i < va_image.num_planes; ++i)
-            priv->last.egl_images[i] = egl_images[i];
+        if (priv->last_pic != NULL)
+            picture_Release(priv->last_pic);
+        priv->last_pic = picture_Hold(pic);
     }
 
     return VLC_SUCCESS;
-
-error:
-    if (release_image)
-    {
-        if (release_buffer_info)
-            vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, va_image.buf);
-
-        for (unsigned i = 0; i < 3 && egl_images[i] != NULL; ++i)
-            vaegl_image_destroy(interop, egl_images[i]);
-
-        vlc_vaapi_DestroyImage(o, priv->vadpy, va_image.image_id);
-    }
-    return VLC_EGENERIC;
 }
 
 static void
@@ -232,8 +392,11 @@ Close(struct vlc_gl_interop *interop)
 {
     struct priv *priv = interop->priv;
 
-    if (priv->last.pic != NULL)
-        vaegl_release_last_pic(interop, priv);
+    for (unsigned i = 0; i < priv->cache_count; ++i)
+        vaegl_surface_release(interop, &priv->cache[i]);
+
+    if (priv->last_pic != NULL)
+        picture_Release(priv->last_pic);
 
     free(priv);
 }
@@ -313,7 +476,8 @@ tc_va_check_derive_image(const struct vlc_gl_interop *interop)
         EGLint h = (va_image.height * image_desc->p[i].h.num) / image_desc->p[i].h.den;
         EGLImageKHR egl_image =
             vaegl_image_create(interop, w, h, priv->drm_fourccs[i], va_buffer_info.handle,
-                               va_image.offsets[i], va_image.pitches[i]);
+                               va_image.offsets[i], va_image.pitches[i],
+                               DRM_FORMAT_MOD_INVALID);
         if (egl_image == NULL)
         {
             msg_Warn(o, "Can't create Image KHR: kernel too old ?");
@@ -405,6 +569,12 @@ Open(vlc_object_t *obj)
     if (tc_va_check_derive_image(interop))
         goto error;
 
+#if VA_CHECK_VERSION(1, 1, 0)
+    priv->can_export = true;
+#endif
+    priv->has_modifiers =
+        vlc_gl_StrHasToken(eglexts, "EGL_EXT_image_dma_buf_import_modifiers");
+
     int ret = opengl_interop_init(interop, GL_TEXTURE_2D, vlc_sw_chroma,
                                   interop->fmt.space);
     if (ret != VLC_SUCCESS)
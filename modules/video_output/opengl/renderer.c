@@ -1002,6 +1002,16 @@ vlc_gl_renderer_Prepare(struct vlc_gl_renderer *renderer, picture_t *picture)
                                          NULL);
 }
 
+picture_pool_t *
+vlc_gl_renderer_GetPool(struct vlc_gl_renderer *renderer, unsigned count)
+{
+    const struct vlc_gl_interop *interop = renderer->interop;
+
+    if (interop->ops->get_pool == NULL)
+        return NULL;
+    return interop->ops->get_pool(interop, count);
+}
+
 int
 vlc_gl_renderer_Draw(struct vlc_gl_renderer *renderer)
 {
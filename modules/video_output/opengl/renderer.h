@@ -191,6 +191,16 @@ vlc_gl_renderer_Delete(struct vlc_gl_renderer *renderer);
 int
 vlc_gl_renderer_Prepare(struct vlc_gl_renderer *renderer, picture_t *picture);
 
+/**
+ * Get a pool of pictures uploaded without copy
+ *
+ * \param renderer the renderer
+ * \param count number of pictures
+ * \return a picture pool, or NULL if the interop does not provide one
+ */
+picture_pool_t *
+vlc_gl_renderer_GetPool(struct vlc_gl_renderer *renderer, unsigned count);
+
 /**
  * Draw the prepared picture
  *
@@ -41,20 +41,36 @@
 #include "interop.h"
 #include "vout_helper.h"
 
+/* Subpicture regions are packed in a single texture, where they stay while
+ * they are displayed: only the new or changed regions are uploaded, and all
+ * of them are drawn at once. */
+#define ATLAS_INITIAL_SIZE 512
+/* Transparent border around each region in the atlas, so that the linear
+ * filtering does not sample the neighbour regions */
+#define ATLAS_BORDER 1
+
+/* position, texture coordinates and alpha */
+#define VERTEX_COMPONENTS 5
+#define VERTICES_PER_REGION 6
+
 typedef struct {
-    GLuint   texture;
+    picture_t *picture; /* held, to recognize unchanged regions */
+    unsigned x_offset;
+    unsigned y_offset;
     GLsizei  width;
     GLsizei  height;
 
+    /* position in the atlas, inside the border */
+    GLsizei  atlas_x;
+    GLsizei  atlas_y;
+    bool     uploaded;
+
     float    alpha;
 
     float    top;
     float    left;
     float    bottom;
     float    right;
-
-    float    tex_width;
-    float    tex_height;
 } gl_region_t;
 
 struct vlc_gl_sub_renderer
@@ -68,18 +84,35 @@ struct vlc_gl_sub_renderer
     gl_region_t *regions;
     unsigned region_count;
 
+    struct {
+        GLuint texture;
+        GLsizei size;
+        GLsizei max_size;
+        /* shelf packing: regions are placed left to right on rows, space is
+         * only reclaimed when the atlas is full */
+        GLsizei shelf_x;
+        GLsizei shelf_y;
+        GLsizei shelf_height;
+    } atlas;
+
+    /* region pixels with their border, uploaded at once */
+    uint8_t *upload_buffer;
+    size_t upload_size;
+
+    GLfloat *vertices;
+    size_t vertex_size; /* allocated vertices */
+
     GLuint program_id;
     struct {
         GLint vertex_pos;
         GLint tex_coords_in;
+        GLint alpha_in;
     } aloc;
     struct {
         GLint sampler;
-        GLint alpha;
     } uloc;
 
-    GLuint *buffer_objects;
-    unsigned buffer_object_count;
+    GLuint vertex_buffer;
 };
 
 static int
@@ -100,9 +133,9 @@ FetchLocations(struct vlc_gl_sub_renderer *sr)
 #define GET_ULOC(x, str) GET_LOC(Uniform, x, str)
 #define GET_ALOC(x, str) GET_LOC(Attrib, x, str)
     GET_ULOC(sr->uloc.sampler, "sampler");
-    GET_ULOC(sr->uloc.alpha, "alpha");
     GET_ALOC(sr->aloc.vertex_pos, "vertex_pos");
     GET_ALOC(sr->aloc.tex_coords_in, "tex_coords_in");
+    GET_ALOC(sr->aloc.alpha_in, "alpha_in");
 
 #undef GET_LOC
 #undef GET_ULOC
@@ -128,12 +161,23 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
 
     /* Allocates our textures */
     assert(!sr->interop->handle_texs_gen);
+    assert(sr->interop->tex_count == 1);
 
     sr->gl = gl;
     sr->api = api;
     sr->vt = vt;
     sr->region_count = 0;
     sr->regions = NULL;
+    sr->upload_buffer = NULL;
+    sr->upload_size = 0;
+    sr->vertices = NULL;
+    sr->vertex_size = 0;
+
+    GLint max_tex_size;
+    vt->GetIntegerv(GL_MAX_TEXTURE_SIZE, &max_tex_size);
+    sr->atlas.texture = 0;
+    sr->atlas.size = 0;
+    sr->atlas.max_size = max_tex_size;
 
     static const char *const VERTEX_SHADER_SRC =
 #if defined(USE_OPENGL_ES2)
@@ -143,9 +187,12 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
 #endif
         "attribute vec2 vertex_pos;\n"
         "attribute vec2 tex_coords_in;\n"
+        "attribute float alpha_in;\n"
         "varying vec2 tex_coords;\n"
+        "varying float alpha;\n"
         "void main() {\n"
         "  tex_coords = tex_coords_in;\n"
+        "  alpha = alpha_in;\n"
         "  gl_Position = vec4(vertex_pos, 0.0, 1.0);\n"
         "}\n";
 
@@ -157,8 +204,8 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
         "#version 120\n"
 #endif
         "uniform sampler2D sampler;\n"
-        "uniform float alpha;\n"
         "varying vec2 tex_coords;\n"
+        "varying float alpha;\n"
         "void main() {\n"
         "  vec4 color = texture2D(sampler, tex_coords);\n"
         "  color.a *= alpha;\n"
@@ -176,15 +223,7 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
     if (ret != VLC_SUCCESS)
         goto error_3;
 
-    /* Initial number of allocated buffer objects for subpictures, will grow dynamically. */
-    static const unsigned INITIAL_BUFFER_OBJECT_COUNT = 8;
-    sr->buffer_objects = vlc_alloc(INITIAL_BUFFER_OBJECT_COUNT, sizeof(GLuint));
-    if (!sr->buffer_objects)
-        goto error_3;
-
-    sr->buffer_object_count = INITIAL_BUFFER_OBJECT_COUNT;
-
-    vt->GenBuffers(sr->buffer_object_count, sr->buffer_objects);
+    vt->GenBuffers(1, &sr->vertex_buffer);
 
     return sr;
 
@@ -198,115 +237,252 @@ error_1:
     return NULL;
 }
 
+static void
+ReleaseRegions(gl_region_t *regions, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        if (regions[i].picture)
+            picture_Release(regions[i].picture);
+    free(regions);
+}
+
 void
 vlc_gl_sub_renderer_Delete(struct vlc_gl_sub_renderer *sr)
 {
-    if (sr->buffer_object_count)
-        sr->vt->DeleteBuffers(sr->buffer_object_count, sr->buffer_objects);
-    free(sr->buffer_objects);
+    sr->vt->DeleteBuffers(1, &sr->vertex_buffer);
+    sr->vt->DeleteProgram(sr->program_id);
 
-    for (unsigned i = 0; i < sr->region_count; ++i)
-    {
-        if (sr->regions[i].texture)
-            sr->vt->DeleteTextures(1, &sr->regions[i].texture);
-    }
-    free(sr->regions);
+    ReleaseRegions(sr->regions, sr->region_count);
+    if (sr->atlas.texture)
+        vlc_gl_interop_DeleteTextures(sr->interop, &sr->atlas.texture);
+    free(sr->upload_buffer);
+    free(sr->vertices);
 
     vlc_gl_interop_Delete(sr->interop);
 
     free(sr);
 }
 
+static void
+AtlasReset(struct vlc_gl_sub_renderer *sr)
+{
+    sr->atlas.shelf_x = 0;
+    sr->atlas.shelf_y = 0;
+    sr->atlas.shelf_height = 0;
+}
+
+static int
+AtlasResize(struct vlc_gl_sub_renderer *sr, GLsizei size)
+{
+    if (sr->atlas.texture)
+        vlc_gl_interop_DeleteTextures(sr->interop, &sr->atlas.texture);
+    sr->atlas.size = 0;
+    AtlasReset(sr);
+
+    GLsizei width = size, height = size;
+    int ret = vlc_gl_interop_GenerateTextures(sr->interop, &width, &height,
+                                              &sr->atlas.texture);
+    if (ret != VLC_SUCCESS)
+        return ret;
+    sr->atlas.size = size;
+    return VLC_SUCCESS;
+}
+
+static bool
+AtlasPlace(struct vlc_gl_sub_renderer *sr, gl_region_t *glr)
+{
+    const GLsizei width  = glr->width  + 2 * ATLAS_BORDER;
+    const GLsizei height = glr->height + 2 * ATLAS_BORDER;
+
+    if (width > sr->atlas.size)
+        return false;
+    if (sr->atlas.shelf_x + width > sr->atlas.size)
+    {
+        /* next shelf */
+        sr->atlas.shelf_y += sr->atlas.shelf_height;
+        sr->atlas.shelf_x = 0;
+        sr->atlas.shelf_height = 0;
+    }
+    if (sr->atlas.shelf_y + height > sr->atlas.size)
+        return false;
+
+    glr->atlas_x = sr->atlas.shelf_x + ATLAS_BORDER;
+    glr->atlas_y = sr->atlas.shelf_y + ATLAS_BORDER;
+    glr->uploaded = false;
+    sr->atlas.shelf_x += width;
+    if (height > sr->atlas.shelf_height)
+        sr->atlas.shelf_height = height;
+    return true;
+}
+
+/* Places the regions which are not in the atlas yet. When it is full, all
+ * the displayed regions are repacked, then the atlas grows, and the regions
+ * which can't fit in the biggest atlas are dropped (zero size). */
+static int
+AtlasPlaceRegions(struct vlc_gl_sub_renderer *sr)
+{
+    if (sr->atlas.size == 0)
+    {
+        int ret = AtlasResize(sr, __MIN(ATLAS_INITIAL_SIZE, sr->atlas.max_size));
+        if (ret != VLC_SUCCESS)
+            return ret;
+    }
+
+    bool repacked = false;
+    for (;;)
+    {
+        unsigned i;
+        for (i = 0; i < sr->region_count; i++)
+        {
+            gl_region_t *glr = &sr->regions[i];
+            if (!glr->uploaded && glr->width > 0 && !AtlasPlace(sr, glr))
+                break;
+        }
+        if (i == sr->region_count)
+            return VLC_SUCCESS;
+
+        if (repacked && sr->atlas.size < sr->atlas.max_size)
+        {
+            int ret = AtlasResize(sr, __MIN(2 * sr->atlas.size,
+                                            sr->atlas.max_size));
+            if (ret != VLC_SUCCESS)
+                return ret;
+        }
+        else if (repacked)
+        {
+            msg_Warn(sr->gl, "subpicture region %dx%d does not fit",
+                     sr->regions[i].width, sr->regions[i].height);
+            sr->regions[i].width = sr->regions[i].height = 0;
+        }
+
+        AtlasReset(sr);
+        for (unsigned j = 0; j < sr->region_count; j++)
+            sr->regions[j].uploaded = false;
+        repacked = true;
+    }
+}
+
+static int
+AtlasUpload(struct vlc_gl_sub_renderer *sr, gl_region_t *glr)
+{
+    const struct vlc_gl_interop *interop = sr->interop;
+    const plane_t *plane = &glr->picture->p[0];
+    const size_t pixel_pitch = plane->i_pixel_pitch;
+    const GLsizei width  = glr->width  + 2 * ATLAS_BORDER;
+    const GLsizei height = glr->height + 2 * ATLAS_BORDER;
+    const size_t pitch = width * pixel_pitch;
+
+    /* Copy the region with a transparent border, which also gives a packed
+     * buffer (GL ES2 can't upload with a custom row length) */
+    const size_t size = pitch * height;
+    if (size > sr->upload_size)
+    {
+        uint8_t *buffer = realloc(sr->upload_buffer, size);
+        if (!buffer)
+            return VLC_ENOMEM;
+        sr->upload_buffer = buffer;
+        sr->upload_size = size;
+    }
+    memset(sr->upload_buffer, 0, size);
+
+    const uint8_t *src = plane->p_pixels + glr->y_offset * plane->i_pitch
+                         + glr->x_offset * pixel_pitch;
+    uint8_t *dst = sr->upload_buffer + ATLAS_BORDER * pitch
+                   + ATLAS_BORDER * pixel_pitch;
+    for (GLsizei y = 0; y < glr->height; y++)
+    {
+        memcpy(dst, src, glr->width * pixel_pitch);
+        src += plane->i_pitch;
+        dst += pitch;
+    }
+
+    sr->vt->BindTexture(interop->tex_target, sr->atlas.texture);
+    sr->vt->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    sr->vt->TexSubImage2D(interop->tex_target, 0,
+                          glr->atlas_x - ATLAS_BORDER,
+                          glr->atlas_y - ATLAS_BORDER, width, height,
+                          interop->texs[0].format, interop->texs[0].type,
+                          sr->upload_buffer);
+    glr->uploaded = true;
+    return VLC_SUCCESS;
+}
+
 int
 vlc_gl_sub_renderer_Prepare(struct vlc_gl_sub_renderer *sr, subpicture_t *subpicture)
 {
     GL_ASSERT_NOERROR(sr->vt);
 
-    const struct vlc_gl_interop *interop = sr->interop;
-
-    int last_count = sr->region_count;
+    unsigned last_count = sr->region_count;
     gl_region_t *last = sr->regions;
 
+    sr->region_count = 0;
+    sr->regions = NULL;
+
     if (subpicture) {
-        int count = 0;
+        unsigned count = 0;
         for (subpicture_region_t *r = subpicture->p_region; r; r = r->p_next)
             count++;
 
         gl_region_t *regions = calloc(count, sizeof(*regions));
         if (!regions)
+        {
+            ReleaseRegions(last, last_count);
             return VLC_ENOMEM;
+        }
 
         sr->region_count = count;
         sr->regions = regions;
 
-        int i = 0;
+        unsigned i = 0;
         for (subpicture_region_t *r = subpicture->p_region;
              r; r = r->p_next, i++) {
             gl_region_t *glr = &sr->regions[i];
 
+            glr->x_offset = r->fmt.i_x_offset;
+            glr->y_offset = r->fmt.i_y_offset;
             glr->width  = r->fmt.i_visible_width;
             glr->height = r->fmt.i_visible_height;
-            if (!sr->api->supports_npot) {
-                glr->width  = vlc_align_pot(glr->width);
-                glr->height = vlc_align_pot(glr->height);
-                glr->tex_width  = (float) r->fmt.i_visible_width  / glr->width;
-                glr->tex_height = (float) r->fmt.i_visible_height / glr->height;
-            } else {
-                glr->tex_width  = 1.0;
-                glr->tex_height = 1.0;
-            }
             glr->alpha  = (float)subpicture->i_alpha * r->i_alpha / 255 / 255;
             glr->left   =  2.0 * (r->i_x                          ) / subpicture->i_original_picture_width  - 1.0;
             glr->top    = -2.0 * (r->i_y                          ) / subpicture->i_original_picture_height + 1.0;
             glr->right  =  2.0 * (r->i_x + r->fmt.i_visible_width ) / subpicture->i_original_picture_width  - 1.0;
             glr->bottom = -2.0 * (r->i_y + r->fmt.i_visible_height) / subpicture->i_original_picture_height + 1.0;
 
-            glr->texture = 0;
-            /* Try to recycle the textures allocated by the previous
-               call to this function. */
-            for (int j = 0; j < last_count; j++) {
-                if (last[j].texture &&
-                    last[j].width  == glr->width &&
-                    last[j].height == glr->height) {
-                    glr->texture = last[j].texture;
-                    memset(&last[j], 0, sizeof(last[j]));
+            /* Regions showing the same picture part are still in the atlas
+             * from the previous call, the vout keeps their pictures */
+            for (unsigned j = 0; j < last_count; j++) {
+                gl_region_t *prev = &last[j];
+                if (prev->picture == r->p_picture && prev->uploaded &&
+                    prev->x_offset == glr->x_offset &&
+                    prev->y_offset == glr->y_offset &&
+                    prev->width  == glr->width &&
+                    prev->height == glr->height) {
+                    glr->atlas_x = prev->atlas_x;
+                    glr->atlas_y = prev->atlas_y;
+                    glr->uploaded = true;
                     break;
                 }
             }
-
-            const size_t pixels_offset =
-                r->fmt.i_y_offset * r->p_picture->p->i_pitch +
-                r->fmt.i_x_offset * r->p_picture->p->i_pixel_pitch;
-            if (!glr->texture)
-            {
-                /* Could not recycle a previous texture, generate a new one. */
-                int ret = vlc_gl_interop_GenerateTextures(interop, &glr->width,
-                                                          &glr->height,
-                                                          &glr->texture);
-                if (ret != VLC_SUCCESS)
-                    break;
-            }
-            /* Use the visible pitch of the region */
-            r->p_picture->p[0].i_visible_pitch = r->fmt.i_visible_width
-                                               * r->p_picture->p[0].i_pixel_pitch;
-            int ret = interop->ops->update_textures(interop, &glr->texture,
-                                                    &glr->width, &glr->height,
-                                                    r->p_picture, &pixels_offset);
-            if (ret != VLC_SUCCESS)
-                break;
+            glr->picture = picture_Hold(r->p_picture);
         }
     }
-    else
-    {
-        sr->region_count = 0;
-        sr->regions = NULL;
-    }
+    ReleaseRegions(last, last_count);
+
+    if (sr->region_count == 0)
+        return VLC_SUCCESS;
 
-    for (int i = 0; i < last_count; i++) {
-        if (last[i].texture)
-            vlc_gl_interop_DeleteTextures(interop, &last[i].texture);
+    int ret = AtlasPlaceRegions(sr);
+    if (ret != VLC_SUCCESS)
+        return ret;
+
+    for (unsigned i = 0; i < sr->region_count; i++) {
+        gl_region_t *glr = &sr->regions[i];
+        if (!glr->uploaded && glr->width > 0) {
+            ret = AtlasUpload(sr, glr);
+            if (ret != VLC_SUCCESS)
+                return ret;
+        }
     }
-    free(last);
 
     GL_ASSERT_NOERROR(sr->vt);
 
@@ -321,60 +497,76 @@ vlc_gl_sub_renderer_Draw(struct vlc_gl_sub_renderer *sr)
 
     GL_ASSERT_NOERROR(vt);
 
-    assert(sr->program_id);
-    vt->UseProgram(sr->program_id);
-
-    vt->Enable(GL_BLEND);
-    vt->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    /* We need two buffer objects for each region: for vertex and texture coordinates. */
-    if (2 * sr->region_count > sr->buffer_object_count) {
-        if (sr->buffer_object_count > 0)
-            vt->DeleteBuffers(sr->buffer_object_count, sr->buffer_objects);
-        sr->buffer_object_count = 0;
+    if (sr->region_count == 0 || !sr->atlas.texture)
+        return VLC_SUCCESS;
 
-        int new_count = 2 * sr->region_count;
-        sr->buffer_objects = realloc_or_free(sr->buffer_objects, new_count * sizeof(GLuint));
-        if (!sr->buffer_objects)
+    const size_t vertex_count = VERTICES_PER_REGION * sr->region_count;
+    if (vertex_count > sr->vertex_size) {
+        GLfloat *vertices = vlc_reallocarray(sr->vertices, vertex_count,
+                                             VERTEX_COMPONENTS * sizeof(GLfloat));
+        if (!vertices)
             return VLC_ENOMEM;
-
-        sr->buffer_object_count = new_count;
-        vt->GenBuffers(sr->buffer_object_count, sr->buffer_objects);
+        sr->vertices = vertices;
+        sr->vertex_size = vertex_count;
     }
 
-    vt->ActiveTexture(GL_TEXTURE0 + 0);
+    /* Two triangles per region, from the atlas */
+    const float atlas_size = sr->atlas.size;
+    GLfloat *v = sr->vertices;
+    GLsizei drawn = 0;
     for (unsigned i = 0; i < sr->region_count; i++) {
-        gl_region_t *glr = &sr->regions[i];
-        const GLfloat vertexCoord[] = {
-            glr->left,  glr->top,
-            glr->left,  glr->bottom,
-            glr->right, glr->top,
-            glr->right, glr->bottom,
-        };
-        const GLfloat textureCoord[] = {
-            0.0, 0.0,
-            0.0, glr->tex_height,
-            glr->tex_width, 0.0,
-            glr->tex_width, glr->tex_height,
+        const gl_region_t *glr = &sr->regions[i];
+        if (!glr->uploaded || glr->width == 0 || glr->height == 0)
+            continue;
+
+        const float tex_left   = glr->atlas_x / atlas_size;
+        const float tex_top    = glr->atlas_y / atlas_size;
+        const float tex_right  = (glr->atlas_x + glr->width)  / atlas_size;
+        const float tex_bottom = (glr->atlas_y + glr->height) / atlas_size;
+        const GLfloat quad[VERTICES_PER_REGION][VERTEX_COMPONENTS] = {
+            { glr->left,  glr->top,    tex_left,  tex_top,    glr->alpha },
+            { glr->left,  glr->bottom, tex_left,  tex_bottom, glr->alpha },
+            { glr->right, glr->top,    tex_right, tex_top,    glr->alpha },
+            { glr->right, glr->top,    tex_right, tex_top,    glr->alpha },
+            { glr->left,  glr->bottom, tex_left,  tex_bottom, glr->alpha },
+            { glr->right, glr->bottom, tex_right, tex_bottom, glr->alpha },
         };
+        memcpy(v, quad, sizeof(quad));
+        v += VERTICES_PER_REGION * VERTEX_COMPONENTS;
+        drawn += VERTICES_PER_REGION;
+    }
+    if (drawn == 0)
+        return VLC_SUCCESS;
 
-        assert(glr->texture != 0);
-        vt->BindTexture(interop->tex_target, glr->texture);
-
-        vt->Uniform1f(sr->uloc.alpha, glr->alpha);
-
-        vt->BindBuffer(GL_ARRAY_BUFFER, sr->buffer_objects[2 * i]);
-        vt->BufferData(GL_ARRAY_BUFFER, sizeof(textureCoord), textureCoord, GL_STATIC_DRAW);
-        vt->EnableVertexAttribArray(sr->aloc.tex_coords_in);
-        vt->VertexAttribPointer(sr->aloc.tex_coords_in, 2, GL_FLOAT, 0, 0, 0);
+    assert(sr->program_id);
+    vt->UseProgram(sr->program_id);
 
-        vt->BindBuffer(GL_ARRAY_BUFFER, sr->buffer_objects[2 * i + 1]);
-        vt->BufferData(GL_ARRAY_BUFFER, sizeof(vertexCoord), vertexCoord, GL_STATIC_DRAW);
-        vt->EnableVertexAttribArray(sr->aloc.vertex_pos);
-        vt->VertexAttribPointer(sr->aloc.vertex_pos, 2, GL_FLOAT, 0, 0, 0);
+    vt->Enable(GL_BLEND);
+    vt->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        vt->DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    }
+    vt->ActiveTexture(GL_TEXTURE0 + 0);
+    vt->BindTexture(interop->tex_target, sr->atlas.texture);
+    vt->Uniform1i(sr->uloc.sampler, 0);
+
+    const GLsizei stride = VERTEX_COMPONENTS * sizeof(GLfloat);
+    vt->BindBuffer(GL_ARRAY_BUFFER, sr->vertex_buffer);
+    vt->BufferData(GL_ARRAY_BUFFER, drawn * stride, sr->vertices,
+                   GL_STREAM_DRAW);
+    vt->EnableVertexAttribArray(sr->aloc.vertex_pos);
+    vt->VertexAttribPointer(sr->aloc.vertex_pos, 2, GL_FLOAT, 0, stride,
+                            (const void *) 0);
+    vt->EnableVertexAttribArray(sr->aloc.tex_coords_in);
+    vt->VertexAttribPointer(sr->aloc.tex_coords_in, 2, GL_FLOAT, 0, stride,
+                            (const void *) (2 * sizeof(GLfloat)));
+    vt->EnableVertexAttribArray(sr->aloc.alpha_in);
+    vt->VertexAttribPointer(sr->aloc.alpha_in, 1, GL_FLOAT, 0, stride,
+                            (const void *) (4 * sizeof(GLfloat)));
+
+    vt->DrawArrays(GL_TRIANGLES, 0, drawn);
+
+    vt->DisableVertexAttribArray(sr->aloc.vertex_pos);
+    vt->DisableVertexAttribArray(sr->aloc.tex_coords_in);
+    vt->DisableVertexAttribArray(sr->aloc.alpha_in);
     vt->Disable(GL_BLEND);
 
     GL_ASSERT_NOERROR(vt);
@@ -58,8 +58,8 @@ vlc_gl_sub_renderer_Delete(struct vlc_gl_sub_renderer *sr);
 /**
  * Prepare the fragment shader
  *
- * Concretely, it allocates OpenGL textures if necessary and uploads the
- * picture.
+ * Concretely, it places the regions in the texture atlas if necessary, and
+ * uploads the regions which were not displayed by the previous call.
  *
  * \param sr the renderer
  * \param subpicture the subpicture to render
@@ -39,6 +39,7 @@
 #include <vlc_vout.h>
 #include <vlc_viewpoint.h>
 
+#include "filters.h"
 #include "gl_api.h"
 #include "gl_util.h"
 #include "vout_helper.h"
@@ -53,6 +54,7 @@ struct vout_display_opengl_t {
 
     struct vlc_gl_renderer *renderer;
     struct vlc_gl_sub_renderer *sub_renderer;
+    struct vlc_gl_filters *filters; /* can be NULL */
 };
 
 static const vlc_fourcc_t gl_subpicture_chromas[] = {
@@ -155,6 +157,18 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
     GL_ASSERT_NOERROR(vt);
 
+    char *filters = var_InheritString(gl, "gl-filters");
+    if (filters != NULL)
+    {
+        if (renderer->fmt.projection_mode == PROJECTION_MODE_RECTANGULAR)
+            vgl->filters = vlc_gl_filters_New(gl, &vgl->api, filters);
+        else
+            msg_Warn(gl, "OpenGL filters not supported with projections");
+        free(filters);
+    }
+
+    GL_ASSERT_NOERROR(vt);
+
     if (renderer->fmt.projection_mode != PROJECTION_MODE_RECTANGULAR
      && vout_display_opengl_SetViewpoint(vgl, viewpoint) != VLC_SUCCESS)
     {
@@ -181,6 +195,8 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
     vt->Finish();
     vt->Flush();
 
+    if (vgl->filters)
+        vlc_gl_filters_Delete(vgl->filters);
     vlc_gl_sub_renderer_Delete(vgl->sub_renderer);
     vlc_gl_renderer_Delete(vgl->renderer);
 
@@ -206,6 +222,8 @@ void vout_display_opengl_Viewport(vout_display_opengl_t *vgl, int x, int y,
 {
     const opengl_vtable_t *vt = &vgl->api.vt;
     vt->Viewport(x, y, width, height);
+    if (vgl->filters)
+        vlc_gl_filters_SetViewport(vgl->filters, x, y, width, height);
 }
 
 int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
@@ -217,10 +235,29 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
     if (ret != VLC_SUCCESS)
         return ret;
 
+    if (vgl->filters)
+    {
+        /* The filters process the picture at its size, once oriented */
+        const video_format_t *fmt = &vgl->renderer->fmt;
+        bool swap = ORIENT_IS_SWAP(fmt->orientation);
+        ret = vlc_gl_filters_Prepare(vgl->filters, picture,
+                swap ? fmt->i_visible_height : fmt->i_visible_width,
+                swap ? fmt->i_visible_width : fmt->i_visible_height);
+        if (ret != VLC_SUCCESS)
+            return ret;
+    }
+
     ret = vlc_gl_sub_renderer_Prepare(vgl->sub_renderer, subpicture);
     GL_ASSERT_NOERROR(&vgl->api.vt);
     return ret;
 }
+
+picture_pool_t *vout_display_opengl_GetPool(vout_display_opengl_t *vgl,
+                                            unsigned count)
+{
+    return vlc_gl_renderer_GetPool(vgl->renderer, count);
+}
+
 int vout_display_opengl_Display(vout_display_opengl_t *vgl)
 {
     GL_ASSERT_NOERROR(&vgl->api.vt);
@@ -229,10 +266,19 @@ int vout_display_opengl_Display(vout_display_opengl_t *vgl)
        OpenGL providers can call vout_display_opengl_Display to force redraw.
        Currently, the OS X provider uses it to get a smooth window resizing */
 
+    bool filtered = vgl->filters && vlc_gl_filters_Begin(vgl->filters);
+
     int ret = vlc_gl_renderer_Draw(vgl->renderer);
     if (ret != VLC_SUCCESS)
         return ret;
 
+    if (filtered)
+    {
+        ret = vlc_gl_filters_Draw(vgl->filters);
+        if (ret != VLC_SUCCESS)
+            return ret;
+    }
+
     ret = vlc_gl_sub_renderer_Draw(vgl->sub_renderer);
     if (ret != VLC_SUCCESS)
         return ret;
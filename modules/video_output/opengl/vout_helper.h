@@ -29,6 +29,8 @@
 #ifndef VLC_OPENGL_VOUT_HELPER_H
 #define VLC_OPENGL_VOUT_HELPER_H
 
+#include <vlc_picture_pool.h>
+
 #include "gl_common.h"
 
 #ifdef HAVE_LIBPLACEBO
@@ -80,8 +82,15 @@
 #define GLINTEROP_LONGTEXT N_( \
     "Force a \"glinterop\" module.")
 
+#define GL_FILTERS_TEXT N_("Open GL/GLES video filters")
+#define GL_FILTERS_LONGTEXT N_( \
+    "Filters applied by the GPU, separated by ':': adjust, sharpen, " \
+    "transform and deinterlace, with the options of the video filters " \
+    "of the same names, e.g. \"adjust{contrast=1.2}:transform{type=90}\".")
+
 #define add_glopts() \
     add_module("glinterop", "glinterop", NULL, GLINTEROP_TEXT, GLINTEROP_LONGTEXT) \
+    add_string("gl-filters", NULL, GL_FILTERS_TEXT, GL_FILTERS_LONGTEXT, true) \
     add_glopts_placebo ()
 
 typedef struct vout_display_opengl_t vout_display_opengl_t;
@@ -103,6 +112,8 @@ void vout_display_opengl_Viewport(vout_display_opengl_t *vgl, int x, int y,
 
 int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
                                 picture_t *picture, subpicture_t *subpicture);
+picture_pool_t *vout_display_opengl_GetPool(vout_display_opengl_t *vgl,
+                                            unsigned count);
 int vout_display_opengl_Display(vout_display_opengl_t *vgl);
 
 #endif
@@ -76,15 +76,27 @@ vlc_module_end()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+#define QUEUE_SIZE 8
+
+/* The samples of the first channel to analyse, and when to show them */
+typedef struct
+{
+    float samples[FFT_BUFFER_SIZE];
+    vlc_tick_t date;
+} spectrum_frame;
+
 typedef struct
 {
     vlc_thread_t thread;
 
-    /* Audio data */
+    /* Audio data, copied from the audio output thread in a cyclic buffer,
+     * whose oldest frames are dropped if the rendering lags */
     unsigned i_channels;
-    block_fifo_t    *fifo;
-    unsigned i_prev_nb_samples;
-    int16_t *p_prev_s16_buff;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    spectrum_frame queue[QUEUE_SIZE];
+    unsigned i_first;
+    unsigned i_count;
 
     /* Opengl */
     vlc_gl_t *gl;
@@ -92,8 +104,9 @@ typedef struct
     float f_rotationAngle;
     float f_rotationIncrement;
 
-    /* FFT window parameters */
-    window_param wind_param;
+    /* FFT */
+    fft_state *p_state;
+    window_context wind_ctx;
 } filter_sys_t;
 
 
@@ -125,19 +138,25 @@ static int Open(vlc_object_t * p_this)
 
     /* Create the object for the thread */
     p_sys->i_channels = aout_FormatNbChannels(&p_filter->fmt_in.audio);
-    p_sys->i_prev_nb_samples = 0;
-    p_sys->p_prev_s16_buff = NULL;
+    vlc_mutex_init(&p_sys->lock);
+    vlc_cond_init(&p_sys->wait);
+    p_sys->i_first = 0;
+    p_sys->i_count = 0;
 
     p_sys->f_rotationAngle = 0;
     p_sys->f_rotationIncrement = ROTATION_INCREMENT;
 
-    /* Fetch the FFT window parameters */
-    window_get_param( VLC_OBJECT( p_filter ), &p_sys->wind_param );
-
-    /* Create the FIFO for the audio data. */
-    p_sys->fifo = block_FifoNew();
-    if (p_sys->fifo == NULL)
+    /* Set up the FFT and its window */
+    window_param wind_param;
+    window_get_param( VLC_OBJECT( p_filter ), &wind_param );
+    p_sys->wind_ctx = (window_context){ NULL, 0 };
+    p_sys->p_state = visual_fft_init();
+    if (p_sys->p_state == NULL
+     || !window_init(FFT_BUFFER_SIZE, &wind_param, &p_sys->wind_ctx))
+    {
+        msg_Err(p_filter, "unable to initialize FFT transform");
         goto error;
+    }
 
     /* Create the openGL provider */
     vout_window_cfg_t cfg = {
@@ -147,15 +166,15 @@ static int Open(vlc_object_t * p_this)
 
     p_sys->gl = vlc_gl_surface_Create(p_this, &cfg, NULL);
     if (p_sys->gl == NULL)
-    {
-        block_FifoRelease(p_sys->fifo);
         goto error;
-    }
 
     /* Create the thread */
     if (vlc_clone(&p_sys->thread, Thread, p_filter,
                   VLC_THREAD_PRIORITY_VIDEO))
+    {
+        vlc_gl_surface_Destroy(p_sys->gl);
         goto error;
+    }
 
     p_filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
@@ -164,6 +183,8 @@ static int Open(vlc_object_t * p_this)
     return VLC_SUCCESS;
 
 error:
+    window_close(&p_sys->wind_ctx);
+    fft_close(p_sys->p_state);
     free(p_sys);
     return VLC_EGENERIC;
 }
@@ -184,8 +205,8 @@ static void Close(vlc_object_t *p_this)
 
     /* Free the ressources */
     vlc_gl_surface_Destroy(p_sys->gl);
-    block_FifoRelease(p_sys->fifo);
-    free(p_sys->p_prev_s16_buff);
+    window_close(&p_sys->wind_ctx);
+    fft_close(p_sys->p_state);
     free(p_sys);
 }
 
@@ -197,10 +218,26 @@ static void Close(vlc_object_t *p_this)
  */
 static block_t *DoWork(filter_t *p_filter, block_t *p_in_buf)
 {
-    block_t *block = block_Duplicate(p_in_buf);
     filter_sys_t *p_sys = p_filter->p_sys;
-    if (likely(block != NULL))
-        block_FifoPut(p_sys->fifo, block);
+
+    if (p_in_buf->i_nb_samples == 0)
+        return p_in_buf;
+
+    vlc_mutex_lock(&p_sys->lock);
+    if (p_sys->i_count == QUEUE_SIZE)
+    {
+        p_sys->i_first = (p_sys->i_first + 1) % QUEUE_SIZE;
+        p_sys->i_count--;
+    }
+
+    spectrum_frame *frame =
+        &p_sys->queue[(p_sys->i_first + p_sys->i_count) % QUEUE_SIZE];
+    fft_copy_channel(frame->samples, (const float *)p_in_buf->p_buffer,
+                     p_in_buf->i_nb_samples, p_sys->i_channels, 0);
+    frame->date = p_in_buf->i_pts + (p_in_buf->i_length / 2);
+    p_sys->i_count++;
+    vlc_cond_signal(&p_sys->wait);
+    vlc_mutex_unlock(&p_sys->lock);
     return p_in_buf;
 }
 
@@ -362,7 +399,21 @@ static void *Thread( void *p_data )
 
     while (1)
     {
-        block_t *block = block_FifoGet(p_sys->fifo);
+        float p_samples[FFT_BUFFER_SIZE];          /* Buffer on which we perform
+                                                      the FFT (first channel) */
+        vlc_tick_t date;
+
+        vlc_mutex_lock(&p_sys->lock);
+        mutex_cleanup_push(&p_sys->lock);
+        while (p_sys->i_count == 0)
+            vlc_cond_wait(&p_sys->wait, &p_sys->lock);
+        memcpy(p_samples, p_sys->queue[p_sys->i_first].samples,
+               sizeof (p_samples));
+        date = p_sys->queue[p_sys->i_first].date;
+        p_sys->i_first = (p_sys->i_first + 1) % QUEUE_SIZE;
+        p_sys->i_count--;
+        vlc_cleanup_pop();
+        vlc_mutex_unlock(&p_sys->lock);
 
         int canc = vlc_savecancel();
         unsigned win_width, win_height;
@@ -375,78 +426,14 @@ static void *Thread( void *p_data )
         const unsigned xscale[] = {0,1,2,3,4,5,6,7,8,11,15,20,27,
                                    36,47,62,82,107,141,184,255};
 
-        fft_state *p_state = NULL; /* internal FFT data */
-        DEFINE_WIND_CONTEXT(wind_ctx); /* internal window data */
-
         unsigned i, j;
-        float p_output[FFT_BUFFER_SIZE];           /* Raw FFT Result  */
-        int16_t p_buffer1[FFT_BUFFER_SIZE];        /* Buffer on which we perform
-                                                      the FFT (first channel) */
-        int16_t p_dest[FFT_BUFFER_SIZE];           /* Adapted FFT result */
-        float *p_buffl = (float*)block->p_buffer;  /* Original buffer */
-
-        int16_t  *p_buffs;                         /* int16_t converted buffer */
-        int16_t  *p_s16_buff;                      /* int16_t converted buffer */
-
-        if (!block->i_nb_samples) {
-            msg_Err(p_filter, "no samples yet");
-            goto release;
-        }
-
-        /* Allocate the buffer only if the number of samples change */
-        if (block->i_nb_samples != p_sys->i_prev_nb_samples)
-        {
-            free(p_sys->p_prev_s16_buff);
-            p_sys->p_prev_s16_buff = malloc(block->i_nb_samples *
-                                            p_sys->i_channels *
-                                            sizeof(int16_t));
-            if (!p_sys->p_prev_s16_buff)
-                goto release;
-            p_sys->i_prev_nb_samples = block->i_nb_samples;
-        }
-        p_buffs = p_s16_buff = p_sys->p_prev_s16_buff;
-
-        /* Convert the buffer to int16_t
-           Pasted from float32tos16.c */
-        for (i = block->i_nb_samples * p_sys->i_channels; i--;)
-        {
-            union {float f; int32_t i;} u;
+        float p_output[FFT_BUFFER_SIZE / 2 + 1];   /* Raw FFT Result  */
+        int16_t p_dest[FFT_BUFFER_SIZE / 2 + 1];   /* Adapted FFT result */
 
-            u.f = *p_buffl + 384.f;
-            if (u.i > 0x43c07fff)
-                *p_buffs = 32767;
-            else if (u.i < 0x43bf8000)
-                *p_buffs = -32768;
-            else
-                *p_buffs = u.i - 0x43c00000;
-
-            p_buffl++; p_buffs++;
-        }
-        p_state = visual_fft_init();
-        if (!p_state)
-        {
-            msg_Err(p_filter,"unable to initialize FFT transform");
-            goto release;
-        }
-        if (!window_init(FFT_BUFFER_SIZE, &p_sys->wind_param, &wind_ctx))
-        {
-            msg_Err(p_filter,"unable to initialize FFT window");
-            goto release;
-        }
-        p_buffs = p_s16_buff;
-        for (i = 0 ; i < FFT_BUFFER_SIZE; i++)
-        {
-            p_output[i] = 0;
-            p_buffer1[i] = *p_buffs;
-
-            p_buffs += p_sys->i_channels;
-            if (p_buffs >= &p_s16_buff[block->i_nb_samples * p_sys->i_channels])
-                p_buffs = p_s16_buff;
-        }
-        window_scale_in_place (p_buffer1, &wind_ctx);
-        fft_perform (p_buffer1, p_output, p_state);
+        window_scale_in_place (p_samples, &p_sys->wind_ctx);
+        fft_perform (p_samples, p_output, p_sys->p_state);
 
-        for (i = 0; i< FFT_BUFFER_SIZE; ++i)
+        for (i = 0; i < FFT_BUFFER_SIZE / 2 + 1; ++i)
             p_dest[i] = p_output[i] *  (2 ^ 16)
                         / ((FFT_BUFFER_SIZE / 2 * 32768) ^ 2);
 
@@ -487,14 +474,10 @@ static void *Thread( void *p_data )
         glPopMatrix();
 
         /* Wait to swapp the frame on time. */
-        vlc_tick_wait(block->i_pts + (block->i_length / 2));
+        vlc_tick_wait(date);
         vlc_gl_Swap(gl);
 
-release:
-        window_close(&wind_ctx);
-        fft_close(p_state);
         vlc_gl_ReleaseCurrent(gl);
-        block_Release(block);
         vlc_restorecancel(canc);
     }
 
@@ -1,8 +1,8 @@
 /*****************************************************************************
- * fft.c: Iterative implementation of a FFT
+ * fft.c: Real-input FFT of the visualizations
  *****************************************************************************
  *
- * Mainly taken from XMMS's code
+ * Originally taken from XMMS's code
  *
  * Authors: Richard Boulton <richard@tartarus.org>
  *          Ralph Loader <suckfish@ihug.co.nz>
@@ -22,27 +22,167 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
-#include <stdlib.h>
-#include "fft.h"
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
 
 #include <math.h>
-#ifndef PI
- #ifdef M_PI
-  #define PI M_PI
- #else
-  #define PI            3.14159265358979323846  /* pi */
- #endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "fft.h"
+
+#ifdef CAN_COMPILE_SSE
+# include <xmmintrin.h>
 #endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef CAN_COMPILE_ARM64
+# include <arm_neon.h>
+#endif
+
+/* The FFT_BUFFER_SIZE real samples are transformed as FFT_HALF complex
+ * numbers, the even samples as real parts and the odd ones as imaginary
+ * parts, then the spectra of the even and odd samples are separated and
+ * combined: this is half the work of a complex transform of the samples. */
+#define FFT_HALF (FFT_BUFFER_SIZE / 2)
+
+/* The stages of exchanges at least that far apart are vectorized */
+#define FFT_VECTOR 4
+
+typedef void (*fft_stage_fn)(float *, float *, const float *, const float *,
+                             unsigned);
 
-/******************************************************************************
- * Local prototypes
+struct _struct_fft_state {
+     /* Temporary data stores to perform FFT in. */
+     float real[FFT_HALF];
+     float imag[FFT_HALF];
+
+     /* exp(-i pi j / half) for the exchanges half apart, from half - 1 */
+     float tw_real[FFT_HALF - 1];
+     float tw_imag[FFT_HALF - 1];
+
+     /* exp(-i pi k / FFT_HALF), to separate the spectra */
+     float sep_cos[FFT_HALF / 2 + 1];
+     float sep_sin[FFT_HALF / 2 + 1];
+
+     unsigned short bitReverse[FFT_HALF];
+
+     fft_stage_fn stage;
+};
+
+/*****************************************************************************
+ * Stages of exchanges
  *****************************************************************************/
-static void fft_prepare(const sound_sample *input, float * re, float * im,
-                        const unsigned int *bitReverse);
-static void fft_calculate(float * re, float * im,
-                          const float *costable, const float *sintable );
-static void fft_output(const float *re, const float *im, float *output);
-static int reverseBits(unsigned int initial);
+static void fft_stage_c(float *re, float *im, const float *wr,
+                        const float *wi, unsigned half)
+{
+    for (unsigned s = 0; s < FFT_HALF; s += 2 * half)
+    {
+        float *ar = &re[s], *ai = &im[s];
+        float *br = &re[s + half], *bi = &im[s + half];
+
+        for (unsigned j = 0; j < half; j++)
+        {
+            const float tr = br[j] * wr[j] - bi[j] * wi[j];
+            const float ti = br[j] * wi[j] + bi[j] * wr[j];
+            br[j] = ar[j] - tr;
+            bi[j] = ai[j] - ti;
+            ar[j] += tr;
+            ai[j] += ti;
+        }
+    }
+}
+
+#ifdef CAN_COMPILE_SSE
+VLC_SSE
+static void fft_stage_sse(float *re, float *im, const float *wr,
+                          const float *wi, unsigned half)
+{
+    for (unsigned s = 0; s < FFT_HALF; s += 2 * half)
+    {
+        float *ar = &re[s], *ai = &im[s];
+        float *br = &re[s + half], *bi = &im[s + half];
+
+        for (unsigned j = 0; j < half; j += 4)
+        {
+            const __m128 c = _mm_loadu_ps(&wr[j]), d = _mm_loadu_ps(&wi[j]);
+            const __m128 xr = _mm_loadu_ps(&br[j]), xi = _mm_loadu_ps(&bi[j]);
+            const __m128 yr = _mm_loadu_ps(&ar[j]), yi = _mm_loadu_ps(&ai[j]);
+            const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, c), _mm_mul_ps(xi, d));
+            const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, d), _mm_mul_ps(xi, c));
+            _mm_storeu_ps(&br[j], _mm_sub_ps(yr, tr));
+            _mm_storeu_ps(&bi[j], _mm_sub_ps(yi, ti));
+            _mm_storeu_ps(&ar[j], _mm_add_ps(yr, tr));
+            _mm_storeu_ps(&ai[j], _mm_add_ps(yi, ti));
+        }
+    }
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+VLC_AVX2
+static void fft_stage_avx2(float *re, float *im, const float *wr,
+                           const float *wi, unsigned half)
+{
+    if (half < 8)
+    {
+        fft_stage_sse(re, im, wr, wi, half);
+        return;
+    }
+
+    for (unsigned s = 0; s < FFT_HALF; s += 2 * half)
+    {
+        float *ar = &re[s], *ai = &im[s];
+        float *br = &re[s + half], *bi = &im[s + half];
+
+        for (unsigned j = 0; j < half; j += 8)
+        {
+            const __m256 c = _mm256_loadu_ps(&wr[j]);
+            const __m256 d = _mm256_loadu_ps(&wi[j]);
+            const __m256 xr = _mm256_loadu_ps(&br[j]);
+            const __m256 xi = _mm256_loadu_ps(&bi[j]);
+            const __m256 yr = _mm256_loadu_ps(&ar[j]);
+            const __m256 yi = _mm256_loadu_ps(&ai[j]);
+            const __m256 tr = _mm256_sub_ps(_mm256_mul_ps(xr, c),
+                                            _mm256_mul_ps(xi, d));
+            const __m256 ti = _mm256_add_ps(_mm256_mul_ps(xr, d),
+                                            _mm256_mul_ps(xi, c));
+            _mm256_storeu_ps(&br[j], _mm256_sub_ps(yr, tr));
+            _mm256_storeu_ps(&bi[j], _mm256_sub_ps(yi, ti));
+            _mm256_storeu_ps(&ar[j], _mm256_add_ps(yr, tr));
+            _mm256_storeu_ps(&ai[j], _mm256_add_ps(yi, ti));
+        }
+    }
+}
+#endif
+
+#ifdef CAN_COMPILE_ARM64
+static void fft_stage_neon(float *re, float *im, const float *wr,
+                           const float *wi, unsigned half)
+{
+    for (unsigned s = 0; s < FFT_HALF; s += 2 * half)
+    {
+        float *ar = &re[s], *ai = &im[s];
+        float *br = &re[s + half], *bi = &im[s + half];
+
+        for (unsigned j = 0; j < half; j += 4)
+        {
+            const float32x4_t c = vld1q_f32(&wr[j]), d = vld1q_f32(&wi[j]);
+            const float32x4_t xr = vld1q_f32(&br[j]), xi = vld1q_f32(&bi[j]);
+            const float32x4_t yr = vld1q_f32(&ar[j]), yi = vld1q_f32(&ai[j]);
+            const float32x4_t tr = vmlsq_f32(vmulq_f32(xr, c), xi, d);
+            const float32x4_t ti = vmlaq_f32(vmulq_f32(xr, d), xi, c);
+            vst1q_f32(&br[j], vsubq_f32(yr, tr));
+            vst1q_f32(&bi[j], vsubq_f32(yi, ti));
+            vst1q_f32(&ar[j], vaddq_f32(yr, tr));
+            vst1q_f32(&ai[j], vaddq_f32(yi, ti));
+        }
+    }
+}
+#endif
 
 /*****************************************************************************
  * These functions are the ones called externally
@@ -56,151 +196,125 @@ static int reverseBits(unsigned int initial);
  */
 fft_state *visual_fft_init(void)
 {
-    fft_state *p_state;
-    unsigned int i;
-
-    p_state = malloc( sizeof(*p_state) );
-    if(! p_state )
+    fft_state *p_state = malloc(sizeof(*p_state));
+    if (!p_state)
         return NULL;
 
-    for(i = 0; i < FFT_BUFFER_SIZE; i++)
+    for (unsigned i = 0; i < FFT_HALF; i++)
     {
-        p_state->bitReverse[i] = reverseBits(i);
+        unsigned r = 0;
+        for (unsigned b = 1; b < FFT_HALF; b <<= 1)
+            r = (r << 1) | ((i & b) != 0);
+        p_state->bitReverse[i] = r;
     }
-    for(i = 0; i < FFT_BUFFER_SIZE / 2; i++)
+    for (unsigned half = 1; half < FFT_HALF; half <<= 1)
+        for (unsigned j = 0; j < half; j++)
+        {
+            p_state->tw_real[half - 1 + j] = cos(M_PI * j / half);
+            p_state->tw_imag[half - 1 + j] = -sin(M_PI * j / half);
+        }
+    for (unsigned k = 0; k <= FFT_HALF / 2; k++)
     {
-        float j = 2 * PI * i / FFT_BUFFER_SIZE;
-        p_state->costable[i] = cos(j);
-        p_state->sintable[i] = sin(j);
+        p_state->sep_cos[k] = cos(M_PI * k / FFT_HALF);
+        p_state->sep_sin[k] = sin(M_PI * k / FFT_HALF);
     }
 
+    p_state->stage = fft_stage_c;
+#ifdef CAN_COMPILE_SSE
+    if (vlc_CPU_SSE())
+        p_state->stage = fft_stage_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        p_state->stage = fft_stage_avx2;
+#endif
+#ifdef CAN_COMPILE_ARM64
+    if (vlc_CPU_ARM_NEON())
+        p_state->stage = fft_stage_neon;
+#endif
     return p_state;
 }
 
 /*
- * Do all the steps of the FFT, taking as input sound data (as described in
- * sound.h) and returning the intensities of each frequency as floats in the
- * range 0 to ((FFT_BUFFER_SIZE / 2) * 32768) ^ 2
+ * Do all the steps of the FFT, taking as input FFT_BUFFER_SIZE samples, in
+ * the range -1 to 1, and returning the intensities of each frequency as
+ * floats in the range 0 to ((FFT_BUFFER_SIZE / 2) * 32768) ^ 2, as for
+ * 16 bits samples.
  *
- * The input array is assumed to have FFT_BUFFER_SIZE elements,
- * and the output array is assumed to have (FFT_BUFFER_SIZE / 2 + 1) elements.
+ * The output array is assumed to have (FFT_BUFFER_SIZE / 2 + 1) elements.
  * state is a (non-NULL) pointer returned by visual_fft_init.
  */
-void fft_perform(const sound_sample *input, float *output, fft_state *state) {
-    /* Convert data from sound format to be ready for FFT */
-    fft_prepare(input, state->real, state->imag, state->bitReverse );
+void fft_perform(const float *input, float *output, fft_state *state)
+{
+    float *re = state->real, *im = state->imag;
 
-    /* Do the actual FFT */
-    fft_calculate(state->real, state->imag, state->costable, state->sintable);
+    /* Get input, in reverse bit order, through the first two stages,
+     * whose factors are 1 and -i */
+    for (unsigned i = 0; i < FFT_HALF; i += 4)
+    {
+        const float *x0 = &input[2 * state->bitReverse[i]];
+        const float *x1 = &input[2 * state->bitReverse[i + 1]];
+        const float *x2 = &input[2 * state->bitReverse[i + 2]];
+        const float *x3 = &input[2 * state->bitReverse[i + 3]];
+        const float r0 = x0[0] + x1[0], i0 = x0[1] + x1[1];
+        const float r1 = x0[0] - x1[0], i1 = x0[1] - x1[1];
+        const float r2 = x2[0] + x3[0], i2 = x2[1] + x3[1];
+        const float r3 = x2[0] - x3[0], i3 = x2[1] - x3[1];
 
-    /* Convert the FFT output into intensities */
-    fft_output(state->real, state->imag, output);
-}
+        re[i] = r0 + r2;     im[i] = i0 + i2;
+        re[i + 2] = r0 - r2; im[i + 2] = i0 - i2;
+        re[i + 1] = r1 + i3; im[i + 1] = i1 - r3;
+        re[i + 3] = r1 - i3; im[i + 3] = i1 + r3;
+    }
 
-/*
- * Free the state.
- */
-void fft_close(fft_state *state) {
-    free( state );
-}
+    for (unsigned half = FFT_VECTOR; half < FFT_HALF; half <<= 1)
+        state->stage(re, im, &state->tw_real[half - 1],
+                     &state->tw_imag[half - 1], half);
 
-/*****************************************************************************
- * These functions are called from the other ones
- *****************************************************************************/
+    /* Separate the spectra and calculate the intensities. The constant and
+     * highest frequency terms are divided to keep them in scale with the
+     * other terms. */
+    const float scale = 32768.f * 32768.f;
+    const float dc = re[0] + im[0], nyquist = re[0] - im[0];
+    output[0] = dc * dc * scale / 4;
+    output[FFT_HALF] = nyquist * nyquist * scale / 4;
 
-/*
- * Prepare data to perform an FFT on
- */
-static void fft_prepare( const sound_sample *input, float * re, float * im,
-                         const unsigned int *bitReverse ) {
-    unsigned int i;
-    float *p_real = re;
-    float *p_imag = im;
-
-    /* Get input, in reverse bit order */
-    for(i = 0; i < FFT_BUFFER_SIZE; i++)
+    for (unsigned k = 1; k <= FFT_HALF / 2; k++)
     {
-        *p_real++ = input[bitReverse[i]];
-        *p_imag++ = 0;
+        const float zr = re[k], zi = im[k];
+        const float yr = re[FFT_HALF - k], yi = im[FFT_HALF - k];
+        /* the transforms of the even and odd samples */
+        const float er = .5f * (zr + yr), ei = .5f * (zi - yi);
+        const float odr = .5f * (zi + yi), odi = -.5f * (zr - yr);
+        /* times exp(-i pi k / FFT_HALF) */
+        const float tr = odr * state->sep_cos[k] + odi * state->sep_sin[k];
+        const float ti = odi * state->sep_cos[k] - odr * state->sep_sin[k];
+
+        output[k] = ((er + tr) * (er + tr) + (ei + ti) * (ei + ti)) * scale;
+        output[FFT_HALF - k] = ((er - tr) * (er - tr)
+                              + (ti - ei) * (ti - ei)) * scale;
     }
 }
 
 /*
- * Take result of an FFT and calculate the intensities of each frequency
- * Note: only produces half as many data points as the input had.
+ * Free the state.
  */
-static void fft_output(const float * re, const float * im, float *output)
-{
-    float *p_output = output;
-    const float *p_real   = re;
-    const float *p_imag   = im;
-    float *p_end    = output + FFT_BUFFER_SIZE / 2;
-
-    while(p_output <= p_end)
-    {
-        *p_output = (*p_real * *p_real) + (*p_imag * *p_imag);
-        p_output++; p_real++; p_imag++;
-    }
-    /* Do divisions to keep the constant and highest frequency terms in scale
-     * with the other terms. */
-    *output /= 4;
-    *p_end /= 4;
+void fft_close(fft_state *state) {
+    free( state );
 }
 
-
 /*
- * Actually perform the FFT
+ * Copy the FFT_BUFFER_SIZE first samples of a channel of interleaved frames,
+ * repeating the frames if there are not enough of them.
  */
-static void fft_calculate(float * re, float * im, const float *costable, const float *sintable )
-{
-    unsigned int i, j, k;
-    unsigned int exchanges;
-    float fact_real, fact_imag;
-    float tmp_real, tmp_imag;
-    unsigned int factfact;
-
-    /* Set up some variables to reduce calculation in the loops */
-    exchanges = 1;
-    factfact = FFT_BUFFER_SIZE / 2;
-
-    /* Loop through the divide and conquer steps */
-    for(i = FFT_BUFFER_SIZE_LOG; i != 0; i--) {
-        /* In this step, we have 2 ^ (i - 1) exchange groups, each with
-         * 2 ^ (FFT_BUFFER_SIZE_LOG - i) exchanges
-         */
-        /* Loop through the exchanges in a group */
-        for(j = 0; j != exchanges; j++) {
-            /* Work out factor for this exchange
-             * factor ^ (exchanges) = -1
-             * So, real = cos(j * PI / exchanges),
-             *     imag = sin(j * PI / exchanges)
-             */
-            fact_real = costable[j * factfact];
-            fact_imag = sintable[j * factfact];
-
-            /* Loop through all the exchange groups */
-            for(k = j; k < FFT_BUFFER_SIZE; k += exchanges << 1) {
-                int k1 = k + exchanges;
-                tmp_real = fact_real * re[k1] - fact_imag * im[k1];
-                tmp_imag = fact_real * im[k1] + fact_imag * re[k1];
-                re[k1] = re[k] - tmp_real;
-                im[k1] = im[k] - tmp_imag;
-                re[k]  += tmp_real;
-                im[k]  += tmp_imag;
-            }
-        }
-        exchanges <<= 1;
-        factfact >>= 1;
-    }
-}
-
-static int reverseBits(unsigned int initial)
+void fft_copy_channel(float *output, const float *input, unsigned frames,
+                      unsigned channels, unsigned channel)
 {
-    unsigned int reversed = 0, loop;
-    for(loop = 0; loop < FFT_BUFFER_SIZE_LOG; loop++) {
-        reversed <<= 1;
-        reversed += (initial & 1);
-        initial >>= 1;
+    input += channel;
+    for (unsigned i = 0, n = 0; i < FFT_BUFFER_SIZE; i++)
+    {
+        output[i] = input[n * channels];
+        if (++n == frames)
+            n = 0;
     }
-    return reversed;
 }
@@ -38,6 +38,8 @@
 
 #include "visual.h"
 
+#include "fft.h"
+#include "window.h"
 #include "window_presets.h"
 
 /*****************************************************************************
@@ -184,6 +186,12 @@ typedef struct
     visual_effect_t **effect;
     int             i_effect;
     vlc_thread_t    thread;
+
+    /* Spectrum shared by the effects */
+    fft_state       *p_fft;
+    window_context  wind_ctx;
+    float           p_fft_input[FFT_BUFFER_SIZE];
+    float           p_spectrum[FFT_BUFFER_SIZE / 2 + 1];
 } filter_sys_t;
 
 /*****************************************************************************
@@ -212,6 +220,8 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_effect = 0;
     p_sys->effect   = NULL;
+    p_sys->p_fft    = NULL;
+    p_sys->wind_ctx = (window_context){ NULL, 0 };
 
     /* Parse the effect list */
     psz_parser = psz_effects = var_CreateGetString( p_filter, "effect-list" );
@@ -231,6 +241,7 @@ static int Open( vlc_object_t *p_this )
 
         p_effect->p_data   = NULL;
         p_effect->pf_run   = NULL;
+        p_effect->p_spectrum = NULL;
 
         for( unsigned i = 0; i < effectc; i++ )
         {
@@ -239,6 +250,8 @@ static int Open( vlc_object_t *p_this )
             {
                 p_effect->pf_run = effectv[i].run_cb;
                 p_effect->pf_free = effectv[i].free_cb;
+                if( effectv[i].spectrum )
+                    p_effect->p_spectrum = p_sys->p_spectrum;
                 psz_parser += strlen( effectv[i].name );
                 break;
             }
@@ -289,6 +302,24 @@ static int Open( vlc_object_t *p_this )
         goto error;
     }
 
+    /* Set up the spectrum if an effect uses it */
+    for( int i = 0; i < p_sys->i_effect; i++ )
+    {
+        if( p_sys->effect[i]->p_spectrum == NULL )
+            continue;
+
+        window_param wind_param;
+        window_get_param( VLC_OBJECT( p_filter ), &wind_param );
+        p_sys->p_fft = visual_fft_init();
+        if( p_sys->p_fft == NULL
+         || !window_init( FFT_BUFFER_SIZE, &wind_param, &p_sys->wind_ctx ) )
+        {
+            msg_Err( p_filter, "unable to initialize FFT transform" );
+            goto error;
+        }
+        break;
+    }
+
     /* Open the video output */
     video_format_t fmt = {
         .i_chroma = VLC_CODEC_I420,
@@ -331,6 +362,8 @@ static int Open( vlc_object_t *p_this )
     return VLC_SUCCESS;
 
 error:
+    window_close( &p_sys->wind_ctx );
+    fft_close( p_sys->p_fft );
     for( int i = 0; i < p_sys->i_effect; i++ )
         free( p_sys->effect[i] );
     free( p_sys->effect );
@@ -355,6 +388,18 @@ static block_t *DoRealWork( filter_t *p_filter, block_t *p_in_buf )
                 p_outpic->p[i].i_visible_lines * p_outpic->p[i].i_pitch );
     }
 
+    /* The spectrum of the left channel, once for all the effects */
+    if( p_sys->p_fft != NULL && p_in_buf->i_nb_samples > 0 )
+    {
+        fft_copy_channel( p_sys->p_fft_input,
+                          (const float *)p_in_buf->p_buffer,
+                          p_in_buf->i_nb_samples,
+                          p_sys->effect[0]->i_nb_chans,
+                          p_sys->effect[0]->i_idx_left );
+        window_scale_in_place( p_sys->p_fft_input, &p_sys->wind_ctx );
+        fft_perform( p_sys->p_fft_input, p_sys->p_spectrum, p_sys->p_fft );
+    }
+
     /* We can now call our visualization effects */
     for( int i = 0; i < p_sys->i_effect; i++ )
     {
@@ -427,5 +472,7 @@ static void Close( vlc_object_t *p_this )
     }
 
     free( p_sys->effect );
+    window_close( &p_sys->wind_ctx );
+    fft_close( p_sys->p_fft );
     free( p_sys );
 }
@@ -37,6 +37,10 @@ struct visual_effect_t
     /* Channels index */
     int        i_idx_left;
     int        i_idx_right;
+
+    /* FFT_BUFFER_SIZE / 2 + 1 intensities of the left channel, computed
+     * once for all the effects of the block, or NULL if none uses them */
+    const float *p_spectrum;
 };
 
 extern const struct visual_cb_t
@@ -44,5 +48,6 @@ extern const struct visual_cb_t
     char name[16];
     visual_run_t run_cb;
     visual_free_t free_cb;
+    bool spectrum; /* the effect uses the spectrum */
 } effectv[];
 extern const unsigned effectc;
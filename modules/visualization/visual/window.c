@@ -199,7 +199,7 @@ exit:
  * Perform an in-place scaling of the input buffer by the window data
  * referenced from the specified context.
  */
-void window_scale_in_place( int16_t * p_buffer, window_context * p_ctx )
+void window_scale_in_place( float * p_buffer, window_context * p_ctx )
 {
     for( int i = 0; i < p_ctx->i_buffer_size; i++ )
     {
@@ -56,7 +56,7 @@ typedef struct _struct_window_param window_param;
 void window_get_param( vlc_object_t * p_aout, window_param * p_param );
 bool window_init( int i_buffer_size, window_param * p_param,
                   window_context * p_ctx );
-void window_scale_in_place( int16_t * p_buffer, window_context * p_ctx );
+void window_scale_in_place( float * p_buffer, window_context * p_ctx );
 void window_close( window_context * p_ctx );
 
 /* Macro for defining a new window context */
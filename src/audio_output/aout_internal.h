@@ -27,6 +27,7 @@
 
 # include <vlc_atomic.h>
 # include <vlc_viewpoint.h>
+# include <vlc_input_item.h>
 # include "../clock/clock.h"
 
 /* Max input rate factor (1/4 -> 4) */
@@ -73,6 +74,10 @@ typedef struct
         vlc_tick_t request_delay;
         vlc_tick_t delay;
         vlc_tick_t first_pts;
+        vlc_tick_t latency; /**< Latency budget, 0 if none */
+        bool over_budget; /**< Output latency over the budget */
+        vlc_tick_t max_advance; /**< Drift thresholds for the resampling */
+        vlc_tick_t max_delay;
     } sync;
     vlc_tick_t original_pts;
 
@@ -96,6 +101,8 @@ typedef struct
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+    atomic_uint play_latency[INPUT_LATENCY_BUCKETS];
+    atomic_uint output_latency[INPUT_LATENCY_BUCKETS];
     atomic_uchar restart;
 
     vlc_atomic_rc_t rc;
@@ -150,7 +157,8 @@ int aout_DecNew(audio_output_t *, const audio_sample_format_t *, int profile,
                 struct vlc_clock_t *clock, const audio_replay_gain_t *);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *aout, block_t *block);
-void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *,
+                           input_latency_t *, input_latency_t *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, vlc_tick_t i_date);
 void aout_DecChangeRate(audio_output_t *aout, float rate);
 void aout_DecChangeDelay(audio_output_t *aout, vlc_tick_t delay);
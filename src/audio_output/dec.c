@@ -127,8 +127,29 @@ error:
     owner->original_pts = VLC_TICK_INVALID;
     owner->sync.delay = owner->sync.request_delay = 0;
 
+    /* With a latency budget, the drift must be corrected before it eats
+     * the budget up */
+    owner->sync.latency = aout_LatencyBudget(p_aout);
+    owner->sync.over_budget = false;
+    owner->sync.max_advance = AOUT_MAX_PTS_ADVANCE;
+    owner->sync.max_delay = AOUT_MAX_PTS_DELAY;
+    if (owner->sync.latency > 0)
+    {
+        const vlc_tick_t max = __MAX(owner->sync.latency / 2,
+                                     AOUT_MIN_LATENCY);
+        owner->sync.max_advance = __MIN(owner->sync.max_advance, max);
+        owner->sync.max_delay = __MIN(owner->sync.max_delay, max);
+        msg_Dbg(p_aout, "latency budget: %"PRId64" ms",
+                MS_FROM_VLC_TICK(owner->sync.latency));
+    }
+
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    for (size_t i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+    {
+        atomic_init (&owner->play_latency[i], 0);
+        atomic_init (&owner->output_latency[i], 0);
+    }
     atomic_store_explicit(&owner->vp.update, true, memory_order_relaxed);
     return 0;
 }
@@ -286,6 +307,20 @@ static void aout_DecSynchronize(audio_output_t *aout, vlc_tick_t system_now,
     if (aout->time_get(aout, &delay) != 0)
         return; /* nothing can be done if timing is unknown */
 
+    /* The delay is the actual latency of the output: the samples written
+     * now are heard after it */
+    atomic_fetch_add_explicit(&owner->output_latency[
+                                  input_latency_GetBucket(delay)], 1,
+                              memory_order_relaxed);
+    if (owner->sync.latency > 0
+     && (delay > owner->sync.latency) != owner->sync.over_budget)
+    {
+        owner->sync.over_budget = !owner->sync.over_budget;
+        if (owner->sync.over_budget)
+            msg_Warn (aout, "output latency over the budget: %"PRId64" ms",
+                      MS_FROM_VLC_TICK(delay));
+    }
+
     if (owner->sync.discontinuity)
     {
         /* Chicken-egg situation for most aout modules that can't be started
@@ -330,7 +365,7 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
      * where supported. The other alternative is to flush the buffers
      * completely. */
     if (drift > (owner->sync.discontinuity ? 0
-                : lroundf(+3 * AOUT_MAX_PTS_DELAY / rate)))
+                : lroundf(+3 * owner->sync.max_delay / rate)))
     {
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too late (%"PRId64"): "
@@ -347,7 +382,7 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
     /* Early audio output.
      * This is rare except at startup when the buffers are still empty. */
     if (drift < (owner->sync.discontinuity ? 0
-                : lroundf(-3 * AOUT_MAX_PTS_ADVANCE / rate)))
+                : lroundf(-3 * owner->sync.max_advance / rate)))
     {
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too early (%"PRId64"): "
@@ -363,7 +398,7 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
         return;
 
     /* Resampling */
-    if (drift > +AOUT_MAX_PTS_DELAY
+    if (drift > +owner->sync.max_delay
      && owner->sync.resamp_type != AOUT_RESAMPLING_UP)
     {
         msg_Warn (aout, "playback too late (%"PRId64"): up-sampling",
@@ -371,7 +406,7 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
         owner->sync.resamp_type = AOUT_RESAMPLING_UP;
         owner->sync.resamp_start_drift = +drift;
     }
-    if (drift < -AOUT_MAX_PTS_ADVANCE
+    if (drift < -owner->sync.max_advance
      && owner->sync.resamp_type != AOUT_RESAMPLING_DOWN)
     {
         msg_Warn (aout, "playback too early (%"PRId64"): down-sampling",
@@ -490,6 +525,9 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
     owner->sync.discontinuity = false;
     aout->play(aout, block, play_date);
 
+    unsigned bucket = input_latency_GetBucket(vlc_tick_now() - system_now);
+    atomic_fetch_add_explicit(&owner->play_latency[bucket], 1,
+                              memory_order_relaxed);
     atomic_fetch_add_explicit(&owner->buffers_played, 1, memory_order_relaxed);
     return ret;
 drop:
@@ -501,7 +539,9 @@ drop:
 }
 
 void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
-                           unsigned *restrict played)
+                           unsigned *restrict played,
+                           input_latency_t *restrict latency,
+                           input_latency_t *restrict output)
 {
     aout_owner_t *owner = aout_owner (aout);
 
@@ -509,6 +549,17 @@ void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
                                      memory_order_relaxed);
     *played = atomic_exchange_explicit(&owner->buffers_played, 0,
                                        memory_order_relaxed);
+
+    /* latencies are only added with played buffers */
+    for (size_t i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+    {
+        latency->buckets[i] = (*played > 0)
+            ? atomic_exchange_explicit(&owner->play_latency[i], 0,
+                                       memory_order_relaxed) : 0;
+        output->buckets[i] =
+            atomic_exchange_explicit(&owner->output_latency[i], 0,
+                                     memory_order_relaxed);
+    }
 }
 
 void aout_DecChangePause (audio_output_t *aout, bool paused, vlc_tick_t date)
@@ -40,6 +40,7 @@ struct aout_volume
     audio_replay_gain_t replay_gain;
     _Atomic float gain_factor;
     float output_factor;
+    float applied_factor; /* NAN if nothing was amplified yet */
     module_t *module;
 };
 
@@ -59,6 +60,7 @@ aout_volume_t *aout_volume_New(vlc_object_t *parent,
         return NULL;
     vol->module = NULL;
     vol->output_factor = 1.f;
+    vol->applied_factor = NAN;
 
     //audio_volume_t *obj = &vol->object;
 
@@ -96,6 +98,8 @@ int aout_volume_SetFormat(aout_volume_t *vol, vlc_fourcc_t format)
     }
 
     obj->format = format;
+    obj->amplify_ramp = NULL;
+    vol->applied_factor = NAN;
     vol->module = module_need(obj, "audio volume", NULL, false);
     if (vol->module == NULL)
         return -1;
@@ -137,7 +141,15 @@ int aout_volume_Amplify(aout_volume_t *vol, block_t *block)
 
     float amp = vol->output_factor * atomic_load(&vol->gain_factor);
 
-    vol->object.amplify(&vol->object, block, amp);
+    /* Ramp the gain changes over the buffer rather than stepping, which
+     * would be heard as clicks, if the module can */
+    if (vol->object.amplify_ramp != NULL && !isnan(vol->applied_factor)
+     && amp != vol->applied_factor)
+        vol->object.amplify_ramp(&vol->object, block, vol->applied_factor,
+                                 amp);
+    else
+        vol->object.amplify(&vol->object, block, amp);
+    vol->applied_factor = amp;
     return 0;
 }
 
@@ -73,6 +73,18 @@
  * new_average = (old_average * c_average + new_sample_value) / (c_average +1)
  */
 
+/*
+ * The average is the historical clock recovery method, selected by
+ * INPUT_CLOCK_RECOVERY_AVERAGE. It lags behind a constant clock drift and
+ * lets the network jitter through, as it takes one sample per update.
+ *
+ * INPUT_CLOCK_RECOVERY_PI keeps the smallest drift sample seen during each
+ * update period, as the network jitter only ever delays the packets, and
+ * feeds it to a second order loop (a PI controller tracking both the offset
+ * and its slope). It follows a constant drift without any static error and
+ * its bandwidth is derived from i_cr_average like the average one.
+ */
+
 
 /*****************************************************************************
  * Constants
@@ -98,6 +110,9 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET VLC_TICK_FROM_MS(100)
 
+/* Period of the clock drift updates */
+#define CR_DRIFT_PERIOD VLC_TICK_FROM_MS(200)
+
 /* */
 #define INPUT_CLOCK_LATE_COUNT (3)
 
@@ -119,7 +134,26 @@ struct input_clock_t
 
     /* Clock drift */
     vlc_tick_t i_next_drift_update;
-    average_t drift;
+    struct
+    {
+        enum input_clock_recovery mode;
+
+        /* Sample for the next update: the last one, or the smallest one
+         * for INPUT_CLOCK_RECOVERY_PI */
+        vlc_tick_t i_sample;
+        bool       b_has_sample;
+
+        /* INPUT_CLOCK_RECOVERY_AVERAGE */
+        average_t  average;
+
+        /* INPUT_CLOCK_RECOVERY_PI */
+        bool       b_locked;
+        vlc_tick_t i_last_update;
+        double     offset;
+        double     slope; /* per system tick */
+        double     kp;
+        double     ki;
+    } drift;
 
     /* Late statistics */
     struct
@@ -148,10 +182,17 @@ static vlc_tick_t ClockSystemToStream( input_clock_t *, vlc_tick_t i_system );
 
 static vlc_tick_t ClockGetTsOffset( input_clock_t * );
 
+static void DriftInit( input_clock_t *, enum input_clock_recovery, int i_range );
+static void DriftReset( input_clock_t * );
+static void DriftRescale( input_clock_t *, int i_range );
+static void DriftSample( input_clock_t *, vlc_tick_t i_drift );
+static void DriftUpdate( input_clock_t *, vlc_tick_t i_system );
+static vlc_tick_t DriftGet( input_clock_t * );
+
 /*****************************************************************************
  * input_clock_New: create a new clock
  *****************************************************************************/
-input_clock_t *input_clock_New( float rate )
+input_clock_t *input_clock_New( float rate, enum input_clock_recovery recovery )
 {
     input_clock_t *cl = malloc( sizeof(*cl) );
     if( !cl )
@@ -169,7 +210,7 @@ input_clock_t *input_clock_New( float rate )
     cl->i_buffering_duration = 0;
 
     cl->i_next_drift_update = VLC_TICK_INVALID;
-    AvgInit( &cl->drift, 10 );
+    DriftInit( cl, recovery, 10 );
 
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
@@ -188,7 +229,7 @@ input_clock_t *input_clock_New( float rate )
  *****************************************************************************/
 void input_clock_Delete( input_clock_t *cl )
 {
-    AvgClean( &cl->drift );
+    AvgClean( &cl->drift.average );
     free( cl );
 }
 
@@ -232,7 +273,7 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     if( b_reset_reference )
     {
         cl->i_next_drift_update = VLC_TICK_INVALID;
-        AvgReset( &cl->drift );
+        DriftReset( cl );
 
         /* Feed synchro with a new reference point. */
         cl->b_has_reference = true;
@@ -243,13 +284,18 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
 
     /* Compute the drift between the stream clock and the system clock
      * when we don't control the source pace */
-    if( !b_can_pace_control && cl->i_next_drift_update < i_ck_system )
+    if( !b_can_pace_control )
     {
         const vlc_tick_t i_converted = ClockSystemToStream( cl, i_ck_system );
 
-        AvgUpdate( &cl->drift, i_converted - i_ck_stream );
+        DriftSample( cl, i_converted - i_ck_stream );
 
-        cl->i_next_drift_update = i_ck_system + VLC_TICK_FROM_MS(200); /* FIXME why that */
+        if( cl->i_next_drift_update < i_ck_system )
+        {
+            DriftUpdate( cl, i_ck_system );
+
+            cl->i_next_drift_update = i_ck_system + CR_DRIFT_PERIOD; /* FIXME why that */
+        }
     }
 
     /* Update the extra buffering value */
@@ -275,7 +321,7 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
 
     /* It does not take the decoder latency into account but it is not really
      * the goal of the clock here */
-    const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
+    const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + DriftGet( cl ) );
     const vlc_tick_t i_late = ( i_ck_system - cl->i_pts_delay ) - i_system_expected;
     if( i_late > 0 )
     {
@@ -337,6 +383,8 @@ void input_clock_ChangePause( input_clock_t *cl, bool b_paused, vlc_tick_t i_dat
         {
             cl->ref.system += i_duration;
             cl->last.system += i_duration;
+            if( cl->drift.b_locked )
+                cl->drift.i_last_update += i_duration;
         }
     }
     cl->i_pause_date = i_date;
@@ -356,7 +404,7 @@ vlc_tick_t input_clock_GetWakeup( input_clock_t *cl )
 
     /* Synchronized, we can wait */
     if( cl->b_has_reference )
-        i_wakeup = ClockStreamToSystem( cl, cl->last.stream + AvgGet( &cl->drift ) - cl->i_buffering_duration );
+        i_wakeup = ClockStreamToSystem( cl, cl->last.stream + DriftGet( cl ) - cl->i_buffering_duration );
 
     vlc_mutex_unlock( &cl->lock );
 
@@ -394,7 +442,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
     /* */
     if( *pi_ts0 != VLC_TICK_INVALID )
     {
-        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + AvgGet( &cl->drift ) );
+        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + DriftGet( cl ) );
         if( *pi_ts0 > cl->i_ts_max )
             cl->i_ts_max = *pi_ts0;
         *pi_ts0 += i_ts_delay;
@@ -403,7 +451,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
     /* XXX we do not update i_ts_max on purpose */
     if( pi_ts1 && *pi_ts1 != VLC_TICK_INVALID )
     {
-        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + AvgGet( &cl->drift ) ) +
+        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + DriftGet( cl ) ) +
                   i_ts_delay;
     }
 
@@ -530,8 +578,7 @@ void input_clock_SetJitter( input_clock_t *cl,
     if( i_cr_average < 10 )
         i_cr_average = 10;
 
-    if( cl->drift.range != i_cr_average )
-        AvgRescale( &cl->drift, i_cr_average );
+    DriftRescale( cl, i_cr_average );
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -589,3 +636,92 @@ static vlc_tick_t ClockGetTsOffset( input_clock_t *cl )
     return cl->i_pts_delay * ( 1.0f / cl->rate - 1.0f );
 }
 
+
+/*****************************************************************************
+ * Drift*: clock recovery
+ *****************************************************************************/
+static void DriftInit( input_clock_t *cl, enum input_clock_recovery mode,
+                       int i_range )
+{
+    cl->drift.mode = mode;
+    AvgInit( &cl->drift.average, i_range );
+    DriftRescale( cl, i_range );
+    DriftReset( cl );
+}
+
+static void DriftReset( input_clock_t *cl )
+{
+    cl->drift.b_has_sample = false;
+    AvgReset( &cl->drift.average );
+    cl->drift.b_locked = false;
+    cl->drift.i_last_update = VLC_TICK_INVALID;
+    cl->drift.offset = 0.;
+    cl->drift.slope = 0.;
+}
+
+static void DriftRescale( input_clock_t *cl, int i_range )
+{
+    if( cl->drift.average.range != i_range )
+        AvgRescale( &cl->drift.average, i_range );
+
+    /* Critically damped loop, with a time constant close to the one of an
+     * average over i_range samples */
+    cl->drift.kp = 2. / (i_range + 1);
+    cl->drift.ki = cl->drift.kp * cl->drift.kp / 4.;
+}
+
+static void DriftSample( input_clock_t *cl, vlc_tick_t i_drift )
+{
+    if( cl->drift.mode == INPUT_CLOCK_RECOVERY_PI &&
+        cl->drift.b_has_sample && cl->drift.i_sample < i_drift )
+        return;
+
+    cl->drift.i_sample = i_drift;
+    cl->drift.b_has_sample = true;
+}
+
+static void DriftUpdate( input_clock_t *cl, vlc_tick_t i_system )
+{
+    assert( cl->drift.b_has_sample );
+    const double sample = cl->drift.i_sample;
+    cl->drift.b_has_sample = false;
+
+    switch( cl->drift.mode )
+    {
+        case INPUT_CLOCK_RECOVERY_PI:
+            if( !cl->drift.b_locked )
+            {
+                cl->drift.b_locked = true;
+                cl->drift.offset = sample;
+                cl->drift.slope = 0.;
+            }
+            else
+            {
+                const vlc_tick_t i_elapsed = i_system - cl->drift.i_last_update;
+                const double predicted = cl->drift.offset +
+                                         cl->drift.slope * i_elapsed;
+                const double error = sample - predicted;
+
+                cl->drift.offset = predicted + cl->drift.kp * error;
+                cl->drift.slope += cl->drift.ki * error / CR_DRIFT_PERIOD;
+            }
+            cl->drift.i_last_update = i_system;
+            break;
+        case INPUT_CLOCK_RECOVERY_AVERAGE:
+        default:
+            AvgUpdate( &cl->drift.average, sample );
+            break;
+    }
+}
+
+static vlc_tick_t DriftGet( input_clock_t *cl )
+{
+    switch( cl->drift.mode )
+    {
+        case INPUT_CLOCK_RECOVERY_PI:
+            return cl->drift.offset;
+        case INPUT_CLOCK_RECOVERY_AVERAGE:
+        default:
+            return AvgGet( &cl->drift.average );
+    }
+}
@@ -27,6 +27,16 @@
 #include <vlc_common.h>
 #include <vlc_input.h> /* FIXME Needed for input_clock_t */
 
+/**
+ * Clock recovery methods, see input_clock.c
+ */
+enum input_clock_recovery
+{
+    INPUT_CLOCK_RECOVERY_AVERAGE = 0,
+    INPUT_CLOCK_RECOVERY_PI,
+    INPUT_CLOCK_RECOVERY_DEFAULT = INPUT_CLOCK_RECOVERY_AVERAGE,
+};
+
 /** @struct input_clock_t
  * This structure is used to manage clock drift and reception jitters
  *
@@ -39,7 +49,7 @@ typedef struct input_clock_t input_clock_t;
  * This function creates a new input_clock_t.
  * You must use input_clock_Delete to delete it once unused.
  */
-input_clock_t *input_clock_New( float rate );
+input_clock_t *input_clock_New( float rate, enum input_clock_recovery );
 
 /**
  * This function destroys a input_clock_t created by input_clock_New.
@@ -0,0 +1,308 @@
+/*****************************************************************************
+ * clock/test.c: input clock recovery replay test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Replays PCR traces against the input clock recovery methods, and reports
+ * per method the convergence time and the jitter of the recovered clock.
+ *
+ * Usage: test_input_clock [trace...]
+ * A trace file contains one "<pcr_us> <arrival_us>" pair per line, as
+ * recorded from the stream clock references and their reception date.
+ * Without arguments, a few synthetic traces are used.
+ *
+ * The recovered clock is compared with a line fitted over the second half of
+ * the replay: the convergence time is the date after which it stays within
+ * CONVERGED_ERROR of it, and the jitter is the RMS error after that date.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include "input_clock.h"
+
+const char vlc_module_name[] = "test_input_clock";
+
+#define PTS_DELAY        VLC_TICK_FROM_MS(300)
+#define CR_AVERAGE       40
+#define CONVERGED_ERROR  VLC_TICK_FROM_MS(1)
+
+#define SYNTHETIC_DURATION  VLC_TICK_FROM_SEC(180)
+#define SYNTHETIC_PCR_GAP   VLC_TICK_FROM_MS(40)
+
+struct trace
+{
+    const char *name;
+    vlc_tick_t *pcr;
+    vlc_tick_t *arrival;
+    size_t count;
+    size_t size;
+};
+
+struct result
+{
+    bool converged;
+    vlc_tick_t convergence;
+    double jitter;
+    double peak;
+};
+
+static const struct
+{
+    enum input_clock_recovery recovery;
+    const char *name;
+} methods[] = {
+    { INPUT_CLOCK_RECOVERY_AVERAGE, "average" },
+    { INPUT_CLOCK_RECOVERY_PI, "pi" },
+};
+
+static void trace_Init(struct trace *trace, const char *name)
+{
+    trace->name = name;
+    trace->pcr = NULL;
+    trace->arrival = NULL;
+    trace->count = 0;
+    trace->size = 0;
+}
+
+static void trace_Clean(struct trace *trace)
+{
+    free(trace->pcr);
+    free(trace->arrival);
+}
+
+static bool trace_Add(struct trace *trace, vlc_tick_t pcr, vlc_tick_t arrival)
+{
+    if (trace->count == trace->size)
+    {
+        size_t size = trace->size ? trace->size * 2 : 1024;
+        vlc_tick_t *p = realloc(trace->pcr, size * sizeof(*p));
+        if (!p)
+            return false;
+        trace->pcr = p;
+        p = realloc(trace->arrival, size * sizeof(*p));
+        if (!p)
+            return false;
+        trace->arrival = p;
+        trace->size = size;
+    }
+    trace->pcr[trace->count] = pcr;
+    trace->arrival[trace->count] = arrival;
+    trace->count++;
+    return true;
+}
+
+static bool trace_Load(struct trace *trace, const char *path)
+{
+    FILE *fp = vlc_fopen(path, "r");
+    if (!fp)
+        return false;
+
+    long long pcr, arrival;
+    bool ok = true;
+    while (ok && fscanf(fp, "%lld %lld", &pcr, &arrival) == 2)
+        ok = trace_Add(trace, VLC_TICK_0 + pcr, VLC_TICK_0 + arrival);
+    fclose(fp);
+    return ok && trace->count > 1;
+}
+
+/* Deterministic generator, so that the synthetic results are reproducible */
+static double trace_Random(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return ((*seed >> 8) + .5) / (1 << 24);
+}
+
+/**
+ * Generates a sender running ppm away from the receiver clock, received
+ * with a base delay and an exponentially distributed jitter of the given
+ * mean, and with a congestion delaying every packet by burst during 1s at 60s.
+ */
+static bool trace_Generate(struct trace *trace, const char *name, double ppm,
+                           vlc_tick_t jitter, vlc_tick_t burst)
+{
+    uint32_t seed = 42;
+
+    trace_Init(trace, name);
+    for (vlc_tick_t pcr = 0; pcr < SYNTHETIC_DURATION; pcr += SYNTHETIC_PCR_GAP)
+    {
+        vlc_tick_t arrival = pcr + pcr * ppm / 1000000. + VLC_TICK_FROM_MS(10);
+        if (jitter > 0)
+            arrival -= jitter * log(trace_Random(&seed));
+        if (pcr >= VLC_TICK_FROM_SEC(60) && pcr < VLC_TICK_FROM_SEC(61))
+            arrival += burst;
+        if (!trace_Add(trace, VLC_TICK_0 + pcr, VLC_TICK_0 + arrival))
+            return false;
+    }
+    return true;
+}
+
+static bool Replay(const struct trace *trace, enum input_clock_recovery recovery,
+                   struct result *result)
+{
+    input_clock_t *clock = input_clock_New(1.f, recovery);
+    if (!clock)
+        return false;
+    input_clock_SetJitter(clock, PTS_DELAY, CR_AVERAGE);
+
+    vlc_tick_t *recovered = vlc_alloc(trace->count, sizeof(*recovered));
+    if (!recovered)
+    {
+        input_clock_Delete(clock);
+        return false;
+    }
+
+    for (size_t i = 0; i < trace->count; i++)
+    {
+        input_clock_Update(clock, NULL, false, false,
+                           trace->pcr[i], trace->arrival[i]);
+
+        recovered[i] = trace->pcr[i];
+        int ret = input_clock_ConvertTS(NULL, clock, NULL, &recovered[i],
+                                        NULL, INT64_MAX);
+        assert(ret == VLC_SUCCESS);
+    }
+    input_clock_Delete(clock);
+
+    /* Fit recovered = a * pcr + b over the second half, relatively to the
+     * first point of that half to keep the sums precise */
+    const size_t start = trace->count / 2;
+    const double pcr0 = trace->pcr[start];
+    const double rec0 = recovered[start];
+    double sx = 0., sy = 0., sxx = 0., sxy = 0.;
+    for (size_t i = start; i < trace->count; i++)
+    {
+        const double x = trace->pcr[i] - pcr0;
+        const double y = recovered[i] - rec0;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    const double n = trace->count - start;
+    const double a = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    const double b = (sy - a * sx) / n;
+
+    size_t converged = trace->count;
+    for (size_t i = trace->count; i > 0; i--)
+    {
+        const double error = recovered[i - 1] - rec0
+                           - (a * (trace->pcr[i - 1] - pcr0) + b);
+        if (fabs(error) >= CONVERGED_ERROR)
+            break;
+        converged = i - 1;
+    }
+
+    double sum = 0., peak = 0.;
+    const size_t from = converged < trace->count ? converged : start;
+    for (size_t i = from; i < trace->count; i++)
+    {
+        const double error = recovered[i] - rec0
+                           - (a * (trace->pcr[i] - pcr0) + b);
+        sum += error * error;
+        if (fabs(error) > peak)
+            peak = fabs(error);
+    }
+    free(recovered);
+
+    result->converged = converged < trace->count;
+    if (result->converged)
+        result->convergence = trace->arrival[converged] - trace->arrival[0];
+    result->jitter = sqrt(sum / (trace->count - from));
+    result->peak = peak;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    struct trace synthetic[3];
+    struct trace *traces;
+    size_t count;
+
+    if (argc > 1)
+    {
+        count = argc - 1;
+        traces = vlc_alloc(count, sizeof(*traces));
+        assert(traces);
+        for (size_t i = 0; i < count; i++)
+        {
+            trace_Init(&traces[i], argv[i + 1]);
+            if (!trace_Load(&traces[i], argv[i + 1]))
+            {
+                fprintf(stderr, "can't load trace %s\n", argv[i + 1]);
+                return 1;
+            }
+        }
+    }
+    else
+    {
+        traces = synthetic;
+        count = ARRAY_SIZE(synthetic);
+        bool ok = trace_Generate(&traces[0], "clean +50ppm", 50., 0, 0);
+        ok = ok && trace_Generate(&traces[1], "iptv multicast +30ppm", 30.,
+                                  VLC_TICK_FROM_MS(2), 0);
+        ok = ok && trace_Generate(&traces[2], "bursty -80ppm", -80.,
+                                  VLC_TICK_FROM_MS(5), VLC_TICK_FROM_MS(40));
+        assert(ok);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        struct result results[ARRAY_SIZE(methods)];
+
+        printf("trace: %s\n", traces[i].name);
+        printf("  %-10s %12s %12s %12s\n", "method", "convergence",
+               "jitter", "peak");
+        for (size_t j = 0; j < ARRAY_SIZE(methods); j++)
+        {
+            bool ok = Replay(&traces[i], methods[j].recovery, &results[j]);
+            assert(ok);
+
+            if (results[j].converged)
+                printf("  %-10s %11.2fs", methods[j].name,
+                       secf_from_vlc_tick(results[j].convergence));
+            else
+                printf("  %-10s %12s", methods[j].name, "never");
+            printf(" %10.3fms %10.3fms\n", results[j].jitter / 1000.,
+                   results[j].peak / 1000.);
+        }
+
+        if (traces == synthetic)
+        {
+            /* The controller must converge, and reject the jitter at least
+             * as well as the average */
+            assert(results[1].converged);
+            assert(results[1].jitter <= results[0].jitter);
+        }
+        trace_Clean(&traces[i]);
+    }
+
+    if (traces != synthetic)
+        free(traces);
+    return 0;
+}
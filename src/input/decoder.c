@@ -62,6 +62,18 @@ enum reload
     RELOAD_DECODER_AOUT /* Stop the aout and reload the decoder module */
 };
 
+/* Output of the packetizer thread, in decoding order */
+struct decoder_packetized
+{
+    struct decoder_packetized *p_next;
+    block_t *p_blocks;
+    es_format_t *p_fmt; /* new packetizer output format, if it changed */
+    bool b_drain; /* the packetizer is drained */
+};
+
+/* Input blocks, and outputs, queued at most by the packetizer thread */
+#define DECODER_PACKETIZER_QUEUE 8
+
 struct vlc_input_decoder_t
 {
     decoder_t        dec;
@@ -83,6 +95,25 @@ struct vlc_input_decoder_t
     decoder_t *p_packetizer;
     bool b_packetizer;
 
+    /* Packetizer running in its own thread, ahead of the decoder module.
+     * The queues and states are protected by the fifo lock. */
+    struct
+    {
+        bool b_threaded;
+        vlc_thread_t thread;
+        vlc_cond_t wait;
+        block_t *p_in;
+        block_t **pp_in_last;
+        unsigned i_in;
+        struct decoder_packetized *p_out;
+        struct decoder_packetized **pp_out_last;
+        unsigned i_out;
+        bool b_drain; /* requested to the packetizer thread */
+        bool b_drain_sent; /* until the drain comes out of it */
+        bool b_busy;
+        bool b_abort;
+    } pkt;
+
     /* Current format in use by the output */
     es_format_t    fmt;
     vlc_video_context *vctx;
@@ -129,6 +160,7 @@ struct vlc_input_decoder_t
     vout_thread_t   *p_vout;
     enum vlc_vout_order vout_order;
     bool            vout_thread_started;
+    vlc_tick_t      first_picture_start; /* until the first picture is sent */
 
     /* -- Theses variables need locking on read *and* write -- */
     /* Preroll */
@@ -406,6 +438,62 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
 
 static int CreateVoutIfNeeded(vlc_input_decoder_t *, vout_thread_t **, enum vlc_vout_order *, vlc_decoder_device **);
 
+static int ModuleThread_CreatePool( decoder_t *p_dec, vout_thread_t *p_vout,
+                                    vlc_video_context *vctx )
+{
+    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
+
+    if ( p_owner->out_pool != NULL )
+        return 0;
+
+    unsigned dpb_size;
+    switch( p_dec->fmt_in.i_codec )
+    {
+    case VLC_CODEC_HEVC:
+    case VLC_CODEC_H264:
+    case VLC_CODEC_DIRAC: /* FIXME valid ? */
+        dpb_size = 18;
+        break;
+    case VLC_CODEC_AV1:
+        dpb_size = 10;
+        break;
+    case VLC_CODEC_MP4V:
+    case VLC_CODEC_VP5:
+    case VLC_CODEC_VP6:
+    case VLC_CODEC_VP6F:
+    case VLC_CODEC_VP8:
+        dpb_size = 3;
+        break;
+    default:
+        dpb_size = 2;
+        break;
+    }
+    const unsigned count = dpb_size + p_dec->i_extra_picture_buffers + 1;
+
+    /* Render into the display buffers if it provides them, to avoid copying
+     * the pictures to upload them */
+    picture_pool_t *pool = NULL;
+    if ( vctx == NULL )
+        pool = vout_GetDecoderPool( p_vout, &p_dec->fmt_out.video, count );
+
+    if ( pool != NULL )
+        msg_Dbg( p_dec, "rendering into %u display pictures", count );
+    else
+    {
+        pool = picture_pool_NewFromFormat( &p_dec->fmt_out.video, count );
+        if ( pool == NULL )
+        {
+            msg_Err(p_dec, "Failed to create a pool of %u %4.4s pictures",
+                           count, (char*)&p_dec->fmt_out.video.i_chroma);
+            return -1;
+        }
+    }
+
+    vlc_mutex_lock( &p_owner->lock );
+    p_owner->out_pool = pool;
+    vlc_mutex_unlock( &p_owner->lock );
+    return 0;
+}
 
 static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *vctx )
 {
@@ -428,48 +516,13 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
 
     // configure the new vout
 
-    if ( p_owner->out_pool == NULL )
-    {
-        unsigned dpb_size;
-        switch( p_dec->fmt_in.i_codec )
-        {
-        case VLC_CODEC_HEVC:
-        case VLC_CODEC_H264:
-        case VLC_CODEC_DIRAC: /* FIXME valid ? */
-            dpb_size = 18;
-            break;
-        case VLC_CODEC_AV1:
-            dpb_size = 10;
-            break;
-        case VLC_CODEC_MP4V:
-        case VLC_CODEC_VP5:
-        case VLC_CODEC_VP6:
-        case VLC_CODEC_VP6F:
-        case VLC_CODEC_VP8:
-            dpb_size = 3;
-            break;
-        default:
-            dpb_size = 2;
-            break;
-        }
-
-        p_owner->out_pool = picture_pool_NewFromFormat( &p_dec->fmt_out.video,
-                            dpb_size + p_dec->i_extra_picture_buffers + 1 );
-        if (p_owner->out_pool == NULL)
-        {
-            msg_Err(p_dec, "Failed to create a pool of %d %4.4s pictures",
-                           dpb_size + p_dec->i_extra_picture_buffers + 1,
-                           (char*)&p_dec->fmt_out.video.i_chroma);
-            return -1;
-        }
-    }
     int res;
     if (p_owner->vout_thread_started)
     {
         res = vout_ChangeSource(p_vout, &p_dec->fmt_out.video);
         if (res == 0)
             // the display/thread is started and can handle the new source format
-            return 0;
+            return ModuleThread_CreatePool( p_dec, p_vout, vctx );
     }
 
     vout_configuration_t cfg = {
@@ -481,6 +534,7 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
     {
         p_owner->vout_thread_started = true;
         decoder_Notify(p_owner, on_vout_started, p_vout, vout_order);
+        res = ModuleThread_CreatePool( p_dec, p_vout, vctx );
     }
     return res;
 }
@@ -1049,6 +1103,16 @@ static void ModuleThread_QueueCc( decoder_t *p_videodec, block_t *p_cc,
     }
 }
 
+static void DecoderNotifyLatency( vlc_input_decoder_t *p_owner,
+                                  enum input_latency_stage stage,
+                                  vlc_tick_t duration )
+{
+    input_latency_t latency = { { 0 } };
+
+    latency.buckets[input_latency_GetBucket( duration )] = 1;
+    decoder_Notify(p_owner, on_new_latency, stage, &latency);
+}
+
 static int ModuleThread_PlayVideo( vlc_input_decoder_t *p_owner, picture_t *p_picture )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1118,6 +1182,26 @@ static int ModuleThread_PlayVideo( vlc_input_decoder_t *p_owner, picture_t *p_pi
         /* Ensure no earlier higher pts breaks still state */
         vout_Flush( p_vout, p_picture->date );
     }
+
+    if( unlikely(p_owner->first_picture_start != VLC_TICK_INVALID) )
+    {
+        msg_Dbg( p_dec, "first picture sent to the vout %"PRId64" ms after "
+                 "the decoder creation",
+                 MS_FROM_VLC_TICK(vlc_tick_now() - p_owner->first_picture_start) );
+        p_owner->first_picture_start = VLC_TICK_INVALID;
+    }
+
+    if( p_owner->p_clock != NULL )
+    {
+        vlc_tick_t now = vlc_tick_now();
+        vlc_tick_t display_date =
+            ModuleThread_GetDisplayDate( p_dec, now, p_picture->date );
+
+        /* late pictures are counted in the first bucket */
+        if( display_date != VLC_TICK_INVALID && display_date != INT64_MAX )
+            DecoderNotifyLatency( p_owner, INPUT_LATENCY_VIDEO_QUEUE,
+                                  display_date - now );
+    }
     vout_PutPicture( p_vout, p_picture );
 
     return VLC_SUCCESS;
@@ -1128,13 +1212,28 @@ static void ModuleThread_UpdateStatVideo( vlc_input_decoder_t *p_owner,
 {
     unsigned displayed = 0;
     unsigned vout_lost = 0;
+    input_latency_t latency[VOUT_STATISTIC_LATENCIES];
     if( p_owner->p_vout != NULL )
     {
-        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost );
+        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost,
+                                latency );
     }
     if (lost) vout_lost++;
 
     decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed);
+    if( displayed > 0 )
+    {
+        static const enum input_latency_stage stages[] = {
+            [VOUT_STATISTIC_DISPLAY] = INPUT_LATENCY_VIDEO_DISPLAY,
+            [VOUT_STATISTIC_PREPARE] = INPUT_LATENCY_VIDEO_PREPARE,
+            [VOUT_STATISTIC_PRESENT] = INPUT_LATENCY_VIDEO_PRESENT,
+            [VOUT_STATISTIC_PRESENT_ERROR] = INPUT_LATENCY_VIDEO_PRESENT_ERROR,
+        };
+        static_assert(ARRAY_SIZE(stages) == VOUT_STATISTIC_LATENCIES,
+                      "missing vout latency stage");
+        for( size_t i = 0; i < VOUT_STATISTIC_LATENCIES; i++ )
+            decoder_Notify(p_owner, on_new_latency, stages[i], &latency[i]);
+    }
 }
 
 static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
@@ -1159,6 +1258,15 @@ static vlc_decoder_device * thumbnailer_get_device( decoder_t *p_dec )
 static picture_t *thumbnailer_buffer_new( decoder_t *p_dec )
 {
     vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
+
+    /* Do not take a thumbnail from the previous position, when seeking to
+     * the next thumbnail of a batch */
+    vlc_fifo_Lock( p_owner->p_fifo );
+    bool flushing = p_owner->flushing;
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    if( flushing )
+        return NULL;
+
     /* Avoid decoding more than one frame when a thumbnail was
      * already generated */
     vlc_mutex_lock( &p_owner->lock );
@@ -1263,13 +1371,22 @@ static void ModuleThread_UpdateStatAudio( vlc_input_decoder_t *p_owner,
 {
     unsigned played = 0;
     unsigned aout_lost = 0;
+    input_latency_t latency, output = { { 0 } };
     if( p_owner->p_aout != NULL )
     {
-        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played,
+                               &latency, &output );
     }
     if (lost) aout_lost++;
 
     decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played);
+    if( played > 0 )
+    {
+        decoder_Notify(p_owner, on_new_latency, INPUT_LATENCY_AUDIO_PLAY,
+                       &latency);
+        decoder_Notify(p_owner, on_new_latency, INPUT_LATENCY_AUDIO_OUTPUT,
+                       &output);
+    }
 }
 
 static void ModuleThread_QueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
@@ -1344,7 +1461,15 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, block_t *p_
 {
     decoder_t *p_dec = &p_owner->dec;
 
+    vlc_tick_t start = vlc_tick_now();
     int ret = p_dec->pf_decode( p_dec, p_block );
+    if( p_block != NULL && p_dec->fmt_in.i_cat == VIDEO_ES )
+        DecoderNotifyLatency( p_owner, INPUT_LATENCY_VIDEO_DECODE,
+                              vlc_tick_now() - start );
+    else if( p_block != NULL && p_dec->fmt_in.i_cat == AUDIO_ES )
+        DecoderNotifyLatency( p_owner, INPUT_LATENCY_AUDIO_DECODE,
+                              vlc_tick_now() - start );
+
     switch( ret )
     {
         case VLCDEC_SUCCESS:
@@ -1375,13 +1500,10 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, block_t *p_
  * \param p_dec the decoder object
  * \param p_block the block to decode
  */
-static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, block_t *p_block )
+static int DecoderThread_CheckReload( vlc_input_decoder_t *p_owner )
 {
     decoder_t *p_dec = &p_owner->dec;
 
-    if( p_owner->error )
-        goto error;
-
     /* Here, the atomic doesn't prevent to miss a reload request.
      * DecoderThread_ProcessInput() can still be called after the decoder module or the
      * audio output requested a reload. This will only result in a drop of an
@@ -1392,9 +1514,53 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, block_t *p
         msg_Warn( p_dec, "Reloading the decoder module%s",
                   reload == RELOAD_DECODER_AOUT ? " and the audio output" : "" );
 
-        if( DecoderThread_Reload( p_owner, &p_dec->fmt_in, reload ) != VLC_SUCCESS )
-            goto error;
+        return DecoderThread_Reload( p_owner, &p_dec->fmt_in, reload );
     }
+    return VLC_SUCCESS;
+}
+
+static int DecoderThread_UpdatePacketizedFormat( vlc_input_decoder_t *p_owner,
+                                                 const es_format_t *p_fmt )
+{
+    decoder_t *p_dec = &p_owner->dec;
+
+    if( es_format_IsSimilar( &p_dec->fmt_in, p_fmt ) )
+        return VLC_SUCCESS;
+
+    msg_Dbg( p_dec, "restarting module due to input format change");
+
+    /* Drain the decoder module */
+    DecoderThread_DecodeBlock( p_owner, NULL );
+
+    return DecoderThread_Reload( p_owner, p_fmt, RELOAD_DECODER );
+}
+
+static void DecoderThread_DecodeChain( vlc_input_decoder_t *p_owner,
+                                       block_t *p_packetized_block )
+{
+    while( p_packetized_block )
+    {
+        block_t *p_next = p_packetized_block->p_next;
+        p_packetized_block->p_next = NULL;
+
+        DecoderThread_DecodeBlock( p_owner, p_packetized_block );
+        if( p_owner->error )
+        {
+            block_ChainRelease( p_next );
+            return;
+        }
+
+        p_packetized_block = p_next;
+    }
+}
+
+static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, block_t *p_block )
+{
+    if( p_owner->error )
+        goto error;
+
+    if( DecoderThread_CheckReload( p_owner ) != VLC_SUCCESS )
+        goto error;
 
     bool packetize = p_owner->p_packetizer != NULL;
     if( p_block )
@@ -1428,38 +1594,19 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, block_t *p
         while( (p_packetized_block =
                 p_packetizer->pf_packetize( p_packetizer, pp_block ) ) )
         {
-            if( !es_format_IsSimilar( &p_dec->fmt_in, &p_packetizer->fmt_out ) )
+            if( DecoderThread_UpdatePacketizedFormat( p_owner,
+                                    &p_packetizer->fmt_out ) != VLC_SUCCESS )
             {
-                msg_Dbg( p_dec, "restarting module due to input format change");
-
-                /* Drain the decoder module */
-                DecoderThread_DecodeBlock( p_owner, NULL );
-
-                if( DecoderThread_Reload( p_owner, &p_packetizer->fmt_out,
-                                          RELOAD_DECODER ) != VLC_SUCCESS )
-                {
-                    block_ChainRelease( p_packetized_block );
-                    return;
-                }
+                block_ChainRelease( p_packetized_block );
+                return;
             }
 
             if( p_packetizer->pf_get_cc )
                 PacketizerGetCc( p_owner, p_packetizer );
 
-            while( p_packetized_block )
-            {
-                block_t *p_next = p_packetized_block->p_next;
-                p_packetized_block->p_next = NULL;
-
-                DecoderThread_DecodeBlock( p_owner, p_packetized_block );
-                if( p_owner->error )
-                {
-                    block_ChainRelease( p_next );
-                    return;
-                }
-
-                p_packetized_block = p_next;
-            }
+            DecoderThread_DecodeChain( p_owner, p_packetized_block );
+            if( p_owner->error )
+                return;
         }
         /* Drain the decoder after the packetizer is drained */
         if( !pp_block )
@@ -1474,11 +1621,280 @@ error:
         block_Release( p_block );
 }
 
+/* Nothing is waiting to be packetized or decoded */
+static bool DecoderFifoIsEmptyLocked( vlc_input_decoder_t *p_owner )
+{
+    return vlc_fifo_IsEmpty( p_owner->p_fifo )
+        && p_owner->pkt.p_in == NULL && p_owner->pkt.p_out == NULL
+        && !p_owner->pkt.b_busy;
+}
+
+static void DecoderPacketizedRelease( struct decoder_packetized *p_out )
+{
+    while( p_out != NULL )
+    {
+        struct decoder_packetized *p_next = p_out->p_next;
+
+        block_ChainRelease( p_out->p_blocks );
+        if( p_out->p_fmt != NULL )
+        {
+            es_format_Clean( p_out->p_fmt );
+            free( p_out->p_fmt );
+        }
+        free( p_out );
+        p_out = p_next;
+    }
+}
+
+static void PacketizerThread_Queue( vlc_input_decoder_t *p_owner,
+                                    struct decoder_packetized *p_out )
+{
+    vlc_fifo_Lock( p_owner->p_fifo );
+    *p_owner->pkt.pp_out_last = p_out;
+    p_owner->pkt.pp_out_last = &p_out->p_next;
+    p_owner->pkt.i_out++;
+    vlc_fifo_Signal( p_owner->p_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
+/**
+ * The packetizer loop, when it runs in its own thread
+ *
+ * It packetizes the input blocks handed by the DecoderThread, and queues the
+ * packetized blocks back to it, with the format changes of the packetizer.
+ */
+static void *PacketizerThread( void *p_data )
+{
+    vlc_input_decoder_t *p_owner = p_data;
+    decoder_t *p_packetizer = p_owner->p_packetizer;
+    es_format_t fmt;
+
+    if( es_format_Copy( &fmt, &p_packetizer->fmt_out ) != VLC_SUCCESS )
+        es_format_Init( &fmt, p_packetizer->fmt_out.i_cat, 0 );
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    for( ;; )
+    {
+        while( !p_owner->pkt.b_abort
+            && ( ( p_owner->pkt.p_in == NULL && !p_owner->pkt.b_drain )
+              || p_owner->pkt.i_out >= DECODER_PACKETIZER_QUEUE ) )
+            vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->pkt.wait );
+        if( p_owner->pkt.b_abort )
+            break;
+
+        block_t *p_block = p_owner->pkt.p_in;
+        if( p_block != NULL )
+        {
+            p_owner->pkt.p_in = p_block->p_next;
+            if( p_owner->pkt.p_in == NULL )
+                p_owner->pkt.pp_in_last = &p_owner->pkt.p_in;
+            p_owner->pkt.i_in--;
+            p_block->p_next = NULL;
+        }
+        else
+            p_owner->pkt.b_drain = false;
+        p_owner->pkt.b_busy = true;
+        vlc_fifo_Unlock( p_owner->p_fifo );
+
+        block_t *p_packetized_block;
+        block_t **pp_block = p_block ? &p_block : NULL;
+
+        while( (p_packetized_block =
+                p_packetizer->pf_packetize( p_packetizer, pp_block ) ) )
+        {
+            struct decoder_packetized *p_out = malloc( sizeof( *p_out ) );
+            if( unlikely(p_out == NULL) )
+            {
+                block_ChainRelease( p_packetized_block );
+                continue;
+            }
+            p_out->p_next = NULL;
+            p_out->p_blocks = p_packetized_block;
+            p_out->p_fmt = NULL;
+            p_out->b_drain = false;
+
+            if( !es_format_IsSimilar( &fmt, &p_packetizer->fmt_out ) )
+            {
+                es_format_Clean( &fmt );
+                if( es_format_Copy( &fmt, &p_packetizer->fmt_out ) != VLC_SUCCESS )
+                    es_format_Init( &fmt, p_packetizer->fmt_out.i_cat, 0 );
+
+                p_out->p_fmt = malloc( sizeof( *p_out->p_fmt ) );
+                if( p_out->p_fmt != NULL
+                 && es_format_Copy( p_out->p_fmt, &fmt ) != VLC_SUCCESS )
+                {
+                    free( p_out->p_fmt );
+                    p_out->p_fmt = NULL;
+                }
+            }
+
+            if( p_packetizer->pf_get_cc )
+                PacketizerGetCc( p_owner, p_packetizer );
+
+            PacketizerThread_Queue( p_owner, p_out );
+        }
+
+        if( pp_block == NULL )
+        {   /* Drain the decoder after the packetizer is drained */
+            struct decoder_packetized *p_out = calloc( 1, sizeof( *p_out ) );
+            if( likely(p_out != NULL) )
+            {
+                p_out->b_drain = true;
+                PacketizerThread_Queue( p_owner, p_out );
+            }
+        }
+
+        vlc_fifo_Lock( p_owner->p_fifo );
+        p_owner->pkt.b_busy = false;
+        vlc_fifo_Signal( p_owner->p_fifo );
+    }
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    es_format_Clean( &fmt );
+    return NULL;
+}
+
+static void DecoderThread_ProcessPacketized( vlc_input_decoder_t *p_owner,
+                                             struct decoder_packetized *p_out )
+{
+    if( p_owner->error
+     || DecoderThread_CheckReload( p_owner ) != VLC_SUCCESS )
+        goto end;
+
+    if( p_out->p_fmt != NULL
+     && DecoderThread_UpdatePacketizedFormat( p_owner,
+                                              p_out->p_fmt ) != VLC_SUCCESS )
+        goto end;
+
+    DecoderThread_DecodeChain( p_owner, p_out->p_blocks );
+    p_out->p_blocks = NULL;
+
+    if( p_out->b_drain && !p_owner->error )
+        DecoderThread_DecodeBlock( p_owner, NULL );
+
+end:
+    DecoderPacketizedRelease( p_out );
+}
+
+/**
+ * One step of the decoding loop, when the packetizer runs in its own thread:
+ * decodes its output first, then hands it the next input block, or the drain
+ * request.
+ *
+ * It is called, and returns, with the fifo locked.
+ */
+static void DecoderThread_StepPacketizer( vlc_input_decoder_t *p_owner )
+{
+    struct decoder_packetized *p_out = p_owner->pkt.p_out;
+    if( p_out != NULL )
+    {
+        p_owner->pkt.p_out = p_out->p_next;
+        if( p_owner->pkt.p_out == NULL )
+            p_owner->pkt.pp_out_last = &p_owner->pkt.p_out;
+        p_owner->pkt.i_out--;
+        p_out->p_next = NULL;
+        vlc_cond_signal( &p_owner->pkt.wait );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+
+        const bool b_drain = p_out->b_drain;
+        DecoderThread_ProcessPacketized( p_owner, p_out );
+
+        vlc_mutex_lock( &p_owner->lock );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        if( b_drain )
+        {
+            p_owner->pkt.b_drain_sent = false;
+            if( p_owner->b_draining )
+            {
+                p_owner->b_draining = false;
+                p_owner->drained = true;
+            }
+        }
+        vlc_cond_signal( &p_owner->wait_acknowledge );
+        vlc_mutex_unlock( &p_owner->lock );
+        return;
+    }
+
+    vlc_cond_signal( &p_owner->wait_fifo );
+
+    if( p_owner->pkt.i_in < DECODER_PACKETIZER_QUEUE )
+    {
+        block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+        if( p_block != NULL )
+        {
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            if( p_block->i_buffer > 0 )
+            {
+                vlc_mutex_lock( &p_owner->lock );
+                DecoderUpdatePreroll( &p_owner->i_preroll_end, p_block );
+                vlc_mutex_unlock( &p_owner->lock );
+            }
+            else
+            {
+                block_Release( p_block );
+                p_block = NULL;
+            }
+            vlc_fifo_Lock( p_owner->p_fifo );
+
+            if( p_block != NULL )
+            {
+                *p_owner->pkt.pp_in_last = p_block;
+                p_owner->pkt.pp_in_last = &p_block->p_next;
+                p_owner->pkt.i_in++;
+                vlc_cond_signal( &p_owner->pkt.wait );
+            }
+            return;
+        }
+
+        if( p_owner->b_draining && !p_owner->pkt.b_drain_sent )
+        {   /* We have emptied the FIFO and there is a pending request to
+             * drain: drain the packetizer, then the decoder, just once. */
+            p_owner->pkt.b_drain = true;
+            p_owner->pkt.b_drain_sent = true;
+            vlc_cond_signal( &p_owner->pkt.wait );
+            return;
+        }
+    }
+
+    /* Wait for a block to decode, to packetize, or a request */
+    p_owner->b_idle = true;
+    vlc_cond_signal( &p_owner->wait_acknowledge );
+    vlc_fifo_Wait( p_owner->p_fifo );
+    p_owner->b_idle = false;
+}
+
+static void DecoderThread_FlushPacketizer( vlc_input_decoder_t *p_owner )
+{
+    vlc_fifo_Lock( p_owner->p_fifo );
+    block_ChainRelease( p_owner->pkt.p_in );
+    p_owner->pkt.p_in = NULL;
+    p_owner->pkt.pp_in_last = &p_owner->pkt.p_in;
+    p_owner->pkt.i_in = 0;
+    p_owner->pkt.b_drain = false;
+
+    /* The packetizer is not used anymore once it is idle */
+    while( p_owner->pkt.b_busy )
+        vlc_fifo_Wait( p_owner->p_fifo );
+
+    struct decoder_packetized *p_out = p_owner->pkt.p_out;
+    p_owner->pkt.p_out = NULL;
+    p_owner->pkt.pp_out_last = &p_owner->pkt.p_out;
+    p_owner->pkt.i_out = 0;
+    p_owner->pkt.b_drain_sent = false;
+    vlc_cond_signal( &p_owner->pkt.wait );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    DecoderPacketizedRelease( p_out );
+}
+
 static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
 {
     decoder_t *p_dec = &p_owner->dec;
     decoder_t *p_packetizer = p_owner->p_packetizer;
 
+    if( p_owner->pkt.b_threaded )
+        DecoderThread_FlushPacketizer( p_owner );
+
     if( p_owner->error )
         return;
 
@@ -1711,6 +2127,12 @@ static void *DecoderThread( void *p_data )
             continue;
         }
 
+        if( p_owner->pkt.b_threaded )
+        {
+            DecoderThread_StepPacketizer( p_owner );
+            continue;
+        }
+
         vlc_cond_signal( &p_owner->wait_fifo );
 
         block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
@@ -1828,11 +2250,23 @@ CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_aout = NULL;
     p_owner->p_vout = NULL;
     p_owner->vout_thread_started = false;
+    p_owner->first_picture_start = vlc_tick_now();
     p_owner->i_spu_channel = VOUT_SPU_CHANNEL_INVALID;
     p_owner->i_spu_order = 0;
     p_owner->p_sout = p_sout;
     p_owner->p_sout_input = NULL;
     p_owner->p_packetizer = NULL;
+    p_owner->pkt.b_threaded = false;
+    p_owner->pkt.p_in = NULL;
+    p_owner->pkt.pp_in_last = &p_owner->pkt.p_in;
+    p_owner->pkt.i_in = 0;
+    p_owner->pkt.p_out = NULL;
+    p_owner->pkt.pp_out_last = &p_owner->pkt.p_out;
+    p_owner->pkt.i_out = 0;
+    p_owner->pkt.b_drain = false;
+    p_owner->pkt.b_drain_sent = false;
+    p_owner->pkt.b_busy = false;
+    p_owner->pkt.b_abort = false;
 
     atomic_init( &p_owner->b_fmt_description, false );
     p_owner->p_description = NULL;
@@ -1874,6 +2308,7 @@ CreateDecoder( vlc_object_t *p_parent,
     vlc_cond_init( &p_owner->wait_request );
     vlc_cond_init( &p_owner->wait_acknowledge );
     vlc_cond_init( &p_owner->wait_fifo );
+    vlc_cond_init( &p_owner->pkt.wait );
 
     /* Load a packetizer module if the input is not already packetized */
     if( p_sout == NULL && !fmt->b_packetized )
@@ -2005,7 +2440,8 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner )
                  * thread */
                 if (p_owner->out_pool)
                     picture_pool_Cancel( p_owner->out_pool, false );
-                vout_StopDisplay(vout);
+                /* keep the display for the next decoder, if compatible */
+                vout_ParkDisplay(vout);
                 p_owner->vout_thread_started = false;
                 decoder_Notify(p_owner, on_vout_stopped, vout);
                 input_resource_PutVout(p_owner->p_resource, vout);
@@ -2043,6 +2479,25 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner )
 }
 
 /* */
+static void StopPacketizerThread( vlc_input_decoder_t *p_owner )
+{
+    if( !p_owner->pkt.b_threaded )
+        return;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    p_owner->pkt.b_abort = true;
+    vlc_cond_signal( &p_owner->pkt.wait );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    vlc_join( p_owner->pkt.thread, NULL );
+    p_owner->pkt.b_threaded = false;
+
+    block_ChainRelease( p_owner->pkt.p_in );
+    p_owner->pkt.p_in = NULL;
+    DecoderPacketizedRelease( p_owner->pkt.p_out );
+    p_owner->pkt.p_out = NULL;
+}
+
 static void DecoderUnsupportedCodec( decoder_t *p_dec, const es_format_t *fmt, bool b_decoding )
 {
     if (fmt->i_codec != VLC_CODEC_UNKNOWN && fmt->i_codec) {
@@ -2113,10 +2568,25 @@ decoder_New( vlc_object_t *p_parent, const es_format_t *fmt,
     }
 #endif
 
+    /* Spawn the packetizer thread, if wanted */
+    if( p_owner->p_packetizer != NULL && p_dec->fmt_in.i_cat == VIDEO_ES
+     && !thumbnailing && var_InheritBool( p_dec, "packetizer-thread" ) )
+    {
+        if( vlc_clone( &p_owner->pkt.thread, PacketizerThread, p_owner,
+                       i_priority ) == 0 )
+        {
+            p_owner->pkt.b_threaded = true;
+            msg_Dbg( p_dec, "packetizing in a separate thread" );
+        }
+        else
+            msg_Warn( p_dec, "cannot spawn packetizer thread" );
+    }
+
     /* Spawn the decoder thread */
     if( vlc_clone( &p_owner->thread, DecoderThread, p_owner, i_priority ) )
     {
         msg_Err( p_dec, "cannot spawn decoder thread" );
+        StopPacketizerThread( p_owner );
         DeleteDecoder( p_owner );
         return NULL;
     }
@@ -2192,6 +2662,7 @@ void vlc_input_decoder_Delete( vlc_input_decoder_t *p_owner )
     vlc_mutex_unlock( &p_owner->lock );
 
     vlc_join( p_owner->thread, NULL );
+    StopPacketizerThread( p_owner );
 
     /* */
     if( p_owner->cc.b_supported )
@@ -2246,7 +2717,7 @@ bool vlc_input_decoder_IsEmpty( vlc_input_decoder_t * p_owner )
     assert( !p_owner->b_waiting );
 
     vlc_fifo_Lock( p_owner->p_fifo );
-    if( !vlc_fifo_IsEmpty( p_owner->p_fifo ) || p_owner->b_draining )
+    if( !DecoderFifoIsEmptyLocked( p_owner ) || p_owner->b_draining )
     {
         vlc_fifo_Unlock( p_owner->p_fifo );
         return false;
@@ -2495,7 +2966,7 @@ void vlc_input_decoder_Wait( vlc_input_decoder_t *p_owner )
         if( p_owner->paused )
             break;
         vlc_fifo_Lock( p_owner->p_fifo );
-        if( p_owner->b_idle && vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+        if( p_owner->b_idle && DecoderFifoIsEmptyLocked( p_owner ) )
         {
             msg_Err( &p_owner->dec, "buffer deadlock prevented" );
             vlc_fifo_Unlock( p_owner->p_fifo );
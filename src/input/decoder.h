@@ -27,6 +27,7 @@
 #include <vlc_common.h>
 #include <vlc_codec.h>
 #include <vlc_mouse.h>
+#include <vlc_input_item.h>
 
 struct vlc_input_decoder_callbacks {
     /* notifications */
@@ -43,6 +44,9 @@ struct vlc_input_decoder_callbacks {
                                void *userdata);
     void (*on_new_audio_stats)(vlc_input_decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned played, void *userdata);
+    void (*on_new_latency)(vlc_input_decoder_t *decoder,
+                           enum input_latency_stage stage,
+                           const input_latency_t *latency, void *userdata);
 
     /* requests */
     int (*get_attachments)(vlc_input_decoder_t *decoder,
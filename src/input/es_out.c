@@ -205,6 +205,7 @@ typedef struct
     vlc_tick_t  i_tracks_pts_delay;
     vlc_tick_t  i_pts_jitter;
     int         i_cr_average;
+    enum input_clock_recovery clock_recovery;
     float       rate;
 
     /* */
@@ -393,6 +394,27 @@ decoder_on_new_audio_stats(vlc_input_decoder_t *decoder, unsigned decoded, unsig
                               memory_order_relaxed);
 }
 
+static void
+decoder_on_new_latency(vlc_input_decoder_t *decoder,
+                       enum input_latency_stage stage,
+                       const input_latency_t *latency, void *userdata)
+{
+    (void) decoder;
+
+    es_out_id_t *id = userdata;
+    es_out_t *out = id->out;
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+
+    if (!p_sys->p_input)
+        return;
+
+    struct input_stats *stats = input_priv(p_sys->p_input)->stats;
+    if (!stats)
+        return;
+
+    input_stats_AddLatency(stats, stage, latency);
+}
+
 static int
 decoder_get_attachments(vlc_input_decoder_t *decoder,
                         input_attachment_t ***ppp_attachment,
@@ -416,6 +438,7 @@ static const struct vlc_input_decoder_callbacks decoder_cbs = {
     .on_thumbnail_ready = decoder_on_thumbnail_ready,
     .on_new_video_stats = decoder_on_new_video_stats,
     .on_new_audio_stats = decoder_on_new_audio_stats,
+    .on_new_latency = decoder_on_new_latency,
     .get_attachments = decoder_get_attachments,
 };
 
@@ -525,6 +548,8 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, input_source_t *main_source,
             break;
     }
 
+    p_sys->clock_recovery = var_InheritInteger( p_input, "clock-recovery" );
+
     p_sys->i_pause_date = -1;
 
     p_sys->rate = rate;
@@ -1372,7 +1397,7 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, input_source_t *source, in
     p_pgrm->p_meta = NULL;
 
     p_pgrm->p_master_clock = NULL;
-    p_pgrm->p_input_clock = input_clock_New( p_sys->rate );
+    p_pgrm->p_input_clock = input_clock_New( p_sys->rate, p_sys->clock_recovery );
     p_pgrm->p_main_clock = vlc_clock_main_New();
     if( !p_pgrm->p_input_clock || !p_pgrm->p_main_clock )
     {
@@ -1393,6 +1418,13 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, input_source_t *source, in
      * than the visual quality if the user chose this option. */
     if (input_priv(p_input)->b_low_delay)
         vlc_clock_main_SetDejitter(p_pgrm->p_main_clock, 0);
+    else
+    {
+        /* Nor more than the latency budget of the audio output, if any */
+        const vlc_tick_t budget = aout_LatencyBudget(p_input);
+        if (budget > 0 && budget < 2 * AOUT_MAX_PTS_ADVANCE)
+            vlc_clock_main_SetDejitter(p_pgrm->p_main_clock, budget);
+    }
 
     /* Append it */
     vlc_list_append(&p_pgrm->node, &p_sys->programs);
@@ -36,6 +36,11 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_FALLOCATE)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  define TS_STORAGE_MMAP 1
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -183,8 +188,12 @@ struct ts_storage_t
 #endif
     size_t  i_file_max; /* Max size in bytes */
     int64_t i_file_size;/* Current size in bytes */
+#ifdef TS_STORAGE_MMAP
+    uint8_t *p_map;     /* Mapping of the whole (preallocated) file */
+#else
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
+#endif
 
     /* */
     int      i_cmd_r;
@@ -221,6 +230,7 @@ typedef struct
     /* */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage_spare; /* Consumed storage kept for reuse */
 
     vlc_tick_t     i_cmd_delay;
 
@@ -277,7 +287,7 @@ static void         *TsRun( void * );
 
 static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
 static void         TsStorageDelete( ts_storage_t * );
-static void         TsStoragePack( ts_storage_t *p_storage );
+static void         TsStorageReset( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
 static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
@@ -892,6 +902,7 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_cmd_delay = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_storage_spare = NULL;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -936,6 +947,8 @@ static void TsStop( ts_thread_t *p_ts )
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
     if( p_ts->p_storage_r )
         TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage_spare )
+        TsStorageDelete( p_ts->p_storage_spare );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -944,9 +957,19 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
+    /* Everything written was read, start over in the same storage */
+    if( p_ts->p_storage_w && p_ts->p_storage_w == p_ts->p_storage_r &&
+        TsStorageIsEmpty( p_ts->p_storage_w ) )
+        TsStorageReset( p_ts->p_storage_w );
+
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = p_ts->p_storage_spare;
+
+        if( p_storage )
+            p_ts->p_storage_spare = NULL;
+        else
+            p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
 
         if( !p_storage )
         {
@@ -962,7 +985,6 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
         }
         else
         {
-            TsStoragePack( p_ts->p_storage_w );
             p_ts->p_storage_w->p_next = p_storage;
             p_ts->p_storage_w = p_storage;
         }
@@ -990,7 +1012,15 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
         if( !p_next )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
+        /* Keep one storage around, instead of creating a new file for each
+         * storage */
+        if( !p_ts->p_storage_spare )
+        {
+            TsStorageReset( p_ts->p_storage_r );
+            p_ts->p_storage_spare = p_ts->p_storage_r;
+        }
+        else
+            TsStorageDelete( p_ts->p_storage_r );
         p_ts->p_storage_r = p_next;
     }
 
@@ -1204,6 +1234,21 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
 
+#ifdef TS_STORAGE_MMAP
+    /* The file blocks are allocated upfront, so that writing to the mapping
+     * cannot fail (with SIGBUS) if the disk gets full */
+    if( posix_fallocate( fd, 0, i_tmp_size_max ) )
+        p_storage->p_map = MAP_FAILED;
+    else
+        p_storage->p_map = mmap( NULL, i_tmp_size_max, PROT_READ|PROT_WRITE,
+                                 MAP_SHARED, fd, 0 );
+    vlc_close( fd );
+    if( p_storage->p_map == MAP_FAILED )
+    {
+        vlc_unlink( psz_file );
+        goto error;
+    }
+#else
     p_storage->p_filew = fdopen( fd, "w+b" );
     if( p_storage->p_filew == NULL )
     {
@@ -1219,6 +1264,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         vlc_unlink( psz_file );
         goto error;
     }
+#endif
 
 #ifndef _WIN32
     vlc_unlink( psz_file );
@@ -1263,8 +1309,12 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
+#ifdef TS_STORAGE_MMAP
+    munmap( p_storage->p_map, p_storage->i_file_max );
+#else
     fclose( p_storage->p_filer );
     fclose( p_storage->p_filew );
+#endif
 #ifdef _WIN32
     vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
@@ -1272,17 +1322,32 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     free( p_storage );
 }
 
-static void TsStoragePack( ts_storage_t *p_storage )
+static void TsStorageReset( ts_storage_t *p_storage )
 {
-    /* Try to release a bit of memory */
-    if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
-        return;
+    assert( TsStorageIsEmpty( p_storage ) );
 
-    p_storage->i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
+    p_storage->p_next = NULL;
+    p_storage->i_file_size = 0;
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_r = 0;
+#ifndef TS_STORAGE_MMAP
+    rewind( p_storage->p_filew );
+#endif
+}
 
-    ts_cmd_t *p_new = realloc( p_storage->p_cmd, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
-    if( p_new )
-        p_storage->p_cmd = p_new;
+static bool TsStorageWrite( ts_storage_t *p_storage, const void *p_data, size_t i_data )
+{
+#ifdef TS_STORAGE_MMAP
+    /* Only a block larger than the whole file may not fit */
+    if( p_storage->i_file_max - p_storage->i_file_size < i_data )
+        return false;
+    memcpy( &p_storage->p_map[p_storage->i_file_size], p_data, i_data );
+#else
+    if( fwrite( p_data, i_data, 1, p_storage->p_filew ) != 1 )
+        return false;
+#endif
+    p_storage->i_file_size += i_data;
+    return true;
 }
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
@@ -1310,27 +1375,23 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         block_t *p_block = cmd.u.send.p_block;
 
         cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        cmd.u.send.i_offset = p_storage->i_file_size;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        if( !TsStorageWrite( p_storage, p_block, sizeof(*p_block) ) ||
+            ( p_block->i_buffer > 0 &&
+              !TsStorageWrite( p_storage, p_block->p_buffer, p_block->i_buffer ) ) )
         {
             block_Release( p_block );
             return;
         }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
-        }
-        p_storage->i_file_size += p_block->i_buffer;
         block_Release( p_block );
 
+#ifndef TS_STORAGE_MMAP
         if( b_flush )
             fflush( p_storage->p_filew );
+#else
+        VLC_UNUSED( b_flush );
+#endif
     }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
@@ -1343,6 +1404,26 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     {
         block_t block;
 
+#ifdef TS_STORAGE_MMAP
+        const uint8_t *p_data = &p_storage->p_map[p_cmd->u.send.i_offset];
+
+        if( !b_flush )
+        {
+            memcpy( &block, p_data, sizeof(block) );
+
+            block_t *p_block = block_Alloc( block.i_buffer );
+            if( p_block )
+            {
+                p_block->i_dts      = block.i_dts;
+                p_block->i_pts      = block.i_pts;
+                p_block->i_flags    = block.i_flags;
+                p_block->i_length   = block.i_length;
+                p_block->i_nb_samples = block.i_nb_samples;
+                memcpy( p_block->p_buffer, &p_data[sizeof(block)], block.i_buffer );
+            }
+            p_cmd->u.send.p_block = p_block;
+        }
+#else
         if( !b_flush &&
             !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
             fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
@@ -1359,6 +1440,7 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
             }
             p_cmd->u.send.p_block = p_block;
         }
+#endif
         else
         {
             //perror( "TsStoragePopCmd" );
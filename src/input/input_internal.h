@@ -730,11 +730,14 @@ struct input_stats {
     atomic_uintmax_t lost_abuffers;
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t lost_pictures;
+    atomic_uintmax_t latency[INPUT_LATENCY_STAGES][INPUT_LATENCY_BUCKETS];
 };
 
 struct input_stats *input_stats_Create(void);
 void input_stats_Destroy(struct input_stats *);
 void input_rate_Add(input_rate_t *, uintmax_t);
+void input_stats_AddLatency(struct input_stats *, enum input_latency_stage,
+                            const input_latency_t *);
 void input_stats_Compute(struct input_stats *, input_stats_t*);
 
 #endif
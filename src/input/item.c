@@ -1520,6 +1520,7 @@ struct rdh_slave
 {
     input_item_slave_t *p_slave;
     char *psz_filename;
+    char *psz_name; /* see rdh_name_from_filename() */
     input_item_node_t *p_node;
 };
 
@@ -1560,16 +1561,13 @@ static char *rdh_name_from_filename(const char *psz_filename)
     return psz_name;
 }
 
-static uint8_t rdh_get_slave_priority(input_item_t *p_item,
+/* The names are normalized once per item and per slave, as all the
+ * combinations are tried */
+static uint8_t rdh_get_slave_priority(const char *psz_item_name,
                                       input_item_slave_t *p_slave,
-                                      const char *psz_slave_filename)
+                                      const char *psz_slave_name)
 {
     uint8_t i_priority = SLAVE_PRIORITY_MATCH_NONE;
-    char *psz_item_name = rdh_name_from_filename(p_item->psz_name);
-    char *psz_slave_name = rdh_name_from_filename(psz_slave_filename);
-
-    if (!psz_item_name || !psz_slave_name)
-        goto done;
 
     size_t i_item_len = strlen(psz_item_name);
     size_t i_slave_len = strlen(psz_slave_name);
@@ -1612,8 +1610,6 @@ static uint8_t rdh_get_slave_priority(input_item_t *p_item,
     }
 
 done:
-    free(psz_item_name);
-    free(psz_slave_name);
     return i_priority;
 }
 
@@ -1673,6 +1669,10 @@ static void rdh_attach_slaves(struct vlc_readdir_helper *p_rdh,
          || input_item_slave_GetType(p_item->psz_name, &unused))
             continue; /* don't match 2 possible slaves between each others */
 
+        char *psz_item_name = rdh_name_from_filename(p_item->psz_name);
+        if (psz_item_name == NULL)
+            continue;
+
         for (size_t j = 0; j < p_rdh->i_slaves; j++)
         {
             struct rdh_slave *p_rdh_slave = p_rdh->pp_slaves[j];
@@ -1684,8 +1684,8 @@ static void rdh_attach_slaves(struct vlc_readdir_helper *p_rdh,
                 continue;
 
             uint8_t i_priority =
-                rdh_get_slave_priority(p_item, p_rdh_slave->p_slave,
-                                         p_rdh_slave->psz_filename);
+                rdh_get_slave_priority(psz_item_name, p_rdh_slave->p_slave,
+                                       p_rdh_slave->psz_name);
 
             if (i_priority < p_rdh->i_sub_autodetect_fuzzy)
                 continue;
@@ -1719,6 +1719,7 @@ static void rdh_attach_slaves(struct vlc_readdir_helper *p_rdh,
 
             p_rdh_slave->p_slave->i_priority = i_priority;
         }
+        free(psz_item_name);
     }
 
     /* Attach all children */
@@ -1837,6 +1838,7 @@ void vlc_readdir_helper_finish(struct vlc_readdir_helper *p_rdh, bool b_success)
         if (p_rdh_slave != NULL)
         {
             input_item_slave_Delete(p_rdh_slave->p_slave);
+            free(p_rdh_slave->psz_name);
             free(p_rdh_slave->psz_filename);
             free(p_rdh_slave);
         }
@@ -1883,10 +1885,15 @@ int vlc_readdir_helper_additem(struct vlc_readdir_helper *p_rdh,
 
         p_rdh_slave->p_node = NULL;
         p_rdh_slave->psz_filename = strdup(psz_filename);
+        p_rdh_slave->psz_name = rdh_name_from_filename(psz_filename);
         p_rdh_slave->p_slave = input_item_slave_New(psz_uri, i_slave_type,
                                                       SLAVE_PRIORITY_MATCH_NONE);
-        if (!p_rdh_slave->p_slave || !p_rdh_slave->psz_filename)
+        if (!p_rdh_slave->p_slave || !p_rdh_slave->psz_filename
+         || !p_rdh_slave->psz_name)
         {
+            if (p_rdh_slave->p_slave)
+                input_item_slave_Delete(p_rdh_slave->p_slave);
+            free(p_rdh_slave->psz_name);
             free(p_rdh_slave->psz_filename);
             free(p_rdh_slave);
             return VLC_ENOMEM;
@@ -24,6 +24,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -67,6 +68,9 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->lost_abuffers, 0);
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
+    for (size_t i = 0; i < INPUT_LATENCY_STAGES; i++)
+        for (size_t j = 0; j < INPUT_LATENCY_BUCKETS; j++)
+            atomic_init(&stats->latency[i][j], 0);
     return stats;
 }
 
@@ -108,6 +112,29 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    /* Latencies */
+    for (size_t i = 0; i < INPUT_LATENCY_STAGES; i++)
+        for (size_t j = 0; j < INPUT_LATENCY_BUCKETS; j++)
+            st->latency[i].buckets[j] =
+                atomic_load_explicit(&stats->latency[i][j],
+                                     memory_order_relaxed);
+}
+
+/**
+ * Adds samples to a latency histogram.
+ */
+void input_stats_AddLatency(struct input_stats *stats,
+                            enum input_latency_stage stage,
+                            const input_latency_t *latency)
+{
+    assert(stage < INPUT_LATENCY_STAGES);
+
+    for (size_t i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+        if (latency->buckets[i] != 0)
+            atomic_fetch_add_explicit(&stats->latency[stage][i],
+                                      latency->buckets[i],
+                                      memory_order_relaxed);
 }
 
 /** Update a counter element with new values
@@ -402,6 +402,45 @@ static ssize_t vlc_stream_CopyBlock(block_t **restrict pp,
     return likely(len > 0) ? (ssize_t)len : -1;
 }
 
+/**
+ * Takes data from a pending block without copying it.
+ */
+static block_t *vlc_stream_CutBlock(block_t **restrict pp, size_t len)
+{
+    block_t *block = *pp;
+
+    if (block == NULL || block->i_buffer < len)
+        return NULL;
+
+    if (block->i_buffer == len)
+    {
+        *pp = NULL;
+        block->p_next = NULL;
+        block->i_flags = 0;
+        block->i_nb_samples = 0;
+        block->i_pts = block->i_dts = VLC_TICK_INVALID;
+        block->i_length = 0;
+        return block;
+    }
+
+    block = block_Share(block);
+    if (unlikely(block == NULL))
+        return NULL;
+    *pp = block;
+
+    block_t *view = block_View(block, 0, len);
+    if (unlikely(view == NULL))
+        return NULL;
+
+    /* Keep the remaining data from being moved over the view, as would
+     * vlc_stream_Peek() reallocation */
+    block->p_buffer += len;
+    block->i_buffer -= len;
+    block->i_size -= block->p_buffer - block->p_start;
+    block->p_start = block->p_buffer;
+    return view;
+}
+
 static ssize_t vlc_stream_ReadRaw(stream_t *s, void *buf, size_t len)
 {
     stream_priv_t *priv = (stream_priv_t *)s;
@@ -711,12 +750,30 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
  * @return a block of data, or NULL on error
  @ note The block size may be shorter than requested if the end-of-stream was
  * reached.
+ * @note The block may share its data with the access block it was read from,
+ * see block_View().
  */
 block_t *vlc_stream_Block( stream_t *s, size_t size )
 {
+    stream_priv_t *priv = (stream_priv_t *)s;
+
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
+    /* Share the data if it is already buffered, typically from a block
+     * based access */
+    if( size > 0 )
+    {
+        block_t *block = vlc_stream_CutBlock( priv->peek != NULL
+                                              ? &priv->peek : &priv->block,
+                                              size );
+        if( block != NULL )
+        {
+            priv->offset += size;
+            return block;
+        }
+    }
+
     block_t *block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
@@ -54,6 +54,10 @@ typedef struct vlc_thumbnailer_params_t
      */
     vlc_tick_t timeout;
     vlc_thumbnailer_cb cb;
+    /* batch requests only, the time and cb fields are not used then */
+    vlc_tick_t* times;
+    size_t count;
+    vlc_thumbnailer_batch_cb batch_cb;
     void* user_data;
 } vlc_thumbnailer_params_t;
 
@@ -66,8 +70,39 @@ struct vlc_thumbnailer_request_t
 
     vlc_mutex_t lock;
     bool done;
+    size_t next; /* next thumbnail of a batch */
 };
 
+static void
+thumbnailer_request_NotifyLocked( vlc_thumbnailer_request_t* request,
+                                  picture_t* pic )
+{
+    if ( request->params.times == NULL )
+    {
+        if ( request->params.cb )
+        {
+            request->params.cb( request->params.user_data, pic );
+            request->params.cb = NULL;
+        }
+        return;
+    }
+    if ( request->params.batch_cb && request->next < request->params.count )
+        request->params.batch_cb( request->params.user_data, request->next,
+                                  pic );
+    request->next++;
+}
+
+/* Signals the failure of the thumbnails not generated yet, if any */
+static void
+thumbnailer_request_FailLocked( vlc_thumbnailer_request_t* request )
+{
+    do
+        thumbnailer_request_NotifyLocked( request, NULL );
+    while ( request->params.times != NULL &&
+            request->next < request->params.count );
+    request->params.batch_cb = NULL;
+}
+
 static void
 on_thumbnailer_input_event( input_thread_t *input,
                             const struct vlc_input_event *event, void *userdata )
@@ -79,28 +114,34 @@ on_thumbnailer_input_event( input_thread_t *input,
          return;
 
     vlc_thumbnailer_request_t* request = userdata;
-    picture_t *pic = NULL;
 
+    vlc_mutex_lock( &request->lock );
     if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
     {
+        /*
+         * If the request has not been cancelled, we can invoke the completion
+         * callback.
+         */
+        thumbnailer_request_NotifyLocked( request, event->thumbnail );
+        if ( request->params.times != NULL &&
+             request->next < request->params.count )
+        {
+            /* Keep the input opened, and seek to the next thumbnail */
+            input_SetTime( request->input_thread,
+                           request->params.times[request->next],
+                           request->params.fast_seek );
+            vlc_mutex_unlock( &request->lock );
+            return;
+        }
         /*
          * Stop the input thread ASAP, delegate its release to
          * thumbnailer_request_Release
          */
         input_Stop( request->input_thread );
-        pic = event->thumbnail;
     }
-    vlc_mutex_lock( &request->lock );
+    else
+        thumbnailer_request_FailLocked( request );
     request->done = true;
-    /*
-     * If the request has not been cancelled, we can invoke the completion
-     * callback.
-     */
-    if ( request->params.cb )
-    {
-        request->params.cb( request->params.user_data, pic );
-        request->params.cb = NULL;
-    }
     vlc_mutex_unlock( &request->lock );
     background_worker_RequestProbe( request->thumbnailer->worker );
 }
@@ -117,6 +158,7 @@ static void thumbnailer_request_Release( void* data )
         input_Close( request->input_thread );
 
     input_item_Release( request->params.input_item );
+    free( request->params.times );
     free( request );
 }
 
@@ -130,10 +172,25 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                                      request->params.input_item );
     if ( unlikely( input == NULL ) )
     {
-        request->params.cb( request->params.user_data, NULL );
+        vlc_mutex_lock( &request->lock );
+        thumbnailer_request_FailLocked( request );
+        vlc_mutex_unlock( &request->lock );
         return VLC_EGENERIC;
     }
-    if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
+    if ( request->params.times != NULL )
+    {
+        if ( request->params.fast_seek )
+        {
+            /* Many small pictures: trade quality for decoding speed */
+            var_Create( input, "avcodec-skiploopfilter", VLC_VAR_INTEGER );
+            var_SetInteger( input, "avcodec-skiploopfilter", 4 );
+            var_Create( input, "avcodec-fast", VLC_VAR_BOOL );
+            var_SetBool( input, "avcodec-fast", true );
+        }
+        input_SetTime( input, request->params.times[0],
+                       request->params.fast_seek );
+    }
+    else if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
     {
         input_SetTime( input, request->params.time,
                        request->params.fast_seek );
@@ -146,7 +203,9 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
     }
     if ( input_Start( input ) != VLC_SUCCESS )
     {
-        request->params.cb( request->params.user_data, NULL );
+        vlc_mutex_lock( &request->lock );
+        thumbnailer_request_FailLocked( request );
+        vlc_mutex_unlock( &request->lock );
         return VLC_EGENERIC;
     }
     *out = request;
@@ -163,11 +222,7 @@ static void thumbnailer_request_Stop( void* owner, void* handle )
      * If the callback hasn't been invoked yet, we assume a timeout and
      * signal it back to the user
      */
-    if ( request->params.cb != NULL )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        request->params.cb = NULL;
-    }
+    thumbnailer_request_FailLocked( request );
     vlc_mutex_unlock( &request->lock );
     assert( request->input_thread != NULL );
     input_Stop( request->input_thread );
@@ -189,11 +244,15 @@ thumbnailer_RequestCommon( vlc_thumbnailer_t* thumbnailer,
 {
     vlc_thumbnailer_request_t *request = malloc( sizeof( *request ) );
     if ( unlikely( request == NULL ) )
+    {
+        free( params->times );
         return NULL;
+    }
     request->thumbnailer = thumbnailer;
     request->input_thread = NULL;
     request->params = *(vlc_thumbnailer_params_t*)params;
     request->done = false;
+    request->next = 0;
     input_item_Hold( request->params.input_item );
     vlc_mutex_init( &request->lock );
 
@@ -245,12 +304,41 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
         });
 }
 
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data )
+{
+    if ( count == 0 )
+        return NULL;
+    vlc_tick_t* copy = vlc_alloc( count, sizeof( *copy ) );
+    if ( unlikely( copy == NULL ) )
+        return NULL;
+    memcpy( copy, times, count * sizeof( *copy ) );
+
+    /* the request owns the copy, even on failure */
+    return thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .type = VLC_THUMBNAILER_SEEK_TIME,
+                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .input_item = input_item,
+                .timeout = timeout,
+                .times = copy,
+                .count = count,
+                .batch_cb = cb,
+                .user_data = user_data,
+        });
+}
+
 void vlc_thumbnailer_Cancel( vlc_thumbnailer_t* thumbnailer,
                              vlc_thumbnailer_request_t* req )
 {
     vlc_mutex_lock( &req->lock );
     /* Ensure we won't invoke the callback if the input was running. */
     req->params.cb = NULL;
+    req->params.batch_cb = NULL;
     vlc_mutex_unlock( &req->lock );
     background_worker_Cancel( thumbnailer->worker, req );
 }
@@ -264,6 +352,9 @@ vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t* parent)
     struct background_worker_config cfg = {
         .default_timeout = -1,
         .max_threads = 1,
+        /* requested for display, usually */
+        .priority = 1,
+        .obj = parent,
         .pf_release = thumbnailer_request_Release,
         .pf_hold = thumbnailer_request_Hold,
         .pf_start = thumbnailer_request_Start,
@@ -46,6 +46,7 @@
 #include "vlm_event.h"
 #include <vlc_sout.h>
 #include <vlc_url.h>
+#include <vlc_memstream.h>
 #include "../stream_output/stream_output.h"
 #include "../libvlc.h"
 #include "input_internal.h"
@@ -56,6 +57,34 @@
 
 static void* Manage( void * );
 
+static enum vlm_state_e vlm_StateFromPlayer(vlc_player_t *player,
+                                            enum vlc_player_state state)
+{
+    switch (state)
+    {
+        case VLC_PLAYER_STATE_STOPPED:
+            return vlc_player_GetError(player) ? VLM_ERROR_S : VLM_INIT_S;
+        case VLC_PLAYER_STATE_STARTED:
+            return VLM_OPENING_S;
+        case VLC_PLAYER_STATE_PLAYING:
+            return VLM_PLAYING_S;
+        case VLC_PLAYER_STATE_PAUSED:
+            return VLM_PAUSE_S;
+        case VLC_PLAYER_STATE_STOPPING:
+            return vlc_player_GetError(player) ? VLM_ERROR_S : VLM_END_S;
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+static void vlm_SignalManage( vlm_t *p_vlm )
+{
+    vlc_mutex_lock( &p_vlm->lock_manage );
+    p_vlm->input_state_changed = true;
+    vlc_cond_signal( &p_vlm->wait_manage );
+    vlc_mutex_unlock( &p_vlm->lock_manage );
+}
+
 static void player_on_state_changed(vlc_player_t *player,
                                     enum vlc_player_state new_state, void *data)
 {
@@ -66,40 +95,37 @@ static void player_on_state_changed(vlc_player_t *player,
 
     for( int i = 0; i < p_media->i_instance; i++ )
     {
-        if( p_media->instance[i]->player == player )
+        if( p_media->instance[i]->own_player == player )
         {
             psz_instance_name = p_media->instance[i]->psz_name;
             break;
         }
     }
     assert(psz_instance_name);
-    enum vlm_state_e vlm_state;
-    switch (new_state)
+    enum vlm_state_e vlm_state = vlm_StateFromPlayer( player, new_state );
+    vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, psz_instance_name, vlm_state );
+
+    vlm_SignalManage( p_vlm );
+}
+
+static void share_on_state_changed(vlc_player_t *player,
+                                   enum vlc_player_state new_state, void *data)
+{
+    vlm_share_sys_t *share = data;
+    enum vlm_state_e vlm_state = vlm_StateFromPlayer( player, new_state );
+
+    /* the attached instances only change with the player locked */
+    for( int i = 0; i < share->i_instance; i++ )
     {
-        case VLC_PLAYER_STATE_STOPPED:
-            vlm_state = vlc_player_GetError(player) ? VLM_ERROR_S : VLM_INIT_S;
-            break;
-        case VLC_PLAYER_STATE_STARTED:
-            vlm_state = VLM_OPENING_S;
-            break;
-        case VLC_PLAYER_STATE_PLAYING:
-            vlm_state = VLM_PLAYING_S;
-            break;
-        case VLC_PLAYER_STATE_PAUSED:
-            vlm_state = VLM_PAUSE_S;
-            break;
-        case VLC_PLAYER_STATE_STOPPING:
-            vlm_state = vlc_player_GetError(player) ? VLM_ERROR_S : VLM_END_S;
-            break;
-        default:
-            vlc_assert_unreachable();
+        vlm_media_instance_sys_t *p_instance = share->instance[i];
+        vlm_media_sys_t *p_media = p_instance->p_media;
+
+        vlm_SendEventMediaInstanceState( share->p_vlm, p_media->cfg.id,
+                                         p_media->cfg.psz_name,
+                                         p_instance->psz_name, vlm_state );
     }
-    vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, psz_instance_name, vlm_state );
 
-    vlc_mutex_lock( &p_vlm->lock_manage );
-    p_vlm->input_state_changed = true;
-    vlc_cond_signal( &p_vlm->wait_manage );
-    vlc_mutex_unlock( &p_vlm->lock_manage );
+    vlm_SignalManage( share->p_vlm );
 }
 
 static vlc_mutex_t vlm_mutex = VLC_STATIC_MUTEX;
@@ -144,6 +170,7 @@ vlm_t *vlm_New( libvlc_int_t *libvlc, const char *psz_vlmconf )
     p_vlm->i_id = 1;
     TAB_INIT( p_vlm->i_media, p_vlm->media );
     TAB_INIT( p_vlm->i_schedule, p_vlm->schedule );
+    TAB_INIT( p_vlm->i_share, p_vlm->share );
     var_Create( p_vlm, "intf-event", VLC_VAR_ADDRESS );
 
     if( vlc_clone( &p_vlm->thread, Manage, p_vlm, VLC_THREAD_PRIORITY_LOW ) )
@@ -205,6 +232,10 @@ void vlm_Delete( vlm_t *p_vlm )
 
     vlm_ControlInternal( p_vlm, VLM_CLEAR_SCHEDULES );
     TAB_CLEAN( p_vlm->i_schedule, p_vlm->schedule );
+
+    /* the shared inputs are deleted with their last instance */
+    assert( p_vlm->i_share == 0 );
+    TAB_CLEAN( p_vlm->i_share, p_vlm->share );
     vlc_mutex_unlock( &p_vlm->lock );
 
     vlc_mutex_lock( &p_vlm->lock_manage );
@@ -584,6 +615,234 @@ static vlm_media_instance_sys_t *vlm_ControlMediaInstanceGetByName( vlm_media_sy
     return NULL;
 }
 
+/*****************************************************************************
+ * Shared inputs:
+ *  Broadcasts of the same input MRL with the same options are attached to
+ *  a single player, so that the source is opened and demuxed only once.
+ *  Its stream output duplicates the ES to the output of every attached
+ *  broadcast, and is restarted with the new list when one is added or
+ *  removed.
+ *****************************************************************************/
+static char *vlm_MediaInputMRL( const vlm_media_t *p_cfg, int i_index )
+{
+    const char *psz_input = p_cfg->ppsz_input[i_index];
+
+    if( strstr( psz_input, "://" ) == NULL )
+        return vlc_path2uri( psz_input, NULL );
+    return strdup( psz_input );
+}
+
+static bool vlm_ShareMatch( const vlm_share_sys_t *share, const char *psz_mrl,
+                            const vlm_media_t *p_cfg )
+{
+    if( strcmp( share->psz_mrl, psz_mrl ) ||
+        share->i_option != p_cfg->i_option )
+        return false;
+
+    for( int i = 0; i < share->i_option; i++ )
+    {
+        if( strcmp( share->ppsz_option[i], p_cfg->ppsz_option[i] ) )
+            return false;
+    }
+    return true;
+}
+
+static void vlm_ShareFree( vlm_share_sys_t *share )
+{
+    for( int i = 0; i < share->i_option; i++ )
+        free( share->ppsz_option[i] );
+    TAB_CLEAN( share->i_option, share->ppsz_option );
+    TAB_CLEAN( share->i_instance, share->instance );
+    free( share->psz_mrl );
+    free( share );
+}
+
+static vlm_share_sys_t *vlm_ShareNew( vlm_t *p_vlm, const char *psz_mrl,
+                                      const vlm_media_t *p_cfg )
+{
+    vlm_share_sys_t *share = calloc( 1, sizeof(*share) );
+    if( !share )
+        return NULL;
+
+    share->p_vlm = p_vlm;
+    TAB_INIT( share->i_option, share->ppsz_option );
+    TAB_INIT( share->i_instance, share->instance );
+
+    share->psz_mrl = strdup( psz_mrl );
+    if( !share->psz_mrl )
+        goto error;
+
+    for( int i = 0; i < p_cfg->i_option; i++ )
+    {
+        char *psz_option = strdup( p_cfg->ppsz_option[i] );
+        if( !psz_option )
+            goto error;
+        TAB_APPEND( share->i_option, share->ppsz_option, psz_option );
+    }
+
+    share->p_parent = vlc_object_create( p_vlm, sizeof (vlc_object_t) );
+    if( !share->p_parent )
+        goto error;
+
+    share->player = vlc_player_New( share->p_parent,
+                                    VLC_PLAYER_LOCK_NORMAL, NULL, NULL );
+    if( !share->player )
+        goto error;
+
+    static const struct vlc_player_cbs cbs = {
+        .on_state_changed = share_on_state_changed,
+    };
+    vlc_player_Lock( share->player );
+    share->listener = vlc_player_AddListener( share->player, &cbs, share );
+    vlc_player_Unlock( share->player );
+
+    if( !share->listener )
+        goto error;
+
+    TAB_APPEND( p_vlm->i_share, p_vlm->share, share );
+    return share;
+
+error:
+    if( share->player )
+        vlc_player_Delete( share->player );
+    if( share->p_parent )
+        vlc_object_delete( share->p_parent );
+    vlm_ShareFree( share );
+    return NULL;
+}
+
+static void vlm_ShareDelete( vlm_t *p_vlm, vlm_share_sys_t *share )
+{
+    vlc_player_Lock( share->player );
+    vlc_player_RemoveListener( share->player, share->listener );
+    vlc_player_Stop( share->player );
+    vlc_player_Unlock( share->player );
+    vlc_player_Delete( share->player );
+    vlc_object_delete( share->p_parent );
+
+    TAB_REMOVE( p_vlm->i_share, p_vlm->share, share );
+    vlm_ShareFree( share );
+}
+
+static char *vlm_ShareOutput( const vlm_share_sys_t *share )
+{
+    /* a single broadcast does not need the duplication */
+    if( share->i_instance == 1 )
+        return strdup( share->instance[0]->p_media->cfg.psz_output );
+
+    struct vlc_memstream stream;
+    vlc_memstream_open( &stream );
+    vlc_memstream_puts( &stream, "#duplicate{" );
+    for( int i = 0; i < share->i_instance; i++ )
+    {
+        const char *psz_output = share->instance[i]->p_media->cfg.psz_output;
+        if( *psz_output == '#' )
+            psz_output++;
+
+        char *psz_escaped = config_StringEscape( psz_output );
+        if( psz_escaped == NULL )
+            continue;
+        vlc_memstream_printf( &stream, "%sdst=\"%s\"", i > 0 ? "," : "",
+                              psz_escaped );
+        free( psz_escaped );
+    }
+    vlc_memstream_putc( &stream, '}' );
+
+    if( vlc_memstream_close( &stream ) )
+        return NULL;
+    return stream.ptr;
+}
+
+static int vlm_ShareStart( vlm_share_sys_t *share )
+{
+    input_item_t *p_item = input_item_New( share->psz_mrl, NULL );
+    if( !p_item )
+        return VLC_ENOMEM;
+
+    char *psz_output = vlm_ShareOutput( share );
+    if( psz_output != NULL )
+    {
+        char *psz_buffer;
+        if( asprintf( &psz_buffer, "sout=%s", psz_output ) != -1 )
+        {
+            input_item_AddOption( p_item, psz_buffer, VLC_INPUT_OPTION_TRUSTED );
+            free( psz_buffer );
+        }
+        free( psz_output );
+    }
+
+    for( int i = 0; i < share->i_option; i++ )
+        input_item_AddOption( p_item, share->ppsz_option[i], VLC_INPUT_OPTION_TRUSTED );
+
+    vlc_player_Lock( share->player );
+    if( vlc_player_GetCurrentMedia( share->player ) )
+        vlc_player_Stop( share->player );
+    vlc_player_SetCurrentMedia( share->player, p_item );
+    int i_ret = vlc_player_Start( share->player );
+    vlc_player_Unlock( share->player );
+
+    input_item_Release( p_item );
+    return i_ret;
+}
+
+static void vlm_ShareDetach( vlm_t *p_vlm, vlm_media_instance_sys_t *p_instance )
+{
+    vlm_share_sys_t *share = p_instance->share;
+
+    vlc_player_Lock( share->player );
+    TAB_REMOVE( share->i_instance, share->instance, p_instance );
+    bool b_started = vlc_player_IsStarted( share->player );
+    vlc_player_Unlock( share->player );
+
+    p_instance->share = NULL;
+    p_instance->player = p_instance->own_player;
+
+    if( share->i_instance == 0 )
+        vlm_ShareDelete( p_vlm, share );
+    else if( b_started )
+        vlm_ShareStart( share ); /* without the output of the instance */
+}
+
+static int vlm_ShareAttach( vlm_t *p_vlm, vlm_media_instance_sys_t *p_instance,
+                            const char *psz_mrl )
+{
+    vlm_media_sys_t *p_media = p_instance->p_media;
+    vlm_share_sys_t *share = NULL;
+
+    for( int i = 0; i < p_vlm->i_share; i++ )
+    {
+        if( vlm_ShareMatch( p_vlm->share[i], psz_mrl, &p_media->cfg ) )
+        {
+            share = p_vlm->share[i];
+            break;
+        }
+    }
+
+    if( share == NULL )
+    {
+        share = vlm_ShareNew( p_vlm, psz_mrl, &p_media->cfg );
+        if( share == NULL )
+            return VLC_ENOMEM;
+    }
+    else
+        msg_Dbg( p_vlm, "media %s shares the input %s with %d broadcast(s)",
+                 p_media->cfg.psz_name, psz_mrl, share->i_instance );
+
+    vlc_player_Lock( share->player );
+    TAB_APPEND( share->i_instance, share->instance, p_instance );
+    vlc_player_Unlock( share->player );
+
+    p_instance->share = share;
+    p_instance->player = share->player;
+
+    if( vlm_ShareStart( share ) )
+    {
+        vlm_ShareDetach( p_vlm, p_instance );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media, const char *psz_name )
 {
     vlm_media_instance_sys_t *p_instance = calloc( 1, sizeof(vlm_media_instance_sys_t) );
@@ -599,30 +858,33 @@ static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media,
         goto error;
 
     p_instance->i_index = 0;
+    p_instance->p_media = p_media;
+    p_instance->share = NULL;
     p_instance->p_parent = vlc_object_create( p_media, sizeof (vlc_object_t) );
     if (!p_instance->p_parent)
         goto error;
 
-    p_instance->player = vlc_player_New(p_instance->p_parent,
-                                        VLC_PLAYER_LOCK_NORMAL, NULL, NULL);
-    if (!p_instance->player)
+    p_instance->own_player = vlc_player_New(p_instance->p_parent,
+                                            VLC_PLAYER_LOCK_NORMAL, NULL, NULL);
+    if (!p_instance->own_player)
         goto error;
+    p_instance->player = p_instance->own_player;
 
     static struct vlc_player_cbs cbs = {
         .on_state_changed = player_on_state_changed,
     };
-    vlc_player_Lock(p_instance->player);
+    vlc_player_Lock(p_instance->own_player);
     p_instance->listener =
-        vlc_player_AddListener(p_instance->player, &cbs, p_media);
-    vlc_player_Unlock(p_instance->player);
+        vlc_player_AddListener(p_instance->own_player, &cbs, p_media);
+    vlc_player_Unlock(p_instance->own_player);
 
     if (!p_instance->listener)
         goto error;
     return p_instance;
 
 error:
-    if (p_instance->player)
-        vlc_player_Delete(p_instance->player);
+    if (p_instance->own_player)
+        vlc_player_Delete(p_instance->own_player);
     if (p_instance->p_parent)
         vlc_object_delete(p_instance->p_parent);
     if (p_instance->p_item)
@@ -633,12 +895,17 @@ error:
 }
 static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instance_sys_t *p_instance, vlm_media_sys_t *p_media )
 {
-    vlc_player_t *player = p_instance->player;
+    bool had_media = p_instance->share != NULL;
+    if( p_instance->share != NULL )
+        vlm_ShareDetach( p_vlm, p_instance );
+
+    vlc_player_t *player = p_instance->own_player;
 
     vlc_player_Lock(player);
     vlc_player_RemoveListener(player, p_instance->listener);
     vlc_player_Stop(player);
-    bool had_media = vlc_player_GetCurrentMedia(player);
+    if (vlc_player_GetCurrentMedia(player))
+        had_media = true;
     vlc_player_Unlock(player);
     vlc_player_Delete(player);
 
@@ -689,7 +956,25 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
     }
 
     /* Stop old instance */
-    vlc_player_t *player = p_instance->player;
+    if( p_instance->share != NULL )
+    {
+        vlc_player_t *player = p_instance->player;
+        vlc_player_Lock(player);
+        if( p_instance->i_index == i_input_index &&
+            vlc_player_GetCurrentMedia(player) )
+        {
+            if (vlc_player_IsPaused(player))
+                vlc_player_Resume(player);
+            vlc_player_Unlock(player);
+            return VLC_SUCCESS;
+        }
+        vlc_player_Unlock(player);
+
+        vlm_ShareDetach( p_vlm, p_instance );
+        vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
+    }
+
+    vlc_player_t *player = p_instance->own_player;
     vlc_player_Lock(player);
     if (vlc_player_GetCurrentMedia(player))
     {
@@ -697,6 +982,7 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
         {
             if (vlc_player_IsPaused(player))
                 vlc_player_Resume(player);
+            vlc_player_Unlock(player);
             return VLC_SUCCESS;
         }
 
@@ -708,15 +994,28 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
 
     /* Start new one */
     p_instance->i_index = i_input_index;
-    if( strstr( p_media->cfg.ppsz_input[p_instance->i_index], "://" ) == NULL )
+    char *psz_mrl = vlm_MediaInputMRL( &p_media->cfg, i_input_index );
+    if( psz_mrl == NULL )
     {
-        char *psz_uri = vlc_path2uri(
-                          p_media->cfg.ppsz_input[p_instance->i_index], NULL );
-        input_item_SetURI( p_instance->p_item, psz_uri ) ;
-        free( psz_uri );
+        vlc_player_Unlock(player);
+        return VLC_ENOMEM;
     }
-    else
-        input_item_SetURI( p_instance->p_item, p_media->cfg.ppsz_input[p_instance->i_index] ) ;
+
+    /* broadcasts with an output share the input of the same MRL */
+    if( p_media->cfg.psz_output != NULL )
+    {
+        vlc_player_Unlock(player);
+        int i_ret = vlm_ShareAttach( p_vlm, p_instance, psz_mrl );
+        free( psz_mrl );
+        if( i_ret )
+            return i_ret;
+
+        vlm_SendEventMediaInstanceStarted( p_vlm, id, p_media->cfg.psz_name );
+        return VLC_SUCCESS;
+    }
+
+    input_item_SetURI( p_instance->p_item, psz_mrl );
+    free( psz_mrl );
 
     vlc_player_SetCurrentMedia(player, p_instance->p_item);
     vlc_player_Start(player);
@@ -28,7 +28,7 @@
 #include "input_interface.h"
 
 /* Private */
-typedef struct
+typedef struct vlm_media_instance_sys_t
 {
     /* instance name */
     char *psz_name;
@@ -36,15 +36,20 @@ typedef struct
     /* "playlist" index */
     int i_index;
 
+    struct vlm_media_sys_t *p_media;
     vlc_object_t *p_parent;
     input_item_t      *p_item;
+    /* player of the instance, or of its shared input */
     vlc_player_t *player;
+    vlc_player_t *own_player;
     vlc_player_listener_id *listener;
 
+    /* shared input the instance is attached to, if any */
+    struct vlm_share_sys_t *share;
 } vlm_media_instance_sys_t;
 
 
-typedef struct
+typedef struct vlm_media_sys_t
 {
     struct vlc_object_t obj;
     vlm_media_t cfg;
@@ -54,6 +59,26 @@ typedef struct
     vlm_media_instance_sys_t **instance;
 } vlm_media_sys_t;
 
+/* Input opened once for all the broadcasts of the same MRL and options,
+ * its stream output duplicates the ES to all their outputs */
+typedef struct vlm_share_sys_t
+{
+    vlm_t *p_vlm;
+
+    char *psz_mrl;
+    int   i_option;
+    char **ppsz_option;
+
+    vlc_object_t *p_parent;
+    input_item_t *p_item;
+    vlc_player_t *player;
+    vlc_player_listener_id *listener;
+
+    /* attached broadcasts */
+    int                      i_instance;
+    vlm_media_instance_sys_t **instance;
+} vlm_share_sys_t;
+
 typedef struct
 {
     /* names "schedule" is reserved */
@@ -97,6 +122,10 @@ struct vlm_t
     /* Schedule list */
     int            i_schedule;
     vlm_schedule_sys_t **schedule;
+
+    /* Shared inputs */
+    int             i_share;
+    vlm_share_sys_t **share;
 };
 
 int vlm_ControlInternal( vlm_t *p_vlm, int i_query, ... );
@@ -46,6 +46,7 @@
 #include <vlc_player.h>
 
 #include "clock/clock.h"
+#include "clock/input_clock.h"
 
 static const char *const ppsz_snap_formats[] =
 { "png", "jpg", "tiff" };
@@ -89,6 +90,12 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Messages are formatted by the calling thread, but written to the log " \
+    "from a separate thread. This reduces the impact of verbose logging " \
+    "on timings. Messages are dropped if the log cannot keep up.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -125,6 +132,13 @@ static const char *const ppsz_snap_formats[] =
 #define ROLE_TEXT N_("Media role")
 #define ROLE_LONGTEXT N_("Media (player) role for operating system policy.")
 
+#define AUDIO_LATENCY_TEXT N_("Audio output latency (ms)")
+#define AUDIO_LATENCY_LONGTEXT N_( \
+    "Latency budget of the audio output, in milliseconds, for interactive " \
+    "uses. The audio output asks the device for buffers that short, and " \
+    "resynchronizes sooner. Short budgets may cause glitches on loaded " \
+    "systems. Zero keeps the default buffering, which favours robustness.")
+
 #define AUDIO_BITEXACT_TEXT N_("Enable bit-exact mode (pure mode)")
 #define AUDIO_BITEXACT_LONGTEXT N_( \
     "This will disable all audio filters, even audio converters. " \
@@ -401,6 +415,12 @@ static const char *const screensaver_texts[] = {
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define VIDEO_FILTER_FUSION_TEXT N_("Fuse per-pixel video filters")
+#define VIDEO_FILTER_FUSION_LONGTEXT N_( \
+    "Run consecutive video filters that only change pixels in place " \
+    "on each part of the picture before the next one, without " \
+    "intermediate pictures.")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -490,6 +510,13 @@ static const char *const screensaver_texts[] = {
     "This drops frames that are late (arrive to the video output after " \
     "their intended display date)." )
 
+#define VSYNC_PACING_TEXT N_("Pace frames on the display refresh")
+#define VSYNC_PACING_LONGTEXT N_( \
+    "When the video output reports when pictures reach the screen, this " \
+    "shows every picture on the refresh closest to its intended date, " \
+    "which avoids irregular judder when the frame rate does not match " \
+    "the refresh rate." )
+
 #define QUIET_SYNCHRO_TEXT N_("Quiet synchro")
 #define QUIET_SYNCHRO_LONGTEXT N_( \
     "This avoids flooding the message log with debug output from the " \
@@ -556,6 +583,22 @@ static const char *const ppsz_clock_master_descriptions[] = {
     N_("Monotonic")
 };
 
+#define CLOCK_RECOVERY_TEXT N_("Clock recovery")
+#define CLOCK_RECOVERY_LONGTEXT N_( \
+    "This selects how the drift between the stream clock and the system " \
+    "clock is estimated when the input pace cannot be controlled. The " \
+    "controller follows the drift more closely and rejects more of the " \
+    "network jitter than the average.")
+
+static const int pi_clock_recovery_values[] = {
+    INPUT_CLOCK_RECOVERY_AVERAGE,
+    INPUT_CLOCK_RECOVERY_PI,
+};
+static const char *const ppsz_clock_recovery_descriptions[] = {
+    N_("Average"),
+    N_("Controller")
+};
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -1108,6 +1151,19 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define PACKETIZER_THREAD_TEXT N_("Packetize video in a separate thread")
+#define PACKETIZER_THREAD_LONGTEXT N_( \
+    "Run the video packetizer of each decoder in its own thread, ahead of " \
+    "the decoder module. This helps high bitrate streams, whose frame " \
+    "assembly would otherwise delay the decoding.")
+
+#define BLOCK_POOL_TEXT N_("Recycle data blocks")
+#define BLOCK_POOL_LONGTEXT N_( \
+    "Keep the data blocks of the most common sizes in per thread caches " \
+    "for reuse, rather than freeing them. This reduces the memory " \
+    "allocator load when many streams are processed at once, at the " \
+    "expense of a higher memory usage.")
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1634,6 +1690,9 @@ vlc_module_begin ()
         change_short('A')
     add_string( "role", "video", ROLE_TEXT, ROLE_LONGTEXT, true )
         change_string_list( ppsz_roles, ppsz_roles_text )
+    add_integer( "audio-latency", 0, AUDIO_LATENCY_TEXT,
+                 AUDIO_LATENCY_LONGTEXT, true )
+        change_integer_range( 0, 1000 )
 
     set_subcategory( SUBCAT_AUDIO_AFILTER )
         add_bool( "audio-bitexact", false, AUDIO_BITEXACT_TEXT,
@@ -1667,6 +1726,8 @@ vlc_module_begin ()
         change_private ()
     add_bool( "drop-late-frames", 1, DROP_LATE_FRAMES_TEXT,
               DROP_LATE_FRAMES_LONGTEXT, true )
+    add_bool( "video-vsync-pacing", true, VSYNC_PACING_TEXT,
+              VSYNC_PACING_LONGTEXT, true )
     /* Used in vout_synchro */
     add_bool( "skip-frames", 1, SKIP_FRAMES_TEXT,
               SKIP_FRAMES_LONGTEXT, true )
@@ -1764,6 +1825,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list("video-filter", "video filter", NULL,
                     VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT)
+    add_bool( "video-filter-fusion", false, VIDEO_FILTER_FUSION_TEXT,
+              VIDEO_FILTER_FUSION_LONGTEXT, true )
 
 #if 0
     add_string( "pixel-ratio", "1", PIXEL_RATIO_TEXT, PIXEL_RATIO_TEXT )
@@ -2037,6 +2100,10 @@ vlc_module_begin ()
     add_integer( "clock-master", VLC_CLOCK_MASTER_DEFAULT,
                  CLOCK_MASTER_TEXT, NULL, true )
         change_integer_list( pi_clock_master_values, ppsz_clock_master_descriptions )
+    add_integer( "clock-recovery", INPUT_CLOCK_RECOVERY_DEFAULT,
+                 CLOCK_RECOVERY_TEXT, CLOCK_RECOVERY_LONGTEXT, true )
+        change_integer_list( pi_clock_recovery_values,
+                             ppsz_clock_recovery_descriptions )
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -2167,6 +2234,11 @@ vlc_module_begin ()
 
     set_section( N_("Performance options"), NULL )
 
+    add_bool( "block-pool", false, BLOCK_POOL_TEXT,
+              BLOCK_POOL_LONGTEXT, true )
+    add_bool( "packetizer-thread", false, PACKETIZER_THREAD_TEXT,
+              PACKETIZER_THREAD_LONGTEXT, true )
+
 #if defined (LIBVLC_USE_PTHREAD)
     add_bool( "rt-priority", false, RT_PRIORITY_TEXT,
               RT_PRIORITY_LONGTEXT, true )
@@ -2271,6 +2343,7 @@ vlc_module_begin ()
         change_short('v')
         change_volatile ()
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
         change_short('d')
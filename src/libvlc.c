@@ -219,6 +219,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         msg_Warn( p_libvlc, "memory keystore init failed" );
 
     vlc_CPU_dump( VLC_OBJECT(p_libvlc) );
+    vlc_block_pool_Init( p_libvlc );
 
     if( var_InheritBool( p_libvlc, "media-library") )
     {
@@ -441,6 +442,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    vlc_block_pool_Deinit( p_libvlc );
+
     vlc_LogDestroy(p_libvlc->obj.logger);
     /* Free module bank. It is refcounted, so we call this each time  */
     module_EndBank (true);
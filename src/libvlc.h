@@ -25,6 +25,7 @@
 # define LIBVLC_LIBVLC_H 1
 
 #include <vlc_input_item.h>
+#include <vlc_memstats.h>
 
 extern const char psz_vlc_changeset[];
 
@@ -39,6 +40,7 @@ void system_Configure ( libvlc_int_t *, int, const char *const [] );
 void system_End(void);
 #endif
 void vlc_CPU_dump(vlc_object_t *);
+unsigned vlc_CPU_mask(unsigned flags);
 
 /*
  * Threads subsystem
@@ -54,6 +56,20 @@ void vlc_threads_setup (libvlc_int_t *);
 void vlc_trace (const char *fn, const char *file, unsigned line);
 #define vlc_backtrace() vlc_trace(__func__, __FILE__, __LINE__)
 
+/*
+ * Block pool
+ */
+void vlc_block_pool_Init(libvlc_int_t *);
+void vlc_block_pool_Deinit(libvlc_int_t *);
+
+/*
+ * Memory accounting
+ * The pointers are only used as keys, the memory may be uninitialized.
+ */
+void vlc_memstats_Alloc(enum vlc_memstats_kind, void *ptr, size_t size,
+                        const void *caller);
+void vlc_memstats_Free(const void *ptr);
+
 /*
  * Logging
  */
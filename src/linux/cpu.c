@@ -26,6 +26,7 @@
 #include <string.h>
 #include <vlc_common.h>
 #include <vlc_cpu.h>
+#include "libvlc.h"
 
 #undef CPU_FLAGS
 #if defined (__arm__) || defined (__aarch64__)
@@ -120,7 +121,7 @@ static void vlc_CPU_init (void)
     if (all_caps == 0xFFFFFFFF) /* Error parsing of cpuinfo? */
         all_caps = 0; /* Do not assume any capability! */
 
-    cpu_flags = all_caps;
+    cpu_flags = vlc_CPU_mask(all_caps);
 }
 
 unsigned vlc_CPU (void)
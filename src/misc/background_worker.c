@@ -28,11 +28,27 @@
 #include "libvlc.h"
 #include "background_worker.h"
 
+/*
+ * Background workers share a process-wide pool of threads.
+ *
+ * A thread runs a single task at a time, from start to stop, and waits for
+ * its completion most of the time. When a pool thread is free, it takes the
+ * next task of the highest priority worker with queued tasks, workers of the
+ * same priority being served in turn. A worker never runs more than its
+ * max_threads tasks at once, and the whole pool is capped as well.
+ *
+ * All the state is protected by the single pool lock: background tasks are
+ * long, so that it is never contended.
+ */
+
+#define POOL_IDLE_TIMEOUT VLC_TICK_FROM_SEC(5)
+
 struct task {
     struct vlc_list node;
     void* id; /**< id associated with entity */
     void* entity; /**< the entity to process */
     vlc_tick_t timeout; /**< timeout duration in vlc_tick_t */
+    vlc_tick_t date; /**< date the task was queued at */
 };
 
 struct background_worker;
@@ -50,19 +66,42 @@ struct background_worker {
     void* owner;
     struct background_worker_config conf;
 
-    vlc_mutex_t lock;
-
-    int uncompleted; /**< number of tasks requested but not completed */
     int nthreads; /**< number of threads in the threads list */
     struct vlc_list threads; /**< list of active background_thread instances */
 
     struct vlc_list queue; /**< queue of tasks */
-    vlc_cond_t queue_wait; /**< wait for the queue to be non-empty */
+    bool ready; /**< true if in the pool list of workers to serve */
+    struct vlc_list node; /**< node in the pool list of workers to serve */
 
     vlc_cond_t nothreads_wait; /**< wait for nthreads == 0 */
     bool closing; /**< true if background worker deletion is requested */
+
+    struct {
+        unsigned tasks; /**< number of started tasks */
+        vlc_tick_t total; /**< total queue latency */
+        vlc_tick_t max; /**< maximum queue latency */
+    } latency;
 };
 
+static struct {
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /**< wait for a worker to serve */
+    struct vlc_list workers; /**< workers to serve, by decreasing priority */
+    unsigned nthreads; /**< number of threads */
+    unsigned idle; /**< number of threads waiting for a worker to serve */
+    unsigned wakeups; /**< number of signaled threads not woken up yet */
+} pool = {
+    VLC_STATIC_MUTEX,
+    VLC_STATIC_COND,
+    VLC_LIST_INITIALIZER(&pool.workers),
+    0, 0, 0,
+};
+
+static unsigned PoolMaxThreads(void)
+{
+    return __MAX(vlc_GetCPUCount(), 4);
+}
+
 static struct task *task_Create(struct background_worker *worker, void *id,
                                 void *entity, int timeout)
 {
@@ -73,6 +112,7 @@ static struct task *task_Create(struct background_worker *worker, void *id,
     task->id = id;
     task->entity = entity;
     task->timeout = timeout < 0 ? worker->conf.default_timeout : VLC_TICK_FROM_MS(timeout);
+    task->date = vlc_tick_now();
     worker->conf.pf_hold(task->entity);
     return task;
 }
@@ -83,17 +123,88 @@ static void task_Destroy(struct background_worker *worker, struct task *task)
     free(task);
 }
 
-static struct task *QueueTake(struct background_worker *worker, int timeout_ms)
+/**
+ * Adds or removes a worker from the pool list of workers to serve.
+ *
+ * A worker already in the list is moved after the other workers of the same
+ * priority, so that they are served in turn.
+ */
+static void PoolUpdateWorker(struct background_worker *worker)
+{
+    vlc_mutex_assert(&pool.lock);
+
+    if (worker->ready)
+    {
+        vlc_list_remove(&worker->node);
+        worker->ready = false;
+    }
+
+    if (worker->closing || vlc_list_is_empty(&worker->queue)
+     || worker->nthreads >= worker->conf.max_threads)
+        return;
+
+    struct background_worker *it;
+    vlc_list_foreach(it, &pool.workers, node)
+    {
+        if (it->conf.priority < worker->conf.priority)
+        {
+            vlc_list_add_before(&worker->node, &it->node);
+            worker->ready = true;
+            return;
+        }
+    }
+    vlc_list_append(&worker->node, &pool.workers);
+    worker->ready = true;
+}
+
+static void *Thread(void *data);
+
+/**
+ * Wakes up or spawns a thread to serve the queued tasks.
+ */
+static void PoolWakeup(void)
+{
+    vlc_mutex_assert(&pool.lock);
+
+    if (pool.idle > pool.wakeups)
+    {
+        pool.wakeups++;
+        vlc_cond_signal(&pool.wait);
+        return;
+    }
+
+    if (pool.nthreads >= PoolMaxThreads())
+        return; /* a busy thread will take it when done */
+
+    if (vlc_clone_detach(NULL, Thread, NULL, VLC_THREAD_PRIORITY_LOW) == 0)
+        pool.nthreads++;
+}
+
+/**
+ * Waits for a worker with queued tasks, and takes its first task.
+ *
+ * \return the task, owned by the caller, or NULL after the idle timeout
+ */
+static struct task *PoolTakeTask(struct background_worker **pworker)
 {
-    vlc_mutex_assert(&worker->lock);
+    vlc_mutex_assert(&pool.lock);
 
-    vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_MS(timeout_ms);
+    vlc_tick_t deadline = vlc_tick_now() + POOL_IDLE_TIMEOUT;
     bool timeout = false;
-    while (!timeout && !worker->closing && vlc_list_is_empty(&worker->queue))
-        timeout = vlc_cond_timedwait(&worker->queue_wait,
-                                     &worker->lock, deadline) != 0;
 
-    if (worker->closing || timeout)
+    pool.idle++;
+    while (!timeout && vlc_list_is_empty(&pool.workers))
+    {
+        timeout = vlc_cond_timedwait(&pool.wait, &pool.lock, deadline) != 0;
+        if (pool.wakeups > 0)
+            pool.wakeups--;
+    }
+    pool.idle--;
+
+    struct background_worker *worker =
+        vlc_list_first_entry_or_null(&pool.workers, struct background_worker,
+                                     node);
+    if (worker == NULL)
         return NULL;
 
     struct task *task = vlc_list_first_entry_or_null(&worker->queue,
@@ -101,19 +212,19 @@ static struct task *QueueTake(struct background_worker *worker, int timeout_ms)
     assert(task);
     vlc_list_remove(&task->node);
 
-    return task;
-}
+    vlc_tick_t latency = vlc_tick_now() - task->date;
+    worker->latency.tasks++;
+    worker->latency.total += latency;
+    if (latency > worker->latency.max)
+        worker->latency.max = latency;
 
-static void QueuePush(struct background_worker *worker, struct task *task)
-{
-    vlc_mutex_assert(&worker->lock);
-    vlc_list_append(&task->node, &worker->queue);
-    vlc_cond_signal(&worker->queue_wait);
+    *pworker = worker;
+    return task;
 }
 
 static void QueueRemoveAll(struct background_worker *worker, void *id)
 {
-    vlc_mutex_assert(&worker->lock);
+    vlc_mutex_assert(&pool.lock);
     struct task *task;
     vlc_list_foreach(task, &worker->queue, node)
     {
@@ -125,26 +236,6 @@ static void QueueRemoveAll(struct background_worker *worker, void *id)
     }
 }
 
-static struct background_thread *
-background_thread_Create(struct background_worker *owner)
-{
-    struct background_thread *thread = malloc(sizeof(*thread));
-    if (!thread)
-        return NULL;
-
-    vlc_cond_init(&thread->probe_cancel_wait);
-    thread->probe = false;
-    thread->cancel = false;
-    thread->task = NULL;
-    thread->owner = owner;
-    return thread;
-}
-
-static void background_thread_Destroy(struct background_thread *thread)
-{
-    free(thread);
-}
-
 static struct background_worker *background_worker_Create(void *owner,
                                          struct background_worker_config *conf)
 {
@@ -155,131 +246,122 @@ static struct background_worker *background_worker_Create(void *owner,
     worker->conf = *conf;
     worker->owner = owner;
 
-    vlc_mutex_init(&worker->lock);
-    worker->uncompleted = 0;
     worker->nthreads = 0;
     vlc_list_init(&worker->threads);
     vlc_list_init(&worker->queue);
-    vlc_cond_init(&worker->queue_wait);
+    worker->ready = false;
     vlc_cond_init(&worker->nothreads_wait);
     worker->closing = false;
+    worker->latency.tasks = 0;
+    worker->latency.total = 0;
+    worker->latency.max = 0;
     return worker;
 }
 
 static void background_worker_Destroy(struct background_worker *worker)
 {
+    if (worker->conf.obj != NULL && worker->latency.tasks > 0)
+        msg_Dbg(worker->conf.obj, "background tasks: %u, queue latency: "
+                "%"PRId64" ms average, %"PRId64" ms max",
+                worker->latency.tasks,
+                MS_FROM_VLC_TICK(worker->latency.total / worker->latency.tasks),
+                MS_FROM_VLC_TICK(worker->latency.max));
     free(worker);
 }
 
-static void TerminateTask(struct background_thread *thread, struct task *task)
-{
-    struct background_worker *worker = thread->owner;
-
-    vlc_mutex_lock(&worker->lock);
-    thread->task = NULL;
-    worker->uncompleted--;
-    assert(worker->uncompleted >= 0);
-    vlc_mutex_unlock(&worker->lock);
-
-    task_Destroy(worker, task);
-}
-
-static void RemoveThread(struct background_thread *thread)
+/**
+ * Runs a task until it completes, times out or gets canceled.
+ *
+ * This is called, and returns, with the pool lock held.
+ */
+static void RunTask(struct background_thread *thread)
 {
     struct background_worker *worker = thread->owner;
+    struct task *task = thread->task;
 
-    vlc_mutex_lock(&worker->lock);
+    vlc_tick_t deadline;
+    if (task->timeout > 0)
+        deadline = vlc_tick_now() + task->timeout;
+    else
+        deadline = INT64_MAX; /* no deadline */
+    vlc_mutex_unlock(&pool.lock);
 
-    vlc_list_remove(&thread->node);
-    worker->nthreads--;
-    assert(worker->nthreads >= 0);
-    if (!worker->nthreads)
-        vlc_cond_signal(&worker->nothreads_wait);
+    void *handle;
+    if (worker->conf.pf_start(worker->owner, task->entity, &handle))
+    {
+        vlc_mutex_lock(&pool.lock);
+        return;
+    }
 
-    vlc_mutex_unlock(&worker->lock);
+    for (;;)
+    {
+        vlc_mutex_lock(&pool.lock);
+        bool timeout = false;
+        while (!timeout && !thread->probe && !thread->cancel)
+            /* any non-zero return value means timeout */
+            timeout = vlc_cond_timedwait(&thread->probe_cancel_wait,
+                                         &pool.lock, deadline) != 0;
+
+        bool cancel = thread->cancel;
+        thread->cancel = false;
+        thread->probe = false;
+        vlc_mutex_unlock(&pool.lock);
 
-    background_thread_Destroy(thread);
+        if (timeout || cancel
+                || worker->conf.pf_probe(worker->owner, handle))
+        {
+            worker->conf.pf_stop(worker->owner, handle);
+            vlc_mutex_lock(&pool.lock);
+            return;
+        }
+    }
 }
 
 static void* Thread( void* data )
 {
-    struct background_thread *thread = data;
-    struct background_worker *worker = thread->owner;
+    VLC_UNUSED(data);
 
+    vlc_mutex_lock(&pool.lock);
     for (;;)
     {
-        vlc_mutex_lock(&worker->lock);
-        struct task *task = QueueTake(worker, 5000);
+        struct background_worker *worker;
+        struct task *task = PoolTakeTask(&worker);
         if (!task)
-        {
-            vlc_mutex_unlock(&worker->lock);
             /* terminate this thread */
             break;
-        }
 
-        thread->task = task;
-        thread->cancel = false;
-        thread->probe = false;
-        vlc_tick_t deadline;
-        if (task->timeout > 0)
-            deadline = vlc_tick_now() + task->timeout;
-        else
-            deadline = INT64_MAX; /* no deadline */
-        vlc_mutex_unlock(&worker->lock);
-
-        void *handle;
-        if (worker->conf.pf_start(worker->owner, task->entity, &handle))
-        {
-            TerminateTask(thread, task);
-            continue;
-        }
-
-        for (;;)
-        {
-            vlc_mutex_lock(&worker->lock);
-            bool timeout = false;
-            while (!timeout && !thread->probe && !thread->cancel)
-                /* any non-zero return value means timeout */
-                timeout = vlc_cond_timedwait(&thread->probe_cancel_wait,
-                                             &worker->lock, deadline) != 0;
-
-            bool cancel = thread->cancel;
-            thread->cancel = false;
-            thread->probe = false;
-            vlc_mutex_unlock(&worker->lock);
-
-            if (timeout || cancel
-                    || worker->conf.pf_probe(worker->owner, handle))
-            {
-                worker->conf.pf_stop(worker->owner, handle);
-                TerminateTask(thread, task);
-                break;
-            }
-        }
-    }
+        struct background_thread thread = {
+            .owner = worker,
+            .probe = false,
+            .cancel = false,
+            .task = task,
+        };
+        vlc_cond_init(&thread.probe_cancel_wait);
 
-    RemoveThread(thread);
+        worker->nthreads++;
+        vlc_list_append(&thread.node, &worker->threads);
+        PoolUpdateWorker(worker);
 
-    return NULL;
-}
+        RunTask(&thread);
 
-static bool SpawnThread(struct background_worker *worker)
-{
-    vlc_mutex_assert(&worker->lock);
+        thread.task = NULL;
+        vlc_list_remove(&thread.node);
+        vlc_mutex_unlock(&pool.lock);
 
-    struct background_thread *thread = background_thread_Create(worker);
-    if (!thread)
-        return false;
+        task_Destroy(worker, task);
 
-    if (vlc_clone_detach(NULL, Thread, thread, VLC_THREAD_PRIORITY_LOW))
-    {
-        free(thread);
-        return false;
+        vlc_mutex_lock(&pool.lock);
+        worker->nthreads--;
+        assert(worker->nthreads >= 0);
+        if (!worker->nthreads)
+            vlc_cond_signal(&worker->nothreads_wait);
+        PoolUpdateWorker(worker);
     }
-    worker->nthreads++;
-    vlc_list_append(&thread->node, &worker->threads);
 
-    return true;
+    pool.nthreads--;
+    vlc_mutex_unlock(&pool.lock);
+
+    return NULL;
 }
 
 struct background_worker* background_worker_New( void* owner,
@@ -295,12 +377,17 @@ int background_worker_Push( struct background_worker* worker, void* entity,
     if (unlikely(!task))
         return VLC_ENOMEM;
 
-    vlc_mutex_lock(&worker->lock);
-    QueuePush(worker, task);
-    if (++worker->uncompleted > worker->nthreads
-            && worker->nthreads < worker->conf.max_threads)
-        SpawnThread(worker);
-    vlc_mutex_unlock(&worker->lock);
+    vlc_mutex_lock(&pool.lock);
+    vlc_list_append(&task->node, &worker->queue);
+    if (!worker->ready)
+    {
+        PoolUpdateWorker(worker);
+        if (worker->ready)
+            PoolWakeup();
+    }
+    else
+        PoolWakeup();
+    vlc_mutex_unlock(&pool.lock);
 
     return VLC_SUCCESS;
 }
@@ -308,9 +395,10 @@ int background_worker_Push( struct background_worker* worker, void* entity,
 static void BackgroundWorkerCancelLocked(struct background_worker *worker,
                                          void *id)
 {
-    vlc_mutex_assert(&worker->lock);
+    vlc_mutex_assert(&pool.lock);
 
     QueueRemoveAll(worker, id);
+    PoolUpdateWorker(worker);
 
     struct background_thread *thread;
     vlc_list_foreach(thread, &worker->threads, node)
@@ -325,14 +413,14 @@ static void BackgroundWorkerCancelLocked(struct background_worker *worker,
 
 void background_worker_Cancel( struct background_worker* worker, void* id )
 {
-    vlc_mutex_lock(&worker->lock);
+    vlc_mutex_lock(&pool.lock);
     BackgroundWorkerCancelLocked(worker, id);
-    vlc_mutex_unlock(&worker->lock);
+    vlc_mutex_unlock(&pool.lock);
 }
 
 void background_worker_RequestProbe( struct background_worker* worker )
 {
-    vlc_mutex_lock(&worker->lock);
+    vlc_mutex_lock(&pool.lock);
 
     struct background_thread *thread;
     vlc_list_foreach(thread, &worker->threads, node)
@@ -341,22 +429,21 @@ void background_worker_RequestProbe( struct background_worker* worker )
         vlc_cond_signal(&thread->probe_cancel_wait);
     }
 
-    vlc_mutex_unlock(&worker->lock);
+    vlc_mutex_unlock(&pool.lock);
 }
 
 void background_worker_Delete( struct background_worker* worker )
 {
-    vlc_mutex_lock(&worker->lock);
+    vlc_mutex_lock(&pool.lock);
 
     worker->closing = true;
     BackgroundWorkerCancelLocked(worker, NULL);
-    /* closing is now true, this will wake up any QueueTake() */
-    vlc_cond_broadcast(&worker->queue_wait);
+    assert(!worker->ready);
 
     while (worker->nthreads)
-        vlc_cond_wait(&worker->nothreads_wait, &worker->lock);
+        vlc_cond_wait(&worker->nothreads_wait, &pool.lock);
 
-    vlc_mutex_unlock(&worker->lock);
+    vlc_mutex_unlock(&pool.lock);
 
     /* no threads use the worker anymore, we can destroy it */
     background_worker_Destroy(worker);
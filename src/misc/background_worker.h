@@ -31,9 +31,25 @@ struct background_worker_config {
 
     /**
      * Maximum number of threads used to execute tasks.
+     *
+     * Threads are shared by all the background-workers, with an overall
+     * limit, so fewer threads may actually be available.
      */
     int max_threads;
 
+    /**
+     * Scheduling priority of the tasks
+     *
+     * When all the shared threads are busy, pending tasks of the workers with
+     * the highest priority are started first. The default is 0.
+     */
+    int priority;
+
+    /**
+     * Object used to log statistics (queue latency), or NULL
+     */
+    vlc_object_t *obj;
+
     /**
      * Release an entity
      *
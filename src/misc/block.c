@@ -30,10 +30,12 @@
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include "../libvlc.h"
 
 #ifndef NDEBUG
 static void block_Check (block_t *block)
@@ -105,6 +107,322 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/* 2 * BLOCK_PADDING: pre + post padding */
+#define BLOCK_ALLOC_SIZE(size) \
+    (sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING) + (size))
+
+/*
+ * Block pool: recycles the blocks of the most common sizes, so that packet
+ * rate allocations mostly avoid the general purpose allocator. Blocks are
+ * cached per thread, and the caches exchange them by batches with a shared
+ * depot. It is enabled with the "block-pool" option.
+ */
+static const size_t block_pool_sizes[] = { 188, 1316, 4096, 65536, 1048576 };
+#define BLOCK_POOL_CLASSES ARRAY_SIZE(block_pool_sizes)
+/* Blocks kept per class in each thread cache, and in the depot */
+static const unsigned block_pool_cache_max[] = { 256, 256, 64, 16, 4 };
+static const unsigned block_pool_depot_max[] = { 4096, 4096, 1024, 64, 16 };
+/* Allocations before a thread cache updates the statistics */
+#define BLOCK_POOL_STATS_PERIOD 256
+
+struct block_pool_class
+{
+    vlc_mutex_t lock;
+    block_t *depot;
+    unsigned depot_count;
+    atomic_uint_fast64_t allocs;
+    atomic_uint_fast64_t hits;
+    atomic_int retained; /* blocks kept in the depot and the caches */
+};
+
+struct block_pool_cache
+{
+    block_t *blocks[BLOCK_POOL_CLASSES];
+    unsigned count[BLOCK_POOL_CLASSES];
+    /* Statistics not yet accounted in the classes */
+    unsigned allocs[BLOCK_POOL_CLASSES];
+    unsigned hits[BLOCK_POOL_CLASSES];
+    int retained[BLOCK_POOL_CLASSES];
+    unsigned pending;
+};
+
+#define BLOCK_POOL_CLASS_INIT { .lock = VLC_STATIC_MUTEX }
+
+static struct
+{
+    vlc_mutex_t lock; /* protects users and key_created */
+    unsigned users;
+    bool key_created;
+    vlc_threadvar_t key;
+    atomic_bool enabled;
+    struct block_pool_class classes[BLOCK_POOL_CLASSES];
+} block_pool =
+{
+    .lock = VLC_STATIC_MUTEX,
+    .classes = {
+        BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT,
+        BLOCK_POOL_CLASS_INIT, BLOCK_POOL_CLASS_INIT,
+    },
+};
+
+static_assert (ARRAY_SIZE(block_pool_cache_max) == BLOCK_POOL_CLASSES
+            && ARRAY_SIZE(block_pool_depot_max) == BLOCK_POOL_CLASSES,
+               "block pool classes mismatch");
+
+static void block_pool_Flush(struct block_pool_cache *cache)
+{
+    for (size_t i = 0; i < BLOCK_POOL_CLASSES; i++)
+    {
+        struct block_pool_class *class = &block_pool.classes[i];
+
+        atomic_fetch_add_explicit(&class->allocs, cache->allocs[i],
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&class->hits, cache->hits[i],
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&class->retained, cache->retained[i],
+                                  memory_order_relaxed);
+        cache->allocs[i] = cache->hits[i] = 0;
+        cache->retained[i] = 0;
+    }
+    cache->pending = 0;
+}
+
+/* Moves blocks from a thread cache to the depot, down to keep blocks */
+static void block_pool_Spill(struct block_pool_cache *cache, size_t i,
+                             unsigned keep)
+{
+    struct block_pool_class *class = &block_pool.classes[i];
+    bool enabled = atomic_load_explicit(&block_pool.enabled,
+                                        memory_order_relaxed);
+
+    vlc_mutex_lock(&class->lock);
+    while (cache->count[i] > keep)
+    {
+        block_t *b = cache->blocks[i];
+
+        cache->blocks[i] = b->p_next;
+        cache->count[i]--;
+
+        if (enabled && class->depot_count < block_pool_depot_max[i])
+        {
+            b->p_next = class->depot;
+            class->depot = b;
+            class->depot_count++;
+        }
+        else
+        {
+            cache->retained[i]--;
+            free(b);
+        }
+    }
+    vlc_mutex_unlock(&class->lock);
+}
+
+static void block_pool_ThreadExit(void *data)
+{
+    struct block_pool_cache *cache = data;
+
+    for (size_t i = 0; i < BLOCK_POOL_CLASSES; i++)
+        block_pool_Spill(cache, i, 0);
+    block_pool_Flush(cache);
+    free(cache);
+}
+
+static struct block_pool_cache *block_pool_GetCache(void)
+{
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool.key);
+
+    if (unlikely(cache == NULL))
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (unlikely(cache == NULL))
+            return NULL;
+        if (vlc_threadvar_set(block_pool.key, cache))
+        {
+            free(cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+static size_t block_pool_GetClass(size_t size)
+{
+    for (size_t i = 0; i < BLOCK_POOL_CLASSES; i++)
+        if (size <= block_pool_sizes[i])
+        {
+            /* Do not waste more than half of the large blocks */
+            if (block_pool_sizes[i] > 4096 && size < block_pool_sizes[i] / 2)
+                break;
+            return i;
+        }
+    return BLOCK_POOL_CLASSES;
+}
+
+static void block_pool_Release(block_t *block)
+{
+    assert (block->p_start == (unsigned char *)(block + 1));
+
+    size_t i = 0;
+    while (block->i_size != BLOCK_ALLOC_SIZE(block_pool_sizes[i])
+                          - sizeof (*block))
+        i++;
+    assert (i < BLOCK_POOL_CLASSES);
+
+    struct block_pool_cache *cache = NULL;
+    if (atomic_load_explicit(&block_pool.enabled, memory_order_relaxed))
+        cache = block_pool_GetCache();
+    if (cache == NULL)
+    {
+        free(block);
+        return;
+    }
+
+    if (cache->count[i] >= block_pool_cache_max[i])
+        block_pool_Spill(cache, i, block_pool_cache_max[i] / 2);
+
+    block->p_next = cache->blocks[i];
+    cache->blocks[i] = block;
+    cache->count[i]++;
+    cache->retained[i]++;
+}
+
+static const struct vlc_block_callbacks block_pool_cbs =
+{
+    block_pool_Release,
+};
+
+static block_t *block_pool_Alloc(size_t size)
+{
+    size_t i = block_pool_GetClass(size);
+    if (i >= BLOCK_POOL_CLASSES)
+        return NULL;
+
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    if (cache->blocks[i] == NULL)
+    {   /* Refill the cache from the depot */
+        struct block_pool_class *class = &block_pool.classes[i];
+
+        vlc_mutex_lock(&class->lock);
+        while (class->depot != NULL
+            && cache->count[i] < block_pool_cache_max[i] / 2)
+        {
+            block_t *b = class->depot;
+
+            class->depot = b->p_next;
+            class->depot_count--;
+            b->p_next = cache->blocks[i];
+            cache->blocks[i] = b;
+            cache->count[i]++;
+        }
+        vlc_mutex_unlock(&class->lock);
+    }
+
+    block_t *b = cache->blocks[i];
+    if (b != NULL)
+    {
+        cache->blocks[i] = b->p_next;
+        cache->count[i]--;
+        cache->retained[i]--;
+        cache->hits[i]++;
+    }
+    else
+    {
+        b = malloc(BLOCK_ALLOC_SIZE(block_pool_sizes[i]));
+        if (unlikely(b == NULL))
+            return NULL;
+    }
+
+    cache->allocs[i]++;
+    if (++cache->pending >= BLOCK_POOL_STATS_PERIOD)
+        block_pool_Flush(cache);
+
+    return block_Init(b, &block_pool_cbs, b + 1,
+                      BLOCK_ALLOC_SIZE(block_pool_sizes[i]) - sizeof (*b));
+}
+
+void vlc_block_pool_Init(libvlc_int_t *libvlc)
+{
+    if (!var_InheritBool(libvlc, "block-pool"))
+        return;
+
+    vlc_mutex_lock(&block_pool.lock);
+    if (!block_pool.key_created)
+    {   /* The key is kept, as cached blocks can outlive the instances */
+        if (vlc_threadvar_create(&block_pool.key, block_pool_ThreadExit))
+        {
+            vlc_mutex_unlock(&block_pool.lock);
+            msg_Err(libvlc, "cannot create the block pool");
+            return;
+        }
+        block_pool.key_created = true;
+    }
+    if (block_pool.users++ == 0)
+        atomic_store_explicit(&block_pool.enabled, true, memory_order_relaxed);
+    vlc_mutex_unlock(&block_pool.lock);
+    msg_Dbg(libvlc, "block pool enabled");
+}
+
+void vlc_block_pool_Deinit(libvlc_int_t *libvlc)
+{
+    if (!var_InheritBool(libvlc, "block-pool"))
+        return;
+
+    vlc_mutex_lock(&block_pool.lock);
+    if (block_pool.users == 0)
+    {   /* the pool could not be enabled */
+        vlc_mutex_unlock(&block_pool.lock);
+        return;
+    }
+
+    /* Account for the calling thread at least */
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool.key);
+    if (cache != NULL)
+        block_pool_Flush(cache);
+
+    bool last = --block_pool.users == 0;
+    if (last)
+        atomic_store_explicit(&block_pool.enabled, false, memory_order_relaxed);
+
+    for (size_t i = 0; i < BLOCK_POOL_CLASSES; i++)
+    {
+        struct block_pool_class *class = &block_pool.classes[i];
+        uint_fast64_t allocs = atomic_load_explicit(&class->allocs,
+                                                    memory_order_relaxed);
+        uint_fast64_t hits = atomic_load_explicit(&class->hits,
+                                                  memory_order_relaxed);
+
+        vlc_mutex_lock(&class->lock);
+        if (last)
+        {   /* Blocks left in thread caches are freed as the threads exit */
+            while (class->depot != NULL)
+            {
+                block_t *b = class->depot;
+
+                class->depot = b->p_next;
+                free(b);
+                atomic_fetch_sub_explicit(&class->retained, 1,
+                                          memory_order_relaxed);
+            }
+            class->depot_count = 0;
+        }
+        vlc_mutex_unlock(&class->lock);
+
+        int retained = atomic_load_explicit(&class->retained,
+                                            memory_order_relaxed);
+        if (allocs > 0)
+            msg_Dbg(libvlc, "block pool: %zu bytes blocks: %"PRIuFAST64
+                    " allocations, %.1f%% from the pool, %zu KiB retained",
+                    block_pool_sizes[i], allocs, 100. * hits / allocs,
+                    (retained > 0 ? retained : 0)
+                    * BLOCK_ALLOC_SIZE(block_pool_sizes[i]) / 1024);
+    }
+    vlc_mutex_unlock(&block_pool.lock);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -113,22 +431,28 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
-    /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
+    const size_t alloc = BLOCK_ALLOC_SIZE(size);
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    block_t *b = NULL;
+    if (atomic_load_explicit(&block_pool.enabled, memory_order_relaxed))
+        b = block_pool_Alloc(size);
+    if (b == NULL)
+    {
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+        block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    }
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
     b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
     b->i_buffer = size;
+    vlc_memstats_Alloc(VLC_MEMSTATS_BLOCK, b, b->i_size,
+                       __builtin_return_address(0));
     return b;
 }
 
@@ -138,6 +462,7 @@ void block_Release(block_t *block)
     block->p_next = NULL;
     block_Check (block);
 #endif
+    vlc_memstats_Free(block);
     block->cbs->free(block);
 }
 
@@ -263,6 +588,92 @@ block_t *block_heap_Alloc (void *addr, size_t length)
     return block_Init(block, &block_heap_cbs, addr, length);
 }
 
+struct block_shared
+{
+    block_t self;
+    block_t *block; /**< Underlying block, owning the data */
+    atomic_uintptr_t refs;
+};
+
+struct block_view
+{
+    block_t self;
+    struct block_shared *shared;
+};
+
+static void block_shared_Unref(struct block_shared *shared)
+{
+    if (atomic_fetch_sub_explicit(&shared->refs, 1,
+                                  memory_order_release) != 1)
+        return;
+
+    atomic_thread_fence(memory_order_acquire);
+    block_Release(shared->block);
+    free(shared);
+}
+
+static void block_shared_Release(block_t *block)
+{
+    block_shared_Unref(container_of(block, struct block_shared, self));
+}
+
+static const struct vlc_block_callbacks block_shared_cbs =
+{
+    block_shared_Release,
+};
+
+static void block_view_Release(block_t *block)
+{
+    struct block_view *view = container_of(block, struct block_view, self);
+
+    block_shared_Unref(view->shared);
+    free(view);
+}
+
+static const struct vlc_block_callbacks block_view_cbs =
+{
+    block_view_Release,
+};
+
+block_t *block_Share(block_t *block)
+{
+    block_Check(block);
+
+    if (block->cbs == &block_shared_cbs)
+        return block;
+
+    struct block_shared *shared = malloc(sizeof (*shared));
+    if (unlikely(shared == NULL))
+        return NULL;
+
+    block_t *self = block_Init(&shared->self, &block_shared_cbs,
+                               block->p_start, block->i_size);
+    self->p_buffer = block->p_buffer;
+    self->i_buffer = block->i_buffer;
+    BlockMetaCopy(self, block);
+    shared->block = block;
+    atomic_init(&shared->refs, 1);
+    return self;
+}
+
+block_t *block_View(block_t *block, size_t offset, size_t length)
+{
+    block_Check(block);
+    assert(block->cbs == &block_shared_cbs);
+    assert(offset <= block->i_buffer && length <= block->i_buffer - offset);
+
+    struct block_shared *shared = container_of(block, struct block_shared,
+                                               self);
+    struct block_view *view = malloc(sizeof (*view));
+    if (unlikely(view == NULL))
+        return NULL;
+
+    atomic_fetch_add_explicit(&shared->refs, 1, memory_order_relaxed);
+    view->shared = shared;
+    return block_Init(&view->self, &block_view_cbs,
+                      block->p_buffer + offset, length);
+}
+
 #ifdef HAVE_MMAP
 # include <sys/mman.h>
 
@@ -57,6 +57,65 @@
 
 static uint32_t cpu_flags;
 
+static const struct
+{
+    char name[8];
+    unsigned flag;
+} cpu_flag_names[] = {
+#if defined (__i386__) || defined (__x86_64__)
+    { "mmx", VLC_CPU_MMX },
+    { "3dnow", VLC_CPU_3dNOW },
+    { "mmxext", VLC_CPU_MMXEXT },
+    { "sse", VLC_CPU_SSE },
+    { "sse2", VLC_CPU_SSE2 },
+    { "sse3", VLC_CPU_SSE3 },
+    { "ssse3", VLC_CPU_SSSE3 },
+    { "sse4.1", VLC_CPU_SSE4_1 },
+    { "sse4.2", VLC_CPU_SSE4_2 },
+    { "sse4a", VLC_CPU_SSE4A },
+    { "avx", VLC_CPU_AVX },
+    { "avx2", VLC_CPU_AVX2 },
+    { "xop", VLC_CPU_XOP },
+    { "fma4", VLC_CPU_FMA4 },
+#elif defined (__powerpc__) || defined (__ppc__) || defined (__ppc64__)
+    { "altivec", VLC_CPU_ALTIVEC },
+#elif defined (__arm__)
+    { "armv6", VLC_CPU_ARMv6 },
+    { "neon", VLC_CPU_ARM_NEON },
+#elif defined (__aarch64__)
+    { "neon", VLC_CPU_ARM_NEON },
+    { "sve", VLC_CPU_ARM_SVE },
+#endif
+};
+
+/**
+ * Restricts detected CPU features to those listed in the VLC_CPU_FLAGS
+ * environment variable, if set. This is meant for testing and benchmarking
+ * the less optimized code paths.
+ */
+unsigned vlc_CPU_mask(unsigned flags)
+{
+    const char *env = getenv("VLC_CPU_FLAGS");
+    if (env == NULL)
+        return flags;
+
+    unsigned mask = 0;
+
+    while (*env)
+    {
+        size_t len = strcspn(env, ", ");
+
+        for (size_t i = 0; i < ARRAY_SIZE(cpu_flag_names); i++)
+            if (strlen(cpu_flag_names[i].name) == len
+             && !strncmp(cpu_flag_names[i].name, env, len))
+                mask |= cpu_flag_names[i].flag;
+
+        env += len;
+        env += strspn(env, ", ");
+    }
+    return flags & mask;
+}
+
 #if defined (__i386__) || defined (__x86_64__) || defined (__powerpc__) \
  || defined (__ppc__) || defined (__ppc64__) || defined (__powerpc64__)
 # if defined (HAVE_FORK)
@@ -249,7 +308,7 @@ out:
 
 #endif
 
-    cpu_flags = i_capabilities;
+    cpu_flags = vlc_CPU_mask(i_capabilities);
 }
 
 /**
@@ -262,6 +321,17 @@ VLC_WEAK unsigned vlc_CPU(void)
     return cpu_flags;
 }
 
+const struct vlc_cpu_impl *vlc_CPU_select(const struct vlc_cpu_impl *impls,
+                                          size_t count)
+{
+    unsigned flags = vlc_CPU();
+
+    for (size_t i = 0; i < count; i++)
+        if ((impls[i].flags & ~flags) == 0)
+            return &impls[i];
+    return NULL;
+}
+
 void vlc_CPU_dump (vlc_object_t *obj)
 {
     struct vlc_memstream stream;
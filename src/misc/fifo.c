@@ -26,6 +26,7 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -34,6 +35,11 @@
 
 /**
  * Internal state for block queues
+ *
+ * block_FifoPut() does not take the lock: it pushes the blocks on the
+ * incoming stack, which is moved to the locked queue by the next
+ * vlc_fifo_Lock() or wait. The producer then only needs the lock to wake a
+ * consumer up, if one is waiting.
  */
 struct block_fifo_t
 {
@@ -44,11 +50,48 @@ struct block_fifo_t
     block_t             **pp_last;
     size_t              i_depth;
     size_t              i_size;
+
+    _Atomic(block_t *)  incoming; /**< Lock-free blocks, in reverse order */
+    atomic_uint         waiters; /**< Threads in vlc_fifo_Wait() */
 };
 
+/**
+ * Moves the lock-free blocks to the queue.
+ */
+static void vlc_fifo_Collect(vlc_fifo_t *fifo)
+{
+    vlc_mutex_assert(&fifo->lock);
+
+    if (atomic_load_explicit(&fifo->incoming, memory_order_relaxed) == NULL)
+        return;
+
+    block_t *block = atomic_exchange_explicit(&fifo->incoming, NULL,
+                                              memory_order_acquire);
+    block_t *chain = NULL;
+
+    /* Restore the queuing order */
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = chain;
+        chain = block;
+        block = next;
+    }
+
+    *(fifo->pp_last) = chain;
+    for (; chain != NULL; chain = chain->p_next)
+    {
+        fifo->pp_last = &chain->p_next;
+        fifo->i_depth++;
+        fifo->i_size += chain->i_buffer;
+    }
+}
+
 void vlc_fifo_Lock(vlc_fifo_t *fifo)
 {
     vlc_mutex_lock(&fifo->lock);
+    vlc_fifo_Collect(fifo);
 }
 
 void vlc_fifo_Unlock(vlc_fifo_t *fifo)
@@ -63,17 +106,26 @@ void vlc_fifo_Signal(vlc_fifo_t *fifo)
 
 void vlc_fifo_Wait(vlc_fifo_t *fifo)
 {
-    vlc_fifo_WaitCond(fifo, &fifo->wait);
+    /* The waiter must be visible before checking for lock-free blocks,
+     * see block_FifoPut(). */
+    atomic_fetch_add(&fifo->waiters, 1);
+    if (atomic_load(&fifo->incoming) == NULL)
+        vlc_cond_wait(&fifo->wait, &fifo->lock);
+    atomic_fetch_sub_explicit(&fifo->waiters, 1, memory_order_relaxed);
+    vlc_fifo_Collect(fifo);
 }
 
 void vlc_fifo_WaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar)
 {
     vlc_cond_wait(condvar, &fifo->lock);
+    vlc_fifo_Collect(fifo);
 }
 
 int vlc_fifo_TimedWaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar, vlc_tick_t deadline)
 {
-    return vlc_cond_timedwait(condvar, &fifo->lock, deadline);
+    int ret = vlc_cond_timedwait(condvar, &fifo->lock, deadline);
+    vlc_fifo_Collect(fifo);
+    return ret;
 }
 
 size_t vlc_fifo_GetCount(const vlc_fifo_t *fifo)
@@ -104,7 +156,9 @@ void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
         block = block->p_next;
     }
 
-    vlc_fifo_Signal(fifo);
+    /* Waiters are counted under the lock */
+    if (atomic_load_explicit(&fifo->waiters, memory_order_relaxed) > 0)
+        vlc_fifo_Signal(fifo);
 }
 
 block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
@@ -154,12 +208,16 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->p_first = NULL;
     p_fifo->pp_last = &p_fifo->p_first;
     p_fifo->i_depth = p_fifo->i_size = 0;
+    atomic_init( &p_fifo->incoming, NULL );
+    atomic_init( &p_fifo->waiters, 0 );
 
     return p_fifo;
 }
 
 void block_FifoRelease( block_fifo_t *p_fifo )
 {
+    /* the order does not matter */
+    block_ChainRelease( atomic_load( &p_fifo->incoming ) );
     block_ChainRelease( p_fifo->p_first );
     free( p_fifo );
 }
@@ -176,9 +234,37 @@ void block_FifoEmpty(block_fifo_t *fifo)
 
 void block_FifoPut(block_fifo_t *fifo, block_t *block)
 {
-    vlc_fifo_Lock(fifo);
-    vlc_fifo_QueueUnlocked(fifo, block);
-    vlc_fifo_Unlock(fifo);
+    if (block == NULL)
+        return;
+
+    /* Reverse the chain, the consumer reverses it back */
+    block_t *first = block, *chain = NULL;
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = chain;
+        chain = block;
+        block = next;
+    }
+
+    block_t *head = atomic_load_explicit(&fifo->incoming,
+                                         memory_order_relaxed);
+    do
+        first->p_next = head;
+    while (!atomic_compare_exchange_weak_explicit(&fifo->incoming, &head,
+                                                  chain, memory_order_release,
+                                                  memory_order_relaxed));
+
+    /* Pairs with vlc_fifo_Wait(): either the consumer sees the blocks before
+     * sleeping, or it is seen waiting here. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&fifo->waiters, memory_order_relaxed) > 0)
+    {
+        vlc_mutex_lock(&fifo->lock);
+        vlc_fifo_Signal(fifo);
+        vlc_mutex_unlock(&fifo->lock);
+    }
 }
 
 block_t *block_FifoGet(block_fifo_t *fifo)
@@ -204,10 +290,10 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
 {
     block_t *b;
 
-    vlc_mutex_lock( &p_fifo->lock );
+    vlc_fifo_Lock( p_fifo );
     assert(p_fifo->p_first != NULL);
     b = p_fifo->p_first;
-    vlc_mutex_unlock( &p_fifo->lock );
+    vlc_fifo_Unlock( p_fifo );
 
     return b;
 }
@@ -217,9 +303,9 @@ size_t block_FifoSize (block_fifo_t *fifo)
 {
     size_t size;
 
-    vlc_mutex_lock (&fifo->lock);
+    vlc_fifo_Lock (fifo);
     size = fifo->i_size;
-    vlc_mutex_unlock (&fifo->lock);
+    vlc_fifo_Unlock (fifo);
     return size;
 }
 
@@ -228,8 +314,8 @@ size_t block_FifoCount (block_fifo_t *fifo)
 {
     size_t depth;
 
-    vlc_mutex_lock (&fifo->lock);
+    vlc_fifo_Lock (fifo);
     depth = fifo->i_depth;
-    vlc_mutex_unlock (&fifo->lock);
+    vlc_fifo_Unlock (fifo);
     return depth;
 }
@@ -29,6 +29,7 @@
 #include <vlc_common.h>
 #include <libvlc.h>
 #include <vlc_filter.h>
+#include <vlc_list.h>
 #include <vlc_modules.h>
 #include "../misc/variables.h"
 
@@ -210,3 +211,160 @@ void video_splitter_Delete( video_splitter_t *p_splitter )
     vlc_object_delete(p_splitter);
 }
 
+
+/*
+ * Slices of the video filters are run by a process-wide pool of threads,
+ * along with the threads waiting for them.
+ *
+ * A filter thread queues its picture as a job, wakes up as many threads as
+ * there are other slices, and processes slices of its own job until there
+ * are none left. The pool threads take the slices of the first queued job.
+ * Idle threads exit after a while, so that the pool only exists while
+ * pictures are filtered.
+ */
+
+#define SLICES_IDLE_TIMEOUT VLC_TICK_FROM_SEC(5)
+#define SLICES_MIN_LINES 16
+#define SLICES_MAX 16
+
+struct filter_slices_job
+{
+    struct vlc_list node; /**< node in the list of jobs, if slices are left */
+    filter_t *filter;
+    filter_slice_cb cb;
+    void *data;
+    unsigned next; /**< next slice to process */
+    unsigned count; /**< number of slices */
+    unsigned pending; /**< number of slices not processed yet */
+    vlc_cond_t done; /**< wait for pending == 0 */
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /**< wait for a job */
+    struct vlc_list jobs; /**< jobs with slices left to take */
+    unsigned nthreads; /**< number of threads */
+    unsigned idle; /**< number of threads waiting for a job */
+    unsigned wakeups; /**< number of signaled threads not woken up yet */
+} slices = {
+    VLC_STATIC_MUTEX,
+    VLC_STATIC_COND,
+    VLC_LIST_INITIALIZER(&slices.jobs),
+    0, 0, 0,
+};
+
+static unsigned SlicesMaxCount(void)
+{
+    return __MIN(vlc_GetCPUCount(), SLICES_MAX);
+}
+
+/**
+ * Processes the next slice of a job.
+ *
+ * This is called, and returns, with the pool lock held.
+ */
+static void SlicesRunNext(struct filter_slices_job *job)
+{
+    vlc_mutex_assert(&slices.lock);
+    assert(job->next < job->count);
+
+    const unsigned slice = job->next++;
+    if (job->next == job->count)
+        vlc_list_remove(&job->node);
+
+    vlc_mutex_unlock(&slices.lock);
+    job->cb(job->filter, job->data, slice, job->count);
+    vlc_mutex_lock(&slices.lock);
+
+    /* The job is gone as soon as the lock is released */
+    if (--job->pending == 0)
+        vlc_cond_signal(&job->done);
+}
+
+static void *SlicesThread(void *data)
+{
+    VLC_UNUSED(data);
+
+    vlc_mutex_lock(&slices.lock);
+    for (;;)
+    {
+        vlc_tick_t deadline = vlc_tick_now() + SLICES_IDLE_TIMEOUT;
+        bool timeout = false;
+
+        slices.idle++;
+        while (!timeout && vlc_list_is_empty(&slices.jobs))
+        {
+            timeout = vlc_cond_timedwait(&slices.wait, &slices.lock,
+                                         deadline) != 0;
+            if (slices.wakeups > 0)
+                slices.wakeups--;
+        }
+        slices.idle--;
+
+        struct filter_slices_job *job =
+            vlc_list_first_entry_or_null(&slices.jobs,
+                                         struct filter_slices_job, node);
+        if (job == NULL)
+            break;
+
+        SlicesRunNext(job);
+    }
+    slices.nthreads--;
+    vlc_mutex_unlock(&slices.lock);
+    return NULL;
+}
+
+/**
+ * Wakes up or spawns threads for count slices.
+ */
+static void SlicesWakeup(unsigned count)
+{
+    vlc_mutex_assert(&slices.lock);
+
+    for (; count > 0 && slices.idle > slices.wakeups; count--)
+    {
+        slices.wakeups++;
+        vlc_cond_signal(&slices.wait);
+    }
+
+    /* The calling threads process slices too */
+    for (; count > 0 && slices.nthreads + 1 < SlicesMaxCount(); count--)
+    {
+        if (vlc_clone_detach(NULL, SlicesThread, NULL,
+                             VLC_THREAD_PRIORITY_VIDEO))
+            break; /* the calling thread takes the slices left */
+        slices.nthreads++;
+    }
+}
+
+void filter_RunSlices(filter_t *filter, unsigned lines, filter_slice_cb cb,
+                      void *data)
+{
+    const unsigned count = __MIN(SlicesMaxCount(), lines / SLICES_MIN_LINES);
+    if (count <= 1)
+    {
+        cb(filter, data, 0, 1);
+        return;
+    }
+
+    struct filter_slices_job job = {
+        .filter = filter,
+        .cb = cb,
+        .data = data,
+        .next = 0,
+        .count = count,
+        .pending = count,
+    };
+    vlc_cond_init(&job.done);
+
+    vlc_mutex_lock(&slices.lock);
+    vlc_list_append(&job.node, &slices.jobs);
+    SlicesWakeup(count - 1);
+
+    while (job.next < job.count)
+        SlicesRunNext(&job);
+    while (job.pending > 0)
+        vlc_cond_wait(&job.done, &slices.lock);
+    vlc_mutex_unlock(&slices.lock);
+}
@@ -56,6 +56,7 @@ struct filter_chain_t
     bool b_allow_fmt_out_change; /**< Each filter can change the output */
     const char *filter_cap; /**< Filter modules capability */
     const char *conv_cap; /**< Converter modules capability */
+    bool b_fusion; /**< Fuse the filters processing slices */
 };
 
 /**
@@ -83,6 +84,7 @@ static filter_chain_t *filter_chain_NewInner( vlc_object_t *obj,
     chain->b_allow_fmt_out_change = fmt_out_change;
     chain->filter_cap = cap;
     chain->conv_cap = conv_cap;
+    chain->b_fusion = false;
     return chain;
 }
 
@@ -157,6 +159,7 @@ filter_chain_t *filter_chain_NewVideo( vlc_object_t *obj, bool allow_change,
     }
     else
         chain->parent_video_owner = (filter_owner_t){};
+    chain->b_fusion = var_InheritBool( obj, "video-filter-fusion" );
     return chain;
 }
 
@@ -422,12 +425,115 @@ vlc_video_context *filter_chain_GetVideoCtxOut(const filter_chain_t *p_chain)
     return p_chain->vctx_in;
 }
 
+/* Fused filters run on tiles of about that size, counting the source and
+ * destination, so that the tiles stay in the cache from a filter to the next */
+#define FUSION_TILE_SIZE (128 * 1024)
+#define FUSION_TILE_MIN_LINES 8
+
+static bool FilterCanFuse( const chained_filter_t *f )
+{
+    const filter_t *filter = &f->filter;
+    return filter->pf_video_filter_slice != NULL
+        && video_format_IsSimilar( &filter->fmt_in.video,
+                                   &filter->fmt_out.video );
+}
+
+/**
+ * Gets the last filter of the fused filters starting with f.
+ *
+ * \return the last filter, or NULL if less than two filters can be fused
+ */
+static chained_filter_t *FilterChainFusedLast( chained_filter_t *f )
+{
+    const filter_chain_t *chain = f->filter.owner.sys;
+    if( !chain->b_fusion || !FilterCanFuse( f ) )
+        return NULL;
+
+    chained_filter_t *last = NULL;
+    for( chained_filter_t *next = f->next;
+         next != NULL && FilterCanFuse( next ); next = next->next )
+        last = next;
+    return last;
+}
+
+struct fused_job
+{
+    chained_filter_t *first, *last;
+    picture_t *dst;
+    const picture_t *src;
+    size_t size; /**< bytes of the source and destination planes */
+    unsigned lines;
+};
+
+static void FusedSlice( filter_t *filter, void *data,
+                        unsigned slice, unsigned slices )
+{
+    VLC_UNUSED(filter);
+    const struct fused_job *job = data;
+    unsigned tiles = __MIN( job->size / slices / FUSION_TILE_SIZE,
+                            job->lines / slices / FUSION_TILE_MIN_LINES );
+    if( tiles == 0 )
+        tiles = 1;
+
+    /* The slice is made of its tiles in a division in slices * tiles */
+    for( unsigned tile = slice * tiles; tile < (slice + 1) * tiles; tile++ )
+    {
+        const picture_t *src = job->src;
+        for( chained_filter_t *f = job->first; ; f = f->next )
+        {
+            f->filter.pf_video_filter_slice( &f->filter, job->dst, src,
+                                             tile, slices * tiles );
+            if( f == job->last )
+                break;
+            src = job->dst;
+        }
+    }
+}
+
+static picture_t *FilterChainFusedFilter( chained_filter_t *first,
+                                          chained_filter_t *last,
+                                          picture_t *p_pic )
+{
+    picture_t *p_outpic = filter_NewPicture( &last->filter );
+    if( p_outpic == NULL )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    struct fused_job job = {
+        .first = first,
+        .last = last,
+        .dst = p_outpic,
+        .src = p_pic,
+        .size = 0,
+        .lines = p_pic->p[0].i_visible_lines,
+    };
+    for( int i = 0; i < p_pic->i_planes; i++ )
+        job.size += 2 * (size_t)p_pic->p[i].i_pitch
+                  * p_pic->p[i].i_visible_lines;
+
+    filter_RunSlices( &first->filter, job.lines, FusedSlice, &job );
+
+    picture_CopyProperties( p_outpic, p_pic );
+    picture_Release( p_pic );
+    return p_outpic;
+}
+
 static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic )
 {
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
-        p_pic = p_filter->pf_video_filter( p_filter, p_pic );
+        chained_filter_t *last = FilterChainFusedLast( f );
+        if( last != NULL )
+        {
+            p_pic = FilterChainFusedFilter( f, last, p_pic );
+            f = last;
+            p_filter = &f->filter;
+        }
+        else
+            p_pic = p_filter->pf_video_filter( p_filter, p_pic );
         if( !p_pic )
             break;
         if( f->pending )
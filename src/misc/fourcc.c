@@ -35,57 +35,44 @@
 
 #include "fourcc_tables.h"
 
-static int fourcc_cmp(const void *key, const void *ent)
-{
-    return memcmp(key, ent, 4);
-}
-
+/* Finds the entry of a FourCC or alias in the generated hash table */
 static vlc_fourcc_t Lookup(vlc_fourcc_t fourcc, const char **restrict dsc,
-                           const struct fourcc_mapping *mapv, size_t mapc,
-                           const struct fourcc_desc *dscv, size_t dscc)
+                           const struct fourcc_hash *hash)
 {
-    const struct fourcc_mapping *mapping;
-    const struct fourcc_desc *desc;
+    /* the key only depends on the bytes, like in fourcc_gen */
+    size_t mask = (1u << (32 - hash->shift)) - 1;
+    size_t slot = (GetDWLE(&fourcc) * hash->mult) >> hash->shift;
 
-    mapping = bsearch(&fourcc, mapv, mapc, sizeof (*mapv), fourcc_cmp);
-    if (mapping != NULL)
+    for (unsigned i = 0; i < hash->probes; i++)
     {
-        if (dsc != NULL)
+        uint16_t idx = hash->slots[(slot + i) & mask];
+        if (idx == 0)
+            break;
+
+        const struct fourcc_entry *entry = &hash->entries[idx - 1];
+        if (entry->alias == fourcc)
         {
-            desc = bsearch(&fourcc, dscv, dscc, sizeof (*dscv), fourcc_cmp);
-            if (desc != NULL)
-            {
-                *dsc = desc->desc;
-                return mapping->fourcc;
-            }
+            if (dsc != NULL)
+                *dsc = entry->desc;
+            return entry->fourcc;
         }
-        fourcc = mapping->fourcc;
     }
-
-    desc = bsearch(&fourcc, dscv, dscc, sizeof (*dscv), fourcc_cmp);
-    if (desc == NULL)
-        return 0; /* Unknown FourCC */
-    if (dsc != NULL)
-        *dsc = desc->desc;
-    return fourcc; /* Known FourCC (has a description) */
+    return 0; /* Unknown FourCC */
 }
 
 static vlc_fourcc_t LookupVideo(vlc_fourcc_t fourcc, const char **restrict dsc)
 {
-    return Lookup(fourcc, dsc, mapping_video, ARRAY_SIZE(mapping_video),
-                  desc_video, ARRAY_SIZE(desc_video));
+    return Lookup(fourcc, dsc, &hash_video);
 }
 
 static vlc_fourcc_t LookupAudio(vlc_fourcc_t fourcc, const char **restrict dsc)
 {
-    return Lookup(fourcc, dsc, mapping_audio, ARRAY_SIZE(mapping_audio),
-                  desc_audio, ARRAY_SIZE(desc_audio));
+    return Lookup(fourcc, dsc, &hash_audio);
 }
 
 static vlc_fourcc_t LookupSpu(vlc_fourcc_t fourcc, const char **restrict dsc)
 {
-    return Lookup(fourcc, dsc, mapping_spu, ARRAY_SIZE(mapping_spu),
-                  desc_spu, ARRAY_SIZE(desc_spu));
+    return Lookup(fourcc, dsc, &hash_spu);
 }
 
 static vlc_fourcc_t LookupCat(vlc_fourcc_t fourcc, const char **restrict dsc,
@@ -844,16 +831,58 @@ static const struct
 #undef PLANAR_8
 #undef PLANAR
 
-const vlc_chroma_description_t *vlc_fourcc_GetChromaDescription( vlc_fourcc_t i_fourcc )
+/* Hash table of the chroma descriptions, built on first use */
+#define CHROMA_HASH_BITS 10
+
+static struct
+{
+    vlc_fourcc_t fourcc; /* 0 if the slot is empty */
+    uint16_t     index;
+} chroma_hash[1 << CHROMA_HASH_BITS];
+
+static_assert(ARRAY_SIZE(p_list_chroma_description) * 4 <= (1 << CHROMA_HASH_BITS) / 2,
+              "chroma hash table too small");
+
+static size_t ChromaHashSlot( vlc_fourcc_t i_fourcc )
+{
+    return (uint32_t)(i_fourcc * UINT32_C(0x9E3779B1)) >> (32 - CHROMA_HASH_BITS);
+}
+
+static void ChromaHashInit( void )
 {
     for( unsigned i = 0; p_list_chroma_description[i].p_fourcc[0]; i++ )
     {
         const vlc_fourcc_t *p_fourcc = p_list_chroma_description[i].p_fourcc;
         for( unsigned j = 0; j < 4 && p_fourcc[j] != 0; j++ )
         {
-            if( p_fourcc[j] == i_fourcc )
-                return &p_list_chroma_description[i].description;
+            size_t slot = ChromaHashSlot( p_fourcc[j] );
+
+            while( chroma_hash[slot].fourcc != 0 && chroma_hash[slot].fourcc != p_fourcc[j] )
+                slot = (slot + 1) & ((1 << CHROMA_HASH_BITS) - 1);
+            /* the first description of a chroma wins */
+            if( chroma_hash[slot].fourcc == 0 )
+            {
+                chroma_hash[slot].fourcc = p_fourcc[j];
+                chroma_hash[slot].index = i;
+            }
         }
     }
+}
+
+const vlc_chroma_description_t *vlc_fourcc_GetChromaDescription( vlc_fourcc_t i_fourcc )
+{
+    static vlc_once_t once = VLC_STATIC_ONCE;
+
+    if( i_fourcc == 0 )
+        return NULL;
+
+    vlc_once( &once, ChromaHashInit );
+
+    for( size_t slot = ChromaHashSlot( i_fourcc ); chroma_hash[slot].fourcc != 0;
+         slot = (slot + 1) & ((1 << CHROMA_HASH_BITS) - 1) )
+    {
+        if( chroma_hash[slot].fourcc == i_fourcc )
+            return &p_list_chroma_description[chroma_hash[slot].index].description;
+    }
     return NULL;
 }
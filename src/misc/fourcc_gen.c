@@ -21,6 +21,8 @@
 /* DO NOT include "config.h" here */
 
 #include <assert.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -53,6 +55,7 @@ struct entry
     char fourcc[4];
     char alias[4];
     const char *desc;
+    bool klass;
 };
 
 static int cmp_entry(const void *a, const void *b)
@@ -61,9 +64,20 @@ static int cmp_entry(const void *a, const void *b)
     int d = memcmp(ea->alias, eb->alias, 4);
     if (d == 0)
         d = memcmp(ea->fourcc, eb->fourcc, 4);
+    if (d == 0) /* the description of an alias is more specific */
+        d = ea->klass - eb->klass;
     return d;
 }
 
+/* Same key as the lookup, whatever the byte order of the build machine */
+static uint32_t fourcc_key(const char fourcc[4])
+{
+    return (uint32_t)(unsigned char)fourcc[0]
+         | ((uint32_t)(unsigned char)fourcc[1] << 8)
+         | ((uint32_t)(unsigned char)fourcc[2] << 16)
+         | ((uint32_t)(unsigned char)fourcc[3] << 24);
+}
+
 static void process_list(const char *name, const staticentry_t *list, size_t n)
 {
     struct entry *entries = malloc(sizeof (*entries) * n);
@@ -87,6 +101,7 @@ static void process_list(const char *name, const staticentry_t *list, size_t n)
         memcpy(entries[i].fourcc, klass->fourcc, 4);
         memcpy(entries[i].alias, list[i].fourcc, 4);
         entries[i].desc = list[i].description;
+        entries[i].klass = list[i].klass;
     }
 
     qsort(entries, n, sizeof (*entries), cmp_entry);
@@ -105,44 +120,114 @@ static void process_list(const char *name, const staticentry_t *list, size_t n)
     if (dups > 0)
         exit(1);
 
-    printf("static const struct fourcc_mapping mapping_%s[] = {\n", name);
+    /* One entry per alias, with the description of the alias, or else the
+     * description of its class. FourCCs without any are unknown. */
+    size_t m = 0;
     for (size_t i = 0; i < n; i++)
     {
-        if (!memcmp(entries[i].fourcc, entries[i].alias, 4))
+        if (m > 0 && !memcmp(entries[m - 1].alias, entries[i].alias, 4))
+        {
+            if (entries[m - 1].desc == NULL)
+                entries[m - 1].desc = entries[i].desc;
             continue;
-        printf("    { { { 0x%02hhx, 0x%02hhx, 0x%02hhx, 0x%02hhx } }, "
-               "{ { 0x%02hhx, 0x%02hhx, 0x%02hhx, 0x%02hhx } } },\n",
-               entries[i].alias[0], entries[i].alias[1], entries[i].alias[2],
-               entries[i].alias[3], entries[i].fourcc[0], entries[i].fourcc[1],
-               entries[i].fourcc[2], entries[i].fourcc[3]);
+        }
+        entries[m++] = entries[i];
     }
-    puts("};");
-    printf("static const struct fourcc_desc desc_%s[] = {\n", name);
-    for (size_t i = 0; i < n; i++)
+
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; entries[i].desc == NULL && j < m; j++)
+            if (!memcmp(entries[j].alias, entries[i].fourcc, 4))
+                entries[i].desc = entries[j].desc;
+
+    size_t k = 0;
+    for (size_t i = 0; i < m; i++)
+        if (entries[i].desc != NULL)
+            entries[k++] = entries[i];
+
+    /* Open addressing hash table, at most half full, with the multiplier
+     * giving the shortest probe sequences */
+    unsigned bits = 1;
+    while ((1u << bits) < 2 * k)
+        bits++;
+
+    size_t size = 1u << bits;
+    uint16_t *slots = malloc(sizeof (*slots) * size);
+    uint16_t *best = malloc(sizeof (*best) * size);
+    if (slots == NULL || best == NULL)
+        abort();
+
+    uint32_t best_mult = 0, seed = 0x9E3779B1;
+    unsigned best_probes = UINT_MAX;
+
+    for (unsigned tries = 0; tries < 20000 && best_probes > 1; tries++)
     {
-        if (entries[i].desc == NULL)
-            continue;
-        printf("    { { { 0x%02hhx, 0x%02hhx, 0x%02hhx, 0x%02hhx } }, "
-               "\"%s\" },\n", entries[i].alias[0], entries[i].alias[1],
-               entries[i].alias[2], entries[i].alias[3], entries[i].desc);
+        uint32_t mult = seed | 1;
+        unsigned probes = 0;
+
+        seed = seed * 1664525 + 1013904223;
+        memset(slots, 0, sizeof (*slots) * size);
+
+        for (size_t i = 0; i < k; i++)
+        {
+            size_t slot = (fourcc_key(entries[i].alias) * mult) >> (32 - bits);
+            unsigned len = 1;
+
+            while (slots[slot] != 0)
+            {
+                slot = (slot + 1) & (size - 1);
+                len++;
+            }
+            slots[slot] = i + 1;
+            if (len > probes)
+                probes = len;
+        }
+
+        if (probes < best_probes)
+        {
+            best_probes = probes;
+            best_mult = mult;
+            memcpy(best, slots, sizeof (*slots) * size);
+        }
     }
-    puts("};");
 
+    printf("static const struct fourcc_entry entries_%s[] = {\n", name);
+    for (size_t i = 0; i < k; i++)
+        printf("    { { { 0x%02hhx, 0x%02hhx, 0x%02hhx, 0x%02hhx } }, "
+               "{ { 0x%02hhx, 0x%02hhx, 0x%02hhx, 0x%02hhx } }, \"%s\" },\n",
+               entries[i].alias[0], entries[i].alias[1], entries[i].alias[2],
+               entries[i].alias[3], entries[i].fourcc[0], entries[i].fourcc[1],
+               entries[i].fourcc[2], entries[i].fourcc[3], entries[i].desc);
+    puts("};");
+    printf("static const uint16_t slots_%s[%zu] = {", name, size);
+    for (size_t i = 0; i < size; i++)
+        printf("%s%"PRIu16",", (i % 16) ? " " : "\n    ", best[i]);
+    puts("\n};");
+    printf("static const struct fourcc_hash hash_%s = {\n"
+           "    entries_%s, slots_%s, 0x%08"PRIx32"u, %u, %u,\n};\n",
+           name, name, name, best_mult, 32 - bits, best_probes);
+
+    free(best);
+    free(slots);
     free(entries);
-    fprintf(stderr, "%s: %zu entries\n", name, n);
+    fprintf(stderr, "%s: %zu entries, %u probe(s) at most\n", name, k,
+            best_probes);
 }
 
 int main(void)
 {
     puts("/* This file is generated automatically. DO NOT EDIT! */");
-    puts("struct fourcc_mapping {");
+    puts("struct fourcc_entry {");
     puts("    union { unsigned char alias_str[4]; vlc_fourcc_t alias; };");
     puts("    union { unsigned char fourcc_str[4]; vlc_fourcc_t fourcc; };");
-    puts("};");
-    puts("struct fourcc_desc {");
-    puts("    union { unsigned char alias_str[4]; vlc_fourcc_t alias; };");
     puts("    const char desc[52];");
     puts("};");
+    puts("struct fourcc_hash {");
+    puts("    const struct fourcc_entry *entries;");
+    puts("    const uint16_t *slots; /* entry index + 1, 0 if empty */");
+    puts("    uint32_t mult;");
+    puts("    unsigned shift;");
+    puts("    unsigned probes; /* longest probe sequence */");
+    puts("};");
 
 #define p(t) \
     process_list(#t, p_list_##t, \
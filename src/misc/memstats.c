@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * memstats.c: memory accounting
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_DLADDR
+# include <dlfcn.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_memstats.h>
+#include "../libvlc.h"
+
+#define MEMSTATS_SITE_BUCKETS 256
+#define MEMSTATS_LIVE_BUCKETS 4096
+
+struct memstats_site
+{
+    struct memstats_site *next;
+    enum vlc_memstats_kind kind;
+    const void *caller;
+
+    size_t live_bytes;
+    size_t live_count;
+    uint64_t total_bytes;
+    uint64_t total_count;
+    /* totals at the previous snapshot, for the rates */
+    uint64_t last_bytes;
+    uint64_t last_count;
+};
+
+struct memstats_live
+{
+    struct memstats_live *next;
+    const void *ptr;
+    size_t size;
+    struct memstats_site *site;
+};
+
+enum
+{
+    MEMSTATS_UNKNOWN,
+    MEMSTATS_DISABLED,
+    MEMSTATS_ENABLED,
+};
+
+static struct
+{
+    atomic_uint state;
+
+    vlc_mutex_t lock;
+    vlc_tick_t last_date;
+    struct memstats_site *sites[MEMSTATS_SITE_BUCKETS];
+    struct memstats_live *live[MEMSTATS_LIVE_BUCKETS];
+} memstats = {
+    .state = ATOMIC_VAR_INIT(MEMSTATS_UNKNOWN),
+    .lock = VLC_STATIC_MUTEX,
+    .last_date = VLC_TICK_INVALID,
+};
+
+static bool vlc_memstats_Enabled(void)
+{
+    unsigned state = atomic_load_explicit(&memstats.state,
+                                          memory_order_relaxed);
+
+    if (likely(state != MEMSTATS_UNKNOWN))
+        return state == MEMSTATS_ENABLED;
+
+    /* Concurrent initializations reach the same result. */
+    const char *env = getenv("VLC_MEMSTATS");
+    state = (env != NULL && atoi(env) != 0) ? MEMSTATS_ENABLED
+                                            : MEMSTATS_DISABLED;
+    atomic_store_explicit(&memstats.state, state, memory_order_relaxed);
+    return state == MEMSTATS_ENABLED;
+}
+
+static size_t memstats_hash(const void *ptr, size_t buckets)
+{
+    uint64_t v = (uintptr_t)ptr;
+
+    /* Allocations are aligned, discard the low bits. */
+    v ^= v >> 4;
+    v *= UINT64_C(0x9E3779B97F4A7C15);
+    return (v >> 16) % buckets;
+}
+
+static struct memstats_site *memstats_GetSite(enum vlc_memstats_kind kind,
+                                              const void *caller)
+{
+    struct memstats_site **pp = &memstats.sites[memstats_hash(caller,
+                                                    MEMSTATS_SITE_BUCKETS)];
+
+    for (struct memstats_site *site = *pp; site != NULL; site = site->next)
+        if (site->caller == caller && site->kind == kind)
+            return site;
+
+    struct memstats_site *site = calloc(1, sizeof (*site));
+    if (unlikely(site == NULL))
+        return NULL;
+
+    site->kind = kind;
+    site->caller = caller;
+    site->next = *pp;
+    *pp = site;
+    return site;
+}
+
+void vlc_memstats_Alloc(enum vlc_memstats_kind kind, void *ptr,
+                        size_t size, const void *caller)
+{
+    if (likely(!vlc_memstats_Enabled()))
+        return;
+
+    struct memstats_live *live = malloc(sizeof (*live));
+    if (unlikely(live == NULL))
+        return;
+
+    live->ptr = ptr;
+    live->size = size;
+
+    vlc_mutex_lock(&memstats.lock);
+    live->site = memstats_GetSite(kind, caller);
+    if (unlikely(live->site == NULL))
+    {
+        vlc_mutex_unlock(&memstats.lock);
+        free(live);
+        return;
+    }
+
+    struct memstats_site *site = live->site;
+    site->live_bytes += size;
+    site->live_count++;
+    site->total_bytes += size;
+    site->total_count++;
+
+    struct memstats_live **pp = &memstats.live[memstats_hash(ptr,
+                                                    MEMSTATS_LIVE_BUCKETS)];
+    live->next = *pp;
+    *pp = live;
+    vlc_mutex_unlock(&memstats.lock);
+}
+
+void vlc_memstats_Free(const void *ptr)
+{
+    if (likely(!vlc_memstats_Enabled()))
+        return;
+
+    struct memstats_live *live = NULL;
+
+    vlc_mutex_lock(&memstats.lock);
+    for (struct memstats_live **pp = &memstats.live[memstats_hash(ptr,
+                                                    MEMSTATS_LIVE_BUCKETS)];
+         *pp != NULL; pp = &(*pp)->next)
+    {
+        if ((*pp)->ptr == ptr)
+        {
+            live = *pp;
+            *pp = live->next;
+
+            struct memstats_site *site = live->site;
+            assert(site->live_bytes >= live->size && site->live_count > 0);
+            site->live_bytes -= live->size;
+            site->live_count--;
+            break;
+        }
+    }
+    vlc_mutex_unlock(&memstats.lock);
+    /* Not found if not allocated through an accounted function. */
+    free(live);
+}
+
+static int memstats_cmp(const void *a, const void *b)
+{
+    const struct vlc_memstats_entry *ea = a, *eb = b;
+
+    if (ea->live_bytes != eb->live_bytes)
+        return (ea->live_bytes < eb->live_bytes) ? 1 : -1;
+    if (ea->total_bytes != eb->total_bytes)
+        return (ea->total_bytes < eb->total_bytes) ? 1 : -1;
+    return 0;
+}
+
+static void memstats_Resolve(struct vlc_memstats_entry *entry)
+{
+    entry->module = NULL;
+    entry->symbol = NULL;
+#ifdef HAVE_DLADDR
+    Dl_info info;
+
+    /* The return address is right after the call. */
+    if (dladdr((const char *)entry->caller - 1, &info) == 0)
+        return;
+
+    if (info.dli_fname != NULL)
+    {
+        /* The plugins may be unloaded, copy the names. */
+        const char *name = strrchr(info.dli_fname, '/');
+        entry->module = strdup(name != NULL ? name + 1 : info.dli_fname);
+    }
+    if (info.dli_sname != NULL)
+        entry->symbol = strdup(info.dli_sname);
+#endif
+}
+
+ssize_t vlc_memstats_Get(struct vlc_memstats_entry **restrict entriesp)
+{
+    *entriesp = NULL;
+    if (!vlc_memstats_Enabled())
+        return 0;
+
+    struct vlc_memstats_entry *entries = NULL;
+    size_t count = 0, size = 0;
+
+    vlc_mutex_lock(&memstats.lock);
+
+    vlc_tick_t now = vlc_tick_now();
+    double elapsed = 0.;
+    if (memstats.last_date != VLC_TICK_INVALID && now > memstats.last_date)
+        elapsed = secf_from_vlc_tick(now - memstats.last_date);
+    memstats.last_date = now;
+
+    for (size_t i = 0; i < MEMSTATS_SITE_BUCKETS; i++)
+        for (struct memstats_site *site = memstats.sites[i]; site != NULL;
+             site = site->next)
+        {
+            if (count == size)
+            {
+                size_t newsize = size ? size * 2 : 64;
+                void *tab = realloc(entries, newsize * sizeof (*entries));
+                if (unlikely(tab == NULL))
+                {
+                    vlc_mutex_unlock(&memstats.lock);
+                    free(entries);
+                    return -1;
+                }
+                entries = tab;
+                size = newsize;
+            }
+
+            struct vlc_memstats_entry *entry = &entries[count++];
+
+            entry->kind = site->kind;
+            entry->caller = site->caller;
+            entry->live_bytes = site->live_bytes;
+            entry->live_count = site->live_count;
+            entry->total_bytes = site->total_bytes;
+            entry->total_count = site->total_count;
+            entry->byte_rate = entry->count_rate = 0.;
+            if (elapsed > 0.)
+            {
+                entry->byte_rate =
+                    (site->total_bytes - site->last_bytes) / elapsed;
+                entry->count_rate =
+                    (site->total_count - site->last_count) / elapsed;
+            }
+            site->last_bytes = site->total_bytes;
+            site->last_count = site->total_count;
+        }
+
+    vlc_mutex_unlock(&memstats.lock);
+
+    /* Resolve outside of the lock, the loader may allocate. */
+    for (size_t i = 0; i < count; i++)
+        memstats_Resolve(&entries[i]);
+
+    qsort(entries, count, sizeof (*entries), memstats_cmp);
+    *entriesp = entries;
+    return count;
+}
+
+void vlc_memstats_Release(struct vlc_memstats_entry *entries, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        free((char *)entries[i].module);
+        free((char *)entries[i].symbol);
+    }
+    free(entries);
+}
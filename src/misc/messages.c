@@ -40,6 +40,7 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 static void vlc_LogSpam(vlc_object_t *obj)
@@ -439,6 +440,258 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * A message log that formats messages in the calling thread, stores them in
+ * a bounded lock-free ring, and passes them to another log from a dedicated
+ * writer thread. Messages are dropped, and counted, when the ring is full.
+ */
+#define ASYNC_LOG_SIZE   1024 /* records, power of two */
+#define ASYNC_LOG_INLINE  512 /* bytes of text stored in the record */
+
+struct vlc_log_async_record {
+    atomic_size_t seq;
+    int type;
+    vlc_log_t meta;
+    char *text; /* module, header and message, each nul-terminated */
+    char buf[ASYNC_LOG_INLINE];
+};
+
+struct vlc_logger_async {
+    struct vlc_logger logger;
+    struct vlc_logger *sink;
+    vlc_thread_t thread;
+
+    atomic_size_t tail; /* next record to write (producers) */
+    size_t head; /* next record to read (writer thread) */
+    atomic_uint dropped;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    atomic_bool sleeping;
+    bool closing;
+
+    struct vlc_log_async_record ring[ASYNC_LOG_SIZE];
+};
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+    struct vlc_log_async_record *rec;
+
+    /* Reserve a record */
+    size_t pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    for (;;) {
+        rec = &async->ring[pos & (ASYNC_LOG_SIZE - 1)];
+
+        size_t seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&async->tail, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* Full: the writer is lagging behind */
+            atomic_fetch_add_explicit(&async->dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        } else
+            pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    }
+
+    /* Format the record */
+    const char *header = (item->psz_header != NULL) ? item->psz_header : "";
+    size_t modlen = strlen(item->psz_module) + 1;
+    size_t hdrlen = strlen(header) + 1;
+    size_t avail = sizeof (rec->buf) - modlen - hdrlen;
+    va_list aq;
+
+    va_copy(aq, ap);
+    int len = (modlen + hdrlen < sizeof (rec->buf))
+              ? vsnprintf(rec->buf + modlen + hdrlen, avail, format, aq) : -1;
+    va_end(aq);
+
+    rec->text = rec->buf;
+
+    if (len < 0 || (size_t)len >= avail) {
+        /* Too long for the record: heap allocate */
+        if (len < 0) {
+            va_copy(aq, ap);
+            len = vsnprintf(NULL, 0, format, aq);
+            va_end(aq);
+        }
+
+        rec->text = (len >= 0) ? malloc(modlen + hdrlen + len + 1) : NULL;
+        if (rec->text != NULL)
+            vsnprintf(rec->text + modlen + hdrlen, len + 1, format, ap);
+        else if (modlen + hdrlen < sizeof (rec->buf)) {
+            rec->text = rec->buf; /* keep the truncated message */
+            len = avail - 1;
+        } else
+            len = -1;
+    }
+
+    if (len >= 0) {
+        memcpy(rec->text, item->psz_module, modlen);
+        memcpy(rec->text + modlen, header, hdrlen);
+    } else
+        rec->text = NULL;
+
+    rec->type = type;
+    rec->meta = *item;
+    rec->meta.psz_module = NULL;
+    rec->meta.psz_header = (item->psz_header != NULL) ? "" : NULL;
+
+    /* Publish the record */
+    atomic_store_explicit(&rec->seq, pos + 1, memory_order_release);
+
+    /* Wake the writer up if it is waiting (pairs with vlc_LogAsyncThread) */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&async->sleeping, memory_order_relaxed)) {
+        vlc_mutex_lock(&async->lock);
+        vlc_cond_signal(&async->wait);
+        vlc_mutex_unlock(&async->lock);
+    }
+}
+
+static struct vlc_log_async_record *
+vlc_LogAsyncPeek(struct vlc_logger_async *async)
+{
+    struct vlc_log_async_record *rec =
+        &async->ring[async->head & (ASYNC_LOG_SIZE - 1)];
+
+    if (atomic_load_explicit(&rec->seq, memory_order_acquire)
+                                                        != async->head + 1)
+        return NULL;
+    return rec;
+}
+
+static void vlc_LogAsyncDrain(struct vlc_logger_async *async)
+{
+    struct vlc_log_async_record *rec;
+
+    while ((rec = vlc_LogAsyncPeek(async)) != NULL) {
+        vlc_log_t meta = rec->meta;
+
+        if (likely(rec->text != NULL)) {
+            const char *module = rec->text;
+            const char *header = module + strlen(module) + 1;
+            const char *msg = header + strlen(header) + 1;
+
+            meta.psz_module = module;
+            if (meta.psz_header != NULL)
+                meta.psz_header = header;
+            vlc_LogCallback(async->sink, rec->type, &meta, "%s", msg);
+
+            if (rec->text != rec->buf)
+                free(rec->text);
+        } else {
+            meta.psz_module = "logger";
+            vlc_LogCallback(async->sink, rec->type, &meta, "message lost");
+        }
+
+        /* Release the record to the producers */
+        atomic_store_explicit(&rec->seq, async->head + ASYNC_LOG_SIZE,
+                              memory_order_release);
+        async->head++;
+    }
+
+    unsigned dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                                memory_order_relaxed);
+    if (dropped > 0) {
+        vlc_log_t meta = {
+            .i_object_id = (uintptr_t)(void *)async,
+            .psz_object_type = "logger",
+            .psz_module = "logger",
+            .tid = vlc_thread_id(),
+        };
+
+        vlc_LogCallback(async->sink, VLC_MSG_WARN, &meta,
+                        "%u message(s) dropped", dropped);
+    }
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+
+    vlc_mutex_lock(&async->lock);
+    for (;;) {
+        atomic_store_explicit(&async->sleeping, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (vlc_LogAsyncPeek(async) == NULL
+         && atomic_load_explicit(&async->dropped, memory_order_relaxed) == 0) {
+            if (async->closing)
+                break;
+            vlc_cond_wait(&async->wait, &async->lock);
+            continue;
+        }
+
+        atomic_store_explicit(&async->sleeping, false, memory_order_relaxed);
+        vlc_mutex_unlock(&async->lock);
+        vlc_LogAsyncDrain(async);
+        vlc_mutex_lock(&async->lock);
+    }
+    vlc_mutex_unlock(&async->lock);
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+
+    vlc_mutex_lock(&async->lock);
+    async->closing = true;
+    vlc_cond_signal(&async->wait);
+    vlc_mutex_unlock(&async->lock);
+    vlc_join(async->thread, NULL);
+
+    vlc_LogDestroy(async->sink);
+    free(async);
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+};
+
+static struct vlc_logger *vlc_LogAsyncCreate(struct vlc_logger *sink)
+{
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return NULL;
+
+    async->logger.ops = &async_ops;
+    async->sink = sink;
+    atomic_init(&async->tail, 0);
+    async->head = 0;
+    atomic_init(&async->dropped, 0);
+    vlc_mutex_init(&async->lock);
+    vlc_cond_init(&async->wait);
+    atomic_init(&async->sleeping, false);
+    async->closing = false;
+
+    for (size_t i = 0; i < ASYNC_LOG_SIZE; i++)
+        atomic_init(&async->ring[i].seq, i);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW)) {
+        free(async);
+        return NULL;
+    }
+    return &async->logger;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -448,6 +701,11 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async")) {
+        struct vlc_logger *async = vlc_LogAsyncCreate(logger);
+        if (async != NULL)
+            logger = async;
+    }
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
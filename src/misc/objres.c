@@ -124,9 +124,9 @@ void vlc_objres_remove(vlc_object_t *obj, void *data,
     }
 }
 
-static void dummy_release(void *data)
+static void obj_malloc_release(void *data)
 {
-    (void) data;
+    vlc_memstats_Free(data);
 }
 
 static bool ptrcmp(void *a, void *b)
@@ -134,14 +134,23 @@ static bool ptrcmp(void *a, void *b)
     return a == b;
 }
 
-void *vlc_obj_malloc(vlc_object_t *obj, size_t size)
+static void *vlc_obj_alloc(vlc_object_t *obj, size_t size,
+                           const void *caller)
 {
-    void *ptr = vlc_objres_new(size, dummy_release);
+    void *ptr = vlc_objres_new(size, obj_malloc_release);
     if (likely(ptr != NULL))
+    {
+        vlc_memstats_Alloc(VLC_MEMSTATS_OBJRES, ptr, size, caller);
         vlc_objres_push(obj, ptr);
+    }
     return ptr;
 }
 
+void *vlc_obj_malloc(vlc_object_t *obj, size_t size)
+{
+    return vlc_obj_alloc(obj, size, __builtin_return_address(0));
+}
+
 void *vlc_obj_calloc(vlc_object_t *obj, size_t nmemb, size_t size)
 {
     size_t tabsize;
@@ -151,15 +160,16 @@ void *vlc_obj_calloc(vlc_object_t *obj, size_t nmemb, size_t size)
         return NULL;
     }
 
-    void *ptr = vlc_obj_malloc(obj, tabsize);
+    void *ptr = vlc_obj_alloc(obj, tabsize, __builtin_return_address(0));
     if (likely(ptr != NULL))
         memset(ptr, 0, tabsize);
     return ptr;
 }
 
-static void *vlc_obj_memdup(vlc_object_t *obj, const void *base, size_t len)
+static void *vlc_obj_memdup(vlc_object_t *obj, const void *base, size_t len,
+                            const void *caller)
 {
-    void *ptr = vlc_obj_malloc(obj, len);
+    void *ptr = vlc_obj_alloc(obj, len, caller);
     if (likely(ptr != NULL))
         memcpy(ptr, base, len);
     return ptr;
@@ -167,7 +177,8 @@ static void *vlc_obj_memdup(vlc_object_t *obj, const void *base, size_t len)
 
 char *vlc_obj_strdup(vlc_object_t *obj, const char *str)
 {
-    return vlc_obj_memdup(obj, str, strlen(str) + 1);
+    return vlc_obj_memdup(obj, str, strlen(str) + 1,
+                          __builtin_return_address(0));
 }
 
 void vlc_obj_free(vlc_object_t *obj, void *ptr)
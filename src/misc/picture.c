@@ -37,6 +37,7 @@
 #include "picture.h"
 #include <vlc_image.h>
 #include <vlc_block.h>
+#include "../libvlc.h"
 
 static void PictureDestroyContext( picture_t *p_picture )
 {
@@ -68,7 +69,10 @@ static void picture_DestroyFromFormat(picture_t *pic)
     picture_buffer_t *res = pic->p_sys;
 
     if (res != NULL)
+    {
+        vlc_memstats_Free(pic);
         picture_Deallocate(res->fd, res->base, res->size);
+    }
 }
 
 VLC_WEAK void *picture_Allocate(int *restrict fdp, size_t size)
@@ -314,6 +318,8 @@ picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
         buf += plane_sizes[i];
     }
 
+    vlc_memstats_Alloc(VLC_MEMSTATS_PICTURE, pic, pic_size,
+                       __builtin_return_address(0));
     return pic;
 error:
     free(privbuf);
@@ -455,6 +461,65 @@ picture_t *picture_Clone(picture_t *picture)
     return clone;
 }
 
+static bool picture_IsShared(picture_t *picture)
+{
+    picture_priv_t *priv = (picture_priv_t *)picture;
+
+    if (atomic_load(&picture->refs) > 1)
+        return true;
+    /* a clone shares the planes of its parent */
+    if (priv->gc.destroy == picture_DestroyClone)
+        return picture_IsShared(priv->gc.opaque);
+    return false;
+}
+
+picture_t *picture_MakeWritable(picture_t *picture)
+{
+    if (picture->i_planes == 0 || !picture_IsShared(picture))
+        return picture;
+
+    picture_t *copy = picture_NewFromFormat(&picture->format);
+    if (likely(copy != NULL))
+        picture_Copy(copy, picture);
+    picture_Release(picture);
+    return copy;
+}
+
+picture_t *picture_CloneRegion(picture_t *picture, const video_format_t *fmt,
+                               unsigned x, unsigned y)
+{
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(picture->format.i_chroma);
+    if (dsc == NULL || dsc->plane_count == 0
+     || dsc->plane_count != (unsigned)picture->i_planes)
+        return NULL;
+
+    picture_resource_t res = {
+        .p_sys = picture->p_sys,
+        .pf_destroy = picture_DestroyClone,
+    };
+
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+        unsigned px = x * dsc->p[i].w.num / dsc->p[i].w.den;
+        unsigned py = y * dsc->p[i].h.num / dsc->p[i].h.den;
+
+        if (py >= (unsigned)p->i_lines)
+            return NULL;
+        res.p[i].p_pixels = p->p_pixels + py * p->i_pitch
+                          + px * p->i_pixel_pitch;
+        res.p[i].i_lines = p->i_lines - py;
+        res.p[i].i_pitch = p->i_pitch;
+    }
+
+    picture_t *clone = picture_NewFromResource(fmt, &res);
+    if (likely(clone != NULL)) {
+        ((picture_priv_t *)clone)->gc.opaque = picture;
+        picture_Hold(picture);
+    }
+    return clone;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
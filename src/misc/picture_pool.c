@@ -38,12 +38,16 @@
 
 static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
 
+/* The available pictures bitmap is handled lock-free. The lock and condition
+ * variable only serve picture_pool_Wait(): a released picture signals it if
+ * some thread is waiting. */
 struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool        canceled;
+    _Atomic unsigned long long available;
+    atomic_uint        waiters;
     atomic_ushort      refs;
     unsigned short     picture_count;
     picture_t  *picture[];
@@ -65,6 +69,51 @@ void picture_pool_Release(picture_pool_t *pool)
     picture_pool_Destroy(pool);
 }
 
+/**
+ * Marks a picture as available, and wakes a waiting thread up if any.
+ */
+static void picture_pool_Put(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long prev =
+        atomic_fetch_or_explicit(&pool->available, 1ULL << offset,
+                                 memory_order_release);
+    assert(!(prev & (1ULL << offset)));
+    (void) prev;
+
+    /* Pairs with picture_pool_Wait(): either the waiter sees the picture
+     * before sleeping, or it is seen waiting here. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&pool->waiters, memory_order_relaxed) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * Reserves an available picture.
+ * \return the picture offset, or -1 if none is available
+ */
+static int picture_pool_Take(picture_pool_t *pool)
+{
+    unsigned long long available =
+        atomic_load_explicit(&pool->available, memory_order_relaxed);
+
+    while (available != 0)
+    {
+        int i = ctz(available);
+
+        if (atomic_compare_exchange_weak_explicit(&pool->available,
+                                                  &available,
+                                                  available & ~(1ULL << i),
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+            return i;
+    }
+    return -1;
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
@@ -74,13 +123,7 @@ static void picture_pool_ReleasePicture(picture_t *clone)
     picture_t *picture = pool->picture[offset];
 
     picture_Release(picture);
-
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    picture_pool_Put(pool, offset);
     picture_pool_Destroy(pool);
 }
 
@@ -90,8 +133,16 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
     picture_t *picture = pool->picture[offset];
     uintptr_t sys = ((uintptr_t)pool) + offset;
 
-    return picture_InternalClone(picture, picture_pool_ReleasePicture,
-                                 (void*)sys);
+    picture_t *clone = picture_InternalClone(picture,
+                                             picture_pool_ReleasePicture,
+                                             (void*)sys);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    }
+    else
+        picture_pool_Put(pool, offset);
+    return clone;
 }
 
 picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
@@ -110,13 +161,14 @@ picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
     if (count == POOL_MAX)
-        pool->available = ~0ULL;
+        atomic_init(&pool->available, ~0ULL);
     else
-        pool->available = (1ULL << count) - 1;
+        atomic_init(&pool->available, (1ULL << count) - 1);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
     pool->picture_count = count;
     memcpy(pool->picture, tab, count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
     return pool;
 }
 
@@ -169,68 +221,58 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    unsigned long long available;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    while (available != 0)
-    {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
-            break;
-
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
+    if (unlikely(atomic_load_explicit(&pool->canceled, memory_order_relaxed)))
+        return NULL;
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
-        }
-        return clone;
-    }
+    int i = picture_pool_Take(pool);
+    if (i < 0)
+        return NULL;
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    return picture_pool_ClonePicture(pool, i);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
+
+    /* A free picture is returned even if the pool is canceled: only the
+     * wait is canceled. */
+    int i = picture_pool_Take(pool);
 
-    while (pool->available == 0)
+    if (i < 0)
     {
-        if (pool->canceled)
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+
+        for (;;)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            atomic_thread_fence(memory_order_seq_cst);
+            i = picture_pool_Take(pool);
+            if (i >= 0)
+                break;
+            if (atomic_load_explicit(&pool->canceled, memory_order_relaxed))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub_explicit(&pool->waiters, 1, memory_order_relaxed);
+        vlc_mutex_unlock(&pool->lock);
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+        if (i < 0)
+            return NULL;
     }
-    return clone;
+
+    return picture_pool_ClonePicture(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    pool->canceled = canceled;
+    atomic_store_explicit(&pool->canceled, canceled, memory_order_relaxed);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
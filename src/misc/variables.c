@@ -27,9 +27,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -38,6 +35,7 @@
 #include <vlc_common.h>
 #include <vlc_arrays.h>
 #include <vlc_charset.h>
+#include <vlc_list.h>
 #include "libvlc.h"
 #include "variables.h"
 #include "config/configuration.h"
@@ -52,6 +50,15 @@ typedef struct callback_entry_t
         void *               p_callback;
     };
     void *         p_data;
+
+    /* Deferred value callback state, protected by the dispatcher lock */
+    bool           deferred; /**< Run from the dispatcher thread */
+    bool           queued; /**< In the dispatcher queue */
+    vlc_object_t  *obj;
+    variable_t    *var;
+    vlc_value_t    oldval; /**< Value before the first undelivered change */
+    vlc_value_t    newval; /**< Latest value */
+    struct vlc_list node;
 } callback_entry_t;
 
 typedef struct variable_ops_t
@@ -67,7 +74,10 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     i_hash;   /**< Hash of the name */
+    /** Next variable in the same hash table bucket */
+    struct variable_t *p_next;
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -136,29 +146,220 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/* FNV-1a */
+static uint32_t VarHash( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    uint32_t hash = 2166136261u;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    for( const unsigned char *p = (const unsigned char *)psz_name; *p; p++ )
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
 }
 
+static variable_t *LookupLocked( vlc_object_internals_t *priv,
+                                 const char *psz_name, uint32_t hash )
+{
+    vlc_mutex_assert( &priv->var_lock );
+
+    if( priv->var_table == NULL )
+        return NULL;
+
+    for( variable_t *var = priv->var_table[hash & priv->var_mask];
+         var != NULL; var = var->p_next )
+        if( var->i_hash == hash && !strcmp( var->psz_name, psz_name ) )
+            return var;
+    return NULL;
+}
+
+/**
+ * Finds a variable, and returns with the variables lock held.
+ */
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    void **pp_var;
+    /* hash outside of the lock */
+    uint32_t hash = VarHash( psz_name );
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    return LookupLocked( priv, psz_name, hash );
 }
 
-static void Destroy( variable_t *p_var )
+static int Insert( vlc_object_internals_t *priv, variable_t *var )
 {
-    p_var->ops->pf_free( &p_var->val );
+    vlc_mutex_assert( &priv->var_lock );
+
+    if( priv->var_table == NULL || priv->var_count > priv->var_mask )
+    {   /* Grow the table, keeping at most one variable per bucket average */
+        unsigned size = priv->var_table != NULL ? 2 * (priv->var_mask + 1)
+                                                : 16;
+        variable_t **table = calloc( size, sizeof (*table) );
+
+        if( table != NULL )
+        {
+            for( unsigned i = 0; priv->var_table != NULL
+                              && i <= priv->var_mask; i++ )
+            {
+                variable_t *p = priv->var_table[i];
+
+                while( p != NULL )
+                {
+                    variable_t *next = p->p_next;
+
+                    p->p_next = table[p->i_hash & (size - 1)];
+                    table[p->i_hash & (size - 1)] = p;
+                    p = next;
+                }
+            }
+            free( priv->var_table );
+            priv->var_table = table;
+            priv->var_mask = size - 1;
+        }
+        else if( priv->var_table == NULL )
+            return VLC_ENOMEM;
+        /* otherwise, use the current table */
+    }
+
+    variable_t **pp = &priv->var_table[var->i_hash & priv->var_mask];
+    var->p_next = *pp;
+    *pp = var;
+    priv->var_count++;
+    return VLC_SUCCESS;
+}
+
+static void Remove( vlc_object_internals_t *priv, variable_t *var )
+{
+    vlc_mutex_assert( &priv->var_lock );
 
+    variable_t **pp = &priv->var_table[var->i_hash & priv->var_mask];
+    while( *pp != var )
+        pp = &(*pp)->p_next;
+    *pp = var->p_next;
+    priv->var_count--;
+}
+
+/*
+ * Deferred callbacks are called from a single dispatcher thread. While a
+ * change is waiting for a callback to be run, later changes are merged into
+ * it, so that only the latest value is delivered.
+ */
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait; /**< Wait for queued callbacks */
+    vlc_cond_t  done; /**< Wait for the running callback to return */
+    struct vlc_list queue;
+    callback_entry_t *running;
+    bool        active; /**< Dispatcher thread running */
+} dispatcher = {
+    VLC_STATIC_MUTEX,
+    VLC_STATIC_COND,
+    VLC_STATIC_COND,
+    VLC_LIST_INITIALIZER(&dispatcher.queue),
+    NULL,
+    false,
+};
+
+static thread_local bool in_dispatcher;
+
+static void *DeferredThread(void *data)
+{
+    (void) data;
+    in_dispatcher = true;
+
+    vlc_mutex_lock(&dispatcher.lock);
+    for (;;)
+    {
+        /* the thread exits when idle, and is started again on demand */
+        vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_SEC(5);
+
+        while (vlc_list_is_empty(&dispatcher.queue))
+            if (vlc_cond_timedwait(&dispatcher.wait, &dispatcher.lock,
+                                   deadline)
+             && vlc_list_is_empty(&dispatcher.queue))
+            {
+                dispatcher.active = false;
+                vlc_mutex_unlock(&dispatcher.lock);
+                return NULL;
+            }
+
+        callback_entry_t *entry =
+            vlc_list_first_entry_or_null(&dispatcher.queue,
+                                         callback_entry_t, node);
+        vlc_list_remove(&entry->node);
+        entry->queued = false;
+        dispatcher.running = entry;
+
+        vlc_value_t oldval = entry->oldval, newval = entry->newval;
+        /* the callback may delete itself, do not use the entry afterwards */
+        const variable_ops_t *ops = entry->var->ops;
+        vlc_mutex_unlock(&dispatcher.lock);
+
+        entry->pf_value_callback(entry->obj, entry->var->psz_name,
+                                 oldval, newval, entry->p_data);
+        ops->pf_free(&oldval);
+        ops->pf_free(&newval);
+
+        vlc_mutex_lock(&dispatcher.lock);
+        dispatcher.running = NULL;
+        vlc_cond_broadcast(&dispatcher.done);
+    }
+}
+
+static void DeferredQueue(vlc_object_t *obj, variable_t *var,
+                          callback_entry_t *entry, vlc_value_t prev)
+{
+    vlc_value_t val = var->val;
+
+    var->ops->pf_dup(&val);
+
+    vlc_mutex_lock(&dispatcher.lock);
+    if (entry->queued)
+    {   /* merge with the pending change */
+        var->ops->pf_free(&entry->newval);
+        entry->newval = val;
+    }
+    else
+    {
+        var->ops->pf_dup(&prev);
+        entry->obj = obj;
+        entry->var = var;
+        entry->oldval = prev;
+        entry->newval = val;
+        entry->queued = true;
+        vlc_list_append(&entry->node, &dispatcher.queue);
+
+        if (!dispatcher.active)
+            dispatcher.active = !vlc_clone_detach(NULL, DeferredThread, NULL,
+                                                  VLC_THREAD_PRIORITY_LOW);
+        vlc_cond_signal(&dispatcher.wait);
+    }
+    vlc_mutex_unlock(&dispatcher.lock);
+}
+
+/**
+ * Drops the pending change of a deferred callback, and waits for it to
+ * return if it is running (unless called from the callback itself).
+ */
+static void DeferredCancel(callback_entry_t *entry)
+{
+    if (!entry->deferred)
+        return;
+
+    vlc_mutex_lock(&dispatcher.lock);
+    if (entry->queued)
+    {
+        vlc_list_remove(&entry->node);
+        entry->queued = false;
+        entry->var->ops->pf_free(&entry->oldval);
+        entry->var->ops->pf_free(&entry->newval);
+    }
+    while (dispatcher.running == entry && !in_dispatcher)
+        vlc_cond_wait(&dispatcher.done, &dispatcher.lock);
+    vlc_mutex_unlock(&dispatcher.lock);
+}
+
+static void Destroy( variable_t *p_var )
+{
     for (size_t i = 0, count = p_var->choices_count; i < count; i++)
     {
         p_var->ops->pf_free(&p_var->choices[i]);
@@ -167,16 +368,19 @@ static void Destroy( variable_t *p_var )
     free(p_var->choices);
     free(p_var->choices_text);
 
-    free( p_var->psz_name );
-    free( p_var->psz_text );
+    /* deferred callbacks may still use the variable */
     while (unlikely(p_var->value_callbacks != NULL))
     {
         callback_entry_t *next = p_var->value_callbacks->next;
 
+        DeferredCancel(p_var->value_callbacks);
         free(p_var->value_callbacks);
         p_var->value_callbacks = next;
     }
     assert(p_var->list_callbacks == NULL);
+    p_var->ops->pf_free( &p_var->val );
+    free( p_var->psz_name );
+    free( p_var->psz_text );
     free( p_var );
 }
 
@@ -238,7 +442,17 @@ static void TriggerCallback(vlc_object_t *obj, variable_t *var,
     assert(obj != NULL);
 
     callback_entry_t *entry = var->value_callbacks;
-    if (entry == NULL)
+    bool b_sync = false;
+
+    for (callback_entry_t *e = entry; e != NULL; e = e->next)
+    {
+        if (e->deferred)
+            DeferredQueue(obj, var, e, prev);
+        else
+            b_sync = true;
+    }
+
+    if (!b_sync)
         return;
 
     vlc_object_internals_t *priv = vlc_internals(obj);
@@ -249,7 +463,9 @@ static void TriggerCallback(vlc_object_t *obj, variable_t *var,
 
     do
     {
-        entry->pf_value_callback(obj, name, prev, var->val, entry->p_data);
+        if (!entry->deferred)
+            entry->pf_value_callback(obj, name, prev, var->val,
+                                     entry->p_data);
         entry = entry->next;
     }
     while (entry != NULL);
@@ -295,6 +511,7 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -352,17 +569,18 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    void **pp_var;
     variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = LookupLocked( p_priv, psz_name, p_var->i_hash );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = Insert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -392,7 +610,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        Remove( p_priv, p_var );
     }
     else
     {
@@ -405,17 +623,26 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( unsigned i = 0; priv->var_table != NULL && i <= priv->var_mask; i++ )
+    {
+        variable_t *var = priv->var_table[i];
+
+        while( var != NULL )
+        {
+            variable_t *next = var->p_next;
+
+            Destroy( var );
+            var = next;
+        }
+    }
+    free( priv->var_table );
+    priv->var_table = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -803,6 +1030,20 @@ void (var_AddCallback)(vlc_object_t *p_this, const char *psz_name,
 
     entry->pf_value_callback = pf_callback;
     entry->p_data = p_data;
+    entry->deferred = false;
+    entry->queued = false;
+    AddCallback(p_this, psz_name, entry, vlc_value_callback);
+}
+
+void (var_AddDeferredCallback)(vlc_object_t *p_this, const char *psz_name,
+                               vlc_callback_t pf_callback, void *p_data)
+{
+    callback_entry_t *entry = xmalloc(sizeof (*entry));
+
+    entry->pf_value_callback = pf_callback;
+    entry->p_data = p_data;
+    entry->deferred = true;
+    entry->queued = false;
     AddCallback(p_this, psz_name, entry, vlc_value_callback);
 }
 
@@ -846,6 +1087,7 @@ static void DelCallback( vlc_object_t *p_this, const char *psz_name,
 
     *pp = entry->next;
     vlc_mutex_unlock( &p_priv->var_lock );
+    DeferredCancel(entry);
     free(entry);
 }
 
@@ -881,6 +1123,8 @@ void (var_AddListCallback)(vlc_object_t *p_this, const char *psz_name,
 
     entry->pf_list_callback = pf_callback;
     entry->p_data = p_data;
+    entry->deferred = false;
+    entry->queued = false;
     AddCallback(p_this, psz_name, entry, vlc_list_callback);
 }
 
@@ -1135,21 +1379,6 @@ error:
     return VLC_EGENERIC;
 }
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
-}
-
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
@@ -1157,9 +1386,15 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (unsigned i = 0; priv->var_table != NULL && i <= priv->var_mask; i++)
+        for (const variable_t *var = priv->var_table[i]; var != NULL;
+             var = var->p_next)
+        {
+            char *dup = strdup(var->psz_name);
+            if (dup != NULL)
+                ARRAY_APPEND(names, dup);
+        }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
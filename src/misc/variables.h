@@ -38,7 +38,9 @@ struct vlc_object_internals
     const char *typename; /**< Object type human-readable name */
 
     /* Object variables */
-    void           *var_root;
+    struct variable_t **var_table; /**< Hash table of variables (or NULL) */
+    unsigned        var_mask; /**< Hash table size minus one */
+    unsigned        var_count; /**< Number of variables */
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
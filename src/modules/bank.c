@@ -284,6 +284,16 @@ typedef enum
     CACHE_WRITE_FILE = 0x4,
 } cache_mode_t;
 
+/** Plug-in file that needs to be loaded, as it is not in the cache */
+typedef struct module_candidate
+{
+    char         *abspath;
+    char         *relpath;
+    int64_t       mtime;
+    uint64_t      size;
+    vlc_plugin_t *plugin;
+} module_candidate_t;
+
 typedef struct module_bank
 {
     vlc_object_t *obj;
@@ -293,8 +303,25 @@ typedef struct module_bank
     size_t        size;
     vlc_plugin_t **plugins;
     vlc_plugin_t *cache;
+
+    size_t        candidates_count;
+    module_candidate_t *candidates;
+    atomic_size_t candidates_next;
 } module_bank_t;
 
+static void AllocatePluginAdd(module_bank_t *bank, vlc_plugin_t *plugin)
+{
+    vlc_plugin_store(plugin);
+
+    if (bank->mode & CACHE_WRITE_FILE) /* Add entry to to-be-saved cache */
+    {
+        bank->plugins = xrealloc(bank->plugins,
+                                 (bank->size + 1) * sizeof (vlc_plugin_t *));
+        bank->plugins[bank->size] = plugin;
+        bank->size++;
+    }
+}
+
 /**
  * Scans a plug-in from a file.
  */
@@ -319,38 +346,107 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
         }
     }
 
-    if (plugin == NULL)
+    if (plugin != NULL)
     {
-        char *path = strdup(relpath);
-        if (path == NULL)
-            return -1;
+        AllocatePluginAdd(bank, plugin);
+        return 0;
+    }
 
-        plugin = module_InitDynamic(bank->obj, abspath, true);
+    /* Not cached: the plug-in is loaded later, see AllocatePluginCandidates */
+    module_candidate_t *cand = realloc(bank->candidates,
+                        (bank->candidates_count + 1) * sizeof (*cand));
+    if (unlikely(cand == NULL))
+        return -1;
+    bank->candidates = cand;
+    cand += bank->candidates_count;
 
-        if (plugin != NULL)
-        {
-            plugin->path = path;
-            plugin->mtime = st->st_mtime;
-            plugin->size = st->st_size;
-        }
-        else free(path);
+    cand->abspath = strdup(abspath);
+    cand->relpath = strdup(relpath);
+    if (unlikely(cand->abspath == NULL || cand->relpath == NULL))
+    {
+        free(cand->abspath);
+        free(cand->relpath);
+        return -1;
     }
+    cand->mtime = st->st_mtime;
+    cand->size = st->st_size;
+    cand->plugin = NULL;
+    bank->candidates_count++;
+    return 0;
+}
 
-    if (plugin == NULL)
-        return -1;
+static void *AllocatePluginThread(void *data)
+{
+    module_bank_t *bank = data;
+    size_t i;
 
-    vlc_plugin_store(plugin);
+    while ((i = atomic_fetch_add_explicit(&bank->candidates_next, 1,
+                                          memory_order_relaxed))
+                                                    < bank->candidates_count)
+    {
+        module_candidate_t *cand = &bank->candidates[i];
 
-    if (bank->mode & CACHE_WRITE_FILE) /* Add entry to to-be-saved cache */
+        cand->plugin = module_InitDynamic(bank->obj, cand->abspath, true);
+    }
+    return NULL;
+}
+
+/**
+ * Loads the plug-in files which were not found in the cache.
+ *
+ * Loading and describing the plug-ins is independent from one file to the
+ * other and dominated by the dynamic linker, so it is spread over a few
+ * threads. The plug-ins are then added in the directory scan order.
+ */
+static void AllocatePluginCandidates(module_bank_t *bank)
+{
+    size_t count = bank->candidates_count;
+    if (count == 0)
+        return;
+
+    unsigned nthreads = vlc_GetCPUCount();
+    if (nthreads > count)
+        nthreads = count;
+    if (nthreads > 8)
+        nthreads = 8;
+
+    vlc_thread_t threads[8];
+    unsigned started = 0;
+
+    atomic_init(&bank->candidates_next, 0);
+
+    /* the calling thread is one of the workers */
+    while (started + 1 < nthreads
+        && vlc_clone(&threads[started], AllocatePluginThread, bank,
+                     VLC_THREAD_PRIORITY_LOW) == 0)
+        started++;
+
+    AllocatePluginThread(bank);
+
+    for (unsigned i = 0; i < started; i++)
+        vlc_join(threads[i], NULL);
+
+    for (size_t i = 0; i < count; i++)
     {
-        bank->plugins = xrealloc(bank->plugins,
-                                 (bank->size + 1) * sizeof (vlc_plugin_t *));
-        bank->plugins[bank->size] = plugin;
-        bank->size++;
+        module_candidate_t *cand = &bank->candidates[i];
+        vlc_plugin_t *plugin = cand->plugin;
+
+        free(cand->abspath);
+        if (plugin == NULL)
+        {
+            free(cand->relpath);
+            continue;
+        }
+
+        plugin->path = cand->relpath;
+        plugin->mtime = cand->mtime;
+        plugin->size = cand->size;
+        AllocatePluginAdd(bank, plugin);
     }
 
-    /* TODO: deal with errors */
-    return  0;
+    free(bank->candidates);
+    bank->candidates = NULL;
+    bank->candidates_count = 0;
 }
 
 /**
@@ -455,6 +551,7 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
 
         /* Don't go deeper than 5 subdirectories */
         AllocatePluginDir(&bank, 5, path, NULL);
+        AllocatePluginCandidates(&bank);
     }
 
     /* Deal with unmatched cache entries from cache file */
@@ -42,6 +42,7 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_interrupt.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -68,8 +69,14 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* stream data shared by the clients, see httpd_stream_t */
+#define HTTPD_CHUNK_SIZE 65536
+
+typedef struct httpd_chunk_t httpd_chunk_t;
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
 static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+static void httpd_ChunkRelease(httpd_chunk_t *chunk);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -89,6 +96,9 @@ struct httpd_host_t
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
+    /* wakes the thread up when waiting clients may have data to send */
+    vlc_interrupt_t *interrupt;
+
     /* all registered url (becarefull that 2 httpd_url_t could point at the same url)
      * This will slow down the url research but make my live easier
      * All url will have their cb trigger, but only the first one can answer
@@ -155,6 +165,11 @@ struct httpd_client_t
     int     i_buffer;
     uint8_t *p_buffer;
 
+    /* stream data p_buffer (resp. answer.p_body) points to, which is
+     * not owned by the client if not NULL */
+    httpd_chunk_t *chunk;
+    httpd_chunk_t *answer_chunk;
+
     /*
      * If waiting for a keyframe, this is the position (in bytes) of the
      * last keyframe the stream saw before this client connected.
@@ -607,9 +622,10 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* data kept for the clients, as a list of reference counted chunks,
+     * so that all clients send from the same memory */
+    int         i_buffer_size;      /* data size kept for late clients */
+    struct vlc_list chunks;
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -618,6 +634,59 @@ struct httpd_stream_t
     httpd_header * p_http_headers;
 };
 
+struct httpd_chunk_t
+{
+    atomic_uint refs;
+    struct vlc_list node;
+    int64_t  i_pos;     /* absolute position of the first byte */
+    size_t   i_size;    /* written bytes, protected by the stream lock */
+    size_t   i_alloc;
+    uint8_t  p_data[];
+};
+
+static httpd_chunk_t *httpd_ChunkNew(int64_t i_pos, size_t i_alloc)
+{
+    httpd_chunk_t *chunk = malloc(sizeof (*chunk) + i_alloc);
+    if (unlikely(chunk == NULL))
+        return NULL;
+
+    atomic_init(&chunk->refs, 1);
+    chunk->i_pos = i_pos;
+    chunk->i_size = 0;
+    chunk->i_alloc = i_alloc;
+    return chunk;
+}
+
+static httpd_chunk_t *httpd_ChunkHold(httpd_chunk_t *chunk)
+{
+    atomic_fetch_add_explicit(&chunk->refs, 1, memory_order_relaxed);
+    return chunk;
+}
+
+static void httpd_ChunkRelease(httpd_chunk_t *chunk)
+{
+    if (chunk != NULL
+     && atomic_fetch_sub_explicit(&chunk->refs, 1, memory_order_acq_rel) == 1)
+        free(chunk);
+}
+
+/* Finds the chunk holding the given position, searching from the most
+ * recent one as the clients are usually up to date with the stream */
+static httpd_chunk_t *httpd_StreamChunkAt(httpd_stream_t *stream, int64_t i_pos)
+{
+    for (struct vlc_list *node = stream->chunks.prev;
+         node != &stream->chunks; node = node->prev) {
+        httpd_chunk_t *chunk = container_of(node, httpd_chunk_t, node);
+
+        if (chunk->i_pos <= i_pos) {
+            if (i_pos - chunk->i_pos < (int64_t)chunk->i_size)
+                return chunk;
+            break;
+        }
+    }
+    return NULL;
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -628,15 +697,14 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
-
+        vlc_mutex_lock(&stream->lock);
         if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+            goto wait;    /* wait, no data available */
 
         if (cl->i_keyframe_wait_to_pass >= 0) {
             if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
                 /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+                goto wait;
 
             /* seek to the new keyframe */
             answer->i_body_offset = stream->i_last_keyframe_seen_pos;
@@ -646,29 +714,36 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
             answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+        httpd_chunk_t *chunk = httpd_StreamChunkAt(stream, answer->i_body_offset);
+        if (chunk == NULL) {
+            /* data already dropped (or lost) */
+            answer->i_body_offset = stream->i_buffer_last_pos;
+            chunk = httpd_StreamChunkAt(stream, answer->i_body_offset);
+            if (chunk == NULL)
+                goto wait;
+        }
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        /* Send the chunk data in place, it is never overwritten */
+        size_t i_offset = answer->i_body_offset - chunk->i_pos;
+        size_t i_write = chunk->i_size - i_offset;
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
+        httpd_ChunkRelease(cl->answer_chunk);
+        cl->answer_chunk = httpd_ChunkHold(chunk);
         answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+        answer->p_body = &chunk->p_data[i_offset];
 
         answer->i_body_offset += i_write;
+        vlc_mutex_unlock(&stream->lock);
 
         return VLC_SUCCESS;
+wait:
+        vlc_mutex_unlock(&stream->lock);
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -752,7 +827,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
         return NULL;
 
     stream->psz_mime = NULL;
-    stream->p_buffer = NULL;
+    vlc_list_init(&stream->chunks);
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
@@ -770,10 +845,6 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
 
-    stream->p_buffer = malloc(stream->i_buffer_size);
-    if (stream->p_buffer == NULL)
-        goto error;
-
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -821,20 +892,38 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
 
 static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
+    while (i_data > 0) {
+        httpd_chunk_t *chunk = vlc_list_last_entry_or_null(&stream->chunks,
+                                                           httpd_chunk_t, node);
+
+        /* Clients only send the bytes written before they got the chunk,
+         * so the remaining space can be filled in place */
+        if (chunk == NULL || chunk->i_size == chunk->i_alloc) {
+            chunk = httpd_ChunkNew(stream->i_buffer_pos,
+                                   __MAX(i_data, HTTPD_CHUNK_SIZE));
+            if (unlikely(chunk == NULL))
+                break;
+            vlc_list_append(&chunk->node, &stream->chunks);
+        }
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+        size_t i_copy = __MIN((size_t)i_data, chunk->i_alloc - chunk->i_size);
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+        memcpy(&chunk->p_data[chunk->i_size], p_data, i_copy);
+        chunk->i_size += i_copy;
+        stream->i_buffer_pos += i_copy;
+        i_data -= i_copy;
+        p_data += i_copy;
     }
 
-    stream->i_buffer_pos += i_data;
+    /* Drop the data too old for any client */
+    httpd_chunk_t *chunk;
+    vlc_list_foreach(chunk, &stream->chunks, node) {
+        if (chunk->i_pos + (int64_t)chunk->i_size + stream->i_buffer_size
+                >= stream->i_buffer_pos)
+            break;
+        vlc_list_remove(&chunk->node);
+        httpd_ChunkRelease(chunk);
+    }
 }
 
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
@@ -855,6 +944,9 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
     httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
 
     vlc_mutex_unlock(&stream->lock);
+
+    /* let the waiting clients send it */
+    vlc_interrupt_raise(stream->url->host->interrupt);
     return VLC_SUCCESS;
 }
 
@@ -868,7 +960,10 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     free(stream->p_http_headers);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+
+    httpd_chunk_t *chunk;
+    vlc_list_foreach(chunk, &stream->chunks, node)
+        httpd_ChunkRelease(chunk);
     free(stream);
 }
 
@@ -955,6 +1050,11 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_mutex_init(&host->lock);
     vlc_cond_init(&host->wait);
     atomic_init(&host->ref, 1);
+    host->fds = NULL;
+
+    host->interrupt = vlc_interrupt_create();
+    if (unlikely(host->interrupt == NULL))
+        goto error;
 
     char *hostname = var_InheritString(p_this, hostvar);
 
@@ -990,7 +1090,10 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
-        net_ListenClose(host->fds);
+        if (host->fds != NULL)
+            net_ListenClose(host->fds);
+        if (host->interrupt != NULL)
+            vlc_interrupt_destroy(host->interrupt);
         vlc_object_delete(host);
     }
 
@@ -1026,6 +1129,7 @@ void httpd_HostDelete(httpd_host_t *host)
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
     net_ListenClose(host->fds);
+    vlc_interrupt_destroy(host->interrupt);
     vlc_object_delete(host);
     vlc_mutex_unlock(&httpd.mutex);
 }
@@ -1206,6 +1310,8 @@ static void httpd_ClientInit(httpd_client_t *cl, vlc_tick_t now)
     cl->i_buffer_size = HTTPD_CL_BUFSIZE;
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc(cl->i_buffer_size);
+    cl->chunk = NULL;
+    cl->answer_chunk = NULL;
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
 
@@ -1223,14 +1329,43 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
     return net_GetSockAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
 }
 
+/* Releases the data being sent */
+static void httpd_ClientBufferClean(httpd_client_t *cl)
+{
+    if (cl->chunk != NULL) {
+        httpd_ChunkRelease(cl->chunk);
+        cl->chunk = NULL;
+    } else
+        free(cl->p_buffer);
+    cl->p_buffer = NULL;
+}
+
+/* Moves the answer body to the data to send */
+static void httpd_ClientBufferSetBody(httpd_client_t *cl)
+{
+    httpd_ClientBufferClean(cl);
+    cl->p_buffer      = cl->answer.p_body;
+    cl->i_buffer_size = cl->answer.i_body;
+    cl->i_buffer      = 0;
+    cl->chunk         = cl->answer_chunk;
+
+    cl->answer.p_body = NULL;
+    cl->answer.i_body = 0;
+    cl->answer_chunk  = NULL;
+}
+
 static void httpd_ClientDestroy(httpd_client_t *cl)
 {
     vlc_list_remove(&cl->node);
     vlc_tls_Close(cl->sock);
+    if (cl->answer_chunk != NULL) {
+        cl->answer.p_body = NULL;
+        httpd_ChunkRelease(cl->answer_chunk);
+    }
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
-    free(cl->p_buffer);
+    httpd_ClientBufferClean(cl);
     free(cl);
 }
 
@@ -1585,9 +1720,9 @@ static void httpd_ClientSend(httpd_client_t *cl)
             i_size += strlen(cl->answer.p_headers[i].name) + 2 +
                       strlen(cl->answer.p_headers[i].value) + 2;
 
-        if (cl->i_buffer_size < i_size) {
+        if (cl->i_buffer_size < i_size || cl->chunk != NULL) {
             cl->i_buffer_size = i_size;
-            free(cl->p_buffer);
+            httpd_ClientBufferClean(cl);
             cl->p_buffer = xmalloc(i_size);
         }
         p = (char *)cl->p_buffer;
@@ -1625,13 +1760,7 @@ static void httpd_ClientSend(httpd_client_t *cl)
 
             if (cl->answer.i_body > 0) {
                 /* send the body data */
-                free(cl->p_buffer);
-                cl->p_buffer = cl->answer.p_body;
-                cl->i_buffer_size = cl->answer.i_body;
-                cl->i_buffer = 0;
-
-                cl->answer.i_body = 0;
-                cl->answer.p_body = NULL;
+                httpd_ClientBufferSetBody(cl);
             } else /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
         }
@@ -1916,7 +2045,7 @@ static void httpdLoop(httpd_host_t *host)
 
                         cl->i_buffer = 0;
                         cl->i_buffer_size = 1000;
-                        free(cl->p_buffer);
+                        httpd_ClientBufferClean(cl);
                         // Allocate an extra byte for the null terminating byte
                         cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
                         cl->i_state = HTTPD_CLIENT_RECEIVING;
@@ -1928,8 +2057,7 @@ static void httpdLoop(httpd_host_t *host)
                     httpd_MsgClean(&cl->answer);
 
                     cl->answer.i_body_offset = i_offset;
-                    free(cl->p_buffer);
-                    cl->p_buffer = NULL;
+                    httpd_ClientBufferClean(cl);
                     cl->i_buffer = 0;
                     cl->i_buffer_size = 0;
 
@@ -1948,12 +2076,9 @@ static void httpdLoop(httpd_host_t *host)
                         &cl->answer, &cl->query);
                 if (cl->answer.i_type != HTTPD_MSG_NONE) {
                     /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
+                    httpd_ClientBufferSetBody(cl);
                     cl->i_state = HTTPD_CLIENT_SENDING;
+                    pufd->events = POLLOUT;
                 }
         }
 
@@ -1961,18 +2086,19 @@ static void httpdLoop(httpd_host_t *host)
 
         if (pufd->events != 0)
             nfd++;
-        else
-            b_low_delay = true;
+        else if (cl->i_state != HTTPD_CLIENT_WAITING)
+            b_low_delay = true; /* waiting clients are woken by their stream */
     }
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
 
-    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-    while (poll(ufd, nfd, b_low_delay ? 20 : -1) < 0)
-    {
-        if (errno != EINTR)
-            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
-    }
+    /* we will wait 20ms (not too big) if some clients need processing,
+     * or until a stream has new data */
+    /* only the poll is interruptible, not the URL callbacks */
+    vlc_interrupt_set(host->interrupt);
+    if (vlc_poll_i11e(ufd, nfd, b_low_delay ? 20 : -1) < 0 && errno != EINTR)
+        msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+    vlc_interrupt_set(NULL);
 
     canc = vlc_savecancel();
     vlc_mutex_lock(&host->lock);
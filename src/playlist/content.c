@@ -39,6 +39,13 @@ vlc_playlist_ClearItems(vlc_playlist_t *playlist)
     vlc_vector_clear(&playlist->items);
 }
 
+void
+vlc_playlist_UpdateIndexes(vlc_playlist_t *playlist, size_t from, size_t to)
+{
+    for (size_t i = from; i < to; ++i)
+        playlist->items.data[i]->index = i;
+}
+
 static void
 vlc_playlist_ItemsReset(vlc_playlist_t *playlist)
 {
@@ -60,6 +67,8 @@ vlc_playlist_ItemsReset(vlc_playlist_t *playlist)
 static void
 vlc_playlist_ItemsInserted(vlc_playlist_t *playlist, size_t index, size_t count)
 {
+    vlc_playlist_UpdateIndexes(playlist, index, playlist->items.size);
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
         randomizer_Add(&playlist->randomizer,
                        &playlist->items.data[index], count);
@@ -79,7 +88,7 @@ vlc_playlist_ItemsInserted(vlc_playlist_t *playlist, size_t index, size_t count)
     for (size_t i = index; i < index + count; ++i)
     {
         vlc_playlist_item_t *item = playlist->items.data[i];
-        vlc_playlist_AutoPreparse(playlist, item->media);
+        vlc_playlist_AutoPreparse(playlist, item);
     }
 }
 
@@ -87,6 +96,11 @@ static void
 vlc_playlist_ItemsMoved(vlc_playlist_t *playlist, size_t index, size_t count,
                         size_t target)
 {
+    if (index < target)
+        vlc_playlist_UpdateIndexes(playlist, index, target + count);
+    else
+        vlc_playlist_UpdateIndexes(playlist, target, index + count);
+
     struct vlc_playlist_state state;
     vlc_playlist_state_Save(playlist, &state);
 
@@ -175,7 +189,7 @@ vlc_playlist_ItemReplaced(vlc_playlist_t *playlist, size_t index)
                         &playlist->items.data[index], 1);
     vlc_playlist_state_NotifyChanges(playlist, &state);
 
-    vlc_playlist_AutoPreparse(playlist, playlist->items.data[index]->media);
+    vlc_playlist_AutoPreparse(playlist, playlist->items.data[index]);
 }
 
 size_t
@@ -197,9 +211,11 @@ vlc_playlist_IndexOf(vlc_playlist_t *playlist, const vlc_playlist_item_t *item)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    ssize_t index;
-    vlc_vector_index_of(&playlist->items, item, &index);
-    return index;
+    /* the item may have been removed, or even belong to another playlist */
+    if (item->index < playlist->items.size
+            && playlist->items.data[item->index] == item)
+        return item->index;
+    return -1;
 }
 
 ssize_t
@@ -314,6 +330,7 @@ vlc_playlist_Remove(vlc_playlist_t *playlist, size_t index, size_t count)
         vlc_playlist_item_Release(playlist->items.data[index + i]);
 
     vlc_vector_remove_slice(&playlist->items, index, count);
+    vlc_playlist_UpdateIndexes(playlist, index, playlist->items.size);
 
     bool current_media_changed = vlc_playlist_ItemsRemoved(playlist, index,
                                                            count);
@@ -344,6 +361,7 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
 
     vlc_playlist_item_Release(playlist->items.data[index]);
     playlist->items.data[index] = item;
+    item->index = index;
 
     vlc_playlist_ItemReplaced(playlist, index);
     return VLC_SUCCESS;
@@ -28,6 +28,10 @@ typedef struct input_item_t input_item_t;
 void
 vlc_playlist_ClearItems(vlc_playlist_t *playlist);
 
+/* update the index of the items in [from, to), after they moved */
+void
+vlc_playlist_UpdateIndexes(vlc_playlist_t *playlist, size_t from, size_t to);
+
 /* expand an item (replace it by the given media array) */
 int
 vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
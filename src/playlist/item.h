@@ -30,6 +30,7 @@ struct vlc_playlist_item
 {
     input_item_t *media;
     uint64_t id;
+    size_t index; /**< position in the playlist, kept up to date by content.c */
     vlc_atomic_rc_t rc;
 };
 
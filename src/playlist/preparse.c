@@ -76,34 +76,75 @@ vlc_playlist_ExpandItemFromNode(vlc_playlist_t *playlist,
     return vlc_playlist_ExpandItem(playlist, index, subitems);
 }
 
+/* context of a preparsing request */
+struct vlc_playlist_preparse
+{
+    vlc_playlist_t *playlist;
+    /* the item to update, to avoid searching the media in the whole playlist
+     * (NULL if unknown) */
+    vlc_playlist_item_t *item;
+};
+
+static ssize_t
+vlc_playlist_preparse_IndexOf(struct vlc_playlist_preparse *req,
+                              input_item_t *media)
+{
+    vlc_playlist_t *playlist = req->playlist;
+    ssize_t index = -1;
+
+    if (req->item)
+        index = vlc_playlist_IndexOf(playlist, req->item);
+    if (index == -1)
+        /* expanded, moved to another item or not known */
+        index = vlc_playlist_IndexOfMedia(playlist, media);
+    return index;
+}
+
 static void
 on_subtree_added(input_item_t *media, input_item_node_t *subtree,
                  void *userdata)
 {
     VLC_UNUSED(media); /* retrieved by subtree->p_item */
-    vlc_playlist_t *playlist = userdata;
+    struct vlc_playlist_preparse *req = userdata;
+    vlc_playlist_t *playlist = req->playlist;
 
     vlc_playlist_Lock(playlist);
-    vlc_playlist_ExpandItemFromNode(playlist, subtree);
+    ssize_t index = vlc_playlist_preparse_IndexOf(req, subtree->p_item);
+    if (index != -1)
+        /* replace the item by its flatten subtree */
+        vlc_playlist_ExpandItem(playlist, index, subtree);
     vlc_playlist_Unlock(playlist);
 }
 
+static void
+vlc_playlist_preparse_Delete(struct vlc_playlist_preparse *req)
+{
+    if (req->item)
+        vlc_playlist_item_Release(req->item);
+    free(req);
+}
+
 static void
 on_preparse_ended(input_item_t *media,
                   enum input_item_preparse_status status, void *userdata)
 {
-    VLC_UNUSED(media); /* retrieved by subtree->p_item */
-    vlc_playlist_t *playlist = userdata;
+    struct vlc_playlist_preparse *req = userdata;
+    vlc_playlist_t *playlist = req->playlist;
 
     if (status != ITEM_PREPARSE_DONE)
+    {
+        vlc_playlist_preparse_Delete(req);
         return;
+    }
 
     vlc_playlist_Lock(playlist);
-    ssize_t index = vlc_playlist_IndexOfMedia(playlist, media);
+    ssize_t index = vlc_playlist_preparse_IndexOf(req, media);
     if (index != -1)
         vlc_playlist_Notify(playlist, on_items_updated, index,
                             &playlist->items.data[index], 1);
     vlc_playlist_Unlock(playlist);
+
+    vlc_playlist_preparse_Delete(req);
 }
 
 static const input_preparser_callbacks_t input_preparser_callbacks = {
@@ -111,25 +152,46 @@ static const input_preparser_callbacks_t input_preparser_callbacks = {
     .on_subtree_added = on_subtree_added,
 };
 
-void
-vlc_playlist_Preparse(vlc_playlist_t *playlist, input_item_t *input)
+static void
+Preparse(vlc_playlist_t *playlist, vlc_playlist_item_t *item,
+         input_item_t *input, input_item_meta_request_option_t options)
 {
 #ifdef TEST_PLAYLIST
     VLC_UNUSED(playlist);
+    VLC_UNUSED(item);
     VLC_UNUSED(input);
+    VLC_UNUSED(options);
     VLC_UNUSED(input_preparser_callbacks);
 #else
+    struct vlc_playlist_preparse *req = malloc(sizeof(*req));
+    if (unlikely(!req))
+        return;
+
+    req->playlist = playlist;
+    req->item = item;
+    if (item)
+        vlc_playlist_item_Hold(item);
+
     /* vlc_MetadataRequest is not exported */
-    vlc_MetadataRequest(playlist->libvlc, input,
-                        META_REQUEST_OPTION_SCOPE_LOCAL |
-                        META_REQUEST_OPTION_FETCH_LOCAL,
-                        &input_preparser_callbacks, playlist, -1, NULL);
+    int ret = vlc_MetadataRequest(playlist->libvlc, input,
+                                  META_REQUEST_OPTION_SCOPE_LOCAL |
+                                  META_REQUEST_OPTION_FETCH_LOCAL | options,
+                                  &input_preparser_callbacks, req, -1, NULL);
+    if (ret != VLC_SUCCESS)
+        vlc_playlist_preparse_Delete(req);
 #endif
 }
 
 void
-vlc_playlist_AutoPreparse(vlc_playlist_t *playlist, input_item_t *input)
+vlc_playlist_Preparse(vlc_playlist_t *playlist, input_item_t *input)
+{
+    Preparse(playlist, NULL, input, META_REQUEST_OPTION_NONE);
+}
+
+void
+vlc_playlist_AutoPreparse(vlc_playlist_t *playlist, vlc_playlist_item_t *item)
 {
-    if (playlist->auto_preparse && !input_item_IsPreparsed(input))
-        vlc_playlist_Preparse(playlist, input);
+    /* items added in bulk must not delay the explicit requests */
+    if (playlist->auto_preparse && !input_item_IsPreparsed(item->media))
+        Preparse(playlist, item, item->media, META_REQUEST_OPTION_BACKGROUND);
 }
@@ -25,9 +25,10 @@
 
 typedef struct vlc_playlist vlc_playlist_t;
 typedef struct input_item_node_t input_item_node_t;
+typedef struct vlc_playlist_item vlc_playlist_item_t;
 
 void
-vlc_playlist_AutoPreparse(vlc_playlist_t *playlist, input_item_t *input);
+vlc_playlist_AutoPreparse(vlc_playlist_t *playlist, vlc_playlist_item_t *item);
 
 int
 vlc_playlist_ExpandItem(vlc_playlist_t *playlist, size_t index,
@@ -24,6 +24,7 @@
 
 #include <vlc_common.h>
 #include <vlc_rand.h>
+#include "content.h"
 #include "control.h"
 #include "item.h"
 #include "notify.h"
@@ -56,6 +57,7 @@ vlc_playlist_Shuffle(vlc_playlist_t *playlist)
         playlist->items.data[i] = playlist->items.data[selected];
         playlist->items.data[selected] = tmp;
     }
+    vlc_playlist_UpdateIndexes(playlist, 0, playlist->items.size);
 
     struct vlc_playlist_state state;
     if (current)
@@ -23,8 +23,11 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_charset.h>
+#include <vlc_cpu.h>
 #include <vlc_rand.h>
 #include <vlc_sort.h>
+#include "content.h"
 #include "control.h"
 #include "item.h"
 #include "notify.h"
@@ -33,6 +36,9 @@
 /**
  * Struct containing a copy of (parsed) media metadata, used for sorting
  * without locking all the items.
+ *
+ * The strings are collation keys (see vlc_strcasefold()), so that they can be
+ * compared with strcmp().
  */
 struct vlc_playlist_item_meta {
     vlc_playlist_item_t *item;
@@ -58,7 +64,7 @@ vlc_playlist_item_meta_CopyString(const char **to, const char *from)
 {
     if (from)
     {
-        *to = strdup(from);
+        *to = vlc_strcasefold(from);
         if (unlikely(!*to))
             return VLC_ENOMEM;
     }
@@ -187,43 +193,28 @@ vlc_playlist_item_meta_InitFields(struct vlc_playlist_item_meta *meta,
     return VLC_SUCCESS;
 }
 
-static struct vlc_playlist_item_meta *
-vlc_playlist_item_meta_New(vlc_playlist_item_t *item,
-                           const struct vlc_playlist_sort_criterion criteria[],
-                           size_t count)
+static int
+vlc_playlist_item_meta_Init(struct vlc_playlist_item_meta *meta,
+                            vlc_playlist_item_t *item,
+                            const struct vlc_playlist_sort_criterion criteria[],
+                            size_t count)
 {
     /* assume that NULL representation is all-zeros */
-    struct vlc_playlist_item_meta *meta = calloc(1, sizeof(*meta));
-    if (unlikely(!meta))
-        return NULL;
-
+    memset(meta, 0, sizeof(*meta));
     meta->item = item;
 
     vlc_mutex_lock(&item->media->lock);
     int ret = vlc_playlist_item_meta_InitFields(meta, criteria, count);
     vlc_mutex_unlock(&item->media->lock);
 
-    if (unlikely(ret != VLC_SUCCESS))
-    {
-        free(meta);
-        return NULL;
-    }
-
-    return meta;
-}
-
-static void
-vlc_playlist_item_meta_Delete(struct vlc_playlist_item_meta *meta)
-{
-    vlc_playlist_item_meta_DestroyFields(meta);
-    free(meta);
+    return ret;
 }
 
 static inline int
 CompareStrings(const char *a, const char *b)
 {
     if (a && b)
-        return strcasecmp(a, b);
+        return strcmp(a, b);
     if (!a && !b)
         return 0;
     return a ? 1 : -1;
@@ -321,42 +312,205 @@ compare_meta(const void *lhs, const void *rhs, void *userdata)
     return 0;
 }
 
+/* the sort keys of all the items, extracted once per sort */
+struct vlc_playlist_sort_keys
+{
+    struct vlc_playlist_item_meta *metas;
+    struct vlc_playlist_item_meta **array; /* to be sorted */
+    size_t count;
+};
+
 static void
-vlc_playlist_DeleteMetaArray(struct vlc_playlist_item_meta *array[],
-                             size_t count)
+vlc_playlist_sort_keys_Destroy(struct vlc_playlist_sort_keys *keys)
 {
-    for (size_t i = 0; i < count; ++i)
-        vlc_playlist_item_meta_Delete(array[i]);
-    free(array);
+    for (size_t i = 0; i < keys->count; ++i)
+        vlc_playlist_item_meta_DestroyFields(&keys->metas[i]);
+    free(keys->metas);
+    free(keys->array);
 }
 
-static struct vlc_playlist_item_meta **
-vlc_playlist_NewMetaArray(vlc_playlist_t *playlist,
+static int
+vlc_playlist_sort_keys_Init(struct vlc_playlist_sort_keys *keys,
+        vlc_playlist_t *playlist,
         const struct vlc_playlist_sort_criterion criteria[], size_t count)
 {
-    struct vlc_playlist_item_meta **array =
-            vlc_alloc(playlist->items.size, sizeof(*array));
+    size_t size = playlist->items.size;
 
-    if (unlikely(!array))
-        return NULL;
+    /* one allocation for all the items, there may be a lot of them */
+    keys->metas = vlc_alloc(size, sizeof(*keys->metas));
+    keys->array = vlc_alloc(size, sizeof(*keys->array));
+    keys->count = 0;
+    if (unlikely(!keys->metas || !keys->array))
+    {
+        vlc_playlist_sort_keys_Destroy(keys);
+        return VLC_ENOMEM;
+    }
 
-    size_t i;
-    for (i = 0; i < playlist->items.size; ++i)
+    for (size_t i = 0; i < size; ++i)
     {
-        array[i] = vlc_playlist_item_meta_New(playlist->items.data[i],
+        struct vlc_playlist_item_meta *meta = &keys->metas[i];
+        int ret = vlc_playlist_item_meta_Init(meta, playlist->items.data[i],
                                               criteria, count);
-        if (unlikely(!array[i]))
-            break;
+        if (unlikely(ret != VLC_SUCCESS))
+        {
+            /* the fields of the failed item are already destroyed */
+            vlc_playlist_sort_keys_Destroy(keys);
+            return ret;
+        }
+        keys->array[i] = meta;
+        keys->count = i + 1;
     }
 
-    if (i < playlist->items.size)
+    return VLC_SUCCESS;
+}
+
+/* merge two sorted runs into dst, the first run comes first on equal keys */
+static void
+MergeRuns(struct vlc_playlist_item_meta **dst,
+          struct vlc_playlist_item_meta *const *a, size_t count_a,
+          struct vlc_playlist_item_meta *const *b, size_t count_b,
+          struct sort_request *req)
+{
+    size_t i = 0, j = 0;
+    while (i < count_a && j < count_b)
     {
-        /* allocation failure */
-        vlc_playlist_DeleteMetaArray(array, i);
-        return NULL;
+        if (compare_meta(&b[j], &a[i], req) < 0)
+            *dst++ = b[j++];
+        else
+            *dst++ = a[i++];
     }
+    memcpy(dst, &a[i], (count_a - i) * sizeof(*dst));
+    memcpy(dst + count_a - i, &b[j], (count_b - j) * sizeof(*dst));
+}
+
+/* do not start threads for fewer items, it would cost more than it saves */
+#define SORT_ITEMS_PER_THREAD 16384
+#define SORT_MAX_THREADS 16
 
-    return array;
+struct sort_run
+{
+    struct vlc_playlist_item_meta **array;
+    size_t count;
+    struct sort_request *req;
+    vlc_thread_t thread;
+    bool started;
+};
+
+static void
+SortRun(struct sort_run *run)
+{
+    vlc_qsort(run->array, run->count, sizeof(*run->array), compare_meta,
+              run->req);
+}
+
+static void *
+SortRunThread(void *data)
+{
+    SortRun(data);
+    return NULL;
+}
+
+/**
+ * Sort an array, using several threads for large arrays: runs are sorted in
+ * parallel, then merged.
+ *
+ * tmp must be able to hold count items.
+ */
+static void
+SortParallel(struct vlc_playlist_item_meta **array, size_t count,
+             struct sort_request *req, struct vlc_playlist_item_meta **tmp)
+{
+    size_t nruns = count / SORT_ITEMS_PER_THREAD;
+    if (nruns > vlc_GetCPUCount())
+        nruns = vlc_GetCPUCount();
+    if (nruns > SORT_MAX_THREADS)
+        nruns = SORT_MAX_THREADS;
+
+    if (nruns < 2)
+    {
+        vlc_qsort(array, count, sizeof(*array), compare_meta, req);
+        return;
+    }
+
+    struct sort_run runs[SORT_MAX_THREADS];
+    size_t bounds[SORT_MAX_THREADS + 1];
+    for (size_t i = 0; i < nruns; ++i)
+    {
+        bounds[i] = count * i / nruns;
+        runs[i].array = &array[bounds[i]];
+        runs[i].count = count * (i + 1) / nruns - bounds[i];
+        runs[i].req = req;
+    }
+    bounds[nruns] = count;
+
+    /* the first run is sorted by the calling thread */
+    for (size_t i = 1; i < nruns; ++i)
+        runs[i].started = !vlc_clone(&runs[i].thread, SortRunThread, &runs[i],
+                                     VLC_THREAD_PRIORITY_LOW);
+    SortRun(&runs[0]);
+    for (size_t i = 1; i < nruns; ++i)
+    {
+        if (runs[i].started)
+            vlc_join(runs[i].thread, NULL);
+        else
+            SortRun(&runs[i]);
+    }
+
+    /* merge the runs pairwise, alternating between the two buffers */
+    struct vlc_playlist_item_meta **src = array, **dst = tmp;
+    while (nruns > 1)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < nruns; i += 2, ++n)
+        {
+            size_t begin = bounds[i];
+            size_t mid = bounds[i + 1];
+            size_t end = i + 2 <= nruns ? bounds[i + 2] : mid;
+            MergeRuns(&dst[begin], &src[begin], mid - begin,
+                      &src[mid], end - mid, req);
+            bounds[n] = begin;
+        }
+        bounds[n] = count;
+        nruns = n;
+
+        struct vlc_playlist_item_meta **swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != array)
+        memcpy(array, src, count * sizeof(*array));
+}
+
+/**
+ * Sort the keys, reusing the already sorted prefix.
+ *
+ * Sorting again after items have been appended (or without any change) is
+ * common, so only the remaining items are sorted then merged.
+ *
+ * Return false if the keys were already sorted.
+ */
+static bool
+vlc_playlist_sort_keys_Sort(struct vlc_playlist_sort_keys *keys,
+                            struct sort_request *req,
+                            struct vlc_playlist_item_meta **tmp)
+{
+    struct vlc_playlist_item_meta **array = keys->array;
+    size_t size = keys->count;
+
+    size_t sorted = 1;
+    while (sorted < size
+            && compare_meta(&array[sorted - 1], &array[sorted], req) <= 0)
+        ++sorted;
+
+    if (sorted >= size)
+        return false;
+
+    SortParallel(&array[sorted], size - sorted, req, tmp);
+
+    MergeRuns(tmp, array, sorted, &array[sorted], size - sorted, req);
+    memcpy(array, tmp, size * sizeof(*array));
+    return true;
 }
 
 int
@@ -367,24 +521,45 @@ vlc_playlist_Sort(vlc_playlist_t *playlist,
     assert(count > 0);
     vlc_playlist_AssertLocked(playlist);
 
+    if (playlist->items.size < 2)
+        /* nothing to sort */
+        return VLC_SUCCESS;
+
     vlc_playlist_item_t *current = playlist->current != -1
                                  ? playlist->items.data[playlist->current]
                                  : NULL;
 
-    struct vlc_playlist_item_meta **array =
-        vlc_playlist_NewMetaArray(playlist, criteria, count);
-    if (unlikely(!array))
+    struct vlc_playlist_sort_keys keys;
+    int ret = vlc_playlist_sort_keys_Init(&keys, playlist, criteria, count);
+    if (unlikely(ret != VLC_SUCCESS))
+        return ret;
+
+    struct vlc_playlist_item_meta **tmp =
+            vlc_alloc(keys.count, sizeof(*tmp));
+    if (unlikely(!tmp))
+    {
+        vlc_playlist_sort_keys_Destroy(&keys);
         return VLC_ENOMEM;
+    }
 
     struct sort_request req = { criteria, count };
 
-    vlc_qsort(array, playlist->items.size, sizeof(*array), compare_meta, &req);
+    bool changed = vlc_playlist_sort_keys_Sort(&keys, &req, tmp);
+    free(tmp);
+
+    if (!changed)
+    {
+        /* already sorted, do not reset the listeners */
+        vlc_playlist_sort_keys_Destroy(&keys);
+        return VLC_SUCCESS;
+    }
 
     /* apply the sorting result to the playlist */
     for (size_t i = 0; i < playlist->items.size; ++i)
-        playlist->items.data[i] = array[i]->item;
+        playlist->items.data[i] = keys.array[i]->item;
+    vlc_playlist_UpdateIndexes(playlist, 0, playlist->items.size);
 
-    vlc_playlist_DeleteMetaArray(array, playlist->items.size);
+    vlc_playlist_sort_keys_Destroy(&keys);
 
     struct vlc_playlist_state state;
     if (current)
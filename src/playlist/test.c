@@ -2349,6 +2349,74 @@ test_sort(void)
     vlc_playlist_Delete(playlist);
 }
 
+static void
+test_sort_incremental(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL);
+    assert(playlist);
+
+    input_item_t *media[8];
+    CreateDummyMediaArray(media, 8);
+
+    /* items 0 to 2 in order, then 5, 4, 3 */
+    input_item_t *initial[] = { media[0], media[1], media[2], media[5],
+                                media[4], media[3] };
+    int ret = vlc_playlist_Append(playlist, initial, 6);
+    assert(ret == VLC_SUCCESS);
+
+    struct vlc_playlist_callbacks cbs = {
+        .on_items_reset = callback_on_items_reset,
+    };
+
+    struct callback_ctx ctx = CALLBACK_CTX_INITIALIZER;
+    vlc_playlist_listener_id *listener =
+            vlc_playlist_AddListener(playlist, &cbs, &ctx, false);
+    assert(listener);
+
+    struct vlc_playlist_sort_criterion criteria[] = {
+        { VLC_PLAYLIST_SORT_KEY_TITLE, VLC_PLAYLIST_SORT_ORDER_ASCENDING },
+    };
+    vlc_playlist_Sort(playlist, criteria, 1);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        EXPECT_AT(i, i);
+        vlc_playlist_item_t *item = vlc_playlist_Get(playlist, i);
+        assert(vlc_playlist_IndexOf(playlist, item) == i);
+    }
+
+    assert(ctx.vec_items_reset.size == 1);
+    assert(ctx.vec_items_reset.data[0].count == 6);
+
+    callback_ctx_reset(&ctx);
+
+    /* already sorted, nothing to notify */
+    vlc_playlist_Sort(playlist, criteria, 1);
+    assert(ctx.vec_items_reset.size == 0);
+
+    /* insert items, the sorted prefix is merged with the rest */
+    input_item_t *appended[] = { media[7], media[6] };
+    ret = vlc_playlist_Insert(playlist, 3, appended, 2);
+    assert(ret == VLC_SUCCESS);
+
+    vlc_playlist_Sort(playlist, criteria, 1);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_AT(i, i);
+        vlc_playlist_item_t *item = vlc_playlist_Get(playlist, i);
+        assert(vlc_playlist_IndexOf(playlist, item) == i);
+    }
+
+    assert(ctx.vec_items_reset.size == 1);
+    assert(ctx.vec_items_reset.data[0].count == 8);
+
+    callback_ctx_destroy(&ctx);
+    vlc_playlist_RemoveListener(playlist, listener);
+    DestroyMediaArray(media, 8);
+    vlc_playlist_Delete(playlist);
+}
+
 #undef EXPECT_AT
 
 int main(void)
@@ -2384,6 +2452,7 @@ int main(void)
     test_random();
     test_shuffle();
     test_sort();
+    test_sort_incremental();
     return 0;
 }
 
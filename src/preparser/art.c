@@ -224,6 +224,71 @@ int input_FindArtInCache( input_item_t *p_item )
     return b_found ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
+/* Marker of a failed lookup, must not start with "art" */
+#define ART_NOT_FOUND_FILE "notfound"
+
+static char *ArtNotFoundName( input_item_t *p_item )
+{
+    const char *psz_artist, *psz_album, *psz_date;
+    char *psz_filename = NULL;
+
+    vlc_mutex_lock( &p_item->lock );
+    if( !p_item->p_meta )
+        goto end;
+
+    /* Only albums are remembered, the art URL is unknown by definition */
+    psz_artist = vlc_meta_Get( p_item->p_meta, vlc_meta_Artist );
+    psz_album = vlc_meta_Get( p_item->p_meta, vlc_meta_Album );
+    psz_date = vlc_meta_Get( p_item->p_meta, vlc_meta_Date );
+    if( EMPTY_STR(psz_artist) || EMPTY_STR(psz_album) )
+        goto end;
+
+    char *psz_path = ArtCacheGetDirPath( NULL, psz_artist, psz_album,
+                                         psz_date, NULL );
+    if( psz_path && asprintf( &psz_filename, "%s" DIR_SEP ART_NOT_FOUND_FILE,
+                              psz_path ) < 0 )
+        psz_filename = NULL;
+    free( psz_path );
+
+end:
+    vlc_mutex_unlock( &p_item->lock );
+    return psz_filename;
+}
+
+bool input_FindArtNotFoundInCache( input_item_t *p_item, time_t i_ttl )
+{
+    char *psz_filename = ArtNotFoundName( p_item );
+    if( !psz_filename )
+        return false;
+
+    struct stat s;
+    bool b_found = !vlc_stat( psz_filename, &s ) &&
+                   s.st_mtime + i_ttl > time( NULL );
+    free( psz_filename );
+    return b_found;
+}
+
+void input_SaveArtNotFound( input_item_t *p_item )
+{
+    char *psz_filename = ArtNotFoundName( p_item );
+    if( !psz_filename )
+        return;
+
+    char *psz_dir = strdup( psz_filename );
+    if( likely( psz_dir ) )
+    {
+        *strrchr( psz_dir, DIR_SEP_CHAR ) = '\0';
+        ArtCacheCreateDir( psz_dir );
+        free( psz_dir );
+    }
+
+    /* the modification time is the date of the lookup */
+    FILE *f = vlc_fopen( psz_filename, "wb" );
+    if( f )
+        fclose( f );
+    free( psz_filename );
+}
+
 static char * GetDirByItemUIDs( char *psz_uid )
 {
     char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
@@ -323,6 +388,13 @@ int input_SaveArt( vlc_object_t *obj, input_item_t *p_item,
         {
             msg_Dbg( obj, "album art saved to %s", psz_filename );
             input_item_SetArtURL( p_item, psz_uri );
+
+            char *psz_notfound = ArtNotFoundName( p_item );
+            if( psz_notfound )
+            {
+                vlc_unlink( psz_notfound );
+                free( psz_notfound );
+            }
         }
         fclose( f );
     }
@@ -30,5 +30,9 @@ int input_FindArtInCacheUsingItemUID( input_item_t * );
 int input_SaveArt( vlc_object_t *, input_item_t *,
                    const void *, size_t, const char *psz_type );
 
+/* Failed lookups, remembered for i_ttl seconds */
+bool input_FindArtNotFoundInCache( input_item_t *, time_t i_ttl );
+void input_SaveArtNotFound( input_item_t * );
+
 #endif
 
@@ -30,6 +30,7 @@
 #include <vlc_arrays.h>
 #include <vlc_threads.h>
 #include <vlc_memstream.h>
+#include <vlc_url.h>
 #include <vlc_meta_fetcher.h>
 
 #include "art.h"
@@ -39,12 +40,20 @@
 #include "misc/background_worker.h"
 #include "misc/interrupt.h"
 
+/* Failed network lookups are not retried before (seconds) */
+#define FETCHER_MISS_TTL (24 * 3600)
+/* Concurrent downloads from a single host */
+#define FETCHER_HOST_SLOTS 2
+
 struct input_fetcher_t {
     struct background_worker* local;
     struct background_worker* network;
     struct background_worker* downloader;
 
     vlc_dictionary_t album_cache;
+    vlc_dictionary_t miss_cache; /* expiry dates of the failed lookups */
+    vlc_dictionary_t host_slots; /* downloads in progress per host */
+    vlc_cond_t host_wait;
     vlc_object_t* owner;
     vlc_mutex_t lock;
 };
@@ -144,6 +153,127 @@ static void AddAlbumCache( input_fetcher_t* fetcher, input_item_t* item,
     free( key );
 }
 
+static char* CreateMissKey( input_item_t* item )
+{
+    char* key = CreateCacheKey( item );
+    if( key != NULL )
+        return key;
+
+    /* without album, remember the item itself */
+    vlc_mutex_lock( &item->lock );
+    if( asprintf( &key, "mrl:%s", item->psz_uri ) < 0 )
+        key = NULL;
+    vlc_mutex_unlock( &item->lock );
+    return key;
+}
+
+static bool ReadMissCache( input_fetcher_t* fetcher, input_item_t* item )
+{
+    char* key = CreateMissKey( item );
+
+    if( key == NULL )
+        return false;
+
+    vlc_mutex_lock( &fetcher->lock );
+    vlc_tick_t* expiry = vlc_dictionary_value_for_key( &fetcher->miss_cache,
+                                                       key );
+    bool miss = expiry && *expiry > vlc_tick_now();
+    if( expiry && !miss )
+        vlc_dictionary_remove_value_for_key( &fetcher->miss_cache, key,
+                                             FreeCacheEntry, NULL );
+    vlc_mutex_unlock( &fetcher->lock );
+
+    free( key );
+    return miss || input_FindArtNotFoundInCache( item, FETCHER_MISS_TTL );
+}
+
+static void AddMissCache( input_fetcher_t* fetcher, input_item_t* item )
+{
+    char* key = CreateMissKey( item );
+    vlc_tick_t* expiry = malloc( sizeof( *expiry ) );
+
+    if( key && expiry )
+    {
+        *expiry = vlc_tick_now() + VLC_TICK_FROM_SEC( FETCHER_MISS_TTL );
+
+        vlc_mutex_lock( &fetcher->lock );
+        vlc_dictionary_remove_value_for_key( &fetcher->miss_cache, key,
+                                             FreeCacheEntry, NULL );
+        vlc_dictionary_insert( &fetcher->miss_cache, key, expiry );
+        expiry = NULL;
+        vlc_mutex_unlock( &fetcher->lock );
+
+        input_SaveArtNotFound( item );
+    }
+
+    free( expiry );
+    free( key );
+}
+
+static void WakeHostSlots( void* fetcher_ )
+{
+    input_fetcher_t* fetcher = fetcher_;
+
+    vlc_mutex_lock( &fetcher->lock );
+    vlc_cond_broadcast( &fetcher->host_wait );
+    vlc_mutex_unlock( &fetcher->lock );
+}
+
+/* Number of downloads in progress from the host, with the lock held */
+static uintptr_t GetHostSlots( input_fetcher_t* fetcher, char const* host )
+{
+    void* slots = vlc_dictionary_value_for_key( &fetcher->host_slots, host );
+    return (uintptr_t)slots;
+}
+
+/* Waits until a download can start from the host of the URL, returns the
+ * host to give to ReleaseHostSlot() */
+static char* AcquireHostSlot( input_fetcher_t* fetcher, char const* psz_url )
+{
+    vlc_url_t url;
+    char* host = NULL;
+
+    if( vlc_UrlParse( &url, psz_url ) == 0 && url.psz_host )
+        host = strdup( url.psz_host );
+    vlc_UrlClean( &url );
+
+    if( host == NULL )
+        return NULL;
+
+    vlc_interrupt_register( WakeHostSlots, fetcher );
+    vlc_mutex_lock( &fetcher->lock );
+
+    uintptr_t count;
+    while( (count = GetHostSlots( fetcher, host )) >= FETCHER_HOST_SLOTS
+        && !vlc_killed() )
+        vlc_cond_wait( &fetcher->host_wait, &fetcher->lock );
+
+    vlc_dictionary_remove_value_for_key( &fetcher->host_slots, host,
+                                         NULL, NULL );
+    vlc_dictionary_insert( &fetcher->host_slots, host, (void*)(count + 1) );
+
+    vlc_mutex_unlock( &fetcher->lock );
+    vlc_interrupt_unregister();
+    return host;
+}
+
+static void ReleaseHostSlot( input_fetcher_t* fetcher, char* host )
+{
+    if( host == NULL )
+        return;
+
+    vlc_mutex_lock( &fetcher->lock );
+    uintptr_t count = GetHostSlots( fetcher, host );
+    vlc_dictionary_remove_value_for_key( &fetcher->host_slots, host,
+                                         NULL, NULL );
+    if( count > 1 )
+        vlc_dictionary_insert( &fetcher->host_slots, host, (void*)(count - 1) );
+    vlc_cond_broadcast( &fetcher->host_wait );
+    vlc_mutex_unlock( &fetcher->lock );
+
+    free( host );
+}
+
 static int InvokeModule( input_fetcher_t* fetcher, input_item_t* item,
                          int scope, char const* type )
 {
@@ -235,10 +365,14 @@ static void Downloader( input_fetcher_t* fetcher,
         !strncasecmp( psz_arturl, "attachment://", 13 ) )
         goto out; /* no fetch required */
 
+    char* host = AcquireHostSlot( fetcher, psz_arturl );
     stream_t* source = vlc_stream_NewURL( fetcher->owner, psz_arturl );
 
     if( !source )
+    {
+        ReleaseHostSlot( fetcher, host );
         goto error;
+    }
 
     struct vlc_memstream output_stream;
     vlc_memstream_open( &output_stream );
@@ -256,6 +390,7 @@ static void Downloader( input_fetcher_t* fetcher,
     }
 
     vlc_stream_Delete( source );
+    ReleaseHostSlot( fetcher, host );
 
     if( vlc_memstream_close( &output_stream ) )
         goto error;
@@ -308,8 +443,18 @@ static void SearchLocal( input_fetcher_t* fetcher, struct fetcher_request* req )
 
 static void SearchNetwork( input_fetcher_t* fetcher, struct fetcher_request* req )
 {
+    if( ReadMissCache( fetcher, req->item ) )
+    {
+        input_item_SetArtNotFound( req->item, true );
+        NotifyArtFetchEnded(req, false);
+        return;
+    }
+
     if( SearchByScope( fetcher, req, FETCHER_SCOPE_NETWORK ) )
     {
+        /* an interrupted lookup did not fail */
+        if( CheckArt( req->item ) && !vlc_killed() )
+            AddMissCache( fetcher, req->item );
         input_item_SetArtNotFound( req->item, true );
         NotifyArtFetchEnded(req, false);
     }
@@ -404,6 +549,9 @@ static void WorkerInit( input_fetcher_t* fetcher,
     struct background_worker_config conf = {
         .default_timeout = 0,
         .max_threads = var_InheritInteger( fetcher->owner, "fetch-art-threads" ),
+        /* art is fetched after preparsing, and downloads can be slow */
+        .priority = -1,
+        .obj = fetcher->owner,
         .pf_start = starter,
         .pf_probe = ProbeWorker,
         .pf_stop = CloseWorker,
@@ -443,6 +591,9 @@ input_fetcher_t* input_fetcher_New( vlc_object_t* owner )
 
     vlc_mutex_init( &fetcher->lock );
     vlc_dictionary_init( &fetcher->album_cache, 0 );
+    vlc_dictionary_init( &fetcher->miss_cache, 0 );
+    vlc_dictionary_init( &fetcher->host_slots, 0 );
+    vlc_cond_init( &fetcher->host_wait );
 
     return fetcher;
 }
@@ -481,5 +632,7 @@ void input_fetcher_Delete( input_fetcher_t* fetcher )
     background_worker_Delete( fetcher->downloader );
 
     vlc_dictionary_clear( &fetcher->album_cache, FreeCacheEntry, NULL );
+    vlc_dictionary_clear( &fetcher->miss_cache, FreeCacheEntry, NULL );
+    vlc_dictionary_clear( &fetcher->host_slots, NULL, NULL );
     free( fetcher );
 }
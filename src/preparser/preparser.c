@@ -36,6 +36,7 @@ struct input_preparser_t
     vlc_object_t* owner;
     input_fetcher_t* fetcher;
     struct background_worker* worker;
+    struct background_worker* bulk_worker; /* META_REQUEST_OPTION_BACKGROUND */
     atomic_bool deactivated;
 };
 
@@ -78,6 +79,13 @@ static input_preparser_req_t *ReqCreate(input_item_t *item,
     return req;
 }
 
+static struct background_worker *
+ReqWorker(input_preparser_t *preparser, input_item_meta_request_option_t opts)
+{
+    return opts & META_REQUEST_OPTION_BACKGROUND ? preparser->bulk_worker
+                                               : preparser->worker;
+}
+
 static void ReqHold(input_preparser_req_t *req)
 {
     vlc_atomic_rc_inc(&req->rc);
@@ -99,7 +107,8 @@ static void OnParserEnded(input_item_t *item, int status, void *task_)
 
     atomic_store( &task->state, status );
     atomic_store( &task->done, true );
-    background_worker_RequestProbe( task->preparser->worker );
+    background_worker_RequestProbe( ReqWorker( task->preparser,
+                                               task->req->options ) );
 }
 
 static void OnParserSubtreeAdded(input_item_t *item, input_item_node_t *subtree,
@@ -230,6 +239,7 @@ input_preparser_t* input_preparser_New( vlc_object_t *parent )
     struct background_worker_config conf = {
         .default_timeout = VLC_TICK_FROM_MS(var_InheritInteger( parent, "preparse-timeout" )),
         .max_threads = var_InheritInteger( parent, "preparse-threads" ),
+        .obj = parent,
         .pf_start = PreparserOpenInput,
         .pf_probe = PreparserProbeInput,
         .pf_stop = PreparserCloseInput,
@@ -237,12 +247,25 @@ input_preparser_t* input_preparser_New( vlc_object_t *parent )
         .pf_hold = ReqHoldVoid
     };
 
+    if( unlikely( !preparser ) )
+        return NULL;
 
-    if( likely( preparser ) )
-        preparser->worker = background_worker_New( preparser, &conf );
+    /* Interactive requests get their own lane, served before the bulk one by
+     * the shared threads, so that they never wait behind a whole playlist */
+    conf.priority = 1;
+    preparser->worker = background_worker_New( preparser, &conf );
+    if( unlikely( !preparser->worker ) )
+    {
+        free( preparser );
+        return NULL;
+    }
 
-    if( unlikely( !preparser || !preparser->worker ) )
+    conf.priority = 0;
+    preparser->bulk_worker = background_worker_New( preparser, &conf );
+    if( unlikely( !preparser->bulk_worker ) )
     {
+        background_worker_Delete( preparser->bulk_worker );
+    background_worker_Delete( preparser->worker );
         free( preparser );
         return NULL;
     }
@@ -263,7 +286,12 @@ void input_preparser_Push( input_preparser_t *preparser,
     int timeout, void *id )
 {
     if( atomic_load( &preparser->deactivated ) )
+    {
+        /* the callbacks own resources to release */
+        if (cbs && cbs->on_preparse_ended)
+            cbs->on_preparse_ended(item, ITEM_PREPARSE_SKIPPED, cbs_userdata);
         return;
+    }
 
     vlc_mutex_lock( &item->lock );
     enum input_item_type_e i_type = item->i_type;
@@ -290,7 +318,8 @@ void input_preparser_Push( input_preparser_t *preparser,
     struct input_preparser_req_t *req = ReqCreate(item, i_options,
                                                   cbs, cbs_userdata);
 
-    if (background_worker_Push(preparser->worker, req, id, timeout))
+    if (background_worker_Push(ReqWorker(preparser, i_options), req, id,
+                               timeout))
         if (req->cbs && cbs->on_preparse_ended)
             cbs->on_preparse_ended(item, ITEM_PREPARSE_FAILED, cbs_userdata);
 
@@ -309,12 +338,14 @@ void input_preparser_fetcher_Push( input_preparser_t *preparser,
 void input_preparser_Cancel( input_preparser_t *preparser, void *id )
 {
     background_worker_Cancel( preparser->worker, id );
+    background_worker_Cancel( preparser->bulk_worker, id );
 }
 
 void input_preparser_Deactivate( input_preparser_t* preparser )
 {
     atomic_store( &preparser->deactivated, true );
     background_worker_Cancel( preparser->worker, NULL );
+    background_worker_Cancel( preparser->bulk_worker, NULL );
 }
 
 void input_preparser_Delete( input_preparser_t *preparser )
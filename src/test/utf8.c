@@ -123,6 +123,21 @@ static void test_strcasestr (const char *h, const char *n, ssize_t offset)
 }
 
 
+static void test_strcasefold (const char *in, const char *out)
+{
+    printf ("\"%s\" should be folded as \"%s\"...\n", in, out);
+
+    char *key = vlc_strcasefold (in);
+    if (key == NULL)
+        abort ();
+    if (strcmp (key, out))
+    {
+        printf ("ERROR: got \"%s\"\n", key);
+        exit (13);
+    }
+    free (key);
+}
+
 int main (void)
 {
     (void)setvbuf (stdout, NULL, _IONBF, 0);
@@ -189,5 +204,10 @@ int main (void)
     test_strcasestr ("Télé", "élé", 1);
     test_strcasestr ("Télé", "léé", -1);
 
+    test_strcasefold ("", "");
+    test_strcasefold ("heLLo", "hello");
+    test_strcasefold ("T\xC3\xA9l\xC3\xA9", "t\xC3\xA9l\xC3\xA9");
+    test_strcasefold ("T\xE9l\xE9", "t\xE9l\xE9"); /* kept as is */
+
     return 0;
 }
@@ -228,6 +228,62 @@ char *vlc_strcasestr (const char *haystack, const char *needle)
     return NULL;
 }
 
+/**
+ * Computes a key to compare UTF-8 strings in a case-insensitive fashion.
+ * Comparing the keys of two strings with strcmp() is equivalent to comparing
+ * their lower case code points, which makes sorting many strings much faster
+ * than folding the case on each comparison. Invalid sequences are kept as is.
+ *
+ * @param str nul-terminated UTF-8 string
+ * @return the key to free() with free(), or NULL on allocation error
+ */
+char *vlc_strcasefold (const char *str)
+{
+    /* folding may lengthen a character, by one byte at most */
+    size_t len = strlen (str);
+    char *key = malloc (len + len / 2 + 4), *out = key;
+    if (unlikely(key == NULL))
+        return NULL;
+
+    while (*str != '\0')
+    {
+        uint32_t cp;
+        size_t s = vlc_towc (str, &cp);
+
+        if (unlikely(s == (size_t)-1))
+        {
+            *(out++) = *(str++);
+            continue;
+        }
+        str += s;
+
+        if (sizeof (wint_t) > 2 || cp < 0x10000) /* 16-bits on Windows */
+            cp = towlower (cp);
+        if (cp < 0x80)
+            *(out++) = cp;
+        else if (cp < 0x800)
+        {
+            *(out++) = 0xC0 | (cp >> 6);
+            *(out++) = 0x80 | (cp & 0x3F);
+        }
+        else if (cp < 0x10000)
+        {
+            *(out++) = 0xE0 | (cp >> 12);
+            *(out++) = 0x80 | ((cp >> 6) & 0x3F);
+            *(out++) = 0x80 | (cp & 0x3F);
+        }
+        else
+        {
+            *(out++) = 0xF0 | (cp >> 18);
+            *(out++) = 0x80 | ((cp >> 12) & 0x3F);
+            *(out++) = 0x80 | ((cp >> 6) & 0x3F);
+            *(out++) = 0x80 | (cp & 0x3F);
+        }
+    }
+    *out = '\0';
+    return key;
+}
+
 /**
  * Converts a string from the given character encoding to utf-8.
  *
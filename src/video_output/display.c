@@ -418,6 +418,29 @@ picture_pool_t *vout_GetPool(vout_display_t *vd, unsigned count)
     return osys->pool;
 }
 
+/**
+ * It retrieves a pool for the decoder from the display, if the decoder
+ * pictures reach it unconverted
+ */
+picture_pool_t *vout_display_GetDecoderPool(vout_display_t *vd,
+                                            const video_format_t *fmt,
+                                            unsigned count)
+{
+    const video_format_t *source = &vd->source;
+
+    if (vd->pool == NULL || vout_IsDisplayFiltered(vd))
+        return NULL;
+
+    /* The pictures must have the planes the decoder expects */
+    if (fmt->i_chroma != source->i_chroma
+     || fmt->i_width != source->i_width || fmt->i_height != source->i_height
+     || fmt->i_visible_width != source->i_visible_width
+     || fmt->i_visible_height != source->i_visible_height)
+        return NULL;
+
+    return vd->pool(vd, count);
+}
+
 bool vout_IsDisplayFiltered(vout_display_t *vd)
 {
     vout_display_priv_t *osys = container_of(vd, vout_display_priv_t, display);
@@ -760,6 +783,7 @@ vout_display_t *vout_display_New(vlc_object_t *parent,
     vd->prepare = NULL;
     vd->display = NULL;
     vd->control = NULL;
+    vd->pool = NULL;
     vd->close = NULL;
     vd->sys = NULL;
     if (owner)
@@ -36,9 +36,28 @@
 #include <vlc_strings.h>
 #include <vlc_block.h>
 #include <vlc_vout.h>
+#include <vlc_list.h>
 
 #include "snapshot.h"
 #include "vout_internal.h"
+#include "../misc/background_worker.h"
+
+/* Maximum number of asynchronous requests waiting for a picture or being
+ * encoded, per video output */
+#define SNAPSHOT_ASYNC_MAX 4
+
+struct vout_snapshot_request {
+    vout_snapshot_t *snap;
+    vlc_fourcc_t    codec;
+    int             width;
+    int             height;
+    vout_snapshot_cb cb;
+    void            *data;
+
+    picture_t       *picture; /* set when the picture is grabbed */
+    bool            done;     /* true once the callback was invoked */
+    struct vlc_list node;
+};
 
 struct vout_snapshot {
     vlc_mutex_t lock;
@@ -48,28 +67,129 @@ struct vout_snapshot {
     int         request_count;
     picture_t   *picture;
 
+    /* Asynchronous requests, encoded by the worker */
+    vlc_object_t *obj;
+    struct background_worker *worker;
+    struct vlc_list async; /* requests waiting for a picture */
+    unsigned    async_count; /* requests waiting or queued to the worker */
 };
 
-vout_snapshot_t *vout_snapshot_New(void)
+static void RequestRelease(void *entity)
+{
+    struct vout_snapshot_request *req = entity;
+    vout_snapshot_t *snap = req->snap;
+
+    if (!req->done)
+        req->cb(req->data, NULL, NULL);
+    if (req->picture != NULL)
+        picture_Release(req->picture);
+    free(req);
+
+    vlc_mutex_lock(&snap->lock);
+    assert(snap->async_count > 0);
+    snap->async_count--;
+    vlc_mutex_unlock(&snap->lock);
+}
+
+static void RequestHold(void *entity)
+{
+    VLC_UNUSED(entity);
+}
+
+/* The encoding is done synchronously, on the shared worker thread */
+static int RequestStart(void *owner, void *entity, void **out)
+{
+    vout_snapshot_t *snap = owner;
+    struct vout_snapshot_request *req = entity;
+    block_t *image;
+    video_format_t fmt;
+
+    if (picture_Export(snap->obj, &image, &fmt, req->picture, req->codec,
+                       req->width, req->height, false)) {
+        msg_Err(snap->obj, "Failed to convert image for snapshot");
+        req->cb(req->data, NULL, NULL);
+    } else
+        req->cb(req->data, image, &fmt);
+    req->done = true;
+
+    *out = req;
+    return VLC_SUCCESS;
+}
+
+static int RequestProbe(void *owner, void *handle)
+{
+    VLC_UNUSED(owner); VLC_UNUSED(handle);
+    return 1;
+}
+
+static void RequestStop(void *owner, void *handle)
+{
+    VLC_UNUSED(owner); VLC_UNUSED(handle);
+}
+
+vout_snapshot_t *vout_snapshot_New(vlc_object_t *obj)
 {
     vout_snapshot_t *snap = malloc(sizeof (*snap));
     if (unlikely(snap == NULL))
         return NULL;
 
+    struct background_worker_config conf = {
+        .default_timeout = 0,
+        .max_threads = 1,
+        /* periodic monitoring snapshots must not delay playback start */
+        .priority = -1,
+        .obj = obj,
+        .pf_start = RequestStart,
+        .pf_probe = RequestProbe,
+        .pf_stop = RequestStop,
+        .pf_release = RequestRelease,
+        .pf_hold = RequestHold,
+    };
+    snap->worker = background_worker_New(snap, &conf);
+    if (unlikely(snap->worker == NULL)) {
+        free(snap);
+        return NULL;
+    }
+
     vlc_mutex_init(&snap->lock);
     vlc_cond_init(&snap->wait);
 
     snap->is_available = true;
     snap->request_count = 0;
     snap->picture = NULL;
+    snap->obj = obj;
+    vlc_list_init(&snap->async);
+    snap->async_count = 0;
     return snap;
 }
 
+/* Fails the requests still waiting for a picture */
+static void vout_snapshot_FailAsync(vout_snapshot_t *snap)
+{
+    struct vout_snapshot_request *req;
+
+    vlc_mutex_lock(&snap->lock);
+    while ((req = vlc_list_first_entry_or_null(&snap->async,
+                                               struct vout_snapshot_request,
+                                               node)) != NULL) {
+        vlc_list_remove(&req->node);
+        vlc_mutex_unlock(&snap->lock);
+        RequestRelease(req);
+        vlc_mutex_lock(&snap->lock);
+    }
+    vlc_mutex_unlock(&snap->lock);
+}
+
 void vout_snapshot_Destroy(vout_snapshot_t *snap)
 {
     if (snap == NULL)
         return;
 
+    /* Waits for the current encoding, and fails the queued ones */
+    background_worker_Delete(snap->worker);
+    vout_snapshot_FailAsync(snap);
+    assert(snap->async_count == 0);
+
     picture_t *picture = snap->picture;
     while (picture) {
         picture_t *next = picture->p_next;
@@ -91,6 +211,40 @@ void vout_snapshot_End(vout_snapshot_t *snap)
 
     vlc_cond_broadcast(&snap->wait);
     vlc_mutex_unlock(&snap->lock);
+
+    vout_snapshot_FailAsync(snap);
+}
+
+int vout_snapshot_GetAsync(vout_snapshot_t *snap, vlc_fourcc_t codec,
+                           int width, int height,
+                           vout_snapshot_cb cb, void *data)
+{
+    if (snap == NULL)
+        return VLC_EGENERIC;
+
+    struct vout_snapshot_request *req = malloc(sizeof (*req));
+    if (unlikely(req == NULL))
+        return VLC_ENOMEM;
+
+    req->snap = snap;
+    req->codec = codec;
+    req->width = width;
+    req->height = height;
+    req->cb = cb;
+    req->data = data;
+    req->picture = NULL;
+    req->done = false;
+
+    vlc_mutex_lock(&snap->lock);
+    if (!snap->is_available || snap->async_count >= SNAPSHOT_ASYNC_MAX) {
+        vlc_mutex_unlock(&snap->lock);
+        free(req);
+        return VLC_EGENERIC;
+    }
+    vlc_list_append(&req->node, &snap->async);
+    snap->async_count++;
+    vlc_mutex_unlock(&snap->lock);
+    return VLC_SUCCESS;
 }
 
 /* */
@@ -129,7 +283,8 @@ bool vout_snapshot_IsRequested(vout_snapshot_t *snap)
 
     bool has_request = false;
     if (!vlc_mutex_trylock(&snap->lock)) {
-        has_request = snap->request_count > 0;
+        has_request = snap->request_count > 0
+                   || !vlc_list_is_empty(&snap->async);
         vlc_mutex_unlock(&snap->lock);
     }
     return has_request;
@@ -158,7 +313,28 @@ void vout_snapshot_Set(vout_snapshot_t *snap,
         snap->request_count--;
     }
     vlc_cond_broadcast(&snap->wait);
+
+    struct vlc_list grabbed;
+    struct vout_snapshot_request *req;
+
+    vlc_list_init(&grabbed);
+    vlc_list_foreach(req, &snap->async, node) {
+        req->picture = picture_Clone(picture);
+        if (!req->picture)
+            break;
+
+        video_format_CopyCrop(&req->picture->format, fmt);
+        vlc_list_remove(&req->node);
+        vlc_list_append(&req->node, &grabbed);
+    }
     vlc_mutex_unlock(&snap->lock);
+
+    /* The worker owns the requests from now on */
+    vlc_list_foreach(req, &grabbed, node) {
+        vlc_list_remove(&req->node);
+        if (background_worker_Push(snap->worker, req, NULL, -1))
+            RequestRelease(req);
+    }
 }
 /* */
 char *vout_snapshot_GetDirectory(void)
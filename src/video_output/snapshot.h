@@ -28,7 +28,7 @@
 typedef struct vout_snapshot vout_snapshot_t;
 
 /* */
-vout_snapshot_t *vout_snapshot_New(void);
+vout_snapshot_t *vout_snapshot_New(vlc_object_t *);
 void vout_snapshot_Destroy(vout_snapshot_t *);
 
 void vout_snapshot_End(vout_snapshot_t *);
@@ -36,6 +36,16 @@ void vout_snapshot_End(vout_snapshot_t *);
 /* */
 picture_t *vout_snapshot_Get(vout_snapshot_t *, vlc_tick_t timeout);
 
+/**
+ * It requests the next picture to be encoded on a background thread.
+ *
+ * The callback is invoked exactly once, from the worker thread or from
+ * vout_snapshot_End(), unless an error is returned.
+ */
+int vout_snapshot_GetAsync(vout_snapshot_t *, vlc_fourcc_t codec,
+                           int width, int height,
+                           vout_snapshot_cb cb, void *data);
+
 /**
  * It tells if they are pending snapshot request
  */
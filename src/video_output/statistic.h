@@ -23,6 +23,16 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
+# include <vlc_input_item.h>
+
+/* Latency histograms of the video output */
+enum vout_statistic_latency {
+    VOUT_STATISTIC_DISPLAY, /* preparation and display */
+    VOUT_STATISTIC_PREPARE, /* filtering, rendering and prepare */
+    VOUT_STATISTIC_PRESENT, /* display callback */
+    VOUT_STATISTIC_PRESENT_ERROR, /* reported presentation minus intended date */
+};
+#define VOUT_STATISTIC_LATENCIES 4
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
@@ -30,12 +40,16 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint latency[VOUT_STATISTIC_LATENCIES][INPUT_LATENCY_BUCKETS];
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    for (size_t i = 0; i < VOUT_STATISTIC_LATENCIES; i++)
+        for (size_t j = 0; j < INPUT_LATENCY_BUCKETS; j++)
+            atomic_init(&stat->latency[i][j], 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -45,11 +59,28 @@ static inline void vout_statistic_Clean(vout_statistic_t *stat)
 
 static inline void vout_statistic_GetReset(vout_statistic_t *stat,
                                            unsigned *restrict displayed,
-                                           unsigned *restrict lost)
+                                           unsigned *restrict lost,
+                                           input_latency_t *restrict latency)
 {
     *displayed = atomic_exchange_explicit(&stat->displayed, 0,
                                           memory_order_relaxed);
     *lost = atomic_exchange_explicit(&stat->lost, 0, memory_order_relaxed);
+
+    /* latencies are only added with displayed pictures */
+    for (size_t i = 0; i < VOUT_STATISTIC_LATENCIES; i++)
+        for (size_t j = 0; j < INPUT_LATENCY_BUCKETS; j++)
+            latency[i].buckets[j] = (*displayed > 0)
+                ? atomic_exchange_explicit(&stat->latency[i][j], 0,
+                                           memory_order_relaxed) : 0;
+}
+
+static inline void vout_statistic_AddLatency(vout_statistic_t *stat,
+                                             enum vout_statistic_latency which,
+                                             vlc_tick_t duration)
+{
+    atomic_fetch_add_explicit(
+        &stat->latency[which][input_latency_GetBucket(duration)],
+        1, memory_order_relaxed);
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -73,6 +73,9 @@
 /* Better be in advance when awakening than late... */
 #define VOUT_MWAIT_TOLERANCE VLC_TICK_FROM_MS(4)
 
+/* Presentation feedback older than this is not used to pace pictures */
+#define VOUT_PRESENT_TIMEOUT VLC_TICK_FROM_SEC(1)
+
 /* */
 static bool VoutCheckFormat(const video_format_t *src)
 {
@@ -217,10 +220,11 @@ static void vout_UpdateWindowSizeLocked(vout_thread_t *vout)
 
 /* */
 void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
-                            unsigned *restrict lost)
+                            unsigned *restrict lost,
+                            input_latency_t *restrict latency)
 {
     assert(!vout->p->dummy);
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, latency );
 }
 
 bool vout_IsEmpty(vout_thread_t *vout)
@@ -388,6 +392,24 @@ int vout_GetSnapshot(vout_thread_t *vout,
     return VLC_SUCCESS;
 }
 
+int vout_GetSnapshotAsync(vout_thread_t *vout, const char *type,
+                          int width, int height,
+                          vout_snapshot_cb cb, void *data)
+{
+    assert(!vout->p->dummy);
+
+    vlc_fourcc_t codec = VLC_CODEC_PNG;
+    if (type && image_Type2Fourcc(type))
+        codec = image_Type2Fourcc(type);
+
+    if (vout_snapshot_GetAsync(vout->p->snapshot, codec, width, height,
+                               cb, data)) {
+        msg_Err(vout, "Failed to request a snapshot");
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 /* vout_Control* are usable by anyone at anytime */
 void vout_ChangeFullscreen(vout_thread_t *vout, const char *id)
 {
@@ -1030,6 +1052,44 @@ static picture_t *ConvertRGB32AndBlend(vout_thread_t *vout, picture_t *pic,
     return NULL;
 }
 
+/* Accounts the presentation reported by the display since the last call, as
+ * the one of the picture intended at present.expected */
+static void ThreadUpdatePresented(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+    const vlc_tick_t date = atomic_load_explicit(&sys->present.date,
+                                                 memory_order_acquire);
+    if (date == sys->present.last)
+        return;
+
+    sys->present.last = date;
+    sys->present.period = atomic_load_explicit(&sys->present.refresh,
+                                               memory_order_relaxed);
+    if (sys->present.expected != VLC_TICK_INVALID)
+    {
+        vout_statistic_AddLatency(&sys->statistic, VOUT_STATISTIC_PRESENT_ERROR,
+                                  llabs(date - sys->present.expected));
+        sys->present.expected = VLC_TICK_INVALID;
+    }
+}
+
+/* Gets the refresh date closest to system_pts, from the last reported
+ * presentation and refresh period */
+static bool ThreadGetRefreshDate(vout_thread_t *vout, vlc_tick_t system_now,
+                                 vlc_tick_t system_pts, vlc_tick_t *date)
+{
+    vout_thread_sys_t *sys = vout->p;
+    const vlc_tick_t period = sys->present.period;
+    const vlc_tick_t last = sys->present.last;
+
+    if (!sys->present.vsync || period <= 0 || last == VLC_TICK_INVALID
+     || system_now - last > VOUT_PRESENT_TIMEOUT || system_pts < last)
+        return false;
+
+    *date = last + (system_pts - last + period / 2) / period * period;
+    return true;
+}
+
 static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -1220,6 +1280,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (vd->prepare != NULL)
         vd->prepare(vd, todisplay, do_dr_spu ? subpic : NULL, system_pts);
 
+    const vlc_tick_t prepare_time = vlc_tick_now() - sys->render.start;
     vout_chrono_Stop(&sys->render);
 #if 0
         {
@@ -1231,9 +1292,19 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 #endif
 
     system_now = vlc_tick_now();
+    ThreadUpdatePresented(vout);
     if (!is_forced)
     {
-        if (unlikely(system_now > system_pts))
+        /* When pacing on the refresh, submit half a refresh before it, far
+         * from the refresh boundary, so that wake up jitter does not move the
+         * picture to a neighbouring refresh */
+        vlc_tick_t present_date = system_pts;
+        vlc_tick_t submit_date = system_pts;
+        if (ThreadGetRefreshDate(vout, system_now, system_pts, &present_date))
+            submit_date = present_date - sys->present.period / 2;
+
+        sys->present.expected = system_pts;
+        if (unlikely(system_now > submit_date))
         {
             /* vd->prepare took too much time. Tell the clock that the pts was
              * rendered late. */
@@ -1241,18 +1312,24 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         }
         else
         {
-            /* Wait to reach system_pts */
-            vlc_clock_Wait(sys->clock, system_now, pts, sys->rate,
-                           VOUT_REDISPLAY_DELAY);
-
-            /* Don't touch system_pts. Tell the clock that the pts was rendered
-             * at the expected date */
+            /* Wait to reach system_pts, or the submission date */
+            vlc_tick_t max_wait = VOUT_REDISPLAY_DELAY;
+            if (submit_date < system_pts)
+                max_wait = __MIN(max_wait, submit_date - system_now);
+            if (max_wait > 0)
+                vlc_clock_Wait(sys->clock, system_now, pts, sys->rate,
+                               max_wait);
+
+            /* Tell the clock that the pts was rendered at the expected date,
+             * or the refresh it was aligned on */
+            system_pts = present_date;
         }
         sys->displayed.date = system_pts;
     }
     else
     {
         sys->displayed.date = system_now;
+        sys->present.expected = VLC_TICK_INVALID;
         /* Tell the clock that the pts was forced */
         system_pts = INT64_MAX;
     }
@@ -1260,12 +1337,22 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
                           frame_rate, frame_rate_base);
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    vlc_tick_t display_start = vlc_tick_now();
     vout_display_Display(vd, todisplay);
+    const vlc_tick_t display_time = vlc_tick_now() - display_start;
+    /* Synchronous presentation feedback */
+    ThreadUpdatePresented(vout);
     vlc_mutex_unlock(&sys->display_lock);
 
     if (subpic)
         subpicture_Delete(subpic);
 
+    vout_statistic_AddLatency(&sys->statistic, VOUT_STATISTIC_PREPARE,
+                              prepare_time);
+    vout_statistic_AddLatency(&sys->statistic, VOUT_STATISTIC_PRESENT,
+                              display_time);
+    vout_statistic_AddLatency(&sys->statistic, VOUT_STATISTIC_DISPLAY,
+                              prepare_time + display_time);
     vout_statistic_AddDisplayed(&sys->statistic, 1);
 
     return VLC_SUCCESS;
@@ -1408,8 +1495,11 @@ static void vout_FlushUnlocked(vout_thread_t *vout, bool below,
     vout_FilterFlush(sys->display);
     vlc_mutex_unlock(&sys->display_lock);
 
-    vlc_clock_Reset(sys->clock);
-    vlc_clock_SetDelay(sys->clock, sys->delay);
+    if (sys->clock != NULL) /* detached from a parked display */
+    {
+        vlc_clock_Reset(sys->clock);
+        vlc_clock_SetDelay(sys->clock, sys->delay);
+    }
 }
 
 void vout_Flush(vout_thread_t *vout, vlc_tick_t date)
@@ -1775,10 +1865,78 @@ void vout_StopDisplay(vout_thread_t *vout)
 {
     vout_thread_sys_t *sys = vout->p;
 
+    if (sys->display_parked)
+        sys->display_parked = false; /* the thread is already stopped */
+    else
+    {
+        vlc_cancel(sys->thread);
+        vlc_join(sys->thread, NULL);
+    }
+
+    vout_ReleaseDisplay(vout);
+}
+
+void vout_ParkDisplay(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    assert(sys->display != NULL && !sys->display_parked);
+
     vlc_cancel(sys->thread);
     vlc_join(sys->thread, NULL);
 
-    vout_ReleaseDisplay(vout);
+    vout_FlushUnlocked(vout, true, INT64_MAX);
+
+    if (sys->mouse_event)
+        sys->mouse_event(NULL, sys->mouse_opaque);
+
+    if (sys->spu)
+        spu_Detach(sys->spu);
+    sys->mouse_event = NULL;
+    sys->clock = NULL;
+    sys->display_parked = true;
+}
+
+/* Restarts a parked display for a new source, if it is compatible */
+static int vout_UnparkDisplay(vout_thread_t *vout, vlc_video_context *vctx,
+                              const vout_configuration_t *cfg,
+                              const video_format_t *original)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    assert(sys->display_parked);
+
+    if (!video_format_IsSimilar(original, &sys->original)
+     || vctx != sys->filter.src_vctx)
+    {
+        vout_StopDisplay(vout);
+        return -1;
+    }
+
+    msg_Dbg(vout, "reusing the display");
+    sys->mouse_event = cfg->mouse_event;
+    sys->mouse_opaque = cfg->mouse_opaque;
+    vlc_mouse_Init(&sys->mouse);
+
+    sys->delay = 0;
+    sys->rate = 1.f;
+    sys->clock = cfg->clock;
+
+    sys->displayed.date          = VLC_TICK_INVALID;
+    sys->displayed.timestamp     = VLC_TICK_INVALID;
+    sys->displayed.is_interlaced = false;
+    sys->pause.is_on = false;
+    sys->pause.date  = VLC_TICK_INVALID;
+
+    if (vlc_clone(&sys->thread, Thread, vout, VLC_THREAD_PRIORITY_OUTPUT))
+    {
+        sys->display_parked = false;
+        sys->clock = NULL;
+        vout_ReleaseDisplay(vout);
+        return -1;
+    }
+    sys->display_parked = false;
+    return 0;
 }
 
 static void vout_DisableWindow(vout_thread_t *vout)
@@ -1914,7 +2072,7 @@ vout_thread_t *vout_Create(vlc_object_t *object)
     sys->source.dar.num = 0;
     sys->source.dar.den = 0;
     sys->source.crop.mode = VOUT_CROP_NONE;
-    sys->snapshot = vout_snapshot_New();
+    sys->snapshot = vout_snapshot_New(VLC_OBJECT(vout));
     vout_statistic_Init(&sys->statistic);
 
     /* Initialize subpicture unit */
@@ -1935,6 +2093,7 @@ vout_thread_t *vout_Create(vlc_object_t *object)
 
     /* Display */
     sys->display = NULL;
+    sys->display_parked = false;
     vlc_mutex_init(&sys->display_lock);
 
     /* Window */
@@ -1954,6 +2113,13 @@ vout_thread_t *vout_Create(vlc_object_t *object)
     /* Arbitrary initial time */
     vout_chrono_Init(&sys->render, 5, VLC_TICK_FROM_MS(10));
 
+    sys->present.vsync = var_InheritBool(vout, "video-vsync-pacing");
+    atomic_init(&sys->present.date, VLC_TICK_INVALID);
+    atomic_init(&sys->present.refresh, 0);
+    sys->present.last = VLC_TICK_INVALID;
+    sys->present.period = 0;
+    sys->present.expected = VLC_TICK_INVALID;
+
     if (var_InheritBool(vout, "video-wallpaper"))
         vout_window_SetState(sys->display_cfg.window, VOUT_WINDOW_STATE_BELOW);
     else if (var_InheritBool(vout, "video-on-top"))
@@ -1985,6 +2151,22 @@ int vout_ChangeSource( vout_thread_t *vout, const video_format_t *original )
     return -1;
 }
 
+picture_pool_t *vout_GetDecoderPool(vout_thread_t *vout,
+                                    const video_format_t *fmt, unsigned count)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_pool_t *pool = NULL;
+
+    if (sys->dummy)
+        return NULL;
+
+    vlc_mutex_lock(&sys->display_lock);
+    if (sys->display != NULL)
+        pool = vout_display_GetDecoderPool(sys->display, fmt, count);
+    vlc_mutex_unlock(&sys->display_lock);
+    return pool;
+}
+
 static int EnableWindowLocked(vout_thread_t *vout, const video_format_t *original)
 {
     assert(vout != NULL);
@@ -2032,7 +2214,18 @@ int vout_Request(const vout_configuration_t *cfg, vlc_video_context *vctx, input
     video_format_t original;
     VoutFixFormat(&original, cfg->fmt);
 
-    if (vout_ChangeSource(vout, &original) == 0)
+    if (sys->display_parked)
+    {
+        if (vout_UnparkDisplay(vout, vctx, cfg, &original) == 0)
+        {
+            video_format_Clean(&original);
+            if (input != NULL && sys->spu)
+                spu_Attach(sys->spu, input);
+            vout_IntfReinit(vout);
+            return 0;
+        }
+    }
+    else if (vout_ChangeSource(vout, &original) == 0)
     {
         video_format_Clean(&original);
         return 0;
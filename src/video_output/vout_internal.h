@@ -177,12 +177,23 @@ struct vout_thread_sys_t
     vout_display_cfg_t display_cfg;
     vout_display_t *display;
     vlc_mutex_t     display_lock;
+    bool            display_parked; /**< display kept open without source */
 
     picture_pool_t  *private_pool;
     picture_pool_t  *display_pool;
     picture_fifo_t  *decoder_fifo;
     vout_chrono_t   render;           /**< picture render time estimator */
 
+    /* Presentation feedback, see vout_display_SendEventPresented() */
+    struct {
+        bool        vsync;      /**< pace pictures on the reported refresh */
+        atomic_llong date;      /**< last reported presentation date */
+        atomic_llong refresh;   /**< last reported refresh period */
+        vlc_tick_t  last;       /**< last accounted presentation date */
+        vlc_tick_t  period;     /**< refresh period of the last date or 0 */
+        vlc_tick_t  expected;   /**< intended date of the displayed picture */
+    } present;
+
     vlc_atomic_rc_t rc;
 };
 
@@ -230,6 +241,16 @@ void vout_Stop(vout_thread_t *);
  */
 void vout_StopDisplay(vout_thread_t *);
 
+/**
+ * Detaches the source from the display, but keeps the display plugin open.
+ *
+ * The vout thread is stopped and all pictures are flushed. The display is
+ * reused as is by the next vout_Request() with the same video format and
+ * video context, for example when switching to another input. Otherwise it is
+ * stopped then.
+ */
+void vout_ParkDisplay(vout_thread_t *);
+
 /**
  * Destroys a vout.
  *
@@ -247,6 +268,17 @@ void vout_Close( vout_thread_t *p_vout );
  */
 int vout_ChangeSource( vout_thread_t *p_vout, const video_format_t *fmt );
 
+/**
+ * Get pictures the decoder can render into, allocated by the display
+ *
+ * \param fmt the decoder output format
+ * \param count number of pictures
+ * \return a picture pool, or NULL if the display does not provide one
+ */
+picture_pool_t *vout_GetDecoderPool( vout_thread_t *p_vout,
+                                     const video_format_t *fmt,
+                                     unsigned count );
+
 /* TODO to move them to vlc_vout.h */
 void vout_ChangeFullscreen(vout_thread_t *, const char *id);
 void vout_ChangeWindowed(vout_thread_t *);
@@ -324,9 +356,12 @@ void vout_MouseState(vout_thread_t *, const vlc_mouse_t *);
 
 /**
  * This function will return and reset internal statistics.
+ *
+ * \param p_latency array of VOUT_STATISTIC_LATENCIES histograms, indexed by
+ * enum vout_statistic_latency
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
-                             unsigned *pi_lost );
+                             unsigned *pi_lost, input_latency_t *p_latency );
 
 /**
  * This function will force to display the next picture while paused
@@ -75,6 +75,21 @@ typedef struct VLC_VECTOR(struct spu_channel) spu_channel_vector;
 typedef struct VLC_VECTOR(subpicture_t *) spu_prerender_vector;
 #define SPU_CHROMALIST_COUNT 8
 
+/* Text region rendered, with its last scaled version, reused while
+ * subpictures keep showing the same text (karaoke, marquee, logo...) */
+typedef struct {
+    uint64_t       key;       /* see SpuCacheKey */
+    unsigned       last_use;
+    picture_t      *picture;  /* rendered text, NULL if the entry is free */
+    video_format_t fmt;
+    int            x;         /* region position set by the renderer */
+    int            y;
+    picture_t      *scaled;   /* scaled picture, or NULL */
+    video_format_t scaled_fmt;
+} spu_cache_entry_t;
+
+#define SPU_CACHE_SIZE 16
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     input_thread_t *input;
@@ -84,6 +99,12 @@ struct spu_private_t {
     int channel;             /**< number of subpicture channels registered */
     filter_t *text;                              /**< text renderer module */
     vlc_mutex_t textlock;
+    struct {
+        spu_cache_entry_t entries[SPU_CACHE_SIZE];
+        unsigned clock;
+        unsigned hits;
+        unsigned misses;
+    } cache;                      /**< rendered text, protected by textlock */
     filter_t *scale_yuvp;                     /**< scaling module for YUVP */
     filter_t *scale;                    /**< scaling module (all but YUVP) */
     bool force_crop;                     /**< force cropping of subpicture */
@@ -305,6 +326,171 @@ static filter_t *SpuRenderCreateAndLoadScale(vlc_object_t *object,
     return scale;
 }
 
+/**
+ * Text render cache helpers, called with textlock held.
+ */
+static uint64_t SpuCacheHash(uint64_t hash, const void *data, size_t size)
+{
+    /* FNV-1a */
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * UINT64_C(0x100000001b3);
+    return hash;
+}
+
+static uint64_t SpuCacheHashString(uint64_t hash, const char *psz)
+{
+    static const uint8_t none = 0xff; /* not a valid UTF-8 byte */
+    if (psz == NULL)
+        return SpuCacheHash(hash, &none, 1);
+    return SpuCacheHash(hash, psz, strlen(psz) + 1);
+}
+
+#define SPU_CACHE_HASH(hash, field) \
+    hash = SpuCacheHash(hash, &(field), sizeof(field))
+
+static uint64_t SpuCacheHashStyle(uint64_t hash, const text_style_t *style)
+{
+    if (style == NULL)
+        return SpuCacheHashString(hash, NULL);
+
+    hash = SpuCacheHashString(hash, style->psz_fontname);
+    hash = SpuCacheHashString(hash, style->psz_monofontname);
+    SPU_CACHE_HASH(hash, style->i_features);
+    SPU_CACHE_HASH(hash, style->i_style_flags);
+    SPU_CACHE_HASH(hash, style->f_font_relsize);
+    SPU_CACHE_HASH(hash, style->i_font_size);
+    SPU_CACHE_HASH(hash, style->i_font_color);
+    SPU_CACHE_HASH(hash, style->i_font_alpha);
+    SPU_CACHE_HASH(hash, style->i_spacing);
+    SPU_CACHE_HASH(hash, style->i_outline_color);
+    SPU_CACHE_HASH(hash, style->i_outline_alpha);
+    SPU_CACHE_HASH(hash, style->i_outline_width);
+    SPU_CACHE_HASH(hash, style->i_shadow_color);
+    SPU_CACHE_HASH(hash, style->i_shadow_alpha);
+    SPU_CACHE_HASH(hash, style->i_shadow_width);
+    SPU_CACHE_HASH(hash, style->i_background_color);
+    SPU_CACHE_HASH(hash, style->i_background_alpha);
+    SPU_CACHE_HASH(hash, style->e_wrapinfo);
+    return hash;
+}
+
+/* Hashes everything the text renderer output depends on */
+static uint64_t SpuCacheKey(const subpicture_region_t *region,
+                            int i_original_width, int i_original_height,
+                            const vlc_fourcc_t *chroma_list)
+{
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+
+    for (const text_segment_t *seg = region->p_text; seg; seg = seg->p_next)
+    {
+        hash = SpuCacheHashString(hash, seg->psz_text);
+        hash = SpuCacheHashStyle(hash, seg->style);
+        for (const text_segment_ruby_t *ruby = seg->p_ruby; ruby;
+             ruby = ruby->p_next)
+        {
+            hash = SpuCacheHashString(hash, ruby->psz_base);
+            hash = SpuCacheHashString(hash, ruby->psz_rt);
+        }
+    }
+
+    SPU_CACHE_HASH(hash, region->i_x);
+    SPU_CACHE_HASH(hash, region->i_y);
+    SPU_CACHE_HASH(hash, region->i_text_align);
+    SPU_CACHE_HASH(hash, region->b_noregionbg);
+    SPU_CACHE_HASH(hash, region->b_gridmode);
+    SPU_CACHE_HASH(hash, region->b_balanced_text);
+    SPU_CACHE_HASH(hash, region->i_max_width);
+    SPU_CACHE_HASH(hash, region->i_max_height);
+    SPU_CACHE_HASH(hash, region->fmt.i_sar_num);
+    SPU_CACHE_HASH(hash, region->fmt.i_sar_den);
+    SPU_CACHE_HASH(hash, region->fmt.transfer);
+    SPU_CACHE_HASH(hash, region->fmt.primaries);
+    SPU_CACHE_HASH(hash, region->fmt.space);
+    SPU_CACHE_HASH(hash, region->fmt.color_range);
+    SPU_CACHE_HASH(hash, i_original_width);
+    SPU_CACHE_HASH(hash, i_original_height);
+    for (size_t i = 0; chroma_list[i]; i++)
+        SPU_CACHE_HASH(hash, chroma_list[i]);
+    return hash;
+}
+#undef SPU_CACHE_HASH
+
+static void SpuCacheEntryClean(spu_cache_entry_t *entry)
+{
+    if (entry->scaled)
+    {
+        picture_Release(entry->scaled);
+        video_format_Clean(&entry->scaled_fmt);
+        entry->scaled = NULL;
+    }
+    if (entry->picture)
+    {
+        picture_Release(entry->picture);
+        video_format_Clean(&entry->fmt);
+        entry->picture = NULL;
+    }
+}
+
+static void SpuCacheFlush(spu_private_t *sys)
+{
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++)
+        SpuCacheEntryClean(&sys->cache.entries[i]);
+}
+
+static spu_cache_entry_t *SpuCacheFind(spu_private_t *sys, uint64_t key)
+{
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++)
+    {
+        spu_cache_entry_t *entry = &sys->cache.entries[i];
+        if (entry->picture && entry->key == key)
+        {
+            entry->last_use = ++sys->cache.clock;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static spu_cache_entry_t *SpuCacheFindPicture(spu_private_t *sys,
+                                              const picture_t *picture)
+{
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++)
+    {
+        spu_cache_entry_t *entry = &sys->cache.entries[i];
+        if (entry->picture && entry->picture == picture)
+            return entry;
+    }
+    return NULL;
+}
+
+static void SpuCacheInsert(spu_private_t *sys, uint64_t key,
+                           const subpicture_region_t *region)
+{
+    /* Use a free entry, or replace the least recently used one */
+    spu_cache_entry_t *entry = NULL;
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++)
+    {
+        spu_cache_entry_t *candidate = &sys->cache.entries[i];
+        if (!candidate->picture)
+        {
+            entry = candidate;
+            break;
+        }
+        if (!entry || candidate->last_use < entry->last_use)
+            entry = candidate;
+    }
+    SpuCacheEntryClean(entry);
+
+    if (video_format_Copy(&entry->fmt, &region->fmt) != VLC_SUCCESS)
+        return;
+    entry->key = key;
+    entry->last_use = ++sys->cache.clock;
+    entry->picture = picture_Hold(region->p_picture);
+    entry->x = region->i_x;
+    entry->y = region->i_y;
+}
+
 static void SpuRenderText(spu_t *spu,
                           subpicture_region_t *region,
                           int i_original_width,
@@ -336,7 +522,31 @@ static void SpuRenderText(spu_t *spu,
         text->fmt_out.video.i_visible_height = i_original_height;
 
         if ( region->p_text )
-            text->pf_render(text, region, region, chroma_list);
+        {
+            const uint64_t key = SpuCacheKey(region, i_original_width,
+                                             i_original_height, chroma_list);
+            const spu_cache_entry_t *entry = SpuCacheFind(sys, key);
+            if (entry)
+            {
+                video_format_t fmt;
+                if (video_format_Copy(&fmt, &entry->fmt) == VLC_SUCCESS)
+                {
+                    video_format_Clean(&region->fmt);
+                    region->fmt = fmt;
+                    region->p_picture = picture_Hold(entry->picture);
+                    region->i_x = entry->x;
+                    region->i_y = entry->y;
+                    sys->cache.hits++;
+                }
+            }
+            else
+            {
+                sys->cache.misses++;
+                text->pf_render(text, region, region, chroma_list);
+                if (region->fmt.i_chroma != VLC_CODEC_TEXT && region->p_picture)
+                    SpuCacheInsert(sys, key, region);
+            }
+        }
     }
     vlc_mutex_unlock(&sys->textlock);
 }
@@ -973,6 +1183,25 @@ static void SpuRenderRegion(spu_t *spu,
             }
         }
 
+        /* Reuse the scaled version of a text rendered before */
+        const vlc_fourcc_t dst_chroma = convert_chroma ? chroma_list[0]
+                                                       : region->fmt.i_chroma;
+        if (!region->p_private && !using_palette) {
+            vlc_mutex_lock(&sys->textlock);
+            spu_cache_entry_t *cached =
+                SpuCacheFindPicture(sys, region->p_picture);
+            if (cached && cached->scaled &&
+                cached->scaled_fmt.i_visible_width  == dst_width &&
+                cached->scaled_fmt.i_visible_height == dst_height &&
+                cached->scaled_fmt.i_chroma == dst_chroma) {
+                region->p_private =
+                    subpicture_region_private_New(&cached->scaled_fmt);
+                if (region->p_private)
+                    region->p_private->p_picture = picture_Hold(cached->scaled);
+            }
+            vlc_mutex_unlock(&sys->textlock);
+        }
+
         /* Scale if needed into cache */
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
@@ -1038,6 +1267,24 @@ static void SpuRenderRegion(spu_t *spu,
                     picture_Release(picture);
                 }
             }
+
+            /* Keep it along with the rendered text */
+            if (region->p_private && !using_palette) {
+                vlc_mutex_lock(&sys->textlock);
+                spu_cache_entry_t *cached =
+                    SpuCacheFindPicture(sys, region->p_picture);
+                if (cached) {
+                    if (cached->scaled) {
+                        picture_Release(cached->scaled);
+                        video_format_Clean(&cached->scaled_fmt);
+                        cached->scaled = NULL;
+                    }
+                    if (video_format_Copy(&cached->scaled_fmt,
+                                          &region->p_private->fmt) == VLC_SUCCESS)
+                        cached->scaled = picture_Hold(region->p_private->p_picture);
+                }
+                vlc_mutex_unlock(&sys->textlock);
+            }
         }
 
         /* And use the scaled picture */
@@ -1580,6 +1827,9 @@ static void spu_Cleanup(spu_t *spu)
 {
     spu_private_t *sys = spu->p;
 
+    msg_Dbg(spu, "text render cache: %u hits, %u misses",
+            sys->cache.hits, sys->cache.misses);
+    SpuCacheFlush(sys);
     if (sys->text)
         FilterRelease(sys->text);
 
@@ -1688,6 +1938,12 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     /* Load text and scale module */
     sys->text = SpuRenderCreateAndLoadText(spu);
     vlc_mutex_init(&sys->textlock);
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++)
+    {
+        sys->cache.entries[i].picture = NULL;
+        sys->cache.entries[i].scaled = NULL;
+    }
+    sys->cache.clock = sys->cache.hits = sys->cache.misses = 0;
 
     /* XXX spu->p_scale is used for all conversion/scaling except yuvp to
      * yuva/rgba */
@@ -1734,6 +1990,7 @@ void spu_Attach(spu_t *spu, input_thread_t *input)
         spu->p->input = input;
 
         vlc_mutex_lock(&spu->p->textlock);
+        SpuCacheFlush(spu->p);
         if (spu->p->text)
             FilterRelease(spu->p->text);
         spu->p->text = SpuRenderCreateAndLoadText(spu);
@@ -48,6 +48,17 @@ static void VoutViewpointMoved(void *sys, const vlc_viewpoint_t *vp)
     var_SetAddress(vout, "viewpoint-moved", (void*)vp);
 }
 
+static void VoutPresented(void *sys, vlc_tick_t date, vlc_tick_t refresh)
+{
+    vout_thread_t *vout = sys;
+
+    /* May be called from any thread: the refresh is stored before the date,
+     * so that the vout thread reads a refresh at least as recent */
+    atomic_store_explicit(&vout->p->present.refresh, refresh,
+                          memory_order_relaxed);
+    atomic_store_explicit(&vout->p->present.date, date, memory_order_release);
+}
+
 /* Minimum number of display picture */
 #define DISPLAY_PICTURE_COUNT (1)
 
@@ -61,7 +72,8 @@ vout_display_t *vout_OpenWrapper(vout_thread_t *vout,
     vout_thread_sys_t *sys = vout->p;
     vout_display_t *vd;
     vout_display_owner_t owner = {
-        .viewpoint_moved = VoutViewpointMoved, .sys = vout,
+        .viewpoint_moved = VoutViewpointMoved, .presented = VoutPresented,
+        .sys = vout,
     };
     const char *modlist;
     char *modlistbuf = NULL;
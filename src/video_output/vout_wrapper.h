@@ -28,6 +28,9 @@
 /* XXX DO NOT use it outside the vout module wrapper XXX */
 
 picture_pool_t *vout_GetPool(vout_display_t *vd, unsigned count);
+picture_pool_t *vout_display_GetDecoderPool(vout_display_t *vd,
+                                            const video_format_t *fmt,
+                                            unsigned count);
 
 bool vout_IsDisplayFiltered(vout_display_t *);
 picture_t * vout_ConvertForDisplay(vout_display_t *, picture_t *);
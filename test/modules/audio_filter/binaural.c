@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * binaural.c: convolution engine and binaural renderer tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+#include "../../../modules/audio_filter/convolver.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Checks the partitioned convolution against the direct one, computed in
+ * double precision, with responses shorter and longer than a block, and
+ * checks that the binaural renderer puts the side speakers on their side. */
+
+const char vlc_module_name[] = "test_binaural";
+
+struct test_case
+{
+    unsigned block;
+    unsigned inputs, outputs;
+    unsigned blocks;
+    size_t lengths[4]; /* of the paths, in turn, 0 for none */
+};
+
+static const struct test_case cases[] =
+{
+    {   8, 1, 1, 20, { 1 } },
+    {  64, 3, 2, 40, { 1, 64, 65, 200 } },
+    {  64, 2, 2, 12, { 0, 7, 129, 0 } },
+    { 256, 9, 2, 16, { 256, 300, 513, 1 } },
+    /* a room correction response of each channel */
+    {  64, 2, 2, 100, { 4000, 0, 0, 3999 } },
+};
+
+static float Random( uint32_t *seed )
+{
+    *seed = *seed * 1103515245 + 12345;
+    return ( (int)( ( *seed >> 16 ) & 0x7fff ) - 0x4000 ) / (float)0x4000;
+}
+
+static void CheckConvolver( const struct test_case *test )
+{
+    const unsigned inputs = test->inputs, outputs = test->outputs;
+    const size_t frames = (size_t)test->block * test->blocks;
+    uint32_t seed = test->block + inputs;
+
+    convolver_t *conv = convolver_New( test->block, inputs, outputs );
+    assert( conv != NULL );
+
+    float *ir[inputs * outputs];
+    size_t lengths[inputs * outputs];
+    for( unsigned p = 0; p < inputs * outputs; p++ )
+    {
+        lengths[p] = test->lengths[p % ARRAY_SIZE(test->lengths)];
+        ir[p] = NULL;
+        if( lengths[p] == 0 )
+            continue;
+        ir[p] = malloc( lengths[p] * sizeof (float) );
+        assert( ir[p] != NULL );
+        for( size_t k = 0; k < lengths[p]; k++ )
+            ir[p][k] = Random( &seed ) * exp( -(double)k / 500. );
+        int ret = convolver_SetResponse( conv, p / outputs, p % outputs,
+                                         ir[p], lengths[p] );
+        assert( ret == VLC_SUCCESS );
+    }
+
+    float *in = malloc( frames * inputs * sizeof (float) );
+    float *out = malloc( frames * outputs * sizeof (float) );
+    float *again = malloc( test->block * outputs * sizeof (float) );
+    assert( in != NULL && out != NULL && again != NULL );
+    for( size_t i = 0; i < frames * inputs; i++ )
+        in[i] = Random( &seed );
+
+    for( unsigned b = 0; b < test->blocks; b++ )
+        convolver_Process( conv, &in[b * test->block * inputs],
+                           &out[b * test->block * outputs] );
+
+    double error = 0., energy = 0.;
+    for( size_t n = 0; n < frames; n++ )
+        for( unsigned o = 0; o < outputs; o++ )
+        {
+            double y = 0.;
+            for( unsigned i = 0; i < inputs; i++ )
+            {
+                const unsigned p = i * outputs + o;
+                for( size_t k = 0; k < lengths[p] && k <= n; k++ )
+                    y += ir[p][k] * in[( n - k ) * inputs + i];
+            }
+            const double d = out[n * outputs + o] - y;
+            error += d * d;
+            energy += y * y;
+        }
+
+    const double snr = 10 * log10( energy / error );
+    test_log( "block %u, %u inputs, %u outputs: SNR %.1f dB\n",
+              test->block, inputs, outputs, snr );
+    if( !( snr > 110. ) )
+        abort();
+
+    /* Without the past input, the first block again */
+    convolver_Reset( conv );
+    convolver_Process( conv, in, again );
+    if( memcmp( again, out, test->block * outputs * sizeof (float) ) )
+    {
+        test_log( "the reset convolver remembers the past\n" );
+        abort();
+    }
+
+    free( again );
+    free( out );
+    free( in );
+    for( unsigned p = 0; p < inputs * outputs; p++ )
+        free( ir[p] );
+    convolver_Delete( conv );
+}
+
+#define RENDER_FRAMES 2000
+
+static void CheckRenderer( vlc_object_t *obj )
+{
+    filter_t *filter = vlc_object_create( obj, sizeof (*filter) );
+    assert( filter != NULL );
+
+    es_format_Init( &filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32 );
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = 48000;
+    filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_5_1;
+    aout_FormatPrepare( &filter->fmt_in.audio );
+    es_format_Copy( &filter->fmt_out, &filter->fmt_in );
+    filter->p_module = module_need( filter, "audio filter", "binaural",
+                                    true );
+    assert( filter->p_module != NULL );
+    assert( filter->fmt_out.audio.i_physical_channels == AOUT_CHANS_STEREO );
+
+    /* An impulse on each channel, in the WG4 order: L R RL RR C LFE */
+    const unsigned channels = 6;
+    for( unsigned c = 0; c < channels; c++ )
+    {
+        block_t *in = block_Alloc( RENDER_FRAMES * channels * sizeof (float) );
+        assert( in != NULL );
+        memset( in->p_buffer, 0, in->i_buffer );
+        ((float *)in->p_buffer)[c] = 1.f;
+        in->i_nb_samples = RENDER_FRAMES;
+        in->i_pts = in->i_dts = VLC_TICK_0;
+
+        block_t *out = filter->pf_audio_filter( filter, in );
+        assert( out != NULL && out->i_nb_samples == RENDER_FRAMES );
+
+        /* the energy, and the onset, of each ear */
+        const float *s = (const float *)out->p_buffer;
+        double energy[2] = { 0., 0. };
+        size_t onset[2] = { RENDER_FRAMES, RENDER_FRAMES };
+        for( size_t n = 0; n < RENDER_FRAMES; n++ )
+            for( unsigned e = 0; e < 2; e++ )
+            {
+                energy[e] += s[2 * n + e] * s[2 * n + e];
+                if( onset[e] == RENDER_FRAMES && fabsf( s[2 * n + e] ) > .05f )
+                    onset[e] = n;
+            }
+        block_Release( out );
+        filter->pf_flush( filter );
+
+        test_log( "channel %u: left %.3f at %zu, right %.3f at %zu\n", c,
+                  energy[0], onset[0], energy[1], onset[1] );
+        assert( energy[0] > 0. && energy[1] > 0. );
+        if( c == 4 || c == 5 ) /* centered */
+        {
+            assert( fabs( energy[0] - energy[1] ) < 1e-6 * energy[0] );
+            assert( onset[0] == onset[1] );
+        }
+        else
+        {
+            const unsigned near = c & 1, far = !near;
+            assert( energy[near] > 1.5 * energy[far] );
+            assert( onset[near] < onset[far] );
+        }
+    }
+
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    vlc_object_delete( filter );
+}
+
+int main( void )
+{
+    test_init();
+
+    for( size_t i = 0; i < ARRAY_SIZE(cases); i++ )
+        CheckConvolver( &cases[i] );
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    CheckRenderer( VLC_OBJECT(vlc->p_libvlc_int) );
+
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * loudness.c: loudness normalizer tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_variables.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Normalizes 1 kHz tones, whose loudness is their level in dBFS in each of
+ * 2 channels (EBU Tech 3341), and checks the level of the output once the
+ * gain has settled, and that the peaks stay under the ceiling. */
+
+const char vlc_module_name[] = "test_loudness";
+
+#define BLOCK 1001 /* frames per input block */
+
+struct test_case
+{
+    const char *name;
+    unsigned rate;
+    uint32_t channels;
+    uint32_t tone;  /* channels of the tone, the others are silent */
+    float level;    /* dBFS of the tone */
+    float burst;    /* dBFS of the tone after 14 s, or 0 for none */
+    float target, threshold, ratio;
+    float expected; /* dBFS of the output peaks, at the end */
+};
+
+static const struct test_case cases[] =
+{
+    { "amplify", 48000, AOUT_CHANS_STEREO, AOUT_CHANS_STEREO,
+      -30.f, 0.f, -18.f, -10.f, 2.f, -18.f },
+    { "attenuate", 44100, AOUT_CHANS_STEREO, AOUT_CHANS_STEREO,
+      -10.f, 0.f, -23.f, -10.f, 1.f, -23.f },
+    /* surround channels weigh 1.5 dB more, the LFE not at all */
+    { "surround", 48000, AOUT_CHANS_5_1, AOUT_CHANS_REAR,
+      -30.f, 0.f, -18.f, -10.f, 2.f, -19.5f },
+    { "LFE", 48000, AOUT_CHANS_5_1, AOUT_CHAN_LFE,
+      -30.f, 0.f, -18.f, -10.f, 2.f, -30.f },
+    /* 6 dB over the threshold, compressed 2:1 */
+    { "compress", 48000, AOUT_CHANS_STEREO, AOUT_CHANS_STEREO,
+      -10.f, 0.f, -18.f, -24.f, 2.f, -21.f },
+    /* amplified by the maximum gain, then a full scale tone */
+    { "limit", 44100, AOUT_CHANS_7_1, AOUT_CHANS_STEREO,
+      -40.f, -0.1f, -18.f, -10.f, 1.f, -1.f },
+};
+
+static void Check( vlc_object_t *obj, const struct test_case *test )
+{
+    vlc_object_t *aout = vlc_object_create( obj, sizeof (*aout) );
+    assert( aout != NULL );
+    var_Create( aout, "loudness-target", VLC_VAR_FLOAT );
+    var_SetFloat( aout, "loudness-target", test->target );
+    var_Create( aout, "loudness-threshold", VLC_VAR_FLOAT );
+    var_SetFloat( aout, "loudness-threshold", test->threshold );
+    var_Create( aout, "loudness-ratio", VLC_VAR_FLOAT );
+    var_SetFloat( aout, "loudness-ratio", test->ratio );
+
+    filter_t *filter = vlc_object_create( aout, sizeof (*filter) );
+    assert( filter != NULL );
+
+    es_format_Init( &filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32 );
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = test->rate;
+    filter->fmt_in.audio.i_physical_channels = test->channels;
+    aout_FormatPrepare( &filter->fmt_in.audio );
+    es_format_Copy( &filter->fmt_out, &filter->fmt_in );
+    filter->p_module = module_need( filter, "audio filter", "loudness",
+                                    true );
+    assert( filter->p_module != NULL );
+
+    /* the interleaved channels of the tone */
+    const unsigned channels = filter->fmt_in.audio.i_channels;
+    bool tone[AOUT_CHAN_MAX] = { false };
+    for( unsigned i = 0, c = 0; pi_vlc_chan_order_wg4[i] != 0; i++ )
+        if( test->channels & pi_vlc_chan_order_wg4[i] )
+            tone[c++] = ( test->tone & pi_vlc_chan_order_wg4[i] ) != 0;
+
+    const size_t frames = 16 * test->rate;
+    const size_t burst = test->burst != 0.f ? 14 * test->rate : SIZE_MAX;
+    size_t in_frames = 0, out_frames = 0;
+    float peak = 0.f, end_peak = 0.f;
+
+    for( bool drain = false; ; drain = in_frames >= frames )
+    {
+        block_t *out;
+
+        if( !drain )
+        {
+            block_t *in = block_Alloc( BLOCK * channels * sizeof (float) );
+            assert( in != NULL );
+            float *samples = (float *)in->p_buffer;
+            for( size_t i = 0; i < BLOCK; i++ )
+            {
+                const size_t n = in_frames + i;
+                const float level = n < burst ? test->level : test->burst;
+                const float s = powf( 10.f, level / 20.f )
+                              * sin( 2 * M_PI * 1000. * n / test->rate );
+                for( unsigned c = 0; c < channels; c++ )
+                    samples[i * channels + c] = tone[c] ? s : 0.f;
+            }
+            in->i_nb_samples = BLOCK;
+            in->i_pts = in->i_dts = VLC_TICK_0
+                      + vlc_tick_from_samples( in_frames, test->rate );
+            in_frames += BLOCK;
+            out = filter->pf_audio_filter( filter, in );
+            assert( out != NULL && out->i_nb_samples == BLOCK );
+        }
+        else
+        {
+            out = filter->pf_audio_drain( filter );
+            assert( out != NULL && out->i_nb_samples > 0 );
+            /* after the last input block, to the rounding of its length */
+            const vlc_tick_t end = VLC_TICK_0
+                                 + vlc_tick_from_samples( in_frames, test->rate );
+            assert( out->i_pts >= end - 1 && out->i_pts <= end + 1 );
+        }
+
+        const float *samples = (const float *)out->p_buffer;
+        for( size_t i = 0; i < out->i_nb_samples; i++ )
+            for( unsigned c = 0; c < channels; c++ )
+            {
+                const float s = fabsf( samples[i * channels + c] );
+                if( !tone[c] )
+                    assert( s == 0.f );
+                peak = __MAX( peak, s );
+                /* over the last second of the input */
+                if( out_frames + i + test->rate > frames
+                 && out_frames + i < frames )
+                    end_peak = __MAX( end_peak, s );
+            }
+        out_frames += out->i_nb_samples;
+        block_Release( out );
+        if( drain )
+            break;
+    }
+
+    const float level = 20.f * log10f( end_peak );
+    test_log( "%s: output at %.2f dBFS, expected %.2f, peak %.2f dBFS\n",
+              test->name, level, test->expected, 20.f * log10f( peak ) );
+    if( !( fabsf( level - test->expected ) < .3f ) )
+        abort();
+    /* the default ceiling, and the true peaks of a sine are its samples */
+    if( !( peak < powf( 10.f, -1.f / 20.f ) * 1.001f ) )
+        abort();
+    /* the look-ahead is a few milliseconds */
+    assert( out_frames > in_frames && out_frames < in_frames + test->rate / 50 );
+
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    vlc_object_delete( filter );
+    var_Destroy( aout, "loudness-ratio" );
+    var_Destroy( aout, "loudness-threshold" );
+    var_Destroy( aout, "loudness-target" );
+    vlc_object_delete( aout );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    for( size_t i = 0; i < ARRAY_SIZE(cases); i++ )
+        Check( VLC_OBJECT(vlc->p_libvlc_int), &cases[i] );
+
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * polyphase.c: polyphase resampler tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_variables.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Resamples tones, at fixed ratios and with the small rate changes of the
+ * audio output synchronization, and compares the output with the tones at
+ * the times of the output samples. */
+
+const char vlc_module_name[] = "test_polyphase";
+
+#define BLOCKS 40
+#define BLOCK  1001 /* frames per input block */
+
+struct test_case
+{
+    unsigned in_rate, out_rate;
+    unsigned channels;
+    int quality;
+    int drift; /* Hz added to the input rate on each block */
+    double snr;
+};
+
+static const struct test_case cases[] =
+{
+    { 44100, 48000, 2, 0, 0,  65. },
+    { 44100, 48000, 2, 1, 0,  80. },
+    { 44100, 48000, 2, 2, 0, 105. },
+    { 48000, 44100, 6, 1, 0,  80. },
+    { 96000, 44100, 1, 2, 0, 105. },
+    {  8000, 48000, 1, 1, 0,  80. },
+    { 22050, 44100, 3, 1, 0,  80. },
+    /* synchronization, with and without conversion */
+    { 48000, 48000, 2, 1,  2,  80. },
+    { 48000, 48000, 2, 1, -2,  80. },
+    { 44100, 48000, 8, 1,  1,  80. },
+};
+
+/* Two tones, relative to the lower rate, and far enough from its Nyquist
+ * frequency for the low quality */
+static double Signal( double t, unsigned c, double rate )
+{
+    return .4 * sin( 2 * M_PI * .02 * rate * t + c )
+         + .3 * sin( 2 * M_PI * ( .07 + .01 * c ) * rate * t );
+}
+
+static void Check( vlc_object_t *obj, const struct test_case *test )
+{
+    vlc_object_t *aout = vlc_object_create( obj, sizeof (*aout) );
+    assert( aout != NULL );
+    var_Create( aout, "polyphase-resampler-quality", VLC_VAR_INTEGER );
+    var_SetInteger( aout, "polyphase-resampler-quality", test->quality );
+
+    filter_t *filter = vlc_object_create( aout, sizeof (*filter) );
+    assert( filter != NULL );
+
+    es_format_Init( &filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32 );
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = test->in_rate;
+    filter->fmt_in.audio.i_physical_channels = ( 1u << test->channels ) - 1;
+    aout_FormatPrepare( &filter->fmt_in.audio );
+    es_format_Copy( &filter->fmt_out, &filter->fmt_in );
+    filter->fmt_out.audio.i_rate = test->out_rate;
+    filter->p_module = module_need( filter, "audio resampler", "polyphase",
+                                    true );
+    assert( filter->p_module != NULL );
+
+    /* the rate and the start time of each input block */
+    const unsigned channels = test->channels;
+    const double band = __MIN( test->in_rate, test->out_rate );
+    double starts[BLOCKS + 1];
+    unsigned rates[BLOCKS + 1];
+    for( unsigned k = 0; k <= BLOCKS; k++ )
+    {
+        rates[k] = test->in_rate + test->drift * (int)k;
+        starts[k] = k > 0 ? starts[k - 1] + (double)BLOCK / rates[k - 1] : 0.;
+    }
+
+    /* the position of the next output sample, in input samples */
+    double position = 0.;
+    double error = 0., energy = 0.;
+    size_t outputs = 0;
+
+    for( unsigned k = 0; k <= BLOCKS; k++ )
+    {
+        const unsigned rate = rates[k];
+        block_t *out;
+
+        filter->fmt_in.audio.i_rate = rate;
+        if( k < BLOCKS )
+        {
+            block_t *in = block_Alloc( BLOCK * channels * sizeof (float) );
+            assert( in != NULL );
+            float *samples = (float *)in->p_buffer;
+            for( size_t i = 0; i < BLOCK; i++ )
+                for( unsigned c = 0; c < channels; c++ )
+                    samples[i * channels + c] =
+                        Signal( starts[k] + (double)i / rate, c, band );
+            in->i_nb_samples = BLOCK;
+            in->i_pts = in->i_dts = VLC_TICK_0;
+            out = filter->pf_audio_filter( filter, in );
+        }
+        else
+            out = filter->pf_audio_drain( filter );
+        if( out == NULL )
+            continue;
+
+        const float *resampled = (const float *)out->p_buffer;
+        for( size_t i = 0; i < out->i_nb_samples; i++ )
+        {
+            /* away from the silence before and after the input */
+            if( position > 64 && position < BLOCKS * BLOCK - 64 )
+            {
+                const unsigned b = position / BLOCK;
+                const double t = starts[b]
+                               + ( position - b * BLOCK ) / rates[b];
+                for( unsigned c = 0; c < channels; c++ )
+                {
+                    const double y = Signal( t, c, band );
+                    const double d = resampled[i * channels + c] - y;
+                    error += d * d;
+                    energy += y * y;
+                }
+            }
+            position += (double)rate / test->out_rate;
+        }
+        outputs += out->i_nb_samples;
+        block_Release( out );
+    }
+
+    const double snr = 10 * log10( energy / error );
+    const double expected = (double)BLOCKS * BLOCK * test->out_rate
+                          / test->in_rate;
+    test_log( "%u Hz to %u Hz, %u channels, quality %d, drift %d Hz: "
+              "SNR %.1f dB, %zu samples\n", test->in_rate, test->out_rate,
+              channels, test->quality, test->drift, snr, outputs );
+    if( !( snr > test->snr ) )
+        abort();
+    if( test->drift == 0 && fabs( outputs - expected ) > 2. )
+        abort();
+
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    vlc_object_delete( filter );
+    var_Destroy( aout, "polyphase-resampler-quality" );
+    vlc_object_delete( aout );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    for( size_t i = 0; i < ARRAY_SIZE(cases); i++ )
+        Check( VLC_OBJECT(vlc->p_libvlc_int), &cases[i] );
+
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * scaletempo.c: scaletempo audio filter tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_variables.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Speeds up a signal, and checks the overlap offset of every stride, which
+ * the SIMD dot products or the FFT correlation find, against a search in
+ * double precision. The offsets are found back from the output, where the
+ * end of each stride is a plain copy of the input. */
+
+const char vlc_module_name[] = "test_scaletempo";
+
+#define RATE    48000
+#define STRIDE  30 /* ms, the default */
+#define STRIDES 20
+#define BLOCK   1024
+
+struct test_case
+{
+    unsigned channels;
+    unsigned rate; /* input rate, for the speed */
+    unsigned search; /* ms */
+    float overlap;
+};
+
+static const struct test_case cases[] =
+{
+    /* the defaults, on the dot products */
+    { 2, RATE * 3 / 2, 14, .20f },
+    { 8, RATE * 2, 14, .20f },
+    { 1, RATE * 5 / 4, 14, .20f },
+    /* large windows, on the FFT correlation */
+    { 6, RATE * 3 / 2, 80, .80f },
+    { 1, RATE * 2, 200, .90f },
+};
+
+/* Tones moving across the channels, and some noise, so that the copied
+ * parts of the output are found in a single place of the input */
+static void FillSignal( float *samples, size_t frames, unsigned channels )
+{
+    uint32_t seed = 1;
+
+    for( size_t i = 0; i < frames; i++ )
+        for( unsigned c = 0; c < channels; c++ )
+        {
+            seed = seed * 1103515245 + 12345;
+            const double t = (double)i / RATE;
+            samples[i * channels + c] =
+                .4 * sin( 2 * M_PI * 220 * ( c + 1 ) * t )
+              + .3 * sin( 2 * M_PI * 330 * t + c ) * sin( 2 * M_PI * 3 * t )
+              + .05 * ( (int)( ( seed >> 16 ) & 0x7fff ) - 0x4000 ) / 0x4000;
+        }
+}
+
+/* Correlation of the windowed overlap and the input at a position */
+static double Correlation( const float *overlap, const float *input,
+                           unsigned frames_overlap, unsigned channels )
+{
+    double corr = 0;
+
+    for( unsigned i = 1; i < frames_overlap; i++ )
+    {
+        const double w = (double)i * ( frames_overlap - i );
+        for( unsigned c = 0; c < channels; c++ )
+            corr += w * overlap[i * channels + c] * input[i * channels + c];
+    }
+    return corr;
+}
+
+static void Check( vlc_object_t *obj, const struct test_case *test )
+{
+    filter_t *filter = vlc_object_create( obj, sizeof (*filter) );
+    assert( filter != NULL );
+
+    var_Create( filter, "scaletempo-search", VLC_VAR_INTEGER );
+    var_SetInteger( filter, "scaletempo-search", test->search );
+    var_Create( filter, "scaletempo-overlap", VLC_VAR_FLOAT );
+    var_SetFloat( filter, "scaletempo-overlap", test->overlap );
+
+    es_format_Init( &filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32 );
+    filter->fmt_in.audio.i_format = VLC_CODEC_FL32;
+    filter->fmt_in.audio.i_rate = RATE;
+    filter->fmt_in.audio.i_physical_channels = ( 1u << test->channels ) - 1;
+    aout_FormatPrepare( &filter->fmt_in.audio );
+    es_format_Copy( &filter->fmt_out, &filter->fmt_in );
+    filter->p_module = module_need( filter, "audio filter", "scaletempo",
+                                    true );
+    assert( filter->p_module != NULL );
+    /* the speed follows the input rate */
+    filter->fmt_in.audio.i_rate = test->rate;
+
+    const unsigned channels = test->channels;
+    const unsigned frames_stride = STRIDE * RATE / 1000;
+    const unsigned frames_overlap = frames_stride * test->overlap;
+    const unsigned frames_search = test->search * RATE / 1000;
+    /* the speeds are exact, the strides of input are whole */
+    const unsigned frames_slide = frames_stride * test->rate / RATE;
+    const size_t frames_in = (size_t)frames_slide * STRIDES + frames_search
+                           + 2 * frames_stride + BLOCK;
+
+    float *input = malloc( frames_in * channels * sizeof (*input) );
+    float *output = malloc( frames_in * channels * sizeof (*output) );
+    assert( input != NULL && output != NULL );
+    FillSignal( input, frames_in, channels );
+
+    size_t frames_out = 0;
+    for( size_t pos = 0; pos + BLOCK <= frames_in; pos += BLOCK )
+    {
+        block_t *in = block_Alloc( BLOCK * channels * sizeof (*input) );
+        assert( in != NULL );
+        memcpy( in->p_buffer, &input[pos * channels], in->i_buffer );
+        in->i_nb_samples = BLOCK;
+        in->i_pts = in->i_dts = VLC_TICK_0 + vlc_tick_from_samples( pos, RATE );
+
+        block_t *out = filter->pf_audio_filter( filter, in );
+        if( out != NULL )
+        {
+            assert( frames_out + out->i_nb_samples <= frames_in );
+            memcpy( &output[frames_out * channels], out->p_buffer,
+                    out->i_buffer );
+            frames_out += out->i_nb_samples;
+            block_Release( out );
+        }
+    }
+    assert( frames_out >= STRIDES * frames_stride );
+
+    /* the first stride overlaps with silence, any offset is as good */
+    unsigned prev_start = 0;
+    for( unsigned k = 0; k < STRIDES; k++ )
+    {
+        const size_t standing = ( frames_stride - frames_overlap ) * channels;
+        const float *copied = &output[( k * frames_stride + frames_overlap )
+                                      * channels];
+        const unsigned queue = k * frames_slide;
+        unsigned off = 0;
+
+        while( off < frames_search
+            && memcmp( copied, &input[( queue + off + frames_overlap ) * channels],
+                       standing * sizeof (*input) ) )
+            off++;
+        if( off == frames_search )
+        {
+            test_log( "%u channels, %u ms search: stride %u not found\n",
+                      channels, test->search, k );
+            abort();
+        }
+
+        if( k > 0 )
+        {
+            const float *overlap = &input[( prev_start + frames_stride )
+                                          * channels];
+            double best = -HUGE_VAL;
+            unsigned best_off = 0;
+            for( unsigned o = 0; o < frames_search; o++ )
+            {
+                const double corr = Correlation( overlap,
+                                                 &input[( queue + o ) * channels],
+                                                 frames_overlap, channels );
+                if( corr > best )
+                {
+                    best = corr;
+                    best_off = o;
+                }
+            }
+
+            const double corr = Correlation( overlap,
+                                             &input[( queue + off ) * channels],
+                                             frames_overlap, channels );
+            if( off != best_off && best - corr > 1e-4 * fabs( best ) )
+            {
+                test_log( "%u channels, %u ms search: stride %u offset %u, "
+                          "expected %u (correlation %g, expected %g)\n",
+                          channels, test->search, k, off, best_off, corr,
+                          best );
+                abort();
+            }
+        }
+        prev_start = queue + off;
+    }
+    test_log( "%u channels, %u ms search, %.0f%% overlap: OK\n", channels,
+              test->search, test->overlap * 100 );
+
+    free( output );
+    free( input );
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    var_Destroy( filter, "scaletempo-overlap" );
+    var_Destroy( filter, "scaletempo-search" );
+    vlc_object_delete( filter );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    for( size_t i = 0; i < ARRAY_SIZE(cases); i++ )
+        Check( VLC_OBJECT(vlc->p_libvlc_int), &cases[i] );
+
+    libvlc_release( vlc );
+    return 0;
+}
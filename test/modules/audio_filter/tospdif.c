@@ -0,0 +1,238 @@
+/*****************************************************************************
+ * tospdif.c: S/PDIF encapsulation tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_tick.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Checks the layout of the A/52 and TrueHD (MAT) bursts in both byte orders,
+ * and the reuse of the released bursts, then logs how many TrueHD bursts are built per second. */
+
+const char vlc_module_name[] = "test_tospdif";
+
+#define TRUEHD_FRAMES 24 /* per MAT frame, and burst */
+#define TRUEHD_BURST 61440
+#define RATE_BURSTS 2000
+
+static filter_t *Create( vlc_object_t *obj, vlc_fourcc_t in, vlc_fourcc_t out )
+{
+    filter_t *filter = vlc_object_create( obj, sizeof (*filter) );
+    assert( filter != NULL );
+
+    es_format_Init( &filter->fmt_in, AUDIO_ES, in );
+    filter->fmt_in.audio.i_format = in;
+    filter->fmt_in.audio.i_rate = 48000;
+    es_format_Init( &filter->fmt_out, AUDIO_ES, out );
+    filter->fmt_out.audio.i_format = out;
+    filter->fmt_out.audio.i_rate = 48000;
+    filter->fmt_out.audio.i_bytes_per_frame = 4;
+    filter->fmt_out.audio.i_frame_length = 1;
+    filter->p_module = module_need( filter, "audio converter", "tospdif",
+                                    true );
+    assert( filter->p_module != NULL );
+    return filter;
+}
+
+static void Delete( filter_t *filter )
+{
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    vlc_object_delete( filter );
+}
+
+static block_t *Frame( size_t size, unsigned samples, uint8_t seed )
+{
+    block_t *block = block_Alloc( size );
+    assert( block != NULL );
+    for( size_t i = 0; i < size; i++ )
+        block->p_buffer[i] = seed + i * 7;
+    block->i_nb_samples = samples;
+    block->i_pts = block->i_dts = VLC_TICK_0;
+    block->i_length = vlc_tick_from_samples( samples, 48000 );
+    return block;
+}
+
+/* The 16-bit words of the output, from the big endian ones of the input */
+static void CheckWords( const uint8_t *out, const uint8_t *in, size_t size,
+                        bool big_endian )
+{
+    for( size_t i = 0; i < size; i++ )
+        assert( out[i] == in[big_endian ? i : i ^ 1] );
+}
+
+static uint16_t Word( const uint8_t *p, bool big_endian )
+{
+    return big_endian ? GetWBE( p ) : GetWLE( p );
+}
+
+static void CheckHeader( const block_t *burst, uint16_t type, uint16_t length,
+                         bool big_endian )
+{
+    assert( Word( &burst->p_buffer[0], big_endian ) == 0xf872 );
+    assert( Word( &burst->p_buffer[2], big_endian ) == 0x4e1f );
+    assert( Word( &burst->p_buffer[4], big_endian ) == type );
+    assert( Word( &burst->p_buffer[6], big_endian ) == length );
+}
+
+static void CheckZeros( const uint8_t *p, size_t size )
+{
+    for( size_t i = 0; i < size; i++ )
+        assert( p[i] == 0 );
+}
+
+static void CheckA52( vlc_object_t *obj, bool big_endian )
+{
+    filter_t *filter = Create( obj, VLC_CODEC_A52, big_endian
+                               ? VLC_CODEC_SPDIFB : VLC_CODEC_SPDIFL );
+    const size_t size = 1000;
+    uint8_t copy[size];
+
+    block_t *in = Frame( size, A52_FRAME_NB, 1 );
+    in->p_buffer[5] = 0x03; /* bsmod */
+    memcpy( copy, in->p_buffer, size );
+
+    block_t *burst = filter->pf_audio_filter( filter, in );
+    assert( burst != NULL && burst->i_buffer == A52_FRAME_NB * 4 );
+    assert( burst->i_nb_samples == A52_FRAME_NB );
+    CheckHeader( burst, 0x0301, size * 8, big_endian );
+    CheckWords( &burst->p_buffer[8], copy, size, big_endian );
+    CheckZeros( &burst->p_buffer[8 + size], burst->i_buffer - 8 - size );
+
+    /* the released bursts are reused */
+    const uint8_t *buffer = burst->p_buffer;
+    block_Release( burst );
+    in = Frame( size, A52_FRAME_NB, 2 );
+    in->p_buffer[5] = 0x03;
+    burst = filter->pf_audio_filter( filter, in );
+    assert( burst != NULL && burst->p_buffer == buffer );
+    block_Release( burst );
+    Delete( filter );
+}
+
+static void CheckTrueHD( vlc_object_t *obj, bool big_endian )
+{
+    static const uint8_t mat_start[20] = {
+        0x07, 0x9E, 0x00, 0x03, 0x84, 0x01, 0x01, 0x01, 0x80, 0x00,
+        0x56, 0xA5, 0x3B, 0xF4, 0x81, 0x83, 0x49, 0x80, 0x77, 0xE0
+    };
+    static const uint8_t mat_middle[12] = {
+        0xC3, 0xC1, 0x42, 0x49, 0x3B, 0xFA,
+        0x82, 0x83, 0x49, 0x80, 0x77, 0xE0
+    };
+    static const uint8_t mat_end[16] = {
+        0xC3, 0xC2, 0xC0, 0xC4, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x97, 0x11
+    };
+    filter_t *filter = Create( obj, VLC_CODEC_TRUEHD, big_endian
+                               ? VLC_CODEC_SPDIFB : VLC_CODEC_SPDIFL );
+    const size_t size = 1234;
+    uint8_t copy[TRUEHD_FRAMES][size];
+    block_t *burst = NULL;
+
+    /* A flushed MAT frame starts again */
+    block_t *in = Frame( size, 40, 0 );
+    assert( filter->pf_audio_filter( filter, in ) == NULL );
+    filter->pf_flush( filter );
+
+    for( unsigned f = 0; f < TRUEHD_FRAMES; f++ )
+    {
+        in = Frame( size, 40, f );
+        memcpy( copy[f], in->p_buffer, size );
+        burst = filter->pf_audio_filter( filter, in );
+        assert( ( burst != NULL ) == ( f == TRUEHD_FRAMES - 1 ) );
+    }
+    assert( burst->i_buffer == TRUEHD_BURST );
+    CheckHeader( burst, 0x16, TRUEHD_BURST - 8 - 8, big_endian );
+
+    /* the MAT codes are at fixed offsets, the frames every 2560 bytes */
+    const uint8_t *p = burst->p_buffer;
+    CheckWords( &p[8], mat_start, sizeof (mat_start), big_endian );
+    CheckWords( &p[2560 * 12 - 4], mat_middle, sizeof (mat_middle),
+                big_endian );
+    CheckWords( &p[2560 * 24 - 24], mat_end, sizeof (mat_end), big_endian );
+    CheckZeros( &p[2560 * 24 - 8], 8 );
+    for( unsigned f = 0; f < TRUEHD_FRAMES; f++ )
+    {
+        const size_t offset = f == 0 ? 8 + 20 : f == 12 ? 2560 * 12 + 8
+                            : 2560 * f;
+        CheckWords( &p[offset], copy[f], size, big_endian );
+    }
+    block_Release( burst );
+    Delete( filter );
+}
+
+static void CheckRate( vlc_object_t *obj, bool big_endian )
+{
+    filter_t *filter = Create( obj, VLC_CODEC_TRUEHD, big_endian
+                               ? VLC_CODEC_SPDIFB : VLC_CODEC_SPDIFL );
+    /* the largest TrueHD frames that fit */
+    const size_t size = 2560 - 20 - 8;
+    block_t *frame = Frame( size, 40, 0 );
+
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned b = 0; b < RATE_BURSTS; b++ )
+        for( unsigned f = 0; f < TRUEHD_FRAMES; f++ )
+        {
+            block_t *burst = filter->pf_audio_filter( filter,
+                                                      block_Duplicate( frame ) );
+            assert( ( burst != NULL ) == ( f == TRUEHD_FRAMES - 1 ) );
+            if( burst != NULL )
+                block_Release( burst );
+        }
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    test_log( "TrueHD, %s output: %.0f bursts per second, %.0f MB/s\n",
+              big_endian ? "big endian" : "little endian",
+              RATE_BURSTS * (double)CLOCK_FREQ / elapsed,
+              RATE_BURSTS * (double)TRUEHD_BURST * CLOCK_FREQ / elapsed / 1e6 );
+    block_Release( frame );
+    Delete( filter );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    for( int big_endian = 0; big_endian < 2; big_endian++ )
+    {
+        CheckA52( obj, big_endian );
+        CheckTrueHD( obj, big_endian );
+        CheckRate( obj, big_endian );
+    }
+
+    libvlc_release( vlc );
+    return 0;
+}
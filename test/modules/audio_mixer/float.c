@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * float.c: floating point audio volume tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout_volume.h>
+#include <vlc_block.h>
+#include <vlc_fourcc.h>
+#include <vlc_modules.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Amplifies buffers of the usual channel counts, whose lengths leave tails
+ * to the SIMD vectors, at a constant gain and with gain ramps, and checks
+ * them against the plain computation. */
+
+const char vlc_module_name[] = "test_float_mixer";
+
+#define FRAMES 1001
+
+static const unsigned channels[] = { 1, 2, 3, 4, 6, 8, 12, 32 };
+
+static block_t *NewBuffer( unsigned count, size_t size )
+{
+    block_t *block = block_Alloc( FRAMES * count * size );
+    assert( block != NULL );
+    block->i_nb_samples = FRAMES;
+
+    uint32_t seed = count;
+    for( size_t i = 0; i < FRAMES * count; i++ )
+    {
+        seed = seed * 1103515245 + 12345;
+        const double v = ( (int)( ( seed >> 16 ) & 0x7fff ) - 0x4000 )
+                       / (double)0x4000;
+        if( size == sizeof (float) )
+            ((float *)block->p_buffer)[i] = v;
+        else
+            ((double *)block->p_buffer)[i] = v;
+    }
+    return block;
+}
+
+static void CheckBuffer( const block_t *ref, const block_t *block,
+                         unsigned count, float from, float to )
+{
+    const bool fl32 = block->i_buffer == FRAMES * count * sizeof (float);
+
+    for( size_t i = 0; i < FRAMES * count; i++ )
+    {
+        const double amp = from + ( (double)to - from ) / FRAMES
+                                * ( i / count + 1 );
+        double in, out;
+        if( fl32 )
+        {
+            in = ((const float *)ref->p_buffer)[i];
+            out = ((const float *)block->p_buffer)[i];
+        }
+        else
+        {
+            in = ((const double *)ref->p_buffer)[i];
+            out = ((const double *)block->p_buffer)[i];
+        }
+        if( !( fabs( out - amp * in ) <= 1e-6 ) )
+        {
+            test_log( "%u channels, gain %f to %f: sample %zu is %f, "
+                      "not %f\n", count, from, to, i, out, amp * in );
+            abort();
+        }
+    }
+}
+
+static void Check( vlc_object_t *obj, vlc_fourcc_t format, size_t size )
+{
+    audio_volume_t *volume = vlc_object_create( obj, sizeof (*volume) );
+    assert( volume != NULL );
+    volume->format = format;
+
+    module_t *module = module_need( volume, "audio volume", NULL, false );
+    assert( module != NULL );
+    test_log( "%4.4s: %s\n", (const char *)&format,
+              module_get_object( module ) );
+
+    for( size_t i = 0; i < ARRAY_SIZE(channels); i++ )
+    {
+        const unsigned count = channels[i];
+        block_t *ref = NewBuffer( count, size );
+        block_t *block = NewBuffer( count, size );
+
+        volume->amplify( volume, block, .5f );
+        CheckBuffer( ref, block, count, .5f, .5f );
+        block_Release( block );
+
+        if( volume->amplify_ramp != NULL )
+        {
+            block = NewBuffer( count, size );
+            volume->amplify_ramp( volume, block, 1.f, .25f );
+            CheckBuffer( ref, block, count, 1.f, .25f );
+            block_Release( block );
+
+            block = NewBuffer( count, size );
+            volume->amplify_ramp( volume, block, 0.f, 2.f );
+            CheckBuffer( ref, block, count, 0.f, 2.f );
+            block_Release( block );
+        }
+        block_Release( ref );
+    }
+    test_log( "%4.4s: OK\n", (const char *)&format );
+
+    module_unneed( volume, module );
+    vlc_object_delete( volume );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    Check( VLC_OBJECT(vlc->p_libvlc_int), VLC_CODEC_FL32, sizeof (float) );
+    Check( VLC_OBJECT(vlc->p_libvlc_int), VLC_CODEC_FL64, sizeof (double) );
+
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*****************************************************************************
+ * ts_sync.c: MPEG TS sync byte lookup tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/demux/mpeg/ts_sync.h"
+
+#include "../../libvlc/test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Usage: test_modules_demux_ts_sync [capture.ts]
+ * Checks the accelerated lookups against the plain C ones, and reports the
+ * resync time over the capture, or over a synthetic capture with losses. */
+
+#define SYNTHETIC_SIZE (4 * 1024 * 1024)
+#define BENCH_ROUNDS   8
+
+/* TS like data with the sync byte also showing up in payloads,
+ * and bursts of missing bytes as seen on multicast losses */
+static uint8_t * CreateCapture( size_t *pi_size, unsigned i_packet_size )
+{
+    uint8_t *p = malloc( SYNTHETIC_SIZE );
+    if( !p )
+        return NULL;
+
+    size_t i_size = 0;
+    unsigned i_seed = 1;
+    while( i_size + i_packet_size < SYNTHETIC_SIZE )
+    {
+        for( unsigned i = 0; i < i_packet_size; i++ )
+        {
+            i_seed = i_seed * 1103515245 + 12345;
+            p[i_size + i] = i_seed >> 16;
+        }
+        p[i_size] = TS_SYNC_BYTE;
+
+        i_seed = i_seed * 1103515245 + 12345;
+        if( ( i_seed >> 16 ) % 16 == 0 ) /* truncated packet */
+            i_size += ( i_seed >> 8 ) % i_packet_size;
+        else
+            i_size += i_packet_size;
+    }
+
+    *pi_size = i_size;
+    return p;
+}
+
+static int Check( const uint8_t *p, size_t i_size )
+{
+    for( size_t i = 0; i < TS_SYNC_DETECT_COUNT; i++ )
+    {
+        const unsigned s = ts_sync_detect_sizes[i];
+        for( size_t i_pos = 0; i_pos < i_size; i_pos += 97 )
+        {
+            const uint8_t *end = &p[i_size];
+            if( ts_sync_Find( &p[i_pos], end, s ) != ts_sync_Find_C( &p[i_pos], end, s ) )
+            {
+                fprintf( stderr, "find mismatch at %zu stride %u\n", i_pos, s );
+                return 1;
+            }
+        }
+    }
+
+    for( size_t i_pos = 0; i_pos < i_size; i_pos += 97 )
+    {
+        unsigned i_size_a = 0, i_size_b = 0;
+        const uint8_t *end = &p[__MIN(i_size, i_pos + 4096)];
+        const uint8_t *a = ts_sync_Detect( &p[i_pos], end, &i_size_a );
+        const uint8_t *b = ts_sync_Detect_C( &p[i_pos], end, &i_size_b );
+        if( a != b || ( a && i_size_a != i_size_b ) )
+        {
+            fprintf( stderr, "detect mismatch at %zu\n", i_pos );
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+typedef const uint8_t * (*find_cb)( const uint8_t *, const uint8_t *, size_t );
+
+static vlc_tick_t Bench( find_cb pf_find, const uint8_t *p, size_t i_size,
+                         unsigned i_packet_size, unsigned *pi_resyncs )
+{
+    vlc_tick_t i_start = vlc_tick_now();
+    for( int i = 0; i < BENCH_ROUNDS; i++ )
+    {
+        const uint8_t *end = &p[i_size];
+        const uint8_t *q = p;
+        *pi_resyncs = 0;
+        /* walk packets, resync on each loss */
+        while( q + i_packet_size < end )
+        {
+            if( q[0] == TS_SYNC_BYTE && q[i_packet_size] == TS_SYNC_BYTE )
+            {
+                q += i_packet_size;
+                continue;
+            }
+            (*pi_resyncs)++;
+            q = pf_find( q + 1, end, i_packet_size );
+            if( !q )
+                break;
+        }
+    }
+    return ( vlc_tick_now() - i_start ) / BENCH_ROUNDS;
+}
+
+static int Run( const char *psz_name, const uint8_t *p, size_t i_size,
+                unsigned i_packet_size )
+{
+    if( Check( p, i_size ) )
+        return 1;
+
+    unsigned i_resyncs, i_resyncs_c;
+    vlc_tick_t i_time = Bench( ts_sync_Find, p, i_size, i_packet_size, &i_resyncs );
+    vlc_tick_t i_time_c = Bench( ts_sync_Find_C, p, i_size, i_packet_size, &i_resyncs_c );
+    if( i_resyncs != i_resyncs_c )
+        return 1;
+
+    printf( "%s: %zu bytes, %u resyncs, C %"PRId64"us, accelerated %"PRId64"us\n",
+            psz_name, i_size, i_resyncs, US_FROM_VLC_TICK(i_time_c),
+            US_FROM_VLC_TICK(i_time) );
+    return 0;
+}
+
+int main( int argc, char **argv )
+{
+    test_init();
+
+    if( argc > 1 )
+    {
+        FILE *f = fopen( argv[1], "rb" );
+        if( !f )
+            return 1;
+        uint8_t *p = malloc( SYNTHETIC_SIZE );
+        size_t i_size = p ? fread( p, 1, SYNTHETIC_SIZE, f ) : 0;
+        fclose( f );
+        unsigned i_packet_size = 188;
+        const uint8_t *p_sync = p ? ts_sync_Detect( p, &p[i_size], &i_packet_size ) : NULL;
+        int i_ret = p_sync ? Run( argv[1], p, i_size, i_packet_size ) : 1;
+        free( p );
+        return i_ret;
+    }
+
+    for( size_t i = 0; i < TS_SYNC_DETECT_COUNT; i++ )
+    {
+        const unsigned s = ts_sync_detect_sizes[i];
+        size_t i_size;
+        uint8_t *p = CreateCapture( &i_size, s );
+        if( !p )
+            return 1;
+
+        char psz_name[32];
+        snprintf( psz_name, sizeof(psz_name), "synthetic %u", s );
+        int i_ret = Run( psz_name, p, i_size, s );
+        free( p );
+        if( i_ret )
+            return i_ret;
+    }
+
+    return 0;
+}
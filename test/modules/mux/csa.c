@@ -0,0 +1,178 @@
+/*****************************************************************************
+ * csa.c: CSA scrambling tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/mux/mpeg/csa.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Checks the batch (de)scrambling against the per packet one, then
+ * reports both throughputs */
+
+const char vlc_module_name[] = "test_csa";
+
+#define PACKETS      4096
+#define BENCH_ROUNDS 4
+
+static vlc_object_t *obj;
+
+static void CreatePackets( uint8_t *p, int i_pkt_size )
+{
+    unsigned i_seed = 1;
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        uint8_t *pkt = &p[i * i_pkt_size];
+        for( int j = 0; j < i_pkt_size; j++ )
+        {
+            i_seed = i_seed * 1103515245 + 12345;
+            pkt[j] = i_seed >> 16;
+        }
+        pkt[0] = 0x47;
+        pkt[3] &= 0x3f; /* clear */
+        /* some adaptation fields, up to payload less packets */
+        if( pkt[3] & 0x20 )
+            pkt[4] %= 184;
+    }
+}
+
+static void GetPointers( uint8_t **pp, uint8_t *p, int i_pkt_size )
+{
+    for( int i = 0; i < PACKETS; i++ )
+        pp[i] = &p[i * i_pkt_size];
+}
+
+static void Encrypt( csa_t *c, uint8_t *p, int i_pkt_size, bool b_batch )
+{
+    uint8_t *pp[PACKETS];
+    GetPointers( pp, p, i_pkt_size );
+    /* alternate keys by halves */
+    for( int i = 0; i < 2; i++ )
+    {
+        csa_UseKey( obj, c, i == 0 );
+        if( b_batch )
+            csa_EncryptPackets( c, &pp[i * PACKETS / 2], PACKETS / 2, i_pkt_size );
+        else
+            for( int j = 0; j < PACKETS / 2; j++ )
+                csa_Encrypt( c, pp[i * PACKETS / 2 + j], i_pkt_size );
+    }
+}
+
+static void Decrypt( csa_t *c, uint8_t *p, int i_pkt_size, bool b_batch )
+{
+    uint8_t *pp[PACKETS];
+    GetPointers( pp, p, i_pkt_size );
+    if( b_batch )
+        csa_DecryptPackets( c, pp, PACKETS, i_pkt_size );
+    else
+        for( int i = 0; i < PACKETS; i++ )
+            csa_Decrypt( c, pp[i], i_pkt_size );
+}
+
+static int Run( csa_t *c, int i_pkt_size )
+{
+    const size_t i_size = (size_t) PACKETS * i_pkt_size;
+    uint8_t *p_clear = malloc( i_size );
+    uint8_t *p_ref = malloc( i_size );
+    uint8_t *p_test = malloc( i_size );
+    int i_ret = 1;
+    if( !p_clear || !p_ref || !p_test )
+        goto end;
+
+    CreatePackets( p_clear, i_pkt_size );
+
+    memcpy( p_ref, p_clear, i_size );
+    memcpy( p_test, p_clear, i_size );
+    Encrypt( c, p_ref, i_pkt_size, false );
+    Encrypt( c, p_test, i_pkt_size, true );
+    if( memcmp( p_ref, p_test, i_size ) )
+    {
+        fprintf( stderr, "scrambling mismatch for %d bytes packets\n", i_pkt_size );
+        goto end;
+    }
+
+    Decrypt( c, p_ref, i_pkt_size, false );
+    Decrypt( c, p_test, i_pkt_size, true );
+    if( memcmp( p_ref, p_test, i_size ) || memcmp( p_clear, p_test, i_size ) )
+    {
+        fprintf( stderr, "descrambling mismatch for %d bytes packets\n", i_pkt_size );
+        goto end;
+    }
+
+    vlc_tick_t i_times[2];
+    for( int i = 0; i < 2; i++ )
+    {
+        vlc_tick_t i_start = vlc_tick_now();
+        for( int j = 0; j < BENCH_ROUNDS; j++ )
+        {
+            Encrypt( c, p_test, i_pkt_size, i );
+            Decrypt( c, p_test, i_pkt_size, i );
+        }
+        i_times[i] = __MAX( 1, vlc_tick_now() - i_start );
+    }
+
+    const double f_bits = 2.0 * 8 * BENCH_ROUNDS * i_size;
+    printf( "%d bytes packets: per packet %.0f Mbps, batch %.0f Mbps\n", i_pkt_size,
+            f_bits / US_FROM_VLC_TICK(i_times[0]),
+            f_bits / US_FROM_VLC_TICK(i_times[1]) );
+    i_ret = 0;
+
+end:
+    free( p_clear );
+    free( p_ref );
+    free( p_test );
+    return i_ret;
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs, test_defaults_args );
+    if( !vlc )
+        return 1;
+    obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    int i_ret = 1;
+    char psz_odd[] = "0x0123456789abcdef";
+    char psz_even[] = "fedcba9876543210";
+    csa_t *c = csa_New();
+    if( c && csa_SetCW( obj, c, psz_odd, true ) == VLC_SUCCESS &&
+             csa_SetCW( obj, c, psz_even, false ) == VLC_SUCCESS )
+    {
+        i_ret = Run( c, 188 );
+        if( !i_ret ) /* --ts-csa-pkt partial scrambling */
+            i_ret = Run( c, 100 );
+    }
+    if( c )
+        csa_Delete( c );
+
+    libvlc_release( vlc );
+    return i_ret;
+}
@@ -30,6 +30,7 @@
 #include <vlc_block_helper.h>
 
 #include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
 
 struct results_s
 {
@@ -64,33 +65,169 @@ static int check_set( const uint8_t *p_set, const uint8_t *p_end,
     return 0;
 }
 
+/* Every registered implementation, then the dispatchers */
+static struct
+{
+    const char *psz_name;
+    startcode_find_t pf_find;
+    unsigned i_flags;
+} finders[16];
+static size_t i_finders;
+
+static void init_finders( void )
+{
+    size_t i_impls;
+    const struct vlc_cpu_impl *impls = startcode_FindAnnexB_Impls( &i_impls );
+
+    assert( i_impls + 2 <= ARRAY_SIZE(finders) );
+    for( size_t i = 0; i < i_impls; i++ )
+    {
+        finders[i_finders].psz_name = impls[i].name;
+        finders[i_finders].pf_find = (startcode_find_t) impls[i].func;
+        finders[i_finders++].i_flags = impls[i].flags;
+    }
+    finders[i_finders].psz_name = "best";
+    finders[i_finders].pf_find = startcode_FindAnnexB;
+    finders[i_finders++].i_flags = 0;
+    finders[i_finders].psz_name = "selected";
+    finders[i_finders].pf_find = startcode_FindAnnexB_Select();
+    finders[i_finders++].i_flags = 0;
+}
+
+static bool finder_available( size_t i )
+{
+    return vlc_CPU_has( finders[i].i_flags );
+}
+
 static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
                             const struct results_s *p_results, size_t i_results,
                             ssize_t i_results_offset )
 {
-    int i_ret;
-
-    printf("checking bits code:\n");
-    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                       startcode_FindAnnexB_Bits );
-    if( i_ret != 0 )
-        return i_ret;
-
-    /* Perform same tests on simd optimized code */
-    if( startcode_FindAnnexB_Bits != startcode_FindAnnexB )
+    for( size_t i = 0; i < i_finders; i++ )
     {
-        printf("checking asm:\n");
-        i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                           startcode_FindAnnexB );
+        if( !finder_available( i ) )
+        {
+            printf("%s not supported, skipping test:\n", finders[i].psz_name);
+            continue;
+        }
+        printf("checking %s code:\n", finders[i].psz_name);
+        int i_ret = check_set( p_set, p_end, p_results, i_results,
+                               i_results_offset, finders[i].pf_find );
         if( i_ret != 0 )
             return i_ret;
     }
-    else printf("asm not built in, skipping test:\n");
+    return 0;
+}
+
+/* Bitstream like data: escaped payloads with many zeros, between startcodes */
+static void fill_annexb( uint8_t *p, size_t i_size, unsigned i_seed )
+{
+    unsigned i_zeros = 0;
+    for( size_t i = 0; i < i_size; i++ )
+    {
+        i_seed = i_seed * 1103515245 + 12345;
+        uint8_t v = (i_seed >> 16) & 0x07 ? i_seed >> 24 : 0x00;
+        if( (i_seed >> 8) % 5000 == 0 && i + 4 <= i_size )
+        {
+            memcpy( &p[i], "\x00\x00\x00\x01", 4 );
+            i += 3;
+            i_zeros = 0;
+            continue;
+        }
+        if( i_zeros >= 2 && v <= 0x03 )
+        {
+            p[i++] = 0x03;
+            i_zeros = 0;
+            if( i == i_size )
+                break;
+        }
+        p[i] = v;
+        i_zeros = v ? 0 : i_zeros + 1;
+    }
+}
+
+static int check_random( void )
+{
+    uint8_t buf[1024];
+    size_t i_ep3b_impls;
+    const struct vlc_cpu_impl *ep3b_impls = startcode_FindEP3B_Impls( &i_ep3b_impls );
+
+    for( unsigned i_run = 0; i_run < 20000; i_run++ )
+    {
+        size_t i_size = i_run % sizeof(buf);
+        fill_annexb( buf, i_size, i_run );
+        if( i_run & 1 ) /* lots of zeros and ones */
+            for( size_t i = 0; i < i_size; i++ )
+                buf[i] = buf[i] & 0x41 ? buf[i] & 0x03 : 0x00;
+
+        const uint8_t *p_ep3b = NULL;
+        for( size_t i = 0; i + 3 <= i_size && !p_ep3b; i++ )
+            if( buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 3 )
+                p_ep3b = &buf[i];
+        if( startcode_FindEP3B( buf, buf + i_size ) != p_ep3b )
+            return 1;
+        for( size_t i = 0; i < i_ep3b_impls; i++ )
+            if( vlc_CPU_has( ep3b_impls[i].flags ) &&
+                ((startcode_find_t) ep3b_impls[i].func)( buf, buf + i_size ) != p_ep3b )
+            {
+                printf("%s EP3B mismatch at run %u\n", ep3b_impls[i].name,
+                       i_run);
+                return 1;
+            }
 
+        const uint8_t *p_end = buf + i_size;
+        const uint8_t *p = buf;
+        while( p != NULL )
+        {
+            const uint8_t *p_ref = startcode_FindAnnexB_Bits( p, p_end );
+            for( size_t i = 0; i < i_finders; i++ )
+                if( finder_available( i ) &&
+                    finders[i].pf_find( p, p_end ) != p_ref )
+                {
+                    printf("%s mismatch at run %u\n", finders[i].psz_name,
+                           i_run);
+                    return 1;
+                }
+            p = p_ref ? p_ref + 1 : NULL;
+        }
+    }
     return 0;
 }
 
-int main( void )
+static void bench( const uint8_t *p_data, size_t i_data )
+{
+    for( size_t i = 0; i < i_finders; i++ )
+    {
+        if( !finder_available( i ) )
+            continue;
+
+        unsigned i_found = 0;
+        vlc_tick_t start = vlc_tick_now();
+        for( int i_loop = 0; i_loop < 16; i_loop++ )
+            for( const uint8_t *p = p_data; ; p += 3, i_found++ )
+            {
+                p = finders[i].pf_find( p, p_data + i_data );
+                if( p == NULL )
+                    break;
+            }
+        vlc_tick_t duration = vlc_tick_now() - start;
+        printf("%s: %u startcodes, %.0f MB/s\n", finders[i].psz_name,
+               i_found / 16, 16. * i_data * CLOCK_FREQ / 1000000. /
+               (duration ? duration : 1));
+    }
+
+    size_t i_ep3b = 0;
+    vlc_tick_t start = vlc_tick_now();
+    for( int i_loop = 0; i_loop < 16; i_loop++ )
+        i_ep3b += i_data - hxxx_ep3b_total_size( p_data, p_data + i_data );
+    vlc_tick_t duration = vlc_tick_now() - start;
+    printf("ep3b: %zu escapes, %.0f MB/s\n", i_ep3b / 16,
+           16. * i_data * CLOCK_FREQ / 1000000. / (duration ? duration : 1));
+}
+
+/* Checks the startcode scanners, then benchmarks them, over the Annex B
+ * file given as argument if any */
+int main( int argc, char *argv[] )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
                                          0, 0, 1, 0x22, 0x22, //14
@@ -110,6 +247,8 @@ int main( void )
                                         { 30, 3 + 0 },
                                        };
 
+    init_finders();
+
     printf("* Running tests on set 1:\n");
     int i_ret = run_annexb_sets( test1_annexbdata,
                                  test1_annexbdata + sizeof(test1_annexbdata),
@@ -134,5 +273,35 @@ int main( void )
             return i_ret;
     }
 
+    printf("* Running tests on random sets:\n");
+    i_ret = check_random();
+    if( i_ret != 0 )
+        return i_ret;
+
+    size_t i_data = 8 << 20;
+    p_data = NULL;
+    if( argc > 1 )
+    {
+        FILE *p_file = fopen( argv[1], "rb" );
+        if( p_file == NULL )
+            return 1;
+        p_data = malloc( i_data );
+        if( p_data )
+            i_data = fread( p_data, 1, i_data, p_file );
+        fclose( p_file );
+    }
+    else
+    {
+        p_data = malloc( i_data );
+        if( p_data )
+            fill_annexb( p_data, i_data, 42 );
+    }
+    if( p_data )
+    {
+        printf("* Benchmarking on %zu bytes:\n", i_data);
+        bench( p_data, i_data );
+        free( p_data );
+    }
+
     return 0;
 }
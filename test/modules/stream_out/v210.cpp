@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * v210.cpp: V210 packing tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "../../../modules/stream_out/sdi/V210.hpp"
+
+/* Packs pictures whose widths leave tails to the SIMD packers, with
+ * samples out of the 10-bit range to check the clipping, and compares
+ * them with the scalar packing, by slices or not. */
+
+static const unsigned widths[] = {
+    3840, 1920, 1280, 720, 1282, 100, 34, 24, 22, 16, 12, 10, 6, 4, 2,
+};
+
+#define HEIGHT 67
+
+static inline unsigned clip(unsigned a)
+{
+    if      (a < 4) return 4;
+    else if (a > 1019) return 1019;
+    else               return a;
+}
+
+static inline void put_le32(uint8_t **p, uint32_t d)
+{
+    SetDWLE(*p, d);
+    (*p) += 4;
+}
+
+/* The packing code from before the SIMD versions */
+static void ConvertC(const picture_t *pic, unsigned dst_stride, void *frame_bytes)
+{
+    unsigned width = pic->format.i_width;
+    unsigned height = pic->format.i_height;
+    unsigned payload_size = ((width * 8 + 11) / 12) * 4;
+    unsigned line_padding = (payload_size < dst_stride) ? dst_stride - payload_size : 0;
+    unsigned h, w;
+    uint8_t *dst = (uint8_t*)frame_bytes;
+
+    const uint16_t *y = (const uint16_t*)pic->p[0].p_pixels;
+    const uint16_t *u = (const uint16_t*)pic->p[1].p_pixels;
+    const uint16_t *v = (const uint16_t*)pic->p[2].p_pixels;
+
+#define WRITE_PIXELS(a, b, c)           \
+    do {                                \
+        val =   clip(*a++);             \
+        val |= (clip(*b++) << 10) |     \
+               (clip(*c++) << 20);      \
+        put_le32(&dst, val);           \
+    } while (0)
+
+    for (h = 0; h < height; h++) {
+        uint32_t val = 0;
+        for (w = 0; w + 5 < width; w += 6) {
+            WRITE_PIXELS(u, y, v);
+            WRITE_PIXELS(y, u, y);
+            WRITE_PIXELS(v, y, u);
+            WRITE_PIXELS(y, v, y);
+        }
+        if (w + 1 < width) {
+            WRITE_PIXELS(u, y, v);
+
+            val = clip(*y++);
+            if (w + 2 == width)
+                put_le32(&dst, val);
+#undef WRITE_PIXELS
+        }
+        if (w + 3 < width) {
+            val |= (clip(*u++) << 10) | (clip(*y++) << 20);
+            put_le32(&dst, val);
+
+            val = clip(*v++) | (clip(*y++) << 10);
+            put_le32(&dst, val);
+        }
+
+        memset(dst, 0, line_padding);
+        dst += line_padding;
+
+        y += pic->p[0].i_pitch / 2 - width;
+        u += pic->p[1].i_pitch / 2 - width / 2;
+        v += pic->p[2].i_pitch / 2 - width / 2;
+    }
+}
+
+static void Check(unsigned width)
+{
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_I422_10L);
+    fmt.i_width = fmt.i_visible_width = width;
+    fmt.i_height = fmt.i_visible_height = HEIGHT;
+
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    assert(pic != NULL);
+
+    uint32_t seed = width;
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const plane_t *p = &pic->p[i];
+        for (int y = 0; y < p->i_lines; y++)
+        {
+            uint16_t *line = (uint16_t *)&p->p_pixels[y * p->i_pitch];
+            for (int x = 0; x < p->i_pitch / 2; x++)
+            {
+                seed = seed * 1103515245 + 12345;
+                /* mostly 10-bit samples, some of them out of range */
+                line[x] = (seed >> 16) % 11 ? (seed >> 8) & 0x3ff : seed >> 16;
+            }
+        }
+    }
+
+    /* 48 pixels per 128 bytes, as the DeckLink rows */
+    const unsigned stride = ((width + 47) / 48) * 128;
+    uint8_t *ref = new uint8_t[stride * HEIGHT];
+    uint8_t *out = new uint8_t[stride * HEIGHT];
+    memset(ref, 0xa5, stride * HEIGHT);
+    memset(out, 0x5a, stride * HEIGHT);
+
+    ConvertC(pic, stride, ref);
+    sdi::V210::Convert(pic, stride, out);
+
+    if (memcmp(ref, out, stride * HEIGHT))
+    {
+        for (unsigned i = 0; i < stride * HEIGHT; i++)
+            if (ref[i] != out[i])
+            {
+                fprintf(stderr, "width %u: line %u byte %u: 0x%02x != 0x%02x\n",
+                        width, i / stride, i % stride, out[i], ref[i]);
+                break;
+            }
+        assert(!"V210 mismatch");
+    }
+    printf("width %u: OK\n", width);
+
+    delete[] ref;
+    delete[] out;
+    picture_Release(pic);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(widths); i++)
+        Check(widths[i]);
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*****************************************************************************
+ * hqdn3d.c: hqdn3d video filter tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+
+#include "../../../modules/video_filter/hqdn3d.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Checks the filter, which runs by slices and with SIMD when available,
+ * against the MPlayer code it was ported from, which it must match
+ * exactly: the PSNR of each plane must be infinite. */
+
+const char vlc_module_name[] = "test_hqdn3d";
+
+#define WIDTH  638
+#define HEIGHT 362
+#define FRAMES 6
+
+struct test_case
+{
+    const char *chain;
+    /* luma spatial, luma temporal, chroma spatial, chroma temporal */
+    double params[4];
+};
+
+static const struct test_case cases[] =
+{
+    { "hqdn3d", { 4.0, 6.0, 3.0, 4.5 } },
+    { "hqdn3d{luma-temp=0,chroma-temp=0}", { 4.0, 0.0, 3.0, 0.0 } },
+    { "hqdn3d{luma-spat=0,chroma-spat=0}", { 0.0, 6.0, 0.0, 4.5 } },
+    { "hqdn3d{luma-spat=30,luma-temp=2,chroma-spat=1,chroma-temp=50}",
+      { 30.0, 2.0, 1.0, 50.0 } },
+};
+
+/* Moving gradients, with noise for the filter to remove */
+static void FillPicture( picture_t *pic, unsigned frame )
+{
+    uint32_t seed = frame + 1;
+
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        plane_t *p = &pic->p[i];
+        for( int y = 0; y < p->i_visible_lines; y++ )
+        {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            for( int x = 0; x < p->i_visible_pitch; x++ )
+            {
+                seed = seed * 1103515245 + 12345;
+                line[x] = ((x + 3 * frame) ^ y) / 2 + ((seed >> 16) % 48);
+            }
+        }
+    }
+}
+
+static double PlanePSNR( const plane_t *a, const plane_t *b )
+{
+    uint64_t error = 0;
+
+    for( int y = 0; y < a->i_visible_lines; y++ )
+        for( int x = 0; x < a->i_visible_pitch; x++ )
+        {
+            const int d = a->p_pixels[y * a->i_pitch + x]
+                        - b->p_pixels[y * b->i_pitch + x];
+            error += d * d;
+        }
+    if( error == 0 )
+        return INFINITY;
+    return 10. * log10( 255. * 255. * a->i_visible_pitch * a->i_visible_lines
+                        / error );
+}
+
+static void Check( vlc_object_t *obj, const struct test_case *test )
+{
+    video_format_t fmt;
+    video_format_Init( &fmt, VLC_CODEC_I420 );
+    video_format_Setup( &fmt, VLC_CODEC_I420, WIDTH, HEIGHT, WIDTH, HEIGHT,
+                        1, 1 );
+
+    filter_t *filter = vlc_object_create( obj, sizeof (*filter) );
+    assert( filter != NULL );
+
+    char *name;
+    config_chain_t *chain;
+    free( config_ChainCreate( &name, &chain, test->chain ) );
+
+    es_format_InitFromVideo( &filter->fmt_in, &fmt );
+    es_format_InitFromVideo( &filter->fmt_out, &fmt );
+    filter->psz_name = name;
+    filter->p_cfg = chain;
+    filter->p_module = module_need( filter, "video filter", name, true );
+    assert( filter->p_module != NULL );
+
+    /* the state of the reference filter */
+    static int coefs[4][512*16];
+    unsigned int line[WIDTH];
+    unsigned short *frames[3] = { NULL };
+    for( int i = 0; i < 4; i++ )
+        PrecalcCoefs( coefs[i], test->params[i] );
+
+    for( unsigned f = 0; f < FRAMES; f++ )
+    {
+        picture_t *src = picture_NewFromFormat( &fmt );
+        picture_t *ref = picture_NewFromFormat( &fmt );
+        assert( src != NULL && ref != NULL );
+        FillPicture( src, f );
+
+        for( int i = 0; i < 3; i++ )
+        {
+            int *spatial = coefs[i ? 2 : 0], *temporal = coefs[i ? 3 : 1];
+            deNoise( src->p[i].p_pixels, ref->p[i].p_pixels, line, &frames[i],
+                     src->p[i].i_visible_pitch, src->p[i].i_visible_lines,
+                     src->p[i].i_pitch, ref->p[i].i_pitch,
+                     spatial, spatial, temporal );
+            assert( frames[i] != NULL );
+        }
+
+        picture_t *out = filter->pf_video_filter( filter, picture_Hold( src ) );
+        assert( out != NULL );
+
+        for( int i = 0; i < 3; i++ )
+        {
+            const double psnr = PlanePSNR( &ref->p[i], &out->p[i] );
+            if( psnr != INFINITY )
+            {
+                test_log( "%s: frame %u, plane %d: PSNR %.2f dB\n",
+                          test->chain, f, i, psnr );
+                abort();
+            }
+        }
+
+        picture_Release( out );
+        picture_Release( ref );
+        picture_Release( src );
+    }
+    test_log( "%s: OK\n", test->chain );
+
+    for( int i = 0; i < 3; i++ )
+        free( frames[i] );
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    vlc_object_delete( filter );
+    config_ChainDestroy( chain );
+    free( name );
+    video_format_Clean( &fmt );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    for( size_t i = 0; i < ARRAY_SIZE(cases); i++ )
+        Check( VLC_OBJECT(vlc->p_libvlc_int), &cases[i] );
+
+    libvlc_release( vlc );
+    return 0;
+}
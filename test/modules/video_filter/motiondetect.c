@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * motiondetect.c: motion detection video filter tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+#include <vlc_variables.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../libvlc/test.h"
+
+/* Moves a square over a noisy background, and checks the variables of the
+ * block detection */
+
+const char vlc_module_name[] = "test_motiondetect";
+
+#define WIDTH  642
+#define HEIGHT 362
+#define SQUARE 48
+
+static void FillPicture( picture_t *pic, int square_x, unsigned frame )
+{
+    uint32_t seed = frame + 1;
+
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        plane_t *p = &pic->p[i];
+        for( int y = 0; y < p->i_visible_lines; y++ )
+        {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            for( int x = 0; x < p->i_visible_pitch; x++ )
+            {
+                seed = seed * 1103515245 + 12345;
+                line[x] = 96 + ((seed >> 16) % 8);
+            }
+        }
+    }
+
+    plane_t *luma = &pic->p[Y_PLANE];
+    for( int y = 100; y < 100 + SQUARE; y++ )
+        memset( &luma->p_pixels[y * luma->i_pitch + square_x], 220, SQUARE );
+}
+
+struct step
+{
+    int square_x;
+    bool motion;
+};
+
+static const struct step steps[] =
+{
+    { 100, false }, /* first picture: nothing to compare with */
+    { 100, false },
+    { 140, true },
+    { 180, true },
+    { 180, false },
+    { 180, false },
+    { 500, true },
+};
+
+static void Check( vlc_object_t *obj, const char *chain )
+{
+    video_format_t fmt;
+    video_format_Init( &fmt, VLC_CODEC_I420 );
+    video_format_Setup( &fmt, VLC_CODEC_I420, WIDTH, HEIGHT, WIDTH, HEIGHT,
+                        1, 1 );
+
+    filter_t *filter = vlc_object_create( obj, sizeof (*filter) );
+    assert( filter != NULL );
+
+    char *name;
+    config_chain_t *cfg;
+    free( config_ChainCreate( &name, &cfg, chain ) );
+
+    es_format_InitFromVideo( &filter->fmt_in, &fmt );
+    es_format_InitFromVideo( &filter->fmt_out, &fmt );
+    filter->psz_name = name;
+    filter->p_cfg = cfg;
+    filter->p_module = module_need( filter, "video filter", name, true );
+    assert( filter->p_module != NULL );
+
+    for( size_t i = 0; i < ARRAY_SIZE(steps); i++ )
+    {
+        picture_t *pic = picture_NewFromFormat( &fmt );
+        assert( pic != NULL );
+        FillPicture( pic, steps[i].square_x, i );
+
+        picture_t *out = filter->pf_video_filter( filter, pic );
+        assert( out != NULL );
+        picture_Release( out );
+
+        const bool motion = var_GetBool( filter, "motiondetect-motion" );
+        const int64_t blocks = var_GetInteger( filter, "motiondetect-blocks" );
+        test_log( "%s: picture %zu, %"PRId64" moving blocks\n", chain, i,
+                  blocks );
+        assert( motion == steps[i].motion );
+        assert( motion == ( blocks > 0 ) );
+    }
+
+    module_unneed( filter, filter->p_module );
+    es_format_Clean( &filter->fmt_out );
+    es_format_Clean( &filter->fmt_in );
+    vlc_object_delete( filter );
+    config_ChainDestroy( cfg );
+    free( name );
+    video_format_Clean( &fmt );
+}
+
+int main( void )
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    assert( vlc != NULL );
+
+    Check( VLC_OBJECT(vlc->p_libvlc_int), "motiondetect{block-mode,draw=0}" );
+    Check( VLC_OBJECT(vlc->p_libvlc_int), "motiondetect{block-mode,scale=0}" );
+    Check( VLC_OBJECT(vlc->p_libvlc_int), "motiondetect{block-mode,scale=3}" );
+
+    libvlc_release( vlc );
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ * fft.c: visualization FFT tests
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+
+#include "../../../modules/visualization/visual/fft.h"
+
+#include "../../libvlc/test.h"
+
+/* Checks the intensities against the direct transform, computed in double
+ * precision, in the scale of the 16 bits samples. */
+
+static float Random( uint32_t *seed )
+{
+    *seed = *seed * 1103515245 + 12345;
+    return ( (int)( ( *seed >> 16 ) & 0x7fff ) - 0x4000 ) / (float)0x4000;
+}
+
+static void Check( fft_state *state, const float *input, const char *name )
+{
+    float output[FFT_BUFFER_SIZE / 2 + 1];
+    double error = 0., energy = 0.;
+
+    fft_perform( input, output, state );
+
+    for( unsigned k = 0; k <= FFT_BUFFER_SIZE / 2; k++ )
+    {
+        double re = 0., im = 0.;
+        for( unsigned n = 0; n < FFT_BUFFER_SIZE; n++ )
+        {
+            const double a = 2. * M_PI * k * n / FFT_BUFFER_SIZE;
+            re += 32768. * input[n] * cos( a );
+            im -= 32768. * input[n] * sin( a );
+        }
+        double power = re * re + im * im;
+        /* the constant and highest frequency terms */
+        if( k == 0 || k == FFT_BUFFER_SIZE / 2 )
+            power /= 4;
+
+        const double d = output[k] - power;
+        error += d * d;
+        energy += power * power;
+    }
+
+    const double snr = 10 * log10( energy / error );
+    test_log( "%s: SNR %.1f dB\n", name, snr );
+    if( !( snr > 90. ) )
+        abort();
+}
+
+int main( void )
+{
+    test_init();
+
+    fft_state *state = visual_fft_init();
+    assert( state != NULL );
+
+    float input[FFT_BUFFER_SIZE];
+    uint32_t seed = 42;
+    for( unsigned n = 0; n < FFT_BUFFER_SIZE; n++ )
+        input[n] = Random( &seed );
+    Check( state, input, "noise" );
+
+    for( unsigned n = 0; n < FFT_BUFFER_SIZE; n++ )
+        input[n] = .5f + .25f * sinf( 2.f * M_PI * 37.5f * n / FFT_BUFFER_SIZE );
+    Check( state, input, "tone" );
+
+    /* a full scale tone in bin 64 reaches the top of the scale */
+    float output[FFT_BUFFER_SIZE / 2 + 1];
+    for( unsigned n = 0; n < FFT_BUFFER_SIZE; n++ )
+        input[n] = cosf( 2.f * M_PI * 64 * n / FFT_BUFFER_SIZE );
+    fft_perform( input, output, state );
+    const float top = FFT_BUFFER_SIZE / 2 * 32768.f;
+    assert( fabsf( output[64] / ( top * top ) - 1.f ) < 1e-4f );
+    assert( output[63] < 1e-6f * output[64] && output[65] < 1e-6f * output[64] );
+
+    /* the channel copy repeats the frames of short blocks */
+    const float frames[] = { 1.f, -1.f, 2.f, -2.f, 3.f, -3.f };
+    fft_copy_channel( input, frames, 3, 2, 1 );
+    for( unsigned n = 0; n < FFT_BUFFER_SIZE; n++ )
+        assert( input[n] == -(float)( n % 3 + 1 ) );
+
+    fft_close( state );
+    return 0;
+}
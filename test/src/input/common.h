@@ -18,6 +18,7 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#include <stdint.h>
 #include <vlc/vlc.h>
 
 #if 0
@@ -37,6 +38,12 @@ struct vlc_run_args
 
     /* true to test demux controls */
     bool test_demux_controls;
+
+    /* number of benchmark runs, 0 to process the input once */
+    unsigned bench_runs;
+
+    /* number of memory allocations so far, NULL if not counted */
+    uintmax_t (*alloc_count)(void);
 };
 
 void vlc_run_args_init(struct vlc_run_args *args);
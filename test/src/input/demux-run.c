@@ -33,6 +33,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_access.h>
@@ -49,10 +52,18 @@
 #include "demux-run.h"
 #include "decoder.h"
 
+struct demux_stats
+{
+    uintmax_t input;  /* size of the input, in bytes */
+    uintmax_t blocks; /* blocks sent to the ES output */
+    uintmax_t bytes;  /* payload of these blocks */
+};
+
 struct test_es_out_t
 {
     struct es_out_t out;
     struct es_out_id_t *ids;
+    struct demux_stats stats;
 #ifdef HAVE_DECODERS
     vlc_object_t *parent;
 #endif
@@ -106,6 +117,8 @@ static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
 
     //debug("[%p] Sent    ES: %zu\n", (void *)idd, block->i_buffer);
     EsOutCheckId(ctx, id);
+    ctx->stats.blocks++;
+    ctx->stats.bytes += block->i_buffer;
 #ifdef HAVE_DECODERS
     if (id->decoder)
         test_decoder_process(id->decoder, block);
@@ -230,6 +243,7 @@ static es_out_t *test_es_out_create(vlc_object_t *parent)
     }
 
     ctx->ids = NULL;
+    memset(&ctx->stats, 0, sizeof (ctx->stats));
 
     es_out_t *out = &ctx->out;
     out->cbs = &es_out_cbs;
@@ -279,7 +293,8 @@ static void demux_get_meta(demux_t *demux)
     vlc_meta_Delete(p_meta);
 }
 
-static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
+static int demux_process_stream(const struct vlc_run_args *args, stream_t *s,
+                                struct demux_stats *stats)
 {
     const char *name = args->name;
     if (name == NULL)
@@ -292,6 +307,10 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     if (out == NULL)
         return -1;
 
+    uint64_t size;
+    if (stats != NULL && vlc_stream_GetSize(s, &size) == VLC_SUCCESS)
+        stats->input += size;
+
     demux_t *demux = demux_New(VLC_OBJECT(s), name, s, out);
     if (demux == NULL)
     {
@@ -329,6 +348,12 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     }
 
     demux_Delete(demux);
+    if (stats != NULL)
+    {
+        const struct test_es_out_t *ctx = (struct test_es_out_t *)out;
+        stats->blocks += ctx->stats.blocks;
+        stats->bytes += ctx->stats.bytes;
+    }
     es_out_Delete(out);
 
     debug("Completed with %" PRIuMAX " iteration(s).\n", i);
@@ -336,17 +361,75 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     return val == VLC_DEMUXER_EOF ? 0 : -1;
 }
 
+static void demux_bench_report(const struct vlc_run_args *args,
+                               const char *url, const struct demux_stats *stats,
+                               vlc_tick_t elapsed, uintmax_t allocs)
+{
+    double secs = secf_from_vlc_tick(elapsed > 0 ? elapsed : 1);
+
+    printf("%s: %u run(s) in %.3f s\n", url, args->bench_runs, secs);
+    printf("  input:       %.2f MB/s\n", stats->input / secs / 1e6);
+    printf("  output:      %.2f MB/s, %.0f blocks/s (%ju blocks per run)\n",
+           stats->bytes / secs / 1e6, stats->blocks / secs,
+           stats->blocks / args->bench_runs);
+    if (args->alloc_count != NULL && stats->blocks > 0)
+        printf("  allocations: %.2f per block\n",
+               (double)allocs / stats->blocks);
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        printf("  peak RSS:    %ld kB\n", usage.ru_maxrss);
+#endif
+}
+
+/* Processes the input bench_runs times, and reports the throughput */
+static int demux_bench_url(const struct vlc_run_args *args,
+                           libvlc_instance_t *vlc, const char *url)
+{
+    struct demux_stats stats = { 0, 0, 0 };
+    uintmax_t allocs = 0;
+    vlc_tick_t elapsed = 0;
+
+    for (unsigned i = 0; i < args->bench_runs; i++)
+    {
+        stream_t *s = vlc_access_NewMRL(VLC_OBJECT(vlc->p_libvlc_int), url);
+        if (s == NULL)
+        {
+            fprintf(stderr, "Error: cannot create input stream: %s\n", url);
+            return -1;
+        }
+
+        uintmax_t allocs_start = args->alloc_count ? args->alloc_count() : 0;
+        vlc_tick_t start = vlc_tick_now();
+        int ret = demux_process_stream(args, s, &stats);
+        elapsed += vlc_tick_now() - start;
+        if (args->alloc_count != NULL)
+            allocs += args->alloc_count() - allocs_start;
+        if (ret)
+            return ret;
+    }
+
+    demux_bench_report(args, url, &stats, elapsed, allocs);
+    return 0;
+}
+
 int vlc_demux_process_url(const struct vlc_run_args *args, const char *url)
 {
     libvlc_instance_t *vlc = libvlc_create(args);
     if (vlc == NULL)
         return -1;
 
-    stream_t *s = vlc_access_NewMRL(VLC_OBJECT(vlc->p_libvlc_int), url);
-    if (s == NULL)
-        fprintf(stderr, "Error: cannot create input stream: %s\n", url);
+    int ret;
+    if (args->bench_runs > 0)
+        ret = demux_bench_url(args, vlc, url);
+    else
+    {
+        stream_t *s = vlc_access_NewMRL(VLC_OBJECT(vlc->p_libvlc_int), url);
+        if (s == NULL)
+            fprintf(stderr, "Error: cannot create input stream: %s\n", url);
 
-    int ret = demux_process_stream(args, s);
+        ret = demux_process_stream(args, s, NULL);
+    }
     libvlc_release(vlc);
     return ret;
 }
@@ -374,7 +457,7 @@ int libvlc_demux_process_memory(libvlc_instance_t *vlc,
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream\n");
 
-    return demux_process_stream(args, s);
+    return demux_process_stream(args, s, NULL);
 }
 
 int vlc_demux_process_memory(const struct vlc_run_args *args,
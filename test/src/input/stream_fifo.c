@@ -241,6 +241,39 @@ int main(void)
     vlc_stream_Delete(reader);
     block_Release(block);
 
+    /* queued blocks are handed over without copying */
+    writer = vlc_stream_fifo_New(parent, &reader);
+    assert(writer != NULL);
+    block_t *queued = block_Alloc(10);
+    assert(queued != NULL);
+    memcpy(queued->p_buffer, "1st block\n", 10);
+    val = vlc_stream_fifo_Queue(writer, queued);
+    assert(val == 0);
+    queued = block_Alloc(10);
+    assert(queued != NULL);
+    memcpy(queued->p_buffer, "2nd block\n", 10);
+    val = vlc_stream_fifo_Queue(writer, queued);
+    assert(val == 0);
+    vlc_stream_fifo_Close(writer);
+
+    block = vlc_stream_ReadBlock(reader);
+    assert(block != NULL);
+    assert(block->i_buffer == 10);
+    block_Release(block);
+
+    val = vlc_stream_Read(reader, buf, 4);
+    assert(val == 4);
+    assert(memcmp(buf, "2nd ", 4) == 0);
+
+    /* ... including their remainder after a partial read */
+    block = vlc_stream_ReadBlock(reader);
+    assert(block == queued);
+    assert(block->i_buffer == 6);
+    assert(vlc_stream_Tell(reader) == 20);
+    assert(memcmp(block->p_buffer, "block\n", 6) == 0);
+    block_Release(block);
+    vlc_stream_Delete(reader);
+
     libvlc_release(vlc);
 
     return 0;
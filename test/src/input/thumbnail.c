@@ -207,6 +207,68 @@ static void test_cancel_thumbnail( libvlc_instance_t* p_vlc )
     vlc_thumbnailer_Release( p_thumbnailer );
 }
 
+struct test_batch_ctx
+{
+    vlc_cond_t cond;
+    vlc_mutex_t lock;
+    size_t count;
+};
+
+static void thumbnailer_callback_batch( void* data, size_t index,
+                                        picture_t* p_thumbnail )
+{
+    struct test_batch_ctx* p_ctx = data;
+    vlc_mutex_lock( &p_ctx->lock );
+    assert( index == p_ctx->count && "Unexpected thumbnail order" );
+    assert( p_thumbnail != NULL );
+    assert( p_thumbnail->format.i_chroma == VLC_CODEC_ARGB );
+    p_ctx->count++;
+    vlc_cond_signal( &p_ctx->cond );
+    vlc_mutex_unlock( &p_ctx->lock );
+}
+
+static void test_batch_thumbnails( libvlc_instance_t* p_vlc )
+{
+    vlc_thumbnailer_t* p_thumbnailer = vlc_thumbnailer_Create(
+                VLC_OBJECT( p_vlc->p_libvlc_int ) );
+    assert( p_thumbnailer != NULL );
+
+    struct test_batch_ctx ctx;
+    vlc_cond_init( &ctx.cond );
+    vlc_mutex_init( &ctx.lock );
+    ctx.count = 0;
+
+    char* psz_mrl;
+    if ( asprintf( &psz_mrl, "mock://video_track_count=1;audio_track_count=1"
+                   ";length=%" PRId64 ";video_chroma=ARGB", MOCK_DURATION ) < 0 )
+        assert( !"Failed to allocate mock mrl" );
+    input_item_t* p_item = input_item_New( psz_mrl, "mock item" );
+    assert( p_item != NULL );
+
+    static const vlc_tick_t times[] = {
+        VLC_TICK_FROM_SEC( 10 ), VLC_TICK_FROM_SEC( 60 ),
+        VLC_TICK_FROM_SEC( 120 ), VLC_TICK_FROM_SEC( 240 ),
+    };
+
+    vlc_mutex_lock( &ctx.lock );
+    vlc_thumbnailer_request_t* p_req = vlc_thumbnailer_RequestBatch(
+        p_thumbnailer, times, ARRAY_SIZE( times ), VLC_THUMBNAILER_SEEK_FAST,
+        p_item, VLC_TICK_FROM_SEC( 4 ), thumbnailer_callback_batch, &ctx );
+    assert( p_req != NULL );
+    while ( ctx.count < ARRAY_SIZE( times ) )
+    {
+        vlc_tick_t timeout = vlc_tick_now() + VLC_TICK_FROM_SEC( 1 );
+        int res = vlc_cond_timedwait( &ctx.cond, &ctx.lock, timeout );
+        assert( res != ETIMEDOUT );
+    }
+    vlc_mutex_unlock( &ctx.lock );
+
+    input_item_Release( p_item );
+    free( psz_mrl );
+
+    vlc_thumbnailer_Release( p_thumbnailer );
+}
+
 int main()
 {
     test_init();
@@ -220,6 +282,7 @@ int main()
 
     test_thumbnails( vlc );
     test_cancel_thumbnail( vlc );
+    test_batch_thumbnails( vlc );
 
     libvlc_release( vlc );
 }
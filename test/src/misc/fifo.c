@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * fifo.c: test and benchmark for block FIFOs
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
+
+#define BLOCKS_COUNT 200000
+#define PRODUCERS    2
+
+static block_fifo_t *fifo;
+
+static void *Producer(void *data)
+{
+    uintptr_t id = (uintptr_t)data;
+
+    for (unsigned i = 0; i < BLOCKS_COUNT; i++)
+    {
+        block_t *block = block_Alloc(188);
+        assert(block != NULL);
+        block->i_dts = (id << 32) | i;
+        block_FifoPut(fifo, block);
+    }
+    return NULL;
+}
+
+static void test_order(unsigned producers)
+{
+    vlc_thread_t th[PRODUCERS];
+    uint64_t next[PRODUCERS] = { 0 };
+
+    fifo = block_FifoNew();
+    assert(fifo != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+
+    for (uintptr_t i = 0; i < producers; i++)
+    {
+        int ret = vlc_clone(&th[i], Producer, (void *)i,
+                            VLC_THREAD_PRIORITY_LOW);
+        assert(ret == 0);
+        (void) ret;
+    }
+
+    for (unsigned count = 0; count < producers * BLOCKS_COUNT; count++)
+    {
+        block_t *block = block_FifoGet(fifo);
+        uint64_t id = block->i_dts >> 32;
+
+        assert(id < producers);
+        /* each producer order is preserved */
+        assert((uint32_t)block->i_dts == next[id]);
+        next[id]++;
+        block_Release(block);
+    }
+
+    vlc_tick_t duration = vlc_tick_now() - start;
+
+    for (unsigned i = 0; i < producers; i++)
+        vlc_join(th[i], NULL);
+
+    vlc_fifo_Lock(fifo);
+    assert(vlc_fifo_GetCount(fifo) == 0);
+    vlc_fifo_Unlock(fifo);
+    block_FifoRelease(fifo);
+
+    printf("%u producer(s): %u blocks in %"PRId64" us (%.0f blocks/s)\n",
+           producers, producers * BLOCKS_COUNT, US_FROM_VLC_TICK(duration),
+           producers * BLOCKS_COUNT / secf_from_vlc_tick(duration + 1));
+}
+
+static void test_release(void)
+{
+    fifo = block_FifoNew();
+    assert(fifo != NULL);
+
+    /* blocks left in the FIFO are released with it */
+    block_t *chain = NULL;
+    block_ChainAppend(&chain, block_Alloc(16));
+    block_ChainAppend(&chain, block_Alloc(32));
+    block_FifoPut(fifo, chain);
+    block_FifoPut(fifo, block_Alloc(64));
+
+    vlc_fifo_Lock(fifo);
+    assert(vlc_fifo_GetCount(fifo) == 3);
+    assert(vlc_fifo_GetBytes(fifo) == 16 + 32 + 64);
+    vlc_fifo_Unlock(fifo);
+
+    block_t *block = block_FifoGet(fifo);
+    assert(block->i_buffer == 16);
+    block_Release(block);
+
+    block_FifoRelease(fifo);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_release();
+    test_order(1);
+    test_order(PRODUCERS);
+
+    return 0;
+}
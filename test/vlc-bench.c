@@ -0,0 +1,701 @@
+/**
+ * @file vlc-bench.c
+ */
+/*****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Runs video filters, blenders and chroma converters over synthetic frames,
+ * and audio filters and amplifiers over synthetic samples, and reports the time per pixel
+ * or per sample and the memory throughput, so that the optimizations of
+ * those modules can be tracked.
+ *
+ * The throughput counts the input and output pictures bytes, and also the
+ * destination picture as input for the blending.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_aout_volume.h>
+#include <vlc_block.h>
+#include <vlc_configuration.h>
+#include <vlc_filter.h>
+#include <vlc_fourcc.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+
+enum bench_type
+{
+    BENCH_FILTER,
+    BENCH_CONVERTER,
+    BENCH_BLEND,
+    BENCH_AUDIO,
+    BENCH_VOLUME,
+};
+
+struct bench_case
+{
+    const char *name;
+    enum bench_type type;
+    const char *filter; /* name{config} of the module, NULL for any */
+    vlc_fourcc_t in;    /* blending: subpicture chroma, audio: format */
+    vlc_fourcc_t out;   /* blending: picture chroma, audio: format */
+    bool scale;         /* converts to the output size, volume: ramps */
+    uint8_t channels;   /* audio: number of channels, 2 if zero */
+};
+
+static const struct bench_case cases[] = {
+    { "deinterlace-blend", BENCH_FILTER, "deinterlace{mode=blend}",
+      VLC_CODEC_I420, VLC_CODEC_I420, false },
+    { "deinterlace-linear", BENCH_FILTER, "deinterlace{mode=linear}",
+      VLC_CODEC_I420, VLC_CODEC_I420, false },
+    { "deinterlace-yadif", BENCH_FILTER, "deinterlace{mode=yadif}",
+      VLC_CODEC_I420, VLC_CODEC_I420, false },
+    { "deinterlace-yadif2x", BENCH_FILTER, "deinterlace{mode=yadif2x}",
+      VLC_CODEC_I420, VLC_CODEC_I420, false },
+    { "hqdn3d", BENCH_FILTER, "hqdn3d",
+      VLC_CODEC_I420, VLC_CODEC_I420, false },
+    { "gradfun", BENCH_FILTER, "gradfun",
+      VLC_CODEC_I420, VLC_CODEC_I420, false },
+    { "gradfun-10bit", BENCH_FILTER, "gradfun",
+      VLC_CODEC_I420_10L, VLC_CODEC_I420_10L, false },
+    { "blend-yuva-i420", BENCH_BLEND, NULL,
+      VLC_CODEC_YUVA, VLC_CODEC_I420, false },
+    { "blend-yuva-nv12", BENCH_BLEND, NULL,
+      VLC_CODEC_YUVA, VLC_CODEC_NV12, false },
+    { "blend-rgba-rv32", BENCH_BLEND, NULL,
+      VLC_CODEC_RGBA, VLC_CODEC_RGB32, false },
+    { "blend-rgba-bgra", BENCH_BLEND, NULL,
+      VLC_CODEC_RGBA, VLC_CODEC_BGRA, false },
+    { "chroma-i420-rv32", BENCH_CONVERTER, NULL,
+      VLC_CODEC_I420, VLC_CODEC_RGB32, false },
+    { "chroma-i420-rv16", BENCH_CONVERTER, NULL,
+      VLC_CODEC_I420, VLC_CODEC_RGB16, false },
+    { "chroma-i420-nv12", BENCH_CONVERTER, NULL,
+      VLC_CODEC_I420, VLC_CODEC_NV12, false },
+    { "chroma-nv12-i420", BENCH_CONVERTER, NULL,
+      VLC_CODEC_NV12, VLC_CODEC_I420, false },
+    { "chroma-i420-yuy2", BENCH_CONVERTER, NULL,
+      VLC_CODEC_I420, VLC_CODEC_YUYV, false },
+    { "chroma-yuy2-i420", BENCH_CONVERTER, NULL,
+      VLC_CODEC_YUYV, VLC_CODEC_I420, false },
+    { "chroma-i422-i420", BENCH_CONVERTER, NULL,
+      VLC_CODEC_I422, VLC_CODEC_I420, false },
+    { "chroma-p010-i420", BENCH_CONVERTER, NULL,
+      VLC_CODEC_P010, VLC_CODEC_I420_10L, false },
+    { "scale-i420", BENCH_CONVERTER, NULL,
+      VLC_CODEC_I420, VLC_CODEC_I420, true },
+    { "scale-rv32", BENCH_CONVERTER, NULL,
+      VLC_CODEC_RGB32, VLC_CODEC_RGB32, true },
+    { "spatializer", BENCH_AUDIO, "spatializer",
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false },
+    { "equalizer", BENCH_AUDIO, "equalizer",
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false },
+    { "equalizer-7.1", BENCH_AUDIO, "equalizer",
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false, 8 },
+    { "volume", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false },
+    { "volume-5.1", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false, 6 },
+    { "volume-7.1", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false, 8 },
+    { "volume-32ch", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, false, 32 },
+    { "volume-ramp", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, true },
+    { "volume-ramp-7.1", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, true, 8 },
+    { "volume-ramp-32ch", BENCH_VOLUME, NULL,
+      VLC_CODEC_FL32, VLC_CODEC_FL32, true, 32 },
+};
+
+struct bench_config
+{
+    unsigned iterations;
+    unsigned width, height;
+    unsigned scaled_width, scaled_height;
+    const char *module; /* forced converter or blender */
+    double ghz; /* reports cycles rather than nanoseconds if not zero */
+};
+
+struct bench_result
+{
+    const char *module;
+    vlc_tick_t duration;
+    uint64_t bytes;
+    uint64_t pixels; /* or audio samples, of all the channels */
+};
+
+#define BENCH_PICTURES 4
+
+/* 5 seconds of stereo audio per iteration, by blocks of 1024 samples */
+#define BENCH_AUDIO_RATE     48000
+#define BENCH_AUDIO_SAMPLES  1024
+#define BENCH_AUDIO_BLOCKS   (5 * BENCH_AUDIO_RATE / BENCH_AUDIO_SAMPLES)
+
+/* Fills a picture with gradients and some noise, and in the subpicture
+ * chromas, with transparent spans between translucent and opaque ones */
+static void FillPicture(picture_t *pic, uint32_t seed)
+{
+    const bool alpha = pic->format.i_chroma == VLC_CODEC_YUVA
+                    || pic->format.i_chroma == VLC_CODEC_RGBA
+                    || pic->format.i_chroma == VLC_CODEC_BGRA;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+        for (int y = 0; y < p->i_lines; y++)
+        {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            for (int x = 0; x < p->i_pitch; x++)
+            {
+                seed = seed * 1103515245 + 12345;
+                line[x] = (x + y + i * 64) / 8 + ((seed >> 16) & 15);
+            }
+        }
+    }
+
+    if (!alpha)
+        return;
+
+    /* one span out of three is transparent, one out of three opaque */
+    const bool packed = pic->format.i_chroma != VLC_CODEC_YUVA;
+    plane_t *p = &pic->p[packed ? 0 : 3];
+    for (int y = 0; y < p->i_visible_lines; y++)
+    {
+        uint8_t *line = &p->p_pixels[y * p->i_pitch];
+        const int width = packed ? p->i_visible_pitch / 4 : p->i_visible_pitch;
+        for (int x = 0; x < width; x++)
+        {
+            const unsigned span = (x / 64 + y / 32) % 3;
+            uint8_t *a = packed ? &line[4 * x + 3] : &line[x];
+            *a = span == 0 ? 0 : span == 1 ? 255 : *a;
+        }
+    }
+}
+
+static uint64_t PictureBytes(const picture_t *pic)
+{
+    uint64_t bytes = 0;
+    for (int i = 0; i < pic->i_planes; i++)
+        bytes += (uint64_t)pic->p[i].i_visible_pitch * pic->p[i].i_visible_lines;
+    return bytes;
+}
+
+static void VideoFormatInit(video_format_t *fmt, vlc_fourcc_t chroma,
+                            unsigned width, unsigned height)
+{
+    video_format_Init(fmt, chroma);
+    video_format_Setup(fmt, chroma, width, height, width, height, 1, 1);
+    fmt->i_frame_rate = 25;
+    fmt->i_frame_rate_base = 1;
+    video_format_FixRgb(fmt);
+}
+
+static int RunBlend(vlc_object_t *obj, const struct bench_case *bench,
+                    const struct bench_config *cfg, struct bench_result *res)
+{
+    video_format_t src_fmt, dst_fmt;
+    VideoFormatInit(&src_fmt, bench->in, cfg->width, cfg->height);
+    VideoFormatInit(&dst_fmt, bench->out, cfg->width, cfg->height);
+
+    picture_t *src = picture_NewFromFormat(&src_fmt);
+    picture_t *dst = picture_NewFromFormat(&dst_fmt);
+    vlc_blender_t *blend = filter_NewBlend(obj, &dst_fmt);
+    int ret = VLC_EGENERIC;
+
+    if (src == NULL || dst == NULL || blend == NULL
+     || filter_ConfigureBlend(blend, cfg->width, cfg->height, &src_fmt))
+        goto error;
+
+    FillPicture(src, 1);
+    FillPicture(dst, 2);
+
+    /* warm up, then the same picture is blended over and over */
+    if (filter_Blend(blend, dst, 0, 0, src, 255))
+        goto error;
+
+    const vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < cfg->iterations; i++)
+        filter_Blend(blend, dst, 0, 0, src, 255);
+    res->duration = vlc_tick_now() - start;
+    res->module = module_get_object(blend->p_module);
+    res->bytes = (PictureBytes(src) + 2 * PictureBytes(dst)) * cfg->iterations;
+    res->pixels = (uint64_t)cfg->width * cfg->height * cfg->iterations;
+    ret = VLC_SUCCESS;
+
+error:
+    if (blend != NULL)
+        filter_DeleteBlend(blend);
+    if (dst != NULL)
+        picture_Release(dst);
+    if (src != NULL)
+        picture_Release(src);
+    video_format_Clean(&dst_fmt);
+    video_format_Clean(&src_fmt);
+    return ret;
+}
+
+static int RunFilter(vlc_object_t *obj, const struct bench_case *bench,
+                     const struct bench_config *cfg, struct bench_result *res)
+{
+    const bool converter = bench->type == BENCH_CONVERTER;
+    video_format_t fmt_in, fmt_out;
+    VideoFormatInit(&fmt_in, bench->in, cfg->width, cfg->height);
+    if (bench->scale)
+        VideoFormatInit(&fmt_out, bench->out,
+                        cfg->scaled_width, cfg->scaled_height);
+    else
+        VideoFormatInit(&fmt_out, bench->out, cfg->width, cfg->height);
+
+    filter_t *filter = vlc_object_create(obj, sizeof(*filter));
+    if (unlikely(filter == NULL))
+        return VLC_ENOMEM;
+
+    char *name = NULL;
+    config_chain_t *chain = NULL;
+    const char *module = cfg->module;
+    if (bench->filter != NULL)
+    {
+        free(config_ChainCreate(&name, &chain, bench->filter));
+        module = name;
+    }
+
+    es_format_InitFromVideo(&filter->fmt_in, &fmt_in);
+    es_format_InitFromVideo(&filter->fmt_out, &fmt_out);
+    filter->b_allow_fmt_out_change = false;
+    filter->psz_name = name;
+    filter->p_cfg = chain;
+
+    picture_t *pics[BENCH_PICTURES] = { NULL };
+    int ret = VLC_EGENERIC;
+
+    filter->p_module = module_need(filter,
+                                   converter ? "video converter" : "video filter",
+                                   module, module != NULL);
+    if (filter->p_module == NULL)
+        goto error;
+
+    for (unsigned i = 0; i < BENCH_PICTURES; i++)
+    {
+        pics[i] = picture_NewFromFormat(&fmt_in);
+        if (pics[i] == NULL)
+            goto error;
+        FillPicture(pics[i], i + 1);
+    }
+
+    /* the filters with a history get distinct pictures with increasing
+     * dates, and the pictures they hold are only released at the end */
+    uint64_t bytes = 0;
+    vlc_tick_t duration = 0;
+    for (unsigned i = 0; i < cfg->iterations + BENCH_PICTURES; i++)
+    {
+        picture_t *pic = picture_Hold(pics[i % BENCH_PICTURES]);
+        pic->date = VLC_TICK_0 + i * VLC_TICK_FROM_MS(40);
+        pic->b_progressive = false;
+        pic->b_top_field_first = true;
+
+        const vlc_tick_t start = vlc_tick_now();
+        picture_t *out = filter->pf_video_filter(filter, pic);
+        const vlc_tick_t end = vlc_tick_now();
+
+        /* the first iterations fill the history and warm the caches up */
+        if (i >= BENCH_PICTURES)
+            duration += end - start;
+
+        while (out != NULL)
+        {
+            picture_t *next = out->p_next;
+            if (i >= BENCH_PICTURES)
+                bytes += PictureBytes(out);
+            picture_Release(out);
+            out = next;
+        }
+        if (i >= BENCH_PICTURES)
+            bytes += PictureBytes(pics[0]);
+    }
+    if (filter->pf_flush != NULL)
+        filter->pf_flush(filter);
+
+    res->module = module_get_object(filter->p_module);
+    res->duration = duration;
+    res->bytes = bytes;
+    res->pixels = (uint64_t)cfg->width * cfg->height * cfg->iterations;
+    ret = VLC_SUCCESS;
+
+error:
+    if (filter->p_module != NULL)
+        module_unneed(filter, filter->p_module);
+    for (unsigned i = 0; i < BENCH_PICTURES; i++)
+        if (pics[i] != NULL)
+            picture_Release(pics[i]);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_delete(filter);
+    config_ChainDestroy(chain);
+    free(name);
+    video_format_Clean(&fmt_out);
+    video_format_Clean(&fmt_in);
+    return ret;
+}
+
+/* A decaying noise, which also makes the filters with a feedback run into
+ * denormal numbers */
+static void FillAudio(float *samples, size_t count, uint32_t seed)
+{
+    float amplitude = 1.f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        samples[i] = amplitude * ((int)((seed >> 16) & 0x7fff) - 0x4000) / 0x4000;
+        amplitude *= 0.9999f;
+    }
+}
+
+static int RunAudio(vlc_object_t *obj, const struct bench_case *bench,
+                    const struct bench_config *cfg, struct bench_result *res)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof(*filter));
+    if (unlikely(filter == NULL))
+        return VLC_ENOMEM;
+
+    char *name = NULL;
+    config_chain_t *chain = NULL;
+    free(config_ChainCreate(&name, &chain, bench->filter));
+
+    es_format_Init(&filter->fmt_in, AUDIO_ES, bench->in);
+    filter->fmt_in.audio.i_format = bench->in;
+    filter->fmt_in.audio.i_rate = BENCH_AUDIO_RATE;
+    filter->fmt_in.audio.i_physical_channels =
+        vlc_chan_maps[bench->channels ? bench->channels : 2];
+    aout_FormatPrepare(&filter->fmt_in.audio);
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+    filter->fmt_out.i_codec = filter->fmt_out.audio.i_format = bench->out;
+    filter->psz_name = name;
+    filter->p_cfg = chain;
+
+    const unsigned channels = aout_FormatNbChannels(&filter->fmt_in.audio);
+    const size_t count = BENCH_AUDIO_SAMPLES * channels;
+    float *samples = vlc_alloc(count * BENCH_AUDIO_BLOCKS, sizeof(*samples));
+    int ret = VLC_EGENERIC;
+
+    filter->p_module = module_need(filter, "audio filter", name, true);
+    if (filter->p_module == NULL || samples == NULL
+     || filter->fmt_out.audio.i_format != VLC_CODEC_FL32)
+        goto error;
+
+    FillAudio(samples, count * BENCH_AUDIO_BLOCKS, 1);
+
+    /* the same samples are filtered in every iteration, the state of the
+     * filter keeps on changing anyway */
+    vlc_tick_t duration = 0;
+    for (unsigned i = 0; i < cfg->iterations * BENCH_AUDIO_BLOCKS; i++)
+    {
+        block_t *block = block_Alloc(count * sizeof(*samples));
+        if (block == NULL)
+            goto error;
+        memcpy(block->p_buffer, &samples[(i % BENCH_AUDIO_BLOCKS) * count],
+               count * sizeof(*samples));
+        block->i_nb_samples = BENCH_AUDIO_SAMPLES;
+        block->i_pts = block->i_dts = VLC_TICK_0
+            + vlc_tick_from_samples((uint64_t)i * BENCH_AUDIO_SAMPLES,
+                                    BENCH_AUDIO_RATE);
+
+        const vlc_tick_t start = vlc_tick_now();
+        block_t *out = filter->pf_audio_filter(filter, block);
+        duration += vlc_tick_now() - start;
+
+        if (out != NULL)
+            block_Release(out);
+    }
+
+    res->module = module_get_object(filter->p_module);
+    res->duration = duration;
+    res->bytes = 2 * count * sizeof(*samples) * BENCH_AUDIO_BLOCKS
+               * cfg->iterations;
+    res->pixels = (uint64_t)count * BENCH_AUDIO_BLOCKS * cfg->iterations;
+    ret = VLC_SUCCESS;
+
+error:
+    if (filter->p_module != NULL)
+        module_unneed(filter, filter->p_module);
+    free(samples);
+    es_format_Clean(&filter->fmt_out);
+    es_format_Clean(&filter->fmt_in);
+    vlc_object_delete(filter);
+    config_ChainDestroy(chain);
+    free(name);
+    return ret;
+}
+
+static int RunVolume(vlc_object_t *obj, const struct bench_case *bench,
+                     const struct bench_config *cfg, struct bench_result *res)
+{
+    audio_volume_t *volume = vlc_object_create(obj, sizeof(*volume));
+    if (unlikely(volume == NULL))
+        return VLC_ENOMEM;
+    volume->format = bench->in;
+
+    const unsigned channels = bench->channels ? bench->channels : 2;
+    const size_t count = BENCH_AUDIO_SAMPLES * channels;
+    float *samples = vlc_alloc(count * BENCH_AUDIO_BLOCKS, sizeof(*samples));
+    block_t *block = block_Alloc(count * sizeof(*samples));
+    int ret = VLC_EGENERIC;
+
+    module_t *module = module_need(volume, "audio volume", cfg->module,
+                                   cfg->module != NULL);
+    if (module == NULL || samples == NULL || block == NULL
+     || (bench->scale && volume->amplify_ramp == NULL))
+        goto error;
+
+    FillAudio(samples, count * BENCH_AUDIO_BLOCKS, 1);
+    block->i_nb_samples = BENCH_AUDIO_SAMPLES;
+
+    /* the gain keeps on changing, so that none of the buffers is skipped */
+    vlc_tick_t duration = 0;
+    for (unsigned i = 0; i < cfg->iterations * BENCH_AUDIO_BLOCKS; i++)
+    {
+        const float amp = (i & 1) ? 2.f : .5f;
+
+        memcpy(block->p_buffer, &samples[(i % BENCH_AUDIO_BLOCKS) * count],
+               count * sizeof(*samples));
+
+        const vlc_tick_t start = vlc_tick_now();
+        if (bench->scale)
+            volume->amplify_ramp(volume, block, 2.5f - amp, amp);
+        else
+            volume->amplify(volume, block, amp);
+        duration += vlc_tick_now() - start;
+    }
+
+    res->module = module_get_object(module);
+    res->duration = duration;
+    res->bytes = 2 * count * sizeof(*samples) * BENCH_AUDIO_BLOCKS
+               * cfg->iterations;
+    res->pixels = (uint64_t)count * BENCH_AUDIO_BLOCKS * cfg->iterations;
+    ret = VLC_SUCCESS;
+
+error:
+    if (module != NULL)
+        module_unneed(volume, module);
+    if (block != NULL)
+        block_Release(block);
+    free(samples);
+    vlc_object_delete(volume);
+    return ret;
+}
+
+static int ParseSize(const char *str, unsigned *width, unsigned *height)
+{
+    if (sscanf(str, "%ux%u", width, height) != 2
+     || *width == 0 || *height == 0 || *width > 16384 || *height > 16384)
+    {
+        fprintf(stderr, "invalid size: %s\n", str);
+        return -1;
+    }
+    return 0;
+}
+
+static vlc_fourcc_t ParseChroma(const char *str)
+{
+    vlc_fourcc_t chroma = vlc_fourcc_GetCodecFromString(VIDEO_ES, str);
+    if (chroma == 0 || vlc_fourcc_GetChromaDescription(chroma) == NULL)
+    {
+        fprintf(stderr, "unknown chroma: %s\n", str);
+        return 0;
+    }
+    return chroma;
+}
+
+static void Usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options] [case pattern...]\n"
+        "\n"
+        "Options:\n"
+        "  -n <count>      iterations per case (default 100)\n"
+        "  -s <w>x<h>      picture size (default 1920x1080)\n"
+        "  -S <w>x<h>      scaled output size (default 1280x720)\n"
+        "  -m <module>     converter, blender or audio volume module to use\n"
+        "  -f <filter>     benchmark a video filter, as name{options}\n"
+        "  -c <in>:<out>   benchmark a chroma conversion\n"
+        "  -i <chroma>     input chroma of the -f filter (default I420)\n"
+        "  -g <GHz>        CPU clock, to report cycles per pixel or sample\n"
+        "  -l              list the cases\n"
+        "\n"
+        "Without patterns nor -f or -c, all the cases are run.\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_config cfg = {
+        .iterations = 100,
+        .width = 1920, .height = 1080,
+        .scaled_width = 1280, .scaled_height = 720,
+        .module = NULL,
+        .ghz = 0.,
+    };
+    struct bench_case custom[2];
+    size_t customs = 0;
+    const char *filter = NULL, *conversion = NULL;
+    vlc_fourcc_t filter_chroma = VLC_CODEC_I420;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:S:m:f:c:i:g:lh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                cfg.iterations = strtoul(optarg, NULL, 0);
+                if (cfg.iterations == 0)
+                    cfg.iterations = 1;
+                break;
+            case 's':
+                if (ParseSize(optarg, &cfg.width, &cfg.height))
+                    return 1;
+                break;
+            case 'S':
+                if (ParseSize(optarg, &cfg.scaled_width, &cfg.scaled_height))
+                    return 1;
+                break;
+            case 'm':
+                cfg.module = optarg;
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 'c':
+                conversion = optarg;
+                break;
+            case 'i':
+                filter_chroma = ParseChroma(optarg);
+                if (filter_chroma == 0)
+                    return 1;
+                break;
+            case 'g':
+                cfg.ghz = strtod(optarg, NULL);
+                if (cfg.ghz < 0.)
+                    cfg.ghz = 0.;
+                break;
+            case 'l':
+                for (size_t i = 0; i < ARRAY_SIZE(cases); i++)
+                    printf("%s\n", cases[i].name);
+                return 0;
+            default:
+                Usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (filter != NULL)
+        custom[customs++] = (struct bench_case) {
+            filter, BENCH_FILTER, filter, filter_chroma, filter_chroma, false,
+        };
+    if (conversion != NULL)
+    {
+        char in[16], out[16];
+        if (sscanf(conversion, "%15[^:]:%15s", in, out) != 2)
+        {
+            fprintf(stderr, "invalid conversion: %s\n", conversion);
+            return 1;
+        }
+        struct bench_case *bench = &custom[customs++];
+        *bench = (struct bench_case) {
+            conversion, BENCH_CONVERTER, NULL, ParseChroma(in), ParseChroma(out),
+            false,
+        };
+        if (bench->in == 0 || bench->out == 0)
+            return 1;
+    }
+
+    if (getenv("VLC_PLUGIN_PATH") == NULL)
+        setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    static const char *const args[] = { "--quiet", "--no-media-library" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 1;
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    printf("%-24s %-16s %12s %10s\n", "case", "module",
+           cfg.ghz > 0. ? "cycles/unit" : "ns/unit", "GB/s");
+
+    int failures = 0;
+    const size_t count = customs ? customs : ARRAY_SIZE(cases);
+    for (size_t i = 0; i < count; i++)
+    {
+        const struct bench_case *bench = customs ? &custom[i] : &cases[i];
+
+        if (!customs && optind < argc)
+        {
+            bool match = false;
+            for (int j = optind; j < argc && !match; j++)
+                match = fnmatch(argv[j], bench->name, 0) == 0;
+            if (!match)
+                continue;
+        }
+
+        struct bench_result res;
+        int ret;
+        switch (bench->type)
+        {
+            case BENCH_BLEND:
+                ret = RunBlend(obj, bench, &cfg, &res);
+                break;
+            case BENCH_AUDIO:
+                ret = RunAudio(obj, bench, &cfg, &res);
+                break;
+            case BENCH_VOLUME:
+                ret = RunVolume(obj, bench, &cfg, &res);
+                break;
+            default:
+                ret = RunFilter(obj, bench, &cfg, &res);
+                break;
+        }
+        if (ret != VLC_SUCCESS)
+        {
+            printf("%-24s %-16s\n", bench->name, "unavailable");
+            failures++;
+            continue;
+        }
+
+        const double ns = NS_FROM_VLC_TICK(res.duration);
+        /* per pixel for the video, per sample for the audio */
+        const double unit = ns / res.pixels;
+        printf("%-24s %-16s %12.3f %10.2f\n", bench->name, res.module,
+               cfg.ghz > 0. ? unit * cfg.ghz : unit,
+               ns > 0 ? res.bytes / ns : 0.);
+    }
+
+    libvlc_release(vlc);
+    return failures > 0;
+}
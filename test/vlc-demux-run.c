@@ -28,14 +28,52 @@
 # include "config.h"
 #endif
 
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "src/input/demux-run.h"
 
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+/* Count the allocations for the benchmark mode, forwarding them to the
+ * glibc allocator */
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static atomic_uintmax_t allocs = 0;
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+static uintmax_t alloc_count(void)
+{
+    return atomic_load_explicit(&allocs, memory_order_relaxed);
+}
+#else
+# define alloc_count NULL
+#endif
+
 int main(int argc, char *argv[])
 {
     const char *filename;
     struct vlc_run_args args;
     vlc_run_args_init(&args);
+    args.alloc_count = alloc_count;
 
     switch (argc)
     {
@@ -43,7 +81,7 @@ int main(int argc, char *argv[])
             filename = argv[argc - 1];
             break;
         default:
-            fprintf(stderr, "Usage: [VLC_TARGET=demux] %s <filename>\n", argv[0]);
+            fprintf(stderr, "Usage: [VLC_TARGET=demux] [VLC_BENCH=runs] %s <filename>\n", argv[0]);
             return 1;
     }
 